@@ -15,6 +15,7 @@
 %}
 
 %include <std_shared_ptr.i>
+%include <std_string.i>
 %include <cartoswig.i>
 
 !shared_ptr(carto::Options, components.Options)
@@ -54,9 +55,15 @@
 %attributestring(carto::Options, std::shared_ptr<carto::Bitmap>, BackgroundBitmap, getBackgroundBitmap, setBackgroundBitmap)
 %attribute(carto::Options, int, EnvelopeThreadPoolSize, getEnvelopeThreadPoolSize, setEnvelopeThreadPoolSize)
 %attribute(carto::Options, int, TileThreadPoolSize, getTileThreadPoolSize, setTileThreadPoolSize)
+%attribute(carto::Options, bool, TileThreadPoolWorkStealing, isTileThreadPoolWorkStealing, setTileThreadPoolWorkStealing)
 %attribute(carto::Options, int, TileDrawSize, getTileDrawSize, setTileDrawSize)
 %attribute(carto::Options, float, DPI, getDPI, setDPI)
 %attribute(carto::Options, float, DrawDistance, getDrawDistance, setDrawDistance)
+%attribute(carto::Options, float, InteractionFPS, getInteractionFPS, setInteractionFPS)
+%attribute(carto::Options, float, AnimationFPS, getAnimationFPS, setAnimationFPS)
+%attribute(carto::Options, float, IdleFPS, getIdleFPS, setIdleFPS)
+%attribute(carto::Options, bool, FrameSynchronousScheduling, isFrameSynchronousScheduling, setFrameSynchronousScheduling)
+%attributestring(carto::Options, std::string, ShaderCacheDirectory, getShaderCacheDirectory, setShaderCacheDirectory)
 %attributestring(carto::Options, std::shared_ptr<carto::Bitmap>, WatermarkBitmap, getWatermarkBitmap, setWatermarkBitmap)
 %attribute(carto::Options, float, WatermarkAlignmentX, getWatermarkAlignmentX, setWatermarkAlignmentX)
 %attribute(carto::Options, float, WatermarkAlignmentY, getWatermarkAlignmentY, setWatermarkAlignmentY)
@@ -0,0 +1,28 @@
+#ifndef _CACHESTATISTICS_I
+#define _CACHESTATISTICS_I
+
+%module CacheStatistics
+
+%{
+#include "core/CacheStatistics.h"
+%}
+
+%include <std_string.i>
+%include <cartoswig.i>
+
+!value_type(carto::CacheStatistics, core.CacheStatistics)
+
+%attribute(carto::CacheStatistics, std::size_t, Size, getSize)
+%attribute(carto::CacheStatistics, std::size_t, Capacity, getCapacity)
+%attribute(carto::CacheStatistics, std::size_t, EntryCount, getEntryCount)
+%attribute(carto::CacheStatistics, long long, HitCount, getHitCount)
+%attribute(carto::CacheStatistics, long long, MissCount, getMissCount)
+%attribute(carto::CacheStatistics, double, HitRatio, getHitRatio)
+%attribute(carto::CacheStatistics, long long, EvictionCount, getEvictionCount)
+%attribute(carto::CacheStatistics, double, AverageLoadTime, getAverageLoadTime)
+!custom_equals(carto::CacheStatistics);
+!custom_tostring(carto::CacheStatistics);
+
+%include "core/CacheStatistics.h"
+
+#endif
@@ -22,6 +22,7 @@
 %ignore carto::MapTile::getParent;
 %ignore carto::MapTile::getChild;
 %ignore carto::MapTile::getFlipped;
+%ignore carto::MapTile::FromTileId;
 !custom_equals(carto::MapTile);
 !custom_tostring(carto::MapTile);
 
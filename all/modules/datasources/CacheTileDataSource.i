@@ -3,7 +3,7 @@
 
 %module(directors="1") CacheTileDataSource
 
-!proxy_imports(carto::CacheTileDataSource, core.MapTile, core.MapBounds, core.StringMap, datasources.TileDataSource, datasources.components.TileData)
+!proxy_imports(carto::CacheTileDataSource, core.CacheStatistics, core.MapTile, core.MapBounds, core.StringMap, datasources.TileDataSource, datasources.components.TileData)
 
 %{
 #include "datasources/CacheTileDataSource.h"
@@ -14,6 +14,7 @@
 %include <std_shared_ptr.i>
 %include <cartoswig.i>
 
+%import "core/CacheStatistics.i"
 %import "datasources/TileDataSource.i"
 
 !polymorphic_shared_ptr(carto::CacheTileDataSource, datasources.CacheTileDataSource)
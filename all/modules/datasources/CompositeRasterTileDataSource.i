@@ -0,0 +1,28 @@
+#ifndef _COMPOSITERASTERTILEDATASOURCE_I
+#define _COMPOSITERASTERTILEDATASOURCE_I
+
+%module(directors="1") CompositeRasterTileDataSource
+
+!proxy_imports(carto::CompositeRasterTileDataSource, core.MapTile, core.MapBounds, core.StringMap, datasources.TileDataSource, datasources.components.TileData)
+
+%{
+#include "datasources/CompositeRasterTileDataSource.h"
+#include "components/Exceptions.h"
+#include <memory>
+%}
+
+%include <std_shared_ptr.i>
+%include <std_string.i>
+%include <cartoswig.i>
+
+%import "datasources/TileDataSource.i"
+
+!polymorphic_shared_ptr(carto::CompositeRasterTileDataSource, datasources.CompositeRasterTileDataSource)
+
+%std_exceptions(carto::CompositeRasterTileDataSource::addDataSource)
+
+%feature("director") carto::CompositeRasterTileDataSource;
+
+%include "datasources/CompositeRasterTileDataSource.h"
+
+#endif
@@ -27,6 +27,7 @@
 %std_io_exceptions(carto::GeoJSONVectorTileDataSource::createLayer)
 %std_io_exceptions(carto::GeoJSONVectorTileDataSource::setLayerGeoJSON)
 %std_io_exceptions(carto::GeoJSONVectorTileDataSource::setLayerFeatureCollection)
+%std_io_exceptions(carto::GeoJSONVectorTileDataSource::addLayerFeatureCollection)
 
 %feature("director") carto::GeoJSONVectorTileDataSource;
 
@@ -27,6 +27,7 @@
 %attribute(carto::HTTPTileDataSource, bool, TMSScheme, isTMSScheme, setTMSScheme)
 %attribute(carto::HTTPTileDataSource, bool, MaxAgeHeaderCheck, isMaxAgeHeaderCheck, setMaxAgeHeaderCheck)
 %attributeval(carto::HTTPTileDataSource, %arg(std::map<std::string, std::string>), HTTPHeaders, getHTTPHeaders, setHTTPHeaders)
+%attribute(carto::HTTPTileDataSource, int, MaxConnectionsPerHost, getMaxConnectionsPerHost, setMaxConnectionsPerHost)
 
 %feature("director") carto::HTTPTileDataSource;
 
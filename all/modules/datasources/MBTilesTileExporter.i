@@ -0,0 +1,45 @@
+#ifndef _MBTILESTILEEXPORTER_I
+#define _MBTILESTILEEXPORTER_I
+
+%module MBTilesTileExporter
+
+#ifdef _CARTO_OFFLINE_SUPPORT
+
+#ifdef _CARTO_PACKAGEMANAGER_SUPPORT
+!proxy_imports(carto::MBTilesTileExporter, core.MapBounds, core.StringMap, datasources.TileDataSource, datasources.TileExportListener, packagemanager.PackageTileMask)
+#else
+!proxy_imports(carto::MBTilesTileExporter, core.MapBounds, core.StringMap, datasources.TileDataSource, datasources.TileExportListener)
+#endif
+
+%{
+#include "datasources/MBTilesTileExporter.h"
+#include "components/Exceptions.h"
+#include <memory>
+%}
+
+%include <std_shared_ptr.i>
+%include <std_string.i>
+%include <cartoswig.i>
+
+%import "core/MapBounds.i"
+%import "core/StringMap.i"
+%import "datasources/TileDataSource.i"
+%import "datasources/TileExportListener.i"
+#ifdef _CARTO_PACKAGEMANAGER_SUPPORT
+%import "packagemanager/PackageTileMask.i"
+#endif
+
+!shared_ptr(carto::MBTilesTileExporter, datasources.MBTilesTileExporter)
+
+!attributestring_polymorphic(carto::MBTilesTileExporter, datasources.TileDataSource, DataSource, getDataSource)
+%attributestring(carto::MBTilesTileExporter, std::string, Path, getPath)
+%attributeval(carto::MBTilesTileExporter, %arg(std::map<std::string, std::string>), MetaData, getMetaData, setMetaData)
+%attribute(carto::MBTilesTileExporter, int, MaxConcurrency, getMaxConcurrency, setMaxConcurrency)
+%std_exceptions(carto::MBTilesTileExporter::MBTilesTileExporter)
+%std_exceptions(carto::MBTilesTileExporter::startExportTileMask)
+
+%include "datasources/MBTilesTileExporter.h"
+
+#endif
+
+#endif
@@ -30,6 +30,8 @@
 %ignore carto::NMLModelLODTreeDataSource::loadModelLODTree;
 %ignore carto::NMLModelLODTreeDataSource::loadMesh;
 %ignore carto::NMLModelLODTreeDataSource::loadTexture;
+%ignore carto::NMLModelLODTreeDataSource::loadMeshes;
+%ignore carto::NMLModelLODTreeDataSource::loadTextures;
 
 %include "datasources/NMLModelLODTreeDataSource.h"
 
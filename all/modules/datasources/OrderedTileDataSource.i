@@ -19,6 +19,9 @@
 
 !polymorphic_shared_ptr(carto::OrderedTileDataSource, datasources.OrderedTileDataSource)
 
+%attribute(carto::OrderedTileDataSource, bool, HedgingEnabled, isHedgingEnabled, setHedgingEnabled)
+%attribute(carto::OrderedTileDataSource, float, HedgingLatencyPercentile, getHedgingLatencyPercentile, setHedgingLatencyPercentile)
+
 %std_exceptions(carto::OrderedTileDataSource::OrderedTileDataSource)
 
 %feature("director") carto::OrderedTileDataSource;
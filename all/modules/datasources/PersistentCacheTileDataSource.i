@@ -22,6 +22,8 @@
 
 %attribute(carto::PersistentCacheTileDataSource, bool, CacheOnlyMode, isCacheOnlyMode, setCacheOnlyMode)
 %attribute(carto::PersistentCacheTileDataSource, bool, Open, isOpen)
+%attribute(carto::PersistentCacheTileDataSource, int, WriteQueueSize, getWriteQueueSize, setWriteQueueSize)
+%attribute(carto::PersistentCacheTileDataSource, int, WriteDelay, getWriteDelay, setWriteDelay)
 %std_exceptions(carto::PersistentCacheTileDataSource::PersistentCacheTileDataSource)
 %std_exceptions(carto::PersistentCacheTileDataSource::startDownloadArea)
 
@@ -0,0 +1,35 @@
+#ifndef _RECORDINGTILEDATASOURCE_I
+#define _RECORDINGTILEDATASOURCE_I
+
+%module(directors="1") RecordingTileDataSource
+
+#ifdef _CARTO_OFFLINE_SUPPORT
+
+!proxy_imports(carto::RecordingTileDataSource, core.MapTile, core.MapBounds, core.StringMap, datasources.TileDataSource, datasources.components.TileData)
+
+%{
+#include "datasources/RecordingTileDataSource.h"
+#include "components/Exceptions.h"
+#include <memory>
+%}
+
+%include <std_shared_ptr.i>
+%include <std_string.i>
+%include <cartoswig.i>
+
+%import "datasources/TileDataSource.i"
+
+!polymorphic_shared_ptr(carto::RecordingTileDataSource, datasources.RecordingTileDataSource)
+
+!attributestring_polymorphic(carto::RecordingTileDataSource, datasources.TileDataSource, DataSource, getDataSource)
+%attributestring(carto::RecordingTileDataSource, std::string, Path, getPath)
+%attribute(carto::RecordingTileDataSource, int, RecordedRequestCount, getRecordedRequestCount)
+%std_exceptions(carto::RecordingTileDataSource::RecordingTileDataSource)
+
+%feature("director") carto::RecordingTileDataSource;
+
+%include "datasources/RecordingTileDataSource.h"
+
+#endif
+
+#endif
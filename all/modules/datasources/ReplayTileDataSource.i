@@ -0,0 +1,34 @@
+#ifndef _REPLAYTILEDATASOURCE_I
+#define _REPLAYTILEDATASOURCE_I
+
+%module(directors="1") ReplayTileDataSource
+
+#ifdef _CARTO_OFFLINE_SUPPORT
+
+!proxy_imports(carto::ReplayTileDataSource, core.MapTile, core.MapBounds, core.StringMap, datasources.TileDataSource, datasources.components.TileData)
+
+%{
+#include "datasources/ReplayTileDataSource.h"
+#include "components/Exceptions.h"
+#include <memory>
+%}
+
+%include <std_shared_ptr.i>
+%include <std_string.i>
+%include <cartoswig.i>
+
+%import "datasources/TileDataSource.i"
+
+!polymorphic_shared_ptr(carto::ReplayTileDataSource, datasources.ReplayTileDataSource)
+
+%attribute(carto::ReplayTileDataSource, float, LatencyScale, getLatencyScale, setLatencyScale)
+%attribute(carto::ReplayTileDataSource, int, UnmatchedRequestCount, getUnmatchedRequestCount)
+%std_exceptions(carto::ReplayTileDataSource::ReplayTileDataSource)
+
+%feature("director") carto::ReplayTileDataSource;
+
+%include "datasources/ReplayTileDataSource.h"
+
+#endif
+
+#endif
@@ -31,6 +31,9 @@
 %attribute(carto::TileDataSource, int, MaxZoom, getMaxZoom)
 %attributeval(carto::TileDataSource, carto::MapBounds, DataExtent, getDataExtent)
 !attributestring_polymorphic(carto::TileDataSource, projections.Projection, Projection, getProjection)
+%ignore carto::TileDataSource::loadTiles;
+%ignore carto::TileDataSource::isBatchLoadingSupported;
+%ignore carto::TileDataSource::revalidateTile;
 %ignore carto::TileDataSource::OnChangeListener;
 %ignore carto::TileDataSource::registerOnChangeListener;
 %ignore carto::TileDataSource::unregisterOnChangeListener;
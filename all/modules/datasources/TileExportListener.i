@@ -0,0 +1,25 @@
+#ifndef _TILEEXPORTLISTENER_I
+#define _TILEEXPORTLISTENER_I
+
+%module(directors="1") TileExportListener
+
+!proxy_imports(carto::TileExportListener, core.MapTile)
+
+%{
+#include "datasources/TileExportListener.h"
+#include <memory>
+%}
+
+%include <std_shared_ptr.i>
+%include <std_string.i>
+%include <cartoswig.i>
+
+%import "core/MapTile.i"
+
+!polymorphic_shared_ptr(carto::TileExportListener, datasources.TileExportListener)
+
+%feature("director") carto::TileExportListener;
+
+%include "datasources/TileExportListener.h"
+
+#endif
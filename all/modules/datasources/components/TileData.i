@@ -21,6 +21,12 @@
 %attribute(carto::TileData, bool, ReplaceWithParent, isReplaceWithParent, setReplaceWithParent)
 %attributestring(carto::TileData, std::shared_ptr<carto::BinaryData>, Data, getData)
 !standard_equals(carto::TileData);
+%ignore carto::TileData::getCacheSource;
+%ignore carto::TileData::setCacheSource;
+%ignore carto::TileData::getETag;
+%ignore carto::TileData::setETag;
+%ignore carto::TileData::getLastModified;
+%ignore carto::TileData::setLastModified;
 
 %include "datasources/components/TileData.h"
 
@@ -27,6 +27,7 @@
 
 %std_io_exceptions(carto::OSMOfflineReverseGeocodingService::OSMOfflineReverseGeocodingService)
 %std_io_exceptions(carto::OSMOfflineReverseGeocodingService::calculateAddresses)
+%std_io_exceptions(carto::OSMOfflineReverseGeocodingService::calculateAddressesBatch)
 
 %feature("director") carto::OSMOfflineReverseGeocodingService;
 
@@ -26,6 +26,7 @@
 
 %std_exceptions(carto::PackageManagerReverseGeocodingService::PackageManagerReverseGeocodingService)
 %std_io_exceptions(carto::PackageManagerReverseGeocodingService::calculateAddresses)
+%std_io_exceptions(carto::PackageManagerReverseGeocodingService::calculateAddressesBatch)
 
 %feature("director") carto::PackageManagerReverseGeocodingService;
 
@@ -28,6 +28,7 @@
 %attributestring(carto::ReverseGeocodingService, std::string, Language, getLanguage, setLanguage)
 %std_exceptions(carto::ReverseGeocodingService::setLanguage)
 %std_io_exceptions(carto::ReverseGeocodingService::calculateAddresses)
+%std_io_exceptions(carto::ReverseGeocodingService::calculateAddressesBatch)
 
 %feature("director") carto::ReverseGeocodingService;
 
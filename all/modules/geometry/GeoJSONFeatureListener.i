@@ -0,0 +1,24 @@
+#ifndef _GEOJSONFEATURELISTENER_I
+#define _GEOJSONFEATURELISTENER_I
+
+%module(directors="1") GeoJSONFeatureListener
+
+!proxy_imports(carto::GeoJSONFeatureListener, geometry.Feature)
+
+%{
+#include "geometry/GeoJSONFeatureListener.h"
+#include <memory>
+%}
+
+%include <std_shared_ptr.i>
+%include <cartoswig.i>
+
+%import "geometry/Feature.i"
+
+!polymorphic_shared_ptr(carto::GeoJSONFeatureListener, geometry.GeoJSONFeatureListener)
+
+%feature("director") carto::GeoJSONFeatureListener;
+
+%include "geometry/GeoJSONFeatureListener.h"
+
+#endif
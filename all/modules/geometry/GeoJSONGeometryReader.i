@@ -3,7 +3,7 @@
 
 %module GeoJSONGeometryReader
 
-!proxy_imports(carto::GeoJSONGeometryReader, geometry.Feature, geometry.FeatureCollection, geometry.Geometry, projections.Projection)
+!proxy_imports(carto::GeoJSONGeometryReader, geometry.Feature, geometry.FeatureCollection, geometry.GeoJSONFeatureListener, geometry.Geometry, projections.Projection)
 
 %{
 #include "geometry/GeoJSONGeometryReader.h"
@@ -17,6 +17,7 @@
 
 %import "geometry/Feature.i"
 %import "geometry/FeatureCollection.i"
+%import "geometry/GeoJSONFeatureListener.i"
 %import "geometry/Geometry.i"
 %import "projections/Projection.i"
 
@@ -24,6 +25,8 @@
 %std_exceptions(carto::GeoJSONGeometryReader::readGeometry)
 %std_exceptions(carto::GeoJSONGeometryReader::readFeature)
 %std_exceptions(carto::GeoJSONGeometryReader::readFeatureCollection)
+%std_exceptions(carto::GeoJSONGeometryReader::readFeatureCollectionFeatures)
+%std_exceptions(carto::GeoJSONGeometryReader::readFeatureCollectionFeaturesFromFile)
 
 %include "geometry/GeoJSONGeometryReader.h"
 
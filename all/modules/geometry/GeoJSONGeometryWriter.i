@@ -22,9 +22,11 @@
 
 !attributestring_polymorphic(carto::GeoJSONGeometryWriter, projections.Projection, SourceProjection, getSourceProjection, setSourceProjection)
 %attribute(carto::GeoJSONGeometryWriter, bool, Z, getZ, setZ)
+%attribute(carto::GeoJSONGeometryWriter, int, Precision, getPrecision, setPrecision)
 %std_exceptions(carto::GeoJSONGeometryWriter::writeGeometry)
 %std_exceptions(carto::GeoJSONGeometryWriter::writeFeature)
 %std_exceptions(carto::GeoJSONGeometryWriter::writeFeatureCollection)
+%std_exceptions(carto::GeoJSONGeometryWriter::writeFeatureCollectionToFile)
 
 %include "geometry/GeoJSONGeometryWriter.h"
 
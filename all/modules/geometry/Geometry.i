@@ -22,6 +22,7 @@
 
 %attributeval(carto::Geometry, carto::MapBounds, Bounds, getBounds)
 %attributeval(carto::Geometry, carto::MapPos, CenterPos, getCenterPos)
+%ignore carto::Geometry::getRevision;
 !standard_equals(carto::Geometry);
 
 %include "geometry/Geometry.h"
@@ -25,6 +25,9 @@
 %attributeval(carto::VectorTileFeature, carto::MapTile, MapTile, getMapTile)
 %attributestring(carto::VectorTileFeature, std::string, LayerName, getLayerName)
 !standard_equals(carto::VectorTileFeature);
+%ignore carto::VectorTileFeature::VectorTileFeature(long long, const MapTile&, const std::string&, std::function<std::shared_ptr<Geometry>()>, std::function<Variant()>);
+%ignore carto::VectorTileFeature::getGeometry;
+%ignore carto::VectorTileFeature::getProperties;
 
 %include "geometry/VectorTileFeature.h"
 
@@ -30,6 +30,8 @@
 %ignore carto::Bitmap::getPixelData;
 %rename(getPixelData) carto::Bitmap::getPixelDataPtr;
 %ignore carto::Bitmap::CreateFromCompressed(const unsigned char*, std::size_t);
+%ignore carto::Bitmap::CreateFromCompressed(const unsigned char*, std::size_t, unsigned int, unsigned int, ColorFormat::ColorFormat);
+%ignore carto::Bitmap::CreateFromCompressed(const unsigned char*, std::size_t, unsigned int, unsigned int, ColorFormat::ColorFormat, const std::function<bool()>&);
 !standard_equals(carto::Bitmap);
 
 %include "graphics/Bitmap.h"
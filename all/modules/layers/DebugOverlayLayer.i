@@ -0,0 +1,25 @@
+#ifndef _DEBUGOVERLAYLAYER_I
+#define _DEBUGOVERLAYLAYER_I
+
+%module DebugOverlayLayer
+
+!proxy_imports(carto::DebugOverlayLayer, layers.Layer)
+
+%{
+#include "layers/DebugOverlayLayer.h"
+#include <memory>
+%}
+
+%include <std_shared_ptr.i>
+%include <cartoswig.i>
+
+%import "layers/Layer.i"
+
+!polymorphic_shared_ptr(carto::DebugOverlayLayer, layers.DebugOverlayLayer)
+
+%attribute(carto::DebugOverlayLayer, bool, TileBoundariesVisible, isTileBoundariesVisible, setTileBoundariesVisible)
+%attribute(carto::DebugOverlayLayer, bool, StatisticsVisible, isStatisticsVisible, setStatisticsVisible)
+
+%include "layers/DebugOverlayLayer.h"
+
+#endif
@@ -3,7 +3,7 @@
 
 %module RasterTileLayer
 
-!proxy_imports(carto::RasterTileLayer, datasources.TileDataSource, layers.TileLayer, layers.RasterTileEventListener)
+!proxy_imports(carto::RasterTileLayer, core.CacheStatistics, datasources.TileDataSource, layers.TileLayer, layers.RasterTileEventListener)
 
 %{
 #include "layers/RasterTileLayer.h"
@@ -14,6 +14,7 @@
 %include <std_shared_ptr.i>
 %include <cartoswig.i>
 
+%import "core/CacheStatistics.i"
 %import "datasources/TileDataSource.i"
 %import "layers/RasterTileEventListener.i"
 %import "layers/TileLayer.i"
@@ -25,6 +25,9 @@
 
 %attribute(carto::TileLayer, int, FrameNr, getFrameNr, setFrameNr)
 %attribute(carto::TileLayer, bool, Preloading, isPreloading, setPreloading)
+%attribute(carto::TileLayer, bool, PredictivePreloading, isPredictivePreloading, setPredictivePreloading)
+%attribute(carto::TileLayer, bool, CompactPreloading, isCompactPreloading, setCompactPreloading)
+%attribute(carto::TileLayer, float, MemoryWeight, getMemoryWeight, setMemoryWeight)
 %attribute(carto::TileLayer, bool, SynchronizedRefresh, isSynchronizedRefresh, setSynchronizedRefresh)
 %attribute(carto::TileLayer, carto::TileSubstitutionPolicy::TileSubstitutionPolicy, TileSubstitutionPolicy, getTileSubstitutionPolicy, setTileSubstitutionPolicy)
 %attribute(carto::TileLayer, float, ZoomLevelBias, getZoomLevelBias, setZoomLevelBias)
@@ -35,10 +38,13 @@
 !attributestring_polymorphic(carto::TileLayer, layers.TileLoadListener, TileLoadListener, getTileLoadListener, setTileLoadListener)
 !attributestring_polymorphic(carto::TileLayer, layers.UTFGridEventListener, UTFGridEventListener, getUTFGridEventListener, setUTFGridEventListener)
 %std_exceptions(carto::TileLayer::TileLayer)
+%std_exceptions(carto::TileLayer::setMemoryWeight)
 %ignore carto::TileLayer::FetchTaskBase;
 %ignore carto::TileLayer::FetchingTiles;
 %ignore carto::TileLayer::DataSourceListener;
 %ignore carto::TileLayer::UTFGridTile;
+%ignore carto::TileLayer::getTileLoadTraceListener;
+%ignore carto::TileLayer::setTileLoadTraceListener;
 %ignore carto::TileLayer::getMinZoom;
 %ignore carto::TileLayer::getMaxZoom;
 
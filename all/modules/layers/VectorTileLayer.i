@@ -3,7 +3,7 @@
 
 %module VectorTileLayer
 
-!proxy_imports(carto::VectorTileLayer, datasources.TileDataSource, datasources.components.TileData, layers.TileLayer, layers.VectorTileEventListener, vectortiles.VectorTileDecoder)
+!proxy_imports(carto::VectorTileLayer, core.CacheStatistics, datasources.TileDataSource, datasources.components.TileData, layers.TileLayer, layers.VectorTileEventListener, vectortiles.VectorTileDecoder)
 
 %{
 #include "layers/VectorTileLayer.h"
@@ -14,6 +14,7 @@
 %include <std_shared_ptr.i>
 %include <cartoswig.i>
 
+%import "core/CacheStatistics.i"
 %import "datasources/TileDataSource.i"
 %import "layers/VectorTileEventListener.i"
 %import "layers/TileLayer.i"
@@ -25,6 +26,7 @@
 %attribute(carto::VectorTileLayer, VectorTileRenderOrder::VectorTileRenderOrder, LabelRenderOrder, getLabelRenderOrder, setLabelRenderOrder)
 %attribute(carto::VectorTileLayer, VectorTileRenderOrder::VectorTileRenderOrder, BuildingRenderOrder, getBuildingRenderOrder, setBuildingRenderOrder)
 %attribute(carto::VectorTileLayer, float, ClickRadius, getClickRadius, setClickRadius)
+%attribute(carto::VectorTileLayer, bool, OverzoomTileReuse, isOverzoomTileReuse, setOverzoomTileReuse)
 !attributestring_polymorphic(carto::VectorTileLayer, vectortiles.VectorTileDecoder, TileDecoder, getTileDecoder)
 !attributestring_polymorphic(carto::VectorTileLayer, layers.VectorTileEventListener, VectorTileEventListener, getVectorTileEventListener, setVectorTileEventListener)
 %std_exceptions(carto::VectorTileLayer::VectorTileLayer)
@@ -35,6 +35,8 @@ using std::uint64_t;
 %attributeval(carto::PackageManager, std::vector<std::shared_ptr<carto::PackageInfo> >, ServerPackages, getServerPackages)
 %attributeval(carto::PackageManager, std::vector<std::shared_ptr<carto::PackageInfo> >, LocalPackages, getLocalPackages)
 %attribute(carto::PackageManager, int, ServerPackageListAge, getServerPackageListAge)
+%attribute(carto::PackageManager, int, DownloadConcurrency, getDownloadConcurrency, setDownloadConcurrency)
+%attribute(carto::PackageManager, int, DownloadSegmentCount, getDownloadSegmentCount, setDownloadSegmentCount)
 %attributestring(carto::PackageManager, std::shared_ptr<carto::PackageMetaInfo>, ServerPackageListMetaInfo, getServerPackageListMetaInfo)
 !attributestring_polymorphic(carto::PackageManager, packagemanager.PackageManagerListener, PackageManagerListener, getPackageManagerListener, setPackageManagerListener)
 %std_io_exceptions(carto::PackageManager::PackageManager)
@@ -43,6 +45,8 @@ using std::uint64_t;
 %ignore carto::PackageManager::registerOnChangeListener;
 %ignore carto::PackageManager::unregisterOnChangeListener;
 %ignore carto::PackageManager::getSchema;
+%ignore carto::PackageManager::LocalPackageSnapshot;
+%ignore carto::PackageManager::getLocalPackageSnapshot;
 %ignore carto::PackageManager::accessLocalPackages;
 !standard_equals(carto::PackageManager);
 
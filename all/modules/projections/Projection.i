@@ -23,6 +23,7 @@
 !objc_rename(fromLat) carto::Projection::fromLatLong;
 %ignore carto::Projection::fromInternal;
 %ignore carto::Projection::toInternal;
+%ignore carto::Projection::toInternalPoses;
 !standard_equals(carto::Projection);
 
 %include "projections/Projection.h"
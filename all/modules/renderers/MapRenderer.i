@@ -26,11 +26,13 @@
 
 %attributestring(carto::MapRenderer, std::shared_ptr<carto::MapRendererListener>, MapRendererListener, getMapRendererListener, setMapRendererListener)
 %std_exceptions(carto::MapRenderer::captureRendering)
+%std_exceptions(carto::MapRenderer::captureRenderingAsync)
 %ignore carto::MapRenderer::MapRenderer;
 %ignore carto::MapRenderer::init;
 %ignore carto::MapRenderer::deinit;
 %ignore carto::MapRenderer::getLayers;
 %ignore carto::MapRenderer::getGLResourceManager;
+%ignore carto::MapRenderer::getFrameProfiler;
 %ignore carto::MapRenderer::getBillboardDrawDatas;
 %ignore carto::MapRenderer::getProjectionSurface;
 %ignore carto::MapRenderer::getAnimationHandler;
@@ -24,6 +24,7 @@
 %attributeval(carto::CullState, carto::ViewState, ViewState, getViewState)
 %std_exceptions(carto::CullState::getProjectionEnvelope)
 %ignore carto::CullState::getEnvelope;
+%ignore carto::CullState::isHiddenByHorizon;
 !standard_equals(carto::CullState);
 
 %include "renderers/components/CullState.h"
@@ -5,7 +5,7 @@
 
 #if defined(_CARTO_ROUTING_SUPPORT) && defined(_CARTO_VALHALLA_ROUTING_SUPPORT) && defined(_CARTO_PACKAGEMANAGER_SUPPORT)
 
-!proxy_imports(carto::PackageManagerValhallaRoutingService, packagemanager.PackageManager, core.Variant, routing.RoutingService, routing.RoutingRequest, routing.RoutingResult, routing.RouteMatchingRequest, routing.RouteMatchingResult)
+!proxy_imports(carto::PackageManagerValhallaRoutingService, core.MapBounds, projections.Projection, packagemanager.PackageManager, core.Variant, routing.RoutingService, routing.RoutingRequest, routing.RoutingResult, routing.RouteMatchingRequest, routing.RouteMatchingResult, routing.RoutingMatrixRequest, routing.RoutingMatrixResult)
 
 %{
 #include "routing/PackageManagerValhallaRoutingService.h"
@@ -17,7 +17,9 @@
 %include <std_string.i>
 %include <cartoswig.i>
 
+%import "core/MapBounds.i"
 %import "core/Variant.i"
+%import "projections/Projection.i"
 %import "routing/RoutingService.i"
 %import "packagemanager/PackageManager.i"
 
@@ -26,6 +28,8 @@
 %std_exceptions(carto::PackageManagerValhallaRoutingService::PackageManagerValhallaRoutingService)
 %std_io_exceptions(carto::PackageManagerValhallaRoutingService::matchRoute)
 %std_io_exceptions(carto::PackageManagerValhallaRoutingService::calculateRoute)
+%std_io_exceptions(carto::PackageManagerValhallaRoutingService::calculateMatrix)
+%std_io_exceptions(carto::PackageManagerValhallaRoutingService::warmupGraphTiles)
 
 %feature("director") carto::PackageManagerValhallaRoutingService;
 
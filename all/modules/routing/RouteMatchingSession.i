@@ -0,0 +1,42 @@
+#ifndef _ROUTEMATCHINGSESSION_I
+#define _ROUTEMATCHINGSESSION_I
+
+#pragma SWIG nowarn=325
+
+%module RouteMatchingSession
+
+#ifdef _CARTO_ROUTING_SUPPORT
+
+!proxy_imports(carto::RouteMatchingSession, core.MapPos, core.MapPosVector, projections.Projection, routing.RoutingService, routing.RouteMatchingResult)
+
+%{
+#include "routing/RouteMatchingSession.h"
+#include "components/Exceptions.h"
+#include <memory>
+%}
+
+%include <std_shared_ptr.i>
+%include <cartoswig.i>
+
+%import "core/MapPos.i"
+%import "projections/Projection.i"
+%import "routing/RoutingService.i"
+%import "routing/RouteMatchingResult.i"
+
+!shared_ptr(carto::RouteMatchingSession, routing.RouteMatchingSession)
+
+%attributestring(carto::RouteMatchingSession, std::shared_ptr<carto::RoutingService>, RoutingService, getRoutingService)
+%attributestring(carto::RouteMatchingSession, std::shared_ptr<carto::Projection>, Projection, getProjection)
+%attribute(carto::RouteMatchingSession, float, Accuracy, getAccuracy)
+%attribute(carto::RouteMatchingSession, int, WindowSize, getWindowSize, setWindowSize)
+%attributeval(carto::RouteMatchingSession, std::vector<carto::MapPos>, Points, getPoints)
+%std_exceptions(carto::RouteMatchingSession::RouteMatchingSession)
+%std_exceptions(carto::RouteMatchingSession::setWindowSize)
+%std_io_exceptions(carto::RouteMatchingSession::addPoint)
+!standard_equals(carto::RouteMatchingSession);
+
+%include "routing/RouteMatchingSession.h"
+
+#endif
+
+#endif
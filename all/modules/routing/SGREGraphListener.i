@@ -0,0 +1,25 @@
+#ifndef _SGREGRAPHLISTENER_I
+#define _SGREGRAPHLISTENER_I
+
+%module(directors="1") SGREGraphListener
+
+#if defined(_CARTO_ROUTING_SUPPORT) && defined(_CARTO_OFFLINE_SUPPORT)
+
+%{
+#include "routing/SGREGraphListener.h"
+#include <memory>
+%}
+
+%include <std_shared_ptr.i>
+%include <std_string.i>
+%include <cartoswig.i>
+
+!polymorphic_shared_ptr(carto::SGREGraphListener, routing.SGREGraphListener)
+
+%feature("director") carto::SGREGraphListener;
+
+%include "routing/SGREGraphListener.h"
+
+#endif
+
+#endif
@@ -5,7 +5,7 @@
 
 #if defined(_CARTO_ROUTING_SUPPORT) && defined(_CARTO_VALHALLA_ROUTING_SUPPORT) && defined(_CARTO_OFFLINE_SUPPORT)
 
-!proxy_imports(carto::ValhallaOfflineRoutingService, core.Variant, routing.RoutingService, routing.RoutingRequest, routing.RoutingResult, routing.RouteMatchingRequest, routing.RouteMatchingResult)
+!proxy_imports(carto::ValhallaOfflineRoutingService, core.MapBounds, projections.Projection, core.Variant, routing.RoutingService, routing.RoutingRequest, routing.RoutingResult, routing.RouteMatchingRequest, routing.RouteMatchingResult, routing.RoutingMatrixRequest, routing.RoutingMatrixResult)
 
 %{
 #include "routing/ValhallaOfflineRoutingService.h"
@@ -17,7 +17,9 @@
 %include <std_string.i>
 %include <cartoswig.i>
 
+%import "core/MapBounds.i"
 %import "core/Variant.i"
+%import "projections/Projection.i"
 %import "routing/RoutingService.i"
 
 !polymorphic_shared_ptr(carto::ValhallaOfflineRoutingService, routing.ValhallaOfflineRoutingService)
@@ -25,6 +27,8 @@
 %std_io_exceptions(carto::ValhallaOfflineRoutingService::ValhallaOfflineRoutingService)
 %std_io_exceptions(carto::ValhallaOfflineRoutingService::matchRoute)
 %std_io_exceptions(carto::ValhallaOfflineRoutingService::calculateRoute)
+%std_io_exceptions(carto::ValhallaOfflineRoutingService::calculateMatrix)
+%std_io_exceptions(carto::ValhallaOfflineRoutingService::warmupGraphTiles)
 
 %feature("director") carto::ValhallaOfflineRoutingService;
 
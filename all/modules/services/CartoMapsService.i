@@ -39,6 +39,8 @@
 %attribute(carto::CartoMapsService, float, VectorTileBufferSize, getVectorTileBufferSize, setVectorTileBufferSize)
 %attribute(carto::CartoMapsService, bool, StrictMode, isStrictMode, setStrictMode)
 %attributestring(carto::CartoMapsService, std::shared_ptr<carto::AssetPackage>, VectorTileAssetPackage, getVectorTileAssetPackage, setVectorTileAssetPackage)
+%attributestring(carto::CartoMapsService, std::string, CacheDirectory, getCacheDirectory, setCacheDirectory)
+%attribute(carto::CartoMapsService, int, CacheMaxAge, getCacheMaxAge, setCacheMaxAge)
 %std_io_exceptions(carto::CartoMapsService::buildMap)
 %std_io_exceptions(carto::CartoMapsService::buildNamedMap)
 %ignore carto::CartoMapsService::getTilerURL;
@@ -7,7 +7,7 @@
 
 #ifdef _CARTO_SERVICES_SUPPORT
 
-!proxy_imports(carto::CartoSQLService, core.Variant, geometry.FeatureCollection, projections.Projection)
+!proxy_imports(carto::CartoSQLService, core.Variant, geometry.FeatureCollection, geometry.GeoJSONFeatureListener, projections.Projection)
 
 %{
 #include "services/CartoSQLService.h"
@@ -22,6 +22,7 @@
 
 %import "core/Variant.i"
 %import "geometry/FeatureCollection.i"
+%import "geometry/GeoJSONFeatureListener.i"
 %import "projections/Projection.i"
 
 !shared_ptr(carto::CartoSQLService, services.CartoSQLService)
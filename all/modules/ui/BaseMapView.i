@@ -3,7 +3,7 @@
 
 %module BaseMapView
 
-!proxy_imports(carto::BaseMapView, core.MapPos, core.MapVec, core.MapBounds, core.ScreenPos, core.ScreenBounds, components.Options, components.Layers, components.LicenseManagerListener, renderers.MapRenderer, renderers.RedrawRequestListener, ui.MapEventListener)
+!proxy_imports(carto::BaseMapView, core.MapPos, core.MapVec, core.MapBounds, core.ScreenPos, core.ScreenBounds, core.Variant, components.Options, components.Layers, components.LicenseManagerListener, renderers.MapRenderer, renderers.RedrawRequestListener, ui.MapEventListener)
 
 %{
 #include "ui/BaseMapView.h"
@@ -18,6 +18,7 @@
 %import "core/ScreenPos.i"
 %import "core/ScreenBounds.i"
 %import "core/MapVec.i"
+%import "core/Variant.i"
 %import "components/Options.i"
 %import "components/Layers.i"
 %import "components/LicenseManagerListener.i"
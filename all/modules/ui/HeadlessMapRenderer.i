@@ -0,0 +1,30 @@
+#ifndef _HEADLESSMAPRENDERER_I
+#define _HEADLESSMAPRENDERER_I
+
+%module HeadlessMapRenderer
+
+!proxy_imports(carto::HeadlessMapRenderer, core.MapPos, core.MapBounds, components.Options, components.Layers, graphics.Bitmap)
+
+%{
+#include "ui/HeadlessMapRenderer.h"
+#include "components/Exceptions.h"
+#include <memory>
+%}
+
+%include <std_shared_ptr.i>
+%include <cartoswig.i>
+
+%import "core/MapPos.i"
+%import "core/MapBounds.i"
+%import "components/Options.i"
+%import "components/Layers.i"
+%import "graphics/Bitmap.i"
+
+!shared_ptr(carto::HeadlessMapRenderer, ui.HeadlessMapRenderer)
+
+%attribute(carto::HeadlessMapRenderer, int, Timeout, getTimeout, setTimeout)
+%std_exceptions(carto::HeadlessMapRenderer::renderImage)
+
+%include "ui/HeadlessMapRenderer.h"
+
+#endif
@@ -3,7 +3,7 @@
 
 %module Line
 
-!proxy_imports(carto::Line, core.MapPosVector, geometry.LineGeometry, styles.LineStyle, vectorelements.VectorElement)
+!proxy_imports(carto::Line, core.MapPosVector, core.MapRange, geometry.LineGeometry, styles.LineStyle, vectorelements.VectorElement)
 
 %{
 #include "vectorelements/Line.h"
@@ -14,6 +14,7 @@
 %include <std_shared_ptr.i>
 %include <cartoswig.i>
 
+%import "core/MapRange.i"
 %import "geometry/LineGeometry.i"
 %import "styles/LineStyle.i"
 %import "vectorelements/VectorElement.i"
@@ -23,6 +24,7 @@
 %csmethodmodifiers carto::Line::Geometry "public new";
 !attributestring_polymorphic(carto::Line, geometry.LineGeometry, Geometry, getGeometry, setGeometry)
 %attributestring(carto::Line, std::shared_ptr<carto::LineStyle>, Style, getStyle, setStyle)
+%attributeval(carto::Line, carto::MapRange, VisibleRange, getVisibleRange, setVisibleRange)
 %std_exceptions(carto::Line::Line)
 %std_exceptions(carto::Line::setGeometry)
 %std_exceptions(carto::Line::setStyle)
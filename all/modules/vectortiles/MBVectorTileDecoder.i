@@ -39,6 +39,7 @@
 %ignore carto::MBVectorTileDecoder::decodeFeature;
 %ignore carto::MBVectorTileDecoder::decodeFeatures;
 %ignore carto::MBVectorTileDecoder::decodeTile;
+%ignore carto::MBVectorTileDecoder::decodeTileProgressive;
 %ignore carto::MBVectorTileDecoder::getMapSettings;
 %ignore carto::MBVectorTileDecoder::loadMapnikMap;
 %ignore carto::MBVectorTileDecoder::loadCartoCSSMap;
@@ -27,6 +27,7 @@
 %ignore carto::TorqueTileDecoder::decodeFeature;
 %ignore carto::TorqueTileDecoder::decodeFeatures;
 %ignore carto::TorqueTileDecoder::decodeTile;
+%ignore carto::TorqueTileDecoder::decodeTileProgressive;
 %ignore carto::TorqueTileDecoder::getMapSettings;
 
 %include "vectortiles/TorqueTileDecoder.h"
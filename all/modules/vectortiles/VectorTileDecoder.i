@@ -27,6 +27,7 @@
 %ignore carto::VectorTileDecoder::decodeFeature;
 %ignore carto::VectorTileDecoder::decodeFeatures;
 %ignore carto::VectorTileDecoder::decodeTile;
+%ignore carto::VectorTileDecoder::decodeTileProgressive;
 %ignore carto::VectorTileDecoder::getMapSettings;
 %ignore carto::VectorTileDecoder::OnChangeListener;
 %ignore carto::VectorTileDecoder::registerOnChangeListener;
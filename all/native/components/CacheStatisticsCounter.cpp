@@ -0,0 +1,32 @@
+#include "CacheStatisticsCounter.h"
+
+namespace carto {
+
+    CacheStatisticsCounter::CacheStatisticsCounter() :
+        _hitCount(0),
+        _missCount(0),
+        _loadCount(0),
+        _loadTime(0)
+    {
+    }
+
+    void CacheStatisticsCounter::recordHit() {
+        _hitCount++;
+    }
+
+    void CacheStatisticsCounter::recordMiss() {
+        _missCount++;
+    }
+
+    void CacheStatisticsCounter::recordLoadTime(const std::chrono::steady_clock::duration& loadTime, std::size_t loadCount) {
+        _loadTime += std::chrono::duration_cast<std::chrono::microseconds>(loadTime).count();
+        _loadCount += static_cast<long long>(loadCount);
+    }
+
+    CacheStatistics CacheStatisticsCounter::getStatistics(std::size_t size, std::size_t capacity, std::size_t entryCount, long long evictionCount) const {
+        long long loadCount = _loadCount.load();
+        double averageLoadTime = (loadCount > 0 ? _loadTime.load() / 1000.0 / loadCount : 0.0);
+        return CacheStatistics(size, capacity, entryCount, _hitCount.load(), _missCount.load(), evictionCount, averageLoadTime);
+    }
+
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_CACHESTATISTICSCOUNTER_H_
+#define _CARTO_CACHESTATISTICSCOUNTER_H_
+
+#include "core/CacheStatistics.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+namespace carto {
+
+    /**
+     * Thread-safe counters for cache hits, misses and load times.
+     * The size, capacity and eviction information is owned by the cache itself and
+     * is combined with the counters when the statistics are requested.
+     */
+    class CacheStatisticsCounter {
+    public:
+        CacheStatisticsCounter();
+
+        /**
+         * Records a request served from the cache.
+         */
+        void recordHit();
+        /**
+         * Records a request not served from the cache.
+         */
+        void recordMiss();
+        /**
+         * Records the time spent loading entries after misses.
+         * @param loadTime The load duration.
+         * @param loadCount The number of entries loaded, if the entries were loaded as a batch.
+         */
+        void recordLoadTime(const std::chrono::steady_clock::duration& loadTime, std::size_t loadCount = 1);
+
+        /**
+         * Creates the statistics snapshot of the cache.
+         * @param size The number of bytes used by the cache.
+         * @param capacity The capacity of the cache in bytes.
+         * @param entryCount The number of entries in the cache.
+         * @param evictionCount The number of entries evicted from the cache.
+         * @return The statistics snapshot.
+         */
+        CacheStatistics getStatistics(std::size_t size, std::size_t capacity, std::size_t entryCount, long long evictionCount) const;
+
+    private:
+        std::atomic<long long> _hitCount;
+        std::atomic<long long> _missCount;
+        std::atomic<long long> _loadCount;
+        std::atomic<long long> _loadTime; // total load time in microseconds
+    };
+
+}
+
+#endif
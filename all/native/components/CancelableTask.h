@@ -9,6 +9,7 @@
 
 #include "components/Task.h"
 
+#include <chrono>
 #include <mutex>
 
 namespace carto {
@@ -26,16 +27,44 @@ namespace carto {
             std::lock_guard<std::mutex> lock(_mutex);
             _canceled = true;
         }
+
+        // Returns true if the result of the task is not needed immediately (for example, when preloading).
+        // Operations run by the task can use this to avoid redundant work that only reduces latency.
+        virtual bool isSpeculative() const {
+            return false;
+        }
+
+        // Returns the task run by the calling thread in a CancelableThreadPool, null if the thread is not running a task.
+        // Long blocking operations (like network requests) can use this to stop early once the task is canceled.
+        static const CancelableTask* GetCurrentTask() {
+            return CurrentTask();
+        }
     
     protected:
+        friend class CancelableThreadPool;
+
+        static void SetCurrentTask(const CancelableTask* task) {
+            CurrentTask() = task;
+        }
+
         CancelableTask() :
-            _canceled(false), _mutex()
+            _canceled(false), _mutex(), _queueTime(), _queuePriority(0)
         {
         }
     
         bool _canceled;
     
         mutable std::mutex _mutex;
+
+        // Set by CancelableThreadPool when the task is queued, used for the pool statistics
+        std::chrono::steady_clock::time_point _queueTime;
+        int _queuePriority;
+
+    private:
+        static const CancelableTask*& CurrentTask() {
+            static thread_local const CancelableTask* currentTask = nullptr;
+            return currentTask;
+        }
     };
     
 }
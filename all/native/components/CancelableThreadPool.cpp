@@ -2,19 +2,28 @@
 #include "utils/Log.h"
 #include "utils/ThreadUtils.h"
 
+#include <algorithm>
+#include <iterator>
 #include <limits>
 
 namespace carto {
 
-    CancelableThreadPool::CancelableThreadPool() :
+    CancelableThreadPool::CancelableThreadPool(ThreadRole::ThreadRole threadRole) :
+        _threadRole(threadRole),
         _poolSize(0),
         _taskCount(0),
         _stop(false),
+        _workStealing(false),
         _taskRecords(),
         _workers(),
         _threads(),
+        _taskQueues(std::make_shared<TaskQueueList>()),
+        _queuedTaskCount(0),
+        _nextTaskQueueIndex(0),
         _condition(),
-        _mutex()
+        _mutex(),
+        _statisticsState(),
+        _statisticsMutex()
     {
     }
     
@@ -40,6 +49,12 @@ namespace carto {
         
         _workers.clear();
         _threads.clear();
+        recordWorkerCount(0);
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            updateTaskQueues();
+        }
     }
     
     int CancelableThreadPool::getPoolSize() const {
@@ -57,6 +72,36 @@ namespace carto {
         // Note: won't have an immediate effect
         _poolSize = poolSize;
     }
+
+    bool CancelableThreadPool::isWorkStealing() const {
+        return _workStealing.load();
+    }
+
+    void CancelableThreadPool::setWorkStealing(bool workStealing) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (_stop || _workStealing == workStealing) {
+            return;
+        }
+
+        _workStealing = workStealing;
+        if (workStealing) {
+            // Move tasks from the shared queue to worker queues
+            updateTaskQueues();
+        } else {
+            // Move tasks from worker queues back to the shared queue, keeping the original order within each worker queue
+            for (const std::shared_ptr<TaskQueue>& taskQueue : *_taskQueues) {
+                std::vector<TaskRecord> taskRecords;
+                taskQueue->popAll(taskRecords);
+                _queuedTaskCount -= static_cast<int>(taskRecords.size());
+                for (TaskRecord& taskRecord : taskRecords) {
+                    taskRecord._sequence = _taskCount++;
+                    _taskRecords.push(taskRecord);
+                }
+            }
+        }
+        _condition.notify_all();
+    }
     
     void CancelableThreadPool::execute(std::shared_ptr<CancelableTask> task) {
         execute(task, DEFAULT_PRIORITY);
@@ -70,17 +115,15 @@ namespace carto {
                 return;
             }
     
-            // Push task to queue, increase global task count
-            _taskRecords.push(TaskRecord(task, priority, _taskCount));
-            _taskCount++;
-
             // Check if we need to create a new worker.
+            std::shared_ptr<TaskWorker> targetWorker;
             bool createWorker = static_cast<int>(_threads.size()) < _poolSize;
             if (!createWorker) {
                 bool foundIdleWorker = false;
                 for (std::shared_ptr<TaskWorker>& worker : _workers) {
                     if (worker->_priority == std::numeric_limits<int>::min()) {
                         worker->_priority = priority;
+                        targetWorker = worker;
                         foundIdleWorker = true;
                         break;
                     }
@@ -98,7 +141,24 @@ namespace carto {
             if (createWorker) {
                 Log::Debugf("CancelableThreadPool: Adding worker to the pool (size %d)", (int)_workers.size());
                 _workers.push_back(std::make_shared<TaskWorker>(shared_from_this(), priority));
+                updateTaskQueues();
+                targetWorker = _workers.back();
+            }
+
+            recordTaskQueued(*task, priority);
+
+            if (_workStealing) {
+                // Push task to the queue of the selected worker, other workers can steal it if they are idle
+                pushQueuedTask(task, priority, targetWorker);
+            } else {
+                // Push task to queue, increase global task count
+                _taskRecords.push(TaskRecord(task, priority, _taskCount));
+                _taskCount++;
+            }
+
+            if (createWorker) {
                 _threads.push_back(std::thread(&TaskWorker::operator(), _workers.back()));
+                recordWorkerCount(static_cast<int>(_threads.size()));
             }
     
             // If there are any waiting threads, notify all of them as not all workers may be able to process the task
@@ -106,6 +166,72 @@ namespace carto {
         }
     }
     
+    void CancelableThreadPool::reprioritize(const TaskRankFunction& rankFunc) {
+        typedef std::pair<double, TaskRecord> RankedTaskRecord;
+
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        // Collect all queued tasks in their current execution order
+        std::vector<TaskRecord> taskRecords;
+        taskRecords.reserve(_taskRecords.size());
+        while (!_taskRecords.empty()) {
+            taskRecords.push_back(_taskRecords.top());
+            _taskRecords.pop();
+        }
+        for (const std::shared_ptr<TaskQueue>& taskQueue : *_taskQueues) {
+            std::size_t offset = taskRecords.size();
+            taskQueue->popAll(taskRecords);
+            _queuedTaskCount -= static_cast<int>(taskRecords.size() - offset);
+        }
+
+        // Drop canceled tasks and assign new priorities and ranks
+        std::vector<TaskRecord> activeTaskRecords;
+        std::vector<std::size_t> rankedIndices;
+        std::vector<RankedTaskRecord> rankedTaskRecords;
+        activeTaskRecords.reserve(taskRecords.size());
+        for (TaskRecord& taskRecord : taskRecords) {
+            if (taskRecord._task->isCanceled()) {
+                recordTasksCanceled(1);
+                continue;
+            }
+            double rank = 0;
+            if (rankFunc(taskRecord._task, taskRecord._priority, rank)) {
+                rankedIndices.push_back(activeTaskRecords.size());
+                rankedTaskRecords.emplace_back(rank, taskRecord);
+            }
+            activeTaskRecords.push_back(taskRecord);
+        }
+
+        // Sort ranked tasks and place them into the slots previously used by ranked tasks, other tasks keep their relative order
+        std::stable_sort(rankedTaskRecords.begin(), rankedTaskRecords.end(), [](const RankedTaskRecord& taskRecord1, const RankedTaskRecord& taskRecord2) {
+            if (taskRecord1.second._priority != taskRecord2.second._priority) {
+                return taskRecord1.second._priority > taskRecord2.second._priority;
+            }
+            return taskRecord1.first < taskRecord2.first;
+        });
+        for (std::size_t i = 0; i < rankedIndices.size(); i++) {
+            activeTaskRecords[rankedIndices[i]] = rankedTaskRecords[i].second;
+        }
+        for (TaskRecord& taskRecord : activeTaskRecords) {
+            taskRecord._sequence = _taskCount++;
+        }
+
+        // Requeue tasks in the new order
+        if (_workStealing) {
+            std::stable_sort(activeTaskRecords.begin(), activeTaskRecords.end(), [](const TaskRecord& taskRecord1, const TaskRecord& taskRecord2) {
+                return taskRecord2 < taskRecord1;
+            });
+        }
+        for (const TaskRecord& taskRecord : activeTaskRecords) {
+            if (_workStealing) {
+                pushQueuedTask(taskRecord._task, taskRecord._priority, std::shared_ptr<TaskWorker>());
+            } else {
+                _taskRecords.push(taskRecord);
+            }
+        }
+        _condition.notify_all();
+    }
+    
     void CancelableThreadPool::cancelAll() {
         std::lock_guard<std::mutex> lock(_mutex);
         
@@ -115,6 +241,45 @@ namespace carto {
             task->cancel();
             _taskRecords.pop();
         }
+        int canceledCount = static_cast<int>(taskRecordsSize);
+
+        for (const std::shared_ptr<TaskQueue>& taskQueue : *_taskQueues) {
+            std::vector<TaskRecord> taskRecords;
+            taskQueue->popAll(taskRecords);
+            _queuedTaskCount -= static_cast<int>(taskRecords.size());
+            for (const TaskRecord& taskRecord : taskRecords) {
+                taskRecord._task->cancel();
+            }
+            canceledCount += static_cast<int>(taskRecords.size());
+        }
+
+        recordTasksCanceled(canceledCount);
+    }
+
+    CancelableThreadPool::Statistics CancelableThreadPool::getStatistics() const {
+        int poolSize = getPoolSize();
+
+        std::lock_guard<std::mutex> lock(_statisticsMutex);
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        updateWorkerTime(_statisticsState, now);
+
+        Statistics statistics = _statisticsState.statistics;
+        statistics.poolSize = poolSize;
+        if (_statisticsState.workerTime > 0) {
+            statistics.workerUtilization = static_cast<float>(std::min(1.0, _statisticsState.busyTime / _statisticsState.workerTime));
+        }
+        return statistics;
+    }
+
+    void CancelableThreadPool::resetStatistics() {
+        std::lock_guard<std::mutex> lock(_statisticsMutex);
+
+        // Keep the current state of the pool, reset the counters and the histograms
+        StatisticsState state;
+        state.statistics.workerCount = _statisticsState.statistics.workerCount;
+        state.statistics.queuedTaskCount = _statisticsState.statistics.queuedTaskCount;
+        state.statistics.maxQueuedTaskCount = _statisticsState.statistics.queuedTaskCount;
+        _statisticsState = state;
     }
     
     CancelableThreadPool::TaskRecord::TaskRecord(std::shared_ptr<CancelableTask> task, int priority, long long sequence) :
@@ -131,15 +296,74 @@ namespace carto {
         }
         return _sequence > taskRecord._sequence;
     }
+
+    CancelableThreadPool::StatisticsState::StatisticsState() :
+        statistics(),
+        startTime(std::chrono::steady_clock::now()),
+        workerTimeUpdateTime(startTime),
+        workerTime(0),
+        busyTime(0)
+    {
+    }
+
+    CancelableThreadPool::TaskQueue::TaskQueue() :
+        _buckets(),
+        _topPriority(std::numeric_limits<int>::min()),
+        _mutex()
+    {
+    }
+
+    int CancelableThreadPool::TaskQueue::getTopPriority() const {
+        return _topPriority.load();
+    }
+
+    void CancelableThreadPool::TaskQueue::push(const std::shared_ptr<CancelableTask>& task, int priority) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _buckets[priority].push_back(task);
+        _topPriority = _buckets.rbegin()->first;
+    }
+
+    bool CancelableThreadPool::TaskQueue::pop(std::shared_ptr<CancelableTask>& task, int minPriority) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_buckets.empty()) {
+            return false;
+        }
+
+        auto it = std::prev(_buckets.end());
+        if (it->first < minPriority) {
+            return false;
+        }
+        task = it->second.front();
+        it->second.pop_front();
+        if (it->second.empty()) {
+            _buckets.erase(it);
+        }
+        _topPriority = _buckets.empty() ? std::numeric_limits<int>::min() : _buckets.rbegin()->first;
+        return true;
+    }
+
+    void CancelableThreadPool::TaskQueue::popAll(std::vector<TaskRecord>& taskRecords) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto it = _buckets.rbegin(); it != _buckets.rend(); it++) {
+            for (const std::shared_ptr<CancelableTask>& task : it->second) {
+                taskRecords.emplace_back(task, it->first, 0);
+            }
+        }
+        _buckets.clear();
+        _topPriority = std::numeric_limits<int>::min();
+    }
     
     CancelableThreadPool::TaskWorker::TaskWorker(const std::shared_ptr<CancelableThreadPool>& threadPool, int priority) :
         _threadPool(threadPool),
-        _priority(priority)
+        _priority(priority),
+        _taskQueue(std::make_shared<TaskQueue>())
     {
     }
         
     void CancelableThreadPool::TaskWorker::operator ()() {
-        ThreadUtils::SetThreadPriority(ThreadPriority::MINIMUM);
+        if (auto threadPool = _threadPool.lock()) {
+            ThreadUtils::SetThreadRole(threadPool->_threadRole);
+        }
         while (true) {
             auto threadPool = _threadPool.lock();
             if (!threadPool) {
@@ -153,25 +377,21 @@ namespace carto {
                     return;
                 }
                 
-                if (threadPool->_taskRecords.size() == 0) {
+                if (!threadPool->hasPendingTasks()) {
                     threadPool->_condition.wait(lock);
                 }
             }
     
             // Request another task, execute it if it's not null
             while (true) {
-                std::shared_ptr<CancelableTask> task;
-                int priority = DEFAULT_PRIORITY;
-                {
-                    std::lock_guard<std::mutex> lock(threadPool->_mutex);
-                    if (threadPool->_stop) {
-                        return;
-                    }
-                    priority = _priority;
+                if (threadPool->_stop) {
+                    return;
                 }
+                int priority = _priority;
                 
-                if (threadPool->getNextTask(task, priority)) {
-                    task->operator ()();
+                std::shared_ptr<CancelableTask> task;
+                if (threadPool->getNextTask(*this, task, priority)) {
+                    threadPool->runTask(task);
                 } else {
                     if (threadPool->shouldTerminateWorker(*this)) {
                         return;
@@ -189,7 +409,105 @@ namespace carto {
         }
     }
     
-    bool CancelableThreadPool::getNextTask(std::shared_ptr<CancelableTask>& task, int priority) {
+    void CancelableThreadPool::runTask(const std::shared_ptr<CancelableTask>& task) {
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        bool canceled = task->isCanceled();
+        {
+            std::lock_guard<std::mutex> lock(_statisticsMutex);
+            Statistics& statistics = _statisticsState.statistics;
+            statistics.queuedTaskCount = std::max(0, statistics.queuedTaskCount - 1);
+            if (canceled) {
+                statistics.canceledBeforeStartCount++;
+            }
+            if (task->_queueTime >= _statisticsState.startTime) {
+                double waitTime = std::chrono::duration<double, std::milli>(startTime - task->_queueTime).count();
+                AddHistogramSample(statistics.priorityStatistics[task->_queuePriority].waitTime, waitTime);
+            }
+            sampleQueueDepth(_statisticsState, startTime);
+        }
+
+        CancelableTask::SetCurrentTask(task.get());
+        task->operator ()();
+        CancelableTask::SetCurrentTask(nullptr);
+
+        if (!canceled) {
+            std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now();
+            bool canceledWhileRunning = task->isCanceled();
+
+            std::lock_guard<std::mutex> lock(_statisticsMutex);
+            Statistics& statistics = _statisticsState.statistics;
+            if (canceledWhileRunning) {
+                statistics.canceledAfterStartCount++;
+            } else {
+                statistics.completedTaskCount++;
+            }
+            AddHistogramSample(statistics.priorityStatistics[task->_queuePriority].runTime, std::chrono::duration<double, std::milli>(endTime - startTime).count());
+            _statisticsState.busyTime += std::chrono::duration<double>(endTime - std::max(startTime, _statisticsState.startTime)).count();
+        }
+    }
+
+    void CancelableThreadPool::recordTaskQueued(CancelableTask& task, int priority) {
+        // Note: _mutex must be locked by the caller
+        std::lock_guard<std::mutex> lock(_statisticsMutex);
+        task._queueTime = std::chrono::steady_clock::now();
+        task._queuePriority = priority;
+
+        Statistics& statistics = _statisticsState.statistics;
+        statistics.queuedTaskCount++;
+        statistics.maxQueuedTaskCount = std::max(statistics.maxQueuedTaskCount, statistics.queuedTaskCount);
+        sampleQueueDepth(_statisticsState, task._queueTime);
+    }
+
+    void CancelableThreadPool::recordTasksCanceled(int count) {
+        if (count <= 0) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(_statisticsMutex);
+        Statistics& statistics = _statisticsState.statistics;
+        statistics.queuedTaskCount = std::max(0, statistics.queuedTaskCount - count);
+        statistics.canceledBeforeStartCount += count;
+        sampleQueueDepth(_statisticsState, std::chrono::steady_clock::now());
+    }
+
+    void CancelableThreadPool::recordWorkerCount(int workerCount) {
+        std::lock_guard<std::mutex> lock(_statisticsMutex);
+        updateWorkerTime(_statisticsState, std::chrono::steady_clock::now());
+        _statisticsState.statistics.workerCount = workerCount;
+    }
+
+    void CancelableThreadPool::updateWorkerTime(StatisticsState& state, const std::chrono::steady_clock::time_point& time) const {
+        // Note: _statisticsMutex must be locked by the caller
+        state.workerTime += std::chrono::duration<double>(time - state.workerTimeUpdateTime).count() * state.statistics.workerCount;
+        state.workerTimeUpdateTime = time;
+    }
+
+    void CancelableThreadPool::sampleQueueDepth(StatisticsState& state, const std::chrono::steady_clock::time_point& time) const {
+        // Note: _statisticsMutex must be locked by the caller
+        double sampleTime = std::chrono::duration<double>(time - state.startTime).count();
+        std::deque<QueueDepthSample>& queueDepth = state.statistics.queueDepth;
+        if (!queueDepth.empty() && sampleTime - queueDepth.back().time < QUEUE_DEPTH_SAMPLE_INTERVAL) {
+            return;
+        }
+        queueDepth.emplace_back(sampleTime, state.statistics.queuedTaskCount);
+        if (queueDepth.size() > MAX_QUEUE_DEPTH_SAMPLES) {
+            queueDepth.pop_front();
+        }
+    }
+
+    void CancelableThreadPool::AddHistogramSample(TimeHistogram& histogram, double time) {
+        std::size_t bucket = std::lower_bound(HISTOGRAM_BUCKET_LIMITS.begin(), HISTOGRAM_BUCKET_LIMITS.end(), time) - HISTOGRAM_BUCKET_LIMITS.begin();
+        histogram.bucketCounts[bucket]++;
+        histogram.sampleCount++;
+        histogram.totalTime += time;
+        histogram.maxTime = std::max(histogram.maxTime, time);
+    }
+
+    bool CancelableThreadPool::getNextTask(TaskWorker& worker, std::shared_ptr<CancelableTask>& task, int priority) {
+        if (_workStealing) {
+            return getNextQueuedTask(worker, task, priority);
+        }
+
         std::lock_guard<std::mutex> lock(_mutex);
     
         // Return the next highest priority task from the task queue. Assuming it matches the requested priority.
@@ -202,6 +520,91 @@ namespace carto {
         }
         return false;
     }
+
+    bool CancelableThreadPool::getNextQueuedTask(TaskWorker& worker, std::shared_ptr<CancelableTask>& task, int priority) {
+        std::shared_ptr<TaskQueueList> taskQueues = std::atomic_load(&_taskQueues);
+
+        // Find the queue with the highest priority task. Own queue is preferred, other queues are used only if they contain higher priority tasks.
+        std::shared_ptr<TaskQueue> bestTaskQueue = worker._taskQueue;
+        int bestPriority = bestTaskQueue->getTopPriority();
+        for (const std::shared_ptr<TaskQueue>& taskQueue : *taskQueues) {
+            int topPriority = taskQueue->getTopPriority();
+            if (topPriority > bestPriority) {
+                bestTaskQueue = taskQueue;
+                bestPriority = topPriority;
+            }
+        }
+        if (bestPriority < priority) {
+            return false;
+        }
+
+        if (bestTaskQueue->pop(task, priority)) {
+            _queuedTaskCount--;
+            return true;
+        }
+
+        // Another worker emptied the selected queue first, try all queues in order
+        if (worker._taskQueue->pop(task, priority)) {
+            _queuedTaskCount--;
+            return true;
+        }
+        for (const std::shared_ptr<TaskQueue>& taskQueue : *taskQueues) {
+            if (taskQueue->pop(task, priority)) {
+                _queuedTaskCount--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool CancelableThreadPool::hasPendingTasks() const {
+        return !_taskRecords.empty() || _queuedTaskCount > 0;
+    }
+
+    void CancelableThreadPool::pushQueuedTask(const std::shared_ptr<CancelableTask>& task, int priority, const std::shared_ptr<TaskWorker>& worker) {
+        std::shared_ptr<TaskQueue> taskQueue;
+        if (worker) {
+            taskQueue = worker->_taskQueue;
+        } else if (!_taskQueues->empty()) {
+            // Distribute tasks between worker queues in round-robin fashion
+            _nextTaskQueueIndex = (_nextTaskQueueIndex + 1) % _taskQueues->size();
+            taskQueue = _taskQueues->at(_nextTaskQueueIndex);
+        } else {
+            // No workers, keep the task in the shared queue until a worker is created
+            _taskRecords.push(TaskRecord(task, priority, _taskCount));
+            _taskCount++;
+            return;
+        }
+
+        _queuedTaskCount++;
+        taskQueue->push(task, priority);
+    }
+
+    void CancelableThreadPool::redistributeQueuedTasks(const std::shared_ptr<TaskQueue>& taskQueue) {
+        std::vector<TaskRecord> taskRecords;
+        taskQueue->popAll(taskRecords);
+        _queuedTaskCount -= static_cast<int>(taskRecords.size());
+        for (const TaskRecord& taskRecord : taskRecords) {
+            pushQueuedTask(taskRecord._task, taskRecord._priority, std::shared_ptr<TaskWorker>());
+        }
+    }
+
+    void CancelableThreadPool::updateTaskQueues() {
+        auto taskQueues = std::make_shared<TaskQueueList>();
+        for (const std::shared_ptr<TaskWorker>& worker : _workers) {
+            taskQueues->push_back(worker->_taskQueue);
+        }
+        std::atomic_store(&_taskQueues, taskQueues);
+
+        // Move tasks from the shared queue, if the pool had no workers or the mode was just switched
+        if (_workStealing) {
+            while (!_taskRecords.empty() && !_taskQueues->empty()) {
+                const TaskRecord& taskRecord = _taskRecords.top();
+                pushQueuedTask(taskRecord._task, taskRecord._priority, std::shared_ptr<TaskWorker>());
+                _taskRecords.pop();
+            }
+        }
+    }
     
     bool CancelableThreadPool::shouldTerminateWorker(TaskWorker& worker) {
         std::lock_guard<std::mutex> lock(_mutex);
@@ -218,9 +621,15 @@ namespace carto {
                 if (_workers[index].get() == &worker) {
                     // Remove thread and worker
                     Log::Debugf("CancelableThreadPool: Removing worker from the pool (size %d)", (int)index);
+                    std::shared_ptr<TaskQueue> taskQueue = worker._taskQueue;
                     _workers.erase(_workers.begin() + index);
                     _threads.at(index).detach();
                     _threads.erase(_threads.begin() + index);
+                    recordWorkerCount(static_cast<int>(_threads.size()));
+
+                    // Hand over any tasks left in the worker queue
+                    updateTaskQueues();
+                    redistributeQueuedTasks(taskQueue);
                     break;
                 }
             }
@@ -229,6 +638,12 @@ namespace carto {
         return false;
     }
 
+    const std::vector<double> CancelableThreadPool::HISTOGRAM_BUCKET_LIMITS = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000 };
+
     const int CancelableThreadPool::DEFAULT_PRIORITY = 0;
+
+    const std::size_t CancelableThreadPool::MAX_QUEUE_DEPTH_SAMPLES = 600;
+
+    const double CancelableThreadPool::QUEUE_DEPTH_SAMPLE_INTERVAL = 0.1;
     
 }
@@ -9,27 +9,89 @@
 
 #include "components/CancelableTask.h"
 #include "components/ThreadWorker.h"
+#include "utils/ThreadUtils.h"
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <thread>
+#include <vector>
 
 namespace carto {
 
     class CancelableThreadPool : public std::enable_shared_from_this<CancelableThreadPool> {
     public:
-        CancelableThreadPool();
+        typedef std::function<bool(const std::shared_ptr<CancelableTask>& task, int& priority, double& rank)> TaskRankFunction;
+
+        /**
+         * Task time histogram, in milliseconds.
+         */
+        struct TimeHistogram {
+            TimeHistogram() : sampleCount(0), totalTime(0), maxTime(0), bucketCounts(HISTOGRAM_BUCKET_LIMITS.size() + 1, 0) { }
+
+            long long sampleCount;
+            double totalTime;
+            double maxTime;
+            std::vector<long long> bucketCounts; // bucket i counts the times up to HISTOGRAM_BUCKET_LIMITS[i], the last bucket is unbounded
+        };
+
+        struct PriorityStatistics {
+            TimeHistogram waitTime; // time between queuing and starting the task
+            TimeHistogram runTime; // time spent running the task, tasks canceled before starting are not included
+        };
+
+        struct QueueDepthSample {
+            QueueDepthSample(double time, int queuedTaskCount) : time(time), queuedTaskCount(queuedTaskCount) { }
+
+            double time; // seconds since the statistics were reset
+            int queuedTaskCount;
+        };
+
+        /**
+         * Thread pool statistics snapshot, collected since the statistics were last reset.
+         */
+        struct Statistics {
+            Statistics() : poolSize(0), workerCount(0), queuedTaskCount(0), maxQueuedTaskCount(0), completedTaskCount(0), canceledBeforeStartCount(0), canceledAfterStartCount(0), workerUtilization(0), queueDepth(), priorityStatistics() { }
+
+            int poolSize;
+            int workerCount;
+            int queuedTaskCount;
+            int maxQueuedTaskCount;
+            long long completedTaskCount;
+            long long canceledBeforeStartCount; // tasks canceled while queued
+            long long canceledAfterStartCount; // tasks canceled while running
+            float workerUtilization; // share of the worker thread time spent running tasks, in range [0..1]
+            std::deque<QueueDepthSample> queueDepth; // queue depth over time, only the latest samples are kept
+            std::map<int, PriorityStatistics> priorityStatistics; // statistics per task priority
+        };
+
+        static const std::vector<double> HISTOGRAM_BUCKET_LIMITS;
+
+        explicit CancelableThreadPool(ThreadRole::ThreadRole threadRole = ThreadRole::BACKGROUND);
         virtual ~CancelableThreadPool();
         void deinit();
     
         int getPoolSize() const;
         void setPoolSize(int threadCount);
+
+        bool isWorkStealing() const;
+        void setWorkStealing(bool workStealing);
     
         void execute(std::shared_ptr<CancelableTask>);
         void execute(std::shared_ptr<CancelableTask>, int priority);
     
+        void reprioritize(const TaskRankFunction& rankFunc);
+
         void cancelAll();
+
+        Statistics getStatistics() const;
+        void resetStatistics();
         
     private:
         struct TaskRecord {
@@ -41,6 +103,21 @@ namespace carto {
             int _priority;
             long long _sequence;
         };
+
+        struct TaskQueue {
+            TaskQueue();
+
+            int getTopPriority() const;
+            void push(const std::shared_ptr<CancelableTask>& task, int priority);
+            bool pop(std::shared_ptr<CancelableTask>& task, int minPriority);
+            void popAll(std::vector<TaskRecord>& taskRecords);
+            
+            std::map<int, std::deque<std::shared_ptr<CancelableTask> > > _buckets; // ordered by priority, FIFO order inside a bucket
+            std::atomic<int> _topPriority; // cached highest bucket priority, allows peeking without locking
+            mutable std::mutex _mutex;
+        };
+
+        typedef std::vector<std::shared_ptr<TaskQueue> > TaskQueueList;
     
         struct TaskWorker : public ThreadWorker {
             TaskWorker(const std::shared_ptr<CancelableThreadPool>& threadPool, int priority);
@@ -48,25 +125,64 @@ namespace carto {
             void operator()();
     
             std::weak_ptr<CancelableThreadPool> _threadPool;
-            int _priority; // mutable, guarded by _threadPool->_mutex
+            std::atomic<int> _priority; // written under _threadPool->_mutex
+            std::shared_ptr<TaskQueue> _taskQueue;
         };
     
-        bool getNextTask(std::shared_ptr<CancelableTask>& task, int priority);
+        struct StatisticsState {
+            StatisticsState();
+
+            Statistics statistics;
+            std::chrono::steady_clock::time_point startTime;
+            std::chrono::steady_clock::time_point workerTimeUpdateTime;
+            double workerTime; // total lifetime of the worker threads, in seconds
+            double busyTime; // total time spent running tasks, in seconds
+        };
+
+        void runTask(const std::shared_ptr<CancelableTask>& task);
+
+        void recordTaskQueued(CancelableTask& task, int priority);
+        void recordTasksCanceled(int count);
+        void recordWorkerCount(int workerCount);
+        void updateWorkerTime(StatisticsState& state, const std::chrono::steady_clock::time_point& time) const;
+        void sampleQueueDepth(StatisticsState& state, const std::chrono::steady_clock::time_point& time) const;
+
+        static void AddHistogramSample(TimeHistogram& histogram, double time);
+
+        bool getNextTask(TaskWorker& worker, std::shared_ptr<CancelableTask>& task, int priority);
+        bool getNextQueuedTask(TaskWorker& worker, std::shared_ptr<CancelableTask>& task, int priority);
+
+        bool hasPendingTasks() const;
+
+        void pushQueuedTask(const std::shared_ptr<CancelableTask>& task, int priority, const std::shared_ptr<TaskWorker>& worker);
+        void redistributeQueuedTasks(const std::shared_ptr<TaskQueue>& taskQueue);
+        void updateTaskQueues();
     
         bool shouldTerminateWorker(TaskWorker& worker);
     
         static const int DEFAULT_PRIORITY;
+        static const std::size_t MAX_QUEUE_DEPTH_SAMPLES;
+        static const double QUEUE_DEPTH_SAMPLE_INTERVAL;
     
+        const ThreadRole::ThreadRole _threadRole;
         int _poolSize;
         long long _taskCount;
-        bool _stop;
+        std::atomic<bool> _stop;
+        std::atomic<bool> _workStealing;
     
         std::priority_queue<TaskRecord> _taskRecords;
         std::vector<std::shared_ptr<TaskWorker> > _workers;
         std::vector<std::thread> _threads;
+
+        std::shared_ptr<TaskQueueList> _taskQueues; // copy-on-write snapshot of worker queues, replaced under _mutex
+        std::atomic<int> _queuedTaskCount;
+        std::size_t _nextTaskQueueIndex;
     
         std::condition_variable _condition;
         mutable std::mutex _mutex;
+
+        mutable StatisticsState _statisticsState;
+        mutable std::mutex _statisticsMutex; // locked after _mutex if both are needed
     };
     
 }
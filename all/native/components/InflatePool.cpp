@@ -0,0 +1,130 @@
+#include "InflatePool.h"
+#include "utils/Log.h"
+
+#include <algorithm>
+
+#include <zlib.h>
+
+namespace carto {
+
+    struct InflatePool::Context {
+        z_stream stream;
+        int windowBits;
+        std::vector<unsigned char> buffer;
+
+        Context() : stream(), windowBits(0), buffer() { }
+
+        ~Context() {
+            if (windowBits != 0) {
+                inflateEnd(&stream);
+            }
+        }
+    };
+
+    InflatePool& InflatePool::GetInstance() {
+        static InflatePool pool;
+        return pool;
+    }
+
+    InflatePool::~InflatePool() {
+    }
+
+    bool InflatePool::inflateRaw(const unsigned char* data, std::size_t size, const unsigned char* dictionary, std::size_t dictionarySize, std::vector<unsigned char>& out) {
+        return inflate(data, size, -MAX_WBITS, dictionary, dictionarySize, out);
+    }
+
+    bool InflatePool::inflateGzip(const unsigned char* data, std::size_t size, std::vector<unsigned char>& out) {
+        return inflate(data, size, MAX_WBITS + 16, nullptr, 0, out);
+    }
+
+    InflatePool::InflatePool() :
+        _contexts(),
+        _mutex()
+    {
+    }
+
+    std::unique_ptr<InflatePool::Context> InflatePool::acquireContext() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_contexts.empty()) {
+            return std::unique_ptr<Context>(new Context());
+        }
+        std::unique_ptr<Context> context = std::move(_contexts.back());
+        _contexts.pop_back();
+        return context;
+    }
+
+    void InflatePool::releaseContext(std::unique_ptr<Context> context) {
+        if (context->buffer.capacity() > MAX_BUFFER_SIZE) {
+            std::vector<unsigned char>().swap(context->buffer); // do not keep buffers of exceptionally large tiles
+        }
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_contexts.size() < MAX_IDLE_CONTEXTS) {
+            _contexts.push_back(std::move(context));
+        }
+    }
+
+    bool InflatePool::inflate(const unsigned char* data, std::size_t size, int windowBits, const unsigned char* dictionary, std::size_t dictionarySize, std::vector<unsigned char>& out) {
+        std::unique_ptr<Context> context = acquireContext();
+        z_stream& stream = context->stream;
+
+        // Reuse the existing stream if possible, this avoids reallocating the inflate state and window
+        int result = Z_OK;
+        if (context->windowBits == 0) {
+            result = inflateInit2(&stream, windowBits);
+        } else if (context->windowBits != windowBits) {
+            result = inflateReset2(&stream, windowBits);
+        } else {
+            result = inflateReset(&stream);
+        }
+        if (result != Z_OK) {
+            Log::Errorf("InflatePool::inflate: Failed to initialize inflate stream: %d", result);
+            return false;
+        }
+        context->windowBits = windowBits;
+
+        if (dictionary) {
+            // Raw deflate streams need the dictionary to be set before inflating
+            result = inflateSetDictionary(&stream, dictionary, static_cast<uInt>(dictionarySize));
+            if (result != Z_OK) {
+                releaseContext(std::move(context));
+                return false;
+            }
+        }
+
+        std::vector<unsigned char>& buffer = context->buffer;
+        if (buffer.size() < size * 2 + 1024) {
+            buffer.resize(std::max(buffer.capacity(), size * 2 + 1024));
+        }
+        stream.next_in = const_cast<Bytef*>(data);
+        stream.avail_in = static_cast<uInt>(size);
+        std::size_t outSize = 0;
+        while (true) {
+            stream.next_out = buffer.data() + outSize;
+            stream.avail_out = static_cast<uInt>(buffer.size() - outSize);
+            result = ::inflate(&stream, Z_NO_FLUSH);
+            outSize = buffer.size() - stream.avail_out;
+            if (result == Z_STREAM_END) {
+                break;
+            }
+            if (result != Z_OK && result != Z_BUF_ERROR) {
+                releaseContext(std::move(context));
+                return false;
+            }
+            if (stream.avail_out != 0) {
+                releaseContext(std::move(context));
+                return false; // truncated input
+            }
+            buffer.resize(buffer.size() * 2);
+        }
+
+        // Append the result using a single allocation
+        out.reserve(out.size() + outSize);
+        out.insert(out.end(), buffer.begin(), buffer.begin() + outSize);
+        releaseContext(std::move(context));
+        return true;
+    }
+
+    const unsigned int InflatePool::MAX_IDLE_CONTEXTS = 16;
+    const std::size_t InflatePool::MAX_BUFFER_SIZE = 4 * 1024 * 1024;
+
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_INFLATEPOOL_H_
+#define _CARTO_INFLATEPOOL_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace carto {
+
+    /**
+     * Pool of reusable zlib inflate contexts and output buffers.
+     * Creating a new inflate stream and growing a new output buffer for each tile is expensive,
+     * the pool keeps the streams and buffers of previous decompressions and resets them instead.
+     * The pool is thread-safe, each concurrent decompression uses its own context.
+     */
+    class InflatePool {
+    public:
+        /**
+         * Returns the shared instance of the pool.
+         * @return The shared pool instance.
+         */
+        static InflatePool& GetInstance();
+
+        virtual ~InflatePool();
+
+        /**
+         * Decompresses raw deflate stream, optionally using a preset dictionary.
+         * The decompressed data is appended to the output vector.
+         * @param data The compressed data.
+         * @param size The size of the compressed data.
+         * @param dictionary The preset dictionary or null if no dictionary is used.
+         * @param dictionarySize The size of the dictionary.
+         * @param out The output vector for the decompressed data.
+         * @return True if the data was decompressed successfully, false otherwise.
+         */
+        bool inflateRaw(const unsigned char* data, std::size_t size, const unsigned char* dictionary, std::size_t dictionarySize, std::vector<unsigned char>& out);
+
+        /**
+         * Decompresses gzip stream. The decompressed data is appended to the output vector.
+         * @param data The compressed data.
+         * @param size The size of the compressed data.
+         * @param out The output vector for the decompressed data.
+         * @return True if the data was decompressed successfully, false otherwise.
+         */
+        bool inflateGzip(const unsigned char* data, std::size_t size, std::vector<unsigned char>& out);
+
+    private:
+        struct Context;
+
+        InflatePool();
+
+        std::unique_ptr<Context> acquireContext();
+        void releaseContext(std::unique_ptr<Context> context);
+
+        bool inflate(const unsigned char* data, std::size_t size, int windowBits, const unsigned char* dictionary, std::size_t dictionarySize, std::vector<unsigned char>& out);
+
+        static const unsigned int MAX_IDLE_CONTEXTS;
+        static const std::size_t MAX_BUFFER_SIZE;
+
+        std::vector<std::unique_ptr<Context> > _contexts; // idle contexts
+        std::mutex _mutex;
+    };
+
+}
+
+#endif
@@ -6,6 +6,7 @@
 #include "utils/PlatformUtils.h"
 #include "utils/NetworkUtils.h"
 #include "utils/Log.h"
+#include "utils/JSONUtils.h"
 
 #include <base64.h>
 #include <chrono>
@@ -360,7 +361,7 @@ namespace carto {
         if (responseData) {
             std::string responseString = std::string(reinterpret_cast<const char*>(responseData->data()), responseData->size());
             picojson::value responseDoc;
-            std::string err = picojson::parse(responseDoc, responseString);
+            std::string err = JSONUtils::ParsePicoJSON(responseDoc, responseString);
             if (!err.empty()) {
                 Log::Warnf("LicenseManager::updateOnlineLicense: Illegal response: %s", err.c_str());
                 return std::string();
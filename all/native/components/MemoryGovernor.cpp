@@ -0,0 +1,241 @@
+#include "MemoryGovernor.h"
+#include "utils/Log.h"
+
+#include <algorithm>
+
+namespace carto {
+
+    MemoryGovernor::Consumer::Consumer(std::size_t capacity, float weight, const std::function<void(std::size_t)>& budgetHandler, const std::function<void(bool)>& trimHandler) :
+        _capacity(capacity),
+        _weight(std::max(0.0f, weight)),
+        _budget(capacity),
+        _detached(false),
+        _budgetHandler(budgetHandler),
+        _trimHandler(trimHandler),
+        _mutex()
+    {
+    }
+
+    MemoryGovernor::Consumer::~Consumer() {
+    }
+
+    std::size_t MemoryGovernor::Consumer::getCapacity() const {
+        return _capacity.load();
+    }
+
+    void MemoryGovernor::Consumer::setCapacity(std::size_t capacity) {
+        _capacity.store(capacity);
+        MemoryGovernor::GetInstance().distributeBudget();
+    }
+
+    float MemoryGovernor::Consumer::getWeight() const {
+        return _weight.load();
+    }
+
+    void MemoryGovernor::Consumer::setWeight(float weight) {
+        _weight.store(std::max(0.0f, weight));
+        MemoryGovernor::GetInstance().distributeBudget();
+    }
+
+    std::size_t MemoryGovernor::Consumer::getBudget() const {
+        return _budget.load();
+    }
+
+    void MemoryGovernor::Consumer::detach() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_detached.exchange(true)) {
+                return;
+            }
+            _budgetHandler = std::function<void(std::size_t)>();
+            _trimHandler = std::function<void(bool)>();
+        }
+        MemoryGovernor::GetInstance().distributeBudget();
+    }
+
+    bool MemoryGovernor::Consumer::isDetached() const {
+        return _detached.load();
+    }
+
+    void MemoryGovernor::Consumer::applyBudget(std::size_t budget) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_detached.load()) {
+            return;
+        }
+        if (_budget.exchange(budget) != budget) {
+            if (_budgetHandler) {
+                _budgetHandler(budget);
+            }
+        }
+    }
+
+    void MemoryGovernor::Consumer::trim(bool critical) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_detached.load()) {
+            return;
+        }
+        if (_trimHandler) {
+            _trimHandler(critical);
+        }
+    }
+
+    MemoryGovernor& MemoryGovernor::GetInstance() {
+        static MemoryGovernor instance;
+        return instance;
+    }
+
+    MemoryGovernor::~MemoryGovernor() {
+    }
+
+    std::size_t MemoryGovernor::getTotalBudget() const {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return _totalBudget;
+    }
+
+    void MemoryGovernor::setTotalBudget(std::size_t budgetInBytes) {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _totalBudget = budgetInBytes;
+        distributeBudget();
+    }
+
+    std::shared_ptr<MemoryGovernor::Consumer> MemoryGovernor::registerConsumer(std::size_t capacity, float weight, const std::function<void(std::size_t)>& budgetHandler, const std::function<void(bool)>& trimHandler) {
+        auto consumer = std::make_shared<Consumer>(capacity, weight, budgetHandler, trimHandler);
+
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _consumers.push_back(consumer);
+        distributeBudget();
+        return consumer;
+    }
+
+    void MemoryGovernor::onMemoryWarning(bool critical) {
+        Log::Infof("MemoryGovernor::onMemoryWarning: Releasing caches (critical=%d)", critical ? 1 : 0);
+
+        std::vector<std::shared_ptr<Consumer> > consumers;
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            for (const std::weak_ptr<Consumer>& consumerWeak : _consumers) {
+                if (auto consumer = consumerWeak.lock()) {
+                    consumers.push_back(consumer);
+                }
+            }
+        }
+
+        for (const std::shared_ptr<Consumer>& consumer : consumers) {
+            consumer->trim(critical);
+        }
+    }
+
+    std::size_t MemoryGovernor::getGPUBudget() const {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return _gpuBudget;
+    }
+
+    void MemoryGovernor::setGPUBudget(std::size_t budgetInBytes) {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _gpuBudget = budgetInBytes;
+        _gpuBudgetExceeded = false;
+    }
+
+    std::size_t MemoryGovernor::getGPUMemoryUsage() const {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return _gpuMemoryUsage;
+    }
+
+    void MemoryGovernor::updateGPUMemoryUsage(std::size_t oldSize, std::size_t newSize) {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _gpuMemoryUsage -= std::min(oldSize, _gpuMemoryUsage);
+        _gpuMemoryUsage += newSize;
+    }
+
+    void MemoryGovernor::checkGPUBudget() {
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            if (_gpuBudget == 0 || _gpuMemoryUsage <= _gpuBudget) {
+                _gpuBudgetExceeded = false;
+                return;
+            }
+            // Trim only once when the budget is exceeded, trimming every frame would release the tiles still loading
+            if (_gpuBudgetExceeded) {
+                return;
+            }
+            _gpuBudgetExceeded = true;
+            Log::Infof("MemoryGovernor::checkGPUBudget: GPU memory usage %d KB exceeds the budget %d KB", static_cast<int>(_gpuMemoryUsage / 1024), static_cast<int>(_gpuBudget / 1024));
+        }
+        onMemoryWarning(false);
+    }
+
+    MemoryGovernor::MemoryGovernor() :
+        _consumers(),
+        _totalBudget(0),
+        _gpuBudget(0),
+        _gpuMemoryUsage(0),
+        _gpuBudgetExceeded(false),
+        _mutex()
+    {
+    }
+
+    void MemoryGovernor::distributeBudget() {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+        std::vector<std::shared_ptr<Consumer> > consumers;
+        for (auto it = _consumers.begin(); it != _consumers.end(); ) {
+            std::shared_ptr<Consumer> consumer = it->lock();
+            if (!consumer || consumer->isDetached()) {
+                it = _consumers.erase(it);
+                continue;
+            }
+            consumers.push_back(consumer);
+            it++;
+        }
+
+        std::vector<std::size_t> budgets(consumers.size(), 0);
+        if (_totalBudget == 0) {
+            for (std::size_t i = 0; i < consumers.size(); i++) {
+                budgets[i] = consumers[i]->getCapacity();
+            }
+        } else {
+            // Water-filling: share the remaining budget by weight, consumers needing less than their share are capped
+            // at their capacity and the rest is redistributed between the other consumers.
+            std::vector<bool> capped(consumers.size(), false);
+            std::size_t remainingBudget = _totalBudget;
+            while (true) {
+                double totalWeight = 0;
+                for (std::size_t i = 0; i < consumers.size(); i++) {
+                    if (!capped[i]) {
+                        totalWeight += consumers[i]->getWeight();
+                    }
+                }
+                if (totalWeight <= 0) {
+                    break;
+                }
+
+                bool changed = false;
+                for (std::size_t i = 0; i < consumers.size(); i++) {
+                    if (capped[i]) {
+                        continue;
+                    }
+                    double share = remainingBudget * (consumers[i]->getWeight() / totalWeight);
+                    if (consumers[i]->getCapacity() <= share) {
+                        budgets[i] = consumers[i]->getCapacity();
+                        remainingBudget -= budgets[i];
+                        capped[i] = true;
+                        changed = true;
+                    }
+                }
+                if (!changed) {
+                    for (std::size_t i = 0; i < consumers.size(); i++) {
+                        if (!capped[i]) {
+                            budgets[i] = static_cast<std::size_t>(remainingBudget * (consumers[i]->getWeight() / totalWeight));
+                        }
+                    }
+                    break;
+                }
+            }
+        }
+
+        for (std::size_t i = 0; i < consumers.size(); i++) {
+            consumers[i]->applyBudget(budgets[i]);
+        }
+    }
+
+}
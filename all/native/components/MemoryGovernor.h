@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_MEMORYGOVERNOR_H_
+#define _CARTO_MEMORYGOVERNOR_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace carto {
+
+    /**
+     * Distributes a single memory budget between the caches of all layers and data sources.
+     * Each cache registers itself as a consumer with its own capacity and weight. If the total budget is set,
+     * the budget is shared in proportion to the weights, consumers needing less than their share
+     * leave the rest to the other consumers. If the total budget is not set, every consumer uses its own capacity.
+     * The governor also forwards OS memory warnings to the consumers, so preloading caches can be released first.
+     */
+    class MemoryGovernor {
+    public:
+        class Consumer {
+        public:
+            Consumer(std::size_t capacity, float weight, const std::function<void(std::size_t)>& budgetHandler, const std::function<void(bool)>& trimHandler);
+            virtual ~Consumer();
+
+            std::size_t getCapacity() const;
+            void setCapacity(std::size_t capacity);
+
+            float getWeight() const;
+            void setWeight(float weight);
+
+            std::size_t getBudget() const;
+
+            // Must be called before the resources used by the handlers are released, the handlers are not called after this
+            void detach();
+
+        private:
+            friend class MemoryGovernor;
+
+            bool isDetached() const;
+            void applyBudget(std::size_t budget);
+            void trim(bool critical);
+
+            std::atomic<std::size_t> _capacity;
+            std::atomic<float> _weight;
+            std::atomic<std::size_t> _budget;
+            std::atomic<bool> _detached;
+            std::function<void(std::size_t)> _budgetHandler;
+            std::function<void(bool)> _trimHandler;
+            mutable std::mutex _mutex; // held while the handlers are called
+        };
+
+        /**
+         * Returns the shared instance of the governor.
+         * @return The shared governor instance.
+         */
+        static MemoryGovernor& GetInstance();
+
+        virtual ~MemoryGovernor();
+
+        /**
+         * Returns the total memory budget of all registered caches.
+         * @return The total memory budget in bytes. 0 if the budget is not set.
+         */
+        std::size_t getTotalBudget() const;
+        /**
+         * Sets the total memory budget of all registered caches.
+         * @param budgetInBytes The new total budget in bytes. If 0, each cache uses its own capacity.
+         */
+        void setTotalBudget(std::size_t budgetInBytes);
+
+        /**
+         * Registers a new cache with the governor. The budget handler is called immediately with the initial budget.
+         * @param capacity The capacity requested by the cache.
+         * @param weight The weight of the cache used when distributing the total budget.
+         * @param budgetHandler The handler receiving the budget of the cache.
+         * @param trimHandler The handler called on memory warnings. The argument is true for critical warnings.
+         * @return The consumer object. The consumer is unregistered when it is detached or released.
+         */
+        std::shared_ptr<Consumer> registerConsumer(std::size_t capacity, float weight, const std::function<void(std::size_t)>& budgetHandler, const std::function<void(bool)>& trimHandler);
+
+        /**
+         * Forwards an OS memory warning to all registered caches.
+         * On moderate warnings only preloading caches should be released, on critical warnings all caches not needed for the current view.
+         * @param critical True if the warning is critical.
+         */
+        void onMemoryWarning(bool critical);
+
+        /**
+         * Returns the GPU memory budget of all map views.
+         * @return The GPU memory budget in bytes. 0 if the budget is not set.
+         */
+        std::size_t getGPUBudget() const;
+        /**
+         * Sets the GPU memory budget of all map views. When the GPU memory reported by the graphics resources
+         * exceeds the budget, the caches are trimmed as on moderate memory warnings.
+         * @param budgetInBytes The new GPU memory budget in bytes. If 0, GPU memory usage is not limited.
+         */
+        void setGPUBudget(std::size_t budgetInBytes);
+        /**
+         * Returns the GPU memory currently reported by the graphics resources of all map views.
+         * @return The GPU memory usage in bytes.
+         */
+        std::size_t getGPUMemoryUsage() const;
+
+        // Called by the GL resource managers when the size of a resource changes
+        void updateGPUMemoryUsage(std::size_t oldSize, std::size_t newSize);
+        // Called from the GL thread once per frame, trims the caches when the GPU budget is exceeded
+        void checkGPUBudget();
+
+    private:
+        MemoryGovernor();
+
+        void distributeBudget();
+
+        std::vector<std::weak_ptr<Consumer> > _consumers;
+        std::size_t _totalBudget;
+        std::size_t _gpuBudget;
+        std::size_t _gpuMemoryUsage;
+        bool _gpuBudgetExceeded;
+        mutable std::recursive_mutex _mutex;
+    };
+
+}
+
+#endif
@@ -29,6 +29,11 @@ namespace carto {
         _dpi(160.0f),
         _drawDistance(16),
         _fovY(70),
+        _interactionFPS(0.0f),
+        _animationFPS(30.0f),
+        _idleFPS(15.0f),
+        _frameSynchronousScheduling(false),
+        _shaderCacheDirectory(),
         _panningMode(PanningMode::PANNING_MODE_FREE),
         _pivotMode(PivotMode::PIVOT_MODE_TOUCHPOINT),
         _seamlessPanning(true),
@@ -60,8 +65,13 @@ namespace carto {
         _tileThreadPool(tileThreadPool),
         _mutex()
     {
-        setEnvelopeThreadPoolSize(1);
-        setTileThreadPoolSize(1);
+        // Thread pools shared with other map views keep their current size
+        if (_envelopeThreadPool->getPoolSize() == 0) {
+            setEnvelopeThreadPoolSize(1);
+        }
+        if (_tileThreadPool->getPoolSize() == 0) {
+            setTileThreadPoolSize(1);
+        }
     }
     
     Options::~Options() {
@@ -118,7 +128,6 @@ namespace carto {
     }
     
     RenderProjectionMode::RenderProjectionMode Options::getRenderProjectionMode() const {
-        std::lock_guard<std::mutex> lock(_mutex);
         return _renderProjectionMode;
     }
     
@@ -143,7 +152,6 @@ namespace carto {
     }
     
     bool Options::isClickTypeDetection() const {
-        std::lock_guard<std::mutex> lock(_mutex);
         return _clickTypeDetection;
     }
     
@@ -159,7 +167,6 @@ namespace carto {
     }
     
     int Options::getTileDrawSize() const {
-        std::lock_guard<std::mutex> lock(_mutex);
         return _tileDrawSize;
     }
     
@@ -175,7 +182,6 @@ namespace carto {
     }
     
     float Options::getDPI() const {
-        std::lock_guard<std::mutex> lock(_mutex);
         return _dpi;
     }
     
@@ -191,7 +197,6 @@ namespace carto {
     }
     
     float Options::getDrawDistance() const {
-        std::lock_guard<std::mutex> lock(_mutex);
         return _drawDistance;
     }
     
@@ -207,7 +212,6 @@ namespace carto {
     }
     
     int Options::getFieldOfViewY() const {
-        std::lock_guard<std::mutex> lock(_mutex);
         return _fovY;
     }
     
@@ -221,9 +225,87 @@ namespace carto {
         }
         notifyOptionChanged("FieldOfViewY");
     }
+
+    float Options::getInteractionFPS() const {
+        return _interactionFPS;
+    }
     
-    PanningMode::PanningMode Options::getPanningMode() const {
+    void Options::setInteractionFPS(float fps) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            fps = std::max(0.0f, fps);
+            if (_interactionFPS == fps) {
+                return;
+            }
+            _interactionFPS = fps;
+        }
+        notifyOptionChanged("InteractionFPS");
+    }
+
+    float Options::getAnimationFPS() const {
+        return _animationFPS;
+    }
+    
+    void Options::setAnimationFPS(float fps) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            fps = std::max(0.0f, fps);
+            if (_animationFPS == fps) {
+                return;
+            }
+            _animationFPS = fps;
+        }
+        notifyOptionChanged("AnimationFPS");
+    }
+
+    float Options::getIdleFPS() const {
+        return _idleFPS;
+    }
+    
+    void Options::setIdleFPS(float fps) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            fps = std::max(0.0f, fps);
+            if (_idleFPS == fps) {
+                return;
+            }
+            _idleFPS = fps;
+        }
+        notifyOptionChanged("IdleFPS");
+    }
+
+    bool Options::isFrameSynchronousScheduling() const {
+        return _frameSynchronousScheduling;
+    }
+
+    void Options::setFrameSynchronousScheduling(bool enabled) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_frameSynchronousScheduling == enabled) {
+                return;
+            }
+            _frameSynchronousScheduling = enabled;
+        }
+        notifyOptionChanged("FrameSynchronousScheduling");
+    }
+
+    std::string Options::getShaderCacheDirectory() const {
         std::lock_guard<std::mutex> lock(_mutex);
+        return _shaderCacheDirectory;
+    }
+
+    void Options::setShaderCacheDirectory(const std::string& directory) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_shaderCacheDirectory == directory) {
+                return;
+            }
+            _shaderCacheDirectory = directory;
+        }
+        notifyOptionChanged("ShaderCacheDirectory");
+    }
+    
+    PanningMode::PanningMode Options::getPanningMode() const {
         return _panningMode;
     }
     
@@ -239,7 +321,6 @@ namespace carto {
     }
     
     PivotMode::PivotMode Options::getPivotMode() const {
-        std::lock_guard<std::mutex> lock(_mutex);
         return _pivotMode;
     }
 
@@ -255,7 +336,6 @@ namespace carto {
     }
 
     bool Options::isSeamlessPanning() const {
-        std::lock_guard<std::mutex> lock(_mutex);
         return _seamlessPanning;
     }
     
@@ -271,7 +351,6 @@ namespace carto {
     }
         
     bool Options::isRestrictedPanning() const {
-        std::lock_guard<std::mutex> lock(_mutex);
         return _restrictedPanning;
     }
     
@@ -287,7 +366,6 @@ namespace carto {
     }
         
     bool Options::isTiltGestureReversed() const {
-        std::lock_guard<std::mutex> lock(_mutex);
         return _tiltGestureReversed;
     }
     
@@ -303,7 +381,6 @@ namespace carto {
     }
         
     bool Options::isZoomGestures() const {
-        std::lock_guard<std::mutex> lock(_mutex);
         return _zoomGestures;
     }
     
@@ -349,6 +426,22 @@ namespace carto {
         }
         notifyOptionChanged("TileThreadPoolSize");
     }
+
+    bool Options::isTileThreadPoolWorkStealing() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _tileThreadPool->isWorkStealing();
+    }
+    
+    void Options::setTileThreadPoolWorkStealing(bool workStealing) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_tileThreadPool->isWorkStealing() == workStealing) {
+                return;
+            }
+            _tileThreadPool->setWorkStealing(workStealing);
+        }
+        notifyOptionChanged("TileThreadPoolWorkStealing");
+    }
     
     Color Options::getClearColor() const {
         std::lock_guard<std::mutex> lock(_mutex);
@@ -412,7 +505,6 @@ namespace carto {
     }
     
     float Options::getWatermarkAlignmentX() const {
-        std::lock_guard<std::mutex> lock(_mutex);
         return _watermarkAlignmentX;
     }
     
@@ -429,7 +521,6 @@ namespace carto {
     }
         
     float Options::getWatermarkAlignmentY() const {
-        std::lock_guard<std::mutex> lock(_mutex);
         return _watermarkAlignmentY;
     }
         
@@ -446,7 +537,6 @@ namespace carto {
     }
         
     float Options::getWatermarkScale() const {
-        std::lock_guard<std::mutex> lock(_mutex);
         return _watermarkScale;
     }
         
@@ -494,7 +584,6 @@ namespace carto {
     }
     
     bool Options::isUserInput() const {
-        std::lock_guard<std::mutex> lock(_mutex);
         return _userInput;
     }
     
@@ -510,7 +599,6 @@ namespace carto {
     }
     
     bool Options::isKineticPan() {
-        std::lock_guard<std::mutex> lock(_mutex);
         return _kineticPan;
     }
     
@@ -526,7 +614,6 @@ namespace carto {
     }
     
     bool Options::isKineticRotation() {
-        std::lock_guard<std::mutex> lock(_mutex);
         return _kineticRotation;
     }
     
@@ -542,7 +629,6 @@ namespace carto {
     }
         
     bool Options::isKineticZoom() {
-        std::lock_guard<std::mutex> lock(_mutex);
         return _kineticZoom;
     }
     
@@ -558,7 +644,6 @@ namespace carto {
     }
     
     bool Options::isRotatable() const {
-        std::lock_guard<std::mutex> lock(_mutex);
         return _rotatable;
     }
     
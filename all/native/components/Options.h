@@ -12,8 +12,10 @@
 #include "core/ScreenPos.h"
 #include "graphics/Color.h"
 
+#include <atomic>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <vector>
 
 namespace carto {
@@ -219,6 +221,68 @@ namespace carto {
          * @param fovY The new vertical field of view angle in degrees.
          */
         void setFieldOfViewY(int fovY);
+
+        /**
+         * Returns the target frame rate used while the map is interacted with or the camera is animated.
+         * @return The target frame rate in frames per second. 0 means no limit.
+         */
+        float getInteractionFPS() const;
+        /**
+         * Sets the target frame rate used while the map is interacted with or the camera is animated. The default is 0 (no limit).
+         * @param fps The new target frame rate in frames per second. 0 means no limit.
+         */
+        void setInteractionFPS(float fps);
+        /**
+         * Returns the target frame rate used while only the map content is animated.
+         * @return The target frame rate in frames per second. 0 means no limit.
+         */
+        float getAnimationFPS() const;
+        /**
+         * Sets the target frame rate used while only the map content is animated (for example, clusters are expanding or labels fading).
+         * The default is 30.
+         * @param fps The new target frame rate in frames per second. 0 means no limit.
+         */
+        void setAnimationFPS(float fps);
+        /**
+         * Returns the target frame rate used when the view is redrawn for background updates.
+         * @return The target frame rate in frames per second. 0 means no limit.
+         */
+        float getIdleFPS() const;
+        /**
+         * Sets the target frame rate used when the view is redrawn for background updates only (for example, when tiles are loaded
+         * or slow animations like Torque frames are advanced). The default is 15.
+         * @param fps The new target frame rate in frames per second. 0 means no limit.
+         */
+        void setIdleFPS(float fps);
+
+        /**
+         * Returns the state of the frame synchronous scheduling flag of the background workers.
+         * @return True if frame synchronous scheduling is enabled.
+         */
+        bool isFrameSynchronousScheduling() const;
+        /**
+         * Sets the state of the frame synchronous scheduling flag. If set to true, culling and label/billboard placement
+         * work that becomes due while a frame is drawn is started right after the frame is submitted, placement requests
+         * are not delayed and billboard placement results are applied at the start of the next frame.
+         * This gives predictable label latency during continuous gestures at the cost of more frequent placement calculations.
+         * The default is false.
+         * @param enabled The new state of the frame synchronous scheduling flag.
+         */
+        void setFrameSynchronousScheduling(bool enabled);
+
+        /**
+         * Returns the directory used for caching compiled shader programs.
+         * @return The shader cache directory. Empty if shader programs are not cached.
+         */
+        std::string getShaderCacheDirectory() const;
+        /**
+         * Sets the directory used for caching compiled shader programs. Cached programs speed up the initialization of the map
+         * after the application is started or the rendering surface is recreated. The cache is used only if the OpenGL driver supports
+         * program binaries and the change takes effect when the rendering surface is created next time. The default is empty (no caching),
+         * on Android the application cache directory is used.
+         * @param directory The new shader cache directory. Empty string disables caching.
+         */
+        void setShaderCacheDirectory(const std::string& directory);
     
         /**
          * Returns the panning mode.
@@ -310,6 +374,20 @@ namespace carto {
          * @param poolSize The new tile task thread pool size.
          */
         void setTileThreadPoolSize(int poolSize);
+
+        /**
+         * Returns the state of the work-stealing scheduling mode of the tile task pool.
+         * @return True if work-stealing scheduling is used for tile tasks.
+         */
+        bool isTileThreadPoolWorkStealing() const;
+        /**
+         * Sets the state of the work-stealing scheduling mode of the tile task pool.
+         * In work-stealing mode each worker thread has its own task queue and idle workers take tasks from other workers,
+         * this reduces lock contention when large tile thread pools are used. Task priorities are respected on best-effort basis.
+         * Default is false.
+         * @param workStealing True if work-stealing scheduling should be used.
+         */
+        void setTileThreadPoolWorkStealing(bool workStealing);
     
         /**
          * Returns the clear color used by the renderer before drawing anything else.
@@ -588,28 +666,35 @@ namespace carto {
         Color _mainLightColor;
         MapVec _mainLightDir;
     
-        RenderProjectionMode::RenderProjectionMode _renderProjectionMode;
+        std::atomic<RenderProjectionMode::RenderProjectionMode> _renderProjectionMode;
     
-        bool _clickTypeDetection;
+        std::atomic<bool> _clickTypeDetection;
     
-        int _tileDrawSize;
+        std::atomic<int> _tileDrawSize;
     
-        float _dpi;
+        std::atomic<float> _dpi;
     
-        float _drawDistance;
+        std::atomic<float> _drawDistance;
     
-        int _fovY;
+        std::atomic<int> _fovY;
+
+        std::atomic<float> _interactionFPS;
+        std::atomic<float> _animationFPS;
+        std::atomic<float> _idleFPS;
+        std::atomic<bool> _frameSynchronousScheduling;
+
+        std::string _shaderCacheDirectory;
     
-        PanningMode::PanningMode _panningMode;
+        std::atomic<PanningMode::PanningMode> _panningMode;
         
-        PivotMode::PivotMode _pivotMode;
+        std::atomic<PivotMode::PivotMode> _pivotMode;
     
-        bool _seamlessPanning;
-        bool _restrictedPanning;
+        std::atomic<bool> _seamlessPanning;
+        std::atomic<bool> _restrictedPanning;
 
-        bool _tiltGestureReversed;
+        std::atomic<bool> _tiltGestureReversed;
 
-        bool _zoomGestures;
+        std::atomic<bool> _zoomGestures;
 
         Color _clearColor;
         Color _skyColor;
@@ -619,19 +704,19 @@ namespace carto {
 
         std::shared_ptr<Bitmap> _backgroundBitmap;
         
-        float _watermarkAlignmentX;
-        float _watermarkAlignmentY;
+        std::atomic<float> _watermarkAlignmentX;
+        std::atomic<float> _watermarkAlignmentY;
         std::shared_ptr<Bitmap> _watermarkBitmap;
         ScreenPos _watermarkPadding;
-        float _watermarkScale;
+        std::atomic<float> _watermarkScale;
         
-        bool _userInput;
+        std::atomic<bool> _userInput;
     
-        bool _kineticPan;
-        bool _kineticRotation;
-        bool _kineticZoom;
+        std::atomic<bool> _kineticPan;
+        std::atomic<bool> _kineticRotation;
+        std::atomic<bool> _kineticZoom;
     
-        bool _rotatable;
+        std::atomic<bool> _rotatable;
         MapRange _tiltRange;
         MapRange _zoomRange;
         MapBounds _panBounds;
@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_SHARDEDTILECACHE_H_
+#define _CARTO_SHARDEDTILECACHE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace carto {
+
+    /**
+     * Thread-safe LRU cache keyed by tile id. The elements are distributed between shards
+     * selected by the hash of the tile id, each shard has its own lock. Thus concurrent operations
+     * on different tiles rarely block each other. The capacity is shared by all shards and
+     * the least recently used element of the whole cache is evicted first.
+     * Elements can be given an expiration time, expired elements are kept in the cache but are not valid.
+     */
+    template <typename V>
+    class ShardedTileCache {
+    public:
+        explicit ShardedTileCache(std::size_t capacity) : _shards(), _capacity(capacity), _size(0), _accessCounter(0), _evictionCount(0) { }
+
+        std::size_t capacity() const {
+            return _capacity.load();
+        }
+
+        std::size_t size() const {
+            return _size.load();
+        }
+
+        std::size_t count() const {
+            std::size_t count = 0;
+            for (const Shard& shard : _shards) {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                count += shard.entries.size();
+            }
+            return count;
+        }
+
+        std::uint64_t eviction_count() const {
+            return _evictionCount.load();
+        }
+
+        void resize(std::size_t capacity) {
+            _capacity.store(capacity);
+            evict();
+        }
+
+        void clear() {
+            for (Shard& shard : _shards) {
+                std::unordered_map<long long, Entry> entries; // release the elements outside of the lock
+                {
+                    std::lock_guard<std::mutex> lock(shard.mutex);
+                    std::swap(entries, shard.entries);
+                    shard.lru.clear();
+                    for (auto it = entries.begin(); it != entries.end(); it++) {
+                        _size -= it->second.size;
+                    }
+                }
+            }
+        }
+
+        bool exists(long long tileId) const {
+            const Shard& shard = getShard(tileId);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            return shard.entries.find(tileId) != shard.entries.end();
+        }
+
+        bool valid(long long tileId) const {
+            const Shard& shard = getShard(tileId);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.entries.find(tileId);
+            if (it == shard.entries.end()) {
+                return false;
+            }
+            return !it->second.expires || std::chrono::steady_clock::now() < it->second.expirationTime;
+        }
+
+        bool peek(long long tileId, V& value) const {
+            const Shard& shard = getShard(tileId);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.entries.find(tileId);
+            if (it == shard.entries.end()) {
+                return false;
+            }
+            value = it->second.value;
+            return true;
+        }
+
+        bool read(long long tileId, V& value) {
+            Shard& shard = getShard(tileId);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.entries.find(tileId);
+            if (it == shard.entries.end()) {
+                return false;
+            }
+            touch(shard, it->second);
+            value = it->second.value;
+            return true;
+        }
+
+        V get(long long tileId) {
+            V value = V();
+            read(tileId, value);
+            return value;
+        }
+
+        bool remove(long long tileId) {
+            Entry entry;
+            return take(tileId, entry);
+        }
+
+        void put(long long tileId, const V& value, std::size_t size) {
+            Entry entry;
+            entry.value = value;
+            entry.size = size;
+            insert(tileId, std::move(entry));
+            evict();
+        }
+
+        void invalidate(long long tileId, const std::chrono::steady_clock::time_point& expirationTime) {
+            Shard& shard = getShard(tileId);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.entries.find(tileId);
+            if (it != shard.entries.end()) {
+                it->second.expires = true;
+                it->second.expirationTime = expirationTime;
+            }
+        }
+
+        void invalidate_all(const std::chrono::steady_clock::time_point& expirationTime) {
+            for (Shard& shard : _shards) {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                for (auto it = shard.entries.begin(); it != shard.entries.end(); it++) {
+                    if (!it->second.expires || it->second.expirationTime > expirationTime) {
+                        it->second.expires = true;
+                        it->second.expirationTime = expirationTime;
+                    }
+                }
+            }
+        }
+
+        bool move(long long tileId, ShardedTileCache& other) {
+            if (&other == this) {
+                return exists(tileId);
+            }
+            Entry entry;
+            if (!take(tileId, entry)) {
+                return false;
+            }
+            other.insert(tileId, std::move(entry));
+            other.evict();
+            return true;
+        }
+
+        std::unordered_set<long long> keys() const {
+            std::unordered_set<long long> keys;
+            for (const Shard& shard : _shards) {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                for (auto it = shard.entries.begin(); it != shard.entries.end(); it++) {
+                    keys.insert(it->first);
+                }
+            }
+            return keys;
+        }
+
+    private:
+        enum { SHARD_COUNT = 16 };
+
+        struct Entry {
+            Entry() : value(), size(0), expires(false), expirationTime(), stamp(0), lruIt() { }
+
+            V value;
+            std::size_t size;
+            bool expires;
+            std::chrono::steady_clock::time_point expirationTime;
+            std::uint64_t stamp; // global access order, used to find the least recently used element across shards
+            std::list<long long>::iterator lruIt;
+        };
+
+        struct Shard {
+            Shard() : entries(), lru(), mutex() { }
+
+            std::unordered_map<long long, Entry> entries;
+            std::list<long long> lru; // most recently used first
+            mutable std::mutex mutex;
+        };
+
+        ShardedTileCache(const ShardedTileCache&);
+        ShardedTileCache& operator = (const ShardedTileCache&);
+
+        static std::size_t GetShardIndex(long long tileId) {
+            // Tile ids of neighbouring tiles are close to each other, thus mix the bits before selecting the shard
+            std::uint64_t hash = static_cast<std::uint64_t>(tileId) * 0x9E3779B97F4A7C15ULL;
+            return static_cast<std::size_t>(hash >> 32) % SHARD_COUNT;
+        }
+
+        Shard& getShard(long long tileId) {
+            return _shards[GetShardIndex(tileId)];
+        }
+
+        const Shard& getShard(long long tileId) const {
+            return _shards[GetShardIndex(tileId)];
+        }
+
+        void touch(Shard& shard, Entry& entry) {
+            // Note: shard mutex must be locked by the caller
+            entry.stamp = ++_accessCounter;
+            shard.lru.splice(shard.lru.begin(), shard.lru, entry.lruIt);
+        }
+
+        bool take(long long tileId, Entry& entry) {
+            Shard& shard = getShard(tileId);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.entries.find(tileId);
+            if (it == shard.entries.end()) {
+                return false;
+            }
+            entry = std::move(it->second);
+            shard.lru.erase(entry.lruIt);
+            shard.entries.erase(it);
+            _size -= entry.size;
+            return true;
+        }
+
+        void insert(long long tileId, Entry entry) {
+            Entry oldEntry; // release the replaced element outside of the lock
+            Shard& shard = getShard(tileId);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.entries.find(tileId);
+            if (it != shard.entries.end()) {
+                _size -= it->second.size;
+                entry.lruIt = it->second.lruIt;
+                oldEntry = std::move(it->second);
+                it->second = std::move(entry);
+            } else {
+                shard.lru.push_front(tileId);
+                entry.lruIt = shard.lru.begin();
+                it = shard.entries.emplace(tileId, std::move(entry)).first;
+            }
+            _size += it->second.size;
+            touch(shard, it->second);
+        }
+
+        void evict() {
+            while (_size.load() > _capacity.load()) {
+                // Find the shard containing the least recently used element. Only one shard is locked at a time.
+                Shard* oldestShard = nullptr;
+                std::uint64_t oldestStamp = std::numeric_limits<std::uint64_t>::max();
+                for (Shard& shard : _shards) {
+                    std::lock_guard<std::mutex> lock(shard.mutex);
+                    if (!shard.lru.empty()) {
+                        std::uint64_t stamp = shard.entries.find(shard.lru.back())->second.stamp;
+                        if (stamp < oldestStamp) {
+                            oldestShard = &shard;
+                            oldestStamp = stamp;
+                        }
+                    }
+                }
+                if (!oldestShard) {
+                    break;
+                }
+
+                Entry entry; // release the evicted element outside of the lock
+                std::lock_guard<std::mutex> lock(oldestShard->mutex);
+                if (!oldestShard->lru.empty()) {
+                    auto it = oldestShard->entries.find(oldestShard->lru.back());
+                    entry = std::move(it->second);
+                    oldestShard->lru.pop_back();
+                    oldestShard->entries.erase(it);
+                    _size -= entry.size;
+                    _evictionCount++;
+                }
+            }
+        }
+
+        Shard _shards[SHARD_COUNT];
+        std::atomic<std::size_t> _capacity;
+        std::atomic<std::size_t> _size;
+        std::atomic<std::uint64_t> _accessCounter;
+        std::atomic<std::uint64_t> _evictionCount;
+    };
+
+}
+
+#endif
@@ -34,6 +34,19 @@ namespace carto {
          * @param size The size of the data in bytes.
          */
         BinaryData(const unsigned char* dataPtr, std::size_t size);
+        /**
+         * Constructs a BinaryData object sharing the specified byte vector. The data is not copied.
+         * @param dataPtr The pointer to the byte vector. The vector must not be modified afterwards.
+         */
+        explicit BinaryData(const std::shared_ptr<std::vector<unsigned char> >& dataPtr);
+        /**
+         * Constructs a BinaryData object referencing external memory. The data is not copied.
+         * The memory is kept alive by the owner object, a custom deleter of the owner can be used to release mapped or platform-owned memory.
+         * @param dataPtr The raw pointer to the data.
+         * @param size The size of the data in bytes.
+         * @param owner The owner of the memory. If null, the memory must stay valid for the lifetime of the application (static data).
+         */
+        BinaryData(const unsigned char* dataPtr, std::size_t size, const std::shared_ptr<const void>& owner);
 
         /**
          * Check if the data is empty (size is 0).
@@ -52,9 +65,19 @@ namespace carto {
         const unsigned char* data() const;
         /**
          * Returns the pointer to data byte vector.
+         * If this object references external memory or a slice, the vector is created by copying the data on the first call.
          * @return The pointer to data byte vector.
          */
         std::shared_ptr<std::vector<unsigned char> > getDataPtr() const;
+
+        /**
+         * Returns a slice of this data, sharing the memory of this object. The data is not copied.
+         * @param offset The offset of the slice in bytes.
+         * @param size The size of the slice in bytes.
+         * @return The slice of the data.
+         * @throws std::out_of_range If the slice is not within the data.
+         */
+        std::shared_ptr<BinaryData> getSlice(std::size_t offset, std::size_t size) const;
         
         /**
          * Checks for equality between this and another blob.
@@ -82,7 +105,10 @@ namespace carto {
         std::string toString() const;
 
     private:
-        std::shared_ptr<std::vector<unsigned char> > _dataPtr;
+        std::shared_ptr<const void> _owner;
+        const unsigned char* _data;
+        std::size_t _size;
+        mutable std::shared_ptr<std::vector<unsigned char> > _dataPtr; // accessed atomically, created lazily for external memory and slices
     };
 
 }
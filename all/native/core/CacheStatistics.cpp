@@ -0,0 +1,89 @@
+#include "CacheStatistics.h"
+
+#include <functional>
+#include <sstream>
+
+namespace carto {
+
+    CacheStatistics::CacheStatistics() :
+        _size(0),
+        _capacity(0),
+        _entryCount(0),
+        _hitCount(0),
+        _missCount(0),
+        _evictionCount(0),
+        _averageLoadTime(0)
+    {
+    }
+
+    CacheStatistics::CacheStatistics(std::size_t size, std::size_t capacity, std::size_t entryCount, long long hitCount, long long missCount, long long evictionCount, double averageLoadTime) :
+        _size(size),
+        _capacity(capacity),
+        _entryCount(entryCount),
+        _hitCount(hitCount),
+        _missCount(missCount),
+        _evictionCount(evictionCount),
+        _averageLoadTime(averageLoadTime)
+    {
+    }
+
+    std::size_t CacheStatistics::getSize() const {
+        return _size;
+    }
+
+    std::size_t CacheStatistics::getCapacity() const {
+        return _capacity;
+    }
+
+    std::size_t CacheStatistics::getEntryCount() const {
+        return _entryCount;
+    }
+
+    long long CacheStatistics::getHitCount() const {
+        return _hitCount;
+    }
+
+    long long CacheStatistics::getMissCount() const {
+        return _missCount;
+    }
+
+    double CacheStatistics::getHitRatio() const {
+        long long requestCount = _hitCount + _missCount;
+        if (requestCount <= 0) {
+            return 0;
+        }
+        return static_cast<double>(_hitCount) / requestCount;
+    }
+
+    long long CacheStatistics::getEvictionCount() const {
+        return _evictionCount;
+    }
+
+    double CacheStatistics::getAverageLoadTime() const {
+        return _averageLoadTime;
+    }
+
+    bool CacheStatistics::operator ==(const CacheStatistics& cacheStatistics) const {
+        return _size == cacheStatistics._size && _capacity == cacheStatistics._capacity && _entryCount == cacheStatistics._entryCount &&
+            _hitCount == cacheStatistics._hitCount && _missCount == cacheStatistics._missCount && _evictionCount == cacheStatistics._evictionCount &&
+            _averageLoadTime == cacheStatistics._averageLoadTime;
+    }
+
+    bool CacheStatistics::operator !=(const CacheStatistics& cacheStatistics) const {
+        return !(*this == cacheStatistics);
+    }
+
+    int CacheStatistics::hash() const {
+        std::hash<long long> hasher;
+        return static_cast<int>((hasher(static_cast<long long>(_size)) << 16) ^ (hasher(_hitCount) << 8) ^ hasher(_missCount));
+    }
+
+    std::string CacheStatistics::toString() const {
+        std::stringstream ss;
+        ss << "CacheStatistics [size=" << _size << ", capacity=" << _capacity << ", entryCount=" << _entryCount;
+        ss << ", hitCount=" << _hitCount << ", missCount=" << _missCount << ", evictionCount=" << _evictionCount;
+        ss << ", averageLoadTime=" << _averageLoadTime << "]";
+        return ss.str();
+    }
+
+}
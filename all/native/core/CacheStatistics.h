@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_CACHESTATISTICS_H_
+#define _CARTO_CACHESTATISTICS_H_
+
+#include <cstddef>
+#include <string>
+
+namespace carto {
+
+    /**
+     * An immutable snapshot of the usage statistics of a tile cache.
+     * Hit, miss and eviction counts are accumulated from the creation of the cache.
+     */
+    class CacheStatistics {
+    public:
+        /**
+         * Constructs an empty CacheStatistics object.
+         */
+        CacheStatistics();
+        /**
+         * Constructs a CacheStatistics object from the given values.
+         * @param size The number of bytes used by the cache.
+         * @param capacity The capacity of the cache in bytes.
+         * @param entryCount The number of entries in the cache.
+         * @param hitCount The number of requests served from the cache.
+         * @param missCount The number of requests not served from the cache.
+         * @param evictionCount The number of entries evicted due to the capacity limit.
+         * @param averageLoadTime The average time in milliseconds to load an entry after a cache miss.
+         */
+        CacheStatistics(std::size_t size, std::size_t capacity, std::size_t entryCount, long long hitCount, long long missCount, long long evictionCount, double averageLoadTime);
+
+        /**
+         * Returns the number of bytes used by the cache.
+         * @return The number of bytes used by the cache.
+         */
+        std::size_t getSize() const;
+        /**
+         * Returns the capacity of the cache.
+         * @return The capacity of the cache in bytes.
+         */
+        std::size_t getCapacity() const;
+        /**
+         * Returns the number of entries in the cache.
+         * @return The number of entries in the cache.
+         */
+        std::size_t getEntryCount() const;
+        /**
+         * Returns the number of requests served from the cache.
+         * @return The number of cache hits.
+         */
+        long long getHitCount() const;
+        /**
+         * Returns the number of requests not served from the cache.
+         * @return The number of cache misses.
+         */
+        long long getMissCount() const;
+        /**
+         * Returns the ratio of cache hits to all requests.
+         * @return The hit ratio between 0 and 1, or 0 if there were no requests.
+         */
+        double getHitRatio() const;
+        /**
+         * Returns the number of entries evicted from the cache due to the capacity limit.
+         * Entries removed explicitly (for example, when the cache is cleared) are not counted.
+         * @return The number of evicted entries.
+         */
+        long long getEvictionCount() const;
+        /**
+         * Returns the average time to load an entry after a cache miss.
+         * @return The average load time in milliseconds, or 0 if no entries were loaded.
+         */
+        double getAverageLoadTime() const;
+
+        bool operator ==(const CacheStatistics& cacheStatistics) const;
+        bool operator !=(const CacheStatistics& cacheStatistics) const;
+
+        /**
+         * Returns the hash value of this object.
+         * @return The hash value of this object.
+         */
+        int hash() const;
+
+        /**
+         * Creates a string representation of this object, useful for logging.
+         * @return The string representation of this object.
+         */
+        std::string toString() const;
+
+    private:
+        std::size_t _size;
+        std::size_t _capacity;
+        std::size_t _entryCount;
+        long long _hitCount;
+        long long _missCount;
+        long long _evictionCount;
+        double _averageLoadTime;
+    };
+
+}
+
+#endif
@@ -72,12 +72,7 @@ namespace carto {
             return true;
         }
     
-        for (const MapPos& pos : _convexHull) {
-            if (!GeomUtils::PointInsidePolygon(envelope._convexHull, pos)) {
-                return false;
-            }
-        }
-        return true;
+        return GeomUtils::PointsInsidePolygon(envelope._convexHull, _convexHull);
     }
     
     bool MapEnvelope::intersects(const MapEnvelope& envelope) const {
@@ -60,6 +60,19 @@ namespace carto {
     MapTile MapTile::getFlipped() const {
         return MapTile(_x, (1 << _zoom) - 1 - _y, _zoom, _frameNr);
     }
+
+    MapTile MapTile::FromTileId(long long tileId) {
+        int frameNr = static_cast<int>(tileId / TILE_ID_OFFSET);
+        long long offset = tileId % TILE_ID_OFFSET;
+
+        // Tiles of each zoom level are numbered after the tiles of all lower zoom levels
+        int zoom = 0;
+        for (long long zoomTileCount = 1; offset >= zoomTileCount; zoomTileCount <<= 2) {
+            offset -= zoomTileCount;
+            zoom++;
+        }
+        return MapTile(static_cast<int>(offset & ((1LL << zoom) - 1)), static_cast<int>(offset >> zoom), zoom, frameNr);
+    }
     
     bool MapTile::operator ==(const MapTile& tile) const {
         return _id == tile._id && _x == tile._x && _y == tile._y && _zoom == tile._zoom && _frameNr == tile._frameNr;
@@ -77,6 +77,13 @@ namespace carto {
          */
         MapTile getFlipped() const;
 
+        /**
+         * Constructs the map tile corresponding to the given internal tile id.
+         * @param tileId The internal tile id, as returned by getTileId.
+         * @return The map tile with the given id, including its frame number.
+         */
+        static MapTile FromTileId(long long tileId);
+
         /**
          * Checks for equality between this and another map tile.
          * @param tile The other map tile.
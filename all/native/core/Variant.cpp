@@ -1,57 +1,69 @@
 #include "Variant.h"
 #include "components/Exceptions.h"
 #include "utils/Log.h"
+#include "utils/JSONUtils.h"
 
 namespace carto {
 
     Variant::Variant() :
-        _value()
+        _value(),
+        _sharedValue()
     {
     }
 
     Variant::Variant(bool boolVal) :
-        _value(boolVal)
+        _value(boolVal),
+        _sharedValue()
     {
     }
 
     Variant::Variant(long long longVal) :
-        _value(static_cast<std::int64_t>(longVal))
+        _value(static_cast<std::int64_t>(longVal)),
+        _sharedValue()
     {
     }
 
     Variant::Variant(double doubleVal) :
-        _value(doubleVal)
+        _value(doubleVal),
+        _sharedValue()
     {
     }
 
     Variant::Variant(const char* str) :
-        _value(std::string(str))
+        _value(std::string(str)),
+        _sharedValue()
     {
     }
 
     Variant::Variant(const std::string& string) :
-        _value(string)
+        _value(string),
+        _sharedValue()
     {
     }
 
     Variant::Variant(const std::vector<Variant>& array) :
-        _value()
+        _value(),
+        _sharedValue()
     {
-        picojson::value::array valArr;
+        picojson::value val(picojson::array_type, false);
+        picojson::value::array& valArr = val.get<picojson::value::array>();
+        valArr.reserve(array.size());
         for (auto it = array.begin(); it != array.end(); it++) {
             valArr.push_back(it->toPicoJSON());
         }
-        _value = picojson::value(valArr);
+        _sharedValue = std::make_shared<const picojson::value>(std::move(val));
     }
 
     Variant::Variant(const std::map<std::string, Variant>& object) :
-        _value()
+        _value(),
+        _sharedValue()
     {
-        picojson::value::object valObj;
+        picojson::value val(picojson::object_type, false);
+        picojson::value::object& valObj = val.get<picojson::value::object>();
         for (auto it = object.begin(); it != object.end(); it++) {
-            valObj[it->first] = it->second.toPicoJSON();
+            valObj.emplace_hint(valObj.end(), it->first, it->second.toPicoJSON());
         }
-        _value = picojson::value(valObj);
+        _sharedValue = std::make_shared<const picojson::value>(std::move(val));
     }
 
     VariantType::VariantType Variant::getType() const {
@@ -118,7 +130,7 @@ namespace carto {
         if (val.is<picojson::value::array>()) {
             const picojson::array& valArr = val.get<picojson::value::array>();
             if (idx >= 0 && idx < static_cast<int>(valArr.size())) {
-                return FromPicoJSON(valArr[idx]);
+                return FromSharedPicoJSON(std::shared_ptr<const picojson::value>(_sharedValue, &valArr[idx]));
             }
         }
         return Variant();
@@ -145,19 +157,28 @@ namespace carto {
     }
     
     Variant Variant::getObjectElement(const std::string& key) const {
+        Variant value;
+        findObjectElement(key, value);
+        return value;
+    }
+
+    bool Variant::findObjectElement(const std::string& key, Variant& value) const {
         const picojson::value& val = toPicoJSON();
-        std::vector<std::string> keys;
         if (val.is<picojson::value::object>()) {
             const picojson::object& valObj = val.get<picojson::value::object>();
             auto it = valObj.find(key);
             if (it != valObj.end()) {
-                return FromPicoJSON(it->second);
+                value = FromSharedPicoJSON(std::shared_ptr<const picojson::value>(_sharedValue, &it->second));
+                return true;
             }
         }
-        return Variant();
+        return false;
     }
 
     bool Variant::operator ==(const Variant& var) const {
+        if (_sharedValue && _sharedValue == var._sharedValue) {
+            return true;
+        }
         return toPicoJSON() == var.toPicoJSON();
     }
 
@@ -174,24 +195,38 @@ namespace carto {
     }
 
     const picojson::value& Variant::toPicoJSON() const {
+        if (_sharedValue) {
+            return *_sharedValue;
+        }
         return _value;
     }
 
     Variant Variant::FromString(const std::string& str) {
         picojson::value val;
-        std::string err = picojson::parse(val, str);
+        std::string err = JSONUtils::ParsePicoJSON(val, str);
         if (!err.empty()) {
             throw ParseException(std::string("Variant parsing failed: ") + err, str);
         }
-        Variant var;
-        var._value = std::move(val);
-        return var;
+        return FromPicoJSON(std::move(val));
     }
 
     Variant Variant::FromPicoJSON(picojson::value val) {
         Variant var;
-        var._value = std::move(val);
+        if (val.is<picojson::value::array>() || val.is<picojson::value::object>()) {
+            var._sharedValue = std::make_shared<const picojson::value>(std::move(val));
+        } else {
+            var._value = std::move(val);
+        }
         return var;
     }
 
+    Variant Variant::FromSharedPicoJSON(std::shared_ptr<const picojson::value> sharedValue) {
+        if (sharedValue->is<picojson::value::array>() || sharedValue->is<picojson::value::object>()) {
+            Variant var;
+            var._sharedValue = std::move(sharedValue);
+            return var;
+        }
+        return FromPicoJSON(*sharedValue);
+    }
+
 }
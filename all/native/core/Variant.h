@@ -55,6 +55,7 @@ namespace carto {
     
     /**
      * JSON value. Can contain JSON-style structured data, including objects and arrays.
+     * Arrays and objects are immutable and shared between copies, subelements are returned as views to the same data.
      */
     class Variant {
     public:
@@ -154,6 +155,14 @@ namespace carto {
          * @return The object element with the specified key or null type if the element does not exist or the variant is not an object.
          */
         Variant getObjectElement(const std::string& key) const;
+        /**
+         * Finds the element of object with the specified key.
+         * This is equivalent to calling containsObjectKey and getObjectElement, but requires only a single lookup.
+         * @param key The key of the object element to find.
+         * @param value The object element with the specified key, used as an output parameter.
+         * @return True if the element was found and assigned to value, false otherwise.
+         */
+        bool findObjectElement(const std::string& key, Variant& value) const;
 
         /**
          * Checks for equality between this and another variant object.
@@ -202,7 +211,10 @@ namespace carto {
         static Variant FromPicoJSON(picojson::value val);
 
     private:
-        picojson::value _value;
+        static Variant FromSharedPicoJSON(std::shared_ptr<const picojson::value> sharedValue);
+
+        picojson::value _value; // used for scalar values only
+        std::shared_ptr<const picojson::value> _sharedValue; // used for arrays and objects, immutable and shared between copies and subelement views
     };
 
 }
@@ -4,9 +4,11 @@
 #include "projections/EPSG3857.h"
 #include "graphics/Bitmap.h"
 #include "graphics/utils/BitmapFilterTable.h"
+#include "graphics/utils/BitmapKernels.h"
 #include "utils/Log.h"
 
 #include <array>
+#include <cmath>
 
 #include <cglib/mat.h>
 
@@ -34,7 +36,9 @@ namespace carto {
         _transform(cglib::mat3x3<double>::identity()),
         _invTransform(cglib::mat3x3<double>::identity()),
         _bitmap(),
-        _projection(std::make_shared<EPSG3857>())
+        _bitmapLevels(),
+        _projection(std::make_shared<EPSG3857>()),
+        _mutex()
     {
         if (!bitmap) {
             throw NullArgumentException("Null bitmap");
@@ -122,6 +126,7 @@ namespace carto {
         if (bitmap->getColorFormat() != ColorFormat::COLOR_FORMAT_RGBA) {
             _bitmap = bitmap->getRGBABitmap();
         }
+        _bitmapLevels.push_back(_bitmap);
     }
 
     BitmapOverlayRasterTileDataSource::~BitmapOverlayRasterTileDataSource() {
@@ -165,9 +170,22 @@ namespace carto {
             return std::shared_ptr<TileData>();
         }
 
+        // Select the bitmap level where a tile pixel covers roughly one source pixel, so that the filter footprint stays small
+        cglib::vec2<double> uv0 = ProjectiveTransform(invTransform)(_tileSize / 2 + 0, _tileSize / 2 + 0);
+        double du = cglib::length(ProjectiveTransform(invTransform)(_tileSize / 2 + 1, _tileSize / 2 + 0) - uv0);
+        double dv = cglib::length(ProjectiveTransform(invTransform)(_tileSize / 2 + 0, _tileSize / 2 + 1) - uv0);
+        int level = static_cast<int>(std::floor(std::log2(std::max(1.0, std::min(du, dv)))));
+        std::shared_ptr<Bitmap> bitmap = getBitmapLevel(level);
+        if (!bitmap) {
+            return std::shared_ptr<TileData>();
+        }
+        double levelScaleU = static_cast<double>(bitmap->getWidth()) / _bitmap->getWidth();
+        double levelScaleV = static_cast<double>(bitmap->getHeight()) / _bitmap->getHeight();
+        invTransform = cglib::scale3_matrix(cglib::vec3<double>(levelScaleU, levelScaleV, 1)) * invTransform;
+
         // Calculate filter table
         Log::Infof("BitmapOverlayRasterTileDataSource: Tile %s inside the raster dataset", mapTile.toString().c_str());
-        BitmapFilterTable filterTable(0, 0, _bitmap->getWidth(), _bitmap->getHeight());
+        BitmapFilterTable filterTable(0, 0, bitmap->getWidth(), bitmap->getHeight());
         filterTable.calculateFilterTable(ProjectiveTransform(invTransform), _tileSize, _tileSize, FILTER_SCALE, MAX_FILTER_WIDTH);
         
         std::size_t sampleIndex = 0;
@@ -182,7 +200,7 @@ namespace carto {
             float color[4] = { 0.5f, 0.5f, 0.5f, 0.5f };
             for (int j = 0; j < count; j++) {
                 const BitmapFilterTable::Sample& sample = samples[sampleIndex++];
-                const unsigned char* sampleData = &_bitmap->getPixelData()[(sample.v * _bitmap->getWidth() + sample.u) * 4];
+                const unsigned char* sampleData = &bitmap->getPixelData()[(sample.v * bitmap->getWidth() + sample.u) * 4];
                 for (int c = 0; c < 4; c++) {
                     color[c] += sampleData[c] * sample.weight;
                 }
@@ -193,8 +211,26 @@ namespace carto {
         }
 
         // Build bitmap, "compress" (serialize) to internal format
-        Bitmap bitmap(data.data(), _tileSize, _tileSize, ColorFormat::COLOR_FORMAT_RGBA, 4 * _tileSize);
-        return std::make_shared<TileData>(bitmap.compressToInternal());
+        Bitmap tileBitmap(data.data(), _tileSize, _tileSize, ColorFormat::COLOR_FORMAT_RGBA, 4 * _tileSize);
+        return std::make_shared<TileData>(tileBitmap.compressToInternal());
+    }
+
+    std::shared_ptr<Bitmap> BitmapOverlayRasterTileDataSource::getBitmapLevel(int level) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        // Build missing levels by downsampling the previous level, stop when the bitmap can not be reduced further
+        while (static_cast<int>(_bitmapLevels.size()) <= level) {
+            const std::shared_ptr<Bitmap>& prevBitmap = _bitmapLevels.back();
+            if (prevBitmap->getWidth() <= 1 && prevBitmap->getHeight() <= 1) {
+                break;
+            }
+            unsigned int width = (prevBitmap->getWidth() + 1) / 2;
+            unsigned int height = (prevBitmap->getHeight() + 1) / 2;
+            std::vector<unsigned char> pixelData(width * height * 4);
+            BitmapKernels::Downsample2x(prevBitmap->getPixelData().data(), prevBitmap->getWidth(), prevBitmap->getHeight(), pixelData.data(), 4);
+            _bitmapLevels.push_back(std::make_shared<Bitmap>(pixelData.data(), width, height, ColorFormat::COLOR_FORMAT_RGBA, -static_cast<int>(width * 4)));
+        }
+        return _bitmapLevels[std::min(level, static_cast<int>(_bitmapLevels.size()) - 1)];
     }
 
     const float BitmapOverlayRasterTileDataSource::FILTER_SCALE = 1.5f;
@@ -11,6 +11,9 @@
 #include "core/ScreenPos.h"
 #include "datasources/TileDataSource.h"
 
+#include <mutex>
+#include <vector>
+
 #include <cglib/mat.h>
 
 namespace carto {
@@ -20,6 +23,7 @@ namespace carto {
     /**
      * Tile data source that uses given bitmap with two, three or four control points define a raster overlay.
      * Note: if two points are given, conformal transformation is calculated. If three points are given, affine transformation is calculated. In case of four points, perspective transformation is used.
+     * Tiles at lower zoom levels are sampled from downsampled copies of the bitmap, which are built on demand.
      */
     class BitmapOverlayRasterTileDataSource : public TileDataSource {
     public:
@@ -41,6 +45,8 @@ namespace carto {
         virtual std::shared_ptr<TileData> loadTile(const MapTile& mapTile);
         
     private:
+        std::shared_ptr<Bitmap> getBitmapLevel(int level);
+
         static const float FILTER_SCALE;
         static const int MAX_FILTER_WIDTH;
 
@@ -50,7 +56,10 @@ namespace carto {
         cglib::mat3x3<double> _transform;
         cglib::mat3x3<double> _invTransform;
         std::shared_ptr<Bitmap> _bitmap;
+        std::vector<std::shared_ptr<Bitmap> > _bitmapLevels;
         std::shared_ptr<Projection> _projection;
+
+        mutable std::mutex _mutex;
     };
 }
 
@@ -1,6 +1,7 @@
 #include "CacheTileDataSource.h"
 #include "core/MapTile.h"
 #include "components/Exceptions.h"
+#include "utils/TileUtils.h"
 #include "utils/Log.h"
 
 #include <memory>
@@ -9,7 +10,8 @@ namespace carto {
     
     CacheTileDataSource::CacheTileDataSource(const std::shared_ptr<TileDataSource>& dataSource) :
         TileDataSource(),
-        _dataSource(dataSource)
+        _dataSource(dataSource),
+        _cacheStatistics()
     {
         if (!dataSource) {
             throw NullArgumentException("Null dataSource");
@@ -41,9 +43,30 @@ namespace carto {
         TileDataSource::notifyTilesChanged(removeTiles);
     }
 
+    void CacheTileDataSource::notifyTilesChanged(const MapBounds& bounds, int minZoom, int maxZoom, bool removeTiles) {
+        removeCachedTiles(bounds, minZoom, maxZoom);
+        TileDataSource::notifyTilesChanged(bounds, minZoom, maxZoom, removeTiles);
+    }
+
     std::shared_ptr<TileDataSource> CacheTileDataSource::getDataSource() const {
         return _dataSource.get();
     }
+
+    CacheStatistics CacheTileDataSource::getCacheStatistics() const {
+        return _cacheStatistics.getStatistics(0, getCapacity(), 0, 0);
+    }
+
+    void CacheTileDataSource::removeCachedTiles(const MapBounds& bounds, int minZoom, int maxZoom) {
+        clear();
+    }
+
+    bool CacheTileDataSource::isTileInArea(const MapTile& tile, const MapBounds& bounds, int minZoom, int maxZoom) const {
+        if (tile.getZoom() < minZoom || tile.getZoom() > maxZoom) {
+            return false;
+        }
+        // Note: data source tiles are vertically flipped
+        return TileUtils::CalculateMapTileBounds(tile.getFlipped(), _dataSource->getProjection()).intersects(bounds);
+    }
     
     CacheTileDataSource::DataSourceListener::DataSourceListener(CacheTileDataSource& cacheDataSource) :
         _cacheDataSource(cacheDataSource)
@@ -54,4 +77,8 @@ namespace carto {
         _cacheDataSource.notifyTilesChanged(removeTiles);
     }
 
+    void CacheTileDataSource::DataSourceListener::onTilesChanged(const MapBounds& bounds, int minZoom, int maxZoom, bool removeTiles) {
+        _cacheDataSource.notifyTilesChanged(bounds, minZoom, maxZoom, removeTiles);
+    }
+
 }
@@ -7,7 +7,9 @@
 #ifndef _CARTO_CACHETILEDATASOURCE_H_
 #define _CARTO_CACHETILEDATASOURCE_H_
 
+#include "core/CacheStatistics.h"
 #include "datasources/TileDataSource.h"
+#include "components/CacheStatisticsCounter.h"
 #include "components/DirectorPtr.h"
 
 namespace carto {
@@ -25,6 +27,7 @@ namespace carto {
         virtual MapBounds getDataExtent() const;
 
         virtual void notifyTilesChanged(bool removeTiles);
+        virtual void notifyTilesChanged(const MapBounds& bounds, int minZoom, int maxZoom, bool removeTiles);
 
         /**
          * Returns the original data source that the cache uses.
@@ -48,12 +51,21 @@ namespace carto {
          */
         virtual void setCapacity(std::size_t capacityInBytes) = 0;
 
+        /**
+         * Returns the usage statistics of the cache. A request for a tile that is not in the cache
+         * (or that has expired) is counted as a miss, the load time is the time spent loading the tile
+         * from the original data source.
+         * @return The cache statistics.
+         */
+        virtual CacheStatistics getCacheStatistics() const;
+
     protected:
         class DataSourceListener : public TileDataSource::OnChangeListener {
         public:
             explicit DataSourceListener(CacheTileDataSource& cacheDataSource);
             
             virtual void onTilesChanged(bool removeTiles);
+            virtual void onTilesChanged(const MapBounds& bounds, int minZoom, int maxZoom, bool removeTiles);
             
         private:
             CacheTileDataSource& _cacheDataSource;
@@ -61,7 +73,28 @@ namespace carto {
         
         CacheTileDataSource(const std::shared_ptr<TileDataSource>& dataSource);
 
+        /**
+         * Removes the cached tiles within the given bounds and zoom range.
+         * The default implementation clears the whole cache.
+         * @param bounds The bounds of the area, in the coordinate system of the data source projection.
+         * @param minZoom The minimum zoom level of the tiles to remove (inclusive).
+         * @param maxZoom The maximum zoom level of the tiles to remove (inclusive).
+         */
+        virtual void removeCachedTiles(const MapBounds& bounds, int minZoom, int maxZoom);
+
+        /**
+         * Checks whether the given data source tile is within the given bounds and zoom range.
+         * @param tile The data source tile to check.
+         * @param bounds The bounds of the area, in the coordinate system of the data source projection.
+         * @param minZoom The minimum zoom level (inclusive).
+         * @param maxZoom The maximum zoom level (inclusive).
+         * @return True if the tile is within the area, false otherwise.
+         */
+        bool isTileInArea(const MapTile& tile, const MapBounds& bounds, int minZoom, int maxZoom) const;
+
         const DirectorPtr<TileDataSource> _dataSource;
+
+        CacheStatisticsCounter _cacheStatistics;
         
     private:
         std::shared_ptr<DataSourceListener> _dataSourceListener;
@@ -2,16 +2,22 @@
 #include "core/BinaryData.h"
 #include "core/MapTile.h"
 #include "components/LicenseManager.h"
+#include "datasources/components/ConcurrentTileLoader.h"
 #include "packagemanager/PackageTileMask.h"
 #include "utils/Log.h"
 #include "utils/GeneralUtils.h"
 #include "utils/NetworkUtils.h"
 #include "utils/PlatformUtils.h"
+#include "utils/ThreadUtils.h"
+#include "utils/JSONUtils.h"
 
 #include <picojson/picojson.h>
 
 #include <stdext/base64.h>
 
+#include <limits>
+#include <thread>
+
 namespace carto {
     
     CartoOnlineTileDataSource::CartoOnlineTileDataSource(const std::string& source) :
@@ -19,11 +25,14 @@ namespace carto {
         _source(source),
         _cache(MAX_CACHED_TILES),
         _httpClient(Log::IsShowDebug()),
+        _tileLoadCoalescer(),
         _schema(),
         _tmsScheme(false),
         _tileURLs(),
         _tileMasks(),
+        _hostStatistics(),
         _randomGenerator(),
+        _configurationRefreshStarted(false),
         _mutex()
     {
         _maxZoom = DEFAULT_MAX_ZOOM;
@@ -43,9 +52,7 @@ namespace carto {
     }
 
     std::shared_ptr<TileData> CartoOnlineTileDataSource::loadTile(const MapTile& mapTile) {
-        std::unique_lock<std::recursive_mutex> lock(_mutex);
-
-        // Check if the tile is in cache
+        // Check if the tile is in cache. The cache is thread-safe, so no need to lock.
         std::shared_ptr<TileData> tileData;
         if (_cache.read(mapTile.getTileId(), tileData)) {
             if (tileData->getMaxAge() != 0) {
@@ -54,6 +61,8 @@ namespace carto {
             _cache.remove(mapTile.getTileId());
         }
 
+        std::unique_lock<std::recursive_mutex> lock(_mutex);
+
         // Reload tile service URLs, if needed
         if (_tileURLs.empty()) {
             if (!loadConfiguration()) {
@@ -70,14 +79,17 @@ namespace carto {
             }
         }
 
-        // Select tile URL randomly
-        std::size_t randomIndex = std::uniform_int_distribution<std::size_t>(0, _tileURLs.size() - 1)(_randomGenerator);
-        std::string tileURL = _tileURLs[randomIndex];
+        // Select tile URL based on the measured host latencies and error rates
+        std::string tileURL = selectTileURL();
 
-        // Fetch online tile, allow parallel tile fetching
+        // Fetch online tile, allow parallel tile fetching. Concurrent requests for the same tile share a single download.
         lock.unlock();
-        tileData = loadOnlineTile(tileURL, mapTile);
-        lock.lock();
+        tileData = _tileLoadCoalescer.load(mapTile.getTileId(), [&]() {
+            std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+            std::shared_ptr<TileData> onlineTileData = loadOnlineTile(tileURL, mapTile);
+            updateHostStatistics(tileURL, std::chrono::steady_clock::now() - startTime, onlineTileData != nullptr);
+            return onlineTileData;
+        });
 
         // Store the tile in local cache
         if (tileData) {
@@ -89,6 +101,16 @@ namespace carto {
         return tileData;
     }
 
+    std::vector<std::shared_ptr<TileData> > CartoOnlineTileDataSource::loadTiles(const std::vector<MapTile>& mapTiles) {
+        return ConcurrentTileLoader::LoadTiles(mapTiles, [this](const MapTile& mapTile) {
+            return loadTile(mapTile);
+        }, MAX_CONCURRENT_LOADS);
+    }
+
+    bool CartoOnlineTileDataSource::isBatchLoadingSupported() const {
+        return true;
+    }
+
     std::string CartoOnlineTileDataSource::buildTileURL(const std::string& baseURL, const MapTile& tile) const {
         std::map<std::string, std::string> tagValues = buildTagValues(_tmsScheme ? tile.getFlipped() : tile);
         std::string appToken;
@@ -101,29 +123,83 @@ namespace carto {
         return GeneralUtils::ReplaceTags(baseURL, tagValues, "{", "}", true);
     }
 
-    bool CartoOnlineTileDataSource::loadConfiguration() {
-        std::map<std::string, std::string> params;
-        params["deviceId"] = PlatformUtils::GetDeviceId();
-        params["platform"] = PlatformUtils::GetPlatformId();
-        params["sdk_build"] = PlatformUtils::GetSDKVersion();
-        std::string appToken;
-        if (LicenseManager::GetInstance().getParameter("appToken", appToken, false)) {
-            params["appToken"] = appToken;
+    std::string CartoOnlineTileDataSource::selectTileURL() {
+        // Note: _mutex must be locked by the caller
+        if (std::uniform_real_distribution<double>(0, 1)(_randomGenerator) >= HOST_EXPLORATION_PROBABILITY) {
+            // Use the host with the best score. Hosts without enough samples get the best score, so that they are measured first.
+            std::vector<std::size_t> bestIndices;
+            double bestScore = std::numeric_limits<double>::infinity();
+            for (std::size_t i = 0; i < _tileURLs.size(); i++) {
+                double score = 0;
+                auto it = _hostStatistics.find(_tileURLs[i]);
+                if (it != _hostStatistics.end() && it->second.sampleCount >= MIN_HOST_SAMPLES) {
+                    score = it->second.latency * (1 + HOST_ERROR_PENALTY * it->second.errorRate);
+                }
+                if (score < bestScore) {
+                    bestScore = score;
+                    bestIndices.clear();
+                }
+                if (score == bestScore) {
+                    bestIndices.push_back(i);
+                }
+            }
+            if (!bestIndices.empty()) {
+                std::size_t randomIndex = std::uniform_int_distribution<std::size_t>(0, bestIndices.size() - 1)(_randomGenerator);
+                return _tileURLs[bestIndices[randomIndex]];
+            }
         }
 
-        std::string baseURL = NetworkUtils::CreateServiceURL(TILE_SERVICE_TEMPLATE, _source);
-        std::string url = NetworkUtils::BuildURLFromParameters(baseURL, params);
-        Log::Debugf("CartoOnlineTileDataSource::loadConfiguration: Loading %s", url.c_str());
+        // Explore other hosts occasionally, so that recovered or faster hosts are detected
+        std::size_t randomIndex = std::uniform_int_distribution<std::size_t>(0, _tileURLs.size() - 1)(_randomGenerator);
+        return _tileURLs[randomIndex];
+    }
 
-        std::map<std::string, std::string> requestHeaders = NetworkUtils::CreateAppRefererHeader();
-        std::map<std::string, std::string> responseHeaders;
-        std::string responseString;
-        if (!NetworkUtils::GetHTTP(url, requestHeaders, responseHeaders, responseString, Log::IsShowDebug())) {
+    void CartoOnlineTileDataSource::updateHostStatistics(const std::string& tileURL, const std::chrono::steady_clock::duration& latency, bool success) {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+        HostStatistics& hostStatistics = _hostStatistics[tileURL];
+        double weight = (hostStatistics.sampleCount == 0 ? 1.0 : HOST_STATISTICS_WEIGHT);
+        hostStatistics.errorRate += ((success ? 0.0 : 1.0) - hostStatistics.errorRate) * weight;
+        if (success) {
+            double latencyMs = std::chrono::duration_cast<std::chrono::microseconds>(latency).count() / 1000.0;
+            hostStatistics.latency += (latencyMs - hostStatistics.latency) * (hostStatistics.latency == 0 ? 1.0 : HOST_STATISTICS_WEIGHT);
+        }
+        hostStatistics.sampleCount++;
+    }
+
+    bool CartoOnlineTileDataSource::loadConfiguration() {
+        // Note: _mutex must be locked by the caller
+        // Use the configuration loaded by any data source with the same source id immediately and refresh it in background
+        std::string configJSON;
+        {
+            std::lock_guard<std::mutex> lock(_CachedConfigurationsMutex);
+            auto it = _CachedConfigurations.find(_source);
+            if (it != _CachedConfigurations.end()) {
+                configJSON = it->second;
+            }
+        }
+        if (!configJSON.empty() && applyConfiguration(configJSON)) {
+            startConfigurationRefresh();
+            return true;
+        }
+
+        if (!FetchConfiguration(_source, configJSON)) {
             Log::Warnf("CartoOnlineTileDataSource: Failed to fetch tile source configuration"); // NOTE: we may have error messages, thus do not return from here
         }
+        if (!applyConfiguration(configJSON)) {
+            return false;
+        }
+        _configurationRefreshStarted = true;
+
+        std::lock_guard<std::mutex> lock(_CachedConfigurationsMutex);
+        _CachedConfigurations[_source] = configJSON;
+        return true;
+    }
 
+    bool CartoOnlineTileDataSource::applyConfiguration(const std::string& configJSON) {
+        // Note: _mutex must be locked by the caller
         picojson::value config;
-        std::string err = picojson::parse(config, responseString);
+        std::string err = JSONUtils::ParsePicoJSON(config, configJSON);
         if (!err.empty()) {
             Log::Errorf("CartoOnlineTileDataSource: Failed to parse tile source configuration: %s", err.c_str());
             return false;
@@ -137,15 +213,16 @@ namespace carto {
             }
         }
 
+        if (!config.get("tiles").is<picojson::array>()) {
+            Log::Error("CartoOnlineTileDataSource: Tile URLs missing from configuration");
+            return false;
+        }
+
         if (config.get("schema").is<std::string>()) {
             _schema = config.get("schema").get<std::string>();
         }
 
         _tileURLs.clear();
-        if (!config.get("tiles").is<picojson::array>()) {
-            Log::Error("CartoOnlineTileDataSource: Tile URLs missing from configuration");
-            return false;
-        }
         for (const picojson::value& tileURL : config.get("tiles").get<picojson::array>()) {
             if (tileURL.is<std::string>()) {
                 _tileURLs.push_back(tileURL.get<std::string>());
@@ -185,6 +262,56 @@ namespace carto {
         }
         return !_tileURLs.empty();
     }
+
+    void CartoOnlineTileDataSource::startConfigurationRefresh() {
+        // Note: _mutex must be locked by the caller
+        if (_configurationRefreshStarted) {
+            return;
+        }
+        _configurationRefreshStarted = true;
+
+        std::string source = _source;
+        std::weak_ptr<TileDataSource> dataSourceWeak = shared_from_this();
+        std::thread refreshThread([source, dataSourceWeak]() {
+            ThreadUtils::SetThreadRole(ThreadRole::BACKGROUND);
+
+            std::string configJSON;
+            if (!FetchConfiguration(source, configJSON)) {
+                Log::Warnf("CartoOnlineTileDataSource: Failed to refresh tile source configuration");
+                return;
+            }
+
+            if (auto dataSource = std::static_pointer_cast<CartoOnlineTileDataSource>(dataSourceWeak.lock())) {
+                std::lock_guard<std::recursive_mutex> lock(dataSource->_mutex);
+                if (!dataSource->applyConfiguration(configJSON)) {
+                    return;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(_CachedConfigurationsMutex);
+            _CachedConfigurations[source] = configJSON;
+        });
+        refreshThread.detach();
+    }
+
+    bool CartoOnlineTileDataSource::FetchConfiguration(const std::string& source, std::string& configJSON) {
+        std::map<std::string, std::string> params;
+        params["deviceId"] = PlatformUtils::GetDeviceId();
+        params["platform"] = PlatformUtils::GetPlatformId();
+        params["sdk_build"] = PlatformUtils::GetSDKVersion();
+        std::string appToken;
+        if (LicenseManager::GetInstance().getParameter("appToken", appToken, false)) {
+            params["appToken"] = appToken;
+        }
+
+        std::string baseURL = NetworkUtils::CreateServiceURL(TILE_SERVICE_TEMPLATE, source);
+        std::string url = NetworkUtils::BuildURLFromParameters(baseURL, params);
+        Log::Debugf("CartoOnlineTileDataSource::FetchConfiguration: Loading %s", url.c_str());
+
+        std::map<std::string, std::string> requestHeaders = NetworkUtils::CreateAppRefererHeader();
+        std::map<std::string, std::string> responseHeaders;
+        return NetworkUtils::GetHTTP(url, requestHeaders, responseHeaders, configJSON, Log::IsShowDebug());
+    }
     
     std::shared_ptr<TileData> CartoOnlineTileDataSource::loadOnlineTile(const std::string& tileURL, const MapTile& mapTile) {
         Log::Infof("CartoOnlineTileDataSource::loadOnlineTile: Loading tile %d/%d/%d", mapTile.getZoom(), mapTile.getX(), mapTile.getY());
@@ -234,8 +361,22 @@ namespace carto {
 
     const int CartoOnlineTileDataSource::DEFAULT_MAX_ZOOM = 14;
 
+    const int CartoOnlineTileDataSource::MAX_CONCURRENT_LOADS = 8;
+
+    const int CartoOnlineTileDataSource::MIN_HOST_SAMPLES = 3;
+
+    const double CartoOnlineTileDataSource::HOST_STATISTICS_WEIGHT = 0.2;
+
+    const double CartoOnlineTileDataSource::HOST_ERROR_PENALTY = 10.0;
+
+    const double CartoOnlineTileDataSource::HOST_EXPLORATION_PROBABILITY = 0.05;
+
     const unsigned int CartoOnlineTileDataSource::MAX_CACHED_TILES = 8;
 
     const std::string CartoOnlineTileDataSource::TILE_SERVICE_TEMPLATE = "https://api.nutiteq.com/maps/v2/{source}/1/tiles.json";
+
+    std::map<std::string, std::string> CartoOnlineTileDataSource::_CachedConfigurations;
+
+    std::mutex CartoOnlineTileDataSource::_CachedConfigurationsMutex;
     
 }
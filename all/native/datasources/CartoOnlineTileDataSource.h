@@ -7,14 +7,17 @@
 #ifndef _CARTO_CARTOONLINETILEDATASOURCE_H_
 #define _CARTO_CARTOONLINETILEDATASOURCE_H_
 
+#include "components/ShardedTileCache.h"
 #include "datasources/TileDataSource.h"
+#include "datasources/components/TileLoadCoalescer.h"
 #include "network/HTTPClient.h"
 
+#include <chrono>
+#include <map>
+#include <mutex>
 #include <random>
 #include <vector>
 
-#include <stdext/timed_lru_cache.h>
-
 namespace carto {
     class BinaryData;
     class PackageTileMask;
@@ -40,6 +43,10 @@ namespace carto {
         std::string getSchema();
 
         virtual std::shared_ptr<TileData> loadTile(const MapTile& mapTile);
+
+        virtual std::vector<std::shared_ptr<TileData> > loadTiles(const std::vector<MapTile>& mapTiles);
+
+        virtual bool isBatchLoadingSupported() const;
         
     protected:
         struct TileMask {
@@ -48,28 +55,53 @@ namespace carto {
             std::shared_ptr<BinaryData> tileData;
         };
 
+        struct HostStatistics {
+            double latency = 0; // exponential moving average in milliseconds
+            double errorRate = 0; // exponential moving average of failed requests
+            int sampleCount = 0;
+        };
+
         std::string buildTileURL(const std::string& baseURL, const MapTile& tile) const;
 
+        std::string selectTileURL();
+        void updateHostStatistics(const std::string& tileURL, const std::chrono::steady_clock::duration& latency, bool success);
+
         bool loadConfiguration();
+        bool applyConfiguration(const std::string& configJSON);
+        void startConfigurationRefresh();
+
+        static bool FetchConfiguration(const std::string& source, std::string& configJSON);
 
         std::shared_ptr<TileData> loadOnlineTile(const std::string& url, const MapTile& mapTile);
 
         static const int DEFAULT_MAX_ZOOM;
+        static const int MAX_CONCURRENT_LOADS;
+        static const int MIN_HOST_SAMPLES;
+        static const double HOST_STATISTICS_WEIGHT;
+        static const double HOST_ERROR_PENALTY;
+        static const double HOST_EXPLORATION_PROBABILITY;
         static const unsigned int MAX_CACHED_TILES;
         static const std::string TILE_SERVICE_TEMPLATE;
 
         const std::string _source;
-        mutable cache::timed_lru_cache<long long, std::shared_ptr<TileData> > _cache;
+        mutable ShardedTileCache<std::shared_ptr<TileData> > _cache;
         HTTPClient _httpClient;
+        TileLoadCoalescer _tileLoadCoalescer;
 
         std::string _schema;
 
         bool _tmsScheme;
         std::vector<std::string> _tileURLs;
         std::vector<TileMask> _tileMasks;
+        std::map<std::string, HostStatistics> _hostStatistics;
         std::default_random_engine _randomGenerator;
+        bool _configurationRefreshStarted;
 
         mutable std::recursive_mutex _mutex;
+
+    private:
+        static std::map<std::string, std::string> _CachedConfigurations; // shared between all data sources, keyed by source id
+        static std::mutex _CachedConfigurationsMutex;
     };
     
 }
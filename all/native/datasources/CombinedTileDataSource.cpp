@@ -60,5 +60,9 @@ namespace carto {
     void CombinedTileDataSource::DataSourceListener::onTilesChanged(bool removeTiles) {
         _combinedDataSource.notifyTilesChanged(removeTiles);
     }
+
+    void CombinedTileDataSource::DataSourceListener::onTilesChanged(const MapBounds& bounds, int minZoom, int maxZoom, bool removeTiles) {
+        _combinedDataSource.notifyTilesChanged(bounds, minZoom, maxZoom, removeTiles);
+    }
     
 }
@@ -41,6 +41,7 @@ namespace carto {
             explicit DataSourceListener(CombinedTileDataSource& combinedDataSource);
             
             virtual void onTilesChanged(bool removeTiles);
+            virtual void onTilesChanged(const MapBounds& bounds, int minZoom, int maxZoom, bool removeTiles);
             
         private:
             CombinedTileDataSource& _combinedDataSource;
@@ -0,0 +1,266 @@
+#include "CompositeRasterTileDataSource.h"
+#include "core/BinaryData.h"
+#include "core/MapTile.h"
+#include "components/Exceptions.h"
+#include "graphics/Bitmap.h"
+#include "utils/Const.h"
+#include "utils/Log.h"
+
+#include <algorithm>
+
+namespace carto {
+
+    CompositeRasterTileDataSource::CompositeRasterTileDataSource() :
+        TileDataSource(),
+        _dataSources(),
+        _mutex(),
+        _dataSourceListener()
+    {
+        _dataSourceListener = std::make_shared<DataSourceListener>(*this);
+    }
+
+    CompositeRasterTileDataSource::~CompositeRasterTileDataSource() {
+        std::vector<DataSourceInfo> dataSources;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            dataSources = _dataSources;
+        }
+        for (auto it = dataSources.rbegin(); it != dataSources.rend(); it++) {
+            it->dataSource->unregisterOnChangeListener(_dataSourceListener);
+        }
+        _dataSourceListener.reset();
+    }
+
+    void CompositeRasterTileDataSource::addDataSource(const std::shared_ptr<TileDataSource>& dataSource, float opacity, RasterBlendMode::RasterBlendMode blendMode) {
+        if (!dataSource) {
+            throw NullArgumentException("Null dataSource");
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _dataSources.emplace_back(dataSource, std::min(1.0f, std::max(0.0f, opacity)), blendMode);
+        }
+        dataSource->registerOnChangeListener(_dataSourceListener);
+        notifyTilesChanged(false);
+    }
+
+    bool CompositeRasterTileDataSource::removeDataSource(const std::shared_ptr<TileDataSource>& dataSource) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto it = std::find_if(_dataSources.begin(), _dataSources.end(), [&dataSource](const DataSourceInfo& dataSourceInfo) {
+                return dataSourceInfo.dataSource.get() == dataSource;
+            });
+            if (it == _dataSources.end()) {
+                return false;
+            }
+            _dataSources.erase(it);
+        }
+        dataSource->unregisterOnChangeListener(_dataSourceListener);
+        notifyTilesChanged(false);
+        return true;
+    }
+
+    float CompositeRasterTileDataSource::getDataSourceOpacity(const std::shared_ptr<TileDataSource>& dataSource) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (const DataSourceInfo& dataSourceInfo : _dataSources) {
+            if (dataSourceInfo.dataSource.get() == dataSource) {
+                return dataSourceInfo.opacity;
+            }
+        }
+        return 0.0f;
+    }
+
+    void CompositeRasterTileDataSource::setDataSourceOpacity(const std::shared_ptr<TileDataSource>& dataSource, float opacity) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto it = std::find_if(_dataSources.begin(), _dataSources.end(), [&dataSource](const DataSourceInfo& dataSourceInfo) {
+                return dataSourceInfo.dataSource.get() == dataSource;
+            });
+            if (it == _dataSources.end()) {
+                return;
+            }
+            it->opacity = std::min(1.0f, std::max(0.0f, opacity));
+        }
+        notifyTilesChanged(false);
+    }
+
+    int CompositeRasterTileDataSource::getMinZoom() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_dataSources.empty()) {
+            return TileDataSource::getMinZoom();
+        }
+        int minZoom = Const::MAX_SUPPORTED_ZOOM_LEVEL;
+        for (const DataSourceInfo& dataSourceInfo : _dataSources) {
+            minZoom = std::min(minZoom, dataSourceInfo.dataSource->getMinZoom());
+        }
+        return minZoom;
+    }
+
+    int CompositeRasterTileDataSource::getMaxZoom() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_dataSources.empty()) {
+            return TileDataSource::getMaxZoom();
+        }
+        int maxZoom = 0;
+        for (const DataSourceInfo& dataSourceInfo : _dataSources) {
+            maxZoom = std::max(maxZoom, dataSourceInfo.dataSource->getMaxZoom());
+        }
+        return maxZoom;
+    }
+
+    MapBounds CompositeRasterTileDataSource::getDataExtent() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_dataSources.empty()) {
+            return TileDataSource::getDataExtent();
+        }
+        MapBounds bounds;
+        for (const DataSourceInfo& dataSourceInfo : _dataSources) {
+            bounds.expandToContain(dataSourceInfo.dataSource->getDataExtent());
+        }
+        return bounds;
+    }
+
+    std::shared_ptr<TileData> CompositeRasterTileDataSource::loadTile(const MapTile& mapTile) {
+        std::vector<DataSourceInfo> dataSources;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            dataSources = _dataSources;
+        }
+
+        // Composite the tiles from bottom to top. The size of the first available tile is used for the result.
+        std::vector<unsigned char> pixels;
+        unsigned int width = 0, height = 0;
+        long long maxAge = -1;
+        for (const DataSourceInfo& dataSourceInfo : dataSources) {
+            if (dataSourceInfo.opacity <= 0.0f) {
+                continue;
+            }
+            std::shared_ptr<Bitmap> bitmap = LoadBitmap(dataSourceInfo, mapTile, maxAge);
+            if (!bitmap) {
+                continue;
+            }
+            if (pixels.empty()) {
+                width = bitmap->getWidth();
+                height = bitmap->getHeight();
+                pixels.assign(width * height * 4, 0);
+            } else if (bitmap->getWidth() != width || bitmap->getHeight() != height) {
+                bitmap = bitmap->getResizedBitmap(width, height);
+                if (!bitmap) {
+                    continue;
+                }
+            }
+            BlendBitmap(pixels, *bitmap, dataSourceInfo.opacity, dataSourceInfo.blendMode);
+        }
+
+        if (pixels.empty()) {
+            auto tileData = std::make_shared<TileData>(std::shared_ptr<BinaryData>());
+            tileData->setReplaceWithParent(true);
+            return tileData;
+        }
+
+        // Use the internal bitmap format, as the tile is decoded immediately by the layer
+        Bitmap compositeBitmap(pixels.data(), width, height, ColorFormat::COLOR_FORMAT_RGBA, 4 * width);
+        auto tileData = std::make_shared<TileData>(compositeBitmap.compressToInternal());
+        if (maxAge >= 0) {
+            tileData->setMaxAge(maxAge);
+        }
+        return tileData;
+    }
+
+    CompositeRasterTileDataSource::DataSourceListener::DataSourceListener(CompositeRasterTileDataSource& compositeDataSource) :
+        _compositeDataSource(compositeDataSource)
+    {
+    }
+
+    void CompositeRasterTileDataSource::DataSourceListener::onTilesChanged(bool removeTiles) {
+        _compositeDataSource.notifyTilesChanged(removeTiles);
+    }
+
+    void CompositeRasterTileDataSource::DataSourceListener::onTilesChanged(const MapBounds& bounds, int minZoom, int maxZoom, bool removeTiles) {
+        _compositeDataSource.notifyTilesChanged(bounds, minZoom, maxZoom, removeTiles);
+    }
+
+    std::shared_ptr<Bitmap> CompositeRasterTileDataSource::LoadBitmap(const DataSourceInfo& dataSourceInfo, const MapTile& mapTile, long long& maxAge) {
+        const DirectorPtr<TileDataSource>& dataSource = dataSourceInfo.dataSource;
+        if (mapTile.getZoom() < dataSource->getMinZoom()) {
+            return std::shared_ptr<Bitmap>();
+        }
+
+        // Use the parent tile if the data source does not contain tiles for the requested zoom level
+        MapTile dataSourceTile = mapTile;
+        std::shared_ptr<TileData> tileData;
+        while (true) {
+            if (dataSourceTile.getZoom() <= dataSource->getMaxZoom()) {
+                tileData = dataSource->loadTile(dataSourceTile);
+                if (!tileData || !tileData->isReplaceWithParent()) {
+                    break;
+                }
+            }
+            if (dataSourceTile.getZoom() <= dataSource->getMinZoom()) {
+                return std::shared_ptr<Bitmap>();
+            }
+            dataSourceTile = dataSourceTile.getParent();
+        }
+        if (!tileData || !tileData->getData()) {
+            return std::shared_ptr<Bitmap>();
+        }
+        if (tileData->getMaxAge() >= 0) {
+            maxAge = (maxAge >= 0 ? std::min(maxAge, tileData->getMaxAge()) : tileData->getMaxAge());
+        }
+
+        std::shared_ptr<Bitmap> bitmap = Bitmap::CreateFromCompressed(tileData->getData());
+        if (!bitmap) {
+            Log::Errorf("CompositeRasterTileDataSource::LoadBitmap: Failed to decode tile %s", mapTile.toString().c_str());
+            return std::shared_ptr<Bitmap>();
+        }
+        if (bitmap->getColorFormat() != ColorFormat::COLOR_FORMAT_RGBA) {
+            bitmap = bitmap->getRGBABitmap();
+        }
+
+        // Extract the corresponding part of the parent tile
+        if (dataSourceTile != mapTile) {
+            int deltaZoom = mapTile.getZoom() - dataSourceTile.getZoom();
+            int x = (bitmap->getWidth()  * (mapTile.getX() & ((1 << deltaZoom) - 1))) >> deltaZoom;
+            int y = (bitmap->getHeight() * (mapTile.getY() & ((1 << deltaZoom) - 1))) >> deltaZoom;
+            int w = bitmap->getWidth()  >> deltaZoom;
+            int h = bitmap->getHeight() >> deltaZoom;
+            std::shared_ptr<Bitmap> subBitmap = bitmap->getSubBitmap(x, y, std::max(w, 1), std::max(h, 1));
+            if (!subBitmap) {
+                return std::shared_ptr<Bitmap>();
+            }
+            bitmap = subBitmap->getResizedBitmap(bitmap->getWidth(), bitmap->getHeight());
+        }
+        return bitmap;
+    }
+
+    void CompositeRasterTileDataSource::BlendBitmap(std::vector<unsigned char>& pixels, const Bitmap& bitmap, float opacity, RasterBlendMode::RasterBlendMode blendMode) {
+        // Both the destination and the source are premultiplied RGBA
+        const std::vector<unsigned char>& srcPixels = bitmap.getPixelData();
+        unsigned int alpha = static_cast<unsigned int>(opacity * 255.0f + 0.5f);
+        for (std::size_t i = 0; i + 3 < pixels.size() && i + 3 < srcPixels.size(); i += 4) {
+            unsigned int src[4], dst[4];
+            for (int j = 0; j < 4; j++) {
+                src[j] = (srcPixels[i + j] * alpha + 127) / 255;
+                dst[j] = pixels[i + j];
+            }
+            unsigned int invSrcA = 255 - src[3];
+            unsigned int invDstA = 255 - dst[3];
+            for (int j = 0; j < 4; j++) {
+                unsigned int result = 0;
+                switch (blendMode) {
+                case RasterBlendMode::RASTER_BLEND_MODE_MULTIPLY:
+                    result = (src[j] * dst[j] + src[j] * invDstA + dst[j] * invSrcA + 127) / 255;
+                    break;
+                case RasterBlendMode::RASTER_BLEND_MODE_SCREEN:
+                    result = src[j] + dst[j] - (src[j] * dst[j] + 127) / 255;
+                    break;
+                default:
+                    result = src[j] + (dst[j] * invSrcA + 127) / 255;
+                    break;
+                }
+                pixels[i + j] = static_cast<unsigned char>(std::min(result, 255u));
+            }
+        }
+    }
+
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_COMPOSITERASTERTILEDATASOURCE_H_
+#define _CARTO_COMPOSITERASTERTILEDATASOURCE_H_
+
+#include "datasources/TileDataSource.h"
+#include "components/DirectorPtr.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace carto {
+    class Bitmap;
+
+    namespace RasterBlendMode {
+        /**
+         * Supported blend modes for composited raster data sources.
+         */
+        enum RasterBlendMode {
+            /**
+             * The source image is drawn over the destination image.
+             */
+            RASTER_BLEND_MODE_NORMAL,
+            /**
+             * The source and destination colors are multiplied. Useful for hillshading.
+             */
+            RASTER_BLEND_MODE_MULTIPLY,
+            /**
+             * The inverted source and destination colors are multiplied and the result is inverted.
+             */
+            RASTER_BLEND_MODE_SCREEN
+        };
+    }
+
+    /**
+     * A raster tile data source that composites the tiles of multiple raster data sources into a single tile.
+     * Using a single raster tile layer with this data source instead of stacking multiple raster tile layers
+     * (for example, satellite imagery, hillshading and a weather overlay) avoids the overdraw and
+     * the extra render passes of the stacked layers. Each data source is composited with its own opacity and blend mode,
+     * in the order the data sources were added.
+     */
+    class CompositeRasterTileDataSource : public TileDataSource {
+    public:
+        /**
+         * Constructs a composite raster tile data source object with no data sources.
+         */
+        CompositeRasterTileDataSource();
+        virtual ~CompositeRasterTileDataSource();
+
+        /**
+         * Adds a data source to the top of the composition.
+         * @param dataSource The raster data source to add.
+         * @param opacity The opacity of the data source tiles, between 0 and 1.
+         * @param blendMode The blend mode to use when compositing the data source tiles.
+         * @throws std::invalid_argument If the data source is null.
+         */
+        void addDataSource(const std::shared_ptr<TileDataSource>& dataSource, float opacity, RasterBlendMode::RasterBlendMode blendMode);
+        /**
+         * Removes a data source from the composition.
+         * @param dataSource The data source to remove.
+         * @return True if the data source was removed, false if it was not part of the composition.
+         */
+        bool removeDataSource(const std::shared_ptr<TileDataSource>& dataSource);
+
+        /**
+         * Returns the opacity of the given data source.
+         * @param dataSource The data source to use.
+         * @return The opacity of the data source, or 0 if the data source is not part of the composition.
+         */
+        float getDataSourceOpacity(const std::shared_ptr<TileDataSource>& dataSource) const;
+        /**
+         * Sets the opacity of the given data source.
+         * @param dataSource The data source to use.
+         * @param opacity The new opacity of the data source, between 0 and 1.
+         */
+        void setDataSourceOpacity(const std::shared_ptr<TileDataSource>& dataSource, float opacity);
+
+        virtual int getMinZoom() const;
+        virtual int getMaxZoom() const;
+
+        virtual MapBounds getDataExtent() const;
+
+        virtual std::shared_ptr<TileData> loadTile(const MapTile& tile);
+
+    protected:
+        class DataSourceListener : public TileDataSource::OnChangeListener {
+        public:
+            explicit DataSourceListener(CompositeRasterTileDataSource& compositeDataSource);
+
+            virtual void onTilesChanged(bool removeTiles);
+            virtual void onTilesChanged(const MapBounds& bounds, int minZoom, int maxZoom, bool removeTiles);
+
+        private:
+            CompositeRasterTileDataSource& _compositeDataSource;
+        };
+
+        struct DataSourceInfo {
+            DirectorPtr<TileDataSource> dataSource;
+            float opacity;
+            RasterBlendMode::RasterBlendMode blendMode;
+
+            DataSourceInfo(const std::shared_ptr<TileDataSource>& dataSource, float opacity, RasterBlendMode::RasterBlendMode blendMode) : dataSource(dataSource), opacity(opacity), blendMode(blendMode) { }
+        };
+
+        static std::shared_ptr<Bitmap> LoadBitmap(const DataSourceInfo& dataSourceInfo, const MapTile& mapTile, long long& maxAge);
+        static void BlendBitmap(std::vector<unsigned char>& pixels, const Bitmap& bitmap, float opacity, RasterBlendMode::RasterBlendMode blendMode);
+
+        std::vector<DataSourceInfo> _dataSources;
+        mutable std::mutex _mutex;
+
+    private:
+        std::shared_ptr<DataSourceListener> _dataSourceListener;
+    };
+
+}
+
+#endif
@@ -19,6 +19,8 @@
 #include "assets/gdal/projop_wparm_csv.h"
 #include "assets/gdal/unit_of_measure_csv.h"
 
+#include <cmath>
+
 #include <boost/lexical_cast.hpp>
 
 #include <gdal_priv.h>
@@ -90,6 +92,9 @@ namespace carto {
 
     GDALRasterTileDataSource::GDALRasterTileDataSource(int minZoom, int maxZoom, const std::string& fileName) :
         TileDataSource(minZoom, maxZoom),
+        _fileName(fileName),
+        _poDataset(nullptr),
+        _datasetPool(),
         _width(0),
         _height(0),
         _tileSize(256),
@@ -119,6 +124,9 @@ namespace carto {
     
     GDALRasterTileDataSource::GDALRasterTileDataSource(int minZoom, int maxZoom, const std::string& fileName, const std::string& srs) :
         TileDataSource(minZoom, maxZoom),
+        _fileName(fileName),
+        _poDataset(nullptr),
+        _datasetPool(),
         _width(0),
         _height(0),
         _tileSize(256),
@@ -159,6 +167,9 @@ namespace carto {
     }
     
     GDALRasterTileDataSource::~GDALRasterTileDataSource() {
+        for (GDALDataset* poDataset : _datasetPool) {
+            delete poDataset;
+        }
         if (_poDataset) {
             delete _poDataset;
         }
@@ -219,13 +230,16 @@ namespace carto {
         BitmapFilterTable filterTable(minUds, minVds, maxUds, maxVds);
         filterTable.calculateFilterTable(AffineTransform(invTransformDS), _tileSize, _tileSize, FILTER_SCALE, MAX_FILTER_WIDTH);
 
-        // Read tile data by band
-        std::lock_guard<std::mutex> lock(_mutex);
+        // Read tile data by band. Use a dataset handle of its own, so that tiles can be read concurrently
+        std::shared_ptr<GDALDataset> poDataset = acquireDataset();
+        if (!poDataset) {
+            return std::shared_ptr<TileData>();
+        }
 
         std::vector<unsigned char> data(_tileSize * _tileSize * 4);
         std::vector<unsigned char> bandData((maxUds - minUds) * (maxVds - minVds));
-        for (int n = 1; n <= _poDataset->GetRasterCount(); n++) {
-            GDALRasterBand* poRasterBand = _poDataset->GetRasterBand(n);
+        for (int n = 1; n <= poDataset->GetRasterCount(); n++) {
+            GDALRasterBand* poRasterBand = poDataset->GetRasterBand(n);
             if (!poRasterBand) {
                 Log::Warnf("GDALRasterTileDataSource: Failed to read band %d", n);
                 continue;
@@ -257,7 +271,21 @@ namespace carto {
                 continue;
             }
 
-            poRasterBand->RasterIO(GF_Read, minU, minV, maxU - minU, maxV - minV, (void *)&bandData[0], maxUds - minUds, maxVds - minVds, GDT_Byte, 0, 0);
+            // Read from the overview level closest to the downsampled resolution, map the window to overview pixels
+            GDALRasterBand* poReadBand = FindOverviewBand(poRasterBand, _width, _height, downsampleU, downsampleV);
+            double overviewScaleU = static_cast<double>(poReadBand->GetXSize()) / _width;
+            double overviewScaleV = static_cast<double>(poReadBand->GetYSize()) / _height;
+            int readMinU = std::max(0, static_cast<int>(std::floor(minU * overviewScaleU)));
+            int readMinV = std::max(0, static_cast<int>(std::floor(minV * overviewScaleV)));
+            int readMaxU = std::max(readMinU + 1, std::min(poReadBand->GetXSize(), static_cast<int>(std::ceil(maxU * overviewScaleU))));
+            int readMaxV = std::max(readMinV + 1, std::min(poReadBand->GetYSize(), static_cast<int>(std::ceil(maxV * overviewScaleV))));
+
+            // Let the driver fetch all internal blocks (tiles or strips) intersecting the window at once
+            poReadBand->AdviseRead(readMinU, readMinV, readMaxU - readMinU, readMaxV - readMinV, maxUds - minUds, maxVds - minVds, GDT_Byte, nullptr);
+            if (poReadBand->RasterIO(GF_Read, readMinU, readMinV, readMaxU - readMinU, readMaxV - readMinV, (void *)&bandData[0], maxUds - minUds, maxVds - minVds, GDT_Byte, 0, 0) != CE_None) {
+                Log::Warnf("GDALRasterTileDataSource: Failed to read data from band %d", n);
+                continue;
+            }
 
             std::size_t sampleIndex = 0;
             const std::vector<BitmapFilterTable::Sample>& samples = filterTable.getSamples();
@@ -315,6 +343,56 @@ namespace carto {
         return bounds;
     }
 
+    std::shared_ptr<GDALDataset> GDALRasterTileDataSource::acquireDataset() {
+        GDALDataset* poDataset = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_datasetPool.empty()) {
+                poDataset = _datasetPool.back();
+                _datasetPool.pop_back();
+            }
+        }
+        if (!poDataset) {
+            poDataset = (GDALDataset*)GDALOpen(_fileName.c_str(), GA_ReadOnly);
+            if (!poDataset) {
+                Log::Errorf("GDALRasterTileDataSource::acquireDataset: Failed to open file %s", _fileName.c_str());
+                return std::shared_ptr<GDALDataset>();
+            }
+        }
+        return std::shared_ptr<GDALDataset>(poDataset, [this](GDALDataset* poDataset) { releaseDataset(poDataset); });
+    }
+
+    void GDALRasterTileDataSource::releaseDataset(GDALDataset* poDataset) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_datasetPool.size() < MAX_DATASET_POOL_SIZE) {
+                _datasetPool.push_back(poDataset);
+                return;
+            }
+        }
+        delete poDataset;
+    }
+
+    GDALRasterBand* GDALRasterTileDataSource::FindOverviewBand(GDALRasterBand* poRasterBand, int width, int height, int downsampleU, int downsampleV) {
+        // Pick the coarsest overview that still has at least the downsampled resolution
+        GDALRasterBand* poBestBand = poRasterBand;
+        int bestXSize = width;
+        for (int i = 0; i < poRasterBand->GetOverviewCount(); i++) {
+            GDALRasterBand* poOverviewBand = poRasterBand->GetOverview(i);
+            if (!poOverviewBand || poOverviewBand->GetXSize() <= 0 || poOverviewBand->GetYSize() <= 0) {
+                continue;
+            }
+            if (static_cast<long long>(poOverviewBand->GetXSize()) << downsampleU < width || static_cast<long long>(poOverviewBand->GetYSize()) << downsampleV < height) {
+                continue;
+            }
+            if (poOverviewBand->GetXSize() < bestXSize) {
+                poBestBand = poOverviewBand;
+                bestXSize = poOverviewBand->GetXSize();
+            }
+        }
+        return poBestBand;
+    }
+
     void GDALRasterTileDataSource::initializeTransform(const std::shared_ptr<OGRSpatialReference>& poDatasetSpatialRef) {
         std::shared_ptr<OGRSpatialReference> poEPSG3857SpatialRef = std::make_shared<OGRSpatialReference>();
         if (poEPSG3857SpatialRef->importFromEPSG(3857) != OGRERR_NONE) {
@@ -378,6 +456,7 @@ namespace carto {
     const float GDALRasterTileDataSource::FILTER_SCALE = 1.5f;
     const int GDALRasterTileDataSource::MAX_FILTER_WIDTH = 16;
     const int GDALRasterTileDataSource::MAX_DOWNSAMPLE_FACTOR = 8;
+    const std::size_t GDALRasterTileDataSource::MAX_DATASET_POOL_SIZE = 4;
 }
 
 #endif
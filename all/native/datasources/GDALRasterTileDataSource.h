@@ -11,10 +11,16 @@
 
 #include "datasources/TileDataSource.h"
 
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
 #include <cglib/vec.h>
 #include <cglib/mat.h>
 
 class GDALDataset;
+class GDALRasterBand;
 class OGRSpatialReference;
 
 namespace carto {
@@ -52,11 +58,19 @@ namespace carto {
     private:
         void initializeTransform(const std::shared_ptr<OGRSpatialReference>& poDatasetSpatialRef);
 
+        std::shared_ptr<GDALDataset> acquireDataset();
+        void releaseDataset(GDALDataset* poDataset);
+
+        static GDALRasterBand* FindOverviewBand(GDALRasterBand* poRasterBand, int width, int height, int downsampleU, int downsampleV);
+
         static const float FILTER_SCALE;
         static const int MAX_FILTER_WIDTH;
         static const int MAX_DOWNSAMPLE_FACTOR;
+        static const std::size_t MAX_DATASET_POOL_SIZE;
 
+        std::string _fileName;
         GDALDataset* _poDataset;
+        std::vector<GDALDataset*> _datasetPool; // additional dataset handles for concurrent reads, GDAL datasets are not thread safe
         int _width;
         int _height;
         int _tileSize;
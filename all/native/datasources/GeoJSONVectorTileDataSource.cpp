@@ -2,11 +2,14 @@
 #include "core/BinaryData.h"
 #include "core/MapTile.h"
 #include "components/Exceptions.h"
+#include "geometry/Feature.h"
 #include "geometry/FeatureCollection.h"
+#include "geometry/Geometry.h"
 #include "geometry/GeoJSONGeometryWriter.h"
 #include "projections/Projection.h"
 #include "utils/Const.h"
 #include "utils/Log.h"
+#include "utils/JSONUtils.h"
 
 #include <mbvtbuilder/MBVTTileBuilder.h>
 
@@ -17,7 +20,9 @@ namespace carto {
     GeoJSONVectorTileDataSource::GeoJSONVectorTileDataSource(int minZoom, int maxZoom) :
         TileDataSource(minZoom, maxZoom),
         _tileBuilder(new mbvtbuilder::MBVTTileBuilder(minZoom, maxZoom)),
-        _mutex()
+        _mutex(),
+        _tileCache(TILE_CACHE_SIZE),
+        _tileCacheMutex()
     {
     }
     
@@ -29,6 +34,7 @@ namespace carto {
         try {
             std::lock_guard<std::mutex> lock(_mutex);
             layerIndex = _tileBuilder->createLayer(name);
+            invalidateCachedTiles(_projection->getBounds());
         }
         catch (const std::exception& ex) {
             Log::Errorf("GeoJSONVectorTileDataSource::createLayer: Failed to create layer: %s", ex.what());
@@ -43,6 +49,7 @@ namespace carto {
             std::lock_guard<std::mutex> lock(_mutex);
             _tileBuilder->clearLayer(layerIndex);
             _tileBuilder->importGeoJSONFeatureCollection(layerIndex, geoJSON.toPicoJSON());
+            invalidateCachedTiles(_projection->getBounds());
         }
         catch (const std::exception& ex) {
             Log::Errorf("GeoJSONVectorTileDataSource::setLayerGeoJSON: Failed to update layer: %s", ex.what());
@@ -57,11 +64,8 @@ namespace carto {
         }
 
         try {
-            GeoJSONGeometryWriter geometryWriter;
-            geometryWriter.setSourceProjection(projection);
-            geometryWriter.setZ(false);
             picojson::value geoJSON;
-            std::string err = picojson::parse(geoJSON, geometryWriter.writeFeatureCollection(featureCollection));
+            std::string err = JSONUtils::ParsePicoJSON(geoJSON, serializeFeatureCollection(projection, featureCollection));
             if (!err.empty()) {
                 throw GenericException("Error while serializing feature data", err);
             }
@@ -69,6 +73,7 @@ namespace carto {
             std::lock_guard<std::mutex> lock(_mutex);
             _tileBuilder->clearLayer(layerIndex);
             _tileBuilder->importGeoJSONFeatureCollection(layerIndex, geoJSON);
+            invalidateCachedTiles(_projection->getBounds());
         }
         catch (const std::exception& ex) {
             Log::Errorf("GeoJSONVectorTileDataSource::setLayerGeoJSON: Failed to update layer: %s", ex.what());
@@ -76,11 +81,37 @@ namespace carto {
         }
         notifyTilesChanged(false);
     }
+
+    void GeoJSONVectorTileDataSource::addLayerFeatureCollection(int layerIndex, const std::shared_ptr<Projection>& projection, const std::shared_ptr<FeatureCollection>& featureCollection) {
+        if (!featureCollection) {
+            throw NullArgumentException("Null featureCollection");
+        }
+
+        MapBounds bounds;
+        try {
+            picojson::value geoJSON;
+            std::string err = JSONUtils::ParsePicoJSON(geoJSON, serializeFeatureCollection(projection, featureCollection));
+            if (!err.empty()) {
+                throw GenericException("Error while serializing feature data", err);
+            }
+            bounds = calculateFeatureCollectionBounds(projection, featureCollection);
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            _tileBuilder->importGeoJSONFeatureCollection(layerIndex, geoJSON);
+            invalidateCachedTiles(bounds);
+        }
+        catch (const std::exception& ex) {
+            Log::Errorf("GeoJSONVectorTileDataSource::addLayerFeatureCollection: Failed to update layer: %s", ex.what());
+            throw GenericException("Failed to add layer contents", ex.what());
+        }
+        notifyAreaTilesChanged(bounds);
+    }
     
     void GeoJSONVectorTileDataSource::deleteLayer(int layerIndex) {
         try {
             std::lock_guard<std::mutex> lock(_mutex);
             _tileBuilder->deleteLayer(layerIndex);
+            invalidateCachedTiles(_projection->getBounds());
         }
         catch (const std::exception& ex) {
             Log::Errorf("GeoJSONVectorTileDataSource::deleteLayer: Failed to delete layer: %s", ex.what());
@@ -101,12 +132,24 @@ namespace carto {
     }
     
     std::shared_ptr<TileData> GeoJSONVectorTileDataSource::loadTile(const MapTile& mapTile) {
+        {
+            std::lock_guard<std::mutex> lock(_tileCacheMutex);
+            CachedTile cachedTile;
+            if (_tileCache.read(mapTile.getTileId(), cachedTile)) {
+                return std::make_shared<TileData>(cachedTile.data);
+            }
+        }
+
         std::lock_guard<std::mutex> lock(_mutex);
         Log::Infof("GeoJSONVectorTileDataSource::loadTile: Loading %s", mapTile.toString().c_str());
         try {
             protobuf::encoded_message encodedTile;
             _tileBuilder->buildTile(mapTile.getZoom(), mapTile.getX(), mapTile.getY(), encodedTile);
             auto data = std::make_shared<BinaryData>(reinterpret_cast<const unsigned char*>(encodedTile.data().data()), encodedTile.data().size());
+            {
+                std::lock_guard<std::mutex> lock(_tileCacheMutex);
+                _tileCache.put(mapTile.getTileId(), CachedTile { mapTile, data }, data->size());
+            }
             return std::make_shared<TileData>(data);
         }
         catch (const std::exception& ex) {
@@ -114,5 +157,65 @@ namespace carto {
             return std::shared_ptr<TileData>();
         }
     }
+
+    std::string GeoJSONVectorTileDataSource::serializeFeatureCollection(const std::shared_ptr<Projection>& projection, const std::shared_ptr<FeatureCollection>& featureCollection) const {
+        GeoJSONGeometryWriter geometryWriter;
+        geometryWriter.setSourceProjection(projection);
+        geometryWriter.setZ(false);
+        return geometryWriter.writeFeatureCollection(featureCollection);
+    }
+
+    MapBounds GeoJSONVectorTileDataSource::calculateFeatureCollectionBounds(const std::shared_ptr<Projection>& projection, const std::shared_ptr<FeatureCollection>& featureCollection) const {
+        MapBounds bounds;
+        for (int i = 0; i < featureCollection->getFeatureCount(); i++) {
+            const std::shared_ptr<Geometry>& geometry = featureCollection->getFeature(i)->getGeometry();
+            if (!geometry) {
+                continue;
+            }
+            const MapBounds& geometryBounds = geometry->getBounds();
+            for (int j = 0; j < 4; j++) {
+                MapPos pos((j & 1) ? geometryBounds.getMax().getX() : geometryBounds.getMin().getX(), (j & 2) ? geometryBounds.getMax().getY() : geometryBounds.getMin().getY());
+                bounds.expandToContain(_projection->fromWgs84(projection ? projection->toWgs84(pos) : pos));
+            }
+        }
+        return bounds;
+    }
+
+    void GeoJSONVectorTileDataSource::invalidateCachedTiles(const MapBounds& bounds) {
+        std::lock_guard<std::mutex> lock(_tileCacheMutex);
+        if (bounds.contains(_projection->getBounds())) {
+            _tileCache.clear();
+            return;
+        }
+
+        // Tiles include geometry from a buffer zone around them, so neighbouring tiles may be affected too. Note: data source tiles are vertically flipped.
+        MapBounds projBounds = _projection->getBounds();
+        for (long long tileId : _tileCache.keys()) {
+            CachedTile cachedTile;
+            if (!_tileCache.peek(tileId, cachedTile)) {
+                continue;
+            }
+            const MapTile& tile = cachedTile.tile;
+            double tileWidth  = projBounds.getDelta().getX() / (1 << tile.getZoom());
+            double tileHeight = projBounds.getDelta().getY() / (1 << tile.getZoom());
+            MapPos tileMin(projBounds.getMin().getX() + tileWidth * (tile.getX() - TILE_BUFFER), projBounds.getMax().getY() - tileHeight * (tile.getY() + 1 + TILE_BUFFER));
+            MapPos tileMax(projBounds.getMin().getX() + tileWidth * (tile.getX() + 1 + TILE_BUFFER), projBounds.getMax().getY() - tileHeight * (tile.getY() - TILE_BUFFER));
+            if (bounds.intersects(MapBounds(tileMin, tileMax))) {
+                _tileCache.remove(tileId);
+            }
+        }
+    }
+
+    void GeoJSONVectorTileDataSource::notifyAreaTilesChanged(const MapBounds& bounds) {
+        // Tiles include geometry from a buffer zone around them, the size of the zone depends on the zoom level
+        MapBounds projBounds = _projection->getBounds();
+        for (int zoom = getMinZoom(); zoom <= getMaxZoom(); zoom++) {
+            MapVec buffer(projBounds.getDelta().getX() / (1 << zoom) * TILE_BUFFER, projBounds.getDelta().getY() / (1 << zoom) * TILE_BUFFER);
+            notifyTilesChanged(MapBounds(bounds.getMin() - buffer, bounds.getMax() + buffer), zoom, zoom, false);
+        }
+    }
+
+    const float GeoJSONVectorTileDataSource::TILE_BUFFER = 0.5f;
+    const std::size_t GeoJSONVectorTileDataSource::TILE_CACHE_SIZE = 8 * 1024 * 1024;
     
 }
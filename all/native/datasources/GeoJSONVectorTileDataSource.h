@@ -14,7 +14,10 @@
 #include <mutex>
 #include <string>
 
+#include <stdext/timed_lru_cache.h>
+
 namespace carto {
+    class BinaryData;
     namespace mbvtbuilder {
         class MBVTTileBuilder;
     }
@@ -61,6 +64,16 @@ namespace carto {
          */
         void setLayerFeatureCollection(int layerIndex, const std::shared_ptr<Projection>& projection, const std::shared_ptr<FeatureCollection>& featureCollection);
 
+        /**
+         * Adds features to the specified layer, keeping the existing features of the layer.
+         * Unlike setting the layer contents, only the tiles touched by the added features need to be rebuilt.
+         * @param layerIndex The index of the layer. A layer with empty name will be created if it does not exist yet.
+         * @param projection Projection for the features in featureCollection. Can be null if the coordinates are based on WGS84.
+         * @param featureCollection The feature collection to add to the specified layer.
+         * @throws std::runtime_error If an error occured during updating the layer.
+         */
+        void addLayerFeatureCollection(int layerIndex, const std::shared_ptr<Projection>& projection, const std::shared_ptr<FeatureCollection>& featureCollection);
+
         /**
          * Deletes an existing layer.
          * @param layerIndex The index of layer to delete.
@@ -72,8 +85,24 @@ namespace carto {
         virtual std::shared_ptr<TileData> loadTile(const MapTile& mapTile);
     
     private:
+        struct CachedTile {
+            MapTile tile;
+            std::shared_ptr<BinaryData> data;
+        };
+
+        std::string serializeFeatureCollection(const std::shared_ptr<Projection>& projection, const std::shared_ptr<FeatureCollection>& featureCollection) const;
+        MapBounds calculateFeatureCollectionBounds(const std::shared_ptr<Projection>& projection, const std::shared_ptr<FeatureCollection>& featureCollection) const;
+        void invalidateCachedTiles(const MapBounds& bounds);
+        void notifyAreaTilesChanged(const MapBounds& bounds);
+
+        static const float TILE_BUFFER;
+        static const std::size_t TILE_CACHE_SIZE;
+
         std::unique_ptr<mbvtbuilder::MBVTTileBuilder> _tileBuilder;
         mutable std::mutex _mutex;
+
+        cache::timed_lru_cache<long long, CachedTile> _tileCache; // built tiles, shared between data source updates
+        mutable std::mutex _tileCacheMutex; // lock order: _mutex before _tileCacheMutex
     };
     
 }
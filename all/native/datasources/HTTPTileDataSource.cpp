@@ -1,9 +1,16 @@
 #include "HTTPTileDataSource.h"
 #include "core/MapTile.h"
+#include "datasources/components/ConcurrentTileLoader.h"
 #include "utils/Log.h"
 #include "utils/NetworkUtils.h"
 #include "utils/GeneralUtils.h"
 
+#include <algorithm>
+#include <functional>
+#include <iterator>
+
+#include <boost/algorithm/string.hpp>
+
 namespace carto {
 
     HTTPTileDataSource::HTTPTileDataSource(int minZoom, int maxZoom, const std::string& baseURL) :
@@ -12,8 +19,12 @@ namespace carto {
         _subdomains({ "a", "b", "c", "d" }),
         _tmsScheme(false),
         _maxAgeHeaderCheck(false),
+        _maxConnectionsPerHost(-1),
         _headers(),
+        _missingTileMaxAge(DEFAULT_MISSING_TILE_MAX_AGE),
+        _missingTiles(),
         _httpClient(true),
+        _tileLoadCoalescer(),
         _randomGenerator(),
         _mutex()
     {
@@ -31,6 +42,7 @@ namespace carto {
         {
             std::lock_guard<std::mutex> lock(_mutex);
             _baseURL = baseURL;
+            _missingTiles.clear();
         }
         notifyTilesChanged(false);
     }
@@ -44,6 +56,7 @@ namespace carto {
         {
             std::lock_guard<std::mutex> lock(_mutex);
             _subdomains = subdomains;
+            _missingTiles.clear();
         }
         notifyTilesChanged(false);
     }
@@ -57,6 +70,7 @@ namespace carto {
         {
             std::lock_guard<std::mutex> lock(_mutex);
             _tmsScheme = tmsScheme;
+            _missingTiles.clear();
         }
         notifyTilesChanged(false);
     }
@@ -83,19 +97,73 @@ namespace carto {
         {
             std::lock_guard<std::mutex> lock(_mutex);
             _headers = headers;
+            _missingTiles.clear();
         }
         notifyTilesChanged(false);
     }
     
+    int HTTPTileDataSource::getMaxConnectionsPerHost() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _maxConnectionsPerHost;
+    }
+
+    void HTTPTileDataSource::setMaxConnectionsPerHost(int maxConnections) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _maxConnectionsPerHost = maxConnections;
+        _httpClient.setMaxConnectionsPerHost(maxConnections);
+    }
+    
+    int HTTPTileDataSource::getMissingTileMaxAge() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _missingTileMaxAge;
+    }
+
+    void HTTPTileDataSource::setMissingTileMaxAge(int maxAge) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _missingTileMaxAge = std::max(0, maxAge);
+        _missingTiles.clear();
+    }
+
     std::shared_ptr<TileData> HTTPTileDataSource::loadTile(const MapTile& mapTile) {
+        // Known missing tiles are replaced with parent tiles without requests
+        if (isMissingTile(mapTile)) {
+            return CreateMissingTileData(getMissingTileMaxAge());
+        }
+
+        // Concurrent requests for the same tile share a single download
+        return _tileLoadCoalescer.load(mapTile.getTileId(), std::bind(&HTTPTileDataSource::loadOnlineTile, this, mapTile, std::shared_ptr<TileData>()));
+    }
+
+    std::vector<std::shared_ptr<TileData> > HTTPTileDataSource::loadTiles(const std::vector<MapTile>& mapTiles) {
+        // Keep multiple requests in flight, limited by the connection count if it is set
+        int maxConcurrentLoads = getMaxConnectionsPerHost();
+        if (maxConcurrentLoads <= 0) {
+            maxConcurrentLoads = DEFAULT_MAX_CONCURRENT_LOADS;
+        }
+        return ConcurrentTileLoader::LoadTiles(mapTiles, [this](const MapTile& mapTile) {
+            return loadTile(mapTile);
+        }, maxConcurrentLoads);
+    }
+
+    bool HTTPTileDataSource::isBatchLoadingSupported() const {
+        return true;
+    }
+
+    std::shared_ptr<TileData> HTTPTileDataSource::revalidateTile(const MapTile& mapTile, const std::shared_ptr<TileData>& cachedTileData) {
+        return loadOnlineTile(mapTile, cachedTileData);
+    }
+
+    std::shared_ptr<TileData> HTTPTileDataSource::loadOnlineTile(const MapTile& mapTile, const std::shared_ptr<TileData>& cachedTileData) {
         std::string baseURL;
         std::map<std::string, std::string> headers;
         bool maxAgeHeaderCheck;
+        int missingTileMaxAge;
         {
             std::lock_guard<std::mutex> lock(_mutex);
             baseURL = _baseURL;
             headers = _headers;
             maxAgeHeaderCheck = _maxAgeHeaderCheck;
+            missingTileMaxAge = _missingTileMaxAge;
         }
 
         std::string url = buildTileURL(baseURL, mapTile);
@@ -103,11 +171,34 @@ namespace carto {
             return std::shared_ptr<TileData>();
         }
 
+        // Use conditional request if the expired tile has validators
+        std::string etag, lastModified;
+        if (cachedTileData && cachedTileData->getData()) {
+            etag = cachedTileData->getETag();
+            lastModified = cachedTileData->getLastModified();
+            if (!etag.empty()) {
+                headers["If-None-Match"] = etag;
+            }
+            if (!lastModified.empty()) {
+                headers["If-Modified-Since"] = lastModified;
+            }
+        }
+
         Log::Infof("HTTPTileDataSource::loadTile: Loading %s", url.c_str());
         std::map<std::string, std::string> responseHeaders;
         std::shared_ptr<BinaryData> responseData;
+        bool notModified = false;
         try {
-            if (_httpClient.get(url, headers, responseHeaders, responseData) != 0) {
+            int statusCode = -1;
+            int code = _httpClient.get(url, headers, responseHeaders, responseData, &statusCode);
+            if (code == 304 && (!etag.empty() || !lastModified.empty())) {
+                Log::Infof("HTTPTileDataSource::loadTile: Tile not modified %s", url.c_str());
+                notModified = true;
+            } else if ((statusCode == 404 || statusCode == 204) && missingTileMaxAge > 0 && mapTile.getZoom() > getMinZoom()) {
+                Log::Infof("HTTPTileDataSource::loadTile: Tile missing %s, redirecting to parent", url.c_str());
+                addMissingTile(mapTile, missingTileMaxAge);
+                return CreateMissingTileData(missingTileMaxAge);
+            } else if (code != 0) {
                 Log::Errorf("HTTPTileDataSource::loadTile: Failed to load %s", url.c_str());
                 return std::shared_ptr<TileData>();
             }
@@ -116,7 +207,16 @@ namespace carto {
             Log::Errorf("HTTPTileDataSource::loadTile: Exception while loading tile %d/%d/%d: %s", mapTile.getZoom(), mapTile.getX(), mapTile.getY(), ex.what());
             return std::shared_ptr<TileData>();
         }
-        auto tileData = std::make_shared<TileData>(responseData);
+        auto tileData = std::make_shared<TileData>(notModified ? cachedTileData->getData() : responseData);
+        tileData->setETag(notModified ? etag : std::string());
+        tileData->setLastModified(notModified ? lastModified : std::string());
+        for (auto it = responseHeaders.begin(); it != responseHeaders.end(); it++) {
+            if (boost::iequals(it->first, "ETag")) {
+                tileData->setETag(it->second);
+            } else if (boost::iequals(it->first, "Last-Modified")) {
+                tileData->setLastModified(it->second);
+            }
+        }
         if (maxAgeHeaderCheck) {
             int maxAge = NetworkUtils::GetMaxAgeHTTPHeader(responseHeaders);
             if (maxAge >= 0) {
@@ -146,4 +246,43 @@ namespace carto {
         return GeneralUtils::ReplaceTags(baseURL, tagValues, "{", "}", true);
     }
     
+    bool HTTPTileDataSource::isMissingTile(const MapTile& mapTile) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _missingTiles.find(mapTile.getTileId());
+        if (it == _missingTiles.end()) {
+            return false;
+        }
+        if (it->second <= std::chrono::steady_clock::now()) {
+            _missingTiles.erase(it);
+            return false;
+        }
+        return true;
+    }
+
+    void HTTPTileDataSource::addMissingTile(const MapTile& mapTile, int maxAge) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto now = std::chrono::steady_clock::now();
+        if (_missingTiles.size() >= MAX_MISSING_TILES) {
+            // Drop expired entries first, if this is not enough then start from scratch
+            for (auto it = _missingTiles.begin(); it != _missingTiles.end(); ) {
+                it = (it->second <= now ? _missingTiles.erase(it) : std::next(it));
+            }
+            if (_missingTiles.size() >= MAX_MISSING_TILES) {
+                _missingTiles.clear();
+            }
+        }
+        _missingTiles[mapTile.getTileId()] = now + std::chrono::milliseconds(maxAge);
+    }
+
+    std::shared_ptr<TileData> HTTPTileDataSource::CreateMissingTileData(int maxAge) {
+        auto tileData = std::make_shared<TileData>(std::shared_ptr<BinaryData>());
+        tileData->setReplaceWithParent(true);
+        tileData->setMaxAge(maxAge);
+        return tileData;
+    }
+
+    const int HTTPTileDataSource::DEFAULT_MAX_CONCURRENT_LOADS = 8;
+    const int HTTPTileDataSource::DEFAULT_MISSING_TILE_MAX_AGE = 3600 * 1000;
+    const std::size_t HTTPTileDataSource::MAX_MISSING_TILES = 4096;
+
 }
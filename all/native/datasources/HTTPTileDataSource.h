@@ -8,11 +8,14 @@
 #define _CARTO_HTTPTILEDATASOURCE_H_
 
 #include "datasources/TileDataSource.h"
+#include "datasources/components/TileLoadCoalescer.h"
 #include "network/HTTPClient.h"
 
+#include <chrono>
 #include <random>
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <mutex>
 
@@ -94,18 +97,68 @@ namespace carto {
          * @param headers A map of HTTP headers that will be used in subsequent requests.
          */
         void setHTTPHeaders(const std::map<std::string, std::string>& headers);
+
+        /**
+         * Returns the maximum number of simultaneous connections to a single tile server.
+         * @return The maximum number of connections per host. -1 if platform default is used.
+         */
+        int getMaxConnectionsPerHost() const;
+        /**
+         * Sets the maximum number of simultaneous connections to a single tile server.
+         * Connections are kept alive and reused for subsequent tile requests. If supported by the platform and the server,
+         * HTTP/2 is used and concurrent requests are multiplexed over a single connection.
+         * Note: on Android the connection pool is shared by the whole process and this setting is ignored.
+         * The default is -1 (platform default).
+         * @param maxConnections The maximum number of connections per host. -1 if platform default should be used.
+         */
+        void setMaxConnectionsPerHost(int maxConnections);
+
+        /**
+         * Returns the time missing tiles are remembered.
+         * @return The time in milliseconds missing tiles are remembered. 0 if missing tiles are not remembered.
+         */
+        int getMissingTileMaxAge() const;
+        /**
+         * Sets the time missing tiles (tiles the server responds with 404 or 204 status code) are remembered.
+         * Missing tiles are replaced with parent tiles and are not requested again until this time has passed.
+         * If the data source is cached by PersistentCacheTileDataSource, missing tiles are also stored in the cache.
+         * The default is 3600000 (1 hour).
+         * @param maxAge The time in milliseconds missing tiles are remembered. 0 if missing tiles should not be remembered.
+         */
+        void setMissingTileMaxAge(int maxAge);
     
         virtual std::shared_ptr<TileData> loadTile(const MapTile& mapTile);
+
+        virtual std::vector<std::shared_ptr<TileData> > loadTiles(const std::vector<MapTile>& mapTiles);
+
+        virtual bool isBatchLoadingSupported() const;
+
+        virtual std::shared_ptr<TileData> revalidateTile(const MapTile& mapTile, const std::shared_ptr<TileData>& cachedTileData);
     
     protected:
+        std::shared_ptr<TileData> loadOnlineTile(const MapTile& mapTile, const std::shared_ptr<TileData>& cachedTileData);
+
         virtual std::string buildTileURL(const std::string& baseURL, const MapTile& tile) const;
+
+        bool isMissingTile(const MapTile& mapTile) const;
+        void addMissingTile(const MapTile& mapTile, int maxAge) const;
+
+        static std::shared_ptr<TileData> CreateMissingTileData(int maxAge);
+
+        static const int DEFAULT_MAX_CONCURRENT_LOADS;
+        static const int DEFAULT_MISSING_TILE_MAX_AGE;
+        static const std::size_t MAX_MISSING_TILES;
     
         std::string _baseURL;
         std::vector<std::string> _subdomains;
         bool _tmsScheme;
         bool _maxAgeHeaderCheck;
+        int _maxConnectionsPerHost;
         std::map<std::string, std::string> _headers;
+        int _missingTileMaxAge;
+        mutable std::unordered_map<long long, std::chrono::steady_clock::time_point> _missingTiles;
         HTTPClient _httpClient;
+        TileLoadCoalescer _tileLoadCoalescer;
         mutable std::default_random_engine _randomGenerator;
         mutable std::mutex _mutex;
     };
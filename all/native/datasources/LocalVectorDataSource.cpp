@@ -10,6 +10,7 @@
 #include "geometry/GeometrySimplifier.h"
 #include "geometry/utils/KDTreeSpatialIndex.h"
 #include "geometry/utils/NullSpatialIndex.h"
+#include "geometry/utils/PackedRTreeSpatialIndex.h"
 #include "projections/Projection.h"
 #include "projections/PlanarProjectionSurface.h"
 #include "styles/PointStyle.h"
@@ -91,17 +92,27 @@ namespace carto {
             }
         }
 
+        // Calculate the element bounds without holding the lock, so that concurrent loadElements calls are not blocked
+        std::shared_ptr<ProjectionSurface> projectionSurface;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            projectionSurface = _projectionSurface;
+        }
+        std::vector<std::pair<cglib::bbox3<double>, std::shared_ptr<VectorElement> > > records = calculateElementRecords(elements, projectionSurface);
+
         std::vector<std::shared_ptr<VectorElement> > elementsAdded, elementsRemoved;
         {
             std::lock_guard<std::mutex> lock(_mutex);
+            if (_projectionSurface != projectionSurface) {
+                // The projection surface was changed meanwhile, the bounds must be recalculated
+                records = calculateElementRecords(elements, _projectionSurface);
+            }
+
             std::vector<std::shared_ptr<VectorElement> > oldElements = _spatialIndex->getAll();
             std::unordered_set<std::shared_ptr<VectorElement> > oldElementSet(oldElements.begin(), oldElements.end());
             
             // Rebuild spatial index, create list of added and removed elements
-            _spatialIndex->clear();
-            _spatialIndex->reserve(elements.size());
             for (const std::shared_ptr<VectorElement>& element : elements) {
-                cglib::bbox3<double> bounds = calculateElementBounds(element);
                 auto it = oldElementSet.find(element);
                 if (it != oldElementSet.end()) {
                     oldElementSet.erase(it);
@@ -110,8 +121,9 @@ namespace carto {
                     elementsAdded.push_back(element);
                     _elementId++;
                 }
-                _spatialIndex->insert(bounds, element);
             }
+            _spatialIndex->clear();
+            _spatialIndex->insertAll(records);
             std::copy(oldElementSet.begin(), oldElementSet.end(), std::back_inserter(elementsRemoved));
         }
         if (!elementsAdded.empty()) {
@@ -133,7 +145,7 @@ namespace carto {
         {
             std::lock_guard<std::mutex> lock(_mutex);
             element->setId(_elementId);
-            cglib::bbox3<double> bounds = calculateElementBounds(element);
+            cglib::bbox3<double> bounds = calculateElementBounds(element, _projectionSurface);
             _spatialIndex->insert(bounds, element);
             _elementId++;
         }
@@ -150,15 +162,24 @@ namespace carto {
             }
         }
 
+        // Calculate the element bounds without holding the lock, so that concurrent loadElements calls are not blocked
+        std::shared_ptr<ProjectionSurface> projectionSurface;
         {
             std::lock_guard<std::mutex> lock(_mutex);
-            _spatialIndex->reserve(_spatialIndex->size() + elements.size());
+            projectionSurface = _projectionSurface;
+        }
+        std::vector<std::pair<cglib::bbox3<double>, std::shared_ptr<VectorElement> > > records = calculateElementRecords(elements, projectionSurface);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_projectionSurface != projectionSurface) {
+                // The projection surface was changed meanwhile, the bounds must be recalculated
+                records = calculateElementRecords(elements, _projectionSurface);
+            }
             for (const std::shared_ptr<VectorElement>& element : elements) {
                 element->setId(_elementId);
-                cglib::bbox3<double> bounds = calculateElementBounds(element);
-                _spatialIndex->insert(bounds, element);
                 _elementId++;
             }
+            _spatialIndex->insertAll(records);
         }
         if (!elements.empty()) {
             notifyElementsAdded(elements);
@@ -178,7 +199,7 @@ namespace carto {
         bool removed = false;
         {
             std::lock_guard<std::mutex> lock(_mutex);
-            cglib::bbox3<double> bounds = calculateElementBounds(element);
+            cglib::bbox3<double> bounds = calculateElementBounds(element, _projectionSurface);
             removed = _spatialIndex->remove(bounds, element);
         }
         if (removed) {
@@ -199,13 +220,23 @@ namespace carto {
             }
         }
 
+        std::shared_ptr<ProjectionSurface> projectionSurface;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            projectionSurface = _projectionSurface;
+        }
+        std::vector<std::pair<cglib::bbox3<double>, std::shared_ptr<VectorElement> > > records = calculateElementRecords(elements, projectionSurface);
+
         std::vector<std::shared_ptr<VectorElement> > removedElements;
         {
             std::lock_guard<std::mutex> lock(_mutex);
-            for (const std::shared_ptr<VectorElement>& element : elements) {
-                cglib::bbox3<double> bounds = calculateElementBounds(element);
-                if (_spatialIndex->remove(bounds, element)) {
-                    removedElements.push_back(element);
+            if (_projectionSurface != projectionSurface) {
+                // The projection surface was changed meanwhile, the bounds must be recalculated
+                records = calculateElementRecords(elements, _projectionSurface);
+            }
+            for (const std::pair<cglib::bbox3<double>, std::shared_ptr<VectorElement> >& record : records) {
+                if (_spatialIndex->remove(record.first, record.second)) {
+                    removedElements.push_back(record.second);
                 }
             }
         }
@@ -247,18 +278,20 @@ namespace carto {
         }
 
         std::vector<std::shared_ptr<VectorElement> > elements;
+        elements.reserve(featureCollection->getFeatureCount());
         for (int i = 0; i < featureCollection->getFeatureCount(); i++) {
             std::shared_ptr<Feature> feature = featureCollection->getFeature(i);
             if (std::shared_ptr<VectorElement> element = createElement(feature->getGeometry(), style)) {
                 const Variant& properties = feature->getProperties();
                 if (properties.getType() == VariantType::VARIANT_TYPE_OBJECT) {
+                    // Keys are sorted, so hinted insertion avoids tree searches. Values are views into the shared properties of the feature.
                     std::map<std::string, Variant> metaData;
-                    for (std::string key : properties.getObjectKeys()) {
-                        metaData[key] = properties.getObjectElement(key);
+                    for (const std::string& key : properties.getObjectKeys()) {
+                        metaData.emplace_hint(metaData.end(), key, properties.getObjectElement(key));
                     }
                     element->setMetaData(metaData);
                 }
-                elements.push_back(element);
+                elements.push_back(std::move(element));
             }
         }
         addAll(elements);
@@ -279,35 +312,23 @@ namespace carto {
     }
     
     std::shared_ptr<VectorData> LocalVectorDataSource::loadElements(const std::shared_ptr<CullState>& cullState) {
-        std::lock_guard<std::mutex> lock(_mutex);
-
-        // Check if we need to rebuild the underlying spatial index
         std::shared_ptr<ProjectionSurface> projectionSurface = cullState->getViewState().getProjectionSurface();
-        if (_spatialIndexType == LocalSpatialIndexType::LOCAL_SPATIAL_INDEX_TYPE_KDTREE) {
-            if (projectionSurface != _projectionSurface) {
-                std::vector<std::shared_ptr<VectorElement> > elements = _spatialIndex->getAll();
-                _projectionSurface = projectionSurface;
-                _spatialIndex = std::make_shared<KDTreeSpatialIndex<std::shared_ptr<VectorElement> > >();
-                for (const std::shared_ptr<VectorElement>& element : elements) {
-                    cglib::bbox3<double> bounds = calculateElementBounds(element);
-                    _spatialIndex->insert(bounds, element);
-                }
-            }
-        } else {
-            _projectionSurface = projectionSurface;
+        std::shared_ptr<GeometrySimplifier> geometrySimplifier;
+        std::vector<std::shared_ptr<VectorElement> > elements;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            querySpatialIndex(cullState, elements);
+            geometrySimplifier = _geometrySimplifier;
         }
-
-        // Query the spatial index
-        std::vector<std::shared_ptr<VectorElement> > elements = _spatialIndex->query(cullState->getViewState().getFrustum());
         
-        // If geometry simplifier is specified, create new vector elements with simplified geometry
-        if (_geometrySimplifier) {
+        // If geometry simplifier is specified, create new vector elements with simplified geometry. This is done without holding the lock.
+        if (geometrySimplifier && projectionSurface) {
             float simplifierScale = cullState->getViewState().estimateWorldPixelMeasure();
 
             std::vector<std::shared_ptr<VectorElement> > simplifiedElements;
             simplifiedElements.reserve(elements.size());
             for (const std::shared_ptr<VectorElement>& element : elements) {
-                std::shared_ptr<VectorElement> simplifiedElement = simplifyElement(element, simplifierScale);
+                std::shared_ptr<VectorElement> simplifiedElement = simplifyElement(element, geometrySimplifier, projectionSurface, simplifierScale);
                 if (simplifiedElement) {
                     simplifiedElements.emplace_back(std::move(simplifiedElement));
                 }
@@ -318,12 +339,33 @@ namespace carto {
         return std::make_shared<VectorData>(elements);
     }
 
+    void LocalVectorDataSource::querySpatialIndex(const std::shared_ptr<CullState>& cullState, std::vector<std::shared_ptr<VectorElement> >& elements) {
+        // Check if we need to rebuild the underlying spatial index
+        std::shared_ptr<ProjectionSurface> projectionSurface = cullState->getViewState().getProjectionSurface();
+        if (_spatialIndexType == LocalSpatialIndexType::LOCAL_SPATIAL_INDEX_TYPE_KDTREE || _spatialIndexType == LocalSpatialIndexType::LOCAL_SPATIAL_INDEX_TYPE_PACKED_RTREE) {
+            if (projectionSurface != _projectionSurface) {
+                _projectionSurface = projectionSurface;
+                std::vector<std::pair<cglib::bbox3<double>, std::shared_ptr<VectorElement> > > records = calculateElementRecords(_spatialIndex->getAll(), _projectionSurface);
+                if (_spatialIndexType == LocalSpatialIndexType::LOCAL_SPATIAL_INDEX_TYPE_PACKED_RTREE) {
+                    _spatialIndex = std::make_shared<PackedRTreeSpatialIndex<std::shared_ptr<VectorElement> > >(records);
+                } else {
+                    _spatialIndex = std::make_shared<KDTreeSpatialIndex<std::shared_ptr<VectorElement> > >(records);
+                }
+            }
+        } else {
+            _projectionSurface = projectionSurface;
+        }
+
+        // Query the spatial index
+        elements = _spatialIndex->query(cullState->getViewState().getFrustum());
+    }
+
     void LocalVectorDataSource::notifyElementChanged(const std::shared_ptr<VectorElement>& element) {
         {
             std::lock_guard<std::mutex> lock(_mutex);
             if (!(std::dynamic_pointer_cast<NullSpatialIndex<std::shared_ptr<VectorElement>>>(_spatialIndex))) {
                 _spatialIndex->remove(element);
-                cglib::bbox3<double> bounds = calculateElementBounds(element);
+                cglib::bbox3<double> bounds = calculateElementBounds(element, _projectionSurface);
                 _spatialIndex->insert(bounds, element);
             }
         }
@@ -381,15 +423,11 @@ namespace carto {
         return std::shared_ptr<VectorElement>();
     }
     
-    std::shared_ptr<VectorElement> LocalVectorDataSource::simplifyElement(const std::shared_ptr<VectorElement>& element, float scale) const {
-        if (!_projectionSurface) {
-            return element;
-        }
-
+    std::shared_ptr<VectorElement> LocalVectorDataSource::simplifyElement(const std::shared_ptr<VectorElement>& element, const std::shared_ptr<GeometrySimplifier>& geometrySimplifier, const std::shared_ptr<ProjectionSurface>& projectionSurface, float scale) const {
         std::shared_ptr<VectorElement> simplifiedElement = element;
         if (auto lineElement = std::dynamic_pointer_cast<Line>(element)) {
             auto lineGeometry = std::dynamic_pointer_cast<LineGeometry>(lineElement->getGeometry());
-            lineGeometry = std::dynamic_pointer_cast<LineGeometry>(_geometrySimplifier->simplify(lineGeometry, _projection, _projectionSurface, scale));
+            lineGeometry = std::dynamic_pointer_cast<LineGeometry>(geometrySimplifier->simplify(lineGeometry, _projection, projectionSurface, scale));
             if (lineGeometry) {
                 simplifiedElement = std::make_shared<Line>(lineGeometry, lineElement->getStyle());
             } else {
@@ -397,7 +435,7 @@ namespace carto {
             }
         } else if (auto polygonElement = std::dynamic_pointer_cast<Polygon>(element)) {
             auto polygonGeometry = std::dynamic_pointer_cast<PolygonGeometry>(polygonElement->getGeometry());
-            polygonGeometry = std::dynamic_pointer_cast<PolygonGeometry>(_geometrySimplifier->simplify(polygonGeometry, _projection, _projectionSurface, scale));
+            polygonGeometry = std::dynamic_pointer_cast<PolygonGeometry>(geometrySimplifier->simplify(polygonGeometry, _projection, projectionSurface, scale));
             if (polygonGeometry) {
                 simplifiedElement = std::make_shared<Polygon>(polygonGeometry, polygonElement->getStyle());
             } else {
@@ -405,7 +443,7 @@ namespace carto {
             }
         } else if (auto polygon3DElement = std::dynamic_pointer_cast<Polygon3D>(element)) {
             auto polygonGeometry = std::dynamic_pointer_cast<PolygonGeometry>(polygon3DElement->getGeometry());
-            polygonGeometry = std::dynamic_pointer_cast<PolygonGeometry>(_geometrySimplifier->simplify(polygonGeometry, _projection, _projectionSurface, scale));
+            polygonGeometry = std::dynamic_pointer_cast<PolygonGeometry>(geometrySimplifier->simplify(polygonGeometry, _projection, projectionSurface, scale));
             if (polygonGeometry) {
                 simplifiedElement = std::make_shared<Polygon3D>(polygonGeometry, polygon3DElement->getStyle(), polygon3DElement->getHeight());
             } else {
@@ -413,7 +451,7 @@ namespace carto {
             }
         } else if (auto geomCollectionElement = std::dynamic_pointer_cast<GeometryCollection>(element)) {
             auto multiGeometry = std::dynamic_pointer_cast<MultiGeometry>(geomCollectionElement->getGeometry());
-            multiGeometry = std::dynamic_pointer_cast<MultiGeometry>(_geometrySimplifier->simplify(multiGeometry, _projection, _projectionSurface, scale));
+            multiGeometry = std::dynamic_pointer_cast<MultiGeometry>(geometrySimplifier->simplify(multiGeometry, _projection, projectionSurface, scale));
             if (multiGeometry) {
                 simplifiedElement = std::make_shared<GeometryCollection>(multiGeometry, geomCollectionElement->getStyle());
             } else {
@@ -431,19 +469,28 @@ namespace carto {
         return simplifiedElement;
     }
 
-    cglib::bbox3<double> LocalVectorDataSource::calculateElementBounds(const std::shared_ptr<VectorElement>& element) const {
-        if (!_projectionSurface) {
+    std::vector<std::pair<cglib::bbox3<double>, std::shared_ptr<VectorElement> > > LocalVectorDataSource::calculateElementRecords(const std::vector<std::shared_ptr<VectorElement> >& elements, const std::shared_ptr<ProjectionSurface>& projectionSurface) const {
+        std::vector<std::pair<cglib::bbox3<double>, std::shared_ptr<VectorElement> > > records;
+        records.reserve(elements.size());
+        for (const std::shared_ptr<VectorElement>& element : elements) {
+            records.emplace_back(calculateElementBounds(element, projectionSurface), element);
+        }
+        return records;
+    }
+
+    cglib::bbox3<double> LocalVectorDataSource::calculateElementBounds(const std::shared_ptr<VectorElement>& element, const std::shared_ptr<ProjectionSurface>& projectionSurface) const {
+        if (!projectionSurface) {
             return cglib::bbox3<double>(cglib::vec3<double>(0, 0, 0), cglib::vec3<double>(0, 0, 0));
         }
 
         MapBounds mapBounds = element->getBounds();
         cglib::bbox3<double> bounds = cglib::bbox3<double>::smallest();
         if (mapBounds.getMin() == mapBounds.getMax()) {
-            bounds.add(_projectionSurface->calculatePosition(_projection->toInternal(mapBounds.getMin())));
+            bounds.add(projectionSurface->calculatePosition(_projection->toInternal(mapBounds.getMin())));
         } else {
             MapPos posesInternal[2] = { _projection->toInternal(mapBounds.getMin()), _projection->toInternal(mapBounds.getMax()) };
             for (int i = 0; i < 8; i++) {
-                bounds.add(_projectionSurface->calculatePosition(MapPos(posesInternal[(i >> 2) & 1].getX(), posesInternal[(i >> 1) & 1].getY(), posesInternal[(i >> 0) & 1].getZ())));
+                bounds.add(projectionSurface->calculatePosition(MapPos(posesInternal[(i >> 2) & 1].getX(), posesInternal[(i >> 1) & 1].getY(), posesInternal[(i >> 0) & 1].getZ())));
             }
         }
         return bounds;
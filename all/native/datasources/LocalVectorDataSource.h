@@ -27,7 +27,13 @@ namespace carto {
             /**
              * K-d tree index, element culling is exact and fast.
              */
-            LOCAL_SPATIAL_INDEX_TYPE_KDTREE
+            LOCAL_SPATIAL_INDEX_TYPE_KDTREE,
+
+            /**
+             * Packed R-tree index, element culling is exact and fastest for large, mostly static element sets.
+             * Adding or removing individual elements is slower than with K-d tree index.
+             */
+            LOCAL_SPATIAL_INDEX_TYPE_PACKED_RTREE
         };
     }
 
@@ -137,8 +143,10 @@ namespace carto {
 
     private:
         std::shared_ptr<VectorElement> createElement(const std::shared_ptr<Geometry>& geometry, const std::shared_ptr<Style>& style) const;
-        std::shared_ptr<VectorElement> simplifyElement(const std::shared_ptr<VectorElement>& element, float scale) const;
-        cglib::bbox3<double> calculateElementBounds(const std::shared_ptr<VectorElement>& element) const;
+        void querySpatialIndex(const std::shared_ptr<CullState>& cullState, std::vector<std::shared_ptr<VectorElement> >& elements);
+        std::shared_ptr<VectorElement> simplifyElement(const std::shared_ptr<VectorElement>& element, const std::shared_ptr<GeometrySimplifier>& geometrySimplifier, const std::shared_ptr<ProjectionSurface>& projectionSurface, float scale) const;
+        std::vector<std::pair<cglib::bbox3<double>, std::shared_ptr<VectorElement> > > calculateElementRecords(const std::vector<std::shared_ptr<VectorElement> >& elements, const std::shared_ptr<ProjectionSurface>& projectionSurface) const;
+        cglib::bbox3<double> calculateElementBounds(const std::shared_ptr<VectorElement>& element, const std::shared_ptr<ProjectionSurface>& projectionSurface) const;
 
         std::shared_ptr<GeometrySimplifier> _geometrySimplifier;
         std::shared_ptr<SpatialIndex<std::shared_ptr<VectorElement> > > _spatialIndex;
@@ -8,6 +8,9 @@
 #include "utils/Const.h"
 #include "utils/Log.h"
 
+#include <algorithm>
+#include <map>
+
 #include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string.hpp>
 
@@ -25,6 +28,7 @@ namespace carto {
         if (_db->connect_v2(path.c_str(), SQLITE_OPEN_READONLY) != SQLITE_OK) {
             throw FileException("Failed to open database file", path);
         }
+        EnableMemoryMapping(*_db);
 
         // First try to use metadata table for min/maxzoom values
         bool foundMinZoom = false, foundMaxZoom = false;
@@ -78,6 +82,7 @@ namespace carto {
         if (_db->connect_v2(path.c_str(), SQLITE_OPEN_READONLY) != SQLITE_OK) {
             throw FileException("Failed to open database file", path);
         }
+        EnableMemoryMapping(*_db);
     }
     
     MBTilesTileDataSource::MBTilesTileDataSource(int minZoom, int maxZoom, const std::string& path, MBTilesScheme::MBTilesScheme scheme) :
@@ -90,6 +95,7 @@ namespace carto {
         if (_db->connect_v2(path.c_str(), SQLITE_OPEN_READONLY) != SQLITE_OK) {
             throw FileException("Failed to open database file", path);
         }
+        EnableMemoryMapping(*_db);
     }
         
     MBTilesTileDataSource::~MBTilesTileDataSource() {
@@ -245,6 +251,85 @@ namespace carto {
             return std::shared_ptr<TileData>();
         }
     }
+
+    std::vector<std::shared_ptr<TileData> > MBTilesTileDataSource::loadTiles(const std::vector<MapTile>& mapTiles) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        Log::Infof("MBTilesTileDataSource::loadTiles: Loading %d tiles", static_cast<int>(mapTiles.size()));
+        std::vector<std::shared_ptr<TileData> > tileDatas(mapTiles.size());
+        if (!_db) {
+            Log::Errorf("MBTilesTileDataSource::loadTiles: Failed to load tiles: Couldn't connect to the database");
+            return tileDatas;
+        }
+
+        try {
+            // Query the tiles in chunks, using single query per chunk
+            for (std::size_t offset = 0; offset < mapTiles.size(); offset += MAX_BATCH_TILES) {
+                std::size_t count = std::min(mapTiles.size() - offset, static_cast<std::size_t>(MAX_BATCH_TILES));
+
+                std::string sql = "SELECT zoom_level, tile_column, tile_row, tile_data FROM tiles WHERE ";
+                for (std::size_t i = 0; i < count; i++) {
+                    sql += (i > 0 ? " OR " : "");
+                    sql += "(zoom_level=? AND tile_column=? AND tile_row=?)";
+                }
+
+                std::multimap<long long, std::size_t> tileIndices; // tile ids in database coordinates
+                sqlite3pp::query query(*_db, sql.c_str());
+                for (std::size_t i = 0; i < count; i++) {
+                    const MapTile& mapTile = mapTiles[offset + i];
+                    int y = _scheme == MBTilesScheme::MBTILES_SCHEME_XYZ ? mapTile.getY() : (1 << (mapTile.getZoom())) - 1 - mapTile.getY();
+                    query.bind(static_cast<int>(i * 3 + 1), mapTile.getZoom());
+                    query.bind(static_cast<int>(i * 3 + 2), mapTile.getX());
+                    query.bind(static_cast<int>(i * 3 + 3), y);
+                    tileIndices.emplace(MapTile(mapTile.getX(), y, mapTile.getZoom(), 0).getTileId(), offset + i);
+                }
+
+                for (auto it = query.begin(); it != query.end(); it++) {
+                    int zoom = (*it).get<int>(0);
+                    int x = (*it).get<int>(1);
+                    int y = (*it).get<int>(2);
+                    auto range = tileIndices.equal_range(MapTile(x, y, zoom, 0).getTileId());
+                    if (range.first == range.second) {
+                        continue;
+                    }
+                    std::size_t dataSize = (*it).column_bytes(3);
+                    const unsigned char* dataPtr = static_cast<const unsigned char*>((*it).get<const void*>(3));
+                    auto tileData = std::make_shared<TileData>(std::make_shared<BinaryData>(dataPtr, dataSize));
+                    for (auto indexIt = range.first; indexIt != range.second; indexIt++) {
+                        tileDatas[indexIt->second] = tileData;
+                    }
+                }
+                query.finish();
+            }
+        }
+        catch (const std::exception& ex) {
+            Log::Errorf("MBTilesTileDataSource::loadTiles: Failed to query tile data from the database: %s", ex.what());
+            return std::vector<std::shared_ptr<TileData> >(mapTiles.size());
+        }
+
+        // Redirect missing tiles to parents, as in loadTile
+        for (std::size_t i = 0; i < mapTiles.size(); i++) {
+            if (!tileDatas[i] && mapTiles[i].getZoom() > getMinZoom()) {
+                tileDatas[i] = std::make_shared<TileData>(std::shared_ptr<BinaryData>());
+                tileDatas[i]->setReplaceWithParent(true);
+            }
+        }
+        return tileDatas;
+    }
+
+    bool MBTilesTileDataSource::isBatchLoadingSupported() const {
+        return true;
+    }
+
+    void MBTilesTileDataSource::EnableMemoryMapping(sqlite3pp::database& db) {
+        // Read the database file through memory mapping, this avoids read calls and lets the OS page cache manage the tile data.
+        // If memory mapping is not supported by the platform, sqlite silently ignores this.
+        if (db.execute(("PRAGMA mmap_size=" + boost::lexical_cast<std::string>(MAX_MMAP_SIZE)).c_str()) != SQLITE_OK) {
+            Log::Warn("MBTilesTileDataSource: Failed to enable memory mapping");
+        }
+    }
+
+    const unsigned int MBTilesTileDataSource::MAX_BATCH_TILES = 64;
+    const long long MBTilesTileDataSource::MAX_MMAP_SIZE = 256LL * 1024 * 1024;
     
 }
 
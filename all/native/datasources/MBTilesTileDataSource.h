@@ -83,8 +83,17 @@ namespace carto {
         virtual MapBounds getDataExtent() const;
 
         virtual std::shared_ptr<TileData> loadTile(const MapTile& mapTile);
+
+        virtual std::vector<std::shared_ptr<TileData> > loadTiles(const std::vector<MapTile>& mapTiles);
+
+        virtual bool isBatchLoadingSupported() const;
     
     private:
+        static void EnableMemoryMapping(sqlite3pp::database& db);
+
+        static const unsigned int MAX_BATCH_TILES;
+        static const long long MAX_MMAP_SIZE;
+
         MBTilesScheme::MBTilesScheme _scheme;
         std::unique_ptr<sqlite3pp::database> _db;
         mutable std::unique_ptr<MapBounds> _cachedDataExtent;
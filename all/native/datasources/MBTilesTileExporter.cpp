@@ -0,0 +1,378 @@
+#ifdef _CARTO_OFFLINE_SUPPORT
+
+#include "MBTilesTileExporter.h"
+#include "core/BinaryData.h"
+#include "components/Exceptions.h"
+#include "datasources/TileDataSource.h"
+#include "datasources/TileExportListener.h"
+#include "datasources/components/ConcurrentTileLoader.h"
+#include "datasources/components/TileData.h"
+#include "projections/Projection.h"
+#include "utils/Log.h"
+#include "utils/TileUtils.h"
+
+#ifdef _CARTO_PACKAGEMANAGER_SUPPORT
+#include "packagemanager/PackageTileMask.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <unordered_set>
+
+#include <boost/lexical_cast.hpp>
+
+#include <sqlite3pp.h>
+
+#include <sha.h>
+#include <filters.h>
+#include <hex.h>
+
+namespace carto {
+
+    MBTilesTileExporter::MBTilesTileExporter(const std::shared_ptr<TileDataSource>& dataSource, const std::string& path) :
+        _dataSource(dataSource),
+        _path(path),
+        _metaData(),
+        _maxConcurrency(DEFAULT_MAX_CONCURRENCY),
+        _exportThreadPool(std::make_shared<CancelableThreadPool>()),
+        _mutex()
+    {
+        if (!dataSource) {
+            throw NullArgumentException("Null dataSource");
+        }
+        _exportThreadPool->setPoolSize(1);
+    }
+
+    MBTilesTileExporter::~MBTilesTileExporter() {
+        stopAllExports();
+        _exportThreadPool->deinit();
+    }
+
+    std::shared_ptr<TileDataSource> MBTilesTileExporter::getDataSource() const {
+        return _dataSource.get();
+    }
+
+    const std::string& MBTilesTileExporter::getPath() const {
+        return _path;
+    }
+
+    std::map<std::string, std::string> MBTilesTileExporter::getMetaData() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _metaData;
+    }
+
+    void MBTilesTileExporter::setMetaData(const std::map<std::string, std::string>& metaData) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _metaData = metaData;
+    }
+
+    int MBTilesTileExporter::getMaxConcurrency() const {
+        return _maxConcurrency.load();
+    }
+
+    void MBTilesTileExporter::setMaxConcurrency(int concurrency) {
+        _maxConcurrency.store(std::max(1, concurrency));
+    }
+
+    void MBTilesTileExporter::startExportArea(const MapBounds& mapBounds, int minZoom, int maxZoom, const std::shared_ptr<TileExportListener>& tileExportListener) {
+        std::shared_ptr<Projection> projection = _dataSource->getProjection();
+        minZoom = std::max(minZoom, _dataSource->getMinZoom());
+        maxZoom = std::min(maxZoom, _dataSource->getMaxZoom());
+        TileEnumerator tileEnumerator = [mapBounds, minZoom, maxZoom, projection](const std::function<bool(const MapTile&)>& visitor) -> bool {
+            for (int zoom = minZoom; zoom <= maxZoom; zoom++) {
+                MapTile mapTile1 = TileUtils::CalculateMapTile(mapBounds.getMin(), zoom, projection);
+                MapTile mapTile2 = TileUtils::CalculateMapTile(mapBounds.getMax(), zoom, projection);
+                for (int y = std::min(mapTile1.getY(), mapTile2.getY()); y <= std::max(mapTile1.getY(), mapTile2.getY()); y++) {
+                    for (int x = std::min(mapTile1.getX(), mapTile2.getX()); x <= std::max(mapTile1.getX(), mapTile2.getX()); x++) {
+                        if (!visitor(MapTile(x, y, zoom, 0).getFlipped())) {
+                            return false;
+                        }
+                    }
+                }
+            }
+            return true;
+        };
+
+        auto task = std::make_shared<ExportTask>(_dataSource.get(), _path, getMetaData(), getMaxConcurrency(), tileEnumerator, tileExportListener);
+        _exportThreadPool->execute(task, 0);
+    }
+
+#ifdef _CARTO_PACKAGEMANAGER_SUPPORT
+    void MBTilesTileExporter::startExportTileMask(const std::shared_ptr<PackageTileMask>& tileMask, const std::shared_ptr<TileExportListener>& tileExportListener) {
+        if (!tileMask) {
+            throw NullArgumentException("Null tileMask");
+        }
+
+        // Package tile masks use the same tile coordinates as the data sources, no flipping is needed
+        int minZoom = _dataSource->getMinZoom();
+        int maxZoom = std::min(tileMask->getMaxZoomLevel(), _dataSource->getMaxZoom());
+        TileEnumerator tileEnumerator = [tileMask, minZoom, maxZoom](const std::function<bool(const MapTile&)>& visitor) -> bool {
+            std::function<bool(const MapTile&)> visitTile;
+            visitTile = [&](const MapTile& mapTile) -> bool {
+                if (tileMask->getTileStatus(mapTile) == PackageTileStatus::PACKAGE_TILE_STATUS_MISSING) {
+                    return true;
+                }
+                if (mapTile.getZoom() >= minZoom) {
+                    if (!visitor(mapTile)) {
+                        return false;
+                    }
+                }
+                if (mapTile.getZoom() < maxZoom) {
+                    for (int dy = 0; dy < 2; dy++) {
+                        for (int dx = 0; dx < 2; dx++) {
+                            if (!visitTile(MapTile(mapTile.getX() * 2 + dx, mapTile.getY() * 2 + dy, mapTile.getZoom() + 1, 0))) {
+                                return false;
+                            }
+                        }
+                    }
+                }
+                return true;
+            };
+            return visitTile(MapTile(0, 0, 0, 0));
+        };
+
+        auto task = std::make_shared<ExportTask>(_dataSource.get(), _path, getMetaData(), getMaxConcurrency(), tileEnumerator, tileExportListener);
+        _exportThreadPool->execute(task, 0);
+    }
+#endif
+
+    void MBTilesTileExporter::stopAllExports() {
+        _exportThreadPool->cancelAll();
+    }
+
+    void MBTilesTileExporter::InitializeDatabase(sqlite3pp::database& db) {
+        db.execute("PRAGMA synchronous=NORMAL");
+        db.execute("CREATE TABLE IF NOT EXISTS metadata(name TEXT NOT NULL PRIMARY KEY, value TEXT)");
+        db.execute("CREATE TABLE IF NOT EXISTS map(zoom_level INTEGER NOT NULL, tile_column INTEGER NOT NULL, tile_row INTEGER NOT NULL, tile_id TEXT NOT NULL, PRIMARY KEY(zoom_level, tile_column, tile_row))");
+        db.execute("CREATE TABLE IF NOT EXISTS images(tile_id TEXT NOT NULL PRIMARY KEY, tile_data BLOB)");
+        db.execute("CREATE VIEW IF NOT EXISTS tiles AS SELECT map.zoom_level AS zoom_level, map.tile_column AS tile_column, map.tile_row AS tile_row, images.tile_data AS tile_data FROM map JOIN images ON images.tile_id = map.tile_id");
+    }
+
+    std::string MBTilesTileExporter::CalculateTileId(const BinaryData& data) {
+        CryptoPP::SHA1 hash;
+        unsigned char digest[CryptoPP::SHA1::DIGESTSIZE];
+        hash.CalculateDigest(digest, data.data(), data.size());
+        std::string sha1;
+        CryptoPP::HexEncoder encoder;
+        encoder.Attach(new CryptoPP::StringSink(sha1));
+        encoder.Put(digest, sizeof(digest));
+        encoder.MessageEnd();
+        return sha1;
+    }
+
+    std::string MBTilesTileExporter::DetectTileFormat(const BinaryData& data) {
+        const unsigned char* bytes = data.data();
+        std::size_t size = data.size();
+        if (size >= 4 && std::memcmp(bytes, "\x89PNG", 4) == 0) {
+            return "png";
+        }
+        if (size >= 2 && bytes[0] == 0xff && bytes[1] == 0xd8) {
+            return "jpg";
+        }
+        if (size >= 12 && std::memcmp(bytes, "RIFF", 4) == 0 && std::memcmp(bytes + 8, "WEBP", 4) == 0) {
+            return "webp";
+        }
+        return "pbf";
+    }
+
+    MBTilesTileExporter::ExportTask::ExportTask(const std::shared_ptr<TileDataSource>& dataSource, const std::string& path, const std::map<std::string, std::string>& metaData, int maxConcurrency, const TileEnumerator& tileEnumerator, const std::shared_ptr<TileExportListener>& listener) :
+        _dataSource(dataSource),
+        _path(path),
+        _metaData(metaData),
+        _maxConcurrency(maxConcurrency),
+        _tileEnumerator(tileEnumerator),
+        _exportListener(listener)
+    {
+    }
+
+    void MBTilesTileExporter::ExportTask::run() {
+        std::unique_ptr<sqlite3pp::database> db;
+        try {
+            db.reset(new sqlite3pp::database(_path.c_str()));
+            InitializeDatabase(*db);
+        }
+        catch (const std::exception& ex) {
+            Log::Errorf("MBTilesTileExporter::ExportTask: Failed to open database: %s", ex.what());
+            if (_exportListener) {
+                _exportListener->onExportFailed(ex.what());
+            }
+            return;
+        }
+
+        try {
+            exportTiles(*db);
+        }
+        catch (const std::exception& ex) {
+            Log::Errorf("MBTilesTileExporter::ExportTask: Failed to write tiles: %s", ex.what());
+            if (_exportListener) {
+                _exportListener->onExportFailed(ex.what());
+            }
+        }
+    }
+
+    bool MBTilesTileExporter::ExportTask::exportTiles(sqlite3pp::database& db) {
+        std::uint64_t tileCount = 0;
+        _tileEnumerator([&tileCount](const MapTile& mapTile) {
+            tileCount++;
+            return true;
+        });
+
+        Log::Infof("MBTilesTileExporter::ExportTask: Starting to export %d tiles", static_cast<int>(tileCount));
+
+        if (_exportListener) {
+            _exportListener->onExportStarting(static_cast<int>(tileCount));
+        }
+
+        std::shared_ptr<Projection> projection = _dataSource->getProjection();
+        sqlite3pp::command insertMapCommand(db, "INSERT OR REPLACE INTO map(zoom_level, tile_column, tile_row, tile_id) VALUES(:zoom, :x, :y, :tileId)");
+        sqlite3pp::command insertImageCommand(db, "INSERT OR IGNORE INTO images(tile_id, tile_data) VALUES(:tileId, :data)");
+
+        // Tiles are loaded in chunks with multiple loads in flight, each chunk is written to the database while
+        // the tiles are still in memory. The transaction is committed once enough tiles have been written, so that
+        // the journal is not synced for every tile. Identical tiles (like empty ocean tiles) are stored only once.
+        std::unordered_set<std::string> writtenTileIds;
+        std::unique_ptr<sqlite3pp::transaction> xct;
+        unsigned int batchTileCount = 0;
+        std::uint64_t tileIndex = 0;
+        std::uint64_t writtenTileCount = 0;
+        int minZoom = -1;
+        int maxZoom = -1;
+        MapBounds bounds;
+        std::string format;
+        std::vector<MapTile> chunkTiles;
+        auto startTime = std::chrono::steady_clock::now();
+        auto calculateThroughput = [&]() -> float {
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+            return static_cast<float>(tileIndex * 1000.0 / std::max(1LL, static_cast<long long>(duration)));
+        };
+        auto writeChunk = [&]() -> bool {
+            std::vector<std::shared_ptr<TileData> > tileDatas;
+            if (_dataSource->isBatchLoadingSupported()) {
+                tileDatas = _dataSource->loadTiles(chunkTiles);
+            } else {
+                tileDatas = ConcurrentTileLoader::LoadTiles(chunkTiles, [this](const MapTile& mapTile) -> std::shared_ptr<TileData> {
+                    if (isCanceled()) {
+                        return std::shared_ptr<TileData>();
+                    }
+                    return _dataSource->loadTile(mapTile);
+                }, _maxConcurrency);
+            }
+            if (isCanceled()) {
+                return false;
+            }
+
+            if (!xct) {
+                xct.reset(new sqlite3pp::transaction(db));
+            }
+            for (std::size_t i = 0; i < chunkTiles.size(); i++) {
+                const MapTile& mapTile = chunkTiles[i];
+                std::shared_ptr<TileData> tileData = (i < tileDatas.size() ? tileDatas[i] : std::shared_ptr<TileData>());
+                std::shared_ptr<BinaryData> data = (tileData && !tileData->isReplaceWithParent() ? tileData->getData() : std::shared_ptr<BinaryData>());
+                if (!data || data->empty()) {
+                    if (_exportListener) {
+                        _exportListener->onExportTileSkipped(mapTile);
+                    }
+                    continue;
+                }
+
+                std::string tileId = CalculateTileId(*data);
+                if (writtenTileIds.insert(tileId).second) {
+                    insertImageCommand.reset();
+                    insertImageCommand.bind(":tileId", tileId.c_str());
+                    insertImageCommand.bind(":data", data->data(), static_cast<unsigned int>(data->size()));
+                    insertImageCommand.execute();
+                }
+                insertMapCommand.reset();
+                insertMapCommand.bind(":zoom", mapTile.getZoom());
+                insertMapCommand.bind(":x", mapTile.getX());
+                insertMapCommand.bind(":y", (1 << mapTile.getZoom()) - 1 - mapTile.getY());
+                insertMapCommand.bind(":tileId", tileId.c_str());
+                insertMapCommand.execute();
+
+                minZoom = (minZoom < 0 ? mapTile.getZoom() : std::min(minZoom, mapTile.getZoom()));
+                maxZoom = std::max(maxZoom, mapTile.getZoom());
+                bounds.expandToContain(TileUtils::CalculateMapTileBounds(mapTile.getFlipped(), projection));
+                if (format.empty()) {
+                    format = DetectTileFormat(*data);
+                }
+                writtenTileCount++;
+                batchTileCount++;
+            }
+            if (batchTileCount >= WRITE_BATCH_SIZE) {
+                xct->commit();
+                xct.reset();
+                batchTileCount = 0;
+            }
+
+            tileIndex += chunkTiles.size();
+            if (_exportListener) {
+                _exportListener->onExportProgress(static_cast<float>(100.0 * tileIndex / tileCount), calculateThroughput());
+            }
+
+            chunkTiles.clear();
+            return true;
+        };
+
+        bool completed = _tileEnumerator([&](const MapTile& mapTile) {
+            chunkTiles.push_back(mapTile);
+            if (chunkTiles.size() >= static_cast<std::size_t>(_maxConcurrency) * EXPORT_CHUNK_TILES_PER_LOAD) {
+                return writeChunk();
+            }
+            return true;
+        });
+        if (completed && !chunkTiles.empty()) {
+            completed = writeChunk();
+        }
+
+        // Tiles written before cancelation are kept, the calculated metadata describes the tiles written by this export
+        if (!xct) {
+            xct.reset(new sqlite3pp::transaction(db));
+        }
+        std::map<std::string, std::string> metaData;
+        if (writtenTileCount > 0) {
+            MapPos wgsMin = projection->toWgs84(bounds.getMin());
+            MapPos wgsMax = projection->toWgs84(bounds.getMax());
+            std::stringstream ss;
+            ss << wgsMin.getX() << "," << wgsMin.getY() << "," << wgsMax.getX() << "," << wgsMax.getY();
+            metaData["bounds"] = ss.str();
+            metaData["minzoom"] = boost::lexical_cast<std::string>(minZoom);
+            metaData["maxzoom"] = boost::lexical_cast<std::string>(maxZoom);
+            metaData["format"] = format;
+        }
+        for (auto it = _metaData.begin(); it != _metaData.end(); it++) {
+            metaData[it->first] = it->second;
+        }
+        sqlite3pp::command insertMetaDataCommand(db, "INSERT OR REPLACE INTO metadata(name, value) VALUES(:name, :value)");
+        for (auto it = metaData.begin(); it != metaData.end(); it++) {
+            insertMetaDataCommand.reset();
+            insertMetaDataCommand.bind(":name", it->first.c_str());
+            insertMetaDataCommand.bind(":value", it->second.c_str());
+            insertMetaDataCommand.execute();
+        }
+        xct->commit();
+        xct.reset();
+
+        if (!completed) {
+            Log::Info("MBTilesTileExporter::ExportTask: Export canceled");
+            return false;
+        }
+
+        if (_exportListener) {
+            _exportListener->onExportProgress(100.0f, calculateThroughput());
+            _exportListener->onExportCompleted(static_cast<int>(writtenTileCount), static_cast<int>(writtenTileIds.size()));
+        }
+
+        Log::Infof("MBTilesTileExporter::ExportTask: Finished exporting %d tiles, %d unique", static_cast<int>(writtenTileCount), static_cast<int>(writtenTileIds.size()));
+        return true;
+    }
+
+    const int MBTilesTileExporter::DEFAULT_MAX_CONCURRENCY = 8;
+    const unsigned int MBTilesTileExporter::EXPORT_CHUNK_TILES_PER_LOAD = 4;
+    const unsigned int MBTilesTileExporter::WRITE_BATCH_SIZE = 256;
+
+}
+
+#endif
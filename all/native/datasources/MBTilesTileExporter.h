@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_MBTILESTILEEXPORTER_H_
+#define _CARTO_MBTILESTILEEXPORTER_H_
+
+#ifdef _CARTO_OFFLINE_SUPPORT
+
+#include "core/MapBounds.h"
+#include "core/MapTile.h"
+#include "components/CancelableThreadPool.h"
+#include "components/DirectorPtr.h"
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace sqlite3pp {
+    class database;
+}
+
+namespace carto {
+    class BinaryData;
+    class TileDataSource;
+    class TileExportListener;
+#ifdef _CARTO_PACKAGEMANAGER_SUPPORT
+    class PackageTileMask;
+#endif
+
+    /**
+     * An exporter that copies tiles from any tile data source into a MBTiles database.
+     * Tiles are loaded with multiple requests in flight and written in batched transactions.
+     * Identical tiles are stored only once, the database uses the deduplicated MBTiles layout
+     * with "map" and "images" tables and a "tiles" view. The resulting file can be opened using MBTilesTileDataSource.
+     * Exports are run in a background thread, one export at a time.
+     */
+    class MBTilesTileExporter {
+    public:
+        /**
+         * Constructs a MBTilesTileExporter object.
+         * If the output file already exists, it must be a database created by this class. Existing tiles are kept or replaced.
+         * @param dataSource The data source to load the tiles from.
+         * @param path The path to the output Sqlite database file.
+         */
+        MBTilesTileExporter(const std::shared_ptr<TileDataSource>& dataSource, const std::string& path);
+        virtual ~MBTilesTileExporter();
+
+        /**
+         * Returns the data source the tiles are loaded from.
+         * @return The data source the tiles are loaded from.
+         */
+        std::shared_ptr<TileDataSource> getDataSource() const;
+        /**
+         * Returns the path of the output database file.
+         * @return The path of the output database file.
+         */
+        const std::string& getPath() const;
+
+        /**
+         * Returns the metadata values written to the "metadata" table.
+         * @return The metadata values.
+         */
+        std::map<std::string, std::string> getMetaData() const;
+        /**
+         * Sets the metadata values written to the "metadata" table.
+         * The "format", "minzoom", "maxzoom" and "bounds" values are calculated from the exported tiles unless specified here.
+         * The change affects only exports started after this call.
+         * @param metaData The metadata values.
+         */
+        void setMetaData(const std::map<std::string, std::string>& metaData);
+
+        /**
+         * Returns the maximum number of concurrent tile loads.
+         * @return The maximum number of concurrent tile loads.
+         */
+        int getMaxConcurrency() const;
+        /**
+         * Sets the maximum number of concurrent tile loads. The default is 8.
+         * @param concurrency The maximum number of concurrent tile loads. Must be at least 1.
+         */
+        void setMaxConcurrency(int concurrency);
+
+        /**
+         * Starts exporting the specified area.
+         * @param mapBounds The bounds of the area to export. The coordinate system of the bounds must be the same as specified in the data source projection.
+         * @param minZoom The minimum zoom of the tiles to export.
+         * @param maxZoom The maximum zoom of the tiles to export.
+         * @param tileExportListener The tile export listener to use that will receive export related callbacks. Can be null.
+         */
+        void startExportArea(const MapBounds& mapBounds, int minZoom, int maxZoom, const std::shared_ptr<TileExportListener>& tileExportListener);
+#ifdef _CARTO_PACKAGEMANAGER_SUPPORT
+        /**
+         * Starts exporting the tiles covered by the specified tile mask.
+         * Tiles from zoom level 0 up to the maximum zoom level of the tile mask are exported.
+         * @param tileMask The tile mask specifying the tiles to export.
+         * @param tileExportListener The tile export listener to use that will receive export related callbacks. Can be null.
+         */
+        void startExportTileMask(const std::shared_ptr<PackageTileMask>& tileMask, const std::shared_ptr<TileExportListener>& tileExportListener);
+#endif
+        /**
+         * Stops all background export processes. Tiles already written are kept in the database.
+         */
+        void stopAllExports();
+
+    protected:
+        // Calls the visitor for each tile to export, in data source coordinates. Returns false if the visitor stopped the enumeration.
+        typedef std::function<bool(const std::function<bool(const MapTile&)>&)> TileEnumerator;
+
+        class ExportTask : public CancelableTask {
+        public:
+            ExportTask(const std::shared_ptr<TileDataSource>& dataSource, const std::string& path, const std::map<std::string, std::string>& metaData, int maxConcurrency, const TileEnumerator& tileEnumerator, const std::shared_ptr<TileExportListener>& listener);
+
+            virtual void run();
+
+        private:
+            bool exportTiles(sqlite3pp::database& db);
+
+            DirectorPtr<TileDataSource> _dataSource;
+            std::string _path;
+            std::map<std::string, std::string> _metaData;
+            int _maxConcurrency;
+            TileEnumerator _tileEnumerator;
+            DirectorPtr<TileExportListener> _exportListener;
+        };
+
+        static void InitializeDatabase(sqlite3pp::database& db);
+        static std::string CalculateTileId(const BinaryData& data);
+        static std::string DetectTileFormat(const BinaryData& data);
+
+        static const int DEFAULT_MAX_CONCURRENCY;
+        static const unsigned int EXPORT_CHUNK_TILES_PER_LOAD;
+        static const unsigned int WRITE_BATCH_SIZE;
+
+        const DirectorPtr<TileDataSource> _dataSource;
+        const std::string _path;
+        std::map<std::string, std::string> _metaData;
+        std::atomic<int> _maxConcurrency;
+        std::shared_ptr<CancelableThreadPool> _exportThreadPool;
+        mutable std::mutex _mutex;
+    };
+
+}
+
+#endif
+
+#endif
@@ -5,6 +5,7 @@
 #include "utils/GeneralUtils.h"
 #include "utils/NetworkUtils.h"
 #include "utils/PlatformUtils.h"
+#include "utils/JSONUtils.h"
 
 #include <picojson/picojson.h>
 
@@ -14,6 +15,7 @@ namespace carto {
         TileDataSource(),
         _key(key),
         _httpClient(Log::IsShowDebug()),
+        _tileLoadCoalescer(),
         _serviceURL(),
         _tmsScheme(false),
         _tileURLs(),
@@ -50,9 +52,11 @@ namespace carto {
         std::size_t randomIndex = std::uniform_int_distribution<std::size_t>(0, _tileURLs.size() - 1)(_randomGenerator);
         std::string tileURL = _tileURLs[randomIndex];
 
-        // Fetch online tile, allow parallel tile fetching
+        // Fetch online tile, allow parallel tile fetching. Concurrent requests for the same tile share a single download.
         lock.unlock();
-        std::shared_ptr<TileData> tileData = loadOnlineTile(tileURL, mapTile);
+        std::shared_ptr<TileData> tileData = _tileLoadCoalescer.load(mapTile.getTileId(), [&]() {
+            return loadOnlineTile(tileURL, mapTile);
+        });
         lock.lock();
 
         return tileData;
@@ -77,7 +81,7 @@ namespace carto {
         }
 
         picojson::value config;
-        std::string err = picojson::parse(config, responseString);
+        std::string err = JSONUtils::ParsePicoJSON(config, responseString);
         if (!err.empty()) {
             Log::Errorf("MapTilerOnlineTileDataSource: Failed to parse tile source configuration: %s", err.c_str());
             return false;
@@ -8,6 +8,7 @@
 #define _CARTO_MAPTILERONLINETILEDATASOURCE_H_
 
 #include "datasources/TileDataSource.h"
+#include "datasources/components/TileLoadCoalescer.h"
 #include "network/HTTPClient.h"
 
 #include <random>
@@ -58,6 +59,7 @@ namespace carto {
 
         const std::string _key;
         HTTPClient _httpClient;
+        TileLoadCoalescer _tileLoadCoalescer;
         std::string _serviceURL;
 
         bool _tmsScheme;
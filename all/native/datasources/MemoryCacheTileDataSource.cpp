@@ -3,6 +3,7 @@
 #include "core/MapTile.h"
 #include "utils/Log.h"
 
+#include <chrono>
 #include <memory>
 
 namespace carto {
@@ -10,29 +11,35 @@ namespace carto {
     MemoryCacheTileDataSource::MemoryCacheTileDataSource(const std::shared_ptr<TileDataSource>& dataSource) :
         CacheTileDataSource(dataSource),
         _cache(DEFAULT_CAPACITY),
-        _mutex()
+        _memoryConsumer()
     {
+        _memoryConsumer = MemoryGovernor::GetInstance().registerConsumer(DEFAULT_CAPACITY, 1.0f,
+            [this](std::size_t budget) { _cache.resize(budget); },
+            [this](bool critical) { if (critical) { _cache.clear(); } }
+        );
     }
     
     MemoryCacheTileDataSource::~MemoryCacheTileDataSource() {
+        _memoryConsumer->detach();
     }
     
     std::shared_ptr<TileData> MemoryCacheTileDataSource::loadTile(const MapTile& mapTile) {
-        std::unique_lock<std::recursive_mutex> lock(_mutex);
-        
         Log::Infof("MemoryCacheTileDataSource::loadTile: Loading %s", mapTile.toString().c_str());
         
         std::shared_ptr<TileData> tileData;
         if (_cache.read(mapTile.getTileId(), tileData)) {
             if (tileData->getMaxAge() != 0) {
+                tileData->setCacheSource("MemoryCacheTileDataSource");
+                _cacheStatistics.recordHit();
                 return tileData;
             }
             _cache.remove(mapTile.getTileId());
         }
+        _cacheStatistics.recordMiss();
         
-        lock.unlock();
+        std::chrono::steady_clock::time_point loadStartTime = std::chrono::steady_clock::now();
         tileData = _dataSource->loadTile(mapTile);
-        lock.lock();
+        _cacheStatistics.recordLoadTime(std::chrono::steady_clock::now() - loadStartTime);
 
         if (tileData) {
             if (tileData->getMaxAge() != 0 && tileData->getData() && !tileData->isReplaceWithParent()) {
@@ -45,19 +52,76 @@ namespace carto {
         return tileData;
     }
     
+    std::vector<std::shared_ptr<TileData> > MemoryCacheTileDataSource::loadTiles(const std::vector<MapTile>& mapTiles) {
+        Log::Infof("MemoryCacheTileDataSource::loadTiles: Loading %d tiles", static_cast<int>(mapTiles.size()));
+
+        std::vector<std::shared_ptr<TileData> > tileDatas(mapTiles.size());
+        std::vector<MapTile> missingTiles;
+        std::vector<std::size_t> missingIndices;
+        for (std::size_t i = 0; i < mapTiles.size(); i++) {
+            std::shared_ptr<TileData> tileData;
+            if (_cache.read(mapTiles[i].getTileId(), tileData)) {
+                if (tileData->getMaxAge() != 0) {
+                    tileData->setCacheSource("MemoryCacheTileDataSource");
+                    tileDatas[i] = tileData;
+                    _cacheStatistics.recordHit();
+                    continue;
+                }
+                _cache.remove(mapTiles[i].getTileId());
+            }
+            _cacheStatistics.recordMiss();
+            missingTiles.push_back(mapTiles[i]);
+            missingIndices.push_back(i);
+        }
+
+        if (missingTiles.empty()) {
+            return tileDatas;
+        }
+
+        std::chrono::steady_clock::time_point loadStartTime = std::chrono::steady_clock::now();
+        std::vector<std::shared_ptr<TileData> > loadedTileDatas = _dataSource->loadTiles(missingTiles);
+        _cacheStatistics.recordLoadTime(std::chrono::steady_clock::now() - loadStartTime, missingTiles.size());
+        for (std::size_t i = 0; i < missingTiles.size() && i < loadedTileDatas.size(); i++) {
+            const std::shared_ptr<TileData>& tileData = loadedTileDatas[i];
+            if (tileData) {
+                if (tileData->getMaxAge() != 0 && tileData->getData() && !tileData->isReplaceWithParent()) {
+                    _cache.put(missingTiles[i].getTileId(), tileData, tileData->getData()->size() + 16);
+                }
+            } else {
+                Log::Infof("MemoryCacheTileDataSource::loadTiles: Failed to load %s.", missingTiles[i].toString().c_str());
+            }
+            tileDatas[missingIndices[i]] = tileData;
+        }
+
+        return tileDatas;
+    }
+
+    bool MemoryCacheTileDataSource::isBatchLoadingSupported() const {
+        return _dataSource->isBatchLoadingSupported();
+    }
+    
     void MemoryCacheTileDataSource::clear() {
-        std::lock_guard<std::recursive_mutex> lock(_mutex);
         _cache.clear();
     }
+
+    void MemoryCacheTileDataSource::removeCachedTiles(const MapBounds& bounds, int minZoom, int maxZoom) {
+        for (long long tileId : _cache.keys()) {
+            if (isTileInArea(MapTile::FromTileId(tileId), bounds, minZoom, maxZoom)) {
+                _cache.remove(tileId);
+            }
+        }
+    }
     
     std::size_t MemoryCacheTileDataSource::getCapacity() const {
-        std::lock_guard<std::recursive_mutex> lock(_mutex);
-        return _cache.capacity();
+        return _memoryConsumer->getCapacity();
     }
     
     void MemoryCacheTileDataSource::setCapacity(std::size_t capacityInBytes) {
-        std::lock_guard<std::recursive_mutex> lock(_mutex);
-        _cache.resize(capacityInBytes);
+        _memoryConsumer->setCapacity(capacityInBytes);
+    }
+
+    CacheStatistics MemoryCacheTileDataSource::getCacheStatistics() const {
+        return _cacheStatistics.getStatistics(_cache.size(), _memoryConsumer->getCapacity(), _cache.count(), static_cast<long long>(_cache.eviction_count()));
     }
 
     const unsigned int MemoryCacheTileDataSource::DEFAULT_CAPACITY = 6 * 1024 * 1024;
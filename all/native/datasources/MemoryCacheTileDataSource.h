@@ -7,10 +7,10 @@
 #ifndef _CARTO_MEMORYCACHETILEDATASOURCE_H_
 #define _CARTO_MEMORYCACHETILEDATASOURCE_H_
 
+#include "components/MemoryGovernor.h"
+#include "components/ShardedTileCache.h"
 #include "datasources/CacheTileDataSource.h"
 
-#include <stdext/timed_lru_cache.h>
-
 namespace carto {
 
     /**
@@ -28,18 +28,26 @@ namespace carto {
         virtual ~MemoryCacheTileDataSource();
     
         virtual std::shared_ptr<TileData> loadTile(const MapTile& mapTile);
+
+        virtual std::vector<std::shared_ptr<TileData> > loadTiles(const std::vector<MapTile>& mapTiles);
+
+        virtual bool isBatchLoadingSupported() const;
                 
         virtual void clear();
 
         virtual std::size_t getCapacity() const;
         
         virtual void setCapacity(std::size_t capacityInBytes);
+
+        virtual CacheStatistics getCacheStatistics() const;
     
     protected:
+        virtual void removeCachedTiles(const MapBounds& bounds, int minZoom, int maxZoom);
+
         static const unsigned int DEFAULT_CAPACITY;
 
-        cache::timed_lru_cache<long long, std::shared_ptr<TileData> > _cache;
-        mutable std::recursive_mutex _mutex;
+        ShardedTileCache<std::shared_ptr<TileData> > _cache;
+        std::shared_ptr<MemoryGovernor::Consumer> _memoryConsumer;
     };
     
 }
@@ -2,12 +2,11 @@
 #include "core/BinaryData.h"
 #include "core/MapTile.h"
 #include "components/Exceptions.h"
+#include "components/InflatePool.h"
 #include "utils/Log.h"
 
 #include <algorithm>
 
-#include <stdext/zlib.h>
-
 namespace carto {
     
     MergedMBVTTileDataSource::MergedMBVTTileDataSource(const std::shared_ptr<TileDataSource>& dataSource1, const std::shared_ptr<TileDataSource>& dataSource2) :
@@ -75,16 +74,11 @@ namespace carto {
             std::vector<unsigned char> mergedData;
             mergedData.reserve(data1->size() + data2->size());
 
-            std::vector<unsigned char> uncompressedData1;
-            if (zlib::inflate_gzip(data1->data(), data1->size(), uncompressedData1)) {
-                mergedData.insert(mergedData.end(), uncompressedData1.begin(), uncompressedData1.end());
-            } else {
+            // Decompressed data is appended directly to the merged data, failed decompression leaves merged data unchanged
+            if (!InflatePool::GetInstance().inflateGzip(data1->data(), data1->size(), mergedData)) {
                 mergedData.insert(mergedData.end(), data1->begin(), data1->end());
             }
-            std::vector<unsigned char> uncompressedData2;
-            if (zlib::inflate_gzip(data2->data(), data2->size(), uncompressedData2)) {
-                mergedData.insert(mergedData.end(), uncompressedData2.begin(), uncompressedData2.end());
-            } else {
+            if (!InflatePool::GetInstance().inflateGzip(data2->data(), data2->size(), mergedData)) {
                 mergedData.insert(mergedData.end(), data2->begin(), data2->end());
             }
 
@@ -104,5 +98,9 @@ namespace carto {
     void MergedMBVTTileDataSource::DataSourceListener::onTilesChanged(bool removeTiles) {
         _combinedDataSource.notifyTilesChanged(removeTiles);
     }
+
+    void MergedMBVTTileDataSource::DataSourceListener::onTilesChanged(const MapBounds& bounds, int minZoom, int maxZoom, bool removeTiles) {
+        _combinedDataSource.notifyTilesChanged(bounds, minZoom, maxZoom, removeTiles);
+    }
     
 }
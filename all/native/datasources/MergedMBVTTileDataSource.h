@@ -39,6 +39,7 @@ namespace carto {
             explicit DataSourceListener(MergedMBVTTileDataSource& combinedDataSource);
             
             virtual void onTilesChanged(bool removeTiles);
+            virtual void onTilesChanged(const MapBounds& bounds, int minZoom, int maxZoom, bool removeTiles);
             
         private:
             MergedMBVTTileDataSource& _combinedDataSource;
@@ -25,6 +25,26 @@ namespace carto {
     std::shared_ptr<Projection> NMLModelLODTreeDataSource::getProjection() const {
         return _projection;
     }
+
+    std::map<long long, std::shared_ptr<nml::Mesh> > NMLModelLODTreeDataSource::loadMeshes(const std::vector<long long>& meshIds) {
+        std::map<long long, std::shared_ptr<nml::Mesh> > meshMap;
+        for (long long meshId : meshIds) {
+            if (std::shared_ptr<nml::Mesh> mesh = loadMesh(meshId)) {
+                meshMap[meshId] = mesh;
+            }
+        }
+        return meshMap;
+    }
+
+    std::map<long long, std::shared_ptr<nml::Texture> > NMLModelLODTreeDataSource::loadTextures(const std::vector<std::pair<long long, int> >& textureIds) {
+        std::map<long long, std::shared_ptr<nml::Texture> > textureMap;
+        for (const std::pair<long long, int>& textureId : textureIds) {
+            if (std::shared_ptr<nml::Texture> texture = loadTexture(textureId.first, textureId.second)) {
+                textureMap[textureId.first] = texture;
+            }
+        }
+        return textureMap;
+    }
     
 }
 
@@ -12,8 +12,11 @@
 #include "core/MapBounds.h"
 #include "datasources/components/NMLModelLODTree.h"
 
+#include <map>
 #include <memory>
 #include <mutex>
+#include <utility>
+#include <vector>
 
 namespace carto {
     class CullState;
@@ -79,6 +82,22 @@ namespace carto {
          * @return The texture corresponding to the id/level or null pointer if texture could not be loaded.
          */
         virtual std::shared_ptr<nml::Texture> loadTexture(long long textureId, int level) = 0;
+
+        /**
+         * Loads multiple LOD tree meshes given their ids.
+         * The default implementation loads the meshes one by one, data sources can override this to use a single request.
+         * @param meshIds The ids of the meshes to be loaded.
+         * @return The map of loaded meshes keyed by mesh ids. Meshes that could not be loaded are missing from the map.
+         */
+        virtual std::map<long long, std::shared_ptr<nml::Mesh> > loadMeshes(const std::vector<long long>& meshIds);
+
+        /**
+         * Loads multiple LOD tree textures given their ids and mip levels.
+         * The default implementation loads the textures one by one, data sources can override this to use a single request.
+         * @param textureIds The list of texture id and mip level pairs to be loaded.
+         * @return The map of loaded textures keyed by texture ids. Textures that could not be loaded are missing from the map.
+         */
+        virtual std::map<long long, std::shared_ptr<nml::Texture> > loadTextures(const std::vector<std::pair<long long, int> >& textureIds);
     
     protected:
         explicit NMLModelLODTreeDataSource(const std::shared_ptr<Projection>& projection);
@@ -102,6 +102,8 @@ namespace carto {
         _geometrySimplifier(),
         _localElementId(-1),
         _localElements(),
+        _elementCacheZoom(-1),
+        _elementCache(ELEMENT_CACHE_SIZE),
         _dataBase(std::make_shared<OGRVectorDataBase>(fileName, false)),
         _poLayer(),
         _poLayerSpatialRef()
@@ -126,6 +128,8 @@ namespace carto {
         _geometrySimplifier(),
         _localElementId(-1),
         _localElements(),
+        _elementCacheZoom(-1),
+        _elementCache(ELEMENT_CACHE_SIZE),
         _dataBase(dataBase),
         _poLayer(),
         _poLayerSpatialRef()
@@ -158,6 +162,7 @@ namespace carto {
         {
             std::lock_guard<std::mutex> lock(_dataBase->_mutex);
             _codePage = codePage;
+            _elementCache.clear();
         }
         notifyElementsChanged();
     }
@@ -171,6 +176,7 @@ namespace carto {
         {
             std::lock_guard<std::mutex> lock(_dataBase->_mutex);
             _geometrySimplifier = simplifier;
+            _elementCache.clear();
         }
         notifyElementsChanged();
     }
@@ -336,6 +342,8 @@ namespace carto {
                 it = _localElements.erase(--it);
             }
             
+            _elementCache.clear();
+
             OGRErr err = _poLayer->SyncToDisk();
             if (err != OGRERR_NONE) {
                 Log::Errorf("OGRVectorDataSource::commit: SyncToDisk failed, error code: %d", (int)err);
@@ -359,6 +367,7 @@ namespace carto {
                 rolledbackElements.push_back(element);
             }
             _localElements.clear();
+            _elementCache.clear();
         }
         notifyElementsChanged();
         return rolledbackElements;
@@ -427,6 +436,7 @@ namespace carto {
             Log::Errorf("OGRVectorDataSource::createField: Error while creating field %s, error code %d", name.c_str(), (int)err);
             return false;
         }
+        _elementCache.clear();
         return true;
     }
 
@@ -446,6 +456,7 @@ namespace carto {
             Log::Errorf("OGRVectorDataSource::deleteField: Error while deleting field %d, error code %d", index, (int)err);
             return false;
         }
+        _elementCache.clear();
         return true;
     }
 
@@ -454,6 +465,29 @@ namespace carto {
         return _poLayer->TestCapability(capability.c_str()) != 0;
     }
 
+    bool OGRVectorDataSource::createSpatialIndex() {
+        std::lock_guard<std::mutex> lock(_dataBase->_mutex);
+
+        if (!_poLayer) {
+            return false;
+        }
+
+        if (_poLayer->TestCapability(OLCFastSpatialFilter)) {
+            return true;
+        }
+
+        std::string sql = std::string("CREATE SPATIAL INDEX ON \"") + _poLayer->GetName() + "\"";
+        if (OGRLayer* poResultLayer = _dataBase->_poDS->ExecuteSQL(sql.c_str(), nullptr, nullptr)) {
+            _dataBase->_poDS->ReleaseResultSet(poResultLayer);
+        }
+
+        if (!_poLayer->TestCapability(OLCFastSpatialFilter)) {
+            Log::Warnf("OGRVectorDataSource::createSpatialIndex: Failed to create spatial index for layer %s", _poLayer->GetName());
+            return false;
+        }
+        return true;
+    }
+
     void OGRVectorDataSource::SetConfigOption(const std::string& name, const std::string& value) {
         CPLSetConfigOption(name.c_str(), value.c_str());
     }
@@ -492,6 +526,12 @@ namespace carto {
 
         float simplifierScale = cullState->getViewState().estimateWorldPixelMeasure();
 
+        // Styles and simplification depend on the zoom level, so cached elements can be reused only while panning
+        if (cullState->getViewState().getZoom() != _elementCacheZoom) {
+            _elementCache.clear();
+            _elementCacheZoom = cullState->getViewState().getZoom();
+        }
+
         MapBounds bounds;
         for (const MapPos& mapPos : cullState->getProjectionEnvelope(_projection).getConvexHull()) {
             bounds.expandToContain(_poLayerSpatialRef->inverseTransform(mapPos.getX(), mapPos.getY(), mapPos.getZ()));
@@ -509,6 +549,12 @@ namespace carto {
                 continue;
             }
 
+            std::shared_ptr<VectorElement> cachedElement;
+            if (_elementCache.read(poFeature->GetFID(), cachedElement)) {
+                elements.push_back(cachedElement);
+                continue;
+            }
+
             OGRGeometry* poGeometry = poFeature->GetGeometryRef();
             if (!poGeometry) {
                 continue;
@@ -559,6 +605,7 @@ namespace carto {
                     vectorElement->setId(poFeature->GetFID());
                     vectorElement->setMetaData(metaData);
                     attachElement(vectorElement);
+                    _elementCache.put(poFeature->GetFID(), vectorElement, 1);
                     elements.push_back(std::move(vectorElement));
                 }
             }
@@ -602,7 +649,7 @@ namespace carto {
                 for (int i = 0; i < poLineString->getNumPoints(); i++) {
                     mapPoses[i] = _poLayerSpatialRef->transform(poLineString->getX(i), poLineString->getY(i), poLineString->getZ(i));
                 }
-                geometry = std::make_shared<LineGeometry>(mapPoses);
+                geometry = std::make_shared<LineGeometry>(std::move(mapPoses));
             }
             break;
         case wkbPolygon:
@@ -621,7 +668,7 @@ namespace carto {
                         interiorMapPoses[n][i] = _poLayerSpatialRef->transform(poLineString->getX(i), poLineString->getY(i),   poLineString->getZ(i));
                     }
                 }
-                geometry = std::make_shared<PolygonGeometry>(mapPoses, interiorMapPoses);
+                geometry = std::make_shared<PolygonGeometry>(std::move(mapPoses), std::move(interiorMapPoses));
             }
             break;
         case wkbGeometryCollection:
@@ -634,7 +681,7 @@ namespace carto {
                         geoms.push_back(geom);
                     }
                 }
-                geometry = std::make_shared<MultiGeometry>(geoms);
+                geometry = std::make_shared<MultiGeometry>(std::move(geoms));
             }
             break;
         case wkbMultiPoint:
@@ -828,6 +875,8 @@ namespace carto {
         return poFeature;
     }
 
+    const std::size_t OGRVectorDataSource::ELEMENT_CACHE_SIZE = 16384;
+
 }
 
 #endif
@@ -16,6 +16,8 @@
 #include <map>
 #include <vector>
 
+#include <stdext/timed_lru_cache.h>
+
 class OGRGeometry;
 class OGRFeature;
 class OGRLayer;
@@ -184,6 +186,13 @@ namespace carto {
          */
         bool testCapability(const std::string& capability) const;
 
+        /**
+         * Creates a spatial index for the layer if the layer does not support fast spatial filtering.
+         * Only some drivers support this, for example shapefile driver creates .qix index file next to the data file.
+         * @return True when the layer has a spatial index after the call, false otherwise.
+         */
+        bool createSpatialIndex();
+
         /**
          * Sets global OGR configuration option. This method can be used to redefine default locale, for example.
          * @param name The name of the option parameter to set ("SHAPE_ENCODING", for example)
@@ -215,6 +224,8 @@ namespace carto {
 
         std::shared_ptr<OGRFeature> createOGRFeature(const std::shared_ptr<VectorElement>& element) const;
 
+        static const std::size_t ELEMENT_CACHE_SIZE;
+
         std::string _codePage;
         std::shared_ptr<StyleSelector> _styleSelector;
         std::shared_ptr<GeometrySimplifier> _geometrySimplifier;
@@ -222,6 +233,9 @@ namespace carto {
         long long _localElementId;
         std::map<long long, std::shared_ptr<VectorElement> > _localElements;
 
+        float _elementCacheZoom;
+        cache::timed_lru_cache<long long, std::shared_ptr<VectorElement> > _elementCache; // elements created for the current zoom level, keyed by feature id
+
         std::shared_ptr<OGRVectorDataBase> _dataBase;
         OGRLayer* _poLayer;
         std::shared_ptr<LayerSpatialReference> _poLayerSpatialRef;
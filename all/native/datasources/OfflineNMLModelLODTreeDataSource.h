@@ -11,6 +11,11 @@
 
 #include "datasources/NMLModelLODTreeDataSource.h"
 
+#include <condition_variable>
+#include <memory>
+#include <string>
+#include <vector>
+
 namespace sqlite3pp {
     class database;
 }
@@ -20,6 +25,8 @@ namespace carto {
     /**
      * A sqlite database based data source for NML model LOD trees. The database must be created using
      * custom toolkit from Carto that supports several input formats like KMZ or GeoJSON.
+     * The data source uses a small pool of read-only database connections, so multiple
+     * LOD trees, meshes and textures can be read and decoded concurrently.
      */
     class OfflineNMLModelLODTreeDataSource : public NMLModelLODTreeDataSource {
     public:
@@ -38,10 +45,33 @@ namespace carto {
         virtual std::shared_ptr<nml::Texture> loadTexture(long long textureId, int level);
 
     private:
+        class DatabaseConnection {
+        public:
+            explicit DatabaseConnection(const OfflineNMLModelLODTreeDataSource& dataSource);
+            ~DatabaseConnection();
+
+            sqlite3pp::database* get() const { return _db.get(); }
+
+        private:
+            const OfflineNMLModelLODTreeDataSource& _dataSource;
+            std::unique_ptr<sqlite3pp::database> _db;
+        };
+
+        std::unique_ptr<sqlite3pp::database> acquireDatabase() const;
+        void releaseDatabase(std::unique_ptr<sqlite3pp::database> db) const;
+
+        static std::unique_ptr<sqlite3pp::database> OpenDatabase(const std::string& path);
+
         static const float MIN_HEIGHT;
         static const float MAX_HEIGHT;
 
-        std::unique_ptr<sqlite3pp::database> _db;
+        static const int MAX_DATABASE_CONNECTIONS;
+        static const long long MAX_MMAP_SIZE;
+
+        std::string _path;
+        mutable std::vector<std::unique_ptr<sqlite3pp::database> > _dbPool;
+        mutable int _dbCount;
+        mutable std::condition_variable _dbCondition;
     };
 
 }
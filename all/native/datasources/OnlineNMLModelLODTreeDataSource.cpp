@@ -165,71 +165,111 @@ namespace carto {
     }
     
     std::shared_ptr<nml::Mesh> OnlineNMLModelLODTreeDataSource::loadMesh(long long meshId) {
-        std::map<std::string, std::string> urlParams;
-        urlParams["q"] = "Meshes";
-        urlParams["ids"] = boost::lexical_cast<std::string>(meshId);
-        std::string url = NetworkUtils::BuildURLFromParameters(_serviceURL, urlParams);
+        std::map<long long, std::shared_ptr<nml::Mesh> > meshMap = loadMeshes(std::vector<long long> { meshId });
+        auto it = meshMap.find(meshId);
+        if (it == meshMap.end()) {
+            return std::shared_ptr<nml::Mesh>();
+        }
+        return it->second;
+    }
     
-        Log::Debugf("OnlineNMLModelLODTreeDataSource: Request %s", url.c_str());
-        std::shared_ptr<BinaryData> response;
-        if (!NetworkUtils::GetHTTP(url, response, Log::IsShowDebug())) {
+    std::shared_ptr<nml::Texture> OnlineNMLModelLODTreeDataSource::loadTexture(long long textureId, int level) {
+        std::map<long long, std::shared_ptr<nml::Texture> > textureMap = loadTextures(std::vector<std::pair<long long, int> > { std::make_pair(textureId, level) });
+        auto it = textureMap.find(textureId);
+        if (it == textureMap.end()) {
+            return std::shared_ptr<nml::Texture>();
+        }
+        return it->second;
+    }
+
+    std::map<long long, std::shared_ptr<nml::Mesh> > OnlineNMLModelLODTreeDataSource::loadMeshes(const std::vector<long long>& meshIds) {
+        std::map<long long, std::shared_ptr<nml::Mesh> > meshMap;
+        std::map<long long, std::vector<unsigned char> > dataMap;
+        if (!loadPackedData("Meshes", meshIds, dataMap)) {
             Log::Error("OnlineNMLModelLODTreeDataSource: Failed to receive mesh data.");
-            return std::shared_ptr<nml::Mesh>();
+            return meshMap;
         }
-        if (!response) {
-            Log::Error("OnlineNMLModelLODTreeDataSource: Empty response.");
-            return std::shared_ptr<nml::Mesh>();
+
+        for (auto it = dataMap.begin(); it != dataMap.end(); it++) {
+            const std::vector<unsigned char>& data = it->second;
+            meshMap[it->first] = std::make_shared<nml::Mesh>(protobuf::message(data.size() > 0 ? &data[0] : nullptr, data.size()));
         }
-    
-        DataInputStream gzipStream(*response->getDataPtr());
-        gzipStream.readLongLong();
-        int gzipDataSize = gzipStream.readInt();
-        std::vector<unsigned char> gzipData = gzipStream.readBytes(gzipDataSize);
-        std::vector<unsigned char> data;
-        if (!zlib::inflate_gzip(gzipData.data(), gzipData.size(), data)) {
-            Log::Error("OnlineNMLModelLODTreeDataSource: Failed to decompress mesh data.");
-            return std::shared_ptr<nml::Mesh>();
+        return meshMap;
+    }
+
+    std::map<long long, std::shared_ptr<nml::Texture> > OnlineNMLModelLODTreeDataSource::loadTextures(const std::vector<std::pair<long long, int> >& textureIds) {
+        std::vector<long long> ids;
+        for (auto it = textureIds.begin(); it != textureIds.end(); it++) {
+            ids.push_back(it->first);
         }
-    
-        std::shared_ptr<nml::Mesh> mesh = std::make_shared<nml::Mesh>(protobuf::message(data.size() > 0 ? &data[0] : nullptr, data.size()));
-        return mesh;
+
+        std::map<long long, std::shared_ptr<nml::Texture> > textureMap;
+        std::map<long long, std::vector<unsigned char> > dataMap;
+        if (!loadPackedData("Textures", ids, dataMap)) {
+            Log::Error("OnlineNMLModelLODTreeDataSource: Failed to receive texture data.");
+            return textureMap;
+        }
+
+        for (auto it = dataMap.begin(); it != dataMap.end(); it++) {
+            const std::vector<unsigned char>& data = it->second;
+            textureMap[it->first] = std::make_shared<nml::Texture>(protobuf::message(data.size() > 0 ? &data[0] : nullptr, data.size()));
+        }
+        return textureMap;
     }
-    
-    std::shared_ptr<nml::Texture> OnlineNMLModelLODTreeDataSource::loadTexture(long long textureId, int level) {
+
+    bool OnlineNMLModelLODTreeDataSource::loadPackedData(const std::string& query, const std::vector<long long>& ids, std::map<long long, std::vector<unsigned char> >& dataMap) const {
+        if (ids.empty()) {
+            return true;
+        }
+
+        // All ids are requested at once, the response contains a list of (id, gzipped data) records
+        std::string idsParam;
+        for (auto it = ids.begin(); it != ids.end(); it++) {
+            idsParam += (idsParam.empty() ? "" : ",") + boost::lexical_cast<std::string>(*it);
+        }
+
         std::map<std::string, std::string> urlParams;
-        urlParams["q"] = "Textures";
-        urlParams["ids"] = boost::lexical_cast<std::string>(textureId);
+        urlParams["q"] = query;
+        urlParams["ids"] = idsParam;
         std::string url = NetworkUtils::BuildURLFromParameters(_serviceURL, urlParams);
     
         Log::Debugf("OnlineNMLModelLODTreeDataSource: Request %s", url.c_str());
         std::shared_ptr<BinaryData> response;
         if (!NetworkUtils::GetHTTP(url, response, Log::IsShowDebug())) {
-            Log::Error("OnlineNMLModelLODTreeDataSource: Failed to receive texture data.");
-            return std::shared_ptr<nml::Texture>();
+            return false;
         }
         if (!response) {
             Log::Error("OnlineNMLModelLODTreeDataSource: Empty response.");
-            return std::shared_ptr<nml::Texture>();
+            return false;
         }
     
         DataInputStream gzipStream(*response->getDataPtr());
-        gzipStream.readLongLong();
-        int gzipDataSize = gzipStream.readInt();
-        std::vector<unsigned char> gzipData = gzipStream.readBytes(gzipDataSize);
-        std::vector<unsigned char> data;
-        if (!zlib::inflate_gzip(gzipData.data(), gzipData.size(), data)) {
-            Log::Error("OnlineNMLModelLODTreeDataSource: Failed to decompress texture data.");
-            return std::shared_ptr<nml::Texture>();
+        while (!gzipStream.eof()) {
+            long long id = gzipStream.readLongLong();
+            int gzipDataSize = gzipStream.readInt();
+            std::vector<unsigned char> gzipData = gzipStream.readBytes(gzipDataSize >= 0 ? gzipDataSize : 0);
+            if (gzipDataSize <= 0 || gzipData.size() != static_cast<std::size_t>(gzipDataSize)) {
+                Log::Error("OnlineNMLModelLODTreeDataSource: Truncated or invalid response.");
+                break;
+            }
+            std::vector<unsigned char> data;
+            if (!zlib::inflate_gzip(gzipData.data(), gzipData.size(), data)) {
+                Log::Errorf("OnlineNMLModelLODTreeDataSource: Failed to decompress data for id %lld.", id);
+                continue;
+            }
+            dataMap[id] = std::move(data);
         }
-    
-        std::shared_ptr<nml::Texture> texture = std::make_shared<nml::Texture>(protobuf::message(data.size() > 0 ? &data[0] : nullptr, data.size()));
-        return texture;
+        return true;
     }
     
     OnlineNMLModelLODTreeDataSource::DataInputStream::DataInputStream(const std::vector<unsigned char>& data) : _data(data), _offset(0)
     {
     }
     
+    bool OnlineNMLModelLODTreeDataSource::DataInputStream::eof() const {
+        return _offset >= _data.size();
+    }
+
     unsigned char OnlineNMLModelLODTreeDataSource::DataInputStream::readByte() {
         if (_offset >= _data.size()) {
             Log::Error("OnlineNMLModelLODTreeDataSource::DataInputStream: reading past the end");
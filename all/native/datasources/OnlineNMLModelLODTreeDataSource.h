@@ -30,11 +30,15 @@ namespace carto {
         virtual std::shared_ptr<NMLModelLODTree> loadModelLODTree(const MapTile& mapTile);
         virtual std::shared_ptr<nml::Mesh> loadMesh(long long meshId);
         virtual std::shared_ptr<nml::Texture> loadTexture(long long textureId, int level);
+        virtual std::map<long long, std::shared_ptr<nml::Mesh> > loadMeshes(const std::vector<long long>& meshIds);
+        virtual std::map<long long, std::shared_ptr<nml::Texture> > loadTextures(const std::vector<std::pair<long long, int> >& textureIds);
     
     private:
         class DataInputStream {
         public:
             DataInputStream(const std::vector<unsigned char>& data);
+
+            bool eof() const;
     
             unsigned char readByte();
             int readInt();
@@ -49,6 +53,8 @@ namespace carto {
             std::size_t _offset;
         };
     
+        bool loadPackedData(const std::string& query, const std::vector<long long>& ids, std::map<long long, std::vector<unsigned char> >& dataMap) const;
+
         std::string _serviceURL;
     };
     
@@ -1,17 +1,38 @@
 #include "OrderedTileDataSource.h"
 #include "core/MapTile.h"
+#include "components/CancelableThreadPool.h"
 #include "components/Exceptions.h"
 #include "utils/Log.h"
 
 #include <memory>
 #include <algorithm>
+#include <condition_variable>
+#include <vector>
 
 namespace carto {
+
+    struct OrderedTileDataSource::HedgedRequest {
+        explicit HedgedRequest(const std::shared_ptr<std::atomic<int> >& requestCount) : requestCount(requestCount) { }
+        ~HedgedRequest() { (*requestCount)--; } // released only after both load tasks have finished or have been dropped by the pool
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::shared_ptr<TileData> results[2];
+        bool completed[2] = { false, false };
+        std::shared_ptr<std::atomic<int> > requestCount;
+    };
     
     OrderedTileDataSource::OrderedTileDataSource(const std::shared_ptr<TileDataSource>& dataSource1, const std::shared_ptr<TileDataSource>& dataSource2) :
         TileDataSource(),
         _dataSource1(dataSource1),
-        _dataSource2(dataSource2)
+        _dataSource2(dataSource2),
+        _dataSourceListener(),
+        _hedgingEnabled(false),
+        _hedgingLatencyPercentile(DEFAULT_HEDGING_LATENCY_PERCENTILE),
+        _latencyTracker1(std::make_shared<LatencyTracker>()),
+        _latencyTracker2(std::make_shared<LatencyTracker>()),
+        _hedgedRequestCount(std::make_shared<std::atomic<int> >(0)),
+        _hedgingThreadPool(std::make_shared<CancelableThreadPool>())
     {
         if (!dataSource1) {
             throw NullArgumentException("Null dataSource1");
@@ -20,12 +41,15 @@ namespace carto {
             throw NullArgumentException("Null dataSource2");
         }
 
+        _hedgingThreadPool->setPoolSize(MAX_HEDGED_REQUESTS * 2); // each hedged request has 2 load tasks, so tasks never wait for a worker
+
         _dataSourceListener = std::make_shared<DataSourceListener>(*this);
         _dataSource1->registerOnChangeListener(_dataSourceListener);
         _dataSource2->registerOnChangeListener(_dataSourceListener);
     }
     
     OrderedTileDataSource::~OrderedTileDataSource() {
+        _hedgingThreadPool->deinit();
         _dataSource2->unregisterOnChangeListener(_dataSourceListener);
         _dataSource1->unregisterOnChangeListener(_dataSourceListener);
         _dataSourceListener.reset();
@@ -46,6 +70,20 @@ namespace carto {
     }
     
     std::shared_ptr<TileData> OrderedTileDataSource::loadTile(const MapTile& mapTile) {
+        int zoom = mapTile.getZoom();
+        if (_hedgingEnabled) {
+            if (zoom >= _dataSource1->getMinZoom() && zoom <= _dataSource1->getMaxZoom() && zoom >= _dataSource2->getMinZoom() && zoom <= _dataSource2->getMaxZoom()) {
+                // Do not hedge if too many hedged requests are in flight, including abandoned load tasks that are still running
+                if ((*_hedgedRequestCount)++ < MAX_HEDGED_REQUESTS) {
+                    return loadTileHedged(mapTile);
+                }
+                (*_hedgedRequestCount)--;
+            }
+        }
+        return loadTileOrdered(mapTile);
+    }
+
+    std::shared_ptr<TileData> OrderedTileDataSource::loadTileOrdered(const MapTile& mapTile) {
         std::shared_ptr<TileData> result1, result2;
         int zoom = mapTile.getZoom();
         if (zoom >= _dataSource1->getMinZoom()) {
@@ -73,6 +111,156 @@ namespace carto {
         return result1 ? result1 : result2;
     }
 
+    bool OrderedTileDataSource::isHedgingEnabled() const {
+        return _hedgingEnabled;
+    }
+
+    void OrderedTileDataSource::setHedgingEnabled(bool enabled) {
+        _hedgingEnabled = enabled;
+    }
+
+    float OrderedTileDataSource::getHedgingLatencyPercentile() const {
+        return _hedgingLatencyPercentile;
+    }
+
+    void OrderedTileDataSource::setHedgingLatencyPercentile(float percentile) {
+        _hedgingLatencyPercentile = std::max(0.0f, std::min(1.0f, percentile));
+    }
+
+    std::shared_ptr<TileData> OrderedTileDataSource::loadTileHedged(const MapTile& mapTile) {
+        // Visible tiles are loaded from both data sources in parallel. For preloading tiles use the recent latency percentile
+        // of the first data source as the hedging delay, or the default delay until enough samples exist.
+        const CancelableTask* currentTask = CancelableTask::GetCurrentTask();
+        std::chrono::steady_clock::duration hedgingDelay = std::chrono::steady_clock::duration::zero();
+        float percentile = _hedgingLatencyPercentile;
+        if (percentile > 0 && currentTask && currentTask->isSpeculative()) {
+            hedgingDelay = std::chrono::milliseconds(DEFAULT_HEDGING_DELAY);
+            _latencyTracker1->getPercentile(percentile, hedgingDelay);
+        }
+
+        // The request keeps the in-flight count until both tasks are released
+        auto request = std::make_shared<HedgedRequest>(_hedgedRequestCount);
+        std::shared_ptr<HedgedLoadTask> tasks[2] = {
+            std::make_shared<HedgedLoadTask>(request, 0, _dataSource1, _latencyTracker1, mapTile, std::chrono::steady_clock::duration::zero()),
+            std::make_shared<HedgedLoadTask>(request, 1, _dataSource2, _latencyTracker2, mapTile, hedgingDelay)
+        };
+        _hedgingThreadPool->execute(tasks[0]);
+        _hedgingThreadPool->execute(tasks[1]);
+
+        // Wait for the first valid result, or for both tasks to fail. Stop waiting if the calling task is canceled.
+        std::shared_ptr<TileData> result;
+        {
+            std::unique_lock<std::mutex> lock(request->mutex);
+            while (true) {
+                if (request->completed[0] && IsValidResult(request->results[0])) {
+                    result = request->results[0];
+                    break;
+                }
+                if (request->completed[1] && IsValidResult(request->results[1])) {
+                    result = request->results[1];
+                    break;
+                }
+                if (request->completed[0] && request->completed[1]) {
+                    result = request->results[0] ? request->results[0] : request->results[1];
+                    break;
+                }
+                if (currentTask && currentTask->isCanceled()) {
+                    break;
+                }
+                request->condition.wait_for(lock, std::chrono::milliseconds(CANCEL_CHECK_INTERVAL));
+            }
+        }
+
+        // Cancel the other task, its worker is released once its data source returns
+        tasks[0]->cancel();
+        tasks[1]->cancel();
+        return result;
+    }
+
+    bool OrderedTileDataSource::IsValidResult(const std::shared_ptr<TileData>& result) {
+        return result && !result->isReplaceWithParent();
+    }
+
+    OrderedTileDataSource::HedgedLoadTask::HedgedLoadTask(const std::shared_ptr<HedgedRequest>& request, int index, const DirectorPtr<TileDataSource>& dataSource, const std::shared_ptr<LatencyTracker>& latencyTracker, const MapTile& mapTile, const std::chrono::steady_clock::duration& delay) :
+        CancelableTask(),
+        _request(request),
+        _index(index),
+        _dataSource(dataSource),
+        _latencyTracker(latencyTracker),
+        _mapTile(mapTile),
+        _startTime(std::chrono::steady_clock::now() + delay)
+    {
+    }
+
+    void OrderedTileDataSource::HedgedLoadTask::cancel() {
+        CancelableTask::cancel();
+
+        // Wake up the task if it is waiting for the hedging delay
+        std::lock_guard<std::mutex> lock(_request->mutex);
+        _request->condition.notify_all();
+    }
+
+    void OrderedTileDataSource::HedgedLoadTask::run() {
+        // Wait for the hedging delay, start immediately if the other data source fails
+        bool load = false;
+        {
+            std::unique_lock<std::mutex> lock(_request->mutex);
+            int other = 1 - _index;
+            _request->condition.wait_until(lock, _startTime, [this, other]() { return _request->completed[other] || isCanceled(); });
+            load = !isCanceled() && !(_request->completed[other] && IsValidResult(_request->results[other]));
+        }
+
+        std::shared_ptr<TileData> result;
+        if (load) {
+            std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+            try {
+                result = _dataSource->loadTile(_mapTile);
+            }
+            catch (const std::exception& ex) {
+                Log::Errorf("OrderedTileDataSource: Exception while loading tile: %s", ex.what());
+            }
+            if (!isCanceled()) {
+                _latencyTracker->record(std::chrono::steady_clock::now() - startTime);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_request->mutex);
+            _request->results[_index] = result;
+            _request->completed[_index] = true;
+        }
+        _request->condition.notify_all();
+    }
+
+    OrderedTileDataSource::LatencyTracker::LatencyTracker() :
+        _latencies(),
+        _mutex()
+    {
+    }
+
+    void OrderedTileDataSource::LatencyTracker::record(const std::chrono::steady_clock::duration& latency) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _latencies.push_back(latency);
+        while (_latencies.size() > static_cast<std::size_t>(MAX_LATENCY_SAMPLES)) {
+            _latencies.pop_front();
+        }
+    }
+
+    bool OrderedTileDataSource::LatencyTracker::getPercentile(float percentile, std::chrono::steady_clock::duration& latency) const {
+        std::vector<std::chrono::steady_clock::duration> latencies;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_latencies.size() < static_cast<std::size_t>(MIN_LATENCY_SAMPLES)) {
+                return false;
+            }
+            latencies.assign(_latencies.begin(), _latencies.end());
+        }
+        std::size_t index = std::min(latencies.size() - 1, static_cast<std::size_t>(percentile * latencies.size()));
+        std::nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+        latency = latencies[index];
+        return true;
+    }
+
     OrderedTileDataSource::DataSourceListener::DataSourceListener(OrderedTileDataSource& combinedDataSource) :
         _combinedDataSource(combinedDataSource)
     {
@@ -81,5 +269,16 @@ namespace carto {
     void OrderedTileDataSource::DataSourceListener::onTilesChanged(bool removeTiles) {
         _combinedDataSource.notifyTilesChanged(removeTiles);
     }
+
+    void OrderedTileDataSource::DataSourceListener::onTilesChanged(const MapBounds& bounds, int minZoom, int maxZoom, bool removeTiles) {
+        _combinedDataSource.notifyTilesChanged(bounds, minZoom, maxZoom, removeTiles);
+    }
+    
+    const int OrderedTileDataSource::MAX_LATENCY_SAMPLES = 64;
+    const int OrderedTileDataSource::MIN_LATENCY_SAMPLES = 8;
+    const int OrderedTileDataSource::DEFAULT_HEDGING_DELAY = 250;
+    const float OrderedTileDataSource::DEFAULT_HEDGING_LATENCY_PERCENTILE = 0.95f;
+    const int OrderedTileDataSource::MAX_HEDGED_REQUESTS = 4;
+    const int OrderedTileDataSource::CANCEL_CHECK_INTERVAL = 100;
     
 }
@@ -8,13 +8,23 @@
 #define _CARTO_ORDEREDTILEDATASOURCE_H_
 
 #include "datasources/TileDataSource.h"
+#include "components/CancelableTask.h"
 #include "components/DirectorPtr.h"
 
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+
 namespace carto {
+    class CancelableThreadPool;
     
     /**
      * A tile data source that combines two data sources (usually offline and online).
      * All requests are made first to first data source. If not found the request will be made to the second data source.
+     * Optionally requests can be hedged: both data sources are queried in parallel (the second one after a latency based delay
+     * for preloading tiles), the first valid response is used and the other request is canceled.
      */
     class OrderedTileDataSource : public TileDataSource {
     public:
@@ -32,6 +42,32 @@ namespace carto {
         virtual MapBounds getDataExtent() const;
         
         virtual std::shared_ptr<TileData> loadTile(const MapTile& tile);
+
+        /**
+         * Returns true if hedged requests are enabled. Hedging is disabled by default.
+         * @return True if hedged requests are enabled.
+         */
+        bool isHedgingEnabled() const;
+        /**
+         * Enables or disables hedged requests. When enabled, both data sources are queried in background threads.
+         * For visible tiles the requests are started in parallel, for preloading tiles the second data source is queried only if the first data source
+         * has not responded within the hedging latency percentile of its recent requests. The first valid tile is used and the other request is canceled,
+         * if both fail the result of the first data source is preferred.
+         * The number of concurrent hedged requests is limited, requests exceeding the limit are not hedged.
+         * @param enabled True if hedged requests should be enabled.
+         */
+        void setHedgingEnabled(bool enabled);
+        /**
+         * Returns the latency percentile of the first data source used as the hedging delay.
+         * @return The latency percentile in range 0..1. The default is 0.95.
+         */
+        float getHedgingLatencyPercentile() const;
+        /**
+         * Sets the latency percentile of the first data source used as the hedging delay.
+         * Percentile 0 means that both data sources are always queried in parallel.
+         * @param percentile The latency percentile in range 0..1.
+         */
+        void setHedgingLatencyPercentile(float percentile);
         
     protected:
         class DataSourceListener : public TileDataSource::OnChangeListener {
@@ -39,6 +75,7 @@ namespace carto {
             explicit DataSourceListener(OrderedTileDataSource& combinedDataSource);
             
             virtual void onTilesChanged(bool removeTiles);
+            virtual void onTilesChanged(const MapBounds& bounds, int minZoom, int maxZoom, bool removeTiles);
             
         private:
             OrderedTileDataSource& _combinedDataSource;
@@ -48,7 +85,56 @@ namespace carto {
         const DirectorPtr<TileDataSource> _dataSource2;
         
     private:
+        class LatencyTracker {
+        public:
+            LatencyTracker();
+
+            void record(const std::chrono::steady_clock::duration& latency);
+            bool getPercentile(float percentile, std::chrono::steady_clock::duration& latency) const;
+
+        private:
+            std::deque<std::chrono::steady_clock::duration> _latencies;
+            mutable std::mutex _mutex;
+        };
+
+        struct HedgedRequest;
+
+        class HedgedLoadTask : public CancelableTask {
+        public:
+            HedgedLoadTask(const std::shared_ptr<HedgedRequest>& request, int index, const DirectorPtr<TileDataSource>& dataSource, const std::shared_ptr<LatencyTracker>& latencyTracker, const MapTile& mapTile, const std::chrono::steady_clock::duration& delay);
+
+            virtual void cancel();
+            virtual void run();
+
+        private:
+            std::shared_ptr<HedgedRequest> _request;
+            int _index;
+            DirectorPtr<TileDataSource> _dataSource;
+            std::shared_ptr<LatencyTracker> _latencyTracker;
+            MapTile _mapTile;
+            std::chrono::steady_clock::time_point _startTime;
+        };
+
+        std::shared_ptr<TileData> loadTileOrdered(const MapTile& mapTile);
+        std::shared_ptr<TileData> loadTileHedged(const MapTile& mapTile);
+
+        static bool IsValidResult(const std::shared_ptr<TileData>& result);
+
+        static const int MAX_LATENCY_SAMPLES;
+        static const int MIN_LATENCY_SAMPLES;
+        static const int DEFAULT_HEDGING_DELAY;
+        static const float DEFAULT_HEDGING_LATENCY_PERCENTILE;
+        static const int MAX_HEDGED_REQUESTS;
+        static const int CANCEL_CHECK_INTERVAL;
+
         std::shared_ptr<DataSourceListener> _dataSourceListener;
+
+        std::atomic<bool> _hedgingEnabled;
+        std::atomic<float> _hedgingLatencyPercentile;
+        std::shared_ptr<LatencyTracker> _latencyTracker1;
+        std::shared_ptr<LatencyTracker> _latencyTracker2;
+        std::shared_ptr<std::atomic<int> > _hedgedRequestCount; // requests with unfinished load tasks, shared with the tasks
+        std::shared_ptr<CancelableThreadPool> _hedgingThreadPool;
     };
     
 }
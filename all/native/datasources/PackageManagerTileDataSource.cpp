@@ -7,6 +7,7 @@
 #include "utils/Log.h"
 #include "utils/Const.h"
 
+#include <algorithm>
 #include <memory>
 
 namespace carto {
@@ -39,51 +40,18 @@ namespace carto {
         try {
             MapTile mapTileFlipped = mapTile.getFlipped();
 
+            // Resolve the packages using the tile mask index of the local package snapshot, no locking is needed here
             std::shared_ptr<BinaryData> data;
-            _packageManager->accessLocalPackages([this, mapTileFlipped, &data](const std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> >& packageHandlerMap) {
-                std::lock_guard<std::mutex> lock(_mutex);
-
-                // Fast path: try already open packages
-                for (auto it = _cachedOpenPackageHandlers.begin(); it != _cachedOpenPackageHandlers.end(); it++) {
-                    const std::shared_ptr<PackageInfo>& packageInfo = it->first;
-                    std::shared_ptr<PackageTileMask> tileMask = packageInfo->getTileMask();
-                    if (tileMask) {
-                        if (tileMask->getTileStatus(mapTileFlipped) == PackageTileStatus::PACKAGE_TILE_STATUS_MISSING) {
-                            continue;
-                        }
-                    }
-
-                    data = it->second->loadTile(mapTileFlipped);
-                    if (data || tileMask) {
-                        std::rotate(_cachedOpenPackageHandlers.begin(), it, it + 1);
-                        return;
-                    }
-                }
-
-                // Slow path: try other packages
-                for (auto it = packageHandlerMap.begin(); it != packageHandlerMap.end(); it++) {
-                    if (auto mapHandler = std::dynamic_pointer_cast<MapPackageHandler>(it->second)) {
-                        const std::shared_ptr<PackageInfo>& packageInfo = it->first;
-                        std::shared_ptr<PackageTileMask> tileMask = packageInfo->getTileMask();
-                        if (tileMask) {
-                            if (tileMask->getTileStatus(mapTileFlipped) == PackageTileStatus::PACKAGE_TILE_STATUS_MISSING) {
-                                continue;
-                            }
-                        }
-
-                        mapHandler->openDatabase();
-                        data = mapHandler->loadTile(mapTileFlipped);
-                        if (data || tileMask) {
-                            _cachedOpenPackageHandlers.insert(_cachedOpenPackageHandlers.begin(), std::make_pair(packageInfo, mapHandler));
-                            if (_cachedOpenPackageHandlers.size() > MAX_OPEN_PACKAGES) {
-                                _cachedOpenPackageHandlers.back().second->closeDatabase();
-                                _cachedOpenPackageHandlers.pop_back();
-                            }
-                            return;
-                        }
+            std::shared_ptr<const PackageManager::LocalPackageSnapshot> snapshot = _packageManager->getLocalPackageSnapshot();
+            for (const std::pair<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> >& packageHandler : snapshot->findTilePackageHandlers(mapTileFlipped)) {
+                if (auto mapHandler = std::dynamic_pointer_cast<MapPackageHandler>(packageHandler.second)) {
+                    data = mapHandler->loadTile(mapTileFlipped);
+                    if (data || packageHandler.first->getTileMask()) {
+                        updateOpenPackageHandler(packageHandler.first, mapHandler);
+                        break;
                     }
                 }
-            });
+            }
 
             std::shared_ptr<TileData> tileData = std::make_shared<TileData>(data);
             if (!data) {
@@ -102,6 +70,107 @@ namespace carto {
         }
         return std::shared_ptr<TileData>();
     }
+
+    std::vector<std::shared_ptr<TileData> > PackageManagerTileDataSource::loadTiles(const std::vector<MapTile>& mapTiles) {
+        Log::Infof("PackageManagerTileDataSource::loadTiles: Loading %d tiles", static_cast<int>(mapTiles.size()));
+        std::vector<std::shared_ptr<BinaryData> > datas(mapTiles.size());
+        try {
+            std::vector<MapTile> mapTilesFlipped;
+            std::vector<std::vector<std::pair<std::shared_ptr<PackageInfo>, std::shared_ptr<MapPackageHandler> > > > tilePackageHandlers;
+            std::shared_ptr<const PackageManager::LocalPackageSnapshot> snapshot = _packageManager->getLocalPackageSnapshot();
+            for (const MapTile& mapTile : mapTiles) {
+                mapTilesFlipped.push_back(mapTile.getFlipped());
+                tilePackageHandlers.emplace_back();
+                for (const std::pair<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> >& packageHandler : snapshot->findTilePackageHandlers(mapTilesFlipped.back())) {
+                    if (auto mapHandler = std::dynamic_pointer_cast<MapPackageHandler>(packageHandler.second)) {
+                        tilePackageHandlers.back().emplace_back(packageHandler.first, mapHandler);
+                    }
+                }
+            }
+
+            // Each round tries the next candidate package of all unresolved tiles, each package is queried once per round for all its tiles
+            std::vector<std::size_t> candidateIndices(mapTiles.size(), 0);
+            std::vector<std::size_t> remainingIndices;
+            for (std::size_t i = 0; i < mapTiles.size(); i++) {
+                remainingIndices.push_back(i);
+            }
+            while (!remainingIndices.empty()) {
+                std::map<std::shared_ptr<PackageInfo>, std::vector<std::size_t> > packageTileIndices;
+                for (std::size_t index : remainingIndices) {
+                    if (candidateIndices[index] < tilePackageHandlers[index].size()) {
+                        packageTileIndices[tilePackageHandlers[index][candidateIndices[index]].first].push_back(index);
+                    }
+                }
+
+                remainingIndices.clear();
+                for (auto it = packageTileIndices.begin(); it != packageTileIndices.end(); it++) {
+                    const std::shared_ptr<PackageInfo>& packageInfo = it->first;
+                    const std::vector<std::size_t>& indices = it->second;
+                    std::shared_ptr<MapPackageHandler> mapHandler = tilePackageHandlers[indices.front()][candidateIndices[indices.front()]].second;
+
+                    std::vector<MapTile> packageTiles;
+                    for (std::size_t index : indices) {
+                        packageTiles.push_back(mapTilesFlipped[index]);
+                    }
+                    std::vector<std::shared_ptr<BinaryData> > packageDatas = mapHandler->loadTiles(packageTiles);
+
+                    bool resolved = false;
+                    for (std::size_t i = 0; i < indices.size(); i++) {
+                        datas[indices[i]] = packageDatas[i];
+                        if (packageDatas[i] || packageInfo->getTileMask()) {
+                            resolved = true;
+                        } else {
+                            candidateIndices[indices[i]]++;
+                            remainingIndices.push_back(indices[i]);
+                        }
+                    }
+                    if (resolved) {
+                        updateOpenPackageHandler(packageInfo, mapHandler);
+                    }
+                }
+            }
+        }
+        catch (const std::exception& ex) {
+            Log::Errorf("PackageManagerTileDataSource::loadTiles: Exception: %s", ex.what());
+            return std::vector<std::shared_ptr<TileData> >(mapTiles.size());
+        }
+
+        std::vector<std::shared_ptr<TileData> > tileDatas(mapTiles.size());
+        for (std::size_t i = 0; i < mapTiles.size(); i++) {
+            if (datas[i]) {
+                tileDatas[i] = std::make_shared<TileData>(datas[i]);
+            } else if (mapTiles[i].getZoom() > getMinZoom()) {
+                tileDatas[i] = std::make_shared<TileData>(std::shared_ptr<BinaryData>());
+                tileDatas[i]->setReplaceWithParent(true);
+            }
+        }
+        return tileDatas;
+    }
+
+    bool PackageManagerTileDataSource::isBatchLoadingSupported() const {
+        return true;
+    }
+        
+    void PackageManagerTileDataSource::updateOpenPackageHandler(const std::shared_ptr<PackageInfo>& packageInfo, const std::shared_ptr<MapPackageHandler>& mapHandler) {
+        std::shared_ptr<MapPackageHandler> closedHandler;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto packageHandler = std::make_pair(packageInfo, mapHandler);
+            auto it = std::find(_cachedOpenPackageHandlers.begin(), _cachedOpenPackageHandlers.end(), packageHandler);
+            if (it != _cachedOpenPackageHandlers.end()) {
+                std::rotate(_cachedOpenPackageHandlers.begin(), it, it + 1);
+                return;
+            }
+            _cachedOpenPackageHandlers.insert(_cachedOpenPackageHandlers.begin(), packageHandler);
+            if (_cachedOpenPackageHandlers.size() > MAX_OPEN_PACKAGES) {
+                closedHandler = _cachedOpenPackageHandlers.back().second;
+                _cachedOpenPackageHandlers.pop_back();
+            }
+        }
+        if (closedHandler) {
+            closedHandler->closeDatabase();
+        }
+    }
         
     PackageManagerTileDataSource::PackageManagerListener::PackageManagerListener(PackageManagerTileDataSource& dataSource) :
         _dataSource(dataSource)
@@ -119,6 +188,26 @@ namespace carto {
         _dataSource.notifyTilesChanged(_dataSource._packageManager->getLocalPackages().empty()); // we need to remove all tiles only if there are no more packages left
     }
 
+    void PackageManagerTileDataSource::PackageManagerListener::onLocalPackagesChanged(const std::vector<std::shared_ptr<PackageInfo> >& addedPackages, const std::vector<std::shared_ptr<PackageInfo> >& removedPackages) {
+        // Handlers of unchanged packages are shared with the new package snapshot, keep their databases open
+        std::vector<std::shared_ptr<MapPackageHandler> > closedHandlers;
+        {
+            std::lock_guard<std::mutex> lock(_dataSource._mutex);
+            for (auto it = _dataSource._cachedOpenPackageHandlers.begin(); it != _dataSource._cachedOpenPackageHandlers.end(); ) {
+                if (std::find(removedPackages.begin(), removedPackages.end(), it->first) != removedPackages.end()) {
+                    closedHandlers.push_back(it->second);
+                    it = _dataSource._cachedOpenPackageHandlers.erase(it);
+                } else {
+                    it++;
+                }
+            }
+        }
+        for (const std::shared_ptr<MapPackageHandler>& closedHandler : closedHandlers) {
+            closedHandler->closeDatabase();
+        }
+        _dataSource.notifyTilesChanged(_dataSource._packageManager->getLocalPackages().empty()); // we need to remove all tiles only if there are no more packages left
+    }
+
     void PackageManagerTileDataSource::PackageManagerListener::onStylesChanged() {
         // NOTE: ignore
     }
@@ -40,12 +40,17 @@ namespace carto {
 
         virtual std::shared_ptr<TileData> loadTile(const MapTile& mapTile);
 
+        virtual std::vector<std::shared_ptr<TileData> > loadTiles(const std::vector<MapTile>& mapTiles);
+
+        virtual bool isBatchLoadingSupported() const;
+
     protected:
         class PackageManagerListener : public PackageManager::OnChangeListener {
         public:
             explicit PackageManagerListener(PackageManagerTileDataSource& dataSource);
                 
             virtual void onPackagesChanged();
+            virtual void onLocalPackagesChanged(const std::vector<std::shared_ptr<PackageInfo> >& addedPackages, const std::vector<std::shared_ptr<PackageInfo> >& removedPackages);
             virtual void onStylesChanged();
 
         private:
@@ -54,9 +59,11 @@ namespace carto {
 
         static const unsigned int MAX_OPEN_PACKAGES;
 
+        void updateOpenPackageHandler(const std::shared_ptr<PackageInfo>& packageInfo, const std::shared_ptr<MapPackageHandler>& mapHandler);
+
         const std::shared_ptr<PackageManager> _packageManager;
 
-        mutable std::vector<std::pair<std::shared_ptr<PackageInfo>, std::shared_ptr<MapPackageHandler> > > _cachedOpenPackageHandlers;
+        mutable std::vector<std::pair<std::shared_ptr<PackageInfo>, std::shared_ptr<MapPackageHandler> > > _cachedOpenPackageHandlers; // most recently used first, databases of evicted handlers are closed
 
         mutable std::mutex _mutex;
 
@@ -1,21 +1,72 @@
 #include "PersistentCacheTileDataSource.h"
+#include "components/InflatePool.h"
 #include "core/BinaryData.h"
 #include "datasources/TileDownloadListener.h"
+#include "datasources/components/ConcurrentTileLoader.h"
 #include "utils/Log.h"
+#include "utils/ThreadUtils.h"
 #include "utils/TileUtils.h"
 
+#include <algorithm>
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <set>
 
 #include <sqlite3pp.h>
 
+#include <zlib.h>
+
+#include <sha.h>
+#include <filters.h>
+#include <hex.h>
+
 namespace carto {
+
+    struct PersistentCacheTileDataSource::ReadConnection {
+        std::unique_ptr<sqlite3pp::database> database;
+        std::unique_ptr<sqlite3pp::query> selectQuery;
+    };
     
     PersistentCacheTileDataSource::PersistentCacheTileDataSource(const std::shared_ptr<TileDataSource>& dataSource, const std::string& databasePath) :
         CacheTileDataSource(dataSource),
         _database(),
+        _selectQuery(),
+        _sizeQuery(),
+        _insertCommand(),
+        _deleteCommand(),
+        _touchCommand(),
+        _findContentQuery(),
+        _contentQuery(),
+        _insertContentCommand(),
+        _updateContentCommand(),
+        _deleteContentCommand(),
+        _databasePath(databasePath),
+        _walMode(false),
+        _capacity(DEFAULT_CAPACITY),
+        _cacheSize(0),
+        _databaseMutex(),
+        _evictionCount(0),
+        _pendingTiles(),
+        _committingTiles(),
+        _pendingAccessTimes(),
+        _pendingTime(),
+        _writeQueueSize(DEFAULT_WRITE_QUEUE_SIZE),
+        _writeDelay(DEFAULT_WRITE_DELAY),
+        _writerStopped(true),
+        _writerThread(),
+        _pendingCondition(),
+        _pendingSpaceCondition(),
+        _pendingMutex(),
+        _readConnections(),
+        _readConnectionCount(0),
+        _readConnectionsOpen(false),
+        _readConnectionsCondition(),
+        _readConnectionsMutex(),
         _cacheOnlyMode(false),
+        _contentCompression(false),
         _downloadThreadPool(std::make_shared<CancelableThreadPool>()),
-        _cache(DEFAULT_CAPACITY),
+        _maxDownloadConcurrency(DEFAULT_MAX_DOWNLOAD_CONCURRENCY),
         _mutex()
     {
         _downloadThreadPool->setPoolSize(1);
@@ -38,6 +89,44 @@ namespace carto {
         _cacheOnlyMode = enabled;
     }
 
+    int PersistentCacheTileDataSource::getWriteQueueSize() const {
+        std::lock_guard<std::mutex> lock(_pendingMutex);
+        return static_cast<int>(_writeQueueSize);
+    }
+
+    void PersistentCacheTileDataSource::setWriteQueueSize(int queueSize) {
+        std::lock_guard<std::mutex> lock(_pendingMutex);
+        _writeQueueSize = static_cast<unsigned int>(std::max(1, queueSize));
+        _pendingSpaceCondition.notify_all();
+    }
+
+    int PersistentCacheTileDataSource::getWriteDelay() const {
+        std::lock_guard<std::mutex> lock(_pendingMutex);
+        return static_cast<int>(_writeDelay);
+    }
+
+    void PersistentCacheTileDataSource::setWriteDelay(int delay) {
+        std::lock_guard<std::mutex> lock(_pendingMutex);
+        _writeDelay = static_cast<unsigned int>(std::max(0, delay));
+        _pendingCondition.notify_all();
+    }
+
+    bool PersistentCacheTileDataSource::isContentCompression() const {
+        return _contentCompression;
+    }
+
+    void PersistentCacheTileDataSource::setContentCompression(bool enabled) {
+        _contentCompression = enabled;
+    }
+
+    int PersistentCacheTileDataSource::getMaxDownloadConcurrency() const {
+        return static_cast<int>(_maxDownloadConcurrency.load());
+    }
+
+    void PersistentCacheTileDataSource::setMaxDownloadConcurrency(int concurrency) {
+        _maxDownloadConcurrency = static_cast<unsigned int>(std::max(1, concurrency));
+    }
+
     void PersistentCacheTileDataSource::startDownloadArea(const MapBounds& mapBounds, int minZoom, int maxZoom, const std::shared_ptr<TileDownloadListener>& tileDownloadListener) {
         auto task = std::make_shared<DownloadTask>(std::static_pointer_cast<PersistentCacheTileDataSource>(shared_from_this()), mapBounds, minZoom, maxZoom, tileDownloadListener);
         _downloadThreadPool->execute(task, 0);
@@ -56,45 +145,166 @@ namespace carto {
             Log::Error("PersistentCacheTileDataSource::loadTile: Could not connect to the database, loading tile without caching");
         }
 
-        if (_cache.empty()) {
-            loadTileInfo();
-        }
-        
+        long long tileId = mapTile.getTileId();
         std::shared_ptr<TileData> tileData;
 
-        std::shared_ptr<long long> tileIdPtr;
-        if (_cache.read(mapTile.getTileId(), tileIdPtr)) {
-            tileData = get(mapTile.getTileId());
-            if (tileData) {
-                if (tileData->getMaxAge() != 0) {
-                    return tileData;
-                }
+        if (_walMode) {
+            // Committed tiles can be read without blocking other workers
+            lock.unlock();
+            tileData = get(tileId);
+            lock.lock();
+        } else {
+            tileData = get(tileId);
+        }
+        std::shared_ptr<TileData> expiredTileData;
+        if (tileData) {
+            if (tileData->getMaxAge() != 0) {
+                // Update access time, used for evicting least recently used tiles
+                touch(tileId);
+                tileData->setCacheSource("PersistentCacheTileDataSource");
+                _cacheStatistics.recordHit();
+                return tileData;
             }
-            _cache.remove(mapTile.getTileId());
+            std::swap(expiredTileData, tileData);
         }
+        _cacheStatistics.recordMiss();
         
         if (!_cacheOnlyMode) {
             lock.unlock();
-            tileData = _dataSource->loadTile(mapTile);
+            std::chrono::steady_clock::time_point loadStartTime = std::chrono::steady_clock::now();
+            if (HasValidators(expiredTileData)) {
+                // If the tile has not changed, only its expiration time is refreshed and the tile data is not downloaded again
+                tileData = _dataSource->revalidateTile(mapTile, expiredTileData);
+            } else {
+                tileData = _dataSource->loadTile(mapTile);
+            }
+            _cacheStatistics.recordLoadTime(std::chrono::steady_clock::now() - loadStartTime);
+            waitPendingTiles();
             lock.lock();
         }
     
+        bool stored = false;
         if (tileData) {
-            if (tileData->getMaxAge() != 0 && !tileData->isReplaceWithParent() && tileData->getData()) {
-                long long tileId = mapTile.getTileId();
-                std::size_t tileSize = tileData->getData()->size();
-                _cache.put(mapTile.getTileId(), createTileId(tileId), tileSize + EXTRA_TILE_FOOTPRINT);
-                if (_cache.exists(mapTile.getTileId())) { // make sure the tile was added
-                    store(mapTile.getTileId(), tileData);
-                }
+            if (isStorable(tileData)) {
+                store(tileId, tileData);
+                stored = true;
             }
         } else {
             Log::Infof("PersistentCacheTileDataSource::loadTile: Failed to load %s", mapTile.toString().c_str());
         }
+        if (expiredTileData && !stored) {
+            remove(tileId);
+        }
         
         return tileData;
     }
 
+    std::vector<std::shared_ptr<TileData> > PersistentCacheTileDataSource::loadTiles(const std::vector<MapTile>& mapTiles) {
+        std::unique_lock<std::recursive_mutex> lock(_mutex);
+
+        Log::Infof("PersistentCacheTileDataSource::loadTiles: Loading %d tiles", static_cast<int>(mapTiles.size()));
+
+        if (!_database) {
+            Log::Error("PersistentCacheTileDataSource::loadTiles: Could not connect to the database, loading tiles without caching");
+        }
+
+        std::vector<long long> tileIds;
+        tileIds.reserve(mapTiles.size());
+        for (const MapTile& mapTile : mapTiles) {
+            tileIds.push_back(mapTile.getTileId());
+        }
+
+        std::map<long long, std::shared_ptr<TileData> > cachedTileDatas;
+        if (_walMode) {
+            // Committed tiles can be read without blocking other workers
+            lock.unlock();
+            cachedTileDatas = getMultiple(tileIds);
+            lock.lock();
+        } else {
+            cachedTileDatas = getMultiple(tileIds);
+        }
+
+        std::vector<std::shared_ptr<TileData> > tileDatas(mapTiles.size());
+        std::vector<MapTile> missingTiles;
+        std::vector<std::size_t> missingIndices;
+        std::vector<std::pair<std::size_t, std::shared_ptr<TileData> > > expiredTileDatas;
+        for (std::size_t i = 0; i < mapTiles.size(); i++) {
+            auto it = cachedTileDatas.find(tileIds[i]);
+            if (it != cachedTileDatas.end() && it->second) {
+                if (it->second->getMaxAge() != 0) {
+                    // Update access time, used for evicting least recently used tiles
+                    touch(tileIds[i]);
+                    it->second->setCacheSource("PersistentCacheTileDataSource");
+                    tileDatas[i] = it->second;
+                    _cacheStatistics.recordHit();
+                    continue;
+                }
+                _cacheStatistics.recordMiss();
+                if (HasValidators(it->second) && !_cacheOnlyMode) {
+                    // Expired tiles with validators are revalidated one by one instead of loading them again
+                    expiredTileDatas.emplace_back(i, it->second);
+                    continue;
+                }
+                remove(tileIds[i]);
+            } else {
+                _cacheStatistics.recordMiss();
+            }
+            missingTiles.push_back(mapTiles[i]);
+            missingIndices.push_back(i);
+        }
+
+        for (const std::pair<std::size_t, std::shared_ptr<TileData> >& expiredTileData : expiredTileDatas) {
+            std::size_t index = expiredTileData.first;
+            lock.unlock();
+            std::chrono::steady_clock::time_point loadStartTime = std::chrono::steady_clock::now();
+            std::shared_ptr<TileData> tileData = _dataSource->revalidateTile(mapTiles[index], expiredTileData.second);
+            _cacheStatistics.recordLoadTime(std::chrono::steady_clock::now() - loadStartTime);
+            waitPendingTiles();
+            lock.lock();
+
+            bool stored = false;
+            if (tileData && isStorable(tileData)) {
+                store(tileIds[index], tileData);
+                stored = true;
+            }
+            if (!stored) {
+                remove(tileIds[index]);
+            }
+            tileDatas[index] = tileData;
+        }
+
+        if (missingTiles.empty() || _cacheOnlyMode) {
+            return tileDatas;
+        }
+
+        lock.unlock();
+        std::chrono::steady_clock::time_point loadStartTime = std::chrono::steady_clock::now();
+        std::vector<std::shared_ptr<TileData> > loadedTileDatas = _dataSource->loadTiles(missingTiles);
+        _cacheStatistics.recordLoadTime(std::chrono::steady_clock::now() - loadStartTime, missingTiles.size());
+        waitPendingTiles();
+        lock.lock();
+
+        for (std::size_t i = 0; i < missingTiles.size() && i < loadedTileDatas.size(); i++) {
+            const std::shared_ptr<TileData>& tileData = loadedTileDatas[i];
+            if (tileData) {
+                if (isStorable(tileData)) {
+                    store(missingTiles[i].getTileId(), tileData);
+                }
+            } else {
+                Log::Infof("PersistentCacheTileDataSource::loadTiles: Failed to load %s", missingTiles[i].toString().c_str());
+            }
+            tileDatas[missingIndices[i]] = tileData;
+        }
+
+        return tileDatas;
+    }
+
+    bool PersistentCacheTileDataSource::isBatchLoadingSupported() const {
+        // Loading tiles in batches is useful only if the cache misses can also be loaded in batches
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return _cacheOnlyMode || _dataSource->isBatchLoadingSupported();
+    }
+
     bool PersistentCacheTileDataSource::isOpen() const {
         std::lock_guard<std::recursive_mutex> lock(_mutex);
         return (bool) _database;
@@ -106,23 +316,120 @@ namespace carto {
     }
         
     void PersistentCacheTileDataSource::clear() {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        std::lock_guard<std::mutex> databaseLock(_databaseMutex);
+
+        {
+            std::lock_guard<std::mutex> pendingLock(_pendingMutex);
+            _pendingTiles.clear();
+            _pendingAccessTimes.clear();
+            _pendingSpaceCondition.notify_all();
+        }
+
+        if (!_database) {
+            return;
+        }
+
         try {
-            std::lock_guard<std::recursive_mutex> lock(_mutex);
-            _cache.clear(); // forces all elements to be removed, but can be slow
+            sqlite3pp::transaction xct(*_database);
+            {
+                sqlite3pp::command command(*_database, "DELETE FROM persistent_cache");
+                command.execute();
+                _database->execute("DELETE FROM persistent_cache_content");
+                _cacheSize = 0;
+                storeCacheSize();
+            }
+            xct.commit();
         }
         catch (const std::exception& ex) {
             Log::Errorf("PersistentCacheTileDataSource::clear: Failed to clear cache: %s", ex.what());
+            loadCacheSize();
         }
     }
     
-    std::size_t PersistentCacheTileDataSource::getCapacity() const {
+    void PersistentCacheTileDataSource::removeCachedTiles(const MapBounds& bounds, int minZoom, int maxZoom) {
         std::lock_guard<std::recursive_mutex> lock(_mutex);
-        return _cache.capacity();
+        std::lock_guard<std::mutex> databaseLock(_databaseMutex);
+
+        {
+            std::lock_guard<std::mutex> pendingLock(_pendingMutex);
+            for (auto it = _pendingTiles.begin(); it != _pendingTiles.end(); ) {
+                if (isTileInArea(MapTile::FromTileId(it->first), bounds, minZoom, maxZoom)) {
+                    it = _pendingTiles.erase(it);
+                } else {
+                    it++;
+                }
+            }
+            for (auto it = _pendingAccessTimes.begin(); it != _pendingAccessTimes.end(); ) {
+                if (isTileInArea(MapTile::FromTileId(it->first), bounds, minZoom, maxZoom)) {
+                    it = _pendingAccessTimes.erase(it);
+                } else {
+                    it++;
+                }
+            }
+            _pendingSpaceCondition.notify_all();
+        }
+
+        if (!_database) {
+            return;
+        }
+
+        try {
+            std::vector<long long> tileIds;
+            sqlite3pp::query query(*_database, "SELECT tileId FROM persistent_cache");
+            for (auto qit = query.begin(); qit != query.end(); ++qit) {
+                long long tileId = static_cast<long long>((*qit).get<std::uint64_t>(0));
+                if (isTileInArea(MapTile::FromTileId(tileId), bounds, minZoom, maxZoom)) {
+                    tileIds.push_back(tileId);
+                }
+            }
+            query.finish();
+
+            sqlite3pp::transaction xct(*_database);
+            {
+                for (long long tileId : tileIds) {
+                    releaseTile(tileId);
+                    _deleteCommand->reset();
+                    _deleteCommand->bind(":tileId", static_cast<std::uint64_t>(tileId));
+                    _deleteCommand->execute();
+                }
+                storeCacheSize();
+            }
+            xct.commit();
+        }
+        catch (const std::exception& ex) {
+            Log::Errorf("PersistentCacheTileDataSource::removeCachedTiles: Failed to remove tiles: %s", ex.what());
+            loadCacheSize();
+        }
+    }
+    
+    std::size_t PersistentCacheTileDataSource::getCapacity() const {
+        return _capacity;
     }
     
     void PersistentCacheTileDataSource::setCapacity(std::size_t capacityInBytes) {
         std::lock_guard<std::recursive_mutex> lock(_mutex);
-        _cache.resize(capacityInBytes);
+        _capacity = capacityInBytes;
+        commitPendingTiles();
+    }
+
+    CacheStatistics PersistentCacheTileDataSource::getCacheStatistics() const {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        std::lock_guard<std::mutex> databaseLock(_databaseMutex);
+
+        std::size_t entryCount = 0;
+        if (_database) {
+            try {
+                sqlite3pp::query query(*_database, "SELECT COUNT(*) FROM persistent_cache");
+                for (auto qit = query.begin(); qit != query.end(); ++qit) {
+                    entryCount = static_cast<std::size_t>((*qit).get<std::uint64_t>(0));
+                }
+            }
+            catch (const std::exception& ex) {
+                Log::Errorf("PersistentCacheTileDataSource::getCacheStatistics: Failed to query tile count: %s", ex.what());
+            }
+        }
+        return _cacheStatistics.getStatistics(_cacheSize, _capacity, entryCount, _evictionCount.load());
     }
     
     void PersistentCacheTileDataSource::openDatabase(const std::string& databasePath) {
@@ -154,17 +461,105 @@ namespace carto {
                 sqlite3pp::command command(*_database, "DROP TABLE IF EXISTS persistent_cache");
                 command.execute();
                 command.finish();
+                _database->execute("DROP TABLE IF EXISTS persistent_cache_content");
+                _database->execute("DROP TABLE IF EXISTS persistent_cache_meta");
             }
 
-            sqlite3pp::command command3(*_database, "CREATE TABLE IF NOT EXISTS persistent_cache(tileId INTEGER NOT NULL PRIMARY KEY, compressed BLOB, time INTEGER, expirationTime INTEGER)");
+            sqlite3pp::command command3(*_database, "CREATE TABLE IF NOT EXISTS persistent_cache(tileId INTEGER NOT NULL PRIMARY KEY, compressed BLOB, time INTEGER, expirationTime INTEGER, etag TEXT, lastModified TEXT, contentId INTEGER)");
             command3.execute();
             command3.finish();
+
+            // Validator and content columns are added to cache databases created by older SDK versions
+            std::set<std::string> columnNames;
+            sqlite3pp::query query3(*_database, "PRAGMA table_info(persistent_cache)");
+            for (auto it3 = query3.begin(); it3 != query3.end(); ++it3) {
+                const char* columnName = (*it3).get<const char*>(1);
+                if (columnName) {
+                    columnNames.insert(columnName);
+                }
+            }
+            query3.finish();
+            if (columnNames.count("etag") == 0) {
+                _database->execute("ALTER TABLE persistent_cache ADD COLUMN etag TEXT");
+                _database->execute("ALTER TABLE persistent_cache ADD COLUMN lastModified TEXT");
+            }
+            if (columnNames.count("contentId") == 0) {
+                _database->execute("ALTER TABLE persistent_cache ADD COLUMN contentId INTEGER");
+            }
+
+            // Unique tile contents, shared by all tiles with identical data. The codec column is added to databases created by older SDK versions.
+            _database->execute("CREATE TABLE IF NOT EXISTS persistent_cache_content(contentId INTEGER NOT NULL PRIMARY KEY, hash TEXT NOT NULL, compressed BLOB, refCount INTEGER, codec INTEGER)");
+            bool contentCodec = false;
+            sqlite3pp::query query5(*_database, "PRAGMA table_info(persistent_cache_content)");
+            for (auto it5 = query5.begin(); it5 != query5.end(); ++it5) {
+                const char* columnName = (*it5).get<const char*>(1);
+                if (columnName && std::string(columnName) == "codec") {
+                    contentCodec = true;
+                }
+            }
+            query5.finish();
+            if (!contentCodec) {
+                _database->execute("ALTER TABLE persistent_cache_content ADD COLUMN codec INTEGER");
+            }
+            _database->execute("CREATE INDEX IF NOT EXISTS persistent_cache_content_hash ON persistent_cache_content(hash)");
+
+            // The time index is used for evicting least recently used tiles, the meta table keeps the total size of the cache.
+            // Both are created only once for existing cache databases.
+            _database->execute("CREATE INDEX IF NOT EXISTS persistent_cache_time ON persistent_cache(time)");
+            _database->execute("CREATE TABLE IF NOT EXISTS persistent_cache_meta(name TEXT NOT NULL PRIMARY KEY, value INTEGER)");
+
+            // Try to switch to WAL mode, this is not supported on all platforms
+            _walMode = false;
+            try {
+                sqlite3pp::query query4(*_database, "PRAGMA journal_mode=WAL");
+                for (auto it4 = query4.begin(); it4 != query4.end(); ++it4) {
+                    std::string journalMode = (*it4).get<const char*>(0);
+                    _walMode = (journalMode == "wal" || journalMode == "WAL");
+                }
+                query4.finish();
+            }
+            catch (const std::exception& ex) {
+                Log::Infof("PersistentCacheTileDataSource::openDatabase: Failed to switch to WAL mode: %s", ex.what());
+            }
+            if (_walMode) {
+                _database->execute("PRAGMA synchronous=NORMAL");
+            }
+
+            _selectQuery.reset(new sqlite3pp::query(*_database, "SELECT IFNULL(c.compressed, t.compressed), t.expirationTime, t.etag, t.lastModified, t.contentId=0, IFNULL(c.codec, 0) FROM persistent_cache t LEFT JOIN persistent_cache_content c ON c.contentId=t.contentId WHERE t.tileId=:tileId"));
+            _sizeQuery.reset(new sqlite3pp::query(*_database, "SELECT LENGTH(compressed), contentId FROM persistent_cache WHERE tileId=:tileId"));
+            _insertCommand.reset(new sqlite3pp::command(*_database, "INSERT OR REPLACE INTO persistent_cache(tileId, compressed, time, expirationTime, etag, lastModified, contentId) VALUES (:tileId, NULL, :time, :expirationTime, :etag, :lastModified, :contentId)"));
+            _deleteCommand.reset(new sqlite3pp::command(*_database, "DELETE FROM persistent_cache WHERE tileId=:tileId"));
+            _touchCommand.reset(new sqlite3pp::command(*_database, "UPDATE persistent_cache SET time=:time WHERE tileId=:tileId"));
+            _findContentQuery.reset(new sqlite3pp::query(*_database, "SELECT contentId FROM persistent_cache_content WHERE hash=:hash"));
+            _contentQuery.reset(new sqlite3pp::query(*_database, "SELECT refCount, LENGTH(compressed) FROM persistent_cache_content WHERE contentId=:contentId"));
+            _insertContentCommand.reset(new sqlite3pp::command(*_database, "INSERT INTO persistent_cache_content(hash, compressed, refCount, codec) VALUES (:hash, :compressed, 1, :codec)"));
+            _updateContentCommand.reset(new sqlite3pp::command(*_database, "UPDATE persistent_cache_content SET refCount=refCount+:delta WHERE contentId=:contentId"));
+            _deleteContentCommand.reset(new sqlite3pp::command(*_database, "DELETE FROM persistent_cache_content WHERE contentId=:contentId"));
+
+            loadCacheSize();
         }
         catch (const std::exception& ex) {
             Log::Errorf("PersistentCacheTileDataSource::openDatabase: Failed to initialize database: %s", ex.what());
+            _selectQuery.reset();
+            _sizeQuery.reset();
+            _insertCommand.reset();
+            _deleteCommand.reset();
+            _touchCommand.reset();
+            _findContentQuery.reset();
+            _contentQuery.reset();
+            _insertContentCommand.reset();
+            _updateContentCommand.reset();
+            _deleteContentCommand.reset();
             _database.reset();
             return;
         }
+
+        {
+            std::lock_guard<std::mutex> lock(_readConnectionsMutex);
+            _readConnectionsOpen = _walMode;
+        }
+
+        startWriter();
     }
 
     void PersistentCacheTileDataSource::closeDatabase() {
@@ -172,7 +567,22 @@ namespace carto {
             return;
         }
 
+        // Stop the writer thread and write the remaining tiles synchronously
+        stopWriter();
+        commitPendingTiles();
+        closeReadConnections();
+
         try {
+            _selectQuery.reset();
+            _sizeQuery.reset();
+            _insertCommand.reset();
+            _deleteCommand.reset();
+            _touchCommand.reset();
+            _findContentQuery.reset();
+            _contentQuery.reset();
+            _insertContentCommand.reset();
+            _updateContentCommand.reset();
+            _deleteContentCommand.reset();
             if (_database->disconnect() != SQLITE_OK) {
                 Log::Error("PersistentCacheTileDataSource::closeDatabase: Failed to close database");
             }
@@ -183,83 +593,438 @@ namespace carto {
             _database.reset();
         }
 
-        _cache.clear(); // NOTE: as the database is closed at this point, elements are not removed
+        {
+            std::lock_guard<std::mutex> lock(_pendingMutex);
+            _pendingTiles.clear();
+            _pendingAccessTimes.clear();
+        }
+        _cacheSize = 0;
     }
     
-    void PersistentCacheTileDataSource::loadTileInfo() {
-        struct TileInfo {
-            std::uint64_t tileId;
-            std::size_t tileSize;
-            std::uint64_t time;
-        };
-
+    void PersistentCacheTileDataSource::loadCacheSize() {
         if (!_database) {
             return;
         }
 
         try {
-            // Get tile ids and sizes ordered by the timestamp from the database
-            std::vector<TileInfo> tileInfos;
-            tileInfos.reserve(_cache.capacity() / (EXTRA_TILE_FOOTPRINT + 1));
-            sqlite3pp::query query(*_database, "SELECT tileId, LENGTH(compressed), time FROM persistent_cache");
-            for (auto it = query.begin(); it != query.end(); ++it) {
-                TileInfo tileInfo;
-                tileInfo.tileId = (*it).get<std::uint64_t>(0);
-                tileInfo.tileSize = static_cast<std::size_t>((*it).get<std::uint64_t>(1));
-                tileInfo.time = (*it).get<std::uint64_t>(2);
-                tileInfos.push_back(tileInfo);
+            bool found = false;
+            sqlite3pp::query query1(*_database, "SELECT value FROM persistent_cache_meta WHERE name='size'");
+            for (auto it1 = query1.begin(); it1 != query1.end(); ++it1) {
+                _cacheSize = static_cast<std::size_t>((*it1).get<std::uint64_t>(0));
+                found = true;
+            }
+            query1.finish();
+            if (found) {
+                return;
             }
-            query.finish();
-
-            // Sort the tiles
-            std::sort(tileInfos.begin(), tileInfos.end(), [](const TileInfo& tileInfo1, const TileInfo& tileInfo2) {
-                return tileInfo1.time < tileInfo2.time;
-            });
 
-            // Now store the queried items in cache. This may result in eviction of some of the items.
-            for (const TileInfo& tileInfo : tileInfos) {
-                _cache.put(tileInfo.tileId, createTileId(tileInfo.tileId), tileInfo.tileSize + EXTRA_TILE_FOOTPRINT);
+            // Calculate the size from the tile and content tables. This is needed only once for caches created by older SDK versions.
+            Log::Info("PersistentCacheTileDataSource::loadCacheSize: Calculating cache size");
+            sqlite3pp::query query2(*_database, "SELECT COUNT(*), IFNULL(SUM(LENGTH(compressed)), 0) FROM persistent_cache");
+            for (auto it2 = query2.begin(); it2 != query2.end(); ++it2) {
+                std::uint64_t tileCount = (*it2).get<std::uint64_t>(0);
+                std::uint64_t dataSize = (*it2).get<std::uint64_t>(1);
+                _cacheSize = static_cast<std::size_t>(dataSize + tileCount * EXTRA_TILE_FOOTPRINT);
+            }
+            query2.finish();
+            sqlite3pp::query query3(*_database, "SELECT IFNULL(SUM(LENGTH(compressed)), 0) FROM persistent_cache_content");
+            for (auto it3 = query3.begin(); it3 != query3.end(); ++it3) {
+                _cacheSize += static_cast<std::size_t>((*it3).get<std::uint64_t>(0));
             }
+            query3.finish();
+            storeCacheSize();
         }
         catch (const std::exception& ex) {
-            Log::Errorf("PersistentCacheTileDataSource::loadTileInfo: Failed to query tile set from the database: %s", ex.what());
+            Log::Errorf("PersistentCacheTileDataSource::loadCacheSize: Failed to query cache size from the database: %s", ex.what());
         }
     }
+
+    void PersistentCacheTileDataSource::storeCacheSize() {
+        sqlite3pp::command command(*_database, "INSERT OR REPLACE INTO persistent_cache_meta(name, value) VALUES('size', :value)");
+        command.bind(":value", static_cast<std::uint64_t>(_cacheSize));
+        command.execute();
+    }
+
+    std::shared_ptr<PersistentCacheTileDataSource::ReadConnection> PersistentCacheTileDataSource::acquireReadConnection() {
+        std::unique_lock<std::mutex> lock(_readConnectionsMutex);
+        while (_readConnectionsOpen) {
+            if (!_readConnections.empty()) {
+                std::shared_ptr<ReadConnection> readConnection = _readConnections.back();
+                _readConnections.pop_back();
+                return readConnection;
+            }
+            
+            if (_readConnectionCount < MAX_READ_CONNECTIONS) {
+                auto readConnection = std::make_shared<ReadConnection>();
+                try {
+                    readConnection->database.reset(new sqlite3pp::database());
+                    if (readConnection->database->connect_v2(_databasePath.c_str(), SQLITE_OPEN_READONLY) != SQLITE_OK) {
+                        Log::Error("PersistentCacheTileDataSource::acquireReadConnection: Failed to open read connection");
+                        return std::shared_ptr<ReadConnection>();
+                    }
+                    readConnection->selectQuery.reset(new sqlite3pp::query(*readConnection->database, "SELECT IFNULL(c.compressed, t.compressed), t.expirationTime, t.etag, t.lastModified, t.contentId=0, IFNULL(c.codec, 0) FROM persistent_cache t LEFT JOIN persistent_cache_content c ON c.contentId=t.contentId WHERE t.tileId=:tileId"));
+                }
+                catch (const std::exception& ex) {
+                    Log::Errorf("PersistentCacheTileDataSource::acquireReadConnection: Failed to open read connection: %s", ex.what());
+                    return std::shared_ptr<ReadConnection>();
+                }
+                _readConnectionCount++;
+                return readConnection;
+            }
+
+            _readConnectionsCondition.wait(lock);
+        }
+        return std::shared_ptr<ReadConnection>();
+    }
+
+    void PersistentCacheTileDataSource::releaseReadConnection(const std::shared_ptr<ReadConnection>& readConnection) {
+        std::lock_guard<std::mutex> lock(_readConnectionsMutex);
+        if (_readConnectionsOpen) {
+            _readConnections.push_back(readConnection);
+        }
+        _readConnectionsCondition.notify_one();
+    }
+
+    void PersistentCacheTileDataSource::closeReadConnections() {
+        std::lock_guard<std::mutex> lock(_readConnectionsMutex);
+        _readConnectionsOpen = false;
+        _readConnections.clear(); // connections currently in use are closed once released
+        _readConnectionCount = 0;
+        _readConnectionsCondition.notify_all();
+    }
     
+    void PersistentCacheTileDataSource::startWriter() {
+        std::lock_guard<std::mutex> lock(_pendingMutex);
+        _writerStopped = false;
+        _writerThread = std::make_shared<std::thread>(std::bind(&PersistentCacheTileDataSource::runWriter, this));
+    }
+
+    void PersistentCacheTileDataSource::stopWriter() {
+        std::shared_ptr<std::thread> writerThread;
+        {
+            std::lock_guard<std::mutex> lock(_pendingMutex);
+            _writerStopped = true;
+            _pendingCondition.notify_all();
+            _pendingSpaceCondition.notify_all();
+            std::swap(writerThread, _writerThread);
+        }
+
+        if (writerThread) {
+            writerThread->join();
+        }
+    }
+
+    void PersistentCacheTileDataSource::runWriter() {
+        ThreadUtils::SetThreadRole(ThreadRole::BACKGROUND);
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(_pendingMutex);
+                if (_writerStopped) {
+                    break;
+                }
+
+                // Wait until the batch is large or old enough
+                std::size_t pendingCount = _pendingTiles.size() + _pendingAccessTimes.size();
+                if (pendingCount == 0) {
+                    _pendingCondition.wait(lock);
+                    continue;
+                }
+                if (pendingCount < WRITE_BATCH_SIZE && _pendingTiles.size() < _writeQueueSize) {
+                    std::chrono::steady_clock::time_point commitTime = _pendingTime + std::chrono::milliseconds(_writeDelay);
+                    if (std::chrono::steady_clock::now() < commitTime) {
+                        _pendingCondition.wait_until(lock, commitTime);
+                        continue;
+                    }
+                }
+            }
+
+            commitPendingTiles();
+        }
+    }
+
+    void PersistentCacheTileDataSource::checkPendingTiles() {
+        // Note: _pendingMutex must be locked by the caller
+        std::size_t pendingCount = _pendingTiles.size() + _pendingAccessTimes.size();
+        if (pendingCount == 1) {
+            _pendingTime = std::chrono::steady_clock::now();
+            _pendingCondition.notify_one();
+        } else if (pendingCount >= WRITE_BATCH_SIZE || _pendingTiles.size() >= _writeQueueSize) {
+            _pendingCondition.notify_one();
+        }
+    }
+
+    void PersistentCacheTileDataSource::waitPendingTiles() {
+        std::unique_lock<std::mutex> lock(_pendingMutex);
+        while (!_writerStopped && _pendingTiles.size() >= _writeQueueSize) {
+            _pendingCondition.notify_one();
+            _pendingSpaceCondition.wait(lock);
+        }
+    }
+
+    void PersistentCacheTileDataSource::commitPendingTiles() {
+        std::lock_guard<std::mutex> databaseLock(_databaseMutex);
+
+        // Move the pending changes to the committing batch. The tiles remain readable until they are committed.
+        std::map<long long, long long> accessTimes;
+        {
+            std::lock_guard<std::mutex> lock(_pendingMutex);
+            if (_pendingTiles.empty() && _pendingAccessTimes.empty() && _cacheSize <= _capacity) {
+                return;
+            }
+            std::swap(_committingTiles, _pendingTiles);
+            std::swap(accessTimes, _pendingAccessTimes);
+            _pendingSpaceCondition.notify_all();
+        }
+        
+        if (_database) {
+            // Write all pending changes using a single transaction
+            try {
+                sqlite3pp::transaction xct(*_database);
+                for (auto it = _committingTiles.begin(); it != _committingTiles.end(); it++) {
+                    long long tileId = it->first;
+                    const PendingTile& pendingTile = it->second;
+
+                    // Retain the new content before releasing the existing tile, so unchanged contents are not deleted and reinserted
+                    long long contentId = 0; // missing tiles are stored without content
+                    if (pendingTile.tileData && !pendingTile.tileData->isReplaceWithParent()) {
+                        contentId = retainContent(pendingTile.tileData->getData());
+                    }
+                    releaseTile(tileId);
+
+                    if (pendingTile.tileData) {
+                        std::string etag = pendingTile.tileData->getETag();
+                        std::string lastModified = pendingTile.tileData->getLastModified();
+                        _insertCommand->reset();
+                        _insertCommand->bind(":tileId", static_cast<std::uint64_t>(tileId));
+                        _insertCommand->bind(":time", static_cast<std::uint64_t>(pendingTile.time));
+                        _insertCommand->bind(":expirationTime", static_cast<std::uint64_t>(pendingTile.expirationTime));
+                        _insertCommand->bind(":etag", etag.c_str());
+                        _insertCommand->bind(":lastModified", lastModified.c_str());
+                        _insertCommand->bind(":contentId", static_cast<std::uint64_t>(contentId));
+                        _insertCommand->execute();
+                        _cacheSize += EXTRA_TILE_FOOTPRINT;
+                    } else {
+                        _deleteCommand->reset();
+                        _deleteCommand->bind(":tileId", static_cast<std::uint64_t>(tileId));
+                        _deleteCommand->execute();
+                    }
+                }
+
+                for (auto it = accessTimes.begin(); it != accessTimes.end(); it++) {
+                    if (_committingTiles.find(it->first) == _committingTiles.end()) {
+                        _touchCommand->reset();
+                        _touchCommand->bind(":time", static_cast<std::uint64_t>(it->second));
+                        _touchCommand->bind(":tileId", static_cast<std::uint64_t>(it->first));
+                        _touchCommand->execute();
+                    }
+                }
+
+                evictTiles();
+                storeCacheSize();
+                xct.commit();
+            }
+            catch (const std::exception& ex) {
+                Log::Errorf("PersistentCacheTileDataSource::commitPendingTiles: Failed to store tile data in the database: %s", ex.what());
+                loadCacheSize();
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(_pendingMutex);
+        _committingTiles.clear();
+    }
+
+    void PersistentCacheTileDataSource::evictTiles() {
+        while (_cacheSize > _capacity) {
+            // Find the least recently used tiles
+            std::vector<long long> tileIds;
+            sqlite3pp::query query(*_database, "SELECT tileId FROM persistent_cache ORDER BY time ASC LIMIT 64");
+            for (auto qit = query.begin(); qit != query.end(); ++qit) {
+                tileIds.push_back(static_cast<long long>((*qit).get<std::uint64_t>(0)));
+            }
+            query.finish();
+
+            if (tileIds.empty()) {
+                // The cache is empty, size information was inaccurate
+                _cacheSize = 0;
+                break;
+            }
+
+            for (long long tileId : tileIds) {
+                if (_cacheSize <= _capacity) {
+                    break;
+                }
+                releaseTile(tileId);
+                _deleteCommand->reset();
+                _deleteCommand->bind(":tileId", static_cast<std::uint64_t>(tileId));
+                _deleteCommand->execute();
+                _evictionCount++;
+            }
+        }
+    }
+
+    void PersistentCacheTileDataSource::releaseTile(long long tileId) {
+        // Subtract the size of the existing tile, if any, and release its content
+        long long contentId = 0;
+        _sizeQuery->reset();
+        _sizeQuery->bind(":tileId", static_cast<std::uint64_t>(tileId));
+        for (auto qit = _sizeQuery->begin(); qit != _sizeQuery->end(); ++qit) {
+            std::size_t tileSize = static_cast<std::size_t>((*qit).get<std::uint64_t>(0)) + EXTRA_TILE_FOOTPRINT;
+            _cacheSize -= std::min(_cacheSize, tileSize);
+            contentId = static_cast<long long>((*qit).get<std::uint64_t>(1));
+        }
+        _sizeQuery->reset();
+
+        if (contentId != 0) {
+            releaseContent(contentId);
+        }
+    }
+
+    long long PersistentCacheTileDataSource::retainContent(const std::shared_ptr<BinaryData>& data) {
+        std::string hash = CalculateContentHash(data);
+
+        // Reuse the existing content, if identical data is already stored. The hash is calculated from uncompressed data, so the content is found regardless of its codec.
+        long long contentId = 0;
+        _findContentQuery->reset();
+        _findContentQuery->bind(":hash", hash.c_str());
+        for (auto qit = _findContentQuery->begin(); qit != _findContentQuery->end(); ++qit) {
+            contentId = static_cast<long long>((*qit).get<std::uint64_t>(0));
+        }
+        _findContentQuery->reset();
+
+        if (contentId != 0) {
+            _updateContentCommand->reset();
+            _updateContentCommand->bind(":delta", 1);
+            _updateContentCommand->bind(":contentId", static_cast<std::uint64_t>(contentId));
+            _updateContentCommand->execute();
+            return contentId;
+        }
+
+        // Compress the content only if this saves enough space, already compressed images are stored as is
+        int codec = CONTENT_CODEC_NONE;
+        std::vector<unsigned char> compressedData;
+        if (_contentCompression && CompressContent(*data, compressedData)) {
+            codec = CONTENT_CODEC_DEFLATE;
+        }
+        const unsigned char* contentPtr = (codec == CONTENT_CODEC_DEFLATE ? compressedData.data() : data->data());
+        std::size_t contentSize = (codec == CONTENT_CODEC_DEFLATE ? compressedData.size() : data->size());
+
+        _insertContentCommand->reset();
+        _insertContentCommand->bind(":hash", hash.c_str());
+        _insertContentCommand->bind(":compressed", contentPtr, static_cast<unsigned int>(contentSize));
+        _insertContentCommand->bind(":codec", codec);
+        _insertContentCommand->execute();
+        _cacheSize += contentSize;
+        return static_cast<long long>(_database->last_insert_rowid());
+    }
+
+    void PersistentCacheTileDataSource::releaseContent(long long contentId) {
+        _updateContentCommand->reset();
+        _updateContentCommand->bind(":delta", -1);
+        _updateContentCommand->bind(":contentId", static_cast<std::uint64_t>(contentId));
+        _updateContentCommand->execute();
+
+        // Delete the content once no tiles refer to it
+        int refCount = 0;
+        std::size_t contentSize = 0;
+        _contentQuery->reset();
+        _contentQuery->bind(":contentId", static_cast<std::uint64_t>(contentId));
+        for (auto qit = _contentQuery->begin(); qit != _contentQuery->end(); ++qit) {
+            refCount = (*qit).get<int>(0);
+            contentSize = static_cast<std::size_t>((*qit).get<std::uint64_t>(1));
+        }
+        _contentQuery->reset();
+
+        if (refCount <= 0) {
+            _deleteContentCommand->reset();
+            _deleteContentCommand->bind(":contentId", static_cast<std::uint64_t>(contentId));
+            _deleteContentCommand->execute();
+            _cacheSize -= std::min(_cacheSize, contentSize);
+        }
+    }
+
+    bool PersistentCacheTileDataSource::isStorable(const std::shared_ptr<TileData>& tileData) const {
+        if (tileData->isReplaceWithParent()) {
+            // Missing tiles are stored only if they expire, otherwise the tiles could never appear later
+            return tileData->getMaxAge() > 0;
+        }
+        if (tileData->getMaxAge() == 0 || !tileData->getData()) {
+            return false;
+        }
+        std::size_t tileSize = tileData->getData()->size();
+        return tileSize + EXTRA_TILE_FOOTPRINT <= _capacity; // do not store tiles that would not fit into the cache
+    }
+
     std::shared_ptr<TileData> PersistentCacheTileDataSource::get(long long tileId) {
+        {
+            // Tiles not yet committed are read directly from the queue
+            std::lock_guard<std::mutex> lock(_pendingMutex);
+            auto it = _pendingTiles.find(tileId);
+            if (it != _pendingTiles.end()) {
+                return it->second.tileData;
+            }
+            it = _committingTiles.find(tileId);
+            if (it != _committingTiles.end()) {
+                return it->second.tileData;
+            }
+        }
+
+        if (_walMode) {
+            std::shared_ptr<ReadConnection> readConnection = acquireReadConnection();
+            if (!readConnection) {
+                return std::shared_ptr<TileData>();
+            }
+            std::shared_ptr<TileData> tileData = QueryTile(*readConnection->selectQuery, tileId);
+            releaseReadConnection(readConnection);
+            return tileData;
+        }
+
+        std::lock_guard<std::mutex> databaseLock(_databaseMutex);
         if (!_database) {
             return std::shared_ptr<TileData>();
         }
+        return QueryTile(*_selectQuery, tileId);
+    }
     
-        try {
-            // Get the tile from the database
-            sqlite3pp::query query(*_database, "SELECT compressed, expirationTime FROM persistent_cache WHERE tileId=:tileId");
-            query.bind(":tileId", static_cast<std::uint64_t>(tileId));
-            auto qit = query.begin();
-            if (qit == query.end()) {
-                // No data exists for this tile in the database
-                Log::Error("PersistentCacheTileDataSource::get: Inconsistency, tile data does not exist in the database");
-                return std::shared_ptr<TileData>();
+    std::map<long long, std::shared_ptr<TileData> > PersistentCacheTileDataSource::getMultiple(const std::vector<long long>& tileIds) {
+        std::map<long long, std::shared_ptr<TileData> > tileDatas;
+        std::vector<long long> committedTileIds;
+        {
+            // Tiles not yet committed are read directly from the queue
+            std::lock_guard<std::mutex> lock(_pendingMutex);
+            for (long long tileId : tileIds) {
+                auto it = _pendingTiles.find(tileId);
+                if (it != _pendingTiles.end()) {
+                    tileDatas[tileId] = it->second.tileData;
+                    continue;
+                }
+                it = _committingTiles.find(tileId);
+                if (it != _committingTiles.end()) {
+                    tileDatas[tileId] = it->second.tileData;
+                    continue;
+                }
+                committedTileIds.push_back(tileId);
             }
-            
-            // Construct TileData from the blob returned from the database
-            std::size_t dataSize = (*qit).column_bytes(0);
-            const unsigned char* dataPtr = static_cast<const unsigned char*>((*qit).get<const void*>(0));
-            long long expirationTime = (*qit).get<std::uint64_t>(1);
-            auto data = std::make_shared<BinaryData>(dataPtr, dataSize);
-            query.finish();
-            
-            auto tileData = std::make_shared<TileData>(data);
-            if (expirationTime != 0) {
-                long long maxAge = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::time_point(std::chrono::milliseconds(expirationTime)) - std::chrono::system_clock::now()).count();
-                tileData->setMaxAge(maxAge > 0 ? maxAge : 0);
+        }
+        if (committedTileIds.empty()) {
+            return tileDatas;
+        }
+
+        if (_walMode) {
+            std::shared_ptr<ReadConnection> readConnection = acquireReadConnection();
+            if (!readConnection) {
+                return tileDatas;
             }
-            return tileData;
+            QueryTiles(*readConnection->database, committedTileIds, tileDatas);
+            releaseReadConnection(readConnection);
+            return tileDatas;
         }
-        catch (const std::exception& ex) {
-            Log::Errorf("PersistentCacheTileDataSource::get: Failed to query tile data from the database: %s", ex.what());
-            return std::shared_ptr<TileData>();
+
+        std::lock_guard<std::mutex> databaseLock(_databaseMutex);
+        if (!_database) {
+            return tileDatas;
         }
+        QueryTiles(*_database, committedTileIds, tileDatas);
+        return tileDatas;
     }
     
     void PersistentCacheTileDataSource::store(long long tileId, const std::shared_ptr<TileData>& tileData) {
@@ -273,19 +1038,28 @@ namespace carto {
             expirationTime = std::chrono::duration_cast<std::chrono::milliseconds>((std::chrono::system_clock::now() + std::chrono::milliseconds(tileData->getMaxAge())).time_since_epoch()).count();
         }
 
-        // Add tile to the database
-        try {
-            sqlite3pp::command command(*_database, "INSERT OR REPLACE INTO persistent_cache(tileId, compressed, time, expirationTime) VALUES (:tileId, :compressed, :time, :expirationTime)");
-            command.bind(":tileId", static_cast<std::uint64_t>(tileId));
-            command.bind(":compressed", tileData->getData()->data(), static_cast<unsigned int>(tileData->getData()->size()));
-            command.bind(":time", static_cast<std::uint64_t>(time));
-            command.bind(":expirationTime", static_cast<std::uint64_t>(expirationTime));
-            command.execute();
-            command.finish();
+        // Add tile to the write queue, the writer thread will commit it
+        std::lock_guard<std::mutex> lock(_pendingMutex);
+        PendingTile& pendingTile = _pendingTiles[tileId];
+        pendingTile.tileData = tileData;
+        pendingTile.time = time;
+        pendingTile.expirationTime = expirationTime;
+        checkPendingTiles();
+    }
+
+    void PersistentCacheTileDataSource::touch(long long tileId) {
+        if (!_database) {
+            return;
         }
-        catch (const std::exception& ex) {
-            Log::Errorf("PersistentCacheTileDataSource::store: Failed to store tile data in the database: %s", ex.what());
+
+        long long time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+        std::lock_guard<std::mutex> lock(_pendingMutex);
+        if (_pendingTiles.find(tileId) != _pendingTiles.end()) {
+            return; // queued tiles are stored with the current time
         }
+        _pendingAccessTimes[tileId] = time;
+        checkPendingTiles();
     }
 
     void PersistentCacheTileDataSource::remove(long long tileId) {
@@ -293,29 +1067,146 @@ namespace carto {
             return;
         }
         
+        std::lock_guard<std::mutex> lock(_pendingMutex);
+        PendingTile& pendingTile = _pendingTiles[tileId];
+        pendingTile.tileData.reset();
+        pendingTile.time = 0;
+        pendingTile.expirationTime = 0;
+        checkPendingTiles();
+    }
+
+    std::shared_ptr<TileData> PersistentCacheTileDataSource::QueryTile(sqlite3pp::query& query, long long tileId) {
         try {
-            sqlite3pp::command command(*_database, "DELETE FROM persistent_cache WHERE tileId=:tileId");
-            command.bind(":tileId", static_cast<std::uint64_t>(tileId));
-            command.execute();
-            command.finish();
+            // Get the tile from the database
+            query.reset();
+            query.bind(":tileId", static_cast<std::uint64_t>(tileId));
+            auto qit = query.begin();
+            if (qit == query.end()) {
+                // No data exists for this tile in the database
+                query.reset();
+                return std::shared_ptr<TileData>();
+            }
+            
+            // Construct TileData from the blob returned from the database
+            std::size_t dataSize = (*qit).column_bytes(0);
+            const unsigned char* dataPtr = static_cast<const unsigned char*>((*qit).get<const void*>(0));
+            long long expirationTime = (*qit).get<std::uint64_t>(1);
+            std::shared_ptr<TileData> tileData = CreateTileData(dataPtr, dataSize, expirationTime, (*qit).get<const char*>(2), (*qit).get<const char*>(3), (*qit).get<int>(4) != 0, (*qit).get<int>(5));
+            query.reset();
+            return tileData;
         }
         catch (const std::exception& ex) {
-            Log::Errorf("PersistentCacheTileDataSource::remove: Failed to remove tile from the database: %s", ex.what());
+            Log::Errorf("PersistentCacheTileDataSource::QueryTile: Failed to query tile data from the database: %s", ex.what());
+            query.reset();
+            return std::shared_ptr<TileData>();
         }
     }
-    
-    std::shared_ptr<long long> PersistentCacheTileDataSource::createTileId(long long tileId) {
-        std::weak_ptr<PersistentCacheTileDataSource> cacheWeak(std::static_pointer_cast<PersistentCacheTileDataSource>(shared_from_this()));
-        auto tileIdDeleter = [cacheWeak](long long* tileIdPtr) {
-            std::unique_ptr<long long> tileId(tileIdPtr);
-            if (auto cache = cacheWeak.lock()) {
-                std::lock_guard<std::recursive_mutex> lock(cache->_mutex); // probably not needed, as this gets called from already locked state
-                cache->remove(*tileId);
+
+    void PersistentCacheTileDataSource::QueryTiles(sqlite3pp::database& database, const std::vector<long long>& tileIds, std::map<long long, std::shared_ptr<TileData> >& tileDatas) {
+        try {
+            // Get the tiles from the database in chunks, using single query per chunk
+            for (std::size_t offset = 0; offset < tileIds.size(); offset += MAX_BATCH_TILES) {
+                std::size_t count = std::min(tileIds.size() - offset, static_cast<std::size_t>(MAX_BATCH_TILES));
+
+                std::string sql = "SELECT t.tileId, IFNULL(c.compressed, t.compressed), t.expirationTime, t.etag, t.lastModified, t.contentId=0, IFNULL(c.codec, 0) FROM persistent_cache t LEFT JOIN persistent_cache_content c ON c.contentId=t.contentId WHERE t.tileId IN (";
+                for (std::size_t i = 0; i < count; i++) {
+                    sql += (i > 0 ? ",?" : "?");
+                }
+                sql += ")";
+
+                sqlite3pp::query query(database, sql.c_str());
+                for (std::size_t i = 0; i < count; i++) {
+                    query.bind(static_cast<int>(i + 1), static_cast<std::uint64_t>(tileIds[offset + i]));
+                }
+                for (auto qit = query.begin(); qit != query.end(); qit++) {
+                    long long tileId = (*qit).get<std::uint64_t>(0);
+                    std::size_t dataSize = (*qit).column_bytes(1);
+                    const unsigned char* dataPtr = static_cast<const unsigned char*>((*qit).get<const void*>(1));
+                    long long expirationTime = (*qit).get<std::uint64_t>(2);
+                    tileDatas[tileId] = CreateTileData(dataPtr, dataSize, expirationTime, (*qit).get<const char*>(3), (*qit).get<const char*>(4), (*qit).get<int>(5) != 0, (*qit).get<int>(6));
+                }
+                query.finish();
             }
-        };
-        return std::shared_ptr<long long>(new long long(tileId), tileIdDeleter);
+        }
+        catch (const std::exception& ex) {
+            Log::Errorf("PersistentCacheTileDataSource::QueryTiles: Failed to query tile data from the database: %s", ex.what());
+        }
     }
 
+    std::shared_ptr<TileData> PersistentCacheTileDataSource::CreateTileData(const unsigned char* dataPtr, std::size_t dataSize, long long expirationTime, const char* etag, const char* lastModified, bool missing, int codec) {
+        if (missing) {
+            // Tiles missing from the original data source are stored without content and replaced with parent tiles
+            auto tileData = std::make_shared<TileData>(std::shared_ptr<BinaryData>());
+            tileData->setReplaceWithParent(true);
+            long long maxAge = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::time_point(std::chrono::milliseconds(expirationTime)) - std::chrono::system_clock::now()).count();
+            tileData->setMaxAge(maxAge > 0 ? maxAge : 0);
+            return tileData;
+        }
+
+        std::shared_ptr<BinaryData> data;
+        if (codec == CONTENT_CODEC_DEFLATE) {
+            std::vector<unsigned char> uncompressedData;
+            if (!InflatePool::GetInstance().inflateRaw(dataPtr, dataSize, nullptr, 0, uncompressedData)) {
+                Log::Error("PersistentCacheTileDataSource::CreateTileData: Failed to decompress tile data");
+                return std::shared_ptr<TileData>();
+            }
+            data = std::make_shared<BinaryData>(std::move(uncompressedData));
+        } else {
+            data = std::make_shared<BinaryData>(dataPtr, dataSize);
+        }
+
+        auto tileData = std::make_shared<TileData>(data);
+        if (expirationTime != 0) {
+            long long maxAge = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::time_point(std::chrono::milliseconds(expirationTime)) - std::chrono::system_clock::now()).count();
+            tileData->setMaxAge(maxAge > 0 ? maxAge : 0);
+        }
+        tileData->setETag(etag ? etag : "");
+        tileData->setLastModified(lastModified ? lastModified : "");
+        return tileData;
+    }
+
+    bool PersistentCacheTileDataSource::CompressContent(const BinaryData& data, std::vector<unsigned char>& compressedData) {
+        if (data.empty()) {
+            return false;
+        }
+
+        z_stream stream = z_stream();
+        if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return false;
+        }
+        compressedData.resize(deflateBound(&stream, static_cast<uLong>(data.size())));
+        stream.next_in = const_cast<Bytef*>(data.data());
+        stream.avail_in = static_cast<uInt>(data.size());
+        stream.next_out = compressedData.data();
+        stream.avail_out = static_cast<uInt>(compressedData.size());
+        int result = deflate(&stream, Z_FINISH);
+        deflateEnd(&stream);
+        if (result != Z_STREAM_END) {
+            return false;
+        }
+        compressedData.resize(stream.total_out);
+        return compressedData.size() * 100 <= data.size() * MIN_COMPRESSION_PERCENTAGE;
+    }
+
+    bool PersistentCacheTileDataSource::HasValidators(const std::shared_ptr<TileData>& tileData) {
+        if (!tileData) {
+            return false;
+        }
+        return !tileData->getETag().empty() || !tileData->getLastModified().empty();
+    }
+
+    std::string PersistentCacheTileDataSource::CalculateContentHash(const std::shared_ptr<BinaryData>& data) {
+        CryptoPP::SHA1 hash;
+        unsigned char digest[CryptoPP::SHA1::DIGESTSIZE];
+        hash.CalculateDigest(digest, data->data(), data->size());
+        std::string sha1;
+        CryptoPP::HexEncoder encoder;
+        encoder.Attach(new CryptoPP::StringSink(sha1));
+        encoder.Put(digest, sizeof(digest));
+        encoder.MessageEnd();
+        return sha1;
+    }
+    
     PersistentCacheTileDataSource::DownloadTask::DownloadTask(const std::shared_ptr<PersistentCacheTileDataSource>& dataSource, const MapBounds& mapBounds, int minZoom, int maxZoom, const std::shared_ptr<TileDownloadListener>& listener) :
         _dataSource(dataSource),
         _mapBounds(mapBounds),
@@ -356,39 +1247,84 @@ namespace carto {
             _downloadListener->onDownloadStarting(static_cast<int>(tileCount));
         }
 
+        // Tiles are loaded in chunks with multiple loads in flight. Valid cached tiles are returned by loadTile without network requests
+        // and new tiles are committed in batches by the writer thread. The concurrency is increased while the throughput grows
+        // and halved when requests fail, so that a slow or overloaded server is not flooded with requests.
+        unsigned int concurrency = 1;
+        double prevThroughput = 0;
+        std::vector<MapTile> chunkTiles;
         std::uint64_t tileIndex = 0;
-        for (int zoom = minZoom; zoom <= maxZoom; zoom++) {
-            MapTile mapTile1 = TileUtils::CalculateMapTile(_mapBounds.getMin(), zoom, projection);
-            MapTile mapTile2 = TileUtils::CalculateMapTile(_mapBounds.getMax(), zoom, projection);
-            for (int y = std::min(mapTile1.getY(), mapTile2.getY()); y <= std::max(mapTile1.getY(), mapTile2.getY()); y++) {
+        auto loadChunk = [&]() -> bool {
+            auto dataSource = _dataSource.lock();
+            if (!dataSource) {
+                return false;
+            }
+
+            std::vector<MapTile> flippedTiles;
+            flippedTiles.reserve(chunkTiles.size());
+            for (const MapTile& mapTile : chunkTiles) {
+                flippedTiles.push_back(mapTile.getFlipped());
+            }
+
+            auto startTime = std::chrono::steady_clock::now();
+            std::vector<std::shared_ptr<TileData> > tileDatas = ConcurrentTileLoader::LoadTiles(flippedTiles, [this, &dataSource](const MapTile& mapTile) -> std::shared_ptr<TileData> {
                 if (isCanceled()) {
-                    break;
+                    return std::shared_ptr<TileData>();
                 }
+                return dataSource->loadTile(mapTile);
+            }, static_cast<int>(concurrency));
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+            if (isCanceled()) {
+                return false;
+            }
 
-                for (int x = std::min(mapTile1.getX(), mapTile2.getX()); x <= std::max(mapTile1.getX(), mapTile2.getX()); x++) {
-                    if (isCanceled()) {
-                        break;
-                    }
-
+            std::size_t failedCount = 0;
+            for (std::size_t i = 0; i < chunkTiles.size(); i++) {
+                if (!tileDatas[i]) {
+                    failedCount++;
                     if (_downloadListener) {
-                        _downloadListener->onDownloadProgress(static_cast<float>(100.0 * tileIndex / tileCount));
+                        _downloadListener->onDownloadFailed(chunkTiles[i]);
                     }
+                }
+            }
+            tileIndex += chunkTiles.size();
+            if (_downloadListener) {
+                _downloadListener->onDownloadProgress(static_cast<float>(100.0 * tileIndex / tileCount));
+            }
 
-                    MapTile mapTile(x, y, zoom, 0);
-                    std::shared_ptr<TileData> tileData;
-                    if (auto dataSource = _dataSource.lock()) {
-                        tileData = dataSource->loadTile(mapTile.getFlipped());
-                    } else {
-                        return;
-                    }
-                    tileIndex++;
+            unsigned int maxConcurrency = std::max(1u, dataSource->_maxDownloadConcurrency.load());
+            double throughput = static_cast<double>(chunkTiles.size() - failedCount) * 1000.0 / std::max(1LL, static_cast<long long>(duration));
+            if (failedCount > 0) {
+                concurrency = std::max(1u, concurrency / 2);
+            } else if (throughput >= prevThroughput) {
+                concurrency = concurrency + 1;
+            }
+            concurrency = std::min(concurrency, maxConcurrency);
+            prevThroughput = throughput;
+
+            chunkTiles.clear();
+            return true;
+        };
 
-                    if (!tileData && _downloadListener) {
-                        _downloadListener->onDownloadFailed(mapTile);
+        for (int zoom = minZoom; zoom <= maxZoom; zoom++) {
+            MapTile mapTile1 = TileUtils::CalculateMapTile(_mapBounds.getMin(), zoom, projection);
+            MapTile mapTile2 = TileUtils::CalculateMapTile(_mapBounds.getMax(), zoom, projection);
+            for (int y = std::min(mapTile1.getY(), mapTile2.getY()); y <= std::max(mapTile1.getY(), mapTile2.getY()); y++) {
+                for (int x = std::min(mapTile1.getX(), mapTile2.getX()); x <= std::max(mapTile1.getX(), mapTile2.getX()); x++) {
+                    chunkTiles.emplace_back(x, y, zoom, 0);
+                    if (chunkTiles.size() >= concurrency * DOWNLOAD_CHUNK_TILES_PER_LOAD) {
+                        if (!loadChunk()) {
+                            return;
+                        }
                     }
                 }
             }
         }
+        if (!chunkTiles.empty()) {
+            if (!loadChunk()) {
+                return;
+            }
+        }
 
         if (tileIndex == tileCount && _downloadListener) {
             _downloadListener->onDownloadProgress(100.0f);
@@ -400,5 +1336,15 @@ namespace carto {
 
     const unsigned int PersistentCacheTileDataSource::DEFAULT_CAPACITY = 50 * 1024 * 1024;
     const unsigned int PersistentCacheTileDataSource::EXTRA_TILE_FOOTPRINT = 1024;
+    const unsigned int PersistentCacheTileDataSource::WRITE_BATCH_SIZE = 32;
+    const unsigned int PersistentCacheTileDataSource::DEFAULT_WRITE_QUEUE_SIZE = 256;
+    const unsigned int PersistentCacheTileDataSource::DEFAULT_WRITE_DELAY = 1000;
+    const unsigned int PersistentCacheTileDataSource::MAX_READ_CONNECTIONS = 4;
+    const unsigned int PersistentCacheTileDataSource::MAX_BATCH_TILES = 256;
+    const unsigned int PersistentCacheTileDataSource::MIN_COMPRESSION_PERCENTAGE = 90;
+    const int PersistentCacheTileDataSource::CONTENT_CODEC_NONE = 0;
+    const int PersistentCacheTileDataSource::CONTENT_CODEC_DEFLATE = 1;
+    const unsigned int PersistentCacheTileDataSource::DEFAULT_MAX_DOWNLOAD_CONCURRENCY = 8;
+    const unsigned int PersistentCacheTileDataSource::DOWNLOAD_CHUNK_TILES_PER_LOAD = 4;
 
 }
@@ -12,15 +12,24 @@
 #include "components/DirectorPtr.h"
 #include "datasources/CacheTileDataSource.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
-
-#include <stdext/timed_lru_cache.h>
+#include <thread>
+#include <vector>
 
 namespace sqlite3pp {
     class database;
+    class query;
+    class command;
 }
 
 namespace carto {
+    class BinaryData;
     class TileDownloadListener;
 
     /**
@@ -28,9 +37,22 @@ namespace carto {
      * and caches them in an offline sqlite database. Tiles will remain in the database
      * even after the application is closed.
      * The database contains table "persistent_cache" with the following fields:
-     * "tileId" (tile id), "compressed" (compressed tile image),
-     * "time" (the time the tile was cached in milliseconds from epoch).
+     * "tileId" (tile id), "contentId" (reference to the tile content),
+     * "time" (the time the tile was cached or last accessed in milliseconds from epoch),
+     * "expirationTime" (the expiration time of the tile in milliseconds from epoch, 0 if the tile does not expire),
+     * "etag" and "lastModified" (validators used for revalidating expired tiles with the original data source).
+     * Tile contents are stored in table "persistent_cache_content" with fields "contentId", "hash" (SHA1 of the content),
+     * "compressed" (compressed tile image), "refCount" (number of tiles using the content) and "codec"
+     * (0 if the content is stored as delivered, 1 if it is compressed with raw deflate), so identical tiles
+     * (like empty ocean tiles) are stored only once. Tiles missing from the original data source are stored without content
+     * (with "contentId" 0) until they expire, so they are replaced with parent tiles without new requests.
+     * Tiles stored by older SDK versions keep their data in the "compressed" field of "persistent_cache".
+     * The total size of the cached tiles and unique contents is kept in table "persistent_cache_meta", so the cache can be opened
+     * without scanning all the tiles. Least recently used tiles are evicted when the cache capacity is exceeded.
      * Default cache capacity is 50MB.
+     * If supported by the platform, the database is used in WAL journaling mode,
+     * which allows tiles to be read concurrently while new tiles are written.
+     * New tiles are written in batches by a separate writer thread, so loading threads are not blocked by disk writes.
      */
     class PersistentCacheTileDataSource : public CacheTileDataSource {
     public:
@@ -57,6 +79,58 @@ namespace carto {
          */
         void setCacheOnlyMode(bool enabled);
 
+        /**
+         * Returns the maximum number of tiles waiting to be written to the cache database.
+         * @return The maximum number of tiles in the write queue.
+         */
+        int getWriteQueueSize() const;
+        /**
+         * Sets the maximum number of tiles waiting to be written to the cache database.
+         * If the write queue is full, loading threads will wait until the writer thread has stored the queued tiles.
+         * The default is 256.
+         * @param queueSize The maximum number of tiles in the write queue. Must be at least 1.
+         */
+        void setWriteQueueSize(int queueSize);
+
+        /**
+         * Returns the maximum time the queued tiles are kept in memory before they are written to the cache database.
+         * @return The maximum write delay in milliseconds.
+         */
+        int getWriteDelay() const;
+        /**
+         * Sets the maximum time the queued tiles are kept in memory before they are written to the cache database.
+         * Longer delays allow writing more tiles in a single batch. The default is 1000 milliseconds.
+         * @param delay The maximum write delay in milliseconds.
+         */
+        void setWriteDelay(int delay);
+
+        /**
+         * Returns the state of tile content compression.
+         * @return True when new tile contents are compressed, false otherwise.
+         */
+        bool isContentCompression() const;
+        /**
+         * Enables or disables compression of new tile contents stored in the cache.
+         * If enabled, the writer thread compresses tile contents that can be compressed well (like uncompressed vector tiles),
+         * already compressed images are stored as is. The codec is stored with each content, so tiles stored with
+         * different settings can be read regardless of the current setting. The default is disabled.
+         * @param enabled True when new tile contents should be compressed, false otherwise.
+         */
+        void setContentCompression(bool enabled);
+
+        /**
+         * Returns the maximum number of tiles loaded concurrently when downloading an area.
+         * @return The maximum number of concurrent tile loads.
+         */
+        int getMaxDownloadConcurrency() const;
+        /**
+         * Sets the maximum number of tiles loaded concurrently when downloading an area.
+         * The actual number of requests in flight is adjusted between 1 and this value
+         * based on the measured throughput and failed requests. The default is 8.
+         * @param concurrency The maximum number of concurrent tile loads. Must be at least 1.
+         */
+        void setMaxDownloadConcurrency(int concurrency);
+
         /**
          * Starts downloading the specified area. The area will be stored in the cache.
          * Note that is the area is too big or cache is already filled, subsequent downloaded tiles
@@ -79,12 +153,16 @@ namespace carto {
         bool isOpen() const;
 
         /**
-         * Closes the cache database. The datasource will still work afterwards,
-         * but all requests will be directed to the original datasource.
+         * Closes the cache database. All queued tiles are written to the database before closing.
+         * The datasource will still work afterwards, but all requests will be directed to the original datasource.
          */
         void close();
 
         virtual std::shared_ptr<TileData> loadTile(const MapTile& mapTile);
+
+        virtual std::vector<std::shared_ptr<TileData> > loadTiles(const std::vector<MapTile>& mapTiles);
+
+        virtual bool isBatchLoadingSupported() const;
         
         virtual void clear();
         
@@ -92,6 +170,13 @@ namespace carto {
 
         virtual void setCapacity(std::size_t capacityInBytes);
 
+        /**
+         * Returns the usage statistics of the cache. The size and the entry count include only the tiles
+         * already written to the database.
+         * @return The cache statistics.
+         */
+        virtual CacheStatistics getCacheStatistics() const;
+
     protected:
         class DownloadTask : public CancelableTask {
         public:
@@ -107,28 +192,109 @@ namespace carto {
             DirectorPtr<TileDownloadListener> _downloadListener;
         };
 
+        struct PendingTile {
+            std::shared_ptr<TileData> tileData; // null if the tile should be deleted
+            long long time;
+            long long expirationTime;
+        };
+
+        struct ReadConnection;
+
+        virtual void removeCachedTiles(const MapBounds& bounds, int minZoom, int maxZoom);
+
         static const unsigned int DEFAULT_CAPACITY;
         static const unsigned int EXTRA_TILE_FOOTPRINT;
+        static const unsigned int WRITE_BATCH_SIZE;
+        static const unsigned int DEFAULT_WRITE_QUEUE_SIZE;
+        static const unsigned int DEFAULT_WRITE_DELAY;
+        static const unsigned int MAX_READ_CONNECTIONS;
+        static const unsigned int MAX_BATCH_TILES;
+        static const unsigned int MIN_COMPRESSION_PERCENTAGE;
+        static const int CONTENT_CODEC_NONE;
+        static const int CONTENT_CODEC_DEFLATE;
+        static const unsigned int DEFAULT_MAX_DOWNLOAD_CONCURRENCY;
+        static const unsigned int DOWNLOAD_CHUNK_TILES_PER_LOAD;
 
         void openDatabase(const std::string& databasePath);
         void closeDatabase();
-        void loadTileInfo();
+        void loadCacheSize();
+        void storeCacheSize();
+
+        std::shared_ptr<ReadConnection> acquireReadConnection();
+        void releaseReadConnection(const std::shared_ptr<ReadConnection>& readConnection);
+        void closeReadConnections();
+
+        void startWriter();
+        void stopWriter();
+        void runWriter();
+
+        void checkPendingTiles();
+        void waitPendingTiles();
+        void commitPendingTiles();
+        void evictTiles();
+        void releaseTile(long long tileId);
+        long long retainContent(const std::shared_ptr<BinaryData>& data);
+        void releaseContent(long long contentId);
 
         void downloadArea(const MapBounds& mapBounds, int minZoom, int maxZoom, const std::shared_ptr<TileDownloadListener>& listener);
         
+        bool isStorable(const std::shared_ptr<TileData>& tileData) const;
         std::shared_ptr<TileData> get(long long tileId);
+        std::map<long long, std::shared_ptr<TileData> > getMultiple(const std::vector<long long>& tileIds);
         void store(long long tileId, const std::shared_ptr<TileData>& tileData);
+        void touch(long long tileId);
         void remove(long long tileId);
 
-        std::shared_ptr<long long> createTileId(long long tileId);
+        static std::shared_ptr<TileData> QueryTile(sqlite3pp::query& query, long long tileId);
+        static void QueryTiles(sqlite3pp::database& database, const std::vector<long long>& tileIds, std::map<long long, std::shared_ptr<TileData> >& tileDatas);
+        static std::shared_ptr<TileData> CreateTileData(const unsigned char* dataPtr, std::size_t dataSize, long long expirationTime, const char* etag, const char* lastModified, bool missing, int codec);
+        static bool CompressContent(const BinaryData& data, std::vector<unsigned char>& compressedData);
+        static bool HasValidators(const std::shared_ptr<TileData>& tileData);
+        static std::string CalculateContentHash(const std::shared_ptr<BinaryData>& data);
         
         std::unique_ptr<sqlite3pp::database> _database;
+        std::unique_ptr<sqlite3pp::query> _selectQuery;
+        std::unique_ptr<sqlite3pp::query> _sizeQuery;
+        std::unique_ptr<sqlite3pp::command> _insertCommand;
+        std::unique_ptr<sqlite3pp::command> _deleteCommand;
+        std::unique_ptr<sqlite3pp::command> _touchCommand;
+        std::unique_ptr<sqlite3pp::query> _findContentQuery;
+        std::unique_ptr<sqlite3pp::query> _contentQuery;
+        std::unique_ptr<sqlite3pp::command> _insertContentCommand;
+        std::unique_ptr<sqlite3pp::command> _updateContentCommand;
+        std::unique_ptr<sqlite3pp::command> _deleteContentCommand;
+        std::string _databasePath;
+        bool _walMode;
+
+        std::atomic<std::size_t> _capacity;
+        std::size_t _cacheSize; // total size of committed unique contents, including EXTRA_TILE_FOOTPRINT per tile
+        mutable std::mutex _databaseMutex; // guards the write connection and _cacheSize
+        std::atomic<long long> _evictionCount;
+
+        std::map<long long, PendingTile> _pendingTiles;
+        std::map<long long, PendingTile> _committingTiles; // tiles currently being written by commitPendingTiles
+        std::map<long long, long long> _pendingAccessTimes;
+        std::chrono::steady_clock::time_point _pendingTime;
+        unsigned int _writeQueueSize;
+        unsigned int _writeDelay;
+        bool _writerStopped;
+        std::shared_ptr<std::thread> _writerThread;
+        std::condition_variable _pendingCondition;
+        std::condition_variable _pendingSpaceCondition;
+        mutable std::mutex _pendingMutex;
+
+        std::vector<std::shared_ptr<ReadConnection> > _readConnections; // idle read connections
+        unsigned int _readConnectionCount;
+        bool _readConnectionsOpen;
+        std::condition_variable _readConnectionsCondition;
+        std::mutex _readConnectionsMutex;
         
         bool _cacheOnlyMode;
+        std::atomic<bool> _contentCompression;
 
         std::shared_ptr<CancelableThreadPool> _downloadThreadPool;
+        std::atomic<unsigned int> _maxDownloadConcurrency;
         
-        cache::timed_lru_cache<long long, std::shared_ptr<long long> > _cache;
         mutable std::recursive_mutex _mutex;
     };
 
@@ -0,0 +1,230 @@
+#ifdef _CARTO_OFFLINE_SUPPORT
+
+#include "RecordingTileDataSource.h"
+#include "core/BinaryData.h"
+#include "core/MapTile.h"
+#include "components/Exceptions.h"
+#include "datasources/components/TileData.h"
+#include "utils/Log.h"
+
+#include <map>
+
+#include <boost/lexical_cast.hpp>
+
+#include <sqlite3pp.h>
+
+#include <sha.h>
+#include <filters.h>
+#include <hex.h>
+
+namespace carto {
+
+    RecordingTileDataSource::RecordingTileDataSource(const std::shared_ptr<TileDataSource>& dataSource, const std::string& path) :
+        TileDataSource(),
+        _dataSource(dataSource),
+        _path(path),
+        _recordingStartTime(std::chrono::steady_clock::now()),
+        _db(),
+        _transaction(),
+        _pendingRequestCount(0),
+        _recordedRequestCount(0),
+        _blobIds(),
+        _dataSourceListener(),
+        _mutex()
+    {
+        if (!dataSource) {
+            throw NullArgumentException("Null dataSource");
+        }
+
+        try {
+            _db.reset(new sqlite3pp::database(path.c_str()));
+            InitializeDatabase(*_db);
+
+            // The replaying data source reports the same zoom range and extent as the recorded one
+            MapBounds dataExtent = _dataSource->getDataExtent();
+            std::map<std::string, std::string> metaData;
+            metaData["minzoom"] = boost::lexical_cast<std::string>(_dataSource->getMinZoom());
+            metaData["maxzoom"] = boost::lexical_cast<std::string>(_dataSource->getMaxZoom());
+            metaData["bounds"] = boost::lexical_cast<std::string>(dataExtent.getMin().getX()) + "," + boost::lexical_cast<std::string>(dataExtent.getMin().getY()) + "," + boost::lexical_cast<std::string>(dataExtent.getMax().getX()) + "," + boost::lexical_cast<std::string>(dataExtent.getMax().getY());
+            sqlite3pp::command insertMetaDataCommand(*_db, "INSERT INTO metadata(name, value) VALUES(:name, :value)");
+            for (auto it = metaData.begin(); it != metaData.end(); it++) {
+                insertMetaDataCommand.reset();
+                insertMetaDataCommand.bind(":name", it->first.c_str());
+                insertMetaDataCommand.bind(":value", it->second.c_str());
+                insertMetaDataCommand.execute();
+            }
+        }
+        catch (const std::exception& ex) {
+            throw FileException(std::string("Failed to create recording database: ") + ex.what(), path);
+        }
+
+        _dataSourceListener = std::make_shared<DataSourceListener>(*this);
+        _dataSource->registerOnChangeListener(_dataSourceListener);
+    }
+    
+    RecordingTileDataSource::~RecordingTileDataSource() {
+        _dataSource->unregisterOnChangeListener(_dataSourceListener);
+        _dataSourceListener.reset();
+
+        flush();
+    }
+
+    std::shared_ptr<TileDataSource> RecordingTileDataSource::getDataSource() const {
+        return _dataSource.get();
+    }
+
+    const std::string& RecordingTileDataSource::getPath() const {
+        return _path;
+    }
+
+    int RecordingTileDataSource::getRecordedRequestCount() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _recordedRequestCount;
+    }
+
+    void RecordingTileDataSource::flush() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_transaction) {
+            try {
+                _transaction->commit();
+            }
+            catch (const std::exception& ex) {
+                Log::Errorf("RecordingTileDataSource::flush: Failed to commit recorded requests: %s", ex.what());
+            }
+            _transaction.reset();
+            _pendingRequestCount = 0;
+        }
+    }
+
+    int RecordingTileDataSource::getMinZoom() const {
+        return _dataSource->getMinZoom();
+    }
+
+    int RecordingTileDataSource::getMaxZoom() const {
+        return _dataSource->getMaxZoom();
+    }
+
+    MapBounds RecordingTileDataSource::getDataExtent() const {
+        return _dataSource->getDataExtent();
+    }
+    
+    std::shared_ptr<TileData> RecordingTileDataSource::loadTile(const MapTile& mapTile) {
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        std::shared_ptr<TileData> tileData;
+        try {
+            tileData = _dataSource->loadTile(mapTile);
+        }
+        catch (...) {
+            // Failed requests are replayed as null responses
+            recordRequest(mapTile, startTime, std::chrono::steady_clock::now(), std::shared_ptr<TileData>());
+            throw;
+        }
+        recordRequest(mapTile, startTime, std::chrono::steady_clock::now(), tileData);
+        return tileData;
+    }
+
+    void RecordingTileDataSource::InitializeDatabase(sqlite3pp::database& db) {
+        db.execute("PRAGMA synchronous=NORMAL");
+        db.execute("DROP TABLE IF EXISTS metadata");
+        db.execute("DROP TABLE IF EXISTS requests");
+        db.execute("DROP TABLE IF EXISTS blobs");
+        db.execute("CREATE TABLE metadata(name TEXT NOT NULL PRIMARY KEY, value TEXT)");
+        db.execute("CREATE TABLE requests(id INTEGER NOT NULL PRIMARY KEY, zoom INTEGER NOT NULL, x INTEGER NOT NULL, y INTEGER NOT NULL, frame_nr INTEGER NOT NULL, start_time REAL NOT NULL, duration REAL NOT NULL, result INTEGER NOT NULL, blob_id INTEGER, max_age INTEGER NOT NULL, cache_source TEXT)");
+        db.execute("CREATE TABLE blobs(id INTEGER NOT NULL PRIMARY KEY, hash TEXT NOT NULL UNIQUE, data BLOB)");
+    }
+
+    std::string RecordingTileDataSource::CalculateBlobHash(const BinaryData& data) {
+        CryptoPP::SHA1 hash;
+        unsigned char digest[CryptoPP::SHA1::DIGESTSIZE];
+        hash.CalculateDigest(digest, data.data(), data.size());
+        std::string sha1;
+        CryptoPP::HexEncoder encoder;
+        encoder.Attach(new CryptoPP::StringSink(sha1));
+        encoder.Put(digest, sizeof(digest));
+        encoder.MessageEnd();
+        return sha1;
+    }
+
+    void RecordingTileDataSource::recordRequest(const MapTile& mapTile, const std::chrono::steady_clock::time_point& startTime, const std::chrono::steady_clock::time_point& endTime, const std::shared_ptr<TileData>& tileData) {
+        typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+        int result = RESULT_NULL;
+        std::shared_ptr<BinaryData> data;
+        if (tileData) {
+            result = tileData->isReplaceWithParent() ? RESULT_REPLACE_WITH_PARENT : RESULT_DATA;
+            data = tileData->getData();
+        }
+
+        // Hash outside of the lock, tiles are loaded concurrently
+        std::string blobHash;
+        if (data) {
+            blobHash = CalculateBlobHash(*data);
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        try {
+            if (!_transaction) {
+                _transaction.reset(new sqlite3pp::transaction(*_db));
+            }
+
+            long long blobId = -1;
+            if (data) {
+                auto it = _blobIds.find(blobHash);
+                if (it != _blobIds.end()) {
+                    blobId = it->second;
+                } else {
+                    sqlite3pp::command insertBlobCommand(*_db, "INSERT INTO blobs(hash, data) VALUES(:hash, :data)");
+                    insertBlobCommand.bind(":hash", blobHash.c_str());
+                    insertBlobCommand.bind(":data", data->data(), static_cast<unsigned int>(data->size()));
+                    insertBlobCommand.execute();
+                    blobId = _db->last_insert_rowid();
+                    _blobIds[blobHash] = blobId;
+                }
+            }
+
+            sqlite3pp::command insertRequestCommand(*_db, "INSERT INTO requests(zoom, x, y, frame_nr, start_time, duration, result, blob_id, max_age, cache_source) VALUES(:zoom, :x, :y, :frameNr, :startTime, :duration, :result, :blobId, :maxAge, :cacheSource)");
+            insertRequestCommand.bind(":zoom", mapTile.getZoom());
+            insertRequestCommand.bind(":x", mapTile.getX());
+            insertRequestCommand.bind(":y", mapTile.getY());
+            insertRequestCommand.bind(":frameNr", mapTile.getFrameNr());
+            insertRequestCommand.bind(":startTime", std::chrono::duration_cast<Milliseconds>(startTime - _recordingStartTime).count());
+            insertRequestCommand.bind(":duration", std::chrono::duration_cast<Milliseconds>(endTime - startTime).count());
+            insertRequestCommand.bind(":result", result);
+            if (blobId >= 0) {
+                insertRequestCommand.bind(":blobId", blobId); // unbound parameters are stored as NULL
+            }
+            insertRequestCommand.bind(":maxAge", tileData ? tileData->getMaxAge() : -1LL);
+            std::string cacheSource = tileData ? tileData->getCacheSource() : std::string();
+            insertRequestCommand.bind(":cacheSource", cacheSource.c_str());
+            insertRequestCommand.execute();
+
+            _recordedRequestCount++;
+            if (++_pendingRequestCount >= WRITE_BATCH_SIZE) {
+                _transaction->commit();
+                _transaction.reset();
+                _pendingRequestCount = 0;
+            }
+        }
+        catch (const std::exception& ex) {
+            Log::Errorf("RecordingTileDataSource::recordRequest: Failed to record request: %s", ex.what());
+        }
+    }
+
+    RecordingTileDataSource::DataSourceListener::DataSourceListener(RecordingTileDataSource& recordingDataSource) :
+        _recordingDataSource(recordingDataSource)
+    {
+    }
+    
+    void RecordingTileDataSource::DataSourceListener::onTilesChanged(bool removeTiles) {
+        _recordingDataSource.notifyTilesChanged(removeTiles);
+    }
+
+    void RecordingTileDataSource::DataSourceListener::onTilesChanged(const MapBounds& bounds, int minZoom, int maxZoom, bool removeTiles) {
+        _recordingDataSource.notifyTilesChanged(bounds, minZoom, maxZoom, removeTiles);
+    }
+
+    const unsigned int RecordingTileDataSource::WRITE_BATCH_SIZE = 256;
+    
+}
+
+#endif
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_RECORDINGTILEDATASOURCE_H_
+#define _CARTO_RECORDINGTILEDATASOURCE_H_
+
+#ifdef _CARTO_OFFLINE_SUPPORT
+
+#include "datasources/TileDataSource.h"
+#include "components/DirectorPtr.h"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace sqlite3pp {
+    class database;
+    class transaction;
+}
+
+namespace carto {
+    class BinaryData;
+
+    /**
+     * A tile data source that passes all requests to another data source and records the requests,
+     * responses and timings to a Sqlite database file. The recording can be replayed later using ReplayTileDataSource,
+     * for example to benchmark tile loading and rendering deterministically with the headless renderer.
+     * Requests are recorded in the order they complete, identical tile payloads are stored only once.
+     */
+    class RecordingTileDataSource : public TileDataSource {
+    public:
+        /**
+         * Constructs a RecordingTileDataSource object.
+         * If the output file already exists, the previous recording in it is replaced.
+         * @param dataSource The data source to pass the requests to.
+         * @param path The path to the output Sqlite database file.
+         * @throws std::runtime_error If the database file could not be created.
+         */
+        RecordingTileDataSource(const std::shared_ptr<TileDataSource>& dataSource, const std::string& path);
+        virtual ~RecordingTileDataSource();
+
+        /**
+         * Returns the data source the requests are passed to.
+         * @return The recorded data source.
+         */
+        std::shared_ptr<TileDataSource> getDataSource() const;
+        /**
+         * Returns the path of the output database file.
+         * @return The path of the output database file.
+         */
+        const std::string& getPath() const;
+
+        /**
+         * Returns the number of requests recorded so far.
+         * @return The number of recorded requests.
+         */
+        int getRecordedRequestCount() const;
+
+        /**
+         * Commits the pending recorded requests to the database file.
+         * Requests are committed in batches, the remaining requests are committed when the data source is released.
+         */
+        void flush();
+
+        virtual int getMinZoom() const;
+        virtual int getMaxZoom() const;
+
+        virtual MapBounds getDataExtent() const;
+
+        virtual std::shared_ptr<TileData> loadTile(const MapTile& mapTile);
+
+    protected:
+        friend class ReplayTileDataSource;
+
+        class DataSourceListener : public TileDataSource::OnChangeListener {
+        public:
+            explicit DataSourceListener(RecordingTileDataSource& recordingDataSource);
+            
+            virtual void onTilesChanged(bool removeTiles);
+            virtual void onTilesChanged(const MapBounds& bounds, int minZoom, int maxZoom, bool removeTiles);
+            
+        private:
+            RecordingTileDataSource& _recordingDataSource;
+        };
+
+        // Response types stored in the 'result' column of the 'requests' table
+        enum ResultType {
+            RESULT_NULL = 0,
+            RESULT_DATA = 1,
+            RESULT_REPLACE_WITH_PARENT = 2
+        };
+
+        static void InitializeDatabase(sqlite3pp::database& db);
+        static std::string CalculateBlobHash(const BinaryData& data);
+
+        static const unsigned int WRITE_BATCH_SIZE;
+
+        const DirectorPtr<TileDataSource> _dataSource;
+
+    private:
+        void recordRequest(const MapTile& mapTile, const std::chrono::steady_clock::time_point& startTime, const std::chrono::steady_clock::time_point& endTime, const std::shared_ptr<TileData>& tileData);
+
+        const std::string _path;
+        const std::chrono::steady_clock::time_point _recordingStartTime;
+        std::unique_ptr<sqlite3pp::database> _db;
+        std::unique_ptr<sqlite3pp::transaction> _transaction;
+        unsigned int _pendingRequestCount;
+        int _recordedRequestCount;
+        std::unordered_map<std::string, long long> _blobIds;
+
+        std::shared_ptr<DataSourceListener> _dataSourceListener;
+
+        mutable std::mutex _mutex;
+    };
+    
+}
+
+#endif
+
+#endif
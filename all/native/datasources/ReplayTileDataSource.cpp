@@ -0,0 +1,156 @@
+#ifdef _CARTO_OFFLINE_SUPPORT
+
+#include "ReplayTileDataSource.h"
+#include "RecordingTileDataSource.h"
+#include "core/BinaryData.h"
+#include "core/MapTile.h"
+#include "components/Exceptions.h"
+#include "datasources/components/TileData.h"
+#include "utils/Log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/algorithm/string.hpp>
+
+#include <sqlite3pp.h>
+
+namespace carto {
+
+    ReplayTileDataSource::ReplayTileDataSource(const std::string& path) :
+        TileDataSource(),
+        _dataExtent(),
+        _db(new sqlite3pp::database()),
+        _responses(),
+        _latencyScale(1.0f),
+        _unmatchedRequestCount(0),
+        _mutex()
+    {
+        if (_db->connect_v2(path.c_str(), SQLITE_OPEN_READONLY) != SQLITE_OK) {
+            throw FileException("Failed to open database file", path);
+        }
+
+        try {
+            sqlite3pp::query metaDataQuery(*_db, "SELECT name, value FROM metadata");
+            for (auto it = metaDataQuery.begin(); it != metaDataQuery.end(); it++) {
+                std::string name = (*it).get<const char*>(0);
+                std::string value = (*it).get<const char*>(1);
+                if (name == "minzoom") {
+                    _minZoom = boost::lexical_cast<int>(value);
+                } else if (name == "maxzoom") {
+                    _maxZoom = boost::lexical_cast<int>(value);
+                } else if (name == "bounds") {
+                    std::vector<std::string> coordinates;
+                    boost::split(coordinates, value, boost::is_any_of(","));
+                    if (coordinates.size() == 4) {
+                        double x0 = boost::lexical_cast<double>(coordinates[0]);
+                        double y0 = boost::lexical_cast<double>(coordinates[1]);
+                        double x1 = boost::lexical_cast<double>(coordinates[2]);
+                        double y1 = boost::lexical_cast<double>(coordinates[3]);
+                        _dataExtent = MapBounds(MapPos(x0, y0), MapPos(x1, y1));
+                    }
+                }
+            }
+
+            // Requests are kept in memory, only the payloads are read from the file when replayed
+            sqlite3pp::query requestQuery(*_db, "SELECT zoom, x, y, frame_nr, duration, result, blob_id, max_age, cache_source FROM requests ORDER BY id");
+            for (auto it = requestQuery.begin(); it != requestQuery.end(); it++) {
+                MapTile mapTile((*it).get<int>(1), (*it).get<int>(2), (*it).get<int>(0), (*it).get<int>(3));
+                Response response;
+                response.duration = (*it).get<double>(4);
+                response.result = (*it).get<int>(5);
+                response.blobId = ((*it).column_type(6) == SQLITE_NULL ? -1 : (*it).get<long long>(6));
+                response.maxAge = (*it).get<long long>(7);
+                response.cacheSource = ((*it).column_type(8) == SQLITE_NULL ? std::string() : std::string((*it).get<const char*>(8)));
+                _responses[mapTile.getTileId()].push_back(response);
+            }
+        }
+        catch (const std::exception& ex) {
+            throw FileException(std::string("Failed to read recording: ") + ex.what(), path);
+        }
+    }
+    
+    ReplayTileDataSource::~ReplayTileDataSource() {
+    }
+
+    float ReplayTileDataSource::getLatencyScale() const {
+        return _latencyScale.load();
+    }
+
+    void ReplayTileDataSource::setLatencyScale(float scale) {
+        _latencyScale.store(std::max(0.0f, scale));
+    }
+
+    int ReplayTileDataSource::getUnmatchedRequestCount() const {
+        return _unmatchedRequestCount.load();
+    }
+
+    MapBounds ReplayTileDataSource::getDataExtent() const {
+        return _dataExtent;
+    }
+    
+    std::shared_ptr<TileData> ReplayTileDataSource::loadTile(const MapTile& mapTile) {
+        Response response;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto it = _responses.find(mapTile.getTileId());
+            if (it == _responses.end() || it->second.empty()) {
+                _unmatchedRequestCount++;
+                Log::Warnf("ReplayTileDataSource::loadTile: No recorded response for %s", mapTile.toString().c_str());
+                return std::shared_ptr<TileData>();
+            }
+
+            // Keep the last response, repeated requests of the same tile are answered with it
+            response = it->second.front();
+            if (it->second.size() > 1) {
+                it->second.pop_front();
+            }
+        }
+
+        // Wait outside of the lock, so that concurrent requests overlap as in the recorded session
+        double delay = response.duration * _latencyScale.load();
+        if (delay > 0) {
+            std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(delay));
+        }
+
+        std::shared_ptr<BinaryData> data;
+        if (response.blobId >= 0) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            try {
+                sqlite3pp::query query(*_db, "SELECT data FROM blobs WHERE id=:id");
+                query.bind(":id", response.blobId);
+                auto it = query.begin();
+                if (it != query.end()) {
+                    std::size_t dataSize = (*it).column_bytes(0);
+                    const unsigned char* dataPtr = static_cast<const unsigned char*>((*it).get<const void*>(0));
+                    data = std::make_shared<BinaryData>(dataPtr, dataSize);
+                }
+                query.finish();
+            }
+            catch (const std::exception& ex) {
+                Log::Errorf("ReplayTileDataSource::loadTile: Failed to query tile data from the database: %s", ex.what());
+                return std::shared_ptr<TileData>();
+            }
+        }
+
+        switch (response.result) {
+        case RecordingTileDataSource::RESULT_DATA:
+        case RecordingTileDataSource::RESULT_REPLACE_WITH_PARENT:
+            {
+                auto tileData = std::make_shared<TileData>(data);
+                tileData->setMaxAge(response.maxAge);
+                tileData->setCacheSource(response.cacheSource);
+                tileData->setReplaceWithParent(response.result == RecordingTileDataSource::RESULT_REPLACE_WITH_PARENT);
+                return tileData;
+            }
+        default:
+            return std::shared_ptr<TileData>();
+        }
+    }
+    
+}
+
+#endif
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_REPLAYTILEDATASOURCE_H_
+#define _CARTO_REPLAYTILEDATASOURCE_H_
+
+#ifdef _CARTO_OFFLINE_SUPPORT
+
+#include "datasources/TileDataSource.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace sqlite3pp {
+    class database;
+}
+
+namespace carto {
+
+    /**
+     * A tile data source that replays the responses recorded by RecordingTileDataSource.
+     * Each request is answered with the next recorded response for the same tile, after waiting
+     * for the recorded latency multiplied by the latency scale. Once the recorded responses of a tile are used up,
+     * the last one is repeated. Tiles that were not recorded are returned as null and counted as unmatched requests.
+     */
+    class ReplayTileDataSource : public TileDataSource {
+    public:
+        /**
+         * Constructs a ReplayTileDataSource object.
+         * @param path The path to the recording database file.
+         * @throws std::runtime_error If the database file could not be opened.
+         */
+        explicit ReplayTileDataSource(const std::string& path);
+        virtual ~ReplayTileDataSource();
+
+        /**
+         * Returns the scaling factor of the recorded latencies.
+         * @return The latency scaling factor.
+         */
+        float getLatencyScale() const;
+        /**
+         * Sets the scaling factor of the recorded latencies. The default is 1, meaning that the responses
+         * are delayed by the recorded latencies. Value 0 disables delays.
+         * @param scale The new latency scaling factor. Must be non-negative.
+         */
+        void setLatencyScale(float scale);
+
+        /**
+         * Returns the number of requests so far that had no recorded response.
+         * A non-zero value means that the replayed session differs from the recorded one.
+         * @return The number of unmatched requests.
+         */
+        int getUnmatchedRequestCount() const;
+
+        virtual MapBounds getDataExtent() const;
+
+        virtual std::shared_ptr<TileData> loadTile(const MapTile& mapTile);
+
+    private:
+        struct Response {
+            double duration; // in milliseconds
+            int result;
+            long long blobId;
+            long long maxAge;
+            std::string cacheSource;
+
+            Response() : duration(0), result(0), blobId(-1), maxAge(-1), cacheSource() { }
+        };
+
+        MapBounds _dataExtent;
+        std::unique_ptr<sqlite3pp::database> _db;
+        std::unordered_map<long long, std::deque<Response> > _responses;
+        std::atomic<float> _latencyScale;
+        std::atomic<int> _unmatchedRequestCount;
+
+        mutable std::mutex _mutex;
+    };
+    
+}
+
+#endif
+
+#endif
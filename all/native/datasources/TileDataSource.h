@@ -38,6 +38,15 @@ namespace carto {
              * @param removeTiles The remove tiles flag.
              */
             virtual void onTilesChanged(bool removeTiles) = 0;
+            /**
+             * Listener method that gets called when tiles within the given bounds and zoom range have changes and need to be updated.
+             * The default implementation handles the change as if all tiles had changed.
+             * @param bounds The bounds of the changed area, in the coordinate system of the data source projection.
+             * @param minZoom The minimum zoom level of the changed tiles (inclusive).
+             * @param maxZoom The maximum zoom level of the changed tiles (inclusive).
+             * @param removeTiles The remove tiles flag.
+             */
+            virtual void onTilesChanged(const MapBounds& bounds, int minZoom, int maxZoom, bool removeTiles) { onTilesChanged(removeTiles); }
         };
         
         virtual ~TileDataSource();
@@ -73,6 +82,33 @@ namespace carto {
          * @return The tile data. If the tile is not available, null may be returned.
          */
         virtual std::shared_ptr<TileData> loadTile(const MapTile& tile) = 0;
+
+        /**
+         * Loads the specified tiles.
+         * The default implementation loads the tiles one by one using loadTile.
+         * Data sources that can load multiple tiles more efficiently (for example, using a single database query) override this.
+         * Note: the tile coordinate system used here is vertically flipped relative to layer tile coordinate system.
+         * @param tiles The tiles to load.
+         * @return The tile data for each tile, in the same order as the requested tiles. If a tile is not available, null may be returned in its place.
+         */
+        virtual std::vector<std::shared_ptr<TileData> > loadTiles(const std::vector<MapTile>& tiles);
+
+        /**
+         * Returns true if the data source can load multiple tiles more efficiently than loading them one by one.
+         * @return True if batch loading using loadTiles is more efficient, false otherwise.
+         */
+        virtual bool isBatchLoadingSupported() const;
+
+        /**
+         * Reloads the specified expired tile, using the validators (ETag, Last-Modified) of the cached tile data.
+         * If the tile has not changed, the returned tile data may share the data of the cached tile and only have its expiration time refreshed.
+         * The default implementation simply loads the tile using loadTile.
+         * Note: the tile coordinate system used here is vertically flipped relative to layer tile coordinate system.
+         * @param tile The tile to load.
+         * @param cachedTileData The expired tile data from a cache.
+         * @return The tile data. If the tile is not available, null may be returned.
+         */
+        virtual std::shared_ptr<TileData> revalidateTile(const MapTile& tile, const std::shared_ptr<TileData>& cachedTileData);
     
         /**
          * Notifies listeners that the tiles have changed. Action taken depends on the implementation of the
@@ -81,6 +117,16 @@ namespace carto {
          * @param removeTiles The remove tiles flag.
          */
         virtual void notifyTilesChanged(bool removeTiles);
+        /**
+         * Notifies listeners that the tiles within the given bounds and zoom range have changed.
+         * Only the cached tiles intersecting the bounds will be reloaded, other tiles are kept as they are.
+         * Tiles that include data from a buffer zone around them should be covered by the bounds, if the buffer contents may change.
+         * @param bounds The bounds of the changed area, in the coordinate system of the data source projection.
+         * @param minZoom The minimum zoom level of the changed tiles (inclusive).
+         * @param maxZoom The maximum zoom level of the changed tiles (inclusive).
+         * @param removeTiles The remove tiles flag.
+         */
+        virtual void notifyTilesChanged(const MapBounds& bounds, int minZoom, int maxZoom, bool removeTiles);
     
         /**
          * Registers listener for data source change events.
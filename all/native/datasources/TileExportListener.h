@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_TILEEXPORTLISTENER_H_
+#define _CARTO_TILEEXPORTLISTENER_H_
+
+#include "core/MapTile.h"
+
+#include <memory>
+#include <string>
+
+namespace carto {
+
+    /**
+     * Listener for tile exporter.
+     */
+    class TileExportListener {
+    public:
+        virtual ~TileExportListener() { }
+
+        /**
+         * Listener method that is called before export has actually started to report the total tile count.
+         * @param tileCount The number of tiles that will be exported.
+         */
+        virtual void onExportStarting(int tileCount) { }
+        /**
+         * Listener method that is called to report about export progress.
+         * @param progress The progress of the export, from 0 to 100.
+         * @param tilesPerSecond The average number of tiles processed per second since the export was started.
+         */
+        virtual void onExportProgress(float progress, float tilesPerSecond) { }
+        /**
+         * Listener method that is called when exporting has finished.
+         * @param tileCount The number of tiles written.
+         * @param uniqueTileCount The number of distinct tile blobs written. Identical tiles are stored only once.
+         */
+        virtual void onExportCompleted(int tileCount, int uniqueTileCount) { }
+        /**
+         * Listener method that is called when a tile could not be loaded or contains no data. The tile is not written.
+         * @param tile The tile that was skipped.
+         */
+        virtual void onExportTileSkipped(const MapTile& tile) { }
+        /**
+         * Listener method that is called when the export fails, for example when the output file can not be written.
+         * @param message The error message.
+         */
+        virtual void onExportFailed(const std::string& message) { }
+    };
+
+}
+
+#endif
@@ -13,7 +13,10 @@ namespace carto {
     VectorDataSource::VectorDataSource(const std::shared_ptr<Projection>& projection) :
         _projection(projection),
         _onChangeListeners(std::make_shared<std::vector<std::shared_ptr<OnChangeListener> > >()),
-        _onChangeListenersMutex()
+        _onChangeListenersMutex(),
+        _updateDepth(0),
+        _pendingUpdate(),
+        _updateMutex()
     {
         if (!projection) {
             throw NullArgumentException("Null projection");
@@ -32,6 +35,14 @@ namespace carto {
     }
 
     void VectorDataSource::notifyElementsChanged() {
+        {
+            std::lock_guard<std::mutex> lock(_updateMutex);
+            if (_updateDepth > 0) {
+                _pendingUpdate.allChanged = true;
+                return;
+            }
+        }
+
         std::shared_ptr<std::vector<std::shared_ptr<OnChangeListener> > > onChangeListeners;
         {
             std::lock_guard<std::mutex> lock(_onChangeListenersMutex);
@@ -42,6 +53,47 @@ namespace carto {
         }
     }
     
+    void VectorDataSource::beginUpdate() {
+        std::lock_guard<std::mutex> lock(_updateMutex);
+        _updateDepth++;
+    }
+
+    void VectorDataSource::commitUpdate() {
+        PendingUpdate pendingUpdate;
+        {
+            std::lock_guard<std::mutex> lock(_updateMutex);
+            if (_updateDepth <= 0) {
+                Log::Warn("VectorDataSource::commitUpdate: No matching beginUpdate call");
+                return;
+            }
+            if (--_updateDepth > 0) {
+                return;
+            }
+            std::swap(pendingUpdate, _pendingUpdate);
+        }
+
+        if (pendingUpdate.allChanged) {
+            notifyElementsChanged();
+            return;
+        }
+
+        // Classify the elements by their final state. Elements that were removed after being added or changed are not in the set anymore.
+        std::vector<std::shared_ptr<VectorElement> > addedElements, changedElements;
+        for (const std::shared_ptr<VectorElement>& element : pendingUpdate.addedElements) {
+            if (pendingUpdate.elementSet.erase(element) > 0) {
+                addedElements.push_back(element);
+            }
+        }
+        for (const std::shared_ptr<VectorElement>& element : pendingUpdate.changedElements) {
+            if (pendingUpdate.elementSet.erase(element) > 0) {
+                changedElements.push_back(element);
+            }
+        }
+        if (!addedElements.empty() || !changedElements.empty() || !pendingUpdate.removedElements.empty()) {
+            notifyElementsUpdated(addedElements, changedElements, pendingUpdate.removedElements);
+        }
+    }
+    
     void VectorDataSource::registerOnChangeListener(const std::shared_ptr<OnChangeListener>& listener) {
         {
             std::lock_guard<std::mutex> lock(_onChangeListenersMutex);
@@ -67,12 +119,31 @@ namespace carto {
             onChangeListeners = _onChangeListeners;
         }
         attachElement(element);
+        {
+            std::lock_guard<std::mutex> lock(_updateMutex);
+            if (_updateDepth > 0) {
+                if (_pendingUpdate.elementSet.insert(element).second) {
+                    _pendingUpdate.addedElements.push_back(element);
+                }
+                return;
+            }
+        }
         for (const std::shared_ptr<OnChangeListener>& listener : *onChangeListeners) {
             listener->onElementAdded(element);
         }
     }
     
     void VectorDataSource::notifyElementChanged(const std::shared_ptr<VectorElement>& element) {
+        {
+            std::lock_guard<std::mutex> lock(_updateMutex);
+            if (_updateDepth > 0) {
+                if (_pendingUpdate.elementSet.insert(element).second) {
+                    _pendingUpdate.changedElements.push_back(element);
+                }
+                return;
+            }
+        }
+
         std::shared_ptr<std::vector<std::shared_ptr<OnChangeListener> > > onChangeListeners;
         {
             std::lock_guard<std::mutex> lock(_onChangeListenersMutex);
@@ -90,6 +161,14 @@ namespace carto {
             onChangeListeners = _onChangeListeners;
         }
         detachElement(element);
+        {
+            std::lock_guard<std::mutex> lock(_updateMutex);
+            if (_updateDepth > 0) {
+                _pendingUpdate.elementSet.erase(element);
+                _pendingUpdate.removedElements.push_back(element);
+                return;
+            }
+        }
         for (const std::shared_ptr<OnChangeListener>& listener : *onChangeListeners) {
             listener->onElementRemoved(element);
         }
@@ -104,6 +183,17 @@ namespace carto {
         for (const std::shared_ptr<VectorElement>& element : elements) {
             attachElement(element);
         }
+        {
+            std::lock_guard<std::mutex> lock(_updateMutex);
+            if (_updateDepth > 0) {
+                for (const std::shared_ptr<VectorElement>& element : elements) {
+                    if (_pendingUpdate.elementSet.insert(element).second) {
+                        _pendingUpdate.addedElements.push_back(element);
+                    }
+                }
+                return;
+            }
+        }
         for (const std::shared_ptr<OnChangeListener>& listener : *onChangeListeners) {
             listener->onElementsAdded(elements);
         }
@@ -118,11 +208,32 @@ namespace carto {
         for (const std::shared_ptr<VectorElement>& element : elements) {
             detachElement(element);
         }
+        {
+            std::lock_guard<std::mutex> lock(_updateMutex);
+            if (_updateDepth > 0) {
+                for (const std::shared_ptr<VectorElement>& element : elements) {
+                    _pendingUpdate.elementSet.erase(element);
+                    _pendingUpdate.removedElements.push_back(element);
+                }
+                return;
+            }
+        }
         for (const std::shared_ptr<OnChangeListener>& listener : *onChangeListeners) {
             listener->onElementsRemoved();
         }
     }
 
+    void VectorDataSource::notifyElementsUpdated(const std::vector<std::shared_ptr<VectorElement> >& addedElements, const std::vector<std::shared_ptr<VectorElement> >& changedElements, const std::vector<std::shared_ptr<VectorElement> >& removedElements) {
+        std::shared_ptr<std::vector<std::shared_ptr<OnChangeListener> > > onChangeListeners;
+        {
+            std::lock_guard<std::mutex> lock(_onChangeListenersMutex);
+            onChangeListeners = _onChangeListeners;
+        }
+        for (const std::shared_ptr<OnChangeListener>& listener : *onChangeListeners) {
+            listener->onElementsUpdated(addedElements, changedElements, removedElements);
+        }
+    }
+
     std::shared_ptr<VectorDataSource> VectorDataSource::getElementDataSource(const std::shared_ptr<VectorElement>& element) const {
         return element->getDataSource();
     }
@@ -12,6 +12,7 @@
 
 #include <memory>
 #include <mutex>
+#include <unordered_set>
 #include <vector>
 
 namespace carto {
@@ -64,6 +65,24 @@ namespace carto {
              * Listener method that gets called before all vector elements are removed from the data source.
              */
             virtual void onElementsRemoved() = 0;
+            /**
+             * Listener method that gets called once when a batch update of the data source is committed.
+             * The default implementation forwards each element to the corresponding single element listener method.
+             * @param addedElements The elements added during the batch.
+             * @param changedElements The elements changed during the batch, excluding added and removed elements.
+             * @param removedElements The elements removed during the batch.
+             */
+            virtual void onElementsUpdated(const std::vector<std::shared_ptr<VectorElement> >& addedElements, const std::vector<std::shared_ptr<VectorElement> >& changedElements, const std::vector<std::shared_ptr<VectorElement> >& removedElements) {
+                for (const std::shared_ptr<VectorElement>& element : removedElements) {
+                    onElementRemoved(element);
+                }
+                for (const std::shared_ptr<VectorElement>& element : addedElements) {
+                    onElementAdded(element);
+                }
+                for (const std::shared_ptr<VectorElement>& element : changedElements) {
+                    onElementChanged(element);
+                }
+            }
         };
     
         virtual ~VectorDataSource();
@@ -93,6 +112,18 @@ namespace carto {
          * vector elements in the data source.
          */
         void notifyElementsChanged();
+
+        /**
+         * Starts a batch update. Until the matching commitUpdate call, element change notifications
+         * are collected instead of being sent to the listeners one by one.
+         * Batch updates can be nested, the notifications are sent when the outermost batch is committed.
+         */
+        void beginUpdate();
+        /**
+         * Commits a batch update started with beginUpdate. When the outermost batch is committed,
+         * the listeners receive a single notification containing all added, changed and removed elements.
+         */
+        void commitUpdate();
     
         /**
          * Registers listener for data source change events.
@@ -119,6 +150,7 @@ namespace carto {
         virtual void notifyElementRemoved(const std::shared_ptr<VectorElement>& element);
         virtual void notifyElementsAdded(const std::vector<std::shared_ptr<VectorElement> >& elements);
         virtual void notifyElementsRemoved(const std::vector<std::shared_ptr<VectorElement> >& elements);
+        virtual void notifyElementsUpdated(const std::vector<std::shared_ptr<VectorElement> >& addedElements, const std::vector<std::shared_ptr<VectorElement> >& changedElements, const std::vector<std::shared_ptr<VectorElement> >& removedElements);
 
         virtual std::shared_ptr<VectorDataSource> getElementDataSource(const std::shared_ptr<VectorElement>& element) const;
         virtual void attachElement(const std::shared_ptr<VectorElement>& element);
@@ -127,8 +159,20 @@ namespace carto {
         const std::shared_ptr<Projection> _projection;
     
     private:
+        struct PendingUpdate {
+            std::vector<std::shared_ptr<VectorElement> > addedElements;
+            std::vector<std::shared_ptr<VectorElement> > changedElements;
+            std::vector<std::shared_ptr<VectorElement> > removedElements;
+            std::unordered_set<std::shared_ptr<VectorElement> > elementSet; // added or changed elements
+            bool allChanged = false;
+        };
+
         std::shared_ptr<std::vector<std::shared_ptr<OnChangeListener> > > _onChangeListeners;
         mutable std::mutex _onChangeListenersMutex;
+
+        int _updateDepth;
+        PendingUpdate _pendingUpdate;
+        mutable std::mutex _updateMutex;
     };
     
 }
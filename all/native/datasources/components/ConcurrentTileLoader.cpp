@@ -0,0 +1,42 @@
+#include "ConcurrentTileLoader.h"
+#include "datasources/components/TileData.h"
+#include "utils/Log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace carto {
+
+    std::vector<std::shared_ptr<TileData> > ConcurrentTileLoader::LoadTiles(const std::vector<MapTile>& mapTiles, const LoadFunction& loadFunc, int maxConcurrentLoads) {
+        std::vector<std::shared_ptr<TileData> > tileDatas(mapTiles.size());
+        std::atomic<std::size_t> nextIndex(0);
+
+        // Each loader takes the next unclaimed tile, the calling thread acts as one of the loaders
+        auto loader = [&]() {
+            for (std::size_t i = nextIndex++; i < mapTiles.size(); i = nextIndex++) {
+                try {
+                    tileDatas[i] = loadFunc(mapTiles[i]);
+                }
+                catch (const std::exception& ex) {
+                    Log::Errorf("ConcurrentTileLoader::LoadTiles: Exception while loading tile %s: %s", mapTiles[i].toString().c_str(), ex.what());
+                }
+            }
+        };
+
+        std::size_t threadCount = std::min(mapTiles.size(), static_cast<std::size_t>(std::max(1, maxConcurrentLoads)));
+        std::vector<std::thread> threads;
+        for (std::size_t i = 1; i < threadCount; i++) {
+            threads.emplace_back(loader);
+        }
+        loader();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        return tileDatas;
+    }
+
+    ConcurrentTileLoader::ConcurrentTileLoader() {
+    }
+
+}
@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_CONCURRENTTILELOADER_H_
+#define _CARTO_CONCURRENTTILELOADER_H_
+
+#include "core/MapTile.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace carto {
+    class TileData;
+
+    /**
+     * Helper for loading a batch of tiles with multiple requests in flight.
+     * Used by network data sources to implement batch loading, so that a single tile worker
+     * can wait for many requests while the other workers keep decoding tiles.
+     */
+    class ConcurrentTileLoader {
+    public:
+        typedef std::function<std::shared_ptr<TileData>(const MapTile&)> LoadFunction;
+
+        static std::vector<std::shared_ptr<TileData> > LoadTiles(const std::vector<MapTile>& mapTiles, const LoadFunction& loadFunc, int maxConcurrentLoads);
+
+    private:
+        ConcurrentTileLoader();
+    };
+
+}
+
+#endif
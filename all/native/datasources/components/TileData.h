@@ -10,6 +10,7 @@
 #include <chrono>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <vector>
 
 namespace carto {
@@ -49,6 +50,38 @@ namespace carto {
          */
         void setReplaceWithParent(bool flag);
         
+        /**
+         * Returns the name of the cache data source that served this tile data.
+         * @return The name of the cache data source, or empty string if the data was not served from a cache.
+         */
+        std::string getCacheSource() const;
+        /**
+         * Sets the name of the cache data source that served this tile data.
+         * @param cacheSource The name of the cache data source.
+         */
+        void setCacheSource(const std::string& cacheSource);
+
+        /**
+         * Returns the entity tag of the tile data, used for revalidating expired tiles.
+         * @return The entity tag (HTTP ETag header value), or empty string if not available.
+         */
+        std::string getETag() const;
+        /**
+         * Sets the entity tag of the tile data.
+         * @param etag The entity tag (HTTP ETag header value).
+         */
+        void setETag(const std::string& etag);
+        /**
+         * Returns the last modification time of the tile data, used for revalidating expired tiles.
+         * @return The last modification time (HTTP Last-Modified header value), or empty string if not available.
+         */
+        std::string getLastModified() const;
+        /**
+         * Sets the last modification time of the tile data.
+         * @param lastModified The last modification time (HTTP Last-Modified header value).
+         */
+        void setLastModified(const std::string& lastModified);
+
         /**
          * Returns tile data as binary data.
          * @return Tile data as binary data.
@@ -59,6 +92,9 @@ namespace carto {
         const std::shared_ptr<BinaryData> _data;
         std::shared_ptr<std::chrono::steady_clock::time_point> _expirationTime;
         bool _replaceWithParent;
+        std::string _cacheSource;
+        std::string _etag;
+        std::string _lastModified;
         mutable std::mutex _mutex;
     };
 
@@ -0,0 +1,58 @@
+#include "TileLoadCoalescer.h"
+#include "datasources/components/TileData.h"
+
+namespace carto {
+
+    TileLoadCoalescer::TileLoadCoalescer() :
+        _pendingLoads(),
+        _condition(),
+        _mutex()
+    {
+    }
+
+    TileLoadCoalescer::~TileLoadCoalescer() {
+    }
+
+    std::shared_ptr<TileData> TileLoadCoalescer::load(long long tileId, const LoadFunction& loadFunc) {
+        std::shared_ptr<PendingLoad> pendingLoad;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            auto it = _pendingLoads.find(tileId);
+            if (it != _pendingLoads.end()) {
+                // The tile is already being loaded by another thread, wait for the result
+                std::shared_ptr<PendingLoad> activeLoad = it->second;
+                _condition.wait(lock, [&activeLoad]() { return activeLoad->finished; });
+                return activeLoad->tileData;
+            }
+            
+            pendingLoad = std::make_shared<PendingLoad>();
+            _pendingLoads[tileId] = pendingLoad;
+        }
+
+        std::shared_ptr<TileData> tileData;
+        try {
+            tileData = loadFunc();
+        }
+        catch (...) {
+            finish(tileId, pendingLoad, std::shared_ptr<TileData>());
+            throw;
+        }
+        finish(tileId, pendingLoad, tileData);
+        return tileData;
+    }
+
+    void TileLoadCoalescer::finish(long long tileId, const std::shared_ptr<PendingLoad>& pendingLoad, const std::shared_ptr<TileData>& tileData) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        pendingLoad->tileData = tileData;
+        pendingLoad->finished = true;
+        _pendingLoads.erase(tileId);
+        _condition.notify_all();
+    }
+
+    TileLoadCoalescer::PendingLoad::PendingLoad() :
+        tileData(),
+        finished(false)
+    {
+    }
+
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_TILELOADCOALESCER_H_
+#define _CARTO_TILELOADCOALESCER_H_
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace carto {
+    class TileData;
+
+    /**
+     * Helper for merging concurrent loads of the same tile.
+     * The first caller for a tile id performs the actual load, callers arriving while the load
+     * is in progress wait for it and receive the same tile data instance.
+     */
+    class TileLoadCoalescer {
+    public:
+        typedef std::function<std::shared_ptr<TileData>()> LoadFunction;
+
+        TileLoadCoalescer();
+        virtual ~TileLoadCoalescer();
+
+        std::shared_ptr<TileData> load(long long tileId, const LoadFunction& loadFunc);
+
+    private:
+        struct PendingLoad {
+            PendingLoad();
+
+            std::shared_ptr<TileData> tileData;
+            bool finished;
+        };
+
+        void finish(long long tileId, const std::shared_ptr<PendingLoad>& pendingLoad, const std::shared_ptr<TileData>& tileData);
+
+        std::unordered_map<long long, std::shared_ptr<PendingLoad> > _pendingLoads;
+        std::condition_variable _condition;
+        std::mutex _mutex;
+    };
+
+}
+
+#endif
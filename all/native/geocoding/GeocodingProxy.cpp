@@ -1,6 +1,7 @@
 #ifdef _CARTO_GEOCODING_SUPPORT
 
 #include "GeocodingProxy.h"
+#include "components/Exceptions.h"
 #include "core/Variant.h"
 #include "geometry/Feature.h"
 #include "geometry/FeatureCollection.h"
@@ -12,6 +13,7 @@
 #include "projections/Projection.h"
 #include "projections/EPSG3857.h"
 #include "utils/Const.h"
+#include "utils/GeneralUtils.h"
 
 #include <geocoding/Geocoder.h>
 #include <geocoding/RevGeocoder.h>
@@ -19,6 +21,11 @@
 #include <cmath>
 #include <functional>
 #include <algorithm>
+#include <map>
+#include <sstream>
+#include <tuple>
+
+#include <stdext/unistring.h>
 
 namespace {
 
@@ -86,9 +93,72 @@ namespace carto {
         return results;
     }
 
+    std::vector<std::vector<std::shared_ptr<GeocodingResult> > > GeocodingProxy::CalculateAddressesBatch(const std::shared_ptr<geocoding::RevGeocoder>& revGeocoder, const std::vector<std::shared_ptr<ReverseGeocodingRequest> >& requests) {
+        // Process the requests along a Z-order curve, so that consecutive lookups touch the same database pages and geocoder caches
+        std::vector<std::pair<std::uint64_t, std::size_t> > order;
+        std::vector<MapPos> wgs84Poses;
+        order.reserve(requests.size());
+        wgs84Poses.reserve(requests.size());
+        for (std::size_t i = 0; i < requests.size(); i++) {
+            if (!requests[i]) {
+                throw NullArgumentException("Null request");
+            }
+            wgs84Poses.push_back(requests[i]->getProjection()->toWgs84(requests[i]->getLocation()));
+            order.emplace_back(CalculateMortonCode(wgs84Poses.back()), i);
+        }
+        std::sort(order.begin(), order.end());
+
+        std::vector<std::vector<std::shared_ptr<GeocodingResult> > > results(requests.size());
+        std::map<std::tuple<double, double, float, const Projection*>, std::size_t> processedRequests;
+        for (const std::pair<std::uint64_t, std::size_t>& item : order) {
+            const std::shared_ptr<ReverseGeocodingRequest>& request = requests[item.second];
+            const MapPos& posWgs84 = wgs84Poses[item.second];
+
+            // Identical requests are common in GPS traces (stationary points), reuse their results
+            auto key = std::make_tuple(posWgs84.getX(), posWgs84.getY(), request->getSearchRadius(), request->getProjection().get());
+            auto it = processedRequests.find(key);
+            if (it != processedRequests.end()) {
+                results[item.second] = results[it->second];
+                continue;
+            }
+
+            std::vector<std::pair<geocoding::Address, float> > addrs = revGeocoder->findAddresses(posWgs84.getX(), posWgs84.getY(), request->getSearchRadius());
+            for (const std::pair<geocoding::Address, float>& addr : addrs) {
+                results[item.second].push_back(TranslateAddress(request->getProjection(), addr.first, addr.second));
+            }
+            processedRequests[key] = item.second;
+        }
+        return results;
+    }
+
     GeocodingProxy::GeocodingProxy() {
     }
 
+    std::string GeocodingProxy::CalculateRequestKey(const std::shared_ptr<GeocodingRequest>& request) {
+        // Normalize case and whitespace of the query, so that equivalent autocomplete queries share the key
+        std::string normalizedQuery = GeneralUtils::NormalizeWhitespace(unistring::to_utf8string(unistring::to_normalized(unistring::to_upper(unistring::to_unistring(request->getQuery())))));
+
+        std::stringstream ss;
+        ss.precision(10);
+        ss << normalizedQuery << '\n' << request->getProjection()->getName();
+        if (request->isLocationDefined() || request->getLocationRadius() > 0) {
+            MapPos location = request->getLocation();
+            ss << '\n' << location.getX() << ',' << location.getY() << ',' << request->getLocationRadius();
+        }
+        ss << '\n' << request->getCustomParameters().toString();
+        return ss.str();
+    }
+
+    std::uint64_t GeocodingProxy::CalculateMortonCode(const MapPos& posWgs84) {
+        std::uint32_t x = static_cast<std::uint32_t>(std::min(std::max((posWgs84.getX() + 180.0) / 360.0, 0.0), 1.0) * 4294967295.0);
+        std::uint32_t y = static_cast<std::uint32_t>(std::min(std::max((posWgs84.getY() + 90.0) / 180.0, 0.0), 1.0) * 4294967295.0);
+        std::uint64_t code = 0;
+        for (int i = 31; i >= 0; i--) {
+            code = (code << 2) | (static_cast<std::uint64_t>((y >> i) & 1) << 1) | ((x >> i) & 1);
+        }
+        return code;
+    }
+
     std::shared_ptr<GeocodingResult> GeocodingProxy::TranslateAddress(const std::shared_ptr<Projection>& proj, const geocoding::Address& addr, float rank) {
         std::vector<std::shared_ptr<Feature> > features;
         std::transform(addr.features.begin(), addr.features.end(), std::back_inserter(features), std::bind(&GeocodingProxy::TranslateFeature, proj, std::placeholders::_1));
@@ -128,11 +198,11 @@ namespace carto {
         } else if (auto polygonGeom = std::dynamic_pointer_cast<geocoding::PolygonGeometry>(geom)) {
             std::vector<std::vector<MapPos> > holes;
             std::transform(polygonGeom->getHoles().begin(), polygonGeom->getHoles().end(), std::back_inserter(holes), translateRing);
-            return std::make_shared<PolygonGeometry>(translateRing(polygonGeom->getPoints()), holes);
+            return std::make_shared<PolygonGeometry>(translateRing(polygonGeom->getPoints()), std::move(holes));
         } else if (auto multiGeom = std::dynamic_pointer_cast<geocoding::MultiGeometry>(geom)) {
             std::vector<std::shared_ptr<Geometry> > geometries;
             std::transform(multiGeom->getGeometries().begin(), multiGeom->getGeometries().end(), std::back_inserter(geometries), std::bind(&GeocodingProxy::TranslateGeometry, proj, std::placeholders::_1));
-            return std::make_shared<MultiGeometry>(geometries);
+            return std::make_shared<MultiGeometry>(std::move(geometries));
         }
         return std::shared_ptr<Geometry>();
     }
@@ -12,7 +12,9 @@
 #include "geocoding/GeocodingService.h"
 #include "geocoding/ReverseGeocodingService.h"
 
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace carto {
@@ -34,9 +36,15 @@ namespace carto {
 
         static std::vector<std::shared_ptr<GeocodingResult> > CalculateAddresses(const std::shared_ptr<geocoding::RevGeocoder>& revGeocoder, const std::shared_ptr<ReverseGeocodingRequest>& request);
 
+        static std::vector<std::vector<std::shared_ptr<GeocodingResult> > > CalculateAddressesBatch(const std::shared_ptr<geocoding::RevGeocoder>& revGeocoder, const std::vector<std::shared_ptr<ReverseGeocodingRequest> >& requests);
+
+        static std::string CalculateRequestKey(const std::shared_ptr<GeocodingRequest>& request);
+
     private:
         GeocodingProxy();
 
+        static std::uint64_t CalculateMortonCode(const MapPos& posWgs84);
+
         static std::shared_ptr<GeocodingResult> TranslateAddress(const std::shared_ptr<Projection>& proj, const geocoding::Address& addr, float rank);
 
         static std::shared_ptr<Feature> TranslateFeature(const std::shared_ptr<Projection>& proj, const geocoding::Feature& feature);
@@ -11,6 +11,7 @@
 #include "projections/Projection.h"
 #include "utils/Log.h"
 #include "utils/GeneralUtils.h"
+#include "utils/JSONUtils.h"
 
 #include <picojson/picojson.h>
 
@@ -18,7 +19,7 @@ namespace carto {
 
     std::vector<std::shared_ptr<GeocodingResult> > MapBoxGeocodingProxy::ReadResponse(const std::string& responseString, const std::shared_ptr<Projection>& proj) {
         picojson::value response;
-        std::string err = picojson::parse(response, responseString);
+        std::string err = JSONUtils::ParsePicoJSON(response, responseString);
         if (!err.empty()) {
             throw GenericException("Failed to parse response", err);
         }
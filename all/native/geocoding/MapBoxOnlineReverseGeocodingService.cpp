@@ -6,6 +6,7 @@
 #include "geocoding/MapBoxGeocodingProxy.h"
 #include "projections/Projection.h"
 #include "utils/GeneralUtils.h"
+#include "network/ServiceResponseCache.h"
 #include "utils/NetworkUtils.h"
 #include "utils/Log.h"
 
@@ -72,7 +73,7 @@ namespace carto {
         Log::Debugf("MapBoxOnlineReverseGeocodingService::calculateAddresses: Loading %s", url.c_str());
 
         std::string responseString;
-        if (!NetworkUtils::GetHTTP(url, responseString, Log::IsShowDebug())) {
+        if (ServiceResponseCache::GetInstance().get(url, responseString, std::shared_ptr<ServiceResponseCache::Session>(), Log::IsShowDebug()) != 0) {
             throw NetworkException("Failed to fetch response");
         }
         return MapBoxGeocodingProxy::ReadResponse(responseString, request->getProjection());
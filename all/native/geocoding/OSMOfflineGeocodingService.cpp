@@ -11,7 +11,9 @@
 namespace carto {
 
     OSMOfflineGeocodingService::OSMOfflineGeocodingService(const std::string& path) :
-        _geocoder()
+        _geocoder(),
+        _resultCache(RESULT_CACHE_SIZE),
+        _mutex()
     {
         auto database = std::make_shared<sqlite3pp::database>();
         if (database->connect_v2(path.c_str(), SQLITE_OPEN_READONLY) != SQLITE_OK) {
@@ -31,7 +33,9 @@ namespace carto {
     }
 
     void OSMOfflineGeocodingService::setAutocomplete(bool autocomplete) {
+        std::lock_guard<std::mutex> lock(_mutex);
         _geocoder->setAutocomplete(autocomplete);
+        _resultCache.clear();
     }
 
     std::string OSMOfflineGeocodingService::getLanguage() const {
@@ -39,7 +43,9 @@ namespace carto {
     }
 
     void OSMOfflineGeocodingService::setLanguage(const std::string& lang) {
+        std::lock_guard<std::mutex> lock(_mutex);
         _geocoder->setLanguage(lang);
+        _resultCache.clear();
     }
 
     int OSMOfflineGeocodingService::getMaxResults() const {
@@ -47,7 +53,9 @@ namespace carto {
     }
 
     void OSMOfflineGeocodingService::setMaxResults(int maxResults) {
+        std::lock_guard<std::mutex> lock(_mutex);
         _geocoder->setMaxResults(maxResults);
+        _resultCache.clear();
     }
 
     std::vector<std::shared_ptr<GeocodingResult> > OSMOfflineGeocodingService::calculateAddresses(const std::shared_ptr<GeocodingRequest>& request) const {
@@ -55,8 +63,23 @@ namespace carto {
             throw NullArgumentException("Null request");
         }
 
-        return GeocodingProxy::CalculateAddresses(_geocoder, request);
+        std::string requestKey = GeocodingProxy::CalculateRequestKey(request);
+        std::vector<std::shared_ptr<GeocodingResult> > results;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_resultCache.read(requestKey, results)) {
+                return results;
+            }
+        }
+
+        results = GeocodingProxy::CalculateAddresses(_geocoder, request);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _resultCache.put(requestKey, results, 1);
+        return results;
     }
+
+    const std::size_t OSMOfflineGeocodingService::RESULT_CACHE_SIZE = 256;
     
 }
 
@@ -11,6 +11,11 @@
 
 #include "geocoding/GeocodingService.h"
 
+#include <mutex>
+#include <string>
+
+#include <stdext/timed_lru_cache.h>
+
 namespace carto {
     namespace geocoding {
         class Geocoder;
@@ -18,6 +23,7 @@ namespace carto {
 
     /**
      * A geocoding service that uses custom geocoding database files.
+     * Results of recent requests are cached, so that repeated autocomplete queries are answered without querying the database.
      * Note: this class is experimental and may change or even be removed in future SDK versions.
      */
     class OSMOfflineGeocodingService : public GeocodingService {
@@ -42,7 +48,13 @@ namespace carto {
         virtual std::vector<std::shared_ptr<GeocodingResult> > calculateAddresses(const std::shared_ptr<GeocodingRequest>& request) const;
 
     protected:
+        static const std::size_t RESULT_CACHE_SIZE;
+
         std::shared_ptr<geocoding::Geocoder> _geocoder;
+
+        mutable cache::timed_lru_cache<std::string, std::vector<std::shared_ptr<GeocodingResult> > > _resultCache;
+
+        mutable std::mutex _mutex;
     };
     
 }
@@ -41,6 +41,10 @@ namespace carto {
 
         return GeocodingProxy::CalculateAddresses(_revGeocoder, request);
     }
+
+    std::vector<std::vector<std::shared_ptr<GeocodingResult> > > OSMOfflineReverseGeocodingService::calculateAddressesBatch(const std::vector<std::shared_ptr<ReverseGeocodingRequest> >& requests) const {
+        return GeocodingProxy::CalculateAddressesBatch(_revGeocoder, requests);
+    }
     
 }
 
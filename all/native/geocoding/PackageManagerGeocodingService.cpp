@@ -19,6 +19,7 @@ namespace carto {
         _maxResults(10),
         _cachedPackageDatabaseMap(),
         _cachedGeocoder(),
+        _resultCache(RESULT_CACHE_SIZE),
         _mutex()
     {
         if (!packageManager) {
@@ -44,6 +45,7 @@ namespace carto {
         if (autocomplete != _autocomplete) {
             _autocomplete = autocomplete;
             _cachedGeocoder.reset();
+            _resultCache.clear();
         }
     }
 
@@ -57,6 +59,7 @@ namespace carto {
         if (lang != _language) {
             _language = lang;
             _cachedGeocoder.reset();
+            _resultCache.clear();
         }
     }
 
@@ -70,6 +73,7 @@ namespace carto {
         if (maxResults != _maxResults) {
             _maxResults = maxResults;
             _cachedGeocoder.reset();
+            _resultCache.clear();
         }
     }
 
@@ -78,9 +82,17 @@ namespace carto {
             throw NullArgumentException("Null request");
         }
 
-        // Do routing via package manager, so that all packages are locked during routing
+        std::string requestKey = GeocodingProxy::CalculateRequestKey(request);
         std::vector<std::shared_ptr<GeocodingResult> > results;
-        _packageManager->accessLocalPackages([this, &results, &request](const std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> >& packageHandlerMap) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_resultCache.read(requestKey, results)) {
+                return results;
+            }
+        }
+
+        // Do routing via package manager, so that all packages are locked during routing
+        _packageManager->accessLocalPackages([this, &results, &request, &requestKey](const std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> >& packageHandlerMap) {
             // Build map of geocoding databases
             std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<sqlite3pp::database> > packageDatabaseMap;
             for (auto it = packageHandlerMap.begin(); it != packageHandlerMap.end(); it++) {
@@ -108,9 +120,11 @@ namespace carto {
                 }
                 _cachedPackageDatabaseMap = packageDatabaseMap;
                 _cachedGeocoder = geocoder;
+                _resultCache.clear();
             }
 
             results = GeocodingProxy::CalculateAddresses(_cachedGeocoder, request);
+            _resultCache.put(requestKey, results, 1);
         });
         return results;
     }
@@ -124,12 +138,15 @@ namespace carto {
         std::lock_guard<std::mutex> lock(_service._mutex);
         _service._cachedPackageDatabaseMap.clear();
         _service._cachedGeocoder.reset();
+        _service._resultCache.clear();
     }
 
     void PackageManagerGeocodingService::PackageManagerListener::onStylesChanged() {
         // Impossible
     }
 
+    const std::size_t PackageManagerGeocodingService::RESULT_CACHE_SIZE = 256;
+
 }
 
 #endif
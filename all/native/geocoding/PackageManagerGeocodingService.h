@@ -12,6 +12,12 @@
 #include "geocoding/GeocodingService.h"
 #include "packagemanager/PackageManager.h"
 
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <stdext/timed_lru_cache.h>
+
 namespace sqlite3pp {
     class database;
 }
@@ -23,6 +29,7 @@ namespace carto {
 
     /**
      * A geocoding service that uses geocoding packages from package manager.
+     * Results of recent requests are cached until the packages or the geocoding options change.
      */
     class PackageManagerGeocodingService : public GeocodingService {
     public:
@@ -63,10 +70,13 @@ namespace carto {
 
         mutable std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<sqlite3pp::database> > _cachedPackageDatabaseMap;
         mutable std::shared_ptr<geocoding::Geocoder> _cachedGeocoder;
+        mutable cache::timed_lru_cache<std::string, std::vector<std::shared_ptr<GeocodingResult> > > _resultCache;
 
         mutable std::mutex _mutex;
 
     private:
+        static const std::size_t RESULT_CACHE_SIZE;
+
         std::shared_ptr<PackageManagerListener> _packageManagerListener;
     };
     
@@ -53,36 +53,50 @@ namespace carto {
         // Do routing via package manager, so that all packages are locked during routing
         std::vector<std::shared_ptr<GeocodingResult> > results;
         _packageManager->accessLocalPackages([this, &results, &request](const std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> >& packageHandlerMap) {
-            // Build map of geocoding databases
-            std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<sqlite3pp::database> > packageDatabaseMap;
-            for (auto it = packageHandlerMap.begin(); it != packageHandlerMap.end(); it++) {
-                if (auto geocodingHandler = std::dynamic_pointer_cast<GeocodingPackageHandler>(it->second)) {
-                    packageDatabaseMap[it->first] = geocodingHandler->getGeocodingDatabase();
-                }
-            }
+            std::lock_guard<std::mutex> lock(_mutex);
+            updateRevGeocoder(packageHandlerMap);
+            results = GeocodingProxy::CalculateAddresses(_cachedRevGeocoder, request);
+        });
+        return results;
+    }
 
-            // Now check if we have to reinitialize the geocoder
+    std::vector<std::vector<std::shared_ptr<GeocodingResult> > > PackageManagerReverseGeocodingService::calculateAddressesBatch(const std::vector<std::shared_ptr<ReverseGeocodingRequest> >& requests) const {
+        // Lock the packages and the geocoder once for the whole batch
+        std::vector<std::vector<std::shared_ptr<GeocodingResult> > > results;
+        _packageManager->accessLocalPackages([this, &results, &requests](const std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> >& packageHandlerMap) {
             std::lock_guard<std::mutex> lock(_mutex);
-            if (!_cachedRevGeocoder || packageDatabaseMap != _cachedPackageDatabaseMap) {
-                auto revGeocoder = std::make_shared<geocoding::RevGeocoder>();
-                revGeocoder->setLanguage(_language);
-                for (auto it = packageDatabaseMap.begin(); it != packageDatabaseMap.end(); it++) {
-                    try {
-                        if (!revGeocoder->import(it->second)) {
-                            throw FileException("Failed to import geocoding database " + it->first->getPackageId(), "");
-                        }
-                    }
-                    catch (const std::exception& ex) {
-                        throw GenericException("Exception while importing geocoding database " + it->first->getPackageId(), ex.what());
+            updateRevGeocoder(packageHandlerMap);
+            results = GeocodingProxy::CalculateAddressesBatch(_cachedRevGeocoder, requests);
+        });
+        return results;
+    }
+
+    void PackageManagerReverseGeocodingService::updateRevGeocoder(const std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> >& packageHandlerMap) const {
+        // Build map of geocoding databases
+        std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<sqlite3pp::database> > packageDatabaseMap;
+        for (auto it = packageHandlerMap.begin(); it != packageHandlerMap.end(); it++) {
+            if (auto geocodingHandler = std::dynamic_pointer_cast<GeocodingPackageHandler>(it->second)) {
+                packageDatabaseMap[it->first] = geocodingHandler->getGeocodingDatabase();
+            }
+        }
+
+        // Now check if we have to reinitialize the geocoder
+        if (!_cachedRevGeocoder || packageDatabaseMap != _cachedPackageDatabaseMap) {
+            auto revGeocoder = std::make_shared<geocoding::RevGeocoder>();
+            revGeocoder->setLanguage(_language);
+            for (auto it = packageDatabaseMap.begin(); it != packageDatabaseMap.end(); it++) {
+                try {
+                    if (!revGeocoder->import(it->second)) {
+                        throw FileException("Failed to import geocoding database " + it->first->getPackageId(), "");
                     }
                 }
-                _cachedPackageDatabaseMap = packageDatabaseMap;
-                _cachedRevGeocoder = revGeocoder;
+                catch (const std::exception& ex) {
+                    throw GenericException("Exception while importing geocoding database " + it->first->getPackageId(), ex.what());
+                }
             }
-
-            results = GeocodingProxy::CalculateAddresses(_cachedRevGeocoder, request);
-        });
-        return results;
+            _cachedPackageDatabaseMap = packageDatabaseMap;
+            _cachedRevGeocoder = revGeocoder;
+        }
     }
     
     PackageManagerReverseGeocodingService::PackageManagerListener::PackageManagerListener(PackageManagerReverseGeocodingService& service) :
@@ -10,6 +10,7 @@
 #include "geometry/GeoJSONGeometryReader.h"
 #include "projections/Projection.h"
 #include "utils/Log.h"
+#include "utils/JSONUtils.h"
 
 #include <picojson/picojson.h>
 
@@ -17,7 +18,7 @@ namespace carto {
 
     std::vector<std::shared_ptr<GeocodingResult> > PeliasGeocodingProxy::ReadResponse(const std::string& responseString, const std::shared_ptr<Projection>& proj) {
         picojson::value response;
-        std::string err = picojson::parse(response, responseString);
+        std::string err = JSONUtils::ParsePicoJSON(response, responseString);
         if (!err.empty()) {
             throw GenericException("Failed to parse response", err);
         }
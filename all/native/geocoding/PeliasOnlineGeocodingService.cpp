@@ -21,6 +21,7 @@ namespace carto {
         _language(),
         _maxResults(10),
         _serviceURL(),
+        _autocompleteSession(std::make_shared<ServiceResponseCache::Session>()),
         _mutex()
     {
     }
@@ -73,23 +74,30 @@ namespace carto {
             throw NullArgumentException("Null request");
         }
 
-        if (request->getQuery().empty()) {
+        // Equivalent queries share the cached response
+        std::string query = GeneralUtils::NormalizeWhitespace(request->getQuery());
+        if (query.empty()) {
             return std::vector<std::shared_ptr<GeocodingResult> >();
         }
 
         std::string baseURL;
 
+        std::shared_ptr<ServiceResponseCache::Session> session;
         std::map<std::string, std::string> params;
         {
             std::lock_guard<std::mutex> lock(_mutex);
 
+            if (_autocomplete) {
+                session = _autocompleteSession;
+            }
+
             std::map<std::string, std::string> tagMap;
             tagMap["api_key"] = NetworkUtils::URLEncode(_apiKey);
             tagMap["mode"] = _autocomplete ? "autocomplete": "search";
 
             baseURL = GeneralUtils::ReplaceTags(_serviceURL.empty() ? MAPZEN_SERVICE_URL : _serviceURL, tagMap);
 
-            params["text"] = request->getQuery();
+            params["text"] = query;
 
             if (request->isLocationDefined()) {
                 MapPos wgs84Center = request->getProjection()->toWgs84(request->getLocation());
@@ -115,7 +123,11 @@ namespace carto {
         Log::Debugf("PeliasOnlineGeocodingService::calculateAddresses: Loading %s", url.c_str());
 
         std::string responseString;
-        if (!NetworkUtils::GetHTTP(url, responseString, Log::IsShowDebug())) {
+        int code = ServiceResponseCache::GetInstance().get(url, responseString, session, Log::IsShowDebug());
+        if (code == ServiceResponseCache::REQUEST_SUPERSEDED) {
+            return std::vector<std::shared_ptr<GeocodingResult> >(); // a later autocomplete query replaced this one
+        }
+        if (code != 0) {
             throw NetworkException("Failed to fetch response");
         }
         return PeliasGeocodingProxy::ReadResponse(responseString, request->getProjection());
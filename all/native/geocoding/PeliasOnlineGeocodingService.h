@@ -10,6 +10,7 @@
 #if defined(_CARTO_GEOCODING_SUPPORT)
 
 #include "geocoding/GeocodingService.h"
+#include "network/ServiceResponseCache.h"
 
 namespace carto {
 
@@ -62,6 +63,7 @@ namespace carto {
         std::string _language;
         int _maxResults;
         std::string _serviceURL;
+        std::shared_ptr<ServiceResponseCache::Session> _autocompleteSession;
 
         mutable std::mutex _mutex;
     };
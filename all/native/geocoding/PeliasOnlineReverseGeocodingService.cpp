@@ -6,6 +6,7 @@
 #include "geocoding/PeliasGeocodingProxy.h"
 #include "projections/Projection.h"
 #include "utils/GeneralUtils.h"
+#include "network/ServiceResponseCache.h"
 #include "utils/NetworkUtils.h"
 #include "utils/Log.h"
 
@@ -77,7 +78,7 @@ namespace carto {
         Log::Debugf("PeliasOnlineReverseGeocodingService::calculateAddresses: Loading %s", url.c_str());
 
         std::string responseString;
-        if (!NetworkUtils::GetHTTP(url, responseString, Log::IsShowDebug())) {
+        if (ServiceResponseCache::GetInstance().get(url, responseString, std::shared_ptr<ServiceResponseCache::Session>(), Log::IsShowDebug()) != 0) {
             throw NetworkException("Failed to fetch response");
         }
         return PeliasGeocodingProxy::ReadResponse(responseString, request->getProjection());
@@ -1,6 +1,7 @@
 #ifdef _CARTO_GEOCODING_SUPPORT
 
 #include "ReverseGeocodingService.h"
+#include "components/Exceptions.h"
 
 namespace carto {
 
@@ -10,6 +11,18 @@ namespace carto {
     ReverseGeocodingService::~ReverseGeocodingService() {
     }
 
+    std::vector<std::vector<std::shared_ptr<GeocodingResult> > > ReverseGeocodingService::calculateAddressesBatch(const std::vector<std::shared_ptr<ReverseGeocodingRequest> >& requests) const {
+        std::vector<std::vector<std::shared_ptr<GeocodingResult> > > results;
+        results.reserve(requests.size());
+        for (const std::shared_ptr<ReverseGeocodingRequest>& request : requests) {
+            if (!request) {
+                throw NullArgumentException("Null request");
+            }
+            results.push_back(calculateAddresses(request));
+        }
+        return results;
+    }
+
 }
 
 #endif
@@ -43,6 +43,15 @@ namespace carto {
          */
         virtual std::vector<std::shared_ptr<GeocodingResult> > calculateAddresses(const std::shared_ptr<ReverseGeocodingRequest>& request) const = 0;
 
+        /**
+         * Calculates matching addresses for a batch of reverse geocoding requests.
+         * The default implementation calls calculateAddresses for each request, offline services process the batch in spatial order.
+         * @param requests The list of reverse geocoding requests to use.
+         * @result The list of geocoding results for each request, in the same order as the requests.
+         * @throws std::runtime_error If IO error occured during the calculation.
+         */
+        virtual std::vector<std::vector<std::shared_ptr<GeocodingResult> > > calculateAddressesBatch(const std::vector<std::shared_ptr<ReverseGeocodingRequest> >& requests) const;
+
     protected:
         /**
          * The default constructor.
@@ -10,6 +10,7 @@
 #include "projections/Projection.h"
 #include "utils/GeneralUtils.h"
 #include "utils/Log.h"
+#include "utils/JSONUtils.h"
 
 #include <boost/lexical_cast.hpp>
 
@@ -19,7 +20,7 @@ namespace carto {
 
     std::vector<std::shared_ptr<GeocodingResult> > TomTomGeocodingProxy::ReadResponse(const std::string& responseString, const std::shared_ptr<Projection>& proj) {
         picojson::value response;
-        std::string err = picojson::parse(response, responseString);
+        std::string err = JSONUtils::ParsePicoJSON(response, responseString);
         if (!err.empty()) {
             throw GenericException("Failed to parse response", err);
         }
@@ -19,6 +19,7 @@ namespace carto {
         _language(),
         _maxResults(10),
         _serviceURL(),
+        _autocompleteSession(std::make_shared<ServiceResponseCache::Session>()),
         _mutex()
     {
     }
@@ -71,18 +72,25 @@ namespace carto {
             throw NullArgumentException("Null request");
         }
 
-        if (request->getQuery().empty()) {
+        // Equivalent queries share the cached response
+        std::string query = GeneralUtils::NormalizeWhitespace(request->getQuery());
+        if (query.empty()) {
             return std::vector<std::shared_ptr<GeocodingResult> >();
         }
 
         std::string baseURL;
 
+        std::shared_ptr<ServiceResponseCache::Session> session;
         std::map<std::string, std::string> params;
         {
             std::lock_guard<std::mutex> lock(_mutex);
 
+            if (_autocomplete) {
+                session = _autocompleteSession;
+            }
+
             std::map<std::string, std::string> tagMap;
-            tagMap["query"] = NetworkUtils::URLEncode(request->getQuery());
+            tagMap["query"] = NetworkUtils::URLEncode(query);
             tagMap["api_key"] = NetworkUtils::URLEncode(_apiKey);
 
             baseURL = GeneralUtils::ReplaceTags(_serviceURL.empty() ? TOMTOM_SERVICE_URL : _serviceURL, tagMap);
@@ -110,7 +118,11 @@ namespace carto {
         Log::Debugf("TomTomOnlineGeocodingService::calculateAddresses: Loading %s", url.c_str());
 
         std::string responseString;
-        if (!NetworkUtils::GetHTTP(url, responseString, Log::IsShowDebug())) {
+        int code = ServiceResponseCache::GetInstance().get(url, responseString, session, Log::IsShowDebug());
+        if (code == ServiceResponseCache::REQUEST_SUPERSEDED) {
+            return std::vector<std::shared_ptr<GeocodingResult> >(); // a later autocomplete query replaced this one
+        }
+        if (code != 0) {
             throw NetworkException("Failed to fetch response");
         }
         return TomTomGeocodingProxy::ReadResponse(responseString, request->getProjection());
@@ -6,6 +6,7 @@
 #include "geocoding/TomTomGeocodingProxy.h"
 #include "projections/Projection.h"
 #include "utils/GeneralUtils.h"
+#include "network/ServiceResponseCache.h"
 #include "utils/NetworkUtils.h"
 #include "utils/Log.h"
 
@@ -73,7 +74,7 @@ namespace carto {
         Log::Debugf("TomTomOnlineReverseGeocodingService::calculateAddresses: Loading %s", url.c_str());
 
         std::string responseString;
-        if (!NetworkUtils::GetHTTP(url, responseString, Log::IsShowDebug())) {
+        if (ServiceResponseCache::GetInstance().get(url, responseString, std::shared_ptr<ServiceResponseCache::Session>(), Log::IsShowDebug()) != 0) {
             throw NetworkException("Failed to fetch response");
         }
         return TomTomGeocodingProxy::ReadResponse(responseString, request->getProjection());
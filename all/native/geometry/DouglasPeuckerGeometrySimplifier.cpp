@@ -12,6 +12,7 @@
 #include "utils/Const.h"
 
 #include <stack>
+#include <limits>
 #include <utility>
 #include <algorithm>
 
@@ -22,27 +23,44 @@ namespace carto {
         Helper(const std::shared_ptr<Projection>& projection, const std::shared_ptr<ProjectionSurface>& projectionSurface) : _projection(projection), _projectionSurface(projectionSurface) {
         }
 
-        void approximate(const MapPos* points, std::size_t pointCount, double minDist, unsigned char* keys) const {
+        std::vector<double> calculateSignificances(const std::vector<MapPos>& ring) const {
+            std::vector<double> significances(ring.size(), 0.0);
+            if (ring.empty()) {
+                return significances;
+            }
+            significances.front() = std::numeric_limits<double>::infinity();
+            significances.back() = std::numeric_limits<double>::infinity();
+
+            // Surface positions are calculated once, the recursion only works on the contiguous position array
+            std::vector<MapPos> internalPoses(ring.size());
+            _projection->toInternalPoses(ring.data(), internalPoses.data(), ring.size());
+            std::vector<cglib::vec3<double> > positions(ring.size());
+            _projectionSurface->calculatePositions(internalPoses.data(), positions.data(), ring.size());
+
+            // Significance of a key vertex is limited by the significance of its parent, so that filtering by any tolerance gives the same result as the recursive algorithm
             std::stack<SubPoly> stack;
-            stack.push(SubPoly(0, pointCount - 1));
+            stack.push(SubPoly(0, positions.size() - 1, std::numeric_limits<double>::infinity()));
             while (!stack.empty()) {
                 SubPoly subPoly = stack.top();
                 stack.pop();
-                KeyInfo keyInfo = findKey(points, subPoly.first, subPoly.last);
-                if (keyInfo.index && minDist < keyInfo.dist) {
-                    keys[keyInfo.index] = 1;
-                    stack.push(SubPoly(keyInfo.index, subPoly.last));
-                    stack.push(SubPoly(subPoly.first, keyInfo.index));
+                KeyInfo keyInfo = findKey(positions.data(), subPoly.first, subPoly.last);
+                if (keyInfo.index) {
+                    double significance = std::min(keyInfo.dist, subPoly.significance);
+                    significances[keyInfo.index] = significance;
+                    stack.push(SubPoly(keyInfo.index, subPoly.last, significance));
+                    stack.push(SubPoly(subPoly.first, keyInfo.index, significance));
                 }
             }
+            return significances;
         }
 
     private:
         struct SubPoly {
-            SubPoly(std::size_t first = 0, std::size_t last = 0) : first(first), last(last) { }
+            SubPoly(std::size_t first = 0, std::size_t last = 0, double significance = 0) : first(first), last(last), significance(significance) { }
 
             std::size_t first;
             std::size_t last;
+            double significance;
         };
 
         struct KeyInfo {
@@ -70,14 +88,13 @@ namespace carto {
             return cglib::length(pProj - p);
         }
 
-        KeyInfo findKey(const MapPos* points, std::size_t first, std::size_t last) const {
+        static KeyInfo findKey(const cglib::vec3<double>* positions, std::size_t first, std::size_t last) {
             KeyInfo keyInfo;
 
-            cglib::vec3<double> s1 = _projectionSurface->calculatePosition(_projection->toInternal(points[first]));
-            cglib::vec3<double> s2 = _projectionSurface->calculatePosition(_projection->toInternal(points[last]));
+            const cglib::vec3<double>& s1 = positions[first];
+            const cglib::vec3<double>& s2 = positions[last];
             for (std::size_t current = first + 1; current < last; current++) {
-                cglib::vec3<double> p = _projectionSurface->calculatePosition(_projection->toInternal(points[current]));
-                double dist = FindSegmentDistance(s1, s2, p);
+                double dist = FindSegmentDistance(s1, s2, positions[current]);
                 if (dist < keyInfo.dist) {
                     continue;
                 }
@@ -93,38 +110,51 @@ namespace carto {
 
     DouglasPeuckerGeometrySimplifier::DouglasPeuckerGeometrySimplifier(float tolerance) :
         GeometrySimplifier(),
-        _tolerance(tolerance)
+        _tolerance(tolerance),
+        _significanceCache(SIGNIFICANCE_CACHE_SIZE),
+        _mutex()
     {
     }
 
     std::shared_ptr<Geometry> DouglasPeuckerGeometrySimplifier::simplify(const std::shared_ptr<Geometry>& geometry, const std::shared_ptr<Projection>& projection, const std::shared_ptr<ProjectionSurface>& projectionSurface, float scale) const {
+        double minDist = scale * _tolerance;
         if (auto lineGeometry = std::dynamic_pointer_cast<LineGeometry>(geometry)) {
-            std::vector<MapPos> mapPoses = simplifyRing(lineGeometry->getPoses(), projection, projectionSurface, scale);
+            const std::vector<MapPos>& poses = lineGeometry->getPoses();
+            if (poses.size() <= 2) {
+                return geometry;
+            }
+            std::shared_ptr<const Significances> significances = getSignificances(geometry, &poses, 1, projection, projectionSurface);
+            std::vector<MapPos> mapPoses = SimplifyRing(poses, significances->ringSignificances.at(0), minDist);
             if (mapPoses.size() < 2) {
                 return std::shared_ptr<Geometry>();
             }
-            bool simplified = mapPoses.size() < lineGeometry->getPoses().size();
+            bool simplified = mapPoses.size() < poses.size();
             if (simplified) {
-                return std::make_shared<LineGeometry>(mapPoses);
+                return std::make_shared<LineGeometry>(std::move(mapPoses));
             }
         } else if (auto polygonGeometry = std::dynamic_pointer_cast<PolygonGeometry>(geometry)) {
-            std::vector<MapPos> mapPoses = simplifyRing(polygonGeometry->getPoses(), projection, projectionSurface, scale);
+            const std::vector<std::vector<MapPos> >& rings = polygonGeometry->getRings();
+            if (rings.empty()) {
+                return geometry;
+            }
+            std::shared_ptr<const Significances> significances = getSignificances(geometry, rings.data(), rings.size(), projection, projectionSurface);
+            std::vector<MapPos> mapPoses = SimplifyRing(rings[0], significances->ringSignificances.at(0), minDist);
             if (mapPoses.size() < 3) {
                 return std::shared_ptr<Geometry>();
             }
-            bool simplified = mapPoses.size() < polygonGeometry->getPoses().size();
+            bool simplified = mapPoses.size() < rings[0].size();
             std::vector<std::vector<MapPos> > holes;
-            for (const std::vector<MapPos>& holeRing : polygonGeometry->getHoles()) {
-                std::vector<MapPos> holeMapPoses = simplifyRing(holeRing, projection, projectionSurface, scale);
-                if (holeMapPoses.size() < holeRing.size()) {
+            for (std::size_t i = 1; i < rings.size(); i++) {
+                std::vector<MapPos> holeMapPoses = SimplifyRing(rings[i], significances->ringSignificances.at(i), minDist);
+                if (holeMapPoses.size() < rings[i].size()) {
                     simplified = true;
                 }
-                if (holes.size() >= 3) {
+                if (holeMapPoses.size() >= 3) {
                     holes.push_back(std::move(holeMapPoses));
                 }
             }
             if (simplified) {
-                return std::make_shared<PolygonGeometry>(mapPoses, holes);
+                return std::make_shared<PolygonGeometry>(std::move(mapPoses), std::move(holes));
             }
         } else if (auto multiLineGeometry = std::dynamic_pointer_cast<MultiLineGeometry>(geometry)) {
             std::vector<std::shared_ptr<LineGeometry> > lines;
@@ -169,45 +199,51 @@ namespace carto {
                 }
             }
             if (simplified) {
-                return std::make_shared<MultiGeometry>(geoms);
+                return std::make_shared<MultiGeometry>(std::move(geoms));
             }
         }
         return geometry;
     }
 
-    std::vector<MapPos> DouglasPeuckerGeometrySimplifier::simplifyRing(const std::vector<MapPos>& ring, const std::shared_ptr<Projection>& projection, const std::shared_ptr<ProjectionSurface>& projectionSurface, float scale) const {
-        if (ring.size() <= 2) {
-            return ring;
-        }
-
-        std::vector<MapPos> simplifiedRing1;
-        simplifiedRing1.reserve(ring.size());
-        simplifiedRing1.push_back(ring.front());
-        cglib::vec3<double> pos0 = projectionSurface->calculatePosition(projection->toInternal(simplifiedRing1.back()));
-        for (std::size_t i = 1; i + 1 < ring.size(); i++) {
-            cglib::vec3<double> pos1 = projectionSurface->calculatePosition(projection->toInternal(ring[i]));
-            double dist = cglib::length(pos1 - pos0); // NOTE: not really correct on spherical surface but, but should still give reasonable results
-            if (dist > scale * _tolerance) {
-                simplifiedRing1.push_back(ring[i]);
-                pos0 = pos1;
+    std::shared_ptr<const DouglasPeuckerGeometrySimplifier::Significances> DouglasPeuckerGeometrySimplifier::getSignificances(const std::shared_ptr<Geometry>& geometry, const std::vector<MapPos>* rings, std::size_t ringCount, const std::shared_ptr<Projection>& projection, const std::shared_ptr<ProjectionSurface>& projectionSurface) const {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            std::shared_ptr<const Significances> significances;
+            if (_significanceCache.read(geometry.get(), significances)) {
+                // The address of a released geometry may be reused, so check that the entry belongs to the same geometry
+                if (significances->geometry.lock() == geometry && significances->projection == projection && significances->projectionSurface == projectionSurface) {
+                    return significances;
+                }
             }
         }
-        simplifiedRing1.push_back(ring.back());
 
-        std::vector<unsigned char> keys(simplifiedRing1.size(), 0);
-        keys.front() = 1;
-        keys.back() = 1;
+        auto significances = std::make_shared<Significances>();
+        significances->geometry = geometry;
+        significances->projection = projection;
+        significances->projectionSurface = projectionSurface;
         Helper helper(projection, projectionSurface);
-        helper.approximate(simplifiedRing1.data(), simplifiedRing1.size(), scale * _tolerance, &keys[0]);
-        std::vector<MapPos> simplifiedRing2;
-        simplifiedRing2.reserve(std::count(keys.begin(), keys.end(), 1));
-        for (std::size_t i = 0; i < simplifiedRing1.size(); i++) {
-            if (keys[i] == 1) {
-                simplifiedRing2.push_back(simplifiedRing1[i]);
-            }
+        std::size_t vertexCount = 0;
+        for (std::size_t i = 0; i < ringCount; i++) {
+            significances->ringSignificances.push_back(helper.calculateSignificances(rings[i]));
+            vertexCount += rings[i].size();
         }
 
-        return simplifiedRing2;
+        std::lock_guard<std::mutex> lock(_mutex);
+        _significanceCache.put(geometry.get(), significances, vertexCount * sizeof(double));
+        return significances;
     }
 
+    std::vector<MapPos> DouglasPeuckerGeometrySimplifier::SimplifyRing(const std::vector<MapPos>& ring, const std::vector<double>& significances, double minDist) {
+        std::vector<MapPos> simplifiedRing;
+        simplifiedRing.reserve(ring.size());
+        for (std::size_t i = 0; i < ring.size(); i++) {
+            if (significances[i] > minDist) {
+                simplifiedRing.push_back(ring[i]);
+            }
+        }
+        return simplifiedRing;
+    }
+
+    const std::size_t DouglasPeuckerGeometrySimplifier::SIGNIFICANCE_CACHE_SIZE = 8 * 1024 * 1024;
+
 }
@@ -9,16 +9,21 @@
 
 #include "geometry/GeometrySimplifier.h"
 
+#include <memory>
+#include <mutex>
 #include <vector>
 
+#include <stdext/timed_lru_cache.h>
+
 namespace carto {
     class MapPos;
 
     /**
      * An implementation of Ramer-Douglas-Peucker algorithm for geometry simplification.
      * Simplifier works on lines and polygons.
-     * Simplification is done in two passes - first pass uses fast Radial Distance vertex rejection,
-     * second pass uses Ramer-Douglas-Peuckerworst algorithm (with worst case quadratic complexity).
+     * The significance of each vertex (the tolerance at which the vertex would be removed) is calculated once per geometry
+     * using Ramer-Douglas-Peucker algorithm (with worst case quadratic complexity) and cached,
+     * so simplifying the same geometry for different zoom levels only requires a linear pass over the vertices.
      */
     class DouglasPeuckerGeometrySimplifier : public GeometrySimplifier {
     public:
@@ -33,9 +38,23 @@ namespace carto {
     private:
         class Helper;
 
-        std::vector<MapPos> simplifyRing(const std::vector<MapPos>& ring, const std::shared_ptr<Projection>& projection, const std::shared_ptr<ProjectionSurface>& projectionSurface, float scale) const;
+        struct Significances {
+            std::weak_ptr<Geometry> geometry;
+            std::shared_ptr<Projection> projection;
+            std::shared_ptr<ProjectionSurface> projectionSurface;
+            std::vector<std::vector<double> > ringSignificances;
+        };
+
+        std::shared_ptr<const Significances> getSignificances(const std::shared_ptr<Geometry>& geometry, const std::vector<MapPos>* rings, std::size_t ringCount, const std::shared_ptr<Projection>& projection, const std::shared_ptr<ProjectionSurface>& projectionSurface) const;
+
+        static std::vector<MapPos> SimplifyRing(const std::vector<MapPos>& ring, const std::vector<double>& significances, double minDist);
+
+        static const std::size_t SIGNIFICANCE_CACHE_SIZE;
 
         const float _tolerance;
+
+        mutable cache::timed_lru_cache<const Geometry*, std::shared_ptr<const Significances> > _significanceCache;
+        mutable std::mutex _mutex;
     };
 }
 
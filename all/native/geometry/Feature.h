@@ -31,13 +31,13 @@ namespace carto {
          * Returns the geometry of the feature.
          * @return The geometry of the feature.
          */
-        const std::shared_ptr<Geometry>& getGeometry() const;
+        virtual const std::shared_ptr<Geometry>& getGeometry() const;
     
         /**
          * Returns the properties of the feature.
          * @return The properties of the feature.
          */
-        const Variant& getProperties() const;
+        virtual const Variant& getProperties() const;
     
     protected:
         const std::shared_ptr<Geometry> _geometry;
@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_GEOJSONFEATURELISTENER_H_
+#define _CARTO_GEOJSONFEATURELISTENER_H_
+
+#include <memory>
+
+namespace carto {
+    class Feature;
+    
+    /**
+     * Listener for features read incrementally from a GeoJSON feature collection.
+     */
+    class GeoJSONFeatureListener {
+    public:
+        virtual ~GeoJSONFeatureListener() { }
+    
+        /**
+         * Listener method that gets called for each feature once it has been read.
+         * This method is called from the thread that reads the feature collection.
+         * @param feature The feature that was read.
+         * @return True if reading should continue, false if reading should stop.
+         */
+        virtual bool onFeatureRead(const std::shared_ptr<Feature>& feature) { return true; }
+    };
+    
+}
+
+#endif
@@ -2,6 +2,7 @@
 #include "components/Exceptions.h"
 #include "geometry/Feature.h"
 #include "geometry/FeatureCollection.h"
+#include "geometry/GeoJSONFeatureListener.h"
 #include "geometry/Geometry.h"
 #include "geometry/PointGeometry.h"
 #include "geometry/LineGeometry.h"
@@ -13,10 +14,15 @@
 #include "projections/Projection.h"
 #include "utils/Log.h"
 
+#include <cstdio>
 #include <stdexcept>
 
 #include <rapidjson/rapidjson.h>
 #include <rapidjson/document.h>
+#include <rapidjson/reader.h>
+#include <rapidjson/writer.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/filereadstream.h>
 #include <rapidjson/error/en.h>
 
 namespace {
@@ -53,6 +59,131 @@ namespace {
 
 namespace carto {
 
+    class GeoJSONGeometryReader::FeatureCollectionHandler {
+    public:
+        FeatureCollectionHandler(const GeoJSONGeometryReader& reader, const std::shared_ptr<GeoJSONFeatureListener>& listener) :
+            _reader(reader), _listener(listener), _depth(0), _inFeatures(false), _stopped(false), _featureCount(0), _key(), _type(), _featureBuffer(), _featureWriter() { }
+
+        bool isStopped() const { return _stopped; }
+        int getFeatureCount() const { return _featureCount; }
+        const std::string& getType() const { return _type; }
+
+        bool Null() { return _featureWriter ? _featureWriter->Null() : checkValue(); }
+        bool Bool(bool b) { return _featureWriter ? _featureWriter->Bool(b) : checkValue(); }
+        bool Int(int i) { return _featureWriter ? _featureWriter->Int(i) : checkValue(); }
+        bool Uint(unsigned int i) { return _featureWriter ? _featureWriter->Uint(i) : checkValue(); }
+        bool Int64(std::int64_t i) { return _featureWriter ? _featureWriter->Int64(i) : checkValue(); }
+        bool Uint64(std::uint64_t i) { return _featureWriter ? _featureWriter->Uint64(i) : checkValue(); }
+        bool Double(double d) { return _featureWriter ? _featureWriter->Double(d) : checkValue(); }
+        bool RawNumber(const char* str, rapidjson::SizeType length, bool copy) { return _featureWriter ? _featureWriter->String(str, length, copy) : checkValue(); } // NOTE: only used with kParseNumbersAsStringsFlag
+
+        bool String(const char* str, rapidjson::SizeType length, bool copy) {
+            if (_featureWriter) {
+                return _featureWriter->String(str, length, copy);
+            }
+            if (_depth == 1 && _key == "type") {
+                _type.assign(str, length);
+            }
+            return checkValue();
+        }
+
+        bool Key(const char* str, rapidjson::SizeType length, bool copy) {
+            if (_featureWriter) {
+                return _featureWriter->Key(str, length, copy);
+            }
+            if (_depth == 1) {
+                _key.assign(str, length);
+            }
+            return true;
+        }
+
+        bool StartObject() {
+            if (!_featureWriter && _inFeatures && _depth == 2) {
+                // Start of the next feature, buffer it and parse it once complete
+                _featureBuffer.Clear();
+                _featureWriter.reset(new rapidjson::Writer<rapidjson::StringBuffer>(_featureBuffer));
+            }
+            if (!_featureWriter && _depth == 0) {
+                _depth++;
+                return true;
+            }
+            _depth++;
+            return _featureWriter ? _featureWriter->StartObject() : true;
+        }
+
+        bool EndObject(rapidjson::SizeType memberCount) {
+            _depth--;
+            if (!_featureWriter) {
+                return true;
+            }
+            if (!_featureWriter->EndObject(memberCount)) {
+                return false;
+            }
+            if (_depth > 2) {
+                return true;
+            }
+            _featureWriter.reset();
+
+            rapidjson::Document featureDoc;
+            if (featureDoc.Parse<rapidjson::kParseDefaultFlags>(_featureBuffer.GetString()).HasParseError()) {
+                throw ParseException(rapidjson::GetParseError_En(featureDoc.GetParseError()), _featureBuffer.GetString(), static_cast<int>(featureDoc.GetErrorOffset()));
+            }
+            std::shared_ptr<Feature> feature = _reader.readFeature(featureDoc);
+            _featureCount++;
+            if (!_listener->onFeatureRead(feature)) {
+                _stopped = true;
+                return false;
+            }
+            return true;
+        }
+
+        bool StartArray() {
+            if (_featureWriter) {
+                _depth++;
+                return _featureWriter->StartArray();
+            }
+            checkValue();
+            if (_depth == 1 && _key == "features") {
+                _inFeatures = true;
+            }
+            _depth++;
+            return true;
+        }
+
+        bool EndArray(rapidjson::SizeType elementCount) {
+            _depth--;
+            if (_featureWriter) {
+                return _featureWriter->EndArray(elementCount);
+            }
+            if (_depth == 1) {
+                _inFeatures = false;
+            }
+            return true;
+        }
+
+    private:
+        bool checkValue() const {
+            if (_depth == 0) {
+                throw ParseException("Wrong JSON type for feature collection");
+            }
+            if (_inFeatures && _depth == 2) {
+                throw ParseException("Wrong JSON type for feature");
+            }
+            return true;
+        }
+
+        const GeoJSONGeometryReader& _reader;
+        std::shared_ptr<GeoJSONFeatureListener> _listener;
+        int _depth;
+        bool _inFeatures;
+        bool _stopped;
+        int _featureCount;
+        std::string _key;
+        std::string _type;
+        rapidjson::StringBuffer _featureBuffer;
+        std::unique_ptr<rapidjson::Writer<rapidjson::StringBuffer> > _featureWriter;
+    };
+
     GeoJSONGeometryReader::GeoJSONGeometryReader() :
         _targetProjection(),
         _mutex()
@@ -105,6 +236,54 @@ namespace carto {
         return readFeatureCollection(featureCollectionDoc);
     }
 
+    int GeoJSONGeometryReader::readFeatureCollectionFeatures(const std::string& geoJSON, const std::shared_ptr<GeoJSONFeatureListener>& listener) const {
+        if (!listener) {
+            throw NullArgumentException("Null listener");
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        FeatureCollectionHandler handler(*this, listener);
+        rapidjson::Reader reader;
+        rapidjson::StringStream stream(geoJSON.c_str());
+        rapidjson::ParseResult result = reader.Parse<rapidjson::kParseDefaultFlags>(stream, handler);
+        if (result.IsError() && !handler.isStopped()) {
+            std::string err = rapidjson::GetParseError_En(result.Code());
+            throw ParseException(err, geoJSON, static_cast<int>(result.Offset()));
+        }
+        if (!handler.isStopped() && handler.getType() != "FeatureCollection") {
+            throw ParseException(handler.getType().empty() ? "Missing type information from feature collection" : "Illegal type for the feature collection");
+        }
+        return handler.getFeatureCount();
+    }
+
+    int GeoJSONGeometryReader::readFeatureCollectionFeaturesFromFile(const std::string& fileName, const std::shared_ptr<GeoJSONFeatureListener>& listener) const {
+        if (!listener) {
+            throw NullArgumentException("Null listener");
+        }
+
+        std::shared_ptr<std::FILE> file(std::fopen(fileName.c_str(), "rb"), [](std::FILE* file) { if (file) { std::fclose(file); } });
+        if (!file) {
+            throw FileException("Failed to open file", fileName);
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        FeatureCollectionHandler handler(*this, listener);
+        std::vector<char> readBuffer(FILE_READ_BUFFER_SIZE);
+        rapidjson::Reader reader;
+        rapidjson::FileReadStream stream(file.get(), readBuffer.data(), readBuffer.size());
+        rapidjson::ParseResult result = reader.Parse<rapidjson::kParseDefaultFlags>(stream, handler);
+        if (result.IsError() && !handler.isStopped()) {
+            std::string err = rapidjson::GetParseError_En(result.Code());
+            throw ParseException(err, fileName);
+        }
+        if (!handler.isStopped() && handler.getType() != "FeatureCollection") {
+            throw ParseException(handler.getType().empty() ? "Missing type information from feature collection" : "Illegal type for the feature collection");
+        }
+        return handler.getFeatureCount();
+    }
+
     std::shared_ptr<FeatureCollection> GeoJSONGeometryReader::readFeatureCollection(const rapidjson::Value& value) const {
         if (!value.IsObject()) {
             throw ParseException("Wrong JSON type for feature collection");
@@ -207,7 +386,7 @@ namespace carto {
             for (rapidjson::SizeType i = 0; i < geometries.Size(); i++) {
                 geometryList.push_back(readGeometry(geometries[i]));
             }
-            return std::make_shared<MultiGeometry>(geometryList);
+            return std::make_shared<MultiGeometry>(std::move(geometryList));
         } else {
             throw ParseException("Unsupported geometry type: " + type);
         }
@@ -255,4 +434,6 @@ namespace carto {
         return rings;
     }
 
+    const std::size_t GeoJSONGeometryReader::FILE_READ_BUFFER_SIZE = 64 * 1024;
+
 }
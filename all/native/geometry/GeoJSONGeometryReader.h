@@ -26,6 +26,7 @@ namespace rapidjson {
 namespace carto {
     class Feature;
     class FeatureCollection;
+    class GeoJSONFeatureListener;
     class Geometry;
     class Projection;
 
@@ -78,7 +79,33 @@ namespace carto {
          */
         std::shared_ptr<FeatureCollection> readFeatureCollection(const std::string& geoJSON) const;
 
+        /**
+         * Reads features of the feature collection from the specified GeoJSON string incrementally.
+         * Unlike readFeatureCollection, the collection is not built in memory, each feature is passed to the listener as soon as it is read.
+         * The listener must not call the methods of this reader.
+         * @param geoJSON The GeoJSON string containing the feature collection.
+         * @param listener The listener that receives the features.
+         * @return The number of features read.
+         * @throws std::runtime_error If string could not be parsed.
+         */
+        int readFeatureCollectionFeatures(const std::string& geoJSON, const std::shared_ptr<GeoJSONFeatureListener>& listener) const;
+
+        /**
+         * Reads features of the feature collection from the specified GeoJSON file incrementally.
+         * The file is parsed in small chunks, so memory usage does not depend on the size of the file.
+         * The listener must not call the methods of this reader.
+         * @param fileName The full path of the GeoJSON file containing the feature collection.
+         * @param listener The listener that receives the features.
+         * @return The number of features read.
+         * @throws std::runtime_error If the file could not be opened or parsed.
+         */
+        int readFeatureCollectionFeaturesFromFile(const std::string& fileName, const std::shared_ptr<GeoJSONFeatureListener>& listener) const;
+
     private:
+        class FeatureCollectionHandler;
+
+        static const std::size_t FILE_READ_BUFFER_SIZE;
+
         std::shared_ptr<FeatureCollection> readFeatureCollection(const rapidjson::Value& value) const;
         std::shared_ptr<Feature> readFeature(const rapidjson::Value& value) const;
         std::shared_ptr<Geometry> readGeometry(const rapidjson::Value& value) const;
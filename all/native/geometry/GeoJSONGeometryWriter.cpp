@@ -11,20 +11,24 @@
 #include "geometry/MultiLineGeometry.h"
 #include "geometry/MultiPolygonGeometry.h"
 #include "projections/Projection.h"
+#include "utils/GeneralUtils.h"
 #include "utils/Log.h"
 
+#include <algorithm>
+#include <cstdio>
 #include <stdexcept>
 
 #include <rapidjson/rapidjson.h>
 #include <rapidjson/writer.h>
 #include <rapidjson/stringbuffer.h>
-#include <rapidjson/document.h>
+#include <rapidjson/filewritestream.h>
 
 namespace carto {
 
     GeoJSONGeometryWriter::GeoJSONGeometryWriter() :
         _sourceProjection(),
         _z(false),
+        _precision(-1),
         _mutex()
     {
     }
@@ -49,6 +53,16 @@ namespace carto {
         _z = z;
     }
 
+    int GeoJSONGeometryWriter::getPrecision() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _precision;
+    }
+
+    void GeoJSONGeometryWriter::setPrecision(int precision) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _precision = std::max(-1, precision);
+    }
+
     std::string GeoJSONGeometryWriter::writeGeometry(const std::shared_ptr<Geometry>& geometry) const {
         if (!geometry) {
             throw NullArgumentException("Null geometry");
@@ -58,10 +72,8 @@ namespace carto {
 
         rapidjson::StringBuffer geoJSON;
         rapidjson::Writer<rapidjson::StringBuffer> writer(geoJSON);
-        rapidjson::Document doc;
-        writeGeometry(geometry, doc, doc.GetAllocator());
-        doc.Accept(writer);
-        return geoJSON.GetString();
+        writeGeometry(geometry, writer);
+        return std::string(geoJSON.GetString(), geoJSON.GetSize());
     }
 
     std::string GeoJSONGeometryWriter::writeFeature(const std::shared_ptr<Feature>& feature) const {
@@ -73,10 +85,8 @@ namespace carto {
 
         rapidjson::StringBuffer geoJSON;
         rapidjson::Writer<rapidjson::StringBuffer> writer(geoJSON);
-        rapidjson::Document doc;
-        writeFeature(feature, doc, doc.GetAllocator());
-        doc.Accept(writer);
-        return geoJSON.GetString();
+        writeFeature(*feature, writer);
+        return std::string(geoJSON.GetString(), geoJSON.GetSize());
     }
 
     std::string GeoJSONGeometryWriter::writeFeatureCollection(const std::shared_ptr<FeatureCollection>& featureCollection) const {
@@ -88,124 +98,179 @@ namespace carto {
 
         rapidjson::StringBuffer geoJSON;
         rapidjson::Writer<rapidjson::StringBuffer> writer(geoJSON);
-        rapidjson::Document doc;
-        writeFeatureCollection(featureCollection, doc, doc.GetAllocator());
-        doc.Accept(writer);
-        return geoJSON.GetString();
-    }
-
-    void GeoJSONGeometryWriter::writeFeatureCollection(const std::shared_ptr<FeatureCollection>& featureCollection, rapidjson::Value& value, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>& allocator) const {
-        value.SetObject();
-        value.AddMember("type", "FeatureCollection", allocator);
-        rapidjson::Value featuresValue;
-        featuresValue.SetArray();
-        for (int i = 0; i < featureCollection->getFeatureCount(); i++) {
-            featuresValue.PushBack(rapidjson::Value(), allocator);
-            writeFeature(featureCollection->getFeature(i), featuresValue[i], allocator);
+        writeFeatureCollection(*featureCollection, writer);
+        return std::string(geoJSON.GetString(), geoJSON.GetSize());
+    }
+
+    void GeoJSONGeometryWriter::writeFeatureCollectionToFile(const std::shared_ptr<FeatureCollection>& featureCollection, const std::string& fileName) const {
+        if (!featureCollection) {
+            throw NullArgumentException("Null feature collection");
+        }
+
+        std::shared_ptr<std::FILE> file(std::fopen(fileName.c_str(), "wb"), [](std::FILE* file) { if (file) { std::fclose(file); } });
+        if (!file) {
+            throw FileException("Failed to open file", fileName);
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        std::vector<char> writeBuffer(FILE_WRITE_BUFFER_SIZE);
+        rapidjson::FileWriteStream stream(file.get(), writeBuffer.data(), writeBuffer.size());
+        rapidjson::Writer<rapidjson::FileWriteStream> writer(stream);
+        writeFeatureCollection(*featureCollection, writer);
+        stream.Flush();
+        if (std::ferror(file.get())) {
+            throw FileException("Failed to write file", fileName);
         }
-        value.AddMember("features", featuresValue.Move(), allocator);
     }
 
-    void GeoJSONGeometryWriter::writeFeature(const std::shared_ptr<Feature>& feature, rapidjson::Value& value, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>& allocator) const {
-        value.SetObject();
-        value.AddMember("type", "Feature", allocator);
-        value.AddMember("geometry", rapidjson::Value(), allocator);
-        writeGeometry(feature->getGeometry(), value["geometry"], allocator);
-        value.AddMember("properties", rapidjson::Value(), allocator);
-        writeProperties(feature->getProperties(), value["properties"], allocator);
+    template <typename JSONWriter>
+    void GeoJSONGeometryWriter::writeFeatureCollection(const FeatureCollection& featureCollection, JSONWriter& writer) const {
+        writer.StartObject();
+        writer.Key("type");
+        writer.String("FeatureCollection");
+        writer.Key("features");
+        writer.StartArray();
+        for (int i = 0; i < featureCollection.getFeatureCount(); i++) {
+            writeFeature(*featureCollection.getFeature(i), writer);
+        }
+        writer.EndArray();
+        writer.EndObject();
+    }
+
+    template <typename JSONWriter>
+    void GeoJSONGeometryWriter::writeFeature(const Feature& feature, JSONWriter& writer) const {
+        writer.StartObject();
+        writer.Key("type");
+        writer.String("Feature");
+        writer.Key("geometry");
+        writeGeometry(feature.getGeometry(), writer);
+        writer.Key("properties");
+        WriteProperties(feature.getProperties().toPicoJSON(), writer);
+        writer.EndObject();
     }
 
-    void GeoJSONGeometryWriter::writeGeometry(const std::shared_ptr<Geometry>& geometry, rapidjson::Value& value, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>& allocator) const {
-        value.SetObject();
+    template <typename JSONWriter>
+    void GeoJSONGeometryWriter::writeGeometry(const std::shared_ptr<Geometry>& geometry, JSONWriter& writer) const {
+        writer.StartObject();
+        writer.Key("type");
         if (auto point = std::dynamic_pointer_cast<PointGeometry>(geometry)) {
-            value.AddMember("type", "Point", allocator);
-            value.AddMember("coordinates", rapidjson::Value(), allocator);
-            writePoint(point->getPos(), value["coordinates"], allocator);
+            writer.String("Point");
+            writer.Key("coordinates");
+            writePoint(point->getPos(), writer);
         } else if (auto line = std::dynamic_pointer_cast<LineGeometry>(geometry)) {
-            value.AddMember("type", "LineString", allocator);
-            value.AddMember("coordinates", rapidjson::Value(), allocator);
-            writeRing(line->getPoses(), value["coordinates"], allocator);
+            writer.String("LineString");
+            writer.Key("coordinates");
+            writeRing(line->getPoses(), writer);
         } else if (auto polygon = std::dynamic_pointer_cast<PolygonGeometry>(geometry)) {
-            value.AddMember("type", "Polygon", allocator);
-            value.AddMember("coordinates", rapidjson::Value(), allocator);
-            writeRings(polygon->getRings(), value["coordinates"], allocator);
+            writer.String("Polygon");
+            writer.Key("coordinates");
+            writeRings(polygon->getRings(), writer);
         } else if (auto multiPoint = std::dynamic_pointer_cast<MultiPointGeometry>(geometry)) {
-            value.AddMember("type", "MultiPoint", allocator);
-            value.AddMember("coordinates", rapidjson::Value(), allocator);
-            rapidjson::Value& coordinates = value["coordinates"];
-            coordinates.SetArray();
+            writer.String("MultiPoint");
+            writer.Key("coordinates");
+            writer.StartArray();
             for (int i = 0; i < multiPoint->getGeometryCount(); i++) {
-                coordinates.PushBack(rapidjson::Value(), allocator);
-                writePoint(multiPoint->getGeometry(i)->getPos(), coordinates[i], allocator);
+                writePoint(multiPoint->getGeometry(i)->getPos(), writer);
             }
+            writer.EndArray();
         } else if (auto multiLine = std::dynamic_pointer_cast<MultiLineGeometry>(geometry)) {
-            value.AddMember("type", "MultiLineString", allocator);
-            value.AddMember("coordinates", rapidjson::Value(), allocator);
-            rapidjson::Value& coordinates = value["coordinates"];
-            coordinates.SetArray();
+            writer.String("MultiLineString");
+            writer.Key("coordinates");
+            writer.StartArray();
             for (int i = 0; i < multiLine->getGeometryCount(); i++) {
-                coordinates.PushBack(rapidjson::Value(), allocator);
-                writeRing(multiLine->getGeometry(i)->getPoses(), coordinates[i], allocator);
+                writeRing(multiLine->getGeometry(i)->getPoses(), writer);
             }
+            writer.EndArray();
         } else if (auto multiPolygon = std::dynamic_pointer_cast<MultiPolygonGeometry>(geometry)) {
-            value.AddMember("type", "MultiPolygon", allocator);
-            value.AddMember("coordinates", rapidjson::Value(), allocator);
-            rapidjson::Value& coordinates = value["coordinates"];
-            coordinates.SetArray();
+            writer.String("MultiPolygon");
+            writer.Key("coordinates");
+            writer.StartArray();
             for (int i = 0; i < multiPolygon->getGeometryCount(); i++) {
-                coordinates.PushBack(rapidjson::Value(), allocator);
-                writeRings(multiPolygon->getGeometry(i)->getRings(), coordinates[i], allocator);
+                writeRings(multiPolygon->getGeometry(i)->getRings(), writer);
             }
+            writer.EndArray();
         } else if (auto multiGeometry = std::dynamic_pointer_cast<MultiGeometry>(geometry)) {
-            value.AddMember("type", "GeometryCollection", allocator);
-            value.AddMember("geometries", rapidjson::Value(), allocator);
-            rapidjson::Value& geometries = value["geometries"];
-            geometries.SetArray();
+            writer.String("GeometryCollection");
+            writer.Key("geometries");
+            writer.StartArray();
             for (int i = 0; i < multiGeometry->getGeometryCount(); i++) {
-                geometries.PushBack(rapidjson::Value(), allocator);
-                writeGeometry(multiGeometry->getGeometry(i), geometries[i], allocator);
+                writeGeometry(multiGeometry->getGeometry(i), writer);
             }
+            writer.EndArray();
         } else {
             throw GenerateException("Unsupported geometry type");
         }
+        writer.EndObject();
     }
 
-    void GeoJSONGeometryWriter::writeProperties(const Variant& properties, rapidjson::Value& value, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>& allocator) const {
-        rapidjson::Document propertiesDoc;
-        if (propertiesDoc.Parse<rapidjson::kParseDefaultFlags>(properties.toString().c_str()).HasParseError()) {
-            throw GenerateException("Failed to read properties");
-        }
-
-        value.CopyFrom(propertiesDoc, allocator);
-    }
-
-    void GeoJSONGeometryWriter::writePoint(const MapPos& pos, rapidjson::Value& value, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>& allocator) const {
+    template <typename JSONWriter>
+    void GeoJSONGeometryWriter::writePoint(const MapPos& pos, JSONWriter& writer) const {
         MapPos mapPos(pos);
         if (_sourceProjection) {
             mapPos = _sourceProjection->toWgs84(mapPos);
         }
-        value.SetArray();
-        value.PushBack(rapidjson::Value(mapPos.getX()), allocator);
-        value.PushBack(rapidjson::Value(mapPos.getY()), allocator);
+        writer.StartArray();
+        bool valid = writer.Double(GeneralUtils::RoundDecimals(mapPos.getX(), _precision));
+        valid = writer.Double(GeneralUtils::RoundDecimals(mapPos.getY(), _precision)) && valid;
         if (_z) {
-            value.PushBack(rapidjson::Value(mapPos.getZ()), allocator);
+            valid = writer.Double(GeneralUtils::RoundDecimals(mapPos.getZ(), _precision)) && valid;
+        }
+        writer.EndArray();
+        if (!valid) {
+            throw GenerateException("Invalid coordinate value");
         }
     }
 
-    void GeoJSONGeometryWriter::writeRing(const std::vector<MapPos>& ring, rapidjson::Value& value, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>& allocator) const {
-        value.SetArray();
-        for (rapidjson::SizeType i = 0; i < ring.size(); i++) {
-            value.PushBack(rapidjson::Value(), allocator);
-            writePoint(ring[i], value[i], allocator);
+    template <typename JSONWriter>
+    void GeoJSONGeometryWriter::writeRing(const std::vector<MapPos>& ring, JSONWriter& writer) const {
+        writer.StartArray();
+        for (const MapPos& pos : ring) {
+            writePoint(pos, writer);
         }
+        writer.EndArray();
     }
 
-    void GeoJSONGeometryWriter::writeRings(const std::vector<std::vector<MapPos> >& rings, rapidjson::Value& value, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>& allocator) const {
-        value.SetArray();
-        for (rapidjson::SizeType i = 0; i < rings.size(); i++) {
-            value.PushBack(rapidjson::Value(), allocator);
-            writeRing(rings[i], value[i], allocator);
+    template <typename JSONWriter>
+    void GeoJSONGeometryWriter::writeRings(const std::vector<std::vector<MapPos> >& rings, JSONWriter& writer) const {
+        writer.StartArray();
+        for (const std::vector<MapPos>& ring : rings) {
+            writeRing(ring, writer);
         }
+        writer.EndArray();
     }
 
+    template <typename JSONWriter>
+    void GeoJSONGeometryWriter::WriteProperties(const picojson::value& value, JSONWriter& writer) {
+        if (value.is<picojson::value::object>()) {
+            writer.StartObject();
+            for (const std::pair<const std::string, picojson::value>& member : value.get<picojson::value::object>()) {
+                writer.Key(member.first.data(), static_cast<rapidjson::SizeType>(member.first.size()));
+                WriteProperties(member.second, writer);
+            }
+            writer.EndObject();
+        } else if (value.is<picojson::value::array>()) {
+            writer.StartArray();
+            for (const picojson::value& element : value.get<picojson::value::array>()) {
+                WriteProperties(element, writer);
+            }
+            writer.EndArray();
+        } else if (value.is<std::string>()) {
+            const std::string& str = value.get<std::string>();
+            writer.String(str.data(), static_cast<rapidjson::SizeType>(str.size()));
+        } else if (value.is<bool>()) {
+            writer.Bool(value.get<bool>());
+        } else if (value.is<std::int64_t>()) {
+            writer.Int64(value.get<std::int64_t>());
+        } else if (value.is<double>()) {
+            if (!writer.Double(value.get<double>())) {
+                throw GenerateException("Invalid property value");
+            }
+        } else {
+            writer.Null();
+        }
+    }
+
+    const std::size_t GeoJSONGeometryWriter::FILE_WRITE_BUFFER_SIZE = 64 * 1024;
+
 }
@@ -13,16 +13,8 @@
 #include <memory>
 #include <mutex>
 #include <cstddef>
+#include <string>
 #include <vector>
-#include <stack>
-
-namespace rapidjson {
-    class CrtAllocator;
-    template <typename BaseAllocator> class MemoryPoolAllocator;
-    template<typename CharType> struct UTF8;
-    template <typename Encoding, typename Allocator> class GenericValue;
-    typedef GenericValue<UTF8<char>, MemoryPoolAllocator<CrtAllocator> > Value;
-}
 
 namespace carto {
     class Feature;
@@ -32,7 +24,8 @@ namespace carto {
 
     /**
      * A GeoJSON writer. Generates human-readable GeoJSON representation of the geometry, feature or feature collection.
-     * Supports both 2D and 3D coordinate serialization.
+     * Supports both 2D and 3D coordinate serialization. The output is generated directly, without building
+     * an intermediate JSON document, coordinates use the shortest representation that reads back to the same value.
      */
     class GeoJSONGeometryWriter {
     public:
@@ -66,6 +59,18 @@ namespace carto {
          */
         void setZ(bool z);
 
+        /**
+         * Returns the number of decimal places used for coordinates.
+         * @return The number of decimal places used for coordinates. -1 if coordinates are written with full precision.
+         */
+        int getPrecision() const;
+        /**
+         * Sets the number of decimal places used for coordinates. Coordinates are rounded to the given precision,
+         * for example 7 decimal places of WGS84 coordinates correspond to about 1cm. The default is -1 (full precision).
+         * @param precision The number of decimal places, or -1 for full precision.
+         */
+        void setPrecision(int precision);
+
         /**
          * Creates a GeoJSON string corresponding to the specified geometry.
          * @param geometry The geometry to write.
@@ -90,17 +95,29 @@ namespace carto {
          */
         std::string writeFeatureCollection(const std::shared_ptr<FeatureCollection>& featureCollection) const;
 
+        /**
+         * Writes the GeoJSON representation of the specified feature collection to a file.
+         * The output is written in small chunks, so memory usage does not depend on the size of the collection.
+         * @param featureCollection The feature collection to write.
+         * @param fileName The full path of the output file. An existing file is overwritten.
+         * @throws std::runtime_error If the file could not be written or the GeoJSON could not be generated.
+         */
+        void writeFeatureCollectionToFile(const std::shared_ptr<FeatureCollection>& featureCollection, const std::string& fileName) const;
+
     private:
-        void writeFeatureCollection(const std::shared_ptr<FeatureCollection>& featureCollection, rapidjson::Value& value, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>& allocator) const;
-        void writeFeature(const std::shared_ptr<Feature>& feature, rapidjson::Value& value, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>& allocator) const;
-        void writeGeometry(const std::shared_ptr<Geometry>& geometry, rapidjson::Value& value, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>& allocator) const;
-        void writeProperties(const Variant& properties, rapidjson::Value& value, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>& allocator) const;
-        void writePoint(const MapPos& pos, rapidjson::Value& value, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>& allocator) const;
-        void writeRing(const std::vector<MapPos>& ring, rapidjson::Value& value, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>& allocator) const;
-        void writeRings(const std::vector<std::vector<MapPos> >& rings, rapidjson::Value& value, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>& allocator) const;
+        static const std::size_t FILE_WRITE_BUFFER_SIZE;
+
+        template <typename JSONWriter> void writeFeatureCollection(const FeatureCollection& featureCollection, JSONWriter& writer) const;
+        template <typename JSONWriter> void writeFeature(const Feature& feature, JSONWriter& writer) const;
+        template <typename JSONWriter> void writeGeometry(const std::shared_ptr<Geometry>& geometry, JSONWriter& writer) const;
+        template <typename JSONWriter> void writePoint(const MapPos& pos, JSONWriter& writer) const;
+        template <typename JSONWriter> void writeRing(const std::vector<MapPos>& ring, JSONWriter& writer) const;
+        template <typename JSONWriter> void writeRings(const std::vector<std::vector<MapPos> >& rings, JSONWriter& writer) const;
+        template <typename JSONWriter> static void WriteProperties(const picojson::value& value, JSONWriter& writer);
 
         std::shared_ptr<Projection> _sourceProjection;
         bool _z;
+        int _precision;
 
         mutable std::mutex _mutex;
     };
@@ -10,6 +10,7 @@
 #include "core/MapPos.h"
 #include "core/MapBounds.h"
 
+#include <atomic>
 #include <string>
 
 namespace carto {
@@ -34,11 +35,28 @@ namespace carto {
         const MapBounds& getBounds() const {
             return _bounds;
         }
+
+        /**
+         * Returns the revision of the geometry. Geometries are immutable, each new instance gets a unique revision.
+         * The revision can be used as a key for caching data derived from the geometry.
+         * @return The revision of the geometry.
+         */
+        long long getRevision() const {
+            return _revision;
+        }
     
     protected:
-        Geometry() : _bounds() { }
+        Geometry() : _bounds(), _revision(GenerateRevision()) { }
     
         MapBounds _bounds;
+
+    private:
+        static long long GenerateRevision() {
+            static std::atomic<long long> revisionCounter(0);
+            return ++revisionCounter;
+        }
+
+        long long _revision;
     };
     
 }
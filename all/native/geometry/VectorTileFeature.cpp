@@ -6,7 +6,29 @@ namespace carto {
         Feature(geometry, std::move(properties)),
         _id(id),
         _mapTile(mapTile),
-        _layerName(layerName)
+        _layerName(layerName),
+        _lazy(false),
+        _geometryLoader(),
+        _propertiesLoader(),
+        _loadedGeometry(),
+        _loadedProperties(),
+        _geometryLoaded(),
+        _propertiesLoaded()
+    {
+    }
+
+    VectorTileFeature::VectorTileFeature(long long id, const MapTile& mapTile, const std::string& layerName, std::function<std::shared_ptr<Geometry>()> geometryLoader, std::function<Variant()> propertiesLoader) :
+        Feature(std::shared_ptr<Geometry>(), Variant()),
+        _id(id),
+        _mapTile(mapTile),
+        _layerName(layerName),
+        _lazy(true),
+        _geometryLoader(std::move(geometryLoader)),
+        _propertiesLoader(std::move(propertiesLoader)),
+        _loadedGeometry(),
+        _loadedProperties(),
+        _geometryLoaded(),
+        _propertiesLoaded()
     {
     }
     
@@ -24,5 +46,27 @@ namespace carto {
     const std::string& VectorTileFeature::getLayerName() const {
         return _layerName;
     }
+
+    const std::shared_ptr<Geometry>& VectorTileFeature::getGeometry() const {
+        if (!_lazy) {
+            return Feature::getGeometry();
+        }
+        std::call_once(_geometryLoaded, [this]() {
+            _loadedGeometry = _geometryLoader();
+            _geometryLoader = nullptr;
+        });
+        return _loadedGeometry;
+    }
+
+    const Variant& VectorTileFeature::getProperties() const {
+        if (!_lazy) {
+            return Feature::getProperties();
+        }
+        std::call_once(_propertiesLoaded, [this]() {
+            _loadedProperties = _propertiesLoader();
+            _propertiesLoader = nullptr;
+        });
+        return _loadedProperties;
+    }
     
 }
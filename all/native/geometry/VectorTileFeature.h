@@ -10,8 +10,10 @@
 #include "core/MapTile.h"
 #include "geometry/Feature.h"
 
-#include <string>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
 
 namespace carto {
 
@@ -29,6 +31,16 @@ namespace carto {
          * @param properties The properties of the feature.
          */
         VectorTileFeature(long long id, const MapTile& mapTile, const std::string& layerName, const std::shared_ptr<Geometry>& geometry, Variant properties);
+        /**
+         * Constructs a VectorTileFeature object whose geometry and properties are decoded on first access.
+         * The loaders are called at most once each, and may be called from any thread.
+         * @param id The id of the feature.
+         * @param mapTile The map tile of this feature
+         * @param layerName The name of the layer of the feature.
+         * @param geometryLoader The function creating the geometry of the feature.
+         * @param propertiesLoader The function creating the properties of the feature.
+         */
+        VectorTileFeature(long long id, const MapTile& mapTile, const std::string& layerName, std::function<std::shared_ptr<Geometry>()> geometryLoader, std::function<Variant()> propertiesLoader);
         virtual ~VectorTileFeature();
 
         /**
@@ -48,11 +60,24 @@ namespace carto {
          * @return The layer name of the feature.
          */
         const std::string& getLayerName() const;
+
+        virtual const std::shared_ptr<Geometry>& getGeometry() const;
+
+        virtual const Variant& getProperties() const;
         
     protected:
         const long long _id;
         const MapTile _mapTile;
         const std::string _layerName;
+
+    private:
+        const bool _lazy;
+        mutable std::function<std::shared_ptr<Geometry>()> _geometryLoader;
+        mutable std::function<Variant()> _propertiesLoader;
+        mutable std::shared_ptr<Geometry> _loadedGeometry;
+        mutable Variant _loadedProperties;
+        mutable std::once_flag _geometryLoaded;
+        mutable std::once_flag _propertiesLoaded;
     };
     
 }
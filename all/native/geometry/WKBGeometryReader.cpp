@@ -14,38 +14,40 @@
 #include "geometry/WKBGeometryEnums.h"
 #include "utils/Log.h"
 
+#include <cstring>
 #include <stdexcept>
 
 namespace carto {
 
-    WKBGeometryReader::Stream::Stream(const std::vector<unsigned char>& data) :
+    WKBGeometryReader::Stream::Stream(const unsigned char* data, std::size_t size) :
         _data(data),
+        _size(size),
         _offset(0),
-        _bigEndian()
+        _bigEndian(false)
     {
     }
 
-    void WKBGeometryReader::Stream::pushBigEndian(bool little) {
-        _bigEndian.push(little);
+    bool WKBGeometryReader::Stream::isBigEndian() const {
+        return _bigEndian;
     }
 
-    void WKBGeometryReader::Stream::popBigEndian() {
-        _bigEndian.pop();
+    void WKBGeometryReader::Stream::setBigEndian(bool bigEndian) {
+        _bigEndian = bigEndian;
     }
 
     unsigned char WKBGeometryReader::Stream::readByte() {
-        if (_offset + 1 > _data.size()) {
+        if (_offset + 1 > _size) {
             throw ParseException("Stream array too short, can not read byte");
         }
         return _data[_offset++];
     }
 
     std::uint32_t WKBGeometryReader::Stream::readUInt32() {
-        if (_offset + 4 > _data.size()) {
+        if (_offset + 4 > _size) {
             throw ParseException("Stream array too short, can not read 32-bit word");
         }
         std::uint32_t val = 0;
-        if (_bigEndian.top()) {
+        if (_bigEndian) {
             val = _data[_offset + 0];
             val = (val << 8) | _data[_offset + 1];
             val = (val << 8) | _data[_offset + 2];
@@ -61,11 +63,11 @@ namespace carto {
     }
 
     double WKBGeometryReader::Stream::readDouble() {
-        if (_offset + 8 > _data.size()) {
+        if (_offset + 8 > _size) {
             throw ParseException("Stream array too short, can not read double float");
         }
         std::uint64_t val = 0;
-        if (_bigEndian.top()) {
+        if (_bigEndian) {
             for (int i = 0; i < 8; i++) {
                 val = (val << 8) | _data[_offset + i];
             }
@@ -75,7 +77,9 @@ namespace carto {
             }
         }
         _offset += 8;
-        return *reinterpret_cast<double*>(&val);
+        double result = 0;
+        std::memcpy(&result, &val, sizeof(double));
+        return result;
     }
 
     WKBGeometryReader::WKBGeometryReader() {
@@ -86,13 +90,15 @@ namespace carto {
             throw NullArgumentException("Null wkbData");
         }
 
-        Stream stream(*wkbData->getDataPtr());
+        // Read directly from the data, it may be a view to a larger buffer
+        Stream stream(wkbData->data(), wkbData->size());
         return readGeometry(stream);
     }
 
     std::shared_ptr<Geometry> WKBGeometryReader::readGeometry(Stream& stream) const {
+        bool parentBigEndian = stream.isBigEndian();
         unsigned char bigEndian = stream.readByte();
-        stream.pushBigEndian(bigEndian == WKB_XDR);
+        stream.setBigEndian(bigEndian == WKB_XDR);
 
         std::uint32_t type = stream.readUInt32();
         std::shared_ptr<Geometry> geometry;
@@ -161,14 +167,14 @@ namespace carto {
                         geometries.push_back(geometry);
                     }
                 }
-                geometry = std::make_shared<MultiGeometry>(geometries);
+                geometry = std::make_shared<MultiGeometry>(std::move(geometries));
             }
             break;
         default:
             throw ParseException("Unknown geometry type"); // NOTE: not possible to continue after this
         }
 
-        stream.popBigEndian();
+        stream.setBigEndian(parentBigEndian);
         return geometry;
     }
 
@@ -13,7 +13,6 @@
 
 #include <memory>
 #include <vector>
-#include <stack>
 #include <cstddef>
 
 namespace carto {
@@ -40,19 +39,20 @@ namespace carto {
 
     private:
         struct Stream {
-            Stream(const std::vector<unsigned char>& data);
+            Stream(const unsigned char* data, std::size_t size);
 
-            void pushBigEndian(bool little);
-            void popBigEndian();
+            bool isBigEndian() const;
+            void setBigEndian(bool bigEndian);
 
             unsigned char readByte();
             std::uint32_t readUInt32();
             double readDouble();
         
         private:
-            const std::vector<unsigned char>& _data;
+            const unsigned char* _data;
+            std::size_t _size;
             std::size_t _offset;
-            std::stack<bool> _bigEndian;
+            bool _bigEndian;
         };
 
         std::shared_ptr<Geometry> readGeometry(Stream& stream) const;
@@ -10,13 +10,20 @@
 #include "geometry/MultiPointGeometry.h"
 #include "geometry/MultiLineGeometry.h"
 #include "geometry/MultiPolygonGeometry.h"
-#include "geometry/WKTGeometryGenerator.h"
+#include "utils/GeneralUtils.h"
 #include "utils/Log.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include <rapidjson/internal/dtoa.h>
+
 namespace carto {
 
     WKTGeometryWriter::WKTGeometryWriter() :
         _z(false),
+        _precision(-1),
         _mutex()
     {
     }
@@ -31,6 +38,16 @@ namespace carto {
         _z = z;
     }
 
+    int WKTGeometryWriter::getPrecision() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _precision;
+    }
+
+    void WKTGeometryWriter::setPrecision(int precision) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _precision = std::max(-1, precision);
+    }
+
     std::string WKTGeometryWriter::writeGeometry(const std::shared_ptr<Geometry>& geometry) const {
         if (!geometry) {
             throw NullArgumentException("Null geometry");
@@ -39,15 +56,175 @@ namespace carto {
         std::lock_guard<std::mutex> lock(_mutex);
 
         std::string wkt;
-        std::back_insert_iterator<std::string> it(wkt);
-        WKTGeometryGenerator<std::back_insert_iterator<std::string> > grammar;
-        bool result = boost::spirit::karma::generate(it, grammar(_z), geometry);
-        if (!result) {
-            throw GenerateException("Failed to generate WKT");
-        }
+        wkt.reserve(INITIAL_BUFFER_SIZE);
+        writeGeometry(geometry, wkt);
         return wkt;
     }
 
+    void WKTGeometryWriter::writeGeometry(const std::shared_ptr<Geometry>& geometry, std::string& wkt) const {
+        const char* type = _z ? " Z" : "";
+        if (auto point = std::dynamic_pointer_cast<PointGeometry>(geometry)) {
+            wkt.append("POINT").append(type).append("(");
+            writePos(point->getPos(), wkt);
+            wkt.append(")");
+        } else if (auto line = std::dynamic_pointer_cast<LineGeometry>(geometry)) {
+            wkt.append("LINESTRING").append(type);
+            if (line->getPoses().empty()) {
+                wkt.append(" EMPTY");
+            } else {
+                writeRing(line->getPoses(), wkt);
+            }
+        } else if (auto polygon = std::dynamic_pointer_cast<PolygonGeometry>(geometry)) {
+            wkt.append("POLYGON").append(type);
+            if (polygon->getRings().empty()) {
+                wkt.append(" EMPTY");
+            } else {
+                writeRings(polygon->getRings(), wkt);
+            }
+        } else if (auto multiPoint = std::dynamic_pointer_cast<MultiPointGeometry>(geometry)) {
+            wkt.append("MULTIPOINT").append(type);
+            if (multiPoint->getGeometryCount() == 0) {
+                wkt.append(" EMPTY");
+            } else {
+                wkt.append("(");
+                for (int i = 0; i < multiPoint->getGeometryCount(); i++) {
+                    if (i > 0) {
+                        wkt.append(",");
+                    }
+                    writePos(multiPoint->getGeometry(i)->getPos(), wkt);
+                }
+                wkt.append(")");
+            }
+        } else if (auto multiLine = std::dynamic_pointer_cast<MultiLineGeometry>(geometry)) {
+            wkt.append("MULTILINESTRING").append(type);
+            if (multiLine->getGeometryCount() == 0) {
+                wkt.append(" EMPTY");
+            } else {
+                wkt.append("(");
+                for (int i = 0; i < multiLine->getGeometryCount(); i++) {
+                    if (i > 0) {
+                        wkt.append(",");
+                    }
+                    writeRing(multiLine->getGeometry(i)->getPoses(), wkt);
+                }
+                wkt.append(")");
+            }
+        } else if (auto multiPolygon = std::dynamic_pointer_cast<MultiPolygonGeometry>(geometry)) {
+            wkt.append("MULTIPOLYGON").append(type);
+            if (multiPolygon->getGeometryCount() == 0) {
+                wkt.append(" EMPTY");
+            } else {
+                wkt.append("(");
+                for (int i = 0; i < multiPolygon->getGeometryCount(); i++) {
+                    if (i > 0) {
+                        wkt.append(",");
+                    }
+                    writeRings(multiPolygon->getGeometry(i)->getRings(), wkt);
+                }
+                wkt.append(")");
+            }
+        } else if (auto multiGeometry = std::dynamic_pointer_cast<MultiGeometry>(geometry)) {
+            wkt.append("GEOMETRYCOLLECTION");
+            if (multiGeometry->getGeometryCount() == 0) {
+                wkt.append(" EMPTY");
+            } else {
+                wkt.append("(");
+                for (int i = 0; i < multiGeometry->getGeometryCount(); i++) {
+                    if (i > 0) {
+                        wkt.append(",");
+                    }
+                    writeGeometry(multiGeometry->getGeometry(i), wkt);
+                }
+                wkt.append(")");
+            }
+        } else {
+            throw GenerateException("Unsupported geometry type");
+        }
+    }
+
+    void WKTGeometryWriter::writePos(const MapPos& pos, std::string& wkt) const {
+        writeCoord(pos.getX(), wkt);
+        wkt.append(" ");
+        writeCoord(pos.getY(), wkt);
+        if (_z) {
+            wkt.append(" ");
+            writeCoord(pos.getZ(), wkt);
+        }
+    }
+
+    void WKTGeometryWriter::writeRing(const std::vector<MapPos>& ring, std::string& wkt) const {
+        if (ring.empty()) {
+            throw GenerateException("Empty ring");
+        }
+        wkt.append("(");
+        for (std::size_t i = 0; i < ring.size(); i++) {
+            if (i > 0) {
+                wkt.append(",");
+            }
+            writePos(ring[i], wkt);
+        }
+        wkt.append(")");
+    }
+
+    void WKTGeometryWriter::writeRings(const std::vector<std::vector<MapPos> >& rings, std::string& wkt) const {
+        wkt.append("(");
+        for (std::size_t i = 0; i < rings.size(); i++) {
+            if (i > 0) {
+                wkt.append(",");
+            }
+            writeRing(rings[i], wkt);
+        }
+        wkt.append(")");
+    }
+
+    void WKTGeometryWriter::writeCoord(double value, std::string& wkt) const {
+        if (!std::isfinite(value)) {
+            throw GenerateException("Invalid coordinate value");
+        }
+        char buf[32]; // dtoa output is at most 25 characters
+        const char* end = rapidjson::internal::dtoa(GeneralUtils::RoundDecimals(value, _precision), buf);
+        const char* exp = std::find(static_cast<const char*>(buf), end, 'e');
+        if (exp == end) {
+            wkt.append(buf, end);
+            return;
+        }
+
+        // dtoa uses exponent notation for very small and very large values, WKT readers expect fixed notation
+        const char* ptr = buf;
+        if (*ptr == '-') {
+            wkt.append("-");
+            ptr++;
+        }
+        std::string digits;
+        int pointPos = -1;
+        for (; ptr != exp; ptr++) {
+            if (*ptr == '.') {
+                pointPos = static_cast<int>(digits.size());
+            } else {
+                digits.push_back(*ptr);
+            }
+        }
+        if (pointPos < 0) {
+            pointPos = static_cast<int>(digits.size());
+        }
+        pointPos += std::atoi(exp + 1);
+        if (pointPos <= 0) {
+            wkt.append("0.");
+            wkt.append(-pointPos, '0');
+            wkt.append(digits);
+        } else if (pointPos >= static_cast<int>(digits.size())) {
+            wkt.append(digits);
+            wkt.append(pointPos - digits.size(), '0');
+            wkt.append(".0");
+        } else {
+            wkt.append(digits, 0, pointPos);
+            wkt.append(".");
+            wkt.append(digits, pointPos, std::string::npos);
+        }
+    }
+
+    const std::size_t WKTGeometryWriter::INITIAL_BUFFER_SIZE = 256;
+
 }
 
 #endif
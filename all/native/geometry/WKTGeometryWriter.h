@@ -11,8 +11,11 @@
 
 #include "core/MapPos.h"
 
+#include <cstddef>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <vector>
 
 namespace carto {
     class Geometry;
@@ -20,6 +23,8 @@ namespace carto {
     /**
      * Generates Well Known Text (WKT) representation of the geometry.
      * Supports both 2D and 3D coordinate serialization.
+     * The output is generated directly into the result string, coordinates are written
+     * using the shortest representation that reads back to the same value.
      */
     class WKTGeometryWriter {
     public:
@@ -39,6 +44,18 @@ namespace carto {
          */
         void setZ(bool z);
 
+        /**
+         * Returns the number of decimal digits kept in coordinate values.
+         * @return The number of decimal digits kept in coordinate values. -1 if coordinates are written with full precision (the default).
+         */
+        int getPrecision() const;
+        /**
+         * Sets the number of decimal digits kept in coordinate values.
+         * Reducing precision (for example to 7 digits for WGS84 coordinates) makes the output considerably smaller.
+         * @param precision The number of decimal digits kept in coordinate values. -1 for full precision.
+         */
+        void setPrecision(int precision);
+
         /**
          * Creates a WKT string corresponding to the specified geometry.
          * @param geometry The geometry to write.
@@ -48,7 +65,16 @@ namespace carto {
         std::string writeGeometry(const std::shared_ptr<Geometry>& geometry) const;
 
     private:
+        void writeGeometry(const std::shared_ptr<Geometry>& geometry, std::string& wkt) const;
+        void writePos(const MapPos& pos, std::string& wkt) const;
+        void writeRing(const std::vector<MapPos>& ring, std::string& wkt) const;
+        void writeRings(const std::vector<std::vector<MapPos> >& rings, std::string& wkt) const;
+        void writeCoord(double value, std::string& wkt) const;
+
+        static const std::size_t INITIAL_BUFFER_SIZE;
+
         bool _z;
+        int _precision;
 
         mutable std::mutex _mutex;
     };
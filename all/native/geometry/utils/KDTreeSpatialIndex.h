@@ -9,298 +9,473 @@
 
 #include "geometry/utils/SpatialIndex.h"
 
-#include <list>
+#include <algorithm>
+#include <numeric>
 
 namespace carto {
 
+    /**
+     * KD-tree based spatial index. Nodes and records are kept in contiguous arrays and linked by indices,
+     * records of the same leaf are stored next to each other when the tree is bulk loaded.
+     */
     template <typename T>
     class KDTreeSpatialIndex : public SpatialIndex<T> {
     public:
         KDTreeSpatialIndex();
+        explicit KDTreeSpatialIndex(const std::vector<std::pair<cglib::bbox3<double>, T> >& records);
         virtual ~KDTreeSpatialIndex() { }
-        
+
         virtual std::size_t size() const;
         virtual void reserve(std::size_t size);
-        
+
         virtual void clear();
         virtual void insert(const cglib::bbox3<double>& bounds, const T& object);
+        virtual void insertAll(const std::vector<std::pair<cglib::bbox3<double>, T> >& records);
         virtual bool remove(const cglib::bbox3<double>& bounds, const T& object);
         virtual bool remove(const T& object);
-        
+
         virtual std::vector<T> query(const cglib::frustum3<double>& frustum) const;
         virtual std::vector<T> query(const cglib::bbox3<double>& bounds) const;
+        virtual std::vector<T> query(const cglib::ray3<double>& ray, double margin) const;
         virtual std::vector<T> getAll() const;
-        
+
     private:
-        class Record {
-        public:
+        struct Record {
             Record(const cglib::bbox3<double>& bounds, const T& object);
-            
+
             cglib::bbox3<double> bounds;
             T object;
+            int next; // next record of the same node or free list, -1 if last
         };
-        
-        class Node {
-        public:
-            Node(const cglib::bbox3<double>& bounds);
-            
+
+        struct Node {
+            explicit Node(const cglib::bbox3<double>& bounds);
+
             cglib::bbox3<double> bounds;
-            std::list<Record> records;
-            std::vector<std::shared_ptr<Node> > children; // <, >= half-planes
+            int records; // first record index, -1 if none
+            int children[2]; // <, >= half-planes, -1 if missing
             int axis; // splitting axis (0 is x, 1 is y, 2 is z)
-            double distance; // only defined if children != null, once defined, becomes immutable
+            double distance; // only defined if node has children, once defined, becomes immutable
         };
-        
-        void insertToNode(const std::shared_ptr<Node>& node, const cglib::bbox3<double>& bounds, const T& object, int depth);
-        std::shared_ptr<Node> removeFromNode(const std::shared_ptr<Node>& node, const cglib::bbox3<double>* bounds, const T& object);
-        
-        void queryNode(const std::shared_ptr<Node>& node, const cglib::frustum3<double>& frustum, std::vector<T>& results) const;
-        void queryNode(const std::shared_ptr<Node>& node, const cglib::bbox3<double>& bounds, std::vector<T>& results) const;
-        void getAllFromNode(const std::shared_ptr<Node>& node, std::vector<T>& results) const;
-        
+
+        int createNode(const cglib::bbox3<double>& bounds);
+        int createRecord(const cglib::bbox3<double>& bounds, const T& object);
+        void releaseRecord(int recordIndex);
+
+        void splitNode(int nodeIndex);
+        bool removeRecords(const cglib::bbox3<double>* bounds, const T& object);
+        void build(std::vector<Record>& records);
+        int buildNode(std::vector<Record>& records, std::vector<int>& order, std::size_t begin, std::size_t end, int depth);
+
+        static int GetSplitAxis(const cglib::bbox3<double>& bounds);
+
         static const int MAX_DEPTH;
         static const unsigned int MIN_SPLIT_COUNT;
-        
-        std::shared_ptr<Node> _root;
+
+        std::vector<Node> _nodes; // root is at index 0
+        std::vector<Record> _records;
+        int _freeRecords; // first unused record index, -1 if none
         std::size_t _count;
     };
-    
+
     template<typename T>
     KDTreeSpatialIndex<T>::KDTreeSpatialIndex() :
-        _root(),
+        _nodes(),
+        _records(),
+        _freeRecords(-1),
+        _count(0)
+    {
+    }
+
+    template<typename T>
+    KDTreeSpatialIndex<T>::KDTreeSpatialIndex(const std::vector<std::pair<cglib::bbox3<double>, T> >& records) :
+        _nodes(),
+        _records(),
+        _freeRecords(-1),
         _count(0)
     {
+        insertAll(records);
     }
-    
+
     template<typename T>
     std::size_t KDTreeSpatialIndex<T>::size() const {
         return _count;
     }
-    
+
     template<typename T>
     void KDTreeSpatialIndex<T>::reserve(std::size_t size) {
+        _records.reserve(size);
     }
-    
+
     template<typename T>
     void KDTreeSpatialIndex<T>::clear() {
-        _root.reset();
+        _nodes.clear();
+        _records.clear();
+        _freeRecords = -1;
         _count = 0;
     }
-    
+
     template<typename T>
     void KDTreeSpatialIndex<T>::insert(const cglib::bbox3<double>& bounds, const T& object) {
-        if (!_root) {
-            _root = std::make_shared<Node>(bounds);
+        if (_nodes.empty()) {
+            createNode(bounds);
+        }
+
+        int nodeIndex = 0;
+        for (int depth = 0; ; depth++) {
+            // Update node bounds
+            _nodes[nodeIndex].bounds.add(bounds);
+
+            // Add to node records if depth limit has been exceeded or this is a leaf node
+            if (depth >= MAX_DEPTH || (_nodes[nodeIndex].children[0] < 0 && _nodes[nodeIndex].children[1] < 0)) {
+                int recordIndex = createRecord(bounds, object);
+                _records[recordIndex].next = _nodes[nodeIndex].records;
+                _nodes[nodeIndex].records = recordIndex;
+                _count++;
+                if (depth < MAX_DEPTH) {
+                    splitNode(nodeIndex);
+                }
+                return;
+            }
+
+            // Descend to the child containing the center of the record
+            int index = (bounds.center()(_nodes[nodeIndex].axis) >= _nodes[nodeIndex].distance ? 1 : 0);
+            if (_nodes[nodeIndex].children[index] < 0) {
+                int childIndex = createNode(bounds);
+                _nodes[nodeIndex].children[index] = childIndex;
+            }
+            nodeIndex = _nodes[nodeIndex].children[index];
+        }
+    }
+
+    template<typename T>
+    void KDTreeSpatialIndex<T>::insertAll(const std::vector<std::pair<cglib::bbox3<double>, T> >& records) {
+        // Small batches are cheaper to insert incrementally, otherwise rebuild the whole tree
+        if (records.size() < _count) {
+            for (const std::pair<cglib::bbox3<double>, T>& record : records) {
+                insert(record.first, record.second);
+            }
+            return;
+        }
+
+        std::vector<Record> allRecords;
+        allRecords.reserve(_count + records.size());
+        for (const Node& node : _nodes) {
+            for (int recordIndex = node.records; recordIndex >= 0; recordIndex = _records[recordIndex].next) {
+                allRecords.push_back(_records[recordIndex]);
+            }
+        }
+        for (const std::pair<cglib::bbox3<double>, T>& record : records) {
+            allRecords.emplace_back(record.first, record.second);
         }
-        insertToNode(_root, bounds, object, 0);
+        build(allRecords);
     }
-    
+
     template<typename T>
     bool KDTreeSpatialIndex<T>::remove(const cglib::bbox3<double>& bounds, const T& object) {
-        std::size_t count = _count;
-        _root = removeFromNode(_root, &bounds, object);
-        return count != _count;
+        return removeRecords(&bounds, object);
     }
-    
+
     template<typename T>
     bool KDTreeSpatialIndex<T>::remove(const T& object) {
-        std::size_t count = _count;
-        _root = removeFromNode(_root, nullptr, object);
-        return count != _count;
+        return removeRecords(nullptr, object);
     }
-    
+
     template<typename T>
     std::vector<T> KDTreeSpatialIndex<T>::query(const cglib::frustum3<double>& frustum) const {
         std::vector<T> results;
-        queryNode(_root, frustum, results);
+        if (_nodes.empty()) {
+            return results;
+        }
+
+        std::vector<int> stack;
+        stack.push_back(0);
+        while (!stack.empty()) {
+            const Node& node = _nodes[stack.back()];
+            stack.pop_back();
+            if (!frustum.inside(node.bounds)) {
+                continue;
+            }
+
+            for (int recordIndex = node.records; recordIndex >= 0; recordIndex = _records[recordIndex].next) {
+                const Record& record = _records[recordIndex];
+                if (frustum.inside(record.bounds)) {
+                    results.push_back(record.object);
+                }
+            }
+            for (int childIndex : node.children) {
+                if (childIndex >= 0) {
+                    stack.push_back(childIndex);
+                }
+            }
+        }
         return results;
     }
-    
+
     template<typename T>
     std::vector<T> KDTreeSpatialIndex<T>::query(const cglib::bbox3<double>& bounds) const {
         std::vector<T> results;
-        queryNode(_root, bounds, results);
+        if (_nodes.empty()) {
+            return results;
+        }
+
+        std::vector<int> stack;
+        stack.push_back(0);
+        while (!stack.empty()) {
+            const Node& node = _nodes[stack.back()];
+            stack.pop_back();
+            if (!bounds.inside(node.bounds)) {
+                continue;
+            }
+
+            for (int recordIndex = node.records; recordIndex >= 0; recordIndex = _records[recordIndex].next) {
+                const Record& record = _records[recordIndex];
+                if (bounds.inside(record.bounds)) {
+                    results.push_back(record.object);
+                }
+            }
+            for (int childIndex : node.children) {
+                if (childIndex >= 0) {
+                    stack.push_back(childIndex);
+                }
+            }
+        }
+        return results;
+    }
+
+    template<typename T>
+    std::vector<T> KDTreeSpatialIndex<T>::query(const cglib::ray3<double>& ray, double margin) const {
+        std::vector<T> results;
+        if (_nodes.empty()) {
+            return results;
+        }
+
+        cglib::vec3<double> marginVec(margin, margin, margin);
+        auto intersects = [&ray, &marginVec](const cglib::bbox3<double>& bounds) {
+            return cglib::intersect_bbox(cglib::bbox3<double>(bounds.min - marginVec, bounds.max + marginVec), ray);
+        };
+
+        std::vector<int> stack;
+        stack.push_back(0);
+        while (!stack.empty()) {
+            const Node& node = _nodes[stack.back()];
+            stack.pop_back();
+            if (!intersects(node.bounds)) {
+                continue;
+            }
+
+            for (int recordIndex = node.records; recordIndex >= 0; recordIndex = _records[recordIndex].next) {
+                const Record& record = _records[recordIndex];
+                if (intersects(record.bounds)) {
+                    results.push_back(record.object);
+                }
+            }
+            for (int childIndex : node.children) {
+                if (childIndex >= 0) {
+                    stack.push_back(childIndex);
+                }
+            }
+        }
         return results;
     }
-    
+
     template<typename T>
     std::vector<T> KDTreeSpatialIndex<T>::getAll() const {
         std::vector<T> results;
-        getAllFromNode(_root, results);
+        results.reserve(_count);
+        for (const Node& node : _nodes) {
+            for (int recordIndex = node.records; recordIndex >= 0; recordIndex = _records[recordIndex].next) {
+                results.push_back(_records[recordIndex].object);
+            }
+        }
         return results;
     }
-    
+
     template<typename T>
     KDTreeSpatialIndex<T>::Record::Record(const cglib::bbox3<double>& bounds, const T& object) :
         bounds(bounds),
-        object(object)
+        object(object),
+        next(-1)
     {
     }
-    
+
     template<typename T>
     KDTreeSpatialIndex<T>::Node::Node(const cglib::bbox3<double>& bounds) :
         bounds(bounds),
-        records(),
+        records(-1),
         children(),
         axis(0),
         distance(-1)
     {
+        children[0] = children[1] = -1;
     }
-    
+
     template<typename T>
-    void KDTreeSpatialIndex<T>::insertToNode(const std::shared_ptr<Node>& node, const cglib::bbox3<double>& bounds, const T& object, int depth) {
-        // Update node bounds
-        node->bounds.add(bounds);
-        
-        // If depth limit has been exceeded, add to current node
-        if (depth >= MAX_DEPTH) {
-            node->records.emplace_back(bounds, object);
-            _count++;
-            return;
-        }
-        
-        // Add to node records if this is leaf node
-        if (node->children.empty()) {
-            node->records.emplace_back(bounds, object);
-            _count++;
-            
-            // Create children and redistribute node records among children if enough records have been added
-            if (node->records.size() > MIN_SPLIT_COUNT) {
-                cglib::vec3<double> boundsDelta = node->bounds.size();
-                int axis = 0;
-                if (boundsDelta(1) > boundsDelta(0) && boundsDelta(1) > boundsDelta(2)) {
-                    axis = 1;
-                } else if (boundsDelta(2) > boundsDelta(0) && boundsDelta(2) > boundsDelta(1)) {
-                    axis = 2;
-                }
-                
-                std::vector<std::shared_ptr<Node> > children(2);
-                double distance = node->bounds.center()(axis);
-                for (const Record& record : node->records) {
-                    int index = record.bounds.center()(axis) >= distance ? 1 : 0;
-                    if (!children[index]) {
-                        children[index] = std::make_shared<Node>(record.bounds);
-                    } else {
-                        children[index]->bounds.add(record.bounds);
-                    }
-                    children[index]->records.push_back(record);
-                }
-                
-                // Check that split succeeded
-                if (children[0] && children[1]) {
-                    node->children = std::move(children);
-                    node->axis = axis;
-                    node->distance = distance;
-                    node->records.clear();
-                }
-            }
-            return;
-        }
-        
-        // Recurse to children
-        int index = (node->bounds.center()(node->axis) >= node->distance ? 1 : 0);
-        if (!node->children[index]) {
-            node->children[index] = std::make_shared<Node>(bounds);
+    int KDTreeSpatialIndex<T>::createNode(const cglib::bbox3<double>& bounds) {
+        _nodes.emplace_back(bounds);
+        return static_cast<int>(_nodes.size()) - 1;
+    }
+
+    template<typename T>
+    int KDTreeSpatialIndex<T>::createRecord(const cglib::bbox3<double>& bounds, const T& object) {
+        if (_freeRecords >= 0) {
+            int recordIndex = _freeRecords;
+            _freeRecords = _records[recordIndex].next;
+            _records[recordIndex] = Record(bounds, object);
+            return recordIndex;
         }
-        insertToNode(node->children[index], bounds, object, depth + 1);
+        _records.emplace_back(bounds, object);
+        return static_cast<int>(_records.size()) - 1;
     }
-    
+
+    template<typename T>
+    void KDTreeSpatialIndex<T>::releaseRecord(int recordIndex) {
+        // Release the object immediately, the slot is reused by later inserts
+        _records[recordIndex].object = T();
+        _records[recordIndex].next = _freeRecords;
+        _freeRecords = recordIndex;
+    }
+
     template<typename T>
-    std::shared_ptr<typename KDTreeSpatialIndex<T>::Node> KDTreeSpatialIndex<T>::removeFromNode(const std::shared_ptr<Node>& node, const cglib::bbox3<double>* bounds, const T& object) {
-        // Check if we need to proceed
-        if (!node) {
-            return node;
+    void KDTreeSpatialIndex<T>::splitNode(int nodeIndex) {
+        unsigned int recordCount = 0;
+        for (int recordIndex = _nodes[nodeIndex].records; recordIndex >= 0; recordIndex = _records[recordIndex].next) {
+            recordCount++;
         }
-        if (bounds && !node->bounds.inside(*bounds)) {
-            return node;
+        if (recordCount <= MIN_SPLIT_COUNT) {
+            return;
         }
-        
-        // Remove object from current node
-        for (auto it = node->records.begin(); it != node->records.end(); ++it) {
-            const Record& record = *it;
-            if (record.object == object) {
-                it = node->records.erase(it);
-                _count--;
-            }
+
+        // Check that split succeeds before creating children
+        int axis = GetSplitAxis(_nodes[nodeIndex].bounds);
+        double distance = _nodes[nodeIndex].bounds.center()(axis);
+        unsigned int counts[2] = { 0, 0 };
+        for (int recordIndex = _nodes[nodeIndex].records; recordIndex >= 0; recordIndex = _records[recordIndex].next) {
+            counts[_records[recordIndex].bounds.center()(axis) >= distance ? 1 : 0]++;
         }
-        
-        // Recurse and prune
-        bool empty = true;
-        for (std::size_t i = 0; i < node->children.size(); i++) {
-            node->children[i] = removeFromNode(node->children[i], bounds, object);
-            if (node->children[i]) {
-                empty = false;
-            }
+        if (counts[0] == 0 || counts[1] == 0) {
+            return;
         }
-        if (empty) {
-            node->children.clear();
+
+        // Redistribute node records among children
+        int recordIndex = _nodes[nodeIndex].records;
+        _nodes[nodeIndex].records = -1;
+        _nodes[nodeIndex].axis = axis;
+        _nodes[nodeIndex].distance = distance;
+        while (recordIndex >= 0) {
+            int nextIndex = _records[recordIndex].next;
+            int index = (_records[recordIndex].bounds.center()(axis) >= distance ? 1 : 0);
+            int childIndex = _nodes[nodeIndex].children[index];
+            if (childIndex < 0) {
+                childIndex = createNode(_records[recordIndex].bounds);
+                _nodes[nodeIndex].children[index] = childIndex;
+            } else {
+                _nodes[childIndex].bounds.add(_records[recordIndex].bounds);
+            }
+            _records[recordIndex].next = _nodes[childIndex].records;
+            _nodes[childIndex].records = recordIndex;
+            recordIndex = nextIndex;
         }
-        return node->records.empty() && node->children.empty() ? std::shared_ptr<Node>() : node;
     }
-    
+
     template<typename T>
-    void KDTreeSpatialIndex<T>::queryNode(const std::shared_ptr<Node>& node, const cglib::frustum3<double>& frustum, std::vector<T>& results) const {
-        // Check if this node intersects with given envelope
-        if (!node) {
-            return;
+    bool KDTreeSpatialIndex<T>::removeRecords(const cglib::bbox3<double>* bounds, const T& object) {
+        if (_nodes.empty()) {
+            return false;
         }
-        if (!frustum.inside(node->bounds)) {
-            return;
-        }
-        
-        // Test for intersection of current node records
-        for (typename std::list<Record>::iterator it = node->records.begin(); it != node->records.end(); ++it) {
-            const Record& record = *it;
-            if (frustum.inside(record.bounds)) {
-                results.push_back(record.object);
+
+        // Node bounds are not shrunk, they remain valid (conservative) after removal
+        std::size_t count = _count;
+        std::vector<int> stack;
+        stack.push_back(0);
+        while (!stack.empty()) {
+            Node& node = _nodes[stack.back()];
+            stack.pop_back();
+            if (bounds && !node.bounds.inside(*bounds)) {
+                continue;
+            }
+
+            int* link = &node.records;
+            while (*link >= 0) {
+                int recordIndex = *link;
+                if (_records[recordIndex].object == object) {
+                    *link = _records[recordIndex].next;
+                    releaseRecord(recordIndex);
+                    _count--;
+                } else {
+                    link = &_records[recordIndex].next;
+                }
+            }
+            for (int childIndex : node.children) {
+                if (childIndex >= 0) {
+                    stack.push_back(childIndex);
+                }
             }
         }
-        
-        // Recurse
-        for (const std::shared_ptr<Node>& child : node->children) {
-            queryNode(child, frustum, results);
+
+        if (_count == 0) {
+            clear();
         }
+        return count != _count;
     }
-    
+
     template<typename T>
-    void KDTreeSpatialIndex<T>::queryNode(const std::shared_ptr<Node>& node, const cglib::bbox3<double>& bounds, std::vector<T>& results) const {
-        // Check if this node intersects with given envelope
-        if (!node) {
+    void KDTreeSpatialIndex<T>::build(std::vector<Record>& records) {
+        clear();
+        if (records.empty()) {
             return;
         }
-        if (!bounds.inside(node->bounds)) {
-            return;
+
+        std::vector<int> order(records.size());
+        std::iota(order.begin(), order.end(), 0);
+        _nodes.reserve(records.size() / MIN_SPLIT_COUNT * 2 + 1);
+        _records.reserve(records.size());
+        buildNode(records, order, 0, order.size(), 0);
+        _count = records.size();
+    }
+
+    template<typename T>
+    int KDTreeSpatialIndex<T>::buildNode(std::vector<Record>& records, std::vector<int>& order, std::size_t begin, std::size_t end, int depth) {
+        cglib::bbox3<double> bounds = records[order[begin]].bounds;
+        for (std::size_t i = begin + 1; i < end; i++) {
+            bounds.add(records[order[i]].bounds);
         }
-        
-        // Test for intersection of current node records
-        for (typename std::list<Record>::iterator it = node->records.begin(); it != node->records.end(); ++it) {
-            const Record& record = *it;
-            if (bounds.inside(record.bounds)) {
-                results.push_back(record.object);
-            }
+        int nodeIndex = createNode(bounds);
+
+        // Split at the median of the record centers along the longest axis
+        if (end - begin > MIN_SPLIT_COUNT && depth < MAX_DEPTH) {
+            int axis = GetSplitAxis(bounds);
+            std::size_t mid = begin + (end - begin) / 2;
+            std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end, [&records, axis](int index1, int index2) {
+                return records[index1].bounds.center()(axis) < records[index2].bounds.center()(axis);
+            });
+            _nodes[nodeIndex].axis = axis;
+            _nodes[nodeIndex].distance = records[order[mid]].bounds.center()(axis);
+            int childIndex0 = buildNode(records, order, begin, mid, depth + 1);
+            int childIndex1 = buildNode(records, order, mid, end, depth + 1);
+            _nodes[nodeIndex].children[0] = childIndex0;
+            _nodes[nodeIndex].children[1] = childIndex1;
+            return nodeIndex;
         }
-        
-        // Recurse
-        for (const std::shared_ptr<Node>& child : node->children) {
-            queryNode(child, bounds, results);
+
+        // Leaf node, store its records contiguously
+        for (std::size_t i = begin; i < end; i++) {
+            _records.push_back(std::move(records[order[i]]));
+            _records.back().next = (i + 1 < end ? static_cast<int>(_records.size()) : -1);
         }
+        _nodes[nodeIndex].records = static_cast<int>(_records.size() - (end - begin));
+        return nodeIndex;
     }
-    
+
     template<typename T>
-    void KDTreeSpatialIndex<T>::getAllFromNode(const std::shared_ptr<Node>& node, std::vector<T>& results) const {
-        if (!node) {
-            return;
-        }
-        
-        // All objects under this node
-        for (const Record& record : node->records) {
-            results.push_back(record.object);
-        }
-        
-        // Recurse
-        for (const std::shared_ptr<Node>& child : node->children) {
-            getAllFromNode(child, results);
+    int KDTreeSpatialIndex<T>::GetSplitAxis(const cglib::bbox3<double>& bounds) {
+        cglib::vec3<double> boundsDelta = bounds.size();
+        if (boundsDelta(1) > boundsDelta(0) && boundsDelta(1) > boundsDelta(2)) {
+            return 1;
+        } else if (boundsDelta(2) > boundsDelta(0) && boundsDelta(2) > boundsDelta(1)) {
+            return 2;
         }
+        return 0;
     }
 
     template<typename T>
@@ -308,7 +483,7 @@ namespace carto {
 
     template<typename T>
     const unsigned int KDTreeSpatialIndex<T>::MIN_SPLIT_COUNT = 2;
-    
+
 }
 
 #endif
@@ -24,11 +24,13 @@ namespace carto {
         
         virtual void clear();
         virtual void insert(const cglib::bbox3<double>& bounds, const T& object);
+        virtual void insertAll(const std::vector<std::pair<cglib::bbox3<double>, T> >& records);
         virtual bool remove(const cglib::bbox3<double>& bounds, const T& object);
         virtual bool remove(const T& object);
         
         virtual std::vector<T> query(const cglib::frustum3<double>& frustum) const;
         virtual std::vector<T> query(const cglib::bbox3<double>& bounds) const;
+        virtual std::vector<T> query(const cglib::ray3<double>& ray, double margin) const;
         virtual std::vector<T> getAll() const;
         
     private:
@@ -61,6 +63,14 @@ namespace carto {
         _objects.push_back(object);
     }
     
+    template<typename T>
+    void NullSpatialIndex<T>::insertAll(const std::vector<std::pair<cglib::bbox3<double>, T> >& records) {
+        _objects.reserve(_objects.size() + records.size());
+        for (const std::pair<cglib::bbox3<double>, T>& record : records) {
+            _objects.push_back(record.second);
+        }
+    }
+    
     template<typename T>
     bool NullSpatialIndex<T>::remove(const cglib::bbox3<double>& bounds, const T& object) {
         return remove(object);
@@ -89,6 +99,11 @@ namespace carto {
         return _objects;
     }
     
+    template<typename T>
+    std::vector<T> NullSpatialIndex<T>::query(const cglib::ray3<double>& ray, double margin) const {
+        return _objects;
+    }
+    
     template<typename T>
     std::vector<T> NullSpatialIndex<T>::getAll() const {
         return _objects;
@@ -0,0 +1,387 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_PACKEDRTREESPATIALINDEX_H_
+#define _CARTO_PACKEDRTREESPATIALINDEX_H_
+
+#include "geometry/utils/SpatialIndex.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace carto {
+
+    /**
+     * Static R-tree spatial index, packed bottom-up from records sorted along a Hilbert curve.
+     * The tree is not updated incrementally: inserted records are kept in a separate unsorted list and
+     * removed records are only marked. The tree is repacked once the number of such edits becomes large
+     * compared to the size of the tree. Best suited for large, mostly static datasets.
+     */
+    template <typename T>
+    class PackedRTreeSpatialIndex : public SpatialIndex<T> {
+    public:
+        PackedRTreeSpatialIndex();
+        explicit PackedRTreeSpatialIndex(const std::vector<std::pair<cglib::bbox3<double>, T> >& records);
+        virtual ~PackedRTreeSpatialIndex() { }
+
+        virtual std::size_t size() const;
+        virtual void reserve(std::size_t size);
+
+        virtual void clear();
+        virtual void insert(const cglib::bbox3<double>& bounds, const T& object);
+        virtual void insertAll(const std::vector<std::pair<cglib::bbox3<double>, T> >& records);
+        virtual bool remove(const cglib::bbox3<double>& bounds, const T& object);
+        virtual bool remove(const T& object);
+
+        virtual std::vector<T> query(const cglib::frustum3<double>& frustum) const;
+        virtual std::vector<T> query(const cglib::bbox3<double>& bounds) const;
+        virtual std::vector<T> query(const cglib::ray3<double>& ray, double margin) const;
+        virtual std::vector<T> getAll() const;
+
+    private:
+        struct Record {
+            Record(const cglib::bbox3<double>& bounds, const T& object);
+
+            cglib::bbox3<double> bounds;
+            T object;
+            bool removed;
+        };
+
+        template <typename Filter>
+        void queryRecords(const Filter& filter, std::vector<T>& results) const;
+
+        void checkRebuild();
+        void rebuild();
+
+        static std::uint32_t CalculateHilbertIndex(std::uint32_t x, std::uint32_t y);
+
+        static const std::size_t NODE_SIZE;
+        static const std::size_t MIN_REBUILD_COUNT;
+        static const std::uint32_t HILBERT_GRID_SIZE;
+
+        std::vector<Record> _records; // packed records, sorted along the Hilbert curve
+        std::vector<cglib::bbox3<double> > _nodes; // node bounds of all levels, lowest level first
+        std::vector<std::size_t> _levelOffsets; // offsets of the levels in _nodes, last element is the node count
+        std::vector<Record> _pendingRecords; // records inserted after the last rebuild
+        std::size_t _removedCount; // number of removed records in _records
+    };
+
+    template<typename T>
+    PackedRTreeSpatialIndex<T>::PackedRTreeSpatialIndex() :
+        _records(),
+        _nodes(),
+        _levelOffsets(),
+        _pendingRecords(),
+        _removedCount(0)
+    {
+    }
+
+    template<typename T>
+    PackedRTreeSpatialIndex<T>::PackedRTreeSpatialIndex(const std::vector<std::pair<cglib::bbox3<double>, T> >& records) :
+        _records(),
+        _nodes(),
+        _levelOffsets(),
+        _pendingRecords(),
+        _removedCount(0)
+    {
+        insertAll(records);
+    }
+
+    template<typename T>
+    std::size_t PackedRTreeSpatialIndex<T>::size() const {
+        return _records.size() - _removedCount + _pendingRecords.size();
+    }
+
+    template<typename T>
+    void PackedRTreeSpatialIndex<T>::reserve(std::size_t size) {
+        _records.reserve(size);
+    }
+
+    template<typename T>
+    void PackedRTreeSpatialIndex<T>::clear() {
+        _records.clear();
+        _nodes.clear();
+        _levelOffsets.clear();
+        _pendingRecords.clear();
+        _removedCount = 0;
+    }
+
+    template<typename T>
+    void PackedRTreeSpatialIndex<T>::insert(const cglib::bbox3<double>& bounds, const T& object) {
+        _pendingRecords.emplace_back(bounds, object);
+        checkRebuild();
+    }
+
+    template<typename T>
+    void PackedRTreeSpatialIndex<T>::insertAll(const std::vector<std::pair<cglib::bbox3<double>, T> >& records) {
+        _pendingRecords.reserve(_pendingRecords.size() + records.size());
+        for (const std::pair<cglib::bbox3<double>, T>& record : records) {
+            _pendingRecords.emplace_back(record.first, record.second);
+        }
+        checkRebuild();
+    }
+
+    template<typename T>
+    bool PackedRTreeSpatialIndex<T>::remove(const cglib::bbox3<double>& bounds, const T& object) {
+        std::size_t count = size();
+        auto it = std::remove_if(_pendingRecords.begin(), _pendingRecords.end(), [&object](const Record& record) {
+            return record.object == object;
+        });
+        _pendingRecords.erase(it, _pendingRecords.end());
+
+        if (!_levelOffsets.empty()) {
+            std::vector<std::pair<std::size_t, std::size_t> > stack; // level, index (level 0 is records)
+            stack.emplace_back(_levelOffsets.size() - 1, 0);
+            while (!stack.empty()) {
+                std::size_t level = stack.back().first;
+                std::size_t index = stack.back().second;
+                stack.pop_back();
+                if (level == 0) {
+                    Record& record = _records[index];
+                    if (!record.removed && record.object == object && bounds.inside(record.bounds)) {
+                        record.object = T();
+                        record.removed = true;
+                        _removedCount++;
+                    }
+                    continue;
+                }
+                if (!bounds.inside(_nodes[_levelOffsets[level - 1] + index])) {
+                    continue;
+                }
+                std::size_t childCount = (level == 1 ? _records.size() : _levelOffsets[level - 1] - _levelOffsets[level - 2]);
+                for (std::size_t i = index * NODE_SIZE; i < std::min((index + 1) * NODE_SIZE, childCount); i++) {
+                    stack.emplace_back(level - 1, i);
+                }
+            }
+        }
+
+        if (count != size()) {
+            checkRebuild();
+            return true;
+        }
+        return false;
+    }
+
+    template<typename T>
+    bool PackedRTreeSpatialIndex<T>::remove(const T& object) {
+        std::size_t count = size();
+        auto it = std::remove_if(_pendingRecords.begin(), _pendingRecords.end(), [&object](const Record& record) {
+            return record.object == object;
+        });
+        _pendingRecords.erase(it, _pendingRecords.end());
+
+        for (Record& record : _records) {
+            if (!record.removed && record.object == object) {
+                record.object = T();
+                record.removed = true;
+                _removedCount++;
+            }
+        }
+
+        if (count != size()) {
+            checkRebuild();
+            return true;
+        }
+        return false;
+    }
+
+    template<typename T>
+    std::vector<T> PackedRTreeSpatialIndex<T>::query(const cglib::frustum3<double>& frustum) const {
+        std::vector<T> results;
+        queryRecords([&frustum](const cglib::bbox3<double>& bounds) { return frustum.inside(bounds); }, results);
+        return results;
+    }
+
+    template<typename T>
+    std::vector<T> PackedRTreeSpatialIndex<T>::query(const cglib::bbox3<double>& bounds) const {
+        std::vector<T> results;
+        queryRecords([&bounds](const cglib::bbox3<double>& recordBounds) { return bounds.inside(recordBounds); }, results);
+        return results;
+    }
+
+    template<typename T>
+    std::vector<T> PackedRTreeSpatialIndex<T>::query(const cglib::ray3<double>& ray, double margin) const {
+        std::vector<T> results;
+        cglib::vec3<double> marginVec(margin, margin, margin);
+        queryRecords([&ray, &marginVec](const cglib::bbox3<double>& recordBounds) {
+            return cglib::intersect_bbox(cglib::bbox3<double>(recordBounds.min - marginVec, recordBounds.max + marginVec), ray);
+        }, results);
+        return results;
+    }
+
+    template<typename T>
+    std::vector<T> PackedRTreeSpatialIndex<T>::getAll() const {
+        std::vector<T> results;
+        results.reserve(size());
+        for (const Record& record : _records) {
+            if (!record.removed) {
+                results.push_back(record.object);
+            }
+        }
+        for (const Record& record : _pendingRecords) {
+            results.push_back(record.object);
+        }
+        return results;
+    }
+
+    template<typename T>
+    PackedRTreeSpatialIndex<T>::Record::Record(const cglib::bbox3<double>& bounds, const T& object) :
+        bounds(bounds),
+        object(object),
+        removed(false)
+    {
+    }
+
+    template<typename T>
+    template<typename Filter>
+    void PackedRTreeSpatialIndex<T>::queryRecords(const Filter& filter, std::vector<T>& results) const {
+        if (!_levelOffsets.empty()) {
+            std::vector<std::pair<std::size_t, std::size_t> > stack; // level, index (level 0 is records)
+            stack.emplace_back(_levelOffsets.size() - 1, 0);
+            while (!stack.empty()) {
+                std::size_t level = stack.back().first;
+                std::size_t index = stack.back().second;
+                stack.pop_back();
+                if (!filter(_nodes[_levelOffsets[level - 1] + index])) {
+                    continue;
+                }
+
+                // Test the records of the lowest level nodes directly, they are stored contiguously
+                if (level == 1) {
+                    for (std::size_t i = index * NODE_SIZE; i < std::min((index + 1) * NODE_SIZE, _records.size()); i++) {
+                        const Record& record = _records[i];
+                        if (!record.removed && filter(record.bounds)) {
+                            results.push_back(record.object);
+                        }
+                    }
+                    continue;
+                }
+                std::size_t childCount = _levelOffsets[level - 1] - _levelOffsets[level - 2];
+                for (std::size_t i = std::min((index + 1) * NODE_SIZE, childCount); i-- > index * NODE_SIZE; ) {
+                    stack.emplace_back(level - 1, i);
+                }
+            }
+        }
+
+        for (const Record& record : _pendingRecords) {
+            if (filter(record.bounds)) {
+                results.push_back(record.object);
+            }
+        }
+    }
+
+    template<typename T>
+    void PackedRTreeSpatialIndex<T>::checkRebuild() {
+        // Repack once the number of edits is comparable to the size of the tree, this keeps edits amortized O(log n)
+        std::size_t editCount = _pendingRecords.size() + _removedCount;
+        if (editCount >= std::max(MIN_REBUILD_COUNT, (_records.size() - _removedCount) / 8)) {
+            rebuild();
+        }
+    }
+
+    template<typename T>
+    void PackedRTreeSpatialIndex<T>::rebuild() {
+        std::vector<Record> records;
+        records.reserve(size());
+        for (Record& record : _records) {
+            if (!record.removed) {
+                records.push_back(std::move(record));
+            }
+        }
+        for (Record& record : _pendingRecords) {
+            records.push_back(std::move(record));
+        }
+        clear();
+        if (records.empty()) {
+            return;
+        }
+
+        // Use the two axes with the largest extent for the Hilbert curve
+        cglib::bbox3<double> totalBounds = records.front().bounds;
+        for (const Record& record : records) {
+            totalBounds.add(record.bounds);
+        }
+        cglib::vec3<double> totalSize = totalBounds.size();
+        int axis0 = 0, axis1 = 1;
+        if (totalSize(2) > totalSize(0) || totalSize(2) > totalSize(1)) {
+            if (totalSize(0) >= totalSize(1)) {
+                axis1 = 2;
+            } else {
+                axis0 = 2;
+            }
+        }
+        double scale0 = (totalSize(axis0) > 0 ? (HILBERT_GRID_SIZE - 1) / totalSize(axis0) : 0);
+        double scale1 = (totalSize(axis1) > 0 ? (HILBERT_GRID_SIZE - 1) / totalSize(axis1) : 0);
+
+        std::vector<std::pair<std::uint32_t, std::size_t> > keys;
+        keys.reserve(records.size());
+        for (std::size_t i = 0; i < records.size(); i++) {
+            cglib::vec3<double> center = records[i].bounds.center();
+            std::uint32_t x = static_cast<std::uint32_t>((center(axis0) - totalBounds.min(axis0)) * scale0);
+            std::uint32_t y = static_cast<std::uint32_t>((center(axis1) - totalBounds.min(axis1)) * scale1);
+            keys.emplace_back(CalculateHilbertIndex(x, y), i);
+        }
+        std::sort(keys.begin(), keys.end());
+
+        _records.reserve(records.size());
+        for (const std::pair<std::uint32_t, std::size_t>& key : keys) {
+            _records.push_back(std::move(records[key.second]));
+        }
+
+        // Pack the levels bottom-up, each node covers NODE_SIZE consecutive nodes or records of the level below
+        _levelOffsets.push_back(0);
+        for (std::size_t i = 0; i < _records.size(); i += NODE_SIZE) {
+            cglib::bbox3<double> bounds = _records[i].bounds;
+            for (std::size_t j = i + 1; j < std::min(i + NODE_SIZE, _records.size()); j++) {
+                bounds.add(_records[j].bounds);
+            }
+            _nodes.push_back(bounds);
+        }
+        _levelOffsets.push_back(_nodes.size());
+        while (_levelOffsets.back() - _levelOffsets[_levelOffsets.size() - 2] > 1) {
+            std::size_t begin = _levelOffsets[_levelOffsets.size() - 2];
+            std::size_t end = _levelOffsets.back();
+            for (std::size_t i = begin; i < end; i += NODE_SIZE) {
+                cglib::bbox3<double> bounds = _nodes[i];
+                for (std::size_t j = i + 1; j < std::min(i + NODE_SIZE, end); j++) {
+                    bounds.add(_nodes[j]);
+                }
+                _nodes.push_back(bounds);
+            }
+            _levelOffsets.push_back(_nodes.size());
+        }
+    }
+
+    template<typename T>
+    std::uint32_t PackedRTreeSpatialIndex<T>::CalculateHilbertIndex(std::uint32_t x, std::uint32_t y) {
+        std::uint32_t index = 0;
+        for (std::uint32_t s = HILBERT_GRID_SIZE / 2; s > 0; s /= 2) {
+            std::uint32_t rx = (x & s) > 0 ? 1 : 0;
+            std::uint32_t ry = (y & s) > 0 ? 1 : 0;
+            index += s * s * ((3 * rx) ^ ry);
+            if (ry == 0) {
+                if (rx == 1) {
+                    x = HILBERT_GRID_SIZE - 1 - x;
+                    y = HILBERT_GRID_SIZE - 1 - y;
+                }
+                std::swap(x, y);
+            }
+        }
+        return index;
+    }
+
+    template<typename T>
+    const std::size_t PackedRTreeSpatialIndex<T>::NODE_SIZE = 16;
+
+    template<typename T>
+    const std::size_t PackedRTreeSpatialIndex<T>::MIN_REBUILD_COUNT = 256;
+
+    template<typename T>
+    const std::uint32_t PackedRTreeSpatialIndex<T>::HILBERT_GRID_SIZE = 65536;
+
+}
+
+#endif
@@ -7,11 +7,13 @@
 #ifndef _CARTO_SPATIALINDEX_H_
 #define _CARTO_SPATIALINDEX_H_
 
+#include <utility>
 #include <vector>
 
 #include <cglib/vec.h>
 #include <cglib/bbox.h>
 #include <cglib/frustum3.h>
+#include <cglib/ray.h>
 
 namespace carto {
     
@@ -25,11 +27,13 @@ namespace carto {
         
         virtual void clear() = 0;
         virtual void insert(const cglib::bbox3<double>& bounds, const T& object) = 0;
+        virtual void insertAll(const std::vector<std::pair<cglib::bbox3<double>, T> >& records) = 0;
         virtual bool remove(const cglib::bbox3<double>& bounds, const T& object) = 0;
         virtual bool remove(const T& object) = 0;
         
         virtual std::vector<T> query(const cglib::frustum3<double>& frustum) const = 0;
         virtual std::vector<T> query(const cglib::bbox3<double>& bounds) const = 0;
+        virtual std::vector<T> query(const cglib::ray3<double>& ray, double margin) const = 0; // records whose bounds expanded by margin intersect the ray
         virtual std::vector<T> getAll() const = 0;
     };
 
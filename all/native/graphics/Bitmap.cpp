@@ -1,6 +1,7 @@
 #include "Bitmap.h"
 #include "core/BinaryData.h"
 #include "components/Exceptions.h"
+#include "graphics/utils/BitmapKernels.h"
 #include "utils/Log.h"
 
 #include <algorithm>
@@ -76,6 +77,24 @@ namespace {
         return data;
     }
 
+    bool calculateDownscaledSize(unsigned int width, unsigned int height, unsigned int maxWidth, unsigned int maxHeight, unsigned int& scaledWidth, unsigned int& scaledHeight) {
+        float scale = 1.0f;
+        if (maxWidth > 0) {
+            scale = std::min(scale, static_cast<float>(maxWidth) / width);
+        }
+        if (maxHeight > 0) {
+            scale = std::min(scale, static_cast<float>(maxHeight) / height);
+        }
+        if (scale >= 1.0f) {
+            scaledWidth = width;
+            scaledHeight = height;
+            return false;
+        }
+        scaledWidth = std::max(1u, static_cast<unsigned int>(std::round(width * scale)));
+        scaledHeight = std::max(1u, static_cast<unsigned int>(std::round(height * scale)));
+        return true;
+    }
+
 }
 
 namespace carto {
@@ -263,128 +282,8 @@ namespace carto {
 
         // This will only scale the actual image part, the padding that was previously added to make the image
         // dimensions power of 2 will be ignored
-        const unsigned char* dsrc = _pixelData.data();
         std::vector<unsigned char> pixelData(width * height * _bytesPerPixel);
-        unsigned char* ddest = pixelData.data();
-    
-        bool bUpsampleX = (_width < width);
-        bool bUpsampleY = (_height < height);
-    
-        // If too many input pixels map to one output pixel, our 32-bit accumulation values
-        // could overflow - so, if we have huge mappings like that, cut down the weights:
-        //    256 max color value
-        //   *256 weight_x
-        //   *256 weight_y
-        //   *256 (16*16) maximum # of input pixels (x,y) - unless we cut the weights down...
-        int weight_shift = 0;
-        float source_texels_per_out_pixel = ((_width / static_cast<float>(width + 1))
-                * (_height / static_cast<float>(height + 1)));
-        float weight_per_pixel = source_texels_per_out_pixel * 256 * 256; //weight_x * weight_y
-        float accum_per_pixel = weight_per_pixel * 256; //color value is 0-255
-        float weight_div = accum_per_pixel / 4294967000.0f;
-        if (weight_div > 1) {
-            weight_shift = static_cast<int>(ceilf(logf(weight_div) / logf(2)));
-        }
-        weight_shift = std::min(15, weight_shift); // this could go to 15 and still be ok.
-    
-        float fh = 256 * _height / static_cast<float>(height);
-        float fw = 256 * _width / static_cast<float>(width);
-        // Cache x1a, x1b for all the columns
-    
-        std::vector<int> g_px1ab(width * 2 * 2);
-    
-        for (std::size_t x2 = 0; x2 < width; x2++) {
-            // Find the x-range of input pixels that will contribute:
-            int x1a = static_cast<int>((x2) * fw);
-            int x1b = static_cast<int>((x2 + 1) * fw);
-            if (bUpsampleX) {
-                // Map to same pixel -> we want to interpolate between two pixels!
-                x1b = x1a + 256;
-            }
-            x1b = std::min(x1b, static_cast<int>(256 * _width - 1));
-            g_px1ab[x2 * 2 + 0] = x1a;
-            g_px1ab[x2 * 2 + 1] = x1b;
-        }
-    
-        // For every output pixel
-        for (std::size_t y2 = 0; y2 < height; y2++) {
-            // Find the y-range of input pixels that will contribute:
-            int y1a = static_cast<int>((y2) * fh);
-            int y1b = static_cast<int>((y2 + 1) * fh);
-            if (bUpsampleY) {
-                // Map to same pixel -> we want to interpolate between two pixels!
-                y1b = y1a + 256;
-            }
-            y1b = std::min(y1b, static_cast<int>(256 * _height - 1));
-            int y1c = y1a >> 8;
-            int y1d = y1b >> 8;
-    
-            for (std::size_t x2 = 0; x2 < width; x2++) {
-                // Find the x-range of input pixels that will contribute
-                int x1a = g_px1ab[x2 * 2 + 0];
-                int x1b = g_px1ab[x2 * 2 + 1];
-                int x1c = x1a >> 8;
-                int x1d = x1b >> 8;
-    
-                // Add ip all input pixels contributing to this output pixel
-                unsigned int r = 0, g = 0, b = 0, a = 0, wa = 0;
-                for (int y = y1c; y <= y1d; y++) {
-                    unsigned int weight_y = 256;
-                    if (y1c != y1d) {
-                        if (y == y1c) {
-                            weight_y = 256 - (y1a & 0xFF);
-                        } else if (y == y1d) {
-                            weight_y = (y1b & 0xFF);
-                        }
-                    }
-    
-                    const unsigned char* dsrc2 = &dsrc[y * _width * _bytesPerPixel + x1c * _bytesPerPixel];
-                    for (int x = x1c; x <= x1d; x++) {
-                        unsigned int weight_x = 256;
-                        if (x1c != x1d) {
-                            if (x == x1c) {
-                                weight_x = 256 - (x1a & 0xFF);
-                            } else if (x == x1d) {
-                                weight_x = (x1b & 0xFF);
-                            }
-                        }
-    
-                        unsigned int w = (weight_x * weight_y) >> weight_shift;
-
-                        unsigned char r_src = *dsrc2++;
-                        r += r_src * w;
-                        if (_bytesPerPixel > 1) {
-                            unsigned char g_src = *dsrc2++;
-                            g += g_src * w;
-                        }
-                        if (_bytesPerPixel > 2) {
-                            unsigned char b_src = *dsrc2++;
-                            b += b_src * w;
-                        }
-                        if (_bytesPerPixel > 3) {
-                            unsigned char a_src = *dsrc2++;
-                            a += a_src * w;
-                        }
-                        wa += w;
-                    }
-                }
-                if (wa <= 0) {
-                    wa = std::numeric_limits<int>::max();
-                }
-    
-                // Write results
-                *ddest++ = r / wa;
-                if (_bytesPerPixel > 1) {
-                    *ddest++ = g / wa;
-                }
-                if (_bytesPerPixel > 2) {
-                    *ddest++ = b / wa;
-                }
-                if (_bytesPerPixel > 3) {
-                    *ddest++ = a / wa;
-                }
-            }
-        }
+        BitmapKernels::Resample(_pixelData.data(), _width, _height, pixelData.data(), width, height, _bytesPerPixel);
         
         return std::make_shared<Bitmap>(pixelData.data(), width, height, _colorFormat, -static_cast<int>(width * _bytesPerPixel));
     }
@@ -417,75 +316,8 @@ namespace carto {
     
     std::shared_ptr<Bitmap> Bitmap::getRGBABitmap() const {
         std::vector<unsigned char> pixelData(_width * _height * 4, 255);
-        for (unsigned int i = 0; i < _height; i++) {
-            for (unsigned int j = 0; j < _width; j++) {
-                unsigned int destIndex = (i * _width + j) * 4;
-                unsigned int srcIndex = (i * _width + j) * _bytesPerPixel;
-                switch (_colorFormat) {
-                case ColorFormat::COLOR_FORMAT_GRAYSCALE:
-                    pixelData[destIndex + 0] = _pixelData[srcIndex];
-                    pixelData[destIndex + 1] = _pixelData[srcIndex];
-                    pixelData[destIndex + 2] = _pixelData[srcIndex];
-                    break;
-                case ColorFormat::COLOR_FORMAT_GRAYSCALE_ALPHA:
-                    pixelData[destIndex + 0] = _pixelData[srcIndex];
-                    pixelData[destIndex + 1] = _pixelData[srcIndex];
-                    pixelData[destIndex + 2] = _pixelData[srcIndex];
-                    pixelData[destIndex + 3] = _pixelData[srcIndex + 1];
-                    break;
-                case ColorFormat::COLOR_FORMAT_RGB:
-                    pixelData[destIndex + 0] = _pixelData[srcIndex + 0];
-                    pixelData[destIndex + 1] = _pixelData[srcIndex + 1];
-                    pixelData[destIndex + 2] = _pixelData[srcIndex + 2];
-                    break;
-                case ColorFormat::COLOR_FORMAT_RGBA:
-                    pixelData[destIndex + 0] = _pixelData[srcIndex + 0];
-                    pixelData[destIndex + 1] = _pixelData[srcIndex + 1];
-                    pixelData[destIndex + 2] = _pixelData[srcIndex + 2];
-                    pixelData[destIndex + 3] = _pixelData[srcIndex + 3];
-                    break;
-                case ColorFormat::COLOR_FORMAT_BGRA:
-                    pixelData[destIndex + 0] = _pixelData[srcIndex + 2];
-                    pixelData[destIndex + 1] = _pixelData[srcIndex + 1];
-                    pixelData[destIndex + 2] = _pixelData[srcIndex + 0];
-                    pixelData[destIndex + 3] = _pixelData[srcIndex + 3];
-                    break;
-                case ColorFormat::COLOR_FORMAT_RGBA_4444:
-                    {
-                        unsigned short color = *reinterpret_cast<const unsigned short*>(&_pixelData[srcIndex]);
-                        unsigned char r = (color & 0xF000) >> 8;
-                        r = r | (r >> 4);
-                        unsigned char g = (color & 0xF00) >> 4;
-                        g = g | (g >> 4);
-                        unsigned char b = (color & 0xF0);
-                        b = b | (b >> 4);
-                        unsigned char a = (color & 0xF) << 4;
-                        a = a | (a >> 4);
-                        pixelData[destIndex + 0] = r;
-                        pixelData[destIndex + 1] = g;
-                        pixelData[destIndex + 2] = b;
-                        pixelData[destIndex + 3] = a;
-                    }
-                    break;
-                case ColorFormat::COLOR_FORMAT_RGB_565:
-                    {
-                        unsigned short color = *reinterpret_cast<const unsigned short*>(&_pixelData[srcIndex]);
-                        unsigned char r = (color & 0xF800) >> 8;
-                        r = r | (r >> 5);
-                        unsigned char g = (color & 0x7E0) >> 3;
-                        g = g | (g >> 6);
-                        unsigned char b = (color & 0x1F) << 3;
-                        b = b | (b >> 5);
-                        pixelData[destIndex + 0] = r;
-                        pixelData[destIndex + 1] = g;
-                        pixelData[destIndex + 2] = b;
-                    }
-                    break;
-                default:
-                    Log::Error("Bitmap::getRGBABitmap: Failed to convert bitmap due to unsupported color format");
-                    break;
-                }
-            }
+        if (!BitmapKernels::ConvertToRGBA(_pixelData.data(), pixelData.data(), _width * _height, _colorFormat)) {
+            Log::Error("Bitmap::getRGBABitmap: Failed to convert bitmap due to unsupported color format");
         }
         
         // Create new bitmap
@@ -506,9 +338,45 @@ namespace carto {
         }
 
         std::shared_ptr<Bitmap> bitmap(new Bitmap);
-        if (!bitmap->loadFromCompressedBytes(compressedData, dataSize)) {
+        if (!bitmap->loadFromCompressedBytes(compressedData, dataSize, 0, 0, std::function<bool()>())) {
+            return std::shared_ptr<Bitmap>();
+        }
+        return bitmap;
+    }
+
+    std::shared_ptr<Bitmap> Bitmap::CreateFromCompressed(const std::shared_ptr<BinaryData>& compressedData, unsigned int maxWidth, unsigned int maxHeight, ColorFormat::ColorFormat colorFormat) {
+        if (!compressedData) {
+            throw NullArgumentException("Null compressedData");
+        }
+
+        return CreateFromCompressed(compressedData->data(), compressedData->size(), maxWidth, maxHeight, colorFormat);
+    }
+
+    std::shared_ptr<Bitmap> Bitmap::CreateFromCompressed(const unsigned char* compressedData, std::size_t dataSize, unsigned int maxWidth, unsigned int maxHeight, ColorFormat::ColorFormat colorFormat) {
+        return CreateFromCompressed(compressedData, dataSize, maxWidth, maxHeight, colorFormat, std::function<bool()>());
+    }
+
+    std::shared_ptr<Bitmap> Bitmap::CreateFromCompressed(const unsigned char* compressedData, std::size_t dataSize, unsigned int maxWidth, unsigned int maxHeight, ColorFormat::ColorFormat colorFormat, const std::function<bool()>& cancelCheck) {
+        if (!compressedData) {
+            throw NullArgumentException("Null compressedData");
+        }
+        if (colorFormat != ColorFormat::COLOR_FORMAT_UNSUPPORTED && colorFormat != ColorFormat::COLOR_FORMAT_RGBA) {
+            throw InvalidArgumentException("Unsupported color format");
+        }
+
+        std::shared_ptr<Bitmap> bitmap(new Bitmap);
+        if (!bitmap->loadFromCompressedBytes(compressedData, dataSize, maxWidth, maxHeight, cancelCheck)) {
             return std::shared_ptr<Bitmap>();
         }
+
+        // Resize formats that could not be scaled by the decoder, JPEG decoder scales only by powers of 2
+        unsigned int scaledWidth = 0, scaledHeight = 0;
+        if (calculateDownscaledSize(bitmap->_width, bitmap->_height, maxWidth, maxHeight, scaledWidth, scaledHeight)) {
+            bitmap = bitmap->getResizedBitmap(scaledWidth, scaledHeight);
+        }
+        if (colorFormat == ColorFormat::COLOR_FORMAT_RGBA && bitmap->_colorFormat != ColorFormat::COLOR_FORMAT_RGBA) {
+            bitmap = bitmap->getRGBABitmap();
+        }
         return bitmap;
     }
     
@@ -521,20 +389,20 @@ namespace carto {
     {
     }
 
-    bool Bitmap::loadFromCompressedBytes(const unsigned char* compressedData, std::size_t dataSize) {
+    bool Bitmap::loadFromCompressedBytes(const unsigned char* compressedData, std::size_t dataSize, unsigned int maxWidth, unsigned int maxHeight, const std::function<bool()>& cancelCheck) {
         if (IsJPEG(compressedData, dataSize)) {
-            return loadJPEG(compressedData, dataSize);
+            return loadJPEG(compressedData, dataSize, maxWidth, maxHeight, cancelCheck);
         } else if (IsPNG(compressedData, dataSize)) {
-            return loadPNG(compressedData, dataSize);
+            return loadPNG(compressedData, dataSize, cancelCheck);
         } else if (IsWEBP(compressedData, dataSize)) {
-            return loadWEBP(compressedData, dataSize);
+            return loadWEBP(compressedData, dataSize, maxWidth, maxHeight);
         } else if (IsNUTI(compressedData, dataSize)) {
             return loadNUTI(compressedData, dataSize);
         } else {
             std::vector<unsigned char> uncompressedData;
             if (zlib::inflate_gzip(compressedData, dataSize, uncompressedData)) {
                 Log::Info("Bitmap::loadFromCompressedBytes: Image is gzipped, decompressing");
-                return loadFromCompressedBytes(uncompressedData.data(), uncompressedData.size());
+                return loadFromCompressedBytes(uncompressedData.data(), uncompressedData.size(), maxWidth, maxHeight, cancelCheck);
             } else {
                 Log::Error("Bitmap::loadFromCompressedBytes: Unsupported image format");
                 return false;
@@ -585,7 +453,15 @@ namespace carto {
         unsigned int newBytesPerRow = _width * _bytesPerPixel;
         unsigned int newActualBytesPerRow = _width * _bytesPerPixel;
         
-        if (convert) {
+        if (_colorFormat == ColorFormat::COLOR_FORMAT_BGRA) {
+            // Swizzle whole rows, bytes per pixel do not change
+            for (unsigned int i = 0; i < _height; i++) {
+                unsigned int flippedI = _height - 1 - i;
+                unsigned int srcIndex = (bytesPerRow < 0 ? flippedI : i) * std::abs(bytesPerRow);
+                BitmapKernels::ConvertToRGBA(pixelData + srcIndex, &_pixelData[flippedI * newBytesPerRow], _width, _colorFormat);
+            }
+            _colorFormat = ColorFormat::COLOR_FORMAT_RGBA;
+        } else if (convert) {
             for (unsigned int i = 0; i < _height; i++) {
                 unsigned int flippedI = (_height - 1 - i);
                 for (unsigned int j = 0; j < newActualBytesPerRow; j += _bytesPerPixel) {
@@ -697,7 +573,7 @@ namespace carto {
         return std::equal(NUTiHeader, NUTiHeader + sizeof(NUTiHeader), compressedData);
     }
         
-    bool Bitmap::loadJPEG(const unsigned char* compressedData, std::size_t dataSize) {
+    bool Bitmap::loadJPEG(const unsigned char* compressedData, std::size_t dataSize, unsigned int maxWidth, unsigned int maxHeight, const std::function<bool()>& cancelCheck) {
         jpeg_decompress_struct cinfo;
         JPEGErrorManager jerr;
         cinfo.err = jpeg_std_error(&jerr.pub);
@@ -717,6 +593,17 @@ namespace carto {
     
         // Read headers, prepare to decompress
         jpeg_read_header(&cinfo, TRUE);
+
+        // Use DCT scaling, but keep the image at least as large as the requested size
+        unsigned int scaledWidth = 0, scaledHeight = 0;
+        if (calculateDownscaledSize(cinfo.image_width, cinfo.image_height, maxWidth, maxHeight, scaledWidth, scaledHeight)) {
+            unsigned int scaleDenom = 1;
+            while (scaleDenom < 8 && (cinfo.image_width + scaleDenom * 2 - 1) / (scaleDenom * 2) >= scaledWidth && (cinfo.image_height + scaleDenom * 2 - 1) / (scaleDenom * 2) >= scaledHeight) {
+                scaleDenom *= 2;
+            }
+            cinfo.scale_num = 1;
+            cinfo.scale_denom = scaleDenom;
+        }
         jpeg_start_decompress(&cinfo);
     
         _width = cinfo.output_width;
@@ -739,8 +626,12 @@ namespace carto {
         int bytesPerRow = _width * _bytesPerPixel;
         _pixelData.resize(bytesPerRow * _height);
     
-        // Read lines, flip y
+        // Read lines, flip y. Stop early if the decoding is canceled.
         while (cinfo.output_scanline < _height) {
+            if (cancelCheck && cinfo.output_scanline % CANCEL_CHECK_ROWS == 0 && cancelCheck()) {
+                jpeg_destroy_decompress(&cinfo);
+                return false;
+            }
             unsigned char* pixelDataPtr = &_pixelData[(_height - 1 - cinfo.output_scanline) * bytesPerRow];
             jpeg_read_scanlines(&cinfo, &pixelDataPtr, 1);
         }
@@ -752,7 +643,7 @@ namespace carto {
         return true;
     }
     
-    bool Bitmap::loadPNG(const unsigned char* compressedData, std::size_t dataSize) {
+    bool Bitmap::loadPNG(const unsigned char* compressedData, std::size_t dataSize, const std::function<bool()>& cancelCheck) {
         png_structp pngPtr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, reportPNGErrorCallback, reportPNGWarningCallback);
         if (!pngPtr) {
             Log::Error("Bitmap::loadPNG: Failed to load PNG");
@@ -816,6 +707,9 @@ namespace carto {
             png_set_tRNS_to_alpha(pngPtr);
         }
     
+        // Read interlaced images in multiple passes
+        int passCount = png_set_interlace_handling(pngPtr);
+
         // Update png info
         png_read_update_info(pngPtr, infoPtr);
         if (png_get_IHDR(pngPtr, infoPtr, &_width, &_height, &bitDepth, &colorType, NULL, NULL, NULL) == 0) {
@@ -865,16 +759,20 @@ namespace carto {
             rowPointers[_height - 1 - i] = pixelDataPtr + i * bytesPerRow;
         }
     
-        // Read the png into image_data through row_pointers
-        png_read_image(pngPtr, rowPointers.data());
+        // Read the png into image_data through row_pointers. Stop early if the decoding is canceled.
+        for (int pass = 0; pass < passCount; pass++) {
+            for (std::size_t i = 0; i < _height; i++) {
+                if (cancelCheck && i % CANCEL_CHECK_ROWS == 0 && cancelCheck()) {
+                    png_destroy_read_struct(&pngPtr, &infoPtr, &endInfo);
+                    return false;
+                }
+                png_read_row(pngPtr, rowPointers[i], NULL);
+            }
+        }
     
         if (premultiply) {
             // Premultiply alpha
-            for (std::size_t i = 0; i < _pixelData.size(); i += _bytesPerPixel) {
-                for (std::size_t j = 0; j < _bytesPerPixel - 1; j++) {
-                    _pixelData[i + j] = (_pixelData[i + j] * _pixelData[i + _bytesPerPixel - 1]) / 255;
-                }
-            }
+            BitmapKernels::PremultiplyAlpha(_pixelData.data(), _pixelData.size() / _bytesPerPixel, _bytesPerPixel);
         }
     
         // Free memory
@@ -883,36 +781,53 @@ namespace carto {
         return true;
     }
         
-    bool Bitmap::loadWEBP(const unsigned char* compressedData, std::size_t dataSize) {
-        WebPBitstreamFeatures features;
-        if (WebPGetFeatures(compressedData, dataSize, &features) != VP8_STATUS_OK) {
+    bool Bitmap::loadWEBP(const unsigned char* compressedData, std::size_t dataSize, unsigned int maxWidth, unsigned int maxHeight) {
+        WebPDecoderConfig config;
+        if (!WebPInitDecoderConfig(&config)) {
+            Log::Error("Bitmap::loadWEBP: Failed to initialize WEBP decoder");
+            return false;
+        }
+        if (WebPGetFeatures(compressedData, dataSize, &config.input) != VP8_STATUS_OK) {
             Log::Error("Bitmap::loadWEBP: Failed to load WEBP features");
             return false;
         }
         
-        _width = features.width;
-        _height = features.height;
+        _width = config.input.width;
+        _height = config.input.height;
+        if (calculateDownscaledSize(config.input.width, config.input.height, maxWidth, maxHeight, _width, _height)) {
+            config.options.use_scaling = 1;
+            config.options.scaled_width = _width;
+            config.options.scaled_height = _height;
+        }
     
-        unsigned char* decodedData;
-        if (features.has_alpha) {
+        if (config.input.has_alpha) {
             _bytesPerPixel = 4;
             _colorFormat = ColorFormat::COLOR_FORMAT_RGBA;
-            decodedData = WebPDecodeRGBA(compressedData, dataSize, NULL, NULL);
+            config.output.colorspace = MODE_RGBA;
         } else {
             _bytesPerPixel = 3;
             _colorFormat = ColorFormat::COLOR_FORMAT_RGB;
-            decodedData = WebPDecodeRGB(compressedData, dataSize, NULL, NULL);
+            config.output.colorspace = MODE_RGB;
         }
         
+        // Decode directly into the pixel buffer
         unsigned int bytesPerRow = _width * _bytesPerPixel;
         _pixelData.resize(_height * bytesPerRow);
-        for (unsigned int i = 0; i < _height; i++) {
-            for (unsigned int j = 0; j < bytesPerRow; j++) {
-                _pixelData[(_height - i - 1) * bytesPerRow + j] = decodedData[i * bytesPerRow + j];
-            }
+        config.output.is_external_memory = 1;
+        config.output.u.RGBA.rgba = _pixelData.data();
+        config.output.u.RGBA.stride = bytesPerRow;
+        config.output.u.RGBA.size = _pixelData.size();
+        VP8StatusCode status = WebPDecode(compressedData, dataSize, &config);
+        WebPFreeDecBuffer(&config.output);
+        if (status != VP8_STATUS_OK) {
+            Log::Errorf("Bitmap::loadWEBP: Failed to decode WEBP: %d", static_cast<int>(status));
+            return false;
         }
         
-        WebPFree(decodedData);
+        // Flip y
+        for (unsigned int i = 0; i < _height / 2; i++) {
+            std::swap_ranges(&_pixelData[i * bytesPerRow], &_pixelData[i * bytesPerRow] + bytesPerRow, &_pixelData[(_height - i - 1) * bytesPerRow]);
+        }
         
         return true;
     }
@@ -937,5 +852,7 @@ namespace carto {
     
         return true;
     }
+
+    const unsigned int Bitmap::CANCEL_CHECK_ROWS = 32;
         
 }
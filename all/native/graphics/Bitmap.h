@@ -7,6 +7,7 @@
 #ifndef _CARTO_BITMAP_H_
 #define _CARTO_BITMAP_H_
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -195,11 +196,46 @@ namespace carto {
          * @return The bitmap created from the compressed data. If the decompression fails, null is returned.
          */
         static std::shared_ptr<Bitmap> CreateFromCompressed(const unsigned char* compressedData, std::size_t dataSize);
+        /**
+         * Creates a new bitmap from compressed byte vector, downscaling the image to fit within the given size and converting it to the given color format.
+         * JPEG and WEBP images are scaled by the decoder, thus the full resolution image is never created. Other formats are resized after decoding.
+         * Aspect ratio of the image is kept and smaller images are not upscaled.
+         * @param compressedData The compressed bitmap data.
+         * @param maxWidth The maximum width of the bitmap. If 0, the width is not limited.
+         * @param maxHeight The maximum height of the bitmap. If 0, the height is not limited.
+         * @param colorFormat The color format of the bitmap. Can be COLOR_FORMAT_RGBA or COLOR_FORMAT_UNSUPPORTED, in which case the format of the image is kept.
+         * @return The bitmap created from the compressed data. If the decompression fails, null is returned.
+         */
+        static std::shared_ptr<Bitmap> CreateFromCompressed(const std::shared_ptr<BinaryData>& compressedData, unsigned int maxWidth, unsigned int maxHeight, ColorFormat::ColorFormat colorFormat);
+        /**
+         * Creates a new bitmap from compressed byte data, downscaling the image to fit within the given size and converting it to the given color format.
+         * JPEG and WEBP images are scaled by the decoder, thus the full resolution image is never created. Other formats are resized after decoding.
+         * Aspect ratio of the image is kept and smaller images are not upscaled.
+         * @param compressedData The compressed bitmap data.
+         * @param dataSize size of the compressed data.
+         * @param maxWidth The maximum width of the bitmap. If 0, the width is not limited.
+         * @param maxHeight The maximum height of the bitmap. If 0, the height is not limited.
+         * @param colorFormat The color format of the bitmap. Can be COLOR_FORMAT_RGBA or COLOR_FORMAT_UNSUPPORTED, in which case the format of the image is kept.
+         * @return The bitmap created from the compressed data. If the decompression fails, null is returned.
+         */
+        static std::shared_ptr<Bitmap> CreateFromCompressed(const unsigned char* compressedData, std::size_t dataSize, unsigned int maxWidth, unsigned int maxHeight, ColorFormat::ColorFormat colorFormat);
+        /**
+         * Creates a new bitmap from compressed byte data, downscaling the image to fit within the given size and converting it to the given color format.
+         * JPEG and PNG images are decoded row by row and the decoding is stopped once the cancel check returns true.
+         * @param compressedData The compressed bitmap data.
+         * @param dataSize size of the compressed data.
+         * @param maxWidth The maximum width of the bitmap. If 0, the width is not limited.
+         * @param maxHeight The maximum height of the bitmap. If 0, the height is not limited.
+         * @param colorFormat The color format of the bitmap. Can be COLOR_FORMAT_RGBA or COLOR_FORMAT_UNSUPPORTED, in which case the format of the image is kept.
+         * @param cancelCheck The function that is called periodically during decoding. If it returns true, the decoding is stopped. Can be empty.
+         * @return The bitmap created from the compressed data. If the decompression fails or is canceled, null is returned.
+         */
+        static std::shared_ptr<Bitmap> CreateFromCompressed(const unsigned char* compressedData, std::size_t dataSize, unsigned int maxWidth, unsigned int maxHeight, ColorFormat::ColorFormat colorFormat, const std::function<bool()>& cancelCheck);
         
     protected:
         Bitmap();
         
-        bool loadFromCompressedBytes(const unsigned char* compressedData, std::size_t dataSize);
+        bool loadFromCompressedBytes(const unsigned char* compressedData, std::size_t dataSize, unsigned int maxWidth, unsigned int maxHeight, const std::function<bool()>& cancelCheck);
         bool loadFromUncompressedBytes(const unsigned char* pixelData, unsigned int width, unsigned int height,
                                        ColorFormat::ColorFormat colorFormat, int bytesPerRow);
     
@@ -208,10 +244,12 @@ namespace carto {
         static bool IsWEBP(const unsigned char* compressedData, std::size_t dataSize);
         static bool IsNUTI(const unsigned char* compressedData, std::size_t dataSize);
     
-        bool loadJPEG(const unsigned char* compressedData, std::size_t dataSize);
-        bool loadPNG(const unsigned char* compressedData, std::size_t dataSize);
-        bool loadWEBP(const unsigned char* compressedData, std::size_t dataSize);
+        bool loadJPEG(const unsigned char* compressedData, std::size_t dataSize, unsigned int maxWidth, unsigned int maxHeight, const std::function<bool()>& cancelCheck);
+        bool loadPNG(const unsigned char* compressedData, std::size_t dataSize, const std::function<bool()>& cancelCheck);
+        bool loadWEBP(const unsigned char* compressedData, std::size_t dataSize, unsigned int maxWidth, unsigned int maxHeight);
         bool loadNUTI(const unsigned char* compressedData, std::size_t dataSize);
+
+        static const unsigned int CANCEL_CHECK_ROWS;
         
         unsigned int _width;
         unsigned int _height;
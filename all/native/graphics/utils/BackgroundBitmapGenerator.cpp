@@ -12,6 +12,31 @@ namespace carto {
     }
 
     std::shared_ptr<Bitmap> BackgroundBitmapGenerator::generateBitmap(const Color& backgroundColor, const Color& dotColor) const {
+        BitmapKey key(_blockSize, _blockCount, backgroundColor.getARGB(), dotColor.getARGB());
+
+        std::lock_guard<std::mutex> lock(_GeneratedBitmapsMutex);
+        auto it = _GeneratedBitmaps.find(key);
+        if (it != _GeneratedBitmaps.end()) {
+            if (std::shared_ptr<Bitmap> bitmap = it->second.lock()) {
+                return bitmap;
+            }
+        }
+
+        // Drop the entries of released bitmaps before adding the new one
+        for (auto it2 = _GeneratedBitmaps.begin(); it2 != _GeneratedBitmaps.end(); ) {
+            if (it2->second.expired()) {
+                it2 = _GeneratedBitmaps.erase(it2);
+            } else {
+                it2++;
+            }
+        }
+
+        std::shared_ptr<Bitmap> bitmap = createBitmap(backgroundColor, dotColor);
+        _GeneratedBitmaps[key] = bitmap;
+        return bitmap;
+    }
+
+    std::shared_ptr<Bitmap> BackgroundBitmapGenerator::createBitmap(const Color& backgroundColor, const Color& dotColor) const {
         int size = _blockSize * _blockCount;
         std::vector<unsigned char> data(size * size * 4);
 
@@ -39,4 +64,7 @@ namespace carto {
 
     const int BackgroundBitmapGenerator::DEFAULT_CONTRAST_DIFF = 40;
 
+    std::map<BackgroundBitmapGenerator::BitmapKey, std::weak_ptr<Bitmap> > BackgroundBitmapGenerator::_GeneratedBitmaps;
+    std::mutex BackgroundBitmapGenerator::_GeneratedBitmapsMutex;
+
 }
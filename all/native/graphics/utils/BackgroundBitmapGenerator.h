@@ -10,10 +10,17 @@
 #include "graphics/Bitmap.h"
 #include "graphics/Color.h"
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
 namespace carto {
 
     /**
      * A generator for background bitmaps.
+     * Generated bitmaps are shared while in use, so generating the bitmap again with the same parameters
+     * (for example, after a style or option change is reverted) returns the existing instance.
      */
     class BackgroundBitmapGenerator {
     public:
@@ -23,8 +30,15 @@ namespace carto {
         std::shared_ptr<Bitmap> generateBitmap(const Color& backgroundColor, const Color& dotColor) const;
 
     private:
+        typedef std::tuple<int, int, int, int> BitmapKey;
+
+        std::shared_ptr<Bitmap> createBitmap(const Color& backgroundColor, const Color& dotColor) const;
+
         static const int DEFAULT_CONTRAST_DIFF;
 
+        static std::map<BitmapKey, std::weak_ptr<Bitmap> > _GeneratedBitmaps;
+        static std::mutex _GeneratedBitmapsMutex;
+
         const int _blockSize;
         const int _blockCount;
     };
@@ -0,0 +1,320 @@
+#include "BitmapKernels.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define CARTO_BITMAPKERNELS_NEON
+#include <arm_neon.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CARTO_BITMAPKERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+    struct AxisContribution {
+        int first;
+        int last;
+        unsigned int firstWeight;
+        unsigned int lastWeight;
+        unsigned int weightSum;
+
+        unsigned int getWeight(int i) const {
+            if (first == last) {
+                return 256;
+            }
+            return i == first ? firstWeight : (i == last ? lastWeight : 256);
+        }
+    };
+
+    std::vector<AxisContribution> calculateAxisContributions(unsigned int srcSize, unsigned int destSize) {
+        // Positions are in 1/256 source pixel units, upsampling interpolates between two neighbouring pixels
+        bool upsample = srcSize < destSize;
+        float scale = 256 * srcSize / static_cast<float>(destSize);
+
+        std::vector<AxisContribution> contributions(destSize);
+        for (unsigned int i = 0; i < destSize; i++) {
+            int a = static_cast<int>(i * scale);
+            int b = upsample ? a + 256 : static_cast<int>((i + 1) * scale);
+            b = std::min(b, static_cast<int>(256 * srcSize - 1));
+
+            AxisContribution& contribution = contributions[i];
+            contribution.first = a >> 8;
+            contribution.last = b >> 8;
+            contribution.firstWeight = 256 - (a & 0xFF);
+            contribution.lastWeight = b & 0xFF;
+            contribution.weightSum = 0;
+            for (int j = contribution.first; j <= contribution.last; j++) {
+                contribution.weightSum += contribution.getWeight(j);
+            }
+        }
+        return contributions;
+    }
+
+    inline unsigned char divideBy255(unsigned int x) {
+        // Exact floor(x / 255) for x <= 255 * 255
+        return static_cast<unsigned char>((x + 1 + (x >> 8)) >> 8);
+    }
+
+}
+
+namespace carto {
+
+    void BitmapKernels::PremultiplyAlpha(unsigned char* pixels, std::size_t pixelCount, unsigned int bytesPerPixel) {
+        std::size_t i = 0;
+        if (bytesPerPixel == 4) {
+#if defined(CARTO_BITMAPKERNELS_NEON)
+            uint16x8_t one = vdupq_n_u16(1);
+            for (; i + 8 <= pixelCount; i += 8) {
+                uint8x8x4_t rgba = vld4_u8(pixels + i * 4);
+                for (int c = 0; c < 3; c++) {
+                    uint16x8_t x = vmull_u8(rgba.val[c], rgba.val[3]);
+                    x = vshrq_n_u16(vaddq_u16(vaddq_u16(x, vshrq_n_u16(x, 8)), one), 8);
+                    rgba.val[c] = vmovn_u16(x);
+                }
+                vst4_u8(pixels + i * 4, rgba);
+            }
+#elif defined(CARTO_BITMAPKERNELS_SSE2)
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i one = _mm_set1_epi16(1);
+            const __m128i alphaMask = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+            const __m128i alphaOne = _mm_and_si128(alphaMask, _mm_set1_epi16(255));
+            for (; i + 4 <= pixelCount; i += 4) {
+                __m128i rgba = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i * 4));
+                __m128i halves[2] = { _mm_unpacklo_epi8(rgba, zero), _mm_unpackhi_epi8(rgba, zero) };
+                for (int h = 0; h < 2; h++) {
+                    // Broadcast alpha to all channels of both pixels, keep alpha itself unchanged
+                    __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(halves[h], _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+                    alpha = _mm_or_si128(_mm_andnot_si128(alphaMask, alpha), alphaOne);
+                    __m128i x = _mm_mullo_epi16(halves[h], alpha);
+                    halves[h] = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), one), 8);
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i * 4), _mm_packus_epi16(halves[0], halves[1]));
+            }
+#endif
+        }
+
+        for (; i < pixelCount; i++) {
+            unsigned char* pixel = pixels + i * bytesPerPixel;
+            unsigned int a = pixel[bytesPerPixel - 1];
+            for (unsigned int j = 0; j < bytesPerPixel - 1; j++) {
+                pixel[j] = divideBy255(pixel[j] * a);
+            }
+        }
+    }
+
+    bool BitmapKernels::ConvertToRGBA(const unsigned char* src, unsigned char* dest, std::size_t pixelCount, ColorFormat::ColorFormat colorFormat) {
+        std::size_t i = 0;
+        switch (colorFormat) {
+        case ColorFormat::COLOR_FORMAT_GRAYSCALE:
+#if defined(CARTO_BITMAPKERNELS_NEON)
+            for (; i + 16 <= pixelCount; i += 16) {
+                uint8x16x4_t rgba;
+                rgba.val[0] = rgba.val[1] = rgba.val[2] = vld1q_u8(src + i);
+                rgba.val[3] = vdupq_n_u8(255);
+                vst4q_u8(dest + i * 4, rgba);
+            }
+#endif
+            for (; i < pixelCount; i++) {
+                dest[i * 4 + 0] = dest[i * 4 + 1] = dest[i * 4 + 2] = src[i];
+                dest[i * 4 + 3] = 255;
+            }
+            return true;
+        case ColorFormat::COLOR_FORMAT_GRAYSCALE_ALPHA:
+#if defined(CARTO_BITMAPKERNELS_NEON)
+            for (; i + 16 <= pixelCount; i += 16) {
+                uint8x16x2_t ga = vld2q_u8(src + i * 2);
+                uint8x16x4_t rgba;
+                rgba.val[0] = rgba.val[1] = rgba.val[2] = ga.val[0];
+                rgba.val[3] = ga.val[1];
+                vst4q_u8(dest + i * 4, rgba);
+            }
+#endif
+            for (; i < pixelCount; i++) {
+                dest[i * 4 + 0] = dest[i * 4 + 1] = dest[i * 4 + 2] = src[i * 2 + 0];
+                dest[i * 4 + 3] = src[i * 2 + 1];
+            }
+            return true;
+        case ColorFormat::COLOR_FORMAT_RGB:
+#if defined(CARTO_BITMAPKERNELS_NEON)
+            for (; i + 16 <= pixelCount; i += 16) {
+                uint8x16x3_t rgb = vld3q_u8(src + i * 3);
+                uint8x16x4_t rgba;
+                rgba.val[0] = rgb.val[0];
+                rgba.val[1] = rgb.val[1];
+                rgba.val[2] = rgb.val[2];
+                rgba.val[3] = vdupq_n_u8(255);
+                vst4q_u8(dest + i * 4, rgba);
+            }
+#endif
+            for (; i < pixelCount; i++) {
+                dest[i * 4 + 0] = src[i * 3 + 0];
+                dest[i * 4 + 1] = src[i * 3 + 1];
+                dest[i * 4 + 2] = src[i * 3 + 2];
+                dest[i * 4 + 3] = 255;
+            }
+            return true;
+        case ColorFormat::COLOR_FORMAT_RGBA:
+            std::memcpy(dest, src, pixelCount * 4);
+            return true;
+        case ColorFormat::COLOR_FORMAT_BGRA:
+#if defined(CARTO_BITMAPKERNELS_NEON)
+            for (; i + 16 <= pixelCount; i += 16) {
+                uint8x16x4_t bgra = vld4q_u8(src + i * 4);
+                std::swap(bgra.val[0], bgra.val[2]);
+                vst4q_u8(dest + i * 4, bgra);
+            }
+#elif defined(CARTO_BITMAPKERNELS_SSE2)
+            {
+                const __m128i greenAlphaMask = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+                for (; i + 4 <= pixelCount; i += 4) {
+                    __m128i bgra = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+                    __m128i ga = _mm_and_si128(bgra, greenAlphaMask);
+                    __m128i br = _mm_andnot_si128(greenAlphaMask, bgra);
+                    __m128i rb = _mm_shufflehi_epi16(_mm_shufflelo_epi16(br, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 4), _mm_or_si128(ga, rb));
+                }
+            }
+#endif
+            for (; i < pixelCount; i++) {
+                dest[i * 4 + 0] = src[i * 4 + 2];
+                dest[i * 4 + 1] = src[i * 4 + 1];
+                dest[i * 4 + 2] = src[i * 4 + 0];
+                dest[i * 4 + 3] = src[i * 4 + 3];
+            }
+            return true;
+        case ColorFormat::COLOR_FORMAT_RGBA_4444:
+            for (; i < pixelCount; i++) {
+                unsigned short color = *reinterpret_cast<const unsigned short*>(&src[i * 2]);
+                unsigned char r = (color & 0xF000) >> 8;
+                unsigned char g = (color & 0xF00) >> 4;
+                unsigned char b = (color & 0xF0);
+                unsigned char a = (color & 0xF) << 4;
+                dest[i * 4 + 0] = r | (r >> 4);
+                dest[i * 4 + 1] = g | (g >> 4);
+                dest[i * 4 + 2] = b | (b >> 4);
+                dest[i * 4 + 3] = a | (a >> 4);
+            }
+            return true;
+        case ColorFormat::COLOR_FORMAT_RGB_565:
+            for (; i < pixelCount; i++) {
+                unsigned short color = *reinterpret_cast<const unsigned short*>(&src[i * 2]);
+                unsigned char r = (color & 0xF800) >> 8;
+                unsigned char g = (color & 0x7E0) >> 3;
+                unsigned char b = (color & 0x1F) << 3;
+                dest[i * 4 + 0] = r | (r >> 5);
+                dest[i * 4 + 1] = g | (g >> 6);
+                dest[i * 4 + 2] = b | (b >> 5);
+                dest[i * 4 + 3] = 255;
+            }
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    void BitmapKernels::Resample(const unsigned char* src, unsigned int srcWidth, unsigned int srcHeight, unsigned char* dest, unsigned int destWidth, unsigned int destHeight, unsigned int bytesPerPixel) {
+        std::vector<AxisContribution> xContributions = calculateAxisContributions(srcWidth, destWidth);
+        std::vector<AxisContribution> yContributions = calculateAxisContributions(srcHeight, destHeight);
+
+        // Horizontal pass, only the rows used by the vertical pass are filtered. The sums are not normalized to keep full precision.
+        std::vector<unsigned int> rowSums(static_cast<std::size_t>(srcHeight) * destWidth * bytesPerPixel);
+        std::vector<bool> rowFiltered(srcHeight, false);
+        for (const AxisContribution& yContribution : yContributions) {
+            for (int y = yContribution.first; y <= yContribution.last; y++) {
+                if (rowFiltered[y]) {
+                    continue;
+                }
+                rowFiltered[y] = true;
+
+                const unsigned char* srcRow = src + static_cast<std::size_t>(y) * srcWidth * bytesPerPixel;
+                unsigned int* rowSum = &rowSums[static_cast<std::size_t>(y) * destWidth * bytesPerPixel];
+                for (const AxisContribution& xContribution : xContributions) {
+                    for (unsigned int c = 0; c < bytesPerPixel; c++) {
+                        rowSum[c] = 0;
+                    }
+                    for (int x = xContribution.first; x <= xContribution.last; x++) {
+                        unsigned int weight = xContribution.getWeight(x);
+                        const unsigned char* srcPixel = srcRow + x * bytesPerPixel;
+                        for (unsigned int c = 0; c < bytesPerPixel; c++) {
+                            rowSum[c] += srcPixel[c] * weight;
+                        }
+                    }
+                    rowSum += bytesPerPixel;
+                }
+            }
+        }
+
+        // Vertical pass
+        std::vector<unsigned long long> sums(bytesPerPixel);
+        for (const AxisContribution& yContribution : yContributions) {
+            for (unsigned int x2 = 0; x2 < destWidth; x2++) {
+                std::fill(sums.begin(), sums.end(), 0);
+                for (int y = yContribution.first; y <= yContribution.last; y++) {
+                    unsigned int weight = yContribution.getWeight(y);
+                    const unsigned int* rowSum = &rowSums[(static_cast<std::size_t>(y) * destWidth + x2) * bytesPerPixel];
+                    for (unsigned int c = 0; c < bytesPerPixel; c++) {
+                        sums[c] += static_cast<unsigned long long>(rowSum[c]) * weight;
+                    }
+                }
+
+                unsigned long long weightSum = static_cast<unsigned long long>(xContributions[x2].weightSum) * yContribution.weightSum;
+                for (unsigned int c = 0; c < bytesPerPixel; c++) {
+                    *dest++ = weightSum > 0 ? static_cast<unsigned char>(sums[c] / weightSum) : 0;
+                }
+            }
+        }
+    }
+
+    void BitmapKernels::Downsample2x(const unsigned char* src, unsigned int srcWidth, unsigned int srcHeight, unsigned char* dest, unsigned int bytesPerPixel) {
+        unsigned int destWidth = (srcWidth + 1) / 2;
+        unsigned int destHeight = (srcHeight + 1) / 2;
+        for (unsigned int y = 0; y < destHeight; y++) {
+            const unsigned char* srcRow0 = src + static_cast<std::size_t>(2 * y) * srcWidth * bytesPerPixel;
+            const unsigned char* srcRow1 = src + static_cast<std::size_t>(std::min(2 * y + 1, srcHeight - 1)) * srcWidth * bytesPerPixel;
+            unsigned char* destRow = dest + static_cast<std::size_t>(y) * destWidth * bytesPerPixel;
+
+            unsigned int x = 0;
+            if (bytesPerPixel == 4) {
+#if defined(CARTO_BITMAPKERNELS_NEON)
+                for (; 2 * (x + 8) <= srcWidth; x += 8) {
+                    uint8x16x4_t rgba0 = vld4q_u8(srcRow0 + x * 8);
+                    uint8x16x4_t rgba1 = vld4q_u8(srcRow1 + x * 8);
+                    uint8x8x4_t rgba;
+                    for (int c = 0; c < 4; c++) {
+                        uint16x8_t sum = vaddq_u16(vpaddlq_u8(rgba0.val[c]), vpaddlq_u8(rgba1.val[c]));
+                        rgba.val[c] = vrshrn_n_u16(sum, 2);
+                    }
+                    vst4_u8(destRow + x * 4, rgba);
+                }
+#elif defined(CARTO_BITMAPKERNELS_SSE2)
+                const __m128i zero = _mm_setzero_si128();
+                const __m128i two = _mm_set1_epi16(2);
+                for (; 2 * (x + 2) <= srcWidth; x += 2) {
+                    __m128i rgba0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcRow0 + x * 8));
+                    __m128i rgba1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcRow1 + x * 8));
+                    // Sum rows, then add neighbouring pixels stored in the lower and upper halves of each register
+                    __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(rgba0, zero), _mm_unpacklo_epi8(rgba1, zero));
+                    __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(rgba0, zero), _mm_unpackhi_epi8(rgba1, zero));
+                    lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+                    hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+                    __m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(lo, hi), two), 2);
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(destRow + x * 4), _mm_packus_epi16(sum, zero));
+                }
+#endif
+            }
+
+            for (; x < destWidth; x++) {
+                unsigned int x0 = 2 * x;
+                unsigned int x1 = std::min(2 * x + 1, srcWidth - 1);
+                for (unsigned int c = 0; c < bytesPerPixel; c++) {
+                    unsigned int sum = srcRow0[x0 * bytesPerPixel + c] + srcRow0[x1 * bytesPerPixel + c] + srcRow1[x0 * bytesPerPixel + c] + srcRow1[x1 * bytesPerPixel + c];
+                    destRow[x * bytesPerPixel + c] = static_cast<unsigned char>((sum + 2) >> 2);
+                }
+            }
+        }
+    }
+
+}
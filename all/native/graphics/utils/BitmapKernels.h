@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_BITMAPKERNELS_H_
+#define _CARTO_BITMAPKERNELS_H_
+
+#include "graphics/Bitmap.h"
+
+#include <cstddef>
+
+namespace carto {
+
+    /**
+     * Pixel processing kernels used by Bitmap. NEON or SSE2 implementations are used when the target supports them.
+     */
+    class BitmapKernels {
+    public:
+        /**
+         * Premultiplies the color channels by alpha, alpha must be the last channel of each pixel.
+         * @param pixels The pixel data to premultiply in place.
+         * @param pixelCount The number of pixels.
+         * @param bytesPerPixel The number of bytes per pixel, either 2 (grayscale and alpha) or 4 (RGBA).
+         */
+        static void PremultiplyAlpha(unsigned char* pixels, std::size_t pixelCount, unsigned int bytesPerPixel);
+
+        /**
+         * Converts pixels of the specified color format to RGBA.
+         * @param src The source pixel data.
+         * @param dest The destination RGBA pixel data, must contain space for pixelCount * 4 bytes.
+         * @param pixelCount The number of pixels.
+         * @param colorFormat The color format of the source pixels.
+         * @return True if the color format is supported, false otherwise.
+         */
+        static bool ConvertToRGBA(const unsigned char* src, unsigned char* dest, std::size_t pixelCount, ColorFormat::ColorFormat colorFormat);
+
+        /**
+         * Resamples the pixels using separable area-weighted filter (box filter when downsampling, linear filter when upsampling).
+         * @param src The source pixel data, rows are tightly packed.
+         * @param srcWidth The width of the source image.
+         * @param srcHeight The height of the source image.
+         * @param dest The destination pixel data, must contain space for destWidth * destHeight * bytesPerPixel bytes.
+         * @param destWidth The width of the destination image.
+         * @param destHeight The height of the destination image.
+         * @param bytesPerPixel The number of bytes per pixel.
+         */
+        static void Resample(const unsigned char* src, unsigned int srcWidth, unsigned int srcHeight, unsigned char* dest, unsigned int destWidth, unsigned int destHeight, unsigned int bytesPerPixel);
+
+        /**
+         * Downsamples the pixels by factor of 2 in both dimensions using 2x2 box filter.
+         * With odd dimensions the last source row or column is repeated.
+         * @param src The source pixel data, rows are tightly packed.
+         * @param srcWidth The width of the source image.
+         * @param srcHeight The height of the source image.
+         * @param dest The destination pixel data, must contain space for ((srcWidth + 1) / 2) * ((srcHeight + 1) / 2) * bytesPerPixel bytes.
+         * @param bytesPerPixel The number of bytes per pixel.
+         */
+        static void Downsample2x(const unsigned char* src, unsigned int srcWidth, unsigned int srcHeight, unsigned char* dest, unsigned int bytesPerPixel);
+
+    private:
+        BitmapKernels();
+    };
+
+}
+
+#endif
@@ -15,6 +15,31 @@ namespace carto {
     }
 
     std::shared_ptr<Bitmap> SkyBitmapGenerator::generateBitmap(const Color& backgroundColor, const Color& skyColor) const {
+        BitmapKey key(_width, _height, backgroundColor.getARGB(), skyColor.getARGB());
+
+        std::lock_guard<std::mutex> lock(_GeneratedBitmapsMutex);
+        auto it = _GeneratedBitmaps.find(key);
+        if (it != _GeneratedBitmaps.end()) {
+            if (std::shared_ptr<Bitmap> bitmap = it->second.lock()) {
+                return bitmap;
+            }
+        }
+
+        // Drop the entries of released bitmaps before adding the new one
+        for (auto it2 = _GeneratedBitmaps.begin(); it2 != _GeneratedBitmaps.end(); ) {
+            if (it2->second.expired()) {
+                it2 = _GeneratedBitmaps.erase(it2);
+            } else {
+                it2++;
+            }
+        }
+
+        std::shared_ptr<Bitmap> bitmap = createBitmap(backgroundColor, skyColor);
+        _GeneratedBitmaps[key] = bitmap;
+        return bitmap;
+    }
+
+    std::shared_ptr<Bitmap> SkyBitmapGenerator::createBitmap(const Color& backgroundColor, const Color& skyColor) const {
         std::vector<unsigned char> data(_width * _height * 4);
 
         unsigned char baseValue = std::min(128, 255 - std::max(backgroundColor.getR(), std::max(backgroundColor.getG(), backgroundColor.getB())));
@@ -47,4 +72,7 @@ namespace carto {
         return std::make_shared<Bitmap>(data.data(), _width, _height, ColorFormat::COLOR_FORMAT_RGBA, 4 * _width);
     }
 
+    std::map<SkyBitmapGenerator::BitmapKey, std::weak_ptr<Bitmap> > SkyBitmapGenerator::_GeneratedBitmaps;
+    std::mutex SkyBitmapGenerator::_GeneratedBitmapsMutex;
+
 }
@@ -10,10 +10,16 @@
 #include "graphics/Bitmap.h"
 #include "graphics/Color.h"
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
 namespace carto {
 
     /**
      * A generator for sky bitmaps.
+     * Generated bitmaps are shared while in use, so generating the bitmap again with the same parameters returns the existing instance.
      */
     class SkyBitmapGenerator {
     public:
@@ -23,6 +29,13 @@ namespace carto {
         std::shared_ptr<Bitmap> generateBitmap(const Color& groundColor, const Color& skyColor) const;
 
     private:
+        typedef std::tuple<int, int, int, int> BitmapKey;
+
+        std::shared_ptr<Bitmap> createBitmap(const Color& groundColor, const Color& skyColor) const;
+
+        static std::map<BitmapKey, std::weak_ptr<Bitmap> > _GeneratedBitmaps;
+        static std::mutex _GeneratedBitmapsMutex;
+
         const int _width;
         const int _height;
     };
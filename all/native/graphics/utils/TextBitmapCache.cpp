@@ -0,0 +1,64 @@
+#include "TextBitmapCache.h"
+#include "graphics/Bitmap.h"
+
+namespace carto {
+
+    TextBitmapCache& TextBitmapCache::GetInstance() {
+        static TextBitmapCache instance;
+        return instance;
+    }
+
+    TextBitmapCache::~TextBitmapCache() {
+        _memoryConsumer->detach();
+    }
+
+    std::size_t TextBitmapCache::getCapacity() const {
+        return _memoryConsumer->getCapacity();
+    }
+
+    void TextBitmapCache::setCapacity(std::size_t capacityInBytes) {
+        _memoryConsumer->setCapacity(capacityInBytes);
+    }
+
+    void TextBitmapCache::clear() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _cache.clear();
+    }
+
+    std::shared_ptr<Bitmap> TextBitmapCache::getBitmap(const std::string& key, const std::function<std::shared_ptr<Bitmap>()>& drawFunc) {
+        std::shared_ptr<Bitmap> bitmap;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_cache.read(key, bitmap)) {
+                return bitmap;
+            }
+        }
+
+        // Draw outside of the lock, concurrent misses for the same key simply replace each other
+        bitmap = drawFunc();
+        if (bitmap) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _cache.put(key, bitmap, bitmap->getPixelData().size() + key.size());
+        }
+        return bitmap;
+    }
+
+    TextBitmapCache::TextBitmapCache() :
+        _cache(DEFAULT_CAPACITY),
+        _memoryConsumer(),
+        _mutex()
+    {
+        _memoryConsumer = MemoryGovernor::GetInstance().registerConsumer(DEFAULT_CAPACITY, 1.0f,
+            [this](std::size_t budget) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _cache.resize(budget);
+            },
+            [this](bool critical) {
+                clear();
+            }
+        );
+    }
+
+    const std::size_t TextBitmapCache::DEFAULT_CAPACITY = 4 * 1024 * 1024;
+
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_TEXTBITMAPCACHE_H_
+#define _CARTO_TEXTBITMAPCACHE_H_
+
+#include "components/MemoryGovernor.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <stdext/timed_lru_cache.h>
+
+namespace carto {
+    class Bitmap;
+
+    /**
+     * Shared cache of rasterized text bitmaps. Text elements with identical text and rendering parameters
+     * share the same bitmap instance, so the text is rasterized only once and the renderers can share the texture.
+     */
+    class TextBitmapCache {
+    public:
+        static TextBitmapCache& GetInstance();
+
+        virtual ~TextBitmapCache();
+
+        std::size_t getCapacity() const;
+        void setCapacity(std::size_t capacityInBytes);
+
+        void clear();
+
+        // Returns the cached bitmap for the key or draws, caches and returns a new one
+        std::shared_ptr<Bitmap> getBitmap(const std::string& key, const std::function<std::shared_ptr<Bitmap>()>& drawFunc);
+
+    private:
+        TextBitmapCache();
+
+        static const std::size_t DEFAULT_CAPACITY;
+
+        cache::timed_lru_cache<std::string, std::shared_ptr<Bitmap> > _cache;
+        std::shared_ptr<MemoryGovernor::Consumer> _memoryConsumer;
+
+        mutable std::mutex _mutex;
+    };
+
+}
+
+#endif
@@ -11,7 +11,7 @@ namespace carto {
     CartoOnlineVectorTileLayer::CartoOnlineVectorTileLayer(CartoBaseMapStyle::CartoBaseMapStyle style) :
         CartoVectorTileLayer(CreateDataSource(style), style),
         _style(style),
-        _styleUpdateThreadPool(std::make_shared<CancelableThreadPool>())
+        _styleUpdateThreadPool(std::make_shared<CancelableThreadPool>(ThreadRole::BULK))
     {
         _styleUpdateThreadPool->setPoolSize(1);
     }
@@ -19,7 +19,7 @@ namespace carto {
     CartoOnlineVectorTileLayer::CartoOnlineVectorTileLayer(const std::string& source, CartoBaseMapStyle::CartoBaseMapStyle style) :
         CartoVectorTileLayer(std::make_shared<CartoOnlineTileDataSource>(source), style),
         _style(style),
-        _styleUpdateThreadPool(std::make_shared<CancelableThreadPool>())
+        _styleUpdateThreadPool(std::make_shared<CancelableThreadPool>(ThreadRole::BULK))
     {
         _styleUpdateThreadPool->setPoolSize(1);
     }
@@ -7,6 +7,11 @@
 #include "utils/AssetPackage.h"
 #include "utils/ZippedAssetPackage.h"
 #include "utils/Log.h"
+#include "utils/ThreadUtils.h"
+
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include <boost/lexical_cast.hpp>
 
@@ -100,9 +105,38 @@ namespace carto {
         return std::make_shared<MBVectorTileDecoder>(std::make_shared<CompiledStyleSet>(styleAssetPackage, styleName));
     }
 
+    void CartoVectorTileLayer::PreloadStyle(CartoBaseMapStyle::CartoBaseMapStyle style) {
+        // Keep the preloaded decoders, so the shared style package and its compiled maps stay cached
+        static std::mutex mutex;
+        static std::vector<std::shared_ptr<VectorTileDecoder> > preloadedDecoders;
+
+        std::thread preloadThread([style]() {
+            ThreadUtils::SetThreadRole(ThreadRole::INTERACTIVE);
+            try {
+                std::shared_ptr<VectorTileDecoder> decoder = CreateTileDecoder(style);
+                std::lock_guard<std::mutex> lock(mutex);
+                preloadedDecoders.push_back(decoder);
+            }
+            catch (const std::exception& ex) {
+                Log::Errorf("CartoVectorTileLayer::PreloadStyle: Failed to preload style: %s", ex.what());
+            }
+        });
+        preloadThread.detach();
+    }
+
     std::shared_ptr<AssetPackage> CartoVectorTileLayer::CreateStyleAssetPackage() {
-        auto styleAsset = std::make_shared<BinaryData>(cartostyles_v2_zip, cartostyles_v2_zip_len);
-        return std::make_shared<ZippedAssetPackage>(styleAsset);
+        // Share the package between layers while it is in use, so its index and asset cache are reused
+        static std::mutex mutex;
+        static std::weak_ptr<AssetPackage> sharedAssetPackage;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        std::shared_ptr<AssetPackage> assetPackage = sharedAssetPackage.lock();
+        if (!assetPackage) {
+            auto styleAsset = std::make_shared<BinaryData>(cartostyles_v2_zip, cartostyles_v2_zip_len, std::shared_ptr<const void>());
+            assetPackage = std::make_shared<ZippedAssetPackage>(styleAsset);
+            sharedAssetPackage = assetPackage;
+        }
+        return assetPackage;
     }
 
     std::string CartoVectorTileLayer::GetStyleName(CartoBaseMapStyle::CartoBaseMapStyle style) {
@@ -167,6 +167,16 @@ namespace carto {
          */
         static std::shared_ptr<VectorTileDecoder> CreateTileDecoder(const std::shared_ptr<AssetPackage>& styleAssetPackage, const std::string& styleName);
 
+        /**
+         * Starts loading and compiling the specified base map style in a background thread.
+         * Compiling the style is the most expensive part of creating the layer. If this method is called
+         * at application startup, the style is compiled in parallel with the rest of the initialization
+         * and creating the layer or the tile decoder later reuses the compiled style (or waits for the compilation in progress).
+         * The preloaded style is kept in memory until the application exits.
+         * @param style The style to preload.
+         */
+        static void PreloadStyle(CartoBaseMapStyle::CartoBaseMapStyle style);
+
         static std::shared_ptr<AssetPackage> CreateStyleAssetPackage();
 
         static std::string GetStyleName(CartoBaseMapStyle::CartoBaseMapStyle style);
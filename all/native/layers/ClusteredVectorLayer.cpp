@@ -18,13 +18,13 @@
 #include "utils/Const.h"
 #include "utils/Log.h"
 
+#include <algorithm>
+#include <cmath>
 #include <unordered_map>
 #include <vector>
-#include <list>
 #include <stack>
 #include <memory>
 #include <utility>
-#include <numeric>
 
 #include <cglib/vec.h>
 
@@ -44,6 +44,10 @@ namespace carto {
         _rootClusterIdx(-1),
         _renderClusterIdxs(),
         _refreshRootCluster(true),
+        _removedClusterCount(0),
+        _pendingElements(),
+        _pendingElementsTime(),
+        _pendingElementsScheduled(false),
         _clusterMutex()
     {
         if (!clusterElementBuilder) {
@@ -136,6 +140,24 @@ namespace carto {
         }
 
         bool refresh = renderClusters(viewState, deltaSeconds);
+
+        // Apply batched element changes once the batching window has passed, keep redrawing until then
+        bool updateClusters = false;
+        {
+            std::lock_guard<std::mutex> lock(_clusterMutex);
+            if (!_pendingElements.empty() && !_pendingElementsScheduled) {
+                if (std::chrono::steady_clock::now() >= _pendingElementsTime) {
+                    _pendingElementsScheduled = true;
+                    updateClusters = true;
+                } else {
+                    refresh = true;
+                }
+            }
+        }
+        if (updateClusters) {
+            VectorLayer::refresh();
+        }
+
         return VectorLayer::onDrawFrame(deltaSeconds, billboardSorter, viewState) || refresh;
     }
 
@@ -146,7 +168,41 @@ namespace carto {
                 syncRendererElement(element, _lastCullState->getViewState(), remove);
             }
         }
-        refresh();
+        {
+            std::lock_guard<std::mutex> lock(_clusterMutex);
+            if (_pendingElements.empty()) {
+                _pendingElementsTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(UPDATE_BATCH_DELAY);
+            }
+            _pendingElements[element] = remove;
+        }
+        redraw();
+    }
+
+    void ClusteredVectorLayer::refreshElements(const std::vector<std::shared_ptr<VectorElement> >& elements, const std::vector<std::shared_ptr<VectorElement> >& removedElements) {
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            if (_lastCullState) {
+                for (const std::shared_ptr<VectorElement>& element : removedElements) {
+                    syncRendererElement(element, _lastCullState->getViewState(), true);
+                }
+                for (const std::shared_ptr<VectorElement>& element : elements) {
+                    syncRendererElement(element, _lastCullState->getViewState(), false);
+                }
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(_clusterMutex);
+            if (_pendingElements.empty()) {
+                _pendingElementsTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(UPDATE_BATCH_DELAY);
+            }
+            for (const std::shared_ptr<VectorElement>& element : removedElements) {
+                _pendingElements[element] = true;
+            }
+            for (const std::shared_ptr<VectorElement>& element : elements) {
+                _pendingElements[element] = false;
+            }
+        }
+        redraw();
     }
 
     std::shared_ptr<CancelableTask> ClusteredVectorLayer::createFetchTask(const std::shared_ptr<CullState>& cullState) {
@@ -169,13 +225,21 @@ namespace carto {
             layer->_dpiScale = options->getDPI() / Const::UNSCALED_DPI;
         }
 
-        std::vector<std::shared_ptr<VectorElement> > vectorElements = std::static_pointer_cast<LocalVectorDataSource>(layer->_dataSource.get())->getAll();
         bool refresh = false;
+        std::unordered_map<std::shared_ptr<VectorElement>, bool> pendingElements;
         {
             std::lock_guard<std::mutex> lock(layer->_clusterMutex);
             std::swap(refresh, layer->_refreshRootCluster);
+            std::swap(pendingElements, layer->_pendingElements);
+            layer->_pendingElementsScheduled = false;
+        }
+
+        // Apply individual element changes incrementally, if possible. Otherwise rebuild the whole cluster hierarchy
+        if (!refresh && !pendingElements.empty()) {
+            refresh = !layer->updateClusters(pendingElements);
         }
         if (refresh) {
+            std::vector<std::shared_ptr<VectorElement> > vectorElements = std::static_pointer_cast<LocalVectorDataSource>(layer->_dataSource.get())->getAll();
             layer->rebuildClusters(vectorElements);
         }
         return false;
@@ -231,7 +295,7 @@ namespace carto {
             }
 
             // Rebuild clusters, by doing bottom-up merging into a single cluster
-            rootClusterIdx = mergeClusters(clusterIdxs.begin(), clusterIdxs.end(), *clusters, *projectionSurface, 1).front();
+            rootClusterIdx = buildClusterHierarchy(clusterIdxs, *clusters, *projectionSurface);
         }
 
         // Synchronize cluster data
@@ -240,9 +304,143 @@ namespace carto {
         std::swap(projectionSurface, _projectionSurface);
         std::swap(singletonClusterCount, _singletonClusterCount);
         std::swap(rootClusterIdx, _rootClusterIdx);
+        _removedClusterCount = 0;
         _renderClusterIdxs.clear();
     }
 
+    bool ClusteredVectorLayer::updateClusters(const std::unordered_map<std::shared_ptr<VectorElement>, bool>& pendingElements) {
+        if (pendingElements.size() > MAX_INCREMENTAL_UPDATES) {
+            return false;
+        }
+
+        std::shared_ptr<ProjectionSurface> projectionSurface;
+        if (auto mapRenderer = getMapRenderer()) {
+            projectionSurface = mapRenderer->getProjectionSurface();
+        }
+
+        std::lock_guard<std::mutex> lock(_clusterMutex);
+        if (!projectionSurface || projectionSurface != _projectionSurface) {
+            return false;
+        }
+        std::vector<Cluster>& clusters = *_clusters;
+        if (_removedClusterCount > static_cast<int>(clusters.size() / 2)) {
+            return false;
+        }
+
+        for (auto it = pendingElements.begin(); it != pendingElements.end(); it++) {
+            // Detach the old singleton cluster of the element, then insert the element as a new singleton cluster
+            for (std::size_t i = 0; i < clusters.size(); i++) {
+                if (clusters[i].vectorElement == it->first) {
+                    removeCluster(static_cast<int>(i), clusters, *projectionSurface);
+                    break;
+                }
+            }
+            if (!it->second) {
+                int clusterIdx = createSingletonCluster(it->first, clusters, *projectionSurface);
+                if (clusterIdx != -1) {
+                    insertCluster(clusterIdx, clusters, *projectionSurface);
+                }
+            }
+        }
+
+        // Singleton clusters are no longer stored first, thus next rebuild can not be skipped
+        _singletonClusterCount = -1;
+        _renderClusterIdxs.erase(std::remove_if(_renderClusterIdxs.begin(), _renderClusterIdxs.end(), [&clusters](int clusterIdx) {
+            return clusters[clusterIdx].elementCount == 0;
+        }), _renderClusterIdxs.end());
+        return true;
+    }
+
+    void ClusteredVectorLayer::insertCluster(int clusterIdx, std::vector<Cluster>& clusters, const ProjectionSurface& projectionSurface) {
+        if (_rootClusterIdx == -1) {
+            _rootClusterIdx = clusterIdx;
+            return;
+        }
+
+        // Descend towards the closest child until the new cluster is outside of the spread of the current cluster
+        MapPos pos = clusters[clusterIdx].staticPos;
+        int nodeIdx = _rootClusterIdx;
+        while (clusters[nodeIdx].elementCount > 1) {
+            const Cluster& node = clusters[nodeIdx];
+            if (calculateClusterDistance(node.staticPos, pos, projectionSurface) > node.maxDistance) {
+                break;
+            }
+            double dist1 = calculateClusterDistance(clusters[node.childClusterIdx[0]].staticPos, pos, projectionSurface);
+            double dist2 = calculateClusterDistance(clusters[node.childClusterIdx[1]].staticPos, pos, projectionSurface);
+            nodeIdx = node.childClusterIdx[dist1 <= dist2 ? 0 : 1];
+        }
+
+        // Replace the found cluster with the merged cluster
+        int parentClusterIdx = clusters[nodeIdx].parentClusterIdx;
+        int childIndex = (parentClusterIdx != -1 && clusters[parentClusterIdx].childClusterIdx[1] == nodeIdx ? 1 : 0);
+        int mergedClusterIdx = createMergedCluster(nodeIdx, clusterIdx, clusters, projectionSurface);
+        clusters[mergedClusterIdx].parentClusterIdx = parentClusterIdx;
+        if (parentClusterIdx == -1) {
+            _rootClusterIdx = mergedClusterIdx;
+        } else {
+            clusters[parentClusterIdx].childClusterIdx[childIndex] = mergedClusterIdx;
+        }
+        updateClusterAncestors(parentClusterIdx, clusters, projectionSurface);
+    }
+
+    void ClusteredVectorLayer::removeCluster(int clusterIdx, std::vector<Cluster>& clusters, const ProjectionSurface& projectionSurface) {
+        int parentClusterIdx = clusters[clusterIdx].parentClusterIdx;
+        Cluster& cluster = clusters[clusterIdx];
+        cluster.elementCount = 0;
+        cluster.parentClusterIdx = -1;
+        cluster.vectorElement.reset();
+        cluster.clusterElement.reset();
+        _removedClusterCount++;
+        if (parentClusterIdx == -1) {
+            if (_rootClusterIdx == clusterIdx) {
+                _rootClusterIdx = -1;
+            }
+            return;
+        }
+
+        // Replace the parent cluster with the sibling cluster
+        Cluster& parentCluster = clusters[parentClusterIdx];
+        int siblingClusterIdx = parentCluster.childClusterIdx[parentCluster.childClusterIdx[0] == clusterIdx ? 1 : 0];
+        int grandParentClusterIdx = parentCluster.parentClusterIdx;
+        parentCluster.elementCount = 0;
+        parentCluster.parentClusterIdx = -1;
+        parentCluster.childClusterIdx[0] = parentCluster.childClusterIdx[1] = -1;
+        parentCluster.clusterElement.reset();
+        _removedClusterCount++;
+
+        clusters[siblingClusterIdx].parentClusterIdx = grandParentClusterIdx;
+        if (grandParentClusterIdx == -1) {
+            _rootClusterIdx = siblingClusterIdx;
+        } else {
+            Cluster& grandParentCluster = clusters[grandParentClusterIdx];
+            grandParentCluster.childClusterIdx[grandParentCluster.childClusterIdx[0] == parentClusterIdx ? 0 : 1] = siblingClusterIdx;
+        }
+        updateClusterAncestors(grandParentClusterIdx, clusters, projectionSurface);
+    }
+
+    void ClusteredVectorLayer::updateClusterAncestors(int clusterIdx, std::vector<Cluster>& clusters, const ProjectionSurface& projectionSurface) const {
+        while (clusterIdx != -1) {
+            Cluster& cluster = clusters[clusterIdx];
+            const Cluster& childCluster1 = clusters[cluster.childClusterIdx[0]];
+            const Cluster& childCluster2 = clusters[cluster.childClusterIdx[1]];
+            int n1 = childCluster1.elementCount;
+            int n2 = childCluster2.elementCount;
+            cluster.maxDistance = calculateClusterDistance(childCluster1.staticPos, childCluster2.staticPos, projectionSurface);
+            cluster.staticPos = MapPos((childCluster1.staticPos.getX() * n1 + childCluster2.staticPos.getX() * n2) / (n1 + n2), (childCluster1.staticPos.getY() * n1 + childCluster2.staticPos.getY() * n2) / (n1 + n2));
+            cluster.bounds = childCluster1.bounds;
+            cluster.bounds.add(childCluster2.bounds);
+            cluster.elementCount = n1 + n2;
+            cluster.clusterElement.reset(); // element count or position has changed
+            clusterIdx = cluster.parentClusterIdx;
+        }
+    }
+
+    double ClusteredVectorLayer::calculateClusterDistance(const MapPos& pos1, const MapPos& pos2, const ProjectionSurface& projectionSurface) const {
+        MapPos internalPos1 = _dataSource->getProjection()->toInternal(pos1);
+        MapPos internalPos2 = _dataSource->getProjection()->toInternal(pos2);
+        return projectionSurface.calculateDistance(projectionSurface.calculatePosition(internalPos1), projectionSurface.calculatePosition(internalPos2));
+    }
+
     int ClusteredVectorLayer::createSingletonCluster(const std::shared_ptr<VectorElement>& element, std::vector<Cluster>& clusters, const ProjectionSurface& projectionSurface) const {
         MapPos mapPos;
         if (!element->isVisible() || !GetVectorElementPos(element, mapPos)) {
@@ -270,9 +468,7 @@ namespace carto {
         int n2 = clusters[clusterIdx2].elementCount;
         const MapPos& clusterPos1 = clusters[clusterIdx1].staticPos;
         const MapPos& clusterPos2 = clusters[clusterIdx2].staticPos;
-        MapPos internalPos1 = _dataSource->getProjection()->toInternal(clusterPos1);
-        MapPos internalPos2 = _dataSource->getProjection()->toInternal(clusterPos2);
-        double dist = projectionSurface.calculateDistance(projectionSurface.calculatePosition(internalPos1), projectionSurface.calculatePosition(internalPos2));
+        double dist = calculateClusterDistance(clusterPos1, clusterPos2, projectionSurface);
         MapPos mapPos((clusterPos1.getX() * n1 + clusterPos2.getX() * n2) / (n1 + n2), (clusterPos1.getY() * n1 + clusterPos2.getY() * n2) / (n1 + n2));
 
         int clusterIdx = static_cast<int>(clusters.size());
@@ -292,154 +488,82 @@ namespace carto {
         return clusterIdx;
     }
 
-    std::vector<int> ClusteredVectorLayer::mergeClusters(std::vector<int>::iterator clustersBegin, std::vector<int>::iterator clustersEnd, std::vector<Cluster>& clusters, const ProjectionSurface& projectionSurface, std::size_t maxClusters) const {
-        struct ClusterInfo {
-            int clusterIdx;
-            double closestClusterDistance;
-            std::list<ClusterInfo>::iterator closestClusterInfoIt;
-        };
-        
-        std::size_t initialClusters = clustersEnd - clustersBegin;
-
-        // Find axis of bigger variance, use this axis for sorting
-        double meanFactor = 1.0 / initialClusters;
-        cglib::vec2<double> mean = std::accumulate(clustersBegin, clustersEnd, cglib::vec2<double>::zero(), [meanFactor, &clusters](const cglib::vec2<double>& result, int clusterIdx) {
-            const MapPos& pos = clusters[clusterIdx].staticPos;
-            return result + cglib::vec2<double>(pos.getX(), pos.getY()) * meanFactor;
-        });
-        cglib::vec2<double> variance = std::accumulate(clustersBegin, clustersEnd, cglib::vec2<double>::zero(), [mean, &clusters](const cglib::vec2<double>& result, int clusterIdx) {
-            const MapPos& pos = clusters[clusterIdx].staticPos;
-            cglib::vec2<double> delta = cglib::vec2<double>(pos.getX(), pos.getY()) - mean;
-            return result + cglib::vec2<double>(delta(0) * delta(0), delta(1) * delta(1));
-        });
-
-        int axis = (variance(0) > variance(1) ? 0 : 1);
-        auto clusterComparator = [axis, &clusters](int clusterIdx1, int clusterIdx2) {
-            return clusters[clusterIdx1].staticPos[axis] < clusters[clusterIdx2].staticPos[axis];
-        };
-
-        // Use hierarchical clustering, if size above threshold
-        std::list<ClusterInfo> clusterInfos;
-        if (initialClusters > 2 * HIERARCHICAL_MODE_THRESHOLD) {
-            std::vector<int> childClusterIdxs1;
-            childClusterIdxs1.reserve(initialClusters);
-            std::vector<int> childClusterIdxs2;
-            childClusterIdxs2.reserve(initialClusters);
-            for (auto it = clustersBegin; it != clustersEnd; it++) {
-                const Cluster& cluster = clusters[*it];
-                if (cluster.staticPos[axis] < mean(axis)) {
-                    childClusterIdxs1.push_back(*it);
-                } else {
-                    childClusterIdxs2.push_back(*it);
-                }
-            }
-            if (!childClusterIdxs1.empty() && !childClusterIdxs2.empty()) {
-                childClusterIdxs1 = mergeClusters(childClusterIdxs1.begin(), childClusterIdxs1.end(), clusters, projectionSurface, HIERARCHICAL_MODE_THRESHOLD);
-                childClusterIdxs2 = mergeClusters(childClusterIdxs2.begin(), childClusterIdxs2.end(), clusters, projectionSurface, HIERARCHICAL_MODE_THRESHOLD);
-                std::sort(childClusterIdxs1.begin(), childClusterIdxs1.end(), clusterComparator);
-                std::sort(childClusterIdxs2.begin(), childClusterIdxs2.end(), clusterComparator);
-                for (int clusterIdx : childClusterIdxs1) {
-                    ClusterInfo clusterInfo;
-                    clusterInfo.clusterIdx = clusterIdx;
-                    clusterInfos.push_back(clusterInfo);
-                }
-                for (int clusterIdx : childClusterIdxs2) {
-                    ClusterInfo clusterInfo;
-                    clusterInfo.clusterIdx = clusterIdx;
-                    clusterInfos.push_back(clusterInfo);
-                }
-            }
-        }
-        
-        // If hierarchical clustering was not needed/did not succeed, use normal sorting/create full clustering
-        if (clusterInfos.empty()) {
-            std::sort(clustersBegin, clustersEnd, clusterComparator);
-            for (auto it = clustersBegin; it != clustersEnd; it++) {
-                ClusterInfo clusterInfo;
-                clusterInfo.clusterIdx = *it;
-                clusterInfos.push_back(clusterInfo);
-            }
+    int ClusteredVectorLayer::buildClusterHierarchy(const std::vector<int>& singletonClusterIdxs, std::vector<Cluster>& clusters, const ProjectionSurface& projectionSurface) const {
+        if (singletonClusterIdxs.empty()) {
+            return -1;
         }
 
-        // Find closest clusters. n*sqrt(n) steps avg, n^2 worst
-        for (auto it = clusterInfos.begin(); it != clusterInfos.end(); it++) {
-            it->closestClusterDistance = std::numeric_limits<double>::infinity();
-            it->closestClusterInfoIt = clusterInfos.end();
-            for (auto testIt = it; ++testIt != clusterInfos.end(); ) {
-                if (clusters[testIt->clusterIdx].staticPos[axis] - clusters[it->clusterIdx].staticPos[axis] >= it->closestClusterDistance) {
-                    break;
-                }
-                double distanceSqr = MapVec(clusters[testIt->clusterIdx].staticPos - clusters[it->clusterIdx].staticPos).lengthSqr();
-                if (distanceSqr < it->closestClusterDistance * it->closestClusterDistance) {
-                    it->closestClusterDistance = std::sqrt(distanceSqr);
-                    it->closestClusterInfoIt = testIt;
-                }
+        // Start from a small fraction of the total extent, the merging distance is doubled at each level
+        MapPos minPos = clusters[singletonClusterIdxs.front()].staticPos;
+        MapPos maxPos = minPos;
+        for (int clusterIdx : singletonClusterIdxs) {
+            const MapPos& pos = clusters[clusterIdx].staticPos;
+            minPos = MapPos(std::min(minPos.getX(), pos.getX()), std::min(minPos.getY(), pos.getY()));
+            maxPos = MapPos(std::max(maxPos.getX(), pos.getX()), std::max(maxPos.getY(), pos.getY()));
+        }
+        double extent = std::max(maxPos.getX() - minPos.getX(), maxPos.getY() - minPos.getY());
+        double distance = (extent > 0 ? extent / (1 << CLUSTER_LEVEL_COUNT) : 1);
+
+        std::vector<int> clusterIdxs(singletonClusterIdxs);
+        std::vector<int> nextClusterIdxs;
+        std::vector<MapPos> clusterPoses;
+        std::vector<bool> merged;
+        std::vector<std::pair<double, std::size_t> > neighbours;
+        std::unordered_map<long long, std::vector<std::size_t> > grid;
+        while (clusterIdxs.size() > 1) {
+            // Bucket the clusters of this level into a grid with the cell size equal to the merging distance
+            grid.clear();
+            clusterPoses.clear();
+            for (std::size_t i = 0; i < clusterIdxs.size(); i++) {
+                const MapPos& pos = clusters[clusterIdxs[i]].staticPos;
+                clusterPoses.push_back(pos);
+                grid[GetGridCellKey(static_cast<long long>(std::floor(pos.getX() / distance)), static_cast<long long>(std::floor(pos.getY() / distance)))].push_back(i);
             }
-        }
 
-        // Merge clusters one-by-one (n steps)
-        while (clusterInfos.size() > maxClusters) {
-            // Find closest pair. n steps
-            std::list<ClusterInfo>::iterator it1 = clusterInfos.begin();
-            for (auto it = clusterInfos.begin(); ++it != clusterInfos.end(); ) {
-                if (it->closestClusterDistance < it1->closestClusterDistance) {
-                    it1 = it;
-                }
-            }
-            std::list<ClusterInfo>::iterator it2 = it1->closestClusterInfoIt;
-
-            // Merge cluster pair
-            ClusterInfo mergedClusterInfo;
-            mergedClusterInfo.clusterIdx = createMergedCluster(it1->clusterIdx, it2->clusterIdx, clusters, projectionSurface);
-            mergedClusterInfo.closestClusterDistance = std::numeric_limits<double>::infinity();
-            mergedClusterInfo.closestClusterInfoIt = it2; // to force recalculation
-
-            // Insert cluster to sorted cluster info list. 1 steps avg, n steps worst
-            std::list<ClusterInfo>::iterator lastIt = clusterInfos.erase(it2);
-            std::list<ClusterInfo>::iterator firstIt = clusterInfos.erase(it1);
-            std::list<ClusterInfo>::iterator mergeIt;
-            for (mergeIt = firstIt; mergeIt != lastIt; mergeIt++) {
-                if (clusters[mergedClusterInfo.clusterIdx].staticPos[axis] > clusters[mergeIt->clusterIdx].staticPos[axis]) {
-                    break;
+            // Greedily merge each cluster with all unmerged neighbours within the merging distance, closest first
+            merged.assign(clusterIdxs.size(), false);
+            nextClusterIdxs.clear();
+            for (std::size_t i = 0; i < clusterIdxs.size(); i++) {
+                if (merged[i]) {
+                    continue;
                 }
-            }
-            mergeIt = clusterInfos.insert(mergeIt, mergedClusterInfo);
-
-            // For all clusters, if closest cluster is one of the merged clusters, recalculate closest cluster. n/2 steps avg
-            for (auto it = clusterInfos.begin(); it != lastIt; it++) {
-                if (it->closestClusterInfoIt == it1 || it->closestClusterInfoIt == it2) {
-                    it->closestClusterDistance = std::numeric_limits<double>::infinity();
-                    it->closestClusterInfoIt = clusterInfos.end();
-                    for (auto testIt = it; ++testIt != clusterInfos.end(); ) {
-                        if (clusters[testIt->clusterIdx].staticPos[axis] - clusters[it->clusterIdx].staticPos[axis] >= it->closestClusterDistance) {
-                            break;
+                merged[i] = true;
+
+                const MapPos& pos = clusterPoses[i];
+                long long cellX = static_cast<long long>(std::floor(pos.getX() / distance));
+                long long cellY = static_cast<long long>(std::floor(pos.getY() / distance));
+                neighbours.clear();
+                for (long long y = cellY - 1; y <= cellY + 1; y++) {
+                    for (long long x = cellX - 1; x <= cellX + 1; x++) {
+                        auto it = grid.find(GetGridCellKey(x, y));
+                        if (it == grid.end()) {
+                            continue;
                         }
-                        double distanceSqr = MapVec(clusters[testIt->clusterIdx].staticPos - clusters[it->clusterIdx].staticPos).lengthSqr();
-                        if (distanceSqr < it->closestClusterDistance * it->closestClusterDistance) {
-                            it->closestClusterDistance = std::sqrt(distanceSqr);
-                            it->closestClusterInfoIt = testIt;
+                        for (std::size_t j : it->second) {
+                            if (merged[j]) {
+                                continue;
+                            }
+                            double dist = MapVec(clusterPoses[j] - pos).length();
+                            if (dist <= distance) {
+                                neighbours.emplace_back(dist, j);
+                            }
                         }
                     }
                 }
-            }
+                std::sort(neighbours.begin(), neighbours.end());
 
-            // Update clusters, check if merged cluster is closer than previously closest cluster. n/2 steps avg
-            for (auto it = clusterInfos.begin(); it != mergeIt; it++) {
-                double distanceSqr = MapVec(clusters[mergeIt->clusterIdx].staticPos - clusters[it->clusterIdx].staticPos).lengthSqr();
-                if (distanceSqr < it->closestClusterDistance * it->closestClusterDistance) {
-                    it->closestClusterDistance = std::sqrt(distanceSqr);
-                    it->closestClusterInfoIt = mergeIt;
+                int clusterIdx = clusterIdxs[i];
+                for (const std::pair<double, std::size_t>& neighbour : neighbours) {
+                    merged[neighbour.second] = true;
+                    clusterIdx = createMergedCluster(clusterIdx, clusterIdxs[neighbour.second], clusters, projectionSurface);
                 }
+                nextClusterIdxs.push_back(clusterIdx);
             }
-        }
 
-        // Return the remaining clusters
-        std::vector<int> clusterIdxs;
-        clusterIdxs.reserve(maxClusters);
-        for (const ClusterInfo& clusterInfo : clusterInfos) {
-            clusterIdxs.push_back(clusterInfo.clusterIdx);
+            std::swap(clusterIdxs, nextClusterIdxs);
+            distance *= 2;
         }
-        return clusterIdxs;
+        return clusterIdxs.front();
     }
 
     bool ClusteredVectorLayer::renderClusters(const ViewState& viewState, float deltaSeconds) {
@@ -642,6 +766,10 @@ namespace carto {
         return _dataSource->getProjection()->fromInternal(internalPos + MapVec(std::cos(angle), std::sin(angle)) * dist);
     }
 
+    long long ClusteredVectorLayer::GetGridCellKey(long long x, long long y) {
+        return (x << 32) ^ (y & 0xFFFFFFFFLL);
+    }
+
     void ClusteredVectorLayer::StoreVectorElements(int clusterIdx, const std::vector<Cluster>& clusters, std::vector<std::shared_ptr<VectorElement> >& elements) {
         if (clusterIdx == -1) {
             return;
@@ -678,6 +806,10 @@ namespace carto {
         return false;
     }
 
-    const unsigned int ClusteredVectorLayer::HIERARCHICAL_MODE_THRESHOLD = 100;
+    const int ClusteredVectorLayer::CLUSTER_LEVEL_COUNT = 20;
+
+    const unsigned int ClusteredVectorLayer::MAX_INCREMENTAL_UPDATES = 256;
+
+    const int ClusteredVectorLayer::UPDATE_BATCH_DELAY = 250;
 
 }
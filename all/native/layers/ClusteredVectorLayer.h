@@ -13,6 +13,7 @@
 #include "layers/VectorLayer.h"
 #include "layers/ClusterElementBuilder.h"
 
+#include <chrono>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -30,7 +31,8 @@ namespace carto {
 
     /**
      * A vector layer that supports clustering point-type features.
-     * A Pairwise centroid hierarchical clustering algorithm is used internally.
+     * A centroid hierarchical clustering is used internally. The hierarchy is built bottom-up in levels,
+     * at each level nearby clusters are merged using a grid with doubling cell size.
      */
     class ClusteredVectorLayer : public VectorLayer {
     public:
@@ -126,7 +128,9 @@ namespace carto {
             virtual bool loadElements(const std::shared_ptr<CullState>& cullState);
         };
 
-        static const unsigned int HIERARCHICAL_MODE_THRESHOLD;
+        static const int CLUSTER_LEVEL_COUNT;
+        static const unsigned int MAX_INCREMENTAL_UPDATES;
+        static const int UPDATE_BATCH_DELAY;
 
         const DirectorPtr<ClusterElementBuilder> _clusterElementBuilder;
         ClusterBuilderMode::ClusterBuilderMode _clusterBuilderMode;
@@ -141,18 +145,28 @@ namespace carto {
         int _rootClusterIdx;
         std::vector<int> _renderClusterIdxs;
         bool _refreshRootCluster;
-        mutable std::mutex _clusterMutex; // for _minClusterDistance, _maxClusterZoom, _dpiScale, _rootClusterIdx, _refreshRootCluster, _renderClusters, _renderClusterIdxs
+        int _removedClusterCount; // clusters left unused by incremental updates
+        std::unordered_map<std::shared_ptr<VectorElement>, bool> _pendingElements; // element -> removed flag
+        std::chrono::steady_clock::time_point _pendingElementsTime; // time when the pending elements should be applied
+        bool _pendingElementsScheduled;
+        mutable std::mutex _clusterMutex; // for _minClusterDistance, _maxClusterZoom, _dpiScale, _rootClusterIdx, _refreshRootCluster, _renderClusters, _renderClusterIdxs, _pendingElements
 
         virtual bool onDrawFrame(float deltaSeconds, BillboardSorter& billboardSorter, const ViewState& viewState);
 
         virtual void refreshElement(const std::shared_ptr<VectorElement>& element, bool remove);
+        virtual void refreshElements(const std::vector<std::shared_ptr<VectorElement> >& elements, const std::vector<std::shared_ptr<VectorElement> >& removedElements);
 
         virtual std::shared_ptr<CancelableTask> createFetchTask(const std::shared_ptr<CullState>& cullState);
 
         void rebuildClusters(const std::vector<std::shared_ptr<VectorElement> >& vectorElements);
         int createSingletonCluster(const std::shared_ptr<VectorElement>& element, std::vector<Cluster>& clusters, const ProjectionSurface& projectionSurface) const;
         int createMergedCluster(int clusterIdx1, int clusterIdx2, std::vector<Cluster>& clusters, const ProjectionSurface& projectionSurface) const;
-        std::vector<int> mergeClusters(std::vector<int>::iterator clustersBegin, std::vector<int>::iterator clustersEnd, std::vector<Cluster>& clusters, const ProjectionSurface& projectionSurface, std::size_t maxClusters) const;
+        bool updateClusters(const std::unordered_map<std::shared_ptr<VectorElement>, bool>& pendingElements);
+        void insertCluster(int clusterIdx, std::vector<Cluster>& clusters, const ProjectionSurface& projectionSurface);
+        void removeCluster(int clusterIdx, std::vector<Cluster>& clusters, const ProjectionSurface& projectionSurface);
+        void updateClusterAncestors(int clusterIdx, std::vector<Cluster>& clusters, const ProjectionSurface& projectionSurface) const;
+        double calculateClusterDistance(const MapPos& pos1, const MapPos& pos2, const ProjectionSurface& projectionSurface) const;
+        int buildClusterHierarchy(const std::vector<int>& singletonClusterIdxs, std::vector<Cluster>& clusters, const ProjectionSurface& projectionSurface) const;
 
         bool renderClusters(const ViewState& viewState, float deltaSeconds);
         bool renderCluster(int clusterIdx, const ViewState& viewState, RenderState& renderState, float deltaSeconds);
@@ -160,6 +174,7 @@ namespace carto {
         bool moveCluster(int clusterIdx, const MapPos& targetPos, const RenderState& renderState, float deltaSeconds);
         MapPos createExpandedElementPos(RenderState& renderState) const;
 
+        static long long GetGridCellKey(long long x, long long y);
         static void StoreVectorElements(int clusterIdx, const std::vector<Cluster>& clusters, std::vector<std::shared_ptr<VectorElement> >& elements);
         static bool GetVectorElementPos(const std::shared_ptr<VectorElement>& vectorElement, MapPos& pos);
         static bool SetVectorElementPos(const std::shared_ptr<VectorElement>& vectorElement, const MapPos& pos);
@@ -0,0 +1,370 @@
+#include "DebugOverlayLayer.h"
+#include "components/CancelableThreadPool.h"
+#include "components/Layers.h"
+#include "core/CacheStatistics.h"
+#include "graphics/Bitmap.h"
+#include "graphics/BitmapCanvas.h"
+#include "graphics/ViewState.h"
+#include "layers/RasterTileLayer.h"
+#include "layers/VectorTileLayer.h"
+#include "projections/Projection.h"
+#include "projections/ProjectionSurface.h"
+#include "renderers/DebugOverlayRenderer.h"
+#include "renderers/MapRenderer.h"
+#include "utils/Const.h"
+#include "utils/Log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+
+namespace carto {
+
+    DebugOverlayLayer::DebugOverlayLayer() :
+        Layer(),
+        _tileBoundariesVisible(true),
+        _statisticsVisible(true),
+        _lastTileDebugInfos(),
+        _frameTimes(),
+        _lastStatisticsUpdateTime(),
+        _debugOverlayRenderer(std::make_shared<DebugOverlayRenderer>())
+    {
+        setCullDelay(TILE_UPDATE_DELAY);
+    }
+
+    DebugOverlayLayer::~DebugOverlayLayer() {
+    }
+
+    bool DebugOverlayLayer::isTileBoundariesVisible() const {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return _tileBoundariesVisible;
+    }
+
+    void DebugOverlayLayer::setTileBoundariesVisible(bool visible) {
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            _tileBoundariesVisible = visible;
+        }
+        refresh();
+    }
+
+    bool DebugOverlayLayer::isStatisticsVisible() const {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return _statisticsVisible;
+    }
+
+    void DebugOverlayLayer::setStatisticsVisible(bool visible) {
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            _statisticsVisible = visible;
+        }
+        redraw();
+    }
+
+    bool DebugOverlayLayer::isUpdateInProgress() const {
+        return false;
+    }
+
+    void DebugOverlayLayer::setComponents(const std::shared_ptr<CancelableThreadPool>& envelopeThreadPool,
+                                          const std::shared_ptr<CancelableThreadPool>& tileThreadPool,
+                                          const std::weak_ptr<Options>& options,
+                                          const std::weak_ptr<MapRenderer>& mapRenderer,
+                                          const std::weak_ptr<TouchHandler>& touchHandler)
+    {
+        Layer::setComponents(envelopeThreadPool, tileThreadPool, options, mapRenderer, touchHandler);
+        _debugOverlayRenderer->setComponents(options, mapRenderer);
+
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _lastTileDebugInfos.clear();
+    }
+    
+    void DebugOverlayLayer::loadData(const std::shared_ptr<CullState>& cullState) {
+        std::shared_ptr<MapRenderer> mapRenderer = getMapRenderer();
+        std::shared_ptr<ProjectionSurface> projectionSurface = cullState->getViewState().getProjectionSurface();
+        if (!mapRenderer || !projectionSurface) {
+            return;
+        }
+
+        std::vector<std::shared_ptr<TileLayer> > tileLayers;
+        std::vector<std::vector<TileLayer::TileDebugInfo> > tileDebugInfos;
+        if (isVisible() && isTileBoundariesVisible()) {
+            for (const std::shared_ptr<Layer>& layer : mapRenderer->getLayers()->getAll()) {
+                if (auto tileLayer = std::dynamic_pointer_cast<TileLayer>(layer)) {
+                    if (tileLayer->isVisible()) {
+                        tileLayers.push_back(tileLayer);
+                        tileDebugInfos.push_back(tileLayer->getTileDebugInfos());
+                    }
+                }
+            }
+        }
+
+        // The layer is updated after each frame, rebuild the boundaries only if the tile states have changed
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            auto equalInfos = [](const TileLayer::TileDebugInfo& info1, const TileLayer::TileDebugInfo& info2) {
+                return info1.tile == info2.tile && info1.state == info2.state && info1.loadTime == info2.loadTime;
+            };
+            bool changed = tileDebugInfos.size() != _lastTileDebugInfos.size();
+            for (std::size_t i = 0; i < tileDebugInfos.size() && !changed; i++) {
+                changed = tileDebugInfos[i].size() != _lastTileDebugInfos[i].size() || !std::equal(tileDebugInfos[i].begin(), tileDebugInfos[i].end(), _lastTileDebugInfos[i].begin(), equalInfos);
+            }
+            if (!changed) {
+                return;
+            }
+            _lastTileDebugInfos = tileDebugInfos;
+        }
+
+        std::vector<DebugOverlayRenderer::TileBoundary> tileBoundaries;
+        for (std::size_t i = 0; i < tileLayers.size(); i++) {
+            std::shared_ptr<Projection> projection = tileLayers[i]->getDataSource()->getProjection();
+            for (const TileLayer::TileDebugInfo& tileDebugInfo : tileDebugInfos[i]) {
+                // Visible tiles use flipped y coordinates and may be outside of the world bounds when panning seamlessly
+                const MapTile& tile = tileDebugInfo.tile;
+                int tileCount = 1 << tile.getZoom();
+                int tileMask = tileCount - 1;
+                MapTile flippedTile(tile.getX() & tileMask, tileMask - (tile.getY() & tileMask), tile.getZoom(), 0);
+                MapBounds tileBounds = tileLayers[i]->calculateMapTileBounds(flippedTile);
+                double offsetX = std::floor(static_cast<double>(tile.getX()) / tileCount) * Const::WORLD_SIZE;
+
+                MapPos corners[4] = {
+                    MapPos(tileBounds.getMin().getX(), tileBounds.getMin().getY()),
+                    MapPos(tileBounds.getMax().getX(), tileBounds.getMin().getY()),
+                    MapPos(tileBounds.getMax().getX(), tileBounds.getMax().getY()),
+                    MapPos(tileBounds.getMin().getX(), tileBounds.getMax().getY())
+                };
+
+                // Subdivide the edges, so that the boundaries follow the curved projection surfaces
+                DebugOverlayRenderer::TileBoundary tileBoundary;
+                tileBoundary.color = GetTileStateColor(tileDebugInfo);
+                tileBoundary.positions.reserve(4 * TILE_EDGE_SEGMENTS);
+                for (int j = 0; j < 4; j++) {
+                    const MapPos& pos0 = corners[j];
+                    const MapPos& pos1 = corners[(j + 1) % 4];
+                    for (int k = 0; k < TILE_EDGE_SEGMENTS; k++) {
+                        double t = static_cast<double>(k) / TILE_EDGE_SEGMENTS;
+                        MapPos internalPos = projection->toInternal(MapPos(pos0.getX() + (pos1.getX() - pos0.getX()) * t, pos0.getY() + (pos1.getY() - pos0.getY()) * t));
+                        internalPos.setX(internalPos.getX() + offsetX);
+                        tileBoundary.positions.push_back(projectionSurface->calculatePosition(internalPos));
+                    }
+                }
+                tileBoundaries.push_back(std::move(tileBoundary));
+            }
+        }
+        _debugOverlayRenderer->setTileBoundaries(tileBoundaries);
+
+        redraw();
+    }
+
+    void DebugOverlayLayer::offsetLayerHorizontally(double offset) {
+        _debugOverlayRenderer->offsetLayerHorizontally(offset);
+    }
+    
+    bool DebugOverlayLayer::onDrawFrame(float deltaSeconds, BillboardSorter& billboardSorter, const ViewState& viewState) {
+        // Longer gaps between the frames are idle periods, not slow frames
+        float frameTime = deltaSeconds * 1000.0f;
+        if (frameTime < IDLE_FRAME_TIME) {
+            _frameTimes.push_back(frameTime);
+            if (_frameTimes.size() > MAX_FRAME_SAMPLES) {
+                _frameTimes.pop_front();
+            }
+        }
+
+        // Tile states change as the tiles are loaded, so schedule a delayed update after each frame.
+        // The cull worker keeps the earliest pending update time, thus the updates are throttled by the cull delay.
+        if (isTileBoundariesVisible()) {
+            if (auto mapRenderer = getMapRenderer()) {
+                mapRenderer->layerChanged(shared_from_this(), true);
+            }
+        }
+
+        if (isStatisticsVisible()) {
+            std::chrono::steady_clock::time_point currentTime = std::chrono::steady_clock::now();
+            if (currentTime - _lastStatisticsUpdateTime >= std::chrono::milliseconds(STATISTICS_UPDATE_INTERVAL)) {
+                _debugOverlayRenderer->setStatisticsBitmap(drawStatistics(viewState));
+                _lastStatisticsUpdateTime = currentTime;
+            }
+        } else {
+            _debugOverlayRenderer->setStatisticsBitmap(std::shared_ptr<Bitmap>());
+            _lastStatisticsUpdateTime = std::chrono::steady_clock::time_point();
+        }
+
+        _debugOverlayRenderer->onDrawFrame(viewState);
+        return false;
+    }
+    
+    void DebugOverlayLayer::calculateRayIntersectedElements(const cglib::ray3<double>& ray, const ViewState& viewState, std::vector<RayIntersectedElement>& results) const {
+    }
+
+    bool DebugOverlayLayer::processClick(ClickType::ClickType clickType, const RayIntersectedElement& intersectedElement, const ViewState& viewState) const {
+        return false;
+    }
+    
+    void DebugOverlayLayer::registerDataSourceListener() {
+    }
+
+    void DebugOverlayLayer::unregisterDataSourceListener() {
+    }
+
+    std::shared_ptr<Bitmap> DebugOverlayLayer::drawStatistics(const ViewState& viewState) const {
+        std::shared_ptr<MapRenderer> mapRenderer = getMapRenderer();
+        if (!mapRenderer) {
+            return std::shared_ptr<Bitmap>();
+        }
+
+        // Frame statistics
+        std::vector<std::string> headerLines;
+        {
+            float totalTime = std::accumulate(_frameTimes.begin(), _frameTimes.end(), 0.0f);
+            float maxTime = _frameTimes.empty() ? 0.0f : *std::max_element(_frameTimes.begin(), _frameTimes.end());
+            std::stringstream ss;
+            ss << std::fixed << std::setprecision(1);
+            ss << "FPS " << (totalTime > 0 ? _frameTimes.size() * 1000.0f / totalTime : 0.0f);
+            ss << "  frame " << (_frameTimes.empty() ? 0.0f : totalTime / _frameTimes.size()) << " ms, max " << maxTime << " ms";
+            headerLines.push_back(ss.str());
+        }
+
+        // Thread pool and layer statistics
+        std::vector<std::string> lines;
+        const std::pair<std::string, std::shared_ptr<CancelableThreadPool> > threadPools[2] = {
+            std::make_pair("Envelope", _envelopeThreadPool),
+            std::make_pair("Tile", _tileThreadPool)
+        };
+        for (const std::pair<std::string, std::shared_ptr<CancelableThreadPool> >& threadPool : threadPools) {
+            if (threadPool.second) {
+                CancelableThreadPool::Statistics stats = threadPool.second->getStatistics();
+                std::stringstream ss;
+                ss << threadPool.first << " pool (" << stats.poolSize << " threads): " << stats.queuedTaskCount << " queued, max " << stats.maxQueuedTaskCount;
+                lines.push_back(ss.str());
+            }
+        }
+        std::vector<std::shared_ptr<Layer> > layers = mapRenderer->getLayers()->getAll();
+        for (std::size_t i = 0; i < layers.size(); i++) {
+            auto tileLayer = std::dynamic_pointer_cast<TileLayer>(layers[i]);
+            if (!tileLayer) {
+                continue;
+            }
+
+            int stateCounts[4] = { 0, 0, 0, 0 };
+            for (const TileLayer::TileDebugInfo& tileDebugInfo : tileLayer->getTileDebugInfos()) {
+                stateCounts[tileDebugInfo.state]++;
+            }
+
+            std::stringstream ss;
+            ss << std::fixed << std::setprecision(1);
+            ss << "Layer " << i << ": " << stateCounts[TileLayer::TileDebugInfo::CACHED] << " cached, ";
+            ss << stateCounts[TileLayer::TileDebugInfo::PARENT_SUBSTITUTE] << " parent, ";
+            ss << stateCounts[TileLayer::TileDebugInfo::CHILD_SUBSTITUTE] << " child, ";
+            ss << stateCounts[TileLayer::TileDebugInfo::LOADING] << " loading";
+            CacheStatistics cacheStats;
+            bool hasCache = false;
+            if (auto rasterTileLayer = std::dynamic_pointer_cast<RasterTileLayer>(tileLayer)) {
+                cacheStats = rasterTileLayer->getTextureCacheStatistics();
+                hasCache = true;
+            } else if (auto vectorTileLayer = std::dynamic_pointer_cast<VectorTileLayer>(tileLayer)) {
+                cacheStats = vectorTileLayer->getTileCacheStatistics();
+                hasCache = true;
+            }
+            if (hasCache) {
+                ss << ", cache " << cacheStats.getSize() / 1048576.0 << "/" << cacheStats.getCapacity() / 1048576.0 << " MB";
+            }
+            lines.push_back(ss.str());
+        }
+
+        // Layout: header, frame time graph, other lines
+        float dpToPx = viewState.getDPI() / Const::UNSCALED_DPI;
+        float padding = 4.0f * dpToPx;
+        float graphHeight = 32.0f * dpToPx;
+        float fontSize = STATISTICS_FONT_SIZE * dpToPx;
+
+        BitmapCanvas measureCanvas(0, 0);
+        measureCanvas.setFont(STATISTICS_FONT_NAME, fontSize);
+        std::vector<std::string> allLines = headerLines;
+        allLines.insert(allLines.end(), lines.begin(), lines.end());
+        float textWidth = 0, lineHeight = 0;
+        for (const std::string& line : allLines) {
+            ScreenBounds textBounds = measureCanvas.measureTextSize(line, -1, false);
+            textWidth = std::max(textWidth, textBounds.getWidth());
+            lineHeight = std::max(lineHeight, textBounds.getHeight());
+        }
+        float graphWidth = std::max(textWidth, static_cast<float>(MAX_FRAME_SAMPLES) * dpToPx);
+
+        int canvasWidth = static_cast<int>(std::ceil(graphWidth + 2 * padding));
+        int canvasHeight = static_cast<int>(std::ceil(allLines.size() * lineHeight + graphHeight + 4 * padding));
+        BitmapCanvas canvas(canvasWidth, canvasHeight);
+        canvas.setFont(STATISTICS_FONT_NAME, fontSize);
+
+        canvas.setDrawMode(BitmapCanvas::FILL);
+        canvas.setColor(Color(0, 0, 0, 160));
+        canvas.drawRoundRect(ScreenBounds(ScreenPos(0, 0), ScreenPos(canvasWidth, canvasHeight)), padding);
+
+        float y = padding;
+        canvas.setColor(Color(255, 255, 255, 255));
+        for (const std::string& line : headerLines) {
+            canvas.drawText(line, ScreenPos(padding, y), -1, false);
+            y += lineHeight;
+        }
+
+        // Frame time graph, the newest frame is on the right. The red line marks the 60 FPS frame budget.
+        y += padding;
+        canvas.setColor(Color(0, 0, 0, 160));
+        canvas.drawRoundRect(ScreenBounds(ScreenPos(padding, y), ScreenPos(padding + graphWidth, y + graphHeight)), 0);
+        if (!_frameTimes.empty()) {
+            float barWidth = graphWidth / MAX_FRAME_SAMPLES;
+            std::vector<ScreenPos> graphPoses;
+            graphPoses.emplace_back(padding + graphWidth - _frameTimes.size() * barWidth, y + graphHeight);
+            for (std::size_t i = 0; i < _frameTimes.size(); i++) {
+                float x = padding + graphWidth - (_frameTimes.size() - i) * barWidth;
+                float h = std::min(_frameTimes[i] / FRAME_GRAPH_MAX_TIME, 1.0f) * graphHeight;
+                graphPoses.emplace_back(x, y + graphHeight - h);
+                graphPoses.emplace_back(x + barWidth, y + graphHeight - h);
+            }
+            graphPoses.emplace_back(padding + graphWidth, y + graphHeight);
+            canvas.setColor(Color(0, 200, 80, 255));
+            canvas.drawPolygon(graphPoses);
+        }
+        float budgetY = y + graphHeight - 1000.0f / 60.0f / FRAME_GRAPH_MAX_TIME * graphHeight;
+        canvas.setColor(Color(255, 64, 64, 255));
+        canvas.drawRoundRect(ScreenBounds(ScreenPos(padding, budgetY - 0.5f * dpToPx), ScreenPos(padding + graphWidth, budgetY + 0.5f * dpToPx)), 0);
+        y += graphHeight + padding;
+
+        canvas.setColor(Color(255, 255, 255, 255));
+        for (const std::string& line : lines) {
+            canvas.drawText(line, ScreenPos(padding, y), -1, false);
+            y += lineHeight;
+        }
+
+        return canvas.buildBitmap();
+    }
+
+    Color DebugOverlayLayer::GetTileStateColor(const TileLayer::TileDebugInfo& tileDebugInfo) {
+        switch (tileDebugInfo.state) {
+        case TileLayer::TileDebugInfo::LOADING:
+            return Color(160, 160, 160, 255);
+        case TileLayer::TileDebugInfo::PARENT_SUBSTITUTE:
+            return Color(0, 128, 255, 255);
+        case TileLayer::TileDebugInfo::CHILD_SUBSTITUTE:
+            return Color(255, 0, 255, 255);
+        default:
+            break;
+        }
+
+        // Green for fast or unknown load times, through yellow to red for slow loads
+        float t = std::min(std::max(tileDebugInfo.loadTime, 0.0f) / SLOW_TILE_LOAD_TIME, 1.0f);
+        unsigned char r = static_cast<unsigned char>(std::min(1.0f, 2.0f * t) * 255.0f);
+        unsigned char g = static_cast<unsigned char>(std::min(1.0f, 2.0f - 2.0f * t) * 255.0f);
+        return Color(r, g, 0, 255);
+    }
+
+    const int DebugOverlayLayer::TILE_UPDATE_DELAY = 250;
+    const int DebugOverlayLayer::STATISTICS_UPDATE_INTERVAL = 500;
+    const int DebugOverlayLayer::TILE_EDGE_SEGMENTS = 8;
+    const float DebugOverlayLayer::SLOW_TILE_LOAD_TIME = 1000.0f;
+    const float DebugOverlayLayer::IDLE_FRAME_TIME = 250.0f;
+    const std::size_t DebugOverlayLayer::MAX_FRAME_SAMPLES = 120;
+    const float DebugOverlayLayer::FRAME_GRAPH_MAX_TIME = 50.0f;
+    const float DebugOverlayLayer::STATISTICS_FONT_SIZE = 11.0f;
+    const std::string DebugOverlayLayer::STATISTICS_FONT_NAME = "HelveticaNeue-Light";
+
+}
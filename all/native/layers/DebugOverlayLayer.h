@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_DEBUGOVERLAYLAYER_H_
+#define _CARTO_DEBUGOVERLAYLAYER_H_
+
+#include "graphics/Color.h"
+#include "layers/Layer.h"
+#include "layers/TileLayer.h"
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace carto {
+    class Bitmap;
+    class CullState;
+    class DebugOverlayRenderer;
+    class ViewState;
+    
+    /**
+     * A diagnostic layer that draws rendering and loading statistics of the map on top of the layers below it.
+     * Tile boundaries of the visible tile layers are colored by the tile state: gray for tiles still loading,
+     * blue for tiles substituted by a parent tile, magenta for tiles substituted by child tiles and
+     * green to red (by the load time, up to 1 second) for tiles drawn from own data.
+     * The statistics panel in the top-left corner shows the frame rate, a frame time graph,
+     * cache occupancy of each tile layer and the queue depths of the SDK thread pools.
+     * The layer is meant for development builds, it adds overhead to each frame.
+     */
+    class DebugOverlayLayer : public Layer {
+    public:
+        /**
+         * Constructs a DebugOverlayLayer object. Both tile boundaries and statistics are shown by default.
+         */
+        DebugOverlayLayer();
+        virtual ~DebugOverlayLayer();
+        
+        /**
+         * Returns true if the tile boundaries are drawn.
+         * @return True if the tile boundaries are drawn.
+         */
+        bool isTileBoundariesVisible() const;
+        /**
+         * Sets the tile boundaries visibility state.
+         * @param visible True if the tile boundaries should be drawn.
+         */
+        void setTileBoundariesVisible(bool visible);
+
+        /**
+         * Returns true if the statistics panel is drawn.
+         * @return True if the statistics panel is drawn.
+         */
+        bool isStatisticsVisible() const;
+        /**
+         * Sets the statistics panel visibility state.
+         * @param visible True if the statistics panel should be drawn.
+         */
+        void setStatisticsVisible(bool visible);
+        
+        virtual bool isUpdateInProgress() const;
+        
+    protected:
+        virtual void setComponents(const std::shared_ptr<CancelableThreadPool>& envelopeThreadPool,
+                                   const std::shared_ptr<CancelableThreadPool>& tileThreadPool,
+                                   const std::weak_ptr<Options>& options,
+                                   const std::weak_ptr<MapRenderer>& mapRenderer,
+                                   const std::weak_ptr<TouchHandler>& touchHandler);
+        
+        virtual void loadData(const std::shared_ptr<CullState>& cullState);
+
+        virtual void offsetLayerHorizontally(double offset);
+        
+        virtual bool onDrawFrame(float deltaSeconds, BillboardSorter& billboardSorter, const ViewState& viewState);
+        
+        virtual void calculateRayIntersectedElements(const cglib::ray3<double>& ray, const ViewState& viewState, std::vector<RayIntersectedElement>& results) const;
+        virtual bool processClick(ClickType::ClickType clickType, const RayIntersectedElement& intersectedElement, const ViewState& viewState) const;
+
+        virtual void registerDataSourceListener();
+        virtual void unregisterDataSourceListener();
+
+    private:
+        std::shared_ptr<Bitmap> drawStatistics(const ViewState& viewState) const;
+
+        static Color GetTileStateColor(const TileLayer::TileDebugInfo& tileDebugInfo);
+
+        static const int TILE_UPDATE_DELAY;
+        static const int STATISTICS_UPDATE_INTERVAL;
+        static const int TILE_EDGE_SEGMENTS;
+        static const float SLOW_TILE_LOAD_TIME;
+        static const float IDLE_FRAME_TIME;
+        static const std::size_t MAX_FRAME_SAMPLES;
+        static const float FRAME_GRAPH_MAX_TIME;
+        static const float STATISTICS_FONT_SIZE;
+        static const std::string STATISTICS_FONT_NAME;
+
+        bool _tileBoundariesVisible;
+        bool _statisticsVisible;
+
+        std::vector<std::vector<TileLayer::TileDebugInfo> > _lastTileDebugInfos;
+        std::deque<float> _frameTimes; // in milliseconds, accessed only from the GL thread
+        std::chrono::steady_clock::time_point _lastStatisticsUpdateTime;
+
+        std::shared_ptr<DebugOverlayRenderer> _debugOverlayRenderer;
+    };
+    
+}
+
+#endif
@@ -20,6 +20,7 @@
 #include "renderers/PolygonRenderer.h"
 #include "renderers/components/CullState.h"
 #include "renderers/components/RayIntersectedElement.h"
+#include "renderers/drawdatas/DrawDataPool.h"
 #include "renderers/drawdatas/LabelDrawData.h"
 #include "renderers/drawdatas/LineDrawData.h"
 #include "renderers/drawdatas/MarkerDrawData.h"
@@ -799,17 +800,29 @@ namespace carto {
     }
 
     std::shared_ptr<Point> EditableVectorLayer::createOverlayPoint(const MapPos& mapPos, bool virtualPoint, int index) const {
+        auto mapRenderer = getMapRenderer();
+
         std::shared_ptr<Point> overlayPoint;
         if (index >= 0 && index < static_cast<int>(_overlayPoints.size())) {
             overlayPoint = _overlayPoints[index];
+            std::shared_ptr<PointStyle> style = overlayPoint == _overlayDragPoint ? _overlayStyleSelected : (virtualPoint ? _overlayStyleVirtual : _overlayStyleNormal);
+
+            // While dragging, only the points next to the dragged vertex move, keep the draw data of the unchanged points
+            if (mapRenderer && overlayPoint->getPos() == mapPos && overlayPoint->getStyle() == style) {
+                std::shared_ptr<PointDrawData> drawData = overlayPoint->getDrawData();
+                if (drawData && !drawData->isOffset() && drawData->getProjectionSurface() == mapRenderer->getProjectionSurface()) {
+                    return overlayPoint;
+                }
+            }
+
             overlayPoint->setPos(mapPos);
-            overlayPoint->setStyle(overlayPoint == _overlayDragPoint ? _overlayStyleSelected : (virtualPoint ? _overlayStyleVirtual : _overlayStyleNormal));
+            overlayPoint->setStyle(style);
         } else {
             overlayPoint = std::make_shared<Point>(mapPos, virtualPoint ? _overlayStyleVirtual : _overlayStyleNormal);
         }
         if (overlayPoint->getStyle()) {
-            if (auto mapRenderer = getMapRenderer()) {
-                overlayPoint->setDrawData(std::make_shared<PointDrawData>(*overlayPoint->getGeometry(), *overlayPoint->getStyle(), *_dataSource->getProjection(), mapRenderer->getProjectionSurface()));
+            if (mapRenderer) {
+                overlayPoint->setDrawData(DrawDataPool::Create<PointDrawData>(*overlayPoint->getGeometry(), *overlayPoint->getStyle(), *_dataSource->getProjection(), mapRenderer->getProjectionSurface()));
             }
         }
         return overlayPoint;
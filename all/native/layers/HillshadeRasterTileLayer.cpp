@@ -39,7 +39,7 @@ namespace carto {
             std::lock_guard<std::recursive_mutex> lock(_mutex);
             _contrast = std::min(1.0f, std::max(0.0f, contrast));
         }
-        tilesChanged(false);
+        redraw();
     }
 
     float HillshadeRasterTileLayer::getHeightScale() const {
@@ -94,7 +94,9 @@ namespace carto {
             _tileRenderer->setRasterFilterMode(getRasterFilterMode());
             _tileRenderer->setNormalMapShadowColor(getShadowColor());
             _tileRenderer->setNormalMapHighlightColor(getHighlightColor());
+            _tileRenderer->setNormalMapContrast(getContrast());
             bool refresh = _tileRenderer->onDrawFrame(deltaSeconds, viewState);
+            reportTileLoadTraces();
 
             if (opacity < 1.0f) {
                 mapRenderer->blendAndUnbindScreenFBO(opacity);
@@ -106,11 +108,11 @@ namespace carto {
     }
     
     std::shared_ptr<vt::Tile> HillshadeRasterTileLayer::createVectorTile(const MapTile& tile, const std::shared_ptr<Bitmap>& bitmap) const {
-        std::uint8_t alpha = 0;
+        // Contrast is applied in the lighting shader, so normal maps are built with full intensity
+        std::uint8_t alpha = 255;
         std::array<float, 4> scales;
         {
             std::lock_guard<std::recursive_mutex> lock(_mutex);
-            alpha = static_cast<std::uint8_t>(_contrast * 255.0f);
             float exaggeration = tile.getZoom() < 2 ? 0.2f : tile.getZoom() < 5 ? 0.3f : 0.35f;
             float scale = 16 * _heightScale * static_cast<float>(bitmap->getHeight() * std::pow(2.0, tile.getZoom() * (1 - exaggeration)) / 40075016.6855785);
             scales = std::array<float, 4> { 65536 * scale, 256 * scale, scale, 0.0f };
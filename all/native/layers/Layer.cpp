@@ -210,6 +210,10 @@ namespace carto {
         return _touchHandler.lock();
     }
 
+    bool Layer::isCullStateInvariant(const CullState& lastCullState, const CullState& cullState) const {
+        return false;
+    }
+
     void Layer::redraw() const {
         if (auto mapRenderer = getMapRenderer()) {
             mapRenderer->requestRedraw();
@@ -228,6 +232,10 @@ namespace carto {
         return std::shared_ptr<Bitmap>();
     }
 
+    std::size_t Layer::getGPUMemoryUsage() const {
+        return 0;
+    }
+
     const int Layer::DEFAULT_CULL_DELAY = 400;
 
 }
@@ -162,6 +162,7 @@ namespace carto {
         friend class MapRenderer;
         friend class BackgroundRenderer;
         friend class TouchHandler;
+        friend class CullWorker;
     
         Layer();
         
@@ -179,6 +180,9 @@ namespace carto {
         void redraw() const;
     
         virtual void loadData(const std::shared_ptr<CullState>& cullState) = 0;
+
+        // Returns true if the layer data does not depend on the changes between the given cull states, in that case the update can be skipped
+        virtual bool isCullStateInvariant(const CullState& lastCullState, const CullState& cullState) const;
         
         virtual void offsetLayerHorizontally(double offset) = 0;
 
@@ -187,6 +191,9 @@ namespace carto {
         
         virtual std::shared_ptr<Bitmap> getBackgroundBitmap() const;
         virtual std::shared_ptr<Bitmap> getSkyBitmap() const;
+
+        // Returns the GPU memory used by the graphics resources owned by the layer renderers
+        virtual std::size_t getGPUMemoryUsage() const;
         
         virtual void calculateRayIntersectedElements(const cglib::ray3<double>& ray, const ViewState& viewState, std::vector<RayIntersectedElement>& results) const = 0;
         virtual bool processClick(ClickType::ClickType clickType, const RayIntersectedElement& intersectedElement, const ViewState& viewState) const = 0;
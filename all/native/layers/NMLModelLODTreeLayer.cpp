@@ -68,21 +68,28 @@ namespace carto {
         _fetchingModelLODTrees(),
         _fetchingMeshes(),
         _fetchingTextures(),
+        _meshFetchRanks(),
+        _textureFetchRanks(),
         _fetchThreadPool(std::make_shared<CancelableThreadPool>()),
         _dataSource(dataSource),
         _nmlModelLODTreeEventListener(),
         _nmlModelLODTreeRenderer(std::make_shared<NMLModelLODTreeRenderer>()),
         _glResourceManager(),
-        _projectionSurface()
+        _projectionSurface(),
+        _memoryConsumer()
     {
         if (!dataSource) {
             throw NullArgumentException("Null dataSource");
         }
 
         _fetchThreadPool->setPoolSize(1);
+
+        // The budget is read from the consumer when the node list is calculated, the handlers are not needed
+        _memoryConsumer = MemoryGovernor::GetInstance().registerConsumer(DEFAULT_MAX_MEMORY_SIZE, 1.0f, std::function<void(std::size_t)>(), std::function<void(bool)>());
     }
     
     NMLModelLODTreeLayer::~NMLModelLODTreeLayer() {
+        _memoryConsumer->detach();
         _fetchThreadPool->cancelAll();
         _fetchThreadPool->deinit();
     }
@@ -97,8 +104,11 @@ namespace carto {
     }    
 
     void NMLModelLODTreeLayer::setMaxMemorySize(std::size_t size) {
-        std::lock_guard<std::recursive_mutex> lock(_mutex);
-        _maxMemorySize = size;
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            _maxMemorySize = size;
+        }
+        _memoryConsumer->setCapacity(size);
         refresh();
     }
 
@@ -148,6 +158,10 @@ namespace carto {
         return false;
     }
     
+    std::size_t NMLModelLODTreeLayer::getGPUMemoryUsage() const {
+        return _nmlModelLODTreeRenderer->getGPUMemoryUsage();
+    }
+
     void NMLModelLODTreeLayer::calculateRayIntersectedElements(const cglib::ray3<double>& ray, const ViewState& viewState, std::vector<RayIntersectedElement>& results) const {
         std::shared_ptr<NMLModelLODTreeLayer> thisLayer = std::static_pointer_cast<NMLModelLODTreeLayer>(std::const_pointer_cast<Layer>(shared_from_this()));
         _nmlModelLODTreeRenderer->calculateRayIntersectedElements(thisLayer, ray, viewState, results);
@@ -244,7 +258,7 @@ namespace carto {
     }
     
     bool NMLModelLODTreeLayer::isDataAvailable(const NMLModelLODTree* modelLODTree, int nodeId) {
-        return loadMeshes(modelLODTree, nodeId, true) && loadTextures(modelLODTree, nodeId, true);
+        return loadMeshes(modelLODTree, nodeId, true, 0, 0) && loadTextures(modelLODTree, nodeId, true, 0, 0);
     }    
     
     bool NMLModelLODTreeLayer::loadModelLODTrees(const MapTileList& mapTileList, bool checkOnly) {
@@ -270,12 +284,16 @@ namespace carto {
         return true;
     }
     
-    bool NMLModelLODTreeLayer::loadMeshes(const NMLModelLODTree* modelLODTree, int nodeId, bool checkOnly) {
+    bool NMLModelLODTreeLayer::loadMeshes(const NMLModelLODTree* modelLODTree, int nodeId, bool checkOnly, int priorityOffset, double rank) {
         auto mapIt = modelLODTree->getMeshBindingsMap().find(nodeId);
         if (mapIt == modelLODTree->getMeshBindingsMap().end()) {
             return false;
         }
     
+        // Missing meshes of the node are fetched using a single batch request
+        std::vector<NMLModelLODTree::MeshBinding> fetchBindings;
+        std::unordered_set<long long> fetchIds;
+        int priority = getUpdatePriority() + MESH_LOADING_PRIORITY_OFFSET + priorityOffset;
         for (auto listIt = mapIt->second.begin(); listIt != mapIt->second.end(); listIt++) {
             const NMLModelLODTree::MeshBinding& binding = *listIt;
     
@@ -288,22 +306,31 @@ namespace carto {
                     if (checkOnly) {
                         return false;
                     }
-                    if (!_fetchingMeshes.exists(binding.meshId)) {
-                        auto task = std::make_shared<MeshFetchTask>(std::static_pointer_cast<NMLModelLODTreeLayer>(shared_from_this()), binding);
-                        _fetchThreadPool->execute(task, getUpdatePriority() + MESH_LOADING_PRIORITY_OFFSET);
+                    UpdateFetchRank(_meshFetchRanks, binding.meshId, priority, rank);
+                    if (!_fetchingMeshes.exists(binding.meshId) && fetchIds.insert(binding.meshId).second) {
+                        fetchBindings.push_back(binding);
                     }
                 }
             }
         }
+
+        if (!fetchBindings.empty() && canScheduleFetch()) {
+            auto task = std::make_shared<MeshFetchTask>(std::static_pointer_cast<NMLModelLODTreeLayer>(shared_from_this()), fetchBindings);
+            _fetchThreadPool->execute(task, priority);
+        }
         return true;
     }
     
-    bool NMLModelLODTreeLayer::loadTextures(const NMLModelLODTree* modelLODTree, int nodeId, bool checkOnly) {
+    bool NMLModelLODTreeLayer::loadTextures(const NMLModelLODTree* modelLODTree, int nodeId, bool checkOnly, int priorityOffset, double rank) {
         auto mapIt = modelLODTree->getTextureBindingsMap().find(nodeId);
         if (mapIt == modelLODTree->getTextureBindingsMap().end()) {
             return false;
         }
     
+        // Missing textures of the node are fetched using a single batch request
+        std::vector<NMLModelLODTree::TextureBinding> fetchBindings;
+        std::unordered_set<long long> fetchIds;
+        int priority = getUpdatePriority() + TEXTURE_LOADING_PRIORITY_OFFSET + priorityOffset;
         for (auto listIt = mapIt->second.begin(); listIt != mapIt->second.end(); listIt++) {
             const NMLModelLODTree::TextureBinding& binding = *listIt;
     
@@ -316,15 +343,64 @@ namespace carto {
                     if (checkOnly) {
                         return false;
                     }
-                    if (!_fetchingTextures.exists(binding.textureId)) {
-                        auto task = std::make_shared<TextureFetchTask>(std::static_pointer_cast<NMLModelLODTreeLayer>(shared_from_this()), binding);
-                        _fetchThreadPool->execute(task, getUpdatePriority() + TEXTURE_LOADING_PRIORITY_OFFSET);
+                    UpdateFetchRank(_textureFetchRanks, binding.textureId, priority, rank);
+                    if (!_fetchingTextures.exists(binding.textureId) && fetchIds.insert(binding.textureId).second) {
+                        fetchBindings.push_back(binding);
                     }
                 }
             }
         }
+
+        if (!fetchBindings.empty() && canScheduleFetch()) {
+            auto task = std::make_shared<TextureFetchTask>(std::static_pointer_cast<NMLModelLODTreeLayer>(shared_from_this()), fetchBindings);
+            _fetchThreadPool->execute(task, priority);
+        }
         return true;
     }
+
+    bool NMLModelLODTreeLayer::canScheduleFetch() const {
+        return _fetchingMeshes.getTaskCount() + _fetchingTextures.getTaskCount() < MAX_FETCHING_TASKS;
+    }
+
+    void NMLModelLODTreeLayer::reprioritizeFetchTasks() {
+        // Mesh and texture requests not needed by the current view are canceled, others are ordered by the projected screen size of their nodes
+        // Batch requests use the best rank of their items and are canceled only if none of the items is needed
+        _fetchThreadPool->reprioritize([this](const std::shared_ptr<CancelableTask>& task, int& priority, double& rank) {
+            const FetchRankMap* fetchRanks = nullptr;
+            std::vector<long long> ids;
+            if (auto meshTask = std::dynamic_pointer_cast<MeshFetchTask>(task)) {
+                fetchRanks = &_meshFetchRanks;
+                for (const NMLModelLODTree::MeshBinding& binding : meshTask->getBindings()) {
+                    ids.push_back(binding.meshId);
+                }
+            } else if (auto textureTask = std::dynamic_pointer_cast<TextureFetchTask>(task)) {
+                fetchRanks = &_textureFetchRanks;
+                for (const NMLModelLODTree::TextureBinding& binding : textureTask->getBindings()) {
+                    ids.push_back(binding.textureId);
+                }
+            } else {
+                return false;
+            }
+
+            bool found = false;
+            for (long long id : ids) {
+                auto it = fetchRanks->find(id);
+                if (it == fetchRanks->end()) {
+                    continue;
+                }
+                if (!found || it->second.first > priority || (it->second.first == priority && it->second.second < rank)) {
+                    priority = it->second.first;
+                    rank = it->second.second;
+                }
+                found = true;
+            }
+            if (!found) {
+                task->cancel();
+                return false;
+            }
+            return true;
+        });
+    }
     
     void NMLModelLODTreeLayer::updateModelLODTrees(const MapTileList& mapTileList, ModelLODTreeMap& modelLODTreeMap) {
         for (auto it = mapTileList.begin(); it != mapTileList.end(); it++) {
@@ -399,6 +475,9 @@ namespace carto {
         if (!projectionSurface) {
             return;
         }
+
+        _meshFetchRanks.clear();
+        _textureFetchRanks.clear();
     
         cglib::mat4x4<double> mvpMatrix = viewState.getModelviewProjectionMat();
         cglib::frustum3<double> frustum = cglib::gl_projection_frustum(mvpMatrix);
@@ -417,6 +496,7 @@ namespace carto {
         }
     
         // Create new queue by taking root nodes from initial queue until size limits are exceeded
+        std::size_t maxMemorySize = std::min(_maxMemorySize, _memoryConsumer->getBudget());
         std::size_t totalSize = 0;
         std::priority_queue<SizeNodePair> queue;
         while (!initialQueue.empty()) {
@@ -435,7 +515,7 @@ namespace carto {
     
             // Test if this node can be added or we have already exceeded max memory footprint
             std::size_t nodeSize = node->model().texture_footprint() + node->model().mesh_footprint();
-            if (totalSize + nodeSize <= _maxMemorySize) {
+            if (totalSize + nodeSize <= maxMemorySize) {
                 queue.push(sizeNodePair);
                 totalSize += nodeSize;
             }
@@ -444,6 +524,7 @@ namespace carto {
         // Create actual draw list by opening bigger nodes (as seen from viewpoint) first and maximum memory footprint is not exceeded
         std::vector<const nml::ModelLODTreeNode*> childList;
         std::vector<Node> nodeDrawList;
+        std::map<long long, float> nodeScreenSizes;
         while (!queue.empty()) {
             SizeNodePair sizeNodePair = queue.top();
             queue.pop();
@@ -469,7 +550,7 @@ namespace carto {
                         childListTotalSize += childNodeSize;
                     }
                 }
-                if (childListTotalSize <= _maxMemorySize) {
+                if (childListTotalSize <= maxMemorySize) {
                     for (std::size_t i = 0; i < childList.size(); i++) {
                         const nml::ModelLODTreeNode* childNode = childList[i];
                         float screenSize = calculateProjectedScreenSize(childNode->bounds(), mvpMatrix * CalculateLocalMat(viewState, modelLODTree));
@@ -482,7 +563,13 @@ namespace carto {
     
             // Done with this node, add to draw list
             nodeDrawList.push_back(Node(modelLODTree, nodeId));
+            nodeScreenSizes[modelLODTree->getGlobalNodeId(nodeId)] = screenSize;
         }
+
+        // Process nodes with bigger visual impact first, so that their data is requested first when the number of concurrent requests is limited
+        std::stable_sort(nodeDrawList.begin(), nodeDrawList.end(), [&nodeScreenSizes](const Node& node1, const Node& node2) {
+            return nodeScreenSizes[node1.first->getGlobalNodeId(node1.second)] > nodeScreenSizes[node2.first->getGlobalNodeId(node2.second)];
+        });
     
         // Build children list for each parent node of current draw list
         std::map<long long, std::vector<int> > childrenIdsMap;
@@ -506,9 +593,15 @@ namespace carto {
                 continue;
             }
     
-            // Schedule data loading and remove this node from draw list
-            loadMeshes(modelLODTree, nodeId, false);
-            loadTextures(modelLODTree, nodeId, false);
+            // Schedule data loading and remove this node from draw list. The root node of the model is requested before
+            // the details, so that a coarse version of the whole area is displayed while the details are streamed in.
+            float screenSize = nodeScreenSizes[modelLODTree->getGlobalNodeId(nodeId)];
+            if (nodeId != 0 && !isDataAvailable(modelLODTree, 0)) {
+                loadMeshes(modelLODTree, 0, false, COARSE_LOADING_PRIORITY_OFFSET, -screenSize);
+                loadTextures(modelLODTree, 0, false, COARSE_LOADING_PRIORITY_OFFSET, -screenSize);
+            }
+            loadMeshes(modelLODTree, nodeId, false, 0, -screenSize);
+            loadTextures(modelLODTree, nodeId, false, 0, -screenSize);
             
             // Find closest parent that has data available. Ignore size constraints
             bool parentFound = false;
@@ -600,11 +693,21 @@ namespace carto {
             _nmlModelLODTreeRenderer->addDrawData(nodeDrawData);
         }
     
+        reprioritizeFetchTasks();
+
         _nmlModelLODTreeRenderer->refreshDrawData();
     
         redraw();
     }
 
+    void NMLModelLODTreeLayer::UpdateFetchRank(FetchRankMap& fetchRanks, long long id, int priority, double rank) {
+        // Keep the highest priority and the lowest rank if the same data is requested by multiple nodes
+        auto it = fetchRanks.find(id);
+        if (it == fetchRanks.end() || priority > it->second.first || (priority == it->second.first && rank < it->second.second)) {
+            fetchRanks[id] = std::make_pair(priority, rank);
+        }
+    }
+
     cglib::mat4x4<double> NMLModelLODTreeLayer::CalculateLocalMat(const ViewState& viewState, const NMLModelLODTree* modelLODTree) {
         if (std::shared_ptr<ProjectionSurface> projectionSurface = viewState.getProjectionSurface()) {
             MapPos mapPosInternal = modelLODTree->getProjection()->toInternal(modelLODTree->getMapPos());
@@ -632,10 +735,9 @@ namespace carto {
     
         std::unique_lock<std::recursive_mutex> lock(layer->_mutex);
         
-        // If view has changed, cancel all previous task and fetch new list of map tiles
+        // If view has changed, fetch new list of map tiles. Pending mesh and texture requests are kept,
+        // requests not needed for the new view are canceled when the draw lists are updated.
         if (layer->_mapTileListViewState.getModelviewProjectionMat() != _cullState->getViewState().getModelviewProjectionMat()) {
-            layer->_fetchThreadPool->cancelAll();
-
             std::shared_ptr<CullState> cullState = _cullState;
             
             lock.unlock();
@@ -719,11 +821,13 @@ namespace carto {
         layer->_fetchingModelLODTrees.remove(_mapTile.modelLODTreeId);
     }
     
-    NMLModelLODTreeLayer::MeshFetchTask::MeshFetchTask(const std::shared_ptr<NMLModelLODTreeLayer>& layer, const NMLModelLODTree::MeshBinding& binding) :
+    NMLModelLODTreeLayer::MeshFetchTask::MeshFetchTask(const std::shared_ptr<NMLModelLODTreeLayer>& layer, const std::vector<NMLModelLODTree::MeshBinding>& bindings) :
         _layer(layer),
-        _binding(binding)
+        _bindings(bindings)
     {
-        layer->_fetchingMeshes.add(_binding.meshId);
+        for (const NMLModelLODTree::MeshBinding& binding : _bindings) {
+            layer->_fetchingMeshes.add(binding.meshId);
+        }
     }
     
     void NMLModelLODTreeLayer::MeshFetchTask::cancel() {
@@ -733,7 +837,9 @@ namespace carto {
         if (!layer) {
             return;
         }
-        layer->_fetchingMeshes.remove(_binding.meshId);
+        for (const NMLModelLODTree::MeshBinding& binding : _bindings) {
+            layer->_fetchingMeshes.remove(binding.meshId);
+        }
     }
     
     void NMLModelLODTreeLayer::MeshFetchTask::run() {
@@ -746,34 +852,49 @@ namespace carto {
             return;
         }
     
-        // Load new mesh
-        std::shared_ptr<nml::Mesh> mesh;
+        // Load new meshes
+        std::vector<long long> meshIds;
+        for (const NMLModelLODTree::MeshBinding& binding : _bindings) {
+            meshIds.push_back(binding.meshId);
+        }
+        std::map<long long, std::shared_ptr<nml::Mesh> > meshes;
         try {
-            mesh = layer->_dataSource->loadMesh(_binding.meshId);
+            meshes = layer->_dataSource->loadMeshes(meshIds);
         }
         catch (const std::exception& ex) {
-            Log::Errorf("NMLModelLODTreeLayer::MeshFetchTask: Exception while loading mesh: %s", ex.what());
+            Log::Errorf("NMLModelLODTreeLayer::MeshFetchTask: Exception while loading meshes: %s", ex.what());
         }
 
-        if (mesh) {
-            auto glMesh = std::make_shared<nml::GLMesh>(*mesh);
+        if (!meshes.empty()) {
+            MeshMap glMeshes;
+            for (auto it = meshes.begin(); it != meshes.end(); it++) {
+                if (it->second) {
+                    glMeshes[it->first] = std::make_shared<nml::GLMesh>(*it->second);
+                }
+            }
     
             std::unique_lock<std::recursive_mutex> lock(layer->_mutex);
-            layer->_meshMap[_binding.meshId] = glMesh;
-            layer->_meshCache.put(_binding.meshId, glMesh, glMesh->getTotalGeometrySize());
+            for (auto it = glMeshes.begin(); it != glMeshes.end(); it++) {
+                layer->_meshMap[it->first] = it->second;
+                layer->_meshCache.put(it->first, it->second, it->second->getTotalGeometrySize());
+            }
     
             if (auto mapRenderer = layer->getMapRenderer()) {
                 mapRenderer->layerChanged(layer->shared_from_this(), false);
             }
         }
-        layer->_fetchingMeshes.remove(_binding.meshId);
+        for (long long meshId : meshIds) {
+            layer->_fetchingMeshes.remove(meshId);
+        }
     }
     
-    NMLModelLODTreeLayer::TextureFetchTask::TextureFetchTask(const std::shared_ptr<NMLModelLODTreeLayer>& layer, const NMLModelLODTree::TextureBinding& binding) :
+    NMLModelLODTreeLayer::TextureFetchTask::TextureFetchTask(const std::shared_ptr<NMLModelLODTreeLayer>& layer, const std::vector<NMLModelLODTree::TextureBinding>& bindings) :
         _layer(layer),
-        _binding(binding)
+        _bindings(bindings)
     {
-        layer->_fetchingTextures.add(_binding.textureId);
+        for (const NMLModelLODTree::TextureBinding& binding : _bindings) {
+            layer->_fetchingTextures.add(binding.textureId);
+        }
     }
     
     void NMLModelLODTreeLayer::TextureFetchTask::cancel() {
@@ -783,7 +904,9 @@ namespace carto {
         if (!layer) {
             return;
         }
-        layer->_fetchingTextures.remove(_binding.textureId);
+        for (const NMLModelLODTree::TextureBinding& binding : _bindings) {
+            layer->_fetchingTextures.remove(binding.textureId);
+        }
     }
     
     void NMLModelLODTreeLayer::TextureFetchTask::run() {
@@ -796,34 +919,49 @@ namespace carto {
             return;
         }
     
-        // Load new mesh
-        std::shared_ptr<nml::Texture> texture;
+        // Load new textures
+        std::vector<std::pair<long long, int> > textureIds;
+        for (const NMLModelLODTree::TextureBinding& binding : _bindings) {
+            textureIds.emplace_back(binding.textureId, binding.level);
+        }
+        std::map<long long, std::shared_ptr<nml::Texture> > textures;
         try {
-            texture = layer->_dataSource->loadTexture(_binding.textureId, _binding.level);
+            textures = layer->_dataSource->loadTextures(textureIds);
         }
         catch (const std::exception& ex) {
-            Log::Errorf("NMLModelLODTreeLayer::TextureFetchTask: Exception while loading texture: %s", ex.what());
+            Log::Errorf("NMLModelLODTreeLayer::TextureFetchTask: Exception while loading textures: %s", ex.what());
         }
 
-        if (texture) {
-            nml::GLTexture::transcodeIfNeeded(*texture);
-
-            auto glTexture = std::make_shared<nml::GLTexture>(texture);
+        if (!textures.empty()) {
+            TextureMap glTextures;
+            for (auto it = textures.begin(); it != textures.end(); it++) {
+                if (it->second) {
+                    nml::GLTexture::transcodeIfNeeded(*it->second);
+                    glTextures[it->first] = std::make_shared<nml::GLTexture>(it->second);
+                }
+            }
     
             std::unique_lock<std::recursive_mutex> lock(layer->_mutex);
-            layer->_textureMap[_binding.textureId] = glTexture;
-            layer->_textureCache.put(_binding.textureId, glTexture, glTexture->getTextureSize());
+            for (auto it = glTextures.begin(); it != glTextures.end(); it++) {
+                layer->_textureMap[it->first] = it->second;
+                layer->_textureCache.put(it->first, it->second, it->second->getTextureSize());
+            }
     
             if (auto mapRenderer = layer->getMapRenderer()) {
                 mapRenderer->layerChanged(layer->shared_from_this(), false);
             }
         }
-        layer->_fetchingTextures.remove(_binding.textureId);
+        for (const std::pair<long long, int>& textureId : textureIds) {
+            layer->_fetchingTextures.remove(textureId.first);
+        }
     }
 
     const int NMLModelLODTreeLayer::MODELLODTREE_LOADING_PRIORITY_OFFSET = 1;
     const int NMLModelLODTreeLayer::MESH_LOADING_PRIORITY_OFFSET = 0;
     const int NMLModelLODTreeLayer::TEXTURE_LOADING_PRIORITY_OFFSET = 0;
+    const int NMLModelLODTreeLayer::COARSE_LOADING_PRIORITY_OFFSET = 1;
+
+    const int NMLModelLODTreeLayer::MAX_FETCHING_TASKS = 32;
 
     const unsigned int NMLModelLODTreeLayer::DEFAULT_MODELLODTREE_CACHE_SIZE = 64;
     const unsigned int NMLModelLODTreeLayer::DEFAULT_MAX_MEMORY_SIZE = 80 * 1024 * 1024;
@@ -12,6 +12,7 @@
 #include "components/CancelableTask.h"
 #include "components/CancelableThreadPool.h"
 #include "components/DirectorPtr.h"
+#include "components/MemoryGovernor.h"
 #include "datasources/NMLModelLODTreeDataSource.h"
 #include "graphics/ViewState.h"
 #include "layers/Layer.h"
@@ -19,6 +20,8 @@
 #include <string>
 #include <memory>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <stdext/timed_lru_cache.h>
@@ -100,6 +103,8 @@ namespace carto {
         virtual void offsetLayerHorizontally(double offset);
     
         virtual bool onDrawFrame(float deltaSeconds, BillboardSorter& billboardSorter, const ViewState& viewState);
+
+        virtual std::size_t getGPUMemoryUsage() const;
     
         virtual void calculateRayIntersectedElements(const cglib::ray3<double>& ray, const ViewState& viewState, std::vector<RayIntersectedElement>& results) const;
         virtual bool processClick(ClickType::ClickType clickType, const RayIntersectedElement& intersectedElement, const ViewState& viewState) const;
@@ -124,6 +129,7 @@ namespace carto {
         typedef std::map<long long, std::shared_ptr<nml::GLTexture> > TextureMap;
         typedef cache::timed_lru_cache<long long, std::shared_ptr<nml::GLTexture> > TextureCache;
         typedef std::map<long long, std::shared_ptr<NMLModelLODTreeDrawData> > NodeDrawDataMap;
+        typedef std::unordered_map<long long, std::pair<int, double> > FetchRankMap;
     
         class FetchingTasks {
         public:
@@ -176,41 +182,49 @@ namespace carto {
     
         class MeshFetchTask : public CancelableTask {
         public:
-            MeshFetchTask(const std::shared_ptr<NMLModelLODTreeLayer>& layer, const NMLModelLODTree::MeshBinding& binding);
+            MeshFetchTask(const std::shared_ptr<NMLModelLODTreeLayer>& layer, const std::vector<NMLModelLODTree::MeshBinding>& bindings);
+            const std::vector<NMLModelLODTree::MeshBinding>& getBindings() const { return _bindings; }
             virtual void cancel();
             virtual void run();
     
         private:
             std::weak_ptr<NMLModelLODTreeLayer> _layer;
-            NMLModelLODTree::MeshBinding _binding;
+            std::vector<NMLModelLODTree::MeshBinding> _bindings;
         };
     
         class TextureFetchTask : public CancelableTask {
         public:
-            TextureFetchTask(const std::shared_ptr<NMLModelLODTreeLayer>& layer, const NMLModelLODTree::TextureBinding& binding);
+            TextureFetchTask(const std::shared_ptr<NMLModelLODTreeLayer>& layer, const std::vector<NMLModelLODTree::TextureBinding>& bindings);
+            const std::vector<NMLModelLODTree::TextureBinding>& getBindings() const { return _bindings; }
             virtual void cancel();
             virtual void run();
     
         private:
             std::weak_ptr<NMLModelLODTreeLayer> _layer;
-            NMLModelLODTree::TextureBinding _binding;
+            std::vector<NMLModelLODTree::TextureBinding> _bindings;
         };
     
         void clearCaches();
         bool isDataAvailable(const NMLModelLODTree* modelLODTree, int nodeId);
         bool loadModelLODTrees(const MapTileList& mapTileList, bool checkOnly);
-        bool loadMeshes(const NMLModelLODTree* modelLODTree, int nodeId, bool checkOnly);
-        bool loadTextures(const NMLModelLODTree* modelLODTree, int nodeId, bool checkOnly);
+        bool loadMeshes(const NMLModelLODTree* modelLODTree, int nodeId, bool checkOnly, int priorityOffset, double rank);
+        bool loadTextures(const NMLModelLODTree* modelLODTree, int nodeId, bool checkOnly, int priorityOffset, double rank);
+        bool canScheduleFetch() const;
+        void reprioritizeFetchTasks();
         void updateModelLODTrees(const MapTileList& mapTileList, ModelLODTreeMap& modelLODTreeMap);
         void updateMeshes(const NMLModelLODTree* modelLODTree, int nodeId, std::shared_ptr<nml::GLModel> glModel, MeshMap& meshMap);
         void updateTextures(const NMLModelLODTree* modelLODTree, int nodeId, std::shared_ptr<nml::GLModel> glModel, TextureMap& textureMap);
         void updateDrawLists(const ViewState& viewState, MeshMap& meshMap, TextureMap& textureMap, NodeDrawDataMap& nodeDrawDataMap);
 
+        static void UpdateFetchRank(FetchRankMap& fetchRanks, long long id, int priority, double rank);
         static cglib::mat4x4<double> CalculateLocalMat(const ViewState& viewState, const NMLModelLODTree* modelLODTree);
     
         static const int MODELLODTREE_LOADING_PRIORITY_OFFSET;
         static const int MESH_LOADING_PRIORITY_OFFSET;
         static const int TEXTURE_LOADING_PRIORITY_OFFSET;
+        static const int COARSE_LOADING_PRIORITY_OFFSET;
+
+        static const int MAX_FETCHING_TASKS;
 
         static const unsigned int DEFAULT_MODELLODTREE_CACHE_SIZE;
         static const unsigned int DEFAULT_MAX_MEMORY_SIZE;
@@ -234,6 +248,8 @@ namespace carto {
         FetchingTasks _fetchingModelLODTrees;
         FetchingTasks _fetchingMeshes;
         FetchingTasks _fetchingTextures;
+        FetchRankMap _meshFetchRanks;
+        FetchRankMap _textureFetchRanks;
         
         std::shared_ptr<CancelableThreadPool> _fetchThreadPool;
 
@@ -245,6 +261,8 @@ namespace carto {
 
         std::weak_ptr<GLResourceManager> _glResourceManager;
         std::weak_ptr<ProjectionSurface> _projectionSurface;
+
+        std::shared_ptr<MemoryGovernor::Consumer> _memoryConsumer;
     };
     
 }
@@ -1,6 +1,8 @@
 #include "RasterTileLayer.h"
+#include "core/BinaryData.h"
 #include "components/Exceptions.h"
 #include "components/CancelableThreadPool.h"
+#include "components/Options.h"
 #include "datasources/TileDataSource.h"
 #include "layers/RasterTileEventListener.h"
 #include "projections/Projection.h"
@@ -15,6 +17,7 @@
 #include "utils/Const.h"
 
 #include <array>
+#include <cmath>
 #include <algorithm>
 
 #include <vt/TileId.h>
@@ -75,6 +78,7 @@ namespace carto {
     RasterTileLayer::RasterTileLayer(const std::shared_ptr<TileDataSource>& dataSource) :
         TileLayer(dataSource),
         _tileFilterMode(RasterTileFilterMode::RASTER_TILE_FILTER_MODE_BILINEAR),
+        _tileDownscaling(false),
         _rasterTileEventListener(),
         _visibleTileIds(),
         _tempDrawDatas(),
@@ -82,19 +86,30 @@ namespace carto {
         _preloadingCache(DEFAULT_PRELOADING_CACHE_SIZE)
     {
         setCullDelay(DEFAULT_CULL_DELAY);
+
+        _memoryConsumer = MemoryGovernor::GetInstance().registerConsumer(DEFAULT_PRELOADING_CACHE_SIZE, 1.0f,
+            [this](std::size_t budget) { _preloadingCache.resize(budget); },
+            [this](bool critical) { _preloadingCache.clear(); }
+        );
     }
     
     RasterTileLayer::~RasterTileLayer() {
+        _memoryConsumer->detach();
     }
     
     std::size_t RasterTileLayer::getTextureCacheCapacity() const {
-        std::lock_guard<std::recursive_mutex> lock(_mutex);
-        return _preloadingCache.capacity();
+        return _memoryConsumer->getCapacity();
     }
     
     void RasterTileLayer::setTextureCacheCapacity(std::size_t capacityInBytes) {
-        std::lock_guard<std::recursive_mutex> lock(_mutex);
-        _preloadingCache.resize(capacityInBytes);
+        _memoryConsumer->setCapacity(capacityInBytes);
+    }
+
+    CacheStatistics RasterTileLayer::getTextureCacheStatistics() const {
+        std::size_t size = _visibleCache.size() + _preloadingCache.size();
+        std::size_t entryCount = _visibleCache.count() + _preloadingCache.count();
+        long long evictionCount = static_cast<long long>(_visibleCache.eviction_count() + _preloadingCache.eviction_count());
+        return _tileCacheStatistics.getStatistics(size, _memoryConsumer->getCapacity(), entryCount, evictionCount);
     }
     
     RasterTileFilterMode::RasterTileFilterMode RasterTileLayer::getTileFilterMode() const {
@@ -110,6 +125,19 @@ namespace carto {
         redraw();
     }
 
+    bool RasterTileLayer::isTileDownscaling() const {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return _tileDownscaling;
+    }
+
+    void RasterTileLayer::setTileDownscaling(bool enabled) {
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            _tileDownscaling = enabled;
+        }
+        refresh();
+    }
+
     std::shared_ptr<RasterTileEventListener> RasterTileLayer::getRasterTileEventListener() const {
         return _rasterTileEventListener.get();
     }
@@ -124,7 +152,6 @@ namespace carto {
     }
     
     bool RasterTileLayer::tileExists(const MapTile& tile, bool preloadingCache) const {
-        std::lock_guard<std::recursive_mutex> lock(_mutex);
         long long tileId = tile.getTileId();
         if (preloadingCache) {
             return _preloadingCache.exists(tileId);
@@ -134,7 +161,6 @@ namespace carto {
     }
     
     bool RasterTileLayer::tileValid(const MapTile& tile, bool preloadingCache) const {
-        std::lock_guard<std::recursive_mutex> lock(_mutex);
         long long tileId = tile.getTileId();
         if (preloadingCache) {
             return _preloadingCache.exists(tileId) && _preloadingCache.valid(tileId);
@@ -150,21 +176,28 @@ namespace carto {
         }
 
         if (!invalidated) {
-            std::lock_guard<std::recursive_mutex> lock(_mutex);
             if (_preloadingCache.exists(tileId) && _preloadingCache.valid(tileId)) {
                 if (!preloadingTile) {
                     _preloadingCache.move(tileId, _visibleCache); // move to visible cache, just in case the element gets trashed
                 } else {
                     _preloadingCache.get(tileId);
                 }
+                _tileCacheStatistics.recordHit();
                 return;
             }
     
             if (_visibleCache.exists(tileId) && _visibleCache.valid(tileId)) {
                 _visibleCache.get(tileId); // just mark usage, do not move to preloading, it will be moved at later stage
+                _tileCacheStatistics.recordHit();
                 return;
             }
+
+            if (preloadingTile && compactTileExists(tile)) {
+                _tileCacheStatistics.recordHit();
+                return; // already stored in encoded form, decoded once visible
+            }
         }
+        _tileCacheStatistics.recordMiss();
     
         auto task = std::make_shared<FetchTask>(std::static_pointer_cast<RasterTileLayer>(shared_from_this()), tile, preloadingTile);
         _fetchingTiles.add(tile.getTileId(), task);
@@ -207,6 +240,36 @@ namespace carto {
         refresh();
     }
 
+    void RasterTileLayer::tilesChanged(const MapBounds& bounds, int minZoom, int maxZoom, bool removeTiles) {
+        // Invalidate current tasks within the area
+        for (const std::shared_ptr<FetchTaskBase>& task : _fetchingTiles.getTasks()) {
+            if (isTileInArea(task->getTile(), bounds, minZoom, maxZoom)) {
+                task->invalidate();
+            }
+        }
+
+        // Flush cached tiles within the area, other tiles are kept valid
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            for (long long tileId : _visibleCache.keys()) {
+                if (isTileInArea(MapTile::FromTileId(tileId), bounds, minZoom, maxZoom)) {
+                    if (removeTiles) {
+                        _visibleCache.remove(tileId);
+                    } else {
+                        _visibleCache.invalidate(tileId, now);
+                    }
+                }
+            }
+            for (long long tileId : _preloadingCache.keys()) {
+                if (isTileInArea(MapTile::FromTileId(tileId), bounds, minZoom, maxZoom)) {
+                    _preloadingCache.remove(tileId);
+                }
+            }
+        }
+        refresh();
+    }
+
     vt::RasterFilterMode RasterTileLayer::getRasterFilterMode() const {
         std::lock_guard<std::recursive_mutex> lock(_mutex);
         switch (_tileFilterMode) {
@@ -300,6 +363,7 @@ namespace carto {
             if (_tileRenderer->refreshTiles(_tempDrawDatas)) {
                 refresh = true;
             }
+            submitTileLoadTraces(_tempDrawDatas);
         }
     
         if (refresh) {
@@ -403,6 +467,7 @@ namespace carto {
 
             _tileRenderer->setRasterFilterMode(getRasterFilterMode());
             bool refresh = _tileRenderer->onDrawFrame(deltaSeconds, viewState);
+            reportTileLoadTraces();
 
             if (opacity < 1.0f) {
                 mapRenderer->blendAndUnbindScreenFBO(opacity);
@@ -437,7 +502,7 @@ namespace carto {
     
         bool refresh = false;
         for (const MapTile& dataSourceTile : _dataSourceTiles) {
-            std::shared_ptr<TileData> tileData = layer->_dataSource->loadTile(dataSourceTile);
+            std::shared_ptr<TileData> tileData = loadDataSourceTile(layer, dataSourceTile);
             if (!tileData) {
                 break;
             }
@@ -447,11 +512,32 @@ namespace carto {
             if (!tileData->getData()) {
                 break;
             }
+            if (storeCompactTile(layer, dataSourceTile, tileData)) {
+                refresh = true;
+                break;
+            }
     
             // Save tile to texture cache, unless invalidated
             vt::TileId vtTile(_tile.getZoom(), _tile.getX(), _tile.getY());
             vt::TileId vtDataSourceTile(dataSourceTile.getZoom(), dataSourceTile.getX(), dataSourceTile.getY());
-            std::shared_ptr<Bitmap> bitmap = Bitmap::CreateFromCompressed(tileData->getData());
+            unsigned int maxTileSize = 0;
+            if (layer->isTileDownscaling()) {
+                if (std::shared_ptr<Options> options = layer->getOptions()) {
+                    // Keep enough resolution for the extracted sub tile when the data source tile is overzoomed
+                    int deltaZoom = _tile.getZoom() - dataSourceTile.getZoom();
+                    if (deltaZoom < 16) {
+                        float drawSize = options->getTileDrawSize() * options->getDPI() / Const::UNSCALED_DPI;
+                        maxTileSize = static_cast<unsigned int>(std::ceil(drawSize)) << deltaZoom;
+                    }
+                }
+            }
+            // Stop decoding once the task is canceled, the tile would be dropped anyway
+            std::shared_ptr<BinaryData> data = tileData->getData();
+            std::shared_ptr<Bitmap> bitmap = Bitmap::CreateFromCompressed(data->data(), data->size(), maxTileSize, maxTileSize, ColorFormat::COLOR_FORMAT_UNSUPPORTED, [this]() { return isCanceled(); });
+            traceTileDecoded();
+            if (isCanceled()) {
+                break;
+            }
             if (bitmap) {
                 // Check if we received the requested tile or extract/scale the corresponding part
                 if (dataSourceTile != _tile) {
@@ -499,7 +585,6 @@ namespace carto {
     }
 
     const int RasterTileLayer::DEFAULT_CULL_DELAY = 200;
-    const int RasterTileLayer::PRELOADING_PRIORITY_OFFSET = -2;
 
     const unsigned int RasterTileLayer::EXTRA_TILE_FOOTPRINT = 4096;
     const unsigned int RasterTileLayer::DEFAULT_PRELOADING_CACHE_SIZE = 10 * 1024 * 1024;
@@ -8,8 +8,10 @@
 #define _CARTO_RASTERTILELAYER_H_
 
 #include "core/MapTile.h"
+#include "core/CacheStatistics.h"
 #include "components/CancelableTask.h"
 #include "components/DirectorPtr.h"
+#include "components/ShardedTileCache.h"
 #include "components/Task.h"
 #include "layers/TileLayer.h"
 
@@ -17,8 +19,6 @@
 #include <memory>
 #include <map>
 
-#include <stdext/timed_lru_cache.h>
-
 #include <vt/Styles.h>
 
 namespace carto {
@@ -75,9 +75,17 @@ namespace carto {
          * whether or not preloading is enabled.
          * The default is 10MB, which should be enough for most use cases with preloading enabled. If preloading is
          * disabled, the cache size should be reduced by the user to conserve memory.
+         * If the global memory budget is set (see MapView.setMemoryBudget), the actual cache size may be smaller.
          * @param capacityInBytes The new tile bitmap cache capacity in bytes.
          */
         void setTextureCacheCapacity(std::size_t capacityInBytes);
+        /**
+         * Returns the usage statistics of the tile texture cache. The statistics include both visible and preloaded tiles.
+         * A request for a tile that is not in the cache is counted as a miss, the load time includes
+         * loading the tile from the data source and decoding it.
+         * @return The tile texture cache statistics.
+         */
+        CacheStatistics getTextureCacheStatistics() const;
     
         /**
          * Returns the current tile filter mode.
@@ -90,6 +98,19 @@ namespace carto {
          */
         void setTileFilterMode(RasterTileFilterMode::RasterTileFilterMode filterMode);
 
+        /**
+         * Returns the state of tile downscaling flag.
+         * @return True when tiles larger than the on-screen tile size are downscaled while decoding. The default is false.
+         */
+        bool isTileDownscaling() const;
+        /**
+         * Sets the state of tile downscaling flag. When enabled, tiles with higher resolution than needed for the current
+         * tile draw size and screen DPI are downscaled while decoding. This reduces decoding time and texture memory usage.
+         * The flag should not be enabled for layers that use pixel values as data, like HillshadeRasterTileLayer.
+         * @param enabled True if tiles should be downscaled.
+         */
+        void setTileDownscaling(bool enabled);
+
         /**
          * Returns the raster tile event listener.
          * @return The raster tile event listener.
@@ -118,6 +139,7 @@ namespace carto {
         virtual void fetchTile(const MapTile& mapTile, bool preloadingTile, bool invalidated);
         virtual void clearTiles(bool preloadingTiles);
         virtual void tilesChanged(bool removeTiles);
+        virtual void tilesChanged(const MapBounds& bounds, int minZoom, int maxZoom, bool removeTiles);
 
         virtual vt::RasterFilterMode getRasterFilterMode() const;
 
@@ -142,10 +164,10 @@ namespace carto {
         virtual void unregisterDataSourceListener();
 
         RasterTileFilterMode::RasterTileFilterMode _tileFilterMode;
+        bool _tileDownscaling;
 
     private:    
         static const int DEFAULT_CULL_DELAY;
-        static const int PRELOADING_PRIORITY_OFFSET;
 
         static const unsigned int EXTRA_TILE_FOOTPRINT;
         static const unsigned int DEFAULT_PRELOADING_CACHE_SIZE;
@@ -155,8 +177,8 @@ namespace carto {
         std::vector<long long> _visibleTileIds;
         std::vector<std::shared_ptr<TileDrawData> > _tempDrawDatas;
         
-        cache::timed_lru_cache<long long, std::shared_ptr<const vt::Tile> > _visibleCache;
-        cache::timed_lru_cache<long long, std::shared_ptr<const vt::Tile> > _preloadingCache;
+        ShardedTileCache<std::shared_ptr<const vt::Tile> > _visibleCache;
+        ShardedTileCache<std::shared_ptr<const vt::Tile> > _preloadingCache;
     };
     
 }
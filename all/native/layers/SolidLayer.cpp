@@ -85,6 +85,10 @@ namespace carto {
     void SolidLayer::loadData(const std::shared_ptr<CullState>& cullState) {
     }
 
+    bool SolidLayer::isCullStateInvariant(const CullState& lastCullState, const CullState& cullState) const {
+        return true; // the layer covers the whole view and has no data to load
+    }
+
     void SolidLayer::offsetLayerHorizontally(double offset) {
     }
     
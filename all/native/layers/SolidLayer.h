@@ -85,6 +85,7 @@ namespace carto {
                                    const std::weak_ptr<TouchHandler>& touchHandler);
         
         virtual void loadData(const std::shared_ptr<CullState>& cullState);
+        virtual bool isCullStateInvariant(const CullState& lastCullState, const CullState& cullState) const;
 
         virtual void offsetLayerHorizontally(double offset);
         
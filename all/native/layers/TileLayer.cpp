@@ -2,14 +2,17 @@
 #include "core/BinaryData.h"
 #include "components/Exceptions.h"
 #include "components/CancelableTask.h"
+#include "components/CancelableThreadPool.h"
 #include "datasources/components/TileData.h"
 #include "layers/TileLoadListener.h"
+#include "layers/TileLoadTraceListener.h"
 #include "layers/UTFGridEventListener.h"
 #include "layers/components/UTFGridTile.h"
 #include "projections/Projection.h"
 #include "projections/ProjectionSurface.h"
 #include "renderers/components/CullState.h"
 #include "renderers/components/RayIntersectedElement.h"
+#include "renderers/drawdatas/TileDrawData.h"
 #include "renderers/MapRenderer.h"
 #include "renderers/TileRenderer.h"
 #include "projections/Projection.h"
@@ -18,12 +21,17 @@
 #include "utils/Const.h"
 #include "utils/TileUtils.h"
 #include "utils/Log.h"
+#include "utils/TraceUtils.h"
+
+#include <unordered_set>
 
 #include <vt/TileTransformer.h>
 
 namespace carto {
 
     TileLayer::~TileLayer() {
+        _compactMemoryConsumer->detach();
+        _utfGridMemoryConsumer->detach();
     }
     
     std::shared_ptr<TileDataSource> TileLayer::getDataSource() const {
@@ -65,6 +73,57 @@ namespace carto {
         refresh();
     }
     
+    bool TileLayer::isPredictivePreloading() const {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return _predictivePreloading;
+    }
+    
+    void TileLayer::setPredictivePreloading(bool predictivePreloading) {
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            _predictivePreloading = predictivePreloading;
+        }
+        refresh();
+    }
+    
+    bool TileLayer::isCompactPreloading() const {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return _compactPreloading;
+    }
+    
+    void TileLayer::setCompactPreloading(bool compactPreloading) {
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            _compactPreloading = compactPreloading;
+        }
+        if (!compactPreloading) {
+            _compactPreloadingCache.clear();
+        }
+        refresh();
+    }
+    
+    float TileLayer::getMemoryWeight() const {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return _memoryConsumer ? _memoryConsumer->getWeight() : 1.0f;
+    }
+    
+    void TileLayer::setMemoryWeight(float weight) {
+        if (weight < 0) {
+            throw InvalidArgumentException("Negative memory weight");
+        }
+
+        std::shared_ptr<MemoryGovernor::Consumer> memoryConsumer;
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            memoryConsumer = _memoryConsumer;
+        }
+        if (memoryConsumer) {
+            memoryConsumer->setWeight(weight);
+        }
+        _compactMemoryConsumer->setWeight(weight);
+        _utfGridMemoryConsumer->setWeight(weight);
+    }
+    
     bool TileLayer::isSynchronizedRefresh() const {
         return _synchronizedRefresh;
     }
@@ -138,6 +197,7 @@ namespace carto {
     }
     
     void TileLayer::clearTileCaches(bool all) {
+        _compactPreloadingCache.clear();
         clearTiles(true);
         if (all) {
             clearTiles(false);
@@ -152,6 +212,20 @@ namespace carto {
         _tileLoadListener.set(tileLoadListener);
     }
 
+    std::shared_ptr<TileLoadTraceListener> TileLayer::getTileLoadTraceListener() const {
+        return _tileLoadTraceListener.get();
+    }
+    
+    void TileLayer::setTileLoadTraceListener(const std::shared_ptr<TileLoadTraceListener>& tileLoadTraceListener) {
+        _tileLoadTraceListener.set(tileLoadTraceListener);
+        if (!tileLoadTraceListener) {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            _tileLoadTraces.clear();
+            _submittedTileLoadTraces.clear();
+            _expiredTileLoadTraces.clear();
+        }
+    }
+
     std::shared_ptr<UTFGridEventListener> TileLayer::getUTFGridEventListener() const {
         return _utfGridEventListener.get();
     }
@@ -171,11 +245,25 @@ namespace carto {
         
     void TileLayer::DataSourceListener::onTilesChanged(bool removeTiles) {
         if (std::shared_ptr<TileLayer> layer = _layer.lock()) {
+            layer->_compactPreloadingCache.clear();
             layer->tilesChanged(removeTiles);
         } else {
             Log::Error("TileLayer::DataSourceListener: Lost connection to layer");
         }
     }
+
+    void TileLayer::DataSourceListener::onTilesChanged(const MapBounds& bounds, int minZoom, int maxZoom, bool removeTiles) {
+        if (std::shared_ptr<TileLayer> layer = _layer.lock()) {
+            for (long long tileId : layer->_compactPreloadingCache.keys()) {
+                if (layer->isTileInArea(MapTile::FromTileId(tileId), bounds, minZoom, maxZoom)) {
+                    layer->_compactPreloadingCache.remove(tileId);
+                }
+            }
+            layer->tilesChanged(bounds, minZoom, maxZoom, removeTiles);
+        } else {
+            Log::Error("TileLayer::DataSourceListener: Lost connection to layer");
+        }
+    }
         
     TileLayer::TileLayer(const std::shared_ptr<TileDataSource>& dataSource) :
         Layer(),
@@ -186,21 +274,37 @@ namespace carto {
         _dataSourceListener(),
         _utfGridDataSource(),
         _tileLoadListener(),
+        _tileLoadTraceListener(),
         _utfGridEventListener(),
         _fetchingTiles(),
+        _tileCacheStatistics(),
         _frameNr(0),
         _lastFrameNr(-1),
         _preloading(false),
+        _predictivePreloading(false),
+        _compactPreloading(false),
         _substitutionPolicy(TileSubstitutionPolicy::TILE_SUBSTITUTION_POLICY_ALL),
         _zoomLevelBias(0.0f),
         _maxOverzoomLevel(MAX_PARENT_SEARCH_DEPTH),
         _maxUnderzoomLevel(MAX_CHILD_SEARCH_DEPTH),
         _tileRenderer(std::make_shared<TileRenderer>()),
+        _memoryConsumer(),
         _visibleTiles(),
         _preloadingTiles(),
-        _utfGridTiles(),
-        _glResourceManager(),
-        _projectionSurface()
+        _predictedTiles(),
+        _visibleCacheLookups(),
+        _preloadingCacheLookups(),
+        _tileBoundingVolumes(),
+        _tileLoadTraces(),
+        _submittedTileLoadTraces(),
+        _expiredTileLoadTraces(),
+        _tileDebugInfos(),
+        _tileLoadTimes(),
+        _projectionSurface(),
+        _compactPreloadingCache(DEFAULT_COMPACT_PRELOADING_CACHE_SIZE),
+        _compactMemoryConsumer(),
+        _utfGridCache(DEFAULT_UTF_GRID_CACHE_SIZE),
+        _utfGridMemoryConsumer()
     {
         if (!dataSource) {
             throw NullArgumentException("Null dataSource");
@@ -211,6 +315,15 @@ namespace carto {
         }
 
         resetTileTransformer();
+
+        _compactMemoryConsumer = MemoryGovernor::GetInstance().registerConsumer(DEFAULT_COMPACT_PRELOADING_CACHE_SIZE, 1.0f,
+            [this](std::size_t budget) { _compactPreloadingCache.resize(budget); },
+            [this](bool critical) { _compactPreloadingCache.clear(); }
+        );
+        _utfGridMemoryConsumer = MemoryGovernor::GetInstance().registerConsumer(DEFAULT_UTF_GRID_CACHE_SIZE, 1.0f,
+            [this](std::size_t budget) { _utfGridCache.resize(budget); },
+            [this](bool critical) { if (critical) { _utfGridCache.clear(); } }
+        );
     }
     
     void TileLayer::setComponents(const std::shared_ptr<CancelableThreadPool>& envelopeThreadPool,
@@ -226,7 +339,6 @@ namespace carto {
         std::lock_guard<std::recursive_mutex> lock(_mutex);
         clearTileCaches(true);
         _projectionSurface.reset();
-        _glResourceManager.reset();
     }
 
     void TileLayer::loadData(const std::shared_ptr<CullState>& cullState) {
@@ -235,36 +347,38 @@ namespace carto {
 
         _calculatingTiles = true;
 
-        // Check if we need to invalidate caches
+        // Neighbouring tiles share parents and children, so cache lookups are memorized for the duration of this call
+        _visibleCacheLookups.clear();
+        _preloadingCacheLookups.clear();
+        _tileDebugInfos.clear();
+
+        // Check if we need to invalidate caches. The cached tiles keep their data in CPU memory, so they are kept after a GL context loss;
+        // the tile renderer is recreated with the new resource manager and simply uploads the current tiles again.
         std::shared_ptr<ProjectionSurface> projectionSurface;
-        std::shared_ptr<GLResourceManager> glResourceManager;
         if (auto mapRenderer = getMapRenderer()) {
             projectionSurface = mapRenderer->getProjectionSurface();
-            glResourceManager = mapRenderer->getGLResourceManager();
         }
-        if (_projectionSurface.lock() != projectionSurface || _glResourceManager.lock() != glResourceManager) {
+        if (_projectionSurface.lock() != projectionSurface) {
             clearTileCaches(true);
             resetTileTransformer();
             _projectionSurface = projectionSurface;
-            _glResourceManager = glResourceManager;
         }
 
         // Remove UTF grid tiles that are missing from the cache
-        for (auto it = _utfGridTiles.begin(); it != _utfGridTiles.end(); ) {
-            if (!tileExists(it->first, false) && !tileExists(it->first, true)) {
-                it = _utfGridTiles.erase(it);
-            } else {
-                it++;
+        for (long long tileId : _utfGridCache.keys()) {
+            UTFGridCacheEntry entry;
+            if (_utfGridCache.peek(tileId, entry) && !tileExists(entry.dataSourceTile, false) && !tileExists(entry.dataSourceTile, true)) {
+                _utfGridCache.remove(tileId);
             }
         }
     
-        // Cancel old tasks
-        for (const std::shared_ptr<FetchTaskBase>& task : _fetchingTiles.getTasks()) {
-            task->cancel();
-        }
-        
         // Check if layer should be drawn
         if (!isVisible() || !getVisibleZoomRange().inRange(cullState->getViewState().getZoom()) || getOpacity() <= 0) {
+            // Cancel old tasks
+            for (const std::shared_ptr<FetchTaskBase>& task : _fetchingTiles.getTasks()) {
+                task->cancel();
+            }
+
             _calculatingTiles = false;
 
             refreshDrawData(cullState);
@@ -275,9 +389,25 @@ namespace carto {
             // If the view has changed calculate new visible tiles, otherwise use the old ones
             calculateVisibleTiles(cullState);
         }
+
+        // Cancel old tasks that are not needed for the current view
+        updateFetchTasks();
     
         // Find replacements for visible tiles
         findTiles(_visibleTiles, false);
+
+        // Keep load times only for the visible tiles
+        std::unordered_set<long long> visibleFetchTileIds;
+        for (const MapTile& visTile : _visibleTiles) {
+            visibleFetchTileIds.insert(calculateFetchTile(visTile).getTileId());
+        }
+        for (auto it = _tileLoadTimes.begin(); it != _tileLoadTimes.end(); ) {
+            if (visibleFetchTileIds.count(it->first) == 0) {
+                it = _tileLoadTimes.erase(it);
+            } else {
+                it++;
+            }
+        }
     
         if (_preloading) {
             // Find replacements for preloading tiles
@@ -288,12 +418,22 @@ namespace carto {
             allTiles.insert(allTiles.end(), _preloadingTiles.begin(), _preloadingTiles.end());
             for (const MapTile& visTile : allTiles) {
                 if (visTile.getZoom() > 0) {
-                    int tileMask = (1 << visTile.getZoom()) - 1;
-                    MapTile tile(visTile.getX() & tileMask, visTile.getY() & tileMask, visTile.getZoom(), visTile.getFrameNr());
+                    MapTile tile = calculateFetchTile(visTile);
                     fetchTile(tile.getParent(), true, false);
                 }
             }
         }
+
+        // Fetch the tiles along the predicted camera trajectory, these are not drawn until they become visible
+        for (const MapTile& predictedTile : _predictedTiles) {
+            MapTile tile = calculateFetchTile(predictedTile);
+            if (!isTileCached(tile, true) && !isTileCached(tile, false)) {
+                fetchTile(tile, true, false);
+            }
+        }
+
+        // Reorder queued tasks based on the current view
+        reprioritizeFetchTasks(cullState->getViewState());
     
         _calculatingTiles = false;
         _refreshedTiles = true;
@@ -321,6 +461,60 @@ namespace carto {
         }
     }
     
+    void TileLayer::submitTileLoadTraces(const std::vector<std::shared_ptr<TileDrawData> >& drawDatas) {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+        if (_tileLoadTraces.empty()) {
+            return;
+        }
+
+        std::unordered_set<long long> tileIds;
+        for (const std::shared_ptr<TileDrawData>& drawData : drawDatas) {
+            tileIds.insert(drawData->getTileId());
+        }
+
+        std::chrono::steady_clock::time_point currentTime = std::chrono::steady_clock::now();
+        for (auto it = _tileLoadTraces.begin(); it != _tileLoadTraces.end(); ) {
+            // Tile map based layers use frame-independent tile ids in draw datas
+            const MapTile& tile = it->second.getTile();
+            if (tileIds.count(tile.getTileId()) > 0 || tileIds.count(MapTile(tile.getX(), tile.getY(), tile.getZoom(), 0).getTileId()) > 0) {
+                _submittedTileLoadTraces.push_back(it->second);
+                it = _tileLoadTraces.erase(it);
+            } else if (currentTime - it->second.getQueuedTime() > std::chrono::milliseconds(TILE_LOAD_TRACE_TIMEOUT)) {
+                _expiredTileLoadTraces.push_back(it->second);
+                it = _tileLoadTraces.erase(it);
+            } else {
+                it++;
+            }
+        }
+    }
+
+    void TileLayer::reportTileLoadTraces() {
+        DirectorPtr<TileLoadTraceListener> tileLoadTraceListener = _tileLoadTraceListener;
+
+        if (!tileLoadTraceListener) {
+            return;
+        }
+
+        std::vector<TileLoadTrace> submittedTileLoadTraces;
+        std::vector<TileLoadTrace> expiredTileLoadTraces;
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            std::swap(submittedTileLoadTraces, _submittedTileLoadTraces);
+            std::swap(expiredTileLoadTraces, _expiredTileLoadTraces);
+        }
+
+        // GL upload of the submitted tiles happens in the renderer during the frame, thus upload and draw share the timestamp
+        std::chrono::steady_clock::time_point currentTime = std::chrono::steady_clock::now();
+        for (TileLoadTrace& trace : submittedTileLoadTraces) {
+            trace.setDrawnTime(currentTime);
+            tileLoadTraceListener->onTileLoadTraced(trace);
+        }
+        for (const TileLoadTrace& trace : expiredTileLoadTraces) {
+            tileLoadTraceListener->onTileLoadTraced(trace);
+        }
+    }
+    
     void TileLayer::calculateRayIntersectedElements(const cglib::ray3<double>& ray, const ViewState& viewState, std::vector<RayIntersectedElement>& results) const {
         DirectorPtr<TileDataSource> utfGridDataSource = _utfGridDataSource;
 
@@ -348,10 +542,9 @@ namespace carto {
         for (MapTile flippedMapTile = calculateMapTile(mapPos, utfGridDataSource->getMaxZoom()).getFlipped(); true; flippedMapTile = flippedMapTile.getParent()) {
             if (std::abs(flippedMapTile.getZoom() - zoom) < std::abs(utfGridTileZoom - zoom)) {
                 if (tileExists(flippedMapTile, false) || tileExists(flippedMapTile, true)) {
-                    std::lock_guard<std::recursive_mutex> lock(_mutex);
-                    auto it = _utfGridTiles.find(flippedMapTile);
-                    if (it != _utfGridTiles.end()) {
-                        utfGridTile = it->second;
+                    UTFGridCacheEntry entry;
+                    if (_utfGridCache.read(flippedMapTile.getTileId(), entry)) {
+                        utfGridTile = entry.utfGridTile;
                         utfGridTileZoom = flippedMapTile.getZoom();
                     }
                 }
@@ -402,9 +595,10 @@ namespace carto {
     }
 
     void TileLayer::calculateVisibleTiles(const std::shared_ptr<CullState>& cullState) {
-        // Remove last visible and preloading tiles
+        // Remove last visible, preloading and predicted tiles
         _visibleTiles.clear();
         _preloadingTiles.clear();
+        _predictedTiles.clear();
 
         // Recursively calculate visible tiles
         calculateVisibleTilesRecursive(cullState, MapTile(0, 0, 0, _frameNr), _dataSource->getDataExtent());
@@ -420,6 +614,45 @@ namespace carto {
         
         sortTiles(_visibleTiles, cullState->getViewState(), false);
         sortTiles(_preloadingTiles, cullState->getViewState(), true);
+
+        if (_predictivePreloading) {
+            calculatePredictedTiles(cullState);
+        }
+    }
+
+    void TileLayer::calculatePredictedTiles(const std::shared_ptr<CullState>& cullState) {
+        std::shared_ptr<MapRenderer> mapRenderer = getMapRenderer();
+        if (!mapRenderer) {
+            return;
+        }
+
+        std::vector<ViewState> predictedViewStates = mapRenderer->calculatePredictedViewStates(PREDICTION_STEP_COUNT);
+        if (predictedViewStates.empty()) {
+            return;
+        }
+
+        std::unordered_set<MapTile> currentTiles(_visibleTiles.begin(), _visibleTiles.end());
+        currentTiles.insert(_preloadingTiles.begin(), _preloadingTiles.end());
+
+        // Calculate the tiles visible in the predicted views, reusing the visible tile calculation with the current tile lists swapped out
+        std::vector<MapTile> visibleTiles;
+        std::vector<MapTile> preloadingTiles;
+        std::swap(visibleTiles, _visibleTiles);
+        std::swap(preloadingTiles, _preloadingTiles);
+        for (const ViewState& predictedViewState : predictedViewStates) {
+            calculateVisibleTilesRecursive(std::make_shared<CullState>(cullState->getEnvelope(), predictedViewState), MapTile(0, 0, 0, _frameNr), _dataSource->getDataExtent());
+        }
+        std::vector<MapTile> predictedTiles;
+        std::swap(predictedTiles, _visibleTiles);
+        std::swap(visibleTiles, _visibleTiles);
+        std::swap(preloadingTiles, _preloadingTiles);
+
+        for (const MapTile& tile : predictedTiles) {
+            if (currentTiles.insert(tile).second) {
+                _predictedTiles.push_back(tile);
+            }
+        }
+        sortTiles(_predictedTiles, predictedViewStates.back(), true);
     }
 
     void TileLayer::calculateVisibleTilesRecursive(const std::shared_ptr<CullState>& cullState, const MapTile& tile, const MapBounds& dataExtent) {
@@ -436,8 +669,15 @@ namespace carto {
             return;
         }
         
-        cglib::bbox3<double> tileBounds = getTileTransformer()->calculateTileBBox(vt::TileId(tile.getZoom(), tile.getX(), tile.getY()));
-        cglib::vec3<double> tileCenter = tileBounds.center();
+        TileBoundingVolume boundingVolume = getTileBoundingVolume(tile);
+        const cglib::bbox3<double>& tileBounds = boundingVolume.bounds;
+        const cglib::vec3<double>& tileCenter = boundingVolume.center;
+
+        // On the globe, the tiles on the far side can be inside the frustum while hidden behind the horizon
+        if (cullState->isHiddenByHorizon(tileCenter, boundingVolume.radius * PRELOADING_TILE_SCALE)) {
+            return;
+        }
+
         cglib::bbox3<double> preloadingBounds(tileCenter + (tileBounds.min - tileCenter) * PRELOADING_TILE_SCALE, tileCenter + (tileBounds.max - tileCenter) * PRELOADING_TILE_SCALE);
 
         bool inPreloadingFrustum = visibleFrustum.inside(preloadingBounds);
@@ -473,6 +713,29 @@ namespace carto {
         }
     }
     
+    TileLayer::TileBoundingVolume TileLayer::getTileBoundingVolume(const MapTile& tile) {
+        // Seamless panning uses tiles outside of the world bounds, these share ids with the wrapped tiles and are not cached
+        bool cacheable = tile.getX() >= 0 && tile.getX() < (1 << tile.getZoom());
+        if (cacheable) {
+            auto it = _tileBoundingVolumes.find(tile.getTileId());
+            if (it != _tileBoundingVolumes.end()) {
+                return it->second;
+            }
+        }
+
+        TileBoundingVolume boundingVolume;
+        boundingVolume.bounds = getTileTransformer()->calculateTileBBox(vt::TileId(tile.getZoom(), tile.getX(), tile.getY()));
+        boundingVolume.center = boundingVolume.bounds.center();
+        boundingVolume.radius = cglib::length(boundingVolume.bounds.size()) * 0.5;
+        if (cacheable) {
+            if (_tileBoundingVolumes.size() >= MAX_TILE_BOUNDING_VOLUMES) {
+                _tileBoundingVolumes.clear();
+            }
+            _tileBoundingVolumes[tile.getTileId()] = boundingVolume;
+        }
+        return boundingVolume;
+    }
+
     void TileLayer::sortTiles(std::vector<MapTile>& tiles, const ViewState& viewState, bool preloadingTiles) {
         typedef std::pair<std::tuple<int, int, double>, MapTile> TaggedMapTile;
 
@@ -482,13 +745,13 @@ namespace carto {
         for (const MapTile& mapTile : tiles) {
             int parentSubstLevel = 0;
             MapTile parentTile = mapTile.getParent();
-            if (tileExists(parentTile, preloadingTiles) || tileExists(parentTile, !preloadingTiles)) {
+            if (isTileCached(parentTile, preloadingTiles) || isTileCached(parentTile, !preloadingTiles)) {
                 parentSubstLevel = 1;
             }
             int childSubstLevel = 0;
             for (int n = 0; n < 4; n++) {
                 MapTile subTile = mapTile.getChild(n);
-                if (tileExists(subTile, preloadingTiles) || tileExists(subTile, !preloadingTiles)) {
+                if (isTileCached(subTile, preloadingTiles) || isTileCached(subTile, !preloadingTiles)) {
                     childSubstLevel = 1;
                     break;
                 }
@@ -511,18 +774,82 @@ namespace carto {
         });
     }
     
+    void TileLayer::updateFetchTasks() {
+        // Tiles requested for the current view, the flag is true for preloading tiles. This must match the tiles fetched in loadData.
+        std::unordered_map<long long, bool> fetchTileIds;
+        for (const MapTile& visTile : _visibleTiles) {
+            MapTile tile = calculateFetchTile(visTile);
+            fetchTileIds[tile.getTileId()] = false;
+        }
+        if (_preloading) {
+            std::vector<MapTile> allTiles = _visibleTiles;
+            allTiles.insert(allTiles.end(), _preloadingTiles.begin(), _preloadingTiles.end());
+            for (const MapTile& visTile : allTiles) {
+                MapTile tile = calculateFetchTile(visTile);
+                fetchTileIds.insert({ tile.getTileId(), true });
+                if (tile.getZoom() > 0) {
+                    fetchTileIds.insert({ tile.getParent().getTileId(), true });
+                }
+            }
+        }
+        for (const MapTile& predictedTile : _predictedTiles) {
+            MapTile tile = calculateFetchTile(predictedTile);
+            fetchTileIds.insert({ tile.getTileId(), true });
+        }
+
+        // Keep the tasks that are still needed and update their preloading state, cancel the rest
+        for (const std::shared_ptr<FetchTaskBase>& task : _fetchingTiles.getTasks()) {
+            auto it = fetchTileIds.find(task->getTile().getTileId());
+            if (it != fetchTileIds.end()) {
+                task->setPreloading(it->second);
+            } else {
+                task->cancel();
+            }
+        }
+    }
+
+    void TileLayer::reprioritizeFetchTasks(const ViewState& viewState) {
+        std::shared_ptr<CancelableThreadPool> tileThreadPool = _tileThreadPool;
+        if (!tileThreadPool) {
+            return;
+        }
+
+        // Visible tiles are loaded before preloading tiles, tiles closer to the focus point are loaded first
+        std::unordered_map<const CancelableTask*, std::pair<int, double> > taskRanks;
+        for (const std::shared_ptr<FetchTaskBase>& task : _fetchingTiles.getTasks()) {
+            const MapTile& tile = task->getTile();
+            cglib::vec3<double> center = getTileTransformer()->calculateTileBBox(vt::TileId(tile.getZoom(), tile.getX(), tile.getY())).center();
+            double dist = cglib::length(center - viewState.getFocusPos());
+            int priority = task->isPreloading() ? getUpdatePriority() + PRELOADING_PRIORITY_OFFSET : getUpdatePriority();
+            taskRanks[task.get()] = std::make_pair(priority, dist);
+        }
+
+        tileThreadPool->reprioritize([&taskRanks](const std::shared_ptr<CancelableTask>& task, int& priority, double& rank) {
+            auto it = taskRanks.find(task.get());
+            if (it == taskRanks.end()) {
+                return false;
+            }
+            priority = it->second.first;
+            rank = it->second.second;
+            return true;
+        });
+    }
+    
     void TileLayer::findTiles(const std::vector<MapTile>& visTiles, bool preloadingTiles) {
         for (const MapTile& visTile : visTiles) {
-            int tileMask = (1 << visTile.getZoom()) - 1;
-            MapTile tile(visTile.getX() & tileMask, visTile.getY() & tileMask, visTile.getZoom(), visTile.getFrameNr());
+            MapTile tile = calculateFetchTile(visTile);
 
             // Check caches
-            if (tileExists(tile, preloadingTiles) || tileExists(tile, !preloadingTiles)) {
+            if (isTileCached(tile, preloadingTiles) || isTileCached(tile, !preloadingTiles)) {
                 calculateDrawData(visTile, tile, preloadingTiles);
+                if (!preloadingTiles) {
+                    _tileDebugInfos.emplace_back(visTile, TileDebugInfo::CACHED);
+                }
 
                 // Re-fetch invalid tile
                 if (!tileValid(tile, preloadingTiles) && !tileValid(tile, !preloadingTiles)) {
                     fetchTile(tile, preloadingTiles, true);
+                    forgetTileCached(tile);
                 }
                 continue;
             }
@@ -543,31 +870,111 @@ namespace carto {
             default:
                 break;
             }
+            TileDebugInfo::State debugState = TileDebugInfo::LOADING;
             for (bool preloadingCache : preloadingCaches) {
                 // Check for a tile with the last frame nr
                 MapTile prevFrameTile(tile.getX(), tile.getY(), tile.getZoom(), _lastFrameNr);
-                bool foundSubstitute = tileExists(prevFrameTile, preloadingCache);
+                bool foundSubstitute = isTileCached(prevFrameTile, preloadingCache);
 
                 if (foundSubstitute) {
                     calculateDrawData(visTile, prevFrameTile, preloadingTiles);
+                    debugState = TileDebugInfo::CACHED;
                 } else {
                     // Check cache for parent tile
                     if (tile.getZoom() > 0) {
                         foundSubstitute = findParentTile(visTile, tile, getMaxOverzoomLevel(), preloadingCache, preloadingTiles);
+                        debugState = TileDebugInfo::PARENT_SUBSTITUTE;
                     }
                     if (!foundSubstitute) {
                         // Didn't find parent tile, check cache for children tiles
                         foundSubstitute = findChildTiles(visTile, tile, getMaxUnderzoomLevel(), preloadingCache, preloadingTiles) > 0;
+                        debugState = TileDebugInfo::CHILD_SUBSTITUTE;
                     }
                 }
                 if (foundSubstitute) {
                     break;
                 }
+                debugState = TileDebugInfo::LOADING;
+            }
+            if (!preloadingTiles) {
+                _tileDebugInfos.emplace_back(visTile, debugState);
             }
     
             // Finally fetch the tile from source
             fetchTile(tile, preloadingTiles, false);
+            forgetTileCached(tile);
+        }
+    }
+
+    std::vector<TileLayer::TileDebugInfo> TileLayer::getTileDebugInfos() const {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+        std::vector<TileDebugInfo> tileDebugInfos = _tileDebugInfos;
+        for (TileDebugInfo& tileDebugInfo : tileDebugInfos) {
+            auto it = _tileLoadTimes.find(calculateFetchTile(tileDebugInfo.tile).getTileId());
+            if (it != _tileLoadTimes.end()) {
+                tileDebugInfo.loadTime = it->second;
+            }
+        }
+        return tileDebugInfos;
+    }
+
+    std::size_t TileLayer::getGPUMemoryUsage() const {
+        return _tileRenderer->getGPUMemoryUsage();
+    }
+
+    bool TileLayer::isOverzoomParentTileReused() const {
+        return false;
+    }
+
+    bool TileLayer::isTileInArea(const MapTile& tile, const MapBounds& bounds, int minZoom, int maxZoom) const {
+        // Overzoomed tiles are built from the data source tiles at the maximum zoom level of the data source
+        int dataSourceZoom = std::min(tile.getZoom(), _dataSource->getMaxZoom());
+        if (dataSourceZoom < minZoom || dataSourceZoom > maxZoom) {
+            return false;
+        }
+        int tileMask = (1 << tile.getZoom()) - 1;
+        MapTile flippedTile(tile.getX() & tileMask, tileMask - (tile.getY() & tileMask), tile.getZoom(), 0);
+        return calculateMapTileBounds(flippedTile).intersects(bounds);
+    }
+
+    MapTile TileLayer::calculateFetchTile(const MapTile& visTile) const {
+        int tileMask = (1 << visTile.getZoom()) - 1;
+        MapTile tile(visTile.getX() & tileMask, visTile.getY() & tileMask, visTile.getZoom(), visTile.getFrameNr());
+
+        // Use the data source tile directly instead of creating separate overzoomed tiles, if the layer supports this
+        if (isOverzoomParentTileReused()) {
+            int dataSourceMaxZoom = _dataSource->getMaxZoom();
+            while (tile.getZoom() > dataSourceMaxZoom && tile.getZoom() > 0) {
+                tile = tile.getParent();
+            }
         }
+        return tile;
+    }
+
+    bool TileLayer::compactTileExists(const MapTile& tile) const {
+        long long tileId = tile.getTileId();
+        return _compactPreloadingCache.exists(tileId) && _compactPreloadingCache.valid(tileId);
+    }
+
+    void TileLayer::storeCompactTile(const MapTile& tile, const MapTile& dataSourceTile, const std::shared_ptr<TileData>& tileData) {
+        // The stored tile is used by the next fetch task of the same tile instead of loading the tile from the data source
+        _compactPreloadingCache.put(tile.getTileId(), CompactTile(dataSourceTile, tileData), tileData->getData()->size() + EXTRA_COMPACT_TILE_FOOTPRINT);
+    }
+
+    bool TileLayer::isTileCached(const MapTile& tile, bool preloadingCache) {
+        std::unordered_map<long long, bool>& cacheLookups = (preloadingCache ? _preloadingCacheLookups : _visibleCacheLookups);
+        auto it = cacheLookups.find(tile.getTileId());
+        if (it == cacheLookups.end()) {
+            it = cacheLookups.emplace(tile.getTileId(), tileExists(tile, preloadingCache)).first;
+        }
+        return it->second;
+    }
+
+    void TileLayer::forgetTileCached(const MapTile& tile) {
+        // Fetching may move the tile between the caches
+        _visibleCacheLookups.erase(tile.getTileId());
+        _preloadingCacheLookups.erase(tile.getTileId());
     }
     
     bool TileLayer::findParentTile(const MapTile& visTile, const MapTile& tile, int depth, bool preloadingCache, bool preloadingTile) {
@@ -578,7 +985,7 @@ namespace carto {
         MapTile parentTile = tile.getParent();
         
         // Check the cache
-        if (tileExists(parentTile, preloadingCache)) {
+        if (isTileCached(parentTile, preloadingCache)) {
             calculateDrawData(visTile, parentTile, preloadingTile);
             return true;
         }
@@ -595,7 +1002,7 @@ namespace carto {
         int childTileCount = 0;
         for (int n = 0; n < 4; n++) {
             MapTile subTile = tile.getChild(n);
-            if (tileExists(subTile, preloadingCache)) {
+            if (isTileCached(subTile, preloadingCache)) {
                 calculateDrawData(visTile, subTile, preloadingTile);
                 childTileCount++;
             } else {
@@ -627,6 +1034,7 @@ namespace carto {
             tileTransformer = std::make_shared<vt::DefaultTileTransformer>(static_cast<float>(Const::WORLD_SIZE));
         }
         _tileRenderer->setTileTransformer(tileTransformer);
+        _tileBoundingVolumes.clear();
     }
 
     TileLayer::FetchTaskBase::FetchTaskBase(const std::shared_ptr<TileLayer>& layer, const MapTile& tile, bool preloadingTile) :
@@ -635,7 +1043,11 @@ namespace carto {
         _dataSourceTiles(),
         _preloadingTile(preloadingTile),
         _started(false),
-        _invalidated(false)
+        _invalidated(false),
+        _prefetching(false),
+        _prefetched(false),
+        _prefetchedTileData(),
+        _trace(tile, preloadingTile, std::chrono::steady_clock::now())
     {
         for (MapTile dataSourceTile = tile; true; ) {
             int zoom = dataSourceTile.getZoom();
@@ -649,9 +1061,20 @@ namespace carto {
         }
     }
     
+    const MapTile& TileLayer::FetchTaskBase::getTile() const {
+        return _tile;
+    }
+
     bool TileLayer::FetchTaskBase::isPreloading() const {
         return _preloadingTile;
     }
+
+    void TileLayer::FetchTaskBase::setPreloading(bool preloadingTile) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_started) {
+            _preloadingTile = preloadingTile;
+        }
+    }
     
     bool TileLayer::FetchTaskBase::isInvalidated() const {
         std::lock_guard<std::mutex> lock(_mutex);
@@ -662,12 +1085,16 @@ namespace carto {
         std::lock_guard<std::mutex> lock(_mutex);
         _invalidated = true;
     }
+
+    bool TileLayer::FetchTaskBase::isSpeculative() const {
+        return isPreloading();
+    }
         
     void TileLayer::FetchTaskBase::cancel() {
         std::lock_guard<std::mutex> lock(_mutex);
+        // If the task is already running, pending network requests of the task are aborted
+        _canceled = true;
         if (!_started) {
-            _canceled = true;
-                
             if (std::shared_ptr<TileLayer> layer = _layer.lock()) {
                 layer->_fetchingTiles.remove(_tile.getTileId());
             }
@@ -675,6 +1102,8 @@ namespace carto {
     }
         
     void TileLayer::FetchTaskBase::run() {
+        CARTO_TRACE_SECTION("TileLayer::FetchTask");
+
         std::shared_ptr<TileLayer> layer = _layer.lock();
         if (!layer) {
             return;
@@ -687,13 +1116,32 @@ namespace carto {
             }
             _started = true;
         }
+
+        // Preloading flag is fixed once the task is started
+        _trace = TileLoadTrace(_tile, _preloadingTile, _trace.getQueuedTime());
+        _trace.setStartedTime(std::chrono::steady_clock::now());
         
         bool refresh = false;
         try {
-            refresh = loadTile(layer) && !_preloadingTile;
+            prefetchTiles(layer);
+            bool loaded = loadTile(layer);
+            if (loaded) {
+                std::chrono::steady_clock::duration loadTime = std::chrono::steady_clock::now() - _trace.getStartedTime();
+                layer->_tileCacheStatistics.recordLoadTime(loadTime);
+
+                std::lock_guard<std::recursive_mutex> lock(layer->_mutex);
+                layer->_tileLoadTimes[_tile.getTileId()] = std::chrono::duration_cast<std::chrono::duration<float, std::milli> >(loadTime).count();
+            }
+            refresh = loaded && !_preloadingTile;
             if (refresh) {
                 loadUTFGridTile(layer);
             }
+
+            if (loaded && layer->_tileLoadTraceListener.get()) {
+                std::lock_guard<std::recursive_mutex> lock(layer->_mutex);
+                layer->_tileLoadTraces.erase(_tile.getTileId());
+                layer->_tileLoadTraces.emplace(_tile.getTileId(), _trace);
+            }
         }
         catch (const std::exception& ex) {
             Log::Errorf("TileLayer::FetchTaskBase: Exception while loading tile: %s", ex.what());
@@ -701,6 +1149,13 @@ namespace carto {
     
         layer->_fetchingTiles.remove(_tile.getTileId());
 
+        // If the task was canceled while running, the tile may be incomplete. Recalculate the tiles, so it is fetched again if still needed.
+        if (!refresh && isCanceled()) {
+            if (auto mapRenderer = layer->getMapRenderer()) {
+                mapRenderer->layerChanged(layer->shared_from_this(), false);
+            }
+        }
+
         if (refresh) {
             if (auto mapRenderer = layer->getMapRenderer()) {
                 mapRenderer->layerChanged(layer->shared_from_this(), false);
@@ -709,6 +1164,119 @@ namespace carto {
         }
     }
     
+    std::shared_ptr<TileData> TileLayer::FetchTaskBase::loadDataSourceTile(const std::shared_ptr<TileLayer>& layer, const MapTile& dataSourceTile) {
+        std::shared_ptr<TileData> tileData;
+        bool prefetched = false;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_prefetched && dataSourceTile == _dataSourceTiles.front()) {
+                _prefetched = false;
+                std::swap(tileData, _prefetchedTileData);
+                prefetched = true;
+            }
+        }
+        if (!prefetched && !isInvalidated()) {
+            // Promote the encoded preloading tile, if the same datasource tile was stored
+            TileLayer::CompactTile compactTile;
+            if (layer->_compactPreloadingCache.valid(_tile.getTileId()) && layer->_compactPreloadingCache.peek(_tile.getTileId(), compactTile)) {
+                if (compactTile.dataSourceTile == dataSourceTile) {
+                    if (!isPreloading()) {
+                        layer->_compactPreloadingCache.remove(_tile.getTileId());
+                    }
+                    tileData = compactTile.tileData;
+                    prefetched = true;
+                }
+            }
+        }
+        if (!prefetched) {
+            tileData = layer->_dataSource->loadTile(dataSourceTile);
+        }
+        if (tileData) {
+            _trace.setLoadedTime(std::chrono::steady_clock::now(), tileData->getCacheSource());
+        }
+        return tileData;
+    }
+
+    bool TileLayer::FetchTaskBase::storeCompactTile(const std::shared_ptr<TileLayer>& layer, const MapTile& dataSourceTile, const std::shared_ptr<TileData>& tileData) {
+        if (!isPreloading() || !layer->isCompactPreloading()) {
+            return false;
+        }
+
+        // Keep the tile in encoded form, it is decoded by a new fetch task once the tile becomes visible
+        if (!isInvalidated()) {
+            long long tileId = _tile.getTileId();
+            layer->_compactPreloadingCache.put(tileId, CompactTile(dataSourceTile, tileData), tileData->getData()->size() + EXTRA_COMPACT_TILE_FOOTPRINT);
+            if (tileData->getMaxAge() >= 0) {
+                layer->_compactPreloadingCache.invalidate(tileId, std::chrono::steady_clock::now() + std::chrono::milliseconds(tileData->getMaxAge()));
+            }
+        }
+        return true;
+    }
+
+    void TileLayer::FetchTaskBase::traceTileDecoded() {
+        _trace.setDecodedTime(std::chrono::steady_clock::now());
+    }
+
+    bool TileLayer::FetchTaskBase::claimPrefetch() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_started || _canceled || _prefetching || _dataSourceTiles.empty()) {
+            return false;
+        }
+        _prefetching = true;
+        return true;
+    }
+
+    void TileLayer::FetchTaskBase::setPrefetchedTileData(const std::shared_ptr<TileData>& tileData) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _prefetched = true;
+        _prefetchedTileData = tileData;
+    }
+
+    void TileLayer::FetchTaskBase::prefetchTiles(const std::shared_ptr<TileLayer>& layer) {
+        if (_dataSourceTiles.empty() || !layer->_dataSource->isBatchLoadingSupported()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_prefetching) {
+                return; // this task is already part of another batch
+            }
+            _prefetching = true;
+        }
+
+        // Load the first datasource tiles of the pending tasks with the same priority class in a single batch.
+        // The tasks will still be run separately, but will use the prefetched data instead of loading the tile.
+        std::vector<std::shared_ptr<FetchTaskBase> > batchTasks;
+        std::vector<MapTile> batchTiles;
+        batchTiles.push_back(_dataSourceTiles.front());
+        for (const std::shared_ptr<FetchTaskBase>& task : layer->_fetchingTiles.getTasks()) {
+            if (batchTiles.size() >= MAX_BATCH_TILES) {
+                break;
+            }
+            if (task.get() == this || task->isPreloading() != _preloadingTile) {
+                continue;
+            }
+            if (task->claimPrefetch()) {
+                batchTasks.push_back(task);
+                batchTiles.push_back(task->_dataSourceTiles.front());
+            }
+        }
+        if (batchTasks.empty()) {
+            return;
+        }
+
+        // The batch is shared with other tasks, so it must not be aborted if this task is canceled
+        const CancelableTask* currentTask = GetCurrentTask();
+        SetCurrentTask(nullptr);
+        std::vector<std::shared_ptr<TileData> > tileDatas = layer->_dataSource->loadTiles(batchTiles);
+        SetCurrentTask(currentTask);
+        tileDatas.resize(batchTiles.size());
+        setPrefetchedTileData(tileDatas[0]);
+        for (std::size_t i = 0; i < batchTasks.size(); i++) {
+            batchTasks[i]->setPrefetchedTileData(tileDatas[i + 1]);
+        }
+    }
+    
     bool TileLayer::FetchTaskBase::loadUTFGridTile(const std::shared_ptr<TileLayer>& tileLayer) {
         DirectorPtr<TileDataSource> dataSource = tileLayer->_utfGridDataSource;
 
@@ -738,8 +1306,7 @@ namespace carto {
 
             std::shared_ptr<UTFGridTile> utfTile = UTFGridTile::DecodeUTFTile(tileData->getData());
             if (utfTile) {
-                std::lock_guard<std::recursive_mutex> lock(tileLayer->_mutex);
-                tileLayer->_utfGridTiles[dataSourceTile] = utfTile; // we ignore expiration info here
+                tileLayer->_utfGridCache.put(dataSourceTile.getTileId(), UTFGridCacheEntry(dataSourceTile, utfTile), tileData->getData()->size()); // we ignore expiration info here
                 refresh = true;
             } else {
                 Log::Error("TileLayer::FetchTaskBase: Failed to decode UTF grid tile");
@@ -751,10 +1318,24 @@ namespace carto {
 
     const float TileLayer::DISCRETE_ZOOM_LEVEL_BIAS = 0.001f;
 
+    const int TileLayer::PRELOADING_PRIORITY_OFFSET = -2;
+
     const int TileLayer::MAX_PARENT_SEARCH_DEPTH = 6;
     const int TileLayer::MAX_CHILD_SEARCH_DEPTH = 3;
 
     const double TileLayer::PRELOADING_TILE_SCALE = 1.5;
+    const std::size_t TileLayer::MAX_TILE_BOUNDING_VOLUMES = 16384;
+    const int TileLayer::PREDICTION_STEP_COUNT = 2;
     const float TileLayer::SUBDIVISION_THRESHOLD = Const::WORLD_SIZE;
+
+    const int TileLayer::TILE_LOAD_TRACE_TIMEOUT = 30000;
+
+    const unsigned int TileLayer::EXTRA_COMPACT_TILE_FOOTPRINT = 256;
+
+    const unsigned int TileLayer::DEFAULT_COMPACT_PRELOADING_CACHE_SIZE = 16 * 1024 * 1024;
+
+    const unsigned int TileLayer::DEFAULT_UTF_GRID_CACHE_SIZE = 2 * 1024 * 1024;
+
+    const unsigned int TileLayer::FetchTaskBase::MAX_BATCH_TILES = 32;
     
 }
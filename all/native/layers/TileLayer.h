@@ -10,22 +10,31 @@
 #include "core/MapPos.h"
 #include "core/MapBounds.h"
 #include "core/MapTile.h"
+#include "components/CacheStatisticsCounter.h"
 #include "components/CancelableTask.h"
 #include "components/DirectorPtr.h"
+#include "components/MemoryGovernor.h"
+#include "components/ShardedTileCache.h"
 #include "datasources/TileDataSource.h"
 #include "layers/Layer.h"
 #include "layers/components/FetchingTileTasks.h"
+#include "layers/components/TileLoadTrace.h"
 
 #include <atomic>
 #include <unordered_map>
+#include <vector>
+
+#include <cglib/bbox.h>
 
 namespace carto {
     class CancelableTask;
     class CullState;
     class GLResourceManager;
     class ProjectionSurface;
+    class TileDrawData;
     class TileRenderer;
     class TileLoadListener;
+    class TileLoadTraceListener;
     class UTFGridTile;
     class UTFGridEventListener;
     namespace vt {
@@ -104,6 +113,47 @@ namespace carto {
          * @param preloading The new preloading state of the layer.
          */
         void setPreloading(bool preloading);
+
+        /**
+         * Returns the state of the predictive preloading flag of this layer.
+         * @return True if predictive preloading is enabled.
+         */
+        bool isPredictivePreloading() const;
+        /**
+         * Sets the state of predictive preloading for this layer. When enabled and the map is moving due to kinetic panning
+         * or an animation (for example, setFocusPos or setZoom with duration), tiles along the predicted camera trajectory
+         * and at the destination zoom level are downloaded with lower priority than the visible tiles.
+         * The default is false.
+         * @param predictivePreloading The new predictive preloading state of the layer.
+         */
+        void setPredictivePreloading(bool predictivePreloading);
+
+        /**
+         * Returns the state of the compact preloading flag of this layer.
+         * @return True if compact preloading is enabled.
+         */
+        bool isCompactPreloading() const;
+        /**
+         * Sets the state of compact preloading for this layer. When enabled, preloaded tiles are kept in
+         * their original encoded form and are decoded only when they become visible. This allows preloading
+         * a considerably larger area using the same amount of memory, at the cost of decoding the tiles later.
+         * The default is false.
+         * @param compactPreloading The new compact preloading state of the layer.
+         */
+        void setCompactPreloading(bool compactPreloading);
+
+        /**
+         * Returns the weight of the tile cache of this layer used when the global memory budget is shared between caches.
+         * @return The memory weight of the layer.
+         */
+        float getMemoryWeight() const;
+        /**
+         * Sets the weight of the tile cache of this layer used when the global memory budget is shared between caches.
+         * Layers with larger weights receive a proportionally larger part of the budget. Has no effect if the global memory budget is not set.
+         * The default is 1.
+         * @param weight The new memory weight of the layer. Must be non-negative.
+         */
+        void setMemoryWeight(float weight);
         
         /**
          * Returns the state of the synchronized refresh flag.
@@ -207,6 +257,17 @@ namespace carto {
          */
         void setTileLoadListener(const std::shared_ptr<TileLoadListener>& tileLoadListener);
 
+        /**
+         * Returns the tile load trace listener.
+         * @return The tile load trace listener.
+         */
+        std::shared_ptr<TileLoadTraceListener> getTileLoadTraceListener() const;
+        /**
+         * Sets the tile load trace listener. Tiles are traced only while the listener is set.
+         * @param tileLoadTraceListener The tile load trace listener.
+         */
+        void setTileLoadTraceListener(const std::shared_ptr<TileLoadTraceListener>& tileLoadTraceListener);
+
         /**
          * Returns the UTF grid event listener.
          * @return The UTF grid event listener.
@@ -221,11 +282,30 @@ namespace carto {
         virtual bool isUpdateInProgress() const;
         
     protected:
+        friend class DebugOverlayLayer;
+
+        // State of a visible tile, as resolved by the last cull
+        struct TileDebugInfo {
+            enum State {
+                LOADING, // no data available yet
+                CACHED, // the tile itself is drawn
+                PARENT_SUBSTITUTE, // a parent tile is drawn instead
+                CHILD_SUBSTITUTE // child tiles are drawn instead
+            };
+
+            MapTile tile;
+            State state;
+            float loadTime; // in milliseconds, negative if not known
+
+            TileDebugInfo(const MapTile& tile, State state) : tile(tile), state(state), loadTime(-1.0f) { }
+        };
+
         class DataSourceListener : public TileDataSource::OnChangeListener {
         public:
             explicit DataSourceListener(const std::shared_ptr<TileLayer>& layer);
             
             virtual void onTilesChanged(bool removeTiles);
+            virtual void onTilesChanged(const MapBounds& bounds, int minZoom, int maxZoom, bool removeTiles);
             
         private:
             std::weak_ptr<TileLayer> _layer;
@@ -235,25 +315,41 @@ namespace carto {
         public:
             FetchTaskBase(const std::shared_ptr<TileLayer>& layer, const MapTile& tile, bool preloadingTile);
             
+            const MapTile& getTile() const;
             bool isPreloading() const;
+            void setPreloading(bool preloadingTile);
             bool isInvalidated() const;
             void invalidate();
+            virtual bool isSpeculative() const;
             virtual void cancel();
             virtual void run();
             
         protected:
             virtual bool loadTile(const std::shared_ptr<TileLayer>& layer) = 0;
+
+            std::shared_ptr<TileData> loadDataSourceTile(const std::shared_ptr<TileLayer>& layer, const MapTile& dataSourceTile);
+            bool storeCompactTile(const std::shared_ptr<TileLayer>& layer, const MapTile& dataSourceTile, const std::shared_ptr<TileData>& tileData);
+            void traceTileDecoded();
             
             std::weak_ptr<TileLayer> _layer;
             MapTile _tile; // original tile
             std::vector<MapTile> _dataSourceTiles; // tiles in valid datasource range, ordered to top
 
         private:
+            static const unsigned int MAX_BATCH_TILES;
+
+            bool claimPrefetch();
+            void setPrefetchedTileData(const std::shared_ptr<TileData>& tileData);
+            void prefetchTiles(const std::shared_ptr<TileLayer>& layer);
             bool loadUTFGridTile(const std::shared_ptr<TileLayer>& layer);
 
-            bool _preloadingTile;
+            std::atomic<bool> _preloadingTile; // can be changed only before the task is started
             bool _started;
             bool _invalidated;
+            bool _prefetching; // the first datasource tile is loaded by another task in a batch
+            bool _prefetched;
+            std::shared_ptr<TileData> _prefetchedTileData;
+            TileLoadTrace _trace;
         };
         
         explicit TileLayer(const std::shared_ptr<TileDataSource>& dataSource);
@@ -268,18 +364,33 @@ namespace carto {
 
         virtual void updateTileLoadListener();
 
+        void submitTileLoadTraces(const std::vector<std::shared_ptr<TileDrawData> >& drawDatas);
+        void reportTileLoadTraces();
+
         virtual bool tileExists(const MapTile& tile, bool preloadingCache) const = 0;
         virtual bool tileValid(const MapTile& tile, bool preloadingCache) const = 0;
         virtual void fetchTile(const MapTile& tile, bool preloadingTile, bool invalidated) = 0;
         virtual void clearTiles(bool preloadingTiles) = 0;
         virtual void tilesChanged(bool removeTiles) = 0;
+        virtual void tilesChanged(const MapBounds& bounds, int minZoom, int maxZoom, bool removeTiles) = 0;
+        bool isTileInArea(const MapTile& tile, const MapBounds& bounds, int minZoom, int maxZoom) const;
+
+        virtual bool isOverzoomParentTileReused() const;
+        MapTile calculateFetchTile(const MapTile& visTile) const;
 
         virtual void calculateDrawData(const MapTile& visTile, const MapTile& closestTile, bool preloadingTile) = 0;
+
+        bool compactTileExists(const MapTile& tile) const;
+        void storeCompactTile(const MapTile& tile, const MapTile& dataSourceTile, const std::shared_ptr<TileData>& tileData);
         virtual void refreshDrawData(const std::shared_ptr<CullState>& cullState) = 0;
         
         virtual int getMinZoom() const = 0;
         virtual int getMaxZoom() const = 0;
         virtual std::vector<long long> getVisibleTileIds() const = 0;
+
+        std::vector<TileDebugInfo> getTileDebugInfos() const;
+
+        virtual std::size_t getGPUMemoryUsage() const;
         
         virtual void calculateRayIntersectedElements(const cglib::ray3<double>& ray, const ViewState& viewState, std::vector<RayIntersectedElement>& results) const;
         virtual bool processClick(ClickType::ClickType clickType, const RayIntersectedElement& intersectedElement, const ViewState& viewState) const;
@@ -291,6 +402,8 @@ namespace carto {
 
         static const float DISCRETE_ZOOM_LEVEL_BIAS;
 
+        static const int PRELOADING_PRIORITY_OFFSET;
+
         std::atomic<bool> _synchronizedRefresh;
 
         std::atomic<bool> _calculatingTiles;
@@ -302,15 +415,21 @@ namespace carto {
         ThreadSafeDirectorPtr<TileDataSource> _utfGridDataSource;
         
         ThreadSafeDirectorPtr<TileLoadListener> _tileLoadListener;
+
+        ThreadSafeDirectorPtr<TileLoadTraceListener> _tileLoadTraceListener;
     
         ThreadSafeDirectorPtr<UTFGridEventListener> _utfGridEventListener;
 
         FetchingTileTasks<FetchTaskBase> _fetchingTiles;
+
+        CacheStatisticsCounter _tileCacheStatistics; // hits and misses are recorded by subclasses in fetchTile
         
         int _frameNr;
         int _lastFrameNr;
     
         bool _preloading;
+        bool _predictivePreloading;
+        bool _compactPreloading;
         
         TileSubstitutionPolicy::TileSubstitutionPolicy _substitutionPolicy;
     
@@ -319,28 +438,81 @@ namespace carto {
         int _maxUnderzoomLevel;
 
         std::shared_ptr<TileRenderer> _tileRenderer;
-    
+
+        std::shared_ptr<MemoryGovernor::Consumer> _memoryConsumer; // registered by subclasses, must be detached in subclass destructors
+
     private:
+        struct CompactTile {
+            MapTile dataSourceTile;
+            std::shared_ptr<TileData> tileData;
+
+            CompactTile() : dataSourceTile(), tileData() { }
+            CompactTile(const MapTile& dataSourceTile, const std::shared_ptr<TileData>& tileData) : dataSourceTile(dataSourceTile), tileData(tileData) { }
+        };
+
+        struct UTFGridCacheEntry {
+            MapTile dataSourceTile;
+            std::shared_ptr<UTFGridTile> utfGridTile;
+
+            UTFGridCacheEntry() : dataSourceTile(), utfGridTile() { }
+            UTFGridCacheEntry(const MapTile& dataSourceTile, const std::shared_ptr<UTFGridTile>& utfGridTile) : dataSourceTile(dataSourceTile), utfGridTile(utfGridTile) { }
+        };
+
         void calculateVisibleTiles(const std::shared_ptr<CullState>& cullState);
         void calculateVisibleTilesRecursive(const std::shared_ptr<CullState>& cullState, const MapTile& mapTile, const MapBounds& dataExtent);
+        struct TileBoundingVolume {
+            cglib::bbox3<double> bounds;
+            cglib::vec3<double> center;
+            double radius;
+        };
+
+        void calculatePredictedTiles(const std::shared_ptr<CullState>& cullState);
+        TileBoundingVolume getTileBoundingVolume(const MapTile& tile);
 
         void sortTiles(std::vector<MapTile>& tiles, const ViewState& viewState, bool preloadingTiles);
+        void updateFetchTasks();
+        void reprioritizeFetchTasks(const ViewState& viewState);
         void findTiles(const std::vector<MapTile>& visTiles, bool preloadingTiles);
         bool findParentTile(const MapTile& visTile, const MapTile& tile, int depth, bool preloadingCache, bool preloadingTile);
         int findChildTiles(const MapTile& visTile, const MapTile& tile, int depth, bool preloadingCache, bool preloadingTile);
+        bool isTileCached(const MapTile& tile, bool preloadingCache);
+        void forgetTileCached(const MapTile& tile);
     
         static const int MAX_PARENT_SEARCH_DEPTH;
         static const int MAX_CHILD_SEARCH_DEPTH;
         
         static const double PRELOADING_TILE_SCALE;
+        static const std::size_t MAX_TILE_BOUNDING_VOLUMES;
+        static const int PREDICTION_STEP_COUNT;
         static const float SUBDIVISION_THRESHOLD;
-        
+
+        static const int TILE_LOAD_TRACE_TIMEOUT;
+
+        static const unsigned int EXTRA_COMPACT_TILE_FOOTPRINT;
+        static const unsigned int DEFAULT_COMPACT_PRELOADING_CACHE_SIZE;
+        static const unsigned int DEFAULT_UTF_GRID_CACHE_SIZE;
+
         std::vector<MapTile> _visibleTiles;
         std::vector<MapTile> _preloadingTiles;
-        std::unordered_map<MapTile, std::shared_ptr<UTFGridTile> > _utfGridTiles;
+        std::vector<MapTile> _predictedTiles; // fetched with preloading priority, but never drawn
+        std::unordered_map<long long, bool> _visibleCacheLookups; // results of tileExists calls during the current loadData call
+        std::unordered_map<long long, bool> _preloadingCacheLookups;
+        std::unordered_map<long long, TileBoundingVolume> _tileBoundingVolumes; // tile transformer bounds, cleared when the transformer changes
+
+        std::unordered_map<long long, TileLoadTrace> _tileLoadTraces; // loaded tiles waiting to be drawn
+        std::vector<TileLoadTrace> _submittedTileLoadTraces; // tiles submitted to the renderer, reported after the next frame
+        std::vector<TileLoadTrace> _expiredTileLoadTraces; // tiles not drawn within the timeout
+
+        std::vector<TileDebugInfo> _tileDebugInfos; // states of the visible tiles
+        std::unordered_map<long long, float> _tileLoadTimes; // load times of the visible fetch tiles, in milliseconds
 
-        std::weak_ptr<GLResourceManager> _glResourceManager;
         std::weak_ptr<ProjectionSurface> _projectionSurface;
+
+        ShardedTileCache<CompactTile> _compactPreloadingCache; // encoded preloading tiles, keyed by fetch tile id
+        std::shared_ptr<MemoryGovernor::Consumer> _compactMemoryConsumer;
+
+        ShardedTileCache<UTFGridCacheEntry> _utfGridCache; // decoded UTF grid tiles, keyed by datasource tile id
+        std::shared_ptr<MemoryGovernor::Consumer> _utfGridMemoryConsumer;
     };
     
 }
@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_TILELOADTRACELISTENER_H_
+#define _CARTO_TILELOADTRACELISTENER_H_
+
+namespace carto {
+    class TileLoadTrace;
+
+    /**
+     * Interface for tracing individual tiles through the tile loading pipeline.
+     */
+    class TileLoadTraceListener {
+    public:
+        virtual ~TileLoadTraceListener() { }
+
+        /**
+         * Listener method that gets called once the traced tile has been drawn for the first time,
+         * or when the tile was not drawn within the tracing timeout (for example, preloading tiles).
+         * This method is called from the GL thread, implementations should return quickly.
+         * @param trace The completed tile trace.
+         */
+        virtual void onTileLoadTraced(const TileLoadTrace& trace) = 0;
+    };
+
+}
+
+#endif
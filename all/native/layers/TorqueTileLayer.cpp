@@ -42,12 +42,19 @@ namespace carto {
             if (std::shared_ptr<mvt::Map::Settings> mapSettings = getTileDecoder()->getMapSettings()) {
                 backgroundColor = Color(mapSettings->backgroundColor.value());
             }
-            mapRenderer->clearAndBindScreenFBO(backgroundColor, false, false);
+            // The offscreen pass is only needed for the background color or for partial opacity
+            bool screenFBO = opacity < 1.0f || backgroundColor.getA() != 0;
+            if (screenFBO) {
+                mapRenderer->clearAndBindScreenFBO(backgroundColor, false, false);
+            }
 
             _tileRenderer->setSubTileBlending(false);
             bool refresh = _tileRenderer->onDrawFrame(deltaSeconds, viewState);
+            reportTileLoadTraces();
 
-            mapRenderer->blendAndUnbindScreenFBO(opacity);
+            if (screenFBO) {
+                mapRenderer->blendAndUnbindScreenFBO(opacity);
+            }
 
             return refresh;
         }
@@ -16,6 +16,8 @@ namespace carto {
 
     /**
      * A vector tile layer for rendering time-based animated point clouds.
+     * All frames of a tile are decoded together and cached under a single tile id,
+     * so changing the frame number does not load or decode tiles again.
      */
     class TorqueTileLayer : public VectorTileLayer {
     public:
@@ -16,6 +16,7 @@
 #include "renderers/PolygonRenderer.h"
 #include "renderers/components/CullState.h"
 #include "renderers/components/RayIntersectedElement.h"
+#include "renderers/drawdatas/DrawDataPool.h"
 #include "renderers/drawdatas/GeometryCollectionDrawData.h"
 #include "renderers/drawdatas/LabelDrawData.h"
 #include "renderers/drawdatas/LineDrawData.h"
@@ -37,6 +38,7 @@
 #include "ui/VectorElementClickInfo.h"
 #include "utils/Log.h"
 
+#include <algorithm>
 #include <vector>
 
 namespace carto {
@@ -270,6 +272,94 @@ namespace carto {
         }
     }
     
+    void VectorLayer::refreshElements(const std::vector<std::shared_ptr<VectorElement> >& elements, const std::vector<std::shared_ptr<VectorElement> >& removedElements) {
+        bool billboardsChanged = false;
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+            if (!_lastCullState) {
+                return;
+            }
+            
+            const ViewState& viewState = _lastCullState->getViewState();
+            for (const std::shared_ptr<VectorElement>& element : removedElements) {
+                billboardsChanged = syncRendererElement(element, viewState, true) || billboardsChanged;
+            }
+            for (const std::shared_ptr<VectorElement>& element : elements) {
+                billboardsChanged = syncRendererElement(element, viewState, false) || billboardsChanged;
+            }
+            
+            if (!isVisible() || !getVisibleZoomRange().inRange(viewState.getZoom()) || getOpacity() <= 0) {
+                return;
+            }
+        }
+
+        if (auto mapRenderer = getMapRenderer()) {
+            if (billboardsChanged) {
+                mapRenderer->billboardsChanged();
+            }
+            mapRenderer->requestRedraw();
+        }
+    }
+    
+    std::shared_ptr<VectorElementDrawData> VectorLayer::getRendererElementDrawData(const std::shared_ptr<VectorElement>& element) const {
+        if (const std::shared_ptr<Billboard>& billboard = std::dynamic_pointer_cast<Billboard>(element)) {
+            return billboard->getDrawData();
+        } else if (const std::shared_ptr<Line>& line = std::dynamic_pointer_cast<Line>(element)) {
+            return line->getDrawData();
+        } else if (const std::shared_ptr<Point>& point = std::dynamic_pointer_cast<Point>(element)) {
+            return point->getDrawData();
+        } else if (const std::shared_ptr<Polygon>& polygon = std::dynamic_pointer_cast<Polygon>(element)) {
+            return polygon->getDrawData();
+        } else if (const std::shared_ptr<GeometryCollection>& geomCollection = std::dynamic_pointer_cast<GeometryCollection>(element)) {
+            return geomCollection->getDrawData();
+        } else if (const std::shared_ptr<Polygon3D>& polygon3D = std::dynamic_pointer_cast<Polygon3D>(element)) {
+            return polygon3D->getDrawData();
+        } else if (const std::shared_ptr<NMLModel>& nmlModel = std::dynamic_pointer_cast<NMLModel>(element)) {
+            return nmlModel->getDrawData();
+        }
+        return std::shared_ptr<VectorElementDrawData>();
+    }
+
+    std::shared_ptr<VectorElementDrawData> VectorLayer::createRendererElementDrawData(const std::shared_ptr<VectorElement>& element, const std::shared_ptr<ProjectionSurface>& projectionSurface) const {
+        // Only geometry based draw datas are created here, labels and popups depend on the layer state and are created in addRendererElement
+        if (const std::shared_ptr<Line>& line = std::dynamic_pointer_cast<Line>(element)) {
+            return DrawDataPool::Create<LineDrawData>(*line->getGeometry(), *line->getStyle(), *_dataSource->getProjection(), projectionSurface);
+        } else if (const std::shared_ptr<Marker>& marker = std::dynamic_pointer_cast<Marker>(element)) {
+            return DrawDataPool::Create<MarkerDrawData>(*marker, *marker->getStyle(), *_dataSource->getProjection(), projectionSurface);
+        } else if (const std::shared_ptr<Point>& point = std::dynamic_pointer_cast<Point>(element)) {
+            return DrawDataPool::Create<PointDrawData>(*point->getGeometry(), *point->getStyle(), *_dataSource->getProjection(), projectionSurface);
+        } else if (const std::shared_ptr<Polygon>& polygon = std::dynamic_pointer_cast<Polygon>(element)) {
+            return DrawDataPool::Create<PolygonDrawData>(*polygon->getGeometry(), *polygon->getStyle(), *_dataSource->getProjection(), projectionSurface);
+        } else if (const std::shared_ptr<GeometryCollection>& geomCollection = std::dynamic_pointer_cast<GeometryCollection>(element)) {
+            return DrawDataPool::Create<GeometryCollectionDrawData>(*geomCollection->getGeometry(), *geomCollection->getStyle(), *_dataSource->getProjection(), projectionSurface);
+        } else if (const std::shared_ptr<Polygon3D>& polygon3D = std::dynamic_pointer_cast<Polygon3D>(element)) {
+            return DrawDataPool::Create<Polygon3DDrawData>(*polygon3D, *polygon3D->getStyle(), *_dataSource->getProjection(), projectionSurface);
+        } else if (const std::shared_ptr<NMLModel>& nmlModel = std::dynamic_pointer_cast<NMLModel>(element)) {
+            return DrawDataPool::Create<NMLModelDrawData>(*nmlModel, *nmlModel->getStyle(), *_dataSource->getProjection(), projectionSurface);
+        }
+        return std::shared_ptr<VectorElementDrawData>();
+    }
+
+    void VectorLayer::setRendererElementDrawData(const std::shared_ptr<VectorElement>& element, const std::shared_ptr<VectorElementDrawData>& drawData) const {
+        // The draw data must be created by createRendererElementDrawData for the same element
+        if (const std::shared_ptr<Marker>& marker = std::dynamic_pointer_cast<Marker>(element)) {
+            marker->setDrawData(std::static_pointer_cast<MarkerDrawData>(drawData));
+        } else if (const std::shared_ptr<Line>& line = std::dynamic_pointer_cast<Line>(element)) {
+            line->setDrawData(std::static_pointer_cast<LineDrawData>(drawData));
+        } else if (const std::shared_ptr<Point>& point = std::dynamic_pointer_cast<Point>(element)) {
+            point->setDrawData(std::static_pointer_cast<PointDrawData>(drawData));
+        } else if (const std::shared_ptr<Polygon>& polygon = std::dynamic_pointer_cast<Polygon>(element)) {
+            polygon->setDrawData(std::static_pointer_cast<PolygonDrawData>(drawData));
+        } else if (const std::shared_ptr<GeometryCollection>& geomCollection = std::dynamic_pointer_cast<GeometryCollection>(element)) {
+            geomCollection->setDrawData(std::static_pointer_cast<GeometryCollectionDrawData>(drawData));
+        } else if (const std::shared_ptr<Polygon3D>& polygon3D = std::dynamic_pointer_cast<Polygon3D>(element)) {
+            polygon3D->setDrawData(std::static_pointer_cast<Polygon3DDrawData>(drawData));
+        } else if (const std::shared_ptr<NMLModel>& nmlModel = std::dynamic_pointer_cast<NMLModel>(element)) {
+            nmlModel->setDrawData(std::static_pointer_cast<NMLModelDrawData>(drawData));
+        }
+    }
+
     void VectorLayer::addRendererElement(const std::shared_ptr<VectorElement>& element, const ViewState& viewState) {
         if (!element->isVisible()) {
             return;
@@ -281,54 +371,45 @@ namespace carto {
         }
 
         if (const std::shared_ptr<Label>& label = std::dynamic_pointer_cast<Label>(element)) {
-            if (!label->getDrawData() || label->getDrawData()->isOffset() || label->getDrawData()->getProjectionSurface() != projectionSurface) {
-                label->setDrawData(std::make_shared<LabelDrawData>(*label, *label->getStyle(), *_dataSource->getProjection(), projectionSurface, _lastCullState->getViewState()));
+            if (IsDrawDataOutdated(label->getDrawData(), projectionSurface)) {
+                label->setDrawData(DrawDataPool::Create<LabelDrawData>(*label, *label->getStyle(), *_dataSource->getProjection(), projectionSurface, _lastCullState->getViewState()));
             }
             _billboardRenderer->addElement(label);
-        } else if (const std::shared_ptr<Line>& line = std::dynamic_pointer_cast<Line>(element)) {
-            if (!line->getDrawData() || line->getDrawData()->isOffset() || line->getDrawData()->getProjectionSurface() != projectionSurface) {
-                line->setDrawData(std::make_shared<LineDrawData>(*line->getGeometry(), *line->getStyle(), *_dataSource->getProjection(), projectionSurface));
+            return;
+        } else if (const std::shared_ptr<Popup>& popup = std::dynamic_pointer_cast<Popup>(element)) {
+            if (IsDrawDataOutdated(popup->getDrawData(), projectionSurface)) {
+                if (auto options = getOptions()) {
+                    popup->setDrawData(DrawDataPool::Create<PopupDrawData>(*popup, *popup->getStyle(), *_dataSource->getProjection(), projectionSurface, options, _lastCullState->getViewState()));
+                } else {
+                    return;
+                }
+            }
+            _billboardRenderer->addElement(popup);
+            return;
+        }
+
+        if (IsDrawDataOutdated(getRendererElementDrawData(element), projectionSurface)) {
+            std::shared_ptr<VectorElementDrawData> drawData = createRendererElementDrawData(element, projectionSurface);
+            if (!drawData) {
+                return;
             }
+            setRendererElementDrawData(element, drawData);
+        }
+
+        if (const std::shared_ptr<Line>& line = std::dynamic_pointer_cast<Line>(element)) {
             _lineRenderer->addElement(line);
         } else if (const std::shared_ptr<Marker>& marker = std::dynamic_pointer_cast<Marker>(element)) {
-            if (!marker->getDrawData() || marker->getDrawData()->isOffset() || marker->getDrawData()->getProjectionSurface() != projectionSurface) {
-                marker->setDrawData(std::make_shared<MarkerDrawData>(*marker, *marker->getStyle(), *_dataSource->getProjection(), projectionSurface));
-            }
             _billboardRenderer->addElement(marker);
         } else if (const std::shared_ptr<Point>& point = std::dynamic_pointer_cast<Point>(element)) {
-            if (!point->getDrawData() || point->getDrawData()->isOffset() || point->getDrawData()->getProjectionSurface() != projectionSurface) {
-                point->setDrawData(std::make_shared<PointDrawData>(*point->getGeometry(), *point->getStyle(), *_dataSource->getProjection(), projectionSurface));
-            }
             _pointRenderer->addElement(point);
         } else if (const std::shared_ptr<Polygon>& polygon = std::dynamic_pointer_cast<Polygon>(element)) {
-            if (!polygon->getDrawData() || polygon->getDrawData()->isOffset() || polygon->getDrawData()->getProjectionSurface() != projectionSurface) {
-                polygon->setDrawData(std::make_shared<PolygonDrawData>(*polygon->getGeometry(), *polygon->getStyle(), *_dataSource->getProjection(), projectionSurface));
-            }
             _polygonRenderer->addElement(polygon);
         } else if (const std::shared_ptr<GeometryCollection>& geomCollection = std::dynamic_pointer_cast<GeometryCollection>(element)) {
-            if (!geomCollection->getDrawData() || geomCollection->getDrawData()->isOffset() || geomCollection->getDrawData()->getProjectionSurface() != projectionSurface) {
-                geomCollection->setDrawData(std::make_shared<GeometryCollectionDrawData>(*geomCollection->getGeometry(), *geomCollection->getStyle(), *_dataSource->getProjection(), projectionSurface));
-            }
             _geometryCollectionRenderer->addElement(geomCollection);
         } else if (const std::shared_ptr<Polygon3D>& polygon3D = std::dynamic_pointer_cast<Polygon3D>(element)) {
-            if (!polygon3D->getDrawData() || polygon3D->getDrawData()->isOffset() || polygon3D->getDrawData()->getProjectionSurface() != projectionSurface) {
-                polygon3D->setDrawData(std::make_shared<Polygon3DDrawData>(*polygon3D, *polygon3D->getStyle(), *_dataSource->getProjection(), projectionSurface));
-            }
             _polygon3DRenderer->addElement(polygon3D);
         } else if (const std::shared_ptr<NMLModel>& nmlModel = std::dynamic_pointer_cast<NMLModel>(element)) {
-            if (!nmlModel->getDrawData() || nmlModel->getDrawData()->isOffset() || nmlModel->getDrawData()->getProjectionSurface() != projectionSurface) {
-                nmlModel->setDrawData(std::make_shared<NMLModelDrawData>(*nmlModel, *nmlModel->getStyle(), *_dataSource->getProjection(), projectionSurface));
-            }
             _nmlModelRenderer->addElement(nmlModel);
-        } else if (const std::shared_ptr<Popup>& popup = std::dynamic_pointer_cast<Popup>(element)) {
-            if (!popup->getDrawData() || popup->getDrawData()->isOffset() || popup->getDrawData()->getProjectionSurface() != projectionSurface) {
-                if (auto options = getOptions()) {
-                    popup->setDrawData(std::make_shared<PopupDrawData>(*popup, *popup->getStyle(), *_dataSource->getProjection(), projectionSurface, options, _lastCullState->getViewState()));
-                } else {
-                    return;
-                }
-            }
-            _billboardRenderer->addElement(popup);
         }
     }
     
@@ -359,7 +440,7 @@ namespace carto {
         // Update/remove the draw data of a single element in one of the renderers,
         if (const std::shared_ptr<Label>& label = std::dynamic_pointer_cast<Label>(element)) {
             if (visible && !remove) {
-                label->setDrawData(std::make_shared<LabelDrawData>(*label, *label->getStyle(), *_dataSource->getProjection(), projectionSurface, viewState));
+                label->setDrawData(DrawDataPool::Create<LabelDrawData>(*label, *label->getStyle(), *_dataSource->getProjection(), projectionSurface, viewState));
                 _billboardRenderer->updateElement(label);
             } else {
                 _billboardRenderer->removeElement(label);
@@ -367,14 +448,18 @@ namespace carto {
             billboardsChanged = true;
         } else if (const std::shared_ptr<Line>& line = std::dynamic_pointer_cast<Line>(element)) {
             if (visible && !remove) {
-                line->setDrawData(std::make_shared<LineDrawData>(*line->getGeometry(), *line->getStyle(), *_dataSource->getProjection(), projectionSurface));
+                // Keep the current draw data if only draw time parameters (like the visible range) have changed
+                bool dirty = line->testAndClearDrawDataDirty();
+                if (dirty || !line->getDrawData() || line->getDrawData()->isOffset() || line->getDrawData()->getProjectionSurface() != projectionSurface) {
+                    line->setDrawData(DrawDataPool::Create<LineDrawData>(*line->getGeometry(), *line->getStyle(), *_dataSource->getProjection(), projectionSurface));
+                }
                 _lineRenderer->updateElement(line);
             } else {
                 _lineRenderer->removeElement(line);
             }
         } else if (const std::shared_ptr<Marker>& marker = std::dynamic_pointer_cast<Marker>(element)) {
             if (visible && !remove) {
-                marker->setDrawData(std::make_shared<MarkerDrawData>(*marker, *marker->getStyle(), *_dataSource->getProjection(), projectionSurface));
+                marker->setDrawData(DrawDataPool::Create<MarkerDrawData>(*marker, *marker->getStyle(), *_dataSource->getProjection(), projectionSurface));
                 _billboardRenderer->updateElement(marker);
             } else {
                 _billboardRenderer->removeElement(marker);
@@ -382,35 +467,35 @@ namespace carto {
             billboardsChanged = true;
         } else if (const std::shared_ptr<Point>& point = std::dynamic_pointer_cast<Point>(element)) {
             if (visible && !remove) {
-                point->setDrawData(std::make_shared<PointDrawData>(*point->getGeometry(), *point->getStyle(), *_dataSource->getProjection(), projectionSurface));
+                point->setDrawData(DrawDataPool::Create<PointDrawData>(*point->getGeometry(), *point->getStyle(), *_dataSource->getProjection(), projectionSurface));
                 _pointRenderer->updateElement(point);
             } else {
                 _pointRenderer->removeElement(point);
             }
         } else if (const std::shared_ptr<Polygon>& polygon = std::dynamic_pointer_cast<Polygon>(element)) {
             if (visible && !remove) {
-                polygon->setDrawData(std::make_shared<PolygonDrawData>(*polygon->getGeometry(), *polygon->getStyle(), *_dataSource->getProjection(), projectionSurface));
+                polygon->setDrawData(DrawDataPool::Create<PolygonDrawData>(*polygon->getGeometry(), *polygon->getStyle(), *_dataSource->getProjection(), projectionSurface));
                 _polygonRenderer->updateElement(polygon);
             } else {
                 _polygonRenderer->removeElement(polygon);
             }
         } else if (const std::shared_ptr<GeometryCollection>& geomCollection = std::dynamic_pointer_cast<GeometryCollection>(element)) {
             if (visible && !remove) {
-                geomCollection->setDrawData(std::make_shared<GeometryCollectionDrawData>(*geomCollection->getGeometry(), *geomCollection->getStyle(), *_dataSource->getProjection(), projectionSurface));
+                geomCollection->setDrawData(DrawDataPool::Create<GeometryCollectionDrawData>(*geomCollection->getGeometry(), *geomCollection->getStyle(), *_dataSource->getProjection(), projectionSurface));
                 _geometryCollectionRenderer->updateElement(geomCollection);
             } else {
                 _geometryCollectionRenderer->removeElement(geomCollection);
             }
         } else if (const std::shared_ptr<Polygon3D>& polygon3D = std::dynamic_pointer_cast<Polygon3D>(element)) {
             if (visible && !remove) {
-                polygon3D->setDrawData(std::make_shared<Polygon3DDrawData>(*polygon3D, *polygon3D->getStyle(), *_dataSource->getProjection(), projectionSurface));
+                polygon3D->setDrawData(DrawDataPool::Create<Polygon3DDrawData>(*polygon3D, *polygon3D->getStyle(), *_dataSource->getProjection(), projectionSurface));
                 _polygon3DRenderer->updateElement(polygon3D);
             } else {
                 _polygon3DRenderer->removeElement(polygon3D);
             }
         } else if (const std::shared_ptr<NMLModel>& nmlModel = std::dynamic_pointer_cast<NMLModel>(element)) {
             if (visible && !remove) {
-                nmlModel->setDrawData(std::make_shared<NMLModelDrawData>(*nmlModel, *nmlModel->getStyle(), *_dataSource->getProjection(), projectionSurface));
+                nmlModel->setDrawData(DrawDataPool::Create<NMLModelDrawData>(*nmlModel, *nmlModel->getStyle(), *_dataSource->getProjection(), projectionSurface));
                 _nmlModelRenderer->updateElement(nmlModel);
             } else {
                 _nmlModelRenderer->removeElement(nmlModel);
@@ -418,7 +503,7 @@ namespace carto {
         } else if (const std::shared_ptr<Popup>& popup = std::dynamic_pointer_cast<Popup>(element)) {
             if (visible && !remove) {
                 if (auto options = getOptions()) {
-                    popup->setDrawData(std::make_shared<PopupDrawData>(*popup, *popup->getStyle(), *_dataSource->getProjection(), projectionSurface, options, viewState));
+                    popup->setDrawData(DrawDataPool::Create<PopupDrawData>(*popup, *popup->getStyle(), *_dataSource->getProjection(), projectionSurface, options, viewState));
                     _billboardRenderer->updateElement(popup);
                 }
             } else {
@@ -497,6 +582,18 @@ namespace carto {
         }
     }
     
+    void VectorLayer::DataSourceListener::onElementsUpdated(const std::vector<std::shared_ptr<VectorElement> >& addedElements, const std::vector<std::shared_ptr<VectorElement> >& changedElements, const std::vector<std::shared_ptr<VectorElement> >& removedElements) {
+        if (std::shared_ptr<VectorLayer> layer = _layer.lock()) {
+            std::vector<std::shared_ptr<VectorElement> > elements;
+            elements.reserve(addedElements.size() + changedElements.size());
+            elements.insert(elements.end(), addedElements.begin(), addedElements.end());
+            elements.insert(elements.end(), changedElements.begin(), changedElements.end());
+            layer->refreshElements(elements, removedElements);
+        } else {
+            Log::Error("VectorLayer::DataSourceListener: Lost connection to layer");
+        }
+    }
+    
     VectorLayer::FetchTask::FetchTask(const std::weak_ptr<VectorLayer>& layer) :
         _layer(layer), _started(false)
     {
@@ -587,11 +684,120 @@ namespace carto {
 
         const ViewState& viewState = cullState->getViewState();
 
+        // Build the draw datas before locking the layer, this is the most expensive part of the fetch
+        const std::vector<std::shared_ptr<VectorElement> >& elements = vectorData->getElements();
+        std::vector<std::shared_ptr<VectorElementDrawData> > prevDrawDatas;
+        std::vector<std::shared_ptr<VectorElementDrawData> > drawDatas;
+        buildDrawDatas(layer, elements, viewState, prevDrawDatas, drawDatas);
+
         std::lock_guard<std::recursive_mutex> lock(layer->_mutex);
-        for (const std::shared_ptr<VectorElement>& element : vectorData->getElements()) {
-            layer->addRendererElement(element, viewState);
+        for (std::size_t i = 0; i < elements.size(); i++) {
+            // Install the new draw data only if the element was not synced meanwhile, otherwise the draw data may be based on an old style or geometry
+            if (drawDatas[i] && layer->getRendererElementDrawData(elements[i]) == prevDrawDatas[i]) {
+                layer->setRendererElementDrawData(elements[i], drawDatas[i]);
+            }
+            layer->addRendererElement(elements[i], viewState);
         }
         return layer->refreshRendererElements();
     }
 
+    void VectorLayer::FetchTask::buildDrawDatas(const std::shared_ptr<VectorLayer>& layer, const std::vector<std::shared_ptr<VectorElement> >& elements, const ViewState& viewState, std::vector<std::shared_ptr<VectorElementDrawData> >& prevDrawDatas, std::vector<std::shared_ptr<VectorElementDrawData> >& drawDatas) {
+        prevDrawDatas.assign(elements.size(), std::shared_ptr<VectorElementDrawData>());
+        drawDatas.assign(elements.size(), std::shared_ptr<VectorElementDrawData>());
+        auto batch = std::make_shared<DrawDataBatch>(*layer, elements, viewState, prevDrawDatas, drawDatas);
+
+        // Distribute large element sets between envelope threads. The current thread processes chunks too,
+        // thus the batch is completed even if the helper tasks are not started before it.
+        if (batch->chunkCount > 1) {
+            std::shared_ptr<CancelableThreadPool> envelopeThreadPool;
+            int priority = 0;
+            {
+                std::lock_guard<std::recursive_mutex> lock(layer->_mutex);
+                envelopeThreadPool = layer->_envelopeThreadPool;
+                priority = layer->getUpdatePriority();
+            }
+            if (envelopeThreadPool) {
+                int taskCount = std::min(static_cast<int>(batch->chunkCount) - 1, envelopeThreadPool->getPoolSize() - 1);
+                for (int i = 0; i < taskCount; i++) {
+                    envelopeThreadPool->execute(std::make_shared<DrawDataTask>(batch), priority);
+                }
+            }
+        }
+
+        while (batch->processChunk()) {
+        }
+        batch->wait();
+    }
+
+    VectorLayer::FetchTask::DrawDataBatch::DrawDataBatch(const VectorLayer& layer, const std::vector<std::shared_ptr<VectorElement> >& elements, const ViewState& viewState, std::vector<std::shared_ptr<VectorElementDrawData> >& prevDrawDatas, std::vector<std::shared_ptr<VectorElementDrawData> >& drawDatas) :
+        layer(layer),
+        elements(elements),
+        viewState(viewState),
+        prevDrawDatas(prevDrawDatas),
+        drawDatas(drawDatas),
+        chunkCount((elements.size() + DRAW_DATA_CHUNK_SIZE - 1) / DRAW_DATA_CHUNK_SIZE),
+        nextChunk(0),
+        finishedChunks(0),
+        condition(),
+        mutex()
+    {
+    }
+
+    bool VectorLayer::FetchTask::DrawDataBatch::processChunk() {
+        std::size_t chunk = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (nextChunk >= chunkCount) {
+                return false;
+            }
+            chunk = nextChunk++;
+        }
+
+        // Note: layer, elements, viewState and the output vectors are valid here, as the owner of the batch waits until all chunks are finished.
+        // Each chunk writes only its own slots of the output vectors, the elements themselves are not modified.
+        std::shared_ptr<ProjectionSurface> projectionSurface = viewState.getProjectionSurface();
+        std::size_t end = std::min(elements.size(), (chunk + 1) * DRAW_DATA_CHUNK_SIZE);
+        for (std::size_t i = chunk * DRAW_DATA_CHUNK_SIZE; i < end; i++) {
+            try {
+                if (projectionSurface && elements[i]->isVisible()) {
+                    prevDrawDatas[i] = layer.getRendererElementDrawData(elements[i]);
+                    if (IsDrawDataOutdated(prevDrawDatas[i], projectionSurface)) {
+                        drawDatas[i] = layer.createRendererElementDrawData(elements[i], projectionSurface);
+                    }
+                }
+            }
+            catch (const std::exception& ex) {
+                Log::Errorf("VectorLayer::FetchTask: Exception while building draw data: %s", ex.what());
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            finishedChunks++;
+        }
+        condition.notify_all();
+        return true;
+    }
+
+    void VectorLayer::FetchTask::DrawDataBatch::wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this]() { return finishedChunks >= chunkCount; });
+    }
+
+    VectorLayer::FetchTask::DrawDataTask::DrawDataTask(const std::shared_ptr<DrawDataBatch>& batch) :
+        _batch(batch)
+    {
+    }
+
+    void VectorLayer::FetchTask::DrawDataTask::run() {
+        while (_batch->processChunk()) {
+        }
+    }
+
+    bool VectorLayer::IsDrawDataOutdated(const std::shared_ptr<VectorElementDrawData>& drawData, const std::shared_ptr<ProjectionSurface>& projectionSurface) {
+        return !drawData || drawData->isOffset() || drawData->getProjectionSurface() != projectionSurface;
+    }
+
+    const std::size_t VectorLayer::DRAW_DATA_CHUNK_SIZE = 256;
+
 }
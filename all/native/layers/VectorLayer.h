@@ -13,11 +13,15 @@
 #include "datasources/VectorDataSource.h"
 #include "layers/Layer.h"
 
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 
 namespace carto {
     class CullState;
+    class ProjectionSurface;
     class ViewState;
 
     class Billboard;
@@ -31,6 +35,7 @@ namespace carto {
     class Polygon3D;
     class Polygon;
     class Popup;
+    class VectorElementDrawData;
     class VectorElementEventListener;
     
     class BillboardRenderer;
@@ -95,6 +100,7 @@ namespace carto {
             virtual void onElementsAdded(const std::vector<std::shared_ptr<VectorElement> >& elements);
             virtual void onElementsChanged();
             virtual void onElementsRemoved();
+            virtual void onElementsUpdated(const std::vector<std::shared_ptr<VectorElement> >& addedElements, const std::vector<std::shared_ptr<VectorElement> >& changedElements, const std::vector<std::shared_ptr<VectorElement> >& removedElements);
             
         private:
             std::weak_ptr<VectorLayer> _layer;
@@ -112,6 +118,36 @@ namespace carto {
             bool _started;
             
             virtual bool loadElements(const std::shared_ptr<CullState>& cullState);
+
+            void buildDrawDatas(const std::shared_ptr<VectorLayer>& layer, const std::vector<std::shared_ptr<VectorElement> >& elements, const ViewState& viewState, std::vector<std::shared_ptr<VectorElementDrawData> >& prevDrawDatas, std::vector<std::shared_ptr<VectorElementDrawData> >& drawDatas);
+
+        private:
+            struct DrawDataBatch {
+                DrawDataBatch(const VectorLayer& layer, const std::vector<std::shared_ptr<VectorElement> >& elements, const ViewState& viewState, std::vector<std::shared_ptr<VectorElementDrawData> >& prevDrawDatas, std::vector<std::shared_ptr<VectorElementDrawData> >& drawDatas);
+
+                bool processChunk();
+                void wait();
+
+                const VectorLayer& layer;
+                const std::vector<std::shared_ptr<VectorElement> >& elements;
+                const ViewState& viewState;
+                std::vector<std::shared_ptr<VectorElementDrawData> >& prevDrawDatas; // draw datas of the elements before building
+                std::vector<std::shared_ptr<VectorElementDrawData> >& drawDatas; // new draw datas, null if the current one can be kept
+                std::size_t chunkCount;
+                std::size_t nextChunk;
+                std::size_t finishedChunks;
+                std::condition_variable condition;
+                std::mutex mutex;
+            };
+
+            class DrawDataTask : public CancelableTask {
+            public:
+                explicit DrawDataTask(const std::shared_ptr<DrawDataBatch>& batch);
+                virtual void run();
+
+            private:
+                std::shared_ptr<DrawDataBatch> _batch;
+            };
         };
         
         virtual void setComponents(const std::shared_ptr<CancelableThreadPool>& envelopeThreadPool,
@@ -130,7 +166,11 @@ namespace carto {
         virtual bool processClick(ClickType::ClickType clickType, const RayIntersectedElement& intersectedElement, const ViewState& viewState) const;
 
         virtual void refreshElement(const std::shared_ptr<VectorElement>& element, bool remove);
+        virtual void refreshElements(const std::vector<std::shared_ptr<VectorElement> >& elements, const std::vector<std::shared_ptr<VectorElement> >& removedElements);
 
+        virtual std::shared_ptr<VectorElementDrawData> getRendererElementDrawData(const std::shared_ptr<VectorElement>& element) const;
+        virtual std::shared_ptr<VectorElementDrawData> createRendererElementDrawData(const std::shared_ptr<VectorElement>& element, const std::shared_ptr<ProjectionSurface>& projectionSurface) const;
+        virtual void setRendererElementDrawData(const std::shared_ptr<VectorElement>& element, const std::shared_ptr<VectorElementDrawData>& drawData) const;
         virtual void addRendererElement(const std::shared_ptr<VectorElement>& element, const ViewState& viewState);
         virtual bool refreshRendererElements();
         virtual bool syncRendererElement(const std::shared_ptr<VectorElement>& element, const ViewState& viewState, bool remove);
@@ -140,6 +180,10 @@ namespace carto {
 
         virtual std::shared_ptr<CancelableTask> createFetchTask(const std::shared_ptr<CullState>& cullState);
 
+        static bool IsDrawDataOutdated(const std::shared_ptr<VectorElementDrawData>& drawData, const std::shared_ptr<ProjectionSurface>& projectionSurface);
+
+        static const std::size_t DRAW_DATA_CHUNK_SIZE;
+
         const DirectorPtr<VectorDataSource> _dataSource;
         std::shared_ptr<VectorDataSource::OnChangeListener> _dataSourceListener;
         
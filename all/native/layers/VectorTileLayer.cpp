@@ -31,6 +31,7 @@ namespace carto {
         _labelRenderOrder(VectorTileRenderOrder::VECTOR_TILE_RENDER_ORDER_LAYER),
         _buildingRenderOrder(VectorTileRenderOrder::VECTOR_TILE_RENDER_ORDER_LAST),
         _clickRadius(4),
+        _overzoomTileReuse(false),
         _tileDecoder(decoder),
         _tileDecoderListener(),
         _backgroundColor(0, 0, 0, 0),
@@ -49,9 +50,15 @@ namespace carto {
         }
 
         setCullDelay(DEFAULT_CULL_DELAY);
+
+        _memoryConsumer = MemoryGovernor::GetInstance().registerConsumer(DEFAULT_PRELOADING_CACHE_SIZE, 1.0f,
+            [this](std::size_t budget) { _preloadingCache.resize(budget); },
+            [this](bool critical) { _preloadingCache.clear(); }
+        );
     }
     
     VectorTileLayer::~VectorTileLayer() {
+        _memoryConsumer->detach();
     }
     
     std::shared_ptr<VectorTileDecoder> VectorTileLayer::getTileDecoder() const {
@@ -59,13 +66,18 @@ namespace carto {
     }
     
     std::size_t VectorTileLayer::getTileCacheCapacity() const {
-        std::lock_guard<std::recursive_mutex> lock(_mutex);
-        return _preloadingCache.capacity();
+        return _memoryConsumer->getCapacity();
     }
     
     void VectorTileLayer::setTileCacheCapacity(std::size_t capacityInBytes) {
-        std::lock_guard<std::recursive_mutex> lock(_mutex);
-        _preloadingCache.resize(capacityInBytes);
+        _memoryConsumer->setCapacity(capacityInBytes);
+    }
+
+    CacheStatistics VectorTileLayer::getTileCacheStatistics() const {
+        std::size_t size = _visibleCache.size() + _preloadingCache.size();
+        std::size_t entryCount = _visibleCache.count() + _preloadingCache.count();
+        long long evictionCount = static_cast<long long>(_visibleCache.eviction_count() + _preloadingCache.eviction_count());
+        return _tileCacheStatistics.getStatistics(size, _memoryConsumer->getCapacity(), entryCount, evictionCount);
     }
     
     VectorTileRenderOrder::VectorTileRenderOrder VectorTileLayer::getLabelRenderOrder() const {
@@ -103,6 +115,19 @@ namespace carto {
         std::lock_guard<std::recursive_mutex> lock(_mutex);
         _clickRadius = radius;
     }
+
+    bool VectorTileLayer::isOverzoomTileReuse() const {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return _overzoomTileReuse;
+    }
+
+    void VectorTileLayer::setOverzoomTileReuse(bool enabled) {
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            _overzoomTileReuse = enabled;
+        }
+        refresh();
+    }
     
     std::shared_ptr<VectorTileEventListener> VectorTileLayer::getVectorTileEventListener() const {
         return _vectorTileEventListener.get();
@@ -118,7 +143,6 @@ namespace carto {
     }
     
     bool VectorTileLayer::tileExists(const MapTile& tile, bool preloadingCache) const {
-        std::lock_guard<std::recursive_mutex> lock(_mutex);
         long long tileId = getTileId(tile);
         if (preloadingCache) {
             return _preloadingCache.exists(tileId);
@@ -128,7 +152,6 @@ namespace carto {
     }
     
     bool VectorTileLayer::tileValid(const MapTile& tile, bool preloadingCache) const {
-        std::lock_guard<std::recursive_mutex> lock(_mutex);
         long long tileId = getTileId(tile);
         if (preloadingCache) {
             return _preloadingCache.exists(tileId) && _preloadingCache.valid(tileId);
@@ -144,21 +167,28 @@ namespace carto {
         }
 
         if (!invalidated) {
-            std::lock_guard<std::recursive_mutex> lock(_mutex);
             if (_preloadingCache.exists(tileId) && _preloadingCache.valid(tileId)) {
                 if (!preloadingTile) {
                     _preloadingCache.move(tileId, _visibleCache); // move to visible cache, just in case the element gets trashed
                 } else {
                     _preloadingCache.get(tileId);
                 }
+                _tileCacheStatistics.recordHit();
                 return;
             }
 
             if (_visibleCache.exists(tileId) && _visibleCache.valid(tileId)) {
                 _visibleCache.get(tileId); // do not move to preloading, it will be moved at later stage
+                _tileCacheStatistics.recordHit();
                 return;
             }
+
+            if (preloadingTile && compactTileExists(MapTile(tile.getX(), tile.getY(), tile.getZoom(), 0))) {
+                _tileCacheStatistics.recordHit();
+                return; // already stored in encoded form, decoded once visible
+            }
         }
+        _tileCacheStatistics.recordMiss();
         
         auto task = std::make_shared<FetchTask>(std::static_pointer_cast<VectorTileLayer>(shared_from_this()), MapTile(tile.getX(), tile.getY(), tile.getZoom(), 0), preloadingTile);
         _fetchingTiles.add(tileId, task);
@@ -201,6 +231,69 @@ namespace carto {
         refresh();
     }
 
+    void VectorTileLayer::tilesChanged(const MapBounds& bounds, int minZoom, int maxZoom, bool removeTiles) {
+        // Invalidate current tasks within the area
+        for (const std::shared_ptr<FetchTaskBase>& task : _fetchingTiles.getTasks()) {
+            if (isTileInArea(task->getTile(), bounds, minZoom, maxZoom)) {
+                task->invalidate();
+            }
+        }
+
+        // Flush cached tiles within the area, other tiles are kept valid
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            for (long long tileId : _visibleCache.keys()) {
+                if (isTileInArea(MapTile::FromTileId(tileId), bounds, minZoom, maxZoom)) {
+                    if (removeTiles) {
+                        _visibleCache.remove(tileId);
+                    } else {
+                        _visibleCache.invalidate(tileId, now);
+                    }
+                }
+            }
+            for (long long tileId : _preloadingCache.keys()) {
+                if (isTileInArea(MapTile::FromTileId(tileId), bounds, minZoom, maxZoom)) {
+                    _preloadingCache.remove(tileId);
+                }
+            }
+        }
+        refresh();
+    }
+
+    void VectorTileLayer::decoderChanged() {
+        if (_useTileMapMode) {
+            tilesChanged(false); // cache keys do not include the frame number, thus the fetch tiles can not be reconstructed
+            return;
+        }
+
+        // Invalidate current tasks
+        for (const std::shared_ptr<FetchTaskBase>& task : _fetchingTiles.getTasks()) {
+            task->invalidate();
+        }
+
+        // Keep the encoded data of the cached tiles, so that the tiles are decoded again without loading them from the data source.
+        // The old tiles remain visible until the new tiles are decoded.
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            for (ShardedTileCache<TileInfo>* cache : { &_visibleCache, &_preloadingCache }) {
+                for (long long tileId : cache->keys()) {
+                    TileInfo tileInfo;
+                    if (cache->valid(tileId) && cache->peek(tileId, tileInfo) && tileInfo.getDataSourceTileData()) {
+                        storeCompactTile(MapTile::FromTileId(tileId), tileInfo.getDataSourceTile(), tileInfo.getDataSourceTileData());
+                    }
+                }
+            }
+            _visibleCache.invalidate_all(std::chrono::steady_clock::now());
+            _preloadingCache.clear();
+        }
+        refresh();
+    }
+
+    bool VectorTileLayer::isOverzoomParentTileReused() const {
+        return isOverzoomTileReuse();
+    }
+
     long long VectorTileLayer::getTileId(const MapTile& mapTile) const {
         if (_useTileMapMode) {
             return MapTile(mapTile.getX(), mapTile.getY(), mapTile.getZoom(), 0).getTileId();
@@ -306,6 +399,7 @@ namespace carto {
             if (_tileRenderer->refreshTiles(drawDatas)) {
                 tilesChanged = true;
             }
+            submitTileLoadTraces(_tempDrawDatas);
         }
     
         bool updateLabels = tilesChanged;
@@ -315,7 +409,7 @@ namespace carto {
     
         if (auto mapRenderer = getMapRenderer()) {
             if (updateLabels) {
-                mapRenderer->vtLabelsChanged(shared_from_this(), false);
+                mapRenderer->vtLabelsChanged(shared_from_this(), false, tilesChanged);
             }
             if (tilesChanged) {
                 mapRenderer->requestRedraw();
@@ -422,6 +516,7 @@ namespace carto {
             _tileRenderer->setBuildingOrder(static_cast<int>(getBuildingRenderOrder()));
             _tileRenderer->setSubTileBlending(false);
             bool refresh = _tileRenderer->onDrawFrame(deltaSeconds, viewState);
+            reportTileLoadTraces();
 
             if (opacity < 1.0f) {
                 mapRenderer->blendAndUnbindScreenFBO(opacity);
@@ -505,7 +600,7 @@ namespace carto {
         
     void VectorTileLayer::TileDecoderListener::onDecoderChanged() {
         if (std::shared_ptr<VectorTileLayer> layer = _layer.lock()) {
-            layer->tilesChanged(false);
+            layer->decoderChanged();
         } else {
             Log::Error("VectorTileLayer::TileDecoderListener: Lost connection to layer");
         }
@@ -521,7 +616,7 @@ namespace carto {
         
         bool refresh = false;
         for (const MapTile& dataSourceTile : _dataSourceTiles) {
-            std::shared_ptr<TileData> tileData = layer->_dataSource->loadTile(dataSourceTile);
+            std::shared_ptr<TileData> tileData = loadDataSourceTile(layer, dataSourceTile);
             if (!tileData) {
                 break;
             }
@@ -531,20 +626,52 @@ namespace carto {
             if (!tileData->getData()) {
                 break;
             }
+            if (storeCompactTile(layer, dataSourceTile, tileData)) {
+                refresh = true;
+                break;
+            }
     
             vt::TileId vtTile(_tile.getZoom(), _tile.getX(), _tile.getY());
             vt::TileId vtDataSourceTile(dataSourceTile.getZoom(), dataSourceTile.getX(), dataSourceTile.getY());
             std::shared_ptr<vt::TileTransformer> tileTransformer = layer->getTileTransformer();
-            std::shared_ptr<VectorTileDecoder::TileMap> tileMap = layer->_tileDecoder->decodeTile(vtDataSourceTile, vtTile, tileTransformer, tileData->getData());
+            long long tileId = layer->getTileId(_tile);
+
+            // Show partially decoded visible tiles immediately. The partial tile is replaced by the complete tile below.
+            bool partialTileStored = false;
+            VectorTileDecoder::PartialTileHandler partialTileHandler;
+            if (!isPreloading()) {
+                partialTileHandler = [&](const std::shared_ptr<VectorTileDecoder::TileMap>& partialTileMap) {
+                    if (isInvalidated() || isCanceled()) {
+                        return;
+                    }
+                    VectorTileLayer::TileInfo tileInfo(layer->calculateMapTileBounds(dataSourceTile.getFlipped()), layer->_vectorTileEventListener.get() ? tileData->getData() : std::shared_ptr<BinaryData>(), partialTileMap, dataSourceTile, tileData);
+                    {
+                        std::lock_guard<std::recursive_mutex> lock(layer->_mutex);
+                        if (layer->getTileTransformer() != tileTransformer) {
+                            return;
+                        }
+                        layer->_visibleCache.put(tileId, tileInfo, tileInfo.getSize());
+                        partialTileStored = true;
+                    }
+                    if (auto mapRenderer = layer->getMapRenderer()) {
+                        mapRenderer->layerChanged(layer->shared_from_this(), false);
+                        mapRenderer->requestRedraw();
+                    }
+                };
+            }
+
+            std::shared_ptr<VectorTileDecoder::TileMap> tileMap = layer->_tileDecoder->decodeTileProgressive(vtDataSourceTile, vtTile, tileTransformer, tileData->getData(), partialTileHandler);
+            traceTileDecoded();
+            bool completeTileStored = false;
             if (tileMap) {
                 // Construct tile info - keep original data if interactivity is required
-                VectorTileLayer::TileInfo tileInfo(layer->calculateMapTileBounds(dataSourceTile.getFlipped()), layer->_vectorTileEventListener.get() ? tileData->getData() : std::shared_ptr<BinaryData>(), tileMap);
+                VectorTileLayer::TileInfo tileInfo(layer->calculateMapTileBounds(dataSourceTile.getFlipped()), layer->_vectorTileEventListener.get() ? tileData->getData() : std::shared_ptr<BinaryData>(), tileMap, dataSourceTile, tileData);
 
                 // Store tile to cache, unless invalidated
                 if (!isInvalidated()) {
-                    long long tileId = layer->getTileId(_tile);
                     std::lock_guard<std::recursive_mutex> lock(layer->_mutex);
                     if (layer->getTileTransformer() == tileTransformer) { // extra check that the tile is created with correct transformer. Otherwise simply drop it.
+                        completeTileStored = true;
                         if (isPreloading()) {
                             layer->_preloadingCache.put(tileId, tileInfo, tileInfo.getSize());
                             if (tileData->getMaxAge() >= 0) {
@@ -575,9 +702,16 @@ namespace carto {
                 }
                 
                 refresh = true; // NOTE: need to refresh even when invalidated
-            } else if (!tileData->getData()->empty()) {
+            } else if (!tileData->getData()->empty() && !isCanceled()) {
                 Log::Error("VectorTileLayer::FetchTask: Failed to decode tile");
             }
+
+            // Never leave an incomplete tile in the cache, otherwise it would not be fetched again
+            if (partialTileStored && !completeTileStored) {
+                std::lock_guard<std::recursive_mutex> lock(layer->_mutex);
+                layer->_visibleCache.remove(tileId);
+                refresh = true;
+            }
             break;
         }
         
@@ -589,6 +723,9 @@ namespace carto {
         if (_tileData) {
             size += _tileData->size();
         }
+        if (_dataSourceTileData && _dataSourceTileData->getData() != _tileData) {
+            size += _dataSourceTileData->getData()->size();
+        }
         for (auto it = _tileMap->begin(); it != _tileMap->end(); it++) {
             size += it->second->getResidentSize();
         }
@@ -599,7 +736,6 @@ namespace carto {
     const int VectorTileLayer::BACKGROUND_BLOCK_COUNT = 16;
 
     const int VectorTileLayer::DEFAULT_CULL_DELAY = 200;
-    const int VectorTileLayer::PRELOADING_PRIORITY_OFFSET = -2;
 
     const unsigned int VectorTileLayer::EXTRA_TILE_FOOTPRINT = 4096;
     const unsigned int VectorTileLayer::DEFAULT_VISIBLE_CACHE_SIZE = 512 * 1024 * 1024; // NOTE: the limit should never be reached in normal cases
@@ -9,8 +9,10 @@
 
 #include "core/MapTile.h"
 #include "core/MapBounds.h"
+#include "core/CacheStatistics.h"
 #include "components/CancelableTask.h"
 #include "components/DirectorPtr.h"
+#include "components/ShardedTileCache.h"
 #include "components/Task.h"
 #include "layers/TileLayer.h"
 #include "vectortiles/VectorTileDecoder.h"
@@ -18,8 +20,6 @@
 #include <memory>
 #include <map>
 
-#include <stdext/timed_lru_cache.h>
-
 namespace carto {
     class TileDrawData;
     class VectorTileEventListener;
@@ -80,9 +80,17 @@ namespace carto {
          * The more tiles are visible on the screen, the larger this cache should be. 
          * The default is 10MB, which should be enough for most use cases with preloading enabled. If preloading is
          * disabled, the cache size should be reduced by the user to conserve memory.
+         * If the global memory budget is set (see MapView.setMemoryBudget), the actual cache size may be smaller.
          * @param capacityInBytes The new tile bitmap cache capacity in bytes.
          */
         void setTileCacheCapacity(std::size_t capacityInBytes);
+        /**
+         * Returns the usage statistics of the tile cache. The statistics include both visible and preloaded tiles.
+         * A request for a tile that is not in the cache is counted as a miss, the load time includes
+         * loading the tile from the data source and decoding it.
+         * @return The tile cache statistics.
+         */
+        CacheStatistics getTileCacheStatistics() const;
         
         /**
          * Returns the current display order of the labels.
@@ -119,6 +127,21 @@ namespace carto {
          * @param radius The new click radius of vector tile features. The default value is 4.
          */
         void setClickRadius(float radius);
+
+        /**
+         * Returns the state of the overzoom tile reuse flag.
+         * @return True when the tiles loaded at the maximum zoom level of the data source are drawn directly at higher zoom levels.
+         */
+        bool isOverzoomTileReuse() const;
+        /**
+         * Sets the state of the overzoom tile reuse flag.
+         * When enabled, the tiles loaded at the maximum zoom level of the data source are drawn directly at higher zoom levels,
+         * instead of decoding the data source tile again for each overzoomed tile. This makes zooming in beyond
+         * the data source zoom levels much cheaper, but zoom-dependent style properties are evaluated
+         * at the maximum zoom level of the data source.
+         * @param enabled True when the overzoom tiles should be reused. The default is false.
+         */
+        void setOverzoomTileReuse(bool enabled);
     
         /**
          * Returns the vector tile event listener.
@@ -139,6 +162,10 @@ namespace carto {
         virtual void fetchTile(const MapTile& mapTile, bool preloadingTile, bool invalidated);
         virtual void clearTiles(bool preloadingTiles);
         virtual void tilesChanged(bool removeTiles);
+        virtual void tilesChanged(const MapBounds& bounds, int minZoom, int maxZoom, bool removeTiles);
+        virtual void decoderChanged();
+
+        virtual bool isOverzoomParentTileReused() const;
 
         virtual long long getTileId(const MapTile& mapTile) const;
         virtual std::shared_ptr<VectorTileDecoder::TileMap> getTileMap(long long tileId) const;
@@ -189,12 +216,14 @@ namespace carto {
         
         class TileInfo {
         public:
-            TileInfo() : _tileBounds(), _tileData(), _tileMap() { }
-            TileInfo(const MapBounds& tileBounds, const std::shared_ptr<BinaryData>& tileData, const std::shared_ptr<VectorTileDecoder::TileMap>& tileMap) : _tileBounds(tileBounds), _tileData(tileData), _tileMap(tileMap) { }
+            TileInfo() : _tileBounds(), _tileData(), _tileMap(), _dataSourceTile(), _dataSourceTileData() { }
+            TileInfo(const MapBounds& tileBounds, const std::shared_ptr<BinaryData>& tileData, const std::shared_ptr<VectorTileDecoder::TileMap>& tileMap, const MapTile& dataSourceTile, const std::shared_ptr<TileData>& dataSourceTileData) : _tileBounds(tileBounds), _tileData(tileData), _tileMap(tileMap), _dataSourceTile(dataSourceTile), _dataSourceTileData(dataSourceTileData) { }
 
             const MapBounds& getTileBounds() const { return _tileBounds; }
             const std::shared_ptr<BinaryData>& getTileData() const { return _tileData; }
             const std::shared_ptr<VectorTileDecoder::TileMap>& getTileMap() const { return _tileMap; }
+            const MapTile& getDataSourceTile() const { return _dataSourceTile; }
+            const std::shared_ptr<TileData>& getDataSourceTileData() const { return _dataSourceTileData; }
 
             std::size_t getSize() const;
 
@@ -202,13 +231,14 @@ namespace carto {
             MapBounds _tileBounds;
             std::shared_ptr<BinaryData> _tileData;
             std::shared_ptr<VectorTileDecoder::TileMap> _tileMap;
+            MapTile _dataSourceTile;
+            std::shared_ptr<TileData> _dataSourceTileData; // encoded tile, kept for decoding the tile again after decoder changes
         };
 
         static const int BACKGROUND_BLOCK_SIZE;
         static const int BACKGROUND_BLOCK_COUNT;
 
         static const int DEFAULT_CULL_DELAY;
-        static const int PRELOADING_PRIORITY_OFFSET;
 
         static const unsigned int EXTRA_TILE_FOOTPRINT;
         static const unsigned int DEFAULT_VISIBLE_CACHE_SIZE;
@@ -219,6 +249,7 @@ namespace carto {
         VectorTileRenderOrder::VectorTileRenderOrder _labelRenderOrder;
         VectorTileRenderOrder::VectorTileRenderOrder _buildingRenderOrder;
         float _clickRadius;
+        bool _overzoomTileReuse;
     
         const std::shared_ptr<VectorTileDecoder> _tileDecoder;
         std::shared_ptr<TileDecoderListener> _tileDecoderListener;
@@ -233,8 +264,8 @@ namespace carto {
         std::vector<long long> _visibleTileIds;
         std::vector<std::shared_ptr<TileDrawData> > _tempDrawDatas;
 
-        cache::timed_lru_cache<long long, TileInfo> _visibleCache;
-        cache::timed_lru_cache<long long, TileInfo> _preloadingCache;
+        ShardedTileCache<TileInfo> _visibleCache;
+        ShardedTileCache<TileInfo> _preloadingCache;
     };
     
 }
@@ -0,0 +1,94 @@
+#include "TileLoadTrace.h"
+
+#include <iomanip>
+#include <sstream>
+
+namespace carto {
+
+    TileLoadTrace::TileLoadTrace(const MapTile& tile, bool preloadingTile, const TimePoint& queuedTime) :
+        _tile(tile),
+        _preloadingTile(preloadingTile),
+        _queuedTime(queuedTime),
+        _startedTime(),
+        _loadedTime(),
+        _decodedTime(),
+        _drawnTime(),
+        _cacheSource()
+    {
+    }
+
+    TileLoadTrace::~TileLoadTrace() {
+    }
+
+    const MapTile& TileLoadTrace::getTile() const {
+        return _tile;
+    }
+
+    bool TileLoadTrace::isPreloadingTile() const {
+        return _preloadingTile;
+    }
+
+    const TileLoadTrace::TimePoint& TileLoadTrace::getQueuedTime() const {
+        return _queuedTime;
+    }
+
+    const TileLoadTrace::TimePoint& TileLoadTrace::getStartedTime() const {
+        return _startedTime;
+    }
+
+    const TileLoadTrace::TimePoint& TileLoadTrace::getLoadedTime() const {
+        return _loadedTime;
+    }
+
+    const TileLoadTrace::TimePoint& TileLoadTrace::getDecodedTime() const {
+        return _decodedTime;
+    }
+
+    const TileLoadTrace::TimePoint& TileLoadTrace::getUploadedTime() const {
+        return _drawnTime;
+    }
+
+    const TileLoadTrace::TimePoint& TileLoadTrace::getDrawnTime() const {
+        return _drawnTime;
+    }
+
+    const std::string& TileLoadTrace::getCacheSource() const {
+        return _cacheSource;
+    }
+
+    void TileLoadTrace::setStartedTime(const TimePoint& time) {
+        _startedTime = time;
+    }
+
+    void TileLoadTrace::setLoadedTime(const TimePoint& time, const std::string& cacheSource) {
+        _loadedTime = time;
+        _cacheSource = cacheSource;
+    }
+
+    void TileLoadTrace::setDecodedTime(const TimePoint& time) {
+        _decodedTime = time;
+    }
+
+    void TileLoadTrace::setDrawnTime(const TimePoint& time) {
+        _drawnTime = time;
+    }
+
+    std::string TileLoadTrace::toString() const {
+        auto formatTime = [this](const TimePoint& time) -> std::string {
+            if (time == TimePoint()) {
+                return "-";
+            }
+            std::stringstream ss;
+            ss << std::fixed << std::setprecision(1) << std::chrono::duration_cast<std::chrono::duration<float, std::milli> >(time - _queuedTime).count();
+            return ss.str();
+        };
+
+        std::stringstream ss;
+        ss << "TileLoadTrace [tile=" << _tile.toString() << ", preloading=" << (_preloadingTile ? "true" : "false");
+        ss << ", started=" << formatTime(_startedTime) << ", loaded=" << formatTime(_loadedTime);
+        ss << ", decoded=" << formatTime(_decodedTime) << ", drawn=" << formatTime(_drawnTime);
+        ss << ", cacheSource=" << (_cacheSource.empty() ? "none" : _cacheSource) << "]";
+        return ss.str();
+    }
+
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_TILELOADTRACE_H_
+#define _CARTO_TILELOADTRACE_H_
+
+#include "core/MapTile.h"
+
+#include <chrono>
+#include <string>
+
+namespace carto {
+
+    /**
+     * Timestamps of a single tile passing through the tile loading pipeline.
+     * Stages that were not reached have default-constructed (zero) time points.
+     */
+    class TileLoadTrace {
+    public:
+        typedef std::chrono::steady_clock::time_point TimePoint;
+
+        TileLoadTrace(const MapTile& tile, bool preloadingTile, const TimePoint& queuedTime);
+        virtual ~TileLoadTrace();
+
+        /**
+         * Returns the traced tile.
+         * @return The traced tile.
+         */
+        const MapTile& getTile() const;
+        /**
+         * Returns true if the tile was loaded as a preloading tile.
+         * @return True if the tile was loaded as a preloading tile.
+         */
+        bool isPreloadingTile() const;
+
+        /**
+         * Returns the time when the fetch task was queued in the tile thread pool.
+         * @return The time when the fetch task was queued.
+         */
+        const TimePoint& getQueuedTime() const;
+        /**
+         * Returns the time when the fetch task started running.
+         * @return The time when the fetch task started running.
+         */
+        const TimePoint& getStartedTime() const;
+        /**
+         * Returns the time when the data source returned the tile data.
+         * @return The time when the data source returned the tile data.
+         */
+        const TimePoint& getLoadedTime() const;
+        /**
+         * Returns the time when the tile data was decoded.
+         * @return The time when the tile data was decoded.
+         */
+        const TimePoint& getDecodedTime() const;
+        /**
+         * Returns the time when the tile was uploaded to GPU. The upload is done by the tile renderer
+         * during the first frame containing the tile, thus this is the same as the drawn time.
+         * @return The time when the tile was uploaded to GPU.
+         */
+        const TimePoint& getUploadedTime() const;
+        /**
+         * Returns the time when the tile was drawn for the first time.
+         * @return The time when the tile was drawn for the first time.
+         */
+        const TimePoint& getDrawnTime() const;
+
+        /**
+         * Returns the name of the cache that served the tile data.
+         * @return The name of the cache that served the tile data. Empty if the data was loaded from the original data source.
+         */
+        const std::string& getCacheSource() const;
+
+        void setStartedTime(const TimePoint& time);
+        void setLoadedTime(const TimePoint& time, const std::string& cacheSource);
+        void setDecodedTime(const TimePoint& time);
+        void setDrawnTime(const TimePoint& time);
+
+        /**
+         * Creates a string representation of this trace, stages are given in milliseconds relative to the queued time.
+         * @return The string representation of this trace.
+         */
+        std::string toString() const;
+
+    private:
+        MapTile _tile;
+        bool _preloadingTile;
+        TimePoint _queuedTime;
+        TimePoint _startedTime;
+        TimePoint _loadedTime;
+        TimePoint _decodedTime;
+        TimePoint _drawnTime;
+        std::string _cacheSource;
+    };
+
+}
+
+#endif
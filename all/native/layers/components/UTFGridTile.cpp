@@ -48,6 +48,31 @@ namespace {
 
 namespace carto {
 
+    int UTFGridTile::getKeyId(int x, int y) const {
+        if (x < 0 || y < 0 || x >= getXSize() || y >= getYSize()) {
+            return 0;
+        }
+
+        // Skip to the requested column, rows are validated when the tile is decoded
+        const std::string& row = _rows[y];
+        std::string::const_iterator it = row.begin();
+        for (int i = 0; i < x; i++) {
+            if (it == row.end()) {
+                return 0;
+            }
+            utf8::unchecked::next(it);
+        }
+        if (it == row.end()) {
+            return 0; // short row, treat as empty
+        }
+
+        std::uint32_t code = utf8::unchecked::next(it);
+        if (code >= 93) code--;
+        if (code >= 35) code--;
+        code -= 32;
+        return static_cast<int>(code);
+    }
+
     std::shared_ptr<UTFGridTile> UTFGridTile::DecodeUTFTile(const std::shared_ptr<BinaryData>& tileData) {
         if (!tileData) {
             Log::Error("UTFGridTile::DecodeUTFTile: Null tile data");
@@ -77,38 +102,24 @@ namespace carto {
             }
         }
 
-        unsigned int rows = doc["grid"].Size();
-        unsigned int cols = 0;
-        for (unsigned int i = 0; i < rows; i++) {
-            std::string columnUTF8 = doc["grid"][i].GetString();
-            std::vector<std::uint32_t> column;
-            column.reserve(columnUTF8.size());
-            utf8::utf8to32(columnUTF8.begin(), columnUTF8.end(), std::back_inserter(column));
-
-            cols = std::max(cols, static_cast<unsigned int>(column.size()));
-        }
-        std::vector<int> keyIds;
-        keyIds.reserve(cols * rows);
-        for (unsigned int i = 0; i < rows; i++) {
-            std::string columnUTF8 = doc["grid"][i].GetString();
-            std::vector<std::uint32_t> column;
-            column.reserve(columnUTF8.size());
-            utf8::utf8to32(columnUTF8.begin(), columnUTF8.end(), std::back_inserter(column));
-
-            if (column.size() != cols) {
-                Log::Warnf("UTFGridTile::DecodeUTFTile: Mismatching rows/columns");
-                column.resize(cols - column.size(), ' ');
+        std::vector<std::string> rows;
+        rows.reserve(doc["grid"].Size());
+        std::size_t cols = 0;
+        for (unsigned int i = 0; i < doc["grid"].Size(); i++) {
+            std::string rowUTF8 = doc["grid"][i].GetString();
+            if (!utf8::is_valid(rowUTF8.begin(), rowUTF8.end())) {
+                Log::Error("UTFGridTile::DecodeUTFTile: Invalid UTF-8 in grid");
+                return std::shared_ptr<UTFGridTile>();
             }
 
-            for (std::size_t j = 0; j < column.size(); j++) {
-                std::uint32_t code = column[j];
-                if (code >= 93) code--;
-                if (code >= 35) code--;
-                code -= 32;
-                keyIds.push_back(code);
+            std::size_t length = static_cast<std::size_t>(utf8::distance(rowUTF8.begin(), rowUTF8.end()));
+            if (i > 0 && length != cols) {
+                Log::Warn("UTFGridTile::DecodeUTFTile: Mismatching rows/columns");
             }
+            cols = std::max(cols, length);
+            rows.push_back(std::move(rowUTF8));
         }
-        return std::make_shared<UTFGridTile>(keys, data, keyIds, cols, rows);
+        return std::make_shared<UTFGridTile>(keys, data, rows, static_cast<int>(cols));
     }
 
 }
@@ -17,12 +17,16 @@
 namespace carto {
     class BinaryData;
         
+    /**
+     * Decoded UTF grid tile. The grid rows are kept in their compact UTF-8 encoded form
+     * and only the row containing the requested position is decoded on lookup.
+     */
     class UTFGridTile {
     public:
-        UTFGridTile(const std::vector<std::string>& keys, const std::map<std::string, Variant>& data, const std::vector<int>& keyIds, int xSize, int ySize) : _keys(keys), _data(data), _keyIds(keyIds), _xSize(xSize), _ySize(ySize) { }
+        UTFGridTile(const std::vector<std::string>& keys, const std::map<std::string, Variant>& data, const std::vector<std::string>& rows, int xSize) : _keys(keys), _data(data), _rows(rows), _xSize(xSize) { }
 
         std::string getKey(int keyId) const {
-            return keyId >= 0 && keyId <= static_cast<int>(_keys.size()) ? _keys[keyId] : std::string();
+            return keyId >= 0 && keyId < static_cast<int>(_keys.size()) ? _keys[keyId] : std::string();
         }
         
         Variant getData(const std::string& key) const {
@@ -35,21 +39,18 @@ namespace carto {
         }
         
         int getYSize() const {
-            return _ySize;
+            return static_cast<int>(_rows.size());
         }
         
-        int getKeyId(int x, int y) const {
-            return x >= 0 && y >= 0 && x < getXSize() && y < getYSize() ? _keyIds[y * getXSize() + x] : 0;
-        }
+        int getKeyId(int x, int y) const;
 
         static std::shared_ptr<UTFGridTile> DecodeUTFTile(const std::shared_ptr<BinaryData>& tileData);
 
     private:
         std::vector<std::string> _keys;
         std::map<std::string, Variant> _data;
-        std::vector<int> _keyIds;
+        std::vector<std::string> _rows; // UTF-8 encoded grid rows
         int _xSize;
-        int _ySize;
     };
     
 }
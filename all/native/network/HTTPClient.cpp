@@ -1,5 +1,6 @@
 #include "HTTPClient.h"
 #include "core/BinaryData.h"
+#include "components/CancelableTask.h"
 #include "components/Exceptions.h"
 #include "utils/Log.h"
 
@@ -28,7 +29,10 @@ namespace carto {
 
     HTTPClient::HTTPClient(bool log) :
         _log(log),
-        _impl(new CARTO_HTTP_SOCKET_IMPL(log))
+        _impl(new CARTO_HTTP_SOCKET_IMPL(log)),
+        _requestCount(0),
+        _failedRequestCount(0),
+        _receivedBytes(0)
     {
     }
 
@@ -36,6 +40,19 @@ namespace carto {
         _impl->setTimeout(milliseconds);
     }
 
+    void HTTPClient::setMaxConnectionsPerHost(int maxConnections) {
+        _impl->setMaxConnectionsPerHost(maxConnections);
+    }
+
+    HTTPClient::Statistics HTTPClient::getStatistics() const {
+        Statistics stats;
+        stats.requestCount = _requestCount.load();
+        stats.failedRequestCount = _failedRequestCount.load();
+        stats.receivedBytes = _receivedBytes.load();
+        _impl->getConnectionStatistics(stats);
+        return stats;
+    }
+
     int HTTPClient::get(const std::string& url, const std::map<std::string, std::string>& requestHeaders, std::map<std::string, std::string>& responseHeaders, std::shared_ptr<BinaryData>& responseData, int* statusCode) const {
         Request request("GET", url);
         request.headers.insert(requestHeaders.begin(), requestHeaders.end());
@@ -96,7 +113,7 @@ namespace carto {
         if (request.headers.count("Accept") == 0) {
             request.headers["Accept"] = "*/*";
         }
-        if (offset > 0) {
+        if (offset > 0 && request.headers.count("Range") == 0) {
             request.headers["Range"] = "bytes=" + boost::lexical_cast<std::string>(offset) + "-";
         }
 
@@ -110,10 +127,22 @@ namespace carto {
         std::uint64_t contentOffset = 0;
         std::uint64_t contentLength = std::numeric_limits<std::uint64_t>::max();
 
+        // If called from a task, abort the request once the task is canceled. Callbacks may be called from other threads, so capture the task here.
+        const CancelableTask* task = CancelableTask::GetCurrentTask();
+
         auto headersFn = [&](int statusCode, const std::map<std::string, std::string>& headers) {
+            if (task && task->isCanceled()) {
+                return false;
+            }
+
             response.statusCode = statusCode;
             response.headers.insert(headers.begin(), headers.end());
 
+            // If the range request was ignored, the content starts from the beginning
+            if (statusCode == 200) {
+                offset = 0;
+            }
+
             // Read Content-Range
             if (statusCode == 206) {
                 auto it = response.headers.find("Content-Range");
@@ -142,13 +171,26 @@ namespace carto {
 
         std::uint64_t originalOffset = offset;
         auto dataFn = [&](const unsigned char* data, std::size_t size) {
+            if (task && task->isCanceled()) {
+                return false;
+            }
+
             bool result = handlerFn(offset, contentOffset + contentLength, data, size);
             offset += size;
+            _receivedBytes += size;
             return result;
         };
 
-        if (!_impl->makeRequest(request, headersFn, dataFn)) {
-            return -1; // request was cancelled
+        _requestCount++;
+        try {
+            if (!_impl->makeRequest(request, headersFn, dataFn)) {
+                _failedRequestCount++;
+                return -1; // request was cancelled
+            }
+        }
+        catch (...) {
+            _failedRequestCount++;
+            throw;
         }
 
         if (response.statusCode >= 300 && response.statusCode < 400) {
@@ -165,7 +207,11 @@ namespace carto {
             }
         }
 
+        if (response.statusCode == 304) {
+            return response.statusCode; // not modified, response to a conditional request
+        }
         if (response.statusCode < 200 || response.statusCode >= 300) {
+            _failedRequestCount++;
             if (_log) {
                 Log::Errorf("HTTPClient::makeRequest: Bad status code: %d, URL: %s", response.statusCode, request.url.c_str());
             }
@@ -175,7 +221,20 @@ namespace carto {
         return 0;
     }
 
+    HTTPClient::Impl::Impl() :
+        _openedConnectionCount(0),
+        _reusedConnectionCount(0),
+        _multiplexedRequestCount(0)
+    {
+    }
+
     HTTPClient::Impl::~Impl() {
     }
 
+    void HTTPClient::Impl::getConnectionStatistics(Statistics& stats) const {
+        stats.openedConnectionCount = _openedConnectionCount.load();
+        stats.reusedConnectionCount = _reusedConnectionCount.load();
+        stats.multiplexedRequestCount = _multiplexedRequestCount.load();
+    }
+
 }
@@ -7,6 +7,7 @@
 #ifndef _CARTO_HTTPCLIENT_H_
 #define _CARTO_HTTPCLIENT_H_
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <map>
@@ -22,9 +23,23 @@ namespace carto {
     public:
         typedef std::function<bool(std::uint64_t, std::uint64_t, const unsigned char*, std::size_t)> HandlerFunc;
 
+        struct Statistics {
+            std::uint64_t requestCount;
+            std::uint64_t failedRequestCount;
+            std::uint64_t receivedBytes;
+            std::uint64_t openedConnectionCount; // only counted if supported by the platform implementation
+            std::uint64_t reusedConnectionCount; // only counted if supported by the platform implementation
+            std::uint64_t multiplexedRequestCount; // HTTP/2 requests, only counted if supported by the platform implementation
+
+            Statistics() : requestCount(0), failedRequestCount(0), receivedBytes(0), openedConnectionCount(0), reusedConnectionCount(0), multiplexedRequestCount(0) { }
+        };
+
         explicit HTTPClient(bool log);
 
         void setTimeout(int milliseconds);
+        void setMaxConnectionsPerHost(int maxConnections);
+
+        Statistics getStatistics() const;
 
         int get(const std::string& url, const std::map<std::string, std::string>& requestHeaders, std::map<std::string, std::string>& responseHeaders, std::shared_ptr<BinaryData>& responseData, int* statusCode = 0) const;
         int post(const std::string& url, const std::string& contentType, const std::shared_ptr<BinaryData>& requestData, const std::map<std::string, std::string>& requestHeaders, std::map<std::string, std::string>& responseHeaders, std::shared_ptr<BinaryData>& responseData);
@@ -71,7 +86,17 @@ namespace carto {
             virtual ~Impl();
 
             virtual void setTimeout(int milliseconds) = 0;
+            virtual void setMaxConnectionsPerHost(int maxConnections) = 0;
             virtual bool makeRequest(const HTTPClient::Request& request, HeadersFunc headersFn, DataFunc dataFn) const = 0;
+
+            void getConnectionStatistics(Statistics& stats) const;
+
+        protected:
+            Impl();
+
+            mutable std::atomic<std::uint64_t> _openedConnectionCount;
+            mutable std::atomic<std::uint64_t> _reusedConnectionCount;
+            mutable std::atomic<std::uint64_t> _multiplexedRequestCount;
         };
 
         class PionImpl;
@@ -83,6 +108,10 @@ namespace carto {
 
         bool _log;
         std::unique_ptr<Impl> _impl;
+
+        mutable std::atomic<std::uint64_t> _requestCount;
+        mutable std::atomic<std::uint64_t> _failedRequestCount;
+        mutable std::atomic<std::uint64_t> _receivedBytes;
     };
 
 }
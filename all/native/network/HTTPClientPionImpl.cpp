@@ -2,6 +2,7 @@
 #include "components/Exceptions.h"
 #include "utils/Log.h"
 
+#include <algorithm>
 #include <chrono>
 #include <limits>
 #include <regex>
@@ -13,11 +14,17 @@ namespace carto {
 
     HTTPClient::PionImpl::PionImpl(bool log) :
         _log(log),
+        _maxConnectionsPerHost(DEFAULT_MAX_CONNECTIONS_PER_HOST),
         _connectionMap(),
         _mutex()
     {
     }
 
+    void HTTPClient::PionImpl::setMaxConnectionsPerHost(int maxConnections) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _maxConnectionsPerHost = std::max(0, maxConnections);
+    }
+
     bool HTTPClient::PionImpl::makeRequest(const HTTPClient::Request& request, HeadersFunc headersFn, DataFunc dataFn) const {
         // Parse request URL
         std::string proto, host, path, query;
@@ -49,12 +56,12 @@ namespace carto {
                 continue;
             }
 
+            _reusedConnectionCount++;
             result = makeRequest(*connection, request, headersFn, dataFn);
 
             if (result) {
-                std::lock_guard<std::mutex> lock(_mutex);
                 if (request.method == "GET") {
-                    _connectionMap.insert(std::make_pair(connectionKey, connection));
+                    releaseConnection(connectionKey, connection);
                 }
                 return result;
             }
@@ -66,17 +73,25 @@ namespace carto {
             return false;
         }
 
+        _openedConnectionCount++;
         result = makeRequest(*connection, request, headersFn, dataFn);
 
         if (result) {
-            std::lock_guard<std::mutex> lock(_mutex);
             if (request.method == "GET") {
-                _connectionMap.insert(std::make_pair(connectionKey, connection));
+                releaseConnection(connectionKey, connection);
             }
         }
         return result;
     }
 
+    void HTTPClient::PionImpl::releaseConnection(const std::pair<std::string, int>& connectionKey, const std::shared_ptr<Connection>& connection) const {
+        // Keep the connection alive for subsequent requests, unless there are already enough idle connections to the host
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (static_cast<int>(_connectionMap.count(connectionKey)) < _maxConnectionsPerHost) {
+            _connectionMap.insert(std::make_pair(connectionKey, connection));
+        }
+    }
+
     bool HTTPClient::PionImpl::makeRequest(Connection& connection, const HTTPClient::Request& request, HeadersFunc headersFn, DataFunc dataFn) const {
         std::string url = request.url;
         std::string proto, host, path, query;
@@ -214,4 +229,6 @@ namespace carto {
         return maxRequests > 0 && (keepAliveTime == nullTime || keepAliveTime > std::chrono::steady_clock::now());
     }
 
+    const int HTTPClient::PionImpl::DEFAULT_MAX_CONNECTIONS_PER_HOST = 6;
+
 }
@@ -20,6 +20,7 @@ namespace carto {
     public:
         explicit PionImpl(bool log);
 
+        virtual void setMaxConnectionsPerHost(int maxConnections);
         virtual bool makeRequest(const HTTPClient::Request& request, HeadersFunc headersFn, DataFunc dataFn) const;
 
     private:
@@ -34,9 +35,13 @@ namespace carto {
             bool isValid() const;
         };
 
+        static const int DEFAULT_MAX_CONNECTIONS_PER_HOST;
+
         bool makeRequest(Connection& connection, const HTTPClient::Request& request, HeadersFunc headersFn, DataFunc dataFn) const;
+        void releaseConnection(const std::pair<std::string, int>& connectionKey, const std::shared_ptr<Connection>& connection) const;
 
         bool _log;
+        int _maxConnectionsPerHost;
         mutable std::multimap<std::pair<std::string, int>, std::shared_ptr<Connection> > _connectionMap;
         mutable std::mutex _mutex;
     };
@@ -0,0 +1,185 @@
+#include "ServiceResponseCache.h"
+#include "core/BinaryData.h"
+#include "network/HTTPClient.h"
+#include "utils/Log.h"
+
+#include <thread>
+#include <vector>
+
+namespace carto {
+
+    ServiceResponseCache& ServiceResponseCache::GetInstance() {
+        static ServiceResponseCache instance;
+        return instance;
+    }
+
+    ServiceResponseCache::~ServiceResponseCache() {
+        _memoryConsumer->detach();
+    }
+
+    std::size_t ServiceResponseCache::getCapacity() const {
+        return _memoryConsumer->getCapacity();
+    }
+
+    void ServiceResponseCache::setCapacity(std::size_t capacityInBytes) {
+        _memoryConsumer->setCapacity(capacityInBytes);
+    }
+
+    void ServiceResponseCache::clear() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _cache.clear();
+    }
+
+    int ServiceResponseCache::get(const HTTPClient& httpClient, const std::string& url, const std::map<std::string, std::string>& requestHeaders, std::shared_ptr<BinaryData>& responseData, const std::shared_ptr<Session>& session) {
+        unsigned int generation = (session ? ++session->_generation : 0);
+        auto isSuperseded = [&session, generation]() {
+            return session && session->_generation.load() != generation;
+        };
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (readEntry(url, responseData)) {
+                return 0;
+            }
+        }
+
+        // Wait for the next keystroke before sending the request
+        if (session) {
+            std::this_thread::sleep_for(DEBOUNCE_DELAY);
+            if (isSuperseded()) {
+                return REQUEST_SUPERSEDED;
+            }
+        }
+
+        std::shared_ptr<PendingRequest> pendingRequest;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            while (true) {
+                if (readEntry(url, responseData)) {
+                    return 0;
+                }
+
+                auto it = _pendingRequests.find(url);
+                if (it == _pendingRequests.end()) {
+                    pendingRequest = std::make_shared<PendingRequest>();
+                    _pendingRequests[url] = pendingRequest;
+                    break;
+                }
+
+                // Share the response of the identical request in flight. If it was canceled, retry.
+                std::shared_ptr<PendingRequest> otherRequest = it->second;
+                otherRequest->condition.wait(lock, [&otherRequest]() { return otherRequest->done; });
+                if (!otherRequest->canceled) {
+                    responseData = otherRequest->responseData;
+                    return otherRequest->code;
+                }
+                if (isSuperseded()) {
+                    return REQUEST_SUPERSEDED;
+                }
+            }
+        }
+
+        std::vector<unsigned char> content;
+        auto handlerFn = [&content, &isSuperseded](std::uint64_t offset, std::uint64_t length, const unsigned char* buf, std::size_t size) -> bool {
+            if (isSuperseded()) {
+                return false;
+            }
+            if (content.size() != offset) {
+                content.resize(static_cast<std::size_t>(offset));
+            }
+            content.insert(content.end(), buf, buf + size);
+            return true;
+        };
+
+        int code = -1;
+        try {
+            std::map<std::string, std::string> responseHeaders;
+            code = httpClient.streamResponse("GET", url, requestHeaders, responseHeaders, handlerFn, 0);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            pendingRequest->done = true;
+            pendingRequest->canceled = true;
+            _pendingRequests.erase(url);
+            pendingRequest->condition.notify_all();
+            throw;
+        }
+        responseData = std::make_shared<BinaryData>(std::move(content));
+        bool canceled = (code != 0 && isSuperseded()); // completed responses are kept even if superseded
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (code == 0) {
+                Entry entry;
+                entry.responseData = responseData;
+                entry.expirationTime = std::chrono::steady_clock::now() + MAX_AGE;
+                _cache.put(url, entry, responseData->size() + url.size());
+            }
+            pendingRequest->done = true;
+            pendingRequest->canceled = canceled;
+            pendingRequest->code = code;
+            pendingRequest->responseData = responseData;
+            _pendingRequests.erase(url);
+            pendingRequest->condition.notify_all();
+        }
+
+        return canceled ? REQUEST_SUPERSEDED : code;
+    }
+
+    int ServiceResponseCache::get(const std::string& url, std::string& responseString, const std::shared_ptr<Session>& session, bool log) {
+        HTTPClient httpClient(log);
+        std::shared_ptr<BinaryData> responseData;
+        int code = -1;
+        try {
+            code = get(httpClient, url, std::map<std::string, std::string>(), responseData, session);
+        }
+        catch (const std::exception& ex) {
+            if (log) {
+                Log::Errorf("ServiceResponseCache::get: Exception: %s", ex.what());
+            }
+        }
+        if (responseData) {
+            responseString = std::string(reinterpret_cast<const char*>(responseData->data()), responseData->size());
+        } else {
+            responseString.clear();
+        }
+        return code;
+    }
+
+    ServiceResponseCache::ServiceResponseCache() :
+        _cache(DEFAULT_CAPACITY),
+        _pendingRequests(),
+        _memoryConsumer(),
+        _mutex()
+    {
+        _memoryConsumer = MemoryGovernor::GetInstance().registerConsumer(DEFAULT_CAPACITY, 1.0f,
+            [this](std::size_t budget) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _cache.resize(budget);
+            },
+            [this](bool critical) {
+                clear();
+            }
+        );
+    }
+
+    bool ServiceResponseCache::readEntry(const std::string& url, std::shared_ptr<BinaryData>& responseData) {
+        Entry entry;
+        if (!_cache.read(url, entry)) {
+            return false;
+        }
+        if (std::chrono::steady_clock::now() >= entry.expirationTime) {
+            _cache.remove(url);
+            return false;
+        }
+        responseData = entry.responseData;
+        return true;
+    }
+
+    const int ServiceResponseCache::REQUEST_SUPERSEDED = -2;
+
+    const std::size_t ServiceResponseCache::DEFAULT_CAPACITY = 2 * 1024 * 1024;
+    const std::chrono::steady_clock::duration ServiceResponseCache::MAX_AGE = std::chrono::hours(1);
+    const std::chrono::steady_clock::duration ServiceResponseCache::DEBOUNCE_DELAY = std::chrono::milliseconds(150);
+
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_SERVICERESPONSECACHE_H_
+#define _CARTO_SERVICERESPONSECACHE_H_
+
+#include "components/MemoryGovernor.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <stdext/timed_lru_cache.h>
+
+namespace carto {
+    class BinaryData;
+    class HTTPClient;
+
+    /**
+     * Shared cache of online service (geocoding, routing) responses, keyed by request URL.
+     * Only successful responses are cached. Concurrent identical requests are sent only once,
+     * the other callers wait for the response of the first request.
+     * Requests made within an autocomplete session are debounced: each request supersedes the earlier
+     * requests of the same session, superseded requests are canceled before or while being sent.
+     */
+    class ServiceResponseCache {
+    public:
+        /**
+         * Autocomplete session, typically one per service instance.
+         */
+        class Session {
+        public:
+            Session() : _generation(0) { }
+
+        private:
+            friend class ServiceResponseCache;
+
+            std::atomic<unsigned int> _generation;
+        };
+
+        static ServiceResponseCache& GetInstance();
+
+        virtual ~ServiceResponseCache();
+
+        std::size_t getCapacity() const;
+        void setCapacity(std::size_t capacityInBytes);
+
+        void clear();
+
+        // Returns the cached response or makes a GET request using the client. The result code is the same as HTTPClient::get returns,
+        // or REQUEST_SUPERSEDED if a later request of the session superseded this one. The session can be null.
+        int get(const HTTPClient& httpClient, const std::string& url, const std::map<std::string, std::string>& requestHeaders, std::shared_ptr<BinaryData>& responseData, const std::shared_ptr<Session>& session);
+        // Same as above, using a new client and returning the response as a string. Exceptions are logged and reported as failures.
+        int get(const std::string& url, std::string& responseString, const std::shared_ptr<Session>& session, bool log);
+
+        static const int REQUEST_SUPERSEDED;
+
+    private:
+        struct Entry {
+            std::shared_ptr<BinaryData> responseData;
+            std::chrono::steady_clock::time_point expirationTime;
+        };
+
+        struct PendingRequest {
+            bool done;
+            bool canceled;
+            int code;
+            std::shared_ptr<BinaryData> responseData;
+            std::condition_variable condition;
+
+            PendingRequest() : done(false), canceled(false), code(-1), responseData(), condition() { }
+        };
+
+        ServiceResponseCache();
+
+        bool readEntry(const std::string& url, std::shared_ptr<BinaryData>& responseData);
+
+        static const std::size_t DEFAULT_CAPACITY;
+        static const std::chrono::steady_clock::duration MAX_AGE;
+        static const std::chrono::steady_clock::duration DEBOUNCE_DELAY;
+
+        cache::timed_lru_cache<std::string, Entry> _cache;
+        std::unordered_map<std::string, std::shared_ptr<PendingRequest> > _pendingRequests;
+        std::shared_ptr<MemoryGovernor::Consumer> _memoryConsumer;
+
+        mutable std::mutex _mutex;
+    };
+
+}
+
+#endif
@@ -9,13 +9,18 @@
 #include "packagemanager/handlers/PackageHandlerFactory.h"
 #include "utils/URLFileLoader.h"
 #include "utils/GeneralUtils.h"
+#include "utils/JSONUtils.h"
 #include "utils/Log.h"
+#include "utils/ThreadUtils.h"
+#include "utils/TraceUtils.h"
 
 #include <cstdint>
 #include <memory>
 #include <utility>
 #include <algorithm>
+#include <atomic>
 #include <limits>
+#include <numeric>
 #include <time.h>
 
 #include <boost/lexical_cast.hpp>
@@ -27,8 +32,6 @@
 #include <sqlite3ppext.h>
 
 #include <rapidjson/rapidjson.h>
-#include <rapidjson/writer.h>
-#include <rapidjson/stringbuffer.h>
 #include <rapidjson/document.h>
 
 #include <rc5.h>
@@ -40,10 +43,7 @@
 namespace {
 
     std::shared_ptr<carto::PackageMetaInfo> createPackageMetaInfo(const rapidjson::Value& value) {
-        rapidjson::StringBuffer metaInfo;
-        rapidjson::Writer<rapidjson::StringBuffer> writer(metaInfo);
-        value.Accept(writer);
-        carto::Variant var = carto::Variant::FromString(metaInfo.GetString());
+        carto::Variant var = carto::Variant::FromPicoJSON(carto::JSONUtils::ToPicoJSON(value));
         return std::make_shared<carto::PackageMetaInfo>(var);
     }
 
@@ -58,18 +58,22 @@ namespace carto {
         _serverEncKey(serverEncKey),
         _localEncKey(localEncKey),
         _localPackages(),
+        _localPackageIdMap(),
         _localDb(),
         _taskQueue(),
         _taskQueueCondition(),
         _packageManagerThread(),
+        _downloadThreads(),
         _onChangeListeners(),
         _stopped(true),
-        _prevTaskId(-1),
-        _prevAction(PackageAction::PACKAGE_ACTION_WAITING),
-        _prevRoundedProgress(0),
+        _downloadConcurrency(DEFAULT_DOWNLOAD_CONCURRENCY),
+        _downloadSegmentCount(1),
+        _runningTaskIds(),
+        _taskStatusMap(),
         _packageManagerListener(),
         _serverPackageCache(),
-        _packageHandlerCache(),
+        _serverPackageTileIndex(),
+        _localPackageSnapshot(),
         _mutex()
     {
         if (_packageListURL.empty()) {
@@ -110,7 +114,9 @@ namespace carto {
             }
         }
 
-        syncLocalPackages();
+        std::vector<std::shared_ptr<PackageInfo> > addedPackages;
+        std::vector<std::shared_ptr<PackageInfo> > removedPackages;
+        syncLocalPackages(addedPackages, removedPackages);
     }
 
     PackageManager::~PackageManager() {
@@ -135,6 +141,30 @@ namespace carto {
         _onChangeListeners.erase(std::remove(_onChangeListeners.begin(), _onChangeListeners.end(), listener), _onChangeListeners.end());
     }
 
+    int PackageManager::getDownloadConcurrency() const {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return _downloadConcurrency;
+    }
+
+    void PackageManager::setDownloadConcurrency(int concurrency) {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _downloadConcurrency = std::max(1, std::min(MAX_DOWNLOAD_CONCURRENCY, concurrency));
+        if (!_stopped) {
+            startDownloadWorkers();
+        }
+        _taskQueueCondition.notify_all();
+    }
+
+    int PackageManager::getDownloadSegmentCount() const {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return _downloadSegmentCount;
+    }
+
+    void PackageManager::setDownloadSegmentCount(int segmentCount) {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _downloadSegmentCount = std::max(1, std::min(MAX_DOWNLOAD_SEGMENT_COUNT, segmentCount));
+    }
+
     bool PackageManager::start() {
         if (!_localDb) {
             return false;
@@ -151,7 +181,8 @@ namespace carto {
 
         std::lock_guard<std::recursive_mutex> lock(_mutex);
         _stopped = false;
-        _packageManagerThread = std::make_shared<std::thread>(std::bind(&PackageManager::run, this));
+        _packageManagerThread = std::make_shared<std::thread>(std::bind(&PackageManager::run, this, false));
+        startDownloadWorkers();
         Log::Info("PackageManager: Package manager started");
         return true;
     }
@@ -162,6 +193,7 @@ namespace carto {
         }
 
         std::shared_ptr<std::thread> packageManagerThread;
+        std::vector<std::shared_ptr<std::thread> > downloadThreads;
         {
             std::lock_guard<std::recursive_mutex> lock(_mutex);
             if (!_stopped) {
@@ -170,13 +202,18 @@ namespace carto {
                 Log::Info("PackageManager: Stopping package manager");
             }
             packageManagerThread = _packageManagerThread;
+            downloadThreads = _downloadThreads;
         }
 
         if (packageManagerThread && wait) {
             packageManagerThread->join();
+            for (const std::shared_ptr<std::thread>& downloadThread : downloadThreads) {
+                downloadThread->join();
+            }
 
             std::lock_guard<std::recursive_mutex> lock(_mutex);
             _packageManagerThread.reset();
+            _downloadThreads.clear();
             Log::Info("PackageManager: Package manager stopped");
         }
     }
@@ -211,8 +248,9 @@ namespace carto {
                 if (packageListJson.empty()) {
                     return std::vector<std::shared_ptr<PackageInfo> >();
                 }
+                // Parse in-situ, the document strings refer directly to the JSON buffer
                 rapidjson::Document packageListDoc;
-                if (packageListDoc.Parse<rapidjson::kParseDefaultFlags>(packageListJson.c_str()).HasParseError()) {
+                if (packageListDoc.ParseInsitu<rapidjson::kParseDefaultFlags>(&packageListJson[0]).HasParseError()) {
                     throw PackageException(PackageErrorType::PACKAGE_ERROR_TYPE_SYSTEM, "Error while parsing package list");
                 }
 
@@ -263,7 +301,7 @@ namespace carto {
                 return std::shared_ptr<PackageMetaInfo>();
             }
             rapidjson::Document packageListDoc;
-            if (packageListDoc.Parse<rapidjson::kParseDefaultFlags>(packageListJson.c_str()).HasParseError()) {
+            if (packageListDoc.ParseInsitu<rapidjson::kParseDefaultFlags>(&packageListJson[0]).HasParseError()) {
                 throw PackageException(PackageErrorType::PACKAGE_ERROR_TYPE_SYSTEM, "Error while parsing package list");
             }
             if (packageListDoc.HasMember("metainfo")) {
@@ -340,26 +378,52 @@ namespace carto {
         return std::shared_ptr<PackageStatus>();
     }
 
-    void PackageManager::accessLocalPackages(const std::function<void(const std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> >&)>& callback) const {
+    std::shared_ptr<const PackageManager::LocalPackageSnapshot> PackageManager::getLocalPackageSnapshot() const {
+        std::shared_ptr<const LocalPackageSnapshot> snapshot = std::atomic_load(&_localPackageSnapshot);
+        if (snapshot) {
+            return snapshot;
+        }
+
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        snapshot = std::atomic_load(&_localPackageSnapshot);
+        if (snapshot) {
+            return snapshot;
+        }
+
+        snapshot = createLocalPackageSnapshot(std::shared_ptr<const LocalPackageSnapshot>());
+        std::atomic_store(&_localPackageSnapshot, snapshot);
+        return snapshot;
+    }
+
+    std::shared_ptr<const PackageManager::LocalPackageSnapshot> PackageManager::createLocalPackageSnapshot(const std::shared_ptr<const LocalPackageSnapshot>& prevSnapshot) const {
         std::lock_guard<std::recursive_mutex> lock(_mutex);
 
-        // Create instances to all open files
-        std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> > packageHandlerMap;
+        // Reuse the handlers of unchanged packages, create instances only for the new packages
+        std::vector<std::pair<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> > > packageHandlers;
         for (const std::shared_ptr<PackageInfo>& packageInfo : _localPackages) {
-            auto it = _packageHandlerCache.find(packageInfo);
-            if (it == _packageHandlerCache.end()) {
-                std::string fileName = createLocalFilePath(createPackageFileName(packageInfo->getPackageId(), packageInfo->getPackageType(), packageInfo->getVersion()));
-                auto handler = PackageHandlerFactory(_serverEncKey, _localEncKey).createPackageHandler(packageInfo->getPackageType(), fileName);
-                if (!handler) {
+            if (prevSnapshot) {
+                auto it = prevSnapshot->getPackageHandlerMap().find(packageInfo);
+                if (it != prevSnapshot->getPackageHandlerMap().end()) {
+                    packageHandlers.push_back(*it);
                     continue;
                 }
-                it = _packageHandlerCache.insert(std::make_pair(packageInfo, handler)).first;
             }
-            packageHandlerMap[packageInfo] = it->second;
+            std::string fileName = createLocalFilePath(createPackageFileName(packageInfo->getPackageId(), packageInfo->getPackageType(), packageInfo->getVersion()));
+            auto handler = PackageHandlerFactory(_serverEncKey, _localEncKey).createPackageHandler(packageInfo->getPackageType(), fileName);
+            if (!handler) {
+                continue;
+            }
+            packageHandlers.emplace_back(packageInfo, handler);
         }
 
+        return std::make_shared<LocalPackageSnapshot>(packageHandlers);
+    }
+
+    void PackageManager::accessLocalPackages(const std::function<void(const std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> >&)>& callback) const {
+        std::shared_ptr<const LocalPackageSnapshot> snapshot = getLocalPackageSnapshot();
+
         // Use the callback
-        callback(packageHandlerMap);
+        callback(snapshot->getPackageHandlerMap());
     }
     
     std::vector<std::shared_ptr<PackageInfo> > PackageManager::suggestPackages(const MapPos& mapPos, const std::shared_ptr<Projection>& projection) const {
@@ -371,22 +435,45 @@ namespace carto {
             throw NullArgumentException("Null projection");
         }
 
+        // Get server packages and the tile index of the packages, build the index once per package list
+        std::vector<std::shared_ptr<PackageInfo> > serverPackages;
+        std::shared_ptr<const PackageTileIndex> tileIndex;
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            serverPackages = getServerPackages();
+            if (!_serverPackageTileIndex) {
+                std::vector<std::shared_ptr<PackageTileMask> > tileMasks;
+                tileMasks.reserve(serverPackages.size());
+                for (const std::shared_ptr<PackageInfo>& packageInfo : serverPackages) {
+                    tileMasks.push_back(packageInfo->getTileMask());
+                }
+                _serverPackageTileIndex = std::make_shared<PackageTileIndex>(tileMasks);
+            }
+            tileIndex = _serverPackageTileIndex;
+        }
+
         // Detect zoom level from tile masks
         int zoom = 0;
-        for (const std::shared_ptr<PackageInfo>& packageInfo : getServerPackages()) {
-            zoom = std::max(zoom, packageInfo->getTileMask()->getMaxZoomLevel());
+        for (const std::shared_ptr<PackageInfo>& packageInfo : serverPackages) {
+            if (packageInfo->getTileMask()) {
+                zoom = std::max(zoom, packageInfo->getTileMask()->getMaxZoomLevel());
+            }
         }
 
         // Calculate map tile from the map position
         MapTile mapTile = CalculateMapTile(mapPos, zoom, projection);
 
-        // Find tile statuses from all packages. Keep only packages where the tile exists
+        // Find tile statuses from the packages that may contain the tile. Keep only packages where the tile exists
         std::vector<std::pair<std::shared_ptr<PackageInfo>, PackageTileStatus::PackageTileStatus> > packageTileStatuses;
         while (true) {
-            for (const std::shared_ptr<PackageInfo>& packageInfo : getServerPackages()) {
-                PackageTileStatus::PackageTileStatus status = packageInfo->getTileMask()->getTileStatus(mapTile);
+            for (int packageIndex : tileIndex->findPackages(mapTile)) {
+                const std::shared_ptr<PackageInfo>& packageInfo = serverPackages[packageIndex];
+                PackageTileStatus::PackageTileStatus status = PackageTileStatus::PACKAGE_TILE_STATUS_PARTIAL;
+                if (packageInfo->getTileMask()) {
+                    status = packageInfo->getTileMask()->getTileStatus(mapTile);
+                }
                 if (status != PackageTileStatus::PACKAGE_TILE_STATUS_MISSING) {
-                    packageTileStatuses.emplace_back(packageInfo, packageInfo->getTileMask()->getTileStatus(mapTile));
+                    packageTileStatuses.emplace_back(packageInfo, status);
                 }
             }
             if (!packageTileStatuses.empty() || mapTile.getZoom() == 0) {
@@ -421,18 +508,19 @@ namespace carto {
             throw NullArgumentException("Null projection");
         }
 
-        // Get local packages
-        std::vector<std::shared_ptr<PackageInfo> > localPackages = getLocalPackages();
+        // Use the tile index of the local package snapshot to find the candidate packages for each tile
+        std::shared_ptr<const LocalPackageSnapshot> snapshot = getLocalPackageSnapshot();
 
         // Calculate tile extents
         MapTile mapTile1 = CalculateMapTile(mapBounds.getMin(), zoom, projection);
         MapTile mapTile2 = CalculateMapTile(mapBounds.getMax(), zoom, projection);
         for (int y = std::min(mapTile1.getY(), mapTile2.getY()); y <= std::max(mapTile1.getY(), mapTile2.getY()); y++) {
             for (int x = std::min(mapTile1.getX(), mapTile2.getX()); x <= std::max(mapTile1.getX(), mapTile2.getX()); x++) {
+                MapTile mapTile(x, y, zoom, 0);
                 bool found = false;
-                for (std::size_t i = 0; i < localPackages.size(); i++) {
-                    if (localPackages[i]->getTileMask()->getTileStatus(MapTile(x, y, zoom, 0)) == PackageTileStatus::PACKAGE_TILE_STATUS_FULL) {
-                        std::rotate(localPackages.begin(), localPackages.begin() + i, localPackages.begin() + i + 1);
+                for (const std::pair<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> >& packageHandler : snapshot->findTilePackageHandlers(mapTile)) {
+                    const std::shared_ptr<PackageTileMask>& tileMask = packageHandler.first->getTileMask();
+                    if (tileMask && tileMask->getTileStatus(mapTile) == PackageTileStatus::PACKAGE_TILE_STATUS_FULL) {
                         found = true;
                         break;
                     }
@@ -456,7 +544,7 @@ namespace carto {
             int taskId = _taskQueue->scheduleTask(downloadTask);
             _taskQueue->setTaskPriority(taskId, std::numeric_limits<int>::max());
             updateTaskStatus(taskId, PackageAction::PACKAGE_ACTION_WAITING, 0);
-            _taskQueueCondition.notify_one();
+            _taskQueueCondition.notify_all();
             return true;
         }
         catch (const std::exception& ex) {
@@ -479,7 +567,7 @@ namespace carto {
             importTask.packageLocation = packageFileName;
             int taskId = _taskQueue->scheduleTask(importTask);
             updateTaskStatus(taskId, PackageAction::PACKAGE_ACTION_WAITING, 0);
-            _taskQueueCondition.notify_one();
+            _taskQueueCondition.notify_all();
             return true;
         }
         catch (const std::exception& ex) {
@@ -522,7 +610,7 @@ namespace carto {
             downloadTask.packageLocation = package->getServerURL();
             int taskId = _taskQueue->scheduleTask(downloadTask);
             updateTaskStatus(taskId, PackageAction::PACKAGE_ACTION_WAITING, 0);
-            _taskQueueCondition.notify_one();
+            _taskQueueCondition.notify_all();
             return true;
         }
         catch (const std::exception& ex) {
@@ -542,7 +630,7 @@ namespace carto {
                 if (task.packageId == packageId) {
                     _taskQueue->cancelTask(taskId);
                     updateTaskStatus(taskId, task.action, task.progress / 100.0f);
-                    _taskQueueCondition.notify_one();
+                    _taskQueueCondition.notify_all();
                 }
             }
         }
@@ -585,7 +673,7 @@ namespace carto {
             removeTask.packageVersion = package->getVersion();
             int taskId = _taskQueue->scheduleTask(removeTask);
             updateTaskStatus(taskId, PackageAction::PACKAGE_ACTION_WAITING, 0);
-            _taskQueueCondition.notify_one();
+            _taskQueueCondition.notify_all();
             return true;
         }
         catch (const std::exception& ex) {
@@ -605,7 +693,7 @@ namespace carto {
                 if (task.packageId == packageId) {
                     _taskQueue->setTaskPriority(taskId, priority);
                     updateTaskStatus(taskId, task.action, task.progress / 100.0f);
-                    _taskQueueCondition.notify_one();
+                    _taskQueueCondition.notify_all();
                 }
             }
         }
@@ -626,7 +714,7 @@ namespace carto {
             int taskId = _taskQueue->scheduleTask(downloadTask);
             _taskQueue->setTaskPriority(taskId, std::numeric_limits<int>::max());
             updateTaskStatus(taskId, PackageAction::PACKAGE_ACTION_WAITING, 0);
-            _taskQueueCondition.notify_one();
+            _taskQueueCondition.notify_all();
             return true;
         }
         catch (const std::exception& ex) {
@@ -635,7 +723,8 @@ namespace carto {
         return false;
     }
 
-    void PackageManager::run() {
+    void PackageManager::run(bool downloadWorker) {
+        ThreadUtils::SetThreadRole(ThreadRole::BULK);
         try {
             while (true) {
                 int taskId = -1;
@@ -644,11 +733,17 @@ namespace carto {
                     if (_stopped) {
                         break;
                     }
-                    taskId = _taskQueue->getActiveTaskId();
+                    for (int activeTaskId : getActiveTaskIds(downloadWorker)) {
+                        if (_runningTaskIds.find(activeTaskId) == _runningTaskIds.end()) {
+                            taskId = activeTaskId;
+                            break;
+                        }
+                    }
                     if (taskId == -1) {
                         _taskQueueCondition.wait(lock);
                         continue;
                     }
+                    _runningTaskIds.insert(taskId);
                 }
                 try {
                     Task::Command command = _taskQueue->getTask(taskId).command;
@@ -695,6 +790,14 @@ namespace carto {
                     setTaskFailed(taskId, PackageErrorType::PACKAGE_ERROR_TYPE_SYSTEM);
                     Log::Errorf("PackageManager: Exception while executing task: %s", ex.what());
                 }
+
+                // Release the task, other workers may be waiting for it
+                {
+                    std::lock_guard<std::recursive_mutex> lock(_mutex);
+                    _runningTaskIds.erase(taskId);
+                    _taskStatusMap.erase(taskId);
+                    _taskQueueCondition.notify_all();
+                }
             }
         }
         catch (const std::exception& ex) {
@@ -702,7 +805,32 @@ namespace carto {
         }
     }
 
+    void PackageManager::startDownloadWorkers() {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        while (static_cast<int>(_downloadThreads.size()) < _downloadConcurrency) {
+            _downloadThreads.push_back(std::make_shared<std::thread>(std::bind(&PackageManager::run, this, true)));
+        }
+    }
+
+    std::vector<int> PackageManager::getActiveTaskIds(bool downloadTasks) const {
+        // Take the tasks with highest priority of the given kind. Package downloads can be processed concurrently, other tasks are processed one at a time.
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        std::size_t maxTaskCount = downloadTasks ? static_cast<std::size_t>(_downloadConcurrency) : 1;
+        std::vector<int> activeTaskIds;
+        for (int taskId : _taskQueue->getActiveTaskIds(_runningTaskIds)) {
+            if (activeTaskIds.size() >= maxTaskCount) {
+                break;
+            }
+            if (IsDownloadTask(_taskQueue->getTask(taskId).command) == downloadTasks) {
+                activeTaskIds.push_back(taskId);
+            }
+        }
+        return activeTaskIds;
+    }
+
     bool PackageManager::downloadPackageList(int taskId) {
+        CARTO_TRACE_SECTION("PackageManager::downloadPackageList");
+
         // Download package list data
         std::vector<unsigned char> packageListData;
         for (int retry = 0; true; retry++) {
@@ -781,6 +909,8 @@ namespace carto {
     }
 
     bool PackageManager::importPackage(int taskId) {
+        CARTO_TRACE_SECTION("PackageManager::importPackage");
+
         Task task = _taskQueue->getTask(taskId);
 
         // Check if the package is already imported
@@ -881,6 +1011,8 @@ namespace carto {
     }
 
     bool PackageManager::downloadPackage(int taskId) {
+        CARTO_TRACE_SECTION("PackageManager::downloadPackage");
+
         Task task = _taskQueue->getTask(taskId);
 
         // Find the package info
@@ -918,8 +1050,19 @@ namespace carto {
         bool packageSizeIndeterminate = package->getSize() == 0;
         std::string packageFileName = createLocalFilePath(createPackageFileName(task.packageId, task.packageType, task.packageVersion));
         try {
+            // If an older version is installed, try to update it using a delta package first
+            bool packageDownloaded = false;
+            if (downloaded) {
+                packageDownloaded = downloadPackageDelta(taskId, task, packageFileName);
+            }
+
+            // Try segmented download next, it is used only for large packages of known size
+            if (!packageDownloaded && !packageSizeIndeterminate) {
+                packageDownloaded = downloadPackageSegments(taskId, task, package, downloaded, packageFileName);
+            }
+
             // Try to download the package
-            for (int retry = 0; true; retry++) {
+            for (int retry = 0; !packageDownloaded; retry++) {
                 if (retry > 0) {
                     utf8_filesystem::unlink(packageFileName.c_str());
                     Log::Infof("PackageManager: Retrying package %s download", task.packageId.c_str());
@@ -985,18 +1128,7 @@ namespace carto {
                     throw PauseException();
                 }
                 if (retry > 0) {
-                    switch (errorCode) {
-                    case 402: // Payment required
-                        throw PackageException(PackageErrorType::PACKAGE_ERROR_TYPE_DOWNLOAD_LIMIT_EXCEEDED, "Subscription limit exceeded while downloading: " + task.packageId);
-                    case 403: // Forbidden
-                        throw PackageException(PackageErrorType::PACKAGE_ERROR_TYPE_NO_OFFLINE_PLAN, "Offline packages not available");
-                        break;
-                    case 406: // Not acceptable
-                        throw PackageException(PackageErrorType::PACKAGE_ERROR_TYPE_PACKAGE_TOO_BIG, "Package contains too many tiles: " + task.packageId);
-                        break;
-                    default:
-                        throw PackageException(errorCode < 0 ? PackageErrorType::PACKAGE_ERROR_TYPE_CONNECTION : PackageErrorType::PACKAGE_ERROR_TYPE_SYSTEM, "Failed to download package " + task.packageId);
-                    }
+                    throw CreateDownloadException(errorCode, task.packageId);
                 }
             }
 
@@ -1010,37 +1142,40 @@ namespace carto {
                 for (auto qit = query.begin(); qit != query.end(); qit++) {
                     id = qit->get<int>(0);
                 }
-                if (id == -1) {
-                    std::string metaInfo;
-                    if (package->getMetaInfo()) {
-                        metaInfo = package->getMetaInfo()->getVariant().toString();
-                    }
-                    std::string tileMaskValue;
-                    if (package->getTileMask()) {
-                        tileMaskValue = EncodeTileMask(package->getTileMask());
-                    } else if (auto handler = PackageHandlerFactory(_serverEncKey, _localEncKey).createPackageHandler(task.packageType, packageFileName)) {
-                        tileMaskValue = EncodeTileMask(handler->calculateTileMask());
-                    }
-                    std::uint64_t fileSize = package->getSize();
-                    if (packageSizeIndeterminate) {
-                        FILE* fpRaw = utf8_filesystem::fopen(packageFileName.c_str(), "rb");
-                        if (fpRaw) {
-                            std::shared_ptr<FILE> fp(fpRaw, fclose);
-                            utf8_filesystem::fseek64(fp.get(), 0, SEEK_END);
-                            fileSize = utf8_filesystem::ftell64(fp.get());
-                        }
+            }
+            if (id == -1) {
+                // Calculate the tile mask without holding the manager lock, this may take a while for big packages
+                std::string tileMaskValue;
+                if (package->getTileMask()) {
+                    tileMaskValue = EncodeTileMask(package->getTileMask());
+                } else if (auto handler = PackageHandlerFactory(_serverEncKey, _localEncKey).createPackageHandler(task.packageType, packageFileName)) {
+                    tileMaskValue = EncodeTileMask(handler->calculateTileMask());
+                }
+
+                std::lock_guard<std::recursive_mutex> lock(_mutex);
+                std::string metaInfo;
+                if (package->getMetaInfo()) {
+                    metaInfo = package->getMetaInfo()->getVariant().toString();
+                }
+                std::uint64_t fileSize = package->getSize();
+                if (packageSizeIndeterminate) {
+                    FILE* fpRaw = utf8_filesystem::fopen(packageFileName.c_str(), "rb");
+                    if (fpRaw) {
+                        std::shared_ptr<FILE> fp(fpRaw, fclose);
+                        utf8_filesystem::fseek64(fp.get(), 0, SEEK_END);
+                        fileSize = utf8_filesystem::ftell64(fp.get());
                     }
-                    sqlite3pp::command command(*_localDb, "INSERT INTO packages(package_id, package_type, version, size, server_url, tile_mask, metainfo, valid) VALUES(:package_id, :package_type, :version, :size, :server_url, :tile_mask, :metainfo, 0)");
-                    command.bind(":package_id", package->getPackageId().c_str());
-                    command.bind(":package_type", static_cast<int>(package->getPackageType()));
-                    command.bind(":version", package->getVersion());
-                    command.bind(":size", fileSize);
-                    command.bind(":server_url", package->getServerURL().c_str());
-                    command.bind(":tile_mask", tileMaskValue.c_str());
-                    command.bind(":metainfo", metaInfo.c_str());
-                    command.execute();
-                    id = static_cast<int>(_localDb->last_insert_rowid());
                 }
+                sqlite3pp::command command(*_localDb, "INSERT INTO packages(package_id, package_type, version, size, server_url, tile_mask, metainfo, valid) VALUES(:package_id, :package_type, :version, :size, :server_url, :tile_mask, :metainfo, 0)");
+                command.bind(":package_id", package->getPackageId().c_str());
+                command.bind(":package_type", static_cast<int>(package->getPackageType()));
+                command.bind(":version", package->getVersion());
+                command.bind(":size", fileSize);
+                command.bind(":server_url", package->getServerURL().c_str());
+                command.bind(":tile_mask", tileMaskValue.c_str());
+                command.bind(":metainfo", metaInfo.c_str());
+                command.execute();
+                id = static_cast<int>(_localDb->last_insert_rowid());
             }
 
             // Import download package
@@ -1050,10 +1185,12 @@ namespace carto {
             throw;
         }
         catch (const CancelException&) {
+            deletePackageSegments(task.packageId, task.packageVersion);
             utf8_filesystem::unlink(packageFileName.c_str());
             throw;
         }
         catch (...) {
+            deletePackageSegments(task.packageId, task.packageVersion);
             utf8_filesystem::unlink(packageFileName.c_str());
             throw;
         }
@@ -1062,7 +1199,324 @@ namespace carto {
         return true;
     }
 
+    bool PackageManager::downloadPackageDelta(int taskId, const Task& task, const std::string& packageFileName) {
+        CARTO_TRACE_SECTION("PackageManager::downloadPackageDelta");
+
+        // Find the currently installed version of the package, the delta is applied on top of it
+        int baseVersion = -1;
+        PackageType::PackageType basePackageType = task.packageType;
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            sqlite3pp::query query(*_localDb, "SELECT version, package_type FROM packages WHERE package_id=:package_id AND valid=1");
+            query.bind(":package_id", task.packageId.c_str());
+            for (auto qit = query.begin(); qit != query.end(); qit++) {
+                baseVersion = qit->get<int>(0);
+                basePackageType = static_cast<PackageType::PackageType>(qit->get<int>(1));
+            }
+        }
+        if (baseVersion == -1 || baseVersion == task.packageVersion || basePackageType != task.packageType) {
+            return false;
+        }
+
+        std::string deltaURL = createPackageDeltaURL(task.packageId, baseVersion, task.packageVersion, task.packageLocation);
+        if (deltaURL.empty()) {
+            return false;
+        }
+
+        std::string baseFileName = createLocalFilePath(createPackageFileName(task.packageId, basePackageType, baseVersion));
+        std::string deltaFileName = packageFileName + ".delta";
+        try {
+            // Download the delta package
+            {
+                FILE* fpRaw = utf8_filesystem::fopen(deltaFileName.c_str(), "wb");
+                if (!fpRaw) {
+                    throw PackageException(PackageErrorType::PACKAGE_ERROR_TYPE_SYSTEM, std::string("Could not create delta package file ") + deltaFileName);
+                }
+                std::shared_ptr<FILE> fp(fpRaw, fclose);
+
+                std::uint64_t fileOffset = 0;
+                int errorCode = DownloadFile(deltaURL, [this, fp, taskId, &deltaFileName, &fileOffset](std::uint64_t offset, std::uint64_t length, const unsigned char* buf, std::size_t size) {
+                    if (isTaskCancelled(taskId)) {
+                        return false;
+                    }
+                    if (isTaskPaused(taskId)) {
+                        return false;
+                    }
+
+                    if (offset != fileOffset) {
+                        utf8_filesystem::fseek64(fp.get(), offset, SEEK_SET);
+                        utf8_filesystem::ftruncate64(fp.get(), offset);
+                    }
+                    if (fwrite(buf, sizeof(unsigned char), size, fp.get()) != size) {
+                        Log::Errorf("PackageManager: Storage full? Could not write to delta package file %s", deltaFileName.c_str());
+                        return false;
+                    }
+                    fileOffset = offset + size;
+                    if (length > 0 && length != std::numeric_limits<std::uint64_t>::max()) {
+                        updateTaskStatus(taskId, PackageAction::PACKAGE_ACTION_DOWNLOADING, static_cast<float>(fileOffset) / static_cast<float>(length));
+                    }
+                    return true;
+                });
+
+                if (errorCode != 0) {
+                    if (isTaskCancelled(taskId)) {
+                        throw CancelException();
+                    }
+                    if (isTaskPaused(taskId)) {
+                        throw PauseException();
+                    }
+                    Log::Infof("PackageManager: Delta package not available for package %s, downloading full package", task.packageId.c_str());
+                    fp.reset();
+                    utf8_filesystem::unlink(deltaFileName.c_str());
+                    return false;
+                }
+            }
+
+            // Copy the installed package and apply the delta to the copy, the installed package stays usable meanwhile
+            {
+                FILE* fpSrcRaw = utf8_filesystem::fopen(baseFileName.c_str(), "rb");
+                if (!fpSrcRaw) {
+                    throw PackageException(PackageErrorType::PACKAGE_ERROR_TYPE_SYSTEM, std::string("Could not open package file ") + baseFileName);
+                }
+                std::shared_ptr<FILE> fpSrc(fpSrcRaw, fclose);
+                FILE* fpDestRaw = utf8_filesystem::fopen(packageFileName.c_str(), "wb");
+                if (!fpDestRaw) {
+                    throw PackageException(PackageErrorType::PACKAGE_ERROR_TYPE_SYSTEM, std::string("Could not create file ") + packageFileName);
+                }
+                std::shared_ptr<FILE> fpDest(fpDestRaw, fclose);
+
+                std::vector<unsigned char> buf(1024 * 1024);
+                while (std::size_t size = fread(buf.data(), sizeof(unsigned char), buf.size(), fpSrc.get())) {
+                    if (fwrite(buf.data(), sizeof(unsigned char), size, fpDest.get()) != size) {
+                        throw PackageException(PackageErrorType::PACKAGE_ERROR_TYPE_SYSTEM, std::string("Could not write to package file ") + packageFileName);
+                    }
+                }
+            }
+
+            std::shared_ptr<PackageHandler> handler = PackageHandlerFactory(_serverEncKey, _localEncKey).createPackageHandler(task.packageType, packageFileName);
+            if (!handler || !handler->applyDeltaPackage(deltaFileName)) {
+                Log::Warnf("PackageManager: Failed to apply delta package to package %s, downloading full package", task.packageId.c_str());
+                utf8_filesystem::unlink(packageFileName.c_str());
+                utf8_filesystem::unlink(deltaFileName.c_str());
+                return false;
+            }
+        }
+        catch (...) {
+            utf8_filesystem::unlink(deltaFileName.c_str());
+            throw;
+        }
+        utf8_filesystem::unlink(deltaFileName.c_str());
+
+        updateTaskStatus(taskId, PackageAction::PACKAGE_ACTION_DOWNLOADING, 1.0f);
+        Log::Infof("PackageManager: Package %s updated from version %d using delta package", task.packageId.c_str(), baseVersion);
+        return true;
+    }
+
+    bool PackageManager::downloadPackageSegments(int taskId, const Task& task, const std::shared_ptr<PackageInfo>& package, bool downloaded, const std::string& packageFileName) {
+        CARTO_TRACE_SECTION("PackageManager::downloadPackageSegments");
+
+        std::uint64_t fileSize = package->getSize();
+
+        // Load the segments of a previously started segmented download
+        std::vector<std::pair<std::uint64_t, std::uint64_t> > segmentRanges;
+        std::vector<std::uint64_t> segmentSizes;
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            sqlite3pp::query query(*_localDb, "SELECT start_offset, end_offset, downloaded FROM package_segments WHERE package_id=:package_id AND version=:version ORDER BY start_offset ASC");
+            query.bind(":package_id", task.packageId.c_str());
+            query.bind(":version", task.packageVersion);
+            for (auto qit = query.begin(); qit != query.end(); qit++) {
+                segmentRanges.emplace_back(qit->get<std::uint64_t>(0), qit->get<std::uint64_t>(1));
+                segmentSizes.push_back(qit->get<std::uint64_t>(2));
+            }
+        }
+        if (!segmentRanges.empty() && segmentRanges.back().second != fileSize) {
+            Log::Infof("PackageManager: Package %s size changed, restarting segmented download", task.packageId.c_str());
+            deletePackageSegments(task.packageId, task.packageVersion);
+            utf8_filesystem::unlink(packageFileName.c_str());
+            segmentRanges.clear();
+            segmentSizes.clear();
+        }
+
+        // If there is no segmented download in progress, check if a new one should be started
+        if (segmentRanges.empty()) {
+            int segmentCount = getDownloadSegmentCount();
+            if (segmentCount < 2 || fileSize < MIN_SEGMENTED_DOWNLOAD_SIZE) {
+                return false;
+            }
+
+            // Do not discard a partially downloaded file, continue it using a single request instead
+            if (FILE* fpRaw = utf8_filesystem::fopen(packageFileName.c_str(), "rb")) {
+                std::shared_ptr<FILE> fp(fpRaw, fclose);
+                utf8_filesystem::fseek64(fp.get(), 0, SEEK_END);
+                if (utf8_filesystem::ftell64(fp.get()) > 0) {
+                    return false;
+                }
+            }
+
+            // Preallocate the file, so that segments can be written to their own regions
+            {
+                FILE* fpRaw = utf8_filesystem::fopen(packageFileName.c_str(), "wb");
+                if (!fpRaw) {
+                    throw PackageException(PackageErrorType::PACKAGE_ERROR_TYPE_SYSTEM, std::string("Could not create download package file ") + packageFileName);
+                }
+                std::shared_ptr<FILE> fp(fpRaw, fclose);
+                if (utf8_filesystem::ftruncate64(fp.get(), fileSize) != 0) {
+                    throw PackageException(PackageErrorType::PACKAGE_ERROR_TYPE_SYSTEM, std::string("Could not allocate download package file ") + packageFileName);
+                }
+            }
+
+            std::uint64_t segmentSize = (fileSize + segmentCount - 1) / segmentCount;
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            for (std::uint64_t startOffset = 0; startOffset < fileSize; startOffset += segmentSize) {
+                std::uint64_t endOffset = std::min(fileSize, startOffset + segmentSize);
+                sqlite3pp::command command(*_localDb, "INSERT INTO package_segments(package_id, version, start_offset, end_offset, downloaded) VALUES(:package_id, :version, :start_offset, :end_offset, 0)");
+                command.bind(":package_id", task.packageId.c_str());
+                command.bind(":version", task.packageVersion);
+                command.bind(":start_offset", startOffset);
+                command.bind(":end_offset", endOffset);
+                command.execute();
+                segmentRanges.emplace_back(startOffset, endOffset);
+                segmentSizes.push_back(0);
+            }
+        }
+
+        std::string packageURL = createPackageURL(task.packageId, task.packageVersion, task.packageLocation, downloaded);
+        if (packageURL.empty()) {
+            throw PackageException(PackageErrorType::PACKAGE_ERROR_TYPE_NO_OFFLINE_PLAN, "Offline packages not available");
+        }
+
+        // Download all segments concurrently, each segment using its own file handle
+        std::mutex segmentMutex;
+        std::atomic<bool> rangeMismatch(false);
+        std::vector<int> segmentErrorCodes(segmentRanges.size(), 0);
+        auto saveSegmentProgress = [this, &task, &segmentRanges](std::size_t index, std::uint64_t segmentSize) {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            sqlite3pp::command command(*_localDb, "UPDATE package_segments SET downloaded=:downloaded WHERE package_id=:package_id AND version=:version AND start_offset=:start_offset");
+            command.bind(":downloaded", segmentSize);
+            command.bind(":package_id", task.packageId.c_str());
+            command.bind(":version", task.packageVersion);
+            command.bind(":start_offset", segmentRanges[index].first);
+            command.execute();
+        };
+
+        std::vector<std::thread> segmentThreads;
+        for (std::size_t i = 0; i < segmentRanges.size(); i++) {
+            segmentThreads.emplace_back([&, i]() {
+                try {
+                    const std::pair<std::uint64_t, std::uint64_t>& segmentRange = segmentRanges[i];
+                    for (int retry = 0; retry < 2; retry++) {
+                        std::uint64_t segmentOffset = 0;
+                        {
+                            std::lock_guard<std::mutex> lock(segmentMutex);
+                            segmentOffset = segmentRange.first + segmentSizes[i];
+                        }
+                        if (segmentOffset >= segmentRange.second) {
+                            segmentErrorCodes[i] = 0;
+                            return;
+                        }
+
+                        FILE* fpRaw = utf8_filesystem::fopen(packageFileName.c_str(), "r+b");
+                        if (!fpRaw) {
+                            Log::Errorf("PackageManager: Could not open package file %s", packageFileName.c_str());
+                            segmentErrorCodes[i] = -1;
+                            return;
+                        }
+                        std::shared_ptr<FILE> fp(fpRaw, fclose);
+                        utf8_filesystem::fseek64(fp.get(), segmentOffset, SEEK_SET);
+
+                        std::uint64_t savedOffset = segmentOffset;
+                        segmentErrorCodes[i] = DownloadFileRange(packageURL, [&](std::uint64_t offset, std::uint64_t length, const unsigned char* buf, std::size_t size) {
+                            if (isTaskCancelled(taskId)) {
+                                return false;
+                            }
+                            if (isTaskPaused(taskId)) {
+                                return false;
+                            }
+                            if (rangeMismatch || segmentOffset >= segmentRange.second) {
+                                return false;
+                            }
+
+                            if (offset != segmentOffset) {
+                                rangeMismatch = true;
+                                return false;
+                            }
+                            size = static_cast<std::size_t>(std::min(static_cast<std::uint64_t>(size), segmentRange.second - offset));
+                            if (fwrite(buf, sizeof(unsigned char), size, fp.get()) != size) {
+                                Log::Errorf("PackageManager: Storage full? Could not write to package file %s", packageFileName.c_str());
+                                return false;
+                            }
+                            segmentOffset = offset + size;
+                            if (segmentOffset - savedOffset >= SEGMENT_PROGRESS_SAVE_INTERVAL) {
+                                fflush(fp.get());
+                                saveSegmentProgress(i, segmentOffset - segmentRange.first);
+                                savedOffset = segmentOffset;
+                            }
+
+                            std::uint64_t totalSize = 0;
+                            {
+                                std::lock_guard<std::mutex> lock(segmentMutex);
+                                segmentSizes[i] = segmentOffset - segmentRange.first;
+                                totalSize = std::accumulate(segmentSizes.begin(), segmentSizes.end(), static_cast<std::uint64_t>(0));
+                            }
+                            updateTaskStatus(taskId, PackageAction::PACKAGE_ACTION_DOWNLOADING, static_cast<float>(totalSize) / static_cast<float>(fileSize));
+                            return true;
+                        }, segmentOffset, segmentRange.second);
+
+                        if (segmentOffset >= segmentRange.second) {
+                            segmentErrorCodes[i] = 0;
+                            return;
+                        }
+                        if (rangeMismatch || isTaskCancelled(taskId) || isTaskPaused(taskId)) {
+                            return;
+                        }
+                        if (segmentErrorCodes[i] == 0) {
+                            segmentErrorCodes[i] = -1;
+                        }
+                        Log::Infof("PackageManager: Retrying package %s segment download", task.packageId.c_str());
+                    }
+                }
+                catch (const std::exception& ex) {
+                    Log::Errorf("PackageManager: Exception while downloading package segment: %s", ex.what());
+                    segmentErrorCodes[i] = -1;
+                }
+            });
+        }
+        for (std::thread& segmentThread : segmentThreads) {
+            segmentThread.join();
+        }
+
+        // Store the progress of all segments, so that the download can be resumed
+        for (std::size_t i = 0; i < segmentRanges.size(); i++) {
+            saveSegmentProgress(i, segmentSizes[i]);
+        }
+
+        if (isTaskCancelled(taskId)) {
+            throw CancelException();
+        }
+        if (isTaskPaused(taskId)) {
+            throw PauseException();
+        }
+        if (rangeMismatch) {
+            Log::Infof("PackageManager: Range requests not supported for package %s, using single request", task.packageId.c_str());
+            deletePackageSegments(task.packageId, task.packageVersion);
+            utf8_filesystem::unlink(packageFileName.c_str());
+            return false;
+        }
+        for (int errorCode : segmentErrorCodes) {
+            if (errorCode != 0) {
+                throw CreateDownloadException(errorCode, task.packageId);
+            }
+        }
+
+        deletePackageSegments(task.packageId, task.packageVersion);
+        updateTaskStatus(taskId, PackageAction::PACKAGE_ACTION_DOWNLOADING, 1.0f);
+        return true;
+    }
+
     bool PackageManager::removePackage(int taskId) {
+        CARTO_TRACE_SECTION("PackageManager::removePackage");
+
         Task task = _taskQueue->getTask(taskId);
 
         if (_taskQueue->isTaskCancelled(taskId)) {
@@ -1095,6 +1549,8 @@ namespace carto {
     }
 
     bool PackageManager::downloadStyle(int taskId) {
+        CARTO_TRACE_SECTION("PackageManager::downloadStyle");
+
         Task task = _taskQueue->getTask(taskId);
 
         if (_taskQueue->isTaskCancelled(taskId)) {
@@ -1108,49 +1564,79 @@ namespace carto {
         return true;
     }
 
-    void PackageManager::syncLocalPackages() {
+    bool PackageManager::syncLocalPackages(std::vector<std::shared_ptr<PackageInfo> >& addedPackages, std::vector<std::shared_ptr<PackageInfo> >& removedPackages) {
         if (!_localDb) {
-            return;
+            return false;
         }
 
         try {
             std::lock_guard<std::recursive_mutex> lock(_mutex);
 
-            // Find all valid packages
+            // Find all valid packages. Only the rows not seen before are loaded and decoded
             std::vector<std::shared_ptr<PackageInfo> > packages;
-            sqlite3pp::query query(*_localDb, "SELECT package_id, package_type, version, size, server_url, tile_mask, metainfo FROM packages WHERE valid=1 ORDER BY id ASC");
+            std::map<int, std::shared_ptr<PackageInfo> > packageIdMap;
+            sqlite3pp::query query(*_localDb, "SELECT id FROM packages WHERE valid=1 ORDER BY id ASC");
             for (auto qit = query.begin(); qit != query.end(); qit++) {
-                std::shared_ptr<PackageTileMask> tileMask;
-                if (strlen(qit->get<const char*>(5)) != 0) {
-                    tileMask = DecodeTileMask(qit->get<const char*>(5));
-                }
-                std::shared_ptr<PackageMetaInfo> metaInfo;
-                if (strlen(qit->get<const char*>(6)) != 0) {
-                    rapidjson::Document metaInfoDoc;
-                    if (metaInfoDoc.Parse<rapidjson::kParseDefaultFlags>(qit->get<const char*>(6)).HasParseError()) {
-                        throw PackageException(PackageErrorType::PACKAGE_ERROR_TYPE_SYSTEM, "Error while parsing meta info");
+                int id = qit->get<int>(0);
+                std::shared_ptr<PackageInfo> packageInfo;
+                auto it = _localPackageIdMap.find(id);
+                if (it != _localPackageIdMap.end()) {
+                    packageInfo = it->second;
+                } else {
+                    sqlite3pp::query packageQuery(*_localDb, "SELECT package_id, package_type, version, size, server_url, tile_mask, metainfo FROM packages WHERE id=:id");
+                    packageQuery.bind(":id", id);
+                    for (auto pqit = packageQuery.begin(); pqit != packageQuery.end(); pqit++) {
+                        std::shared_ptr<PackageTileMask> tileMask;
+                        if (strlen(pqit->get<const char*>(5)) != 0) {
+                            tileMask = DecodeTileMask(pqit->get<const char*>(5));
+                        }
+                        std::shared_ptr<PackageMetaInfo> metaInfo;
+                        if (strlen(pqit->get<const char*>(6)) != 0) {
+                            picojson::value metaInfoValue;
+                            if (!JSONUtils::ParsePicoJSON(metaInfoValue, pqit->get<const char*>(6)).empty()) {
+                                throw PackageException(PackageErrorType::PACKAGE_ERROR_TYPE_SYSTEM, "Error while parsing meta info");
+                            }
+                            metaInfo = std::make_shared<PackageMetaInfo>(Variant::FromPicoJSON(std::move(metaInfoValue)));
+                        }
+                        packageInfo = std::make_shared<PackageInfo>(
+                            pqit->get<const char*>(0),
+                            static_cast<PackageType::PackageType>(pqit->get<int>(1)),
+                            pqit->get<int>(2),
+                            pqit->get<std::uint64_t>(3),
+                            pqit->get<const char*>(4),
+                            tileMask,
+                            metaInfo
+                        );
+                    }
+                    if (!packageInfo) {
+                        continue;
                     }
-                    metaInfo = createPackageMetaInfo(metaInfoDoc);
+                    addedPackages.push_back(packageInfo);
                 }
-                auto packageInfo = std::make_shared<PackageInfo>(
-                    qit->get<const char*>(0),
-                    static_cast<PackageType::PackageType>(qit->get<int>(1)),
-                    qit->get<int>(2),
-                    qit->get<std::uint64_t>(3),
-                    qit->get<const char*>(4),
-                    tileMask,
-                    metaInfo
-                    );
                 packages.push_back(packageInfo);
+                packageIdMap[id] = packageInfo;
+            }
+            for (auto it = _localPackageIdMap.begin(); it != _localPackageIdMap.end(); it++) {
+                if (packageIdMap.find(it->first) == packageIdMap.end()) {
+                    removedPackages.push_back(it->second);
+                }
+            }
+            if (addedPackages.empty() && removedPackages.empty()) {
+                return false;
             }
 
-            // Update packages, sync caches
+            // Update packages. If a snapshot is already in use, publish a new one that keeps the handlers (and their open databases) of unchanged packages
             std::swap(_localPackages, packages);
-            _packageHandlerCache.clear();
+            std::swap(_localPackageIdMap, packageIdMap);
+            if (std::shared_ptr<const LocalPackageSnapshot> snapshot = std::atomic_load(&_localPackageSnapshot)) {
+                std::atomic_store(&_localPackageSnapshot, createLocalPackageSnapshot(snapshot));
+            }
+            return true;
         }
         catch (const std::exception& ex) {
             Log::Errorf("PackageManager::syncLocalPackages: %s", ex.what());
         }
+        return false;
     }
 
     void PackageManager::importLocalPackage(int id, int taskId, const std::string& packageId, PackageType::PackageType packageType, const std::string& packageFileName) {
@@ -1177,8 +1663,11 @@ namespace carto {
         }
 
         // Sync
-        syncLocalPackages();
-        notifyPackagesChanged();
+        std::vector<std::shared_ptr<PackageInfo> > addedPackages;
+        std::vector<std::shared_ptr<PackageInfo> > removedPackages;
+        if (syncLocalPackages(addedPackages, removedPackages)) {
+            notifyPackagesChanged(addedPackages, removedPackages);
+        }
     }
 
     void PackageManager::deleteLocalPackage(int id) {
@@ -1208,8 +1697,11 @@ namespace carto {
         }
 
         // Sync
-        syncLocalPackages();
-        notifyPackagesChanged();
+        std::vector<std::shared_ptr<PackageInfo> > addedPackages;
+        std::vector<std::shared_ptr<PackageInfo> > removedPackages;
+        if (syncLocalPackages(addedPackages, removedPackages)) {
+            notifyPackagesChanged(addedPackages, removedPackages);
+        }
 
         // Invoke handler callback
         if (auto handler = PackageHandlerFactory(_serverEncKey, _localEncKey).createPackageHandler(packageType, packageFileName)) {
@@ -1220,6 +1712,14 @@ namespace carto {
         utf8_filesystem::unlink(packageFileName.c_str());
     }
 
+    void PackageManager::deletePackageSegments(const std::string& packageId, int version) {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        sqlite3pp::command command(*_localDb, "DELETE FROM package_segments WHERE package_id=:package_id AND version=:version");
+        command.bind(":package_id", packageId.c_str());
+        command.bind(":version", version);
+        command.execute();
+    }
+
     bool PackageManager::isTaskCancelled(int taskId) const {
         std::lock_guard<std::recursive_mutex> lock(_mutex);
         return _taskQueue->isTaskCancelled(taskId);
@@ -1230,21 +1730,21 @@ namespace carto {
         if (_stopped) {
             return true;
         }
-        return _taskQueue->getActiveTaskId(taskId) != taskId;
+        std::vector<int> activeTaskIds = getActiveTaskIds(IsDownloadTask(_taskQueue->getTask(taskId).command));
+        return std::find(activeTaskIds.begin(), activeTaskIds.end(), taskId) == activeTaskIds.end();
     }
 
     void PackageManager::updateTaskStatus(int taskId, PackageAction::PackageAction action, float progress) {
         {
             std::lock_guard<std::recursive_mutex> lock(_mutex);
             int roundedProgress = std::min(100, std::max(0, static_cast<int>(progress * 100.0f)));
-            if (taskId == _prevTaskId && action == _prevAction && roundedProgress == _prevRoundedProgress) {
+            auto it = _taskStatusMap.find(taskId);
+            if (it != _taskStatusMap.end() && it->second == std::make_pair(action, roundedProgress)) {
                 return;
             }
 
             _taskQueue->updateTaskStatus(taskId, action, progress);
-            _prevTaskId = taskId;
-            _prevAction = action;
-            _prevRoundedProgress = roundedProgress;
+            _taskStatusMap[taskId] = std::make_pair(action, roundedProgress);
         }
 
         DirectorPtr<PackageManagerListener> packageManagerListener = _packageManagerListener;
@@ -1377,6 +1877,10 @@ namespace carto {
         return baseURL;
     }
 
+    std::string PackageManager::createPackageDeltaURL(const std::string& packageId, int baseVersion, int version, const std::string& baseURL) const {
+        return std::string(); // delta packages are not available by default
+    }
+
     std::shared_ptr<PackageInfo> PackageManager::getCustomPackage(const std::string& packageId, int version) const {
         return std::shared_ptr<PackageInfo>();
     }
@@ -1385,7 +1889,7 @@ namespace carto {
         return false;
     }
 
-    void PackageManager::notifyPackagesChanged() {
+    void PackageManager::notifyPackagesChanged(const std::vector<std::shared_ptr<PackageInfo> >& addedPackages, const std::vector<std::shared_ptr<PackageInfo> >& removedPackages) {
         std::vector<std::shared_ptr<OnChangeListener> > onChangeListeners;
         {
             std::lock_guard<std::recursive_mutex> lock(_mutex);
@@ -1393,7 +1897,7 @@ namespace carto {
         }
 
         for (const std::shared_ptr<OnChangeListener>& onChangeListener : onChangeListeners) {
-            onChangeListener->onPackagesChanged();
+            onChangeListener->onLocalPackagesChanged(addedPackages, removedPackages);
         }
     }
 
@@ -1447,6 +1951,7 @@ namespace carto {
             throw PackageException(PackageErrorType::PACKAGE_ERROR_TYPE_SYSTEM, std::string("Could not rename package list file ") + tempPackageListFileName);
         }
         _serverPackageCache.reset();
+        _serverPackageTileIndex.reset();
     }
 
     void PackageManager::InitializeDb(sqlite3pp::database& db, const std::string& encKey) {
@@ -1468,7 +1973,16 @@ namespace carto {
                     name TEXT,
                     value TEXT
                 ))SQL");
+        db.execute(R"SQL(
+                CREATE TABLE IF NOT EXISTS package_segments(
+                    package_id TEXT NOT NULL,
+                    version INTEGER NOT NULL,
+                    start_offset INTEGER NOT NULL,
+                    end_offset INTEGER NOT NULL,
+                    downloaded INTEGER NOT NULL DEFAULT 0
+                ))SQL");
         db.execute("CREATE INDEX IF NOT EXISTS packages_package_id ON packages(package_id)");
+        db.execute("CREATE INDEX IF NOT EXISTS package_segments_package_id ON package_segments(package_id, version)");
         
         std::string dbHash;
         sqlite3pp::query query(db, "SELECT value FROM metadata WHERE name='nutikeysha1'");
@@ -1550,6 +2064,55 @@ namespace carto {
         return NetworkUtils::StreamHTTPResponse("GET", url, requestHeaders, responseHeaders, handler, offset, Log::IsShowDebug());
     }
 
+    int PackageManager::DownloadFileRange(const std::string& url, NetworkUtils::HandlerFunc handler, std::uint64_t offset, std::uint64_t endOffset) {
+        Log::Debugf("PackageManager::DownloadFileRange: %s (%lld-%lld)", url.c_str(), static_cast<long long>(offset), static_cast<long long>(endOffset));
+        std::map<std::string, std::string> requestHeaders = NetworkUtils::CreateAppRefererHeader();
+        requestHeaders["Range"] = "bytes=" + boost::lexical_cast<std::string>(offset) + "-" + boost::lexical_cast<std::string>(endOffset - 1);
+        std::map<std::string, std::string> responseHeaders;
+        return NetworkUtils::StreamHTTPResponse("GET", url, requestHeaders, responseHeaders, handler, offset, Log::IsShowDebug());
+    }
+
+    PackageManager::PackageException PackageManager::CreateDownloadException(int errorCode, const std::string& packageId) {
+        switch (errorCode) {
+        case 402: // Payment required
+            return PackageException(PackageErrorType::PACKAGE_ERROR_TYPE_DOWNLOAD_LIMIT_EXCEEDED, "Subscription limit exceeded while downloading: " + packageId);
+        case 403: // Forbidden
+            return PackageException(PackageErrorType::PACKAGE_ERROR_TYPE_NO_OFFLINE_PLAN, "Offline packages not available");
+        case 406: // Not acceptable
+            return PackageException(PackageErrorType::PACKAGE_ERROR_TYPE_PACKAGE_TOO_BIG, "Package contains too many tiles: " + packageId);
+        default:
+            return PackageException(errorCode < 0 ? PackageErrorType::PACKAGE_ERROR_TYPE_CONNECTION : PackageErrorType::PACKAGE_ERROR_TYPE_SYSTEM, "Failed to download package " + packageId);
+        }
+    }
+
+    PackageManager::LocalPackageSnapshot::LocalPackageSnapshot(const std::vector<std::pair<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> > >& packageHandlers) :
+        _packageHandlers(packageHandlers),
+        _packageHandlerMap(packageHandlers.begin(), packageHandlers.end()),
+        _tileIndex(GetTileMasks(packageHandlers))
+    {
+    }
+
+    const std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> >& PackageManager::LocalPackageSnapshot::getPackageHandlerMap() const {
+        return _packageHandlerMap;
+    }
+
+    std::vector<std::pair<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> > > PackageManager::LocalPackageSnapshot::findTilePackageHandlers(const MapTile& tile) const {
+        std::vector<std::pair<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> > > packageHandlers;
+        for (int packageIndex : _tileIndex.findPackages(tile)) {
+            packageHandlers.push_back(_packageHandlers[packageIndex]);
+        }
+        return packageHandlers;
+    }
+
+    std::vector<std::shared_ptr<PackageTileMask> > PackageManager::LocalPackageSnapshot::GetTileMasks(const std::vector<std::pair<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> > >& packageHandlers) {
+        std::vector<std::shared_ptr<PackageTileMask> > tileMasks;
+        tileMasks.reserve(packageHandlers.size());
+        for (const std::pair<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> >& packageHandler : packageHandlers) {
+            tileMasks.push_back(packageHandler.first->getTileMask());
+        }
+        return tileMasks;
+    }
+
     PackageManager::PersistentTaskQueue::PersistentTaskQueue(const std::string& dbFileName) {
         _localDb = std::make_shared<sqlite3pp::database>(dbFileName.c_str());
         _localDb->execute("PRAGMA encoding='UTF-8'");
@@ -1570,26 +2133,44 @@ namespace carto {
         _localDb->execute("CREATE INDEX IF NOT EXISTS manager_tasks_package_id ON manager_tasks(package_id)");
     }
 
-    int PackageManager::PersistentTaskQueue::getActiveTaskId(int currentActiveTaskId) const {
-        // Find task with highest priority. Do not process paused tasks (priority < 0) unless they are cancelled. Cancelled tasks should be always processed.
+    std::vector<int> PackageManager::PersistentTaskQueue::getActiveTaskIds(const std::set<int>& currentActiveTaskIds) const {
+        // Order tasks by priority. Do not process paused tasks (priority < 0) unless they are cancelled. Cancelled tasks should be always processed.
+        // Among the tasks with equal priority, currently active tasks are preferred so that they are not needlessly paused.
         std::lock_guard<std::recursive_mutex> lock(_mutex);
-        sqlite3pp::query query(*_localDb, "SELECT id, package_id, (CASE WHEN id=:active_id THEN -1 ELSE id END) as ordering FROM manager_tasks WHERE priority>=0 OR cancelled=1 ORDER BY priority DESC, ordering ASC LIMIT 1");
-        query.bind(":active_id", currentActiveTaskId);
+        struct TaskRecord {
+            int taskId;
+            int priority;
+            std::shared_ptr<std::string> packageId;
+        };
+        std::vector<TaskRecord> taskRecords;
+        sqlite3pp::query query(*_localDb, "SELECT id, priority, package_id FROM manager_tasks WHERE priority>=0 OR cancelled=1 ORDER BY priority DESC, id ASC");
         for (auto qit = query.begin(); qit != query.end(); qit++) {
-            int taskId = qit->get<int>(0);
-            const char* packageId = qit->get<const char*>(1);
-            if (!packageId) {
-                return taskId;
+            const char* packageId = qit->get<const char*>(2);
+            taskRecords.push_back(TaskRecord { qit->get<int>(0), qit->get<int>(1), packageId ? std::make_shared<std::string>(packageId) : std::shared_ptr<std::string>() });
+        }
+        std::stable_sort(taskRecords.begin(), taskRecords.end(), [&currentActiveTaskIds](const TaskRecord& taskRecord1, const TaskRecord& taskRecord2) {
+            if (taskRecord1.priority != taskRecord2.priority) {
+                return taskRecord1.priority > taskRecord2.priority;
             }
+            return currentActiveTaskIds.count(taskRecord1.taskId) > currentActiveTaskIds.count(taskRecord2.taskId);
+        });
 
-            // This is a package task - package tasks have to be processed in-order, so take the first task with the same package (even if it is paused).
-            sqlite3pp::query query2(*_localDb, "SELECT id FROM manager_tasks WHERE package_id=:package_id ORDER BY id ASC LIMIT 1");
-            query2.bind(":package_id", packageId);
-            for (auto qit2 = query2.begin(); qit2 != query2.end(); qit2++) {
-                return qit2->get<int>(0);
+        std::vector<int> taskIds;
+        for (const TaskRecord& taskRecord : taskRecords) {
+            int taskId = taskRecord.taskId;
+            if (taskRecord.packageId) {
+                // This is a package task - package tasks have to be processed in-order, so take the first task with the same package (even if it is paused).
+                sqlite3pp::query query2(*_localDb, "SELECT id FROM manager_tasks WHERE package_id=:package_id ORDER BY id ASC LIMIT 1");
+                query2.bind(":package_id", taskRecord.packageId->c_str());
+                for (auto qit2 = query2.begin(); qit2 != query2.end(); qit2++) {
+                    taskId = qit2->get<int>(0);
+                }
+            }
+            if (std::find(taskIds.begin(), taskIds.end(), taskId) == taskIds.end()) {
+                taskIds.push_back(taskId);
             }
         }
-        return -1;
+        return taskIds;
     }
 
     std::vector<int> PackageManager::PersistentTaskQueue::getTaskIds() const {
@@ -1677,7 +2258,16 @@ namespace carto {
         command.execute();
     }
 
+    bool PackageManager::IsDownloadTask(Task::Command command) {
+        return command == Task::DOWNLOAD_PACKAGE;
+    }
+
     const int PackageManager::DEFAULT_TILEMASK_ZOOMLEVEL = 14;
+    const int PackageManager::DEFAULT_DOWNLOAD_CONCURRENCY = 2;
+    const int PackageManager::MAX_DOWNLOAD_CONCURRENCY = 8;
+    const int PackageManager::MAX_DOWNLOAD_SEGMENT_COUNT = 8;
+    const std::uint64_t PackageManager::MIN_SEGMENTED_DOWNLOAD_SIZE = 16 * 1024 * 1024;
+    const std::uint64_t PackageManager::SEGMENT_PROGRESS_SAVE_INTERVAL = 4 * 1024 * 1024;
 }
 
 #endif
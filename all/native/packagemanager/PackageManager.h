@@ -17,12 +17,15 @@
 #include "packagemanager/PackageMetaInfo.h"
 #include "packagemanager/PackageStatus.h"
 #include "packagemanager/PackageTileMask.h"
+#include "packagemanager/PackageTileIndex.h"
 #include "packagemanager/PackageManagerListener.h"
 #include "utils/NetworkUtils.h"
 
 #include <string>
 #include <cstdint>
 #include <vector>
+#include <map>
+#include <set>
 #include <memory>
 #include <mutex>
 #include <condition_variable>
@@ -62,6 +65,18 @@ namespace carto {
              */
             virtual void onPackagesChanged() = 0;
 
+            /**
+             * Called when local packages have been added or removed. An updated package is reported as
+             * the removal of the old version and the addition of the new version.
+             * Packages not listed keep their PackageInfo and PackageHandler instances, so open databases
+             * and caches of these packages can be kept. The default implementation calls onPackagesChanged.
+             * @param addedPackages The packages added to the local package list.
+             * @param removedPackages The packages removed from the local package list.
+             */
+            virtual void onLocalPackagesChanged(const std::vector<std::shared_ptr<PackageInfo> >& addedPackages, const std::vector<std::shared_ptr<PackageInfo> >& removedPackages) {
+                onPackagesChanged();
+            }
+
             /**
              * Called when a style has been updated.
              */
@@ -103,6 +118,33 @@ namespace carto {
          */
         void unregisterOnChangeListener(const std::shared_ptr<OnChangeListener>& listener);
 
+        /**
+         * Returns the maximum number of packages that are downloaded concurrently.
+         * @return The maximum number of concurrent package downloads.
+         */
+        int getDownloadConcurrency() const;
+        /**
+         * Sets the maximum number of packages that are downloaded concurrently. The default is 2.
+         * Package downloads are processed separately from other tasks (package list updates, imports and removals),
+         * so other tasks are not blocked by the downloads.
+         * @param concurrency The maximum number of concurrent package downloads. The value is clamped to range 1..8.
+         */
+        void setDownloadConcurrency(int concurrency);
+
+        /**
+         * Returns the number of concurrent segments used for downloading a single large package.
+         * @return The number of concurrent segments per package download.
+         */
+        int getDownloadSegmentCount() const;
+        /**
+         * Sets the number of concurrent segments used for downloading a single large package. The default is 1 (segmented downloads are disabled).
+         * When enabled, large packages are downloaded using multiple concurrent HTTP range requests. Each segment can be resumed
+         * separately if the download is paused or interrupted. The server must support range requests, otherwise
+         * the package is downloaded using a single request.
+         * @param segmentCount The number of concurrent segments per package download. The value is clamped to range 1..8.
+         */
+        void setDownloadSegmentCount(int segmentCount);
+
         /**
          * Starts the package manager. All previous tasks will be resumed after this.
          * @return True if package manager was successfully started. False otherwise (can not create/access database).
@@ -164,7 +206,45 @@ namespace carto {
         std::shared_ptr<PackageStatus> getLocalPackageStatus(const std::string& packageId, int version) const;
 
         /**
-         * Locks local packages and calls specified handler callback.
+         * Immutable snapshot of the local packages and their handlers.
+         * A new snapshot is published each time the local package list changes, existing snapshots are never modified.
+         * Thus snapshots can be used from multiple threads without locking the package manager.
+         */
+        class LocalPackageSnapshot {
+        public:
+            explicit LocalPackageSnapshot(const std::vector<std::pair<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> > >& packageHandlers);
+
+            /**
+             * Returns the map of all local packages and their handlers.
+             * @return The map of local packages and package handlers.
+             */
+            const std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> >& getPackageHandlerMap() const;
+
+            /**
+             * Finds the local packages that may contain the specified tile, using the tile masks of the packages.
+             * @param tile The tile to find. The tile must be in the coordinate system of the package tile masks.
+             * @return The list of packages and package handlers, in the local package order.
+             */
+            std::vector<std::pair<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> > > findTilePackageHandlers(const MapTile& tile) const;
+
+        private:
+            static std::vector<std::shared_ptr<PackageTileMask> > GetTileMasks(const std::vector<std::pair<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> > >& packageHandlers);
+
+            std::vector<std::pair<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> > > _packageHandlers;
+            std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> > _packageHandlerMap;
+            PackageTileIndex _tileIndex;
+        };
+
+        /**
+         * Returns the current snapshot of local packages. The package manager is locked only when the first snapshot
+         * after a local package change is created.
+         * @return The local package snapshot.
+         */
+        std::shared_ptr<const LocalPackageSnapshot> getLocalPackageSnapshot() const;
+
+        /**
+         * Calls specified handler callback with the current snapshot of local packages.
+         * The package manager is not locked while the callback is called.
          * @param callback The callback function.
          */
         void accessLocalPackages(const std::function<void(const std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> >&)>& callback) const;
@@ -223,7 +303,8 @@ namespace carto {
 
         /**
          * Sets the priority of the specific package.
-         * If the given priority is higher than priority of any other package, other operations will be paused and this package is processed immediately.
+         * Packages with the highest priorities are processed first. If the number of higher priority package downloads exceeds
+         * the download concurrency, lower priority downloads will be paused until a download slot becomes available.
          * If the given priority is set to negative value, package download will be paused until priority is reset to non-negative value.
          * @param packageId The id of the download package.
          * @param priority The priority of the download package. If it is less than zero, package download is paused.
@@ -242,12 +323,13 @@ namespace carto {
         virtual std::string createPackageFileName(const std::string& packageId, PackageType::PackageType packageType, int version) const;
         virtual std::string createPackageListURL(const std::string& baseURL) const;
         virtual std::string createPackageURL(const std::string& packageId, int version, const std::string& baseURL, bool downloaded) const;
+        virtual std::string createPackageDeltaURL(const std::string& packageId, int baseVersion, int version, const std::string& baseURL) const;
         
         virtual std::shared_ptr<PackageInfo> getCustomPackage(const std::string& packageId, int version) const;
 
         virtual bool updateStyle(const std::string& styleName);
         
-        void notifyPackagesChanged();
+        void notifyPackagesChanged(const std::vector<std::shared_ptr<PackageInfo> >& addedPackages, const std::vector<std::shared_ptr<PackageInfo> >& removedPackages);
         void notifyStylesChanged();
 
     private:
@@ -275,7 +357,7 @@ namespace carto {
         public:
             PersistentTaskQueue(const std::string& dbFileName);
 
-            int getActiveTaskId(int currentActiveTaskId = -1) const;
+            std::vector<int> getActiveTaskIds(const std::set<int>& currentActiveTaskIds) const;
             std::vector<int> getTaskIds() const;
             Task getTask(int taskId) const;
 
@@ -307,17 +389,24 @@ namespace carto {
             PackageErrorType::PackageErrorType _errorType;
         };
 
-        void run();
+        void run(bool downloadWorker);
+        void startDownloadWorkers();
+
+        std::vector<int> getActiveTaskIds(bool downloadTasks) const;
 
         bool downloadPackageList(int taskId);
         bool importPackage(int taskId);
         bool downloadPackage(int taskId);
+        bool downloadPackageDelta(int taskId, const Task& task, const std::string& packageFileName);
+        bool downloadPackageSegments(int taskId, const Task& task, const std::shared_ptr<PackageInfo>& package, bool downloaded, const std::string& packageFileName);
         bool removePackage(int taskId);
         bool downloadStyle(int taskId);
         
-        void syncLocalPackages();
+        bool syncLocalPackages(std::vector<std::shared_ptr<PackageInfo> >& addedPackages, std::vector<std::shared_ptr<PackageInfo> >& removedPackages);
+        std::shared_ptr<const LocalPackageSnapshot> createLocalPackageSnapshot(const std::shared_ptr<const LocalPackageSnapshot>& prevSnapshot) const;
         void importLocalPackage(int id, int taskId, const std::string& packageId, PackageType::PackageType packageType, const std::string& packageFileName);
         void deleteLocalPackage(int id);
+        void deletePackageSegments(const std::string& packageId, int version);
 
         bool isTaskCancelled(int taskId) const;
         bool isTaskPaused(int taskId) const;
@@ -340,8 +429,18 @@ namespace carto {
         static std::string EncodeTileMask(const std::shared_ptr<PackageTileMask>& tileMask);
 
         static int DownloadFile(const std::string& url, NetworkUtils::HandlerFunc handler, std::uint64_t offset = 0);
+        static int DownloadFileRange(const std::string& url, NetworkUtils::HandlerFunc handler, std::uint64_t offset, std::uint64_t endOffset);
+
+        static PackageException CreateDownloadException(int errorCode, const std::string& packageId);
+
+        static bool IsDownloadTask(Task::Command command);
 
         static const int DEFAULT_TILEMASK_ZOOMLEVEL;
+        static const int DEFAULT_DOWNLOAD_CONCURRENCY;
+        static const int MAX_DOWNLOAD_CONCURRENCY;
+        static const int MAX_DOWNLOAD_SEGMENT_COUNT;
+        static const std::uint64_t MIN_SEGMENTED_DOWNLOAD_SIZE;
+        static const std::uint64_t SEGMENT_PROGRESS_SAVE_INTERVAL;
 
         const std::string _packageListURL;
         const std::string _packageListFileName;
@@ -350,21 +449,25 @@ namespace carto {
         const std::string _localEncKey;
 
         std::vector<std::shared_ptr<PackageInfo> > _localPackages;
+        std::map<int, std::shared_ptr<PackageInfo> > _localPackageIdMap; // database id -> package info, package rows are immutable once valid
         std::shared_ptr<sqlite3pp::database> _localDb;
         std::shared_ptr<PersistentTaskQueue> _taskQueue;
         std::condition_variable_any _taskQueueCondition; // notified when new tasks are available
-        std::shared_ptr<std::thread> _packageManagerThread;
+        std::shared_ptr<std::thread> _packageManagerThread; // processes all tasks except package downloads
+        std::vector<std::shared_ptr<std::thread> > _downloadThreads;
         std::vector<std::shared_ptr<OnChangeListener> > _onChangeListeners;
         bool _stopped;
 
-        int _prevTaskId;
-        PackageAction::PackageAction _prevAction;
-        int _prevRoundedProgress;
+        int _downloadConcurrency;
+        int _downloadSegmentCount;
+        std::set<int> _runningTaskIds;
+        std::map<int, std::pair<PackageAction::PackageAction, int> > _taskStatusMap; // last reported action and rounded progress for each task
 
         ThreadSafeDirectorPtr<PackageManagerListener> _packageManagerListener;
 
         mutable std::shared_ptr<std::vector<std::shared_ptr<PackageInfo> > > _serverPackageCache;
-        mutable std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> > _packageHandlerCache;
+        mutable std::shared_ptr<const PackageTileIndex> _serverPackageTileIndex; // built from the server package cache when first needed
+        mutable std::shared_ptr<const LocalPackageSnapshot> _localPackageSnapshot; // accessed atomically, null if not yet created
 
         mutable std::recursive_mutex _mutex; // guards all state
     };
@@ -0,0 +1,79 @@
+#include "PackageTileIndex.h"
+
+#include <algorithm>
+
+namespace carto {
+
+    PackageTileIndex::PackageTileIndex(const std::vector<std::shared_ptr<PackageTileMask> >& tileMasks) :
+        _tileMasks(tileMasks),
+        _rootNode()
+    {
+        std::vector<int> packageIndices;
+        for (std::size_t i = 0; i < _tileMasks.size(); i++) {
+            packageIndices.push_back(static_cast<int>(i));
+        }
+        buildTileNode(_rootNode, packageIndices, MapTile(0, 0, 0, 0));
+    }
+
+    std::size_t PackageTileIndex::getPackageCount() const {
+        return _tileMasks.size();
+    }
+
+    std::vector<int> PackageTileIndex::findPackages(const MapTile& tile) const {
+        // Find the deepest index node containing the tile
+        const TileNode* node = &_rootNode;
+        int zoom = 0;
+        while (node->subNodes && zoom < tile.getZoom()) {
+            int shift = tile.getZoom() - zoom - 1;
+            int index = ((tile.getY() >> shift) & 1) * 2 + ((tile.getX() >> shift) & 1);
+            node = &(*node->subNodes)[index];
+            zoom++;
+        }
+
+        if (zoom == tile.getZoom()) {
+            return node->packageIndices;
+        }
+
+        // Tile is below the indexed levels, check the remaining candidates directly
+        std::vector<int> packageIndices;
+        packageIndices.reserve(node->packageIndices.size());
+        for (int packageIndex : node->packageIndices) {
+            const std::shared_ptr<PackageTileMask>& tileMask = _tileMasks[packageIndex];
+            if (tileMask) {
+                if (tileMask->getTileStatus(tile) == PackageTileStatus::PACKAGE_TILE_STATUS_MISSING) {
+                    continue;
+                }
+            }
+            packageIndices.push_back(packageIndex);
+        }
+        return packageIndices;
+    }
+
+    void PackageTileIndex::buildTileNode(TileNode& node, const std::vector<int>& packageIndices, const MapTile& tile) const {
+        // Note: if a tile is missing from the tile mask, all its subtiles are also missing
+        int maskedCount = 0;
+        for (int packageIndex : packageIndices) {
+            const std::shared_ptr<PackageTileMask>& tileMask = _tileMasks[packageIndex];
+            if (tileMask) {
+                if (tileMask->getTileStatus(tile) == PackageTileStatus::PACKAGE_TILE_STATUS_MISSING) {
+                    continue;
+                }
+                maskedCount++;
+            }
+            node.packageIndices.push_back(packageIndex);
+        }
+
+        // Subdivide only if multiple tile masks overlap, otherwise a single tile mask test is as fast as an index lookup
+        if (maskedCount < 2 || tile.getZoom() >= MAX_INDEX_ZOOM) {
+            return;
+        }
+
+        node.subNodes = std::unique_ptr<std::array<TileNode, 4> >(new std::array<TileNode, 4>);
+        for (int i = 0; i < 4; i++) {
+            buildTileNode((*node.subNodes)[i], node.packageIndices, tile.getChild(i));
+        }
+    }
+
+    const int PackageTileIndex::MAX_INDEX_ZOOM = 10;
+
+}
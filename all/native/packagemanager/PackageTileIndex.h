@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_PACKAGETILEINDEX_H_
+#define _CARTO_PACKAGETILEINDEX_H_
+
+#include "core/MapTile.h"
+#include "packagemanager/PackageTileMask.h"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace carto {
+
+    /**
+     * Quadtree index built from the tile masks of a list of packages.
+     * The index can be used to quickly find the packages containing a tile, without testing all tile masks.
+     * The index is immutable after construction and can be used from multiple threads without locking.
+     */
+    class PackageTileIndex {
+    public:
+        /**
+         * Constructs a new index from the list of package tile masks.
+         * @param tileMasks The tile masks of the packages. Null tile mask means that the package may contain any tile.
+         */
+        explicit PackageTileIndex(const std::vector<std::shared_ptr<PackageTileMask> >& tileMasks);
+
+        /**
+         * Returns the number of indexed packages.
+         * @return The number of indexed packages.
+         */
+        std::size_t getPackageCount() const;
+
+        /**
+         * Finds the packages that may contain the specified tile.
+         * Packages without tile mask are always included.
+         * @param tile The tile to find.
+         * @return The indices of the packages (as given in the constructor) that may contain the tile, in ascending order.
+         */
+        std::vector<int> findPackages(const MapTile& tile) const;
+
+    private:
+        struct TileNode {
+            std::vector<int> packageIndices;
+            std::unique_ptr<std::array<TileNode, 4> > subNodes;
+
+            TileNode() : packageIndices(), subNodes() { }
+        };
+
+        void buildTileNode(TileNode& node, const std::vector<int>& packageIndices, const MapTile& tile) const;
+
+        static const int MAX_INDEX_ZOOM;
+
+        std::vector<std::shared_ptr<PackageTileMask> > _tileMasks;
+        TileNode _rootNode;
+    };
+}
+
+#endif
@@ -79,6 +79,13 @@ namespace {
         return stringValue;
     }
 
+    int popCount64(std::uint64_t val) {
+        val = val - ((val >> 1) & 0x5555555555555555ULL);
+        val = (val & 0x3333333333333333ULL) + ((val >> 2) & 0x3333333333333333ULL);
+        val = (val + (val >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return static_cast<int>((val * 0x0101010101010101ULL) >> 56);
+    }
+
     std::vector<std::vector<carto::MapPos> > createTilePolygon(const carto::MapTile& mapTile, const std::shared_ptr<carto::Projection>& proj) {
         std::vector<carto::MapPos> poses;
         carto::MapBounds bounds = carto::TileUtils::CalculateMapTileBounds(mapTile, proj);
@@ -155,6 +162,7 @@ namespace carto {
         _stringValue(stringValue),
         _maxZoomLevel(maxZoom),
         _cachedRootNode(),
+        _cachedTileBits(),
         _mutex()
     {
     }
@@ -163,6 +171,7 @@ namespace carto {
         _stringValue(),
         _maxZoomLevel(0),
         _cachedRootNode(),
+        _cachedTileBits(),
         _mutex()
     {
         std::unordered_set<MapTile> tileSet(tiles.begin(), tiles.end());
@@ -209,12 +218,25 @@ namespace carto {
     }
 
     PackageTileStatus::PackageTileStatus PackageTileMask::getTileStatus(const MapTile& mapTile) const {
-        if (const TileNode* node = findTileNode(mapTile)) {
-            if (mapTile.getZoom() <= _maxZoomLevel) {
-                return (node->inside ? PackageTileStatus::PACKAGE_TILE_STATUS_FULL : PackageTileStatus::PACKAGE_TILE_STATUS_MISSING);
-            }
+        int zoom = mapTile.getZoom();
+        if (zoom < 0 || zoom > _maxZoomLevel || zoom >= 32) {
+            return PackageTileStatus::PACKAGE_TILE_STATUS_MISSING;
+        }
+        std::int64_t x = mapTile.getX();
+        std::int64_t y = mapTile.getY();
+        if (x < 0 || y < 0 || (x >> zoom) != 0 || (y >> zoom) != 0) {
+            return PackageTileStatus::PACKAGE_TILE_STATUS_MISSING;
+        }
+
+        // Descend from the root until the tile zoom or a leaf node is reached, leaf nodes cover all their subtiles
+        const TileBits* tileBits = getTileBits();
+        std::size_t index = 0;
+        for (int level = zoom - 1; level >= 0 && tileBits->hasSubNodes(index); level--) {
+            int dx = static_cast<int>((x >> level) & 1);
+            int dy = static_cast<int>((y >> level) & 1);
+            index = tileBits->getChildIndex(index, dy * 2 + dx);
         }
-        return PackageTileStatus::PACKAGE_TILE_STATUS_MISSING;
+        return (tileBits->isInside(index) ? PackageTileStatus::PACKAGE_TILE_STATUS_FULL : PackageTileStatus::PACKAGE_TILE_STATUS_MISSING);
     }
 
     const PackageTileMask::TileNode* PackageTileMask::getRootNode() const {
@@ -227,28 +249,12 @@ namespace carto {
         return _cachedRootNode.get();
     }
 
-    const PackageTileMask::TileNode* PackageTileMask::findTileNode(const MapTile& tile) const {
-        if (tile.getZoom() == 0) {
-            if (tile.getX() == 0 && tile.getY() == 0) {
-                return getRootNode();
-            }
-            return nullptr;
-        }
-
-        if (const TileNode* parentNode = findTileNode(MapTile(tile.getX() / 2, tile.getY() / 2, tile.getZoom() - 1, tile.getFrameNr()))) {
-            if (parentNode->subNodes) {
-                for (int idx = 0; idx < 4; idx++) {
-                    const TileNode* node = &(*parentNode->subNodes)[idx];
-                    if (node->zoom == tile.getZoom() && node->x == tile.getX() && node->y == tile.getY()) {
-                        return node;
-                    }
-                }
-            }
-            if (parentNode->inside) {
-                return parentNode;
-            }
+    const PackageTileMask::TileBits* PackageTileMask::getTileBits() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_cachedTileBits) {
+            _cachedTileBits = BuildTileBits(decodeBase64(_stringValue));
         }
-        return nullptr;
+        return _cachedTileBits.get();
     }
 
     void PackageTileMask::BuildTileNode(TileNode& node, const std::unordered_set<MapTile>& tileSet, const MapTile& tile, int clipZoom) {
@@ -306,6 +312,73 @@ namespace carto {
         }
     }
 
+    void PackageTileMask::DecodeTileLevels(std::vector<std::vector<bool> >& levels, const std::vector<bool>& data, std::size_t& offset, std::size_t level) {
+        // Note: nodes of the same level appear in the same order in the depth-first encoding and in level order
+        if (levels.size() <= level) {
+            levels.resize(level + 1);
+        }
+        bool subNodes = data.at(offset++);
+        bool inside = data.at(offset++);
+        levels[level].push_back(subNodes);
+        levels[level].push_back(inside);
+        if (subNodes) {
+            for (int idx = 0; idx < 4; idx++) {
+                DecodeTileLevels(levels, data, offset, level + 1);
+            }
+        }
+    }
+
+    std::unique_ptr<PackageTileMask::TileBits> PackageTileMask::BuildTileBits(const std::vector<bool>& data) {
+        std::vector<std::vector<bool> > levels;
+        std::size_t offset = 0;
+        DecodeTileLevels(levels, data, offset, 0);
+
+        std::size_t nodeCount = 0;
+        for (const std::vector<bool>& levelData : levels) {
+            nodeCount += levelData.size() / 2;
+        }
+
+        std::unique_ptr<TileBits> tileBits(new TileBits);
+        std::size_t wordCount = (nodeCount + 63) / 64;
+        tileBits->subNodeWords.resize(wordCount, 0);
+        tileBits->insideWords.resize(wordCount, 0);
+        tileBits->subNodeRanks.resize(wordCount, 0);
+
+        std::size_t index = 0;
+        for (const std::vector<bool>& levelData : levels) {
+            for (std::size_t i = 0; i + 1 < levelData.size(); i += 2, index++) {
+                std::uint64_t mask = static_cast<std::uint64_t>(1) << (index % 64);
+                if (levelData[i]) {
+                    tileBits->subNodeWords[index / 64] |= mask;
+                }
+                if (levelData[i + 1]) {
+                    tileBits->insideWords[index / 64] |= mask;
+                }
+            }
+        }
+
+        std::uint32_t rank = 0;
+        for (std::size_t i = 0; i < wordCount; i++) {
+            tileBits->subNodeRanks[i] = rank;
+            rank += popCount64(tileBits->subNodeWords[i]);
+        }
+        return tileBits;
+    }
+
+    bool PackageTileMask::TileBits::hasSubNodes(std::size_t index) const {
+        return ((subNodeWords[index / 64] >> (index % 64)) & 1) != 0;
+    }
+
+    bool PackageTileMask::TileBits::isInside(std::size_t index) const {
+        return ((insideWords[index / 64] >> (index % 64)) & 1) != 0;
+    }
+
+    std::size_t PackageTileMask::TileBits::getChildIndex(std::size_t index, int idx) const {
+        std::uint64_t mask = (static_cast<std::uint64_t>(1) << (index % 64)) - 1;
+        std::size_t rank = subNodeRanks[index / 64] + popCount64(subNodeWords[index / 64] & mask);
+        return 1 + rank * 4 + idx;
+    }
+
     std::vector<std::vector<MapPos> > PackageTileMask::CalculateTileNodeBoundingPolygon(const TileNode& node, const std::shared_ptr<Projection>& proj) {
         std::vector<std::vector<MapPos> > poly;
         if (node.subNodes) {
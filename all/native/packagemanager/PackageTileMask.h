@@ -103,12 +103,28 @@ namespace carto {
             TileNode() : x(0), y(0), zoom(0), inside(1), subNodes() { }
         };
 
+        // Bit-packed quadtree in level order. As every internal node has exactly 4 children, the children of the node
+        // at index i start at index 1 + 4 * rank(i), where rank(i) is the number of internal nodes before i.
+        struct TileBits {
+            std::vector<std::uint64_t> subNodeWords;
+            std::vector<std::uint64_t> insideWords;
+            std::vector<std::uint32_t> subNodeRanks; // number of internal nodes before each word
+
+            TileBits() : subNodeWords(), insideWords(), subNodeRanks() { }
+
+            bool hasSubNodes(std::size_t index) const;
+            bool isInside(std::size_t index) const;
+            std::size_t getChildIndex(std::size_t index, int idx) const;
+        };
+
         const TileNode* getRootNode() const;
-        const TileNode* findTileNode(const MapTile& tile) const;
+        const TileBits* getTileBits() const;
 
         static void BuildTileNode(TileNode& node, const std::unordered_set<MapTile>& tileSet, const MapTile& tile, int clipZoom);
         static void DecodeTileNode(TileNode& node, const std::vector<bool>& data, std::size_t& offset, const MapTile& tile);
         static void EncodeTileNode(const TileNode& node, std::vector<bool>& data);
+        static void DecodeTileLevels(std::vector<std::vector<bool> >& levels, const std::vector<bool>& data, std::size_t& offset, std::size_t level);
+        static std::unique_ptr<TileBits> BuildTileBits(const std::vector<bool>& data);
 
         static std::vector<std::vector<MapPos> > CalculateTileNodeBoundingPolygon(const TileNode& node, const std::shared_ptr<Projection>& proj);
 
@@ -116,6 +132,7 @@ namespace carto {
         int _maxZoomLevel;
 
         mutable std::unique_ptr<TileNode> _cachedRootNode;
+        mutable std::unique_ptr<TileBits> _cachedTileBits;
         mutable std::mutex _mutex;
     };
 }
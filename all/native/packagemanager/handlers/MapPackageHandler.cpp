@@ -3,10 +3,19 @@
 #include "MapPackageHandler.h"
 #include "core/BinaryData.h"
 #include "components/Exceptions.h"
+#include "components/InflatePool.h"
 #include "packagemanager/PackageTileMask.h"
 #include "utils/Log.h"
+#include "utils/TraceUtils.h"
 
-#include <stdext/zlib.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <map>
+#include <thread>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/algorithm/string.hpp>
 
 #include <sqlite3pp.h>
 #include <sqlite3ppext.h>
@@ -19,13 +28,26 @@
 
 namespace carto {
 
+    struct MapPackageHandler::Connection {
+        std::unique_ptr<sqlite3pp::database> database;
+        std::unique_ptr<sqlite3pp::ext::function> decryptFunc;
+        std::unique_ptr<sqlite3pp::query> selectQuery;
+        std::shared_ptr<BinaryData> sharedDictionary;
+        int generation;
+    };
+
     MapPackageHandler::MapPackageHandler(const std::string& fileName, const std::string& serverEncKey, const std::string& localEncKey) :
         PackageHandler(fileName),
         _serverEncKey(serverEncKey),
         _localEncKey(localEncKey),
-        _packageDb(),
-        _decryptFunc(),
-        _sharedDictionary()
+        _encrypted(false),
+        _sharedDictionary(),
+        _connections(),
+        _connectionCount(0),
+        _connectionGeneration(0),
+        _connectionsOpen(false),
+        _connectionsCondition(),
+        _connectionsMutex()
     {
     }
 
@@ -35,43 +57,31 @@ namespace carto {
     void MapPackageHandler::openDatabase() {
         std::lock_guard<std::recursive_mutex> lock(_mutex);
 
-        if (_packageDb) {
-            return;
+        {
+            std::lock_guard<std::mutex> connectionsLock(_connectionsMutex);
+            if (_connectionsOpen) {
+                return;
+            }
         }
 
         try {
-            // Open package database
-            _packageDb.reset(new sqlite3pp::database());
-            if (_packageDb->connect_v2(_fileName.c_str(), SQLITE_OPEN_READONLY) != SQLITE_OK) {
+            // Open package database, check if the database is crypted
+            sqlite3pp::database packageDb;
+            if (packageDb.connect_v2(_fileName.c_str(), SQLITE_OPEN_READONLY) != SQLITE_OK) {
                 Log::Errorf("MapPackageHandler::openDatabase: Failed to open database %s", _fileName.c_str());
                 return;
             }
-
-            // Create new sqlite decryption function. First check if the database is crypted.
-            std::string encKey = _serverEncKey;
-            bool encrypted = CheckDbEncryption(*_packageDb, _serverEncKey + _localEncKey); // NOTE: this is a hack - though tiles are actually encrypted with server key only, with check that local key is included in the hash also
-            _decryptFunc.reset(new sqlite3pp::ext::function(*_packageDb));
-            _decryptFunc->create("tile_decrypt", [encrypted, encKey](sqlite3pp::ext::context& ctx) {
-                const unsigned char* encData = reinterpret_cast<const unsigned char*>(ctx.get<const void*>(0));
-                std::size_t encSize = ctx.args_bytes(0);
-                int zoom = ctx.get<int>(1);
-                int x = ctx.get<int>(2);
-                int y = ctx.get<int>(3);
-                std::vector<unsigned char> encVector(encData, encData + encSize);
-                if (encrypted) {
-                    DecryptTile(encVector, zoom, x, y, encKey);
-                }
-                ctx.result(encVector.empty() ? nullptr : &encVector[0], static_cast<int>(encVector.size()), false);
-            }, 4);
+            bool encrypted = CheckDbEncryption(packageDb, _serverEncKey + _localEncKey); // NOTE: this is a hack - though tiles are actually encrypted with server key only, with check that local key is included in the hash also
 
             // Try to load shared dictionary
-            _sharedDictionary.reset();
-            sqlite3pp::query query(*_packageDb, "SELECT value FROM metadata WHERE name='shared_zlib_dict'");
-            for (auto qit = query.begin(); qit != query.end(); qit++) {
-                const unsigned char* dataPtr = reinterpret_cast<const unsigned char*>(qit->get<const void*>(0));
-                std::size_t dataSize = qit->column_bytes(0);
-                _sharedDictionary.reset(new BinaryData(dataPtr, dataSize));
-            }
+            std::shared_ptr<BinaryData> sharedDictionary = LoadSharedDictionary(packageDb);
+
+            // Read connections are created on demand
+            std::lock_guard<std::mutex> connectionsLock(_connectionsMutex);
+            _encrypted = encrypted;
+            _sharedDictionary = sharedDictionary;
+            _connectionsOpen = true;
+            _connectionsCondition.notify_all();
         }
         catch (const std::exception& ex) {
             Log::Errorf("MapPackageHandler::openDatabase: Exception %s", ex.what());
@@ -81,41 +91,95 @@ namespace carto {
     void MapPackageHandler::closeDatabase() {
         std::lock_guard<std::recursive_mutex> lock(_mutex);
 
-        _packageDb.reset();
-        _decryptFunc.reset();
-        _sharedDictionary.reset();
+        std::vector<std::shared_ptr<Connection> > connections;
+        {
+            std::lock_guard<std::mutex> connectionsLock(_connectionsMutex);
+            std::swap(connections, _connections); // connections currently in use are closed once released
+            _connectionCount = 0;
+            _connectionGeneration++;
+            _connectionsOpen = false;
+            _sharedDictionary.reset();
+            _connectionsCondition.notify_all();
+        }
     }
 
     std::shared_ptr<BinaryData> MapPackageHandler::loadTile(const MapTile& mapTile) {
-        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        std::shared_ptr<Connection> connection = acquireConnection();
+        if (!connection) {
+            return std::shared_ptr<BinaryData>();
+        }
 
+        std::shared_ptr<BinaryData> data;
         try {
-            openDatabase();
-
             // Try to load the tile (this could fail, as tile masks may not be complete to the last zoom level)
-            sqlite3pp::query query(*_packageDb, "SELECT tile_decrypt(tile_data, zoom_level, tile_column, tile_row) FROM tiles WHERE zoom_level=:zoom AND tile_column=:x AND tile_row=:y");
+            sqlite3pp::query& query = *connection->selectQuery;
+            query.reset();
             query.bind(":zoom", mapTile.getZoom());
             query.bind(":x", mapTile.getX());
             query.bind(":y", mapTile.getY());
             for (auto qit = query.begin(); qit != query.end(); qit++) {
                 const unsigned char* dataPtr = reinterpret_cast<const unsigned char*>(qit->get<const void*>(0));
                 std::size_t dataSize = qit->column_bytes(0);
-                std::vector<unsigned char> data(dataPtr, dataPtr + dataSize);
-                if (_sharedDictionary) {
-                    std::vector<unsigned char> uncompressedData;
-                    if (!zlib::inflate_raw(data.data(), data.size(), _sharedDictionary->data(), _sharedDictionary->size(), uncompressedData)) {
-                        Log::Warnf("MapPackageHandler::loadTile: Failed to decompress tile with shared dictionary");
-                        return std::shared_ptr<BinaryData>();
+                data = DecompressTile(dataPtr, dataSize, connection->sharedDictionary);
+                break;
+            }
+            query.reset();
+        }
+        catch (const std::exception& ex) {
+            Log::Errorf("MapPackageHandler::loadTile: Exception %s", ex.what());
+            connection->selectQuery->reset();
+        }
+        releaseConnection(connection);
+        return data;
+    }
+
+    std::vector<std::shared_ptr<BinaryData> > MapPackageHandler::loadTiles(const std::vector<MapTile>& mapTiles) {
+        std::vector<std::shared_ptr<BinaryData> > tileDatas(mapTiles.size());
+        std::shared_ptr<Connection> connection = acquireConnection();
+        if (!connection) {
+            return tileDatas;
+        }
+
+        try {
+            // Query the tiles in chunks, using single query per chunk
+            for (std::size_t offset = 0; offset < mapTiles.size(); offset += MAX_BATCH_TILES) {
+                std::size_t count = std::min(mapTiles.size() - offset, static_cast<std::size_t>(MAX_BATCH_TILES));
+
+                std::string sql = "SELECT zoom_level, tile_column, tile_row, tile_decrypt(tile_data, zoom_level, tile_column, tile_row) FROM tiles WHERE ";
+                for (std::size_t i = 0; i < count; i++) {
+                    sql += (i > 0 ? " OR " : "");
+                    sql += "(zoom_level=? AND tile_column=? AND tile_row=?)";
+                }
+
+                std::multimap<long long, std::size_t> tileIndices;
+                sqlite3pp::query query(*connection->database, sql.c_str());
+                for (std::size_t i = 0; i < count; i++) {
+                    const MapTile& mapTile = mapTiles[offset + i];
+                    query.bind(static_cast<int>(i * 3 + 1), mapTile.getZoom());
+                    query.bind(static_cast<int>(i * 3 + 2), mapTile.getX());
+                    query.bind(static_cast<int>(i * 3 + 3), mapTile.getY());
+                    tileIndices.emplace(MapTile(mapTile.getX(), mapTile.getY(), mapTile.getZoom(), 0).getTileId(), offset + i);
+                }
+
+                for (auto qit = query.begin(); qit != query.end(); qit++) {
+                    auto range = tileIndices.equal_range(MapTile(qit->get<int>(1), qit->get<int>(2), qit->get<int>(0), 0).getTileId());
+                    if (range.first == range.second) {
+                        continue;
+                    }
+                    const unsigned char* dataPtr = reinterpret_cast<const unsigned char*>(qit->get<const void*>(3));
+                    std::size_t dataSize = qit->column_bytes(3);
+                    std::shared_ptr<BinaryData> data = DecompressTile(dataPtr, dataSize, connection->sharedDictionary);
+                    for (auto indexIt = range.first; indexIt != range.second; indexIt++) {
+                        tileDatas[indexIt->second] = data;
                     }
-                    std::swap(data, uncompressedData);
                 }
-                return std::make_shared<BinaryData>(std::move(data));
             }
         }
         catch (const std::exception& ex) {
-            Log::Errorf("MapPackageHandler::loadTile: Exception %s", ex.what());
+            Log::Errorf("MapPackageHandler::loadTiles: Exception %s", ex.what());
         }
-        return std::shared_ptr<BinaryData>();
+        releaseConnection(connection);
+        return tileDatas;
     }
 
     void MapPackageHandler::onImportPackage() {
@@ -135,24 +199,345 @@ namespace carto {
     void MapPackageHandler::onDeletePackage() {
     }
 
-    std::shared_ptr<PackageTileMask> MapPackageHandler::calculateTileMask() const {
+    bool MapPackageHandler::applyDeltaPackage(const std::string& deltaFileName) {
+        // Delta package is an MBTiles database with changed tiles in 'tiles' table (with SHA1 'tile_hash' of tile data) and removed tiles in optional 'deleted_tiles' table
         std::lock_guard<std::recursive_mutex> lock(_mutex);
 
-        // Fetch all tile coordinates and create tilemask from them
+        try {
+            sqlite3pp::database deltaDb;
+            if (deltaDb.connect_v2(deltaFileName.c_str(), SQLITE_OPEN_READONLY) != SQLITE_OK) {
+                Log::Errorf("MapPackageHandler::applyDeltaPackage: Failed to open delta database %s", deltaFileName.c_str());
+                return false;
+            }
+            sqlite3pp::database packageDb;
+            if (packageDb.connect_v2(_fileName.c_str(), SQLITE_OPEN_READWRITE) != SQLITE_OK) {
+                Log::Errorf("MapPackageHandler::applyDeltaPackage: Failed to open database %s", _fileName.c_str());
+                return false;
+            }
+
+            // The delta must use the same tile encryption and compression as the package. Delta tiles are encrypted with the server key only.
+            bool encrypted = CheckDbEncryption(packageDb, _serverEncKey + _localEncKey);
+            if (CheckDbEncryption(deltaDb, _serverEncKey) != encrypted) {
+                Log::Error("MapPackageHandler::applyDeltaPackage: Delta encryption does not match the package");
+                return false;
+            }
+            std::shared_ptr<BinaryData> sharedDictionary = LoadSharedDictionary(packageDb);
+            std::shared_ptr<BinaryData> deltaSharedDictionary = LoadSharedDictionary(deltaDb);
+            if (static_cast<bool>(sharedDictionary) != static_cast<bool>(deltaSharedDictionary) || (sharedDictionary && *sharedDictionary != *deltaSharedDictionary)) {
+                Log::Error("MapPackageHandler::applyDeltaPackage: Delta compression dictionary does not match the package");
+                return false;
+            }
+
+            bool hasDeletedTiles = false;
+            sqlite3pp::query tableQuery(deltaDb, "SELECT name FROM sqlite_master WHERE type='table' AND name='deleted_tiles'");
+            for (auto qit = tableQuery.begin(); qit != tableQuery.end(); qit++) {
+                hasDeletedTiles = true;
+            }
+            tableQuery.finish();
+
+            // Apply all changes in a single transaction, so the package is either fully updated or left intact
+            sqlite3pp::transaction xct(packageDb);
+            {
+                sqlite3pp::command deleteCommand(packageDb, "DELETE FROM tiles WHERE zoom_level=:zoom AND tile_column=:x AND tile_row=:y");
+                sqlite3pp::command insertCommand(packageDb, "INSERT INTO tiles(zoom_level, tile_column, tile_row, tile_data) VALUES(:zoom, :x, :y, :data)");
+
+                if (hasDeletedTiles) {
+                    sqlite3pp::query deletedQuery(deltaDb, "SELECT zoom_level, tile_column, tile_row FROM deleted_tiles");
+                    for (auto qit = deletedQuery.begin(); qit != deletedQuery.end(); qit++) {
+                        deleteCommand.reset();
+                        deleteCommand.bind(":zoom", qit->get<int>(0));
+                        deleteCommand.bind(":x", qit->get<int>(1));
+                        deleteCommand.bind(":y", qit->get<int>(2));
+                        deleteCommand.execute();
+                    }
+                }
+
+                sqlite3pp::query tileQuery(deltaDb, "SELECT zoom_level, tile_column, tile_row, tile_data, tile_hash FROM tiles");
+                for (auto qit = tileQuery.begin(); qit != tileQuery.end(); qit++) {
+                    const unsigned char* dataPtr = reinterpret_cast<const unsigned char*>(qit->get<const void*>(3));
+                    std::size_t dataSize = qit->column_bytes(3);
+                    const char* tileHash = qit->get<const char*>(4);
+                    if (!tileHash || !boost::iequals(CalculateHash(dataPtr, dataSize), tileHash)) {
+                        throw GenericException("Delta tile hash mismatch");
+                    }
+
+                    deleteCommand.reset();
+                    deleteCommand.bind(":zoom", qit->get<int>(0));
+                    deleteCommand.bind(":x", qit->get<int>(1));
+                    deleteCommand.bind(":y", qit->get<int>(2));
+                    deleteCommand.execute();
+
+                    insertCommand.reset();
+                    insertCommand.bind(":zoom", qit->get<int>(0));
+                    insertCommand.bind(":x", qit->get<int>(1));
+                    insertCommand.bind(":y", qit->get<int>(2));
+                    insertCommand.bind(":data", dataPtr, static_cast<int>(dataSize));
+                    insertCommand.execute();
+                }
+            }
+            xct.commit();
+
+            // Restore the server key hash, the local key is added again when the package is imported
+            if (encrypted) {
+                UpdateDbEncryption(packageDb, _serverEncKey);
+            }
+        }
+        catch (const std::exception& ex) {
+            Log::Errorf("MapPackageHandler::applyDeltaPackage: Exception %s", ex.what());
+            return false;
+        }
+        return true;
+    }
+
+    std::shared_ptr<PackageTileMask> MapPackageHandler::calculateTileMask() const {
+        CARTO_TRACE_SECTION("MapPackageHandler::calculateTileMask");
+
+        // The database is only read here, so the handler lock is not needed
         sqlite3pp::database packageDb;
         if (packageDb.connect_v2(_fileName.c_str(), SQLITE_OPEN_READONLY) != SQLITE_OK) {
             Log::Errorf("MapPackageHandler::calculateTileMask: Failed to open database %s", _fileName.c_str());
             return std::shared_ptr<PackageTileMask>();
         }
-        sqlite3pp::query query(packageDb, "SELECT zoom_level, tile_column, tile_row FROM tiles");
+
+        // Use the precomputed tile mask from the package metadata, if present
+        std::string tileMaskValue;
+        int maxZoomLevel = -1;
+        sqlite3pp::query metaQuery(packageDb, "SELECT name, value FROM metadata WHERE name='tilemask' OR name='maxzoom'");
+        for (auto qit = metaQuery.begin(); qit != metaQuery.end(); qit++) {
+            std::string name = qit->get<const char*>(0);
+            const char* value = qit->get<const char*>(1);
+            if (!value) {
+                continue;
+            }
+            if (name == "tilemask") {
+                tileMaskValue = value;
+            } else {
+                try {
+                    maxZoomLevel = boost::lexical_cast<int>(value);
+                }
+                catch (const boost::bad_lexical_cast&) {
+                    Log::Warnf("MapPackageHandler::calculateTileMask: Invalid maxzoom value %s", value);
+                }
+            }
+        }
+        metaQuery.finish();
+        if (!tileMaskValue.empty() && maxZoomLevel >= 0) {
+            return std::make_shared<PackageTileMask>(tileMaskValue, maxZoomLevel);
+        }
+
+        // Split the tile index into ranges of columns per zoom level. The queries below are resolved using the tile index without scanning the table.
+        struct TileRange {
+            int zoom;
+            int minX;
+            int maxX;
+        };
+        std::vector<TileRange> tileRanges;
+        unsigned int threadCount = std::max(1u, std::min(std::thread::hardware_concurrency(), MAX_TILEMASK_THREADS));
+        sqlite3pp::query maxZoomQuery(packageDb, "SELECT MAX(zoom_level) FROM tiles");
+        for (auto qit = maxZoomQuery.begin(); qit != maxZoomQuery.end(); qit++) {
+            maxZoomLevel = qit->column_type(0) == SQLITE_NULL ? -1 : qit->get<int>(0);
+        }
+        maxZoomQuery.finish();
+        sqlite3pp::query minXQuery(packageDb, "SELECT MIN(tile_column) FROM tiles WHERE zoom_level=:zoom");
+        sqlite3pp::query maxXQuery(packageDb, "SELECT MAX(tile_column) FROM tiles WHERE zoom_level=:zoom");
+        for (int zoom = maxZoomLevel; zoom >= 0; zoom--) {
+            int minX = -1;
+            int maxX = -1;
+            minXQuery.reset();
+            minXQuery.bind(":zoom", zoom);
+            for (auto qit = minXQuery.begin(); qit != minXQuery.end(); qit++) {
+                minX = qit->column_type(0) == SQLITE_NULL ? -1 : qit->get<int>(0);
+            }
+            maxXQuery.reset();
+            maxXQuery.bind(":zoom", zoom);
+            for (auto qit = maxXQuery.begin(); qit != maxXQuery.end(); qit++) {
+                maxX = qit->column_type(0) == SQLITE_NULL ? -1 : qit->get<int>(0);
+            }
+            if (minX < 0 || maxX < minX) {
+                continue;
+            }
+
+            // Highest zoom levels contain most of the tiles, split them so that all threads can work on them
+            int rangeCount = static_cast<int>(std::min(static_cast<unsigned int>(maxX - minX + 1), threadCount));
+            for (int i = 0; i < rangeCount; i++) {
+                TileRange tileRange;
+                tileRange.zoom = zoom;
+                tileRange.minX = minX + static_cast<int>(static_cast<long long>(maxX - minX + 1) * i / rangeCount);
+                tileRange.maxX = minX + static_cast<int>(static_cast<long long>(maxX - minX + 1) * (i + 1) / rangeCount) - 1;
+                tileRanges.push_back(tileRange);
+            }
+        }
+        minXQuery.finish();
+        maxXQuery.finish();
+
+        // Read the tile coordinates of the ranges in parallel, each thread uses its own connection
+        std::vector<std::vector<MapTile> > rangeTiles(tileRanges.size());
+        std::atomic<std::size_t> nextRange(0);
+        std::exception_ptr threadException;
+        std::mutex exceptionMutex;
+        std::vector<std::thread> threads;
+        for (unsigned int i = 0; i < std::min(threadCount, static_cast<unsigned int>(tileRanges.size())); i++) {
+            threads.emplace_back([&]() {
+                try {
+                    sqlite3pp::database db;
+                    if (db.connect_v2(_fileName.c_str(), SQLITE_OPEN_READONLY) != SQLITE_OK) {
+                        throw GenericException("Failed to open database", _fileName);
+                    }
+                    sqlite3pp::query query(db, "SELECT tile_column, tile_row FROM tiles WHERE zoom_level=:zoom AND tile_column>=:min_x AND tile_column<=:max_x");
+                    for (std::size_t index = nextRange++; index < tileRanges.size(); index = nextRange++) {
+                        const TileRange& tileRange = tileRanges[index];
+                        query.reset();
+                        query.bind(":zoom", tileRange.zoom);
+                        query.bind(":min_x", tileRange.minX);
+                        query.bind(":max_x", tileRange.maxX);
+                        std::vector<MapTile>& tiles = rangeTiles[index];
+                        for (auto qit = query.begin(); qit != query.end(); qit++) {
+                            tiles.emplace_back(qit->get<int>(0), qit->get<int>(1), tileRange.zoom, 0);
+                        }
+                    }
+                    query.finish();
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(exceptionMutex);
+                    threadException = std::current_exception();
+                    nextRange = tileRanges.size();
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        if (threadException) {
+            std::rethrow_exception(threadException);
+        }
+
         std::vector<MapTile> tiles;
-        int maxZoomLevel = 0;
+        std::size_t tileCount = 0;
+        for (const std::vector<MapTile>& rangeTile : rangeTiles) {
+            tileCount += rangeTile.size();
+        }
+        tiles.reserve(tileCount);
+        for (const std::vector<MapTile>& rangeTile : rangeTiles) {
+            tiles.insert(tiles.end(), rangeTile.begin(), rangeTile.end());
+        }
+        return std::make_shared<PackageTileMask>(tiles, std::max(0, maxZoomLevel));
+    }
+
+    std::shared_ptr<MapPackageHandler::Connection> MapPackageHandler::acquireConnection() {
+        std::unique_lock<std::mutex> lock(_connectionsMutex);
+        while (true) {
+            if (!_connectionsOpen) {
+                lock.unlock();
+                openDatabase();
+                lock.lock();
+                if (!_connectionsOpen) {
+                    return std::shared_ptr<Connection>();
+                }
+                continue;
+            }
+
+            if (!_connections.empty()) {
+                std::shared_ptr<Connection> connection = _connections.back();
+                _connections.pop_back();
+                return connection;
+            }
+
+            if (_connectionCount < MAX_CONNECTIONS) {
+                break;
+            }
+
+            _connectionsCondition.wait(lock);
+        }
+
+        // Create a new connection outside of the lock, as this involves file access
+        _connectionCount++;
+        bool encrypted = _encrypted;
+        std::shared_ptr<BinaryData> sharedDictionary = _sharedDictionary;
+        int generation = _connectionGeneration;
+        lock.unlock();
+
+        std::shared_ptr<Connection> connection = createConnection(encrypted, sharedDictionary, generation);
+        if (!connection) {
+            lock.lock();
+            if (generation == _connectionGeneration) {
+                _connectionCount--;
+            }
+            _connectionsCondition.notify_one();
+        }
+        return connection;
+    }
+
+    void MapPackageHandler::releaseConnection(const std::shared_ptr<Connection>& connection) {
+        std::lock_guard<std::mutex> lock(_connectionsMutex);
+        if (_connectionsOpen && connection->generation == _connectionGeneration) {
+            _connections.push_back(connection);
+        }
+        _connectionsCondition.notify_one();
+    }
+
+    std::shared_ptr<MapPackageHandler::Connection> MapPackageHandler::createConnection(bool encrypted, const std::shared_ptr<BinaryData>& sharedDictionary, int generation) const {
+        try {
+            auto connection = std::make_shared<Connection>();
+            connection->database.reset(new sqlite3pp::database());
+            if (connection->database->connect_v2(_fileName.c_str(), SQLITE_OPEN_READONLY) != SQLITE_OK) {
+                Log::Errorf("MapPackageHandler::createConnection: Failed to open database %s", _fileName.c_str());
+                return std::shared_ptr<Connection>();
+            }
+
+            // Read the package through memory mapping, all connections share the mapped pages of the OS page cache
+            if (connection->database->execute(("PRAGMA mmap_size=" + boost::lexical_cast<std::string>(MAX_MMAP_SIZE)).c_str()) != SQLITE_OK) {
+                Log::Warn("MapPackageHandler::createConnection: Failed to enable memory mapping");
+            }
+
+            // Each connection needs its own sqlite decryption function
+            std::string encKey = _serverEncKey;
+            connection->decryptFunc.reset(new sqlite3pp::ext::function(*connection->database));
+            connection->decryptFunc->create("tile_decrypt", [encrypted, encKey](sqlite3pp::ext::context& ctx) {
+                const unsigned char* encData = reinterpret_cast<const unsigned char*>(ctx.get<const void*>(0));
+                std::size_t encSize = ctx.args_bytes(0);
+                int zoom = ctx.get<int>(1);
+                int x = ctx.get<int>(2);
+                int y = ctx.get<int>(3);
+                std::vector<unsigned char> encVector(encData, encData + encSize);
+                if (encrypted) {
+                    DecryptTile(encVector, zoom, x, y, encKey);
+                }
+                ctx.result(encVector.empty() ? nullptr : &encVector[0], static_cast<int>(encVector.size()), false);
+            }, 4);
+
+            connection->selectQuery.reset(new sqlite3pp::query(*connection->database, "SELECT tile_decrypt(tile_data, zoom_level, tile_column, tile_row) FROM tiles WHERE zoom_level=:zoom AND tile_column=:x AND tile_row=:y"));
+            connection->sharedDictionary = sharedDictionary;
+            connection->generation = generation;
+            return connection;
+        }
+        catch (const std::exception& ex) {
+            Log::Errorf("MapPackageHandler::createConnection: Exception %s", ex.what());
+        }
+        return std::shared_ptr<Connection>();
+    }
+
+    std::shared_ptr<BinaryData> MapPackageHandler::DecompressTile(const unsigned char* dataPtr, std::size_t dataSize, const std::shared_ptr<BinaryData>& sharedDictionary) {
+        if (sharedDictionary) {
+            std::vector<unsigned char> uncompressedData;
+            if (!InflatePool::GetInstance().inflateRaw(dataPtr, dataSize, sharedDictionary->data(), sharedDictionary->size(), uncompressedData)) {
+                Log::Warnf("MapPackageHandler::DecompressTile: Failed to decompress tile with shared dictionary");
+                return std::shared_ptr<BinaryData>();
+            }
+            return std::make_shared<BinaryData>(std::move(uncompressedData));
+        }
+        return std::make_shared<BinaryData>(dataPtr, dataSize);
+    }
+
+    std::shared_ptr<BinaryData> MapPackageHandler::LoadSharedDictionary(sqlite3pp::database& db) {
+        std::shared_ptr<BinaryData> sharedDictionary;
+        sqlite3pp::query query(db, "SELECT value FROM metadata WHERE name='shared_zlib_dict'");
         for (auto qit = query.begin(); qit != query.end(); qit++) {
-            MapTile tile(qit->get<int>(1), qit->get<int>(2), qit->get<int>(0), 0);
-            maxZoomLevel = std::max(maxZoomLevel, tile.getZoom());
-            tiles.push_back(tile);
+            const unsigned char* dataPtr = reinterpret_cast<const unsigned char*>(qit->get<const void*>(0));
+            std::size_t dataSize = qit->column_bytes(0);
+            sharedDictionary = std::make_shared<BinaryData>(dataPtr, dataSize);
         }
-        return std::make_shared<PackageTileMask>(tiles, maxZoomLevel);
+        query.finish();
+        return sharedDictionary;
     }
 
     bool MapPackageHandler::CheckDbEncryption(sqlite3pp::database& db, const std::string& encKey) {
@@ -186,9 +571,13 @@ namespace carto {
     }
     
     std::string MapPackageHandler::CalculateKeyHash(const std::string& encKey) {
+        return CalculateHash(reinterpret_cast<const unsigned char*>(encKey.c_str()), encKey.size());
+    }
+
+    std::string MapPackageHandler::CalculateHash(const unsigned char* data, std::size_t size) {
         CryptoPP::SHA1 hash;
         unsigned char digest[CryptoPP::SHA1::DIGESTSIZE];
-        hash.CalculateDigest(digest, reinterpret_cast<const unsigned char*>(encKey.c_str()), encKey.size());
+        hash.CalculateDigest(digest, data, size);
         std::string sha1;
         CryptoPP::HexEncoder encoder;
         encoder.Attach(new CryptoPP::StringSink(sha1));
@@ -247,6 +636,11 @@ namespace carto {
         std::copy(encKey.begin(), encKey.begin() + std::min(encKey.size(), static_cast<std::size_t>(CryptoPP::RC5::DEFAULT_KEYLENGTH)), k);
     }
 
+    const unsigned int MapPackageHandler::MAX_BATCH_TILES = 64;
+    const unsigned int MapPackageHandler::MAX_CONNECTIONS = 4;
+    const unsigned int MapPackageHandler::MAX_TILEMASK_THREADS = 4;
+    const long long MapPackageHandler::MAX_MMAP_SIZE = 256LL * 1024 * 1024;
+
 }
 
 #endif
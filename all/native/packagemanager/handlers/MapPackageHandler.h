@@ -12,13 +12,13 @@
 #include "core/MapTile.h"
 #include "packagemanager/handlers/PackageHandler.h"
 
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 namespace sqlite3pp {
     class database;
-    namespace ext {
-        class function;
-    }
 }
 
 namespace carto {
@@ -32,17 +32,36 @@ namespace carto {
         void openDatabase();
         void closeDatabase();
         std::shared_ptr<BinaryData> loadTile(const MapTile& mapTile);
+        std::vector<std::shared_ptr<BinaryData> > loadTiles(const std::vector<MapTile>& mapTiles);
 
         virtual void onImportPackage();
         virtual void onDeletePackage();
 
         virtual std::shared_ptr<PackageTileMask> calculateTileMask() const;
 
+        virtual bool applyDeltaPackage(const std::string& deltaFileName);
+
     private:
+        struct Connection;
+
+        static const unsigned int MAX_BATCH_TILES;
+        static const unsigned int MAX_CONNECTIONS;
+        static const unsigned int MAX_TILEMASK_THREADS;
+        static const long long MAX_MMAP_SIZE;
+
+        std::shared_ptr<Connection> acquireConnection();
+        void releaseConnection(const std::shared_ptr<Connection>& connection);
+        std::shared_ptr<Connection> createConnection(bool encrypted, const std::shared_ptr<BinaryData>& sharedDictionary, int generation) const;
+
+        static std::shared_ptr<BinaryData> DecompressTile(const unsigned char* dataPtr, std::size_t dataSize, const std::shared_ptr<BinaryData>& sharedDictionary);
+
+        static std::shared_ptr<BinaryData> LoadSharedDictionary(sqlite3pp::database& db);
+
         static bool CheckDbEncryption(sqlite3pp::database& db, const std::string& encKey);
         static void UpdateDbEncryption(sqlite3pp::database& db, const std::string& encKey);
 
         static std::string CalculateKeyHash(const std::string& encKey);
+        static std::string CalculateHash(const unsigned char* data, std::size_t size);
         static void EncryptTile(std::vector<unsigned char>& data, int zoom, int x, int y, const std::string& encKey);
         static void DecryptTile(std::vector<unsigned char>& data, int zoom, int x, int y, const std::string& encKey);
         static void SetCipherKeyIV(unsigned char* k, unsigned char* iv, int zoom, int x, int y, const std::string& encKey);
@@ -50,9 +69,15 @@ namespace carto {
         const std::string _serverEncKey;
         const std::string _localEncKey;
 
-        std::unique_ptr<sqlite3pp::database> _packageDb;
-        std::unique_ptr<sqlite3pp::ext::function> _decryptFunc;
-        std::unique_ptr<BinaryData> _sharedDictionary;
+        bool _encrypted;
+        std::shared_ptr<BinaryData> _sharedDictionary;
+
+        std::vector<std::shared_ptr<Connection> > _connections; // idle read connections
+        unsigned int _connectionCount;
+        int _connectionGeneration; // incremented when the database is closed, connections of older generations are not reused
+        bool _connectionsOpen;
+        std::condition_variable _connectionsCondition;
+        std::mutex _connectionsMutex;
     };
     
 }
@@ -24,6 +24,8 @@ namespace carto {
         virtual void onDeletePackage() = 0;
 
         virtual std::shared_ptr<PackageTileMask> calculateTileMask() const = 0;
+
+        virtual bool applyDeltaPackage(const std::string& deltaFileName) { return false; }
     
     protected:
         PackageHandler(const std::string& fileName) : _fileName(fileName), _mutex() { }
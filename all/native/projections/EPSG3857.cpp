@@ -22,6 +22,15 @@ namespace carto {
         return MapPos(mapPos.getX() * METERS_TO_INTERNAL_EQUATOR, mapPos.getY() * METERS_TO_INTERNAL_EQUATOR, mapPos.getZ() * METERS_TO_INTERNAL_EQUATOR);
     }
 
+    void EPSG3857::toInternalPoses(const MapPos* mapPoses, MapPos* mapPosesInternal, std::size_t count) const {
+        // Plain scaling over contiguous coordinates, without per-position virtual calls
+        const double scale = METERS_TO_INTERNAL_EQUATOR;
+        for (std::size_t i = 0; i < count; i++) {
+            const MapPos& mapPos = mapPoses[i];
+            mapPosesInternal[i] = MapPos(mapPos.getX() * scale, mapPos.getY() * scale, mapPos.getZ() * scale);
+        }
+    }
+
     MapPos EPSG3857::fromWgs84(const MapPos& wgs84Pos) const {
         double x = wgs84Pos.getX() * Const::DEG_TO_RAD * EARTH_RADIUS;
         double a = std::sin(wgs84Pos.getY() * Const::DEG_TO_RAD);
@@ -22,6 +22,7 @@ namespace carto {
         
         virtual MapPos fromInternal(const MapPos& mapPosInternal) const;
         virtual MapPos toInternal(const MapPos& mapPos) const;
+        virtual void toInternalPoses(const MapPos* mapPoses, MapPos* mapPosesInternal, std::size_t count) const;
 
         virtual MapPos fromWgs84(const MapPos& wgs84Pos) const;
         virtual MapPos toWgs84(const MapPos& mapPos) const;
@@ -29,6 +29,12 @@ namespace carto {
         return MapPos(x, y, z);
     }
 
+    void EPSG4326::toInternalPoses(const MapPos* mapPoses, MapPos* mapPosesInternal, std::size_t count) const {
+        for (std::size_t i = 0; i < count; i++) {
+            mapPosesInternal[i] = EPSG4326::toInternal(mapPoses[i]);
+        }
+    }
+
     MapPos EPSG4326::fromWgs84(const MapPos& wgs84Pos) const {
         return wgs84Pos;
     }
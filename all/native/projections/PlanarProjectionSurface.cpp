@@ -18,6 +18,12 @@ namespace carto {
         return cglib::vec3<double>(mapPos.getX(), mapPos.getY(), mapPos.getZ());
     }
 
+    void PlanarProjectionSurface::calculatePositions(const MapPos* mapPoses, cglib::vec3<double>* positions, std::size_t count) const {
+        for (std::size_t i = 0; i < count; i++) {
+            positions[i] = cglib::vec3<double>(mapPoses[i].getX(), mapPoses[i].getY(), mapPoses[i].getZ());
+        }
+    }
+
     cglib::vec3<double> PlanarProjectionSurface::calculateNormal(const MapPos& mapPos) const {
         return cglib::vec3<double>(0, 0, 1);
     }
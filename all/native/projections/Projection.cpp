@@ -15,6 +15,12 @@ namespace carto {
         return _bounds;
     }
         
+    void Projection::toInternalPoses(const MapPos* poses, MapPos* internalPoses, std::size_t count) const {
+        for (std::size_t i = 0; i < count; i++) {
+            internalPoses[i] = toInternal(poses[i]);
+        }
+    }
+
     MapPos Projection::fromLatLong(double lat, double lng) const {
         return fromWgs84(MapPos(lng, lat));
     }
@@ -10,6 +10,8 @@
 #include "core/MapPos.h"
 #include "core/MapBounds.h"
 
+#include <cstddef>
+
 namespace carto {
     
     /**
@@ -37,6 +39,14 @@ namespace carto {
          * @return The transformed position in the internal coordinate system.
          */
         virtual MapPos toInternal(const MapPos& pos) const = 0;
+        /**
+         * Transforms an array of positions from the coordinate system of this projection to the internal coordinate system.
+         * The default implementation calls toInternal for each position, subclasses can provide faster batch versions.
+         * @param poses The positions in the coordinate system of this projection.
+         * @param internalPoses The array for the transformed positions. Can be the same as the input array.
+         * @param count The number of positions to transform.
+         */
+        virtual void toInternalPoses(const MapPos* poses, MapPos* internalPoses, std::size_t count) const;
         
         /**
          * Transforms a position from the WGS84 coordinate system to the coordinate system of this projection.
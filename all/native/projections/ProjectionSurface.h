@@ -10,6 +10,7 @@
 #include "core/MapPos.h"
 #include "core/MapVec.h"
 
+#include <cstddef>
 #include <vector>
 
 #include <cglib/vec.h>
@@ -26,6 +27,7 @@ namespace carto {
         virtual MapVec calculateMapVec(const cglib::vec3<double>& pos, const cglib::vec3<double>& vec) const = 0;
 
         virtual cglib::vec3<double> calculatePosition(const MapPos& mapPos) const = 0;
+        virtual void calculatePositions(const MapPos* mapPoses, cglib::vec3<double>* positions, std::size_t count) const = 0;
         virtual cglib::vec3<double> calculateNormal(const MapPos& mapPos) const = 0;
         virtual cglib::vec3<double> calculateVector(const MapPos& mapPos, const MapVec& mapVec) const = 0;
 
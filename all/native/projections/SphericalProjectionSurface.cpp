@@ -1,6 +1,8 @@
 #include "SphericalProjectionSurface.h"
 #include "utils/Const.h"
 
+#include <array>
+
 namespace carto {
     
     SphericalProjectionSurface::SphericalProjectionSurface() {
@@ -22,6 +24,12 @@ namespace carto {
         return InternalToSpherical(mapPos) * SPHERE_SIZE;
     }
 
+    void SphericalProjectionSurface::calculatePositions(const MapPos* mapPoses, cglib::vec3<double>* positions, std::size_t count) const {
+        for (std::size_t i = 0; i < count; i++) {
+            positions[i] = InternalToSpherical(mapPoses[i]) * SPHERE_SIZE;
+        }
+    }
+
     cglib::vec3<double> SphericalProjectionSurface::calculateNormal(const MapPos& mapPos) const {
         return InternalToSpherical(mapPos);
     }
@@ -34,48 +42,63 @@ namespace carto {
     }
 
     void SphericalProjectionSurface::tesselateSegment(const MapPos& mapPos0, const MapPos& mapPos1, std::vector<MapPos>& mapPoses) const {
-        // TODO: make it faster, non-recursive
-        MapPos mapPosM;
-        if (SplitSegment(mapPos0, mapPos1, mapPosM)) {
-            tesselateSegment(mapPos0, mapPosM, mapPoses);
-            tesselateSegment(mapPosM, mapPos1, mapPoses);
-            return;
+        // Recursive midpoint splitting divides the great circle arc into equal parts, so the split points can be calculated directly
+        cglib::vec3<double> pos0 = cglib::unit(InternalToSpherical(mapPos0));
+        cglib::vec3<double> pos1 = cglib::unit(InternalToSpherical(mapPos1));
+        double dot = cglib::dot_product(pos0, pos1);
+        double angle = std::acos(std::min(1.0, std::max(-1.0, dot)));
+        int splitCount = 1;
+        if (dot > -1) {
+            for (double length = angle * Const::EARTH_RADIUS; length >= SEGMENT_SPLIT_THRESHOLD; length *= 0.5) {
+                splitCount *= 2;
+            }
         }
 
+        mapPoses.reserve(mapPoses.size() + splitCount + 1);
         mapPoses.push_back(mapPos0);
+        if (splitCount > 1) {
+            double sinAngle = std::sin(angle);
+            for (int i = 1; i < splitCount; i++) {
+                double t = static_cast<double>(i) / splitCount;
+                cglib::vec3<double> pos = pos0 * (std::sin((1 - t) * angle) / sinAngle) + pos1 * (std::sin(t * angle) / sinAngle);
+                mapPoses.push_back(SphericalToInternal(cglib::unit(pos)));
+            }
+        }
         mapPoses.push_back(mapPos1);
     }
 
     void SphericalProjectionSurface::tesselateTriangle(unsigned int i0, unsigned int i1, unsigned int i2, std::vector<unsigned int>& indices, std::vector<MapPos>& mapPoses) const {
-        const MapPos& mapPos0 = mapPoses.at(i0);
-        const MapPos& mapPos1 = mapPoses.at(i1);
-        const MapPos& mapPos2 = mapPoses.at(i2);
-        
-        // TODO: make it faster, non-recursive
-        MapPos mapPosM;
-        if (SplitSegment(mapPos0, mapPos1, mapPosM)) {
-            unsigned int iM = static_cast<int>(mapPoses.size());
-            mapPoses.push_back(mapPosM);
-            tesselateTriangle(i2, i0, iM, indices, mapPoses);
-            tesselateTriangle(i1, i2, iM, indices, mapPoses);
-            return;
-        } else if (SplitSegment(mapPos0, mapPos2, mapPosM)) {
-            unsigned int iM = static_cast<int>(mapPoses.size());
-            mapPoses.push_back(mapPosM);
-            tesselateTriangle(i0, i1, iM, indices, mapPoses);
-            tesselateTriangle(i1, i2, iM, indices, mapPoses);
-            return;
-        } else if (SplitSegment(mapPos1, mapPos2, mapPosM)) {
-            unsigned int iM = static_cast<int>(mapPoses.size());
-            mapPoses.push_back(mapPosM);
-            tesselateTriangle(i0, i1, iM, indices, mapPoses);
-            tesselateTriangle(i2, i0, iM, indices, mapPoses);
-            return;
+        // Split the triangles using an explicit stack, the output order matches depth-first recursion
+        std::vector<std::array<unsigned int, 3> > triangleStack;
+        triangleStack.push_back(std::array<unsigned int, 3> {{ i0, i1, i2 }});
+        while (!triangleStack.empty()) {
+            std::array<unsigned int, 3> triangle = triangleStack.back();
+            triangleStack.pop_back();
+
+            MapPos mapPos0 = mapPoses.at(triangle[0]);
+            MapPos mapPos1 = mapPoses.at(triangle[1]);
+            MapPos mapPos2 = mapPoses.at(triangle[2]);
+
+            MapPos mapPosM;
+            unsigned int iM = static_cast<unsigned int>(mapPoses.size());
+            if (SplitSegment(mapPos0, mapPos1, mapPosM)) {
+                mapPoses.push_back(mapPosM);
+                triangleStack.push_back(std::array<unsigned int, 3> {{ triangle[1], triangle[2], iM }});
+                triangleStack.push_back(std::array<unsigned int, 3> {{ triangle[2], triangle[0], iM }});
+            } else if (SplitSegment(mapPos0, mapPos2, mapPosM)) {
+                mapPoses.push_back(mapPosM);
+                triangleStack.push_back(std::array<unsigned int, 3> {{ triangle[1], triangle[2], iM }});
+                triangleStack.push_back(std::array<unsigned int, 3> {{ triangle[0], triangle[1], iM }});
+            } else if (SplitSegment(mapPos1, mapPos2, mapPosM)) {
+                mapPoses.push_back(mapPosM);
+                triangleStack.push_back(std::array<unsigned int, 3> {{ triangle[2], triangle[0], iM }});
+                triangleStack.push_back(std::array<unsigned int, 3> {{ triangle[0], triangle[1], iM }});
+            } else {
+                indices.push_back(triangle[0]);
+                indices.push_back(triangle[1]);
+                indices.push_back(triangle[2]);
+            }
         }
-
-        indices.push_back(i0);
-        indices.push_back(i1);
-        indices.push_back(i2);
     }
 
     double SphericalProjectionSurface::calculateDistance(const cglib::vec3<double> pos0, const cglib::vec3<double>& pos1) const {
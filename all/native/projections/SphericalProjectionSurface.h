@@ -23,6 +23,7 @@ namespace carto {
         virtual MapVec calculateMapVec(const cglib::vec3<double>& pos, const cglib::vec3<double>& vec) const;
 
         virtual cglib::vec3<double> calculatePosition(const MapPos& mapPos) const;
+        virtual void calculatePositions(const MapPos* mapPoses, cglib::vec3<double>* positions, std::size_t count) const;
         virtual cglib::vec3<double> calculateNormal(const MapPos& mapPos) const;
         virtual cglib::vec3<double> calculateVector(const MapPos& mapPos, const MapVec& mapVec) const;
 
@@ -42,41 +42,17 @@ namespace carto {
     bool BillboardRenderer::CalculateBillboardCoords(const BillboardDrawData& drawData, const ViewState& viewState,
                                                      std::vector<float>& coordBuf, std::size_t drawDataIndex, float sizeScale)
     {
-        cglib::vec3<float> translate = cglib::vec3<float>::convert(drawData.getPos() - viewState.getCameraPos());
-        if (cglib::dot_product(drawData.getZAxis(), translate) > 0) {
+        cglib::vec3<float> translate, xAxis, yAxis;
+        if (!CalculateBillboardTransform(drawData, viewState, sizeScale, translate, xAxis, yAxis)) {
             return false;
         }
-        
+
+        // Build coordinates
         const std::array<cglib::vec2<float>, 4>& coords = drawData.getCoords();
         for (int i = 0; i < 4; i++) {
             std::size_t coordIndex = (drawDataIndex * 4 + i) * 3;
             float x = coords[i](0);
             float y = coords[i](1);
-            
-            float scale = drawData.isScaleWithDPI() ? viewState.getUnitToDPCoef() : viewState.getUnitToPXCoef();
-            scale *= sizeScale;
-
-            // Calculate scaling
-            switch (drawData.getScalingMode()) {
-            case BillboardScaling::BILLBOARD_SCALING_WORLD_SIZE:
-                break;
-            case BillboardScaling::BILLBOARD_SCALING_SCREEN_SIZE:
-                x *= scale;
-                y *= scale;
-                break;
-            case BillboardScaling::BILLBOARD_SCALING_CONST_SCREEN_SIZE:
-            default:
-                float coef = static_cast<float>(scale * drawData.getCameraPlaneZoomDistance());
-                x *= coef;
-                y *= coef;
-                break;
-            }
-            
-            // Calculate axis
-            cglib::vec3<float> xAxis, yAxis;
-            CalculateBillboardAxis(drawData, viewState, xAxis, yAxis);
-        
-            // Build coordinates
             coordBuf[coordIndex + 0] = x * xAxis(0) + y * yAxis(0) + translate(0);
             coordBuf[coordIndex + 1] = x * xAxis(1) + y * yAxis(1) + translate(1);
             coordBuf[coordIndex + 2] = x * xAxis(2) + y * yAxis(2) + translate(2);
@@ -84,21 +60,57 @@ namespace carto {
         return true;
     }
     
+    bool BillboardRenderer::CalculateBillboardTransform(const BillboardDrawData& drawData, const ViewState& viewState, float sizeScale,
+                                                        cglib::vec3<float>& translate, cglib::vec3<float>& xAxis, cglib::vec3<float>& yAxis)
+    {
+        translate = cglib::vec3<float>::convert(drawData.getPos() - viewState.getCameraPos());
+        if (cglib::dot_product(drawData.getZAxis(), translate) > 0) {
+            return false;
+        }
+        
+        // Calculate scaling and axis, these are the same for all the corners
+        float scale = drawData.isScaleWithDPI() ? viewState.getUnitToDPCoef() : viewState.getUnitToPXCoef();
+        scale *= sizeScale;
+        switch (drawData.getScalingMode()) {
+        case BillboardScaling::BILLBOARD_SCALING_WORLD_SIZE:
+            scale = 1.0f;
+            break;
+        case BillboardScaling::BILLBOARD_SCALING_SCREEN_SIZE:
+            break;
+        case BillboardScaling::BILLBOARD_SCALING_CONST_SCREEN_SIZE:
+        default:
+            scale = static_cast<float>(scale * drawData.getCameraPlaneZoomDistance());
+            break;
+        }
+
+        CalculateBillboardAxis(drawData, viewState, xAxis, yAxis);
+        xAxis = xAxis * scale;
+        yAxis = yAxis * scale;
+        return true;
+    }
+    
     BillboardRenderer::BillboardRenderer() :
         _mapRenderer(),
         _layer(),
         _elements(),
         _tempElements(),
+        _drawDataBuffer(),
+        _textureRegionBuffer(),
         _colorBuf(),
         _coordBuf(),
         _indexBuf(),
         _texCoordBuf(),
+        _offsetBuf(),
+        _animationBuf(),
         _textureCache(),
         _shader(),
         _a_color(0),
         _a_coord(0),
+        _a_offset(0),
         _a_texCoord(0),
+        _a_animation(0),
         _u_mvpMat(0),
+        _u_opacity(0),
         _u_tex(0),
         _mutex()
     {
@@ -198,39 +210,56 @@ namespace carto {
     
         // Prepare for drawing
         glUseProgram(_shader->getProgId());
-        // Coords, texCoords, colors
+        // Coords, offsets, texCoords, colors, animation states
         glEnableVertexAttribArray(_a_coord);
+        glEnableVertexAttribArray(_a_offset);
         glEnableVertexAttribArray(_a_texCoord);
         glEnableVertexAttribArray(_a_color);
+        glEnableVertexAttribArray(_a_animation);
         //Matrix
         const cglib::mat4x4<float>& mvpMat = viewState.getRTEModelviewProjectionMat();
         glUniformMatrix4fv(_u_mvpMat, 1, GL_FALSE, mvpMat.data());
+        // Opacity
+        glUniform1f(_u_opacity, opacity);
         // Texture
         glUniform1i(_u_tex, 0);
         glActiveTexture(GL_TEXTURE0);
         
-        // Draw billboards, batch by bitmap
+        // Draw billboards, batch by texture. Bitmaps packed into the same atlas page can be drawn in a single batch.
         _drawDataBuffer.clear();
+        _textureRegionBuffer.clear();
         std::shared_ptr<Bitmap> prevBitmap;
+        bool prevGenMipmaps = false;
+        BitmapTextureCache::TextureRegion textureRegion;
         for (const std::shared_ptr<BillboardDrawData>& drawData : billboardDrawDatas) {
             if (std::shared_ptr<Bitmap> bitmap = drawData->getBitmap()) {
-                if (prevBitmap && prevBitmap != bitmap) {
-                    drawBatch(opacity, viewState);
+                if (bitmap != prevBitmap || drawData->isGenMipmaps() != prevGenMipmaps) {
+                    textureRegion = _textureCache->getTextureRegion(bitmap, drawData->isGenMipmaps());
+                    prevBitmap = bitmap;
+                    prevGenMipmaps = drawData->isGenMipmaps();
+                }
+
+                if (!_textureRegionBuffer.empty() && _textureRegionBuffer.front().texId != textureRegion.texId) {
+                    drawBatch(viewState);
                     _drawDataBuffer.clear();
+                    _textureRegionBuffer.clear();
                 }
         
-                _drawDataBuffer.push_back(std::move(drawData));
-                prevBitmap = bitmap;
+                _drawDataBuffer.push_back(drawData);
+                _textureRegionBuffer.push_back(textureRegion);
             }
         }
     
-        if (prevBitmap) {
-            drawBatch(opacity, viewState);
+        if (!_drawDataBuffer.empty()) {
+            drawBatch(viewState);
         }
+        _textureRegionBuffer.clear();
     
         glDisableVertexAttribArray(_a_coord);
+        glDisableVertexAttribArray(_a_offset);
         glDisableVertexAttribArray(_a_texCoord);
         glDisableVertexAttribArray(_a_color);
+        glDisableVertexAttribArray(_a_animation);
     
         GLContext::CheckGLError("BillboardRenderer::onDrawFrameSorted");
     }
@@ -331,22 +360,38 @@ namespace carto {
         
     void BillboardRenderer::BuildAndDrawBuffers(GLuint a_color,
                                                 GLuint a_coord,
+                                                GLuint a_offset,
                                                 GLuint a_texCoord,
+                                                GLuint a_animation,
                                                 std::vector<unsigned char>& colorBuf,
                                                 std::vector<float>& coordBuf,
+                                                std::vector<float>& offsetBuf,
                                                 std::vector<unsigned short>& indexBuf,
                                                 std::vector<float>& texCoordBuf,
+                                                std::vector<float>& animationBuf,
                                                 std::vector<std::shared_ptr<BillboardDrawData> >& drawDataBuffer,
-                                                const cglib::vec2<float>& texCoordScale,
-                                                float opacity,
+                                                const std::vector<BitmapTextureCache::TextureRegion>& textureRegionBuffer,
                                                 const ViewState& viewState)
     {
         // Resize the buffers, if necessary
         if (coordBuf.size() < drawDataBuffer.size() * 4 * 3) {
             coordBuf.resize(std::min(drawDataBuffer.size() * 4 * 3, GLContext::MAX_VERTEXBUFFER_SIZE * 3));
+            offsetBuf.resize(std::min(drawDataBuffer.size() * 4 * 3, GLContext::MAX_VERTEXBUFFER_SIZE * 3));
+            animationBuf.resize(std::min(drawDataBuffer.size() * 4 * 3, GLContext::MAX_VERTEXBUFFER_SIZE * 3));
             texCoordBuf.resize(std::min(drawDataBuffer.size() * 4 * 2, GLContext::MAX_VERTEXBUFFER_SIZE * 2));
             colorBuf.resize(std::min(drawDataBuffer.size() * 4 * 4, GLContext::MAX_VERTEXBUFFER_SIZE * 4));
             indexBuf.resize(std::min(drawDataBuffer.size() * 6, GLContext::MAX_VERTEXBUFFER_SIZE));
+
+            // Indices do not depend on the draw datas, so they are built only when the buffer grows
+            for (std::size_t i = 0; i + 6 <= indexBuf.size(); i += 6) {
+                unsigned short vertexIndex = static_cast<unsigned short>(i / 6 * 4);
+                indexBuf[i + 0] = vertexIndex + 0;
+                indexBuf[i + 1] = vertexIndex + 1;
+                indexBuf[i + 2] = vertexIndex + 2;
+                indexBuf[i + 3] = vertexIndex + 1;
+                indexBuf[i + 4] = vertexIndex + 3;
+                indexBuf[i + 5] = vertexIndex + 2;
+            }
         }
         
         // Calculate and draw buffers
@@ -354,15 +399,14 @@ namespace carto {
         for (std::size_t i = 0; i < drawDataBuffer.size(); i++) {
             const std::shared_ptr<BillboardDrawData>& drawData = drawDataBuffer[i];
 
-            // Alpha value
-            int alpha = std::min(256, static_cast<int>(256 * opacity * AnimationStyle::CalculateTransition(drawData->getAnimationStyle() ? drawData->getAnimationStyle()->getFadeAnimationType() : AnimationType::ANIMATION_TYPE_NONE, drawData->getTransition())));
-            
             // Check for possible overflow in the buffers
             if ((drawDataIndex + 1) * 6 > GLContext::MAX_VERTEXBUFFER_SIZE) {
                 // If it doesn't fit, stop and draw the buffers
                 glVertexAttribPointer(a_coord, 3, GL_FLOAT, GL_FALSE, 0, coordBuf.data());
+                glVertexAttribPointer(a_offset, 3, GL_FLOAT, GL_FALSE, 0, offsetBuf.data());
                 glVertexAttribPointer(a_texCoord, 2, GL_FLOAT, GL_FALSE, 0, texCoordBuf.data());
                 glVertexAttribPointer(a_color, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, colorBuf.data());
+                glVertexAttribPointer(a_animation, 3, GL_FLOAT, GL_FALSE, 0, animationBuf.data());
                 glDrawElements(GL_TRIANGLES, drawDataIndex * 6, GL_UNSIGNED_SHORT, indexBuf.data());
                 // Start filling buffers from the beginning
                 drawDataIndex = 0;
@@ -373,11 +417,35 @@ namespace carto {
                 continue;
             }
             
-            // Calculate coordinates
-            float relativeSize = AnimationStyle::CalculateTransition(drawData->getAnimationStyle() ? drawData->getAnimationStyle()->getSizeAnimationType() : AnimationType::ANIMATION_TYPE_NONE, drawData->getTransition());
-            if (!CalculateBillboardCoords(*drawData, viewState, coordBuf, drawDataIndex, relativeSize)) {
+            // Calculate coordinates. The anchor position and the corner offsets are stored separately, the offsets are scaled by the size animation in the shader.
+            cglib::vec3<float> translate, xAxis, yAxis;
+            if (!CalculateBillboardTransform(*drawData, viewState, 1.0f, translate, xAxis, yAxis)) {
                 continue;
             }
+            const std::array<cglib::vec2<float>, 4>& coords = drawData->getCoords();
+            for (int j = 0; j < 4; j++) {
+                std::size_t coordIndex = (drawDataIndex * 4 + j) * 3;
+                cglib::vec3<float> offset = xAxis * coords[j](0) + yAxis * coords[j](1);
+                for (int k = 0; k < 3; k++) {
+                    coordBuf[coordIndex + k] = translate(k);
+                    offsetBuf[coordIndex + k] = offset(k);
+                }
+            }
+
+            // Animation state, the transition curves are evaluated in the shader
+            float fadeAnimationType = static_cast<float>(AnimationType::ANIMATION_TYPE_NONE);
+            float sizeAnimationType = static_cast<float>(AnimationType::ANIMATION_TYPE_NONE);
+            if (auto animStyle = drawData->getAnimationStyle()) {
+                fadeAnimationType = static_cast<float>(animStyle->getFadeAnimationType());
+                sizeAnimationType = static_cast<float>(animStyle->getSizeAnimationType());
+            }
+            float transition = drawData->getTransition();
+            for (int j = 0; j < 4; j++) {
+                std::size_t animationIndex = (drawDataIndex * 4 + j) * 3;
+                animationBuf[animationIndex + 0] = transition;
+                animationBuf[animationIndex + 1] = fadeAnimationType;
+                animationBuf[animationIndex + 2] = sizeAnimationType;
+            }
             
             // Billboards with ground orientation (like some texts) have to be flipped to readable
             bool flip = false;
@@ -386,54 +454,49 @@ namespace carto {
                 flip = dAngle > 90 && dAngle < 270;
             }
             
-            // Calculate texture coordinates
+            // Calculate texture coordinates, the bitmap may be a subrectangle of an atlas texture
+            const BitmapTextureCache::TextureRegion& textureRegion = textureRegionBuffer[i];
+            float u0 = textureRegion.texCoordOffset(0), u1 = u0 + textureRegion.texCoordScale(0);
+            float v0 = textureRegion.texCoordOffset(1), v1 = v0 + textureRegion.texCoordScale(1);
             std::size_t texCoordIndex = drawDataIndex * 4 * 2;
             if (!flip) {
-                texCoordBuf[texCoordIndex + 0] = 0.0f;
-                texCoordBuf[texCoordIndex + 1] = texCoordScale(1);
-                texCoordBuf[texCoordIndex + 2] = 0.0f;
-                texCoordBuf[texCoordIndex + 3] = 0.0f;
-                texCoordBuf[texCoordIndex + 4] = texCoordScale(0);
-                texCoordBuf[texCoordIndex + 5] = texCoordScale(1);
-                texCoordBuf[texCoordIndex + 6] = texCoordScale(0);
-                texCoordBuf[texCoordIndex + 7] = 0.0f;
+                texCoordBuf[texCoordIndex + 0] = u0;
+                texCoordBuf[texCoordIndex + 1] = v1;
+                texCoordBuf[texCoordIndex + 2] = u0;
+                texCoordBuf[texCoordIndex + 3] = v0;
+                texCoordBuf[texCoordIndex + 4] = u1;
+                texCoordBuf[texCoordIndex + 5] = v1;
+                texCoordBuf[texCoordIndex + 6] = u1;
+                texCoordBuf[texCoordIndex + 7] = v0;
             } else {
-                texCoordBuf[texCoordIndex + 0] = texCoordScale(0);
-                texCoordBuf[texCoordIndex + 1] = 0.0f;
-                texCoordBuf[texCoordIndex + 2] = texCoordScale(0);
-                texCoordBuf[texCoordIndex + 3] = texCoordScale(1);
-                texCoordBuf[texCoordIndex + 4] = 0.0f;
-                texCoordBuf[texCoordIndex + 5] = 0.0f;
-                texCoordBuf[texCoordIndex + 6] = 0.0f;
-                texCoordBuf[texCoordIndex + 7] = texCoordScale(1);
+                texCoordBuf[texCoordIndex + 0] = u1;
+                texCoordBuf[texCoordIndex + 1] = v0;
+                texCoordBuf[texCoordIndex + 2] = u1;
+                texCoordBuf[texCoordIndex + 3] = v1;
+                texCoordBuf[texCoordIndex + 4] = u0;
+                texCoordBuf[texCoordIndex + 5] = v0;
+                texCoordBuf[texCoordIndex + 6] = u0;
+                texCoordBuf[texCoordIndex + 7] = v1;
             }
             
             // Calculate colors
             const Color& color = drawData->getColor();
             std::size_t colorIndex = drawDataIndex * 4 * 4;
             for (int i = 0; i < 16; i += 4) {
-                colorBuf[colorIndex + i + 0] = static_cast<unsigned char>((color.getR() * alpha) >> 8);
-                colorBuf[colorIndex + i + 1] = static_cast<unsigned char>((color.getG() * alpha) >> 8);
-                colorBuf[colorIndex + i + 2] = static_cast<unsigned char>((color.getB() * alpha) >> 8);
-                colorBuf[colorIndex + i + 3] = static_cast<unsigned char>((color.getA() * alpha) >> 8);
+                colorBuf[colorIndex + i + 0] = color.getR();
+                colorBuf[colorIndex + i + 1] = color.getG();
+                colorBuf[colorIndex + i + 2] = color.getB();
+                colorBuf[colorIndex + i + 3] = color.getA();
             }
             
-            // Calculate indices
-            std::size_t indexIndex = drawDataIndex * 6;
-            unsigned short vertexIndex = static_cast<unsigned short>(drawDataIndex * 4);
-            indexBuf[indexIndex + 0] = vertexIndex + 0;
-            indexBuf[indexIndex + 1] = vertexIndex + 1;
-            indexBuf[indexIndex + 2] = vertexIndex + 2;
-            indexBuf[indexIndex + 3] = vertexIndex + 1;
-            indexBuf[indexIndex + 4] = vertexIndex + 3;
-            indexBuf[indexIndex + 5] = vertexIndex + 2;
-            
             drawDataIndex++;
         }
         
         glVertexAttribPointer(a_coord, 3, GL_FLOAT, GL_FALSE, 0, coordBuf.data());
+        glVertexAttribPointer(a_offset, 3, GL_FLOAT, GL_FALSE, 0, offsetBuf.data());
         glVertexAttribPointer(a_texCoord, 2, GL_FLOAT, GL_FALSE, 0, texCoordBuf.data());
         glVertexAttribPointer(a_color, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, colorBuf.data());
+        glVertexAttribPointer(a_animation, 3, GL_FLOAT, GL_FALSE, 0, animationBuf.data());
         glDrawElements(GL_TRIANGLES, drawDataIndex * 6, GL_UNSIGNED_SHORT, indexBuf.data());
     }
         
@@ -504,47 +567,60 @@ namespace carto {
         }
 
         if (auto mapRenderer = _mapRenderer.lock()) {
-            _textureCache = mapRenderer->getGLResourceManager()->create<BitmapTextureCache>(TEXTURE_CACHE_SIZE);
+            _textureCache = mapRenderer->getGLResourceManager()->create<BitmapTextureCache>(TEXTURE_CACHE_SIZE, true);
 
             _shader = mapRenderer->getGLResourceManager()->create<Shader>("billboard", BILLBOARD_VERTEX_SHADER, BILLBOARD_FRAGMENT_SHADER);
 
             // Get shader variables locations
             _a_color = _shader->getAttribLoc("a_color");
             _a_coord = _shader->getAttribLoc("a_coord");
+            _a_offset = _shader->getAttribLoc("a_offset");
             _a_texCoord = _shader->getAttribLoc("a_texCoord");
+            _a_animation = _shader->getAttribLoc("a_animation");
             _u_mvpMat = _shader->getUniformLoc("u_mvpMat");
+            _u_opacity = _shader->getUniformLoc("u_opacity");
             _u_tex = _shader->getUniformLoc("u_tex");
         }
 
         return _shader && _shader->isValid() && _textureCache && _textureCache->isValid();
     }
     
-    void BillboardRenderer::drawBatch(float opacity, const ViewState& viewState) {
-        // Bind texture
-        const std::shared_ptr<Bitmap>& bitmap = _drawDataBuffer.front()->getBitmap();
-        std::shared_ptr<Texture> texture = _textureCache->get(bitmap);
-        if (!texture) {
-            texture = _textureCache->create(bitmap, _drawDataBuffer.front()->isGenMipmaps(), false);
-        }
-        glBindTexture(GL_TEXTURE_2D, texture->getTexId());
+    void BillboardRenderer::drawBatch(const ViewState& viewState) {
+        // Bind texture, all draw datas in the batch share it
+        glBindTexture(GL_TEXTURE_2D, _textureRegionBuffer.front().texId);
         
         // Draw the draw datas, multiple passes may be necessary
-        BuildAndDrawBuffers(_a_color, _a_coord, _a_texCoord, _colorBuf, _coordBuf, _indexBuf, _texCoordBuf, _drawDataBuffer,
-                            texture->getTexCoordScale(), opacity, viewState);
+        BuildAndDrawBuffers(_a_color, _a_coord, _a_offset, _a_texCoord, _a_animation, _colorBuf, _coordBuf, _offsetBuf, _indexBuf, _texCoordBuf, _animationBuf,
+                            _drawDataBuffer, _textureRegionBuffer, viewState);
     }
     
     const std::string BillboardRenderer::BILLBOARD_VERTEX_SHADER = R"GLSL(
         #version 100
-        attribute vec4 a_coord;
+        attribute vec3 a_coord;
+        attribute vec3 a_offset;
         attribute vec2 a_texCoord;
         attribute vec4 a_color;
+        attribute vec3 a_animation;
         varying vec2 v_texCoord;
         varying vec4 v_color;
         uniform mat4 u_mvpMat;
+        uniform float u_opacity;
+        float transition(float type, float t) {
+            if (type < 0.5) {
+                return 1.0;
+            } else if (type < 1.5) {
+                return step(0.5, t);
+            } else if (type < 2.5) {
+                return t;
+            } else if (type < 3.5) {
+                return t * t * (3.0 - 2.0 * t);
+            }
+            return 1.0 - 0.5 * exp(-6.0 * t) * (sin(12.0 * t) + 2.0 * cos(12.0 * t));
+        }
         void main() {
             v_texCoord = a_texCoord;
-            v_color = a_color;
-            gl_Position = u_mvpMat * a_coord;
+            v_color = a_color * min(1.0, u_opacity * transition(a_animation.y, a_animation.x));
+            gl_Position = u_mvpMat * vec4(a_coord + a_offset * transition(a_animation.z, a_animation.x), 1.0);
         }
     )GLSL";
 
@@ -56,22 +56,28 @@ namespace carto {
         void calculateRayIntersectedElements(const std::shared_ptr<VectorLayer>& layer, const cglib::ray3<double>& ray, const ViewState& viewState, std::vector<RayIntersectedElement>& results) const;
     
     private:
+        static bool CalculateBillboardTransform(const BillboardDrawData& drawData, const ViewState& viewState, float sizeScale,
+                                                cglib::vec3<float>& translate, cglib::vec3<float>& xAxis, cglib::vec3<float>& yAxis);
+
         static void BuildAndDrawBuffers(GLuint a_color,
                                         GLuint a_coord,
+                                        GLuint a_offset,
                                         GLuint a_texCoord,
+                                        GLuint a_animation,
                                         std::vector<unsigned char>& colorBuf,
                                         std::vector<float>& coordBuf,
+                                        std::vector<float>& offsetBuf,
                                         std::vector<unsigned short>& indexBuf,
                                         std::vector<float>& texCoordBuf,
+                                        std::vector<float>& animationBuf,
                                         std::vector<std::shared_ptr<BillboardDrawData> >& drawDataBuffer,
-                                        const cglib::vec2<float>& texCoordScale,
-                                        float opacity,
+                                        const std::vector<BitmapTextureCache::TextureRegion>& textureRegionBuffer,
                                         const ViewState& viewState);
         
         bool calculateBaseBillboardDrawData(const std::shared_ptr<BillboardDrawData>& drawData, const ViewState& viewState);
         
         bool initializeRenderer();
-        void drawBatch(float opacity, const ViewState& viewState);
+        void drawBatch(const ViewState& viewState);
         
         static const std::string BILLBOARD_VERTEX_SHADER;
         static const std::string BILLBOARD_FRAGMENT_SHADER;
@@ -85,18 +91,24 @@ namespace carto {
         std::vector<std::shared_ptr<Billboard> > _tempElements;
         
         std::vector<std::shared_ptr<BillboardDrawData> > _drawDataBuffer;
+        std::vector<BitmapTextureCache::TextureRegion> _textureRegionBuffer;
         
         std::vector<unsigned char> _colorBuf;
         std::vector<float> _coordBuf;
         std::vector<unsigned short> _indexBuf;
         std::vector<float> _texCoordBuf;
+        std::vector<float> _offsetBuf;
+        std::vector<float> _animationBuf;
     
         std::shared_ptr<BitmapTextureCache> _textureCache;
         std::shared_ptr<Shader> _shader;
         GLuint _a_color;
         GLuint _a_coord;
+        GLuint _a_offset;
         GLuint _a_texCoord;
+        GLuint _a_animation;
         GLuint _u_mvpMat;
+        GLuint _u_opacity;
         GLuint _u_tex;
     
         mutable std::recursive_mutex _mutex;
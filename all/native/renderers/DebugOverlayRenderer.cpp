@@ -0,0 +1,233 @@
+#include "DebugOverlayRenderer.h"
+#include "graphics/Bitmap.h"
+#include "graphics/ViewState.h"
+#include "renderers/MapRenderer.h"
+#include "renderers/utils/GLResourceManager.h"
+#include "renderers/utils/Shader.h"
+#include "renderers/utils/Texture.h"
+#include "utils/Const.h"
+#include "utils/Log.h"
+
+#include <algorithm>
+
+#include <cglib/mat.h>
+
+namespace carto {
+
+    DebugOverlayRenderer::DebugOverlayRenderer() :
+        _mapRenderer(),
+        _tileBoundaries(),
+        _horizontalLayerOffset(0),
+        _lineCoords(),
+        _lineColors(),
+        _statisticsBitmap(),
+        _statisticsTex(),
+        _lineShader(),
+        _a_lineCoord(0),
+        _a_lineColor(0),
+        _u_lineMVPMat(0),
+        _bitmapShader(),
+        _a_bitmapCoord(0),
+        _a_bitmapTexCoord(0),
+        _u_bitmapTex(0),
+        _mutex()
+    {
+    }
+    
+    DebugOverlayRenderer::~DebugOverlayRenderer() {
+    }
+    
+    void DebugOverlayRenderer::setComponents(const std::weak_ptr<Options>& options, const std::weak_ptr<MapRenderer>& mapRenderer) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _mapRenderer = mapRenderer;
+        _lineShader.reset();
+        _bitmapShader.reset();
+        _statisticsTex.reset();
+    }
+
+    void DebugOverlayRenderer::offsetLayerHorizontally(double offset) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _horizontalLayerOffset += offset;
+    }
+
+    void DebugOverlayRenderer::setTileBoundaries(const std::vector<TileBoundary>& tileBoundaries) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _tileBoundaries = tileBoundaries;
+        _horizontalLayerOffset = 0;
+    }
+
+    void DebugOverlayRenderer::setStatisticsBitmap(const std::shared_ptr<Bitmap>& bitmap) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (_statisticsBitmap != bitmap) {
+            _statisticsTex.reset();
+        }
+        _statisticsBitmap = bitmap;
+    }
+    
+    void DebugOverlayRenderer::onDrawFrame(const ViewState& viewState) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (!initializeRenderer()) {
+            return;
+        }
+
+        // The overlay is drawn on top of everything drawn so far
+        glDisable(GL_DEPTH_TEST);
+
+        if (!_tileBoundaries.empty()) {
+            drawTileBoundaries(viewState);
+        }
+
+        if (_statisticsTex) {
+            drawStatistics(viewState);
+        }
+
+        glEnable(GL_DEPTH_TEST);
+    
+        GLContext::CheckGLError("DebugOverlayRenderer::onDrawFrame");
+    }
+    
+    bool DebugOverlayRenderer::initializeRenderer() {
+        if (_lineShader && _lineShader->isValid() && _bitmapShader && _bitmapShader->isValid() && (!_statisticsBitmap || (_statisticsTex && _statisticsTex->isValid()))) {
+            return true;
+        }
+
+        if (auto mapRenderer = _mapRenderer.lock()) {
+            // Shaders and textures must be reloaded
+            _lineShader = mapRenderer->getGLResourceManager()->create<Shader>("debugoverlayline", LINE_VERTEX_SHADER, LINE_FRAGMENT_SHADER);
+        
+            // Get shader variables locations
+            _a_lineCoord = _lineShader->getAttribLoc("a_coord");
+            _a_lineColor = _lineShader->getAttribLoc("a_color");
+            _u_lineMVPMat = _lineShader->getUniformLoc("u_mvpMat");
+
+            _bitmapShader = mapRenderer->getGLResourceManager()->create<Shader>("debugoverlaybitmap", BITMAP_VERTEX_SHADER, BITMAP_FRAGMENT_SHADER);
+
+            _a_bitmapCoord = _bitmapShader->getAttribLoc("a_coord");
+            _a_bitmapTexCoord = _bitmapShader->getAttribLoc("a_texCoord");
+            _u_bitmapTex = _bitmapShader->getUniformLoc("u_tex");
+
+            if (_statisticsBitmap) {
+                _statisticsTex = mapRenderer->getGLResourceManager()->create<Texture>(_statisticsBitmap, false, false);
+            }
+        }
+
+        return _lineShader && _lineShader->isValid() && _bitmapShader && _bitmapShader->isValid() && (!_statisticsBitmap || (_statisticsTex && _statisticsTex->isValid()));
+    }
+
+    void DebugOverlayRenderer::drawTileBoundaries(const ViewState& viewState) {
+        // Build line segments relative to the camera, boundary counts are small so this is done each frame
+        cglib::vec3<double> origin = viewState.getCameraPos() - cglib::vec3<double>(_horizontalLayerOffset, 0, 0);
+        _lineCoords.clear();
+        _lineColors.clear();
+        for (const TileBoundary& tileBoundary : _tileBoundaries) {
+            const Color& color = tileBoundary.color;
+            float alpha = color.getA() / 255.0f;
+            for (std::size_t i = 0; i < tileBoundary.positions.size(); i++) {
+                const cglib::vec3<double>* positions[2] = { &tileBoundary.positions[i], &tileBoundary.positions[(i + 1) % tileBoundary.positions.size()] };
+                for (const cglib::vec3<double>* pos : positions) {
+                    cglib::vec3<float> coord = cglib::vec3<float>::convert(*pos - origin);
+                    _lineCoords.push_back(coord(0));
+                    _lineCoords.push_back(coord(1));
+                    _lineCoords.push_back(coord(2));
+                    _lineColors.push_back(color.getR() * alpha / 255.0f);
+                    _lineColors.push_back(color.getG() * alpha / 255.0f);
+                    _lineColors.push_back(color.getB() * alpha / 255.0f);
+                    _lineColors.push_back(alpha);
+                }
+            }
+        }
+
+        glUseProgram(_lineShader->getProgId());
+        glUniformMatrix4fv(_u_lineMVPMat, 1, GL_FALSE, viewState.getRTEModelviewProjectionMat().data());
+        glLineWidth(std::max(1.0f, TILE_BOUNDARY_WIDTH_DP * viewState.getDPI() / Const::UNSCALED_DPI));
+
+        glEnableVertexAttribArray(_a_lineCoord);
+        glEnableVertexAttribArray(_a_lineColor);
+        glVertexAttribPointer(_a_lineCoord, 3, GL_FLOAT, GL_FALSE, 0, _lineCoords.data());
+        glVertexAttribPointer(_a_lineColor, 4, GL_FLOAT, GL_FALSE, 0, _lineColors.data());
+        glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(_lineCoords.size() / 3));
+
+        glDisableVertexAttribArray(_a_lineCoord);
+        glDisableVertexAttribArray(_a_lineColor);
+
+        glLineWidth(1.0f);
+    }
+
+    void DebugOverlayRenderer::drawStatistics(const ViewState& viewState) {
+        // Place the bitmap to the top-left corner, one bitmap pixel per screen pixel
+        float padding = STATISTICS_PADDING_DP * viewState.getDPI() / Const::UNSCALED_DPI;
+        float x0 = -1.0f + 2.0f * padding / viewState.getWidth();
+        float y0 =  1.0f - 2.0f * padding / viewState.getHeight();
+        float x1 = x0 + 2.0f * _statisticsBitmap->getWidth() / viewState.getWidth();
+        float y1 = y0 - 2.0f * _statisticsBitmap->getHeight() / viewState.getHeight();
+        float coords[8] = { x0, y0, x0, y1, x1, y0, x1, y1 };
+
+        const cglib::vec2<float>& texCoordScale = _statisticsTex->getTexCoordScale();
+        float texCoords[8] = { 0.0f, texCoordScale(1), 0.0f, 0.0f, texCoordScale(0), texCoordScale(1), texCoordScale(0), 0.0f };
+
+        glUseProgram(_bitmapShader->getProgId());
+        glUniform1i(_u_bitmapTex, 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, _statisticsTex->getTexId());
+
+        glEnableVertexAttribArray(_a_bitmapCoord);
+        glEnableVertexAttribArray(_a_bitmapTexCoord);
+        glVertexAttribPointer(_a_bitmapCoord, 2, GL_FLOAT, GL_FALSE, 0, coords);
+        glVertexAttribPointer(_a_bitmapTexCoord, 2, GL_FLOAT, GL_FALSE, 0, texCoords);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+        glDisableVertexAttribArray(_a_bitmapCoord);
+        glDisableVertexAttribArray(_a_bitmapTexCoord);
+    }
+    
+    const float DebugOverlayRenderer::STATISTICS_PADDING_DP = 8.0f;
+    const float DebugOverlayRenderer::TILE_BOUNDARY_WIDTH_DP = 1.5f;
+
+    const std::string DebugOverlayRenderer::LINE_VERTEX_SHADER = R"GLSL(
+        #version 100
+        attribute vec4 a_coord;
+        attribute vec4 a_color;
+        varying vec4 v_color;
+        uniform mat4 u_mvpMat;
+        void main() {
+            v_color = a_color;
+            gl_Position = u_mvpMat * a_coord;
+        }
+    )GLSL";
+
+    const std::string DebugOverlayRenderer::LINE_FRAGMENT_SHADER = R"GLSL(
+        #version 100
+        precision mediump float;
+        varying lowp vec4 v_color;
+        void main() {
+            gl_FragColor = v_color;
+        }
+    )GLSL";
+
+    const std::string DebugOverlayRenderer::BITMAP_VERTEX_SHADER = R"GLSL(
+        #version 100
+        attribute vec2 a_coord;
+        attribute vec2 a_texCoord;
+        varying vec2 v_texCoord;
+        void main() {
+            v_texCoord = a_texCoord;
+            gl_Position = vec4(a_coord, 0.0, 1.0);
+        }
+    )GLSL";
+
+    const std::string DebugOverlayRenderer::BITMAP_FRAGMENT_SHADER = R"GLSL(
+        #version 100
+        precision mediump float;
+        varying mediump vec2 v_texCoord;
+        uniform sampler2D u_tex;
+        void main() {
+            gl_FragColor = texture2D(u_tex, v_texCoord);
+        }
+    )GLSL";
+
+}
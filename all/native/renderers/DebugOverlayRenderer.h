@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_DEBUGOVERLAYRENDERER_H_
+#define _CARTO_DEBUGOVERLAYRENDERER_H_
+
+#include "graphics/Color.h"
+#include "renderers/utils/GLContext.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <cglib/vec.h>
+
+namespace carto {
+    class Bitmap;
+    class Options;
+    class MapRenderer;
+    class Shader;
+    class Texture;
+    class ViewState;
+
+    class DebugOverlayRenderer {
+    public:
+        struct TileBoundary {
+            std::vector<cglib::vec3<double> > positions; // closed ring, the first position is not repeated
+            Color color;
+
+            TileBoundary() : positions(), color() { }
+        };
+
+        DebugOverlayRenderer();
+        virtual ~DebugOverlayRenderer();
+    
+        void setComponents(const std::weak_ptr<Options>& options, const std::weak_ptr<MapRenderer>& mapRenderer);
+
+        void offsetLayerHorizontally(double offset);
+
+        void onDrawFrame(const ViewState& viewState);
+
+        void setTileBoundaries(const std::vector<TileBoundary>& tileBoundaries);
+        void setStatisticsBitmap(const std::shared_ptr<Bitmap>& bitmap);
+
+    private:
+        bool initializeRenderer();
+
+        void drawTileBoundaries(const ViewState& viewState);
+        void drawStatistics(const ViewState& viewState);
+
+        static const float STATISTICS_PADDING_DP;
+        static const float TILE_BOUNDARY_WIDTH_DP;
+
+        static const std::string LINE_VERTEX_SHADER;
+        static const std::string LINE_FRAGMENT_SHADER;
+        static const std::string BITMAP_VERTEX_SHADER;
+        static const std::string BITMAP_FRAGMENT_SHADER;
+
+        std::weak_ptr<MapRenderer> _mapRenderer;
+
+        std::vector<TileBoundary> _tileBoundaries;
+        double _horizontalLayerOffset;
+        std::vector<float> _lineCoords;
+        std::vector<float> _lineColors;
+
+        std::shared_ptr<Bitmap> _statisticsBitmap;
+        std::shared_ptr<Texture> _statisticsTex;
+
+        std::shared_ptr<Shader> _lineShader;
+        GLuint _a_lineCoord;
+        GLuint _a_lineColor;
+        GLuint _u_lineMVPMat;
+
+        std::shared_ptr<Shader> _bitmapShader;
+        GLuint _a_bitmapCoord;
+        GLuint _a_bitmapTexCoord;
+        GLuint _u_bitmapTex;
+
+        mutable std::mutex _mutex;
+    };
+    
+}
+
+#endif
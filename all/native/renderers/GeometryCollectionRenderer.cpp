@@ -20,6 +20,9 @@ namespace carto {
         _pointRenderer(),
         _lineRenderer(),
         _polygonRenderer(),
+        _pointDrawDatas(),
+        _lineDrawDatas(),
+        _polygonDrawDatas(),
         _mutex()
     {
     }
@@ -38,6 +41,10 @@ namespace carto {
     void GeometryCollectionRenderer::offsetLayerHorizontally(double offset) {
         std::lock_guard<std::mutex> lock(_mutex);
 
+        for (const std::shared_ptr<GeometryCollection>& element : _elements) {
+            element->getDrawData()->offsetHorizontally(offset);
+        }
+
         _pointRenderer.offsetLayerHorizontally(offset);
         _lineRenderer.offsetLayerHorizontally(offset);
         _polygonRenderer.offsetLayerHorizontally(offset);
@@ -48,6 +55,7 @@ namespace carto {
 
         if (_elements.empty()) {
             // Early return, to avoid calling glUseProgram etc.
+            clearBatchCaches();
             return;
         }
 
@@ -57,60 +65,58 @@ namespace carto {
 
         glDisable(GL_CULL_FACE);
 
-        for (const std::shared_ptr<GeometryCollection>& element : _elements) {
-            for (const std::shared_ptr<VectorElementDrawData>& drawData : element->getDrawData()->getDrawDatas()) {
-                if (std::shared_ptr<PointDrawData> pointDrawData = std::dynamic_pointer_cast<PointDrawData>(drawData)) {
-                    if (!_lineRenderer.isEmptyBatch()) {
-                        _lineRenderer.drawBatch(viewState);
-                        _lineRenderer.unbind();
-                    } else if (!_polygonRenderer.isEmptyBatch()) {
-                        _polygonRenderer.drawBatch(viewState);
-                        _polygonRenderer.unbind();
-                    }
-                    if (_pointRenderer.isEmptyBatch()) {
-                        _pointRenderer.bind(viewState);
-                    }
-                    _pointRenderer.addToBatch(pointDrawData, viewState);
-                } else if (std::shared_ptr<LineDrawData> lineDrawData = std::dynamic_pointer_cast<LineDrawData>(drawData)) {
-                    if (!_pointRenderer.isEmptyBatch()) {
-                        _pointRenderer.drawBatch(viewState);
-                        _pointRenderer.unbind();
-                    } else if (!_polygonRenderer.isEmptyBatch()) {
-                        _polygonRenderer.drawBatch(viewState);
-                        _polygonRenderer.unbind();
-                    }
-                    if (_lineRenderer.isEmptyBatch()) {
-                        _lineRenderer.bind(viewState);
-                    }
-                    _lineRenderer.addToBatch(lineDrawData, viewState);
-                } else if (std::shared_ptr<PolygonDrawData> polygonDrawData = std::dynamic_pointer_cast<PolygonDrawData>(drawData)) {
-                    if (!_pointRenderer.isEmptyBatch()) {
-                        _pointRenderer.drawBatch(viewState);
-                        _pointRenderer.unbind();
-                    } else if (!_lineRenderer.isEmptyBatch()) {
-                        _lineRenderer.drawBatch(viewState);
-                        _lineRenderer.unbind();
-                    }
-                    if (_polygonRenderer.isEmptyBatch()) {
-                        _polygonRenderer.bind(viewState);
+        // Consecutive collections sharing a style are drawn as one group, polygons first, then lines and points.
+        // Each geometry type then needs a single batch per group, regardless of how the geometries are mixed in the collections.
+        auto groupBegin = _elements.begin();
+        while (groupBegin != _elements.end()) {
+            std::shared_ptr<GeometryCollectionStyle> style = (*groupBegin)->getStyle();
+            auto groupEnd = std::find_if(groupBegin + 1, _elements.end(), [&style](const std::shared_ptr<GeometryCollection>& element) {
+                return element->getStyle() != style;
+            });
+
+            for (auto it = groupBegin; it != groupEnd; it++) {
+                for (const std::shared_ptr<VectorElementDrawData>& drawData : (*it)->getDrawData()->getDrawDatas()) {
+                    if (std::shared_ptr<PointDrawData> pointDrawData = std::dynamic_pointer_cast<PointDrawData>(drawData)) {
+                        _pointDrawDatas.push_back(std::move(pointDrawData));
+                    } else if (std::shared_ptr<LineDrawData> lineDrawData = std::dynamic_pointer_cast<LineDrawData>(drawData)) {
+                        _lineDrawDatas.push_back(std::move(lineDrawData));
+                    } else if (std::shared_ptr<PolygonDrawData> polygonDrawData = std::dynamic_pointer_cast<PolygonDrawData>(drawData)) {
+                        _polygonDrawDatas.push_back(std::move(polygonDrawData));
                     }
+                }
+            }
+
+            if (!_polygonDrawDatas.empty()) {
+                _polygonRenderer.bind(viewState);
+                for (const std::shared_ptr<PolygonDrawData>& polygonDrawData : _polygonDrawDatas) {
                     _polygonRenderer.addToBatch(polygonDrawData, viewState);
                 }
+                _polygonRenderer.drawBatch(viewState);
+                _polygonRenderer.unbind();
+                _polygonDrawDatas.clear();
+            }
+            if (!_lineDrawDatas.empty()) {
+                _lineRenderer.bind(viewState);
+                for (const std::shared_ptr<LineDrawData>& lineDrawData : _lineDrawDatas) {
+                    _lineRenderer.addToBatch(lineDrawData, viewState);
+                }
+                _lineRenderer.drawBatch(viewState);
+                _lineRenderer.unbind();
+                _lineDrawDatas.clear();
+            }
+            if (!_pointDrawDatas.empty()) {
+                _pointRenderer.bind(viewState);
+                for (const std::shared_ptr<PointDrawData>& pointDrawData : _pointDrawDatas) {
+                    _pointRenderer.addToBatch(pointDrawData, viewState);
+                }
+                _pointRenderer.drawBatch(viewState);
+                _pointRenderer.unbind();
+                _pointDrawDatas.clear();
             }
-        }
 
-        if (!_pointRenderer._drawDataBuffer.empty()) {
-            _pointRenderer.drawBatch(viewState);
-            _pointRenderer.unbind();
-        }
-        if (!_lineRenderer._drawDataBuffer.empty()) {
-            _lineRenderer.drawBatch(viewState);
-            _lineRenderer.unbind();
-        }
-        if (!_polygonRenderer._drawDataBuffer.empty()) {
-            _polygonRenderer.drawBatch(viewState);
-            _polygonRenderer.unbind();
+            groupBegin = groupEnd;
         }
+        pruneBatchCaches();
         
         glEnable(GL_CULL_FACE);
     }
@@ -139,6 +145,15 @@ namespace carto {
     void GeometryCollectionRenderer::removeElement(const std::shared_ptr<GeometryCollection>& element) {
         std::lock_guard<std::mutex> lock(_mutex);
         _elements.erase(std::remove(_elements.begin(), _elements.end(), element), _elements.end());
+        if (element->getDrawData()) {
+            for (const std::shared_ptr<VectorElementDrawData>& drawData : element->getDrawData()->getDrawDatas()) {
+                if (auto lineDrawData = std::dynamic_pointer_cast<LineDrawData>(drawData)) {
+                    _lineRenderer.removeCachedBatches(lineDrawData.get());
+                } else if (auto polygonDrawData = std::dynamic_pointer_cast<PolygonDrawData>(drawData)) {
+                    _polygonRenderer.removeCachedBatches(polygonDrawData.get());
+                }
+            }
+        }
     }
 
     void GeometryCollectionRenderer::calculateRayIntersectedElements(const std::shared_ptr<VectorLayer>& layer, const cglib::ray3<double>& ray, const ViewState& viewState, std::vector<RayIntersectedElement>& results) const {
@@ -161,4 +176,14 @@ namespace carto {
         return _pointRenderer.initializeRenderer() && _lineRenderer.initializeRenderer() && _polygonRenderer.initializeRenderer();
     }
 
+    void GeometryCollectionRenderer::pruneBatchCaches() {
+        _lineRenderer.pruneBatchCache();
+        _polygonRenderer.pruneBatchCache();
+    }
+
+    void GeometryCollectionRenderer::clearBatchCaches() {
+        _lineRenderer.clearBatchCache();
+        _polygonRenderer.clearBatchCache();
+    }
+
 }
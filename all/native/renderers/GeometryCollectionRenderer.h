@@ -19,6 +19,9 @@ namespace carto {
     class Bitmap;
     class GeometryCollection;
     class GeometryCollectionDrawData;
+    class LineDrawData;
+    class PointDrawData;
+    class PolygonDrawData;
     class Projection;
     class RayIntersectedElement;
     class VectorLayer;
@@ -44,6 +47,8 @@ namespace carto {
 
     private:
         bool initializeRenderer();
+        void pruneBatchCaches();
+        void clearBatchCaches();
 
         std::vector<std::shared_ptr<GeometryCollection> > _elements;
         std::vector<std::shared_ptr<GeometryCollection> > _tempElements;
@@ -52,6 +57,11 @@ namespace carto {
         LineRenderer _lineRenderer;
         PolygonRenderer _polygonRenderer;
 
+        // Draw datas of the current style group, by geometry type
+        std::vector<std::shared_ptr<PointDrawData> > _pointDrawDatas;
+        std::vector<std::shared_ptr<LineDrawData> > _lineDrawDatas;
+        std::vector<std::shared_ptr<PolygonDrawData> > _polygonDrawDatas;
+
         mutable std::mutex _mutex;
     };
 
@@ -1,4 +1,5 @@
 #include "LineRenderer.h"
+#include "geometry/utils/PackedRTreeSpatialIndex.h"
 #include "graphics/Bitmap.h"
 #include "graphics/ViewState.h"
 #include "layers/VectorLayer.h"
@@ -12,6 +13,8 @@
 #include "utils/Log.h"
 #include "vectorelements/Line.h"
 
+#include <algorithm>
+
 #include <cglib/mat.h>
 #include <cglib/vec.h>
 
@@ -21,23 +24,25 @@ namespace carto {
         _mapRenderer(),
         _elements(),
         _tempElements(),
+        _spatialIndex(),
+        _maxClickExtent(0),
         _drawDataBuffer(),
         _lineDrawDataBuffer(),
         _prevBitmap(nullptr),
-        _colorBuf(),
-        _coordBuf(),
-        _normalBuf(),
-        _texCoordBuf(),
-        _indexBuf(),
+        _prevVisibleRange(0, 1),
+        _batchCache(),
         _textureCache(),
         _shader(),
         _a_color(0),
         _a_coord(0),
         _a_normal(0),
         _a_texCoord(0),
+        _a_linePos(0),
         _u_gamma(0),
         _u_dpToPX(0),
         _u_unitToDP(0),
+        _u_texCoordYScale(0),
+        _u_visibleRange(0),
         _u_mvpMat(0),
         _u_tex(0),
         _mutex()
@@ -53,6 +58,7 @@ namespace carto {
         _mapRenderer = mapRenderer;
         _textureCache.reset();
         _shader.reset();
+        clearBatchCache();
     }
 
     void LineRenderer::offsetLayerHorizontally(double offset) {
@@ -62,6 +68,8 @@ namespace carto {
         for (const std::shared_ptr<Line>& element : _elements) {
             element->getDrawData()->offsetHorizontally(offset);
         }
+        offsetBatchCache(offset);
+        _spatialIndex.reset();
     }
     
     void LineRenderer::onDrawFrame(float deltaSeconds, const ViewState& viewState) {
@@ -69,6 +77,7 @@ namespace carto {
         
         if (_elements.empty()) {
             // Early return, to avoid calling glUseProgram etc.
+            clearBatchCache();
             return;
         }
 
@@ -80,11 +89,12 @@ namespace carto {
         
         bind(viewState);
     
-        // Draw, batch by bitmap
+        // Draw, batch by bitmap and visible range
         for (const std::shared_ptr<Line>& element : _elements) {
-            addToBatch(element->getDrawData(), viewState);
+            addToBatch(element->getDrawData(), element->getVisibleRange(), viewState);
         }
         drawBatch(viewState);
+        pruneBatchCache();
         
         unbind();
 
@@ -103,6 +113,7 @@ namespace carto {
         std::lock_guard<std::mutex> lock(_mutex);
         _elements.clear();
         _elements.swap(_tempElements);
+        _spatialIndex.reset();
     }
         
     void LineRenderer::updateElement(const std::shared_ptr<Line>& element) {
@@ -111,98 +122,61 @@ namespace carto {
             if (element->getDrawData()) {
                 _elements.push_back(element);
             }
+        } else if (isCachedDrawData(element->getDrawData().get())) {
+            // The draw data was kept, only draw time parameters (like the visible range) have changed
+            return;
         }
+        // Batches with the previous draw data no longer match the drawn draw datas and are rebuilt or pruned
+        _spatialIndex.reset();
     }
         
     void LineRenderer::removeElement(const std::shared_ptr<Line>& element) {
         std::lock_guard<std::mutex> lock(_mutex);
         _elements.erase(std::remove(_elements.begin(), _elements.end(), element), _elements.end());
+        if (element->getDrawData()) {
+            removeCachedBatches(element->getDrawData().get());
+        }
+        _spatialIndex.reset();
     }
     
     void LineRenderer::calculateRayIntersectedElements(const std::shared_ptr<VectorLayer>& layer, const cglib::ray3<double>& ray, const ViewState& viewState, std::vector<RayIntersectedElement>& results) const {
         std::lock_guard<std::mutex> lock(_mutex);
-    
-        std::vector<MapPos> worldCoords;
-        for (const std::shared_ptr<Line>& element : _elements) {
+
+        if (!_spatialIndex) {
+            buildSpatialIndex();
+        }
+
+        // Only test the elements whose bounds, expanded by the maximum click width, intersect the ray. Keep the original element order.
+        std::vector<int> elementIndices = _spatialIndex->query(ray, _maxClickExtent * viewState.getUnitToDPCoef());
+        std::sort(elementIndices.begin(), elementIndices.end());
+        for (int elementIndex : elementIndices) {
+            const std::shared_ptr<Line>& element = _elements[elementIndex];
             FindElementRayIntersection(element, element->getDrawData(), layer, ray, viewState, results);
         }
     }
         
-    void LineRenderer::BuildAndDrawBuffers(GLuint a_color,
-                                           GLuint a_coord,
-                                           GLuint a_normal,
-                                           GLuint a_texCoord,
-                                           std::vector<unsigned char>& colorBuf,
-                                           std::vector<float>& coordBuf,
-                                           std::vector<float>& normalBuf,
-                                           std::vector<float>& texCoordBuf,
-                                           std::vector<unsigned short>& indexBuf,
-                                           std::vector<const LineDrawData*>& drawDataBuffer,
-                                           const ViewState& viewState)
+    void LineRenderer::BuildBatchSegments(const std::vector<const LineDrawData*>& drawDataBuffer,
+                                          const cglib::vec3<double>& origin,
+                                          std::vector<BatchSegment>& segments)
     {
-        // Get bitmap
-        std::shared_ptr<Bitmap> bitmap = drawDataBuffer.front()->getBitmap();
-        
-        // Calculate buffer size
-        std::size_t totalCoordCount = 0;
-        std::size_t totalIndexCount = 0;
-        for (const LineDrawData* drawData : drawDataBuffer) {
-            for (std::size_t i = 0; i < drawData->getCoords().size(); i++) {
-                const std::vector<cglib::vec3<double>*>& coords = drawData->getCoords()[i];
-                const std::vector<unsigned int>& indices = drawData->getIndices()[i];
-                
-                totalCoordCount += coords.size();
-                totalIndexCount += indices.size();
-            }
-        }
-        
-        // Resize the buffers, if necessary
-        if (coordBuf.size() < totalCoordCount * 3) {
-            colorBuf.resize(std::min(totalCoordCount * 4, GLContext::MAX_VERTEXBUFFER_SIZE * 4));
-            coordBuf.resize(std::min(totalCoordCount * 3, GLContext::MAX_VERTEXBUFFER_SIZE * 3));
-            normalBuf.resize(std::min(totalCoordCount * 4, GLContext::MAX_VERTEXBUFFER_SIZE * 4));
-            texCoordBuf.resize(std::min(totalCoordCount * 2, GLContext::MAX_VERTEXBUFFER_SIZE * 2));
-        }
-        
-        if (indexBuf.size() < totalIndexCount) {
-            indexBuf.resize(std::min(totalIndexCount, GLContext::MAX_VERTEXBUFFER_SIZE));
-        }
-        
-        // Calculate and draw buffers
-        cglib::vec3<double> cameraPos = viewState.getCameraPos();
-        std::size_t colorIndex = 0;
-        std::size_t coordIndex = 0;
-        std::size_t normalIndex = 0;
-        std::size_t texCoordIndex = 0;
-        std::size_t indexIndex = 0;
-        float texCoordYScale = (bitmap->getHeight() > 1 ? 1.0f / viewState.getUnitToDPCoef() : 1.0f);
+        segments.clear();
+        segments.emplace_back();
         for (const LineDrawData* drawData : drawDataBuffer) {
-            // Draw data vertex info may be split into multiple buffers, draw each one
+            // Draw data vertex info may be split into multiple buffers, add each one
             for (std::size_t i = 0; i < drawData->getCoords().size(); i++) {
                 
-                // Check for possible overflow in the buffer
+                // Check for possible overflow in the segment
                 const std::vector<unsigned int>& indices = drawData->getIndices()[i];
-                if (indexIndex + indices.size() > GLContext::MAX_VERTEXBUFFER_SIZE) {
-                    // If it doesn't fit, stop and draw the buffers
-                    glVertexAttribPointer(a_color, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, colorBuf.data());
-                    glVertexAttribPointer(a_coord, 3, GL_FLOAT, GL_FALSE, 0, coordBuf.data());
-                    glVertexAttribPointer(a_normal, 4, GL_FLOAT, GL_FALSE, 0, normalBuf.data());
-                    glVertexAttribPointer(a_texCoord, 2, GL_FLOAT, GL_FALSE, 0, texCoordBuf.data());
-                    glDrawElements(GL_TRIANGLES, indexIndex, GL_UNSIGNED_SHORT, indexBuf.data());
-                    // Start filling buffers from the beginning
-                    colorIndex = 0;
-                    coordIndex = 0;
-                    normalIndex = 0;
-                    texCoordIndex = 0;
-                    indexIndex = 0;
+                if (segments.back().indexBuf.size() + indices.size() > GLContext::MAX_VERTEXBUFFER_SIZE) {
+                    // If it doesn't fit, start a new segment
+                    segments.emplace_back();
                 }
+                BatchSegment& segment = segments.back();
                 
                 // Indices
-                std::size_t indexOffset = coordIndex / 3;
-                std::vector<unsigned int>::const_iterator iit;
-                for (iit = indices.begin(); iit != indices.end(); ++iit) {
-                    indexBuf[indexIndex] = static_cast<unsigned short>(indexOffset + *iit);
-                    indexIndex++;
+                std::size_t indexOffset = segment.coordBuf.size() / 3;
+                for (unsigned int index : indices) {
+                    segment.indexBuf.push_back(static_cast<unsigned short>(indexOffset + index));
                 }
                 
                 // Coords, tex coords and colors
@@ -220,52 +194,45 @@ namespace carto {
                     );
                     normalScale = 0.5f;
                 }
-                const std::vector<cglib::vec3<double>*>& coords = drawData->getCoords()[i];
+                cglib::vec3<double> delta = drawData->getOrigin() - origin;
+                const std::vector<cglib::vec3<float> >& coords = drawData->getCoords()[i];
                 const std::vector<cglib::vec4<float> >& normals = drawData->getNormals()[i];
                 const std::vector<cglib::vec2<float> >& texCoords = drawData->getTexCoords()[i];
+                const std::vector<float>& linePositions = drawData->getLinePositions()[i];
                 auto cit = coords.begin();
                 auto nit = normals.begin();
                 auto tit = texCoords.begin();
-                for ( ; cit != coords.end(); ++cit, ++nit, ++tit) {
+                auto lit = linePositions.begin();
+                for ( ; cit != coords.end(); ++cit, ++nit, ++tit, ++lit) {
                     // Colors
-                    colorBuf[colorIndex + 0] = color.getR();
-                    colorBuf[colorIndex + 1] = color.getG();
-                    colorBuf[colorIndex + 2] = color.getB();
-                    colorBuf[colorIndex + 3] = color.getA();
-                    colorIndex += 4;
-
-                    // Coords
-                    const cglib::vec3<double>& pos = **cit;
-                    coordBuf[coordIndex + 0] = static_cast<float>(pos(0) - cameraPos(0));
-                    coordBuf[coordIndex + 1] = static_cast<float>(pos(1) - cameraPos(1));
-                    coordBuf[coordIndex + 2] = static_cast<float>(pos(2) - cameraPos(2));
-                    coordIndex += 3;
+                    segment.colorBuf.push_back(color.getR());
+                    segment.colorBuf.push_back(color.getG());
+                    segment.colorBuf.push_back(color.getB());
+                    segment.colorBuf.push_back(color.getA());
+
+                    // Coords, translated from the draw data origin to the batch origin
+                    const cglib::vec3<float>& pos = *cit;
+                    segment.coordBuf.push_back(static_cast<float>(pos(0) + delta(0)));
+                    segment.coordBuf.push_back(static_cast<float>(pos(1) + delta(1)));
+                    segment.coordBuf.push_back(static_cast<float>(pos(2) + delta(2)));
 
                     // Normals
                     const cglib::vec4<float>& normal = *nit;
-                    normalBuf[normalIndex + 0] = normal(0) * normalScale;
-                    normalBuf[normalIndex + 1] = normal(1) * normalScale;
-                    normalBuf[normalIndex + 2] = normal(2) * normalScale;
-                    normalBuf[normalIndex + 3] = normal(3);
-                    normalIndex += 4;
+                    segment.normalBuf.push_back(normal(0) * normalScale);
+                    segment.normalBuf.push_back(normal(1) * normalScale);
+                    segment.normalBuf.push_back(normal(2) * normalScale);
+                    segment.normalBuf.push_back(normal(3));
                     
                     // Tex coords
                     const cglib::vec2<float>& texCoord = *tit;
-                    texCoordBuf[texCoordIndex + 0] = texCoord(0);
-                    texCoordBuf[texCoordIndex + 1] = texCoord(1) * texCoordYScale;
-                    texCoordIndex += 2;
+                    segment.texCoordBuf.push_back(texCoord(0));
+                    segment.texCoordBuf.push_back(texCoord(1));
+
+                    // Line positions
+                    segment.linePosBuf.push_back(*lit);
                 }
             }
         }
-        
-        // Draw the final batch
-        if (indexIndex > 0) {
-            glVertexAttribPointer(a_color, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, colorBuf.data());
-            glVertexAttribPointer(a_coord, 3, GL_FLOAT, GL_FALSE, 0, coordBuf.data());
-            glVertexAttribPointer(a_normal, 4, GL_FLOAT, GL_FALSE, 0, normalBuf.data());
-            glVertexAttribPointer(a_texCoord, 2, GL_FLOAT, GL_FALSE, 0, texCoordBuf.data());
-            glDrawElements(GL_TRIANGLES, indexIndex, GL_UNSIGNED_SHORT, indexBuf.data());
-        }
     }
     
     bool LineRenderer::FindElementRayIntersection(const std::shared_ptr<VectorElement>& element,
@@ -277,9 +244,10 @@ namespace carto {
     {
         std::vector<cglib::vec3<double> > worldCoords;
 
+        const cglib::vec3<double>& origin = drawData->getOrigin();
         for (std::size_t i = 0; i < drawData->getCoords().size(); i++) {
             // Resize the buffer for calculated world coordinates
-            const std::vector<cglib::vec3<double>*>& coords = drawData->getCoords()[i];
+            const std::vector<cglib::vec3<float> >& coords = drawData->getCoords()[i];
             worldCoords.clear();
             worldCoords.reserve(coords.size());
             
@@ -289,7 +257,7 @@ namespace carto {
             auto cit = coords.begin();
             auto nit = normals.begin();
             for ( ; cit != coords.end() && nit != normals.end(); ++cit, ++nit) {
-                const cglib::vec3<double>& pos = **cit;
+                cglib::vec3<double> pos = origin + cglib::vec3<double>::convert(*cit);
                 const cglib::vec4<float>& normal = *nit;
                 cglib::vec3<double> worldCoord = pos + cglib::vec3<double>(normal(0) * normal(3), normal(1) * normal(3), normal(2) * normal(3)) * static_cast<double>(viewState.getUnitToDPCoef() * drawData->getClickScale());
                 bounds.add(worldCoord);
@@ -303,13 +271,13 @@ namespace carto {
             
             // Click test
             const std::vector<unsigned int>& indices = drawData->getIndices()[i];
-            const cglib::vec3<double>* prevPos = nullptr;
+            const cglib::vec3<float>* prevPos = nullptr;
             for (std::size_t i = 0; i < indices.size(); i += 3) {
                 // Figure out the start and end point of the current line segment
-                const cglib::vec3<double>* pos = prevPos;
+                const cglib::vec3<float>* pos = prevPos;
                 for (std::size_t j = 0; j < 3; j++) {
-                    const cglib::vec3<double>* nextPos = coords[indices[i + j]];
-                    if (nextPos != pos) {
+                    const cglib::vec3<float>* nextPos = &coords[indices[i + j]];
+                    if (!pos || *nextPos != *pos) {
                         prevPos = pos;
                         pos = nextPos;
                     }
@@ -321,9 +289,11 @@ namespace carto {
                 // Test a line triangle against the click position
                 double t = 0;
                 if (cglib::intersect_triangle(worldCoords[indices[i + 0]], worldCoords[indices[i + 1]], worldCoords[indices[i + 2]], ray, &t)) {
-                    cglib::vec3<double> dp = ray(t) - *prevPos;
-                    cglib::vec3<double> ds = *pos - *prevPos;
-                    cglib::vec3<double> pos = *prevPos + ds * std::max(0.0, std::min(1.0, cglib::dot_product(dp, ds) / cglib::norm(ds)));
+                    cglib::vec3<double> p0 = origin + cglib::vec3<double>::convert(*prevPos);
+                    cglib::vec3<double> dp = ray(t) - p0;
+                    cglib::vec3<double> ds = cglib::vec3<double>::convert(*pos - *prevPos);
+                    double ds2 = cglib::norm(ds);
+                    cglib::vec3<double> pos = p0 + ds * (ds2 > 0 ? std::max(0.0, std::min(1.0, cglib::dot_product(dp, ds) / ds2)) : 0.0);
                     results.push_back(RayIntersectedElement(std::static_pointer_cast<VectorElement>(element), layer, ray(t), pos, layer->isZBuffering()));
                     return true;
                 }
@@ -332,6 +302,21 @@ namespace carto {
         return false;
     }
     
+    void LineRenderer::buildSpatialIndex() const {
+        std::vector<std::pair<cglib::bbox3<double>, int> > records;
+        records.reserve(_elements.size());
+        _maxClickExtent = 0;
+        for (std::size_t i = 0; i < _elements.size(); i++) {
+            const std::shared_ptr<LineDrawData>& drawData = _elements[i]->getDrawData();
+            if (drawData->getCoords().empty()) {
+                continue;
+            }
+            records.emplace_back(drawData->getBoundingBox(), static_cast<int>(i));
+            _maxClickExtent = std::max(_maxClickExtent, static_cast<double>(drawData->getMaxNormalLength() * drawData->getClickScale()));
+        }
+        _spatialIndex = std::make_shared<PackedRTreeSpatialIndex<int> >(records);
+    }
+
     bool LineRenderer::initializeRenderer() {
         if (_shader && _shader->isValid() && _textureCache && _textureCache->isValid()) {
             return true;
@@ -347,9 +332,12 @@ namespace carto {
             _a_coord = _shader->getAttribLoc("a_coord");
             _a_normal = _shader->getAttribLoc("a_normal");
             _a_texCoord = _shader->getAttribLoc("a_texCoord");
+            _a_linePos = _shader->getAttribLoc("a_linePos");
             _u_gamma = _shader->getUniformLoc("u_gamma");
             _u_dpToPX = _shader->getUniformLoc("u_dpToPX");
             _u_unitToDP = _shader->getUniformLoc("u_unitToDP");
+            _u_texCoordYScale = _shader->getUniformLoc("u_texCoordYScale");
+            _u_visibleRange = _shader->getUniformLoc("u_visibleRange");
             _u_mvpMat = _shader->getUniformLoc("u_mvpMat");
             _u_tex = _shader->getUniformLoc("u_tex");
         }
@@ -365,6 +353,7 @@ namespace carto {
         glEnableVertexAttribArray(_a_coord);
         glEnableVertexAttribArray(_a_normal);
         glEnableVertexAttribArray(_a_texCoord);
+        glEnableVertexAttribArray(_a_linePos);
         // Scale, gamma
         glUniform1f(_u_gamma, 0.5f);
         glUniform1f(_u_dpToPX, viewState.getDPToPX());
@@ -382,6 +371,7 @@ namespace carto {
         glDisableVertexAttribArray(_a_coord);
         glDisableVertexAttribArray(_a_normal);
         glDisableVertexAttribArray(_a_texCoord);
+        glDisableVertexAttribArray(_a_linePos);
     }
     
     bool LineRenderer::isEmptyBatch() const {
@@ -389,15 +379,20 @@ namespace carto {
     }
     
     void LineRenderer::addToBatch(const std::shared_ptr<LineDrawData>& drawData, const ViewState& viewState) {
+        addToBatch(drawData, MapRange(0, 1), viewState);
+    }
+    
+    void LineRenderer::addToBatch(const std::shared_ptr<LineDrawData>& drawData, const MapRange& visibleRange, const ViewState& viewState) {
         const Bitmap* bitmap = drawData->getBitmap().get();
         
-        if (_prevBitmap && (_prevBitmap != bitmap)) {
+        if (_prevBitmap && (_prevBitmap != bitmap || _prevVisibleRange != visibleRange)) {
             drawBatch(viewState);
         }
         
         _lineDrawDataBuffer.push_back(drawData.get());
         _drawDataBuffer.push_back(std::move(drawData));
         _prevBitmap = bitmap;
+        _prevVisibleRange = visibleRange;
     }
     
     void LineRenderer::drawBatch(const ViewState& viewState) {
@@ -412,36 +407,118 @@ namespace carto {
             texture = _textureCache->create(bitmap, true, true);
         }
         glBindTexture(GL_TEXTURE_2D, texture->getTexId());
-        
-        BuildAndDrawBuffers(_a_color, _a_coord, _a_normal, _a_texCoord, _colorBuf, _coordBuf, _normalBuf,_texCoordBuf, _indexBuf, _lineDrawDataBuffer, viewState);
+
+        // Use the cached vertex data if the batch has not changed since it was built, otherwise rebuild it.
+        // Also rebuild if the camera has moved too far from the batch origin relative to the view scale, as float vertex precision degrades with the distance.
+        auto it = _batchCache.find(_lineDrawDataBuffer.front());
+        double maxOriginDistance = cglib::length(viewState.getCameraPos() - viewState.getFocusPos()) * MAX_BATCH_ORIGIN_DISTANCE_FACTOR;
+        if (it == _batchCache.end() || it->second.drawDatas != _drawDataBuffer || cglib::length(it->second.origin - viewState.getCameraPos()) > maxOriginDistance) {
+            if (_batchCache.size() >= MAX_CACHED_BATCHES) {
+                clearBatchCache();
+            }
+            CachedBatch& batch = _batchCache[_lineDrawDataBuffer.front()];
+            batch.drawDatas = _drawDataBuffer;
+            batch.origin = viewState.getCameraPos();
+            BuildBatchSegments(_lineDrawDataBuffer, batch.origin, batch.segments);
+            it = _batchCache.find(_lineDrawDataBuffer.front());
+        }
+        CachedBatch& batch = it->second;
+        batch.used = true;
+
+        // Camera dependent values are passed as uniforms
+        glUniform1f(_u_texCoordYScale, bitmap->getHeight() > 1 ? 1.0f / viewState.getUnitToDPCoef() : 1.0f);
+        glUniform2f(_u_visibleRange, _prevVisibleRange.getMin(), _prevVisibleRange.getMax());
+        cglib::mat4x4<float> mvpMat = viewState.getRTEModelviewProjectionMat() * cglib::translate4_matrix(cglib::vec3<float>::convert(batch.origin - viewState.getCameraPos()));
+        glUniformMatrix4fv(_u_mvpMat, 1, GL_FALSE, mvpMat.data());
+
+        for (const BatchSegment& segment : batch.segments) {
+            if (segment.indexBuf.empty()) {
+                continue;
+            }
+            glVertexAttribPointer(_a_color, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, segment.colorBuf.data());
+            glVertexAttribPointer(_a_coord, 3, GL_FLOAT, GL_FALSE, 0, segment.coordBuf.data());
+            glVertexAttribPointer(_a_normal, 4, GL_FLOAT, GL_FALSE, 0, segment.normalBuf.data());
+            glVertexAttribPointer(_a_texCoord, 2, GL_FLOAT, GL_FALSE, 0, segment.texCoordBuf.data());
+            glVertexAttribPointer(_a_linePos, 1, GL_FLOAT, GL_FALSE, 0, segment.linePosBuf.data());
+            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(segment.indexBuf.size()), GL_UNSIGNED_SHORT, segment.indexBuf.data());
+        }
 
         _lineDrawDataBuffer.clear();
         _drawDataBuffer.clear();
         _prevBitmap = nullptr;
     }
 
+    void LineRenderer::offsetBatchCache(double offset) {
+        // Batch vertices are relative to the batch origin, so moving the origin moves the whole batch without rebuilding it
+        for (auto it = _batchCache.begin(); it != _batchCache.end(); it++) {
+            it->second.origin(0) += offset;
+        }
+    }
+
+    bool LineRenderer::isCachedDrawData(const LineDrawData* drawData) const {
+        for (auto it = _batchCache.begin(); it != _batchCache.end(); it++) {
+            for (const std::shared_ptr<LineDrawData>& cachedDrawData : it->second.drawDatas) {
+                if (cachedDrawData.get() == drawData) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void LineRenderer::removeCachedBatches(const LineDrawData* drawData) {
+        for (auto it = _batchCache.begin(); it != _batchCache.end(); ) {
+            const std::vector<std::shared_ptr<LineDrawData> >& drawDatas = it->second.drawDatas;
+            if (std::find_if(drawDatas.begin(), drawDatas.end(), [drawData](const std::shared_ptr<LineDrawData>& cachedDrawData) { return cachedDrawData.get() == drawData; }) != drawDatas.end()) {
+                it = _batchCache.erase(it);
+            } else {
+                it++;
+            }
+        }
+    }
+
+    void LineRenderer::pruneBatchCache() {
+        // Drop the batches that were not drawn since the last pruning, keeping their draw datas alive is not needed
+        for (auto it = _batchCache.begin(); it != _batchCache.end(); ) {
+            if (!it->second.used) {
+                it = _batchCache.erase(it);
+            } else {
+                it->second.used = false;
+                it++;
+            }
+        }
+    }
+
+    void LineRenderer::clearBatchCache() {
+        _batchCache.clear();
+    }
+
     const std::string LineRenderer::LINE_VERTEX_SHADER = R"GLSL(
         #version 100
         attribute vec3 a_coord;
         attribute vec4 a_normal;
         attribute vec2 a_texCoord;
         attribute vec4 a_color;
+        attribute float a_linePos;
         uniform float u_gamma;
         uniform float u_dpToPX;
         uniform float u_unitToDP;
+        uniform float u_texCoordYScale;
         uniform mat4 u_mvpMat;
         varying lowp vec4 v_color;
         varying vec2 v_texCoord;
         varying float v_dist;
         varying float v_width;
+        varying float v_linePos;
         void main() {
             float width = length(a_normal.xyz) * u_dpToPX;
             float roundedWidth = width + 1.0;
             vec3 pos = a_coord + u_unitToDP * roundedWidth / width * (a_normal.xyz * a_normal.w);
             v_color = a_color;
-            v_texCoord = a_texCoord;
+            v_texCoord = vec2(a_texCoord.x, a_texCoord.y * u_texCoordYScale);
             v_dist = a_normal.w * roundedWidth * u_gamma;
             v_width = 1.0 + (width - 1.0) * u_gamma;
+            v_linePos = a_linePos;
             gl_Position = u_mvpMat * vec4(pos, 1.0);
         }
     )GLSL";
@@ -452,15 +529,22 @@ namespace carto {
         uniform sampler2D u_tex;
         varying lowp vec4 v_color;
         #ifdef GL_FRAGMENT_PRECISION_HIGH
+        uniform highp vec2 u_visibleRange;
         varying highp vec2 v_texCoord;
         varying highp float v_dist;
         varying highp float v_width;
+        varying highp float v_linePos;
         #else
+        uniform mediump vec2 u_visibleRange;
         varying mediump vec2 v_texCoord;
         varying mediump float v_dist;
         varying mediump float v_width;
+        varying mediump float v_linePos;
         #endif
         void main() {
+            if (v_linePos < u_visibleRange.x || v_linePos > u_visibleRange.y) {
+                discard;
+            }
             lowp float a = clamp(v_width - abs(v_dist), 0.0, 1.0);
             gl_FragColor = texture2D(u_tex, v_texCoord) * v_color * a;
         }
@@ -468,4 +552,7 @@ namespace carto {
 
     const unsigned int LineRenderer::TEXTURE_CACHE_SIZE = 1 * 1024 * 1024;
 
+    const std::size_t LineRenderer::MAX_CACHED_BATCHES = 1024;
+    const double LineRenderer::MAX_BATCH_ORIGIN_DISTANCE_FACTOR = 16.0;
+
 }
@@ -7,14 +7,18 @@
 #ifndef _CARTO_LINERENDERER_H_
 #define _CARTO_LINERENDERER_H_
 
+#include "core/MapRange.h"
+#include "geometry/utils/SpatialIndex.h"
 #include "renderers/utils/GLContext.h"
 #include "renderers/utils/BitmapTextureCache.h"
 
 #include <deque>
 #include <memory>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 
+#include <cglib/vec.h>
 #include <cglib/ray.h>
 
 namespace carto {
@@ -52,17 +56,25 @@ namespace carto {
         friend class GeometryCollectionRenderer;
 
     private:
-        static void BuildAndDrawBuffers(GLuint a_color,
-                                        GLuint a_coord,
-                                        GLuint a_normal,
-                                        GLuint a_texCoord,
-                                        std::vector<unsigned char>& colorBuf,
-                                        std::vector<float>& coordBuf,
-                                        std::vector<float>& normalBuf,
-                                        std::vector<float>& texCoordBuf,
-                                        std::vector<unsigned short>& indexBuf,
-                                        std::vector<const LineDrawData*>& drawDataBuffer,
-                                        const ViewState& viewState);
+        struct BatchSegment {
+            std::vector<unsigned char> colorBuf;
+            std::vector<float> coordBuf;
+            std::vector<float> normalBuf;
+            std::vector<float> texCoordBuf;
+            std::vector<float> linePosBuf;
+            std::vector<unsigned short> indexBuf;
+        };
+
+        struct CachedBatch {
+            std::vector<std::shared_ptr<LineDrawData> > drawDatas;
+            cglib::vec3<double> origin; // vertex coordinates are relative to this point
+            std::vector<BatchSegment> segments;
+            bool used; // drawn since the last pruning
+        };
+
+        static void BuildBatchSegments(const std::vector<const LineDrawData*>& drawDataBuffer,
+                                       const cglib::vec3<double>& origin,
+                                       std::vector<BatchSegment>& segments);
 
         static bool FindElementRayIntersection(const std::shared_ptr<VectorElement>& element,
                                                const std::shared_ptr<LineDrawData>& drawData,
@@ -77,27 +89,36 @@ namespace carto {
         
         bool isEmptyBatch() const;
         void addToBatch(const std::shared_ptr<LineDrawData>& drawData, const ViewState& viewState);
+        void addToBatch(const std::shared_ptr<LineDrawData>& drawData, const MapRange& visibleRange, const ViewState& viewState);
         void drawBatch(const ViewState& viewState);
+        void offsetBatchCache(double offset);
+        bool isCachedDrawData(const LineDrawData* drawData) const;
+        void removeCachedBatches(const LineDrawData* drawData);
+        void pruneBatchCache();
+        void clearBatchCache();
+        void buildSpatialIndex() const;
     
         static const std::string LINE_VERTEX_SHADER;
         static const std::string LINE_FRAGMENT_SHADER;
 
         static const unsigned int TEXTURE_CACHE_SIZE;
+        static const std::size_t MAX_CACHED_BATCHES;
+        static const double MAX_BATCH_ORIGIN_DISTANCE_FACTOR;
 
         std::weak_ptr<MapRenderer> _mapRenderer;
 
         std::vector<std::shared_ptr<Line> > _elements;
         std::vector<std::shared_ptr<Line> > _tempElements;
+
+        mutable std::shared_ptr<SpatialIndex<int> > _spatialIndex; // element indices for click tests, built lazily, null if invalidated
+        mutable double _maxClickExtent; // maximum click extrusion of the indexed lines, in DP units
         
         std::vector<std::shared_ptr<LineDrawData> > _drawDataBuffer; // this buffer is used to keep objects alive
         std::vector<const LineDrawData*> _lineDrawDataBuffer;
         const Bitmap* _prevBitmap;
-    
-        std::vector<unsigned char> _colorBuf;
-        std::vector<float> _coordBuf;
-        std::vector<float> _normalBuf;
-        std::vector<float> _texCoordBuf;
-        std::vector<unsigned short> _indexBuf;
+        MapRange _prevVisibleRange;
+
+        std::unordered_map<const LineDrawData*, CachedBatch> _batchCache; // built batches, keyed by the first draw data of the batch
     
         std::shared_ptr<BitmapTextureCache> _textureCache;
         std::shared_ptr<Shader> _shader;
@@ -105,9 +126,12 @@ namespace carto {
         GLuint _a_coord;
         GLuint _a_normal;
         GLuint _a_texCoord;
+        GLuint _a_linePos;
         GLuint _u_gamma;
         GLuint _u_dpToPX;
         GLuint _u_unitToDP;
+        GLuint _u_texCoordYScale;
+        GLuint _u_visibleRange;
         GLuint _u_mvpMat;
         GLuint _u_tex;
     
@@ -1,6 +1,9 @@
 #include "MapRenderer.h"
+#include "components/CancelableTask.h"
+#include "components/CancelableThreadPool.h"
 #include "components/Exceptions.h"
 #include "components/Layers.h"
+#include "components/MemoryGovernor.h"
 #include "components/ThreadWorker.h"
 #include "core/MapPos.h"
 #include "core/ScreenPos.h"
@@ -14,6 +17,7 @@
 #include "renderers/RendererCaptureListener.h"
 #include "renderers/RedrawRequestListener.h"
 #include "renderers/components/BillboardSorter.h"
+#include "renderers/components/FrameProfiler.h"
 #include "renderers/components/RayIntersectedElement.h"
 #include "renderers/cameraevents/CameraPanEvent.h"
 #include "renderers/cameraevents/CameraRotationEvent.h"
@@ -24,29 +28,74 @@
 #include "renderers/utils/GLResourceManager.h"
 #include "renderers/utils/FrameBuffer.h"
 #include "renderers/utils/Shader.h"
+#include "renderers/utils/ShaderBinaryCache.h"
 #include "renderers/utils/Texture.h"
 #include "renderers/workers/BillboardPlacementWorker.h"
 #include "renderers/workers/VTLabelPlacementWorker.h"
 #include "renderers/workers/CullWorker.h"
+#include "renderers/workers/RedrawWorker.h"
 #include "utils/Const.h"
 #include "utils/Log.h"
 #include "utils/ThreadUtils.h"
+#include "utils/TraceUtils.h"
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
 
 namespace carto {
 
+    class MapRenderer::CaptureBitmapTask : public CancelableTask {
+    public:
+        CaptureBitmapTask(std::vector<unsigned char>&& pixels, int width, int height, const std::vector<CaptureRequest>& requests) :
+            _pixels(std::move(pixels)),
+            _width(width),
+            _height(height),
+            _requests(requests)
+        {
+        }
+
+        virtual void run() {
+            // The bitmap constructor flips the rows, as GL returns the bottom row first
+            auto bitmap = std::make_shared<Bitmap>(_pixels.data(), _width, _height, ColorFormat::COLOR_FORMAT_RGBA, -4 * _width);
+            std::vector<unsigned char>().swap(_pixels);
+
+            std::map<std::pair<int, int>, std::shared_ptr<Bitmap> > scaledBitmaps;
+            for (const CaptureRequest& request : _requests) {
+                std::shared_ptr<Bitmap> captureBitmap = bitmap;
+                if (request.scale < 1.0f) {
+                    int scaledWidth = std::max(1, static_cast<int>(std::round(_width * request.scale)));
+                    int scaledHeight = std::max(1, static_cast<int>(std::round(_height * request.scale)));
+                    std::shared_ptr<Bitmap>& scaledBitmap = scaledBitmaps[std::make_pair(scaledWidth, scaledHeight)];
+                    if (!scaledBitmap) {
+                        scaledBitmap = bitmap->getResizedBitmap(scaledWidth, scaledHeight);
+                    }
+                    captureBitmap = scaledBitmap;
+                }
+                request.listener->onMapRendered(captureBitmap);
+            }
+        }
+
+    private:
+        std::vector<unsigned char> _pixels;
+        int _width;
+        int _height;
+        std::vector<CaptureRequest> _requests;
+    };
+
     MapRenderer::MapRenderer(const std::shared_ptr<Layers>& layers, const std::shared_ptr<Options>& options) :
         _lastFrameTime(),
         _viewState(),
         _glResourceManager(),
+        _frameProfiler(std::make_shared<FrameProfiler>()),
         _cullWorker(std::make_shared<CullWorker>()),
         _cullThread(),
         _vtLabelPlacementWorker(std::make_shared<VTLabelPlacementWorker>()),
         _vtLabelPlacementThread(),
         _optionsListener(),
         _currentBoundFBOs(),
-        _screenFrameBuffer(),
+        _screenFrameBuffers(),
         _screenBlendShader(),
         _backgroundRenderer(*options, *layers),
         _watermarkRenderer(*options),
@@ -54,6 +103,8 @@ namespace carto {
         _billboardDrawDataBuffer(),
         _billboardPlacementWorker(std::make_shared<BillboardPlacementWorker>()),
         _billboardPlacementThread(),
+        _redrawWorker(std::make_shared<RedrawWorker>()),
+        _redrawThread(),
         _animationHandler(*this),
         _kineticEventHandler(*this, *options),
         _layers(layers),
@@ -62,14 +113,20 @@ namespace carto {
         _surfaceChanged(false),
         _billboardsChanged(false),
         _redrawPending(false),
+        _drawingFrame(false),
+        _cameraChanged(false),
+        _layersAnimating(false),
         _redrawRequestListener(),
         _mapRendererListener(),
         _rendererCaptureListeners(),
         _rendererCaptureListenersMutex(),
+        _pendingCaptures(),
+        _captureThreadPool(std::make_shared<CancelableThreadPool>()),
         _onChangeListeners(),
         _onChangeListenersMutex(),
         _mutex()
     {
+        _captureThreadPool->setPoolSize(1);
     }
         
     MapRenderer::~MapRenderer() {
@@ -84,7 +141,12 @@ namespace carto {
 
         _billboardPlacementWorker->setComponents(shared_from_this(), _billboardPlacementWorker);
         _billboardPlacementThread = std::thread(std::ref(*_billboardPlacementWorker));
+
+        _redrawWorker->setComponents(shared_from_this(), _redrawWorker);
+        _redrawThread = std::thread(std::ref(*_redrawWorker));
         
+        setWorkersFrameSynchronous(_options->isFrameSynchronousScheduling());
+
         _optionsListener = std::make_shared<OptionsListener>(shared_from_this());
         _options->registerOnChangeListener(_optionsListener);
     }
@@ -101,6 +163,12 @@ namespace carto {
         
         _billboardPlacementWorker->stop();
         _billboardPlacementThread.detach();
+
+        _redrawWorker->stop();
+        _redrawThread.detach();
+
+        _captureThreadPool->cancelAll();
+        _captureThreadPool->deinit();
     }
         
     std::shared_ptr<RedrawRequestListener> MapRenderer::getRedrawRequestListener() const {
@@ -137,11 +205,21 @@ namespace carto {
         
     void MapRenderer::requestRedraw() const {
         DirectorPtr<RedrawRequestListener> redrawRequestListener = _redrawRequestListener;
+        if (!redrawRequestListener) {
+            return;
+        }
+
+        // Coalesce the requests, the next frame is scheduled only once
+        if (_redrawPending.exchange(true)) {
+            return;
+        }
 
-        if (redrawRequestListener) {
-            _redrawPending = true;
-            redrawRequestListener->onRedrawRequested();
+        // Requests made while drawing are scheduled at the end of the frame, when the activity state of the frame is known
+        if (_drawingFrame) {
+            return;
         }
+
+        scheduleRedraw();
     }
     
     void MapRenderer::captureRendering(const std::shared_ptr<RendererCaptureListener>& listener, bool waitWhileUpdating) {
@@ -151,7 +229,22 @@ namespace carto {
 
         {
             std::lock_guard<std::mutex> lock(_rendererCaptureListenersMutex);
-            _rendererCaptureListeners.push_back(std::make_pair(DirectorPtr<RendererCaptureListener>(listener), waitWhileUpdating));
+            _rendererCaptureListeners.push_back(CaptureRequest { DirectorPtr<RendererCaptureListener>(listener), waitWhileUpdating, false, 1.0f });
+        }
+        requestRedraw();
+    }
+
+    void MapRenderer::captureRenderingAsync(const std::shared_ptr<RendererCaptureListener>& listener, bool waitWhileUpdating, float scale) {
+        if (!listener) {
+            throw NullArgumentException("Null listener");
+        }
+        if (!(scale > 0.0f && scale <= 1.0f)) {
+            throw InvalidArgumentException("Scale must be in range (0..1]");
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_rendererCaptureListenersMutex);
+            _rendererCaptureListeners.push_back(CaptureRequest { DirectorPtr<RendererCaptureListener>(listener), waitWhileUpdating, true, scale });
         }
         requestRedraw();
     }
@@ -166,6 +259,32 @@ namespace carto {
         return _glResourceManager;
     }
 
+    std::shared_ptr<FrameProfiler> MapRenderer::getFrameProfiler() const {
+        return _frameProfiler;
+    }
+
+    MapRenderer::GPUMemoryStatistics MapRenderer::getGPUMemoryStatistics() const {
+        static const char* categoryNames[GLMemoryCategory::GL_MEMORY_CATEGORY_COUNT] = { "texture", "framebuffer", "vertexbuffer", "tile", "model" };
+
+        GPUMemoryStatistics statistics;
+        std::shared_ptr<GLResourceManager> glResourceManager = getGLResourceManager();
+        if (glResourceManager) {
+            for (int i = 0; i < GLMemoryCategory::GL_MEMORY_CATEGORY_COUNT; i++) {
+                statistics.categoryUsage[categoryNames[i]] = glResourceManager->getGPUMemoryUsage(static_cast<GLMemoryCategory::GLMemoryCategory>(i));
+            }
+            statistics.totalUsage = glResourceManager->getTotalGPUMemoryUsage();
+        }
+
+        std::vector<std::shared_ptr<Layer> > layers = _layers->getAll();
+        for (std::size_t i = 0; i < layers.size(); i++) {
+            std::size_t usage = layers[i]->getGPUMemoryUsage();
+            if (usage > 0) {
+                statistics.layerUsage["layer " + std::to_string(i)] = usage;
+            }
+        }
+        return statistics;
+    }
+
     std::vector<std::shared_ptr<BillboardDrawData> > MapRenderer::getBillboardDrawDatas() const {
         std::lock_guard<std::recursive_mutex> lock(_mutex);
         return _billboardDrawDatas;
@@ -179,6 +298,45 @@ namespace carto {
         return _kineticEventHandler;
     }
     
+    std::vector<ViewState> MapRenderer::calculatePredictedViewStates(int stepCount) const {
+        std::vector<ViewState> viewStates;
+
+        ViewState viewState = getViewState();
+        std::shared_ptr<ProjectionSurface> projectionSurface = viewState.getProjectionSurface();
+        if (!projectionSurface || viewState.getWidth() <= 0 || viewState.getHeight() <= 0) {
+            return viewStates;
+        }
+
+        // Use the animation targets, if animating. Otherwise use the resting position of kinetic panning.
+        MapPos panTarget;
+        bool panning = _animationHandler.getPanTarget(panTarget) || _kineticEventHandler.calculatePanTarget(viewState, panTarget);
+        float zoomTarget = viewState.getZoom();
+        bool zooming = _animationHandler.getZoomTarget(zoomTarget);
+        if (!panning && !zooming) {
+            return viewStates;
+        }
+
+        // Sample the camera trajectory, the last view state corresponds to the destination
+        for (int i = 1; i <= stepCount; i++) {
+            float ratio = static_cast<float>(i) / stepCount;
+            ViewState predictedViewState = viewState;
+            if (panning) {
+                cglib::mat4x4<double> transform = projectionSurface->calculateTranslateMatrix(viewState.getFocusPos(), projectionSurface->calculatePosition(panTarget), ratio);
+                CameraPanEvent cameraPanEvent;
+                cameraPanEvent.setPos(projectionSurface->calculateMapPos(cglib::transform_point(viewState.getFocusPos(), transform)));
+                cameraPanEvent.calculate(*_options, predictedViewState);
+            }
+            if (zooming) {
+                CameraZoomEvent cameraZoomEvent;
+                cameraZoomEvent.setZoom(viewState.getZoom() + (zoomTarget - viewState.getZoom()) * ratio);
+                cameraZoomEvent.calculate(*_options, predictedViewState);
+            }
+            predictedViewState.calculateViewState(*_options);
+            viewStates.push_back(predictedViewState);
+        }
+        return viewStates;
+    }
+    
     void MapRenderer::calculateCameraEvent(CameraPanEvent& cameraEvent, float durationSeconds, bool updateKinetic) {
         if (durationSeconds > 0) {
             if (cameraEvent.isUseDelta()) {
@@ -188,6 +346,7 @@ namespace carto {
             }
     
             // Animation will start on the next frame
+            _cameraChanged = true;
             requestRedraw();
             return;
         }
@@ -231,6 +390,7 @@ namespace carto {
             _animationHandler.setRotationTarget(cameraEvent.isUseDelta() ? oldRotation + cameraEvent.getRotationDelta() : cameraEvent.getRotation(), cameraEvent.isUseTarget() ? &cameraEvent.getTargetPos() : nullptr, durationSeconds);
     
             // Animation will start on the next frame
+            _cameraChanged = true;
             requestRedraw();
             return;
         }
@@ -270,6 +430,7 @@ namespace carto {
             _animationHandler.setTiltTarget(cameraEvent.isUseDelta() ? oldTilt + cameraEvent.getTiltDelta() : cameraEvent.getTilt(), durationSeconds);
     
             // Animation will start on the next frame
+            _cameraChanged = true;
             requestRedraw();
             return;
         }
@@ -295,6 +456,7 @@ namespace carto {
             _animationHandler.setZoomTarget(cameraEvent.isUseDelta() ? oldZoom + cameraEvent.getZoomDelta() : cameraEvent.getZoom(), cameraEvent.isUseTarget() ? &cameraEvent.getTargetPos() : nullptr, durationSeconds);
     
             // Animation will start on the next frame
+            _cameraChanged = true;
             requestRedraw();
             return;
         }
@@ -469,7 +631,7 @@ namespace carto {
     }
     
     void MapRenderer::onSurfaceCreated() {
-        ThreadUtils::SetThreadPriority(ThreadPriority::MAXIMUM);
+        ThreadUtils::SetThreadRole(ThreadRole::RENDER_CRITICAL);
         
         GLContext::LoadExtensions();
     
@@ -490,14 +652,21 @@ namespace carto {
         _glResourceManager = std::make_shared<GLResourceManager>();
         _glResourceManager->setGLThreadId(std::this_thread::get_id());
 
+        // Use the persistent shader binary cache, if configured and supported by the driver
+        std::string shaderCacheDirectory = _options->getShaderCacheDirectory();
+        if (!shaderCacheDirectory.empty() && GLContext::PROGRAM_BINARY) {
+            _glResourceManager->setShaderBinaryCache(std::make_shared<ShaderBinaryCache>(shaderCacheDirectory));
+        }
+
         // Reset screen blending state
         _currentBoundFBOs.clear();
-        _screenFrameBuffer.reset();
+        _screenFrameBuffers.clear();
         _screenBlendShader.reset();
 
         // Notify renderers about the event
         _backgroundRenderer.onSurfaceCreated(_glResourceManager);
         _watermarkRenderer.onSurfaceCreated(_glResourceManager);
+        _frameProfiler->onSurfaceCreated();
 
         GLContext::CheckGLError("MapRenderer::onSurfaceCreated");
     }
@@ -508,7 +677,7 @@ namespace carto {
         _viewState.calculateViewState(*_options);
         _viewState.clampZoom(*_options);
         _viewState.clampFocusPos(*_options);
-        _screenFrameBuffer.reset(); // reset, as this depends on the surface dimensions
+        _screenFrameBuffers.clear(); // reset, as these depend on the surface dimensions
         _surfaceChanged = true;
     }
     
@@ -518,7 +687,17 @@ namespace carto {
             return;
         }
 
+        CARTO_TRACE_SECTION("MapRenderer::onDrawFrame");
+
         _redrawPending = false;
+        _drawingFrame = true;
+        _cameraChanged = false;
+        _redrawWorker->setFrameTime(std::chrono::steady_clock::now());
+
+        // In frame synchronous mode the workers hold back due work until the frame is submitted
+        _cullWorker->frameStarted();
+        _vtLabelPlacementWorker->frameStarted();
+        _billboardPlacementWorker->frameStarted();
 
         std::vector<std::shared_ptr<OnChangeListener> > onChangeListeners;
         {
@@ -531,8 +710,14 @@ namespace carto {
         // Re-set GL thread ids, Windows Phone needs this as onSurfaceCreate/onSurfaceChange may be called from different threads
         _glResourceManager->setGLThreadId(std::this_thread::get_id());
 
-        // Create pending resources
-        _glResourceManager->processResources();
+        _frameProfiler->beginFrame();
+
+        // Process pending resources within the frame budget, continue with the remaining resources in the next frame
+        if (_glResourceManager->processResources(std::chrono::milliseconds(GL_RESOURCE_PROCESSING_BUDGET))) {
+            requestRedraw();
+        }
+        MemoryGovernor::GetInstance().checkGPUBudget();
+        _frameProfiler->endPhase("resources");
 
         // Check if surface has changed
         if (_surfaceChanged.exchange(false)) {
@@ -565,32 +750,53 @@ namespace carto {
             mapRendererListener->onBeforeDrawFrame();
         }
 
+        // Apply input queued since the last frame before the view state is calculated
+        for (const std::shared_ptr<OnChangeListener>& onChangeListener : onChangeListeners) {
+            onChangeListener->onBeforeDrawFrame();
+        }
+
         // Calculate camera params and make a synchronized copy of the view state
         ViewState viewState;
         {
-            std::lock_guard<std::recursive_mutex> lock(_mutex);
-            _viewState.calculateViewState(*_options);
-            viewState = _viewState;
-            _viewState.setHorizontalLayerOffsetDir(0);
+            CARTO_TRACE_SECTION("MapRenderer::prepare");
+
+            {
+                std::lock_guard<std::recursive_mutex> lock(_mutex);
+                _viewState.calculateViewState(*_options);
+                viewState = _viewState;
+                _viewState.setHorizontalLayerOffsetDir(0);
+            }
+
+            // Calculate map moving animations and kinetic events
+            _animationHandler.calculate(viewState, deltaSeconds);
+            _kineticEventHandler.calculate(viewState, deltaSeconds);
         }
 
-        // Calculate map moving animations and kinetic events
-        _animationHandler.calculate(viewState, deltaSeconds);
-        _kineticEventHandler.calculate(viewState, deltaSeconds);
+        _frameProfiler->endPhase("prepare");
+
+        // Apply billboard placement calculated after the previous frame
+        _billboardPlacementWorker->applyPlacement();
 
         // Render everything
         initializeRenderState();
         _backgroundRenderer.onDrawFrame(viewState);
+        _frameProfiler->endPhase("background");
         drawLayers(deltaSeconds, viewState);
         _watermarkRenderer.onDrawFrame(viewState);
+        _frameProfiler->endPhase("watermark");
     
         // Callback for synchronized rendering
         if (mapRendererListener) {
             mapRendererListener->onAfterDrawFrame();
         }
+        _frameProfiler->endPhase("listeners");
 
         // Handle renderer capture callbacks as everything is rendered now
-        handleRendererCaptureCallbacks();
+        {
+            CARTO_TRACE_SECTION("MapRenderer::capture");
+            handleRendererCaptureCallbacks();
+        }
+        _frameProfiler->endPhase("capture");
         
         // Update billboard placements/visibility
         if (_billboardsChanged.exchange(false)) {
@@ -604,6 +810,18 @@ namespace carto {
             }
         }
 
+        _frameProfiler->endFrame();
+
+        // Schedule the next frame, if requested while drawing
+        _drawingFrame = false;
+        if (_redrawPending) {
+            scheduleRedraw();
+        }
+
+        _cullWorker->frameSubmitted();
+        _vtLabelPlacementWorker->frameSubmitted();
+        _billboardPlacementWorker->frameSubmitted();
+
         GLContext::CheckGLError("MapRenderer::onDrawFrame");
     }
     
@@ -619,12 +837,22 @@ namespace carto {
 
         // Reset screen blending state
         _currentBoundFBOs.clear();
-        _screenFrameBuffer.reset();
+        _screenFrameBuffers.clear();
         _screenBlendShader.reset();
 
+        // Readbacks of the lost context can not be completed, capture again from the next frame
+        {
+            std::lock_guard<std::mutex> lock(_rendererCaptureListenersMutex);
+            for (const PendingCapture& pendingCapture : _pendingCaptures) {
+                _rendererCaptureListeners.insert(_rendererCaptureListeners.end(), pendingCapture.requests.begin(), pendingCapture.requests.end());
+            }
+        }
+        _pendingCaptures.clear();
+
         // Notify renderers about the event
         _watermarkRenderer.onSurfaceDestroyed();
         _backgroundRenderer.onSurfaceDestroyed();
+        _frameProfiler->onSurfaceDestroyed();
     }
     
     void MapRenderer::finishRendering() {
@@ -635,13 +863,10 @@ namespace carto {
         GLint prevBoundFBO = 0;
         glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevBoundFBO);
         GLuint bufferMask = GL_COLOR_BUFFER_BIT | (depth ? GL_DEPTH_BUFFER_BIT : 0) | (stencil ? GL_STENCIL_BUFFER_BIT : 0);
-        _currentBoundFBOs.emplace_back(static_cast<GLuint>(prevBoundFBO), bufferMask);
-
-        if (!_screenFrameBuffer) {
-            _screenFrameBuffer = _glResourceManager->create<FrameBuffer>(_viewState.getWidth(), _viewState.getHeight(), true, depth, stencil);
-        }
+        std::shared_ptr<FrameBuffer> frameBuffer = acquireScreenFrameBuffer(depth, stencil);
+        _currentBoundFBOs.emplace_back(static_cast<GLuint>(prevBoundFBO), bufferMask, frameBuffer);
 
-        glBindFramebuffer(GL_FRAMEBUFFER, _screenFrameBuffer->getFBOId());
+        glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer->getFBOId());
 
         glClearColor(color.getR() / 255.0f, color.getG() / 255.0f, color.getB() / 255.0f, color.getA() / 255.0f);
         glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
@@ -672,15 +897,17 @@ namespace carto {
             return;
         }
 
-        GLuint prevBoundFBO = _currentBoundFBOs.back().first;
-        GLuint bufferMask = _currentBoundFBOs.back().second;
+        GLuint prevBoundFBO = _currentBoundFBOs.back().prevFBOId;
+        GLuint bufferMask = _currentBoundFBOs.back().bufferMask;
+        std::shared_ptr<FrameBuffer> frameBuffer = _currentBoundFBOs.back().frameBuffer;
         _currentBoundFBOs.pop_back();
         
-        if (!_screenFrameBuffer || !_screenFrameBuffer->isValid()) {
+        if (!frameBuffer || !frameBuffer->isValid()) {
             return; // should not happen, just safety
         }
-        if (bufferMask & (GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT)) {
-            _screenFrameBuffer->discard(false, (bufferMask & GL_DEPTH_BUFFER_BIT) != 0, (bufferMask & GL_STENCIL_BUFFER_BIT) != 0);
+        // Depth and stencil contents are not needed after rendering, avoid storing them on tile-based GPUs
+        if (frameBuffer->isDepth() || frameBuffer->isStencil()) {
+            frameBuffer->discard(false, frameBuffer->isDepth(), frameBuffer->isStencil());
         }
 
         glBindFramebuffer(GL_FRAMEBUFFER, prevBoundFBO);
@@ -699,7 +926,7 @@ namespace carto {
         
         glUniform1i(_screenBlendShader->getUniformLoc("u_tex"), 0);
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, _screenFrameBuffer->getColorTexId());
+        glBindTexture(GL_TEXTURE_2D, frameBuffer->getColorTexId());
 
         glUniform4f(_screenBlendShader->getUniformLoc("u_color"), opacity, opacity, opacity, opacity);
         glUniform2f(_screenBlendShader->getUniformLoc("u_invScreenSize"), 1.0f / _viewState.getWidth(), 1.0f / _viewState.getHeight());
@@ -713,6 +940,30 @@ namespace carto {
         GLContext::CheckGLError("MapRenderer::blendAndUnbindScreenFBO");
     }
 
+    std::shared_ptr<FrameBuffer> MapRenderer::acquireScreenFrameBuffer(bool depth, bool stencil) {
+        // Reuse a pooled frame buffer that is not bound by an enclosing layer. Prefer the one with the least extra attachments.
+        std::shared_ptr<FrameBuffer> bestFrameBuffer;
+        int bestExtraAttachments = 0;
+        for (const std::shared_ptr<FrameBuffer>& frameBuffer : _screenFrameBuffers) {
+            if (!frameBuffer->isValid() || (depth && !frameBuffer->isDepth()) || (stencil && !frameBuffer->isStencil())) {
+                continue;
+            }
+            if (std::find_if(_currentBoundFBOs.begin(), _currentBoundFBOs.end(), [&frameBuffer](const BoundFBO& boundFBO) { return boundFBO.frameBuffer == frameBuffer; }) != _currentBoundFBOs.end()) {
+                continue;
+            }
+            int extraAttachments = (frameBuffer->isDepth() && !depth ? 1 : 0) + (frameBuffer->isStencil() && !stencil ? 1 : 0);
+            if (!bestFrameBuffer || extraAttachments < bestExtraAttachments) {
+                bestFrameBuffer = frameBuffer;
+                bestExtraAttachments = extraAttachments;
+            }
+        }
+        if (!bestFrameBuffer) {
+            bestFrameBuffer = _glResourceManager->create<FrameBuffer>(_viewState.getWidth(), _viewState.getHeight(), true, depth, stencil);
+            _screenFrameBuffers.push_back(bestFrameBuffer);
+        }
+        return bestFrameBuffer;
+    }
+
     void MapRenderer::setZBuffering(bool enable) {
         glDepthMask(enable ? GL_TRUE : GL_FALSE);
     }
@@ -740,8 +991,8 @@ namespace carto {
         _billboardsChanged = true;
     }
 
-    void MapRenderer::vtLabelsChanged(const std::shared_ptr<Layer>& layer, bool delay) {
-        _vtLabelPlacementWorker->init(layer, delay ? VT_LABEL_PLACEMENT_TASK_DELAY : 0);
+    void MapRenderer::vtLabelsChanged(const std::shared_ptr<Layer>& layer, bool delay, bool tilesChanged) {
+        _vtLabelPlacementWorker->init(layer, delay ? VT_LABEL_PLACEMENT_TASK_DELAY : 0, tilesChanged);
     }
     
     void MapRenderer::layerChanged(const std::shared_ptr<Layer>& layer, bool delay) {
@@ -770,8 +1021,31 @@ namespace carto {
             onChangeListener->onMapChanged();
         }
         
+        _cameraChanged = true;
         requestRedraw();
     }
+
+    void MapRenderer::scheduleRedraw() const {
+        DirectorPtr<RedrawRequestListener> redrawRequestListener = _redrawRequestListener;
+        if (!redrawRequestListener) {
+            return;
+        }
+
+        // Select the target frame rate based on the activity: user interaction, content animations or background updates
+        float targetFPS = _options->getIdleFPS();
+        if (_cameraChanged) {
+            targetFPS = _options->getInteractionFPS();
+        } else if (_layersAnimating) {
+            targetFPS = _options->getAnimationFPS();
+        }
+
+        // Throttle the request, if the next frame is due later
+        if (_redrawWorker->init(targetFPS)) {
+            return;
+        }
+
+        redrawRequestListener->onRedrawRequested();
+    }
     
     void MapRenderer::registerOnChangeListener(const std::shared_ptr<OnChangeListener>& listener) {
         std::lock_guard<std::mutex> lock(_onChangeListenersMutex);
@@ -783,6 +1057,12 @@ namespace carto {
         _onChangeListeners.erase(std::remove(_onChangeListeners.begin(), _onChangeListeners.end(), listener), _onChangeListeners.end());
     }
 
+    void MapRenderer::setWorkersFrameSynchronous(bool enabled) {
+        _cullWorker->setFrameSynchronous(enabled);
+        _vtLabelPlacementWorker->setFrameSynchronous(enabled);
+        _billboardPlacementWorker->setFrameSynchronous(enabled);
+    }
+
     void MapRenderer::initializeRenderState() const {
         // Enable backface culling
         glEnable(GL_CULL_FACE);
@@ -812,6 +1092,8 @@ namespace carto {
     }
     
     void MapRenderer::drawLayers(float deltaSeconds, const ViewState& viewState) {
+        CARTO_TRACE_SECTION("MapRenderer::drawLayers");
+
         std::vector<std::shared_ptr<Layer> > layers = _layers->getAll();
 
         // Create new billboard sorter instance
@@ -824,17 +1106,20 @@ namespace carto {
 
         // Do base drawing pass
         bool needRedraw = false;
-        for (const std::shared_ptr<Layer>& layer : layers) {
+        for (std::size_t i = 0; i < layers.size(); i++) {
+            const std::shared_ptr<Layer>& layer = layers[i];
             if (viewState.getHorizontalLayerOffsetDir() != 0) {
                 layer->offsetLayerHorizontally(viewState.getHorizontalLayerOffsetDir() * Const::WORLD_SIZE);
             }
 
             needRedraw = layer->onDrawFrame(deltaSeconds, billboardSorter, viewState) || needRedraw;
+            _frameProfiler->endLayerPhase(static_cast<int>(i));
         }
         
         // Do 3D drawing pass
-        for (const std::shared_ptr<Layer>& layer : layers) {
-            needRedraw = layer->onDrawFrame3D(deltaSeconds, billboardSorter, viewState) || needRedraw;
+        for (std::size_t i = 0; i < layers.size(); i++) {
+            needRedraw = layers[i]->onDrawFrame3D(deltaSeconds, billboardSorter, viewState) || needRedraw;
+            _frameProfiler->endLayerPhase(static_cast<int>(i));
         }
         
         // Sort billboards, calculate rotation state
@@ -864,6 +1149,8 @@ namespace carto {
             glEnable(GL_DEPTH_TEST);
         }
 
+        _frameProfiler->endPhase("billboards");
+
         // Store the active billboard draw data list
         {
             std::lock_guard<std::recursive_mutex> lock(_mutex);
@@ -871,6 +1158,7 @@ namespace carto {
         }
     
         // Redraw, if needed
+        _layersAnimating = needRedraw;
         if (needRedraw) {
             requestRedraw();
         }
@@ -884,17 +1172,21 @@ namespace carto {
             height = _viewState.getHeight();
         }
         std::shared_ptr<Bitmap> captureBitmap;
+
+        // Complete the asynchronous readbacks of the previous frames first
+        handlePendingCaptures();
         
-        std::vector<std::pair<DirectorPtr<RendererCaptureListener>, bool> > rendererCaptureListeners;
+        std::vector<CaptureRequest> rendererCaptureListeners;
         {
             std::lock_guard<std::mutex> lock(_rendererCaptureListenersMutex);
             _rendererCaptureListeners.swap(rendererCaptureListeners);
         }
 
-        bool callbacksPending = false;
+        bool callbacksPending = !_pendingCaptures.empty();
+        std::vector<CaptureRequest> asyncRequests;
         for (std::size_t i = 0; i < rendererCaptureListeners.size(); i++) {
-            const DirectorPtr<RendererCaptureListener>& listener = rendererCaptureListeners[i].first;
-            bool waitWhileUpdating = rendererCaptureListeners[i].second;
+            const DirectorPtr<RendererCaptureListener>& listener = rendererCaptureListeners[i].listener;
+            bool waitWhileUpdating = rendererCaptureListeners[i].waitWhileUpdating;
             if (waitWhileUpdating) {
                 bool layersUpdating = false;
                 for (const std::shared_ptr<Layer>& layer : _layers->getAll()) {
@@ -910,6 +1202,11 @@ namespace carto {
                     continue;
                 }
             }
+
+            if (rendererCaptureListeners[i].async) {
+                asyncRequests.push_back(rendererCaptureListeners[i]);
+                continue;
+            }
             
             if (!captureBitmap) {
                 std::vector<unsigned char> data(4 * width * height);
@@ -919,11 +1216,62 @@ namespace carto {
             
             listener->onMapRendered(captureBitmap);
         }
+
+        // Start readback for asynchronous requests. Without pixel buffer objects only the bitmap creation is moved to the background thread.
+        if (!asyncRequests.empty()) {
+            std::size_t dataSize = 4 * width * height;
+            if (GLContext::PIXEL_BUFFER_OBJECT) {
+                PendingCapture pendingCapture { 0, nullptr, width, height, asyncRequests };
+                glGenBuffers(1, &pendingCapture.bufferId);
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, pendingCapture.bufferId);
+                glBufferData(GL_PIXEL_PACK_BUFFER, dataSize, nullptr, GL_STREAM_READ);
+                glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+                pendingCapture.sync = GLContext::FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                _pendingCaptures.push_back(std::move(pendingCapture));
+                callbacksPending = true;
+            } else {
+                std::vector<unsigned char> data(dataSize);
+                glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, &data[0]);
+                _captureThreadPool->execute(std::make_shared<CaptureBitmapTask>(std::move(data), width, height, asyncRequests));
+            }
+            GLContext::CheckGLError("MapRenderer::handleRendererCaptureCallbacks");
+        }
+
         if (callbacksPending) {
             requestRedraw();
         }
     }
 
+    void MapRenderer::handlePendingCaptures() {
+        for (auto it = _pendingCaptures.begin(); it != _pendingCaptures.end(); ) {
+            // Do not wait, check the fence again in the next frame
+            if (GLContext::ClientWaitSync(it->sync, 0, 0) == GL_TIMEOUT_EXPIRED) {
+                it++;
+                continue;
+            }
+
+            std::vector<unsigned char> data(4 * it->width * it->height);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, it->bufferId);
+            if (const void* mappedData = GLContext::MapBufferRange(GL_PIXEL_PACK_BUFFER, 0, data.size(), GL_MAP_READ_BIT)) {
+                std::memcpy(data.data(), mappedData, data.size());
+                GLContext::UnmapBuffer(GL_PIXEL_PACK_BUFFER);
+                _captureThreadPool->execute(std::make_shared<CaptureBitmapTask>(std::move(data), it->width, it->height, it->requests));
+            } else {
+                Log::Error("MapRenderer::handlePendingCaptures: Failed to map pixel buffer, capturing again");
+                std::lock_guard<std::mutex> lock(_rendererCaptureListenersMutex);
+                _rendererCaptureListeners.insert(_rendererCaptureListeners.end(), it->requests.begin(), it->requests.end());
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+            glDeleteBuffers(1, &it->bufferId);
+            GLContext::DeleteSync(it->sync);
+            it = _pendingCaptures.erase(it);
+        }
+
+        GLContext::CheckGLError("MapRenderer::handlePendingCaptures");
+    }
+
     MapRenderer::OptionsListener::OptionsListener(const std::shared_ptr<MapRenderer>& mapRenderer) : _mapRenderer(mapRenderer)
     {
     }
@@ -940,6 +1288,10 @@ namespace carto {
                 updateView = true;
             }
 
+            if (optionName == "FrameSynchronousScheduling") {
+                mapRenderer->setWorkersFrameSynchronous(mapRenderer->_options->isFrameSynchronousScheduling());
+            }
+
             if (optionName == "RenderProjectionMode" || optionName == "BaseProjection" || optionName == "ZoomRange" || optionName == "PanBounds" || optionName == "RestrictedPanning") {
                 std::lock_guard<std::recursive_mutex> lock(mapRenderer->_mutex);
                 mapRenderer->_viewState.calculateViewState(*mapRenderer->_options);
@@ -966,6 +1318,8 @@ namespace carto {
 
     const int MapRenderer::VT_LABEL_PLACEMENT_TASK_DELAY = 200;
 
+    const int MapRenderer::GL_RESOURCE_PROCESSING_BUDGET = 4;
+
     const std::string MapRenderer::BLEND_VERTEX_SHADER = R"GLSL(
         #version 100
         attribute vec2 a_coord;
@@ -20,7 +20,9 @@
 
 #include <atomic>
 #include <chrono>
+#include <map>
 #include <memory>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -31,6 +33,7 @@ namespace carto {
     class CameraZoomEvent;
     class Bitmap;
     class BillboardDrawData;
+    class CancelableThreadPool;
     class Layer;
     class Layers;
     class MapRendererListener;
@@ -42,19 +45,30 @@ namespace carto {
     class CullWorker;
     class VTLabelPlacementWorker;
     class BillboardPlacementWorker;
+    class RedrawWorker;
     class FrameBuffer;
     class Shader;
     class Texture;
     class GLResourceManager;
+    class FrameProfiler;
 
     /**
      * The map renderer component.
      */
     class MapRenderer : public std::enable_shared_from_this<MapRenderer> {
     public:
+        struct GPUMemoryStatistics {
+            GPUMemoryStatistics() : totalUsage(0), categoryUsage(), layerUsage() { }
+
+            std::size_t totalUsage; // total GPU memory reported by the graphics resources of the renderer
+            std::map<std::string, std::size_t> categoryUsage; // categories are named "texture", "framebuffer", "vertexbuffer", "tile" and "model"
+            std::map<std::string, std::size_t> layerUsage; // layers are named "layer <index>", layers not owning resources are not included
+        };
+
         struct OnChangeListener {
             virtual ~OnChangeListener() { }
             
+            virtual void onBeforeDrawFrame() { }
             virtual void onMapChanged() = 0;
             virtual void onMapIdle() = 0;
         };
@@ -104,16 +118,32 @@ namespace carto {
          * @param waitWhileUpdating If true, delay the capture until all asynchronous processes are finished (for example, until all tiles are loaded).
          */
         void captureRendering(const std::shared_ptr<RendererCaptureListener>& listener, bool waitWhileUpdating);
+        /**
+         * Captures map rendering as a bitmap without stalling the rendering. The pixels are read back asynchronously
+         * (using pixel buffer objects if OpenGL ES 3.0 is available) and the bitmap is created in a background thread.
+         * The listener is called from the background thread, usually a few frames after the capture.
+         * @param listener The listener interface that will receive the callback once rendering is available.
+         * @param waitWhileUpdating If true, delay the capture until all asynchronous processes are finished (for example, until all tiles are loaded).
+         * @param scale The size of the bitmap relative to the view size, in range (0..1]. Smaller values are useful for thumbnails.
+         * @throws std::invalid_argument If the scale is not in the valid range.
+         */
+        void captureRenderingAsync(const std::shared_ptr<RendererCaptureListener>& listener, bool waitWhileUpdating, float scale);
 
         std::shared_ptr<Layers> getLayers() const;
         
         std::shared_ptr<GLResourceManager> getGLResourceManager() const;
 
+        std::shared_ptr<FrameProfiler> getFrameProfiler() const;
+
+        GPUMemoryStatistics getGPUMemoryStatistics() const;
+
         std::vector<std::shared_ptr<BillboardDrawData> > getBillboardDrawDatas() const;
     
         AnimationHandler& getAnimationHandler();
         KineticEventHandler& getKineticEventHandler();
 
+        std::vector<ViewState> calculatePredictedViewStates(int stepCount) const;
+
         void calculateCameraEvent(CameraPanEvent& cameraEvent, float durationSeconds, bool updateKinetic);
         void calculateCameraEvent(CameraRotationEvent& cameraEvent, float durationSeconds, bool updateKinetic);
         void calculateCameraEvent(CameraTiltEvent& cameraEvent, float durationSeconds, bool updateKinetic);
@@ -135,9 +165,11 @@ namespace carto {
         void calculateRayIntersectedElements(const MapPos& targetPos, ViewState& viewState, std::vector<RayIntersectedElement>& results);
     
         void billboardsChanged();
-        void vtLabelsChanged(const std::shared_ptr<Layer>& layer, bool delay);
+        void vtLabelsChanged(const std::shared_ptr<Layer>& layer, bool delay, bool tilesChanged);
         void layerChanged(const std::shared_ptr<Layer>& layer, bool delay);
         void viewChanged(bool delay);
+
+        void scheduleRedraw() const;
     
         void registerOnChangeListener(const std::shared_ptr<OnChangeListener>& listener);
         void unregisterOnChangeListener(const std::shared_ptr<OnChangeListener>& listener);
@@ -153,14 +185,35 @@ namespace carto {
             std::weak_ptr<MapRenderer> _mapRenderer;
         };
 
+        struct CaptureRequest {
+            DirectorPtr<RendererCaptureListener> listener;
+            bool waitWhileUpdating;
+            bool async;
+            float scale;
+        };
+
+        struct PendingCapture {
+            GLuint bufferId;
+            void* sync;
+            int width;
+            int height;
+            std::vector<CaptureRequest> requests;
+        };
+
+        class CaptureBitmapTask;
+
+        void setWorkersFrameSynchronous(bool enabled);
+
         void initializeRenderState() const;
 
         void drawLayers(float deltaSeconds, const ViewState& viewState);
         
         void handleRendererCaptureCallbacks();
+        void handlePendingCaptures();
 
         static const int BILLBOARD_PLACEMENT_TASK_DELAY;
         static const int VT_LABEL_PLACEMENT_TASK_DELAY;
+        static const int GL_RESOURCE_PROCESSING_BUDGET;
 
         static const std::string BLEND_VERTEX_SHADER;
         static const std::string BLEND_FRAGMENT_SHADER;
@@ -171,6 +224,8 @@ namespace carto {
 
         std::shared_ptr<GLResourceManager> _glResourceManager;
 
+        const std::shared_ptr<FrameProfiler> _frameProfiler;
+
         std::shared_ptr<CullWorker> _cullWorker;
         std::thread _cullThread;
         
@@ -179,9 +234,19 @@ namespace carto {
         
         std::shared_ptr<OptionsListener> _optionsListener;
 
-        std::vector<std::pair<GLuint, GLuint> > _currentBoundFBOs;
+        struct BoundFBO {
+            GLuint prevFBOId;
+            GLuint bufferMask;
+            std::shared_ptr<FrameBuffer> frameBuffer;
 
-        std::shared_ptr<FrameBuffer> _screenFrameBuffer;
+            BoundFBO(GLuint prevFBOId, GLuint bufferMask, const std::shared_ptr<FrameBuffer>& frameBuffer) : prevFBOId(prevFBOId), bufferMask(bufferMask), frameBuffer(frameBuffer) { }
+        };
+
+        std::shared_ptr<FrameBuffer> acquireScreenFrameBuffer(bool depth, bool stencil);
+
+        std::vector<BoundFBO> _currentBoundFBOs;
+
+        std::vector<std::shared_ptr<FrameBuffer> > _screenFrameBuffers;
         std::shared_ptr<Shader> _screenBlendShader;
         
         BackgroundRenderer _backgroundRenderer;
@@ -191,6 +256,9 @@ namespace carto {
         std::vector<std::shared_ptr<BillboardDrawData> > _billboardDrawDataBuffer;
         std::shared_ptr<BillboardPlacementWorker> _billboardPlacementWorker;
         std::thread _billboardPlacementThread;
+
+        std::shared_ptr<RedrawWorker> _redrawWorker;
+        std::thread _redrawThread;
     
         AnimationHandler _animationHandler;
         KineticEventHandler _kineticEventHandler;
@@ -202,13 +270,18 @@ namespace carto {
         mutable std::atomic<bool> _surfaceChanged;
         mutable std::atomic<bool> _billboardsChanged;
         mutable std::atomic<bool> _redrawPending;
+        std::atomic<bool> _drawingFrame; // redraw requests during the frame are scheduled once the frame is finished
+        std::atomic<bool> _cameraChanged; // camera was moved by user or by an animation since the start of the frame
+        std::atomic<bool> _layersAnimating; // layers requested the next frame for their animations
 
         ThreadSafeDirectorPtr<RedrawRequestListener> _redrawRequestListener;
 
         ThreadSafeDirectorPtr<MapRendererListener> _mapRendererListener;
 
-        std::vector<std::pair<DirectorPtr<RendererCaptureListener>, bool> > _rendererCaptureListeners;
+        std::vector<CaptureRequest> _rendererCaptureListeners;
         mutable std::mutex _rendererCaptureListenersMutex;
+        std::vector<PendingCapture> _pendingCaptures; // readbacks in progress, accessed only from the GL thread
+        std::shared_ptr<CancelableThreadPool> _captureThreadPool;
 
         std::vector<std::shared_ptr<OnChangeListener> > _onChangeListeners;
         mutable std::mutex _onChangeListenersMutex;
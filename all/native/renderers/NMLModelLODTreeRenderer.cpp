@@ -16,6 +16,10 @@
 #include <nml/GLTexture.h>
 #include <nml/GLResourceManager.h>
 
+#include <algorithm>
+#include <chrono>
+#include <set>
+
 namespace carto {
 
     NMLModelLODTreeRenderer::NMLModelLODTreeRenderer() :
@@ -77,14 +81,34 @@ namespace carto {
         MapPos internalFocusPos = viewState.getProjectionSurface()->calculateMapPos(viewState.getFocusPos());
         cglib::vec3<float> mainLightDir = cglib::vec3<float>::convert(cglib::unit(viewState.getProjectionSurface()->calculateVector(internalFocusPos, optionsMainLightDirection)));
 
-        // Create new models
+        // Create new models, coarser levels first. Stop when the frame budget is spent, remaining models are created in the following frames.
         cglib::mat4x4<float> projMat = cglib::mat4x4<float>::convert(viewState.getProjectionMat());
+        std::vector<std::pair<int, ModelNodeDrawRecord*> > createRecords;
         for (auto it = _drawRecordMap.begin(); it != _drawRecordMap.end(); it++) {
             ModelNodeDrawRecord& record = *it->second;
             if (!(record.used && !record.created)) {
                 continue;
             }
-    
+
+            int depth = 0;
+            for (ModelNodeDrawRecord* parentRecord = record.parent; parentRecord; parentRecord = parentRecord->parent) {
+                depth++;
+            }
+            createRecords.emplace_back(depth, &record);
+        }
+        std::stable_sort(createRecords.begin(), createRecords.end(), [](const std::pair<int, ModelNodeDrawRecord*>& record1, const std::pair<int, ModelNodeDrawRecord*>& record2) {
+            return record1.first < record2.first;
+        });
+
+        bool refresh = false;
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(MODEL_CREATION_BUDGET);
+        for (std::size_t i = 0; i < createRecords.size(); i++) {
+            if (i > 0 && std::chrono::steady_clock::now() >= deadline) {
+                refresh = true;
+                break;
+            }
+
+            ModelNodeDrawRecord& record = *createRecords[i].second;
             record.drawData.getGLModel()->create(*resourceManager);
 
             record.created = true;
@@ -107,6 +131,18 @@ namespace carto {
                 }
             }
         }
+
+        // If a model is not used but created then also keep it if one of its children is used but not created yet, so that the area is not left empty
+        for (auto it = _drawRecordMap.begin(); it != _drawRecordMap.end(); it++) {
+            ModelNodeDrawRecord& record = *it->second;
+            if (!(!record.used && record.created)) {
+                continue;
+            }
+
+            if (HasPendingChildren(record)) {
+                record.used = true;
+            }
+        }
     
         // Draw nodes if they do not have parents that are also used/created
         for (auto it = _drawRecordMap.begin(); it != _drawRecordMap.end(); it++) {
@@ -152,14 +188,24 @@ namespace carto {
             _drawRecordMap.erase(it++);
         }
     
-        // Release unused resources
+        // Release unused resources, report the size of the created models. Models may be shared between the nodes.
         resourceManager->deleteUnused();
+
+        std::set<std::shared_ptr<nml::GLModel> > createdModels;
+        std::size_t modelSize = 0;
+        for (auto it = _drawRecordMap.begin(); it != _drawRecordMap.end(); it++) {
+            const ModelNodeDrawRecord& record = *it->second;
+            if (record.created && createdModels.insert(record.drawData.getGLModel()).second) {
+                modelSize += record.drawData.getGLModel()->getTotalGeometrySize();
+            }
+        }
+        _nmlResources->setModelMemoryUsage(modelSize);
         
         // Restore expected GL state
         glDepthMask(GL_FALSE);
         glActiveTexture(GL_TEXTURE0);
 
-        return false;
+        return refresh;
     }
 
     void NMLModelLODTreeRenderer::addDrawData(const std::shared_ptr<NMLModelLODTreeDrawData>& drawData) {
@@ -205,6 +251,11 @@ namespace carto {
         _tempDrawDatas.clear();
     }
     
+    std::size_t NMLModelLODTreeRenderer::getGPUMemoryUsage() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _nmlResources ? _nmlResources->getGPUMemoryUsage() : 0;
+    }
+    
     void NMLModelLODTreeRenderer::calculateRayIntersectedElements(const std::shared_ptr<NMLModelLODTreeLayer>& layer, const cglib::ray3<double>& ray, const ViewState& viewState, std::vector<RayIntersectedElement>& results) const {
         std::lock_guard<std::mutex> lock(_mutex);
     
@@ -239,6 +290,18 @@ namespace carto {
         }
     }
 
+    bool NMLModelLODTreeRenderer::HasPendingChildren(const ModelNodeDrawRecord& record) {
+        for (const ModelNodeDrawRecord* childRecord : record.children) {
+            if (childRecord->used && !childRecord->created) {
+                return true;
+            }
+            if (!childRecord->used && HasPendingChildren(*childRecord)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     bool NMLModelLODTreeRenderer::initializeRenderer() {
         if (_nmlResources && _nmlResources->isValid()) {
             return true;
@@ -251,6 +314,8 @@ namespace carto {
         return _nmlResources && _nmlResources->isValid();
     }
 
+    const int NMLModelLODTreeRenderer::MODEL_CREATION_BUDGET = 4;
+
 }
 
 #endif
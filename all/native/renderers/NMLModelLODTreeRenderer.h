@@ -50,6 +50,8 @@ namespace carto {
         void addDrawData(const std::shared_ptr<NMLModelLODTreeDrawData>& drawData);
         void refreshDrawData();
 
+        std::size_t getGPUMemoryUsage() const;
+
         void calculateRayIntersectedElements(const std::shared_ptr<NMLModelLODTreeLayer>& layer, const cglib::ray3<double>& ray, const ViewState& viewState, std::vector<RayIntersectedElement>& results) const;
     
     protected:
@@ -63,6 +65,10 @@ namespace carto {
             ModelNodeDrawRecord(const NMLModelLODTreeDrawData& drawData) : drawData(drawData), parent(0), children(), used(false), created(false) { }
         };
 
+        static const int MODEL_CREATION_BUDGET;
+
+        static bool HasPendingChildren(const ModelNodeDrawRecord& record);
+
         bool initializeRenderer();
     
         std::weak_ptr<MapRenderer> _mapRenderer;
@@ -84,35 +84,50 @@ namespace carto {
         MapPos internalFocusPos = viewState.getProjectionSurface()->calculateMapPos(viewState.getFocusPos());
         cglib::vec3<float> mainLightDir = cglib::vec3<float>::convert(cglib::unit(viewState.getProjectionSurface()->calculateVector(internalFocusPos, optionsMainLightDirection)));
 
-        // Draw models
-        cglib::mat4x4<float> projMat = cglib::mat4x4<float>::convert(viewState.getProjectionMat());
+        // Group elements by source model, so that repeated models share a single GL model lookup and consecutive draws use the same buffers and textures
+        std::map<std::shared_ptr<nml::Model>, std::vector<std::shared_ptr<NMLModelDrawData> > > modelDrawDatas;
         for (const std::shared_ptr<NMLModel>& element : _elements) {
-            const NMLModelDrawData& drawData = *element->getDrawData();
+            std::shared_ptr<NMLModelDrawData> drawData = element->getDrawData();
+            modelDrawDatas[drawData->getSourceModel()].push_back(drawData);
+        }
 
-            Color drawDataColor = drawData.getColor();
-            cglib::vec4<float> modelColor = cglib::vec4<float>(drawDataColor.getR(), drawDataColor.getG(), drawDataColor.getB(), drawDataColor.getA()) * (1.0f / 255.0f);
-            std::shared_ptr<nml::Model> sourceModel = drawData.getSourceModel();
-            std::shared_ptr<nml::GLModel> glModel = _nmlModelMap[sourceModel];
+        // Draw models, skip instances outside of the view frustum
+        cglib::mat4x4<float> projMat = cglib::mat4x4<float>::convert(viewState.getProjectionMat());
+        for (auto it = modelDrawDatas.begin(); it != modelDrawDatas.end(); it++) {
+            const std::shared_ptr<nml::Model>& sourceModel = it->first;
+            std::shared_ptr<nml::GLModel>& glModel = _nmlModelMap[sourceModel];
             if (!glModel) {
                 glModel = std::make_shared<nml::GLModel>(*sourceModel);
                 glModel->create(*resourceManager);
-                _nmlModelMap[sourceModel] = glModel;
             }
-    
-            cglib::mat4x4<float> mvMat = cglib::mat4x4<float>::convert(viewState.getModelviewMat() * drawData.getLocalMat());
-            nml::RenderState renderState(projMat, mvMat, cglib::pointwise_product(ambientLightColor, modelColor), cglib::pointwise_product(mainLightColor, modelColor), -mainLightDir);
+            cglib::bbox3<double> modelBounds = cglib::bbox3<double>::convert(glModel->getBounds());
+
+            for (const std::shared_ptr<NMLModelDrawData>& drawData : it->second) {
+                if (!viewState.getFrustum().inside(cglib::transform_bbox(modelBounds, drawData->getLocalMat()))) {
+                    continue;
+                }
+
+                Color drawDataColor = drawData->getColor();
+                cglib::vec4<float> modelColor = cglib::vec4<float>(drawDataColor.getR(), drawDataColor.getG(), drawDataColor.getB(), drawDataColor.getA()) * (1.0f / 255.0f);
 
-            glModel->draw(*resourceManager, renderState);
+                cglib::mat4x4<float> mvMat = cglib::mat4x4<float>::convert(viewState.getModelviewMat() * drawData->getLocalMat());
+                nml::RenderState renderState(projMat, mvMat, cglib::pointwise_product(ambientLightColor, modelColor), cglib::pointwise_product(mainLightColor, modelColor), -mainLightDir);
+
+                glModel->draw(*resourceManager, renderState);
+            }
         }
 
-        // Remove stale models
+        // Remove stale models, report the size of the remaining models
+        std::size_t modelSize = 0;
         for (auto it = _nmlModelMap.begin(); it != _nmlModelMap.end(); ) {
             if (it->first.expired()) {
                 it = _nmlModelMap.erase(it);
             } else {
+                modelSize += it->second->getTotalGeometrySize();
                 it++;
             }
         }
+        _nmlResources->setModelMemoryUsage(modelSize);
 
         // Dispose unused models
         resourceManager->deleteUnused();
@@ -26,13 +26,20 @@ namespace carto {
         _coordBuf(),
         _indexBuf(),
         _texCoordBuf(),
+        _instanceBuf(),
         _textureCache(),
         _shader(),
+        _instanced(false),
         _a_color(0),
         _a_coord(0),
         _a_texCoord(0),
+        _a_corner(0),
+        _a_center(0),
+        _a_xAxis(0),
+        _a_yAxis(0),
         _u_mvpMat(0),
         _u_tex(0),
+        _u_texCoordScale(0),
         _mutex()
     {
     }
@@ -216,6 +223,58 @@ namespace carto {
         }
     }
     
+    void PointRenderer::BuildAndDrawInstances(GLuint a_color,
+                                              GLuint a_center,
+                                              GLuint a_xAxis,
+                                              GLuint a_yAxis,
+                                              std::vector<unsigned char>& colorBuf,
+                                              std::vector<float>& instanceBuf,
+                                              std::vector<std::shared_ptr<PointDrawData> >& drawDataBuffer,
+                                              const ViewState& viewState)
+    {
+        // Resize the buffers, if necessary. Only the quad center and axes are stored per point, the corners are shared.
+        if (instanceBuf.size() < drawDataBuffer.size() * 9) {
+            instanceBuf.resize(drawDataBuffer.size() * 9);
+        }
+        if (colorBuf.size() < drawDataBuffer.size() * 4) {
+            colorBuf.resize(drawDataBuffer.size() * 4);
+        }
+
+        // Calculate instance attributes
+        cglib::vec3<double> cameraPos = viewState.getCameraPos();
+        for (std::size_t i = 0; i < drawDataBuffer.size(); i++) {
+            const std::shared_ptr<PointDrawData>& drawData = drawDataBuffer[i];
+
+            float coordScale = drawData->getSize() * viewState.getUnitToDPCoef() * 0.5f;
+            cglib::vec3<float> translate = cglib::vec3<float>::convert(drawData->getPos() - cameraPos);
+            cglib::vec3<float> dx = drawData->getXAxis() * coordScale;
+            cglib::vec3<float> dy = drawData->getYAxis() * coordScale;
+
+            std::size_t instanceIndex = i * 9;
+            for (int j = 0; j < 3; j++) {
+                instanceBuf[instanceIndex + 0 + j] = translate(j);
+                instanceBuf[instanceIndex + 3 + j] = dx(j);
+                instanceBuf[instanceIndex + 6 + j] = dy(j);
+            }
+
+            const Color& color = drawData->getColor();
+            std::size_t colorIndex = i * 4;
+            colorBuf[colorIndex + 0] = color.getR();
+            colorBuf[colorIndex + 1] = color.getG();
+            colorBuf[colorIndex + 2] = color.getB();
+            colorBuf[colorIndex + 3] = color.getA();
+        }
+
+        // Draw all points with a single call
+        if (!drawDataBuffer.empty()) {
+            glVertexAttribPointer(a_center, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 9, instanceBuf.data() + 0);
+            glVertexAttribPointer(a_xAxis, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 9, instanceBuf.data() + 3);
+            glVertexAttribPointer(a_yAxis, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 9, instanceBuf.data() + 6);
+            glVertexAttribPointer(a_color, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, colorBuf.data());
+            GLContext::DrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, INSTANCE_INDICES, static_cast<GLsizei>(drawDataBuffer.size()));
+        }
+    }
+    
     bool PointRenderer::FindElementRayIntersection(const std::shared_ptr<VectorElement>& element,
                                                    const std::shared_ptr<PointDrawData>& drawData,
                                                    const std::shared_ptr<VectorLayer>& layer,
@@ -268,14 +327,30 @@ namespace carto {
         if (auto mapRenderer = _mapRenderer.lock()) {
             _textureCache = mapRenderer->getGLResourceManager()->create<BitmapTextureCache>(TEXTURE_CACHE_SIZE);
 
-            _shader = mapRenderer->getGLResourceManager()->create<Shader>("point", POINT_VERTEX_SHADER, POINT_FRAGMENT_SHADER);
+            // Draw points as instanced quads if supported, otherwise build the quads on the CPU
+            _instanced = GLContext::INSTANCED_ARRAYS;
+            if (_instanced) {
+                _shader = mapRenderer->getGLResourceManager()->create<Shader>("point_instanced", POINT_INSTANCED_VERTEX_SHADER, POINT_FRAGMENT_SHADER);
+
+                // Get shader variables locations
+                _a_color = _shader->getAttribLoc("a_color");
+                _a_corner = _shader->getAttribLoc("a_corner");
+                _a_center = _shader->getAttribLoc("a_center");
+                _a_xAxis = _shader->getAttribLoc("a_xAxis");
+                _a_yAxis = _shader->getAttribLoc("a_yAxis");
+                _u_mvpMat = _shader->getUniformLoc("u_mvpMat");
+                _u_tex = _shader->getUniformLoc("u_tex");
+                _u_texCoordScale = _shader->getUniformLoc("u_texCoordScale");
+            } else {
+                _shader = mapRenderer->getGLResourceManager()->create<Shader>("point", POINT_VERTEX_SHADER, POINT_FRAGMENT_SHADER);
     
-            // Get shader variables locations
-            _a_color = _shader->getAttribLoc("a_color");
-            _a_coord = _shader->getAttribLoc("a_coord");
-            _a_texCoord = _shader->getAttribLoc("a_texCoord");
-            _u_mvpMat = _shader->getUniformLoc("u_mvpMat");
-            _u_tex = _shader->getUniformLoc("u_tex");
+                // Get shader variables locations
+                _a_color = _shader->getAttribLoc("a_color");
+                _a_coord = _shader->getAttribLoc("a_coord");
+                _a_texCoord = _shader->getAttribLoc("a_texCoord");
+                _u_mvpMat = _shader->getUniformLoc("u_mvpMat");
+                _u_tex = _shader->getUniformLoc("u_tex");
+            }
        }
 
        return _shader && _shader->isValid() && _textureCache && _textureCache->isValid();
@@ -290,6 +365,20 @@ namespace carto {
         // Matrix
         const cglib::mat4x4<float>& mvpMat = viewState.getRTEModelviewProjectionMat();
         glUniformMatrix4fv(_u_mvpMat, 1, GL_FALSE, mvpMat.data());
+        if (_instanced) {
+            // Shared quad corners, per-point centers, axes and colors
+            glEnableVertexAttribArray(_a_corner);
+            glVertexAttribPointer(_a_corner, 2, GL_FLOAT, GL_FALSE, 0, INSTANCE_CORNERS);
+            glEnableVertexAttribArray(_a_center);
+            glEnableVertexAttribArray(_a_xAxis);
+            glEnableVertexAttribArray(_a_yAxis);
+            glEnableVertexAttribArray(_a_color);
+            GLContext::VertexAttribDivisor(_a_center, 1);
+            GLContext::VertexAttribDivisor(_a_xAxis, 1);
+            GLContext::VertexAttribDivisor(_a_yAxis, 1);
+            GLContext::VertexAttribDivisor(_a_color, 1);
+            return;
+        }
         // Coords, texCoords, colors
         glEnableVertexAttribArray(_a_coord);
         glEnableVertexAttribArray(_a_texCoord);
@@ -297,6 +386,19 @@ namespace carto {
     }
     
     void PointRenderer::unbind() {
+        if (_instanced) {
+            // Reset the divisors, other renderers use the same attribute slots for per-vertex data
+            GLContext::VertexAttribDivisor(_a_center, 0);
+            GLContext::VertexAttribDivisor(_a_xAxis, 0);
+            GLContext::VertexAttribDivisor(_a_yAxis, 0);
+            GLContext::VertexAttribDivisor(_a_color, 0);
+            glDisableVertexAttribArray(_a_corner);
+            glDisableVertexAttribArray(_a_center);
+            glDisableVertexAttribArray(_a_xAxis);
+            glDisableVertexAttribArray(_a_yAxis);
+            glDisableVertexAttribArray(_a_color);
+            return;
+        }
         // Disable bound arrays
         glDisableVertexAttribArray(_a_coord);
         glDisableVertexAttribArray(_a_texCoord);
@@ -332,8 +434,14 @@ namespace carto {
         glBindTexture(GL_TEXTURE_2D, texture->getTexId());
         
         // Draw the draw datas
-        BuildAndDrawBuffers(_a_color, _a_coord, _a_texCoord, _colorBuf, _coordBuf, _indexBuf, _texCoordBuf, _drawDataBuffer,
-                            texture->getTexCoordScale(), viewState);
+        if (_instanced) {
+            const cglib::vec2<float>& texCoordScale = texture->getTexCoordScale();
+            glUniform2f(_u_texCoordScale, texCoordScale(0), texCoordScale(1));
+            BuildAndDrawInstances(_a_color, _a_center, _a_xAxis, _a_yAxis, _colorBuf, _instanceBuf, _drawDataBuffer, viewState);
+        } else {
+            BuildAndDrawBuffers(_a_color, _a_coord, _a_texCoord, _colorBuf, _coordBuf, _indexBuf, _texCoordBuf, _drawDataBuffer,
+                                texture->getTexCoordScale(), viewState);
+        }
 
         _drawDataBuffer.clear();
         _prevBitmap = nullptr;
@@ -369,6 +477,27 @@ namespace carto {
         }
     )GLSL";
 
+    const std::string PointRenderer::POINT_INSTANCED_VERTEX_SHADER = R"GLSL(
+        #version 100
+        attribute vec2 a_corner;
+        attribute vec3 a_center;
+        attribute vec3 a_xAxis;
+        attribute vec3 a_yAxis;
+        attribute vec4 a_color;
+        varying vec2 v_texCoord;
+        varying vec4 v_color;
+        uniform mat4 u_mvpMat;
+        uniform vec2 u_texCoordScale;
+        void main() {
+            v_texCoord = (a_corner + vec2(1.0, 1.0)) * 0.5 * u_texCoordScale;
+            v_color = a_color;
+            gl_Position = u_mvpMat * vec4(a_center + a_xAxis * a_corner.x + a_yAxis * a_corner.y, 1.0);
+        }
+    )GLSL";
+
+    const float PointRenderer::INSTANCE_CORNERS[] = { -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f, -1.0f };
+    const unsigned short PointRenderer::INSTANCE_INDICES[] = { 0, 1, 2, 1, 3, 2 };
+
     const unsigned int PointRenderer::TEXTURE_CACHE_SIZE = 8 * 1024 * 1024;
 
 }
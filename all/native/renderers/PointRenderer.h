@@ -62,6 +62,15 @@ namespace carto {
                                         std::vector<std::shared_ptr<PointDrawData> >& drawDataBuffer,
                                         const cglib::vec2<float>& texCoordScale,
                                         const ViewState& viewState);
+
+        static void BuildAndDrawInstances(GLuint a_color,
+                                          GLuint a_center,
+                                          GLuint a_xAxis,
+                                          GLuint a_yAxis,
+                                          std::vector<unsigned char>& colorBuf,
+                                          std::vector<float>& instanceBuf,
+                                          std::vector<std::shared_ptr<PointDrawData> >& drawDataBuffer,
+                                          const ViewState& viewState);
         
         static bool FindElementRayIntersection(const std::shared_ptr<VectorElement>& element,
                                                const std::shared_ptr<PointDrawData>& drawData,
@@ -80,6 +89,10 @@ namespace carto {
     
         static const std::string POINT_VERTEX_SHADER;
         static const std::string POINT_FRAGMENT_SHADER;
+        static const std::string POINT_INSTANCED_VERTEX_SHADER;
+
+        static const float INSTANCE_CORNERS[];
+        static const unsigned short INSTANCE_INDICES[];
 
         static const unsigned int TEXTURE_CACHE_SIZE;
         
@@ -95,14 +108,21 @@ namespace carto {
         std::vector<float> _coordBuf;
         std::vector<unsigned short> _indexBuf;
         std::vector<float> _texCoordBuf;
+        std::vector<float> _instanceBuf;
     
         std::shared_ptr<BitmapTextureCache> _textureCache;
         std::shared_ptr<Shader> _shader;
+        bool _instanced;
         GLuint _a_color;
         GLuint _a_coord;
         GLuint _a_texCoord;
+        GLuint _a_corner;
+        GLuint _a_center;
+        GLuint _a_xAxis;
+        GLuint _a_yAxis;
         GLuint _u_mvpMat;
         GLuint _u_tex;
+        GLuint _u_texCoordScale;
     
         mutable std::mutex _mutex;
     };
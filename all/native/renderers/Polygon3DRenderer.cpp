@@ -9,11 +9,15 @@
 #include "renderers/components/RayIntersectedElement.h"
 #include "renderers/utils/Shader.h"
 #include "renderers/utils/GLResourceManager.h"
+#include "renderers/utils/VertexBuffer.h"
 #include "utils/Const.h"
 #include "utils/Log.h"
 #include "vectorelements/Polygon3D.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <limits>
+#include <unordered_map>
 
 #include <cglib/mat.h>
 
@@ -24,11 +28,9 @@ namespace carto {
         _mapRenderer(),
         _elements(),
         _tempElements(),
-        _drawDataBuffer(),
-        _colorBuf(),
-        _attribBuf(),
-        _coordBuf(),
-        _normalBuf(),
+        _chunks(),
+        _chunkGLResourceManager(),
+        _chunksDirty(false),
         _shader(),
         _a_color(0),
         _a_attrib(0),
@@ -60,6 +62,13 @@ namespace carto {
         for (const std::shared_ptr<Polygon3D>& element : _elements) {
             element->getDrawData()->offsetHorizontally(offset);
         }
+
+        // Chunk vertices are relative to the chunk origin, so only the origin needs to be moved
+        for (const std::shared_ptr<Chunk>& chunk : _chunks) {
+            chunk->origin(0) += offset;
+            chunk->bounds.min(0) += offset;
+            chunk->bounds.max(0) += offset;
+        }
     }
     
     void Polygon3DRenderer::onDrawFrame(float deltaSeconds, const ViewState& viewState) {
@@ -79,6 +88,10 @@ namespace carto {
         if (!initializeRenderer()) {
             return;
         }
+
+        if (_chunksDirty) {
+            updateChunks();
+        }
         
         // Enable depth test
         glDepthMask(GL_TRUE);
@@ -102,17 +115,15 @@ namespace carto {
         MapPos internalFocusPos = viewState.getProjectionSurface()->calculateMapPos(viewState.getFocusPos());
         cglib::vec3<float> mainLightDir = cglib::vec3<float>::convert(cglib::unit(viewState.getProjectionSurface()->calculateVector(internalFocusPos, options->getMainLightDirection())));
         glUniform3fv(_u_lightDir, 1, mainLightDir.data());
-        // Matrix
-        const cglib::mat4x4<float>& mvpMat = viewState.getRTEModelviewProjectionMat();
-        glUniformMatrix4fv(_u_mvpMat, 1, GL_FALSE, mvpMat.data());
     
-        // Draw
-        _drawDataBuffer.clear();
-        for (const std::shared_ptr<Polygon3D>& element : _elements) {
-            std::shared_ptr<Polygon3DDrawData> drawData = element->getDrawData();
-            _drawDataBuffer.push_back(std::move(drawData));
+        // Draw chunks inside the view frustum
+        for (const std::shared_ptr<Chunk>& chunk : _chunks) {
+            if (!viewState.getFrustum().inside(chunk->bounds)) {
+                continue;
+            }
+            drawChunk(*chunk, viewState);
         }
-        drawBatch(viewState);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
         
         // Disable depth test
         glDepthMask(GL_FALSE);
@@ -133,9 +144,11 @@ namespace carto {
     }
     
     void Polygon3DRenderer::refreshElements() {
+        // Called from the layer worker thread, so the vertex data of new chunks is built here and not in the render thread
         std::lock_guard<std::mutex> lock(_mutex);
         _elements.clear();
         _elements.swap(_tempElements);
+        updateChunks();
     }
         
     void Polygon3DRenderer::updateElement(const std::shared_ptr<Polygon3D>& element) {
@@ -145,11 +158,13 @@ namespace carto {
                 _elements.push_back(element);
             }
         }
+        updateChunks();
     }
     
     void Polygon3DRenderer::removeElement(const std::shared_ptr<Polygon3D>& element) {
         std::lock_guard<std::mutex> lock(_mutex);
         _elements.erase(std::remove(_elements.begin(), _elements.end(), element), _elements.end());
+        updateChunks();
     }
     
     void Polygon3DRenderer::calculateRayIntersectedElements(const std::shared_ptr<VectorLayer>& layer, const cglib::ray3<double>& ray, const ViewState& viewState, std::vector<RayIntersectedElement>& results) const {
@@ -178,102 +193,6 @@ namespace carto {
         }
     }
     
-    void Polygon3DRenderer::BuildAndDrawBuffers(GLuint a_color,
-                                                GLuint a_attrib,
-                                                GLuint a_coord,
-                                                GLuint a_normal,
-                                                std::vector<unsigned char>& colorBuf,
-                                                std::vector<unsigned char>& attribBuf,
-                                                std::vector<float>& coordBuf,
-                                                std::vector<float>& normalBuf,
-                                                std::vector<std::shared_ptr<Polygon3DDrawData> >& drawDataBuffer,
-                                                const ViewState& viewState)
-    {
-        // Calculate buffer size
-        std::size_t totalCoordCount = 0;
-        for (const std::shared_ptr<Polygon3DDrawData>& drawData : drawDataBuffer) {
-            totalCoordCount += drawData->getCoords().size();
-        }
-    
-        // Resize the buffers, if necessary
-        if (colorBuf.size() < totalCoordCount * 4) {
-            colorBuf.resize(std::min(totalCoordCount * 4, GLContext::MAX_VERTEXBUFFER_SIZE * 4));
-            attribBuf.resize(std::min(totalCoordCount * 1, GLContext::MAX_VERTEXBUFFER_SIZE * 1));
-            coordBuf.resize(std::min(totalCoordCount * 3, GLContext::MAX_VERTEXBUFFER_SIZE * 3));
-            normalBuf.resize(std::min(totalCoordCount * 3, GLContext::MAX_VERTEXBUFFER_SIZE * 3));
-        }
-    
-        // View state specific data
-        cglib::vec3<double> cameraPos = viewState.getCameraPos();
-        std::size_t coordIndex = 0;
-        for (std::size_t i = 0; i < drawDataBuffer.size(); i++) {
-            const std::shared_ptr<Polygon3DDrawData>& drawData = drawDataBuffer[i];
-            
-            const std::vector<cglib::vec3<double> >& coords = drawData->getCoords();
-            if (coords.size() > GLContext::MAX_VERTEXBUFFER_SIZE) {
-                Log::Error("Polygon3DRenderer::BuildAndDrawBuffers: Maximum buffer size exceeded, 3d polygon can't be drawn");
-                continue;
-            }
-    
-            // Check for possible overflow in the buffers
-            if (coordIndex + coords.size() > GLContext::MAX_VERTEXBUFFER_SIZE) {
-                // If it doesn't fit, stop and draw the buffers
-                glVertexAttribPointer(a_color, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, colorBuf.data());
-                glVertexAttribPointer(a_attrib, 1, GL_UNSIGNED_BYTE, GL_FALSE, 0, attribBuf.data());
-                glVertexAttribPointer(a_coord, 3, GL_FLOAT, GL_FALSE, 0, coordBuf.data());
-                glVertexAttribPointer(a_normal, 3, GL_FLOAT, GL_FALSE, 0, normalBuf.data());
-                glDrawArrays(GL_TRIANGLES, 0, coordIndex);
-                // Start filling buffers from the beginning
-                coordIndex = 0;
-            }
-    
-            // Coords and colors
-            const Color& color = drawData->getColor();
-            const Color& sideColor = drawData->getSideColor();
-            const std::vector<cglib::vec3<float> >& normals = drawData->getNormals();
-            const std::vector<unsigned char>& attribs = drawData->getAttribs();
-            std::vector<cglib::vec3<double> >::const_iterator cit = coords.begin();
-            std::vector<cglib::vec3<float> >::const_iterator nit = normals.begin();
-            std::vector<unsigned char>::const_iterator ait = attribs.begin();
-            for (; cit != coords.end() && nit != normals.end(); ++cit, ++nit, ait++) {
-                if (*ait) {
-                    colorBuf[coordIndex * 4 + 0] = color.getR();
-                    colorBuf[coordIndex * 4 + 1] = color.getG();
-                    colorBuf[coordIndex * 4 + 2] = color.getB();
-                    colorBuf[coordIndex * 4 + 3] = color.getA();
-                    attribBuf[coordIndex] = 1;
-                } else {
-                    colorBuf[coordIndex * 4 + 0] = sideColor.getR();
-                    colorBuf[coordIndex * 4 + 1] = sideColor.getG();
-                    colorBuf[coordIndex * 4 + 2] = sideColor.getB();
-                    colorBuf[coordIndex * 4 + 3] = sideColor.getA();
-                    attribBuf[coordIndex] = 0;
-                }
-
-                const cglib::vec3<double>& coord = *cit;
-                coordBuf[coordIndex * 3 + 0] = static_cast<float>(coord(0) - cameraPos(0));
-                coordBuf[coordIndex * 3 + 1] = static_cast<float>(coord(1) - cameraPos(1));
-                coordBuf[coordIndex * 3 + 2] = static_cast<float>(coord(2) - cameraPos(2));
-                
-                const cglib::vec3<float>& normal = *nit;
-                normalBuf[coordIndex * 3 + 0] = normal(0);
-                normalBuf[coordIndex * 3 + 1] = normal(1);
-                normalBuf[coordIndex * 3 + 2] = normal(2);
-
-                coordIndex++;
-            }
-        }
-    
-        // Draw the buffers
-        if (coordIndex > 0) {
-            glVertexAttribPointer(a_color, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, colorBuf.data());
-            glVertexAttribPointer(a_attrib, 1, GL_UNSIGNED_BYTE, GL_FALSE, 0, attribBuf.data());
-            glVertexAttribPointer(a_coord, 3, GL_FLOAT, GL_FALSE, 0, coordBuf.data());
-            glVertexAttribPointer(a_normal, 3, GL_FLOAT, GL_FALSE, 0, normalBuf.data());
-            glDrawArrays(GL_TRIANGLES, 0, coordIndex);
-        }
-    }
-        
     bool Polygon3DRenderer::initializeRenderer() {
         if (_shader && _shader->isValid()) {
             return true;
@@ -291,16 +210,186 @@ namespace carto {
             _u_lightColor = _shader->getUniformLoc("u_lightColor");
             _u_lightDir = _shader->getUniformLoc("u_lightDir");
             _u_mvpMat = _shader->getUniformLoc("u_mvpMat");
+
+            // Vertex buffers of the old context are not usable anymore
+            _chunks.clear();
+            _chunksDirty = true;
         }
 
         return _shader && _shader->isValid();
     }
     
-    void Polygon3DRenderer::drawBatch(const ViewState& viewState) {
-        // Draw the draw datas, multiple passes may be necessary
-        BuildAndDrawBuffers(_a_color, _a_attrib, _a_coord, _a_normal, _colorBuf, _attribBuf, _coordBuf, _normalBuf, _drawDataBuffer, viewState);
+    void Polygon3DRenderer::updateChunks() {
+        std::shared_ptr<GLResourceManager> glResourceManager;
+        if (auto mapRenderer = _mapRenderer.lock()) {
+            glResourceManager = mapRenderer->getGLResourceManager();
+        }
+        if (!glResourceManager) {
+            _chunksDirty = true;
+            return;
+        }
+        if (_chunkGLResourceManager.lock() != glResourceManager) {
+            _chunks.clear();
+            _chunkGLResourceManager = glResourceManager;
+        }
+
+        // Find elements that are not stored in any chunk with their current draw data
+        std::unordered_map<const Polygon3D*, const Polygon3DDrawData*> pendingDrawDatas;
+        for (const std::shared_ptr<Polygon3D>& element : _elements) {
+            pendingDrawDatas[element.get()] = element->getDrawData().get();
+        }
+
+        std::vector<std::shared_ptr<Chunk> > chunks;
+        std::vector<std::shared_ptr<Chunk> > sparseChunks;
+        for (const std::shared_ptr<Chunk>& chunk : _chunks) {
+            chunk->activeVertexCount = 0;
+            for (ChunkElement& chunkElement : chunk->elements) {
+                auto it = pendingDrawDatas.find(chunkElement.element.get());
+                chunkElement.active = (it != pendingDrawDatas.end() && it->second == chunkElement.drawData.get());
+                if (chunkElement.active) {
+                    pendingDrawDatas.erase(it);
+                    chunk->activeVertexCount += chunkElement.vertexCount;
+                }
+            }
+            if (chunk->activeVertexCount * 2 < MAX_CHUNK_VERTEX_COUNT) {
+                sparseChunks.push_back(chunk);
+            } else {
+                chunks.push_back(chunk);
+            }
+        }
+
+        // Merge sparse chunks with the new elements, unless there is a single fully active chunk and nothing to add
+        if (sparseChunks.size() == 1 && sparseChunks.front()->activeVertexCount == sparseChunks.front()->vertexCount && pendingDrawDatas.empty()) {
+            chunks.push_back(sparseChunks.front());
+        } else {
+            for (const std::shared_ptr<Chunk>& chunk : sparseChunks) {
+                for (const ChunkElement& chunkElement : chunk->elements) {
+                    if (chunkElement.active) {
+                        pendingDrawDatas[chunkElement.element.get()] = chunkElement.drawData.get();
+                    }
+                }
+            }
+        }
+
+        // Pack the remaining elements into new chunks, in element order
+        std::vector<ChunkElement> chunkElements;
+        std::size_t vertexCount = 0;
+        for (const std::shared_ptr<Polygon3D>& element : _elements) {
+            auto it = pendingDrawDatas.find(element.get());
+            if (it == pendingDrawDatas.end()) {
+                continue;
+            }
+            pendingDrawDatas.erase(it);
+
+            std::shared_ptr<Polygon3DDrawData> drawData = element->getDrawData();
+            if (!drawData || drawData->getCoords().empty()) {
+                continue;
+            }
+
+            std::size_t elementVertexCount = drawData->getCoords().size();
+            if (vertexCount > 0 && vertexCount + elementVertexCount > MAX_CHUNK_VERTEX_COUNT) {
+                chunks.push_back(buildChunk(glResourceManager, std::move(chunkElements), vertexCount));
+                chunkElements.clear();
+                vertexCount = 0;
+            }
+            chunkElements.push_back(ChunkElement { element, drawData, vertexCount, elementVertexCount, true });
+            vertexCount += elementVertexCount;
+        }
+        if (!chunkElements.empty()) {
+            chunks.push_back(buildChunk(glResourceManager, std::move(chunkElements), vertexCount));
+        }
+
+        std::swap(_chunks, chunks);
+        _chunksDirty = false;
     }
 
+    std::shared_ptr<Polygon3DRenderer::Chunk> Polygon3DRenderer::buildChunk(const std::shared_ptr<GLResourceManager>& glResourceManager, std::vector<ChunkElement>&& chunkElements, std::size_t vertexCount) const {
+        auto chunk = std::make_shared<Chunk>();
+        chunk->elements = std::move(chunkElements);
+        chunk->vertexCount = vertexCount;
+        chunk->activeVertexCount = vertexCount;
+
+        // Vertices are stored relative to the center of the chunk to keep float precision
+        chunk->bounds = cglib::bbox3<double>::smallest();
+        for (const ChunkElement& chunkElement : chunk->elements) {
+            chunk->bounds.add(chunkElement.drawData->getBoundingBox().min);
+            chunk->bounds.add(chunkElement.drawData->getBoundingBox().max);
+        }
+        chunk->origin = chunk->bounds.center();
+
+        std::vector<unsigned char> vertexData(vertexCount * sizeof(Vertex));
+        Vertex* vertex = reinterpret_cast<Vertex*>(vertexData.data());
+        for (const ChunkElement& chunkElement : chunk->elements) {
+            const Polygon3DDrawData& drawData = *chunkElement.drawData;
+            const Color& color = drawData.getColor();
+            const Color& sideColor = drawData.getSideColor();
+            const std::vector<cglib::vec3<double> >& coords = drawData.getCoords();
+            const std::vector<cglib::vec3<float> >& normals = drawData.getNormals();
+            const std::vector<unsigned char>& attribs = drawData.getAttribs();
+            for (std::size_t i = 0; i < coords.size(); i++, vertex++) {
+                const Color& vertexColor = (attribs[i] ? color : sideColor);
+                vertex->color[0] = vertexColor.getR();
+                vertex->color[1] = vertexColor.getG();
+                vertex->color[2] = vertexColor.getB();
+                vertex->color[3] = vertexColor.getA();
+                vertex->attrib = (attribs[i] ? 1 : 0);
+
+                cglib::vec3<double> coord = coords[i] - chunk->origin;
+                vertex->coord[0] = static_cast<float>(coord(0));
+                vertex->coord[1] = static_cast<float>(coord(1));
+                vertex->coord[2] = static_cast<float>(coord(2));
+
+                vertex->normal[0] = normals[i](0);
+                vertex->normal[1] = normals[i](1);
+                vertex->normal[2] = normals[i](2);
+            }
+        }
+
+        chunk->vertexBuffer = glResourceManager->create<VertexBuffer>(std::move(vertexData));
+        return chunk;
+    }
+
+    void Polygon3DRenderer::drawChunk(const Chunk& chunk, const ViewState& viewState) {
+        // If the buffer is not uploaded yet, draw from client memory
+        std::uintptr_t vertexData = 0;
+        if (chunk.vertexBuffer->getBufferId() != 0) {
+            glBindBuffer(GL_ARRAY_BUFFER, chunk.vertexBuffer->getBufferId());
+        } else {
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            vertexData = reinterpret_cast<std::uintptr_t>(chunk.vertexBuffer->getData().data());
+        }
+        glVertexAttribPointer(_a_color, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), reinterpret_cast<const GLvoid*>(vertexData + offsetof(Vertex, color)));
+        glVertexAttribPointer(_a_attrib, 1, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(Vertex), reinterpret_cast<const GLvoid*>(vertexData + offsetof(Vertex, attrib)));
+        glVertexAttribPointer(_a_coord, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<const GLvoid*>(vertexData + offsetof(Vertex, coord)));
+        glVertexAttribPointer(_a_normal, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<const GLvoid*>(vertexData + offsetof(Vertex, normal)));
+
+        cglib::vec3<float> originOffset = cglib::vec3<float>::convert(chunk.origin - viewState.getCameraPos());
+        cglib::mat4x4<float> mvpMat = viewState.getRTEModelviewProjectionMat() * cglib::translate4_matrix(originOffset);
+        glUniformMatrix4fv(_u_mvpMat, 1, GL_FALSE, mvpMat.data());
+
+        // Draw consecutive ranges of active elements with single calls
+        std::size_t firstVertex = 0;
+        std::size_t vertexCount = 0;
+        for (const ChunkElement& chunkElement : chunk.elements) {
+            if (chunkElement.active) {
+                if (vertexCount == 0) {
+                    firstVertex = chunkElement.vertexOffset;
+                }
+                vertexCount += chunkElement.vertexCount;
+                continue;
+            }
+            if (vertexCount > 0) {
+                glDrawArrays(GL_TRIANGLES, static_cast<GLint>(firstVertex), static_cast<GLsizei>(vertexCount));
+                vertexCount = 0;
+            }
+        }
+        if (vertexCount > 0) {
+            glDrawArrays(GL_TRIANGLES, static_cast<GLint>(firstVertex), static_cast<GLsizei>(vertexCount));
+        }
+    }
+
+    const std::size_t Polygon3DRenderer::MAX_CHUNK_VERTEX_COUNT = 65536;
+
     const std::string Polygon3DRenderer::POLYGON3D_VERTEX_SHADER = R"GLSL(
         #version 100
         attribute vec4 a_color;
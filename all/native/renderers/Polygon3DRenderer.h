@@ -14,6 +14,7 @@
 #include <mutex>
 #include <vector>
 
+#include <cglib/bbox.h>
 #include <cglib/ray.h>
 
 namespace carto {
@@ -21,7 +22,9 @@ namespace carto {
     class Polygon3DDrawData;
     class Options;
     class MapRenderer;
+    class GLResourceManager;
     class Shader;
+    class VertexBuffer;
     class RayIntersectedElement;
     class VectorLayer;
     class ViewState;
@@ -45,20 +48,40 @@ namespace carto {
         void calculateRayIntersectedElements(const std::shared_ptr<VectorLayer>& layer, const cglib::ray3<double>& ray, const ViewState& viewState, std::vector<RayIntersectedElement>& results) const;
     
     private:
-        static void BuildAndDrawBuffers(GLuint a_color,
-                                        GLuint a_attrib,
-                                        GLuint a_coord,
-                                        GLuint a_normal,
-                                        std::vector<unsigned char>& colorBuf,
-                                        std::vector<unsigned char>& attribBuf,
-                                        std::vector<float>& coordBuf,
-                                        std::vector<float>& normalBuf,
-                                        std::vector<std::shared_ptr<Polygon3DDrawData> >& drawDataBuffer,
-                                        const ViewState& viewState);
-        
+        struct Vertex {
+            float coord[3];
+            float normal[3];
+            unsigned char color[4];
+            unsigned char attrib;
+            unsigned char padding[3];
+        };
+
+        struct ChunkElement {
+            std::shared_ptr<Polygon3D> element;
+            std::shared_ptr<Polygon3DDrawData> drawData;
+            std::size_t vertexOffset;
+            std::size_t vertexCount;
+            bool active;
+        };
+
+        // Static vertex buffer shared by many elements. Elements that are removed or changed are only deactivated,
+        // their vertex ranges are skipped when drawing until the chunk is rebuilt.
+        struct Chunk {
+            cglib::vec3<double> origin;
+            cglib::bbox3<double> bounds;
+            std::vector<ChunkElement> elements;
+            std::size_t vertexCount;
+            std::size_t activeVertexCount;
+            std::shared_ptr<VertexBuffer> vertexBuffer;
+        };
+
         bool initializeRenderer();
-        void drawBatch(const ViewState& viewState);
+        void updateChunks();
+        std::shared_ptr<Chunk> buildChunk(const std::shared_ptr<GLResourceManager>& glResourceManager, std::vector<ChunkElement>&& chunkElements, std::size_t vertexCount) const;
+        void drawChunk(const Chunk& chunk, const ViewState& viewState);
         
+        static const std::size_t MAX_CHUNK_VERTEX_COUNT;
+
         static const std::string POLYGON3D_VERTEX_SHADER;
         static const std::string POLYGON3D_FRAGMENT_SHADER;
     
@@ -68,12 +91,9 @@ namespace carto {
         std::vector<std::shared_ptr<Polygon3D> > _elements;
         std::vector<std::shared_ptr<Polygon3D> > _tempElements;
         
-        std::vector<std::shared_ptr<Polygon3DDrawData> > _drawDataBuffer;
-    
-        std::vector<unsigned char> _colorBuf;
-        std::vector<unsigned char> _attribBuf;
-        std::vector<float> _coordBuf;
-        std::vector<float> _normalBuf;
+        std::vector<std::shared_ptr<Chunk> > _chunks;
+        std::weak_ptr<GLResourceManager> _chunkGLResourceManager;
+        bool _chunksDirty;
     
         std::shared_ptr<Shader> _shader;
         GLuint _a_color;
@@ -1,4 +1,5 @@
 #include "PolygonRenderer.h"
+#include "geometry/utils/PackedRTreeSpatialIndex.h"
 #include "graphics/Bitmap.h"
 #include "graphics/ViewState.h"
 #include "layers/VectorLayer.h"
@@ -12,6 +13,8 @@
 #include "utils/Log.h"
 #include "vectorelements/Polygon.h"
 
+#include <algorithm>
+
 #include <cglib/mat.h>
 
 namespace carto {
@@ -20,11 +23,10 @@ namespace carto {
         _mapRenderer(),
         _elements(),
         _tempElements(),
+        _spatialIndex(),
         _drawDataBuffer(),
         _prevBitmap(nullptr),
-        _colorBuf(),
-        _coordBuf(),
-        _indexBuf(),
+        _batchCache(),
         _shader(),
         _a_color(0),
         _a_coord(0),
@@ -43,6 +45,7 @@ namespace carto {
         _lineRenderer.setComponents(options, mapRenderer);
         _mapRenderer = mapRenderer;
         _shader.reset();
+        clearBatchCache();
     }
     
     void PolygonRenderer::offsetLayerHorizontally(double offset) {
@@ -54,6 +57,8 @@ namespace carto {
         }
 
         _lineRenderer.offsetLayerHorizontally(offset);
+        offsetBatchCache(offset);
+        _spatialIndex.reset();
     }
     
     void PolygonRenderer::onDrawFrame(float deltaSeconds, const ViewState& viewState) {
@@ -61,6 +66,7 @@ namespace carto {
         
         if (_elements.empty()) {
             // Early return, to avoid calling glUseProgram etc.
+            clearBatchCache();
             return;
         }
 
@@ -77,6 +83,7 @@ namespace carto {
             addToBatch(element->getDrawData(), viewState);
         }
         drawBatch(viewState);
+        pruneBatchCache();
         
         unbind();
 
@@ -95,6 +102,7 @@ namespace carto {
         std::lock_guard<std::mutex> lock(_mutex);
         _elements.clear();
         _elements.swap(_tempElements);
+        _spatialIndex.reset();
     }
         
     void PolygonRenderer::updateElement(const std::shared_ptr<Polygon>& element) {
@@ -104,108 +112,78 @@ namespace carto {
                 _elements.push_back(element);
             }
         }
+        // Batches with the previous draw data no longer match the drawn draw datas and are rebuilt or pruned
+        _spatialIndex.reset();
     }
     
     void PolygonRenderer::removeElement(const std::shared_ptr<Polygon>& element) {
         std::lock_guard<std::mutex> lock(_mutex);
         _elements.erase(std::remove(_elements.begin(), _elements.end(), element), _elements.end());
+        if (element->getDrawData()) {
+            removeCachedBatches(element->getDrawData().get());
+        }
+        _spatialIndex.reset();
     }
     
     void PolygonRenderer::calculateRayIntersectedElements(const std::shared_ptr<VectorLayer>& layer, const cglib::ray3<double>& ray, const ViewState& viewState, std::vector<RayIntersectedElement>& results) const {
         std::lock_guard<std::mutex> lock(_mutex);
-    
-        for (const std::shared_ptr<Polygon>& element : _elements) {
+
+        if (!_spatialIndex) {
+            buildSpatialIndex();
+        }
+
+        // Only test the elements whose bounds intersect the ray. Keep the original element order.
+        std::vector<int> elementIndices = _spatialIndex->query(ray, 0);
+        std::sort(elementIndices.begin(), elementIndices.end());
+        for (int elementIndex : elementIndices) {
+            const std::shared_ptr<Polygon>& element = _elements[elementIndex];
             FindElementRayIntersection(element, element->getDrawData(), layer, ray, viewState, results);
         }
     }
     
-    void PolygonRenderer::BuildAndDrawBuffers(GLuint a_color,
-                                              GLuint a_coord,
-                                              std::vector<unsigned char>& colorBuf,
-                                              std::vector<float>& coordBuf,
-                                              std::vector<unsigned short>& indexBuf,
-                                              std::vector<std::shared_ptr<PolygonDrawData> >& drawDataBuffer,
-                                              const ViewState& viewState)
+    void PolygonRenderer::BuildBatchSegments(const std::vector<std::shared_ptr<PolygonDrawData> >& drawDataBuffer,
+                                             const cglib::vec3<double>& origin,
+                                             std::vector<BatchSegment>& segments)
     {
-        // Calculate buffer size
-        std::size_t totalCoordCount = 0;
-        std::size_t totalIndexCount = 0;
-        for (const std::shared_ptr<PolygonDrawData>& drawData : drawDataBuffer) {
-            for (std::size_t i = 0; i < drawData->getCoords().size(); i++) {
-                const std::vector<cglib::vec3<double> >& coords = drawData->getCoords()[i];
-                const std::vector<unsigned int>& indices = drawData->getIndices()[i];
-                totalCoordCount += coords.size();
-                totalIndexCount += indices.size();
-            }
-        }
-    
-        // Resize the buffers, if necessary
-        if (coordBuf.size() < totalCoordCount * 3) {
-            colorBuf.resize(std::min(totalCoordCount * 4, GLContext::MAX_VERTEXBUFFER_SIZE * 4));
-            coordBuf.resize(std::min(totalCoordCount * 3, GLContext::MAX_VERTEXBUFFER_SIZE * 3));
-        }
-    
-        if (indexBuf.size() < totalIndexCount) {
-            indexBuf.resize(std::min(totalIndexCount, GLContext::MAX_VERTEXBUFFER_SIZE));
-        }
-    
-        // View state specific data
-        cglib::vec3<double> cameraPos = viewState.getCameraPos();
-        std::size_t colorIndex = 0;
-        std::size_t coordIndex = 0;
-        std::size_t indexIndex = 0;
+        segments.clear();
+        segments.emplace_back();
         for (const std::shared_ptr<PolygonDrawData>& drawData : drawDataBuffer) {
-            // Draw data vertex info may be split into multiple buffers, draw each one
+            // Draw data vertex info may be split into multiple buffers, add each one
             for (std::size_t i = 0; i < drawData->getCoords().size(); i++) {
-                // Check for possible overflow in the buffers
-                const std::vector<cglib::vec3<double> >& coords = drawData->getCoords()[i];
+                // Check for possible overflow in the segment
+                const std::vector<cglib::vec3<float> >& coords = drawData->getCoords()[i];
                 const std::vector<unsigned int>& indices = drawData->getIndices()[i];
                 if (indices.size() > GLContext::MAX_VERTEXBUFFER_SIZE) {
-                    Log::Error("PolygonRenderer::BuildAndDrawBuffers: Maximum buffer size exceeded, polygon can't be drawn");
+                    Log::Error("PolygonRenderer::BuildBatchSegments: Maximum buffer size exceeded, polygon can't be drawn");
                     continue;
                 }
-                if (indexIndex + indices.size() > GLContext::MAX_VERTEXBUFFER_SIZE) {
-                    // If it doesn't fit, stop and draw the buffers
-                    glVertexAttribPointer(a_coord, 3, GL_FLOAT, GL_FALSE, 0, coordBuf.data());
-                    glVertexAttribPointer(a_color, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, colorBuf.data());
-                    glDrawElements(GL_TRIANGLES, indexIndex, GL_UNSIGNED_SHORT, indexBuf.data());
-
-                    // Start filling buffers from the beginning
-                    colorIndex = 0;
-                    coordIndex = 0;
-                    indexIndex = 0;
+                if (segments.back().indexBuf.size() + indices.size() > GLContext::MAX_VERTEXBUFFER_SIZE) {
+                    // If it doesn't fit, start a new segment
+                    segments.emplace_back();
                 }
+                BatchSegment& segment = segments.back();
                 
                 // Indices
-                unsigned short indexOffset = static_cast<unsigned short>(coordIndex / 3); // invariant: indexOffset <= indexIndex
-                for (unsigned short index : indices) {
-                    indexBuf[indexIndex] = indexOffset + index;
-                    indexIndex++;
+                unsigned short indexOffset = static_cast<unsigned short>(segment.coordBuf.size() / 3); // invariant: indexOffset <= index count
+                for (unsigned int index : indices) {
+                    segment.indexBuf.push_back(static_cast<unsigned short>(indexOffset + index));
                 }
                 
-                // Colors and coords
+                // Colors and coords. Coords are relative to the draw data origin, translate them to the batch origin
                 const Color& color = drawData->getColor();
-                for (const cglib::vec3<double>& pos : coords) {
-                    colorBuf[colorIndex + 0] = color.getR();
-                    colorBuf[colorIndex + 1] = color.getG();
-                    colorBuf[colorIndex + 2] = color.getB();
-                    colorBuf[colorIndex + 3] = color.getA();
-                    colorIndex += 4;
+                cglib::vec3<double> delta = drawData->getOrigin() - origin;
+                for (const cglib::vec3<float>& pos : coords) {
+                    segment.colorBuf.push_back(color.getR());
+                    segment.colorBuf.push_back(color.getG());
+                    segment.colorBuf.push_back(color.getB());
+                    segment.colorBuf.push_back(color.getA());
                     
-                    coordBuf[coordIndex + 0] = static_cast<float>(pos(0) - cameraPos(0));
-                    coordBuf[coordIndex + 1] = static_cast<float>(pos(1) - cameraPos(1));
-                    coordBuf[coordIndex + 2] = static_cast<float>(pos(2) - cameraPos(2));
-                    coordIndex += 3;
+                    segment.coordBuf.push_back(static_cast<float>(pos(0) + delta(0)));
+                    segment.coordBuf.push_back(static_cast<float>(pos(1) + delta(1)));
+                    segment.coordBuf.push_back(static_cast<float>(pos(2) + delta(2)));
                 }
             }
         }
-        
-        // Draw buffers
-        if (indexIndex > 0) {
-            glVertexAttribPointer(a_color, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, colorBuf.data());
-            glVertexAttribPointer(a_coord, 3, GL_FLOAT, GL_FALSE, 0, coordBuf.data());
-            glDrawElements(GL_TRIANGLES, indexIndex, GL_UNSIGNED_SHORT, indexBuf.data());
-        }
     }
     
     bool PolygonRenderer::FindElementRayIntersection(const std::shared_ptr<VectorElement>& element,
@@ -221,13 +199,17 @@ namespace carto {
         }
         
         // Test triangles
+        const cglib::vec3<double>& origin = drawData->getOrigin();
         for (std::size_t i = 0; i < drawData->getCoords().size(); i++) {
-            const std::vector<cglib::vec3<double> >& coords = drawData->getCoords()[i];
+            const std::vector<cglib::vec3<float> >& coords = drawData->getCoords()[i];
             const std::vector<unsigned int>& indices = drawData->getIndices()[i];
             
             for (std::size_t i = 0; i < indices.size(); i += 3) {
+                cglib::vec3<double> p0 = origin + cglib::vec3<double>::convert(coords[indices[i + 0]]);
+                cglib::vec3<double> p1 = origin + cglib::vec3<double>::convert(coords[indices[i + 1]]);
+                cglib::vec3<double> p2 = origin + cglib::vec3<double>::convert(coords[indices[i + 2]]);
                 double t = 0;
-                if (cglib::intersect_triangle(coords[indices[i + 0]], coords[indices[i + 1]], coords[indices[i + 2]], ray, &t)) {
+                if (cglib::intersect_triangle(p0, p1, p2, ray, &t)) {
                     results.push_back(RayIntersectedElement(std::static_pointer_cast<VectorElement>(element), layer, ray(t), ray(t), layer->isZBuffering()));
                     return true;
                 }
@@ -236,6 +218,15 @@ namespace carto {
         return false;
     }
     
+    void PolygonRenderer::buildSpatialIndex() const {
+        std::vector<std::pair<cglib::bbox3<double>, int> > records;
+        records.reserve(_elements.size());
+        for (std::size_t i = 0; i < _elements.size(); i++) {
+            records.emplace_back(_elements[i]->getDrawData()->getBoundingBox(), static_cast<int>(i));
+        }
+        _spatialIndex = std::make_shared<PackedRTreeSpatialIndex<int> >(records);
+    }
+
     bool PolygonRenderer::initializeRenderer() {
         if (_shader && _shader->isValid() && _lineRenderer.initializeRenderer()) {
             return true;
@@ -309,13 +300,79 @@ namespace carto {
             return;
         }
 
-        // Build buffers and draw
-        BuildAndDrawBuffers(_a_color, _a_coord, _colorBuf, _coordBuf, _indexBuf, _drawDataBuffer, viewState);
+        // Use the cached vertex data if the batch has not changed since it was built, otherwise rebuild it.
+        // Also rebuild if the camera has moved too far from the batch origin relative to the view scale, as float vertex precision degrades with the distance.
+        auto it = _batchCache.find(_drawDataBuffer.front().get());
+        double maxOriginDistance = cglib::length(viewState.getCameraPos() - viewState.getFocusPos()) * MAX_BATCH_ORIGIN_DISTANCE_FACTOR;
+        if (it == _batchCache.end() || it->second.drawDatas != _drawDataBuffer || cglib::length(it->second.origin - viewState.getCameraPos()) > maxOriginDistance) {
+            if (_batchCache.size() >= MAX_CACHED_BATCHES) {
+                clearBatchCache();
+            }
+            CachedBatch& batch = _batchCache[_drawDataBuffer.front().get()];
+            batch.drawDatas = _drawDataBuffer;
+            batch.origin = viewState.getCameraPos();
+            BuildBatchSegments(_drawDataBuffer, batch.origin, batch.segments);
+            it = _batchCache.find(_drawDataBuffer.front().get());
+        }
+        CachedBatch& batch = it->second;
+        batch.used = true;
+
+        // Only the translation from the batch origin to the camera changes between frames
+        cglib::mat4x4<float> mvpMat = viewState.getRTEModelviewProjectionMat() * cglib::translate4_matrix(cglib::vec3<float>::convert(batch.origin - viewState.getCameraPos()));
+        glUniformMatrix4fv(_u_mvpMat, 1, GL_FALSE, mvpMat.data());
+
+        for (const BatchSegment& segment : batch.segments) {
+            if (segment.indexBuf.empty()) {
+                continue;
+            }
+            glVertexAttribPointer(_a_color, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, segment.colorBuf.data());
+            glVertexAttribPointer(_a_coord, 3, GL_FLOAT, GL_FALSE, 0, segment.coordBuf.data());
+            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(segment.indexBuf.size()), GL_UNSIGNED_SHORT, segment.indexBuf.data());
+        }
         
         _drawDataBuffer.clear();
         _prevBitmap = nullptr;
     }
     
+    void PolygonRenderer::offsetBatchCache(double offset) {
+        // Batch vertices are relative to the batch origin, so moving the origin moves the whole batch without rebuilding it
+        for (auto it = _batchCache.begin(); it != _batchCache.end(); it++) {
+            it->second.origin(0) += offset;
+        }
+    }
+
+    void PolygonRenderer::removeCachedBatches(const PolygonDrawData* drawData) {
+        for (auto it = _batchCache.begin(); it != _batchCache.end(); ) {
+            const std::vector<std::shared_ptr<PolygonDrawData> >& drawDatas = it->second.drawDatas;
+            if (std::find_if(drawDatas.begin(), drawDatas.end(), [drawData](const std::shared_ptr<PolygonDrawData>& cachedDrawData) { return cachedDrawData.get() == drawData; }) != drawDatas.end()) {
+                it = _batchCache.erase(it);
+            } else {
+                it++;
+            }
+        }
+        for (const std::shared_ptr<LineDrawData>& lineDrawData : drawData->getLineDrawDatas()) {
+            _lineRenderer.removeCachedBatches(lineDrawData.get());
+        }
+    }
+
+    void PolygonRenderer::pruneBatchCache() {
+        // Drop the batches that were not drawn since the last pruning, keeping their draw datas alive is not needed
+        for (auto it = _batchCache.begin(); it != _batchCache.end(); ) {
+            if (!it->second.used) {
+                it = _batchCache.erase(it);
+            } else {
+                it->second.used = false;
+                it++;
+            }
+        }
+        _lineRenderer.pruneBatchCache();
+    }
+
+    void PolygonRenderer::clearBatchCache() {
+        _batchCache.clear();
+        _lineRenderer.clearBatchCache();
+    }
+
     const std::string PolygonRenderer::POLYGON_VERTEX_SHADER = R"GLSL(
         #version 100
         attribute vec4 a_coord;
@@ -340,4 +397,8 @@ namespace carto {
             gl_FragColor = color;
         }
     )GLSL";
+
+    const std::size_t PolygonRenderer::MAX_CACHED_BATCHES = 1024;
+    const double PolygonRenderer::MAX_BATCH_ORIGIN_DISTANCE_FACTOR = 16.0;
+
 }
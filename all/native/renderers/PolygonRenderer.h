@@ -7,13 +7,16 @@
 #ifndef _CARTO_POLYGONRENDERER_H_
 #define _CARTO_POLYGONRENDERER_H_
 
+#include "geometry/utils/SpatialIndex.h"
 #include "renderers/LineRenderer.h"
 
 #include <deque>
 #include <memory>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 
+#include <cglib/vec.h>
 #include <cglib/ray.h>
 
 namespace carto {
@@ -51,13 +54,22 @@ namespace carto {
         friend class GeometryCollectionRenderer;
 
     private:
-        static void BuildAndDrawBuffers(GLuint a_color,
-                                        GLuint a_coord,
-                                        std::vector<unsigned char>& colorBuf,
-                                        std::vector<float>& coordBuf,
-                                        std::vector<unsigned short>& indexBuf,
-                                        std::vector<std::shared_ptr<PolygonDrawData> >& drawDataBuffer,
-                                        const ViewState& viewState);
+        struct BatchSegment {
+            std::vector<unsigned char> colorBuf;
+            std::vector<float> coordBuf;
+            std::vector<unsigned short> indexBuf;
+        };
+
+        struct CachedBatch {
+            std::vector<std::shared_ptr<PolygonDrawData> > drawDatas;
+            cglib::vec3<double> origin; // vertex coordinates are relative to this point
+            std::vector<BatchSegment> segments;
+            bool used; // drawn since the last pruning
+        };
+
+        static void BuildBatchSegments(const std::vector<std::shared_ptr<PolygonDrawData> >& drawDataBuffer,
+                                       const cglib::vec3<double>& origin,
+                                       std::vector<BatchSegment>& segments);
         
         static bool FindElementRayIntersection(const std::shared_ptr<VectorElement>& element,
                                                const std::shared_ptr<PolygonDrawData>& drawData,
@@ -73,21 +85,29 @@ namespace carto {
         bool isEmptyBatch() const;
         void addToBatch(const std::shared_ptr<PolygonDrawData>& drawData, const ViewState& viewState);
         void drawBatch(const ViewState& viewState);
+        void offsetBatchCache(double offset);
+        void removeCachedBatches(const PolygonDrawData* drawData);
+        void pruneBatchCache();
+        void clearBatchCache();
+        void buildSpatialIndex() const;
     
         static const std::string POLYGON_VERTEX_SHADER;
         static const std::string POLYGON_FRAGMENT_SHADER;
+
+        static const std::size_t MAX_CACHED_BATCHES;
+        static const double MAX_BATCH_ORIGIN_DISTANCE_FACTOR;
         
         std::weak_ptr<MapRenderer> _mapRenderer;
 
         std::vector<std::shared_ptr<Polygon> > _elements;
         std::vector<std::shared_ptr<Polygon> > _tempElements;
+
+        mutable std::shared_ptr<SpatialIndex<int> > _spatialIndex; // element indices for click tests, built lazily, null if invalidated
         
         std::vector<std::shared_ptr<PolygonDrawData> > _drawDataBuffer;
         const Bitmap* _prevBitmap;
-    
-        std::vector<unsigned char> _colorBuf;
-        std::vector<float> _coordBuf;
-        std::vector<unsigned short> _indexBuf;
+
+        std::unordered_map<const PolygonDrawData*, CachedBatch> _batchCache; // built batches, keyed by the first draw data of the batch
     
         std::shared_ptr<Shader> _shader;
         GLuint _a_color;
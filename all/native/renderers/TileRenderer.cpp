@@ -31,6 +31,7 @@ namespace carto {
         _rasterFilterMode(vt::RasterFilterMode::BILINEAR),
         _normalMapShadowColor(0, 0, 0, 255),
         _normalMapHighlightColor(255, 255, 255, 255),
+        _normalMapContrast(1.0f),
         _horizontalLayerOffset(0),
         _viewDir(0, 0, 0),
         _mainLightDir(0, 0, 0),
@@ -97,6 +98,11 @@ namespace carto {
         _normalMapHighlightColor = color;
     }
 
+    void TileRenderer::setNormalMapContrast(float contrast) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _normalMapContrast = contrast;
+    }
+
     void TileRenderer::offsetLayerHorizontally(double offset) {
         std::lock_guard<std::mutex> lock(_mutex);
         _horizontalLayerOffset += offset;
@@ -223,9 +229,15 @@ namespace carto {
         }
         _tiles = std::move(tiles);
         _horizontalLayerOffset = 0;
+        updateTileMemoryUsage();
         return true;
     }
 
+    std::size_t TileRenderer::getGPUMemoryUsage() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _vtRenderer ? _vtRenderer->getGPUMemoryUsage() : 0;
+    }
+
     void TileRenderer::calculateRayIntersectedElements(const cglib::ray3<double>& ray, const ViewState& viewState, float radius, std::vector<vt::GLTileRenderer::GeometryIntersectionInfo>& results) const {
         std::lock_guard<std::mutex> lock(_mutex);
 
@@ -301,6 +313,8 @@ namespace carto {
         Log::Debug("TileRenderer: Initializing renderer");
         _vtRenderer = mapRenderer->getGLResourceManager()->create<VTRenderer>(_tileTransformer);
 
+        updateTileMemoryUsage();
+
         if (std::shared_ptr<vt::GLTileRenderer> tileRenderer = _vtRenderer->getTileRenderer()) {
             tileRenderer->setVisibleTiles(_tiles, _horizontalLayerOffset == 0);
 
@@ -327,6 +341,7 @@ namespace carto {
                 glUniform4f(glGetUniformLocation(shaderProgram, "u_shadowColor"), _normalMapShadowColor.getR() / 255.0f, _normalMapShadowColor.getG() / 255.0f, _normalMapShadowColor.getB() / 255.0f, _normalMapShadowColor.getA() / 255.0f);
                 glUniform4f(glGetUniformLocation(shaderProgram, "u_highlightColor"), _normalMapHighlightColor.getR() / 255.0f, _normalMapHighlightColor.getG() / 255.0f, _normalMapHighlightColor.getB() / 255.0f, _normalMapHighlightColor.getA() / 255.0f);
                 glUniform3fv(glGetUniformLocation(shaderProgram, "u_lightDir"), 1, _mainLightDir.data());
+                glUniform1f(glGetUniformLocation(shaderProgram, "u_contrast"), _normalMapContrast);
             });
             tileRenderer->setLightingShaderNormalMap(lightingShaderNormalMap);
         }
@@ -334,6 +349,22 @@ namespace carto {
         return _vtRenderer && _vtRenderer->isValid();
     }
 
+    void TileRenderer::updateTileMemoryUsage() {
+        // Note: _mutex must be locked by the caller
+        if (!_vtRenderer) {
+            return;
+        }
+
+        // The vertex buffers and textures of the tiles are roughly as large as the resident tile data
+        std::size_t size = 0;
+        for (auto it = _tiles.begin(); it != _tiles.end(); it++) {
+            if (it->second) {
+                size += it->second->getResidentSize();
+            }
+        }
+        _vtRenderer->setTileMemoryUsage(size);
+    }
+
     const std::string TileRenderer::LIGHTING_SHADER_2D = R"GLSL(
         uniform vec3 u_viewDir;
         vec4 applyLighting(lowp vec4 color, mediump vec3 normal) {
@@ -363,10 +394,11 @@ namespace carto {
         uniform vec4 u_shadowColor;
         uniform vec4 u_highlightColor;
         uniform vec3 u_lightDir;
+        uniform mediump float u_contrast;
         vec4 applyLighting(lowp vec4 color, mediump vec3 normal, mediump float intensity) {
             mediump float lighting = max(0.0, dot(normal, u_lightDir));
             lowp vec4 shadeColor = mix(u_shadowColor, u_highlightColor, lighting);
-            return shadeColor * color * intensity;
+            return shadeColor * color * (intensity * u_contrast);
         }
     )GLSL";
 
@@ -53,6 +53,7 @@ namespace carto {
         void setRasterFilterMode(vt::RasterFilterMode filterMode);
         void setNormalMapShadowColor(const Color& color);
         void setNormalMapHighlightColor(const Color& color);
+        void setNormalMapContrast(float contrast);
 
         void offsetLayerHorizontally(double offset);
     
@@ -63,12 +64,15 @@ namespace carto {
 
         bool refreshTiles(const std::vector<std::shared_ptr<TileDrawData> >& drawDatas);
 
+        std::size_t getGPUMemoryUsage() const;
+
         void calculateRayIntersectedElements(const cglib::ray3<double>& ray, const ViewState& viewState, float radius, std::vector<vt::GLTileRenderer::GeometryIntersectionInfo>& results) const;
         void calculateRayIntersectedElements3D(const cglib::ray3<double>& ray, const ViewState& viewState, float radius, std::vector<vt::GLTileRenderer::GeometryIntersectionInfo>& results) const;
         void calculateRayIntersectedBitmaps(const cglib::ray3<double>& ray, const ViewState& viewState, std::vector<vt::GLTileRenderer::BitmapIntersectionInfo>& results) const;
     
     private:
         bool initializeRenderer();
+        void updateTileMemoryUsage();
 
         static const std::string LIGHTING_SHADER_2D;
         static const std::string LIGHTING_SHADER_3D;
@@ -86,6 +90,7 @@ namespace carto {
         vt::RasterFilterMode _rasterFilterMode;
         Color _normalMapShadowColor;
         Color _normalMapHighlightColor;
+        float _normalMapContrast;
         double _horizontalLayerOffset;
         cglib::vec3<float> _viewDir;
         cglib::vec3<float> _mainLightDir;
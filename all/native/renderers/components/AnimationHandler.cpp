@@ -59,6 +59,15 @@ namespace carto {
         _panUseDelta = true;
     }
 
+    bool AnimationHandler::getPanTarget(MapPos& panTarget) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_panDurationSeconds <= 0 || _panUseDelta) {
+            return false;
+        }
+        panTarget = _panTarget;
+        return true;
+    }
+
     void AnimationHandler::stopPan() {
         std::lock_guard<std::mutex> lock(_mutex);
         _panDurationSeconds = 0;
@@ -102,6 +111,15 @@ namespace carto {
         _zoomDurationSeconds = durationSeconds;
     }
         
+    bool AnimationHandler::getZoomTarget(float& zoomTarget) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_zoomDurationSeconds <= 0) {
+            return false;
+        }
+        zoomTarget = _zoomTarget;
+        return true;
+    }
+
     void AnimationHandler::stopZoom() {
         std::lock_guard<std::mutex> lock(_mutex);
         _zoomDurationSeconds = 0;
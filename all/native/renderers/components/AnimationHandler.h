@@ -25,6 +25,7 @@ namespace carto {
     
         void setPanTarget(const MapPos& panTarget, float durationSeconds);
         void setPanDelta(const std::pair<MapPos, MapPos>& panDelta, float durationSeconds);
+        bool getPanTarget(MapPos& panTarget) const;
         void stopPan();
         
         void setRotationTarget(float rotationTarget, const MapPos* targetPos, float durationSeconds);
@@ -34,6 +35,7 @@ namespace carto {
         void stopTilt();
         
         void setZoomTarget(float zoomTarget, const MapPos* targetPos, float durationSeconds);
+        bool getZoomTarget(float& zoomTarget) const;
         void stopZoom();
     
     private:
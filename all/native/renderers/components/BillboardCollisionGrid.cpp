@@ -0,0 +1,121 @@
+#include "BillboardCollisionGrid.h"
+
+#include <algorithm>
+
+namespace carto {
+
+    BillboardCollisionGrid::BillboardCollisionGrid() :
+        _items(),
+        _cells(GRID_SIZE * GRID_SIZE),
+        _itemStamps(),
+        _stamp(0)
+    {
+    }
+
+    BillboardCollisionGrid::~BillboardCollisionGrid() {
+    }
+
+    void BillboardCollisionGrid::clear() {
+        _items.clear();
+        for (std::vector<int>& cell : _cells) {
+            cell.clear();
+        }
+        _itemStamps.clear();
+        _stamp = 0;
+    }
+
+    bool BillboardCollisionGrid::intersects(const Quad& quad) const {
+        cglib::vec2<float> min, max;
+        CalculateBounds(quad, min, max);
+
+        // Items covering multiple cells are tested only once per query
+        if (++_stamp == 0) {
+            std::fill(_itemStamps.begin(), _itemStamps.end(), 0);
+            _stamp = 1;
+        }
+
+        int x0 = GetCellIndex(min(0)), x1 = GetCellIndex(max(0));
+        int y0 = GetCellIndex(min(1)), y1 = GetCellIndex(max(1));
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                for (int itemIndex : _cells[y * GRID_SIZE + x]) {
+                    if (_itemStamps[itemIndex] == _stamp) {
+                        continue;
+                    }
+                    _itemStamps[itemIndex] = _stamp;
+
+                    const Item& item = _items[itemIndex];
+                    if (item.min(0) > max(0) || item.max(0) < min(0) || item.min(1) > max(1) || item.max(1) < min(1)) {
+                        continue;
+                    }
+                    if (IntersectQuads(item.quad, quad)) {
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    void BillboardCollisionGrid::insert(const Quad& quad) {
+        Item item;
+        item.quad = quad;
+        CalculateBounds(quad, item.min, item.max);
+
+        int itemIndex = static_cast<int>(_items.size());
+        _items.push_back(item);
+        _itemStamps.push_back(0);
+
+        int x0 = GetCellIndex(item.min(0)), x1 = GetCellIndex(item.max(0));
+        int y0 = GetCellIndex(item.min(1)), y1 = GetCellIndex(item.max(1));
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                _cells[y * GRID_SIZE + x].push_back(itemIndex);
+            }
+        }
+    }
+
+    void BillboardCollisionGrid::CalculateBounds(const Quad& quad, cglib::vec2<float>& min, cglib::vec2<float>& max) {
+        min = max = quad[0];
+        for (std::size_t i = 1; i < quad.size(); i++) {
+            min = cglib::vec2<float>(std::min(min(0), quad[i](0)), std::min(min(1), quad[i](1)));
+            max = cglib::vec2<float>(std::max(max(0), quad[i](0)), std::max(max(1), quad[i](1)));
+        }
+    }
+
+    bool BillboardCollisionGrid::IsSeparated(const Quad& quad1, const Quad& quad2) {
+        // Test the edge normals of the first quad as separating axes
+        for (std::size_t i = 0; i < quad1.size(); i++) {
+            const cglib::vec2<float>& p0 = quad1[i];
+            const cglib::vec2<float>& p1 = quad1[(i + 1) % quad1.size()];
+            cglib::vec2<float> axis(p0(1) - p1(1), p1(0) - p0(0));
+
+            float min1 = 0, max1 = 0, min2 = 0, max2 = 0;
+            for (std::size_t j = 0; j < quad1.size(); j++) {
+                float d1 = axis(0) * quad1[j](0) + axis(1) * quad1[j](1);
+                float d2 = axis(0) * quad2[j](0) + axis(1) * quad2[j](1);
+                min1 = (j == 0 ? d1 : std::min(min1, d1));
+                max1 = (j == 0 ? d1 : std::max(max1, d1));
+                min2 = (j == 0 ? d2 : std::min(min2, d2));
+                max2 = (j == 0 ? d2 : std::max(max2, d2));
+            }
+            if (max1 < min2 || max2 < min1) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool BillboardCollisionGrid::IntersectQuads(const Quad& quad1, const Quad& quad2) {
+        return !IsSeparated(quad1, quad2) && !IsSeparated(quad2, quad1);
+    }
+
+    int BillboardCollisionGrid::GetCellIndex(float coord) {
+        // Coordinates are in normalized device space, [-1..1] covers the screen
+        float pos = std::max(0.0f, std::min(1.0f, (coord + 1.0f) * 0.5f));
+        return std::min(GRID_SIZE - 1, static_cast<int>(pos * GRID_SIZE));
+    }
+
+    const int BillboardCollisionGrid::GRID_SIZE = 32;
+
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_BILLBOARDCOLLISIONGRID_H_
+#define _CARTO_BILLBOARDCOLLISIONGRID_H_
+
+#include <array>
+#include <vector>
+
+#include <cglib/vec.h>
+
+namespace carto {
+
+    /**
+     * Screen space collision index for billboard placement. The normalized screen area is divided into
+     * uniform cells, each inserted convex quad is registered in the cells covered by its bounding box.
+     * Quads outside the screen are clamped to the border cells.
+     */
+    class BillboardCollisionGrid {
+    public:
+        typedef std::array<cglib::vec2<float>, 4> Quad; // convex quad, vertices in winding order
+
+        BillboardCollisionGrid();
+        virtual ~BillboardCollisionGrid();
+
+        void clear();
+
+        bool intersects(const Quad& quad) const;
+        void insert(const Quad& quad);
+
+    private:
+        struct Item {
+            Quad quad;
+            cglib::vec2<float> min;
+            cglib::vec2<float> max;
+        };
+
+        static void CalculateBounds(const Quad& quad, cglib::vec2<float>& min, cglib::vec2<float>& max);
+        static bool IsSeparated(const Quad& quad1, const Quad& quad2);
+        static bool IntersectQuads(const Quad& quad1, const Quad& quad2);
+
+        static int GetCellIndex(float coord);
+
+        static const int GRID_SIZE;
+
+        std::vector<Item> _items;
+        std::vector<std::vector<int> > _cells;
+        mutable std::vector<unsigned int> _itemStamps;
+        mutable unsigned int _stamp;
+    };
+
+}
+
+#endif
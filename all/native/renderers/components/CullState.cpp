@@ -2,14 +2,30 @@
 #include "components/Exceptions.h"
 #include "projections/Projection.h"
 #include "projections/EPSG3857.h"
+#include "projections/SphericalProjectionSurface.h"
+#include "utils/Const.h"
 #include "utils/GeomUtils.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace carto {
     
     CullState::CullState(const MapEnvelope& envelope, const ViewState& viewState) :
         _envelope(envelope),
-        _viewState(viewState)
+        _viewState(viewState),
+        _horizonCulling(false),
+        _cameraDirection(0, 0, 0),
+        _horizonAngle(0)
     {
+        if (std::dynamic_pointer_cast<SphericalProjectionSurface>(viewState.getProjectionSurface())) {
+            double cameraDistance = cglib::length(viewState.getCameraPos());
+            if (cameraDistance > SPHERE_RADIUS) {
+                _horizonCulling = true;
+                _cameraDirection = viewState.getCameraPos() * (1.0 / cameraDistance);
+                _horizonAngle = std::acos(SPHERE_RADIUS / cameraDistance);
+            }
+        }
     }
         
     CullState::~CullState() {
@@ -45,5 +61,28 @@ namespace carto {
     const ViewState& CullState::getViewState() const {
         return _viewState;
     }
+
+    bool CullState::isHiddenByHorizon(const cglib::vec3<double>& center, double radius) const {
+        if (!_horizonCulling) {
+            return false;
+        }
+
+        double centerDistance = cglib::length(center);
+        if (centerDistance <= radius) {
+            return false;
+        }
+
+        // Surface points within the bounding sphere are inside a cone around the center direction, calculate its half-angle
+        double cosPartAngle = (SPHERE_RADIUS * SPHERE_RADIUS + centerDistance * centerDistance - radius * radius) / (2 * SPHERE_RADIUS * centerDistance);
+        if (cosPartAngle <= -1) {
+            return false;
+        }
+        double partAngle = std::acos(std::min(1.0, cosPartAngle));
+        double centerAngle = std::acos(std::max(-1.0, std::min(1.0, cglib::dot_product(center, _cameraDirection) / centerDistance)));
+        return centerAngle > partAngle + _horizonAngle + HORIZON_MARGIN_ANGLE;
+    }
+
+    const double CullState::SPHERE_RADIUS = Const::WORLD_SIZE / Const::PI;
+    const double CullState::HORIZON_MARGIN_ANGLE = 0.01;
     
 }
@@ -48,10 +48,26 @@ namespace carto {
          */
         const ViewState& getViewState() const;
 
+        /**
+         * Tests whether a part of the globe surface is hidden behind the horizon.
+         * Always returns false if the view does not use spherical projection surface.
+         * @param center The center of the bounding sphere of the surface part.
+         * @param radius The radius of the bounding sphere of the surface part.
+         * @return True if no point of the surface part inside the bounding sphere is visible from the camera.
+         */
+        bool isHiddenByHorizon(const cglib::vec3<double>& center, double radius) const;
+
     private:
+        static const double SPHERE_RADIUS;
+        static const double HORIZON_MARGIN_ANGLE; // allows 3D geometry on the far side to rise above the horizon
+
         MapEnvelope _envelope;
         
         ViewState _viewState;
+
+        bool _horizonCulling;
+        cglib::vec3<double> _cameraDirection;
+        double _horizonAngle; // angle between the camera direction and the horizon, as seen from the center of the globe
     };
     
 }
@@ -0,0 +1,231 @@
+#include "FrameProfiler.h"
+#include "renderers/utils/GLContext.h"
+
+#include <algorithm>
+
+namespace carto {
+
+    FrameProfiler::FrameProfiler() :
+        _enabled(false),
+        _frameActive(false),
+        _frameStartTime(),
+        _phaseStartTime(),
+        _framePhaseTimes(),
+        _freeGPUQueries(),
+        _pendingGPUQueries(),
+        _gpuQueryActive(false),
+        _frameBudget(DEFAULT_FRAME_BUDGET),
+        _frameCount(0),
+        _droppedFrameCount(0),
+        _frameTimes(),
+        _gpuFrameTimes(),
+        _phaseTimes(),
+        _mutex()
+    {
+    }
+
+    FrameProfiler::~FrameProfiler() {
+    }
+
+    bool FrameProfiler::isEnabled() const {
+        return _enabled.load();
+    }
+
+    void FrameProfiler::setEnabled(bool enabled) {
+        _enabled.store(enabled);
+    }
+
+    float FrameProfiler::getFrameBudget() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _frameBudget;
+    }
+
+    void FrameProfiler::setFrameBudget(float ms) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _frameBudget = ms;
+    }
+
+    FrameProfiler::Statistics FrameProfiler::getStatistics() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        Statistics statistics;
+        statistics.frameCount = _frameCount;
+        statistics.droppedFrameCount = _droppedFrameCount;
+        statistics.frameTime = CalculateStatistics(_frameTimes);
+        statistics.gpuFrameTime = CalculateStatistics(_gpuFrameTimes);
+        for (auto it = _phaseTimes.begin(); it != _phaseTimes.end(); it++) {
+            statistics.phaseTimes[it->first] = CalculateStatistics(it->second);
+        }
+        return statistics;
+    }
+
+    void FrameProfiler::reset() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _frameCount = 0;
+        _droppedFrameCount = 0;
+        _frameTimes.clear();
+        _gpuFrameTimes.clear();
+        _phaseTimes.clear();
+    }
+
+    void FrameProfiler::onSurfaceCreated() {
+        // Old queries are lost together with the context
+        _freeGPUQueries.clear();
+        _pendingGPUQueries.clear();
+        _gpuQueryActive = false;
+    }
+
+    void FrameProfiler::onSurfaceDestroyed() {
+        _freeGPUQueries.clear();
+        _pendingGPUQueries.clear();
+        _gpuQueryActive = false;
+    }
+
+    void FrameProfiler::beginFrame() {
+        if (!_enabled.load()) {
+            // Release the queries once profiling is disabled
+            if (!_freeGPUQueries.empty() || !_pendingGPUQueries.empty()) {
+                _freeGPUQueries.insert(_freeGPUQueries.end(), _pendingGPUQueries.begin(), _pendingGPUQueries.end());
+                GLContext::DeleteQueriesEXT(static_cast<GLsizei>(_freeGPUQueries.size()), _freeGPUQueries.data());
+                _freeGPUQueries.clear();
+                _pendingGPUQueries.clear();
+            }
+            return;
+        }
+
+        _frameActive = true;
+        _frameStartTime = _phaseStartTime = std::chrono::steady_clock::now();
+        _framePhaseTimes.clear();
+
+        if (GLContext::TIMER_QUERY) {
+            readGPUQueries();
+            beginGPUQuery();
+        }
+    }
+
+    void FrameProfiler::endPhase(const char* name) {
+        if (!_frameActive) {
+            return;
+        }
+        recordPhase(name);
+    }
+
+    void FrameProfiler::endLayerPhase(int layerIndex) {
+        if (!_frameActive) {
+            return;
+        }
+        recordPhase("layer " + std::to_string(layerIndex));
+    }
+
+    void FrameProfiler::endFrame() {
+        if (!_frameActive) {
+            return;
+        }
+        _frameActive = false;
+
+        if (_gpuQueryActive) {
+            endGPUQuery();
+        }
+
+        float frameTime = std::chrono::duration_cast<std::chrono::duration<float, std::milli> >(std::chrono::steady_clock::now() - _frameStartTime).count();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _frameCount++;
+        if (frameTime > _frameBudget) {
+            _droppedFrameCount++;
+        }
+        AddSample(_frameTimes, frameTime);
+        for (auto it = _framePhaseTimes.begin(); it != _framePhaseTimes.end(); it++) {
+            AddSample(_phaseTimes[it->first], it->second);
+        }
+    }
+
+    void FrameProfiler::recordPhase(const std::string& name) {
+        std::chrono::steady_clock::time_point currentTime = std::chrono::steady_clock::now();
+        _framePhaseTimes[name] += std::chrono::duration_cast<std::chrono::duration<float, std::milli> >(currentTime - _phaseStartTime).count();
+        _phaseStartTime = currentTime;
+    }
+
+    void FrameProfiler::beginGPUQuery() {
+#ifdef GL_EXT_disjoint_timer_query
+        // Results arrive with a latency of a few frames, skip the frame if all the queries are still pending
+        if (_freeGPUQueries.empty()) {
+            if (_pendingGPUQueries.size() >= MAX_GPU_QUERIES) {
+                return;
+            }
+            GLuint query = 0;
+            GLContext::GenQueriesEXT(1, &query);
+            if (query == 0) {
+                return;
+            }
+            _freeGPUQueries.push_back(query);
+        }
+
+        GLContext::BeginQueryEXT(GL_TIME_ELAPSED_EXT, _freeGPUQueries.back());
+        _pendingGPUQueries.push_back(_freeGPUQueries.back());
+        _freeGPUQueries.pop_back();
+        _gpuQueryActive = true;
+#endif
+    }
+
+    void FrameProfiler::endGPUQuery() {
+#ifdef GL_EXT_disjoint_timer_query
+        GLContext::EndQueryEXT(GL_TIME_ELAPSED_EXT);
+        _gpuQueryActive = false;
+#endif
+    }
+
+    void FrameProfiler::readGPUQueries() {
+#ifdef GL_EXT_disjoint_timer_query
+        // Disjoint operations (for example frequency changes) invalidate all pending results
+        GLint disjoint = 0;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+        while (!_pendingGPUQueries.empty()) {
+            GLuint query = _pendingGPUQueries.front();
+            GLuint available = 0;
+            GLContext::GetQueryObjectuivEXT(query, GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+            if (!available) {
+                break;
+            }
+            GLuint64 elapsed = 0;
+            GLContext::GetQueryObjectui64vEXT(query, GL_QUERY_RESULT_EXT, &elapsed);
+            _pendingGPUQueries.pop_front();
+            _freeGPUQueries.push_back(query);
+
+            if (!disjoint) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                AddSample(_gpuFrameTimes, static_cast<float>(elapsed / 1.0e6));
+            }
+        }
+#endif
+    }
+
+    void FrameProfiler::AddSample(Samples& samples, float sample) {
+        samples.push_back(sample);
+        if (samples.size() > MAX_SAMPLES) {
+            samples.pop_front();
+        }
+    }
+
+    FrameProfiler::TimingStatistics FrameProfiler::CalculateStatistics(const Samples& samples) {
+        TimingStatistics statistics;
+        if (samples.empty()) {
+            return statistics;
+        }
+
+        std::vector<float> sortedSamples(samples.begin(), samples.end());
+        std::sort(sortedSamples.begin(), sortedSamples.end());
+        statistics.p50 = sortedSamples[(sortedSamples.size() - 1) * 50 / 100];
+        statistics.p95 = sortedSamples[(sortedSamples.size() - 1) * 95 / 100];
+        statistics.max = sortedSamples.back();
+        statistics.sampleCount = static_cast<int>(sortedSamples.size());
+        return statistics;
+    }
+
+    const std::size_t FrameProfiler::MAX_SAMPLES = 300;
+
+    const std::size_t FrameProfiler::MAX_GPU_QUERIES = 4;
+
+    const float FrameProfiler::DEFAULT_FRAME_BUDGET = 1000.0f / 60.0f;
+
+}
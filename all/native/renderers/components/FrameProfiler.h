@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_FRAMEPROFILER_H_
+#define _CARTO_FRAMEPROFILER_H_
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <GLES2/gl2.h>
+
+namespace carto {
+
+    /**
+     * Opt-in frame profiler of the map renderer. Records CPU time of each rendering phase and layer and,
+     * if GL_EXT_disjoint_timer_query is supported, GPU time of the whole frame.
+     * Statistics are calculated over a rolling window of the latest frames.
+     */
+    class FrameProfiler {
+    public:
+        /**
+         * Rolling timing statistics, in milliseconds.
+         */
+        struct TimingStatistics {
+            TimingStatistics() : p50(0), p95(0), max(0), sampleCount(0) { }
+
+            float p50;
+            float p95;
+            float max;
+            int sampleCount;
+        };
+
+        /**
+         * Profiler statistics snapshot.
+         */
+        struct Statistics {
+            Statistics() : frameCount(0), droppedFrameCount(0), frameTime(), gpuFrameTime(), phaseTimes() { }
+
+            long long frameCount; // total number of profiled frames
+            long long droppedFrameCount; // total number of frames exceeding the frame budget
+            TimingStatistics frameTime; // CPU time of the frame
+            TimingStatistics gpuFrameTime; // GPU time of the frame, no samples if timer queries are not supported
+            std::map<std::string, TimingStatistics> phaseTimes; // CPU times per phase, layers are named "layer <index>"
+        };
+
+        FrameProfiler();
+        virtual ~FrameProfiler();
+
+        bool isEnabled() const;
+        void setEnabled(bool enabled);
+
+        float getFrameBudget() const;
+        void setFrameBudget(float ms);
+
+        Statistics getStatistics() const;
+        void reset();
+
+        // Called from GL thread by the map renderer
+        void onSurfaceCreated();
+        void onSurfaceDestroyed();
+
+        void beginFrame();
+        void endPhase(const char* name);
+        void endLayerPhase(int layerIndex);
+        void endFrame();
+
+    private:
+        typedef std::deque<float> Samples;
+
+        void recordPhase(const std::string& name);
+
+        void beginGPUQuery();
+        void endGPUQuery();
+        void readGPUQueries();
+
+        static void AddSample(Samples& samples, float sample);
+        static TimingStatistics CalculateStatistics(const Samples& samples);
+
+        static const std::size_t MAX_SAMPLES;
+        static const std::size_t MAX_GPU_QUERIES;
+        static const float DEFAULT_FRAME_BUDGET;
+
+        std::atomic<bool> _enabled;
+        bool _frameActive;
+        std::chrono::steady_clock::time_point _frameStartTime;
+        std::chrono::steady_clock::time_point _phaseStartTime;
+        std::map<std::string, float> _framePhaseTimes; // phase times accumulated over the current frame
+
+        std::vector<GLuint> _freeGPUQueries;
+        std::deque<GLuint> _pendingGPUQueries;
+        bool _gpuQueryActive;
+
+        float _frameBudget;
+        long long _frameCount;
+        long long _droppedFrameCount;
+        Samples _frameTimes;
+        Samples _gpuFrameTimes;
+        std::map<std::string, Samples> _phaseTimes;
+        mutable std::mutex _mutex; // for statistics
+    };
+
+}
+
+#endif
@@ -0,0 +1,45 @@
+#include "FrameSyncGate.h"
+
+namespace carto {
+
+    FrameSyncGate::FrameSyncGate() :
+        _enabled(false),
+        _frameInProgress(false),
+        _frameStartTime()
+    {
+    }
+
+    FrameSyncGate::~FrameSyncGate() {
+    }
+
+    bool FrameSyncGate::isEnabled() const {
+        return _enabled;
+    }
+
+    void FrameSyncGate::setEnabled(bool enabled) {
+        _enabled = enabled;
+    }
+
+    void FrameSyncGate::frameStarted() {
+        _frameInProgress = true;
+        _frameStartTime = std::chrono::steady_clock::now();
+    }
+
+    void FrameSyncGate::frameSubmitted() {
+        _frameInProgress = false;
+    }
+
+    std::chrono::steady_clock::duration FrameSyncGate::getHoldTime(const std::chrono::steady_clock::time_point& currentTime) const {
+        if (!_enabled || !_frameInProgress) {
+            return std::chrono::steady_clock::duration::zero();
+        }
+        std::chrono::steady_clock::time_point releaseTime = _frameStartTime + MAX_FRAME_WAIT;
+        if (releaseTime <= currentTime) {
+            return std::chrono::steady_clock::duration::zero();
+        }
+        return releaseTime - currentTime;
+    }
+
+    const std::chrono::milliseconds FrameSyncGate::MAX_FRAME_WAIT = std::chrono::milliseconds(100);
+
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_FRAMESYNCGATE_H_
+#define _CARTO_FRAMESYNCGATE_H_
+
+#include <chrono>
+
+namespace carto {
+
+    /**
+     * Frame synchronous scheduling state of a renderer worker. When enabled, work that becomes due
+     * while a frame is drawn is held back until the frame is submitted, so that worker results
+     * are produced in the idle window between frames. If the frame takes too long, the work is released anyway.
+     * The class is not thread safe, the owning worker must synchronize the access.
+     */
+    class FrameSyncGate {
+    public:
+        FrameSyncGate();
+        virtual ~FrameSyncGate();
+
+        bool isEnabled() const;
+        void setEnabled(bool enabled);
+
+        void frameStarted();
+        void frameSubmitted();
+
+        // Returns the time due work must still be held back, zero if it can be started now
+        std::chrono::steady_clock::duration getHoldTime(const std::chrono::steady_clock::time_point& currentTime) const;
+
+    private:
+        static const std::chrono::milliseconds MAX_FRAME_WAIT;
+
+        bool _enabled;
+        bool _frameInProgress;
+        std::chrono::steady_clock::time_point _frameStartTime;
+    };
+
+}
+
+#endif
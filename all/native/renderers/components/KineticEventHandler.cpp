@@ -67,6 +67,29 @@ namespace carto {
         }
     }
     
+    bool KineticEventHandler::calculatePanTarget(const ViewState& viewState, MapPos& panTarget) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_options.isKineticPan() || !_pan || _panDelta < KINETIC_PAN_STOP_TOLERANCE) {
+            return false;
+        }
+
+        // Sum the remaining per-frame deltas until panning stops, assuming a nominal frame rate
+        float factor = std::pow(1.0f - KINETIC_PAN_SLOWDOWN, PREDICTION_FRAME_SECONDS);
+        float panDelta = _panDelta;
+        float totalDelta = 0;
+        while (panDelta >= KINETIC_PAN_STOP_TOLERANCE) {
+            panDelta *= factor;
+            totalDelta += panDelta;
+        }
+
+        std::shared_ptr<ProjectionSurface> projectionSurface = _mapRenderer.getProjectionSurface();
+        cglib::vec3<double> pos0 = projectionSurface->calculatePosition(_panPositions.first);
+        cglib::vec3<double> pos1 = projectionSurface->calculatePosition(_panPositions.second);
+        cglib::mat4x4<double> transform = projectionSurface->calculateTranslateMatrix(pos0, pos1, totalDelta);
+        panTarget = projectionSurface->calculateMapPos(cglib::transform_point(viewState.getFocusPos(), transform));
+        return true;
+    }
+    
     void KineticEventHandler::startPan() {
         std::lock_guard<std::mutex> lock(_mutex);
          _pan = true;
@@ -242,4 +265,6 @@ namespace carto {
 
     const unsigned int KineticEventHandler::AVERAGE_SAMPLE_COUNT = 7;
 
+    const float KineticEventHandler::PREDICTION_FRAME_SECONDS = 1.0f / 60.0f;
+
 }
@@ -27,6 +27,7 @@ namespace carto {
     
         bool isPanning() const;
         void setPanDelta(const std::pair<MapPos, MapPos>& panDelta, float zoom);
+        bool calculatePanTarget(const ViewState& viewState, MapPos& panTarget) const;
         void startPan();
         void stopPan();
     
@@ -64,6 +65,8 @@ namespace carto {
         static const float KINETIC_ZOOM_DELTA_CLAMP;
         
         static const unsigned int AVERAGE_SAMPLE_COUNT;
+
+        static const float PREDICTION_FRAME_SECONDS;
     
         bool _pan;
         float _panDelta;
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_DRAWDATAPOOL_H_
+#define _CARTO_DRAWDATAPOOL_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace carto {
+
+    /**
+     * Factory for vector element draw datas that recycles the memory blocks of released draw datas.
+     * Frequently updated elements (for example markers with tracked positions) create a new draw data on each update,
+     * the pool keeps the blocks (object and shared pointer control block) of the released draw datas of each type
+     * and reuses them instead of going through the general purpose allocator. The pool is thread-safe.
+     */
+    class DrawDataPool {
+    public:
+        /**
+         * Creates a new draw data instance, using a recycled memory block if possible.
+         * @param args The arguments for the draw data constructor.
+         * @return The new draw data instance.
+         */
+        template <typename T, typename... Args>
+        static std::shared_ptr<T> Create(Args&&... args) {
+            return std::allocate_shared<T>(Allocator<T>(), std::forward<Args>(args)...);
+        }
+
+    private:
+        static const std::size_t MAX_FREE_BLOCKS = 4096;
+
+        template <typename T>
+        class Allocator {
+        public:
+            using value_type = T;
+
+            Allocator() { }
+            template <typename U>
+            Allocator(const Allocator<U>&) { }
+
+            T* allocate(std::size_t n) {
+                if (n == 1) {
+                    if (void* block = GetFreeList().pop()) {
+                        return static_cast<T*>(block);
+                    }
+                }
+                return static_cast<T*>(::operator new(n * sizeof(T)));
+            }
+
+            void deallocate(T* ptr, std::size_t n) {
+                if (n == 1 && GetFreeList().push(ptr)) {
+                    return;
+                }
+                ::operator delete(ptr);
+            }
+
+            template <typename U>
+            bool operator ==(const Allocator<U>&) const { return true; }
+            template <typename U>
+            bool operator !=(const Allocator<U>&) const { return false; }
+
+        private:
+            struct FreeList {
+                void* pop() {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (blocks.empty()) {
+                        return nullptr;
+                    }
+                    void* block = blocks.back();
+                    blocks.pop_back();
+                    return block;
+                }
+
+                bool push(void* block) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (blocks.size() >= MAX_FREE_BLOCKS) {
+                        return false;
+                    }
+                    blocks.push_back(block);
+                    return true;
+                }
+
+                std::vector<void*> blocks;
+                std::mutex mutex;
+            };
+
+            static FreeList& GetFreeList() {
+                // Intentionally never destroyed, draw datas may be released during static destruction
+                static FreeList* freeList = new FreeList();
+                return *freeList;
+            }
+        };
+    };
+
+}
+
+#endif
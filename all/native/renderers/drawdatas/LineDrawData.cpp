@@ -1,6 +1,7 @@
 #include "LineDrawData.h"
 #include "core/MapPos.h"
 #include "geometry/LineGeometry.h"
+#include "geometry/PolygonGeometry.h"
 #include "graphics/Bitmap.h"
 #include "projections/Projection.h"
 #include "projections/ProjectionSurface.h"
@@ -21,27 +22,44 @@ namespace carto {
         _bitmap(style.getBitmap()),
         _normalScale(style.getWidth() / 2),
         _clickScale(style.getClickWidth() == -1 ? std::max(1.0f, 1 + (IDEAL_CLICK_WIDTH - style.getWidth()) * CLICK_WIDTH_COEF / style.getWidth()) : style.getClickWidth()),
-        _poses(),
+        _boundingBox(cglib::bbox3<double>::smallest()),
+        _maxNormalLength(0),
+        _origin(0, 0, 0),
         _coords(),
         _normals(),
         _texCoords(),
+        _linePositions(),
         _indices()
     {
-        init(geometry.getPoses(), projection, style);
+        std::shared_ptr<const TesselationCache::TesselatedGeometry> tesselatedLine = TesselationCache::GetInstance().getTesselatedGeometry(geometry, 0, projection, projectionSurface, [&]() {
+            return TesselateLine(geometry.getPoses(), projection, *projectionSurface);
+        });
+        init(*tesselatedLine, style);
     }
     
-    LineDrawData::LineDrawData(const std::vector<MapPos>& poses, const LineStyle& style, const Projection& projection, const std::shared_ptr<ProjectionSurface>& projectionSurface) :
+    LineDrawData::LineDrawData(const PolygonGeometry& geometry, std::size_t ringIndex, const LineStyle& style, const Projection& projection, const std::shared_ptr<ProjectionSurface>& projectionSurface) :
         VectorElementDrawData(style.getColor(), projectionSurface),
         _bitmap(style.getBitmap()),
         _normalScale(style.getWidth() / 2),
         _clickScale(std::max(1.0f, 1 + (IDEAL_CLICK_WIDTH - style.getWidth()) * CLICK_WIDTH_COEF / style.getWidth())),
-        _poses(),
+        _boundingBox(cglib::bbox3<double>::smallest()),
+        _maxNormalLength(0),
+        _origin(0, 0, 0),
         _coords(),
         _normals(),
         _texCoords(),
+        _linePositions(),
         _indices()
     {
-        init(poses, projection, style);
+        // Part 0 is reserved for the polygon interior
+        std::shared_ptr<const TesselationCache::TesselatedGeometry> tesselatedLine = TesselationCache::GetInstance().getTesselatedGeometry(geometry, static_cast<int>(ringIndex) + 1, projection, projectionSurface, [&]() {
+            std::vector<MapPos> ringPoses(geometry.getRings().at(ringIndex));
+            if (!ringPoses.empty()) {
+                ringPoses.push_back(ringPoses.front());
+            }
+            return TesselateLine(ringPoses, projection, *projectionSurface);
+        });
+        init(*tesselatedLine, style);
     }
         
     LineDrawData::~LineDrawData() {
@@ -59,7 +77,19 @@ namespace carto {
         return _clickScale;
     }
     
-    const std::vector<std::vector<cglib::vec3<double>*> >& LineDrawData::getCoords() const {
+    const cglib::bbox3<double>& LineDrawData::getBoundingBox() const {
+        return _boundingBox;
+    }
+
+    float LineDrawData::getMaxNormalLength() const {
+        return _maxNormalLength;
+    }
+    
+    const cglib::vec3<double>& LineDrawData::getOrigin() const {
+        return _origin;
+    }
+
+    const std::vector<std::vector<cglib::vec3<float> > >& LineDrawData::getCoords() const {
         return _coords;
     }
     
@@ -71,62 +101,77 @@ namespace carto {
         return _texCoords;
     }
     
+    const std::vector<std::vector<float> >& LineDrawData::getLinePositions() const {
+        return _linePositions;
+    }
+    
     const std::vector<std::vector<unsigned int> >& LineDrawData::getIndices() const {
         return _indices;
     }
     
     void LineDrawData::offsetHorizontally(double offset) {
-        for (cglib::vec3<double>& pos : _poses) {
-            pos(0) += offset;
-        }
+        _origin(0) += offset;
+        _boundingBox.min(0) += offset;
+        _boundingBox.max(0) += offset;
         setIsOffset(true);
     }
     
-    void LineDrawData::init(const std::vector<MapPos>& poses, const Projection& projection, const LineStyle& style) {
-        // Calculate real coordinates and tesselate the line
-        std::vector<cglib::vec3<float> > posNormals;
-        _poses.reserve(poses.size());
-        posNormals.reserve(poses.size());
-        std::vector<MapPos> internalPoses;
-        for (std::size_t i = 1; i < poses.size(); i++) {
-            internalPoses.clear();
-            _projectionSurface->tesselateSegment(projection.toInternal(poses[i - 1]), projection.toInternal(poses[i]), internalPoses);
-            for (const MapPos& internalPos : internalPoses) {
-                cglib::vec3<double> pos = _projectionSurface->calculatePosition(internalPos);
-                if (_poses.empty() || pos != _poses.back()) {
-                    _poses.push_back(pos);
-                    posNormals.push_back(cglib::vec3<float>::convert(_projectionSurface->calculateNormal(internalPos)));
-                }
-            }
+    void LineDrawData::init(const TesselationCache::TesselatedGeometry& tesselatedLine, const LineStyle& style) {
+        const std::vector<cglib::vec3<double> >& poses = tesselatedLine.positions;
+        const std::vector<cglib::vec3<float> >& posNormals = tesselatedLine.normals;
+        for (const cglib::vec3<double>& pos : poses) {
+            _boundingBox.add(pos);
         }
 
-        if (_poses.size() < 2) {
+        if (poses.size() < 2) {
             _coords.clear();
             _normals.clear();
             _texCoords.clear();
+            _linePositions.clear();
             _indices.clear();
             return;
         }
     
+        // Store vertex coordinates relative to the center of the line
+        _origin = _boundingBox.center();
+        std::vector<cglib::vec3<float> > relPoses;
+        relPoses.reserve(poses.size());
+        for (const cglib::vec3<double>& pos : poses) {
+            relPoses.push_back(cglib::vec3<float>::convert(pos - _origin));
+        }
+
+        // Calculate relative positions of the line points, used for clipping the line to the visible range
+        std::vector<float> posLinePositions(poses.size(), 0.0f);
+        double lineLength = 0;
+        for (std::size_t i = 1; i < poses.size(); i++) {
+            lineLength += cglib::length(poses[i] - poses[i - 1]);
+            posLinePositions[i] = static_cast<float>(lineLength);
+        }
+        if (lineLength > 0) {
+            for (float& linePos : posLinePositions) {
+                linePos = static_cast<float>(linePos / lineLength);
+            }
+        }
+
         // Detect looped line
-        bool loopedLine = (_poses.front() == _poses.back()) && (_poses.size() > 2);
+        bool loopedLine = (poses.front() == poses.back()) && (poses.size() > 2);
 
         // Detect if we must tesselate line joins
         bool tesselateLineJoin = (style.getLineJoinType() == LineJoinType::LINE_JOIN_TYPE_BEVEL || style.getLineJoinType() == LineJoinType::LINE_JOIN_TYPE_ROUND);
     
         // Calculate angles between lines and buffers sizes
-        std::size_t coordCount = (_poses.size() - 1) * 4;
-        std::size_t indexCount = (_poses.size() - 1) * 6;
-        std::vector<float> deltaAngles(_poses.size() - 1);
+        std::size_t coordCount = (poses.size() - 1) * 4;
+        std::size_t indexCount = (poses.size() - 1) * 6;
+        std::vector<float> deltaAngles(poses.size() - 1);
         cglib::vec3<float> prevLineVec(0, 0, 0);
         if (tesselateLineJoin) {
-            for (std::size_t i = 0; i < _poses.size(); i++) {
-                if (!loopedLine && i + 1 >= _poses.size()) {
+            for (std::size_t i = 0; i < poses.size(); i++) {
+                if (!loopedLine && i + 1 >= poses.size()) {
                     break;
                 }
     
-                const cglib::vec3<double>& pos = _poses[i];
-                const cglib::vec3<double>& nextPos = (i + 1 < _poses.size()) ? _poses[i + 1] : _poses[1];
+                const cglib::vec3<double>& pos = poses[i];
+                const cglib::vec3<double>& nextPos = (i + 1 < poses.size()) ? poses[i + 1] : poses[1];
                 if (nextPos == pos) {
                     continue;
                 }
@@ -170,24 +215,26 @@ namespace carto {
 
         // Instead of calculating actual vertex positions calculate vertex origins and normals
         // Actual vertex positions are view dependent and will be calculated in the renderer
-        std::vector<cglib::vec3<double>*> coords;
+        std::vector<cglib::vec3<float> > coords;
         std::vector<cglib::vec4<float> > normals;
         std::vector<cglib::vec2<float> > texCoords;
+        std::vector<float> linePositions;
         std::vector<unsigned int> indices;
         coords.reserve(coordCount);
         normals.reserve(coordCount);
         texCoords.reserve(coordCount);
+        linePositions.reserve(coordCount);
         indices.reserve(indexCount);
 
         // Calculate initial state for line string
-        cglib::vec3<float> nextLine = cglib::vec3<float>::convert(_poses[1] - _poses[0]);
+        cglib::vec3<float> nextLine = cglib::vec3<float>::convert(poses[1] - poses[0]);
         cglib::vec3<float> nextPerpVec = cglib::unit(cglib::vector_product(posNormals[1], nextLine));
 
         cglib::vec3<float> nextNormalVec = nextPerpVec;
         bool resetNormalVec = true;
         if (style.getLineJoinType() == LineJoinType::LINE_JOIN_TYPE_MITER) {
             if (loopedLine) {
-                cglib::vec3<float> prevLine = cglib::vec3<float>::convert(_poses[0] - _poses[_poses.size() - 2]);
+                cglib::vec3<float> prevLine = cglib::vec3<float>::convert(poses[0] - poses[poses.size() - 2]);
                 cglib::vec3<float> prevPerpVec = cglib::unit(cglib::vector_product(posNormals[0], prevLine));
 
                 float dot = cglib::dot_product(prevPerpVec, nextPerpVec);
@@ -202,12 +249,12 @@ namespace carto {
         cglib::vec3<float> firstPerpVec;
         cglib::vec3<float> lastPerpVec;
         unsigned int vertexIndex = 0;
-        for (std::size_t i = 1; i < _poses.size(); i++) {
-            std::size_t i1 = i + 1 < _poses.size() ? i + 1 : 1;
+        for (std::size_t i = 1; i < poses.size(); i++) {
+            std::size_t i1 = i + 1 < poses.size() ? i + 1 : 1;
             
-            cglib::vec3<double>& pos = _poses[i];
-            cglib::vec3<double>& prevPos = _poses[i - 1];
-            cglib::vec3<double>& nextPos = _poses[i1];
+            const cglib::vec3<double>& pos = poses[i];
+            const cglib::vec3<double>& prevPos = poses[i - 1];
+            const cglib::vec3<double>& nextPos = poses[i1];
 
             // Calculate line body
             cglib::vec3<float> prevLine = cglib::vec3<float>::convert(pos - prevPos);
@@ -220,6 +267,8 @@ namespace carto {
                 coords.pop_back();
                 texCoords.pop_back();
                 texCoords.pop_back();
+                linePositions.pop_back();
+                linePositions.pop_back();
                 normals.pop_back();
                 normals.pop_back();
             }
@@ -229,7 +278,7 @@ namespace carto {
             resetNormalVec = true;
 
             if (style.getLineJoinType() == LineJoinType::LINE_JOIN_TYPE_MITER) {
-                if (i + 1 < _poses.size() || loopedLine) {
+                if (i + 1 < poses.size() || loopedLine) {
                     cglib::vec3<float> nextLine = cglib::vec3<float>::convert(nextPos - pos);
                     cglib::vec3<float> nextPerpVec = cglib::unit(cglib::vector_product(posNormals[i1], nextLine));
 
@@ -244,15 +293,15 @@ namespace carto {
             if (i == 1) {
                 firstPerpVec = prevPerpVec;
             }
-            if (i == _poses.size() - 1) {
+            if (i == poses.size() - 1) {
                 lastPerpVec = prevPerpVec;
             }
 
             // Add line vertices, normals and indices
-            coords.push_back(&prevPos);
-            coords.push_back(&prevPos);
-            coords.push_back(&pos);
-            coords.push_back(&pos);
+            coords.push_back(relPoses[i - 1]);
+            coords.push_back(relPoses[i - 1]);
+            coords.push_back(relPoses[i]);
+            coords.push_back(relPoses[i]);
             
             if (useTexCoordY) {
                 float texCoordYOffset = cglib::length(prevLine) * texCoordYScale;
@@ -268,6 +317,11 @@ namespace carto {
                 texCoords.push_back(cglib::vec2<float>(texCoordX, 0.5f));
             }
 
+            linePositions.push_back(posLinePositions[i - 1]);
+            linePositions.push_back(posLinePositions[i - 1]);
+            linePositions.push_back(posLinePositions[i]);
+            linePositions.push_back(posLinePositions[i]);
+
             normals.push_back(cglib::expand(prevNormalVec, 1.0f));
             normals.push_back(cglib::expand(prevNormalVec, -1.0f));
             normals.push_back(cglib::expand(nextNormalVec, 1.0f));
@@ -283,7 +337,7 @@ namespace carto {
             vertexIndex += 4;
             
             // Calculate line joins, if necessary
-            if (tesselateLineJoin && (i + 1 <  _poses.size() || loopedLine)) {
+            if (tesselateLineJoin && (i + 1 <  poses.size() || loopedLine)) {
                 float deltaAngle = deltaAngles[i - 1];
                 
                 int segments = 0;
@@ -300,16 +354,18 @@ namespace carto {
                     cglib::vec3<float> rotVec = prevNormalVec;
                     
                     // Add the t vertex
-                    coords.push_back(&pos);
+                    coords.push_back(relPoses[i]);
                     normals.push_back(cglib::expand(rotVec, 0.0f));
                     texCoords.push_back(cglib::vec2<float>(0.5f, texCoordY));
+                    linePositions.push_back(posLinePositions[i]);
                     
                     // Add vertices and normals, do not create double vertices anywhere
                     for (int j = 0; j < segments - 1; j++) {
                         rotVec = cglib::transform(rotVec, rot3DMat);
-                        coords.push_back(&pos);
+                        coords.push_back(relPoses[i]);
                         normals.push_back(cglib::expand(rotVec, leftTurn ? 1.0f : -1.0f));
                         texCoords.push_back(cglib::vec2<float>(leftTurn ? 0.0f : 1.0f, texCoordY));
+                        linePositions.push_back(posLinePositions[i]);
                     }
                     
                     // Add indices, make use of existing and future line's vertices
@@ -317,7 +373,7 @@ namespace carto {
                         for (int j = 0; j < segments; j++) {
                             indices.push_back(vertexIndex);
                             if (j == segments - 1) {
-                                indices.push_back((i == _poses.size() - 1) ? 0 : (vertexIndex + j + 1));
+                                indices.push_back((i == poses.size() - 1) ? 0 : (vertexIndex + j + 1));
                             } else {
                                 indices.push_back(vertexIndex + j + 1);
                             }
@@ -328,7 +384,7 @@ namespace carto {
                             indices.push_back(vertexIndex);
                             indices.push_back((j == 0) ? vertexIndex - 1 : (vertexIndex + j));
                             if (j == segments - 1) {
-                                indices.push_back((i == _poses.size() - 1) ? 1 : (vertexIndex + j + 2));
+                                indices.push_back((i == poses.size() - 1) ? 1 : (vertexIndex + j + 2));
                             } else {
                                 indices.push_back(vertexIndex + j + 1);
                             }
@@ -355,13 +411,14 @@ namespace carto {
                 cglib::mat2x2<float> rot2DMat = cglib::rotate2_matrix(static_cast<float>(segmentDeltaAngle * Const::DEG_TO_RAD));
                 
                 // Add the t vertex
-                coords.push_back(&_poses[_poses.size() - 1]);
+                coords.push_back(relPoses.back());
                 normals.push_back(cglib::expand(lastPerpVec, 0.0f));
                 texCoords.push_back(cglib::vec2<float>(0.5f, texCoordY));
+                linePositions.push_back(posLinePositions.back());
                 
                 if (style.getLineEndType() == LineEndType::LINE_END_TYPE_ROUND) {
                     // Last end point, lastLine contains the last valid line segment
-                    cglib::mat3x3<float> rot3DMat = cglib::rotate3_matrix(posNormals[_poses.size() - 1], static_cast<float>(segmentDeltaAngle * Const::DEG_TO_RAD));
+                    cglib::mat3x3<float> rot3DMat = cglib::rotate3_matrix(posNormals[poses.size() - 1], static_cast<float>(segmentDeltaAngle * Const::DEG_TO_RAD));
                     cglib::vec3<float> rotVec = lastPerpVec;
                     cglib::vec2<float> uvRotVec(-1, 0);
                 
@@ -369,18 +426,20 @@ namespace carto {
                     for (int i = 0; i < segments - 1; i++) {
                         rotVec = cglib::transform(rotVec, rot3DMat);
                         uvRotVec = cglib::transform(uvRotVec, rot2DMat);
-                        coords.push_back(&_poses[_poses.size() - 1]);
+                        coords.push_back(relPoses.back());
                         normals.push_back(cglib::expand(rotVec, -1.0f));
                         texCoords.push_back(cglib::vec2<float>(uvRotVec(0) * 0.5f + 0.5f, texCoordY));
+                        linePositions.push_back(posLinePositions.back());
                     }
                 } else {
                     // Vertices
                     for (int s = -1; s <= 1; s += 2) {
-                        cglib::mat3x3<float> rot3DMat = cglib::rotate3_matrix(posNormals[_poses.size() - 1], static_cast<float>(-s * segmentDeltaAngle * Const::DEG_TO_RAD));
+                        cglib::mat3x3<float> rot3DMat = cglib::rotate3_matrix(posNormals[poses.size() - 1], static_cast<float>(-s * segmentDeltaAngle * Const::DEG_TO_RAD));
                         cglib::vec3<float> normalVec = cglib::transform(lastPerpVec, rot3DMat) * std::sqrt(2.0f);
-                        coords.push_back(&_poses[_poses.size() - 1]);
+                        coords.push_back(relPoses.back());
                         normals.push_back(cglib::expand(normalVec, static_cast<float>(s)));
                         texCoords.push_back(cglib::vec2<float>(s * 0.5f + 0.5f, texCoordY));
+                        linePositions.push_back(posLinePositions.back());
                     }
                 }
                 
@@ -393,9 +452,10 @@ namespace carto {
                 vertexIndex += segments;
                 
                 // Add the t vertex for the other end point
-                coords.push_back(&_poses[0]);
+                coords.push_back(relPoses.front());
                 normals.push_back(cglib::expand(firstPerpVec, 0.0f));
                 texCoords.push_back(cglib::vec2<float>(0.5f, 0));
+                linePositions.push_back(posLinePositions.front());
                 
                 if (style.getLineEndType() == LineEndType::LINE_END_TYPE_ROUND) {
                     // First end point, firstLine contains the first valid line segment
@@ -407,18 +467,20 @@ namespace carto {
                     for (int i = 0; i < segments - 1; i++) {
                         rotVec = cglib::transform(rotVec, rot3DMat);
                         uvRotVec = cglib::transform(uvRotVec, rot2DMat);
-                        coords.push_back(&_poses[0]);
+                        coords.push_back(relPoses.front());
                         normals.push_back(cglib::expand(rotVec, 1.0f));
                         texCoords.push_back(cglib::vec2<float>(uvRotVec(0) * 0.5f + 0.5f, 0));
+                        linePositions.push_back(posLinePositions.front());
                     }
                 } else {
                     // Vertices
                     for (int s = 1; s >= -1; s -= 2) {
                         cglib::mat3x3<float> rot3DMat = cglib::rotate3_matrix(posNormals[0], static_cast<float>(s * segmentDeltaAngle * Const::DEG_TO_RAD));
                         cglib::vec3<float> normalVec = cglib::transform(firstPerpVec, rot3DMat) * std::sqrt(2.0f);
-                        coords.push_back(&_poses[0]);
+                        coords.push_back(relPoses.front());
                         normals.push_back(cglib::expand(normalVec, static_cast<float>(s)));
                         texCoords.push_back(cglib::vec2<float>(s * 0.5f + 0.5f, 0));
+                        linePositions.push_back(posLinePositions.front());
                     }
                 }
                 
@@ -431,21 +493,29 @@ namespace carto {
                 vertexIndex += segments;
             }
         }
+
+        // Find the maximum vertex extrusion, used to expand the bounds for click tests
+        for (const cglib::vec4<float>& normal : normals) {
+            _maxNormalLength = std::max(_maxNormalLength, cglib::length(cglib::vec3<float>(normal(0), normal(1), normal(2))) * std::abs(normal(3)));
+        }
         
-        _coords.push_back(std::vector<cglib::vec3<double>*>());
+        _coords.push_back(std::vector<cglib::vec3<float> >());
         _normals.push_back(std::vector<cglib::vec4<float> >());
         _texCoords.push_back(std::vector<cglib::vec2<float> >());
+        _linePositions.push_back(std::vector<float>());
         _indices.push_back(std::vector<unsigned int>());
         if (indices.size() <= GLContext::MAX_VERTEXBUFFER_SIZE) {
             _coords.back().swap(coords);
             _normals.back().swap(normals);
             _texCoords.back().swap(texCoords);
+            _linePositions.back().swap(linePositions);
             _indices.back().swap(indices);
         } else {
             // Buffers too big, split into multiple buffers
             _coords.back().reserve(std::min(coords.size(), GLContext::MAX_VERTEXBUFFER_SIZE));
             _normals.back().reserve(std::min(normals.size(), GLContext::MAX_VERTEXBUFFER_SIZE));
             _texCoords.back().reserve(std::min(texCoords.size(), GLContext::MAX_VERTEXBUFFER_SIZE));
+            _linePositions.back().reserve(std::min(linePositions.size(), GLContext::MAX_VERTEXBUFFER_SIZE));
             _indices.back().reserve(std::min(indices.size(), GLContext::MAX_VERTEXBUFFER_SIZE));
             std::unordered_map<unsigned int, unsigned int> indexMap;
             indexMap.reserve(indices.size() * 2);
@@ -455,7 +525,7 @@ namespace carto {
                 if (_indices.back().size() + 3 > GLContext::MAX_VERTEXBUFFER_SIZE) {
                     // The buffer is full, create a new one
                     _coords.back().shrink_to_fit();
-                    _coords.push_back(std::vector<cglib::vec3<double>*>());
+                    _coords.push_back(std::vector<cglib::vec3<float> >());
                     _coords.back().reserve(std::min(coords.size(), GLContext::MAX_VERTEXBUFFER_SIZE));
                     _normals.back().shrink_to_fit();
                     _normals.push_back(std::vector<cglib::vec4<float> >());
@@ -463,6 +533,9 @@ namespace carto {
                     _texCoords.back().shrink_to_fit();
                     _texCoords.push_back(std::vector<cglib::vec2<float> >());
                     _texCoords.back().reserve(std::min(texCoords.size(), GLContext::MAX_VERTEXBUFFER_SIZE));
+                    _linePositions.back().shrink_to_fit();
+                    _linePositions.push_back(std::vector<float>());
+                    _linePositions.back().reserve(std::min(linePositions.size(), GLContext::MAX_VERTEXBUFFER_SIZE));
                     _indices.back().shrink_to_fit();
                     _indices.push_back(std::vector<unsigned int>());
                     _indices.back().reserve(std::min(indices.size(), GLContext::MAX_VERTEXBUFFER_SIZE));
@@ -477,6 +550,7 @@ namespace carto {
                         _coords.back().push_back(coords[index]);
                         _normals.back().push_back(normals[index]);
                         _texCoords.back().push_back(texCoords[index]);
+                        _linePositions.back().push_back(linePositions[index]);
                         _indices.back().push_back(newIndex);
                         indexMap[index] = newIndex;
                     } else {
@@ -489,8 +563,36 @@ namespace carto {
         _coords.back().shrink_to_fit();
         _normals.back().shrink_to_fit();
         _texCoords.back().shrink_to_fit();
+        _linePositions.back().shrink_to_fit();
         _indices.back().shrink_to_fit();
     }
+
+    std::shared_ptr<TesselationCache::TesselatedGeometry> LineDrawData::TesselateLine(const std::vector<MapPos>& mapPoses, const Projection& projection, const ProjectionSurface& projectionSurface) {
+        // Calculate real coordinates and tesselate the line
+        auto tesselatedLine = std::make_shared<TesselationCache::TesselatedGeometry>();
+        std::vector<cglib::vec3<double> >& poses = tesselatedLine->positions;
+        std::vector<cglib::vec3<float> >& posNormals = tesselatedLine->normals;
+        poses.reserve(mapPoses.size());
+        posNormals.reserve(mapPoses.size());
+        std::vector<MapPos> internalMapPoses(mapPoses.size());
+        projection.toInternalPoses(mapPoses.data(), internalMapPoses.data(), mapPoses.size());
+        std::vector<MapPos> internalPoses;
+        std::vector<cglib::vec3<double> > segmentPoses;
+        for (std::size_t i = 1; i < internalMapPoses.size(); i++) {
+            internalPoses.clear();
+            projectionSurface.tesselateSegment(internalMapPoses[i - 1], internalMapPoses[i], internalPoses);
+            segmentPoses.resize(internalPoses.size());
+            projectionSurface.calculatePositions(internalPoses.data(), segmentPoses.data(), internalPoses.size());
+            for (std::size_t j = 0; j < internalPoses.size(); j++) {
+                const cglib::vec3<double>& pos = segmentPoses[j];
+                if (poses.empty() || pos != poses.back()) {
+                    poses.push_back(pos);
+                    posNormals.push_back(cglib::vec3<float>::convert(projectionSurface.calculateNormal(internalPoses[j])));
+                }
+            }
+        }
+        return tesselatedLine;
+    }
     
     const float LineDrawData::LINE_ENDPOINT_TESSELATION_FACTOR = 0.004f;
     const float LineDrawData::LINE_JOIN_TESSELATION_FACTOR = 0.002f;
@@ -8,11 +8,13 @@
 #define _CARTO_LINEDRAWDATA_H_
 
 #include "renderers/drawdatas/VectorElementDrawData.h"
+#include "renderers/utils/TesselationCache.h"
 
 #include <memory>
 #include <vector>
 
 #include <cglib/vec.h>
+#include <cglib/bbox.h>
 
 namespace carto {
     class Bitmap;
@@ -25,7 +27,7 @@ namespace carto {
     class LineDrawData : public VectorElementDrawData {
     public:
         LineDrawData(const LineGeometry& geometry, const LineStyle& style, const Projection& projection, const std::shared_ptr<ProjectionSurface>& projectionSurface);
-        LineDrawData(const std::vector<MapPos>& poses, const LineStyle& style, const Projection& projection, const std::shared_ptr<ProjectionSurface>& projectionSurface);
+        LineDrawData(const PolygonGeometry& geometry, std::size_t ringIndex, const LineStyle& style, const Projection& projection, const std::shared_ptr<ProjectionSurface>& projectionSurface);
         virtual ~LineDrawData();
     
         const std::shared_ptr<Bitmap> getBitmap() const;
@@ -33,12 +35,20 @@ namespace carto {
         float getNormalScale() const;
     
         float getClickScale() const;
+
+        const cglib::bbox3<double>& getBoundingBox() const;
+
+        float getMaxNormalLength() const;
     
-        const std::vector<std::vector<cglib::vec3<double>*> >& getCoords() const;
+        const cglib::vec3<double>& getOrigin() const;
+
+        const std::vector<std::vector<cglib::vec3<float> > >& getCoords() const;
     
         const std::vector<std::vector<cglib::vec4<float> > >& getNormals() const;
     
         const std::vector<std::vector<cglib::vec2<float> > >& getTexCoords() const;
+
+        const std::vector<std::vector<float> >& getLinePositions() const;
     
         const std::vector<std::vector<unsigned int> >& getIndices() const;
     
@@ -53,21 +63,30 @@ namespace carto {
     
         static const float CLICK_WIDTH_COEF;
         
-        void init(const std::vector<MapPos>& poses, const Projection& projection, const LineStyle& style);
+        void init(const TesselationCache::TesselatedGeometry& tesselatedLine, const LineStyle& style);
+
+        static std::shared_ptr<TesselationCache::TesselatedGeometry> TesselateLine(const std::vector<MapPos>& mapPoses, const Projection& projection, const ProjectionSurface& projectionSurface);
     
         std::shared_ptr<Bitmap> _bitmap;
     
         float _normalScale;
 
         float _clickScale;
+
+        // Bounds of the line coordinates, without the line width
+        cglib::bbox3<double> _boundingBox;
+
+        float _maxNormalLength;
     
-        // Actual line coordinates
-        std::vector<cglib::vec3<double> > _poses;
+        // Origin of the relative vertex coordinates
+        cglib::vec3<double> _origin;
     
-        // Origin point and normal for each vertex
-        std::vector<std::vector<cglib::vec3<double>*> > _coords;
+        // Line point (relative to the origin) and normal for each vertex
+        std::vector<std::vector<cglib::vec3<float> > > _coords;
         std::vector<std::vector<cglib::vec4<float> > > _normals;
         std::vector<std::vector<cglib::vec2<float> > > _texCoords;
+        // Relative position of each vertex along the line, from 0 (start) to 1 (end)
+        std::vector<std::vector<float> > _linePositions;
     
         std::vector<std::vector<unsigned int> > _indices;
     };
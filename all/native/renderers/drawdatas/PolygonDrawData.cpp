@@ -11,6 +11,7 @@
 #include "utils/Const.h"
 #include "utils/Log.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <unordered_map>
@@ -23,93 +24,40 @@ namespace carto {
         VectorElementDrawData(style.getColor(), projectionSurface),
         _bitmap(style.getBitmap()),
         _boundingBox(cglib::bbox3<double>::smallest()),
+        _origin(0, 0, 0),
         _coords(),
         _indices(),
         _lineDrawDatas()
     {
-        const std::vector<MapPos>& poses = geometry.getPoses();
-        const std::vector<std::vector<MapPos> >& holes = geometry.getHoles();
-        
-        // Create tesselator
-        TESSalloc ma;
-        ma.memalloc = [](void* userData, unsigned int size) { return malloc(size); };
-        ma.memfree = [](void* userData, void* ptr) { free(ptr); };
-        ma.extraVertices = 256;
-        TESStesselator* tessPtr = tessNewTess(&ma);
-        if (!tessPtr) {
-            Log::Error("PolygonDrawData::PolygonDrawData: Failed to create tesselator!");
-            return;
-        }
-        std::shared_ptr<TESStesselator> tess(tessPtr, tessDeleteTess);
-
-        // Add polygon exterior, calculate bounding box
-        std::vector<double> posesArray(poses.size() * 3);
-        std::vector<MapPos> ringPoses;
-        ringPoses.reserve(poses.size() + 1);
-        for (std::size_t i = 0; i < poses.size(); i++) {
-            MapPos internalPos = projection.toInternal(poses[i]);
-            posesArray[i * 3 + 0] = internalPos.getX();
-            posesArray[i * 3 + 1] = internalPos.getY();
-            posesArray[i * 3 + 2] = internalPos.getZ();
-            ringPoses.push_back(poses[i]);
-        }
-        tessAddContour(tess.get(), 3, posesArray.data(), sizeof(double) * 3, static_cast<unsigned int>(poses.size()));
-    
-        if (style.getLineStyle() && !poses.empty()) {
-            ringPoses.push_back(poses.front());
-            _lineDrawDatas.push_back(std::make_shared<LineDrawData>(ringPoses, *style.getLineStyle(), projection, projectionSurface));
-        }
-    
-        // Add polygon holes
-        for (const std::vector<MapPos>& hole : holes) {
-            ringPoses.clear();
-            ringPoses.reserve(hole.size() + 1);
-            std::vector<double> holeArray(hole.size() * 3);
-            for (std::size_t i = 0; i < hole.size(); i++) {
-                MapPos internalPos = projection.toInternal(hole[i]);
-                holeArray[i * 3 + 0] = internalPos.getX();
-                holeArray[i * 3 + 1] = internalPos.getY();
-                holeArray[i * 3 + 2] = internalPos.getZ();
-                ringPoses.push_back(hole[i]);
-            }
-            tessAddContour(tess.get(), 3, holeArray.data(), sizeof(double) * 3, static_cast<unsigned int>(hole.size()));
-    
-            if (style.getLineStyle() && !hole.empty()) {
-                ringPoses.push_back(hole.front());
-                _lineDrawDatas.push_back(std::make_shared<LineDrawData>(ringPoses, *style.getLineStyle(), projection, projectionSurface));
+        if (style.getLineStyle()) {
+            for (std::size_t i = 0; i < geometry.getRings().size(); i++) {
+                if (!geometry.getRings()[i].empty()) {
+                    _lineDrawDatas.push_back(std::make_shared<LineDrawData>(geometry, i, *style.getLineStyle(), projection, projectionSurface));
+                }
             }
         }
-    
-        // Triangulate
-        if (!tessTesselate(tess.get(), TESS_WINDING_ODD, TESS_POLYGONS, 3, 3, NULL)) {
-            Log::Error("PolygonDrawData::PolygonDrawData: Failed to triangulate polygon!");
+
+        std::shared_ptr<const TesselationCache::TesselatedGeometry> tesselatedPolygon = TesselationCache::GetInstance().getTesselatedGeometry(geometry, 0, projection, projectionSurface, [&]() {
+            return TesselatePolygon(geometry, projection, *projectionSurface);
+        });
+        if (!tesselatedPolygon) {
             return;
         }
-        const double* coords = tessGetVertices(tess.get());
-        const int* elements = tessGetElements(tess.get());
-        std::size_t vertexCount = tessGetVertexCount(tess.get());
-        std::size_t elementCount = tessGetElementCount(tess.get());
+        const std::vector<cglib::vec3<double> >& positions = tesselatedPolygon->positions;
+        const std::vector<unsigned int>& indices = tesselatedPolygon->indices;
 
-        // Do projection-surface based tesselation
-        std::vector<MapPos> internalPoses;
-        internalPoses.reserve(vertexCount);
-        for (std::size_t i = 0; i < vertexCount; i++) {
-            internalPoses.emplace_back(coords[i * 3 + 0], coords[i * 3 + 1], coords[i * 3 + 2]);
+        // Use the center of the vertices as the origin for relative coordinates
+        cglib::bbox3<double> positionBounds = cglib::bbox3<double>::smallest();
+        for (const cglib::vec3<double>& pos : positions) {
+            positionBounds.add(pos);
         }
-        std::vector<unsigned int> indices;
-        indices.reserve(elementCount * 3);
-        for (std::size_t i = 0; i < elementCount * 3; i += 3) {
-            unsigned int i0 = elements[i + 0];
-            unsigned int i1 = elements[i + 1];
-            unsigned int i2 = elements[i + 2];
-            if (i0 != TESS_UNDEF && i1 != TESS_UNDEF && i2 != TESS_UNDEF) {
-                projectionSurface->tesselateTriangle(i0, i1, i2, indices, internalPoses);
-            }
+        if (!positions.empty()) {
+            _origin = positionBounds.center();
         }
-    
+
         // Convert tesselation results to drawable format, split if into multiple buffers, if the polyong is too big
-        _coords.push_back(std::vector<cglib::vec3<double> >());
-        _coords.back().reserve(std::min(internalPoses.size(), GLContext::MAX_VERTEXBUFFER_SIZE));
+        _coords.push_back(std::vector<cglib::vec3<float> >());
+        _coords.back().reserve(std::min(positions.size(), GLContext::MAX_VERTEXBUFFER_SIZE));
         _indices.push_back(std::vector<unsigned int>());
         _indices.back().reserve(std::min(indices.size(), GLContext::MAX_VERTEXBUFFER_SIZE));
         std::unordered_map<unsigned int, unsigned int> indexMap;
@@ -119,8 +67,8 @@ namespace carto {
             if (_indices.back().size() + 3 > GLContext::MAX_VERTEXBUFFER_SIZE) {
                 // The buffer is full, create a new one
                 _coords.back().shrink_to_fit();
-                _coords.push_back(std::vector<cglib::vec3<double> >());
-                _coords.back().reserve(std::min(internalPoses.size(), GLContext::MAX_VERTEXBUFFER_SIZE));
+                _coords.push_back(std::vector<cglib::vec3<float> >());
+                _coords.back().reserve(std::min(positions.size(), GLContext::MAX_VERTEXBUFFER_SIZE));
                 _indices.back().shrink_to_fit();
                 _indices.push_back(std::vector<unsigned int>());
                 _indices.back().reserve(std::min(indices.size(), GLContext::MAX_VERTEXBUFFER_SIZE));
@@ -132,8 +80,8 @@ namespace carto {
                 auto it = indexMap.find(index);
                 if (it == indexMap.end()) {
                     unsigned int newIndex = static_cast<unsigned int>(_coords.back().size());
-                    _coords.back().push_back(projectionSurface->calculatePosition(internalPoses[index]));
-                    _boundingBox.add(_coords.back().back());
+                    _coords.back().push_back(cglib::vec3<float>::convert(positions[index] - _origin));
+                    _boundingBox.add(positions[index]);
                     _indices.back().push_back(newIndex);
                     indexMap[index] = newIndex;
                 } else {
@@ -157,7 +105,11 @@ namespace carto {
         return _boundingBox;
     }
     
-    const std::vector<std::vector<cglib::vec3<double> > >& PolygonDrawData::getCoords() const {
+    const cglib::vec3<double>& PolygonDrawData::getOrigin() const {
+        return _origin;
+    }
+
+    const std::vector<std::vector<cglib::vec3<float> > >& PolygonDrawData::getCoords() const {
         return _coords;
     }
     
@@ -170,11 +122,9 @@ namespace carto {
     }
     
     void PolygonDrawData::offsetHorizontally(double offset) {
-        for (std::vector<cglib::vec3<double> >& coords : _coords) {
-            for (cglib::vec3<double>& coord : coords) {
-                coord(0) += offset;
-            }
-        }
+        _origin(0) += offset;
+        _boundingBox.min(0) += offset;
+        _boundingBox.max(0) += offset;
     
         for (const std::shared_ptr<LineDrawData>& drawData : _lineDrawDatas) {
             drawData->offsetHorizontally(offset);
@@ -182,5 +132,208 @@ namespace carto {
         
         setIsOffset(true);
     }
+
+    std::shared_ptr<TesselationCache::TesselatedGeometry> PolygonDrawData::TesselatePolygon(const PolygonGeometry& geometry, const Projection& projection, const ProjectionSurface& projectionSurface) {
+        // Planar triangulation does not depend on the projection surface, cache it separately so that surface changes only redo the cheap part
+        std::shared_ptr<const TesselationCache::TesselatedGeometry> triangulatedPolygon = TesselationCache::GetInstance().getTesselatedGeometry(geometry, PLANAR_TRIANGULATION_PART, projection, std::shared_ptr<ProjectionSurface>(), [&]() {
+            return TriangulatePolygon(geometry, projection);
+        });
+        if (!triangulatedPolygon) {
+            return std::shared_ptr<TesselationCache::TesselatedGeometry>();
+        }
+
+        // Do projection-surface based tesselation
+        std::vector<MapPos> internalPoses;
+        internalPoses.reserve(triangulatedPolygon->positions.size());
+        for (const cglib::vec3<double>& pos : triangulatedPolygon->positions) {
+            internalPoses.emplace_back(pos(0), pos(1), pos(2));
+        }
+        auto tesselatedPolygon = std::make_shared<TesselationCache::TesselatedGeometry>();
+        std::vector<unsigned int>& indices = tesselatedPolygon->indices;
+        indices.reserve(triangulatedPolygon->indices.size());
+        for (std::size_t i = 0; i + 2 < triangulatedPolygon->indices.size(); i += 3) {
+            projectionSurface.tesselateTriangle(triangulatedPolygon->indices[i + 0], triangulatedPolygon->indices[i + 1], triangulatedPolygon->indices[i + 2], indices, internalPoses);
+        }
+    
+        // Calculate vertex positions
+        tesselatedPolygon->positions.resize(internalPoses.size());
+        projectionSurface.calculatePositions(internalPoses.data(), tesselatedPolygon->positions.data(), internalPoses.size());
+        return tesselatedPolygon;
+    }
+
+    std::shared_ptr<TesselationCache::TesselatedGeometry> PolygonDrawData::TriangulatePolygon(const PolygonGeometry& geometry, const Projection& projection) {
+        const std::vector<std::vector<MapPos> >& rings = geometry.getRings();
+
+        // Simple polygons without holes are handled by ear clipping, which is much cheaper than the general tesselator
+        if (rings.size() == 1 && rings.front().size() <= MAX_EAR_CLIPPING_VERTICES + 1) {
+            std::vector<MapPos> internalRingPoses(rings.front().size());
+            projection.toInternalPoses(rings.front().data(), internalRingPoses.data(), rings.front().size());
+            auto triangulatedPolygon = std::make_shared<TesselationCache::TesselatedGeometry>();
+            if (TriangulateSimpleRing(internalRingPoses, *triangulatedPolygon)) {
+                return triangulatedPolygon;
+            }
+        }
+
+        // Create tesselator
+        TESSalloc ma;
+        ma.memalloc = [](void* userData, unsigned int size) { return malloc(size); };
+        ma.memfree = [](void* userData, void* ptr) { free(ptr); };
+        ma.extraVertices = 256;
+        TESStesselator* tessPtr = tessNewTess(&ma);
+        if (!tessPtr) {
+            Log::Error("PolygonDrawData::TriangulatePolygon: Failed to create tesselator!");
+            return std::shared_ptr<TesselationCache::TesselatedGeometry>();
+        }
+        std::shared_ptr<TESStesselator> tess(tessPtr, tessDeleteTess);
+
+        // Add polygon exterior and holes
+        std::vector<MapPos> internalRingPoses;
+        std::vector<double> ringArray;
+        for (const std::vector<MapPos>& ring : rings) {
+            internalRingPoses.resize(ring.size());
+            projection.toInternalPoses(ring.data(), internalRingPoses.data(), ring.size());
+            ringArray.resize(ring.size() * 3);
+            for (std::size_t i = 0; i < ring.size(); i++) {
+                ringArray[i * 3 + 0] = internalRingPoses[i].getX();
+                ringArray[i * 3 + 1] = internalRingPoses[i].getY();
+                ringArray[i * 3 + 2] = internalRingPoses[i].getZ();
+            }
+            tessAddContour(tess.get(), 3, ringArray.data(), sizeof(double) * 3, static_cast<unsigned int>(ring.size()));
+        }
+
+        // Triangulate
+        if (!tessTesselate(tess.get(), TESS_WINDING_ODD, TESS_POLYGONS, 3, 3, NULL)) {
+            Log::Error("PolygonDrawData::TriangulatePolygon: Failed to triangulate polygon!");
+            return std::shared_ptr<TesselationCache::TesselatedGeometry>();
+        }
+        const double* coords = tessGetVertices(tess.get());
+        const int* elements = tessGetElements(tess.get());
+        std::size_t vertexCount = tessGetVertexCount(tess.get());
+        std::size_t elementCount = tessGetElementCount(tess.get());
+
+        auto triangulatedPolygon = std::make_shared<TesselationCache::TesselatedGeometry>();
+        triangulatedPolygon->positions.reserve(vertexCount);
+        for (std::size_t i = 0; i < vertexCount; i++) {
+            triangulatedPolygon->positions.emplace_back(coords[i * 3 + 0], coords[i * 3 + 1], coords[i * 3 + 2]);
+        }
+        triangulatedPolygon->indices.reserve(elementCount * 3);
+        for (std::size_t i = 0; i < elementCount * 3; i += 3) {
+            unsigned int i0 = elements[i + 0];
+            unsigned int i1 = elements[i + 1];
+            unsigned int i2 = elements[i + 2];
+            if (i0 != TESS_UNDEF && i1 != TESS_UNDEF && i2 != TESS_UNDEF) {
+                triangulatedPolygon->indices.insert(triangulatedPolygon->indices.end(), { i0, i1, i2 });
+            }
+        }
+        return triangulatedPolygon;
+    }
+
+    bool PolygonDrawData::TriangulateSimpleRing(const std::vector<MapPos>& ring, TesselationCache::TesselatedGeometry& triangulatedRing) {
+        // Drop repeated vertices and the closing vertex
+        std::vector<MapPos> poses;
+        poses.reserve(ring.size());
+        for (const MapPos& pos : ring) {
+            if (poses.empty() || poses.back() != pos) {
+                poses.push_back(pos);
+            }
+        }
+        while (poses.size() > 1 && poses.front() == poses.back()) {
+            poses.pop_back();
+        }
+        std::vector<cglib::vec3<double> >& verts = triangulatedRing.positions;
+        verts.clear();
+        verts.reserve(poses.size());
+        for (const MapPos& pos : poses) {
+            verts.emplace_back(pos.getX(), pos.getY(), pos.getZ());
+        }
+        std::size_t n = verts.size();
+        if (n < 3) {
+            return false;
+        }
+
+        auto orient = [&verts](unsigned int i0, unsigned int i1, unsigned int i2) {
+            return (verts[i1](0) - verts[i0](0)) * (verts[i2](1) - verts[i0](1)) - (verts[i1](1) - verts[i0](1)) * (verts[i2](0) - verts[i0](0));
+        };
+        auto inBounds = [&verts](unsigned int i0, unsigned int i1, unsigned int i) {
+            return std::min(verts[i0](0), verts[i1](0)) <= verts[i](0) && verts[i](0) <= std::max(verts[i0](0), verts[i1](0)) &&
+                   std::min(verts[i0](1), verts[i1](1)) <= verts[i](1) && verts[i](1) <= std::max(verts[i0](1), verts[i1](1));
+        };
+
+        double area = 0;
+        for (std::size_t i = 0; i < n; i++) {
+            const cglib::vec3<double>& v0 = verts[i];
+            const cglib::vec3<double>& v1 = verts[(i + 1) % n];
+            area += v0(0) * v1(1) - v1(0) * v0(1);
+        }
+        if (area == 0) {
+            return false;
+        }
+
+        // Self-intersecting and self-touching rings are left to the general tesselator, which applies the odd winding rule
+        for (unsigned int i = 0; i < n; i++) {
+            unsigned int i1 = static_cast<unsigned int>((i + 1) % n);
+            for (unsigned int j = i + 2; j < n; j++) {
+                unsigned int j1 = static_cast<unsigned int>((j + 1) % n);
+                if (j1 == i) {
+                    continue;
+                }
+                double d0 = orient(j, j1, i);
+                double d1 = orient(j, j1, i1);
+                double d2 = orient(i, i1, j);
+                double d3 = orient(i, i1, j1);
+                if (((d0 > 0 && d1 < 0) || (d0 < 0 && d1 > 0)) && ((d2 > 0 && d3 < 0) || (d2 < 0 && d3 > 0))) {
+                    return false;
+                }
+                if ((d0 == 0 && inBounds(j, j1, i)) || (d1 == 0 && inBounds(j, j1, i1)) || (d2 == 0 && inBounds(i, i1, j)) || (d3 == 0 && inBounds(i, i1, j1))) {
+                    return false;
+                }
+            }
+        }
+
+        // Clip ears from a counter-clockwise ordered vertex list
+        std::vector<unsigned int> remaining(n);
+        for (std::size_t i = 0; i < n; i++) {
+            remaining[i] = static_cast<unsigned int>(area > 0 ? i : n - 1 - i);
+        }
+        std::vector<unsigned int>& indices = triangulatedRing.indices;
+        indices.clear();
+        indices.reserve((n - 2) * 3);
+        std::size_t start = 0;
+        while (remaining.size() > 3) {
+            std::size_t m = remaining.size();
+            bool clipped = false;
+            for (std::size_t t = 0; t < m && !clipped; t++) {
+                std::size_t k = (start + t) % m;
+                unsigned int prev = remaining[(k + m - 1) % m];
+                unsigned int curr = remaining[k];
+                unsigned int next = remaining[(k + 1) % m];
+                if (orient(prev, curr, next) <= 0) {
+                    continue;
+                }
+                bool ear = true;
+                for (unsigned int other : remaining) {
+                    if (other != prev && other != curr && other != next && orient(prev, curr, other) >= 0 && orient(curr, next, other) >= 0 && orient(next, prev, other) >= 0) {
+                        ear = false;
+                        break;
+                    }
+                }
+                if (ear) {
+                    indices.insert(indices.end(), { prev, curr, next });
+                    remaining.erase(remaining.begin() + k);
+                    start = k % remaining.size();
+                    clipped = true;
+                }
+            }
+            if (!clipped) {
+                return false;
+            }
+        }
+        indices.insert(indices.end(), { remaining[0], remaining[1], remaining[2] });
+        return true;
+    }
+
+    const int PolygonDrawData::PLANAR_TRIANGULATION_PART = -1;
+
+    const std::size_t PolygonDrawData::MAX_EAR_CLIPPING_VERTICES = 64;
     
 }
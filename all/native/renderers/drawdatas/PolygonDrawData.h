@@ -8,6 +8,7 @@
 #define _CARTO_POLYGONDRAWDATA_H_
 
 #include "renderers/drawdatas/VectorElementDrawData.h"
+#include "renderers/utils/TesselationCache.h"
 
 #include <memory>
 #include <vector>
@@ -32,7 +33,9 @@ namespace carto {
     
         const cglib::bbox3<double>& getBoundingBox() const;
     
-        const std::vector<std::vector<cglib::vec3<double> > >& getCoords() const;
+        const cglib::vec3<double>& getOrigin() const;
+
+        const std::vector<std::vector<cglib::vec3<float> > >& getCoords() const;
     
         const std::vector<std::vector<unsigned int> >& getIndices() const;
     
@@ -41,11 +44,20 @@ namespace carto {
         virtual void offsetHorizontally(double offset);
     
     private:
+        static std::shared_ptr<TesselationCache::TesselatedGeometry> TesselatePolygon(const PolygonGeometry& geometry, const Projection& projection, const ProjectionSurface& projectionSurface);
+        static std::shared_ptr<TesselationCache::TesselatedGeometry> TriangulatePolygon(const PolygonGeometry& geometry, const Projection& projection);
+        static bool TriangulateSimpleRing(const std::vector<MapPos>& ring, TesselationCache::TesselatedGeometry& triangulatedRing);
+
+        static const int PLANAR_TRIANGULATION_PART;
+        static const std::size_t MAX_EAR_CLIPPING_VERTICES;
+
         std::shared_ptr<Bitmap> _bitmap;
     
         cglib::bbox3<double> _boundingBox;
     
-        std::vector<std::vector<cglib::vec3<double> > > _coords;
+        // Vertex coordinates are stored as single precision offsets relative to the origin
+        cglib::vec3<double> _origin;
+        std::vector<std::vector<cglib::vec3<float> > > _coords;
 
         std::vector<std::vector<unsigned int> > _indices;
     
@@ -4,24 +4,27 @@
 #include "renderers/utils/Texture.h"
 #include "utils/Log.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace carto {
     
     BitmapTextureCache::~BitmapTextureCache() {
+        _memoryConsumer->detach();
     }
     
     std::size_t BitmapTextureCache::getCapacity() const {
-        std::lock_guard<std::mutex> lock(_mutex);
-        return _cache.capacity();
+        return _memoryConsumer->getCapacity();
     }
     
     void BitmapTextureCache::setCapacity(std::size_t capacityInBytes) {
-        std::lock_guard<std::mutex> lock(_mutex);
-        _cache.resize(capacityInBytes);
+        _memoryConsumer->setCapacity(capacityInBytes);
     }
 
     void BitmapTextureCache::clear() {
         std::lock_guard<std::mutex> lock(_mutex);
         _cache.clear();
+        releaseAtlasPages();
     }
         
     std::shared_ptr<Texture> BitmapTextureCache::get(const std::shared_ptr<Bitmap>& bitmap) const {
@@ -33,11 +36,27 @@ namespace carto {
         return (texture && texture->isValid() ? texture : std::shared_ptr<Texture>());
     }
     
-    BitmapTextureCache::BitmapTextureCache(const std::weak_ptr<GLResourceManager>& manager, std::size_t capacityInBytes) :
+    BitmapTextureCache::BitmapTextureCache(const std::weak_ptr<GLResourceManager>& manager, std::size_t capacityInBytes, bool atlas) :
         GLResource(manager),
         _cache(capacityInBytes),
+        _atlas(atlas),
+        _atlasPages(),
+        _atlasEntries(),
+        _releasedAtlasTexIds(),
+        _memoryConsumer(),
         _mutex()
     {
+        _memoryConsumer = MemoryGovernor::GetInstance().registerConsumer(capacityInBytes, 1.0f,
+            [this](std::size_t budget) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _cache.resize(budget);
+            },
+            [this](bool critical) {
+                if (critical) {
+                    clear();
+                }
+            }
+        );
     }
     
     std::shared_ptr<Texture> BitmapTextureCache::create(const std::shared_ptr<Bitmap>& bitmap, bool genMipmaps, bool repeat) {
@@ -56,14 +75,194 @@ namespace carto {
         return texture;
     }
         
+    BitmapTextureCache::TextureRegion BitmapTextureCache::getTextureRegion(const std::shared_ptr<Bitmap>& bitmap, bool genMipmaps) {
+        TextureRegion region;
+        if (_atlas && bitmap->getWidth() <= MAX_ATLAS_BITMAP_SIZE && bitmap->getHeight() <= MAX_ATLAS_BITMAP_SIZE) {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            if (!_releasedAtlasTexIds.empty()) {
+                glDeleteTextures(static_cast<GLsizei>(_releasedAtlasTexIds.size()), _releasedAtlasTexIds.data());
+                _releasedAtlasTexIds.clear();
+            }
+
+            AtlasEntry entry;
+            auto it = _atlasEntries.find(bitmap.get());
+            if (it != _atlasEntries.end() && it->second.bitmap.lock() == bitmap && _atlasPages[it->second.pageIndex].mipmaps == genMipmaps) {
+                entry = it->second;
+            } else if (!insertAtlasBitmap(bitmap, genMipmaps, entry)) {
+                entry.pageIndex = std::numeric_limits<std::size_t>::max();
+            }
+
+            if (entry.pageIndex < _atlasPages.size()) {
+                float scale = 1.0f / ATLAS_PAGE_SIZE;
+                region.texId = _atlasPages[entry.pageIndex].texId;
+                region.texCoordOffset = cglib::vec2<float>(entry.x * scale, entry.y * scale);
+                region.texCoordScale = cglib::vec2<float>(bitmap->getWidth() * scale, bitmap->getHeight() * scale);
+                return region;
+            }
+        }
+
+        // The bitmap is not in the atlas, use a separate texture
+        region.texture = get(bitmap);
+        if (!region.texture) {
+            region.texture = create(bitmap, genMipmaps, false);
+        }
+        if (region.texture) {
+            region.texId = region.texture->getTexId();
+            region.texCoordScale = region.texture->getTexCoordScale();
+        }
+        return region;
+    }
+        
     void BitmapTextureCache::create() {
         std::lock_guard<std::mutex> lock(_mutex);
         _cache.clear();
+        releaseAtlasPages();
     }
 
     void BitmapTextureCache::destroy() {
         std::lock_guard<std::mutex> lock(_mutex);
         _cache.clear();
+        releaseAtlasPages();
+        if (!_releasedAtlasTexIds.empty()) {
+            glDeleteTextures(static_cast<GLsizei>(_releasedAtlasTexIds.size()), _releasedAtlasTexIds.data());
+            _releasedAtlasTexIds.clear();
+        }
     }
 
+    bool BitmapTextureCache::insertAtlasBitmap(const std::shared_ptr<Bitmap>& bitmap, bool genMipmaps, AtlasEntry& entry) {
+        // Note: mutex must be locked by the caller
+        if (bitmap->getColorFormat() == ColorFormat::COLOR_FORMAT_UNSUPPORTED) {
+            return false;
+        }
+
+        // Each bitmap is surrounded by transparent padding, so that filtering does not bleed pixels of the neighbouring bitmaps
+        int width = static_cast<int>(bitmap->getWidth()) + 2 * ATLAS_PADDING;
+        int height = static_cast<int>(bitmap->getHeight()) + 2 * ATLAS_PADDING;
+        std::size_t pageIndex = 0;
+        int x = 0, y = 0;
+        for (; pageIndex < _atlasPages.size(); pageIndex++) {
+            if (_atlasPages[pageIndex].mipmaps == genMipmaps && AllocateAtlasRect(_atlasPages[pageIndex], width, height, x, y)) {
+                break;
+            }
+        }
+        if (pageIndex == _atlasPages.size()) {
+            if (_atlasPages.size() >= MAX_ATLAS_PAGES) {
+                return false;
+            }
+
+            AtlasPage page;
+            page.texId = CreateAtlasTexture(genMipmaps);
+            page.mipmaps = genMipmaps;
+            if (page.texId == 0 || !AllocateAtlasRect(page, width, height, x, y)) {
+                if (page.texId != 0) {
+                    glDeleteTextures(1, &page.texId);
+                }
+                return false;
+            }
+            _atlasPages.push_back(page);
+            setGPUMemoryUsage(GLMemoryCategory::GL_MEMORY_CATEGORY_TEXTURE, _atlasPages.size() * ATLAS_PAGE_SIZE * ATLAS_PAGE_SIZE * 4);
+        }
+
+        std::shared_ptr<Bitmap> rgbaBitmap = bitmap;
+        if (bitmap->getColorFormat() != ColorFormat::COLOR_FORMAT_RGBA) {
+            rgbaBitmap = bitmap->getRGBABitmap();
+        }
+
+        GLint oldTexId = 0;
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &oldTexId);
+
+        glBindTexture(GL_TEXTURE_2D, _atlasPages[pageIndex].texId);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x + ATLAS_PADDING, y + ATLAS_PADDING, rgbaBitmap->getWidth(), rgbaBitmap->getHeight(),
+                GL_RGBA, GL_UNSIGNED_BYTE, rgbaBitmap->getPixelData().data());
+        if (genMipmaps) {
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+
+        glBindTexture(GL_TEXTURE_2D, oldTexId);
+
+        GLContext::CheckGLError("BitmapTextureCache::insertAtlasBitmap");
+
+        entry.bitmap = bitmap;
+        entry.pageIndex = pageIndex;
+        entry.x = x + ATLAS_PADDING;
+        entry.y = y + ATLAS_PADDING;
+        _atlasEntries[bitmap.get()] = entry;
+        return true;
+    }
+
+    void BitmapTextureCache::releaseAtlasPages() {
+        // Note: mutex must be locked by the caller. This may be called from any thread, so the textures are deleted later.
+        for (const AtlasPage& page : _atlasPages) {
+            _releasedAtlasTexIds.push_back(page.texId);
+        }
+        _atlasPages.clear();
+        _atlasEntries.clear();
+        setGPUMemoryUsage(GLMemoryCategory::GL_MEMORY_CATEGORY_TEXTURE, 0);
+    }
+
+    bool BitmapTextureCache::AllocateAtlasRect(AtlasPage& page, int width, int height, int& x, int& y) {
+        if (width > ATLAS_PAGE_SIZE || height > ATLAS_PAGE_SIZE) {
+            return false;
+        }
+
+        // Find the lowest shelf that has enough space, to keep the wasted space small
+        AtlasShelf* bestShelf = nullptr;
+        for (AtlasShelf& shelf : page.shelves) {
+            if (shelf.height >= height && shelf.x + width <= ATLAS_PAGE_SIZE) {
+                if (!bestShelf || shelf.height < bestShelf->height) {
+                    bestShelf = &shelf;
+                }
+            }
+        }
+
+        // Start a new shelf if no existing shelf fits the rectangle well
+        if ((!bestShelf || bestShelf->height > height * 2) && page.shelfY + height <= ATLAS_PAGE_SIZE) {
+            page.shelves.emplace_back(0, page.shelfY, height);
+            page.shelfY += height;
+            bestShelf = &page.shelves.back();
+        }
+        if (!bestShelf) {
+            return false;
+        }
+
+        x = bestShelf->x;
+        y = bestShelf->y;
+        bestShelf->x += width;
+        return true;
+    }
+
+    GLuint BitmapTextureCache::CreateAtlasTexture(bool genMipmaps) {
+        GLint oldTexId = 0;
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &oldTexId);
+
+        GLuint texId = 0;
+        glGenTextures(1, &texId);
+        glBindTexture(GL_TEXTURE_2D, texId);
+
+        std::vector<unsigned char> pixelData(ATLAS_PAGE_SIZE * ATLAS_PAGE_SIZE * 4, 0);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixelData.data());
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, genMipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        if (genMipmaps) {
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+
+        glBindTexture(GL_TEXTURE_2D, oldTexId);
+
+        GLContext::CheckGLError("BitmapTextureCache::CreateAtlasTexture");
+        return texId;
+    }
+
+    const int BitmapTextureCache::ATLAS_PAGE_SIZE = 1024;
+
+    const int BitmapTextureCache::ATLAS_PADDING = 4;
+
+    const unsigned int BitmapTextureCache::MAX_ATLAS_BITMAP_SIZE = 128;
+
+    const std::size_t BitmapTextureCache::MAX_ATLAS_PAGES = 2;
+
 }
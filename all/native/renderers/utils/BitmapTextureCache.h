@@ -7,19 +7,33 @@
 #ifndef _CARTO_BITMAPTEXTURECACHE_H_
 #define _CARTO_BITMAPTEXTURECACHE_H_
 
+#include "components/MemoryGovernor.h"
 #include "renderers/utils/GLResource.h"
 
 #include <memory>
 #include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include <stdext/timed_lru_cache.h>
 
+#include <cglib/vec.h>
+
 namespace carto {
     class Bitmap;
     class Texture;
     
     class BitmapTextureCache : public GLResource {
     public:
+        struct TextureRegion {
+            std::shared_ptr<Texture> texture; // null if the region is in an atlas page
+            GLuint texId;
+            cglib::vec2<float> texCoordOffset;
+            cglib::vec2<float> texCoordScale;
+
+            TextureRegion() : texture(), texId(0), texCoordOffset(0.0f, 0.0f), texCoordScale(1.0f, 1.0f) { }
+        };
+
         virtual ~BitmapTextureCache();
         
         std::size_t getCapacity() const;
@@ -29,17 +43,65 @@ namespace carto {
 
         std::shared_ptr<Texture> get(const std::shared_ptr<Bitmap>& bitmap) const;
         std::shared_ptr<Texture> create(const std::shared_ptr<Bitmap>& bitmap, bool genMipmaps, bool repeat);
+
+        // Must be called from the GL thread. If atlas mode is enabled, small bitmaps are packed into shared atlas pages,
+        // other bitmaps get their own textures.
+        TextureRegion getTextureRegion(const std::shared_ptr<Bitmap>& bitmap, bool genMipmaps);
     
     protected:
         friend GLResourceManager;
 
-        BitmapTextureCache(const std::weak_ptr<GLResourceManager>& manager, std::size_t capacityInBytes);
+        BitmapTextureCache(const std::weak_ptr<GLResourceManager>& manager, std::size_t capacityInBytes, bool atlas = false);
 
         virtual void create();
         virtual void destroy();
 
     private:
+        struct AtlasShelf {
+            int x;
+            int y;
+            int height;
+
+            AtlasShelf(int x, int y, int height) : x(x), y(y), height(height) { }
+        };
+
+        struct AtlasPage {
+            GLuint texId;
+            bool mipmaps;
+            std::vector<AtlasShelf> shelves;
+            int shelfY;
+
+            AtlasPage() : texId(0), mipmaps(false), shelves(), shelfY(0) { }
+        };
+
+        struct AtlasEntry {
+            std::weak_ptr<Bitmap> bitmap;
+            std::size_t pageIndex;
+            int x;
+            int y;
+
+            AtlasEntry() : bitmap(), pageIndex(0), x(0), y(0) { }
+        };
+
+        static const int ATLAS_PAGE_SIZE;
+        static const int ATLAS_PADDING;
+        static const unsigned int MAX_ATLAS_BITMAP_SIZE;
+        static const std::size_t MAX_ATLAS_PAGES;
+
+        bool insertAtlasBitmap(const std::shared_ptr<Bitmap>& bitmap, bool genMipmaps, AtlasEntry& entry);
+        void releaseAtlasPages();
+
+        static bool AllocateAtlasRect(AtlasPage& page, int width, int height, int& x, int& y);
+        static GLuint CreateAtlasTexture(bool genMipmaps);
+
         mutable cache::timed_lru_cache<std::shared_ptr<Bitmap>, std::shared_ptr<Texture> > _cache;
+
+        bool _atlas;
+        std::vector<AtlasPage> _atlasPages;
+        std::unordered_map<const Bitmap*, AtlasEntry> _atlasEntries;
+        std::vector<GLuint> _releasedAtlasTexIds; // textures of cleared pages, deleted on the GL thread
+
+        std::shared_ptr<MemoryGovernor::Consumer> _memoryConsumer;
         
         mutable std::mutex _mutex;
     };
@@ -75,6 +75,9 @@ namespace carto {
             GLint oldRBId = 0;
             glGetIntegerv(GL_FRAMEBUFFER_BINDING, &oldRBId);
 
+            std::size_t pixelCount = static_cast<std::size_t>(_width) * _height;
+            std::size_t sizeInBytes = 0;
+
             if (_depth && _stencil && GLContext::PACKED_DEPTH_STENCIL) {
                 GLuint depthStencilRBId = 0;
                 glGenRenderbuffers(1, &depthStencilRBId);
@@ -84,6 +87,7 @@ namespace carto {
                 glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthStencilRBId);
                 glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthStencilRBId);
                 _depthStencilRBIds.push_back(depthStencilRBId);
+                sizeInBytes += pixelCount * 4;
             } else {
                 if (_depth) {
                     GLuint depthRBId = 0;
@@ -93,6 +97,7 @@ namespace carto {
                     glBindRenderbuffer(GL_RENDERBUFFER, oldRBId);
                     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRBId);
                     _depthStencilRBIds.push_back(depthRBId);
+                    sizeInBytes += pixelCount * 2;
                 }
                 if (_stencil) {
                     GLuint stencilRBId = 0;
@@ -102,6 +107,7 @@ namespace carto {
                     glBindRenderbuffer(GL_RENDERBUFFER, oldRBId);
                     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, stencilRBId);
                     _depthStencilRBIds.push_back(stencilRBId);
+                    sizeInBytes += pixelCount;
                 }
             }
 
@@ -118,6 +124,7 @@ namespace carto {
                 glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
                 glBindTexture(GL_TEXTURE_2D, oldTexId);
                 glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _colorTexId, 0);
+                sizeInBytes += pixelCount * 4;
             }
 
             if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
@@ -125,6 +132,7 @@ namespace carto {
             }
 
             glBindFramebuffer(GL_FRAMEBUFFER, oldFBOId);
+            setGPUMemoryUsage(GLMemoryCategory::GL_MEMORY_CATEGORY_FRAME_BUFFER, sizeInBytes);
 
             GLContext::CheckGLError("FrameBuffer::create");
         }
@@ -144,6 +152,7 @@ namespace carto {
                 glDeleteTextures(1, &_colorTexId);
                 _colorTexId = 0;
             }
+            setGPUMemoryUsage(GLMemoryCategory::GL_MEMORY_CATEGORY_FRAME_BUFFER, 0);
 
             GLContext::CheckGLError("FrameBuffer::destroy");
         }
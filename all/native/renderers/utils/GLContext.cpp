@@ -2,6 +2,8 @@
 #include "utils/Log.h"
 #include "utils/GeneralUtils.h"
 
+#include <cstring>
+
 #include <EGL/egl.h>
 
 namespace carto {
@@ -41,6 +43,65 @@ namespace carto {
 #endif
 
         PACKED_DEPTH_STENCIL = HasGLExtension("GL_OES_packed_depth_stencil");
+
+        // ETC2 is part of the core GLES 3.0 API, other formats are optional extensions
+        const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+        GLES3 = version && std::strncmp(version, "OpenGL ES ", 10) == 0 && version[10] >= '3' && version[10] <= '9';
+        TEXTURE_COMPRESSION_ETC2 = GLES3 || HasGLExtension("GL_ARB_ES3_compatibility");
+        TEXTURE_COMPRESSION_ASTC = HasGLExtension("GL_KHR_texture_compression_astc_ldr");
+        TEXTURE_COMPRESSION_S3TC = HasGLExtension("GL_EXT_texture_compression_s3tc") || (HasGLExtension("GL_EXT_texture_compression_dxt1") && HasGLExtension("GL_ANGLE_texture_compression_dxt5"));
+
+        // Pixel pack buffers and fences are part of the core GLES 3.0 API
+        PIXEL_BUFFER_OBJECT = false;
+        if (GLES3) {
+            _MapBufferRange = reinterpret_cast<MapBufferRangeProc>(eglGetProcAddress("glMapBufferRange"));
+            _UnmapBuffer = reinterpret_cast<UnmapBufferProc>(eglGetProcAddress("glUnmapBuffer"));
+            _FenceSync = reinterpret_cast<FenceSyncProc>(eglGetProcAddress("glFenceSync"));
+            _ClientWaitSync = reinterpret_cast<ClientWaitSyncProc>(eglGetProcAddress("glClientWaitSync"));
+            _DeleteSync = reinterpret_cast<DeleteSyncProc>(eglGetProcAddress("glDeleteSync"));
+            PIXEL_BUFFER_OBJECT = _MapBufferRange && _UnmapBuffer && _FenceSync && _ClientWaitSync && _DeleteSync;
+        }
+
+        // Program binaries are part of the core GLES 3.0 API, with GLES 2.0 an extension is needed. Drivers may support no binary formats at all.
+        PROGRAM_BINARY = false;
+        if (GLES3) {
+            _GetProgramBinary = reinterpret_cast<GetProgramBinaryProc>(eglGetProcAddress("glGetProgramBinary"));
+            _ProgramBinary = reinterpret_cast<ProgramBinaryProc>(eglGetProcAddress("glProgramBinary"));
+        } else if (HasGLExtension("GL_OES_get_program_binary")) {
+            _GetProgramBinary = reinterpret_cast<GetProgramBinaryProc>(eglGetProcAddress("glGetProgramBinaryOES"));
+            _ProgramBinary = reinterpret_cast<ProgramBinaryProc>(eglGetProcAddress("glProgramBinaryOES"));
+        }
+        if (_GetProgramBinary && _ProgramBinary) {
+            GLint formatCount = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formatCount);
+            PROGRAM_BINARY = formatCount > 0;
+        }
+
+        // Instanced drawing is part of the core GLES 3.0 API, with GLES 2.0 an extension is needed
+        if (GLES3) {
+            _DrawElementsInstanced = reinterpret_cast<DrawElementsInstancedProc>(eglGetProcAddress("glDrawElementsInstanced"));
+            _VertexAttribDivisor = reinterpret_cast<VertexAttribDivisorProc>(eglGetProcAddress("glVertexAttribDivisor"));
+        } else if (HasGLExtension("GL_EXT_instanced_arrays")) {
+            _DrawElementsInstanced = reinterpret_cast<DrawElementsInstancedProc>(eglGetProcAddress("glDrawElementsInstancedEXT"));
+            _VertexAttribDivisor = reinterpret_cast<VertexAttribDivisorProc>(eglGetProcAddress("glVertexAttribDivisorEXT"));
+        } else if (HasGLExtension("GL_ANGLE_instanced_arrays")) {
+            _DrawElementsInstanced = reinterpret_cast<DrawElementsInstancedProc>(eglGetProcAddress("glDrawElementsInstancedANGLE"));
+            _VertexAttribDivisor = reinterpret_cast<VertexAttribDivisorProc>(eglGetProcAddress("glVertexAttribDivisorANGLE"));
+        }
+        INSTANCED_ARRAYS = _DrawElementsInstanced && _VertexAttribDivisor;
+
+#ifdef GL_EXT_disjoint_timer_query
+        TIMER_QUERY = HasGLExtension("GL_EXT_disjoint_timer_query");
+        if (TIMER_QUERY) {
+            _GenQueriesEXT = reinterpret_cast<PFNGLGENQUERIESEXTPROC>(eglGetProcAddress("glGenQueriesEXT"));
+            _DeleteQueriesEXT = reinterpret_cast<PFNGLDELETEQUERIESEXTPROC>(eglGetProcAddress("glDeleteQueriesEXT"));
+            _BeginQueryEXT = reinterpret_cast<PFNGLBEGINQUERYEXTPROC>(eglGetProcAddress("glBeginQueryEXT"));
+            _EndQueryEXT = reinterpret_cast<PFNGLENDQUERYEXTPROC>(eglGetProcAddress("glEndQueryEXT"));
+            _GetQueryObjectuivEXT = reinterpret_cast<PFNGLGETQUERYOBJECTUIVEXTPROC>(eglGetProcAddress("glGetQueryObjectuivEXT"));
+            _GetQueryObjectui64vEXT = reinterpret_cast<PFNGLGETQUERYOBJECTUI64VEXTPROC>(eglGetProcAddress("glGetQueryObjectui64vEXT"));
+            TIMER_QUERY = _GenQueriesEXT && _DeleteQueriesEXT && _BeginQueryEXT && _EndQueryEXT && _GetQueryObjectuivEXT && _GetQueryObjectui64vEXT;
+        }
+#endif
     }
         
     void GLContext::CheckGLError(const char* place) {
@@ -59,6 +120,144 @@ namespace carto {
 #endif
     }
     
+    void GLContext::GenQueriesEXT(GLsizei n, GLuint* ids) {
+        std::lock_guard<std::recursive_mutex> lock(_Mutex);
+
+#ifdef GL_EXT_disjoint_timer_query
+        if (_GenQueriesEXT) {
+            _GenQueriesEXT(n, ids);
+        }
+#endif
+    }
+
+    void GLContext::DeleteQueriesEXT(GLsizei n, const GLuint* ids) {
+        std::lock_guard<std::recursive_mutex> lock(_Mutex);
+
+#ifdef GL_EXT_disjoint_timer_query
+        if (_DeleteQueriesEXT) {
+            _DeleteQueriesEXT(n, ids);
+        }
+#endif
+    }
+
+    void GLContext::BeginQueryEXT(GLenum target, GLuint id) {
+        std::lock_guard<std::recursive_mutex> lock(_Mutex);
+
+#ifdef GL_EXT_disjoint_timer_query
+        if (_BeginQueryEXT) {
+            _BeginQueryEXT(target, id);
+        }
+#endif
+    }
+
+    void GLContext::EndQueryEXT(GLenum target) {
+        std::lock_guard<std::recursive_mutex> lock(_Mutex);
+
+#ifdef GL_EXT_disjoint_timer_query
+        if (_EndQueryEXT) {
+            _EndQueryEXT(target);
+        }
+#endif
+    }
+
+    void GLContext::GetQueryObjectuivEXT(GLuint id, GLenum pname, GLuint* params) {
+        std::lock_guard<std::recursive_mutex> lock(_Mutex);
+
+#ifdef GL_EXT_disjoint_timer_query
+        if (_GetQueryObjectuivEXT) {
+            _GetQueryObjectuivEXT(id, pname, params);
+        }
+#endif
+    }
+
+    void GLContext::GetQueryObjectui64vEXT(GLuint id, GLenum pname, GLuint64* params) {
+        std::lock_guard<std::recursive_mutex> lock(_Mutex);
+
+#ifdef GL_EXT_disjoint_timer_query
+        if (_GetQueryObjectui64vEXT) {
+            _GetQueryObjectui64vEXT(id, pname, params);
+        }
+#endif
+    }
+    
+    void* GLContext::MapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+        std::lock_guard<std::recursive_mutex> lock(_Mutex);
+
+        if (_MapBufferRange) {
+            return _MapBufferRange(target, offset, length, access);
+        }
+        return nullptr;
+    }
+
+    GLboolean GLContext::UnmapBuffer(GLenum target) {
+        std::lock_guard<std::recursive_mutex> lock(_Mutex);
+
+        if (_UnmapBuffer) {
+            return _UnmapBuffer(target);
+        }
+        return GL_FALSE;
+    }
+
+    void* GLContext::FenceSync(GLenum condition, GLbitfield flags) {
+        std::lock_guard<std::recursive_mutex> lock(_Mutex);
+
+        if (_FenceSync) {
+            return _FenceSync(condition, flags);
+        }
+        return nullptr;
+    }
+
+    GLenum GLContext::ClientWaitSync(void* sync, GLbitfield flags, GLuint64 timeout) {
+        std::lock_guard<std::recursive_mutex> lock(_Mutex);
+
+        if (_ClientWaitSync) {
+            return _ClientWaitSync(sync, flags, timeout);
+        }
+        return GL_TIMEOUT_EXPIRED;
+    }
+
+    void GLContext::DeleteSync(void* sync) {
+        std::lock_guard<std::recursive_mutex> lock(_Mutex);
+
+        if (_DeleteSync) {
+            _DeleteSync(sync);
+        }
+    }
+    
+    void GLContext::GetProgramBinary(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary) {
+        std::lock_guard<std::recursive_mutex> lock(_Mutex);
+
+        if (_GetProgramBinary) {
+            _GetProgramBinary(program, bufSize, length, binaryFormat, binary);
+        } else if (length) {
+            *length = 0;
+        }
+    }
+
+    void GLContext::ProgramBinary(GLuint program, GLenum binaryFormat, const void* binary, GLint length) {
+        std::lock_guard<std::recursive_mutex> lock(_Mutex);
+
+        if (_ProgramBinary) {
+            _ProgramBinary(program, binaryFormat, binary, length);
+        }
+    }
+    
+    void GLContext::DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount) {
+        std::lock_guard<std::recursive_mutex> lock(_Mutex);
+
+        if (_DrawElementsInstanced) {
+            _DrawElementsInstanced(mode, count, type, indices, instanceCount);
+        }
+    }
+
+    void GLContext::VertexAttribDivisor(GLuint index, GLuint divisor) {
+        std::lock_guard<std::recursive_mutex> lock(_Mutex);
+
+        if (_VertexAttribDivisor) {
+            _VertexAttribDivisor(index, divisor);
+        }
+    }
+    
     GLContext::GLContext() {
     }
     
@@ -69,6 +268,20 @@ namespace carto {
     bool GLContext::DISCARD_FRAMEBUFFER = false;
 
     bool GLContext::PACKED_DEPTH_STENCIL = false;
+
+    bool GLContext::TIMER_QUERY = false;
+
+    bool GLContext::GLES3 = false;
+
+    bool GLContext::PIXEL_BUFFER_OBJECT = false;
+
+    bool GLContext::PROGRAM_BINARY = false;
+
+    bool GLContext::INSTANCED_ARRAYS = false;
+
+    bool GLContext::TEXTURE_COMPRESSION_ETC2 = false;
+    bool GLContext::TEXTURE_COMPRESSION_ASTC = false;
+    bool GLContext::TEXTURE_COMPRESSION_S3TC = false;
     
     std::size_t GLContext::MAX_VERTEXBUFFER_SIZE = 65535; // Should NOT exceed 64k!
 
@@ -76,6 +289,27 @@ namespace carto {
     PFNGLDISCARDFRAMEBUFFEREXTPROC GLContext::_DiscardFramebufferEXT = nullptr;
 #endif
 
+#ifdef GL_EXT_disjoint_timer_query
+    PFNGLGENQUERIESEXTPROC GLContext::_GenQueriesEXT = nullptr;
+    PFNGLDELETEQUERIESEXTPROC GLContext::_DeleteQueriesEXT = nullptr;
+    PFNGLBEGINQUERYEXTPROC GLContext::_BeginQueryEXT = nullptr;
+    PFNGLENDQUERYEXTPROC GLContext::_EndQueryEXT = nullptr;
+    PFNGLGETQUERYOBJECTUIVEXTPROC GLContext::_GetQueryObjectuivEXT = nullptr;
+    PFNGLGETQUERYOBJECTUI64VEXTPROC GLContext::_GetQueryObjectui64vEXT = nullptr;
+#endif
+
+    GLContext::MapBufferRangeProc GLContext::_MapBufferRange = nullptr;
+    GLContext::UnmapBufferProc GLContext::_UnmapBuffer = nullptr;
+    GLContext::FenceSyncProc GLContext::_FenceSync = nullptr;
+    GLContext::ClientWaitSyncProc GLContext::_ClientWaitSync = nullptr;
+    GLContext::DeleteSyncProc GLContext::_DeleteSync = nullptr;
+
+    GLContext::GetProgramBinaryProc GLContext::_GetProgramBinary = nullptr;
+    GLContext::ProgramBinaryProc GLContext::_ProgramBinary = nullptr;
+
+    GLContext::DrawElementsInstancedProc GLContext::_DrawElementsInstanced = nullptr;
+    GLContext::VertexAttribDivisorProc GLContext::_VertexAttribDivisor = nullptr;
+
     std::unordered_set<std::string> GLContext::_ExtensionCache;
         
     std::recursive_mutex GLContext::_Mutex;
@@ -10,6 +10,31 @@
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
 
+// GLES 3.0 constants used with the dynamically loaded GLES 3.0 functions
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ 0x88E1
+#endif
+#ifndef GL_MAP_READ_BIT
+#define GL_MAP_READ_BIT 0x0001
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+#ifndef GL_TIMEOUT_EXPIRED
+#define GL_TIMEOUT_EXPIRED 0x911B
+#endif
+
+// Program binary constants, shared by GLES 3.0 and GL_OES_get_program_binary
+#ifndef GL_PROGRAM_BINARY_LENGTH_OES
+#define GL_PROGRAM_BINARY_LENGTH_OES 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS_OES
+#define GL_NUM_PROGRAM_BINARY_FORMATS_OES 0x87FE
+#endif
+
 #include <mutex>
 #include <string>
 #include <unordered_set>
@@ -27,6 +52,20 @@ namespace carto {
 
         static bool PACKED_DEPTH_STENCIL;
 
+        static bool TIMER_QUERY;
+
+        static bool GLES3;
+
+        static bool PIXEL_BUFFER_OBJECT;
+
+        static bool PROGRAM_BINARY;
+
+        static bool INSTANCED_ARRAYS;
+
+        static bool TEXTURE_COMPRESSION_ETC2;
+        static bool TEXTURE_COMPRESSION_ASTC;
+        static bool TEXTURE_COMPRESSION_S3TC;
+
         static std::size_t MAX_VERTEXBUFFER_SIZE;
     
         static bool HasGLExtension(const char* extension);
@@ -36,14 +75,65 @@ namespace carto {
         static void CheckGLError(const char* place);
 
         static void DiscardFramebufferEXT(GLenum target, GLsizei numAttachments, const GLenum* attachments);
+
+        static void GenQueriesEXT(GLsizei n, GLuint* ids);
+        static void DeleteQueriesEXT(GLsizei n, const GLuint* ids);
+        static void BeginQueryEXT(GLenum target, GLuint id);
+        static void EndQueryEXT(GLenum target);
+        static void GetQueryObjectuivEXT(GLuint id, GLenum pname, GLuint* params);
+        static void GetQueryObjectui64vEXT(GLuint id, GLenum pname, GLuint64* params);
+
+        static void* MapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+        static GLboolean UnmapBuffer(GLenum target);
+        static void* FenceSync(GLenum condition, GLbitfield flags);
+        static GLenum ClientWaitSync(void* sync, GLbitfield flags, GLuint64 timeout);
+        static void DeleteSync(void* sync);
+
+        static void GetProgramBinary(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+        static void ProgramBinary(GLuint program, GLenum binaryFormat, const void* binary, GLint length);
+
+        static void DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount);
+        static void VertexAttribDivisor(GLuint index, GLuint divisor);
     
     private:
+        // GLES 3.0 entry points are not declared by the GLES 2.0 headers, sync objects are passed as opaque pointers
+        typedef void* (GL_APIENTRYP MapBufferRangeProc)(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+        typedef GLboolean (GL_APIENTRYP UnmapBufferProc)(GLenum target);
+        typedef void* (GL_APIENTRYP FenceSyncProc)(GLenum condition, GLbitfield flags);
+        typedef GLenum (GL_APIENTRYP ClientWaitSyncProc)(void* sync, GLbitfield flags, GLuint64 timeout);
+        typedef void (GL_APIENTRYP DeleteSyncProc)(void* sync);
+        typedef void (GL_APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+        typedef void (GL_APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLint length);
+        typedef void (GL_APIENTRYP DrawElementsInstancedProc)(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount);
+        typedef void (GL_APIENTRYP VertexAttribDivisorProc)(GLuint index, GLuint divisor);
+
         GLContext();
 
 #ifdef GL_EXT_discard_framebuffer
         static PFNGLDISCARDFRAMEBUFFEREXTPROC _DiscardFramebufferEXT;
 #endif
 
+#ifdef GL_EXT_disjoint_timer_query
+        static PFNGLGENQUERIESEXTPROC _GenQueriesEXT;
+        static PFNGLDELETEQUERIESEXTPROC _DeleteQueriesEXT;
+        static PFNGLBEGINQUERYEXTPROC _BeginQueryEXT;
+        static PFNGLENDQUERYEXTPROC _EndQueryEXT;
+        static PFNGLGETQUERYOBJECTUIVEXTPROC _GetQueryObjectuivEXT;
+        static PFNGLGETQUERYOBJECTUI64VEXTPROC _GetQueryObjectui64vEXT;
+#endif
+
+        static MapBufferRangeProc _MapBufferRange;
+        static UnmapBufferProc _UnmapBuffer;
+        static FenceSyncProc _FenceSync;
+        static ClientWaitSyncProc _ClientWaitSync;
+        static DeleteSyncProc _DeleteSync;
+
+        static GetProgramBinaryProc _GetProgramBinary;
+        static ProgramBinaryProc _ProgramBinary;
+
+        static DrawElementsInstancedProc _DrawElementsInstanced;
+        static VertexAttribDivisorProc _VertexAttribDivisor;
+
         static std::unordered_set<std::string> _ExtensionCache;
     
         static std::recursive_mutex _Mutex;
@@ -1,6 +1,7 @@
 #include "GLResource.h"
 #include "renderers/utils/GLResourceManager.h"
 
+#include <mutex>
 #include <thread>
 
 namespace carto {
@@ -14,10 +15,34 @@ namespace carto {
         }
         return false;
     }
+
+    std::size_t GLResource::getGPUMemoryUsage() const {
+        if (auto manager = _manager.lock()) {
+            std::lock_guard<std::mutex> lock(manager->_mutex);
+            return _memoryUsage;
+        }
+        return _memoryUsage;
+    }
       
     GLResource::GLResource(const std::weak_ptr<GLResourceManager>& manager) :
-        _manager(manager)
+        _manager(manager),
+        _memoryCategory(GLMemoryCategory::GL_MEMORY_CATEGORY_TEXTURE),
+        _memoryUsage(0)
     {
     }
 
+    bool GLResource::createStep() {
+        create();
+        return true;
+    }
+
+    void GLResource::setGPUMemoryUsage(GLMemoryCategory::GLMemoryCategory category, std::size_t size) {
+        if (auto manager = _manager.lock()) {
+            manager->updateGPUMemoryUsage(*this, category, size);
+        } else {
+            _memoryCategory = category;
+            _memoryUsage = size;
+        }
+    }
+
 }
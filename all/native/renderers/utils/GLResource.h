@@ -9,17 +9,34 @@
 
 #include "renderers/utils/GLContext.h"
 
+#include <cstddef>
 #include <memory>
 #include <vector>
 
 namespace carto {
     class GLResourceManager;
     
+    namespace GLMemoryCategory {
+        /**
+         * Categories used for GPU memory accounting.
+         */
+        enum GLMemoryCategory {
+            GL_MEMORY_CATEGORY_TEXTURE,
+            GL_MEMORY_CATEGORY_FRAME_BUFFER,
+            GL_MEMORY_CATEGORY_VERTEX_BUFFER,
+            GL_MEMORY_CATEGORY_TILE,
+            GL_MEMORY_CATEGORY_MODEL,
+            GL_MEMORY_CATEGORY_COUNT
+        };
+    }
+    
     class GLResource {
     public:
         virtual ~GLResource();
         
         bool isValid() const;
+
+        std::size_t getGPUMemoryUsage() const;
         
     protected:
         friend class GLResourceManager;
@@ -27,9 +44,17 @@ namespace carto {
         GLResource(const std::weak_ptr<GLResourceManager>& manager);
 
         virtual void create() = 0;
+        virtual bool createStep();
         virtual void destroy() = 0;
 
+        // Reports the current GPU allocation of the resource to the manager. Resources should report 0 when destroyed.
+        void setGPUMemoryUsage(GLMemoryCategory::GLMemoryCategory category, std::size_t size);
+
         const std::weak_ptr<GLResourceManager> _manager;
+
+    private:
+        GLMemoryCategory::GLMemoryCategory _memoryCategory;
+        std::size_t _memoryUsage;
     };
     
 }
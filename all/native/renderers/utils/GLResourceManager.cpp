@@ -1,14 +1,21 @@
 #include "GLResourceManager.h"
+#include "components/MemoryGovernor.h"
 #include "utils/Log.h"
+#include "utils/TraceUtils.h"
+
+#include <algorithm>
 
 namespace carto {
 
     GLResourceManager::GLResourceManager() :
         _glThreadId(),
+        _shaderBinaryCache(),
         _createQueue(),
         _deleteQueue(),
+        _gpuMemoryUsage(),
         _mutex()
     {
+        _gpuMemoryUsage.fill(0);
     }
     
     GLResourceManager::~GLResourceManager() {
@@ -21,6 +28,13 @@ namespace carto {
         if (!_deleteQueue.empty()) {
             Log::Debugf("GLResourceManager::~GLResourceManager: Delete queue size: %d", static_cast<int>(_deleteQueue.size()));
         }
+
+        // Resources that were not destroyed are released together with the GL context
+        std::size_t totalSize = 0;
+        for (std::size_t size : _gpuMemoryUsage) {
+            totalSize += size;
+        }
+        MemoryGovernor::GetInstance().updateGPUMemoryUsage(totalSize, 0);
     }
 
     std::thread::id GLResourceManager::getGLThreadId() const {
@@ -32,30 +46,83 @@ namespace carto {
         std::lock_guard<std::mutex> lock(_mutex);
         _glThreadId = id;
     }
+
+    std::shared_ptr<ShaderBinaryCache> GLResourceManager::getShaderBinaryCache() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _shaderBinaryCache;
+    }
+
+    void GLResourceManager::setShaderBinaryCache(const std::shared_ptr<ShaderBinaryCache>& shaderBinaryCache) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _shaderBinaryCache = shaderBinaryCache;
+    }
     
-    void GLResourceManager::processResources() {
+    bool GLResourceManager::processResources(const std::chrono::steady_clock::duration& timeBudget) {
         if (std::this_thread::get_id() != getGLThreadId()) {
             Log::Warn("GLResourceManager::processResources: Method called from wrong thread!");
-            return;
+            return false;
         }
 
-        std::vector<std::weak_ptr<GLResource> > createQueue;
-        std::vector<std::unique_ptr<GLResource> > deleteQueue;
-        {
-            std::lock_guard<std::mutex> lock(_mutex);
-            std::swap(deleteQueue, _deleteQueue);
-            std::swap(createQueue, _createQueue);
-        }
-        for (const std::unique_ptr<GLResource>& resource : deleteQueue) {
+        CARTO_TRACE_SECTION("GLResourceManager::processResources");
+
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeBudget;
+
+        // Destroy resources first, so that GPU memory is released before new resources are created
+        while (true) {
+            std::unique_ptr<GLResource> resource;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (_deleteQueue.empty()) {
+                    break;
+                }
+                if (std::chrono::steady_clock::now() >= deadline) {
+                    return true;
+                }
+                resource = std::move(_deleteQueue.front());
+                _deleteQueue.pop_front();
+            }
             resource->destroy();
         }
-        for (const std::weak_ptr<GLResource>& resourceWeak : createQueue) {
-            if (auto resource = resourceWeak.lock()) {
-                resource->create();
+
+        // Create resources in the order they were registered. Always perform at least one creation step to guarantee progress.
+        for (bool first = true; ; first = false) {
+            std::shared_ptr<GLResource> resource;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (_createQueue.empty()) {
+                    return false;
+                }
+                if (!first && std::chrono::steady_clock::now() >= deadline) {
+                    return true;
+                }
+                resource = _createQueue.front().lock();
+                _createQueue.pop_front();
+            }
+            if (resource && !resource->createStep()) {
+                // Resource is only partially created, continue with it before other resources
+                std::lock_guard<std::mutex> lock(_mutex);
+                _createQueue.push_front(resource);
             }
         }
     }
 
+    std::size_t GLResourceManager::getGPUMemoryUsage(GLMemoryCategory::GLMemoryCategory category) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (category < 0 || category >= GLMemoryCategory::GL_MEMORY_CATEGORY_COUNT) {
+            return 0;
+        }
+        return _gpuMemoryUsage[category];
+    }
+
+    std::size_t GLResourceManager::getTotalGPUMemoryUsage() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::size_t totalSize = 0;
+        for (std::size_t size : _gpuMemoryUsage) {
+            totalSize += size;
+        }
+        return totalSize;
+    }
+
     std::shared_ptr<GLResource> GLResourceManager::registerResource(GLResource* resourcePtr) {
         std::shared_ptr<GLResource> resource;
         try {
@@ -89,4 +156,17 @@ namespace carto {
         }
     }
 
+    void GLResourceManager::updateGPUMemoryUsage(GLResource& resource, GLMemoryCategory::GLMemoryCategory category, std::size_t size) {
+        std::size_t oldSize = 0;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            oldSize = resource._memoryUsage;
+            _gpuMemoryUsage[resource._memoryCategory] -= std::min(oldSize, _gpuMemoryUsage[resource._memoryCategory]);
+            _gpuMemoryUsage[category] += size;
+            resource._memoryCategory = category;
+            resource._memoryUsage = size;
+        }
+        MemoryGovernor::GetInstance().updateGPUMemoryUsage(oldSize, size);
+    }
+
 }
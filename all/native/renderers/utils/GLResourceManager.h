@@ -9,12 +9,16 @@
 
 #include "renderers/utils/GLResource.h"
 
+#include <array>
+#include <chrono>
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
 
 namespace carto {
+    class ShaderBinaryCache;
 
     class GLResourceManager : public std::enable_shared_from_this<GLResourceManager> {
     public:
@@ -24,22 +28,49 @@ namespace carto {
         std::thread::id getGLThreadId() const;
         void setGLThreadId(std::thread::id id);
 
+        std::shared_ptr<ShaderBinaryCache> getShaderBinaryCache() const;
+        void setShaderBinaryCache(const std::shared_ptr<ShaderBinaryCache>& shaderBinaryCache);
+
         template <typename T, typename... Args>
         std::shared_ptr<T> create(Args&&... args) {
             std::weak_ptr<GLResourceManager> managerWeak(shared_from_this());
             return std::static_pointer_cast<T>(registerResource(new T(managerWeak, std::forward<Args>(args)...)));
         }
     
-        void processResources();
+        /**
+         * Destroys and creates the queued resources. Resources are processed in queue order until the time budget is spent,
+         * the remaining resources stay queued for the next call. Resources that support incremental creation may be created
+         * over several calls. At least one creation step is performed per call.
+         * @param timeBudget The maximum time to spend on processing the resources.
+         * @return True if there are still queued resources, false otherwise.
+         */
+        bool processResources(const std::chrono::steady_clock::duration& timeBudget);
+
+        /**
+         * Returns the GPU memory reported by the resources of the given category.
+         * @param category The memory category.
+         * @return The GPU memory usage in bytes.
+         */
+        std::size_t getGPUMemoryUsage(GLMemoryCategory::GLMemoryCategory category) const;
+        /**
+         * Returns the total GPU memory reported by all resources of the manager.
+         * @return The total GPU memory usage in bytes.
+         */
+        std::size_t getTotalGPUMemoryUsage() const;
     
     protected:
+        friend class GLResource;
+
         std::shared_ptr<GLResource> registerResource(GLResource* resourcePtr);
         void deleteResource(std::unique_ptr<GLResource> resource);
+        void updateGPUMemoryUsage(GLResource& resource, GLMemoryCategory::GLMemoryCategory category, std::size_t size);
 
     private:
         std::thread::id _glThreadId;
-        std::vector<std::weak_ptr<GLResource> > _createQueue;
-        std::vector<std::unique_ptr<GLResource> > _deleteQueue;
+        std::shared_ptr<ShaderBinaryCache> _shaderBinaryCache;
+        std::deque<std::weak_ptr<GLResource> > _createQueue;
+        std::deque<std::unique_ptr<GLResource> > _deleteQueue;
+        std::array<std::size_t, GLMemoryCategory::GL_MEMORY_CATEGORY_COUNT> _gpuMemoryUsage;
         mutable std::mutex _mutex;
     };
     
@@ -14,6 +14,10 @@ namespace carto {
         return _resourceManager;
     }
 
+    void NMLResources::setModelMemoryUsage(std::size_t size) {
+        setGPUMemoryUsage(GLMemoryCategory::GL_MEMORY_CATEGORY_MODEL, size);
+    }
+
     NMLResources::NMLResources(const std::weak_ptr<GLResourceManager>& manager) :
         GLResource(manager),
         _resourceManager()
@@ -37,6 +41,7 @@ namespace carto {
 
             _resourceManager->deleteAll();
             _resourceManager.reset();
+            setGPUMemoryUsage(GLMemoryCategory::GL_MEMORY_CATEGORY_MODEL, 0);
 
             GLContext::CheckGLError("NMLResources::destroy");
         }
@@ -21,6 +21,9 @@ namespace carto {
 
         std::shared_ptr<nml::GLResourceManager> getResourceManager() const;
 
+        // The buffers of the NML resource manager are not visible outside of it, the caller reports the size of the created models
+        void setModelMemoryUsage(std::size_t size);
+
     protected:
         friend GLResourceManager;
 
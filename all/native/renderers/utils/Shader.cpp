@@ -1,5 +1,6 @@
 #include "Shader.h"
 #include "renderers/utils/GLResourceManager.h"
+#include "renderers/utils/ShaderBinaryCache.h"
 #include "utils/Log.h"
 
 #include <vector>
@@ -47,16 +48,31 @@ namespace carto {
     void Shader::create() {
         enum { VAR_NAME_BUF_SIZE = 256 };
 
-        if (_vertShaderId == 0) {
-            _vertShaderId = LoadShader(_name, _vertSource, GL_VERTEX_SHADER);
-        }
+        if (_progId == 0) {
+            std::shared_ptr<ShaderBinaryCache> binaryCache;
+            if (auto manager = _manager.lock()) {
+                binaryCache = manager->getShaderBinaryCache();
+            }
 
-        if (_fragShaderId == 0) {
-            _fragShaderId = LoadShader(_name, _fragSource, GL_FRAGMENT_SHADER);
-        }
+            // Try the cached program binary first, compile and link the program only if it is not available
+            if (binaryCache) {
+                _progId = binaryCache->loadProgram(_name, _vertSource, _fragSource);
+            }
 
-        if (_progId == 0) {
-            _progId = LoadProg(_name, _vertShaderId, _fragShaderId);
+            if (_progId == 0) {
+                if (_vertShaderId == 0) {
+                    _vertShaderId = LoadShader(_name, _vertSource, GL_VERTEX_SHADER);
+                }
+
+                if (_fragShaderId == 0) {
+                    _fragShaderId = LoadShader(_name, _fragSource, GL_FRAGMENT_SHADER);
+                }
+
+                _progId = LoadProg(_name, _vertShaderId, _fragShaderId);
+                if (binaryCache) {
+                    binaryCache->storeProgram(_name, _vertSource, _fragSource, _progId);
+                }
+            }
 
             // Assign a location for every uniform variable, save them to map
             GLint uniformCount = 0;
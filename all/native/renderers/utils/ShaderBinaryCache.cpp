@@ -0,0 +1,157 @@
+#include "ShaderBinaryCache.h"
+#include "utils/Log.h"
+
+#include <memory>
+#include <vector>
+
+#include <stdext/utf8_filesystem.h>
+
+namespace carto {
+
+    ShaderBinaryCache::ShaderBinaryCache(const std::string& cacheDirectory) :
+        _cacheDirectory(cacheDirectory),
+        _driverId(),
+        _mutex()
+    {
+        for (GLenum param : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+            if (const char* str = reinterpret_cast<const char*>(glGetString(param))) {
+                _driverId += str;
+            }
+            _driverId += '\n';
+        }
+    }
+
+    ShaderBinaryCache::~ShaderBinaryCache() {
+    }
+
+    GLuint ShaderBinaryCache::loadProgram(const std::string& name, const std::string& vertSource, const std::string& fragSource) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (!GLContext::PROGRAM_BINARY) {
+            return 0;
+        }
+
+        std::string fileName = getFileName(name);
+        FILE* fpRaw = utf8_filesystem::fopen(fileName.c_str(), "rb");
+        if (!fpRaw) {
+            return 0;
+        }
+        std::shared_ptr<FILE> fp(fpRaw, fclose);
+
+        std::uint32_t header[3] = { 0, 0, 0 };
+        std::uint64_t key = 0;
+        std::uint32_t binarySize = 0;
+        if (fread(header, sizeof(header), 1, fp.get()) != 1 || fread(&key, sizeof(key), 1, fp.get()) != 1 || fread(&binarySize, sizeof(binarySize), 1, fp.get()) != 1) {
+            return 0;
+        }
+        if (header[0] != FILE_MAGIC || header[1] != FILE_VERSION || key != calculateKey(vertSource, fragSource)) {
+            return 0;
+        }
+        GLenum binaryFormat = static_cast<GLenum>(header[2]);
+
+        std::vector<unsigned char> binary(binarySize);
+        if (binarySize == 0 || fread(binary.data(), 1, binary.size(), fp.get()) != binary.size()) {
+            return 0;
+        }
+        fp.reset();
+
+        GLuint progId = glCreateProgram();
+        if (progId == 0) {
+            return 0;
+        }
+        GLContext::ProgramBinary(progId, binaryFormat, binary.data(), static_cast<GLint>(binary.size()));
+
+        // The driver may reject binaries after updates, fall back to compiling in this case
+        GLint linked = GL_FALSE;
+        glGetProgramiv(progId, GL_LINK_STATUS, &linked);
+        if (linked == GL_FALSE) {
+            Log::Infof("ShaderBinaryCache::loadProgram: Cached binary of '%s' shader rejected", name.c_str());
+            glDeleteProgram(progId);
+            utf8_filesystem::unlink(fileName.c_str());
+            progId = 0;
+        }
+
+        // Rejected binaries may leave errors, these should not be reported
+        while (glGetError() != GL_NO_ERROR) { }
+
+        return progId;
+    }
+
+    void ShaderBinaryCache::storeProgram(const std::string& name, const std::string& vertSource, const std::string& fragSource, GLuint progId) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (!GLContext::PROGRAM_BINARY || progId == 0) {
+            return;
+        }
+
+        GLint binaryLength = 0;
+        glGetProgramiv(progId, GL_PROGRAM_BINARY_LENGTH_OES, &binaryLength);
+        if (binaryLength <= 0) {
+            return;
+        }
+
+        std::vector<unsigned char> binary(binaryLength);
+        GLsizei actualLength = 0;
+        GLenum binaryFormat = 0;
+        GLContext::GetProgramBinary(progId, binaryLength, &actualLength, &binaryFormat, binary.data());
+        GLContext::CheckGLError("ShaderBinaryCache::storeProgram");
+        if (actualLength <= 0) {
+            return;
+        }
+        binary.resize(actualLength);
+
+        // Write to a temporary file first, so that partially written files are never read
+        std::string fileName = getFileName(name);
+        std::string tempFileName = fileName + ".tmp";
+        FILE* fpRaw = utf8_filesystem::fopen(tempFileName.c_str(), "wb");
+        if (!fpRaw) {
+            Log::Warnf("ShaderBinaryCache::storeProgram: Could not create file %s", tempFileName.c_str());
+            return;
+        }
+        std::shared_ptr<FILE> fp(fpRaw, fclose);
+
+        std::uint32_t header[3] = { FILE_MAGIC, FILE_VERSION, static_cast<std::uint32_t>(binaryFormat) };
+        std::uint64_t key = calculateKey(vertSource, fragSource);
+        std::uint32_t binarySize = static_cast<std::uint32_t>(binary.size());
+        bool written = fwrite(header, sizeof(header), 1, fp.get()) == 1 && fwrite(&key, sizeof(key), 1, fp.get()) == 1 && fwrite(&binarySize, sizeof(binarySize), 1, fp.get()) == 1;
+        written = written && fwrite(binary.data(), 1, binary.size(), fp.get()) == binary.size();
+        fp.reset();
+
+        utf8_filesystem::unlink(fileName.c_str());
+        if (!written || utf8_filesystem::rename(tempFileName.c_str(), fileName.c_str()) != 0) {
+            Log::Warnf("ShaderBinaryCache::storeProgram: Could not write file %s", fileName.c_str());
+            utf8_filesystem::unlink(tempFileName.c_str());
+        }
+    }
+
+    std::string ShaderBinaryCache::getFileName(const std::string& name) const {
+        std::string fileName = _cacheDirectory;
+        if (!fileName.empty() && fileName.back() != '/' && fileName.back() != '\\') {
+            fileName += '/';
+        }
+        return fileName + "carto_shader_" + name + ".bin";
+    }
+
+    std::uint64_t ShaderBinaryCache::calculateKey(const std::string& vertSource, const std::string& fragSource) const {
+        std::uint64_t hash = 14695981039346656037ULL;
+        hash = CalculateHash(_driverId, hash);
+        hash = CalculateHash(vertSource, hash);
+        hash = CalculateHash(fragSource, hash);
+        return hash;
+    }
+
+    std::uint64_t ShaderBinaryCache::CalculateHash(const std::string& str, std::uint64_t hash) {
+        // FNV-1a, stable between runs unlike std::hash
+        for (char c : str) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ULL;
+        }
+        hash ^= 0xff; // separator, so that moving text between the strings changes the hash
+        hash *= 1099511628211ULL;
+        return hash;
+    }
+
+    const std::uint32_t ShaderBinaryCache::FILE_MAGIC = 0x42534354; // 'TCSB'
+    const std::uint32_t ShaderBinaryCache::FILE_VERSION = 1;
+    
+}
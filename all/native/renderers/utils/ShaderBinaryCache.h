@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_SHADERBINARYCACHE_H_
+#define _CARTO_SHADERBINARYCACHE_H_
+
+#include "renderers/utils/GLContext.h"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace carto {
+
+    /**
+     * On-disk cache of linked shader program binaries. Each program is stored in its own file together with
+     * a hash of the driver identification and the program sources, binaries produced by a different driver
+     * or from different sources are ignored and replaced. Must be created and used from the GL thread.
+     */
+    class ShaderBinaryCache {
+    public:
+        explicit ShaderBinaryCache(const std::string& cacheDirectory);
+        virtual ~ShaderBinaryCache();
+
+        // Returns the id of the program created from the cached binary or 0 if the binary is missing or was rejected by the driver
+        GLuint loadProgram(const std::string& name, const std::string& vertSource, const std::string& fragSource) const;
+        void storeProgram(const std::string& name, const std::string& vertSource, const std::string& fragSource, GLuint progId) const;
+
+    private:
+        std::string getFileName(const std::string& name) const;
+        std::uint64_t calculateKey(const std::string& vertSource, const std::string& fragSource) const;
+
+        static std::uint64_t CalculateHash(const std::string& str, std::uint64_t hash);
+
+        static const std::uint32_t FILE_MAGIC;
+        static const std::uint32_t FILE_VERSION;
+
+        const std::string _cacheDirectory;
+        std::string _driverId;
+
+        mutable std::mutex _mutex;
+    };
+    
+}
+
+#endif
@@ -0,0 +1,77 @@
+#include "TesselationCache.h"
+#include "geometry/Geometry.h"
+#include "projections/Projection.h"
+#include "projections/ProjectionSurface.h"
+
+#include <cstdint>
+
+namespace carto {
+
+    std::size_t TesselationCache::TesselatedGeometry::getSize() const {
+        return positions.size() * sizeof(cglib::vec3<double>) + normals.size() * sizeof(cglib::vec3<float>) + indices.size() * sizeof(unsigned int);
+    }
+
+    TesselationCache& TesselationCache::GetInstance() {
+        static TesselationCache instance;
+        return instance;
+    }
+
+    TesselationCache::~TesselationCache() {
+        _memoryConsumer->detach();
+    }
+
+    std::size_t TesselationCache::getCapacity() const {
+        return _memoryConsumer->getCapacity();
+    }
+
+    void TesselationCache::setCapacity(std::size_t capacityInBytes) {
+        _memoryConsumer->setCapacity(capacityInBytes);
+    }
+
+    void TesselationCache::clear() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _cache.clear();
+    }
+
+    std::shared_ptr<const TesselationCache::TesselatedGeometry> TesselationCache::getTesselatedGeometry(const Geometry& geometry, int part, const Projection& projection, const std::shared_ptr<ProjectionSurface>& projectionSurface, const std::function<std::shared_ptr<TesselatedGeometry>()>& tesselateFunc) {
+        // Geometry revisions are never reused, the surface is kept alive by the entry, so the key can not refer to stale data
+        std::string key = std::to_string(geometry.getRevision()) + ":" + std::to_string(part) + ":" + projection.getName() + ":" + std::to_string(reinterpret_cast<std::uintptr_t>(projectionSurface.get()));
+
+        Entry entry;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_cache.read(key, entry)) {
+                return entry.tesselatedGeometry;
+            }
+        }
+
+        // Tesselate outside of the lock, concurrent misses for the same key simply replace each other
+        std::shared_ptr<TesselatedGeometry> tesselatedGeometry = tesselateFunc();
+        if (tesselatedGeometry) {
+            entry.projectionSurface = projectionSurface;
+            entry.tesselatedGeometry = tesselatedGeometry;
+            std::lock_guard<std::mutex> lock(_mutex);
+            _cache.put(key, entry, tesselatedGeometry->getSize() + key.size());
+        }
+        return tesselatedGeometry;
+    }
+
+    TesselationCache::TesselationCache() :
+        _cache(DEFAULT_CAPACITY),
+        _memoryConsumer(),
+        _mutex()
+    {
+        _memoryConsumer = MemoryGovernor::GetInstance().registerConsumer(DEFAULT_CAPACITY, 1.0f,
+            [this](std::size_t budget) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _cache.resize(budget);
+            },
+            [this](bool critical) {
+                clear();
+            }
+        );
+    }
+
+    const std::size_t TesselationCache::DEFAULT_CAPACITY = 8 * 1024 * 1024;
+
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_TESSELATIONCACHE_H_
+#define _CARTO_TESSELATIONCACHE_H_
+
+#include "components/MemoryGovernor.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <cglib/vec.h>
+
+#include <stdext/timed_lru_cache.h>
+
+namespace carto {
+    class Geometry;
+    class Projection;
+    class ProjectionSurface;
+
+    /**
+     * Shared cache of projection surface tesselation results of line and polygon geometries.
+     * Draw datas are recreated when the element style changes or the layer is refreshed, the cache
+     * allows reusing the tesselated vertices as long as the geometry, projection and projection surface stay the same.
+     */
+    class TesselationCache {
+    public:
+        struct TesselatedGeometry {
+            std::vector<cglib::vec3<double> > positions;
+            std::vector<cglib::vec3<float> > normals; // for lines only
+            std::vector<unsigned int> indices; // for polygons only
+
+            std::size_t getSize() const;
+        };
+
+        static TesselationCache& GetInstance();
+
+        virtual ~TesselationCache();
+
+        std::size_t getCapacity() const;
+        void setCapacity(std::size_t capacityInBytes);
+
+        void clear();
+
+        // Returns the cached tesselation for the geometry part or tesselates, caches and returns a new one
+        std::shared_ptr<const TesselatedGeometry> getTesselatedGeometry(const Geometry& geometry, int part, const Projection& projection, const std::shared_ptr<ProjectionSurface>& projectionSurface, const std::function<std::shared_ptr<TesselatedGeometry>()>& tesselateFunc);
+
+    private:
+        struct Entry {
+            std::shared_ptr<ProjectionSurface> projectionSurface; // keeps the surface address used in the key valid
+            std::shared_ptr<const TesselatedGeometry> tesselatedGeometry;
+        };
+
+        TesselationCache();
+
+        static const std::size_t DEFAULT_CAPACITY;
+
+        cache::timed_lru_cache<std::string, Entry> _cache;
+        std::shared_ptr<MemoryGovernor::Consumer> _memoryConsumer;
+
+        mutable std::mutex _mutex;
+    };
+
+}
+
+#endif
@@ -1,10 +1,14 @@
 #include "Texture.h"
 #include "graphics/Bitmap.h"
+#include "graphics/utils/BitmapKernels.h"
 #include "renderers/utils/GLResourceManager.h"
 #include "utils/Log.h"
 #include "utils/GeneralUtils.h"
+#include "utils/ThreadUtils.h"
 
 #include <algorithm>
+#include <chrono>
+#include <thread>
 
 namespace carto {
 
@@ -38,7 +42,12 @@ namespace carto {
         _repeat(repeat),
         _sizeInBytes(0),
         _texCoordScale(1.0f, 1.0f),
-        _texId(0)
+        _texId(0),
+        _uploadTexId(0),
+        _uploadedRows(0),
+        _uploadLevel(0),
+        _mipLevelsFuture(),
+        _mipLevels()
     {
         bool npot = !GeneralUtils::IsPow2(bitmap->getWidth()) || !GeneralUtils::IsPow2(bitmap->getHeight());
         if (npot && !GLContext::TEXTURE_NPOT_REPEAT) {
@@ -55,23 +64,146 @@ namespace carto {
         }
 
         _sizeInBytes = static_cast<std::size_t>((_mipmaps ? MIPMAP_SIZE_MULTIPLIER : 1.0) * _bitmap->getWidth() * _bitmap->getHeight() * _bitmap->getBytesPerPixel());
+
+        // Large textures are uploaded in steps. Generate their mip levels in a background thread meanwhile, instead of calling glGenerateMipmap on the GL thread.
+        bool pow2 = GeneralUtils::IsPow2(_bitmap->getWidth()) && GeneralUtils::IsPow2(_bitmap->getHeight());
+        std::size_t levelSize = static_cast<std::size_t>(_bitmap->getWidth()) * _bitmap->getHeight() * _bitmap->getBytesPerPixel();
+        if (_mipmaps && pow2 && levelSize > MAX_UPLOAD_STEP_SIZE && _bitmap->getColorFormat() != ColorFormat::COLOR_FORMAT_UNSUPPORTED) {
+            auto promise = std::make_shared<std::promise<std::shared_ptr<MipLevelList> > >();
+            _mipLevelsFuture = promise->get_future().share();
+            std::shared_ptr<Bitmap> levelBitmap = _bitmap;
+            std::thread mipmapThread([promise, levelBitmap]() {
+                ThreadUtils::SetThreadRole(ThreadRole::BACKGROUND);
+                try {
+                    promise->set_value(GenerateMipLevels(*levelBitmap));
+                }
+                catch (...) {
+                    promise->set_exception(std::current_exception());
+                }
+            });
+            mipmapThread.detach();
+        }
     }
 
     void Texture::create() {
         if (_texId == 0) {
+            if (_uploadTexId != 0) {
+                glDeleteTextures(1, &_uploadTexId);
+                _uploadTexId = 0;
+                _mipLevels.reset();
+            }
+
             _texId = LoadFromBitmap(*_bitmap, _mipmaps, _repeat);
+            setGPUMemoryUsage(GLMemoryCategory::GL_MEMORY_CATEGORY_TEXTURE, _sizeInBytes);
 
             GLContext::CheckGLError("Texture::create");
         }
     }
 
+    bool Texture::createStep() {
+        if (_texId != 0) {
+            return true;
+        }
+
+        // Small textures are uploaded at once, larger ones in horizontal strips over several steps
+        std::size_t rowSize = static_cast<std::size_t>(_bitmap->getWidth()) * _bitmap->getBytesPerPixel();
+        if (_uploadTexId == 0) {
+            if (rowSize * _bitmap->getHeight() <= MAX_UPLOAD_STEP_SIZE || _bitmap->getColorFormat() == ColorFormat::COLOR_FORMAT_UNSUPPORTED) {
+                create();
+                return true;
+            }
+
+            GLint oldTexId = 0;
+            glGetIntegerv(GL_TEXTURE_BINDING_2D, &oldTexId);
+
+            glGenTextures(1, &_uploadTexId);
+            glBindTexture(GL_TEXTURE_2D, _uploadTexId);
+            glTexImage2D(GL_TEXTURE_2D, 0, _bitmap->getColorFormat(), _bitmap->getWidth(), _bitmap->getHeight(),
+                    0, _bitmap->getColorFormat(), GL_UNSIGNED_BYTE, nullptr);
+            glBindTexture(GL_TEXTURE_2D, oldTexId);
+            _uploadedRows = 0;
+            _uploadLevel = 0;
+            setGPUMemoryUsage(GLMemoryCategory::GL_MEMORY_CATEGORY_TEXTURE, rowSize * _bitmap->getHeight());
+
+            GLContext::CheckGLError("Texture::createStep");
+            return false;
+        }
+
+        // Level 0 is taken from the bitmap, the following levels from the generated mip levels
+        unsigned int levelWidth = _bitmap->getWidth();
+        unsigned int levelHeight = _bitmap->getHeight();
+        const unsigned char* levelData = _bitmap->getPixelData().data();
+        if (_uploadLevel > 0) {
+            const MipLevel& mipLevel = (*_mipLevels)[_uploadLevel - 1];
+            levelWidth = mipLevel.width;
+            levelHeight = mipLevel.height;
+            levelData = mipLevel.pixelData.data();
+        }
+        std::size_t levelRowSize = static_cast<std::size_t>(levelWidth) * _bitmap->getBytesPerPixel();
+
+        int rows = std::max(1, static_cast<int>(MAX_UPLOAD_STEP_SIZE / levelRowSize));
+        rows = std::min(rows, static_cast<int>(levelHeight) - _uploadedRows);
+
+        GLint oldTexId = 0;
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &oldTexId);
+
+        glBindTexture(GL_TEXTURE_2D, _uploadTexId);
+        glTexSubImage2D(GL_TEXTURE_2D, _uploadLevel, 0, _uploadedRows, levelWidth, rows,
+                _bitmap->getColorFormat(), GL_UNSIGNED_BYTE, levelData + _uploadedRows * levelRowSize);
+        _uploadedRows += rows;
+
+        bool complete = false;
+        if (_uploadedRows >= static_cast<int>(levelHeight)) {
+            if (_uploadLevel == 0 && _mipLevelsFuture.valid()) {
+                // Use the generated mip levels only if they are already available, never block the GL thread
+                if (_mipLevelsFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                    try {
+                        _mipLevels = _mipLevelsFuture.get();
+                    }
+                    catch (const std::exception& ex) {
+                        Log::Warnf("Texture::createStep: Failed to generate mip levels: %s", ex.what());
+                    }
+                }
+                _mipLevelsFuture = std::shared_future<std::shared_ptr<MipLevelList> >();
+            }
+
+            if (_mipLevels && _uploadLevel < static_cast<int>(_mipLevels->size())) {
+                const MipLevel& nextLevel = (*_mipLevels)[_uploadLevel];
+                _uploadLevel++;
+                _uploadedRows = 0;
+                glTexImage2D(GL_TEXTURE_2D, _uploadLevel, _bitmap->getColorFormat(), nextLevel.width, nextLevel.height,
+                        0, _bitmap->getColorFormat(), GL_UNSIGNED_BYTE, nullptr);
+            } else {
+                SetTextureParameters(*_bitmap, _mipmaps, _repeat, static_cast<bool>(_mipLevels));
+                _texId = _uploadTexId;
+                _uploadTexId = 0;
+                _mipLevels.reset();
+                setGPUMemoryUsage(GLMemoryCategory::GL_MEMORY_CATEGORY_TEXTURE, _sizeInBytes);
+                complete = true;
+            }
+        }
+
+        glBindTexture(GL_TEXTURE_2D, oldTexId);
+
+        GLContext::CheckGLError("Texture::createStep");
+        return complete;
+    }
+
     void Texture::destroy() {
+        if (_uploadTexId != 0) {
+            glDeleteTextures(1, &_uploadTexId);
+            _uploadTexId = 0;
+            _mipLevels.reset();
+        }
+
         if (_texId != 0) {
             glDeleteTextures(1, &_texId);
             _texId = 0;
 
             GLContext::CheckGLError("Texture::destroy");
         }
+
+        setGPUMemoryUsage(GLMemoryCategory::GL_MEMORY_CATEGORY_TEXTURE, 0);
     }
     
     GLuint Texture::LoadFromBitmap(const Bitmap& bitmap, bool genMipmaps, bool repeat) {
@@ -90,7 +222,15 @@ namespace carto {
         const std::vector<unsigned char>& pixelData = bitmap.getPixelData();
         glTexImage2D(GL_TEXTURE_2D, 0, bitmap.getColorFormat(), bitmap.getWidth(), bitmap.getHeight(),
                 0, bitmap.getColorFormat(), GL_UNSIGNED_BYTE, pixelData.data());
-        
+
+        SetTextureParameters(bitmap, genMipmaps, repeat, false);
+
+        glBindTexture(GL_TEXTURE_2D, oldTexId);
+    
+        return texId;
+    }
+
+    void Texture::SetTextureParameters(const Bitmap& bitmap, bool genMipmaps, bool repeat, bool mipLevelsUploaded) {
         if (repeat) {
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -115,16 +255,38 @@ namespace carto {
                 }
             }
     
-            glGenerateMipmap(GL_TEXTURE_2D);
+            if (!mipLevelsUploaded) {
+                glGenerateMipmap(GL_TEXTURE_2D);
+            }
         }
+    }
 
-        glBindTexture(GL_TEXTURE_2D, oldTexId);
-    
-        return texId;
+    std::shared_ptr<Texture::MipLevelList> Texture::GenerateMipLevels(const Bitmap& bitmap) {
+        // Note: the bitmap dimensions must be powers of two, so that the level sizes match the sizes expected by GL
+        unsigned int bytesPerPixel = bitmap.getBytesPerPixel();
+        unsigned int width = bitmap.getWidth();
+        unsigned int height = bitmap.getHeight();
+        auto mipLevels = std::make_shared<MipLevelList>();
+        const unsigned char* levelData = bitmap.getPixelData().data();
+        while (width > 1 || height > 1) {
+            MipLevel mipLevel;
+            mipLevel.width = (width + 1) / 2;
+            mipLevel.height = (height + 1) / 2;
+            mipLevel.pixelData.resize(static_cast<std::size_t>(mipLevel.width) * mipLevel.height * bytesPerPixel);
+            BitmapKernels::Downsample2x(levelData, width, height, mipLevel.pixelData.data(), bytesPerPixel);
+            mipLevels->push_back(std::move(mipLevel));
+
+            width = mipLevels->back().width;
+            height = mipLevels->back().height;
+            levelData = mipLevels->back().pixelData.data();
+        }
+        return mipLevels;
     }
         
     const int Texture::MAX_ANISOTROPY = 8;
         
     const double Texture::MIPMAP_SIZE_MULTIPLIER = 1.33;
+
+    const std::size_t Texture::MAX_UPLOAD_STEP_SIZE = 256 * 1024;
     
 }
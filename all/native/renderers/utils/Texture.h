@@ -9,7 +9,9 @@
 
 #include "renderers/utils/GLResource.h"
 
+#include <future>
 #include <memory>
+#include <vector>
 
 #include <cglib/vec.h>
 
@@ -36,14 +38,27 @@ namespace carto {
         Texture(const std::weak_ptr<GLResourceManager>& manager, const std::shared_ptr<Bitmap>& bitmap, bool genMipmaps, bool repeat);
 
         virtual void create();
+        virtual bool createStep();
         virtual void destroy();
 
     private:
+        struct MipLevel {
+            unsigned int width;
+            unsigned int height;
+            std::vector<unsigned char> pixelData;
+        };
+
+        typedef std::vector<MipLevel> MipLevelList;
+
         static const int MAX_ANISOTROPY;
         
         static const double MIPMAP_SIZE_MULTIPLIER;
+
+        static const std::size_t MAX_UPLOAD_STEP_SIZE;
     
         static GLuint LoadFromBitmap(const Bitmap& bitmap, bool genMipmaps, bool repeat);
+        static void SetTextureParameters(const Bitmap& bitmap, bool genMipmaps, bool repeat, bool mipLevelsUploaded);
+        static std::shared_ptr<MipLevelList> GenerateMipLevels(const Bitmap& bitmap);
         
         std::shared_ptr<Bitmap> _bitmap;
         bool _mipmaps;
@@ -52,6 +67,12 @@ namespace carto {
         cglib::vec2<float> _texCoordScale;
     
         GLuint _texId;
+        GLuint _uploadTexId; // texture being uploaded in steps, published as _texId once complete
+        int _uploadedRows;
+        int _uploadLevel;
+
+        std::shared_future<std::shared_ptr<MipLevelList> > _mipLevelsFuture; // mip levels of large textures, generated in a background thread
+        std::shared_ptr<MipLevelList> _mipLevels;
     };
     
 }
@@ -12,6 +12,10 @@ namespace carto {
         return _tileRenderer;
     }
 
+    void VTRenderer::setTileMemoryUsage(std::size_t size) {
+        setGPUMemoryUsage(GLMemoryCategory::GL_MEMORY_CATEGORY_TILE, size);
+    }
+
     VTRenderer::VTRenderer(const std::weak_ptr<GLResourceManager>& manager, const std::shared_ptr<vt::TileTransformer>& tileTransformer) :
         GLResource(manager),
         _tileTransformer(tileTransformer),
@@ -37,6 +41,7 @@ namespace carto {
 
             _tileRenderer->deinitializeRenderer();
             _tileRenderer.reset();
+            setGPUMemoryUsage(GLMemoryCategory::GL_MEMORY_CATEGORY_TILE, 0);
 
             GLContext::CheckGLError("VTRenderer::destroy");
         }
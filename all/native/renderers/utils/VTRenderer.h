@@ -21,6 +21,9 @@ namespace carto {
 
         std::shared_ptr<vt::GLTileRenderer> getTileRenderer() const;
 
+        // The buffers of the tile renderer are not visible outside of it, the caller reports the estimated size of the visible tiles
+        void setTileMemoryUsage(std::size_t size);
+
     protected:
         friend GLResourceManager;
 
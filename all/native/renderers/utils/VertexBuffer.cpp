@@ -0,0 +1,59 @@
+#include "VertexBuffer.h"
+#include "renderers/utils/GLResourceManager.h"
+#include "utils/Log.h"
+
+namespace carto {
+
+    VertexBuffer::~VertexBuffer() {
+    }
+
+    std::size_t VertexBuffer::getSize() const {
+        return _size;
+    }
+
+    const std::vector<unsigned char>& VertexBuffer::getData() const {
+        return _data;
+    }
+
+    GLuint VertexBuffer::getBufferId() const {
+        return _bufferId;
+    }
+        
+    VertexBuffer::VertexBuffer(const std::weak_ptr<GLResourceManager>& manager, std::vector<unsigned char> data) :
+        GLResource(manager),
+        _data(std::move(data)),
+        _size(0),
+        _bufferId(0)
+    {
+        _size = _data.size();
+    }
+
+    void VertexBuffer::create() {
+        if (_bufferId == 0) {
+            GLint oldBufferId = 0;
+            glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &oldBufferId);
+
+            glGenBuffers(1, &_bufferId);
+            glBindBuffer(GL_ARRAY_BUFFER, _bufferId);
+            glBufferData(GL_ARRAY_BUFFER, _data.size(), _data.data(), GL_STATIC_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, oldBufferId);
+            setGPUMemoryUsage(GLMemoryCategory::GL_MEMORY_CATEGORY_VERTEX_BUFFER, _size);
+
+            // The data is not needed after the upload
+            std::vector<unsigned char>().swap(_data);
+
+            GLContext::CheckGLError("VertexBuffer::create");
+        }
+    }
+
+    void VertexBuffer::destroy() {
+        if (_bufferId != 0) {
+            glDeleteBuffers(1, &_bufferId);
+            _bufferId = 0;
+            setGPUMemoryUsage(GLMemoryCategory::GL_MEMORY_CATEGORY_VERTEX_BUFFER, 0);
+
+            GLContext::CheckGLError("VertexBuffer::destroy");
+        }
+    }
+    
+}
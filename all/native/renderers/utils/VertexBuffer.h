@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_VERTEXBUFFER_H_
+#define _CARTO_VERTEXBUFFER_H_
+
+#include "renderers/utils/GLResource.h"
+
+#include <memory>
+#include <vector>
+
+namespace carto {
+    
+    class VertexBuffer : public GLResource {
+    public:
+        virtual ~VertexBuffer();
+        
+        std::size_t getSize() const;
+
+        // Data not uploaded yet, can be used for drawing from client memory until the buffer is created. Empty once uploaded.
+        const std::vector<unsigned char>& getData() const;
+
+        GLuint getBufferId() const;
+
+    protected:
+        friend GLResourceManager;
+
+        VertexBuffer(const std::weak_ptr<GLResourceManager>& manager, std::vector<unsigned char> data);
+
+        virtual void create();
+        virtual void destroy();
+
+    private:
+        std::vector<unsigned char> _data;
+        std::size_t _size;
+    
+        GLuint _bufferId;
+    };
+    
+}
+
+#endif
@@ -4,6 +4,7 @@
 #include "renderers/drawdatas/BillboardDrawData.h"
 #include "utils/Log.h"
 #include "utils/ThreadUtils.h"
+#include "utils/TraceUtils.h"
 #include "vectorelements/Billboard.h"
 
 #include <algorithm>
@@ -13,9 +14,12 @@ namespace carto {
     BillboardPlacementWorker::BillboardPlacementWorker() :
         _stop(false),
         _idle(false),
-        _kdTree(),
+        _collisionGrid(),
+        _footprints(),
         _pendingWakeup(false),
         _wakeupTime(std::chrono::steady_clock::now() + std::chrono::hours(24)),
+        _frameSyncGate(),
+        _pendingOverlaps(),
         _mapRenderer(),
         _condition(),
         _mutex()
@@ -34,6 +38,9 @@ namespace carto {
         
     void BillboardPlacementWorker::init(int delayTime) {
         std::lock_guard<std::mutex> lock(_mutex);
+        if (_frameSyncGate.isEnabled()) {
+            delayTime = 0; // the placement is started once the current frame is submitted instead
+        }
         _idle = false;
         _pendingWakeup = true;
         _wakeupTime = std::min(_wakeupTime, std::chrono::steady_clock::now() + std::chrono::milliseconds(delayTime));
@@ -50,6 +57,35 @@ namespace carto {
         std::lock_guard<std::mutex> lock(_mutex);
         return _idle;
     }
+
+    void BillboardPlacementWorker::setFrameSynchronous(bool enabled) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _frameSyncGate.setEnabled(enabled);
+        _condition.notify_one();
+    }
+
+    void BillboardPlacementWorker::frameStarted() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _frameSyncGate.frameStarted();
+    }
+
+    void BillboardPlacementWorker::frameSubmitted() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _frameSyncGate.frameSubmitted();
+        _condition.notify_one();
+    }
+
+    bool BillboardPlacementWorker::applyPlacement() {
+        std::vector<std::pair<std::shared_ptr<BillboardDrawData>, bool> > overlaps;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            std::swap(overlaps, _pendingOverlaps);
+        }
+        for (const std::pair<std::shared_ptr<BillboardDrawData>, bool>& overlap : overlaps) {
+            overlap.first->setOverlapping(overlap.second);
+        }
+        return !overlaps.empty();
+    }
         
     void BillboardPlacementWorker::operator ()() {
         run();
@@ -57,7 +93,7 @@ namespace carto {
     }
     
     void BillboardPlacementWorker::run() {
-        ThreadUtils::SetThreadPriority(ThreadPriority::LOW);
+        ThreadUtils::SetThreadRole(ThreadRole::INTERACTIVE);
     
         while (true) {
             bool run = false;
@@ -69,15 +105,20 @@ namespace carto {
                 }
 
                 std::chrono::steady_clock::time_point currentTime = std::chrono::steady_clock::now();
-                if (_wakeupTime - currentTime < std::chrono::milliseconds(1)) {
-                    run = true;
-                    _pendingWakeup = false;
-                    _wakeupTime = currentTime + std::chrono::hours(24);
+                std::chrono::steady_clock::duration waitTime = _wakeupTime - currentTime;
+                if (waitTime < std::chrono::milliseconds(1)) {
+                    // In frame synchronous mode wait until the frame being drawn is submitted
+                    waitTime = _frameSyncGate.getHoldTime(currentTime);
+                    if (waitTime == std::chrono::steady_clock::duration::zero()) {
+                        run = true;
+                        _pendingWakeup = false;
+                        _wakeupTime = currentTime + std::chrono::hours(24);
+                    }
                 }
 
                 if (!run) {
                     _idle = !_pendingWakeup;
-                    _condition.wait_for(lock, _wakeupTime - currentTime);
+                    _condition.wait_for(lock, waitTime);
                     _idle = false;
                 }
             }
@@ -89,6 +130,8 @@ namespace carto {
     }
     
     bool BillboardPlacementWorker::calculateBillboardPlacement() {
+        CARTO_TRACE_SECTION("BillboardPlacementWorker::calculateBillboardPlacement");
+
         std::shared_ptr<MapRenderer> mapRenderer = _mapRenderer.lock();
         if (!mapRenderer) {
             return false;
@@ -108,6 +151,12 @@ namespace carto {
             return false;
         }
 
+        bool frameSynchronous = false;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            frameSynchronous = _frameSyncGate.isEnabled();
+        }
+
         ViewState viewState = mapRenderer->getViewState();
         const cglib::mat4x4<float>& rteMVPMat = viewState.getRTEModelviewProjectionMat();
 
@@ -124,71 +173,78 @@ namespace carto {
         std::stable_sort(billboardDrawDatas.begin(), billboardDrawDatas.end(), distanceComparator);
         std::reverse(billboardDrawDatas.begin(), billboardDrawDatas.end());
 
-        // Calculate billboard screen coordinates, add envelopes to the tree
-        {
-            std::lock_guard<std::mutex> lock(_mutex);
-            _kdTree.clear();
-        }
-
+        // Calculate billboard screen coordinates
+        std::vector<Footprint> footprints;
+        footprints.reserve(billboardDrawDatas.size());
         std::vector<float> coordBuf(12);
-        std::vector<MapPos> convexHull;
-        bool changed = false;
         for (const std::shared_ptr<BillboardDrawData>& drawData : billboardDrawDatas) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            if (_stop) {
-                return false;
+            Footprint footprint;
+            footprint.drawData = drawData;
+            footprint.visible = BillboardRenderer::CalculateBillboardCoords(*drawData, viewState, coordBuf, 0);
+            if (footprint.visible) {
+                // Transform the world coordinates to screen coordinates, store the corners in winding order
+                cglib::vec3<float> topLeft(cglib::transform_point(cglib::vec3<float>(coordBuf[0], coordBuf[1], coordBuf[2]), rteMVPMat));
+                cglib::vec3<float> bottomLeft(cglib::transform_point(cglib::vec3<float>(coordBuf[3], coordBuf[4], coordBuf[5]), rteMVPMat));
+                cglib::vec3<float> topRight(cglib::transform_point(cglib::vec3<float>(coordBuf[6], coordBuf[7], coordBuf[8]), rteMVPMat));
+                cglib::vec3<float> bottomRight(cglib::transform_point(cglib::vec3<float>(coordBuf[9], coordBuf[10], coordBuf[11]), rteMVPMat));
+                footprint.quad[0] = cglib::vec2<float>(topLeft(0), topLeft(1));
+                footprint.quad[1] = cglib::vec2<float>(bottomLeft(0), bottomLeft(1));
+                footprint.quad[2] = cglib::vec2<float>(bottomRight(0), bottomRight(1));
+                footprint.quad[3] = cglib::vec2<float>(topRight(0), topRight(1));
             }
+            footprints.push_back(footprint);
+        }
 
-            // Calculate billboard world coordinates
-            if (!BillboardRenderer::CalculateBillboardCoords(*drawData, viewState, coordBuf, 0)) {
-                continue;
-            }
+        // If the footprints and the order of the billboards are the same as in the previous pass, the placement does not change
+        if (footprints.size() == _footprints.size() && std::equal(footprints.begin(), footprints.end(), _footprints.begin(), IsSameFootprint)) {
+            return true;
+        }
+        std::swap(footprints, _footprints);
+        footprints.clear();
 
-            // Transform the world coordinates to screen coordinates
-            cglib::vec3<float> topLeft(cglib::transform_point(cglib::vec3<float>(coordBuf[0], coordBuf[1], coordBuf[2]), rteMVPMat));
-            cglib::vec3<float> bottomLeft(cglib::transform_point(cglib::vec3<float>(coordBuf[3], coordBuf[4], coordBuf[5]), rteMVPMat));
-            cglib::vec3<float> topRight(cglib::transform_point(cglib::vec3<float>(coordBuf[6], coordBuf[7], coordBuf[8]), rteMVPMat));
-            cglib::vec3<float> bottomRight(cglib::transform_point(cglib::vec3<float>(coordBuf[9], coordBuf[10], coordBuf[11]), rteMVPMat));
+        // Place the billboards in priority order, add the footprints of placed billboards to the collision grid
+        _collisionGrid.clear();
 
-            cglib::bbox3<double> bounds = cglib::bbox3<double>::smallest();
-            bounds.add(cglib::vec3<double>(topLeft(0), topLeft(1), 0));
-            bounds.add(cglib::vec3<double>(bottomLeft(0), bottomLeft(1), 0));
-            bounds.add(cglib::vec3<double>(topRight(0), topRight(1), 0));
-            bounds.add(cglib::vec3<double>(bottomRight(0), bottomRight(1), 0));
+        bool changed = false;
+        std::vector<std::pair<std::shared_ptr<BillboardDrawData>, bool> > overlaps;
+        for (const Footprint& footprint : _footprints) {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (_stop) {
+                    _footprints.clear();
+                    return false;
+                }
+            }
 
-            // Construct convex polygons from the screen coordinatees
-            convexHull.clear();
-            convexHull.emplace_back(topLeft(0), topLeft(1), 0);
-            convexHull.emplace_back(bottomLeft(0), bottomLeft(1), 0);
-            convexHull.emplace_back(topRight(0), topRight(1), 0);
-            convexHull.emplace_back(bottomRight(0), bottomRight(1), 0);
+            if (!footprint.visible) {
+                continue;
+            }
 
-            MapEnvelope envelope(convexHull);
+            const std::shared_ptr<BillboardDrawData>& drawData = footprint.drawData;
 
-            bool overlapped = false;
-            if (drawData->isHideIfOverlapped()) {
-                // Check that there are higher priority billboards overlapping with this one
-                const std::vector<MapEnvelope>& overlappedEnvelopes = _kdTree.query(bounds);
-                for (const MapEnvelope& overlappedEnvelope : overlappedEnvelopes) {
-                    if (overlappedEnvelope.intersects(envelope)) {
-                        // Overlapping detected, hide this billboard
-                        drawData->setOverlapping(true);
-                        changed = true;
-                        overlapped = true;
-                        break;
-                    }
+            // Check that there are no higher priority billboards overlapping with this one
+            bool overlapped = drawData->isHideIfOverlapped() && _collisionGrid.intersects(footprint.quad);
+            if (drawData->isOverlapping() != overlapped) {
+                if (frameSynchronous) {
+                    overlaps.emplace_back(drawData, overlapped);
+                } else {
+                    drawData->setOverlapping(overlapped);
                 }
+                changed = true;
             }
             
-            if (!overlapped) {
-                drawData->setOverlapping(false);
-                changed = true;
-                if (drawData->isCausesOverlap()) {
-                    _kdTree.insert(bounds, envelope);
-                }
+            if (!overlapped && drawData->isCausesOverlap()) {
+                _collisionGrid.insert(footprint.quad);
             }
         }
 
+        // In frame synchronous mode the results are applied at the start of the next frame. The latest pass
+        // is compared against the applied states, so it replaces any results not applied yet.
+        if (frameSynchronous) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            std::swap(overlaps, _pendingOverlaps);
+        }
+
         if (changed) {
             mapRenderer->requestRedraw();
         }
@@ -196,4 +252,19 @@ namespace carto {
         return true;
     }
 
+    bool BillboardPlacementWorker::IsSameFootprint(const Footprint& footprint1, const Footprint& footprint2) {
+        if (footprint1.drawData != footprint2.drawData || footprint1.visible != footprint2.visible) {
+            return false;
+        }
+        if (!footprint1.visible) {
+            return true;
+        }
+        for (std::size_t i = 0; i < footprint1.quad.size(); i++) {
+            if (footprint1.quad[i](0) != footprint2.quad[i](0) || footprint1.quad[i](1) != footprint2.quad[i](1)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
 }
@@ -8,13 +8,15 @@
 #define _CARTO_BILLBOARDPLACEMENTWORKER_H_
 
 #include "components/ThreadWorker.h"
-#include "core/MapEnvelope.h"
-#include "geometry/utils/KDTreeSpatialIndex.h"
+#include "renderers/components/BillboardCollisionGrid.h"
+#include "renderers/components/FrameSyncGate.h"
 
 #include <chrono>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <utility>
+#include <vector>
 
 namespace carto {
     class Billboard;
@@ -33,21 +35,40 @@ namespace carto {
         void stop();
         
         bool isIdle() const;
+
+        void setFrameSynchronous(bool enabled);
+        void frameStarted();
+        void frameSubmitted();
+
+        // Applies the placement results calculated in frame synchronous mode, must be called at the start of a frame
+        bool applyPlacement();
     
         void operator()();
     
     private:
+        struct Footprint {
+            std::shared_ptr<BillboardDrawData> drawData;
+            bool visible;
+            BillboardCollisionGrid::Quad quad;
+        };
+
         void run();
         
         bool calculateBillboardPlacement();
+
+        static bool IsSameFootprint(const Footprint& footprint1, const Footprint& footprint2);
         
         bool _stop;
         bool _idle;
         
-        KDTreeSpatialIndex<MapEnvelope> _kdTree;
+        BillboardCollisionGrid _collisionGrid;
+        std::vector<Footprint> _footprints; // screen footprints of the previous placement pass
         
         bool _pendingWakeup;
         std::chrono::steady_clock::time_point _wakeupTime;
+
+        FrameSyncGate _frameSyncGate;
+        std::vector<std::pair<std::shared_ptr<BillboardDrawData>, bool> > _pendingOverlaps; // overlap states waiting for the next frame
         
         std::weak_ptr<MapRenderer> _mapRenderer;
         std::shared_ptr<BillboardPlacementWorker> _worker;
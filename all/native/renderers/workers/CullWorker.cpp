@@ -1,4 +1,5 @@
 #include "CullWorker.h"
+#include "components/CancelableThreadPool.h"
 #include "layers/Layer.h"
 #include "projections/ProjectionSurface.h"
 #include "projections/PlanarProjectionSurface.h"
@@ -7,11 +8,14 @@
 #include "utils/GeomUtils.h"
 #include "utils/Log.h"
 #include "utils/ThreadUtils.h"
+#include "utils/TraceUtils.h"
 
 namespace carto {
 
     CullWorker::CullWorker() :
         _layerWakeupMap(),
+        _updatingLayers(),
+        _frameSyncGate(),
         _firstCull(true),
         _envelope(),
         _viewState(),
@@ -57,6 +61,23 @@ namespace carto {
         std::lock_guard<std::mutex> lock(_mutex);
         return _idle;
     }
+
+    void CullWorker::setFrameSynchronous(bool enabled) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _frameSyncGate.setEnabled(enabled);
+        _condition.notify_one();
+    }
+
+    void CullWorker::frameStarted() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _frameSyncGate.frameStarted();
+    }
+
+    void CullWorker::frameSubmitted() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _frameSyncGate.frameSubmitted();
+        _condition.notify_one();
+    }
     
     void CullWorker::operator ()() {
         run();
@@ -64,7 +85,7 @@ namespace carto {
     }
         
     void CullWorker::run() {
-        ThreadUtils::SetThreadPriority(ThreadPriority::LOW);
+        ThreadUtils::SetThreadRole(ThreadRole::INTERACTIVE);
         while (true) {
             std::vector<std::shared_ptr<Layer> > layers;
             {
@@ -76,8 +97,17 @@ namespace carto {
 
                 std::chrono::steady_clock::time_point currentTime = std::chrono::steady_clock::now();
                 std::chrono::steady_clock::time_point wakeupTime = std::chrono::steady_clock::now() + std::chrono::hours(24);
+                std::chrono::steady_clock::duration holdTime = _frameSyncGate.getHoldTime(currentTime);
                 for (auto it = _layerWakeupMap.begin(); it != _layerWakeupMap.end(); ) {
-                    if (it->second - currentTime < std::chrono::milliseconds(1)) {
+                    if (_updatingLayers.find(it->first) != _updatingLayers.end()) {
+                        it++; // wait until the previous update finishes, the worker is notified then
+                    } else if (it->second - currentTime < std::chrono::milliseconds(1)) {
+                        if (holdTime > std::chrono::steady_clock::duration::zero()) {
+                            // In frame synchronous mode wait until the frame being drawn is submitted
+                            wakeupTime = std::min(wakeupTime, currentTime + holdTime);
+                            it++;
+                            continue;
+                        }
                         layers.push_back(it->first);
                         it = _layerWakeupMap.erase(it);
                     } else {
@@ -87,13 +117,15 @@ namespace carto {
                 }
                 
                 if (layers.empty()) {
-                    _idle = _layerWakeupMap.empty();
+                    _idle = _layerWakeupMap.empty() && _updatingLayers.empty();
                     _condition.wait_for(lock, wakeupTime - std::chrono::steady_clock::now());
                     _idle = false;
                 }
             }
 
             if (!layers.empty()) {
+                CARTO_TRACE_SECTION("CullWorker::cull");
+
                 const std::shared_ptr<MapRenderer>& mapRenderer = _mapRenderer.lock();
                 if (!mapRenderer) {
                     return;
@@ -217,8 +249,82 @@ namespace carto {
     }
     
     void CullWorker::updateLayers(const std::vector<std::shared_ptr<Layer> >& layers) {
+        // Skip layers that do not depend on the view changes
+        std::vector<std::pair<std::shared_ptr<Layer>, std::shared_ptr<CullState> > > layerCullStates;
         for (const std::shared_ptr<Layer>& layer : layers) {
-            layer->update(std::make_shared<CullState>(_envelope, _viewState));
+            auto cullState = std::make_shared<CullState>(_envelope, _viewState);
+            if (std::shared_ptr<CullState> lastCullState = layer->getLastCullState()) {
+                if (layer->isCullStateInvariant(*lastCullState, *cullState)) {
+                    continue;
+                }
+            }
+            layerCullStates.emplace_back(layer, cullState);
+        }
+
+        // Fan out all but the last layer to the envelope thread pool, so that a slow layer does not delay the others.
+        // The last layer is updated on this thread.
+        for (std::size_t i = 0; i < layerCullStates.size(); i++) {
+            const std::shared_ptr<Layer>& layer = layerCullStates[i].first;
+            const std::shared_ptr<CullState>& cullState = layerCullStates[i].second;
+
+            std::shared_ptr<CancelableThreadPool> envelopeThreadPool;
+            if (i + 1 < layerCullStates.size()) {
+                std::lock_guard<std::recursive_mutex> lock(layer->_mutex);
+                envelopeThreadPool = layer->_envelopeThreadPool;
+            }
+            if (!envelopeThreadPool) {
+                layer->update(cullState);
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _updatingLayers.insert(layer);
+            }
+            envelopeThreadPool->execute(std::make_shared<LayerUpdateTask>(_worker, layer, cullState), layer->getUpdatePriority());
+        }
+    }
+
+    void CullWorker::layerUpdated(const std::shared_ptr<Layer>& layer, bool canceled) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _updatingLayers.erase(layer);
+        if (canceled) {
+            // The view has changed since the last update of the layer, so the update can not be dropped
+            if (_layerWakeupMap.find(layer) == _layerWakeupMap.end()) {
+                _layerWakeupMap[layer] = std::chrono::steady_clock::now();
+            }
+        }
+        _idle = false;
+        _condition.notify_one();
+    }
+
+    CullWorker::LayerUpdateTask::LayerUpdateTask(const std::shared_ptr<CullWorker>& worker, const std::shared_ptr<Layer>& layer, const std::shared_ptr<CullState>& cullState) :
+        CancelableTask(),
+        _worker(worker),
+        _layer(layer),
+        _cullState(cullState),
+        _finished(false)
+    {
+    }
+
+    void CullWorker::LayerUpdateTask::cancel() {
+        CancelableTask::cancel();
+        finish(true);
+    }
+
+    void CullWorker::LayerUpdateTask::run() {
+        if (!isCanceled()) {
+            _layer->update(_cullState);
+        }
+        finish(false);
+    }
+
+    void CullWorker::LayerUpdateTask::finish(bool canceled) {
+        if (_finished.exchange(true)) {
+            return;
+        }
+        if (std::shared_ptr<CullWorker> worker = _worker.lock()) {
+            worker->layerUpdated(_layer, canceled);
         }
     }
     
@@ -7,14 +7,18 @@
 #ifndef _CARTO_CULLWORKER_H_
 #define _CARTO_CULLWORKER_H_
 
+#include "components/CancelableTask.h"
 #include "components/ThreadWorker.h"
 #include "core/MapEnvelope.h"
 #include "renderers/components/CullState.h"
+#include "renderers/components/FrameSyncGate.h"
 
 #include <chrono>
 #include <condition_variable>
+#include <atomic>
 #include <map>
 #include <memory>
+#include <set>
 #include <thread>
 #include <vector>
 
@@ -36,15 +40,36 @@ namespace carto {
         void stop();
         
         bool isIdle() const;
+
+        void setFrameSynchronous(bool enabled);
+        void frameStarted();
+        void frameSubmitted();
     
         void operator()();
     
     private:
+        class LayerUpdateTask : public CancelableTask {
+        public:
+            LayerUpdateTask(const std::shared_ptr<CullWorker>& worker, const std::shared_ptr<Layer>& layer, const std::shared_ptr<CullState>& cullState);
+
+            virtual void cancel();
+            virtual void run();
+
+        private:
+            void finish(bool canceled);
+
+            std::weak_ptr<CullWorker> _worker;
+            std::shared_ptr<Layer> _layer;
+            std::shared_ptr<CullState> _cullState;
+            std::atomic<bool> _finished;
+        };
+
         void run();
     
         void calculateCullState();
         void calculateEnvelope();
         void updateLayers(const std::vector<std::shared_ptr<Layer> >& layers);
+        void layerUpdated(const std::shared_ptr<Layer>& layer, bool canceled);
     
         static const int MAX_VIEWPORT_TESSELATION_LEVEL;
 
@@ -53,6 +78,9 @@ namespace carto {
         static const float VIEWPORT_SCALE;
 
         std::map<std::shared_ptr<Layer>, std::chrono::steady_clock::time_point> _layerWakeupMap;
+        std::set<std::shared_ptr<Layer> > _updatingLayers; // layers with pending update tasks in the envelope thread pool
+
+        FrameSyncGate _frameSyncGate;
         
         bool _firstCull;
         
@@ -0,0 +1,103 @@
+#include "RedrawWorker.h"
+#include "renderers/MapRenderer.h"
+#include "renderers/RedrawRequestListener.h"
+
+#include <algorithm>
+
+namespace carto {
+
+    RedrawWorker::RedrawWorker() :
+        _stop(false),
+        _frameTime(),
+        _pendingWakeup(false),
+        _wakeupTime(std::chrono::steady_clock::now() + std::chrono::hours(24)),
+        _mapRenderer(),
+        _worker(),
+        _condition(),
+        _mutex()
+    {
+    }
+    
+    RedrawWorker::~RedrawWorker() {
+    }
+        
+    void RedrawWorker::setComponents(const std::weak_ptr<MapRenderer>& mapRenderer, const std::shared_ptr<RedrawWorker>& worker) {
+        _mapRenderer = mapRenderer;
+        // When the map component gets destroyed all threads get detatched. Detatched threads need their worker objects to be alive,
+        // so worker objects need to keep references to themselves, until the loop finishes.
+        _worker = worker;
+    }
+
+    void RedrawWorker::setFrameTime(const std::chrono::steady_clock::time_point& frameTime) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _frameTime = frameTime;
+    }
+        
+    bool RedrawWorker::init(float targetFPS) {
+        if (targetFPS <= 0) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto frameInterval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(1.0f / targetFPS));
+        std::chrono::steady_clock::time_point redrawTime = _frameTime + frameInterval;
+        if (redrawTime - std::chrono::steady_clock::now() < std::chrono::milliseconds(1)) {
+            return false;
+        }
+        _pendingWakeup = true;
+        _wakeupTime = std::min(_wakeupTime, redrawTime);
+        _condition.notify_one();
+        return true;
+    }
+    
+    void RedrawWorker::stop() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+        _condition.notify_all();
+    }
+        
+    void RedrawWorker::operator ()() {
+        run();
+        _worker.reset();
+    }
+    
+    void RedrawWorker::run() {
+        while (true) {
+            bool run = false;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+
+                if (_stop) {
+                    return;
+                }
+
+                std::chrono::steady_clock::time_point currentTime = std::chrono::steady_clock::now();
+                if (_pendingWakeup && _wakeupTime - currentTime < std::chrono::milliseconds(1)) {
+                    run = true;
+                    _pendingWakeup = false;
+                    _wakeupTime = currentTime + std::chrono::hours(24);
+                }
+
+                if (!run) {
+                    _condition.wait_for(lock, _wakeupTime - currentTime);
+                }
+            }
+
+            if (run) {
+                requestRedraw();
+            }
+        }
+    }
+
+    void RedrawWorker::requestRedraw() {
+        std::shared_ptr<MapRenderer> mapRenderer = _mapRenderer.lock();
+        if (!mapRenderer) {
+            return;
+        }
+
+        if (std::shared_ptr<RedrawRequestListener> redrawRequestListener = mapRenderer->getRedrawRequestListener()) {
+            redrawRequestListener->onRedrawRequested();
+        }
+    }
+    
+}
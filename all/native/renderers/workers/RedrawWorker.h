@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_REDRAWWORKER_H_
+#define _CARTO_REDRAWWORKER_H_
+
+#include "components/ThreadWorker.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace carto {
+    class MapRenderer;
+    
+    class RedrawWorker : public ThreadWorker {
+    public:
+        RedrawWorker();
+        virtual ~RedrawWorker();
+        
+        void setComponents(const std::weak_ptr<MapRenderer>& mapRenderer, const std::shared_ptr<RedrawWorker>& worker);
+
+        void setFrameTime(const std::chrono::steady_clock::time_point& frameTime);
+
+        // Delays the redraw request until the frame interval of the target frame rate has passed since the last frame.
+        // Returns false if the interval has already passed and the redraw should be requested immediately.
+        bool init(float targetFPS);
+        
+        void stop();
+    
+        void operator()();
+    
+    private:
+        void run();
+
+        void requestRedraw();
+        
+        bool _stop;
+        
+        std::chrono::steady_clock::time_point _frameTime;
+
+        bool _pendingWakeup;
+        std::chrono::steady_clock::time_point _wakeupTime;
+        
+        std::weak_ptr<MapRenderer> _mapRenderer;
+        std::shared_ptr<RedrawWorker> _worker;
+    
+        std::condition_variable _condition;
+        mutable std::mutex _mutex;
+    };
+    
+}
+
+#endif
@@ -6,6 +6,9 @@
 #include "utils/Const.h"
 #include "utils/Log.h"
 #include "utils/ThreadUtils.h"
+#include "utils/TraceUtils.h"
+
+#include <cmath>
 
 #include <vt/LabelCuller.h>
 
@@ -15,7 +18,11 @@ namespace carto {
         _stop(false),
         _idle(false),
         _pendingWakeup(false),
+        _pendingTilesChanged(false),
         _wakeupTime(std::chrono::steady_clock::now() + std::chrono::hours(24)),
+        _frameSyncGate(),
+        _placementValid(false),
+        _placementViewState(),
         _mapRenderer(),
         _condition(),
         _mutex()
@@ -32,14 +39,18 @@ namespace carto {
         _worker = worker;
     }
         
-    void VTLabelPlacementWorker::init(const std::shared_ptr<Layer>& layer, int delayTime) {
+    void VTLabelPlacementWorker::init(const std::shared_ptr<Layer>& layer, int delayTime, bool tilesChanged) {
         if (!std::dynamic_pointer_cast<VectorTileLayer>(layer)) {
             return;
         }
 
         std::lock_guard<std::mutex> lock(_mutex);
+        if (_frameSyncGate.isEnabled()) {
+            delayTime = 0; // the placement is started once the current frame is submitted instead
+        }
         _idle = false;
         _pendingWakeup = true;
+        _pendingTilesChanged = _pendingTilesChanged || tilesChanged;
         _wakeupTime = std::min(_wakeupTime, std::chrono::steady_clock::now() + std::chrono::milliseconds(delayTime));
         _condition.notify_one();
     }
@@ -54,6 +65,23 @@ namespace carto {
         std::lock_guard<std::mutex> lock(_mutex);
         return _idle;
     }
+
+    void VTLabelPlacementWorker::setFrameSynchronous(bool enabled) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _frameSyncGate.setEnabled(enabled);
+        _condition.notify_one();
+    }
+
+    void VTLabelPlacementWorker::frameStarted() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _frameSyncGate.frameStarted();
+    }
+
+    void VTLabelPlacementWorker::frameSubmitted() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _frameSyncGate.frameSubmitted();
+        _condition.notify_one();
+    }
         
     void VTLabelPlacementWorker::operator ()() {
         run();
@@ -61,10 +89,11 @@ namespace carto {
     }
     
     void VTLabelPlacementWorker::run() {
-        ThreadUtils::SetThreadPriority(ThreadPriority::LOW);
+        ThreadUtils::SetThreadRole(ThreadRole::INTERACTIVE);
     
         while (true) {
             bool run = false;
+            bool tilesChanged = false;
             {
                 std::unique_lock<std::mutex> lock(_mutex);
 
@@ -73,32 +102,48 @@ namespace carto {
                 }
 
                 std::chrono::steady_clock::time_point currentTime = std::chrono::steady_clock::now();
-                if (_wakeupTime - currentTime < std::chrono::milliseconds(1)) {
-                    run = true;
-                    _pendingWakeup = false;
-                    _wakeupTime = currentTime + std::chrono::hours(24);
+                std::chrono::steady_clock::duration waitTime = _wakeupTime - currentTime;
+                if (waitTime < std::chrono::milliseconds(1)) {
+                    // In frame synchronous mode wait until the frame being drawn is submitted
+                    waitTime = _frameSyncGate.getHoldTime(currentTime);
+                    if (waitTime == std::chrono::steady_clock::duration::zero()) {
+                        run = true;
+                        tilesChanged = _pendingTilesChanged;
+                        _pendingWakeup = false;
+                        _pendingTilesChanged = false;
+                        _wakeupTime = currentTime + std::chrono::hours(24);
+                    }
                 }
 
                 if (!run) {
                     _idle = !_pendingWakeup;
-                    _condition.wait_for(lock, _wakeupTime - currentTime);
+                    _condition.wait_for(lock, waitTime);
                     _idle = false;
                 }
             }
 
             if (run) {
-                calculateVTLabelPlacement();
+                calculateVTLabelPlacement(tilesChanged);
             }
         }
     }
     
-    bool VTLabelPlacementWorker::calculateVTLabelPlacement() {
+    bool VTLabelPlacementWorker::calculateVTLabelPlacement(bool tilesChanged) {
+        CARTO_TRACE_SECTION("VTLabelPlacementWorker::calculateVTLabelPlacement");
+
         std::shared_ptr<MapRenderer> mapRenderer = _mapRenderer.lock();
         if (!mapRenderer) {
             return false;
         }
 
         ViewState viewState = mapRenderer->getViewState();
+
+        // If the tiles are the same and the labels moved less than the threshold on screen, keep the previous placement
+        if (!tilesChanged && isPlacementReusable(viewState)) {
+            return true;
+        }
+        _placementValid = true;
+        _placementViewState = viewState;
         std::vector<std::shared_ptr<Layer>> layers = mapRenderer->getLayers()->getAll();
 
         vt::LabelCuller culler(Const::WORLD_SIZE);
@@ -122,4 +167,33 @@ namespace carto {
         return true;
     }
 
+    bool VTLabelPlacementWorker::isPlacementReusable(const ViewState& viewState) const {
+        if (!_placementValid || !viewState.getProjectionSurface() || viewState.getProjectionSurface() != _placementViewState.getProjectionSurface()) {
+            return false;
+        }
+        if (viewState.getWidth() != _placementViewState.getWidth() || viewState.getHeight() != _placementViewState.getHeight()) {
+            return false;
+        }
+
+        // Estimate the screen displacement of the labels using the ground points below the screen corners and center
+        float width = static_cast<float>(viewState.getWidth());
+        float height = static_cast<float>(viewState.getHeight());
+        const cglib::vec2<float> screenPoses[] = {
+            cglib::vec2<float>(0, 0), cglib::vec2<float>(width, 0), cglib::vec2<float>(0, height), cglib::vec2<float>(width, height), cglib::vec2<float>(width * 0.5f, height * 0.5f)
+        };
+        for (const cglib::vec2<float>& screenPos : screenPoses) {
+            cglib::vec3<double> worldPos = viewState.screenToWorld(screenPos, 0);
+            if (!(std::isfinite(worldPos(0)) && std::isfinite(worldPos(1)) && std::isfinite(worldPos(2)))) {
+                return false;
+            }
+            cglib::vec2<float> lastScreenPos = _placementViewState.worldToScreen(worldPos);
+            if (!(cglib::length(lastScreenPos - screenPos) < PLACEMENT_REUSE_THRESHOLD)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const float VTLabelPlacementWorker::PLACEMENT_REUSE_THRESHOLD = 1.0f; // in pixels
+
 }
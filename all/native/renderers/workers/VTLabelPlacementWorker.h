@@ -8,6 +8,8 @@
 #define _CARTO_VTLABELPLACEMENTWORKER_H_
 
 #include "components/ThreadWorker.h"
+#include "graphics/ViewState.h"
+#include "renderers/components/FrameSyncGate.h"
 
 #include <chrono>
 #include <condition_variable>
@@ -25,25 +27,38 @@ namespace carto {
         
         void setComponents(const std::weak_ptr<MapRenderer>& mapRenderer, const std::shared_ptr<VTLabelPlacementWorker>& worker);
         
-        void init(const std::shared_ptr<Layer>& layer, int delayTime);
+        void init(const std::shared_ptr<Layer>& layer, int delayTime, bool tilesChanged);
         
         void stop();
         
         bool isIdle() const;
+
+        void setFrameSynchronous(bool enabled);
+        void frameStarted();
+        void frameSubmitted();
     
         void operator()();
     
     private:
         void run();
         
-        bool calculateVTLabelPlacement();
+        bool calculateVTLabelPlacement(bool tilesChanged);
+        bool isPlacementReusable(const ViewState& viewState) const;
+
+        static const float PLACEMENT_REUSE_THRESHOLD;
         
         bool _stop;
         bool _idle;
         
         bool _pendingWakeup;
+        bool _pendingTilesChanged;
         std::chrono::steady_clock::time_point _wakeupTime;
+
+        FrameSyncGate _frameSyncGate;
         
+        bool _placementValid;
+        ViewState _placementViewState; // view state used for the last label placement
+
         std::weak_ptr<MapRenderer> _mapRenderer;
         std::shared_ptr<VTLabelPlacementWorker> _worker;
     
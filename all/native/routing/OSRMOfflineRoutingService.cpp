@@ -13,23 +13,20 @@
 #include <osrm/Instruction.h>
 #include <osrm/RouteFinder.h>
 
+#include <fstream>
+
 namespace carto {
 
     OSRMOfflineRoutingService::OSRMOfflineRoutingService(const std::string& path) :
         RoutingService(),
-        _routeFinder()
+        _path(path),
+        _routeFinder(),
+        _mutex()
     {
-        osrm::Graph::Settings graphSettings;
-        auto graph = std::make_shared<osrm::Graph>(graphSettings);
-        try {
-            if (!graph->import(path)) {
-                throw FileException("Failed to import routing graph", path);
-            }
+        std::ifstream graphFile(path, std::ios::binary);
+        if (!graphFile.good()) {
+            throw FileException("Failed to open routing graph", path);
         }
-        catch (const std::exception& ex) {
-            throw GenericException("Exception while importing routing graph", ex.what());
-        }
-        _routeFinder = std::make_shared<osrm::RouteFinder>(graph);
     }
 
     OSRMOfflineRoutingService::~OSRMOfflineRoutingService() {
@@ -54,7 +51,25 @@ namespace carto {
             throw NullArgumentException("Null request");
         }
 
-        return OSRMRoutingProxy::CalculateRoute(_routeFinder, request);
+        return OSRMRoutingProxy::CalculateRoute(getRouteFinder(), request);
+    }
+
+    std::shared_ptr<osrm::RouteFinder> OSRMOfflineRoutingService::getRouteFinder() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_routeFinder) {
+            osrm::Graph::Settings graphSettings;
+            auto graph = std::make_shared<osrm::Graph>(graphSettings);
+            try {
+                if (!graph->import(_path)) {
+                    throw FileException("Failed to import routing graph", _path);
+                }
+            }
+            catch (const std::exception& ex) {
+                throw GenericException("Exception while importing routing graph", ex.what());
+            }
+            _routeFinder = std::make_shared<osrm::RouteFinder>(graph);
+        }
+        return _routeFinder;
     }
 
 }
@@ -12,6 +12,7 @@
 #include "routing/RoutingService.h"
 
 #include <memory>
+#include <mutex>
 #include <string>
 
 namespace carto {
@@ -28,6 +29,7 @@ namespace carto {
     public:
         /**
          * Constructs a new OSRMOfflineRoutingService instance given database file.
+         * The routing graph is imported lazily when the first route is calculated, so construction is fast.
          * @param path The full path to the database file.
          * @throws std::runtime_error If the database file could not be opened or read.
          */
@@ -42,7 +44,12 @@ namespace carto {
         virtual std::shared_ptr<RoutingResult> calculateRoute(const std::shared_ptr<RoutingRequest>& request) const;
 
     protected:
-        std::shared_ptr<osrm::RouteFinder> _routeFinder;
+        std::shared_ptr<osrm::RouteFinder> getRouteFinder() const;
+
+        const std::string _path;
+        mutable std::shared_ptr<osrm::RouteFinder> _routeFinder;
+
+        mutable std::mutex _mutex;
     };
     
 }
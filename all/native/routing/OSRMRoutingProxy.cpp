@@ -10,6 +10,7 @@
 #include "routing/RouteMatchingRequest.h"
 #include "routing/RouteMatchingResult.h"
 #include "network/HTTPClient.h"
+#include "network/ServiceResponseCache.h"
 #include "utils/NetworkUtils.h"
 #include "utils/Const.h"
 #include "utils/Log.h"
@@ -100,9 +101,8 @@ namespace carto {
         
         std::map<std::string, std::string> requestHeaders = NetworkUtils::CreateAppRefererHeader();
         requestHeaders["Connection"] = "close";
-        std::map<std::string, std::string> responseHeaders;
         std::shared_ptr<BinaryData> responseData;
-        if (httpClient.get(url, requestHeaders, responseHeaders, responseData) != 0) {
+        if (ServiceResponseCache::GetInstance().get(httpClient, url, requestHeaders, responseData, std::shared_ptr<ServiceResponseCache::Session>()) != 0) {
             std::string result;
             if (responseData) {
                 result = std::string(reinterpret_cast<const char*>(responseData->data()), responseData->size());
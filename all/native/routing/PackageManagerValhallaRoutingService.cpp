@@ -6,9 +6,12 @@
 #include "packagemanager/handlers/ValhallaRoutingPackageHandler.h"
 #include "projections/Projection.h"
 #include "routing/ValhallaRoutingProxy.h"
+#include "routing/ValhallaGraphReaderCache.h"
 #include "utils/Const.h"
 #include "utils/Log.h"
 
+#include <algorithm>
+
 #include <boost/algorithm/string.hpp>
 
 namespace carto {
@@ -133,6 +136,64 @@ namespace carto {
 
         return result;
     }
+
+    std::shared_ptr<RoutingMatrixResult> PackageManagerValhallaRoutingService::calculateMatrix(const std::shared_ptr<RoutingMatrixRequest>& request) const {
+        if (!request) {
+            throw NullArgumentException("Null request");
+        }
+
+        // Do routing via package manager, so that all packages are locked during routing
+        std::shared_ptr<RoutingMatrixResult> result;
+        _packageManager->accessLocalPackages([this, &result, &request](const std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> >& packageHandlerMap) {
+            // Build map of routing packages and graph files
+            std::vector<std::shared_ptr<sqlite3pp::database> > packageDatabases;
+            for (auto it = packageHandlerMap.begin(); it != packageHandlerMap.end(); it++) {
+                if (auto valhallaRoutingHandler = std::dynamic_pointer_cast<ValhallaRoutingPackageHandler>(it->second)) {
+                    if (std::shared_ptr<sqlite3pp::database> database = valhallaRoutingHandler->getDatabase()) {
+                        packageDatabases.push_back(database);
+                    }
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (packageDatabases != _cachedPackageDatabases) {
+                _cachedPackageDatabases = packageDatabases;
+            }
+
+            ValhallaRoutingProxy::WorkerContext context(_cachedPackageDatabases, _configuration);
+            result = ValhallaRoutingProxy::CalculateMatrix(context, _profile, request);
+        });
+
+        return result;
+    }
+
+    void PackageManagerValhallaRoutingService::warmupGraphTiles(const MapBounds& bounds, const std::shared_ptr<Projection>& projection) const {
+        if (!projection) {
+            throw NullArgumentException("Null projection");
+        }
+
+        MapBounds wgs84Bounds(projection->toWgs84(bounds.getMin()), projection->toWgs84(bounds.getMax()));
+        _packageManager->accessLocalPackages([this, &wgs84Bounds](const std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> >& packageHandlerMap) {
+            // Build map of routing packages and graph files
+            std::vector<std::shared_ptr<sqlite3pp::database> > packageDatabases;
+            for (auto it = packageHandlerMap.begin(); it != packageHandlerMap.end(); it++) {
+                if (auto valhallaRoutingHandler = std::dynamic_pointer_cast<ValhallaRoutingPackageHandler>(it->second)) {
+                    if (std::shared_ptr<sqlite3pp::database> database = valhallaRoutingHandler->getDatabase()) {
+                        packageDatabases.push_back(database);
+                    }
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (packageDatabases != _cachedPackageDatabases) {
+                _cachedPackageDatabases = packageDatabases;
+            }
+
+            // The graph reader of the context is returned to the shared cache with the loaded tiles
+            ValhallaRoutingProxy::WorkerContext context(_cachedPackageDatabases, _configuration);
+            ValhallaRoutingProxy::WarmupGraphTiles(context, wgs84Bounds);
+        });
+    }
             
     PackageManagerValhallaRoutingService::PackageManagerListener::PackageManagerListener(PackageManagerValhallaRoutingService& service) :
         _service(service)
@@ -140,8 +201,31 @@ namespace carto {
     }
         
     void PackageManagerValhallaRoutingService::PackageManagerListener::onPackagesChanged() {
-        std::lock_guard<std::mutex> lock(_service._mutex);
-        _service._cachedPackageDatabases.clear();
+        // Find the databases of the packages still present, handlers of unchanged packages keep their connections
+        std::vector<std::shared_ptr<sqlite3pp::database> > packageDatabases;
+        _service._packageManager->accessLocalPackages([&packageDatabases](const std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> >& packageHandlerMap) {
+            for (auto it = packageHandlerMap.begin(); it != packageHandlerMap.end(); it++) {
+                if (auto valhallaRoutingHandler = std::dynamic_pointer_cast<ValhallaRoutingPackageHandler>(it->second)) {
+                    if (std::shared_ptr<sqlite3pp::database> database = valhallaRoutingHandler->getDatabase()) {
+                        packageDatabases.push_back(database);
+                    }
+                }
+            }
+        });
+
+        std::vector<std::shared_ptr<sqlite3pp::database> > removedDatabases;
+        {
+            std::lock_guard<std::mutex> lock(_service._mutex);
+            for (const std::shared_ptr<sqlite3pp::database>& database : _service._cachedPackageDatabases) {
+                if (std::find(packageDatabases.begin(), packageDatabases.end(), database) == packageDatabases.end()) {
+                    removedDatabases.push_back(database);
+                }
+            }
+            _service._cachedPackageDatabases.clear();
+        }
+
+        // Close the graph readers of removed and updated packages, instead of waiting for them to be evicted
+        ValhallaGraphReaderCache::GetInstance().removeReaders(removedDatabases);
     }
 
     void PackageManagerValhallaRoutingService::PackageManagerListener::onStylesChanged() {
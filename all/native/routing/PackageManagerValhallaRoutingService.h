@@ -9,6 +9,7 @@
 
 #if defined(_CARTO_ROUTING_SUPPORT) && defined(_CARTO_VALHALLA_ROUTING_SUPPORT) && defined(_CARTO_PACKAGEMANAGER_SUPPORT)
 
+#include "core/MapBounds.h"
 #include "core/Variant.h"
 #include "packagemanager/PackageManager.h"
 #include "routing/RoutingService.h"
@@ -56,6 +57,18 @@ namespace carto {
 
         virtual std::shared_ptr<RoutingResult> calculateRoute(const std::shared_ptr<RoutingRequest>& request) const;
 
+        virtual std::shared_ptr<RoutingMatrixResult> calculateMatrix(const std::shared_ptr<RoutingMatrixRequest>& request) const;
+
+        /**
+         * Loads the routing graph tiles covering the specified area into the graph tile cache,
+         * so that the following routing requests in the area do not need to read and decode them.
+         * The cache is shared by all Valhalla routing service instances.
+         * @param bounds The bounds of the area.
+         * @param projection The projection of the bounds.
+         * @throws std::runtime_error If the graph tiles could not be loaded.
+         */
+        void warmupGraphTiles(const MapBounds& bounds, const std::shared_ptr<Projection>& projection) const;
+
     protected:
         class PackageManagerListener : public PackageManager::OnChangeListener {
         public:
@@ -0,0 +1,88 @@
+#ifdef _CARTO_ROUTING_SUPPORT
+
+#include "RouteMatchingSession.h"
+#include "components/Exceptions.h"
+#include "routing/RoutingService.h"
+#include "routing/RouteMatchingRequest.h"
+#include "routing/RouteMatchingResult.h"
+
+namespace carto {
+
+    RouteMatchingSession::RouteMatchingSession(const std::shared_ptr<RoutingService>& routingService, const std::shared_ptr<Projection>& projection, float accuracy) :
+        _routingService(routingService),
+        _projection(projection),
+        _accuracy(accuracy),
+        _windowSize(DEFAULT_WINDOW_SIZE),
+        _points(),
+        _mutex()
+    {
+        if (!routingService) {
+            throw NullArgumentException("Null routingService");
+        }
+        if (!projection) {
+            throw NullArgumentException("Null projection");
+        }
+    }
+
+    RouteMatchingSession::~RouteMatchingSession() {
+    }
+
+    const std::shared_ptr<RoutingService>& RouteMatchingSession::getRoutingService() const {
+        return _routingService;
+    }
+
+    const std::shared_ptr<Projection>& RouteMatchingSession::getProjection() const {
+        return _projection;
+    }
+
+    float RouteMatchingSession::getAccuracy() const {
+        return _accuracy;
+    }
+
+    int RouteMatchingSession::getWindowSize() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _windowSize;
+    }
+
+    void RouteMatchingSession::setWindowSize(int windowSize) {
+        if (windowSize < 2) {
+            throw InvalidArgumentException("Window size must be at least 2");
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _windowSize = windowSize;
+        while (static_cast<int>(_points.size()) > _windowSize) {
+            _points.pop_front();
+        }
+    }
+
+    std::vector<MapPos> RouteMatchingSession::getPoints() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return std::vector<MapPos>(_points.begin(), _points.end());
+    }
+
+    std::shared_ptr<RouteMatchingResult> RouteMatchingSession::addPoint(const MapPos& pos) {
+        std::vector<MapPos> points;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _points.push_back(pos);
+            while (static_cast<int>(_points.size()) > _windowSize) {
+                _points.pop_front();
+            }
+            points.assign(_points.begin(), _points.end());
+        }
+
+        auto request = std::make_shared<RouteMatchingRequest>(_projection, points, _accuracy);
+        return _routingService->matchRoute(request);
+    }
+
+    void RouteMatchingSession::reset() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _points.clear();
+    }
+
+    const int RouteMatchingSession::DEFAULT_WINDOW_SIZE = 16;
+
+}
+
+#endif
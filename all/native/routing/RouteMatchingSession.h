@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_ROUTEMATCHINGSESSION_H_
+#define _CARTO_ROUTEMATCHINGSESSION_H_
+
+#ifdef _CARTO_ROUTING_SUPPORT
+
+#include "core/MapPos.h"
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace carto {
+    class Projection;
+    class RoutingService;
+    class RouteMatchingResult;
+
+    /**
+     * A stateful route matching session for live GPS positions.
+     * Points are added one at a time and each update matches only a sliding window of the most recent points,
+     * so the cost of an update does not grow with the length of the trace.
+     */
+    class RouteMatchingSession {
+    public:
+        /**
+         * Constructs a new RouteMatchingSession instance.
+         * @param routingService The routing service to use for matching.
+         * @param projection The projection of the points.
+         * @param accuracy Accuracy of the points in meters.
+         */
+        RouteMatchingSession(const std::shared_ptr<RoutingService>& routingService, const std::shared_ptr<Projection>& projection, float accuracy);
+        virtual ~RouteMatchingSession();
+
+        /**
+         * Returns the routing service used by the session.
+         * @return The routing service used by the session.
+         */
+        const std::shared_ptr<RoutingService>& getRoutingService() const;
+        /**
+         * Returns the projection of the points.
+         * @return The projection of the points.
+         */
+        const std::shared_ptr<Projection>& getProjection() const;
+        /**
+         * Returns the accuracy of the points.
+         * @return The accuracy of the points in meters.
+         */
+        float getAccuracy() const;
+
+        /**
+         * Returns the maximum number of recent points used for matching.
+         * @return The maximum number of recent points used for matching.
+         */
+        int getWindowSize() const;
+        /**
+         * Sets the maximum number of recent points used for matching.
+         * Larger windows give more stable results, smaller windows faster updates. The default is 16.
+         * @param windowSize The new window size. Must be at least 2.
+         */
+        void setWindowSize(int windowSize);
+
+        /**
+         * Returns the points currently in the matching window.
+         * @return The points currently in the matching window.
+         */
+        std::vector<MapPos> getPoints() const;
+
+        /**
+         * Adds a new point to the session and matches the current window of points.
+         * @param pos The new point.
+         * @return The matching result for the points in the current window or null if matching failed.
+         * @throws std::runtime_error If IO error occured during the route matching.
+         */
+        std::shared_ptr<RouteMatchingResult> addPoint(const MapPos& pos);
+
+        /**
+         * Removes all points from the session.
+         */
+        void reset();
+
+    private:
+        static const int DEFAULT_WINDOW_SIZE;
+
+        const std::shared_ptr<RoutingService> _routingService;
+        const std::shared_ptr<Projection> _projection;
+        const float _accuracy;
+        int _windowSize;
+        std::deque<MapPos> _points;
+
+        mutable std::mutex _mutex;
+    };
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,97 @@
+#ifdef _CARTO_ROUTING_SUPPORT
+
+#include "RoutingMatrixRequest.h"
+#include "components/Exceptions.h"
+
+#include <iomanip>
+#include <sstream>
+
+#include <boost/algorithm/string.hpp>
+
+namespace carto {
+
+    RoutingMatrixRequest::RoutingMatrixRequest(const std::shared_ptr<Projection>& projection, const std::vector<MapPos>& sourcePoints, const std::vector<MapPos>& targetPoints) :
+        _projection(projection),
+        _sourcePoints(sourcePoints),
+        _targetPoints(targetPoints),
+        _customParams(),
+        _mutex()
+    {
+        if (!projection) {
+            throw NullArgumentException("Null projection");
+        }
+    }
+
+    RoutingMatrixRequest::~RoutingMatrixRequest() {
+    }
+
+    const std::shared_ptr<Projection>& RoutingMatrixRequest::getProjection() const {
+        return _projection;
+    }
+
+    const std::vector<MapPos>& RoutingMatrixRequest::getSourcePoints() const {
+        return _sourcePoints;
+    }
+
+    const std::vector<MapPos>& RoutingMatrixRequest::getTargetPoints() const {
+        return _targetPoints;
+    }
+
+    Variant RoutingMatrixRequest::getCustomParameters() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _customParams;
+    }
+
+    Variant RoutingMatrixRequest::getCustomParameter(const std::string& param) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::vector<std::string> keys;
+        boost::split(keys, param, boost::is_any_of("."));
+        picojson::value subValue = _customParams.toPicoJSON();
+        for (const std::string& key : keys) {
+            if (!subValue.is<picojson::object>()) {
+                return Variant();
+            }
+            subValue = subValue.get(key);
+        }
+        return Variant::FromPicoJSON(subValue);
+    }
+
+    void RoutingMatrixRequest::setCustomParameter(const std::string& param, const Variant& value) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::vector<std::string> keys;
+        boost::split(keys, param, boost::is_any_of("."));
+        picojson::value rootValue = _customParams.toPicoJSON();
+        picojson::value* subValue = &rootValue;
+        for (const std::string& key : keys) {
+            if (!subValue->is<picojson::object>()) {
+                subValue->set(picojson::object());
+            }
+            subValue = &subValue->get<picojson::object>()[key];
+        }
+        *subValue = value.toPicoJSON();
+        _customParams = Variant::FromPicoJSON(rootValue);
+    }
+
+    std::string RoutingMatrixRequest::toString() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::stringstream ss;
+        ss << std::setiosflags(std::ios::fixed);
+        ss << "RoutingMatrixRequest [sourcePoints=[";
+        for (auto it = _sourcePoints.begin(); it != _sourcePoints.end(); ++it) {
+            ss << (it == _sourcePoints.begin() ? "" : ", ") << (*it).toString();
+        }
+        ss << "], targetPoints=[";
+        for (auto it = _targetPoints.begin(); it != _targetPoints.end(); ++it) {
+            ss << (it == _targetPoints.begin() ? "" : ", ") << (*it).toString();
+        }
+        ss << "]";
+        if (_customParams.getType() != VariantType::VARIANT_TYPE_NULL) {
+            ss << ", customParams=" << _customParams.toString();
+        }
+        ss << "]";
+        return ss.str();
+    }
+
+}
+
+#endif
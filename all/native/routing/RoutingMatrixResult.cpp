@@ -0,0 +1,78 @@
+#ifdef _CARTO_ROUTING_SUPPORT
+
+#include "RoutingMatrixResult.h"
+#include "components/Exceptions.h"
+
+#include <sstream>
+
+namespace carto {
+
+    RoutingMatrixResult::RoutingMatrixResult(const std::shared_ptr<Projection>& projection, int sourceCount, int targetCount, const std::vector<double>& times, const std::vector<double>& distances) :
+        _projection(projection),
+        _sourceCount(sourceCount),
+        _targetCount(targetCount),
+        _times(times),
+        _distances(distances)
+    {
+        if (!projection) {
+            throw NullArgumentException("Null projection");
+        }
+        if (sourceCount < 0 || targetCount < 0) {
+            throw InvalidArgumentException("Negative point count");
+        }
+        std::size_t count = static_cast<std::size_t>(sourceCount) * static_cast<std::size_t>(targetCount);
+        if (times.size() != count || distances.size() != count) {
+            throw InvalidArgumentException("Matrix size does not match point counts");
+        }
+    }
+
+    RoutingMatrixResult::~RoutingMatrixResult() {
+    }
+
+    const std::shared_ptr<Projection>& RoutingMatrixResult::getProjection() const {
+        return _projection;
+    }
+
+    int RoutingMatrixResult::getSourceCount() const {
+        return _sourceCount;
+    }
+
+    int RoutingMatrixResult::getTargetCount() const {
+        return _targetCount;
+    }
+
+    double RoutingMatrixResult::getTime(int sourceIndex, int targetIndex) const {
+        return _times[getIndex(sourceIndex, targetIndex)];
+    }
+
+    double RoutingMatrixResult::getDistance(int sourceIndex, int targetIndex) const {
+        return _distances[getIndex(sourceIndex, targetIndex)];
+    }
+
+    std::string RoutingMatrixResult::toString() const {
+        std::stringstream ss;
+        ss << "RoutingMatrixResult [sourceCount=" << _sourceCount << ", targetCount=" << _targetCount << ", times=[";
+        for (std::size_t i = 0; i < _times.size(); i++) {
+            ss << (i == 0 ? "" : ", ") << _times[i];
+        }
+        ss << "], distances=[";
+        for (std::size_t i = 0; i < _distances.size(); i++) {
+            ss << (i == 0 ? "" : ", ") << _distances[i];
+        }
+        ss << "]]";
+        return ss.str();
+    }
+
+    std::size_t RoutingMatrixResult::getIndex(int sourceIndex, int targetIndex) const {
+        if (sourceIndex < 0 || sourceIndex >= _sourceCount) {
+            throw OutOfRangeException("Source index out of range");
+        }
+        if (targetIndex < 0 || targetIndex >= _targetCount) {
+            throw OutOfRangeException("Target index out of range");
+        }
+        return static_cast<std::size_t>(sourceIndex) * _targetCount + targetIndex;
+    }
+
+}
+
+#endif
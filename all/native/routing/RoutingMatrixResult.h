@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_ROUTINGMATRIXRESULT_H_
+#define _CARTO_ROUTINGMATRIXRESULT_H_
+
+#ifdef _CARTO_ROUTING_SUPPORT
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace carto {
+    class Projection;
+
+    /**
+     * A class that contains travel times and distances between all source and target points of a matrix request.
+     */
+    class RoutingMatrixResult {
+    public:
+        /**
+         * Constructs a new RoutingMatrixResult instance from projection, point counts, times and distances.
+         * @param projection The projection of the routing matrix result (same as the request).
+         * @param sourceCount The number of source points.
+         * @param targetCount The number of target points.
+         * @param times The travel times in seconds, in row-major order (sourceCount rows, targetCount columns). Negative values denote unreachable targets.
+         * @param distances The travel distances in meters, in the same order as times.
+         */
+        RoutingMatrixResult(const std::shared_ptr<Projection>& projection, int sourceCount, int targetCount, const std::vector<double>& times, const std::vector<double>& distances);
+        virtual ~RoutingMatrixResult();
+
+        /**
+         * Returns the projection of the result.
+         * @return The projection of the result.
+         */
+        const std::shared_ptr<Projection>& getProjection() const;
+        /**
+         * Returns the number of source points.
+         * @return The number of source points.
+         */
+        int getSourceCount() const;
+        /**
+         * Returns the number of target points.
+         * @return The number of target points.
+         */
+        int getTargetCount() const;
+
+        /**
+         * Returns the travel time between the specified source and target points.
+         * @param sourceIndex The index of the source point.
+         * @param targetIndex The index of the target point.
+         * @return The travel time in seconds. Negative if the target can not be reached from the source.
+         * @throws std::out_of_range If the index is out of range.
+         */
+        double getTime(int sourceIndex, int targetIndex) const;
+        /**
+         * Returns the travel distance between the specified source and target points.
+         * @param sourceIndex The index of the source point.
+         * @param targetIndex The index of the target point.
+         * @return The travel distance in meters. Negative if the target can not be reached from the source.
+         * @throws std::out_of_range If the index is out of range.
+         */
+        double getDistance(int sourceIndex, int targetIndex) const;
+
+        /**
+         * Creates a string representation of this result object, useful for logging.
+         * @return The string representation of this result object.
+         */
+        std::string toString() const;
+
+    private:
+        std::size_t getIndex(int sourceIndex, int targetIndex) const;
+
+        std::shared_ptr<Projection> _projection;
+        int _sourceCount;
+        int _targetCount;
+        std::vector<double> _times;
+        std::vector<double> _distances;
+    };
+
+}
+
+#endif
+
+#endif
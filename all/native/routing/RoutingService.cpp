@@ -1,6 +1,7 @@
 #ifdef _CARTO_ROUTING_SUPPORT
 
 #include "RoutingService.h"
+#include "components/Exceptions.h"
 
 namespace carto {
 
@@ -10,6 +11,32 @@ namespace carto {
     RoutingService::~RoutingService() {
     }
 
+    std::shared_ptr<RoutingMatrixResult> RoutingService::calculateMatrix(const std::shared_ptr<RoutingMatrixRequest>& request) const {
+        if (!request) {
+            throw NullArgumentException("Null request");
+        }
+
+        const std::vector<MapPos>& sourcePoints = request->getSourcePoints();
+        const std::vector<MapPos>& targetPoints = request->getTargetPoints();
+        std::vector<double> times;
+        std::vector<double> distances;
+        times.reserve(sourcePoints.size() * targetPoints.size());
+        distances.reserve(sourcePoints.size() * targetPoints.size());
+        for (const MapPos& sourcePoint : sourcePoints) {
+            for (const MapPos& targetPoint : targetPoints) {
+                auto routingRequest = std::make_shared<RoutingRequest>(request->getProjection(), std::vector<MapPos> { sourcePoint, targetPoint });
+                if (std::shared_ptr<RoutingResult> result = calculateRoute(routingRequest)) {
+                    times.push_back(result->getTotalTime());
+                    distances.push_back(result->getTotalDistance());
+                } else {
+                    times.push_back(-1);
+                    distances.push_back(-1);
+                }
+            }
+        }
+        return std::make_shared<RoutingMatrixResult>(request->getProjection(), static_cast<int>(sourcePoints.size()), static_cast<int>(targetPoints.size()), times, distances);
+    }
+
 }
 
 #endif
@@ -13,6 +13,8 @@
 #include "routing/RoutingResult.h"
 #include "routing/RouteMatchingRequest.h"
 #include "routing/RouteMatchingResult.h"
+#include "routing/RoutingMatrixRequest.h"
+#include "routing/RoutingMatrixResult.h"
 
 #include <memory>
 
@@ -52,6 +54,16 @@ namespace carto {
          */
         virtual std::shared_ptr<RoutingResult> calculateRoute(const std::shared_ptr<RoutingRequest>& request) const = 0;
 
+        /**
+         * Calculates travel times and distances between all source and target points of the request.
+         * The default implementation calculates a separate route for each source and target pair,
+         * services supporting matrix calculation natively override this.
+         * @param request The matrix request defining source and target points.
+         * @return The matrix result.
+         * @throws std::runtime_error If IO error occured during the calculation.
+         */
+        virtual std::shared_ptr<RoutingMatrixResult> calculateMatrix(const std::shared_ptr<RoutingMatrixRequest>& request) const;
+
     protected:
         /**
          * The default constructor.
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_SGREGRAPHLISTENER_H_
+#define _CARTO_SGREGRAPHLISTENER_H_
+
+#if defined(_CARTO_ROUTING_SUPPORT) && defined(_CARTO_OFFLINE_SUPPORT)
+
+#include <string>
+
+namespace carto {
+
+    /**
+     * Listener for background routing graph builds of SGREOfflineRoutingService.
+     * The methods are called from a background thread.
+     */
+    class SGREGraphListener {
+    public:
+        virtual ~SGREGraphListener() { }
+
+        /**
+         * Listener method that is called when the routing graph is ready and routes can be calculated without delay.
+         */
+        virtual void onGraphReady() { }
+        /**
+         * Listener method that is called when the routing graph could not be built, for example because of invalid rules.
+         * @param message The error message.
+         */
+        virtual void onGraphFailed(const std::string& message) { }
+    };
+
+}
+
+#endif
+
+#endif
@@ -1,15 +1,20 @@
 #if defined(_CARTO_ROUTING_SUPPORT) && defined(_CARTO_OFFLINE_SUPPORT)
 
 #include "SGREOfflineRoutingService.h"
+#include "components/DirectorPtr.h"
 #include "components/Exceptions.h"
 #include "geometry/FeatureCollection.h"
 #include "geometry/GeoJSONGeometryWriter.h"
 #include "projections/Projection.h"
 #include "projections/EPSG3857.h"
+#include "routing/SGREGraphListener.h"
 #include "utils/Const.h"
 #include "utils/Log.h"
+#include "utils/ThreadUtils.h"
+#include "utils/JSONUtils.h"
 
 #include <limits>
+#include <thread>
 
 #include <sgre/Graph.h>
 #include <sgre/GraphBuilder.h>
@@ -23,10 +28,10 @@ namespace carto {
 
     SGREOfflineRoutingService::SGREOfflineRoutingService(const Variant& geoJSON, const Variant& config) :
         RoutingService(),
-        _featureData(geoJSON.toPicoJSON()),
-        _config(config.toPicoJSON()),
+        _featureData(std::make_shared<picojson::value>(geoJSON.toPicoJSON())),
+        _config(std::make_shared<picojson::value>(config.toPicoJSON())),
         _profile(),
-        _cachedRouteFinder(),
+        _routeFinderFuture(),
         _mutex()
     {
     }
@@ -34,9 +39,9 @@ namespace carto {
     SGREOfflineRoutingService::SGREOfflineRoutingService(const std::shared_ptr<Projection>& projection, const std::shared_ptr<FeatureCollection>& featureCollection, const Variant& config) :
         RoutingService(),
         _featureData(),
-        _config(config.toPicoJSON()),
+        _config(std::make_shared<picojson::value>(config.toPicoJSON())),
         _profile(),
-        _cachedRouteFinder(),
+        _routeFinderFuture(),
         _mutex()
     {
         if (!featureCollection) {
@@ -46,10 +51,12 @@ namespace carto {
         GeoJSONGeometryWriter geometryWriter;
         geometryWriter.setSourceProjection(projection);
         geometryWriter.setZ(true);
-        std::string err = picojson::parse(_featureData, geometryWriter.writeFeatureCollection(featureCollection));
+        auto featureData = std::make_shared<picojson::value>();
+        std::string err = JSONUtils::ParsePicoJSON(*featureData, geometryWriter.writeFeatureCollection(featureCollection));
         if (!err.empty()) {
             throw GenericException("Error while serializing feature data", err);
         }
+        _featureData = featureData;
     }
 
     SGREOfflineRoutingService::~SGREOfflineRoutingService() {
@@ -64,10 +71,31 @@ namespace carto {
         std::lock_guard<std::mutex> lock(_mutex);
         if (profile != _profile) {
             _profile = profile;
-            _cachedRouteFinder.reset();
+            _routeFinderFuture = std::shared_future<std::shared_ptr<sgre::RouteFinder> >();
         }
     }
 
+    void SGREOfflineRoutingService::prebuildGraph(const std::shared_ptr<SGREGraphListener>& listener) {
+        std::shared_future<std::shared_ptr<sgre::RouteFinder> > routeFinderFuture = getRouteFinderFuture(true);
+        if (!listener) {
+            return;
+        }
+
+        // Keep the listener reference as DirectorPtr as the graph may be built after the method returns
+        DirectorPtr<SGREGraphListener> listenerPtr(listener);
+        std::thread notifyThread([routeFinderFuture, listenerPtr]() {
+            try {
+                routeFinderFuture.get();
+            }
+            catch (const std::exception& ex) {
+                listenerPtr->onGraphFailed(ex.what());
+                return;
+            }
+            listenerPtr->onGraphReady();
+        });
+        notifyThread.detach();
+    }
+
     std::shared_ptr<RouteMatchingResult> SGREOfflineRoutingService::matchRoute(const std::shared_ptr<RouteMatchingRequest>& request) const {
         throw GenericException("matchRoute not implemented for this RoutingService");
     }
@@ -77,26 +105,7 @@ namespace carto {
             throw NullArgumentException("Null request");
         }
 
-        std::shared_ptr<sgre::RouteFinder> routeFinder;
-        {
-            std::lock_guard<std::mutex> lock(_mutex);
-            if (!_cachedRouteFinder) {
-                try {
-                    sgre::RuleList ruleList;
-                    if (_config.contains("rules")) {
-                        ruleList = sgre::RuleList::parse(_config.get("rules"));
-                    }
-                    ruleList.filter(_profile);
-                    sgre::GraphBuilder graphBuilder(std::move(ruleList));
-                    graphBuilder.importGeoJSON(_featureData);
-                    _cachedRouteFinder = sgre::RouteFinder::create(graphBuilder.build(), _config);
-                }
-                catch (const std::exception& ex) {
-                    throw GenericException("Failed to create routing graph", ex.what());
-                }
-            }
-            routeFinder = _cachedRouteFinder;
-        }
+        std::shared_ptr<sgre::RouteFinder> routeFinder = getRouteFinderFuture(false).get();
 
         std::shared_ptr<Projection> proj = request->getProjection();
         EPSG3857 epsg3857;
@@ -179,6 +188,62 @@ namespace carto {
         return std::make_shared<RoutingResult>(proj, points, instructions);
     }
 
+    std::shared_ptr<sgre::RouteFinder> SGREOfflineRoutingService::BuildRouteFinder(const picojson::value& featureData, const picojson::value& config, const std::string& profile) {
+        try {
+            sgre::RuleList ruleList;
+            if (config.contains("rules")) {
+                ruleList = sgre::RuleList::parse(config.get("rules"));
+            }
+            ruleList.filter(profile);
+            sgre::GraphBuilder graphBuilder(std::move(ruleList));
+            graphBuilder.importGeoJSON(featureData);
+            return sgre::RouteFinder::create(graphBuilder.build(), config);
+        }
+        catch (const std::exception& ex) {
+            throw GenericException("Failed to create routing graph", ex.what());
+        }
+    }
+
+    std::shared_future<std::shared_ptr<sgre::RouteFinder> > SGREOfflineRoutingService::getRouteFinderFuture(bool background) const {
+        std::shared_ptr<std::promise<std::shared_ptr<sgre::RouteFinder> > > promise;
+        std::shared_future<std::shared_ptr<sgre::RouteFinder> > routeFinderFuture;
+        std::string profile;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_routeFinderFuture.valid()) {
+                promise = std::make_shared<std::promise<std::shared_ptr<sgre::RouteFinder> > >();
+                _routeFinderFuture = promise->get_future().share();
+            }
+            routeFinderFuture = _routeFinderFuture;
+            profile = _profile;
+        }
+
+        // Build outside of the lock, other callers wait for the future. Build failures are kept, as the inputs do not change.
+        if (promise) {
+            std::shared_ptr<const picojson::value> featureData = _featureData;
+            std::shared_ptr<const picojson::value> config = _config;
+            auto buildFn = [promise, featureData, config, profile]() {
+                try {
+                    promise->set_value(BuildRouteFinder(*featureData, *config, profile));
+                }
+                catch (...) {
+                    promise->set_exception(std::current_exception());
+                }
+            };
+
+            if (background) {
+                std::thread buildThread([buildFn]() {
+                    ThreadUtils::SetThreadRole(ThreadRole::BACKGROUND);
+                    buildFn();
+                });
+                buildThread.detach();
+            } else {
+                buildFn();
+            }
+        }
+        return routeFinderFuture;
+    }
+
     float SGREOfflineRoutingService::CalculateTurnAngle(const std::vector<MapPos>& epsg3857Points, int pointIndex) {
         int pointIndex0 = pointIndex;
         while (--pointIndex0 >= 0) {
@@ -12,6 +12,7 @@
 #include "core/Variant.h"
 #include "routing/RoutingService.h"
 
+#include <future>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -26,6 +27,7 @@ namespace carto {
 
     class FeatureCollection;
     class Projection;
+    class SGREGraphListener;
 
     /**
      * An offline routing service that uses SGRE routing engine.
@@ -53,6 +55,14 @@ namespace carto {
         virtual std::string getProfile() const;
         virtual void setProfile(const std::string& profile);
 
+        /**
+         * Starts building the routing graph for the current profile in a background thread.
+         * Otherwise the graph is built by the first routing request. Requests made while the graph is being built
+         * wait for the build instead of starting a new one. Changing the profile discards the graph.
+         * @param listener The listener to notify when the graph is ready or the build fails. Can be null.
+         */
+        void prebuildGraph(const std::shared_ptr<SGREGraphListener>& listener);
+
         virtual std::shared_ptr<RouteMatchingResult> matchRoute(const std::shared_ptr<RouteMatchingRequest>& request) const;
 
         virtual std::shared_ptr<RoutingResult> calculateRoute(const std::shared_ptr<RoutingRequest>& request) const;
@@ -64,11 +74,15 @@ namespace carto {
         
         static bool TranslateInstructionCode(int instructionCode, RoutingAction::RoutingAction& action);
 
-        picojson::value _featureData;
-        picojson::value _config;
+        static std::shared_ptr<sgre::RouteFinder> BuildRouteFinder(const picojson::value& featureData, const picojson::value& config, const std::string& profile);
+
+        std::shared_future<std::shared_ptr<sgre::RouteFinder> > getRouteFinderFuture(bool background) const;
+
+        std::shared_ptr<const picojson::value> _featureData; // immutable, shared with the graph build threads
+        std::shared_ptr<const picojson::value> _config;
         std::string _profile;
 
-        mutable std::shared_ptr<sgre::RouteFinder> _cachedRouteFinder;
+        mutable std::shared_future<std::shared_ptr<sgre::RouteFinder> > _routeFinderFuture;
 
         mutable std::mutex _mutex;
     };
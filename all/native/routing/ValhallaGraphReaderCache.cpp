@@ -0,0 +1,132 @@
+#if defined(_CARTO_ROUTING_SUPPORT) && defined(_CARTO_VALHALLA_ROUTING_SUPPORT)
+
+#include "ValhallaGraphReaderCache.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include <valhalla/baldr/graphreader.h>
+
+namespace carto {
+
+    ValhallaGraphReaderCache& ValhallaGraphReaderCache::GetInstance() {
+        static ValhallaGraphReaderCache instance;
+        return instance;
+    }
+
+    ValhallaGraphReaderCache::~ValhallaGraphReaderCache() {
+        _memoryConsumer->detach();
+    }
+
+    std::size_t ValhallaGraphReaderCache::getCapacity() const {
+        return _memoryConsumer->getCapacity();
+    }
+
+    void ValhallaGraphReaderCache::setCapacity(std::size_t capacityInBytes) {
+        _memoryConsumer->setCapacity(capacityInBytes);
+    }
+
+    void ValhallaGraphReaderCache::clear() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _idleReaders.clear();
+    }
+
+    std::shared_ptr<valhalla::baldr::GraphReader> ValhallaGraphReaderCache::acquireReader(const std::vector<std::shared_ptr<sqlite3pp::database> >& databases) {
+        std::shared_ptr<valhalla::baldr::GraphReader> reader;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            evict();
+            for (auto it = _idleReaders.begin(); it != _idleReaders.end(); it++) {
+                if (it->databases == databases) {
+                    reader = it->reader;
+                    _idleReaders.erase(it);
+                    break;
+                }
+            }
+        }
+
+        if (!reader) {
+            reader = std::make_shared<valhalla::baldr::GraphReader>(databases);
+        }
+
+        // Return the reader to the cache once the workers using it are released
+        return std::shared_ptr<valhalla::baldr::GraphReader>(reader.get(), [this, databases, reader](valhalla::baldr::GraphReader*) {
+            releaseReader(databases, reader);
+        });
+    }
+
+    void ValhallaGraphReaderCache::removeReaders(const std::vector<std::shared_ptr<sqlite3pp::database> >& databases) {
+        if (databases.empty()) {
+            return;
+        }
+
+        std::list<Entry> removedReaders;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _removedDatabases.insert(_removedDatabases.end(), databases.begin(), databases.end());
+            for (auto it = _idleReaders.begin(); it != _idleReaders.end(); ) {
+                auto next = std::next(it);
+                if (isRemoved(it->databases)) {
+                    removedReaders.splice(removedReaders.end(), _idleReaders, it);
+                }
+                it = next;
+            }
+        }
+        // Readers (and the database connections) are released outside of the lock
+    }
+
+    ValhallaGraphReaderCache::ValhallaGraphReaderCache() :
+        _idleReaders(),
+        _removedDatabases(),
+        _maxIdleReaders(DEFAULT_CAPACITY / READER_SIZE_ESTIMATE),
+        _memoryConsumer(),
+        _mutex()
+    {
+        _memoryConsumer = MemoryGovernor::GetInstance().registerConsumer(DEFAULT_CAPACITY, 1.0f,
+            [this](std::size_t budget) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _maxIdleReaders = budget / READER_SIZE_ESTIMATE;
+                evict();
+            },
+            [this](bool critical) {
+                clear();
+            }
+        );
+    }
+
+    void ValhallaGraphReaderCache::releaseReader(const std::vector<std::shared_ptr<sqlite3pp::database> >& databases, const std::shared_ptr<valhalla::baldr::GraphReader>& reader) {
+        Entry entry;
+        entry.databases = databases;
+        entry.reader = reader;
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _removedDatabases.erase(std::remove_if(_removedDatabases.begin(), _removedDatabases.end(), [](const std::weak_ptr<sqlite3pp::database>& database) { return database.expired(); }), _removedDatabases.end());
+        if (isRemoved(databases)) {
+            return;
+        }
+        _idleReaders.push_front(entry);
+        evict();
+    }
+
+    void ValhallaGraphReaderCache::evict() {
+        while (_idleReaders.size() > _maxIdleReaders) {
+            _idleReaders.pop_back();
+        }
+    }
+
+    bool ValhallaGraphReaderCache::isRemoved(const std::vector<std::shared_ptr<sqlite3pp::database> >& databases) const {
+        for (const std::weak_ptr<sqlite3pp::database>& removedDatabase : _removedDatabases) {
+            std::shared_ptr<sqlite3pp::database> database = removedDatabase.lock();
+            if (database && std::find(databases.begin(), databases.end(), database) != databases.end()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const std::size_t ValhallaGraphReaderCache::DEFAULT_CAPACITY = 32 * 1024 * 1024;
+    const std::size_t ValhallaGraphReaderCache::READER_SIZE_ESTIMATE = 8 * 1024 * 1024; // typical tile cache size of a reader after a few routes
+
+}
+
+#endif
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_VALHALLAGRAPHREADERCACHE_H_
+#define _CARTO_VALHALLAGRAPHREADERCACHE_H_
+
+#if defined(_CARTO_ROUTING_SUPPORT) && defined(_CARTO_VALHALLA_ROUTING_SUPPORT)
+
+#include "components/MemoryGovernor.h"
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sqlite3pp {
+    class database;
+}
+
+namespace valhalla {
+    namespace baldr {
+        class GraphReader;
+    }
+}
+
+namespace carto {
+
+    /**
+     * Process-wide cache of idle Valhalla graph readers, shared by all Valhalla routing services.
+     * Each reader keeps the graph tiles it has decoded, so reusing readers between requests and
+     * service instances avoids reading and decoding the same tiles again. A reader is used by a single request at a time,
+     * it is returned to the cache once all references to it are released.
+     * Readers are keyed by the identity of their database connections.
+     */
+    class ValhallaGraphReaderCache {
+    public:
+        static ValhallaGraphReaderCache& GetInstance();
+
+        virtual ~ValhallaGraphReaderCache();
+
+        std::size_t getCapacity() const;
+        void setCapacity(std::size_t capacityInBytes);
+
+        void clear();
+
+        // Returns an idle reader for the databases or creates a new one
+        std::shared_ptr<valhalla::baldr::GraphReader> acquireReader(const std::vector<std::shared_ptr<sqlite3pp::database> >& databases);
+
+        // Drops the idle readers using any of the databases (for example, of removed packages). Readers currently in use are not returned to the cache
+        void removeReaders(const std::vector<std::shared_ptr<sqlite3pp::database> >& databases);
+
+    private:
+        struct Entry {
+            std::vector<std::shared_ptr<sqlite3pp::database> > databases;
+            std::shared_ptr<valhalla::baldr::GraphReader> reader;
+        };
+
+        ValhallaGraphReaderCache();
+
+        void releaseReader(const std::vector<std::shared_ptr<sqlite3pp::database> >& databases, const std::shared_ptr<valhalla::baldr::GraphReader>& reader);
+        void evict();
+        bool isRemoved(const std::vector<std::shared_ptr<sqlite3pp::database> >& databases) const;
+
+        static const std::size_t DEFAULT_CAPACITY;
+        static const std::size_t READER_SIZE_ESTIMATE;
+
+        std::list<Entry> _idleReaders; // most recently used first
+        std::vector<std::weak_ptr<sqlite3pp::database> > _removedDatabases; // expire once the last reader using them is released
+        std::size_t _maxIdleReaders;
+        std::shared_ptr<MemoryGovernor::Consumer> _memoryConsumer;
+
+        mutable std::mutex _mutex;
+    };
+
+}
+
+#endif
+
+#endif
@@ -2,6 +2,7 @@
 
 #include "ValhallaOfflineRoutingService.h"
 #include "components/Exceptions.h"
+#include "projections/Projection.h"
 #include "routing/ValhallaRoutingProxy.h"
 #include "utils/Const.h"
 #include "utils/Log.h"
@@ -13,9 +14,12 @@
 namespace carto {
 
     ValhallaOfflineRoutingService::ValhallaOfflineRoutingService(const std::string& path) :
+        _path(path),
         _database(),
         _profile("pedestrian"),
         _configuration(ValhallaRoutingProxy::GetDefaultConfiguration()),
+        _configurationVersion(0),
+        _workerContextPool(),
         _mutex()
     {
         _database.reset(new sqlite3pp::database());
@@ -55,6 +59,8 @@ namespace carto {
         }
         *subValue = value.toPicoJSON();
         _configuration = Variant::FromPicoJSON(config);
+        _configurationVersion++;
+        _workerContextPool.clear();
     }
 
     std::string ValhallaOfflineRoutingService::getProfile() const {
@@ -72,8 +78,9 @@ namespace carto {
             throw NullArgumentException("Null request");
         }
 
-        std::lock_guard<std::mutex> lock(_mutex);
-        return ValhallaRoutingProxy::MatchRoute(std::vector<std::shared_ptr<sqlite3pp::database> > { _database }, _profile, _configuration, request);
+        std::string profile = getProfile();
+        std::shared_ptr<ValhallaRoutingProxy::WorkerContext> context = acquireWorkerContext();
+        return ValhallaRoutingProxy::MatchRoute(*context, profile, request);
     }
 
     std::shared_ptr<RoutingResult> ValhallaOfflineRoutingService::calculateRoute(const std::shared_ptr<RoutingRequest>& request) const {
@@ -81,10 +88,78 @@ namespace carto {
             throw NullArgumentException("Null request");
         }
 
+        std::string profile = getProfile();
+        std::shared_ptr<ValhallaRoutingProxy::WorkerContext> context = acquireWorkerContext();
+        return ValhallaRoutingProxy::CalculateRoute(*context, profile, request);
+    }
+
+    std::shared_ptr<RoutingMatrixResult> ValhallaOfflineRoutingService::calculateMatrix(const std::shared_ptr<RoutingMatrixRequest>& request) const {
+        if (!request) {
+            throw NullArgumentException("Null request");
+        }
+
+        std::string profile = getProfile();
+        std::shared_ptr<ValhallaRoutingProxy::WorkerContext> context = acquireWorkerContext();
+        return ValhallaRoutingProxy::CalculateMatrix(*context, profile, request);
+    }
+
+    void ValhallaOfflineRoutingService::warmupGraphTiles(const MapBounds& bounds, const std::shared_ptr<Projection>& projection) const {
+        if (!projection) {
+            throw NullArgumentException("Null projection");
+        }
+
+        MapBounds wgs84Bounds(projection->toWgs84(bounds.getMin()), projection->toWgs84(bounds.getMax()));
+        std::shared_ptr<ValhallaRoutingProxy::WorkerContext> context = acquireWorkerContext();
+        ValhallaRoutingProxy::WarmupGraphTiles(*context, wgs84Bounds);
+    }
+
+    std::shared_ptr<ValhallaRoutingProxy::WorkerContext> ValhallaOfflineRoutingService::acquireWorkerContext() const {
+        std::unique_ptr<ValhallaRoutingProxy::WorkerContext> context;
+        std::shared_ptr<sqlite3pp::database> database;
+        Variant configuration;
+        int configurationVersion = 0;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            configurationVersion = _configurationVersion;
+            if (!_workerContextPool.empty()) {
+                context = std::move(_workerContextPool.back());
+                _workerContextPool.pop_back();
+            } else {
+                configuration = _configuration;
+                // The first context uses the connection opened by the constructor, others open their own connections
+                std::swap(database, _database);
+            }
+        }
+
+        if (!context) {
+            if (!database) {
+                database = std::make_shared<sqlite3pp::database>();
+                if (database->connect_v2(_path.c_str(), SQLITE_OPEN_READONLY) != SQLITE_OK) {
+                    throw FileException("Failed to open routing database", _path);
+                }
+            }
+            context.reset(new ValhallaRoutingProxy::WorkerContext(std::vector<std::shared_ptr<sqlite3pp::database> > { database }, configuration));
+        }
+
+        ValhallaRoutingProxy::WorkerContext* contextPtr = context.release();
+        return std::shared_ptr<ValhallaRoutingProxy::WorkerContext>(contextPtr, [this, configurationVersion](ValhallaRoutingProxy::WorkerContext* context) {
+            releaseWorkerContext(context, configurationVersion);
+        });
+    }
+
+    void ValhallaOfflineRoutingService::releaseWorkerContext(ValhallaRoutingProxy::WorkerContext* context, int configurationVersion) const {
+        std::unique_ptr<ValhallaRoutingProxy::WorkerContext> contextPtr(context);
         std::lock_guard<std::mutex> lock(_mutex);
-        return ValhallaRoutingProxy::CalculateRoute(std::vector<std::shared_ptr<sqlite3pp::database> > { _database }, _profile, _configuration, request);
+        if (configurationVersion == _configurationVersion && _workerContextPool.size() < MAX_WORKER_CONTEXT_POOL_SIZE) {
+            _workerContextPool.push_back(std::move(contextPtr));
+        } else if (!_database && !contextPtr->getDatabases().empty()) {
+            // Keep the connection, the next context created for it gets the cached graph reader with its decoded tiles
+            _database = contextPtr->getDatabases().front();
+        }
     }
 
+    const std::size_t ValhallaOfflineRoutingService::MAX_WORKER_CONTEXT_POOL_SIZE = 4;
+
 }
 
 #endif
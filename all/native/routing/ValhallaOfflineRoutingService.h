@@ -9,12 +9,15 @@
 
 #if defined(_CARTO_ROUTING_SUPPORT) && defined(_CARTO_VALHALLA_ROUTING_SUPPORT) && defined(_CARTO_OFFLINE_SUPPORT)
 
+#include "core/MapBounds.h"
 #include "core/Variant.h"
 #include "routing/RoutingService.h"
+#include "routing/ValhallaRoutingProxy.h"
 
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 namespace sqlite3pp {
     class database;
@@ -24,6 +27,7 @@ namespace carto {
 
     /**
      * An offline routing service that uses Valhalla routing tiles.
+     * Multiple requests can be calculated concurrently, each concurrent request uses a separate database connection and graph reader.
      */
     class ValhallaOfflineRoutingService : public RoutingService {
     public:
@@ -55,10 +59,30 @@ namespace carto {
 
         virtual std::shared_ptr<RoutingResult> calculateRoute(const std::shared_ptr<RoutingRequest>& request) const;
 
+        virtual std::shared_ptr<RoutingMatrixResult> calculateMatrix(const std::shared_ptr<RoutingMatrixRequest>& request) const;
+
+        /**
+         * Loads the routing graph tiles covering the specified area into the graph tile cache,
+         * so that the following routing requests in the area do not need to read and decode them.
+         * The cache is shared by all Valhalla routing service instances.
+         * @param bounds The bounds of the area.
+         * @param projection The projection of the bounds.
+         * @throws std::runtime_error If the graph tiles could not be loaded.
+         */
+        void warmupGraphTiles(const MapBounds& bounds, const std::shared_ptr<Projection>& projection) const;
+
     private:
-        std::shared_ptr<sqlite3pp::database> _database;
+        std::shared_ptr<ValhallaRoutingProxy::WorkerContext> acquireWorkerContext() const;
+        void releaseWorkerContext(ValhallaRoutingProxy::WorkerContext* context, int configurationVersion) const;
+
+        static const std::size_t MAX_WORKER_CONTEXT_POOL_SIZE;
+
+        std::string _path;
+        mutable std::shared_ptr<sqlite3pp::database> _database;
         std::string _profile;
         Variant _configuration;
+        int _configurationVersion;
+        mutable std::vector<std::unique_ptr<ValhallaRoutingProxy::WorkerContext> > _workerContextPool;
         mutable std::mutex _mutex;
     };
     
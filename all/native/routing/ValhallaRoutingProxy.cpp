@@ -13,10 +13,15 @@
 #include "routing/RouteMatchingResult.h"
 #include "routing/RouteMatchingPoint.h"
 #include "routing/RouteMatchingEdge.h"
+#include "routing/RoutingMatrixRequest.h"
+#include "routing/RoutingMatrixResult.h"
+#include "routing/ValhallaGraphReaderCache.h"
 #include "network/HTTPClient.h"
+#include "network/ServiceResponseCache.h"
 #include "utils/NetworkUtils.h"
 #include "utils/Const.h"
 #include "utils/Log.h"
+#include "utils/JSONUtils.h"
 
 #include <ctime>
 #include <vector>
@@ -49,7 +54,10 @@
 #include <valhalla/midgard/constants.h>
 #include <valhalla/midgard/encoded.h>
 #include <valhalla/midgard/pointll.h>
+#include <valhalla/midgard/aabb2.h>
 #include <valhalla/baldr/json.h>
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/baldr/tilehierarchy.h>
 #include <valhalla/baldr/pathlocation.h>
 #include <valhalla/baldr/directededge.h>
 #include <valhalla/baldr/datetime.h>
@@ -192,54 +200,129 @@ namespace carto {
     }
 
 #ifdef _CARTO_VALHALLA_ROUTING_SUPPORT
-    std::shared_ptr<RouteMatchingResult> ValhallaRoutingProxy::MatchRoute(const std::vector<std::shared_ptr<sqlite3pp::database> >& databases, const std::string& profile, const Variant& config, const std::shared_ptr<RouteMatchingRequest>& request) {
-        std::string resultString;
+    struct ValhallaRoutingProxy::WorkerContext::Workers {
+        std::vector<std::shared_ptr<sqlite3pp::database> > databases;
+        boost::property_tree::ptree configTree;
+        std::shared_ptr<valhalla::baldr::GraphReader> reader;
+        std::unique_ptr<valhalla::loki::loki_worker_t> lokiWorker;
+        std::unique_ptr<valhalla::thor::thor_worker_t> thorWorker;
+        std::unique_ptr<valhalla::odin::odin_worker_t> odinWorker;
+
+        void cleanup() {
+            lokiWorker->cleanup();
+            thorWorker->cleanup();
+            odinWorker->cleanup();
+        }
+    };
+
+    ValhallaRoutingProxy::WorkerContext::WorkerContext(const std::vector<std::shared_ptr<sqlite3pp::database> >& databases, const Variant& config) :
+        _workers(new Workers())
+    {
         try {
             std::stringstream ss;
             ss << config.toPicoJSON().serialize();
-            boost::property_tree::ptree configTree;
-            rapidjson::read_json(ss, configTree);
-            auto reader = std::make_shared<valhalla::baldr::GraphReader>(databases);
+            rapidjson::read_json(ss, _workers->configTree);
+            _workers->databases = databases;
+            _workers->reader = ValhallaGraphReaderCache::GetInstance().acquireReader(databases);
+            _workers->lokiWorker.reset(new valhalla::loki::loki_worker_t(_workers->configTree, _workers->reader));
+            _workers->thorWorker.reset(new valhalla::thor::thor_worker_t(_workers->configTree, _workers->reader));
+            _workers->odinWorker.reset(new valhalla::odin::odin_worker_t(_workers->configTree));
+        }
+        catch (const std::exception& ex) {
+            throw GenericException("Exception while initializing routing workers", ex.what());
+        }
+    }
+
+    ValhallaRoutingProxy::WorkerContext::~WorkerContext() {
+    }
+
+    const std::vector<std::shared_ptr<sqlite3pp::database> >& ValhallaRoutingProxy::WorkerContext::getDatabases() const {
+        return _workers->databases;
+    }
+
+    std::shared_ptr<RouteMatchingResult> ValhallaRoutingProxy::MatchRoute(const std::vector<std::shared_ptr<sqlite3pp::database> >& databases, const std::string& profile, const Variant& config, const std::shared_ptr<RouteMatchingRequest>& request) {
+        WorkerContext context(databases, config);
+        return MatchRoute(context, profile, request);
+    }
+
+    std::shared_ptr<RoutingResult> ValhallaRoutingProxy::CalculateRoute(const std::vector<std::shared_ptr<sqlite3pp::database> >& databases, const std::string& profile, const Variant& config, const std::shared_ptr<RoutingRequest>& request) {
+        WorkerContext context(databases, config);
+        return CalculateRoute(context, profile, request);
+    }
 
+    std::shared_ptr<RouteMatchingResult> ValhallaRoutingProxy::MatchRoute(WorkerContext& context, const std::string& profile, const std::shared_ptr<RouteMatchingRequest>& request) {
+        WorkerContext::Workers& workers = *context._workers;
+        std::string resultString;
+        try {
             valhalla::Api api;
             valhalla::ParseApi(SerializeRouteMatchingRequest(profile, request), valhalla::Options::trace_attributes, api);
 
-            valhalla::loki::loki_worker_t lokiworker(configTree, reader);
-            lokiworker.trace(api);
-            valhalla::thor::thor_worker_t thorworker(configTree, reader);
-            resultString = thorworker.trace_attributes(api);
+            workers.lokiWorker->trace(api);
+            resultString = workers.thorWorker->trace_attributes(api);
+            workers.cleanup();
         }
         catch (const std::exception& ex) {
+            workers.cleanup();
             throw GenericException("Exception while matching route", ex.what());
         }
         return ParseRouteMatchingResult(request->getProjection(), resultString);
     }
 
-    std::shared_ptr<RoutingResult> ValhallaRoutingProxy::CalculateRoute(const std::vector<std::shared_ptr<sqlite3pp::database> >& databases, const std::string& profile, const Variant& config, const std::shared_ptr<RoutingRequest>& request) {
+    std::shared_ptr<RoutingResult> ValhallaRoutingProxy::CalculateRoute(WorkerContext& context, const std::string& profile, const std::shared_ptr<RoutingRequest>& request) {
+        WorkerContext::Workers& workers = *context._workers;
         std::string resultString;
         try {
-            std::stringstream ss;
-            ss << config.toPicoJSON().serialize();
-            boost::property_tree::ptree configTree;
-            rapidjson::read_json(ss, configTree);
-            auto reader = std::make_shared<valhalla::baldr::GraphReader>(databases);
-
             valhalla::Api api;
             valhalla::ParseApi(SerializeRoutingRequest(profile, request), valhalla::Options::route, api);
 
-            valhalla::loki::loki_worker_t lokiworker(configTree, reader);
-            lokiworker.route(api);
-            valhalla::thor::thor_worker_t thorworker(configTree, reader);
-            thorworker.route(api);
-            valhalla::odin::odin_worker_t odinworker(configTree);
-            odinworker.narrate(api);
+            workers.lokiWorker->route(api);
+            workers.thorWorker->route(api);
+            workers.odinWorker->narrate(api);
             resultString = valhalla::tyr::serializeDirections(api);
+            workers.cleanup();
         }
         catch (const std::exception& ex) {
+            workers.cleanup();
             throw GenericException("Exception while calculating route", ex.what());
         }
         return ParseRoutingResult(request->getProjection(), resultString);
     }
+
+    std::shared_ptr<RoutingMatrixResult> ValhallaRoutingProxy::CalculateMatrix(WorkerContext& context, const std::string& profile, const std::shared_ptr<RoutingMatrixRequest>& request) {
+        WorkerContext::Workers& workers = *context._workers;
+        std::string resultString;
+        try {
+            valhalla::Api api;
+            valhalla::ParseApi(SerializeRoutingMatrixRequest(profile, request), valhalla::Options::sources_to_targets, api);
+
+            workers.lokiWorker->matrix(api);
+            resultString = workers.thorWorker->matrix(api);
+            workers.cleanup();
+        }
+        catch (const std::exception& ex) {
+            workers.cleanup();
+            throw GenericException("Exception while calculating matrix", ex.what());
+        }
+        return ParseRoutingMatrixResult(request->getProjection(), static_cast<int>(request->getSourcePoints().size()), static_cast<int>(request->getTargetPoints().size()), resultString);
+    }
+
+    void ValhallaRoutingProxy::WarmupGraphTiles(WorkerContext& context, const MapBounds& wgs84Bounds) {
+        WorkerContext::Workers& workers = *context._workers;
+        try {
+            valhalla::midgard::AABB2<valhalla::midgard::PointLL> bbox(
+                valhalla::midgard::PointLL(wgs84Bounds.getMin().getX(), wgs84Bounds.getMin().getY()),
+                valhalla::midgard::PointLL(wgs84Bounds.getMax().getX(), wgs84Bounds.getMax().getY())
+            );
+            for (const valhalla::baldr::TileLevel& level : valhalla::baldr::TileHierarchy::levels()) {
+                for (int tileId : level.tiles.TileList(bbox)) {
+                    workers.reader->GetGraphTile(valhalla::baldr::GraphId(tileId, level.level, 0));
+                }
+            }
+        }
+        catch (const std::exception& ex) {
+            throw GenericException("Exception while loading graph tiles", ex.what());
+        }
+    }
 #endif
 
     Variant ValhallaRoutingProxy::GetDefaultConfiguration() {
@@ -443,9 +526,37 @@ namespace carto {
         return picojson::value(json).serialize();
     }
 
+    std::string ValhallaRoutingProxy::SerializeRoutingMatrixRequest(const std::string& profile, const std::shared_ptr<RoutingMatrixRequest>& request) {
+        std::shared_ptr<Projection> proj = request->getProjection();
+
+        auto serializeLocations = [&proj](const std::vector<MapPos>& points) {
+            picojson::array locations;
+            for (const MapPos& point : points) {
+                MapPos posWgs84 = proj->toWgs84(point);
+                picojson::object location;
+                location["lon"] = picojson::value(posWgs84.getX());
+                location["lat"] = picojson::value(posWgs84.getY());
+                locations.emplace_back(location);
+            }
+            return locations;
+        };
+
+        picojson::value customParams = request->getCustomParameters().toPicoJSON();
+
+        picojson::object json;
+        if (customParams.is<picojson::object>()) {
+            json = customParams.get<picojson::object>();
+        }
+        json["sources"] = picojson::value(serializeLocations(request->getSourcePoints()));
+        json["targets"] = picojson::value(serializeLocations(request->getTargetPoints()));
+        json["costing"] = picojson::value(profile);
+        json["units"] = picojson::value("kilometers");
+        return picojson::value(json).serialize();
+    }
+
     std::shared_ptr<RouteMatchingResult> ValhallaRoutingProxy::ParseRouteMatchingResult(const std::shared_ptr<Projection>& proj, const std::string& resultString) {
         picojson::value result;
-        std::string err = picojson::parse(result, resultString);
+        std::string err = JSONUtils::ParsePicoJSON(result, resultString);
         if (!err.empty()) {
             throw GenericException("Failed to parse result", err);
         }
@@ -494,7 +605,7 @@ namespace carto {
 
     std::shared_ptr<RoutingResult> ValhallaRoutingProxy::ParseRoutingResult(const std::shared_ptr<Projection>& proj, const std::string& resultString) {
         picojson::value result;
-        std::string err = picojson::parse(result, resultString);
+        std::string err = JSONUtils::ParsePicoJSON(result, resultString);
         if (!err.empty()) {
             throw GenericException("Failed to parse result", err);
         }
@@ -556,12 +667,48 @@ namespace carto {
         return std::make_shared<RoutingResult>(proj, points, instructions);
     }
 
+    std::shared_ptr<RoutingMatrixResult> ValhallaRoutingProxy::ParseRoutingMatrixResult(const std::shared_ptr<Projection>& proj, int sourceCount, int targetCount, const std::string& resultString) {
+        picojson::value result;
+        std::string err = JSONUtils::ParsePicoJSON(result, resultString);
+        if (!err.empty()) {
+            throw GenericException("Failed to parse result", err);
+        }
+        if (!result.get("sources_to_targets").is<picojson::array>()) {
+            throw GenericException("No sources_to_targets info in the result");
+        }
+
+        // Unreachable pairs have null time and distance
+        std::vector<double> times(static_cast<std::size_t>(sourceCount) * targetCount, -1);
+        std::vector<double> distances(static_cast<std::size_t>(sourceCount) * targetCount, -1);
+        try {
+            for (const picojson::value& row : result.get("sources_to_targets").get<picojson::array>()) {
+                for (const picojson::value& cell : row.get<picojson::array>()) {
+                    int sourceIndex = static_cast<int>(cell.get("from_index").get<std::int64_t>());
+                    int targetIndex = static_cast<int>(cell.get("to_index").get<std::int64_t>());
+                    if (sourceIndex < 0 || sourceIndex >= sourceCount || targetIndex < 0 || targetIndex >= targetCount) {
+                        continue;
+                    }
+                    std::size_t index = static_cast<std::size_t>(sourceIndex) * targetCount + targetIndex;
+                    if (cell.get("time").is<double>()) {
+                        times[index] = cell.get("time").get<double>();
+                    }
+                    if (cell.get("distance").is<double>()) {
+                        distances[index] = cell.get("distance").get<double>() * 1000.0;
+                    }
+                }
+            }
+        }
+        catch (const std::exception& ex) {
+            throw GenericException("Exception while translating matrix", ex.what());
+        }
+        return std::make_shared<RoutingMatrixResult>(proj, sourceCount, targetCount, times, distances);
+    }
+
     std::string ValhallaRoutingProxy::MakeHTTPRequest(HTTPClient& httpClient, const std::string& url) {
         std::map<std::string, std::string> requestHeaders;
         requestHeaders["Connection"] = "close";
-        std::map<std::string, std::string> responseHeaders;
         std::shared_ptr<BinaryData> responseData;
-        int code = httpClient.get(url, requestHeaders, responseHeaders, responseData);
+        int code = ServiceResponseCache::GetInstance().get(httpClient, url, requestHeaders, responseData, std::shared_ptr<ServiceResponseCache::Session>());
         std::string responseString;
         if (responseData) {
             const char* responseDataPtr = reinterpret_cast<const char*>(responseData->data());
@@ -575,7 +722,7 @@ namespace carto {
             Log::Debugf("ValhallaRoutingProxy::MakeHTTPRequest: Failed response %s", responseString.c_str());
 
             picojson::value result;
-            std::string err = picojson::parse(result, responseString);
+            std::string err = JSONUtils::ParsePicoJSON(result, responseString);
             if (!err.empty()) {
                 throw GenericException("Failed to parse routing/matching result", err);
             }
@@ -9,6 +9,7 @@
 
 #ifdef _CARTO_ROUTING_SUPPORT
 
+#include "core/MapBounds.h"
 #include "core/Variant.h"
 #include "routing/RoutingInstruction.h"
 
@@ -27,6 +28,8 @@ namespace carto {
     class RoutingResult;
     class RouteMatchingRequest;
     class RouteMatchingResult;
+    class RoutingMatrixRequest;
+    class RoutingMatrixResult;
     
     class ValhallaRoutingProxy {
     public:
@@ -34,8 +37,31 @@ namespace carto {
         static std::shared_ptr<RoutingResult> CalculateRoute(HTTPClient& httpClient, const std::string& baseURL, const std::string& profile, const std::shared_ptr<RoutingRequest>& request);
 
 #ifdef _CARTO_VALHALLA_ROUTING_SUPPORT
+        // Graph reader and Valhalla workers built for a fixed set of databases and configuration, reusable for sequential requests
+        class WorkerContext {
+        public:
+            WorkerContext(const std::vector<std::shared_ptr<sqlite3pp::database> >& databases, const Variant& config);
+            ~WorkerContext();
+
+            const std::vector<std::shared_ptr<sqlite3pp::database> >& getDatabases() const;
+
+        private:
+            friend class ValhallaRoutingProxy;
+
+            struct Workers;
+
+            std::unique_ptr<Workers> _workers;
+        };
+
         static std::shared_ptr<RouteMatchingResult> MatchRoute(const std::vector<std::shared_ptr<sqlite3pp::database> >& databases, const std::string& profile, const Variant& config, const std::shared_ptr<RouteMatchingRequest>& request);
         static std::shared_ptr<RoutingResult> CalculateRoute(const std::vector<std::shared_ptr<sqlite3pp::database> >& databases, const std::string& profile, const Variant& config, const std::shared_ptr<RoutingRequest>& request);
+
+        static std::shared_ptr<RouteMatchingResult> MatchRoute(WorkerContext& context, const std::string& profile, const std::shared_ptr<RouteMatchingRequest>& request);
+        static std::shared_ptr<RoutingResult> CalculateRoute(WorkerContext& context, const std::string& profile, const std::shared_ptr<RoutingRequest>& request);
+        static std::shared_ptr<RoutingMatrixResult> CalculateMatrix(WorkerContext& context, const std::string& profile, const std::shared_ptr<RoutingMatrixRequest>& request);
+
+        // Loads the graph tiles of all hierarchy levels covering the bounds into the graph reader of the context
+        static void WarmupGraphTiles(WorkerContext& context, const MapBounds& wgs84Bounds);
 #endif
 
         static Variant GetDefaultConfiguration();
@@ -53,10 +79,14 @@ namespace carto {
 
         static std::string SerializeRoutingRequest(const std::string& profile, const std::shared_ptr<RoutingRequest>& request);
 
+        static std::string SerializeRoutingMatrixRequest(const std::string& profile, const std::shared_ptr<RoutingMatrixRequest>& request);
+
         static std::shared_ptr<RouteMatchingResult> ParseRouteMatchingResult(const std::shared_ptr<Projection>& proj, const std::string& resultString);
 
         static std::shared_ptr<RoutingResult> ParseRoutingResult(const std::shared_ptr<Projection>& proj, const std::string& resultString);
 
+        static std::shared_ptr<RoutingMatrixResult> ParseRoutingMatrixResult(const std::shared_ptr<Projection>& proj, int sourceCount, int targetCount, const std::string& resultString);
+
         static std::string MakeHTTPRequest(HTTPClient& httpClient, const std::string& url);
     };
 
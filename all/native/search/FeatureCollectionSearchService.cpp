@@ -5,18 +5,22 @@
 #include "geometry/Geometry.h"
 #include "geometry/Feature.h"
 #include "geometry/FeatureCollection.h"
+#include "geometry/utils/PackedRTreeSpatialIndex.h"
 #include "search/SearchProxy.h"
 #include "projections/Projection.h"
 #include "projections/EPSG3857.h"
 #include "utils/Log.h"
 
+#include <algorithm>
+
 namespace carto {
 
     FeatureCollectionSearchService::FeatureCollectionSearchService(const std::shared_ptr<Projection>& projection, const std::shared_ptr<FeatureCollection>& featureCollection) :
         _projection(projection),
         _featureCollection(featureCollection),
         _maxResults(1000),
-        _mutex()
+        _mutex(),
+        _spatialIndex()
     {
         if (!projection) {
             throw NullArgumentException("Null projection");
@@ -60,7 +64,7 @@ namespace carto {
         }
 
         std::vector<std::shared_ptr<Feature> > features;
-        for (int i = 0; i < _featureCollection->getFeatureCount(); i++) {
+        for (int i : findCandidateFeatures(proxy)) {
             if (static_cast<int>(features.size()) >= maxResults) {
                 break;
             }
@@ -74,6 +78,39 @@ namespace carto {
         return std::make_shared<FeatureCollection>(features);
     }
 
+    std::vector<int> FeatureCollectionSearchService::findCandidateFeatures(const SearchProxy& proxy) const {
+        if (!proxy.hasSearchGeometry()) {
+            std::vector<int> indices(_featureCollection->getFeatureCount());
+            for (int i = 0; i < static_cast<int>(indices.size()); i++) {
+                indices[i] = i;
+            }
+            return indices;
+        }
+
+        std::shared_ptr<SpatialIndex<int> > spatialIndex;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_spatialIndex) {
+                // The feature collection is immutable, so the index can be built once and reused by all requests
+                std::vector<std::pair<cglib::bbox3<double>, int> > records;
+                records.reserve(_featureCollection->getFeatureCount());
+                for (int i = 0; i < _featureCollection->getFeatureCount(); i++) {
+                    if (const std::shared_ptr<Geometry>& geometry = _featureCollection->getFeature(i)->getGeometry()) {
+                        MapBounds bounds = SearchProxy::CalculateEPSG3857Bounds(geometry->getBounds(), _projection);
+                        records.emplace_back(cglib::bbox3<double>(cglib::vec3<double>(bounds.getMin().getX(), bounds.getMin().getY(), 0), cglib::vec3<double>(bounds.getMax().getX(), bounds.getMax().getY(), 0)), i);
+                    }
+                }
+                _spatialIndex = std::make_shared<PackedRTreeSpatialIndex<int> >(records);
+            }
+            spatialIndex = _spatialIndex;
+        }
+
+        const MapBounds& searchBounds = proxy.getSearchGeometryBounds();
+        std::vector<int> indices = spatialIndex->query(cglib::bbox3<double>(cglib::vec3<double>(searchBounds.getMin().getX(), searchBounds.getMin().getY(), 0), cglib::vec3<double>(searchBounds.getMax().getX(), searchBounds.getMax().getY(), 0)));
+        std::sort(indices.begin(), indices.end());
+        return indices;
+    }
+
 }
 
 #endif
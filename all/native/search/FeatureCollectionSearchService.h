@@ -9,6 +9,7 @@
 
 #ifdef _CARTO_SEARCH_SUPPORT
 
+#include "geometry/utils/SpatialIndex.h"
 #include "search/SearchRequest.h"
 
 #include <memory>
@@ -18,6 +19,7 @@
 namespace carto {
     class FeatureCollection;
     class Projection;
+    class SearchProxy;
 
     /**
      * A search service for finding features from a specified feature collection.
@@ -58,6 +60,7 @@ namespace carto {
 
         /**
          * Searches for the features specified by search request from the feature collection bound to the service.
+         * If the request contains a geometry, candidate features are found using a spatial index that is built on the first such request.
          * @param request The search request containing search filters.
          * @return The resulting feature collection containing features matching the request.
          */
@@ -70,6 +73,11 @@ namespace carto {
         int _maxResults;
 
         mutable std::mutex _mutex;
+
+    private:
+        std::vector<int> findCandidateFeatures(const SearchProxy& proxy) const;
+
+        mutable std::shared_ptr<SpatialIndex<int> > _spatialIndex;
     };
     
 }
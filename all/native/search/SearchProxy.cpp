@@ -28,6 +28,7 @@
 
 #include <limits>
 #include <algorithm>
+#include <functional>
 #include <numeric>
 
 namespace {
@@ -166,7 +167,7 @@ namespace {
 
     class SearchQueryContext : public carto::QueryContext {
     public:
-        explicit SearchQueryContext(const std::shared_ptr<carto::Geometry>& geometry, const std::shared_ptr<carto::Projection>& proj, const std::string* layerName, const carto::Variant& var) : _geometry(geometry), _projection(proj), _layerName(layerName), _variant(var) { }
+        explicit SearchQueryContext(const std::function<std::shared_ptr<carto::Geometry>()>& geometryFunc, const std::shared_ptr<carto::Projection>& proj, const std::string* layerName, const carto::Variant& var) : _geometryFunc(geometryFunc), _projection(proj), _layerName(layerName), _variant(var) { }
         virtual ~SearchQueryContext() { }
 
         virtual bool getVariable(const std::string& name, carto::Variant& value) const {
@@ -176,22 +177,18 @@ namespace {
             }
 
             if (name == "geometry::type") {
-                value = carto::Variant(GetGeometryType(_geometry));
+                value = carto::Variant(GetGeometryType(_geometryFunc()));
                 return true;
             }
 
             if (name == "geometry::vertices") {
-                value = carto::Variant(static_cast<long long>(GetGeometryVerticesCount(_geometry)));
+                value = carto::Variant(static_cast<long long>(GetGeometryVerticesCount(_geometryFunc())));
                 return true;
             }
 
             switch (_variant.getType()) {
             case carto::VariantType::VARIANT_TYPE_OBJECT:
-                if (_variant.containsObjectKey(name)) {
-                    value = _variant.getObjectElement(name);
-                    return true;
-                }
-                return false;
+                return _variant.findObjectElement(name, value);
             case carto::VariantType::VARIANT_TYPE_ARRAY:
                 return false;
             default:
@@ -242,7 +239,7 @@ namespace {
             return 0;
         }
 
-        const std::shared_ptr<carto::Geometry>& _geometry;
+        const std::function<std::shared_ptr<carto::Geometry>()>& _geometryFunc;
         const std::shared_ptr<carto::Projection>& _projection;
         const std::string* _layerName;
         const carto::Variant& _variant;
@@ -256,6 +253,7 @@ namespace carto {
         _request(request),
         _geometry(),
         _searchBounds(),
+        _elementBounds(),
         _searchRadius(0),
         _projection(proj),
         _expr(),
@@ -297,6 +295,7 @@ namespace carto {
             _searchRadius = request->getSearchRadius() / std::cos(std::min(89.9, std::abs(wgs84CenterPos.getY())) * Const::DEG_TO_RAD);
             MapPos boundsPos0 = geometryBounds.getMin() - MapVec(_searchRadius, _searchRadius);
             MapPos boundsPos1 = geometryBounds.getMax() + MapVec(_searchRadius, _searchRadius);
+            _elementBounds = MapBounds(boundsPos0, boundsPos1);
             boundsPos0[0] = std::max(boundsPos0[0], EPSG3857().getBounds().getMin()[0] * 0.9999);
             boundsPos1[0] = std::min(boundsPos1[0], EPSG3857().getBounds().getMax()[0] * 0.9999);
             _searchBounds = MapBounds(boundsPos0, boundsPos1);
@@ -309,6 +308,14 @@ namespace carto {
         return _searchBounds;
     }
 
+    bool SearchProxy::hasSearchGeometry() const {
+        return static_cast<bool>(_geometry);
+    }
+
+    const MapBounds& SearchProxy::getSearchGeometryBounds() const {
+        return _elementBounds;
+    }
+
     bool SearchProxy::testBounds(const MapBounds& bounds) const {
         if (_geometry) {
             std::vector<MapPos> points(4);
@@ -327,20 +334,64 @@ namespace carto {
     }
 
     bool SearchProxy::testElement(const std::shared_ptr<Geometry>& geometry, const std::string* layerName, const Variant& var) const {
+        // Cheap bounding box rejection before evaluating filters and the exact distance
+        if (_geometry && !testGeometryBounds(geometry)) {
+            return false;
+        }
+
+        if (_re) {
+            if (!matchRegexFilter(var, *_re)) {
+                return false;
+            }
+        }
+
+        if (_expr) {
+            std::function<std::shared_ptr<Geometry>()> geometryFunc = [&geometry]() { return geometry; };
+            SearchQueryContext context(geometryFunc, _projection, layerName, var);
+            if (!_expr->evaluate(context)) {
+                return false;
+            }
+        }
+
+        if (_geometry) {
+            if (calculateDistance(convertToEPSG3857(geometry, _projection), _geometry) > _searchRadius) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool SearchProxy::testElement(const std::function<std::shared_ptr<Geometry>()>& geometryFunc, const std::string* layerName, const Variant& var) const {
         if (_re) {
             if (!matchRegexFilter(var, *_re)) {
                 return false;
             }
         }
 
+        // The geometry is requested only if the filter expression refers to it or the search has a geometry
+        std::shared_ptr<Geometry> geometry;
+        bool geometryRequested = false;
+        std::function<std::shared_ptr<Geometry>()> lazyGeometryFunc = [&]() {
+            if (!geometryRequested) {
+                geometry = geometryFunc();
+                geometryRequested = true;
+            }
+            return geometry;
+        };
+
         if (_expr) {
-            SearchQueryContext context(geometry, _projection, layerName, var);
+            SearchQueryContext context(lazyGeometryFunc, _projection, layerName, var);
             if (!_expr->evaluate(context)) {
                 return false;
             }
         }
 
         if (_geometry) {
+            lazyGeometryFunc();
+            if (!testGeometryBounds(geometry)) {
+                return false;
+            }
             if (calculateDistance(convertToEPSG3857(geometry, _projection), _geometry) > _searchRadius) {
                 return false;
             }
@@ -349,6 +400,21 @@ namespace carto {
         return true;
     }
 
+    bool SearchProxy::testGeometryBounds(const std::shared_ptr<Geometry>& geometry) const {
+        if (geometry) {
+            MapBounds bounds = convertToEPSG3857(geometry->getBounds(), _projection);
+            if (bounds.getMax().getX() < _elementBounds.getMin().getX() || bounds.getMin().getX() > _elementBounds.getMax().getX() ||
+                bounds.getMax().getY() < _elementBounds.getMin().getY() || bounds.getMin().getY() > _elementBounds.getMax().getY()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    MapBounds SearchProxy::CalculateEPSG3857Bounds(const MapBounds& bounds, const std::shared_ptr<Projection>& proj) {
+        return convertToEPSG3857(bounds, proj);
+    }
+
 }
 
 #endif
@@ -12,6 +12,7 @@
 #include "core/MapBounds.h"
 #include "search/SearchRequest.h"
 
+#include <functional>
 #include <memory>
 #include <vector>
 #include <regex>
@@ -30,14 +31,26 @@ namespace carto {
 
         const MapBounds& getSearchBounds() const;
 
+        bool hasSearchGeometry() const;
+
+        const MapBounds& getSearchGeometryBounds() const;
+
         bool testBounds(const MapBounds& bounds) const;
 
         bool testElement(const std::shared_ptr<Geometry>& geometry, const std::string* layerName, const Variant& var) const;
 
+        // Tests the properties first and requests the geometry only when needed, so that rejected elements do not have to be decoded
+        bool testElement(const std::function<std::shared_ptr<Geometry>()>& geometryFunc, const std::string* layerName, const Variant& var) const;
+
+        static MapBounds CalculateEPSG3857Bounds(const MapBounds& bounds, const std::shared_ptr<Projection>& proj);
+
     protected:
+        bool testGeometryBounds(const std::shared_ptr<Geometry>& geometry) const;
+
         std::shared_ptr<SearchRequest> _request;
         std::shared_ptr<Geometry> _geometry;
         MapBounds _searchBounds;
+        MapBounds _elementBounds;
         double _searchRadius;
         std::shared_ptr<Projection> _projection;
         std::shared_ptr<QueryExpression> _expr;
@@ -7,17 +7,22 @@
 #include "graphics/ViewState.h"
 #include "renderers/components/CullState.h"
 #include "geometry/Geometry.h"
+#include "geometry/utils/PackedRTreeSpatialIndex.h"
 #include "search/SearchProxy.h"
 #include "projections/Projection.h"
 #include "vectorelements/VectorElement.h"
 #include "utils/Log.h"
 
+#include <algorithm>
+
 namespace carto {
 
     VectorElementSearchService::VectorElementSearchService(const std::shared_ptr<VectorDataSource>& dataSource) :
         _dataSource(dataSource),
         _maxResults(1000),
-        _mutex()
+        _mutex(),
+        _indexedElements(),
+        _spatialIndex()
     {
         if (!dataSource) {
             throw NullArgumentException("Null dataSource");
@@ -57,7 +62,7 @@ namespace carto {
 
         std::vector<std::shared_ptr<VectorElement> > elements;
         if (std::shared_ptr<VectorData> vectorData = _dataSource->loadElements(cullState)) {
-            for (std::size_t i = 0; i < vectorData->getElements().size(); i++) {
+            for (int i : findCandidateElements(proxy, vectorData->getElements())) {
                 if (static_cast<int>(elements.size()) >= maxResults) {
                     break;
                 }
@@ -72,6 +77,50 @@ namespace carto {
         return elements;
     }
 
+    std::vector<int> VectorElementSearchService::findCandidateElements(const SearchProxy& proxy, const std::vector<std::shared_ptr<VectorElement> >& elements) const {
+        std::vector<int> indices(elements.size());
+        for (int i = 0; i < static_cast<int>(indices.size()); i++) {
+            indices[i] = i;
+        }
+        if (!proxy.hasSearchGeometry()) {
+            return indices;
+        }
+
+        std::vector<std::pair<std::shared_ptr<VectorElement>, std::shared_ptr<Geometry> > > indexedElements;
+        indexedElements.reserve(elements.size());
+        for (const std::shared_ptr<VectorElement>& element : elements) {
+            indexedElements.emplace_back(element, element->getGeometry());
+        }
+
+        std::shared_ptr<SpatialIndex<int> > spatialIndex;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (indexedElements != _indexedElements) {
+                // Elements have changed since the last request, index them only when the same elements are searched again
+                _indexedElements = std::move(indexedElements);
+                _spatialIndex.reset();
+                return indices;
+            }
+            if (!_spatialIndex) {
+                std::vector<std::pair<cglib::bbox3<double>, int> > records;
+                records.reserve(_indexedElements.size());
+                for (int i = 0; i < static_cast<int>(_indexedElements.size()); i++) {
+                    if (const std::shared_ptr<Geometry>& geometry = _indexedElements[i].second) {
+                        MapBounds bounds = SearchProxy::CalculateEPSG3857Bounds(geometry->getBounds(), _dataSource->getProjection());
+                        records.emplace_back(cglib::bbox3<double>(cglib::vec3<double>(bounds.getMin().getX(), bounds.getMin().getY(), 0), cglib::vec3<double>(bounds.getMax().getX(), bounds.getMax().getY(), 0)), i);
+                    }
+                }
+                _spatialIndex = std::make_shared<PackedRTreeSpatialIndex<int> >(records);
+            }
+            spatialIndex = _spatialIndex;
+        }
+
+        const MapBounds& searchBounds = proxy.getSearchGeometryBounds();
+        indices = spatialIndex->query(cglib::bbox3<double>(cglib::vec3<double>(searchBounds.getMin().getX(), searchBounds.getMin().getY(), 0), cglib::vec3<double>(searchBounds.getMax().getX(), searchBounds.getMax().getY(), 0)));
+        std::sort(indices.begin(), indices.end());
+        return indices;
+    }
+
 }
 
 #endif
@@ -9,6 +9,7 @@
 
 #ifdef _CARTO_SEARCH_SUPPORT
 
+#include "geometry/utils/SpatialIndex.h"
 #include "search/SearchRequest.h"
 
 #include <memory>
@@ -16,7 +17,9 @@
 #include <vector>
 
 namespace carto {
+    class Geometry;
     class Projection;
+    class SearchProxy;
     class VectorElement;
     class VectorDataSource;
 
@@ -52,6 +55,7 @@ namespace carto {
 
         /**
          * Searches for the vector elements specified by search request from the data source bound to the service.
+         * If the request contains a geometry and the same elements are searched repeatedly, candidate elements are found using a cached spatial index.
          * @param request The search request containing search filters.
          * @return The resulting list of vector elements matching the request.
          */
@@ -63,6 +67,12 @@ namespace carto {
         int _maxResults;
 
         mutable std::mutex _mutex;
+
+    private:
+        std::vector<int> findCandidateElements(const SearchProxy& proxy, const std::vector<std::shared_ptr<VectorElement> >& elements) const;
+
+        mutable std::vector<std::pair<std::shared_ptr<VectorElement>, std::shared_ptr<Geometry> > > _indexedElements;
+        mutable std::shared_ptr<SpatialIndex<int> > _spatialIndex;
     };
     
 }
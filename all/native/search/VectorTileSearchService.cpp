@@ -12,6 +12,10 @@
 #include "utils/TileUtils.h"
 #include "utils/Log.h"
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 #include <vt/TileId.h>
 
 namespace carto {
@@ -93,46 +97,81 @@ namespace carto {
             maxResults = _maxResults;
         }
 
-        std::vector<std::shared_ptr<VectorTileFeature> > features;
-
-        auto testTile = [&](const MapTile& mapTile, const MapBounds& tileBounds) {
-            if (std::shared_ptr<TileData> tileData = _dataSource->loadTile(mapTile.getFlipped())) {
-                if (std::shared_ptr<VectorTileFeatureCollection> featureCollection = _tileDecoder->decodeFeatures(vt::TileId(mapTile.getZoom(), mapTile.getX(), mapTile.getY()), tileData->getData(), tileBounds)) {
-                    for (int i = 0; i < featureCollection->getFeatureCount(); i++) {
-                        if (static_cast<int>(features.size()) >= maxResults) {
-                            break;
-                        }
-
-                        const std::shared_ptr<VectorTileFeature>& feature = featureCollection->getFeature(i);
-
-                        if (proxy.testElement(feature->getGeometry(), &feature->getLayerName(), feature->getProperties())) {
-                            features.push_back(feature);
-                        }
-                    }
-                }
-            }        
-        };
-
+        // Collect candidate tiles first, so that tiles can be processed in parallel while keeping the result order stable
+        std::vector<std::pair<MapTile, MapBounds> > tiles;
         for (int zoom = minZoom; zoom <= maxZoom; zoom++) {
             MapTile mapTile1 = TileUtils::CalculateMapTile(searchBounds.getMin(), zoom, _dataSource->getProjection());
             MapTile mapTile2 = TileUtils::CalculateMapTile(searchBounds.getMax(), zoom, _dataSource->getProjection());
             for (int y = std::min(mapTile1.getY(), mapTile2.getY()); y <= std::max(mapTile1.getY(), mapTile2.getY()); y++) {
                 for (int x = std::min(mapTile1.getX(), mapTile2.getX()); x <= std::max(mapTile1.getX(), mapTile2.getX()); x++) {
-                    if (static_cast<int>(features.size()) >= maxResults) {
-                        break;
-                    }
-
                     MapTile mapTile(x, y, zoom, 0);
                     MapBounds tileBounds = TileUtils::CalculateMapTileBounds(mapTile, _dataSource->getProjection());
                     if (proxy.testBounds(tileBounds)) {
-                        testTile(mapTile, tileBounds);
+                        tiles.emplace_back(mapTile, tileBounds);
                     }
                 }
             }
         }
+
+        // Tiles are claimed in order, so once enough features are found, all tiles preceding the unclaimed ones have been processed
+        std::vector<std::vector<std::shared_ptr<VectorTileFeature> > > tileFeatures(tiles.size());
+        std::atomic<std::size_t> nextTileIndex(0);
+        std::atomic<int> featureCount(0);
+
+        auto testTiles = [&]() {
+            while (featureCount.load() < maxResults) {
+                std::size_t tileIndex = nextTileIndex++;
+                if (tileIndex >= tiles.size()) {
+                    break;
+                }
+
+                const MapTile& mapTile = tiles[tileIndex].first;
+                const MapBounds& tileBounds = tiles[tileIndex].second;
+                if (std::shared_ptr<TileData> tileData = _dataSource->loadTile(mapTile.getFlipped())) {
+                    if (std::shared_ptr<VectorTileFeatureCollection> featureCollection = _tileDecoder->decodeFeatures(vt::TileId(mapTile.getZoom(), mapTile.getX(), mapTile.getY()), tileData->getData(), tileBounds)) {
+                        std::vector<std::shared_ptr<VectorTileFeature> >& features = tileFeatures[tileIndex];
+                        for (int i = 0; i < featureCollection->getFeatureCount(); i++) {
+                            if (static_cast<int>(features.size()) >= maxResults) {
+                                break;
+                            }
+
+                            const std::shared_ptr<VectorTileFeature>& feature = featureCollection->getFeature(i);
+
+                            if (proxy.testElement([&feature]() { return feature->getGeometry(); }, &feature->getLayerName(), feature->getProperties())) {
+                                features.push_back(feature);
+                            }
+                        }
+                        featureCount += static_cast<int>(features.size());
+                    }
+                }
+            }
+        };
+
+        unsigned int threadCount = std::min(std::max(1u, std::thread::hardware_concurrency()), MAX_SEARCH_THREADS);
+        threadCount = static_cast<unsigned int>(std::min(static_cast<std::size_t>(threadCount), tiles.size()));
+        std::vector<std::thread> threads;
+        for (unsigned int i = 1; i < threadCount; i++) {
+            threads.emplace_back(testTiles);
+        }
+        testTiles();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        std::vector<std::shared_ptr<VectorTileFeature> > features;
+        for (const std::vector<std::shared_ptr<VectorTileFeature> >& tileFeatureList : tileFeatures) {
+            for (const std::shared_ptr<VectorTileFeature>& feature : tileFeatureList) {
+                if (static_cast<int>(features.size()) >= maxResults) {
+                    break;
+                }
+                features.push_back(feature);
+            }
+        }
         return std::make_shared<VectorTileFeatureCollection>(features);
     }
 
+    const unsigned int VectorTileSearchService::MAX_SEARCH_THREADS = 4;
+
 }
 
 #endif
@@ -85,6 +85,7 @@ namespace carto {
         /**
          * Searches for the features specified by search request from the vector tiles bound to the service.
          * The zoom level range used for searching is specified using minZoom/maxZoom attributes of the search service.
+         * Tiles are loaded and decoded in parallel, the results are ordered by zoom level and tile coordinates.
          * @param request The search request containing search filters.
          * @return The resulting feature collection containing features matching the request.
          */
@@ -99,6 +100,9 @@ namespace carto {
         int _maxResults;
 
         mutable std::mutex _mutex;
+
+    private:
+        static const unsigned int MAX_SEARCH_THREADS;
     };
     
 }
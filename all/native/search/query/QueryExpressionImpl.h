@@ -11,7 +11,9 @@
 #include "search/query/QueryExpression.h"
 
 #include <limits>
+#include <memory>
 #include <regex>
+#include <string>
 
 #include <boost/variant.hpp>
 #include <boost/lexical_cast.hpp>
@@ -26,6 +28,10 @@ namespace carto {
 
         using Context = QueryContext;
 
+        struct EmptyContext : public Context {
+            virtual bool getVariable(const std::string& name, Value& value) const { return false; }
+        };
+
         struct IsNullPredicate {
             bool operator() (const Value& val) const { return val.getType() == VariantType::VARIANT_TYPE_NULL; }
         };
@@ -36,8 +42,8 @@ namespace carto {
 
         template <bool CaseInsensitive>
         struct RegexpLikePredicate {
-            bool operator() (const Value& val1, const Value& val2) const {
-                switch (val1.getType()) {
+            static bool GetString(const Value& val, std::wstring& str) {
+                switch (val.getType()) {
                 case VariantType::VARIANT_TYPE_NULL:
                 case VariantType::VARIANT_TYPE_ARRAY:
                 case VariantType::VARIANT_TYPE_OBJECT:
@@ -45,27 +51,36 @@ namespace carto {
                 default:
                     break;
                 }
-                std::string str = val1.getString();
-                unistring::unistring unistr = unistring::to_unistring(str);
+                unistring::unistring unistr = unistring::to_unistring(val.getString());
                 if (CaseInsensitive) {
                     unistr = unistring::to_normalized(unistring::to_upper(unistr));
                 }
+                str = unistring::to_wstring(unistr);
+                return true;
+            }
 
-                switch (val2.getType()) {
-                case VariantType::VARIANT_TYPE_NULL:
-                case VariantType::VARIANT_TYPE_ARRAY:
-                case VariantType::VARIANT_TYPE_OBJECT:
-                    return false;
-                default:
-                    break;
+            static std::shared_ptr<std::wregex> CreateRegex(const Value& val) {
+                std::wstring re;
+                if (!GetString(val, re)) {
+                    return std::shared_ptr<std::wregex>();
                 }
-                std::string re = val2.getString();
-                unistring::unistring unire = unistring::to_unistring(re);
-                if (CaseInsensitive) {
-                    unire = unistring::to_normalized(unistring::to_upper(unire));
+                return std::make_shared<std::wregex>(re);
+            }
+
+            bool operator() (const Value& val1, const std::wregex& re) const {
+                std::wstring str;
+                if (!GetString(val1, str)) {
+                    return false;
                 }
+                return std::regex_match(str, re);
+            }
 
-                return std::regex_match(unistring::to_wstring(unistr), std::wregex(unistring::to_wstring(unire)));
+            bool operator() (const Value& val1, const Value& val2) const {
+                std::shared_ptr<std::wregex> re = CreateRegex(val2);
+                if (!re) {
+                    return false;
+                }
+                return (*this)(val1, *re);
             }
         };
 
@@ -148,11 +163,13 @@ namespace carto {
 
         struct Operand {
             virtual ~Operand() = default;
+            virtual bool isConst() const { return false; }
             virtual Value evaluate(const Context& context) const = 0;
         };
 
         struct ConstOperand : public Operand {
             explicit ConstOperand(const Value& value) : _value(value) { }
+            virtual bool isConst() const { return true; }
             virtual Value evaluate(const Context& context) const { return _value; }
             static std::shared_ptr<ConstOperand> create(const Value& value) { return std::make_shared<ConstOperand>(value); }
         private:
@@ -186,10 +203,26 @@ namespace carto {
             bool _nocase;
         };
 
+        // Expressions with constant operands are folded into constant expressions when created
+
+        struct ConstExpression : public Expression {
+            explicit ConstExpression(bool value) : _value(value) { }
+            virtual bool evaluate(const Context& context) const { return _value; }
+            static std::shared_ptr<ConstExpression> create(bool value) { return std::make_shared<ConstExpression>(value); }
+            static const ConstExpression* cast(const std::shared_ptr<Expression>& expr) { return dynamic_cast<const ConstExpression*>(expr.get()); }
+        private:
+            bool _value;
+        };
+
         struct NotExpression : public Expression {
             explicit NotExpression(const std::shared_ptr<Expression>& expr) : _expr(expr) { }
             virtual bool evaluate(const Context& context) const { return !_expr->evaluate(context); }
-            static std::shared_ptr<NotExpression> create(const std::shared_ptr<Expression>& expr) { return std::make_shared<NotExpression>(expr); }
+            static std::shared_ptr<Expression> create(const std::shared_ptr<Expression>& expr) {
+                if (const ConstExpression* constExpr = ConstExpression::cast(expr)) {
+                    return ConstExpression::create(!constExpr->evaluate(EmptyContext()));
+                }
+                return std::make_shared<NotExpression>(expr);
+            }
         private:
             std::shared_ptr<Expression> _expr;
         };
@@ -197,7 +230,15 @@ namespace carto {
         struct OrExpression : public Expression {
             OrExpression(const std::shared_ptr<Expression>& expr1, const std::shared_ptr<Expression>& expr2) : _expr1(expr1), _expr2(expr2) { }
             virtual bool evaluate(const Context& context) const { return _expr1->evaluate(context) || _expr2->evaluate(context); }
-            static std::shared_ptr<OrExpression> create(const std::shared_ptr<Expression>& expr1, const std::shared_ptr<Expression>& expr2) { return std::make_shared<OrExpression>(expr1, expr2); }
+            static std::shared_ptr<Expression> create(const std::shared_ptr<Expression>& expr1, const std::shared_ptr<Expression>& expr2) {
+                if (const ConstExpression* constExpr1 = ConstExpression::cast(expr1)) {
+                    return constExpr1->evaluate(EmptyContext()) ? expr1 : expr2;
+                }
+                if (const ConstExpression* constExpr2 = ConstExpression::cast(expr2)) {
+                    return constExpr2->evaluate(EmptyContext()) ? expr2 : expr1;
+                }
+                return std::make_shared<OrExpression>(expr1, expr2);
+            }
         private:
             std::shared_ptr<Expression> _expr1, _expr2;
         };
@@ -205,7 +246,15 @@ namespace carto {
         struct AndExpression : public Expression {
             AndExpression(const std::shared_ptr<Expression>& expr1, const std::shared_ptr<Expression>& expr2) : _expr1(expr1), _expr2(expr2) { }
             virtual bool evaluate(const Context& context) const { return _expr1->evaluate(context) && _expr2->evaluate(context); }
-            static std::shared_ptr<AndExpression> create(const std::shared_ptr<Expression>& expr1, const std::shared_ptr<Expression>& expr2) { return std::make_shared<AndExpression>(expr1, expr2); }
+            static std::shared_ptr<Expression> create(const std::shared_ptr<Expression>& expr1, const std::shared_ptr<Expression>& expr2) {
+                if (const ConstExpression* constExpr1 = ConstExpression::cast(expr1)) {
+                    return constExpr1->evaluate(EmptyContext()) ? expr2 : expr1;
+                }
+                if (const ConstExpression* constExpr2 = ConstExpression::cast(expr2)) {
+                    return constExpr2->evaluate(EmptyContext()) ? expr1 : expr2;
+                }
+                return std::make_shared<AndExpression>(expr1, expr2);
+            }
         private:
             std::shared_ptr<Expression> _expr1, _expr2;
         };
@@ -214,7 +263,13 @@ namespace carto {
         struct UnaryPredicateExpression : public Expression {
             UnaryPredicateExpression(const std::shared_ptr<Pred>& pred, const std::shared_ptr<Operand>& op) : _pred(pred), _op(op) { }
             virtual bool evaluate(const Context& context) const { return (*_pred)(_op->evaluate(context)); }
-            static std::shared_ptr<UnaryPredicateExpression> create(const std::shared_ptr<Operand>& op) { return std::make_shared<UnaryPredicateExpression>(std::make_shared<Pred>(), op); }
+            static std::shared_ptr<Expression> create(const std::shared_ptr<Operand>& op) {
+                auto expr = std::make_shared<UnaryPredicateExpression>(std::make_shared<Pred>(), op);
+                if (op->isConst()) {
+                    return ConstExpression::create(expr->evaluate(EmptyContext()));
+                }
+                return expr;
+            }
         private:
             std::shared_ptr<Pred> _pred;
             std::shared_ptr<Operand> _op;
@@ -224,11 +279,37 @@ namespace carto {
         struct BinaryPredicateExpression : public Expression {
             BinaryPredicateExpression(const std::shared_ptr<Pred>& pred, const std::shared_ptr<Operand>& op1, const std::shared_ptr<Operand>& op2) : _pred(pred), _op1(op1), _op2(op2) { }
             virtual bool evaluate(const Context& context) const { return (*_pred)(_op1->evaluate(context), _op2->evaluate(context)); }
-            static std::shared_ptr<BinaryPredicateExpression> create(const std::shared_ptr<Operand>& op1, const std::shared_ptr<Operand>& op2) { return std::make_shared<BinaryPredicateExpression>(std::make_shared<Pred>(), op1, op2); }
+            static std::shared_ptr<Expression> create(const std::shared_ptr<Operand>& op1, const std::shared_ptr<Operand>& op2) {
+                auto expr = std::make_shared<BinaryPredicateExpression>(std::make_shared<Pred>(), op1, op2);
+                if (op1->isConst() && op2->isConst()) {
+                    return ConstExpression::create(expr->evaluate(EmptyContext()));
+                }
+                return expr;
+            }
         private:
             std::shared_ptr<Pred> _pred;
             std::shared_ptr<Operand> _op1, _op2;
         };
+
+        template <bool CaseInsensitive>
+        struct RegexpLikeExpression : public Expression {
+            RegexpLikeExpression(const std::shared_ptr<Operand>& op, const std::shared_ptr<std::wregex>& re) : _op(op), _re(re) { }
+            virtual bool evaluate(const Context& context) const { return _re && RegexpLikePredicate<CaseInsensitive>()(_op->evaluate(context), *_re); }
+            static std::shared_ptr<Expression> create(const std::shared_ptr<Operand>& op1, const std::shared_ptr<Operand>& op2) {
+                if (!op2->isConst()) {
+                    return BinaryPredicateExpression<RegexpLikePredicate<CaseInsensitive> >::create(op1, op2);
+                }
+                // Compile constant regular expressions only once
+                auto expr = std::make_shared<RegexpLikeExpression>(op1, RegexpLikePredicate<CaseInsensitive>::CreateRegex(op2->evaluate(EmptyContext())));
+                if (op1->isConst()) {
+                    return ConstExpression::create(expr->evaluate(EmptyContext()));
+                }
+                return expr;
+            }
+        private:
+            std::shared_ptr<Operand> _op;
+            std::shared_ptr<std::wregex> _re;
+        };
     }
 }
 
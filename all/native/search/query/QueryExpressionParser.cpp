@@ -73,8 +73,8 @@ namespace carto {
 
                 term3 =
                       predicate [_val = _1]
-                    | (regexp_like_kw  >> '(' > operand > ',' > operand > ')')  [_val = phoenix::bind(&BinaryPredicateExpression<RegexpLikePredicate<false>>::create, _1, _2)]
-                    | (regexp_ilike_kw >> '(' > operand > ',' > operand > ')')  [_val = phoenix::bind(&BinaryPredicateExpression<RegexpLikePredicate<true>>::create, _1, _2)]
+                    | (regexp_like_kw  >> '(' > operand > ',' > operand > ')')  [_val = phoenix::bind(&RegexpLikeExpression<false>::create, _1, _2)]
+                    | (regexp_ilike_kw >> '(' > operand > ',' > operand > ')')  [_val = phoenix::bind(&RegexpLikeExpression<true>::create, _1, _2)]
                     | ('(' >> expression > ')') [_val = _1]
                     ;
 
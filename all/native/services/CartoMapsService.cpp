@@ -17,12 +17,21 @@
 #include "utils/NetworkUtils.h"
 #include "utils/Const.h"
 #include "utils/Log.h"
+#include "utils/JSONUtils.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
 #include <regex>
+#include <sstream>
+#include <thread>
 
 #include <boost/lexical_cast.hpp>
 
+#include <stdext/utf8_filesystem.h>
+
 namespace carto {
 
     CartoMapsService::CartoMapsService() :
@@ -40,6 +49,8 @@ namespace carto {
         _vectorTileBufferSize(64.0f),
         _strictMode(false),
         _vectorTileAssetPackage(),
+        _cacheDirectory(),
+        _cacheMaxAge(DEFAULT_CACHE_MAX_AGE),
         _mutex()
     {
     }
@@ -187,6 +198,26 @@ namespace carto {
         _vectorTileAssetPackage = assetPackage;
     }
 
+    std::string CartoMapsService::getCacheDirectory() const {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return _cacheDirectory;
+    }
+
+    void CartoMapsService::setCacheDirectory(const std::string& cacheDirectory) {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _cacheDirectory = cacheDirectory;
+    }
+
+    int CartoMapsService::getCacheMaxAge() const {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return _cacheMaxAge;
+    }
+
+    void CartoMapsService::setCacheMaxAge(int maxAge) {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _cacheMaxAge = maxAge;
+    }
+
     std::vector<std::shared_ptr<Layer> > CartoMapsService::buildMap(const Variant& mapConfig) const {
         std::lock_guard<std::recursive_mutex> lock(_mutex);
 
@@ -202,33 +233,8 @@ namespace carto {
         urlParams["callback"] = "callback";
         std::string url = NetworkUtils::BuildURLFromParameters(getServiceURL("/api/v1/map"), urlParams);
 
-        // Do HTTP request
-        HTTPClient client(Log::IsShowDebug());
-        std::shared_ptr<BinaryData> responseData;
-        std::map<std::string, std::string> responseHeaders;
-        if (client.get(url, std::map<std::string, std::string>(), responseHeaders, responseData) != 0) {
-            std::string result;
-            if (responseData) {
-                result = std::string(reinterpret_cast<const char*>(responseData->data()), responseData->size());
-            }
-            throw GenericException("Failed to read map configuration", result);
-        }
-
-        // Parse result
-        picojson::value mapInfo = parseJSONP(responseData);
-
-        // Check for errors and log them
-        if (mapInfo.get("errors").is<picojson::array>()) {
-            const picojson::array& errorsInfo = mapInfo.get("errors").get<picojson::array>();
-            for (auto it = errorsInfo.begin(); it != errorsInfo.end(); it++) {
-                std::string error = it->get<std::string>();
-                Log::Errorf("CartoMapsService::buildMap: %s", error.c_str());
-            }
-            if (!errorsInfo.empty()) {
-                std::string firstError = errorsInfo.front().get<std::string>();
-                throw GenericException("Errors when trying to instantiate anonymous map", firstError);
-            }
-        }
+        // Load the map configuration from the cache or the service
+        picojson::value mapInfo = loadMapInfo(url, "Errors when trying to instantiate anonymous map");
 
         // Create layers
         return createLayers(mapInfo);
@@ -249,33 +255,8 @@ namespace carto {
         urlParams["callback"] = "callback";
         std::string url = NetworkUtils::BuildURLFromParameters(getServiceURL("/api/v1/map/named/" + NetworkUtils::URLEncode(templateId) + "/jsonp"), urlParams);
 
-        // Perform HTTP request
-        HTTPClient client(Log::IsShowDebug());
-        std::shared_ptr<BinaryData> responseData;
-        std::map<std::string, std::string> responseHeaders;
-        if (client.get(url, std::map<std::string, std::string>(), responseHeaders, responseData) != 0) {
-            std::string result;
-            if (responseData) {
-                result = std::string(reinterpret_cast<const char*>(responseData->data()), responseData->size());
-            }
-            throw GenericException("Failed to read map configuration", result);
-        }
-        
-        // Parse result
-        picojson::value mapInfo = parseJSONP(responseData);
-
-        // Check for errors and log them
-        if (mapInfo.get("errors").is<picojson::array>()) {
-            const picojson::array& errorsInfo = mapInfo.get("errors").get<picojson::array>();
-            for (auto it = errorsInfo.begin(); it != errorsInfo.end(); it++) {
-                std::string error = it->get<std::string>();
-                Log::Errorf("CartoMapsService::buildNamedMap: %s", error.c_str());
-            }
-            if (!errorsInfo.empty()) {
-                std::string firstError = errorsInfo.front().get<std::string>();
-                throw GenericException("Errors when trying to instantiate named map", firstError);
-            }
-        }
+        // Load the map configuration from the cache or the service
+        picojson::value mapInfo = loadMapInfo(url, "Errors when trying to instantiate named map");
 
         // Create layers
         return createLayers(mapInfo);
@@ -509,6 +490,139 @@ namespace carto {
         return layers;
     }
 
+    picojson::value CartoMapsService::loadMapInfo(const std::string& url, const std::string& errorMessage) const {
+        // Note: _mutex must be locked by the caller
+        std::string cacheFileName;
+        if (!_cacheDirectory.empty()) {
+            cacheFileName = GetCacheFileName(_cacheDirectory, url);
+            picojson::value mapInfo;
+            if (ReadCachedMapInfo(cacheFileName, _cacheMaxAge, mapInfo)) {
+                // Use the cached configuration and refresh it for the next call. The thread does not reference the service, as it may be released before the request completes.
+                std::thread refreshThread([url, cacheFileName]() {
+                    try {
+                        picojson::value mapInfo = FetchMapInfo(url);
+                        if (!HasErrors(mapInfo)) {
+                            WriteCachedMapInfo(cacheFileName, mapInfo);
+                        }
+                    }
+                    catch (const std::exception& ex) {
+                        Log::Warnf("CartoMapsService::loadMapInfo: Failed to refresh cached map configuration: %s", ex.what());
+                    }
+                });
+                refreshThread.detach();
+                return mapInfo;
+            }
+        }
+
+        picojson::value mapInfo = FetchMapInfo(url);
+
+        // Check for errors and log them
+        if (HasErrors(mapInfo)) {
+            const picojson::array& errorsInfo = mapInfo.get("errors").get<picojson::array>();
+            for (auto it = errorsInfo.begin(); it != errorsInfo.end(); it++) {
+                std::string error = it->get<std::string>();
+                Log::Errorf("CartoMapsService::loadMapInfo: %s", error.c_str());
+            }
+            std::string firstError = errorsInfo.front().get<std::string>();
+            throw GenericException(errorMessage, firstError);
+        }
+
+        if (!cacheFileName.empty()) {
+            WriteCachedMapInfo(cacheFileName, mapInfo);
+        }
+        return mapInfo;
+    }
+
+    picojson::value CartoMapsService::FetchMapInfo(const std::string& url) {
+        HTTPClient client(Log::IsShowDebug());
+        std::shared_ptr<BinaryData> responseData;
+        std::map<std::string, std::string> responseHeaders;
+        if (client.get(url, std::map<std::string, std::string>(), responseHeaders, responseData) != 0) {
+            std::string result;
+            if (responseData) {
+                result = std::string(reinterpret_cast<const char*>(responseData->data()), responseData->size());
+            }
+            throw GenericException("Failed to read map configuration", result);
+        }
+
+        return parseJSONP(responseData);
+    }
+
+    bool CartoMapsService::ReadCachedMapInfo(const std::string& fileName, int maxAge, picojson::value& mapInfo) {
+        FILE* fpRaw = utf8_filesystem::fopen(fileName.c_str(), "rb");
+        if (!fpRaw) {
+            return false;
+        }
+        std::shared_ptr<FILE> fp(fpRaw, fclose);
+
+        std::string json;
+        char buffer[4096];
+        while (std::size_t size = fread(buffer, 1, sizeof(buffer), fp.get())) {
+            json.append(buffer, size);
+        }
+        fp.reset();
+
+        picojson::value cacheEntry;
+        std::string err = JSONUtils::ParsePicoJSON(cacheEntry, json);
+        if (!err.empty() || !cacheEntry.get("time").is<double>() || !cacheEntry.get("mapInfo").is<picojson::object>()) {
+            Log::Warnf("CartoMapsService::ReadCachedMapInfo: Invalid cache file %s", fileName.c_str());
+            return false;
+        }
+
+        long long time = static_cast<long long>(cacheEntry.get("time").get<double>());
+        long long currentTime = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        if (currentTime < time || currentTime - time > maxAge) {
+            return false;
+        }
+        mapInfo = cacheEntry.get("mapInfo");
+        return true;
+    }
+
+    void CartoMapsService::WriteCachedMapInfo(const std::string& fileName, const picojson::value& mapInfo) {
+        picojson::object cacheEntry;
+        cacheEntry["time"] = picojson::value(static_cast<double>(std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count()));
+        cacheEntry["mapInfo"] = mapInfo;
+        std::string json = picojson::value(cacheEntry).serialize();
+
+        // Write to a temporary file first, so that partially written files are never read
+        std::string tempFileName = fileName + ".tmp";
+        FILE* fpRaw = utf8_filesystem::fopen(tempFileName.c_str(), "wb");
+        if (!fpRaw) {
+            Log::Warnf("CartoMapsService::WriteCachedMapInfo: Could not create file %s", tempFileName.c_str());
+            return;
+        }
+        std::shared_ptr<FILE> fp(fpRaw, fclose);
+        bool written = fwrite(json.data(), 1, json.size(), fp.get()) == json.size();
+        fp.reset();
+
+        utf8_filesystem::unlink(fileName.c_str());
+        if (!written || utf8_filesystem::rename(tempFileName.c_str(), fileName.c_str()) != 0) {
+            Log::Warnf("CartoMapsService::WriteCachedMapInfo: Could not write file %s", fileName.c_str());
+            utf8_filesystem::unlink(tempFileName.c_str());
+        }
+    }
+
+    std::string CartoMapsService::GetCacheFileName(const std::string& cacheDirectory, const std::string& url) {
+        // FNV-1a, stable between runs unlike std::hash. The URL contains the full configuration and credentials.
+        std::uint64_t hash = 14695981039346656037ULL;
+        for (char c : url) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ULL;
+        }
+
+        std::stringstream ss;
+        ss << cacheDirectory;
+        if (!cacheDirectory.empty() && cacheDirectory.back() != '/' && cacheDirectory.back() != '\\') {
+            ss << '/';
+        }
+        ss << "carto_mapconfig_" << std::hex << std::setw(16) << std::setfill('0') << hash << ".json";
+        return ss.str();
+    }
+
+    bool CartoMapsService::HasErrors(const picojson::value& mapInfo) {
+        return mapInfo.get("errors").is<picojson::array>() && !mapInfo.get("errors").get<picojson::array>().empty();
+    }
+
     picojson::value CartoMapsService::parseJSONP(const std::shared_ptr<BinaryData>& data) {
         static const std::regex re(".*callback\\s*[(]\\s*(.*)\\s*[)][^)]*");
 
@@ -526,7 +640,7 @@ namespace carto {
 
         // Parse the extracted JSON
         picojson::value result;
-        std::string err = picojson::parse(result, json);
+        std::string err = JSONUtils::ParsePicoJSON(result, json);
         if (!err.empty()) {
             throw ParseException(std::string("Failed to parse map configuration JSONP response: ") + err, jsonp);
         }
@@ -534,6 +648,7 @@ namespace carto {
     }
 
     const std::string CartoMapsService::DEFAULT_API_TEMPLATE = "https://{user}.carto.com";
+    const int CartoMapsService::DEFAULT_CACHE_MAX_AGE = 24 * 60 * 60;
 
 }
 
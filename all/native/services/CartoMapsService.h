@@ -208,6 +208,34 @@ namespace carto {
          */
         void setVectorTileAssetPackage(const std::shared_ptr<AssetPackage>& assetPackage);
 
+        /**
+         * Returns the directory used for caching instantiated map configurations.
+         * @return The cache directory. Empty if caching is disabled.
+         */
+        std::string getCacheDirectory() const;
+        /**
+         * Sets the directory used for caching instantiated map configurations.
+         * If set, the responses of the online service are stored in this directory and
+         * subsequent build calls with the same configuration create the layers from the cached response
+         * without waiting for the network. The cached response is then refreshed in the background,
+         * so the next build call uses an up-to-date configuration.
+         * @param cacheDirectory The cache directory. The directory must exist. Empty string disables caching (the default).
+         */
+        void setCacheDirectory(const std::string& cacheDirectory);
+
+        /**
+         * Returns the maximum age of cached map configurations.
+         * @return The maximum age in seconds.
+         */
+        int getCacheMaxAge() const;
+        /**
+         * Sets the maximum age of cached map configurations. Cached responses older than this
+         * are not used and the map configuration is requested from the online service instead.
+         * The default is 86400 (one day).
+         * @param maxAge The maximum age in seconds.
+         */
+        void setCacheMaxAge(int maxAge);
+
         /**
          * Builds a list of layers given anonymous map configuration.
          * The map configuration specification can be found in CartoDB documentation page.
@@ -243,9 +271,18 @@ namespace carto {
 
         std::vector<std::shared_ptr<Layer> > createLayers(const picojson::value& mapInfo) const;
 
+        picojson::value loadMapInfo(const std::string& url, const std::string& errorMessage) const;
+
+        static picojson::value FetchMapInfo(const std::string& url);
+        static bool ReadCachedMapInfo(const std::string& fileName, int maxAge, picojson::value& mapInfo);
+        static void WriteCachedMapInfo(const std::string& fileName, const picojson::value& mapInfo);
+        static std::string GetCacheFileName(const std::string& cacheDirectory, const std::string& url);
+        static bool HasErrors(const picojson::value& mapInfo);
+
         static picojson::value parseJSONP(const std::shared_ptr<BinaryData>& data);
 
         static const std::string DEFAULT_API_TEMPLATE;
+        static const int DEFAULT_CACHE_MAX_AGE;
         
         std::string _username;
         std::string _apiKey;
@@ -261,6 +298,8 @@ namespace carto {
         float _vectorTileBufferSize;
         bool _strictMode;
         std::shared_ptr<AssetPackage> _vectorTileAssetPackage;
+        std::string _cacheDirectory;
+        int _cacheMaxAge;
 
         mutable std::recursive_mutex _mutex;
     };
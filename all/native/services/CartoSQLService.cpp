@@ -2,8 +2,10 @@
 
 #include "CartoSQLService.h"
 #include "core/BinaryData.h"
+#include "geometry/Feature.h"
 #include "geometry/FeatureCollection.h"
 #include "geometry/GeoJSONGeometryReader.h"
+#include "geometry/GeoJSONFeatureListener.h"
 #include "components/Exceptions.h"
 #include "projections/Projection.h"
 #include "network/HTTPClient.h"
@@ -11,9 +13,86 @@
 #include "utils/NetworkUtils.h"
 #include "utils/Const.h"
 #include "utils/Log.h"
+#include "utils/JSONUtils.h"
+
+#include <exception>
+#include <functional>
 
 namespace carto {
 
+    class CartoSQLService::FeatureStreamParser {
+    public:
+        explicit FeatureStreamParser(const std::function<bool(const std::string&)>& featureHandler) :
+            _featureHandler(featureHandler), _depth(0), _inString(false), _escape(false), _inFeatures(false), _key(), _featureJSON() { }
+
+        bool parse(const unsigned char* data, std::size_t size) {
+            // Only the structure of the response is tracked, the elements of the top-level 'features' array are extracted as strings and parsed separately
+            for (std::size_t i = 0; i < size; i++) {
+                char c = static_cast<char>(data[i]);
+                bool inFeature = _inFeatures && _depth >= 3;
+                if (_inString) {
+                    if (_escape) {
+                        _escape = false;
+                    } else if (c == '\\') {
+                        _escape = true;
+                    } else if (c == '"') {
+                        _inString = false;
+                    } else if (_depth == 1) {
+                        _key += c;
+                    }
+                } else {
+                    switch (c) {
+                    case '"':
+                        _inString = true;
+                        if (_depth == 1) {
+                            _key.clear();
+                        }
+                        break;
+                    case '{':
+                    case '[':
+                        _depth++;
+                        if (_depth == 2 && c == '[' && _key == "features") {
+                            _inFeatures = true;
+                        } else if (_inFeatures && _depth == 3) {
+                            _featureJSON.clear();
+                            inFeature = true;
+                        }
+                        break;
+                    case '}':
+                    case ']':
+                        if (_inFeatures && _depth == 3) {
+                            _featureJSON += c;
+                            inFeature = false;
+                            if (!_featureHandler(_featureJSON)) {
+                                return false;
+                            }
+                            _featureJSON.clear();
+                        } else if (_inFeatures && _depth == 2) {
+                            _inFeatures = false;
+                        }
+                        _depth--;
+                        break;
+                    default:
+                        break;
+                    }
+                }
+                if (inFeature) {
+                    _featureJSON += c;
+                }
+            }
+            return true;
+        }
+
+    private:
+        std::function<bool(const std::string&)> _featureHandler;
+        int _depth;
+        bool _inString;
+        bool _escape;
+        bool _inFeatures;
+        std::string _key; // last string at the top level of the response
+        std::string _featureJSON;
+    };
+
     CartoSQLService::CartoSQLService() :
         _username(),
         _apiKey(),
@@ -88,38 +167,90 @@ namespace carto {
         return reader.readFeatureCollection(result);
     }
 
-    std::string CartoSQLService::executeQuery(const std::map<std::string, std::string>& urlParams) const {
+    int CartoSQLService::queryFeatures(const std::string& sql, const std::shared_ptr<Projection>& proj, const std::shared_ptr<GeoJSONFeatureListener>& listener) const {
+        if (!listener) {
+            throw NullArgumentException("Null listener");
+        }
+
+        std::map<std::string, std::string> urlParams;
+        urlParams["q"] = sql;
+        urlParams["format"] = "GeoJSON";
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            if (!_apiKey.empty()) {
+                urlParams["api_key"] = _apiKey;
+            }
+        }
+        std::string url = getQueryURL(urlParams);
+
+        GeoJSONGeometryReader reader;
+        reader.setTargetProjection(proj);
+
+        // Parse the features while the response is being downloaded. Exceptions are not passed through the HTTP client, as the handler may be called from another thread.
+        int featureCount = 0;
+        bool stopped = false;
+        std::exception_ptr exception;
+        std::string errorResponse;
+        FeatureStreamParser parser([&](const std::string& featureJSON) {
+            try {
+                std::shared_ptr<Feature> feature = reader.readFeature(featureJSON);
+                featureCount++;
+                if (!listener->onFeatureRead(feature)) {
+                    stopped = true;
+                    return false;
+                }
+            }
+            catch (...) {
+                exception = std::current_exception();
+                return false;
+            }
+            return true;
+        });
+        auto handler = [&](std::uint64_t offset, std::uint64_t length, const unsigned char* data, std::size_t size) {
+            if (featureCount == 0 && errorResponse.size() < MAX_ERROR_RESPONSE_SIZE) {
+                errorResponse.append(reinterpret_cast<const char*>(data), size);
+            }
+            return parser.parse(data, size);
+        };
+
+        HTTPClient client(Log::IsShowDebug());
+        std::map<std::string, std::string> responseHeaders;
+        int code = client.streamResponse("GET", url, std::map<std::string, std::string>(), responseHeaders, handler, 0);
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+        if (code != 0 && !stopped) {
+            throw GenericException("Failed to execute query", GetQueryError(errorResponse));
+        }
+        return featureCount;
+    }
+
+    std::string CartoSQLService::getQueryURL(const std::map<std::string, std::string>& urlParams) const {
         std::lock_guard<std::recursive_mutex> lock(_mutex);
 
-        // Build URL
         std::map<std::string, std::string> tagValues = { { "user", _username },{ "username", _username } };
         std::string baseURL = GeneralUtils::ReplaceTags(_apiTemplate, tagValues, "{", "}", false) + "/api/v2/sql";
         std::string url = NetworkUtils::BuildURLFromParameters(baseURL, urlParams);
         if (urlParams.find("api_key") != urlParams.end()) {
             url = NetworkUtils::SetURLProtocol(url, "https");
         }
+        return url;
+    }
+
+    std::string CartoSQLService::executeQuery(const std::map<std::string, std::string>& urlParams) const {
+        // Build URL
+        std::string url = getQueryURL(urlParams);
 
         // Perform HTTP request
         HTTPClient client(Log::IsShowDebug());
         std::shared_ptr<BinaryData> responseData;
         std::map<std::string, std::string> responseHeaders;
         if (client.get(url, std::map<std::string, std::string>(), responseHeaders, responseData) != 0) {
-            std::string error = "Invalid HTTP response code";
+            std::string result;
             if (responseData) {
-                std::string result = std::string(reinterpret_cast<const char*>(responseData->data()), responseData->size());
-                picojson::value resultInfo;
-                picojson::parse(resultInfo, result);
-                if (resultInfo.get("error").is<picojson::array>()) {
-                    const picojson::array& errorInfo = resultInfo.get("error").get<picojson::array>();
-                    for (auto it = errorInfo.begin(); it != errorInfo.end(); it++) {
-                        Log::Errorf("CartoSQLService::executeQuery: %s", it->get<std::string>().c_str());
-                    }
-                    if (!errorInfo.empty()) {
-                        error = errorInfo.front().get<std::string>();
-                    }
-                }
+                result = std::string(reinterpret_cast<const char*>(responseData->data()), responseData->size());
             }
-            throw GenericException("Failed to execute query", error);
+            throw GenericException("Failed to execute query", GetQueryError(result));
         }
 
         // Return the result as string
@@ -127,7 +258,24 @@ namespace carto {
         return result;
     }
 
+    std::string CartoSQLService::GetQueryError(const std::string& result) {
+        std::string error = "Invalid HTTP response code";
+        picojson::value resultInfo;
+        JSONUtils::ParsePicoJSON(resultInfo, result);
+        if (resultInfo.get("error").is<picojson::array>()) {
+            const picojson::array& errorInfo = resultInfo.get("error").get<picojson::array>();
+            for (auto it = errorInfo.begin(); it != errorInfo.end(); it++) {
+                Log::Errorf("CartoSQLService::GetQueryError: %s", it->get<std::string>().c_str());
+            }
+            if (!errorInfo.empty()) {
+                error = errorInfo.front().get<std::string>();
+            }
+        }
+        return error;
+    }
+
     const std::string CartoSQLService::DEFAULT_API_TEMPLATE = "https://{user}.carto.com";
+    const std::size_t CartoSQLService::MAX_ERROR_RESPONSE_SIZE = 64 * 1024;
 
 }
 
@@ -17,6 +17,7 @@
 
 namespace carto {
     class FeatureCollection;
+    class GeoJSONFeatureListener;
     class Projection;
 
     /**
@@ -85,11 +86,28 @@ namespace carto {
          * @throws std::runtime_error If IO error occured during the operation.
          */
         std::shared_ptr<FeatureCollection> queryFeatures(const std::string& sql, const std::shared_ptr<Projection>& proj) const;
+        /**
+         * Connects to the online service and performs the specified query, delivering the resulting features incrementally.
+         * The response is parsed while it is being downloaded and each feature is passed to the listener as soon as it is read.
+         * Thus the memory usage does not depend on the size of the result and the first features are available before the whole result is downloaded.
+         * @param sql The SQL query to use.
+         * @param proj The projection to use for transforming feature coordinates. Can be null for WGS84 coordinates.
+         * @param listener The listener that receives the features. The query is stopped if the listener returns false.
+         * @return The number of features read.
+         * @throws std::runtime_error If IO error occured during the operation.
+         */
+        int queryFeatures(const std::string& sql, const std::shared_ptr<Projection>& proj, const std::shared_ptr<GeoJSONFeatureListener>& listener) const;
 
     private:
+        class FeatureStreamParser;
+
+        std::string getQueryURL(const std::map<std::string, std::string>& urlParams) const;
         std::string executeQuery(const std::map<std::string, std::string>& urlParams) const;
 
+        static std::string GetQueryError(const std::string& result);
+
         static const std::string DEFAULT_API_TEMPLATE;
+        static const std::size_t MAX_ERROR_RESPONSE_SIZE;
 
         std::string _username;
         std::string _apiKey;
@@ -1,5 +1,6 @@
 #include "AnimationStyleBuilder.h"
 #include "styles/AnimationStyle.h"
+#include "styles/StyleCache.h"
 
 namespace carto {
 
@@ -68,7 +69,7 @@ namespace carto {
 
     std::shared_ptr<AnimationStyle> AnimationStyleBuilder::buildStyle() const {
         std::lock_guard<std::mutex> lock(_mutex);
-        return std::make_shared<AnimationStyle>(_relativeSpeed, _phaseInDuration, _phaseOutDuration, _fadeAnimationType, _sizeAnimationType);
+        return StyleCache::Get<AnimationStyle>(_relativeSpeed, _phaseInDuration, _phaseOutDuration, _fadeAnimationType, _sizeAnimationType);
     }
         
 }
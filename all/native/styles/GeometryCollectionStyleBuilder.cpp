@@ -3,6 +3,7 @@
 #include "LineStyleBuilder.h"
 #include "PolygonStyleBuilder.h"
 #include "styles/GeometryCollectionStyle.h"
+#include "styles/StyleCache.h"
 
 namespace carto {
     
@@ -49,7 +50,7 @@ namespace carto {
     
     std::shared_ptr<GeometryCollectionStyle> GeometryCollectionStyleBuilder::buildStyle() const {
         std::lock_guard<std::mutex> lock(_mutex);
-        return std::make_shared<GeometryCollectionStyle>(_pointStyle, _lineStyle, _polygonStyle);
+        return StyleCache::Get<GeometryCollectionStyle>(_pointStyle, _lineStyle, _polygonStyle);
     }
         
 }
@@ -2,6 +2,7 @@
 #include "assets/DefaultLinePNG.h"
 #include "components/Exceptions.h"
 #include "graphics/Bitmap.h"
+#include "styles/StyleCache.h"
 
 namespace carto {
 
@@ -85,7 +86,7 @@ namespace carto {
     
     std::shared_ptr<LineStyle> LineStyleBuilder::buildStyle() const {
         std::lock_guard<std::mutex> lock(_mutex);
-        return std::make_shared<LineStyle>(_color, _bitmap, _clickWidth, _lineEndType, _lineJoinType,
+        return StyleCache::Get<LineStyle>(_color, _bitmap, _clickWidth, _lineEndType, _lineJoinType,
                 _stretchFactor, _width);
     }
     
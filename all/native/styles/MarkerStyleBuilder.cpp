@@ -3,6 +3,7 @@
 #include "components/Exceptions.h"
 #include "graphics/Bitmap.h"
 #include "styles/MarkerStyle.h"
+#include "styles/StyleCache.h"
 
 namespace carto {
 
@@ -103,23 +104,23 @@ namespace carto {
     
     std::shared_ptr<MarkerStyle> MarkerStyleBuilder::buildStyle() const {
         std::lock_guard<std::mutex> lock(_mutex);
-        return std::make_shared<MarkerStyle>(_color,
-                                             _attachAnchorPointX,
-                                             _attachAnchorPointY,
-                                             _causesOverlap,
-                                             _hideIfOverlapped,
-                                             _horizontalOffset,
-                                             _verticalOffset,
-                                             _placementPriority,
-                                             _scaleWithDPI,
-                                             _animationStyle,
-                                             _anchorPointX,
-                                             _anchorPointY,
-                                             _bitmap,
-                                             _orientationMode,
-                                             _scalingMode,
-                                             _clickSize,
-                                             _size);
+        return StyleCache::Get<MarkerStyle>(_color,
+                                            _attachAnchorPointX,
+                                            _attachAnchorPointY,
+                                            _causesOverlap,
+                                            _hideIfOverlapped,
+                                            _horizontalOffset,
+                                            _verticalOffset,
+                                            _placementPriority,
+                                            _scaleWithDPI,
+                                            _animationStyle,
+                                            _anchorPointX,
+                                            _anchorPointY,
+                                            _bitmap,
+                                            _orientationMode,
+                                            _scalingMode,
+                                            _clickSize,
+                                            _size);
     }
     
     std::shared_ptr<Bitmap> MarkerStyleBuilder::GetDefaultBitmap() {
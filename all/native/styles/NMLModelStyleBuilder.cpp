@@ -3,6 +3,7 @@
 #include "core/BinaryData.h"
 #include "components/Exceptions.h"
 #include "styles/NMLModelStyle.h"
+#include "styles/StyleCache.h"
 
 namespace carto {
 
@@ -31,7 +32,7 @@ namespace carto {
         
     std::shared_ptr<NMLModelStyle> NMLModelStyleBuilder::buildStyle() const {
         std::lock_guard<std::mutex> lock(_mutex);
-        return std::make_shared<NMLModelStyle>(_color, _modelAsset);
+        return StyleCache::Get<NMLModelStyle>(_color, _modelAsset);
     }
     
     std::shared_ptr<BinaryData> NMLModelStyleBuilder::GetDefaultModelAsset() {
@@ -3,6 +3,7 @@
 #include "components/Exceptions.h"
 #include "graphics/Bitmap.h"
 #include "styles/PointStyle.h"
+#include "styles/StyleCache.h"
 
 namespace carto {
 
@@ -53,7 +54,7 @@ namespace carto {
     
     std::shared_ptr<PointStyle> PointStyleBuilder::buildStyle() const {
         std::lock_guard<std::mutex> lock(_mutex);
-        return std::make_shared<PointStyle>(_color, _bitmap, _clickSize, _size);
+        return StyleCache::Get<PointStyle>(_color, _bitmap, _clickSize, _size);
     }
     
     std::shared_ptr<Bitmap> PointStyleBuilder::GetDefaultBitmap() {
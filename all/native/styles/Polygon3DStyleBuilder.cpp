@@ -1,5 +1,6 @@
 #include "Polygon3DStyleBuilder.h"
 #include "styles/Polygon3DStyle.h"
+#include "styles/StyleCache.h"
 
 namespace carto {
 
@@ -26,7 +27,7 @@ namespace carto {
 
     std::shared_ptr<Polygon3DStyle> Polygon3DStyleBuilder::buildStyle() const {
         std::lock_guard<std::mutex> lock(_mutex);
-        return std::make_shared<Polygon3DStyle>(_color, _sideColorDefined ? _sideColor : _color);
+        return StyleCache::Get<Polygon3DStyle>(_color, _sideColorDefined ? _sideColor : _color);
     }
     
 }
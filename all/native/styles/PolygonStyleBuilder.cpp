@@ -2,6 +2,7 @@
 #include "assets/DefaultPolygonPNG.h"
 #include "graphics/Bitmap.h"
 #include "styles/PolygonStyle.h"
+#include "styles/StyleCache.h"
 
 namespace carto {
 
@@ -27,7 +28,7 @@ namespace carto {
     
     std::shared_ptr<PolygonStyle> PolygonStyleBuilder::buildStyle() const {
         std::lock_guard<std::mutex> lock(_mutex);
-        return std::make_shared<PolygonStyle>(_color, _bitmap, _lineStyle);
+        return StyleCache::Get<PolygonStyle>(_color, _bitmap, _lineStyle);
     }
     
     std::shared_ptr<Bitmap> PolygonStyleBuilder::GetDefaultBitmap() {
@@ -1,5 +1,6 @@
 #include "PopupStyleBuilder.h"
 #include "styles/PopupStyle.h"
+#include "styles/StyleCache.h"
 
 namespace carto {
 
@@ -15,16 +16,16 @@ namespace carto {
     
     std::shared_ptr<PopupStyle> PopupStyleBuilder::buildStyle() const {
         std::lock_guard<std::mutex> lock(_mutex);
-        return std::make_shared<PopupStyle>(_color,
-                                            _attachAnchorPointX,
-                                            _attachAnchorPointY,
-                                            _causesOverlap,
-                                            _hideIfOverlapped,
-                                            _horizontalOffset,
-                                            _verticalOffset,
-                                            _placementPriority,
-                                            _scaleWithDPI,
-                                            _animationStyle);
+        return StyleCache::Get<PopupStyle>(_color,
+                                           _attachAnchorPointX,
+                                           _attachAnchorPointY,
+                                           _causesOverlap,
+                                           _hideIfOverlapped,
+                                           _horizontalOffset,
+                                           _verticalOffset,
+                                           _placementPriority,
+                                           _scaleWithDPI,
+                                           _animationStyle);
     }
         
 }
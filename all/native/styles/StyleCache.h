@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_STYLECACHE_H_
+#define _CARTO_STYLECACHE_H_
+
+#include "graphics/Color.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+namespace carto {
+
+    /**
+     * Interning cache for style objects used by the style builders.
+     * Styles are immutable, so styles built from equal parameters can share a single instance.
+     * The cache keeps only weak references, styles are released once no element uses them.
+     * Shared members (bitmaps, animation styles, substyles) are compared by identity. The cache is thread-safe.
+     */
+    class StyleCache {
+    public:
+        /**
+         * Returns a style instance constructed from the given arguments. If a live style with equal arguments
+         * exists, it is returned instead of constructing a new instance.
+         * @param args The arguments for the style constructor.
+         * @return The style instance.
+         */
+        template <typename T, typename... Args>
+        static std::shared_ptr<T> Get(const Args&... args) {
+            typedef std::tuple<Args...> Key;
+
+            Cache<T, Key>& cache = GetCache<T, Key>();
+            std::size_t hash = HashValues(args...);
+            Key key(args...);
+
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            auto range = cache.entries.equal_range(hash);
+            for (auto it = range.first; it != range.second; it++) {
+                if (it->second.first == key) {
+                    if (std::shared_ptr<T> style = it->second.second.lock()) {
+                        return style;
+                    }
+                    std::shared_ptr<T> style = std::make_shared<T>(args...);
+                    it->second.second = style;
+                    return style;
+                }
+            }
+
+            if (cache.entries.size() >= cache.purgeSize) {
+                for (auto it = cache.entries.begin(); it != cache.entries.end(); ) {
+                    if (it->second.second.expired()) {
+                        it = cache.entries.erase(it);
+                    } else {
+                        it++;
+                    }
+                }
+                std::size_t minPurgeSize = MIN_PURGE_SIZE;
+                cache.purgeSize = std::max(minPurgeSize, cache.entries.size() * 2);
+            }
+
+            std::shared_ptr<T> style = std::make_shared<T>(args...);
+            cache.entries.emplace(hash, std::make_pair(std::move(key), std::weak_ptr<T>(style)));
+            return style;
+        }
+
+    private:
+        static const std::size_t MIN_PURGE_SIZE = 64;
+
+        template <typename T, typename Key>
+        struct Cache {
+            std::unordered_multimap<std::size_t, std::pair<Key, std::weak_ptr<T> > > entries;
+            std::size_t purgeSize;
+            std::mutex mutex;
+
+            Cache() : entries(), purgeSize(MIN_PURGE_SIZE), mutex() { }
+        };
+
+        template <typename T, typename Key>
+        static Cache<T, Key>& GetCache() {
+            // Intentionally never destroyed, styles may be released during static destruction
+            static Cache<T, Key>* cache = new Cache<T, Key>();
+            return *cache;
+        }
+
+        static std::size_t HashValue(const Color& color) {
+            return std::hash<int>()(color.hash());
+        }
+
+        template <typename T>
+        static std::size_t HashValue(const std::shared_ptr<T>& ptr) {
+            return std::hash<T*>()(ptr.get());
+        }
+
+        template <typename T>
+        static typename std::enable_if<std::is_enum<T>::value, std::size_t>::type HashValue(const T& value) {
+            return std::hash<int>()(static_cast<int>(value));
+        }
+
+        template <typename T>
+        static typename std::enable_if<std::is_arithmetic<T>::value, std::size_t>::type HashValue(const T& value) {
+            return std::hash<T>()(value);
+        }
+
+        static std::size_t HashValues() {
+            return 0;
+        }
+
+        template <typename T, typename... Rest>
+        static std::size_t HashValues(const T& value, const Rest&... rest) {
+            std::size_t seed = HashValues(rest...);
+            return seed ^ (HashValue(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+        }
+    };
+
+}
+
+#endif
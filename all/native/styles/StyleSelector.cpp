@@ -1,21 +1,91 @@
 #ifdef _CARTO_GDAL_SUPPORT
 
 #include "StyleSelector.h"
+#include "search/query/QueryContext.h"
 #include "search/query/QueryExpression.h"
 #include "styles/StyleSelectorRule.h"
 #include "styles/StyleSelectorContext.h"
 
 namespace carto {
 
+    class StyleSelector::RecordingContext : public QueryContext {
+    public:
+        explicit RecordingContext(const StyleSelectorContext& context) : _context(context), _variables() { }
+
+        virtual bool getVariable(const std::string& name, Variant& value) const {
+            bool found = _context.getVariable(name, value);
+            if (!found) {
+                value = Variant();
+            }
+            for (const std::pair<std::string, Variant>& variable : _variables) {
+                if (variable.first == name) {
+                    return found;
+                }
+            }
+            _variables.emplace_back(name, value);
+            return found;
+        }
+
+        const std::vector<std::pair<std::string, Variant> >& getVariables() const {
+            return _variables;
+        }
+
+    private:
+        const StyleSelectorContext& _context;
+        mutable std::vector<std::pair<std::string, Variant> > _variables;
+    };
+
     StyleSelector::StyleSelector(const std::vector<std::shared_ptr<StyleSelectorRule> >& rules) :
-        _rules(rules)
+        _rules(rules),
+        _decisionTree(),
+        _decisionNodeCount(0),
+        _decisionTreeMutex()
     {
     }
-
+    
     StyleSelector::~StyleSelector() {
     }
-
+        
     const std::shared_ptr<Style>& StyleSelector::getStyle(const StyleSelectorContext& context) const {
+        std::lock_guard<std::mutex> lock(_decisionTreeMutex);
+
+        if (_decisionNodeCount >= MAX_DECISION_NODES) {
+            _decisionTree.reset();
+            _decisionNodeCount = 0;
+        }
+
+        // Follow the decision tree as far as it has been built
+        std::unique_ptr<DecisionNode>* nodePtr = &_decisionTree;
+        std::size_t depth = 0;
+        while (DecisionNode* node = nodePtr->get()) {
+            if (node->style) {
+                return *node->style;
+            }
+            Variant value;
+            if (!context.getVariable(node->variableName, value)) {
+                value = Variant();
+            }
+            nodePtr = &node->children[value];
+            depth++;
+        }
+
+        // Unknown combination of variable values, evaluate the rules and extend the tree with the variables read
+        RecordingContext recordingContext(context);
+        const std::shared_ptr<Style>& style = evaluateRules(recordingContext);
+        const std::vector<std::pair<std::string, Variant> >& variables = recordingContext.getVariables();
+        for (std::size_t i = depth; i < variables.size(); i++) {
+            nodePtr->reset(new DecisionNode());
+            (*nodePtr)->variableName = variables[i].first;
+            nodePtr = &(*nodePtr)->children[variables[i].second];
+            _decisionNodeCount++;
+        }
+        nodePtr->reset(new DecisionNode());
+        (*nodePtr)->style = &style;
+        _decisionNodeCount++;
+        return style;
+    }
+
+    const std::shared_ptr<Style>& StyleSelector::evaluateRules(const RecordingContext& context) const {
         static std::shared_ptr<Style> nullStyle;
         for (const std::shared_ptr<StyleSelectorRule>& rule : _rules) {
             if (std::shared_ptr<QueryExpression> expr = rule->getExpression()) {
@@ -9,7 +9,12 @@
 
 #ifdef _CARTO_GDAL_SUPPORT
 
+#include "core/Variant.h"
+
 #include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace carto {
@@ -38,6 +43,31 @@ namespace carto {
 
     protected:
         const std::vector<std::shared_ptr<StyleSelectorRule> > _rules;
+
+    private:
+        static const std::size_t MAX_DECISION_NODES = 65536;
+
+        class RecordingContext;
+
+        struct VariantHash {
+            std::size_t operator() (const Variant& value) const { return static_cast<std::size_t>(value.hash()); }
+        };
+
+        // Rule evaluation depends only on the values of the variables it reads. The tree is built from
+        // the variables read by earlier evaluations: inner nodes hold the next variable to read, leaves hold the resulting style.
+        struct DecisionNode {
+            std::string variableName;
+            const std::shared_ptr<Style>* style;
+            std::unordered_map<Variant, std::unique_ptr<DecisionNode>, VariantHash> children;
+
+            DecisionNode() : variableName(), style(nullptr), children() { }
+        };
+
+        const std::shared_ptr<Style>& evaluateRules(const RecordingContext& context) const;
+
+        mutable std::unique_ptr<DecisionNode> _decisionTree;
+        mutable std::size_t _decisionNodeCount;
+        mutable std::mutex _decisionTreeMutex;
     };
 }
 
@@ -2,6 +2,7 @@
 #include "components/CancelableThreadPool.h"
 #include "components/LicenseManager.h"
 #include "components/Layers.h"
+#include "components/MemoryGovernor.h"
 #include "core/MapPos.h"
 #include "core/MapBounds.h"
 #include "core/ScreenPos.h"
@@ -39,10 +40,49 @@ namespace carto {
         ss << ", device OS: " << PlatformUtils::GetDeviceOS();
         return ss.str();
     }
+
+    std::size_t BaseMapView::GetMemoryBudget() {
+        return MemoryGovernor::GetInstance().getTotalBudget();
+    }
+
+    void BaseMapView::SetMemoryBudget(std::size_t budgetInBytes) {
+        MemoryGovernor::GetInstance().setTotalBudget(budgetInBytes);
+    }
+
+    std::size_t BaseMapView::GetGPUMemoryBudget() {
+        return MemoryGovernor::GetInstance().getGPUBudget();
+    }
+
+    void BaseMapView::SetGPUMemoryBudget(std::size_t budgetInBytes) {
+        MemoryGovernor::GetInstance().setGPUBudget(budgetInBytes);
+    }
     
+    struct BaseMapView::SharedThreadPools {
+        bool enabled;
+        int viewCount;
+        std::shared_ptr<CancelableThreadPool> envelopeThreadPool;
+        std::shared_ptr<CancelableThreadPool> tileThreadPool;
+        std::mutex mutex;
+
+        SharedThreadPools() : enabled(false), viewCount(0), envelopeThreadPool(), tileThreadPool(), mutex() { }
+    };
+
+    bool BaseMapView::IsSharedThreadPools() {
+        SharedThreadPools& sharedThreadPools = GetSharedThreadPools();
+        std::lock_guard<std::mutex> lock(sharedThreadPools.mutex);
+        return sharedThreadPools.enabled;
+    }
+
+    void BaseMapView::SetSharedThreadPools(bool enabled) {
+        SharedThreadPools& sharedThreadPools = GetSharedThreadPools();
+        std::lock_guard<std::mutex> lock(sharedThreadPools.mutex);
+        sharedThreadPools.enabled = enabled;
+    }
+
     BaseMapView::BaseMapView() :
-        _envelopeThreadPool(std::make_shared<CancelableThreadPool>()),
-        _tileThreadPool(std::make_shared<CancelableThreadPool>()),
+        _sharedThreadPools(IsSharedThreadPools()),
+        _envelopeThreadPool(AcquireThreadPool(_sharedThreadPools, &SharedThreadPools::envelopeThreadPool)),
+        _tileThreadPool(AcquireThreadPool(_sharedThreadPools, &SharedThreadPools::tileThreadPool)),
         _options(std::make_shared<Options>(_envelopeThreadPool, _tileThreadPool)),
         _layers(std::make_shared<Layers>(_envelopeThreadPool, _tileThreadPool, _options)),
         _mapRenderer(std::make_shared<MapRenderer>(_layers, _options)),
@@ -64,8 +104,12 @@ namespace carto {
     BaseMapView::~BaseMapView() {
         // Set stop flag and detach every thread, once the thread quits
         // all objects they hold will be released
-        _envelopeThreadPool->deinit();
-        _tileThreadPool->deinit();
+        if (_sharedThreadPools) {
+            ReleaseSharedThreadPools();
+        } else {
+            _envelopeThreadPool->deinit();
+            _tileThreadPool->deinit();
+        }
         _mapRenderer->deinit();
         _touchHandler->deinit();
     }
@@ -284,6 +328,18 @@ namespace carto {
         _envelopeThreadPool->cancelAll();
         _tileThreadPool->cancelAll();
     }
+
+    Variant BaseMapView::getThreadPoolStatistics() const {
+        std::map<std::string, Variant> statistics;
+        statistics["envelope"] = GetThreadPoolStatistics(*_envelopeThreadPool);
+        statistics["tile"] = GetThreadPoolStatistics(*_tileThreadPool);
+        return Variant(statistics);
+    }
+
+    void BaseMapView::resetThreadPoolStatistics() {
+        _envelopeThreadPool->resetStatistics();
+        _tileThreadPool->resetStatistics();
+    }
     
     void BaseMapView::clearPreloadingCaches() {
         for (const std::shared_ptr<Layer>& layer : _layers->getAll()) {
@@ -301,6 +357,10 @@ namespace carto {
         }
     }
     
+    void BaseMapView::onMemoryWarning(bool critical) {
+        MemoryGovernor::GetInstance().onMemoryWarning(critical);
+    }
+    
     const std::shared_ptr<Layers>& BaseMapView::getLayers() const {
         return _layers;
     }
@@ -313,4 +373,92 @@ namespace carto {
         return _mapRenderer;
     }
         
+    BaseMapView::SharedThreadPools& BaseMapView::GetSharedThreadPools() {
+        static SharedThreadPools sharedThreadPools;
+        return sharedThreadPools;
+    }
+
+    Variant BaseMapView::GetThreadPoolStatistics(const CancelableThreadPool& threadPool) {
+        CancelableThreadPool::Statistics statistics = threadPool.getStatistics();
+
+        std::vector<Variant> bucketLimits;
+        for (double bucketLimit : CancelableThreadPool::HISTOGRAM_BUCKET_LIMITS) {
+            bucketLimits.emplace_back(bucketLimit);
+        }
+
+        auto createHistogram = [&bucketLimits](const CancelableThreadPool::TimeHistogram& histogram) {
+            std::vector<Variant> bucketCounts;
+            for (long long bucketCount : histogram.bucketCounts) {
+                bucketCounts.emplace_back(bucketCount);
+            }
+            std::map<std::string, Variant> histogramMap;
+            histogramMap["count"] = Variant(histogram.sampleCount);
+            histogramMap["average"] = Variant(histogram.sampleCount > 0 ? histogram.totalTime / histogram.sampleCount : 0.0);
+            histogramMap["max"] = Variant(histogram.maxTime);
+            histogramMap["bucketLimits"] = Variant(bucketLimits);
+            histogramMap["bucketCounts"] = Variant(bucketCounts);
+            return Variant(histogramMap);
+        };
+
+        std::vector<Variant> queueDepth;
+        for (const CancelableThreadPool::QueueDepthSample& sample : statistics.queueDepth) {
+            queueDepth.emplace_back(std::vector<Variant> { Variant(sample.time), Variant(static_cast<long long>(sample.queuedTaskCount)) });
+        }
+
+        std::map<std::string, Variant> priorities;
+        for (auto it = statistics.priorityStatistics.begin(); it != statistics.priorityStatistics.end(); it++) {
+            std::map<std::string, Variant> priorityMap;
+            priorityMap["waitTime"] = createHistogram(it->second.waitTime);
+            priorityMap["runTime"] = createHistogram(it->second.runTime);
+            priorities[std::to_string(it->first)] = Variant(priorityMap);
+        }
+
+        std::map<std::string, Variant> statisticsMap;
+        statisticsMap["poolSize"] = Variant(static_cast<long long>(statistics.poolSize));
+        statisticsMap["workerCount"] = Variant(static_cast<long long>(statistics.workerCount));
+        statisticsMap["queuedTaskCount"] = Variant(static_cast<long long>(statistics.queuedTaskCount));
+        statisticsMap["maxQueuedTaskCount"] = Variant(static_cast<long long>(statistics.maxQueuedTaskCount));
+        statisticsMap["queueDepth"] = Variant(queueDepth);
+        statisticsMap["completedTaskCount"] = Variant(statistics.completedTaskCount);
+        statisticsMap["canceledBeforeStartCount"] = Variant(statistics.canceledBeforeStartCount);
+        statisticsMap["canceledAfterStartCount"] = Variant(statistics.canceledAfterStartCount);
+        statisticsMap["workerUtilization"] = Variant(static_cast<double>(statistics.workerUtilization));
+        statisticsMap["priorities"] = Variant(priorities);
+        return Variant(statisticsMap);
+    }
+
+    std::shared_ptr<CancelableThreadPool> BaseMapView::AcquireThreadPool(bool shared, std::shared_ptr<CancelableThreadPool> SharedThreadPools::* threadPool) {
+        if (!shared) {
+            return std::make_shared<CancelableThreadPool>();
+        }
+
+        SharedThreadPools& sharedThreadPools = GetSharedThreadPools();
+        std::lock_guard<std::mutex> lock(sharedThreadPools.mutex);
+        if (threadPool == &SharedThreadPools::envelopeThreadPool) {
+            sharedThreadPools.viewCount++; // each view acquires both pools, count it only once
+        }
+        std::shared_ptr<CancelableThreadPool>& sharedThreadPool = sharedThreadPools.*threadPool;
+        if (!sharedThreadPool) {
+            sharedThreadPool = std::make_shared<CancelableThreadPool>();
+        }
+        return sharedThreadPool;
+    }
+
+    void BaseMapView::ReleaseSharedThreadPools() {
+        // The pools are stopped once the last map view using them is destroyed
+        SharedThreadPools& sharedThreadPools = GetSharedThreadPools();
+        std::lock_guard<std::mutex> lock(sharedThreadPools.mutex);
+        if (--sharedThreadPools.viewCount > 0) {
+            return;
+        }
+        if (sharedThreadPools.envelopeThreadPool) {
+            sharedThreadPools.envelopeThreadPool->deinit();
+            sharedThreadPools.envelopeThreadPool.reset();
+        }
+        if (sharedThreadPools.tileThreadPool) {
+            sharedThreadPools.tileThreadPool->deinit();
+            sharedThreadPools.tileThreadPool.reset();
+        }
+    }
+
 }
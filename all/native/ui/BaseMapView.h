@@ -7,6 +7,8 @@
 #ifndef _CARTO_BASEMAPVIEW_H_
 #define _CARTO_BASEMAPVIEW_H_
 
+#include "core/Variant.h"
+
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -46,6 +48,48 @@ namespace carto {
          * @return The SDK version and build info.
          */
         static std::string GetSDKVersion();
+
+        /**
+         * Returns the global memory budget shared by the tile caches of all layers and data sources.
+         * @return The global memory budget in bytes. 0 if the budget is not set.
+         */
+        static std::size_t GetMemoryBudget();
+        /**
+         * Sets the global memory budget shared by the tile caches of all layers and data sources.
+         * The budget is distributed between the caches based on the layer memory weights, no cache
+         * receives more than its own capacity. If 0, each cache uses its own capacity. The default is 0.
+         * @param budgetInBytes The new global memory budget in bytes.
+         */
+        static void SetMemoryBudget(std::size_t budgetInBytes);
+        /**
+         * Returns the global GPU memory budget of all map views.
+         * @return The GPU memory budget in bytes. 0 if the budget is not set.
+         */
+        static std::size_t GetGPUMemoryBudget();
+        /**
+         * Sets the global GPU memory budget of all map views. When the textures, vertex buffers and frame buffers
+         * of the map views exceed the budget, the preloading caches are released as on moderate memory warnings.
+         * If 0, GPU memory usage is not limited. The default is 0.
+         * @param budgetInBytes The new GPU memory budget in bytes.
+         */
+        static void SetGPUMemoryBudget(std::size_t budgetInBytes);
+
+        /**
+         * Returns true if new map views share the envelope and tile thread pools with other map views.
+         * @return True if the thread pools are shared.
+         */
+        static bool IsSharedThreadPools();
+        /**
+         * Enables or disables sharing of the envelope and tile thread pools between map views.
+         * Applications showing multiple maps at the same time (for example, a main map with mini-maps)
+         * can use a single set of worker threads for all views instead of creating separate threads for each view.
+         * The setting affects only map views created after this call. Thread pool sizes set via Options
+         * apply to all map views sharing the pools, and cancelAllTasks cancels the tasks of all these map views.
+         * Tile caches can be shared as well by using the same data source instances in the layers of all views.
+         * The default is false.
+         * @param enabled True if the thread pools should be shared.
+         */
+        static void SetSharedThreadPools(bool enabled);
         
         BaseMapView();
         virtual ~BaseMapView();
@@ -342,6 +386,20 @@ namespace carto {
          * may continue until they finish. Tasks that are added after this method call are not affected.
          */
         void cancelAllTasks();
+
+        /**
+         * Returns the statistics of the envelope and tile thread pools, for tuning the thread pool sizes.
+         * The result is an object with keys "envelope" and "tile". Each pool object contains the pool size,
+         * the worker count, the current and maximum queue depth, the queue depth over time, task counts
+         * (completed, canceled before and after start), worker utilization and wait and run time histograms
+         * (in milliseconds) per task priority.
+         * @return The thread pool statistics.
+         */
+        Variant getThreadPoolStatistics() const;
+        /**
+         * Resets the statistics of the envelope and tile thread pools.
+         */
+        void resetThreadPoolStatistics();
     
         /**
          * Releases the memory occupied by the preloading area. Calling this method releases some
@@ -355,8 +413,24 @@ namespace carto {
          * including the visible area.
          */
         void clearAllCaches();
+
+        /**
+         * Releases cache memory in response to an OS memory warning. On moderate warnings preloading caches are released,
+         * on critical warnings also the data source memory caches and texture caches.
+         * The caches of all map views are affected.
+         * @param critical True if the warning is critical.
+         */
+        void onMemoryWarning(bool critical);
     
     private:
+        struct SharedThreadPools;
+
+        static SharedThreadPools& GetSharedThreadPools();
+        static std::shared_ptr<CancelableThreadPool> AcquireThreadPool(bool shared, std::shared_ptr<CancelableThreadPool> SharedThreadPools::* threadPool);
+        static void ReleaseSharedThreadPools();
+        static Variant GetThreadPoolStatistics(const CancelableThreadPool& threadPool);
+
+        const bool _sharedThreadPools;
         std::shared_ptr<CancelableThreadPool> _envelopeThreadPool;
         std::shared_ptr<CancelableThreadPool> _tileThreadPool;
         std::shared_ptr<Options> _options;
@@ -0,0 +1,189 @@
+#include "HeadlessMapRenderer.h"
+#include "components/Exceptions.h"
+#include "core/MapBounds.h"
+#include "core/MapPos.h"
+#include "core/ScreenBounds.h"
+#include "core/ScreenPos.h"
+#include "graphics/Bitmap.h"
+#include "renderers/MapRenderer.h"
+#include "renderers/RedrawRequestListener.h"
+#include "renderers/RendererCaptureListener.h"
+#include "renderers/utils/GLContext.h"
+#include "renderers/utils/GLResourceManager.h"
+#include "renderers/utils/FrameBuffer.h"
+#include "ui/BaseMapView.h"
+#include "utils/Log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <vector>
+
+namespace carto {
+
+    class HeadlessMapRenderer::RedrawListener : public RedrawRequestListener {
+    public:
+        RedrawListener() : _redrawRequested(false), _condition(), _mutex() { }
+
+        virtual void onRedrawRequested() const {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _redrawRequested = true;
+            _condition.notify_all();
+        }
+
+        void waitRedraw(const std::chrono::steady_clock::time_point& deadline) {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait_until(lock, deadline, [this] { return _redrawRequested; });
+            _redrawRequested = false;
+        }
+
+    private:
+        mutable bool _redrawRequested;
+        mutable std::condition_variable _condition;
+        mutable std::mutex _mutex;
+    };
+
+    class HeadlessMapRenderer::CaptureListener : public RendererCaptureListener {
+    public:
+        CaptureListener() : _bitmap(), _canceled(false), _mutex() { }
+
+        virtual void onMapRendered(const std::shared_ptr<Bitmap>& bitmap) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_canceled) {
+                _bitmap = bitmap;
+            }
+        }
+
+        std::shared_ptr<Bitmap> getBitmap() const {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _bitmap;
+        }
+
+        void cancel() {
+            // Requests that timed out stay queued in the renderer, ignore their late results
+            std::lock_guard<std::mutex> lock(_mutex);
+            _canceled = true;
+        }
+
+    private:
+        std::shared_ptr<Bitmap> _bitmap;
+        bool _canceled;
+        mutable std::mutex _mutex;
+    };
+
+    HeadlessMapRenderer::HeadlessMapRenderer() :
+        _mapView(std::make_shared<BaseMapView>()),
+        _redrawListener(std::make_shared<RedrawListener>()),
+        _frameBuffer(),
+        _surfaceCreated(false),
+        _timeout(DEFAULT_TIMEOUT),
+        _mutex()
+    {
+        _mapView->setRedrawRequestListener(_redrawListener);
+    }
+
+    HeadlessMapRenderer::~HeadlessMapRenderer() {
+        _frameBuffer.reset();
+        if (_surfaceCreated) {
+            _mapView->onSurfaceDestroyed();
+        }
+        _mapView->setRedrawRequestListener(std::shared_ptr<RedrawRequestListener>());
+    }
+
+    const std::shared_ptr<Layers>& HeadlessMapRenderer::getLayers() const {
+        return _mapView->getLayers();
+    }
+
+    const std::shared_ptr<Options>& HeadlessMapRenderer::getOptions() const {
+        return _mapView->getOptions();
+    }
+
+    int HeadlessMapRenderer::getTimeout() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _timeout;
+    }
+
+    void HeadlessMapRenderer::setTimeout(int timeout) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _timeout = std::max(0, timeout);
+    }
+
+    std::shared_ptr<Bitmap> HeadlessMapRenderer::renderImage(const MapPos& focusPos, float zoom, float tilt, float rotation, int width, int height) {
+        if (width <= 0 || height <= 0) {
+            throw InvalidArgumentException("Invalid image size");
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        prepareSurface(width, height);
+        _mapView->setFocusPos(focusPos, 0);
+        _mapView->setZoom(zoom, 0);
+        _mapView->setTilt(tilt, 0);
+        _mapView->setRotation(rotation, 0);
+        return captureImage();
+    }
+
+    std::shared_ptr<Bitmap> HeadlessMapRenderer::renderImage(const MapBounds& mapBounds, int padding, int width, int height) {
+        if (width <= 0 || height <= 0) {
+            throw InvalidArgumentException("Invalid image size");
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        prepareSurface(width, height);
+        float maxPadding = std::max(0.0f, std::min(width, height) * 0.5f - 1.0f);
+        float offset = std::min(static_cast<float>(std::max(0, padding)), maxPadding);
+        ScreenBounds screenBounds(ScreenPos(offset, offset), ScreenPos(width - offset, height - offset));
+        _mapView->moveToFitBounds(mapBounds, screenBounds, false, true, true, 0);
+        return captureImage();
+    }
+
+    void HeadlessMapRenderer::prepareSurface(int width, int height) {
+        // Note: _mutex must be locked by the caller
+        if (!_surfaceCreated) {
+            _mapView->onSurfaceCreated();
+            _surfaceCreated = true;
+        }
+        if (!_frameBuffer || _frameBuffer->getWidth() != width || _frameBuffer->getHeight() != height) {
+            _mapView->onSurfaceChanged(width, height);
+            _frameBuffer = _mapView->getMapRenderer()->getGLResourceManager()->create<FrameBuffer>(width, height, true, true, true);
+        }
+    }
+
+    std::shared_ptr<Bitmap> HeadlessMapRenderer::captureImage() {
+        // Note: _mutex must be locked by the caller
+        auto captureListener = std::make_shared<CaptureListener>();
+        _mapView->getMapRenderer()->captureRendering(captureListener, true);
+
+        GLint prevFBOId = 0;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevFBOId);
+        glBindFramebuffer(GL_FRAMEBUFFER, _frameBuffer->getFBOId());
+
+        // Draw frames only when the renderer requests them (for example, when new tiles are loaded), until the capture is done
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(_timeout);
+        std::shared_ptr<Bitmap> bitmap;
+        while (true) {
+            _mapView->onDrawFrame();
+            bitmap = captureListener->getBitmap();
+            if (bitmap) {
+                break;
+            }
+
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (now >= deadline) {
+                Log::Warn("HeadlessMapRenderer::captureImage: Timeout while waiting for the layers, rendering the available data");
+                captureListener->cancel();
+                std::vector<unsigned char> data(4 * _frameBuffer->getWidth() * _frameBuffer->getHeight());
+                glReadPixels(0, 0, _frameBuffer->getWidth(), _frameBuffer->getHeight(), GL_RGBA, GL_UNSIGNED_BYTE, data.data());
+                bitmap = std::make_shared<Bitmap>(data.data(), _frameBuffer->getWidth(), _frameBuffer->getHeight(), ColorFormat::COLOR_FORMAT_RGBA, -4 * _frameBuffer->getWidth());
+                break;
+            }
+            _redrawListener->waitRedraw(std::min(deadline, now + std::chrono::milliseconds(FRAME_INTERVAL)));
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(prevFBOId));
+        return bitmap;
+    }
+
+    const int HeadlessMapRenderer::DEFAULT_TIMEOUT = 30000;
+    const int HeadlessMapRenderer::FRAME_INTERVAL = 100;
+
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_HEADLESSMAPRENDERER_H_
+#define _CARTO_HEADLESSMAPRENDERER_H_
+
+#include <memory>
+#include <mutex>
+
+namespace carto {
+    class BaseMapView;
+    class Bitmap;
+    class FrameBuffer;
+    class Layers;
+    class MapBounds;
+    class MapPos;
+    class Options;
+
+    /**
+     * A map renderer for creating static map images without a visible map view.
+     * The map is rendered into an offscreen frame buffer and the image is returned once all
+     * layers have finished loading the data for the requested view. Successive images
+     * reuse the loaded tiles, the graphics resources and the frame buffer (if the image size does not change),
+     * so rendering a batch of images (for example, route previews or list thumbnails) is much faster than
+     * driving an interactive map view.
+     * All rendering methods must be called from the same thread, with a current OpenGL ES context
+     * (for example, a pbuffer context created by the application). The renderer should also be released from this thread,
+     * as the graphics resources are released when the renderer is destroyed.
+     */
+    class HeadlessMapRenderer {
+    public:
+        /**
+         * Constructs a new headless map renderer with empty layers and default options.
+         */
+        HeadlessMapRenderer();
+        virtual ~HeadlessMapRenderer();
+
+        /**
+         * Returns the Layers object, that can be used for adding and removing map layers.
+         * @return The Layers object.
+         */
+        const std::shared_ptr<Layers>& getLayers() const;
+        /**
+         * Returns the Options object, that can be used for modifying various map options.
+         * @return The Options object.
+         */
+        const std::shared_ptr<Options>& getOptions() const;
+
+        /**
+         * Returns the maximum time to wait for the data of a single image.
+         * @return The maximum time in milliseconds.
+         */
+        int getTimeout() const;
+        /**
+         * Sets the maximum time to wait for the data of a single image. If the layers have not finished loading
+         * when the time is spent, the image is rendered with the data available. The default is 30000.
+         * @param timeout The maximum time in milliseconds.
+         */
+        void setTimeout(int timeout);
+
+        /**
+         * Renders the map with the given camera parameters.
+         * @param focusPos The focus position of the camera. The coordinate system of the position must be the same as specified in the base projection.
+         * @param zoom The zoom level of the camera.
+         * @param tilt The tilt angle of the camera in degrees.
+         * @param rotation The rotation angle of the camera in degrees.
+         * @param width The width of the image in pixels.
+         * @param height The height of the image in pixels.
+         * @return The rendered image or null if rendering failed.
+         * @throws std::invalid_argument If the image size is not positive.
+         */
+        std::shared_ptr<Bitmap> renderImage(const MapPos& focusPos, float zoom, float tilt, float rotation, int width, int height);
+        /**
+         * Renders the map so that the given bounds fit into the image.
+         * @param mapBounds The bounds to fit. The coordinate system of the bounds must be the same as specified in the base projection.
+         * @param padding The padding around the bounds in pixels.
+         * @param width The width of the image in pixels.
+         * @param height The height of the image in pixels.
+         * @return The rendered image or null if rendering failed.
+         * @throws std::invalid_argument If the image size is not positive.
+         */
+        std::shared_ptr<Bitmap> renderImage(const MapBounds& mapBounds, int padding, int width, int height);
+
+    private:
+        class RedrawListener;
+        class CaptureListener;
+
+        void prepareSurface(int width, int height);
+        std::shared_ptr<Bitmap> captureImage();
+
+        static const int DEFAULT_TIMEOUT;
+        static const int FRAME_INTERVAL;
+
+        std::shared_ptr<BaseMapView> _mapView;
+        std::shared_ptr<RedrawListener> _redrawListener;
+        std::shared_ptr<FrameBuffer> _frameBuffer;
+        bool _surfaceCreated;
+        int _timeout;
+
+        mutable std::mutex _mutex;
+    };
+
+}
+
+#endif
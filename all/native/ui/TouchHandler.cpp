@@ -38,6 +38,11 @@ namespace carto {
         _mapRenderer(mapRenderer),
         _mapRendererListener(),
         _mutex(),
+        _pendingMove(false),
+        _pendingMoveScreenPos1(0, 0),
+        _pendingMoveScreenPos2(0, 0),
+        _pendingMoveMutex(),
+        _touchEventMutex(),
         _onTouchListeners(),
         _onTouchListenersMutex()
     {
@@ -82,6 +87,25 @@ namespace carto {
             }
         }
 
+        // Pointer moves are coalesced and applied once per frame by the render thread, other events are handled immediately
+        if (action == ACTION_MOVE) {
+            {
+                std::lock_guard<std::mutex> lock(_pendingMoveMutex);
+                _pendingMove = true;
+                _pendingMoveScreenPos1 = screenPos1;
+                _pendingMoveScreenPos2 = screenPos2;
+            }
+            _mapRenderer->requestRedraw();
+            return;
+        }
+
+        applyPendingMove();
+        handleTouchEvent(action, screenPos1, screenPos2);
+    }
+
+    void TouchHandler::handleTouchEvent(int action, const ScreenPos& screenPos1, const ScreenPos& screenPos2) {
+        std::lock_guard<std::mutex> touchEventLock(_touchEventMutex);
+
         ViewState viewState = _mapRenderer->getViewState();
         switch (action) {
         case ACTION_POINTER_1_DOWN:
@@ -286,6 +310,20 @@ namespace carto {
         }
     }
     
+    void TouchHandler::applyPendingMove() {
+        ScreenPos screenPos1, screenPos2;
+        {
+            std::lock_guard<std::mutex> lock(_pendingMoveMutex);
+            if (!_pendingMove) {
+                return;
+            }
+            _pendingMove = false;
+            screenPos1 = _pendingMoveScreenPos1;
+            screenPos2 = _pendingMoveScreenPos2;
+        }
+        handleTouchEvent(ACTION_MOVE, screenPos1, screenPos2);
+    }
+
     void TouchHandler::checkMapStable() {
         bool stable = false;
         {
@@ -659,6 +697,12 @@ namespace carto {
     TouchHandler::MapRendererListener::MapRendererListener(const std::shared_ptr<TouchHandler>& touchHandler) : _touchHandler(touchHandler) {
     }
     
+    void TouchHandler::MapRendererListener::onBeforeDrawFrame() {
+        if (auto touchHandler = _touchHandler.lock()) {
+            touchHandler->applyPendingMove();
+        }
+    }
+
     void TouchHandler::MapRendererListener::onMapChanged() {
         if (auto touchHandler = _touchHandler.lock()) {
             {
@@ -73,6 +73,8 @@ namespace carto {
         class MapRendererListener : public MapRenderer::OnChangeListener {
         public:
             explicit MapRendererListener(const std::shared_ptr<TouchHandler>& touchHandler);
+
+            virtual void onBeforeDrawFrame();
             
             virtual void onMapChanged();
             virtual void onMapIdle();
@@ -81,6 +83,9 @@ namespace carto {
             std::weak_ptr<TouchHandler> _touchHandler;
         };
         
+        void handleTouchEvent(int action, const ScreenPos& screenPos1, const ScreenPos& screenPos2);
+        void applyPendingMove();
+
         void checkMapStable();
 
         float calculateRotatingScalingFactor(const ScreenPos& screenPos1, const ScreenPos& screenPos2) const;
@@ -158,6 +163,12 @@ namespace carto {
     
         mutable std::mutex _mutex;
 
+        bool _pendingMove;
+        ScreenPos _pendingMoveScreenPos1;
+        ScreenPos _pendingMoveScreenPos2;
+        mutable std::mutex _pendingMoveMutex;
+        mutable std::mutex _touchEventMutex;
+
         std::vector<std::shared_ptr<OnTouchListener> > _onTouchListeners;
         mutable std::mutex _onTouchListenersMutex;
     };
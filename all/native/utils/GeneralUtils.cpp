@@ -1,5 +1,7 @@
 #include "GeneralUtils.h"
 
+#include <cctype>
+#include <cmath>
 #include <sstream>
 
 namespace carto {
@@ -93,6 +95,36 @@ namespace carto {
         return str;
     }
 
+    std::string GeneralUtils::NormalizeWhitespace(const std::string& str) {
+        std::string normalizedStr;
+        normalizedStr.reserve(str.size());
+        for (char c : str) {
+            if (std::isspace(static_cast<unsigned char>(c))) {
+                if (!normalizedStr.empty() && normalizedStr.back() != ' ') {
+                    normalizedStr += ' ';
+                }
+            } else {
+                normalizedStr += c;
+            }
+        }
+        if (!normalizedStr.empty() && normalizedStr.back() == ' ') {
+            normalizedStr.erase(normalizedStr.size() - 1);
+        }
+        return normalizedStr;
+    }
+
+    double GeneralUtils::RoundDecimals(double value, int decimals) {
+        if (decimals < 0 || !std::isfinite(value)) {
+            return value;
+        }
+        double scale = std::pow(10.0, decimals);
+        double roundedValue = std::round(value * scale) / scale;
+        if (!std::isfinite(roundedValue)) {
+            return value; // too large to be scaled, no fractional part to round anyway
+        }
+        return roundedValue == 0 ? 0.0 : roundedValue; // avoid negative zero
+    }
+
     GeneralUtils::GeneralUtils() {
     }
 
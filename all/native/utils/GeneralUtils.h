@@ -36,6 +36,12 @@ namespace carto {
 
         static std::string Join(const std::vector<std::string>& strs, char delim);
 
+        // Trims leading and trailing whitespace and collapses inner whitespace runs to single spaces
+        static std::string NormalizeWhitespace(const std::string& str);
+
+        // Rounds the value to the given number of decimal places, negative decimal count keeps the value as is
+        static double RoundDecimals(double value, int decimals);
+
     private:
         GeneralUtils();
     };
@@ -74,16 +74,11 @@ namespace carto {
     }
     
     bool GeomUtils::PointInsidePolygon(const std::vector<MapPos>& polygon, const MapPos& point) {
-        float c = IsConvexPolygonClockwise(polygon) ? -1.0f : 1.0f;
-        for (std::size_t i = 0; i < polygon.size(); i++) {
-            const MapPos& v1 = polygon[i];
-            const MapPos& v2 = polygon[(i + 1) % polygon.size()];
-            double d = (v2 - v1).crossProduct2D(point - v1);
-            if (c * d > 0) {
-                return false;
-            }
-        }
-        return true;
+        return PointsInsideConvexPolygon(polygon, &point, 1);
+    }
+    
+    bool GeomUtils::PointsInsidePolygon(const std::vector<MapPos>& polygon, const std::vector<MapPos>& points) {
+        return PointsInsideConvexPolygon(polygon, points.data(), points.size());
     }
     
     MapPos GeomUtils::CalculatePointInsidePolygon(const std::vector<MapPos>& polygon, const std::vector<std::vector<MapPos> >& holes) {
@@ -205,16 +200,38 @@ namespace carto {
         return h;
     }
     
+    bool GeomUtils::PointsInsideConvexPolygon(const std::vector<MapPos>& polygon, const MapPos* points, std::size_t count) {
+        // Orientation is calculated once for all points, the inner loop is branchless over plain coordinates
+        double c = IsConvexPolygonClockwise(polygon) ? -1.0 : 1.0;
+        for (std::size_t i = 0; i < polygon.size(); i++) {
+            const MapPos& v1 = polygon[i];
+            const MapPos& v2 = polygon[i + 1 < polygon.size() ? i + 1 : 0];
+            double ex = (v2.getX() - v1.getX()) * c;
+            double ey = (v2.getY() - v1.getY()) * c;
+            bool outside = false;
+            for (std::size_t j = 0; j < count; j++) {
+                double d = ex * (points[j].getY() - v1.getY()) - ey * (points[j].getX() - v1.getX());
+                outside |= d > 0;
+            }
+            if (outside) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     bool GeomUtils::PointsInsidePolygonEdges(const std::vector<MapPos>& polygon, const std::vector<MapPos>& points) {
-        float c = IsConvexPolygonClockwise(polygon) ? -1.0f : 1.0f;
+        // Check that no edge of the polygon separates the points from the polygon
+        double c = IsConvexPolygonClockwise(polygon) ? -1.0 : 1.0;
         for (std::size_t i = 0; i < polygon.size(); i++) {
             const MapPos& v1 = polygon[i];
-            const MapPos& v2 = polygon[(i + 1) % polygon.size()];
+            const MapPos& v2 = polygon[i + 1 < polygon.size() ? i + 1 : 0];
+            double ex = (v2.getX() - v1.getX()) * c;
+            double ey = (v2.getY() - v1.getY()) * c;
             bool inside = false;
-            for (std::size_t j = 0; j < polygon.size(); j++) {
-                MapPos v3(polygon[j]);
-                double d = ((v2 - v1).crossProduct2D(v3 - v1));
-                if (c * d >= 0) {
+            for (std::size_t j = 0; j < points.size(); j++) {
+                double d = ex * (points[j].getY() - v1.getY()) - ey * (points[j].getX() - v1.getX());
+                if (d <= 0) {
                     inside = true;
                     break;
                 }
@@ -7,6 +7,7 @@
 #ifndef _CARTO_GEOMUTILS_H_
 #define _CARTO_GEOMUTILS_H_
 
+#include <cstddef>
 #include <vector>
 
 namespace carto {
@@ -29,6 +30,8 @@ namespace carto {
         static bool IsConcavePolygonClockwise(const std::vector<MapPos>& polygon);
     
         static bool PointInsidePolygon(const std::vector<MapPos>& polygon, const MapPos& point);
+
+        static bool PointsInsidePolygon(const std::vector<MapPos>& polygon, const std::vector<MapPos>& points);
     
         static MapPos CalculatePointInsidePolygon(const std::vector<MapPos>& polygon, const std::vector<std::vector<MapPos> >& holes);
         
@@ -41,6 +44,8 @@ namespace carto {
     private:
         GeomUtils();
 
+        static bool PointsInsideConvexPolygon(const std::vector<MapPos>& polygon, const MapPos* points, std::size_t count);
+
         static bool PointsInsidePolygonEdges(const std::vector<MapPos>& polygon, const std::vector<MapPos>& points);
     };
     
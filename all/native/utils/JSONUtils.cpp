@@ -0,0 +1,106 @@
+#include "JSONUtils.h"
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <rapidjson/rapidjson.h>
+#include <rapidjson/reader.h>
+#include <rapidjson/error/en.h>
+
+namespace {
+
+    class PicoJSONHandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, PicoJSONHandler> {
+    public:
+        PicoJSONHandler() : _result(), _stack(), _keys() { }
+
+        picojson::value& result() { return _result; }
+
+        bool Null() { return add(picojson::value()); }
+        bool Bool(bool b) { return add(picojson::value(b)); }
+        bool Int(int i) { return add(picojson::value(static_cast<std::int64_t>(i))); }
+        bool Uint(unsigned int u) { return add(picojson::value(static_cast<std::int64_t>(u))); }
+        bool Int64(std::int64_t i) { return add(picojson::value(i)); }
+        bool Uint64(std::uint64_t u) {
+            if (u > static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) {
+                return add(picojson::value(static_cast<double>(u)));
+            }
+            return add(picojson::value(static_cast<std::int64_t>(u)));
+        }
+        bool Double(double d) { return add(picojson::value(d)); }
+        bool String(const char* str, rapidjson::SizeType length, bool copy) { return add(picojson::value(std::string(str, length))); }
+
+        bool Key(const char* str, rapidjson::SizeType length, bool copy) {
+            _keys.emplace_back(str, length);
+            return true;
+        }
+
+        bool StartObject() {
+            _stack.emplace_back(picojson::object_type, false);
+            return true;
+        }
+
+        bool EndObject(rapidjson::SizeType memberCount) {
+            return endContainer();
+        }
+
+        bool StartArray() {
+            _stack.emplace_back(picojson::array_type, false);
+            return true;
+        }
+
+        bool EndArray(rapidjson::SizeType elementCount) {
+            return endContainer();
+        }
+
+    private:
+        bool endContainer() {
+            picojson::value value(std::move(_stack.back()));
+            _stack.pop_back();
+            return add(std::move(value));
+        }
+
+        bool add(picojson::value value) {
+            if (_stack.empty()) {
+                _result = std::move(value);
+            } else if (_stack.back().is<picojson::value::array>()) {
+                _stack.back().get<picojson::value::array>().push_back(std::move(value));
+            } else {
+                _stack.back().get<picojson::value::object>()[_keys.back()] = std::move(value);
+                _keys.pop_back();
+            }
+            return true;
+        }
+
+        picojson::value _result;
+        std::vector<picojson::value> _stack;
+        std::vector<std::string> _keys;
+    };
+
+}
+
+namespace carto {
+
+    std::string JSONUtils::ParsePicoJSON(picojson::value& value, const std::string& json) {
+        PicoJSONHandler handler;
+        rapidjson::StringStream stream(json.c_str());
+        rapidjson::Reader reader;
+        rapidjson::ParseResult result = reader.Parse<rapidjson::kParseFullPrecisionFlag>(stream, handler);
+        if (!result) {
+            return std::string(rapidjson::GetParseError_En(result.Code())) + " at offset " + std::to_string(result.Offset());
+        }
+        value = std::move(handler.result());
+        return std::string();
+    }
+
+    picojson::value JSONUtils::ToPicoJSON(const rapidjson::Value& value) {
+        PicoJSONHandler handler;
+        value.Accept(handler);
+        return std::move(handler.result());
+    }
+
+    JSONUtils::JSONUtils() {
+    }
+
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_JSONUTILS_H_
+#define _CARTO_JSONUTILS_H_
+
+#include <string>
+
+#include <picojson/picojson.h>
+
+#include <rapidjson/document.h>
+
+namespace carto {
+
+    /**
+     * Fast JSON parsing into PicoJSON values.
+     * The input is parsed with the rapidjson SAX reader and the PicoJSON value tree is built directly from the parser
+     * events, avoiding the character-level parsing and intermediate copies of picojson::parse.
+     */
+    class JSONUtils {
+    public:
+        // Drop-in replacement for picojson::parse. Returns an empty string on success and the error message otherwise.
+        static std::string ParsePicoJSON(picojson::value& value, const std::string& json);
+
+        // Converts an already parsed rapidjson value without serializing and reparsing it
+        static picojson::value ToPicoJSON(const rapidjson::Value& value);
+
+    private:
+        JSONUtils();
+    };
+
+}
+
+#endif
@@ -41,42 +41,34 @@ namespace carto {
 #endif
 
     bool Log::IsShowError() {
-        std::lock_guard<std::mutex> lock(_Mutex);
         return _ShowError;
     }
 
     void Log::SetShowError(bool showError) {
-        std::lock_guard<std::mutex> lock(_Mutex);
         _ShowError = showError;
     }
 
     bool Log::IsShowWarn() {
-        std::lock_guard<std::mutex> lock(_Mutex);
         return _ShowWarn;
     }
 
     void Log::SetShowWarn(bool showWarn) {
-        std::lock_guard<std::mutex> lock(_Mutex);
         _ShowWarn = showWarn;
     }
 
     bool Log::IsShowInfo() {
-        std::lock_guard<std::mutex> lock(_Mutex);
         return _ShowInfo;
     }
 
     void Log::SetShowInfo(bool showInfo) {
-        std::lock_guard<std::mutex> lock(_Mutex);
         _ShowInfo = showInfo;
     }
 
     bool Log::IsShowDebug() {
-        std::lock_guard<std::mutex> lock(_Mutex);
         return _ShowDebug;
     }
 
     void Log::SetShowDebug(bool showDebug) {
-        std::lock_guard<std::mutex> lock(_Mutex);
         _ShowDebug = showDebug;
     }
 
@@ -96,6 +88,7 @@ namespace carto {
     
     void Log::SetLogEventListener(const std::shared_ptr<LogEventListener>& listener) {
         _LogEventListener.set(listener);
+        _HasLogEventListener = static_cast<bool>(listener);
     }
 
     void Log::Fatal(const char* message) {
@@ -118,8 +111,8 @@ namespace carto {
             }
         }
 
-        std::lock_guard<std::mutex> lock(_Mutex);
         if (_ShowError) {
+            std::lock_guard<std::mutex> lock(_Mutex);
             OutputLog(LOG_TYPE_ERROR, _Tag, message);
         }
     }
@@ -132,8 +125,8 @@ namespace carto {
             }
         }
 
-        std::lock_guard<std::mutex> lock(_Mutex);
         if (_ShowWarn) {
+            std::lock_guard<std::mutex> lock(_Mutex);
             OutputLog(LOG_TYPE_WARNING, _Tag, message);
         }
     }
@@ -146,13 +139,14 @@ namespace carto {
             }
         }
 
-        std::lock_guard<std::mutex> lock(_Mutex);
         if (_ShowInfo) {
+            std::lock_guard<std::mutex> lock(_Mutex);
             OutputLog(LOG_TYPE_INFO, _Tag, message);
         }
     }
 
     void Log::Debug(const char* message) {
+#ifndef _CARTO_DISABLE_DEBUG_LOG
         DirectorPtr<LogEventListener> logEventListener = _LogEventListener;
         if (logEventListener) {
             if (!logEventListener->onDebugEvent(message)) {
@@ -160,19 +154,21 @@ namespace carto {
             }
         }
 
-        std::lock_guard<std::mutex> lock(_Mutex);
         if (_ShowDebug) {
+            std::lock_guard<std::mutex> lock(_Mutex);
             OutputLog(LOG_TYPE_DEBUG, _Tag, message);
         }
+#endif
     }
 
     Log::Log() {
     }
 
-    bool Log::_ShowError = true;
-    bool Log::_ShowWarn = true;
-    bool Log::_ShowInfo = true;
-    bool Log::_ShowDebug = false;
+    std::atomic<bool> Log::_ShowError(true);
+    std::atomic<bool> Log::_ShowWarn(true);
+    std::atomic<bool> Log::_ShowInfo(true);
+    std::atomic<bool> Log::_ShowDebug(false);
+    std::atomic<bool> Log::_HasLogEventListener(false);
 
     std::string Log::_Tag = "carto-mobile-sdk";
 
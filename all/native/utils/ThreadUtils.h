@@ -21,10 +21,36 @@ namespace carto {
         };
     }
 
+    namespace ThreadRole {
+        /**
+         * The role of a thread, used to select the platform scheduling class of the thread.
+         */
+        enum ThreadRole {
+            /**
+             * Threads that directly block frame rendering.
+             */
+            RENDER_CRITICAL,
+            /**
+             * Threads whose results are needed for the currently visible map (culling, label placement, click handling).
+             */
+            INTERACTIVE,
+            /**
+             * Threads that prefetch or load data in background (tile loading, cache writing).
+             */
+            BACKGROUND,
+            /**
+             * Long running bulk work that must not compete with the other roles (package downloads and imports).
+             */
+            BULK
+        };
+    }
+
     class ThreadUtils {
     public:
         static void SetThreadPriority(ThreadPriority::ThreadPriority priority);
 
+        static void SetThreadRole(ThreadRole::ThreadRole role);
+
     private:
         ThreadUtils();
     };
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_TRACEUTILS_H_
+#define _CARTO_TRACEUTILS_H_
+
+#include <cstdint>
+
+namespace carto {
+
+    /**
+     * Emits platform trace markers, visible in the platform profilers:
+     * ATrace sections on Android (systrace/Perfetto), signpost intervals on iOS (Instruments)
+     * and TraceLogging events on Windows (ETW).
+     * Markers are emitted only if the SDK is compiled with _CARTO_TRACE_SUPPORT, see CARTO_TRACE_SECTION.
+     */
+    class TraceUtils {
+    public:
+        static bool IsEnabled();
+
+        // Returns the platform specific section id that must be passed to EndSection
+        static std::uint64_t BeginSection(const char* name);
+        static void EndSection(const char* name, std::uint64_t sectionId);
+
+    private:
+        TraceUtils();
+    };
+
+    /**
+     * Trace section that is ended when the object goes out of scope.
+     * The name must be a string with static lifetime.
+     */
+    class TraceSection {
+    public:
+        explicit TraceSection(const char* name) : _name(name), _sectionId(TraceUtils::BeginSection(name)) { }
+        ~TraceSection() { TraceUtils::EndSection(_name, _sectionId); }
+
+    private:
+        TraceSection(const TraceSection&);
+        TraceSection& operator = (const TraceSection&);
+
+        const char* _name;
+        std::uint64_t _sectionId;
+    };
+
+}
+
+#ifdef _CARTO_TRACE_SUPPORT
+#define _CARTO_TRACE_CONCAT_IMPL(a, b) a##b
+#define _CARTO_TRACE_CONCAT(a, b) _CARTO_TRACE_CONCAT_IMPL(a, b)
+#define CARTO_TRACE_SECTION(name) carto::TraceSection _CARTO_TRACE_CONCAT(_traceSection, __LINE__)(name)
+#else
+#define CARTO_TRACE_SECTION(name)
+#endif
+
+#endif
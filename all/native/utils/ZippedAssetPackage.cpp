@@ -11,13 +11,18 @@
 #include <miniz.c>
 #include <string.h>
 
+#include <algorithm>
+
 namespace carto {
 
     ZippedAssetPackage::ZippedAssetPackage(const std::shared_ptr<BinaryData>& zipData) :
         _zipData(zipData),
         _baseAssetPackage(),
         _handle(),
-        _assetIndexMap()
+        _assetNames(),
+        _assetIndexMap(),
+        _assetCache(ASSET_CACHE_SIZE),
+        _memoryConsumer()
     {
         initialize();
     }
@@ -26,7 +31,10 @@ namespace carto {
         _zipData(zipData),
         _baseAssetPackage(baseAssetPackage),
         _handle(),
-        _assetIndexMap()
+        _assetNames(),
+        _assetIndexMap(),
+        _assetCache(ASSET_CACHE_SIZE),
+        _memoryConsumer()
     {
         initialize();
     }
@@ -38,14 +46,7 @@ namespace carto {
     std::vector<std::string> ZippedAssetPackage::getLocalAssetNames() const {
         std::lock_guard<std::mutex> lock(_mutex);
 
-        std::vector<std::string> names;
-        names.reserve(_assetIndexMap.size());
-        for (auto it = _assetIndexMap.begin(); it != _assetIndexMap.end(); it++) {
-            if (std::find(names.begin(), names.end(), it->first) == names.end()) {
-                names.push_back(it->first);
-            }
-        }
-        return names;
+        return _assetNames;
     }
     
     std::vector<std::string> ZippedAssetPackage::getAssetNames() const {
@@ -55,10 +56,10 @@ namespace carto {
         if (_baseAssetPackage) {
             names = _baseAssetPackage->getAssetNames();
         }
-        names.reserve(names.size() + _assetIndexMap.size());
-        for (auto it = _assetIndexMap.begin(); it != _assetIndexMap.end(); it++) {
-            if (std::find(names.begin(), names.end(), it->first) == names.end()) {
-                names.push_back(it->first);
+        names.reserve(names.size() + _assetNames.size());
+        for (const std::string& name : _assetNames) {
+            if (std::find(names.begin(), names.end(), name) == names.end()) {
+                names.push_back(name);
             }
         }
         return names;
@@ -75,6 +76,11 @@ namespace carto {
             return std::shared_ptr<BinaryData>();
         }
 
+        std::shared_ptr<BinaryData> assetData;
+        if (_assetCache.read(name, assetData)) {
+            return assetData;
+        }
+
         mz_zip_archive* zip = static_cast<mz_zip_archive*>(_handle.get());
         if (!zip) {
             return std::shared_ptr<BinaryData>();
@@ -86,7 +92,11 @@ namespace carto {
             Log::Error("ZippedAssetPackage::loadAsset: Could not load archive asset");
             return std::shared_ptr<BinaryData>();
         }
-        return std::make_shared<BinaryData>(elementData.get(), elementSize);
+        assetData = std::make_shared<BinaryData>(elementData.get(), elementSize, elementData);
+        if (elementSize <= _assetCache.capacity()) {
+            _assetCache.put(name, assetData, elementSize);
+        }
+        return assetData;
     }
 
     void ZippedAssetPackage::initialize() {
@@ -97,8 +107,7 @@ namespace carto {
         _handle = std::make_shared<mz_zip_archive>();
         mz_zip_archive* zip = static_cast<mz_zip_archive*>(_handle.get());
         memset(zip, 0, sizeof(mz_zip_archive));
-        std::shared_ptr<std::vector<unsigned char> > data = _zipData->getDataPtr();
-        if (!mz_zip_reader_init_mem(zip, data->data(), data->size(), 0)) {
+        if (!mz_zip_reader_init_mem(zip, _zipData->data(), _zipData->size(), 0)) {
             throw GenericException("Could not open ZIP archive");
         }
     
@@ -108,16 +117,36 @@ namespace carto {
                 throw GenericException("Could not read ZIP archive file stats");
             }
     
+            if (_assetIndexMap.find(stat.m_filename) == _assetIndexMap.end()) {
+                _assetNames.push_back(stat.m_filename);
+            }
             _assetIndexMap[stat.m_filename] = i;
         }
+        std::sort(_assetNames.begin(), _assetNames.end());
+
+        _memoryConsumer = MemoryGovernor::GetInstance().registerConsumer(ASSET_CACHE_SIZE, 1.0f,
+            [this](std::size_t budget) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _assetCache.resize(budget);
+            },
+            [this](bool critical) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _assetCache.clear();
+            }
+        );
     }
 
     void ZippedAssetPackage::deinitialize() {
+        if (_memoryConsumer) {
+            _memoryConsumer->detach();
+        }
         mz_zip_archive* zip = static_cast<mz_zip_archive*>(_handle.get());
         if (zip) {
             mz_zip_reader_end(zip);
         }
         _handle.reset();
     }
+
+    const std::size_t ZippedAssetPackage::ASSET_CACHE_SIZE = 4 * 1024 * 1024;
     
 }
@@ -7,15 +7,22 @@
 #ifndef _CARTO_ZIPPEDASSETPACKAGE_H_
 #define _CARTO_ZIPPEDASSETPACKAGE_H_
 
+#include "components/MemoryGovernor.h"
 #include "utils/AssetPackage.h"
 
 #include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <stdext/timed_lru_cache.h>
 
 namespace carto {
 
     /**
      * An asset package based on ZIP archived.
      * Only deflate-based ZIP archives are supported.
+     * The archive directory is indexed once and recently used assets are kept decompressed.
      */
     class ZippedAssetPackage : public AssetPackage {
     public:
@@ -39,13 +46,18 @@ namespace carto {
         virtual std::shared_ptr<BinaryData> loadAsset(const std::string& name) const;
     
     private:
+        static const std::size_t ASSET_CACHE_SIZE;
+
         void initialize();
         void deinitialize();
 
         const std::shared_ptr<BinaryData> _zipData;
         const std::shared_ptr<AssetPackage> _baseAssetPackage;
         std::shared_ptr<void> _handle;
-        std::map<std::string, unsigned int> _assetIndexMap;
+        std::vector<std::string> _assetNames; // sorted
+        std::unordered_map<std::string, unsigned int> _assetIndexMap;
+        mutable cache::timed_lru_cache<std::string, std::shared_ptr<BinaryData> > _assetCache; // decompressed assets
+        std::shared_ptr<MemoryGovernor::Consumer> _memoryConsumer;
 
         mutable std::mutex _mutex;
     };
@@ -16,6 +16,7 @@
 
 #include <cmath>
 #include <algorithm>
+#include <sstream>
 
 namespace carto {
     
@@ -278,6 +279,43 @@ namespace carto {
         
             // Calculate the maximum popup size, adjust with dpi
             int maxPopupWidth = std::min(screenWidth, screenHeight);
+
+            // Triangle offset is the only part of the bitmap that depends on the anchor position
+            auto calculateTriangleOffsetX = [&](float halfPopupWidth) {
+                int triangleOffsetX = 0;
+                if (screenPos.getX() + halfPopupWidth + screenPadding > screenWidth) {
+                    triangleOffsetX = halfPopupWidth - (screenWidth - screenPos.getX()) + screenPadding;
+                } else if (screenPos.getX() - halfPopupWidth - screenPadding < 0) {
+                    triangleOffsetX = screenPos.getX() - halfPopupWidth - screenPadding;
+                }
+            
+                int maxHalfOffsetX = static_cast<int>(halfPopupWidth - triangleWidth * 0.5f - _style->getCornerRadius() - strokeWidth * 0.5f);
+                return std::min(maxHalfOffsetX, std::max(-maxHalfOffsetX, triangleOffsetX));
+            };
+
+            // Reuse the bitmap rendered for the same content, if the triangle position matches
+            std::stringstream keyStream;
+            keyStream << _style.get() << '\n' << dpToPX << '\n' << maxPopupWidth << '\n' << _buttons.size();
+            for (const std::shared_ptr<BalloonPopupButton>& button : _buttons) {
+                keyStream << '\n' << button.get();
+            }
+            keyStream << '\n' << title.size() << '\n' << title << '\n' << desc;
+            std::string bitmapKey = keyStream.str();
+
+            RenderedBitmap renderedBitmap;
+            bool cached = false;
+            {
+                std::lock_guard<std::mutex> cacheLock(_BitmapCacheMutex);
+                cached = _BitmapCache.read(bitmapKey, renderedBitmap);
+            }
+            if (cached && calculateTriangleOffsetX(renderedBitmap.bitmap->getWidth() * 0.5f) == renderedBitmap.triangleOffsetX) {
+                _buttonRects = renderedBitmap.buttonRects;
+
+                lock.unlock();
+                setAnchorPoint(renderedBitmap.triangleOffsetX / (renderedBitmap.bitmap->getWidth() * 0.5f), -1);
+
+                return renderedBitmap.bitmap;
+            }
         
             // Calcualate maximum title and description width
             int leftMarginWidth = leftMargins.getLeft() + leftMargins.getRight() + leftImageWidth;
@@ -363,15 +401,7 @@ namespace carto {
                                         ScreenPos(popupWidth - halfStrokeWidth, popupHeight - triangleStrokeOffset));
         
             // Calculate anchor point and triangle position
-            int triangleOffsetX = 0;
-            if (screenPos.getX() + halfPopupWidth + screenPadding > screenWidth) {
-                triangleOffsetX = halfPopupWidth - (screenWidth - screenPos.getX()) + screenPadding;
-            } else if (screenPos.getX() - halfPopupWidth - screenPadding < 0) {
-                triangleOffsetX = screenPos.getX() - halfPopupWidth - screenPadding;
-            }
-        
-            int maxHalfOffsetX = static_cast<int>(halfPopupWidth - halfTriangleWidth - _style->getCornerRadius() - halfStrokeWidth);
-            triangleOffsetX = std::min(maxHalfOffsetX, std::max(-maxHalfOffsetX, triangleOffsetX));
+            int triangleOffsetX = calculateTriangleOffsetX(halfPopupWidth);
         
             // Prepare triangle path
             float triangleOriginX = triangleOffsetX + halfPopupWidth - halfTriangleWidth;
@@ -462,11 +492,23 @@ namespace carto {
                 _buttonRects[button] = buttonRect;
             }
 
-            // Done with internal state, update anchor point and build bitmap
+            std::shared_ptr<Bitmap> bitmap = canvas.buildBitmap();
+            if (bitmap) {
+                renderedBitmap.bitmap = bitmap;
+                renderedBitmap.triangleOffsetX = triangleOffsetX;
+                renderedBitmap.buttonRects = _buttonRects;
+                renderedBitmap.style = _style;
+                renderedBitmap.buttons = _buttons;
+
+                std::lock_guard<std::mutex> cacheLock(_BitmapCacheMutex);
+                _BitmapCache.put(bitmapKey, renderedBitmap, bitmap->getPixelData().size() + bitmapKey.size());
+            }
+
+            // Done with internal state, update anchor point and return bitmap
             lock.unlock();
             setAnchorPoint(triangleOffsetX / halfPopupWidth, -1);
 
-            return canvas.buildBitmap();
+            return bitmap;
         }
         catch (const std::exception& ex) {
             Log::Errorf("BalloonPopup::drawBitmap: Failed to render bitmap: %s", ex.what());
@@ -525,5 +567,10 @@ namespace carto {
     const int BalloonPopup::SCREEN_PADDING = 10;
 
     const int BalloonPopup::MAX_CANVAS_SIZE = 8192;
+
+    const std::size_t BalloonPopup::BITMAP_CACHE_SIZE = 4 * 1024 * 1024;
+
+    cache::timed_lru_cache<std::string, BalloonPopup::RenderedBitmap> BalloonPopup::_BitmapCache(BITMAP_CACHE_SIZE);
+    std::mutex BalloonPopup::_BitmapCacheMutex;
        
 }
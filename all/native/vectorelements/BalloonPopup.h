@@ -11,7 +11,13 @@
 #include "components/DirectorPtr.h"
 #include "vectorelements/Popup.h"
 
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <stdext/timed_lru_cache.h>
 
 namespace carto {
     class BitmapCanvas;
@@ -131,11 +137,25 @@ namespace carto {
                                                    float screenWidth, float screenHeight, float dpToPX);
         
     private:
+        struct RenderedBitmap {
+            std::shared_ptr<Bitmap> bitmap;
+            int triangleOffsetX;
+            std::map<std::shared_ptr<BalloonPopupButton>, ScreenBounds> buttonRects;
+            std::shared_ptr<BalloonPopupStyle> style; // keeps the style and buttons used in the key alive
+            std::vector<std::shared_ptr<BalloonPopupButton> > buttons;
+
+            RenderedBitmap() : bitmap(), triangleOffsetX(0), buttonRects(), style(), buttons() { }
+        };
+
         ScreenBounds measureButtonSize(const std::shared_ptr<BalloonPopupButton>& button, float dpToPX) const;
         void drawButtonOnCanvas(const std::shared_ptr<BalloonPopupButton>& button, BitmapCanvas& canvas, const ScreenBounds& bounds, float dpToPX) const;
 
         static const int SCREEN_PADDING;
         static const int MAX_CANVAS_SIZE;
+        static const std::size_t BITMAP_CACHE_SIZE;
+
+        static cache::timed_lru_cache<std::string, RenderedBitmap> _BitmapCache; // shared between all balloon popups
+        static std::mutex _BitmapCacheMutex;
 
         std::shared_ptr<BalloonPopupStyle> _style;
         
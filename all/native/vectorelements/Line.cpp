@@ -9,7 +9,10 @@ namespace carto {
 
     Line::Line(const std::shared_ptr<LineGeometry>& geometry, const std::shared_ptr<LineStyle>& style) :
         VectorElement(geometry),
-        _style(style)
+        _drawData(),
+        _drawDataDirty(true),
+        _style(style),
+        _visibleRange(0, 1)
     {
         if (!geometry) {
             throw NullArgumentException("Null geometry");
@@ -21,7 +24,10 @@ namespace carto {
         
     Line::Line(std::vector<MapPos> poses, const std::shared_ptr<LineStyle>& style) :
         VectorElement(std::make_shared<LineGeometry>(std::move(poses))),
-        _style(style)
+        _drawData(),
+        _drawDataDirty(true),
+        _style(style),
+        _visibleRange(0, 1)
     {
         if (!style) {
             throw NullArgumentException("Null style");
@@ -44,6 +50,7 @@ namespace carto {
         {
             std::lock_guard<std::recursive_mutex> lock(_mutex);
             _geometry = geometry;
+            _drawDataDirty = true;
         }
         notifyElementChanged();
     }
@@ -56,6 +63,7 @@ namespace carto {
         {
             std::lock_guard<std::recursive_mutex> lock(_mutex);
             _geometry = std::make_shared<LineGeometry>(poses);
+            _drawDataDirty = true;
         }
         notifyElementChanged();
     
@@ -74,6 +82,20 @@ namespace carto {
         {
             std::lock_guard<std::recursive_mutex> lock(_mutex);
             _style = style;
+            _drawDataDirty = true;
+        }
+        notifyElementChanged();
+    }
+        
+    MapRange Line::getVisibleRange() const {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return _visibleRange;
+    }
+
+    void Line::setVisibleRange(const MapRange& range) {
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            _visibleRange = range;
         }
         notifyElementChanged();
     }
@@ -87,5 +109,12 @@ namespace carto {
         std::lock_guard<std::recursive_mutex> lock(_mutex);
         _drawData = drawData;
     }
+
+    bool Line::testAndClearDrawDataDirty() {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        bool dirty = _drawDataDirty;
+        _drawDataDirty = false;
+        return dirty;
+    }
     
 }
@@ -7,6 +7,7 @@
 #ifndef _CARTO_LINE_H_
 #define _CARTO_LINE_H_
 
+#include "core/MapRange.h"
 #include "vectorelements/VectorElement.h"
 
 #include <vector>
@@ -64,6 +65,20 @@ namespace carto {
          * @param style The new style that defines what this line looks like.
          */
         void setStyle(const std::shared_ptr<LineStyle>& style);
+
+        /**
+         * Returns the visible range of this line.
+         * @return The visible range of this line, as fractions of the line length.
+         */
+        MapRange getVisibleRange() const;
+        /**
+         * Sets the visible range of this line. Only the part of the line between the range minimum and maximum is drawn.
+         * Both values are fractions of the total line length, 0 is the start and 1 is the end of the line. The default range is [0, 1].
+         * Changing the range does not rebuild the vertex data of the line, so it can be updated frequently,
+         * for example to hide the already travelled part of a route on each location update.
+         * @param range The new visible range of this line.
+         */
+        void setVisibleRange(const MapRange& range);
         
         std::shared_ptr<LineDrawData> getDrawData() const;
         void setDrawData(const std::shared_ptr<LineDrawData>& drawData);
@@ -71,11 +86,17 @@ namespace carto {
     protected:
         friend class LineRenderer;
         friend class VectorLayer;
+
+        // Returns true if the geometry or style has changed since the last call
+        bool testAndClearDrawDataDirty();
     
     private:
         std::shared_ptr<LineDrawData> _drawData;
+        bool _drawDataDirty;
         
         std::shared_ptr<LineStyle> _style;
+
+        MapRange _visibleRange;
     };
     
 }
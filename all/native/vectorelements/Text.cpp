@@ -2,12 +2,14 @@
 #include "components/Exceptions.h"
 #include "graphics/Bitmap.h"
 #include "graphics/BitmapCanvas.h"
+#include "graphics/utils/TextBitmapCache.h"
 #include "styles/TextStyle.h"
 #include "utils/Const.h"
 #include "utils/Log.h"
 
 #include <cstdlib>
 #include <cmath>
+#include <sstream>
 
 namespace carto {
     
@@ -67,45 +69,55 @@ namespace carto {
             float bottomPadding = _style->getTextMargins().getBottom() * dpToPX;
             float borderPadding = (borderWidth > 0 ? 1 : 0);
 
-            BitmapCanvas measureCanvas(0, 0);
-            measureCanvas.setFont(_style->getFontName(), fontSize);
-            ScreenBounds textBounds = measureCanvas.measureTextSize(text, -1, _style->isBreakLines());
+            // Texts with identical appearance share the rasterized bitmap
+            std::stringstream keyStream;
+            keyStream << _style->getFontName() << '\n' << fontSize << '\n' << strokeWidth << '\n' << borderWidth;
+            keyStream << '\n' << leftPadding << '\n' << rightPadding << '\n' << topPadding << '\n' << bottomPadding;
+            keyStream << '\n' << _style->getFontColor().getARGB() << '\n' << _style->getStrokeColor().getARGB();
+            keyStream << '\n' << _style->getBorderColor().getARGB() << '\n' << _style->getBackgroundColor().getARGB();
+            keyStream << '\n' << _style->isBreakLines() << '\n' << text;
+
+            return TextBitmapCache::GetInstance().getBitmap(keyStream.str(), [&]() -> std::shared_ptr<Bitmap> {
+                BitmapCanvas measureCanvas(0, 0);
+                measureCanvas.setFont(_style->getFontName(), fontSize);
+                ScreenBounds textBounds = measureCanvas.measureTextSize(text, -1, _style->isBreakLines());
+
+                int canvasWidth = static_cast<int>(std::ceil(textBounds.getWidth() + strokeWidth + leftPadding + rightPadding + 2 * borderWidth + 2 * borderPadding));
+                int canvasHeight = static_cast<int>(std::ceil(textBounds.getHeight() + strokeWidth + topPadding + bottomPadding + 2 * borderWidth + 2 * borderPadding));
+                if (canvasWidth > MAX_CANVAS_SIZE || canvasHeight > MAX_CANVAS_SIZE) {
+                    Log::Errorf("Text::drawBitmap: Text too large: %d x %d!", canvasWidth, canvasHeight);
+                    return std::shared_ptr<Bitmap>();
+                }
 
-            int canvasWidth = static_cast<int>(std::ceil(textBounds.getWidth() + strokeWidth + leftPadding + rightPadding + 2 * borderWidth + 2 * borderPadding));
-            int canvasHeight = static_cast<int>(std::ceil(textBounds.getHeight() + strokeWidth + topPadding + bottomPadding + 2 * borderWidth + 2 * borderPadding));
-            if (canvasWidth > MAX_CANVAS_SIZE || canvasHeight > MAX_CANVAS_SIZE) {
-                Log::Errorf("Text::drawBitmap: Text too large: %d x %d!", canvasWidth, canvasHeight);
-                return std::shared_ptr<Bitmap>();
-            }
+                BitmapCanvas canvas(canvasWidth, canvasHeight);
+                canvas.setFont(_style->getFontName(), fontSize);
 
-            BitmapCanvas canvas(canvasWidth, canvasHeight);
-            canvas.setFont(_style->getFontName(), fontSize);
+                if (_style->getBackgroundColor() != Color()) {
+                    canvas.setColor(_style->getBackgroundColor());
+                    canvas.setDrawMode(BitmapCanvas::FILL);
+                    canvas.drawRoundRect(ScreenBounds(ScreenPos(borderPadding, borderPadding), ScreenPos(canvasWidth - borderPadding, canvasHeight - borderPadding)), 0);
+                }
 
-            if (_style->getBackgroundColor() != Color()) {
-                canvas.setColor(_style->getBackgroundColor());
-                canvas.setDrawMode(BitmapCanvas::FILL);
-                canvas.drawRoundRect(ScreenBounds(ScreenPos(borderPadding, borderPadding), ScreenPos(canvasWidth - borderPadding, canvasHeight - borderPadding)), 0);
-            }
+                if (borderWidth > 0 && _style->getBorderColor() != Color()) {
+                    canvas.setColor(_style->getBorderColor());
+                    canvas.setDrawMode(BitmapCanvas::STROKE);
+                    canvas.setStrokeWidth(borderWidth);
+                    canvas.drawRoundRect(ScreenBounds(ScreenPos(0.5f * borderWidth + borderPadding, 0.5f * borderWidth + borderPadding), ScreenPos(canvasWidth - borderPadding - 0.5f * borderWidth, canvasHeight - borderPadding - 0.5f * borderWidth)), 0);
+                }
 
-            if (borderWidth > 0 && _style->getBorderColor() != Color()) {
-                canvas.setColor(_style->getBorderColor());
-                canvas.setDrawMode(BitmapCanvas::STROKE);
-                canvas.setStrokeWidth(borderWidth);
-                canvas.drawRoundRect(ScreenBounds(ScreenPos(0.5f * borderWidth + borderPadding, 0.5f * borderWidth + borderPadding), ScreenPos(canvasWidth - borderPadding - 0.5f * borderWidth, canvasHeight - borderPadding - 0.5f * borderWidth)), 0);
-            }
+                if (strokeWidth > 0) {
+                    canvas.setColor(_style->getStrokeColor());
+                    canvas.setDrawMode(BitmapCanvas::STROKE);
+                    canvas.setStrokeWidth(strokeWidth);
+                    canvas.drawText(text, ScreenPos(borderPadding + borderWidth + leftPadding + strokeWidth * 0.5f, borderPadding + borderWidth + topPadding + strokeWidth * 0.5f), textBounds.getWidth(), _style->isBreakLines());
+                }
 
-            if (strokeWidth > 0) {
-                canvas.setColor(_style->getStrokeColor());
-                canvas.setDrawMode(BitmapCanvas::STROKE);
-                canvas.setStrokeWidth(strokeWidth);
+                canvas.setColor(_style->getFontColor());
+                canvas.setDrawMode(BitmapCanvas::FILL);
                 canvas.drawText(text, ScreenPos(borderPadding + borderWidth + leftPadding + strokeWidth * 0.5f, borderPadding + borderWidth + topPadding + strokeWidth * 0.5f), textBounds.getWidth(), _style->isBreakLines());
-            }
-
-            canvas.setColor(_style->getFontColor());
-            canvas.setDrawMode(BitmapCanvas::FILL);
-            canvas.drawText(text, ScreenPos(borderPadding + borderWidth + leftPadding + strokeWidth * 0.5f, borderPadding + borderWidth + topPadding + strokeWidth * 0.5f), textBounds.getWidth(), _style->isBreakLines());
 
-            return canvas.buildBitmap();
+                return canvas.buildBitmap();
+            });
         }
         catch (const std::exception& ex) {
             Log::Errorf("Text::drawBitmap: Failed to render bitmap: %s", ex.what());
@@ -3,6 +3,7 @@
 #include "core/MapBounds.h"
 #include "core/BinaryData.h"
 #include "core/Variant.h"
+#include "components/CancelableTask.h"
 #include "components/Exceptions.h"
 #include "geometry/Feature.h"
 #include "geometry/Geometry.h"
@@ -21,10 +22,13 @@
 #include "vectortiles/utils/ValueConverter.h"
 #include "vectortiles/utils/VTBitmapLoader.h"
 #include "vectortiles/utils/CartoCSSAssetLoader.h"
+#include "vectortiles/utils/CompiledMapCache.h"
+#include "vectortiles/utils/DecodedTileCache.h"
 #include "utils/AssetPackage.h"
 #include "utils/FileUtils.h"
 #include "utils/Const.h"
 #include "utils/Log.h"
+#include "utils/TraceUtils.h"
 
 #include <vt/Tile.h>
 #include <mapnikvt/Value.h>
@@ -44,6 +48,7 @@ namespace carto {
     
     CartoVectorTileDecoder::CartoVectorTileDecoder(const std::vector<std::string>& layerIds, const std::map<std::string, std::shared_ptr<CartoCSSStyleSet> >& layerStyleSets) :
         _logger(std::make_shared<MapnikVTLogger>("CartoVectorTileDecoder")),
+        _decodedTileCache(std::make_shared<DecodedTileCache>(DECODED_TILE_CACHE_SIZE, _logger)),
         _layerIds(layerIds),
         _layerInvisibleSet(),
         _fallbackFonts(),
@@ -148,18 +153,7 @@ namespace carto {
         }
 
         try {
-            std::shared_ptr<mvt::MBVTFeatureDecoder> decoder;
-            {
-                std::unique_lock<std::mutex> lock(_mutex);
-                if (_cachedFeatureDecoder.first != tileData) {
-                    lock.unlock();
-                    decoder = std::make_shared<mvt::MBVTFeatureDecoder>(*tileData->getDataPtr(), _logger);
-                    lock.lock();
-                    _cachedFeatureDecoder = std::make_pair(tileData, decoder);
-                } else {
-                    decoder = _cachedFeatureDecoder.second;
-                }
-            }
+            std::shared_ptr<mvt::MBVTFeatureDecoder> decoder = _decodedTileCache->getFeatureLookupDecoder(tile, tileData);
 
             std::string mvtLayerName;
             mvt::Feature mvtFeature;
@@ -202,18 +196,7 @@ namespace carto {
 
         std::vector<std::shared_ptr<VectorTileFeature> > tileFeatures;
         try {
-            std::shared_ptr<mvt::MBVTFeatureDecoder> decoder;
-            {
-                std::unique_lock<std::mutex> lock(_mutex);
-                if (_cachedFeatureDecoder.first != tileData) {
-                    lock.unlock();
-                    decoder = std::make_shared<mvt::MBVTFeatureDecoder>(*tileData->getDataPtr(), _logger);
-                    lock.lock();
-                    _cachedFeatureDecoder = std::make_pair(tileData, decoder);
-                } else {
-                    decoder = _cachedFeatureDecoder.second;
-                }
-            }
+            std::shared_ptr<mvt::MBVTFeatureDecoder> decoder = _decodedTileCache->getFeatureLookupDecoder(tile, tileData);
 
             for (const std::string& mvtLayerName : decoder->getLayerNames()) {
                 for (std::shared_ptr<mvt::FeatureDecoder::FeatureIterator> mvtIt = decoder->createLayerFeatureIterator(mvtLayerName); mvtIt->valid(); mvtIt->advance()) {
@@ -222,21 +205,28 @@ namespace carto {
                         continue;
                     }
 
-                    std::map<std::string, Variant> featureData;
-                    if (std::shared_ptr<const mvt::FeatureData> mvtFeatureData = mvtIt->getFeatureData()) {
-                        for (const std::string& varName : mvtFeatureData->getVariableNames()) {
-                            mvt::Value mvtValue;
-                            if (mvtFeatureData->getVariable(varName, mvtValue)) {
-                                featureData[varName] = boost::apply_visitor(ValueConverter(), mvtValue);
+                    std::shared_ptr<const mvt::FeatureData> mvtFeatureData = mvtIt->getFeatureData();
+                    auto propertiesLoader = [mvtFeatureData]() -> Variant {
+                        std::map<std::string, Variant> featureData;
+                        if (mvtFeatureData) {
+                            for (const std::string& varName : mvtFeatureData->getVariableNames()) {
+                                mvt::Value mvtValue;
+                                if (mvtFeatureData->getVariable(varName, mvtValue)) {
+                                    featureData[varName] = boost::apply_visitor(ValueConverter(), mvtValue);
+                                }
                             }
                         }
-                    }
+                        return Variant(featureData);
+                    };
 
-                    auto convertFn = [&tileBounds](const cglib::vec2<float>& pos) {
-                        return MapPos(tileBounds.getMin().getX() + pos(0) * tileBounds.getDelta().getX(), tileBounds.getMax().getY() - pos(1) * tileBounds.getDelta().getY(), 0);
+                    auto geometryLoader = [mvtGeometry, tileBounds]() -> std::shared_ptr<Geometry> {
+                        auto convertFn = [&tileBounds](const cglib::vec2<float>& pos) {
+                            return MapPos(tileBounds.getMin().getX() + pos(0) * tileBounds.getDelta().getX(), tileBounds.getMax().getY() - pos(1) * tileBounds.getDelta().getY(), 0);
+                        };
+                        return convertGeometry(convertFn, mvtGeometry);
                     };
 
-                    auto feature = std::make_shared<VectorTileFeature>(mvtIt->getGlobalId(), MapTile(tile.x, tile.y, tile.zoom, 0), mvtLayerName, convertGeometry(convertFn, mvtGeometry), Variant(featureData));
+                    auto feature = std::make_shared<VectorTileFeature>(mvtIt->getGlobalId(), MapTile(tile.x, tile.y, tile.zoom, 0), mvtLayerName, geometryLoader, propertiesLoader);
                     tileFeatures.push_back(feature);
                 }
             }
@@ -249,6 +239,12 @@ namespace carto {
     }
 
     std::shared_ptr<CartoVectorTileDecoder::TileMap> CartoVectorTileDecoder::decodeTile(const vt::TileId& tile, const vt::TileId& targetTile, const std::shared_ptr<vt::TileTransformer>& tileTransformer, const std::shared_ptr<BinaryData>& tileData) const {
+        return decodeTileProgressive(tile, targetTile, tileTransformer, tileData, PartialTileHandler());
+    }
+
+    std::shared_ptr<CartoVectorTileDecoder::TileMap> CartoVectorTileDecoder::decodeTileProgressive(const vt::TileId& tile, const vt::TileId& targetTile, const std::shared_ptr<vt::TileTransformer>& tileTransformer, const std::shared_ptr<BinaryData>& tileData, const PartialTileHandler& partialTileHandler) const {
+        CARTO_TRACE_SECTION("CartoVectorTileDecoder::decodeTile");
+
         if (!tileData) {
             Log::Warn("CartoVectorTileDecoder::decodeTile: Null tile data");
             return std::shared_ptr<TileMap>();
@@ -265,45 +261,38 @@ namespace carto {
         }
     
         try {
-            mvt::MBVTFeatureDecoder decoder(*tileData->getDataPtr(), _logger);
-            decoder.setTransform(calculateTileTransform(tile, targetTile));
-            decoder.setGlobalIdOverride(true, MapTile(tile.x, tile.y, tile.zoom, 0).getTileId());
-
-            std::vector<std::shared_ptr<vt::Tile> > tiles(_layerIds.size());
-            for (auto it = layerMaps.begin(); it != layerMaps.end(); it++) {
-                if (layerInvisibleSet.count(it->first) > 0) {
-                    continue;
+            std::shared_ptr<mvt::MBVTFeatureDecoder> decoder = _decodedTileCache->getFeatureDecoder(tile, tileData);
+            decoder->setTransform(calculateTileTransform(tile, targetTile));
+            decoder->setGlobalIdOverride(true, MapTile(tile.x, tile.y, tile.zoom, 0).getTileId());
+
+            // Decode the layers in style order, so that base layers (water, landuse, roads) can be shown before the layers with labels and POIs
+            std::vector<std::size_t> indices;
+            for (std::size_t i = 0; i < _layerIds.size(); i++) {
+                if (layerInvisibleSet.count(_layerIds[i]) == 0 && layerMaps.count(_layerIds[i]) > 0) {
+                    indices.push_back(i);
                 }
+            }
 
-                std::size_t index = std::distance(_layerIds.begin(), std::find(_layerIds.begin(), _layerIds.end(), it->first));
-                if (index >= tiles.size()) {
-                    continue;
+            // If called from a task, stop at layer boundaries once the task is canceled
+            const CancelableTask* task = CancelableTask::GetCurrentTask();
+
+            std::vector<std::shared_ptr<vt::Tile> > tiles(_layerIds.size());
+            for (std::size_t n = 0; n < indices.size(); n++) {
+                if (task && task->isCanceled()) {
+                    return std::shared_ptr<TileMap>();
                 }
 
-                mvt::MBVTTileReader reader(it->second, tileTransformer, *layerSymbolizerContexts[it->first], decoder);
-                reader.setLayerNameOverride(it->first);
-                tiles[index] = reader.readTile(targetTile);
-            }
+                const std::string& layerId = _layerIds[indices[n]];
+                mvt::MBVTTileReader reader(layerMaps[layerId], tileTransformer, *layerSymbolizerContexts[layerId], *decoder);
+                reader.setLayerNameOverride(layerId);
+                tiles[indices[n]] = reader.readTile(targetTile);
 
-            float tileSize = 256.0f;
-            std::shared_ptr<vt::TileBackground> tileBackground;
-            std::vector<std::shared_ptr<vt::TileLayer> > tileLayers;
-            for (std::size_t i = 0; i < tiles.size(); i++) {
-                if (std::shared_ptr<vt::Tile> tile = tiles[i]) {
-                    if (i == 0) {
-                        tileSize = tile->getTileSize();
-                        tileBackground = tile->getBackground();
-                    }
-                    for (const std::shared_ptr<vt::TileLayer>& tileLayer : tile->getLayers()) {
-                        int layerIdx = static_cast<int>(i * 65536) + tileLayer->getLayerIndex();
-                        tileLayers.push_back(std::make_shared<vt::TileLayer>(layerIdx, tileLayer->getCompOp(), tileLayer->getOpacityFunc(), tileLayer->getBitmaps(), tileLayer->getGeometries(), tileLayer->getLabels()));
-                    }
+                if (partialTileHandler && tiles[indices[n]] && n + 1 < indices.size()) {
+                    partialTileHandler(mergeLayerTiles(targetTile, tiles));
                 }
             }
 
-            auto tileMap = std::make_shared<TileMap>();
-            (*tileMap)[0] = std::make_shared<vt::Tile>(targetTile, tileSize, tileBackground, tileLayers);
-            return tileMap;
+            return mergeLayerTiles(targetTile, tiles);
         }
         catch (const std::exception& ex) {
             Log::Errorf("CartoVectorTileDecoder::decodeTile: Exception while decoding: %s", ex.what());
@@ -353,10 +342,13 @@ namespace carto {
 
         std::shared_ptr<mvt::Map> map;
         try {
-            auto assetLoader = std::make_shared<CartoCSSAssetLoader>("", assetPackage);
-            css::CartoCSSMapLoader mapLoader(assetLoader, _logger);
-            mapLoader.setIgnoreLayerPredicates(true);
-            map = mapLoader.loadMap(styleSet->getCartoCSS());
+            std::string cartoCSS = styleSet->getCartoCSS();
+            map = CompiledMapCache::GetInstance().getMap(assetPackage, "cartocss:" + cartoCSS, true, [&]() -> std::shared_ptr<mvt::Map> {
+                auto assetLoader = std::make_shared<CartoCSSAssetLoader>("", assetPackage);
+                css::CartoCSSMapLoader mapLoader(assetLoader, _logger);
+                mapLoader.setIgnoreLayerPredicates(true);
+                return mapLoader.loadMap(cartoCSS);
+            });
         }
         catch (const std::exception& ex) {
             throw ParseException(std::string("CartoCSS style parsing failed: ") + ex.what(), styleSet->getCartoCSS());
@@ -371,8 +363,31 @@ namespace carto {
         _layerSymbolizerContexts[layerId] = symbolizerContext;
     }
 
+    std::shared_ptr<CartoVectorTileDecoder::TileMap> CartoVectorTileDecoder::mergeLayerTiles(const vt::TileId& targetTile, const std::vector<std::shared_ptr<vt::Tile> >& tiles) {
+        float tileSize = 256.0f;
+        std::shared_ptr<vt::TileBackground> tileBackground;
+        std::vector<std::shared_ptr<vt::TileLayer> > tileLayers;
+        for (std::size_t i = 0; i < tiles.size(); i++) {
+            if (std::shared_ptr<vt::Tile> tile = tiles[i]) {
+                if (i == 0) {
+                    tileSize = tile->getTileSize();
+                    tileBackground = tile->getBackground();
+                }
+                for (const std::shared_ptr<vt::TileLayer>& tileLayer : tile->getLayers()) {
+                    int layerIdx = static_cast<int>(i * 65536) + tileLayer->getLayerIndex();
+                    tileLayers.push_back(std::make_shared<vt::TileLayer>(layerIdx, tileLayer->getCompOp(), tileLayer->getOpacityFunc(), tileLayer->getBitmaps(), tileLayer->getGeometries(), tileLayer->getLabels()));
+                }
+            }
+        }
+
+        auto tileMap = std::make_shared<TileMap>();
+        (*tileMap)[0] = std::make_shared<vt::Tile>(targetTile, tileSize, tileBackground, tileLayers);
+        return tileMap;
+    }
+
     const int CartoVectorTileDecoder::DEFAULT_TILE_SIZE = 256;
     const int CartoVectorTileDecoder::STROKEMAP_SIZE = 512;
     const int CartoVectorTileDecoder::GLYPHMAP_SIZE = 2048;
     const std::size_t CartoVectorTileDecoder::MAX_ASSETPACKAGE_SYMBOLIZER_CONTEXTS = 4;
+    const std::size_t CartoVectorTileDecoder::DECODED_TILE_CACHE_SIZE = 4 * 1024 * 1024;
 }
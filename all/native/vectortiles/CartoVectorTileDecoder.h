@@ -27,6 +27,7 @@ namespace carto {
     }
 
     class AssetPackage;
+    class DecodedTileCache;
     class CartoCSSStyleSet;
     
     /**
@@ -91,16 +92,22 @@ namespace carto {
         virtual std::shared_ptr<VectorTileFeatureCollection> decodeFeatures(const vt::TileId& tile, const std::shared_ptr<BinaryData>& tileData, const MapBounds& tileBounds) const;
 
         virtual std::shared_ptr<TileMap> decodeTile(const vt::TileId& tile, const vt::TileId& targetTile, const std::shared_ptr<vt::TileTransformer>& tileTransformer, const std::shared_ptr<BinaryData>& tileData) const;
+
+        virtual std::shared_ptr<TileMap> decodeTileProgressive(const vt::TileId& tile, const vt::TileId& targetTile, const std::shared_ptr<vt::TileTransformer>& tileTransformer, const std::shared_ptr<BinaryData>& tileData, const PartialTileHandler& partialTileHandler) const;
     
     protected:
         void updateLayerStyleSet(const std::string& layerId, const std::shared_ptr<CartoCSSStyleSet>& styleSet);
 
+        static std::shared_ptr<TileMap> mergeLayerTiles(const vt::TileId& targetTile, const std::vector<std::shared_ptr<vt::Tile> >& tiles);
+
         static const int DEFAULT_TILE_SIZE;
         static const int STROKEMAP_SIZE;
         static const int GLYPHMAP_SIZE;
         static const std::size_t MAX_ASSETPACKAGE_SYMBOLIZER_CONTEXTS;
+        static const std::size_t DECODED_TILE_CACHE_SIZE;
         
         const std::shared_ptr<mvt::Logger> _logger;
+        const std::shared_ptr<DecodedTileCache> _decodedTileCache;
         const std::vector<std::string> _layerIds;
         std::set<std::string> _layerInvisibleSet;
         std::vector<std::shared_ptr<BinaryData> > _fallbackFonts;
@@ -110,8 +117,6 @@ namespace carto {
         std::map<std::shared_ptr<AssetPackage>, std::shared_ptr<mvt::SymbolizerContext> > _assetPackageSymbolizerContexts;
         std::shared_ptr<mvt::Map::Settings> _mapSettings;
 
-        mutable std::pair<std::shared_ptr<BinaryData>, std::shared_ptr<mvt::MBVTFeatureDecoder> > _cachedFeatureDecoder;
-    
         mutable std::mutex _mutex;
     };
         
@@ -3,6 +3,7 @@
 #include "core/MapBounds.h"
 #include "core/BinaryData.h"
 #include "core/Variant.h"
+#include "components/CancelableTask.h"
 #include "components/Exceptions.h"
 #include "geometry/Feature.h"
 #include "geometry/Geometry.h"
@@ -22,10 +23,13 @@
 #include "vectortiles/utils/MapnikVTLogger.h"
 #include "vectortiles/utils/VTBitmapLoader.h"
 #include "vectortiles/utils/CartoCSSAssetLoader.h"
+#include "vectortiles/utils/CompiledMapCache.h"
+#include "vectortiles/utils/DecodedTileCache.h"
 #include "utils/AssetPackage.h"
 #include "utils/FileUtils.h"
 #include "utils/Const.h"
 #include "utils/Log.h"
+#include "utils/TraceUtils.h"
 
 #include <vt/Tile.h>
 #include <mapnikvt/Value.h>
@@ -36,6 +40,7 @@
 #include <mapnikvt/MapParser.h>
 #include <cartocss/CartoCSSMapLoader.h>
 
+#include <atomic>
 #include <functional>
 
 #include <boost/lexical_cast.hpp>
@@ -45,6 +50,7 @@ namespace carto {
     
     MBVectorTileDecoder::MBVectorTileDecoder(const std::shared_ptr<CompiledStyleSet>& compiledStyleSet) :
         _logger(std::make_shared<MapnikVTLogger>("MBVectorTileDecoder")),
+        _decodedTileCache(std::make_shared<DecodedTileCache>(DECODED_TILE_CACHE_SIZE, _logger)),
         _featureIdOverride(false),
         _cartoCSSLayerNamesIgnored(false),
         _layerNameOverride(),
@@ -54,7 +60,8 @@ namespace carto {
         _map(),
         _mapSettings(),
         _symbolizerContext(),
-        _assetPackageSymbolizerContexts()
+        _assetPackageSymbolizerContexts(),
+        _decoderState()
     {
         if (!compiledStyleSet) {
             throw NullArgumentException("Null compiledStyleSet");
@@ -65,6 +72,7 @@ namespace carto {
     
     MBVectorTileDecoder::MBVectorTileDecoder(const std::shared_ptr<CartoCSSStyleSet>& cartoCSSStyleSet) :
         _logger(std::make_shared<MapnikVTLogger>("MBVectorTileDecoder")),
+        _decodedTileCache(std::make_shared<DecodedTileCache>(DECODED_TILE_CACHE_SIZE, _logger)),
         _featureIdOverride(false),
         _cartoCSSLayerNamesIgnored(false),
         _layerNameOverride(),
@@ -72,7 +80,10 @@ namespace carto {
         _fallbackFonts(),
         _styleSet(),
         _map(),
-        _symbolizerContext()
+        _mapSettings(),
+        _symbolizerContext(),
+        _assetPackageSymbolizerContexts(),
+        _decoderState()
     {
         if (!cartoCSSStyleSet) {
             throw NullArgumentException("Null cartoCSSStyleSet");
@@ -126,28 +137,28 @@ namespace carto {
     }
 
     std::vector<std::string> MBVectorTileDecoder::getStyleParameters() const {
-        std::lock_guard<std::mutex> lock(_mutex);
+        std::shared_ptr<const DecoderState> state = getDecoderState();
     
         std::vector<std::string> params;
-        for (auto it = _map->getNutiParameterMap().begin(); it != _map->getNutiParameterMap().end(); it++) {
+        for (auto it = state->map->getNutiParameterMap().begin(); it != state->map->getNutiParameterMap().end(); it++) {
             params.push_back(it->first);
         }
         return params;
     }
 
     std::string MBVectorTileDecoder::getStyleParameter(const std::string& param) const {
-        std::lock_guard<std::mutex> lock(_mutex);
+        std::shared_ptr<const DecoderState> state = getDecoderState();
 
-        auto it = _map->getNutiParameterMap().find(param);
-        if (it == _map->getNutiParameterMap().end()) {
+        auto it = state->map->getNutiParameterMap().find(param);
+        if (it == state->map->getNutiParameterMap().end()) {
             throw InvalidArgumentException("Could not find parameter");
         }
         const mvt::NutiParameter& nutiParam = it->second;
         
         mvt::Value value = nutiParam.getDefaultValue();
         {
-            auto it2 = _parameterValueMap.find(param);
-            if (it2 != _parameterValueMap.end()) {
+            auto it2 = state->parameterValueMap.find(param);
+            if (it2 != state->parameterValueMap.end()) {
                 value = it2->second;
             }
         }
@@ -183,16 +194,16 @@ namespace carto {
             }
             const mvt::NutiParameter& nutiParam = it->second;
 
+            mvt::Value val = nutiParam.getDefaultValue();
             if (!nutiParam.getEnumMap().empty()) {
                 auto it2 = nutiParam.getEnumMap().find(value);
                 if (it2 == nutiParam.getEnumMap().end()) {
                     Log::Errorf("MBVectorTileDecoder::setStyleParameter: Illegal enum value for parameter: %s/%s", param.c_str(), value.c_str());
                     return false;
                 }
-                _parameterValueMap[param] = it2->second;
+                val = it2->second;
             } else {
                 try {
-                    mvt::Value val = nutiParam.getDefaultValue();
                     if (boost::get<bool>(&val)) {
                         if (value == "true") {
                             val = mvt::Value(true);
@@ -208,7 +219,6 @@ namespace carto {
                     } else if (boost::get<std::string>(&val)) {
                         val = value;
                     }
-                    _parameterValueMap[param] = val;
                 }
                 catch (const std::exception& ex) {
                     Log::Errorf("MBVectorTileDecoder::setStyleParameter: Exception while converting parameter %s/%s: %s", param.c_str(), value.c_str(), ex.what());
@@ -216,26 +226,34 @@ namespace carto {
                 }
             }
 
+            // Setting the current value again does not change the style, thus the tiles are kept
+            auto it3 = _parameterValueMap.find(param);
+            if (it3 != _parameterValueMap.end() && it3->second == val) {
+                return true;
+            }
+            _parameterValueMap[param] = val;
+
             std::map<std::string, mvt::Value> parameterValueMap = _symbolizerContext->getSettings().getNutiParameterValueMap();
             for (auto it2 = _parameterValueMap.begin(); it2 != _parameterValueMap.end(); it2++) {
                 parameterValueMap[it2->first] = it2->second;
             }
             mvt::SymbolizerContext::Settings settings(_symbolizerContext->getSettings().getTileSize(), parameterValueMap, _symbolizerContext->getSettings().getFallbackFont());
             _symbolizerContext = std::make_shared<mvt::SymbolizerContext>(_symbolizerContext->getBitmapManager(), _symbolizerContext->getFontManager(), _symbolizerContext->getStrokeMap(), _symbolizerContext->getGlyphMap(), settings);
+            publishDecoderState();
         }
         notifyDecoderChanged();
         return true;
     }
 
     bool MBVectorTileDecoder::isFeatureIdOverride() const {
-        std::lock_guard<std::mutex> lock(_mutex);
-        return _featureIdOverride;
+        return getDecoderState()->featureIdOverride;
     }
 
     void MBVectorTileDecoder::setFeatureIdOverride(bool idOverride) {
         {
             std::lock_guard<std::mutex> lock(_mutex);
             _featureIdOverride = idOverride;
+            publishDecoderState();
         }
         notifyDecoderChanged();
     }
@@ -256,21 +274,20 @@ namespace carto {
     }
         
     std::string MBVectorTileDecoder::getLayerNameOverride() const {
-        std::lock_guard<std::mutex> lock(_mutex);
-        return _layerNameOverride;
+        return getDecoderState()->layerNameOverride;
     }
 
     void MBVectorTileDecoder::setLayerNameOverride(const std::string& name) {
         {
             std::lock_guard<std::mutex> lock(_mutex);
             _layerNameOverride = name;
+            publishDecoderState();
         }
         notifyDecoderChanged();
     }
 
     std::shared_ptr<mvt::Map::Settings> MBVectorTileDecoder::getMapSettings() const {
-        std::lock_guard<std::mutex> lock(_mutex);
-        return _mapSettings;
+        return getDecoderState()->mapSettings;
     }
 
     void MBVectorTileDecoder::addFallbackFont(const std::shared_ptr<BinaryData>& fontData) {
@@ -300,18 +317,7 @@ namespace carto {
         }
 
         try {
-            std::shared_ptr<mvt::MBVTFeatureDecoder> decoder;
-            {
-                std::unique_lock<std::mutex> lock(_mutex);
-                if (_cachedFeatureDecoder.first != tileData) {
-                    lock.unlock();
-                    decoder = std::make_shared<mvt::MBVTFeatureDecoder>(*tileData->getDataPtr(), _logger);
-                    lock.lock();
-                    _cachedFeatureDecoder = std::make_pair(tileData, decoder);
-                } else {
-                    decoder = _cachedFeatureDecoder.second;
-                }
-            }
+            std::shared_ptr<mvt::MBVTFeatureDecoder> decoder = _decodedTileCache->getFeatureLookupDecoder(tile, tileData);
 
             std::string mvtLayerName;
             mvt::Feature mvtFeature;
@@ -354,18 +360,7 @@ namespace carto {
 
         std::vector<std::shared_ptr<VectorTileFeature> > tileFeatures;
         try {
-            std::shared_ptr<mvt::MBVTFeatureDecoder> decoder;
-            {
-                std::unique_lock<std::mutex> lock(_mutex);
-                if (_cachedFeatureDecoder.first != tileData) {
-                    lock.unlock();
-                    decoder = std::make_shared<mvt::MBVTFeatureDecoder>(*tileData->getDataPtr(), _logger);
-                    lock.lock();
-                    _cachedFeatureDecoder = std::make_pair(tileData, decoder);
-                } else {
-                    decoder = _cachedFeatureDecoder.second;
-                }
-            }
+            std::shared_ptr<mvt::MBVTFeatureDecoder> decoder = _decodedTileCache->getFeatureLookupDecoder(tile, tileData);
 
             for (const std::string& mvtLayerName : decoder->getLayerNames()) {
                 for (std::shared_ptr<mvt::FeatureDecoder::FeatureIterator> mvtIt = decoder->createLayerFeatureIterator(mvtLayerName); mvtIt->valid(); mvtIt->advance()) {
@@ -374,21 +369,30 @@ namespace carto {
                         continue;
                     }
 
-                    std::map<std::string, Variant> featureData;
-                    if (std::shared_ptr<const mvt::FeatureData> mvtFeatureData = mvtIt->getFeatureData()) {
-                        for (const std::string& varName : mvtFeatureData->getVariableNames()) {
-                            mvt::Value mvtValue;
-                            if (mvtFeatureData->getVariable(varName, mvtValue)) {
-                                featureData[varName] = boost::apply_visitor(ValueConverter(), mvtValue);
+                    // Geometry and properties are converted only when accessed, callers often need just a few features
+                    // or can reject features based on their properties alone
+                    std::shared_ptr<const mvt::FeatureData> mvtFeatureData = mvtIt->getFeatureData();
+                    auto propertiesLoader = [mvtFeatureData]() -> Variant {
+                        std::map<std::string, Variant> featureData;
+                        if (mvtFeatureData) {
+                            for (const std::string& varName : mvtFeatureData->getVariableNames()) {
+                                mvt::Value mvtValue;
+                                if (mvtFeatureData->getVariable(varName, mvtValue)) {
+                                    featureData[varName] = boost::apply_visitor(ValueConverter(), mvtValue);
+                                }
                             }
                         }
-                    }
+                        return Variant(featureData);
+                    };
 
-                    auto convertFn = [&tileBounds](const cglib::vec2<float>& pos) {
-                        return MapPos(tileBounds.getMin().getX() + pos(0) * tileBounds.getDelta().getX(), tileBounds.getMax().getY() - pos(1) * tileBounds.getDelta().getY(), 0);
+                    auto geometryLoader = [mvtGeometry, tileBounds]() -> std::shared_ptr<Geometry> {
+                        auto convertFn = [&tileBounds](const cglib::vec2<float>& pos) {
+                            return MapPos(tileBounds.getMin().getX() + pos(0) * tileBounds.getDelta().getX(), tileBounds.getMax().getY() - pos(1) * tileBounds.getDelta().getY(), 0);
+                        };
+                        return convertGeometry(convertFn, mvtGeometry);
                     };
 
-                    auto feature = std::make_shared<VectorTileFeature>(mvtIt->getGlobalId(), MapTile(tile.x, tile.y, tile.zoom, 0), mvtLayerName, convertGeometry(convertFn, mvtGeometry), Variant(featureData));
+                    auto feature = std::make_shared<VectorTileFeature>(mvtIt->getGlobalId(), MapTile(tile.x, tile.y, tile.zoom, 0), mvtLayerName, geometryLoader, propertiesLoader);
                     tileFeatures.push_back(feature);
                 }
             }
@@ -401,30 +405,28 @@ namespace carto {
     }
 
     std::shared_ptr<MBVectorTileDecoder::TileMap> MBVectorTileDecoder::decodeTile(const vt::TileId& tile, const vt::TileId& targetTile, const std::shared_ptr<vt::TileTransformer>& tileTransformer, const std::shared_ptr<BinaryData>& tileData) const {
+        CARTO_TRACE_SECTION("MBVectorTileDecoder::decodeTile");
+
         if (!tileData) {
             Log::Warn("MBVectorTileDecoder::decodeTile: Null tile data");
             return std::shared_ptr<TileMap>();
         }
 
-        std::shared_ptr<mvt::Map> map;
-        std::shared_ptr<mvt::SymbolizerContext> symbolizerContext;
-        bool featureIdOverride;
-        std::string layerNameOverride;
-        {
-            std::lock_guard<std::mutex> lock(_mutex);
-            map = _map;
-            symbolizerContext = _symbolizerContext;
-            featureIdOverride = _featureIdOverride;
-            layerNameOverride = _layerNameOverride;
-        }
+        std::shared_ptr<const DecoderState> state = getDecoderState();
     
         try {
-            mvt::MBVTFeatureDecoder decoder(*tileData->getDataPtr(), _logger);
-            decoder.setTransform(calculateTileTransform(tile, targetTile));
-            decoder.setGlobalIdOverride(featureIdOverride, MapTile(tile.x, tile.y, tile.zoom, 0).getTileId());
+            std::shared_ptr<mvt::MBVTFeatureDecoder> decoder = _decodedTileCache->getFeatureDecoder(tile, tileData);
+            decoder->setTransform(calculateTileTransform(tile, targetTile));
+            decoder->setGlobalIdOverride(state->featureIdOverride, MapTile(tile.x, tile.y, tile.zoom, 0).getTileId());
             
-            mvt::MBVTTileReader reader(map, tileTransformer, *symbolizerContext, decoder);
-            reader.setLayerNameOverride(layerNameOverride);
+            // If called from a task, skip styling once the task is canceled
+            const CancelableTask* task = CancelableTask::GetCurrentTask();
+            if (task && task->isCanceled()) {
+                return std::shared_ptr<TileMap>();
+            }
+
+            mvt::MBVTTileReader reader(state->map, tileTransformer, *state->symbolizerContext, *decoder);
+            reader.setLayerNameOverride(state->layerNameOverride);
 
             if (std::shared_ptr<vt::Tile> tile = reader.readTile(targetTile)) {
                 auto tileMap = std::make_shared<TileMap>();
@@ -438,6 +440,21 @@ namespace carto {
         return std::shared_ptr<TileMap>();
     }
 
+    std::shared_ptr<const MBVectorTileDecoder::DecoderState> MBVectorTileDecoder::getDecoderState() const {
+        return std::atomic_load(&_decoderState);
+    }
+
+    void MBVectorTileDecoder::publishDecoderState() {
+        auto state = std::make_shared<DecoderState>();
+        state->map = _map;
+        state->mapSettings = _mapSettings;
+        state->symbolizerContext = _symbolizerContext;
+        state->parameterValueMap = _parameterValueMap;
+        state->featureIdOverride = _featureIdOverride;
+        state->layerNameOverride = _layerNameOverride;
+        std::atomic_store(&_decoderState, std::shared_ptr<const DecoderState>(state));
+    }
+
     void MBVectorTileDecoder::updateCurrentStyleSet(const boost::variant<std::shared_ptr<CompiledStyleSet>, std::shared_ptr<CartoCSSStyleSet> >& styleSet) {
         std::string styleAssetName;
         std::shared_ptr<AssetPackage> assetPackage;
@@ -448,10 +465,13 @@ namespace carto {
             assetPackage = (*cartoCSSStyleSet)->getAssetPackage();
 
             try {
-                auto assetLoader = std::make_shared<CartoCSSAssetLoader>("", (*cartoCSSStyleSet)->getAssetPackage());
-                css::CartoCSSMapLoader mapLoader(assetLoader, _logger);
-                mapLoader.setIgnoreLayerPredicates(_cartoCSSLayerNamesIgnored);
-                map = mapLoader.loadMap((*cartoCSSStyleSet)->getCartoCSS());
+                std::string cartoCSS = (*cartoCSSStyleSet)->getCartoCSS();
+                map = CompiledMapCache::GetInstance().getMap(assetPackage, "cartocss:" + cartoCSS, _cartoCSSLayerNamesIgnored, [&]() -> std::shared_ptr<mvt::Map> {
+                    auto assetLoader = std::make_shared<CartoCSSAssetLoader>("", assetPackage);
+                    css::CartoCSSMapLoader mapLoader(assetLoader, _logger);
+                    mapLoader.setIgnoreLayerPredicates(_cartoCSSLayerNamesIgnored);
+                    return mapLoader.loadMap(cartoCSS);
+                });
             }
             catch (const std::exception& ex) {
                 throw ParseException(std::string("CartoCSS style parsing failed: ") + ex.what(), (*cartoCSSStyleSet)->getCartoCSS());
@@ -471,32 +491,37 @@ namespace carto {
                 throw GenericException("Failed to load style description asset");
             }
 
-            if (boost::algorithm::ends_with(styleAssetName, ".xml")) {
-                pugi::xml_document doc;
-                if (!doc.load_buffer(styleData->data(), styleData->size())) {
-                    throw ParseException("Style element XML parsing failed");
-                }
-                try {
-                    auto symbolizerParser = std::make_shared<mvt::SymbolizerParser>(_logger);
-                    mvt::MapParser mapParser(symbolizerParser, _logger);
-                    map = mapParser.parseMap(doc);
-                }
-                catch (const std::exception& ex) {
-                    throw ParseException(std::string("XML style processing failed: ") + ex.what());
-                }
-            } else if (boost::algorithm::ends_with(styleAssetName, ".json")) {
-                try {
-                    auto assetLoader = std::make_shared<CartoCSSAssetLoader>(FileUtils::GetFilePath(styleAssetName), assetPackage);
-                    css::CartoCSSMapLoader mapLoader(assetLoader, _logger);
-                    mapLoader.setIgnoreLayerPredicates(_cartoCSSLayerNamesIgnored);
-                    map = mapLoader.loadMapProject(styleAssetName);
-                }
-                catch (const std::exception& ex) {
-                    throw GenericException(std::string("CartoCSS style loading failed: ") + ex.what());
+            // Compiled maps are shared between decoders, keyed by the style asset contents
+            std::size_t styleHash = std::hash<std::string>()(std::string(reinterpret_cast<const char*>(styleData->data()), styleData->size()));
+            std::string styleKey = "asset:" + styleAssetName + ":" + std::to_string(styleData->size()) + ":" + std::to_string(styleHash);
+            map = CompiledMapCache::GetInstance().getMap(assetPackage, styleKey, _cartoCSSLayerNamesIgnored, [&]() -> std::shared_ptr<mvt::Map> {
+                if (boost::algorithm::ends_with(styleAssetName, ".xml")) {
+                    pugi::xml_document doc;
+                    if (!doc.load_buffer(styleData->data(), styleData->size())) {
+                        throw ParseException("Style element XML parsing failed");
+                    }
+                    try {
+                        auto symbolizerParser = std::make_shared<mvt::SymbolizerParser>(_logger);
+                        mvt::MapParser mapParser(symbolizerParser, _logger);
+                        return mapParser.parseMap(doc);
+                    }
+                    catch (const std::exception& ex) {
+                        throw ParseException(std::string("XML style processing failed: ") + ex.what());
+                    }
+                } else if (boost::algorithm::ends_with(styleAssetName, ".json")) {
+                    try {
+                        auto assetLoader = std::make_shared<CartoCSSAssetLoader>(FileUtils::GetFilePath(styleAssetName), assetPackage);
+                        css::CartoCSSMapLoader mapLoader(assetLoader, _logger);
+                        mapLoader.setIgnoreLayerPredicates(_cartoCSSLayerNamesIgnored);
+                        return mapLoader.loadMapProject(styleAssetName);
+                    }
+                    catch (const std::exception& ex) {
+                        throw GenericException(std::string("CartoCSS style loading failed: ") + ex.what());
+                    }
+                } else {
+                    throw GenericException("Failed to detect style asset type");
                 }
-            } else {
-                throw GenericException("Failed to detect style asset type");
-            }
+            });
         } else {
             throw InvalidArgumentException("Invalid style set");
         }
@@ -571,12 +596,12 @@ namespace carto {
         _map = map;
         _mapSettings = std::make_shared<mvt::Map::Settings>(_map->getSettings());
         _styleSet = styleSet;
-        _cachedFeatureDecoder.first.reset();
-        _cachedFeatureDecoder.second.reset();
+        publishDecoderState();
     }
 
     const int MBVectorTileDecoder::DEFAULT_TILE_SIZE = 256;
     const int MBVectorTileDecoder::STROKEMAP_SIZE = 512;
     const int MBVectorTileDecoder::GLYPHMAP_SIZE = 2048;
     const std::size_t MBVectorTileDecoder::MAX_ASSETPACKAGE_SYMBOLIZER_CONTEXTS = 2;
+    const std::size_t MBVectorTileDecoder::DECODED_TILE_CACHE_SIZE = 4 * 1024 * 1024;
 }
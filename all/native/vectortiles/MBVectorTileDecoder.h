@@ -28,6 +28,7 @@ namespace carto {
     }
 
     class AssetPackage;
+    class DecodedTileCache;
     class CompiledStyleSet;
     class CartoCSSStyleSet;
     
@@ -148,14 +149,33 @@ namespace carto {
         virtual std::shared_ptr<TileMap> decodeTile(const vt::TileId& tile, const vt::TileId& targetTile, const std::shared_ptr<vt::TileTransformer>& tileTransformer, const std::shared_ptr<BinaryData>& tileData) const;
     
     protected:
+        /**
+         * Immutable snapshot of the style state used for decoding.
+         * A new snapshot is published each time the style or decoder options change, existing snapshots are never modified.
+         * Thus decoding can be done from multiple threads without locking the decoder.
+         */
+        struct DecoderState {
+            std::shared_ptr<mvt::Map> map;
+            std::shared_ptr<mvt::Map::Settings> mapSettings;
+            std::shared_ptr<mvt::SymbolizerContext> symbolizerContext;
+            std::map<std::string, mvt::Value> parameterValueMap;
+            bool featureIdOverride;
+            std::string layerNameOverride;
+        };
+
+        std::shared_ptr<const DecoderState> getDecoderState() const;
+        void publishDecoderState();
+
         void updateCurrentStyleSet(const boost::variant<std::shared_ptr<CompiledStyleSet>, std::shared_ptr<CartoCSSStyleSet> >& styleSet);
 
         static const int DEFAULT_TILE_SIZE;
         static const int STROKEMAP_SIZE;
         static const int GLYPHMAP_SIZE;
         static const std::size_t MAX_ASSETPACKAGE_SYMBOLIZER_CONTEXTS;
+        static const std::size_t DECODED_TILE_CACHE_SIZE;
         
         const std::shared_ptr<mvt::Logger> _logger;
+        const std::shared_ptr<DecodedTileCache> _decodedTileCache;
         bool _featureIdOverride;
         bool _cartoCSSLayerNamesIgnored;
         std::string _layerNameOverride;
@@ -167,7 +187,8 @@ namespace carto {
         std::shared_ptr<mvt::SymbolizerContext> _symbolizerContext;
         std::map<std::pair<std::string, std::shared_ptr<AssetPackage> >, std::shared_ptr<mvt::SymbolizerContext> > _assetPackageSymbolizerContexts;
 
-        mutable std::pair<std::shared_ptr<BinaryData>, std::shared_ptr<mvt::MBVTFeatureDecoder> > _cachedFeatureDecoder;
+        std::shared_ptr<const DecoderState> _decoderState; // accessed atomically, published while holding _mutex
+
     
         mutable std::mutex _mutex;
     };
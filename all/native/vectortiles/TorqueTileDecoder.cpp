@@ -7,6 +7,7 @@
 #include "vectortiles/utils/CartoCSSAssetLoader.h"
 #include "utils/Const.h"
 #include "utils/Log.h"
+#include "utils/TraceUtils.h"
 
 #include <vt/Tile.h>
 #include <mapnikvt/Value.h>
@@ -109,6 +110,8 @@ namespace carto {
     }
 
     std::shared_ptr<TorqueTileDecoder::TileMap> TorqueTileDecoder::decodeTile(const vt::TileId& tile, const vt::TileId& targetTile, const std::shared_ptr<vt::TileTransformer>& tileTransformer, const std::shared_ptr<BinaryData>& tileData) const {
+        CARTO_TRACE_SECTION("TorqueTileDecoder::decodeTile");
+
         if (!tileData) {
             Log::Warn("TorqueTileDecoder::decodeTile: Null tile data");
             return std::shared_ptr<TileMap>();
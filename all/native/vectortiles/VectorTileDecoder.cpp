@@ -10,6 +10,10 @@ namespace carto {
     {
     }
 
+    std::shared_ptr<VectorTileDecoder::TileMap> VectorTileDecoder::decodeTileProgressive(const vt::TileId& tile, const vt::TileId& targetTile, const std::shared_ptr<vt::TileTransformer>& tileTransformer, const std::shared_ptr<BinaryData>& tileData, const PartialTileHandler& partialTileHandler) const {
+        return decodeTile(tile, targetTile, tileTransformer, tileData);
+    }
+
     void VectorTileDecoder::notifyDecoderChanged() {
         std::vector<std::shared_ptr<OnChangeListener> > onChangeListeners;
         {
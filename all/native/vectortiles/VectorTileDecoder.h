@@ -10,6 +10,7 @@
 #include "graphics/Color.h"
 
 #include <memory>
+#include <functional>
 #include <string>
 #include <mutex>
 #include <map>
@@ -37,6 +38,7 @@ namespace carto {
     class VectorTileDecoder {
     public:
         typedef std::map<int, std::shared_ptr<const vt::Tile> > TileMap;
+        typedef std::function<void(const std::shared_ptr<TileMap>&)> PartialTileHandler;
 
         /**
          * Interface for monitoring decoder parameter change events.
@@ -103,6 +105,18 @@ namespace carto {
          * @return The vector tile data, for each frame. If the tile is not available, null is returned.
          */
         virtual std::shared_ptr<TileMap> decodeTile(const vt::TileId& tile, const vt::TileId& targetTile, const std::shared_ptr<vt::TileTransformer>& tileTransformer, const std::shared_ptr<BinaryData>& tileData) const = 0;
+
+        /**
+         * Loads the specified vector tile progressively. Decoders that can split the work (for example, by style layers)
+         * call the handler with partial tiles containing the layers decoded so far, before returning the complete tile.
+         * The default implementation simply calls decodeTile.
+         * @param tile The id of the tile to load.
+         * @param targetTile The target tile id that will be created from the data.
+         * @param tileData The tile data to decode.
+         * @param partialTileHandler The handler to call with partial tiles. Called from the decoding thread.
+         * @return The vector tile data, for each frame. If the tile is not available, null is returned.
+         */
+        virtual std::shared_ptr<TileMap> decodeTileProgressive(const vt::TileId& tile, const vt::TileId& targetTile, const std::shared_ptr<vt::TileTransformer>& tileTransformer, const std::shared_ptr<BinaryData>& tileData, const PartialTileHandler& partialTileHandler) const;
     
         /**
          * Notifies listeners that the decoder parameters have changed. Action taken depends on the implementation of the
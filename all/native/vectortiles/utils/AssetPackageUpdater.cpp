@@ -3,6 +3,7 @@
 #include "components/Exceptions.h"
 #include "utils/MemoryAssetPackage.h"
 #include "utils/Log.h"
+#include "utils/JSONUtils.h"
 
 #include <utility>
 
@@ -102,7 +103,7 @@ namespace carto {
 
         std::string json(reinterpret_cast<const char*>(data->data()), data->size());
         picojson::value projectInfo;
-        std::string err = picojson::parse(projectInfo, json);
+        std::string err = JSONUtils::ParsePicoJSON(projectInfo, json);
         if (!err.empty()) {
             throw ParseException(std::string("Failed to parse style info: ") + err, json);
         }
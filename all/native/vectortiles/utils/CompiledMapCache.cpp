@@ -0,0 +1,81 @@
+#include "CompiledMapCache.h"
+#include "utils/AssetPackage.h"
+
+namespace carto {
+
+    CompiledMapCache& CompiledMapCache::GetInstance() {
+        static CompiledMapCache instance;
+        return instance;
+    }
+
+    CompiledMapCache::~CompiledMapCache() {
+    }
+
+    std::shared_ptr<mvt::Map> CompiledMapCache::getMap(const std::shared_ptr<AssetPackage>& assetPackage, const std::string& styleKey, bool ignoreLayerPredicates, const std::function<std::shared_ptr<mvt::Map>()>& compileFn) {
+        std::shared_ptr<std::promise<std::shared_ptr<mvt::Map> > > promise;
+        std::shared_future<std::shared_ptr<mvt::Map> > future;
+        long long entryId = 0;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (auto it = _entries.begin(); it != _entries.end(); ) {
+                if (it->hasAssetPackage && it->assetPackage.expired()) {
+                    it = _entries.erase(it);
+                    continue;
+                }
+                if (it->assetPackage.lock() == assetPackage && it->styleKey == styleKey && it->ignoreLayerPredicates == ignoreLayerPredicates) {
+                    future = it->map;
+                    _entries.splice(_entries.begin(), _entries, it);
+                    break;
+                }
+                it++;
+            }
+
+            if (!future.valid()) {
+                promise = std::make_shared<std::promise<std::shared_ptr<mvt::Map> > >();
+                future = promise->get_future().share();
+                entryId = ++_entryCounter;
+
+                Entry entry;
+                entry.assetPackage = assetPackage;
+                entry.hasAssetPackage = static_cast<bool>(assetPackage);
+                entry.styleKey = styleKey;
+                entry.ignoreLayerPredicates = ignoreLayerPredicates;
+                entry.id = entryId;
+                entry.map = future;
+                _entries.push_front(entry);
+                while (_entries.size() > MAX_ENTRIES) {
+                    _entries.pop_back();
+                }
+            }
+        }
+
+        // Compile outside of the lock, other callers of the same style wait for the future
+        if (promise) {
+            try {
+                promise->set_value(compileFn());
+            }
+            catch (...) {
+                promise->set_exception(std::current_exception());
+
+                std::lock_guard<std::mutex> lock(_mutex);
+                _entries.remove_if([entryId](const Entry& entry) { return entry.id == entryId; });
+            }
+        }
+        return future.get();
+    }
+
+    void CompiledMapCache::clear() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _entries.clear();
+    }
+
+    CompiledMapCache::CompiledMapCache() :
+        _entries(),
+        _entryCounter(0),
+        _mutex()
+    {
+    }
+
+    const std::size_t CompiledMapCache::MAX_ENTRIES = 8;
+
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_COMPILEDMAPCACHE_H_
+#define _CARTO_COMPILEDMAPCACHE_H_
+
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace carto {
+    namespace mvt {
+        class Map;
+    }
+
+    class AssetPackage;
+
+    /**
+     * Process-wide cache of compiled mapnikvt maps. Compiling CartoCSS and XML styles is expensive,
+     * so decoders created for the same style (several layers or a recreated map view) share a single compiled map.
+     * Concurrent requests for the same style wait for a single compilation instead of compiling it again.
+     */
+    class CompiledMapCache {
+    public:
+        static CompiledMapCache& GetInstance();
+
+        virtual ~CompiledMapCache();
+
+        /**
+         * Returns the compiled map for the specified style, compiling it if it is not cached.
+         * Exceptions thrown by the compile function are passed to all waiting callers and the failed style is not cached.
+         * @param assetPackage The asset package of the style, may be null.
+         * @param styleKey The key identifying the style source inside the asset package.
+         * @param ignoreLayerPredicates The layer predicate mode used when compiling the style.
+         * @param compileFn The function compiling the style.
+         * @return The compiled map.
+         */
+        std::shared_ptr<mvt::Map> getMap(const std::shared_ptr<AssetPackage>& assetPackage, const std::string& styleKey, bool ignoreLayerPredicates, const std::function<std::shared_ptr<mvt::Map>()>& compileFn);
+
+        void clear();
+
+    private:
+        struct Entry {
+            std::weak_ptr<AssetPackage> assetPackage;
+            bool hasAssetPackage;
+            std::string styleKey;
+            bool ignoreLayerPredicates;
+            long long id;
+            std::shared_future<std::shared_ptr<mvt::Map> > map;
+        };
+
+        CompiledMapCache();
+
+        static const std::size_t MAX_ENTRIES;
+
+        std::list<Entry> _entries; // most recently used first
+        long long _entryCounter;
+        mutable std::mutex _mutex;
+    };
+
+}
+
+#endif
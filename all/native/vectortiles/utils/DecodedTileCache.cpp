@@ -0,0 +1,93 @@
+#include "DecodedTileCache.h"
+#include "core/BinaryData.h"
+#include "core/MapTile.h"
+
+#include <vt/TileId.h>
+#include <mapnikvt/MBVTFeatureDecoder.h>
+
+#include <cglib/mat.h>
+
+namespace carto {
+
+    DecodedTileCache::DecodedTileCache(std::size_t capacityInBytes, const std::shared_ptr<mvt::Logger>& logger) :
+        _logger(logger),
+        _cache(),
+        _mutex()
+    {
+        _cache.resize(capacityInBytes);
+    }
+
+    DecodedTileCache::~DecodedTileCache() {
+    }
+
+    std::size_t DecodedTileCache::getCapacity() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _cache.capacity();
+    }
+
+    void DecodedTileCache::setCapacity(std::size_t capacityInBytes) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _cache.resize(capacityInBytes);
+    }
+
+    void DecodedTileCache::clear() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _cache.clear();
+    }
+
+    std::shared_ptr<mvt::MBVTFeatureDecoder> DecodedTileCache::getFeatureDecoder(const vt::TileId& tile, const std::shared_ptr<BinaryData>& tileData) {
+        long long tileId = MapTile(tile.x, tile.y, tile.zoom, 0).getTileId();
+
+        std::shared_ptr<Entry> entry;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_cache.read(tileId, entry)) {
+                // Layers with separate data sources return different data instances for the same tile
+                if (entry->tileData != tileData && *entry->tileData != *tileData) {
+                    entry.reset();
+                }
+            }
+        }
+
+        if (entry) {
+            if (std::shared_ptr<mvt::MBVTFeatureDecoder> decoder = ReserveFeatureDecoder(entry)) {
+                return decoder;
+            }
+
+            // Entry is in use by another thread, parsing again is cheaper than waiting for its tile reader
+            return std::make_shared<mvt::MBVTFeatureDecoder>(*tileData->getDataPtr(), _logger);
+        }
+
+        entry = std::make_shared<Entry>();
+        entry->tileData = tileData;
+        entry->decoder = std::make_shared<mvt::MBVTFeatureDecoder>(*tileData->getDataPtr(), _logger);
+        entry->reserved = false;
+        std::shared_ptr<mvt::MBVTFeatureDecoder> decoder = ReserveFeatureDecoder(entry);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (tileData->size() <= _cache.capacity()) {
+                _cache.put(tileId, entry, tileData->size());
+            }
+        }
+        return decoder;
+    }
+
+    std::shared_ptr<mvt::MBVTFeatureDecoder> DecodedTileCache::getFeatureLookupDecoder(const vt::TileId& tile, const std::shared_ptr<BinaryData>& tileData) {
+        std::shared_ptr<mvt::MBVTFeatureDecoder> decoder = getFeatureDecoder(tile, tileData);
+        // Cached decoders keep the transform and id settings of the last tile reader
+        decoder->setTransform(cglib::mat3x3<float>::identity());
+        decoder->setGlobalIdOverride(false, 0);
+        return decoder;
+    }
+
+    std::shared_ptr<mvt::MBVTFeatureDecoder> DecodedTileCache::ReserveFeatureDecoder(const std::shared_ptr<Entry>& entry) {
+        if (entry->reserved.exchange(true)) {
+            return std::shared_ptr<mvt::MBVTFeatureDecoder>();
+        }
+        // The deleter keeps the entry alive and releases the reservation
+        return std::shared_ptr<mvt::MBVTFeatureDecoder>(entry->decoder.get(), [entry](mvt::MBVTFeatureDecoder*) {
+            entry->reserved = false;
+        });
+    }
+
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_DECODEDTILECACHE_H_
+#define _CARTO_DECODEDTILECACHE_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include <stdext/timed_lru_cache.h>
+
+namespace carto {
+    namespace vt {
+        struct TileId;
+    }
+    namespace mvt {
+        class MBVTFeatureDecoder;
+        class Logger;
+    }
+
+    class BinaryData;
+
+    /**
+     * Cache for parsed MapBox vector tiles. Parsed tiles do not depend on the style,
+     * so the same entry can be reused for all target (overzoomed) tiles and by all layers sharing the decoder.
+     * Each entry can be used by a single thread at a time, concurrent users of the same tile get a private decoder instead of waiting.
+     */
+    class DecodedTileCache {
+    public:
+        DecodedTileCache(std::size_t capacityInBytes, const std::shared_ptr<mvt::Logger>& logger);
+        virtual ~DecodedTileCache();
+
+        std::size_t getCapacity() const;
+        void setCapacity(std::size_t capacityInBytes);
+
+        void clear();
+
+        /**
+         * Returns a feature decoder for the specified tile data. The decoder is reserved for the caller until the returned pointer is released.
+         * @param tile The source tile id.
+         * @param tileData The tile data.
+         * @return The feature decoder for the tile data.
+         */
+        std::shared_ptr<mvt::MBVTFeatureDecoder> getFeatureDecoder(const vt::TileId& tile, const std::shared_ptr<BinaryData>& tileData);
+        /**
+         * Returns a feature decoder for looking up features of the specified tile data.
+         * Unlike the decoders used for tile readers, the returned decoder uses tile local coordinates and original feature ids.
+         * @param tile The source tile id.
+         * @param tileData The tile data.
+         * @return The feature decoder for the tile data.
+         */
+        std::shared_ptr<mvt::MBVTFeatureDecoder> getFeatureLookupDecoder(const vt::TileId& tile, const std::shared_ptr<BinaryData>& tileData);
+
+    private:
+        struct Entry {
+            std::shared_ptr<BinaryData> tileData;
+            std::shared_ptr<mvt::MBVTFeatureDecoder> decoder;
+            std::atomic<bool> reserved;
+        };
+
+        static std::shared_ptr<mvt::MBVTFeatureDecoder> ReserveFeatureDecoder(const std::shared_ptr<Entry>& entry);
+
+        const std::shared_ptr<mvt::Logger> _logger;
+
+        cache::timed_lru_cache<long long, std::shared_ptr<Entry> > _cache;
+        mutable std::mutex _mutex;
+    };
+
+}
+
+#endif
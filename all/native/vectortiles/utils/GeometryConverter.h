@@ -59,7 +59,7 @@ namespace carto {
             std::vector<std::vector<MapPos>> posesList = convertPointsList(convertFn, mvtLine->getVerticesList());
             std::vector<std::shared_ptr<LineGeometry> > lines;
             lines.reserve(posesList.size());
-            std::transform(posesList.begin(), posesList.end(), std::back_inserter(lines), [](const std::vector<MapPos>& poses) { return std::make_shared<LineGeometry>(poses); });
+            std::transform(posesList.begin(), posesList.end(), std::back_inserter(lines), [](std::vector<MapPos>& poses) { return std::make_shared<LineGeometry>(std::move(poses)); });
             if (lines.size() == 1) {
                 return lines.front();
             } else {
@@ -69,7 +69,7 @@ namespace carto {
             std::vector<std::vector<std::vector<MapPos> > > posesLists = convertPointsLists(convertFn, mvtPolygon->getPolygonList());
             std::vector<std::shared_ptr<PolygonGeometry> > polygons;
             polygons.reserve(posesLists.size());
-            std::transform(posesLists.begin(), posesLists.end(), std::back_inserter(polygons), [](const std::vector<std::vector<MapPos> >& posesList) { return std::make_shared<PolygonGeometry>(posesList); });
+            std::transform(posesLists.begin(), posesLists.end(), std::back_inserter(polygons), [](std::vector<std::vector<MapPos> >& posesList) { return std::make_shared<PolygonGeometry>(std::move(posesList)); });
             if (polygons.size() == 1) {
                 return polygons.front();
             } else {
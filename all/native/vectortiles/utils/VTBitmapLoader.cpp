@@ -27,6 +27,45 @@ namespace carto {
     }
     
     std::shared_ptr<const vt::Bitmap> VTBitmapLoader::load(const std::string& url, float& resolution) const {
+        // Decoders using the same assets share the decoded bitmaps
+        bool assetBitmap = !_urlFileLoader.isSupported(url);
+        std::string fileName = assetBitmap ? FileUtils::NormalizePath(_basePath + url) : url;
+        auto key = std::make_tuple(assetBitmap ? _assetPackage.get() : nullptr, fileName, resolution);
+        {
+            std::lock_guard<std::mutex> lock(_BitmapCacheMutex);
+            auto it = _BitmapCache.find(key);
+            if (it != _BitmapCache.end()) {
+                if (!assetBitmap || !it->second.assetPackage.expired()) {
+                    if (std::shared_ptr<const vt::Bitmap> bitmap = it->second.bitmap.lock()) {
+                        resolution = it->second.resolution;
+                        return bitmap;
+                    }
+                }
+            }
+        }
+
+        float inputResolution = resolution;
+        std::shared_ptr<const vt::Bitmap> bitmap = loadBitmap(url, resolution);
+        if (bitmap) {
+            std::lock_guard<std::mutex> lock(_BitmapCacheMutex);
+            for (auto it = _BitmapCache.begin(); it != _BitmapCache.end(); ) {
+                if (it->second.bitmap.expired()) {
+                    it = _BitmapCache.erase(it);
+                } else {
+                    it++;
+                }
+            }
+
+            CachedBitmap cachedBitmap;
+            cachedBitmap.assetPackage = _assetPackage;
+            cachedBitmap.bitmap = bitmap;
+            cachedBitmap.resolution = resolution;
+            _BitmapCache[std::make_tuple(std::get<0>(key), fileName, inputResolution)] = cachedBitmap;
+        }
+        return bitmap;
+    }
+
+    std::shared_ptr<const vt::Bitmap> VTBitmapLoader::loadBitmap(const std::string& url, float& resolution) const {
         std::shared_ptr<BinaryData> fileData;
         if (_urlFileLoader.isSupported(url)) {
             if (!_urlFileLoader.load(url, fileData)) {
@@ -97,4 +136,7 @@ namespace carto {
         return std::make_shared<vt::Bitmap>(width, height, std::move(data));
     }
 
+    std::map<std::tuple<const AssetPackage*, std::string, float>, VTBitmapLoader::CachedBitmap> VTBitmapLoader::_BitmapCache;
+    std::mutex VTBitmapLoader::_BitmapCacheMutex;
+
 }
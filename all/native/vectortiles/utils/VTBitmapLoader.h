@@ -9,7 +9,10 @@
 
 #include "utils/URLFileLoader.h"
 
+#include <map>
+#include <mutex>
 #include <string>
+#include <tuple>
 #include <vector>
 #include <memory>
 
@@ -27,8 +30,18 @@ namespace carto {
         virtual std::shared_ptr<const vt::Bitmap> load(const std::string& url, float& resolution) const;
     
     private:
+        struct CachedBitmap {
+            std::weak_ptr<AssetPackage> assetPackage;
+            std::weak_ptr<const vt::Bitmap> bitmap;
+            float resolution;
+        };
+
+        std::shared_ptr<const vt::Bitmap> loadBitmap(const std::string& url, float& resolution) const;
         std::shared_ptr<const vt::Bitmap> loadSVG(const std::vector<unsigned char>& fileData, float& resolution) const;
 
+        static std::map<std::tuple<const AssetPackage*, std::string, float>, CachedBitmap> _BitmapCache; // shared between all loaders, holds bitmaps only while they are in use
+        static std::mutex _BitmapCacheMutex;
+
         std::string _basePath;
         std::shared_ptr<AssetPackage> _assetPackage;
         URLFileLoader _urlFileLoader;
@@ -5,6 +5,7 @@ import java.lang.reflect.Method;
 import javax.microedition.khronos.egl.EGLConfig;
 import javax.microedition.khronos.opengles.GL10;
 
+import android.content.ComponentCallbacks2;
 import android.content.Context;
 import android.content.SharedPreferences;
 import android.content.res.AssetManager;
@@ -22,6 +23,7 @@ import com.carto.core.MapPos;
 import com.carto.core.ScreenPos;
 import com.carto.core.ScreenBounds;
 import com.carto.core.MapVec;
+import com.carto.core.Variant;
 import com.carto.renderers.MapRenderer;
 import com.carto.renderers.RedrawRequestListener;
 import com.carto.utils.AndroidUtils;
@@ -98,6 +100,57 @@ public class MapView extends GLSurfaceView implements Renderer {
         return BaseMapView.registerLicense(newLicenseKey != null ? newLicenseKey : licenseKey, listener);
     }
     
+    /**
+     * Returns the global memory budget shared by the tile caches of all layers and data sources.
+     * @return The global memory budget in bytes. 0 if the budget is not set.
+     */
+    public static long getMemoryBudget() {
+        return BaseMapView.getMemoryBudget();
+    }
+
+    /**
+     * Sets the global memory budget shared by the tile caches of all layers and data sources.
+     * If 0, each cache uses its own capacity. The default is 0.
+     * @param budgetInBytes The new global memory budget in bytes.
+     */
+    public static void setMemoryBudget(long budgetInBytes) {
+        BaseMapView.setMemoryBudget(budgetInBytes);
+    }
+
+    /**
+     * Returns the global GPU memory budget of all map views.
+     * @return The GPU memory budget in bytes. 0 if the budget is not set.
+     */
+    public static long getGPUMemoryBudget() {
+        return BaseMapView.getGPUMemoryBudget();
+    }
+
+    /**
+     * Sets the global GPU memory budget of all map views. When the graphics resources of the map views exceed the budget,
+     * the preloading caches are released. If 0, GPU memory usage is not limited. The default is 0.
+     * @param budgetInBytes The new GPU memory budget in bytes.
+     */
+    public static void setGPUMemoryBudget(long budgetInBytes) {
+        BaseMapView.setGPUMemoryBudget(budgetInBytes);
+    }
+
+    /**
+     * Returns true if new map views share the worker thread pools with other map views.
+     * @return True if the thread pools are shared.
+     */
+    public static boolean isSharedThreadPools() {
+        return BaseMapView.isSharedThreadPools();
+    }
+
+    /**
+     * Enables or disables sharing of the worker thread pools between map views created after this call.
+     * Useful when multiple maps are shown at the same time. The default is false.
+     * @param enabled True if the thread pools should be shared.
+     */
+    public static void setSharedThreadPools(boolean enabled) {
+        BaseMapView.setSharedThreadPools(enabled);
+    }
+    
     /**
      * Creates a new MapView object from a context object.
      * @param context The context object.
@@ -144,6 +197,7 @@ public class MapView extends GLSurfaceView implements Renderer {
         
             baseMapView = new BaseMapView();
             baseMapView.getOptions().setDPI(getResources().getDisplayMetrics().densityDpi);
+            baseMapView.getOptions().setShaderCacheDirectory(context.getApplicationContext().getCacheDir().getAbsolutePath());
             baseMapView.setRedrawRequestListener(new MapRedrawRequestListener(this));
         
             try {
@@ -602,6 +656,23 @@ public class MapView extends GLSurfaceView implements Renderer {
         baseMapView.cancelAllTasks();
     }
 
+    /**
+     * Returns the statistics of the envelope and tile thread pools, for tuning the thread pool sizes.
+     * The result contains the queue depth over time, task counts, worker utilization and
+     * wait and run time histograms per task priority for both pools.
+     * @return The thread pool statistics.
+     */
+    public Variant getThreadPoolStatistics() {
+        return baseMapView.getThreadPoolStatistics();
+    }
+
+    /**
+     * Resets the statistics of the envelope and tile thread pools.
+     */
+    public void resetThreadPoolStatistics() {
+        baseMapView.resetThreadPoolStatistics();
+    }
+
     /**
      * Releases the memory occupied by the preloading area. Calling this method releases some
      * memory if preloading is enabled, but means that the area right outside the visible area has to be
@@ -618,5 +689,16 @@ public class MapView extends GLSurfaceView implements Renderer {
     public void clearAllCaches() {
         baseMapView.clearAllCaches();	
     }
+
+    /**
+     * Releases cache memory in response to an OS memory warning. This should be called from
+     * the onTrimMemory method of the activity or application.
+     * @param level The trim level as given to onTrimMemory.
+     */
+    public void onTrimMemory(int level) {
+        if (level >= ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW) {
+            baseMapView.onMemoryWarning(level >= ComponentCallbacks2.TRIM_MEMORY_RUNNING_CRITICAL);
+        }
+    }
     
 }
@@ -8,6 +8,8 @@
 #include "utils/Log.h"
 
 #include <cmath>
+#include <map>
+#include <mutex>
 
 namespace carto {
 
@@ -104,6 +106,8 @@ namespace carto {
     struct BitmapCanvas::AndroidImpl::TypefaceClass {
         JNIUniqueGlobalRef<jclass> clazz;
         jmethodID create;
+        std::map<std::string, JNIUniqueGlobalRef<jobject> > typefaces; // typefaces are immutable, cache them by name for all canvases
+        std::mutex typefacesMutex;
 
         explicit TypefaceClass(JNIEnv* jenv) {
             clazz = JNIUniqueGlobalRef<jclass>(jenv, jenv->NewGlobalRef(jenv->FindClass("android/graphics/Typeface")));
@@ -252,8 +256,17 @@ namespace carto {
             return;
         }
 
-        jstring fontName = jenv->NewStringUTF(name.c_str());
-        jobject typefaceObject = jenv->CallStaticObjectMethod(GetTypefaceClass()->clazz, GetTypefaceClass()->create, fontName, (jint)0); // 0 = NORMAL
+        jobject typefaceObject = NULL;
+        {
+            std::lock_guard<std::mutex> lock(GetTypefaceClass()->typefacesMutex);
+            auto it = GetTypefaceClass()->typefaces.find(name);
+            if (it == GetTypefaceClass()->typefaces.end()) {
+                jstring fontName = jenv->NewStringUTF(name.c_str());
+                jobject newTypefaceObject = jenv->CallStaticObjectMethod(GetTypefaceClass()->clazz, GetTypefaceClass()->create, fontName, (jint)0); // 0 = NORMAL
+                it = GetTypefaceClass()->typefaces.emplace(name, JNIUniqueGlobalRef<jobject>(jenv, jenv->NewGlobalRef(newTypefaceObject))).first;
+            }
+            typefaceObject = it->second.get();
+        }
         jenv->CallObjectMethod(_paintObject, GetPaintClass()->setTypeface, typefaceObject);
         jenv->CallVoidMethod(_paintObject, GetPaintClass()->setTextSize, (jfloat)size);
     }
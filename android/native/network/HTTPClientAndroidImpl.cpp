@@ -9,6 +9,7 @@
 #include <chrono>
 #include <limits>
 #include <regex>
+#include <vector>
 
 #include <boost/lexical_cast.hpp>
 
@@ -80,6 +81,36 @@ namespace carto {
         }
     };
     
+    struct HTTPClient::AndroidImpl::ChannelsClass {
+        JNIUniqueGlobalRef<jclass> clazz;
+        jmethodID newChannel;
+
+        explicit ChannelsClass(JNIEnv* jenv) {
+            clazz = JNIUniqueGlobalRef<jclass>(jenv, jenv->NewGlobalRef(jenv->FindClass("java/nio/channels/Channels")));
+            newChannel = jenv->GetStaticMethodID(clazz, "newChannel", "(Ljava/io/InputStream;)Ljava/nio/channels/ReadableByteChannel;");
+        }
+    };
+
+    struct HTTPClient::AndroidImpl::ReadableByteChannelClass {
+        JNIUniqueGlobalRef<jclass> clazz;
+        jmethodID read;
+
+        explicit ReadableByteChannelClass(JNIEnv* jenv) {
+            clazz = JNIUniqueGlobalRef<jclass>(jenv, jenv->NewGlobalRef(jenv->FindClass("java/nio/channels/ReadableByteChannel")));
+            read = jenv->GetMethodID(clazz, "read", "(Ljava/nio/ByteBuffer;)I");
+        }
+    };
+
+    struct HTTPClient::AndroidImpl::BufferClass {
+        JNIUniqueGlobalRef<jclass> clazz;
+        jmethodID clear;
+
+        explicit BufferClass(JNIEnv* jenv) {
+            clazz = JNIUniqueGlobalRef<jclass>(jenv, jenv->NewGlobalRef(jenv->FindClass("java/nio/Buffer")));
+            clear = jenv->GetMethodID(clazz, "clear", "()Ljava/nio/Buffer;");
+        }
+    };
+
     struct HTTPClient::AndroidImpl::OutputStreamClass {
         JNIUniqueGlobalRef<jclass> clazz;
         jmethodID write;
@@ -101,6 +132,10 @@ namespace carto {
     void HTTPClient::AndroidImpl::setTimeout(int milliseconds) {
         _timeout = milliseconds;
     }
+
+    void HTTPClient::AndroidImpl::setMaxConnectionsPerHost(int maxConnections) {
+        // HttpURLConnection keeps a process-wide keep-alive pool, configured by 'http.maxConnections' system property
+    }
     
     bool HTTPClient::AndroidImpl::makeRequest(const HTTPClient::Request& request, HeadersFunc headersFn, DataFunc dataFn) const {
         JNIEnv* jenv = AndroidUtils::GetCurrentThreadJNIEnv();
@@ -211,12 +246,19 @@ namespace carto {
         }
         
         try {
-            jbyte buf[4096];
-            jbyteArray jbuf = jenv->NewByteArray(sizeof(buf));
+            // Read directly into native memory through a direct ByteBuffer, avoiding Java byte arrays and per-chunk copies
+            std::vector<unsigned char> buf(READ_BUFFER_SIZE);
+            JNIUniqueLocalRef<jobject> byteBuffer(jenv, jenv->NewDirectByteBuffer(buf.data(), buf.size()));
+            JNIUniqueLocalRef<jobject> channel(jenv, jenv->CallStaticObjectMethod(GetChannelsClass()->clazz, GetChannelsClass()->newChannel, inputStream));
+            if (!byteBuffer || !channel || jenv->ExceptionCheck()) {
+                jenv->ExceptionClear();
+                throw NetworkException("Unable to create input channel", request.url);
+            }
 
             std::uint64_t readOffset = 0;
             while (!cancel) {
-                jint numBytesRead = jenv->CallIntMethod(inputStream, GetInputStreamClass()->read, jbuf);
+                JNIUniqueLocalRef<jobject> clearedBuffer(jenv, jenv->CallObjectMethod(byteBuffer.get(), GetBufferClass()->clear));
+                jint numBytesRead = jenv->CallIntMethod(channel.get(), GetReadableByteChannelClass()->read, byteBuffer.get());
 
                 if (jenv->ExceptionCheck()) {
                     jenv->ExceptionClear();
@@ -225,9 +267,8 @@ namespace carto {
                 if (numBytesRead < 0) {
                     break;
                 }
-                jenv->GetByteArrayRegion(jbuf, 0, numBytesRead, buf);
             
-                if (!dataFn(reinterpret_cast<const unsigned char*>(&buf[0]), numBytesRead)) {
+                if (!dataFn(buf.data(), numBytesRead)) {
                     cancel = true;
                 }
 
@@ -273,6 +314,21 @@ namespace carto {
         return cls;
     }
 
+    std::unique_ptr<HTTPClient::AndroidImpl::ChannelsClass>& HTTPClient::AndroidImpl::GetChannelsClass() {
+        static std::unique_ptr<ChannelsClass> cls(new ChannelsClass(AndroidUtils::GetCurrentThreadJNIEnv()));
+        return cls;
+    }
+
+    std::unique_ptr<HTTPClient::AndroidImpl::ReadableByteChannelClass>& HTTPClient::AndroidImpl::GetReadableByteChannelClass() {
+        static std::unique_ptr<ReadableByteChannelClass> cls(new ReadableByteChannelClass(AndroidUtils::GetCurrentThreadJNIEnv()));
+        return cls;
+    }
+
+    std::unique_ptr<HTTPClient::AndroidImpl::BufferClass>& HTTPClient::AndroidImpl::GetBufferClass() {
+        static std::unique_ptr<BufferClass> cls(new BufferClass(AndroidUtils::GetCurrentThreadJNIEnv()));
+        return cls;
+    }
+
     std::unique_ptr<HTTPClient::AndroidImpl::OutputStreamClass>& HTTPClient::AndroidImpl::GetOutputStreamClass() {
         static std::unique_ptr<OutputStreamClass> cls(new OutputStreamClass(AndroidUtils::GetCurrentThreadJNIEnv()));
         return cls;
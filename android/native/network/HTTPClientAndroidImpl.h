@@ -16,17 +16,26 @@ namespace carto {
         explicit AndroidImpl(bool log);
 
         virtual void setTimeout(int milliseconds);
+        virtual void setMaxConnectionsPerHost(int maxConnections);
         virtual bool makeRequest(const HTTPClient::Request& request, HeadersFunc headersFn, DataFunc dataFn) const;
 
     private:
+        static const std::size_t READ_BUFFER_SIZE = 65536;
+
         struct URLClass;
         struct HttpURLConnectionClass;
         struct InputStreamClass;
+        struct ChannelsClass;
+        struct ReadableByteChannelClass;
+        struct BufferClass;
         struct OutputStreamClass;
         
         static std::unique_ptr<URLClass>& GetURLClass();
         static std::unique_ptr<HttpURLConnectionClass>& GetHttpURLConnectionClass();
         static std::unique_ptr<InputStreamClass>& GetInputStreamClass();
+        static std::unique_ptr<ChannelsClass>& GetChannelsClass();
+        static std::unique_ptr<ReadableByteChannelClass>& GetReadableByteChannelClass();
+        static std::unique_ptr<BufferClass>& GetBufferClass();
         static std::unique_ptr<OutputStreamClass>& GetOutputStreamClass();
 
         bool _log;
@@ -7,6 +7,8 @@
 #include "utils/JNILocalFrame.h"
 #include "utils/Log.h"
 
+#include <cstring>
+
 #include <stdext/utf8_filesystem.h>
 
 #include <android/bitmap.h>
@@ -50,23 +52,18 @@ namespace carto {
         AndroidBitmapInfo bitmapInfo;
         AndroidBitmap_getInfo(jenv, androidBitmap, &bitmapInfo);
 
-        unsigned int bytesPerPixel = 0;
         ColorFormat::ColorFormat colorFormat = ColorFormat::COLOR_FORMAT_RGBA;
         switch (bitmapInfo.format) {
         case ANDROID_BITMAP_FORMAT_A_8:
-            bytesPerPixel = 1;
             colorFormat = ColorFormat::COLOR_FORMAT_GRAYSCALE;
             break;
         case ANDROID_BITMAP_FORMAT_RGB_565:
-            bytesPerPixel = 2;
             colorFormat = ColorFormat::COLOR_FORMAT_RGB_565;
             break;
         case ANDROID_BITMAP_FORMAT_RGBA_4444:
-            bytesPerPixel = 2;
             colorFormat = ColorFormat::COLOR_FORMAT_RGBA_4444;
             break;
         case ANDROID_BITMAP_FORMAT_RGBA_8888:
-            bytesPerPixel = 4;
             colorFormat = ColorFormat::COLOR_FORMAT_RGBA;
             break;
         case ANDROID_BITMAP_FORMAT_NONE:
@@ -82,7 +79,8 @@ namespace carto {
         }
         std::shared_ptr<Bitmap> bitmap;
         try {
-            bitmap = std::make_shared<Bitmap>(uncompressedData, bitmapInfo.width, bitmapInfo.height, colorFormat, bitmapInfo.width * bytesPerPixel);
+            // Read directly from the locked pixels, rows may be padded
+            bitmap = std::make_shared<Bitmap>(uncompressedData, bitmapInfo.width, bitmapInfo.height, colorFormat, bitmapInfo.stride);
         }
         catch (const std::exception& ex) {
             Log::Errorf("BitmapUtils::CreateBitmapFromAndroidBitmap: Failed to create bitmap: %s", ex.what());
@@ -127,46 +125,43 @@ namespace carto {
                 return NULL;
             }
 
+            // Write directly to the locked pixels, converting whole rows. Rows of the destination may be padded.
             const unsigned char* srcData = bitmap->getPixelData().data();
-            unsigned int destBytesPerPixel = 4;
-            unsigned int destBytesPerRow = bitmap->getWidth() * destBytesPerPixel;
             unsigned int srcBytesPerPixel = bitmap->getBytesPerPixel();
             unsigned int srcBytesPerRow = bitmap->getWidth() * srcBytesPerPixel;
             for (unsigned int i = 0; i < bitmap->getHeight(); i++) {
                 unsigned int flippedI = (bitmap->getHeight() - 1 - i);
-                for (unsigned int j = 0; j < bitmap->getWidth(); j++) {
-                    unsigned int destIndex = flippedI * destBytesPerRow + j * destBytesPerPixel;
-                    unsigned int srcIndex = i * srcBytesPerRow + j * srcBytesPerPixel;
-                    switch (bitmap->getColorFormat()) {
-                    case ColorFormat::COLOR_FORMAT_GRAYSCALE:
-                        destData[destIndex + 0] = srcData[srcIndex];
-                        destData[destIndex + 1] = srcData[srcIndex];
-                        destData[destIndex + 2] = srcData[srcIndex];
-                        destData[destIndex + 3] = srcData[srcIndex];
-                        break;
-                    case ColorFormat::COLOR_FORMAT_GRAYSCALE_ALPHA:
-                        destData[destIndex + 0] = srcData[srcIndex];
-                        destData[destIndex + 1] = srcData[srcIndex];
-                        destData[destIndex + 2] = srcData[srcIndex];
-                        destData[destIndex + 3] = srcData[srcIndex + 1];
-                        break;
-                    case ColorFormat::COLOR_FORMAT_RGB:
-                        destData[destIndex + 0] = srcData[srcIndex + 0];
-                        destData[destIndex + 1] = srcData[srcIndex + 1];
-                        destData[destIndex + 2] = srcData[srcIndex + 2];
-                        destData[destIndex + 3] = 255;
-                        break;
-                    case ColorFormat::COLOR_FORMAT_RGBA:
-                        destData[destIndex + 0] = srcData[srcIndex + 0];
-                        destData[destIndex + 1] = srcData[srcIndex + 1];
-                        destData[destIndex + 2] = srcData[srcIndex + 2];
-                        destData[destIndex + 3] = srcData[srcIndex + 3];
-                        break;
-                    default:
-                        Log::Error("BitmapUtils::CreateAndroidBitmapFromBitmap: Failed to convert bitmap");
-                        AndroidBitmap_unlockPixels(jenv, javaBitmap);
-                        return NULL;
+                const unsigned char* srcRow = srcData + i * srcBytesPerRow;
+                unsigned char* destRow = destData + flippedI * bitmapInfo.stride;
+                switch (bitmap->getColorFormat()) {
+                case ColorFormat::COLOR_FORMAT_GRAYSCALE:
+                    for (unsigned int j = 0; j < bitmap->getWidth(); j++) {
+                        std::memset(destRow + j * 4, srcRow[j], 4);
+                    }
+                    break;
+                case ColorFormat::COLOR_FORMAT_GRAYSCALE_ALPHA:
+                    for (unsigned int j = 0; j < bitmap->getWidth(); j++) {
+                        destRow[j * 4 + 0] = srcRow[j * 2];
+                        destRow[j * 4 + 1] = srcRow[j * 2];
+                        destRow[j * 4 + 2] = srcRow[j * 2];
+                        destRow[j * 4 + 3] = srcRow[j * 2 + 1];
+                    }
+                    break;
+                case ColorFormat::COLOR_FORMAT_RGB:
+                    for (unsigned int j = 0; j < bitmap->getWidth(); j++) {
+                        destRow[j * 4 + 0] = srcRow[j * 3 + 0];
+                        destRow[j * 4 + 1] = srcRow[j * 3 + 1];
+                        destRow[j * 4 + 2] = srcRow[j * 3 + 2];
+                        destRow[j * 4 + 3] = 255;
                     }
+                    break;
+                case ColorFormat::COLOR_FORMAT_RGBA:
+                    std::memcpy(destRow, srcRow, srcBytesPerRow);
+                    break;
+                default:
+                    Log::Error("BitmapUtils::CreateAndroidBitmapFromBitmap: Failed to convert bitmap");
+                    AndroidBitmap_unlockPixels(jenv, javaBitmap);
+                    return NULL;
                 }
             }
 
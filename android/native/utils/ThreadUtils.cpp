@@ -19,6 +19,29 @@ namespace carto {
         }
     }
 
+    void ThreadUtils::SetThreadRole(ThreadRole::ThreadRole role) {
+        // Use the nice values of the matching android.os.Process thread priorities
+        int posixPriority = 0;
+        switch (role) {
+        case ThreadRole::RENDER_CRITICAL:
+            posixPriority = -4; // THREAD_PRIORITY_DISPLAY
+            break;
+        case ThreadRole::INTERACTIVE:
+            posixPriority = 0; // THREAD_PRIORITY_DEFAULT
+            break;
+        case ThreadRole::BACKGROUND:
+            posixPriority = 10; // THREAD_PRIORITY_BACKGROUND
+            break;
+        case ThreadRole::BULK:
+            posixPriority = 19; // THREAD_PRIORITY_LOWEST
+            break;
+        }
+        int hasError = ::setpriority(PRIO_PROCESS, gettid(), posixPriority);
+        if (hasError != 0) {
+            Log::Errorf("ThreadUtils::SetThreadRole: Failed to set thread priority: %d", posixPriority);
+        }
+    }
+
     ThreadUtils::ThreadUtils() {
     }
 
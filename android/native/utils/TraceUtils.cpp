@@ -0,0 +1,64 @@
+#include "utils/TraceUtils.h"
+
+#include <dlfcn.h>
+
+namespace carto {
+
+    namespace {
+
+        // ATrace NDK functions are available only from API level 23, resolve them at runtime
+        struct ATraceFunctions {
+            typedef void (*BeginSectionFunc)(const char* sectionName);
+            typedef void (*EndSectionFunc)();
+            typedef bool (*IsEnabledFunc)();
+
+            BeginSectionFunc beginSection;
+            EndSectionFunc endSection;
+            IsEnabledFunc isEnabled;
+
+            ATraceFunctions() : beginSection(nullptr), endSection(nullptr), isEnabled(nullptr) {
+                if (void* lib = ::dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL)) {
+                    beginSection = reinterpret_cast<BeginSectionFunc>(::dlsym(lib, "ATrace_beginSection"));
+                    endSection = reinterpret_cast<EndSectionFunc>(::dlsym(lib, "ATrace_endSection"));
+                    isEnabled = reinterpret_cast<IsEnabledFunc>(::dlsym(lib, "ATrace_isEnabled"));
+                    if (!beginSection || !endSection || !isEnabled) {
+                        beginSection = nullptr;
+                        endSection = nullptr;
+                        isEnabled = nullptr;
+                    }
+                }
+            }
+        };
+
+        const ATraceFunctions& GetATraceFunctions() {
+            static ATraceFunctions functions;
+            return functions;
+        }
+
+    }
+
+    bool TraceUtils::IsEnabled() {
+        const ATraceFunctions& functions = GetATraceFunctions();
+        return functions.isEnabled && functions.isEnabled();
+    }
+
+    std::uint64_t TraceUtils::BeginSection(const char* name) {
+        const ATraceFunctions& functions = GetATraceFunctions();
+        if (!functions.isEnabled || !functions.isEnabled()) {
+            return 0;
+        }
+        functions.beginSection(name);
+        return 1;
+    }
+
+    void TraceUtils::EndSection(const char* name, std::uint64_t sectionId) {
+        // ATrace sections are nested per thread, only close the sections that were actually opened
+        if (sectionId != 0) {
+            GetATraceFunctions().endSection();
+        }
+    }
+
+    TraceUtils::TraceUtils() {
+    }
+
+}
@@ -41,6 +41,9 @@ namespace carto {
         CFAttributedStringRef createCFAttributedString(const std::string& text) const;
         CGSize measureFramesetter(CTFramesetterRef framesetter, int maxWidth, bool breakLines) const;
 
+        static CGColorSpaceRef GetColorSpace();
+        static CTFontRef GetFont(const std::string& name, float size);
+
         int _width;
         int _height;
         std::vector<unsigned char> _data;
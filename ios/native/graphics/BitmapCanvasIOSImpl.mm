@@ -4,6 +4,9 @@
 #include "utils/Log.h"
 
 #include <cmath>
+#include <map>
+#include <mutex>
+#include <utility>
 #include <vector>
 
 #import <Foundation/Foundation.h>
@@ -23,7 +26,7 @@ namespace carto {
         _font(),
         _fontSize(0)
     {
-        _colorSpace = CFUniquePtr<CGColorSpaceRef>(CGColorSpaceCreateDeviceRGB(), CGColorSpaceRelease);
+        _colorSpace = CFUniquePtr<CGColorSpaceRef>(CGColorSpaceRetain(GetColorSpace()), CGColorSpaceRelease);
         if (width > 0 && height > 0) {
             _context = CFUniquePtr<CGContextRef>(CGBitmapContextCreate(_data.data(), width, height, 8, 4 * width, _colorSpace, kCGImageAlphaPremultipliedLast), CGContextRelease);
             if (!_context) {
@@ -50,8 +53,7 @@ namespace carto {
     }
 
     void BitmapCanvas::IOSImpl::setFont(const std::string& name, float size) {
-        CFUniquePtr<CFStringRef> nameRef(CFStringCreateWithCString(nullptr, name.c_str(), kCFStringEncodingUTF8));
-        _font = CFUniquePtr<CTFontRef>(CTFontCreateWithName(nameRef, size, nullptr));
+        _font = CFUniquePtr<CTFontRef>(static_cast<CTFontRef>(CFRetain(GetFont(name, size))));
         _fontSize = size;
     }
 
@@ -279,4 +281,24 @@ namespace carto {
         return CGSizeMake(0, 0);
     }
 
+    CGColorSpaceRef BitmapCanvas::IOSImpl::GetColorSpace() {
+        // Intentionally never released, color spaces are immutable and shared by all canvases
+        static CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+        return colorSpace;
+    }
+
+    CTFontRef BitmapCanvas::IOSImpl::GetFont(const std::string& name, float size) {
+        // Fonts are immutable and thread-safe, cache them for all canvases. The number of distinct fonts used by styles is small.
+        static std::map<std::pair<std::string, float>, CFUniquePtr<CTFontRef> >* fonts = new std::map<std::pair<std::string, float>, CFUniquePtr<CTFontRef> >();
+        static std::mutex fontsMutex;
+
+        std::lock_guard<std::mutex> lock(fontsMutex);
+        auto it = fonts->find(std::make_pair(name, size));
+        if (it == fonts->end()) {
+            CFUniquePtr<CFStringRef> nameRef(CFStringCreateWithCString(nullptr, name.c_str(), kCFStringEncodingUTF8));
+            it = fonts->emplace(std::make_pair(name, size), CFUniquePtr<CTFontRef>(CTFontCreateWithName(nameRef, size, nullptr))).first;
+        }
+        return it->second;
+    }
+
 }
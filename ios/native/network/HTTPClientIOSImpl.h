@@ -9,6 +9,9 @@
 
 #include "network/HTTPClient.h"
 
+#include <memory>
+#include <mutex>
+
 namespace carto {
 
     class HTTPClient::IOSImpl : public HTTPClient::Impl {
@@ -17,11 +20,19 @@ namespace carto {
         virtual ~IOSImpl();
 
         virtual void setTimeout(int milliseconds);
+        virtual void setMaxConnectionsPerHost(int maxConnections);
         virtual bool makeRequest(const HTTPClient::Request& request, HeadersFunc headersFn, DataFunc dataFn) const;
 
     private:
+        struct Session;
+
+        std::shared_ptr<Session> getSession() const;
+
         bool _log;
         int _timeout;
+        int _maxConnectionsPerHost;
+        mutable std::shared_ptr<Session> _session; // shared by all requests, allows keep-alive connections and HTTP/2 multiplexing
+        mutable std::mutex _mutex;
     };
 
 }
@@ -3,10 +3,11 @@
 #include "utils/Log.h"
 
 #import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
 
 @interface URLConnection : NSObject <NSURLSessionDelegate, NSURLSessionTaskDelegate, NSURLSessionDataDelegate>
 
--(id)init;
+-(id)initWithMaxConnectionsPerHost:(int)maxConnections metricsHandler:(void(^)(BOOL, BOOL))metricsHandler;
 -(void)deinit;
 -(NSError*)sendSynchronousRequest:(NSURLRequest*)request didReceiveResponse:(BOOL(^)(NSURLResponse*))responseHandler didReceiveData:(BOOL(^)(NSData*))dataHandler;
 
@@ -18,15 +19,20 @@
 @property(nonatomic, strong) NSCondition* condition;
 @property(nonatomic, strong) NSMutableDictionary* responseHandlers;
 @property(nonatomic, strong) NSMutableDictionary* dataHandlers;
+@property(nonatomic, copy) void(^metricsHandler)(BOOL, BOOL);
 
 @end
 
 @implementation URLConnection
 
--(id)init {
+-(id)initWithMaxConnectionsPerHost:(int)maxConnections metricsHandler:(void(^)(BOOL, BOOL))metricsHandler {
     self = [super init];
 
     NSURLSessionConfiguration* defaultConfigObject = [NSURLSessionConfiguration defaultSessionConfiguration];
+    if (maxConnections > 0) {
+        defaultConfigObject.HTTPMaximumConnectionsPerHost = maxConnections;
+    }
+    self.metricsHandler = metricsHandler;
 
     self.session = [NSURLSession sessionWithConfiguration: defaultConfigObject delegate:self delegateQueue:nil];
     self.condition = [[NSCondition alloc] init];
@@ -47,6 +53,25 @@
     [self.dataHandlers setObject:dataHandler forKey:dataTask];
     [self.condition unlock];
 
+    // Keep the request running if the app is moved to background (for example while downloading packages).
+    // If the background time expires, the request is cancelled and the caller can resume it later.
+    UIApplication* application = [UIApplication sharedApplication];
+    __block UIBackgroundTaskIdentifier backgroundTask = UIBackgroundTaskInvalid;
+    void(^endBackgroundTask)(void) = ^{
+        @synchronized (dataTask) {
+            if (backgroundTask != UIBackgroundTaskInvalid) {
+                [application endBackgroundTask:backgroundTask];
+                backgroundTask = UIBackgroundTaskInvalid;
+            }
+        }
+    };
+    @synchronized (dataTask) {
+        backgroundTask = [application beginBackgroundTaskWithName:@"HTTPClient" expirationHandler:^{
+            [dataTask cancel];
+            endBackgroundTask();
+        }];
+    }
+
     [dataTask resume];
 
     [self.condition lock];
@@ -55,6 +80,8 @@
     }
     [self.condition unlock];
 
+    endBackgroundTask();
+
     return dataTask.error;
 }
 
@@ -62,6 +89,13 @@
     [self signalConnectionDidFinishLoading:(NSURLSessionDataTask*)task];
 }
 
+-(void)URLSession:(NSURLSession*)session task:(NSURLSessionTask*)task didFinishCollectingMetrics:(NSURLSessionTaskMetrics*)metrics API_AVAILABLE(ios(10.0)) {
+    NSURLSessionTaskTransactionMetrics* transactionMetrics = [metrics.transactionMetrics lastObject];
+    if (transactionMetrics && self.metricsHandler) {
+        self.metricsHandler(transactionMetrics.reusedConnection, [transactionMetrics.networkProtocolName isEqualToString:@"h2"]);
+    }
+}
+
 -(void)URLSession:(NSURLSession*)session task:(NSURLSessionTask*)task willPerformHTTPRedirection:(NSHTTPURLResponse*)response newRequest:(NSURLRequest*)request completionHandler:(void (^)(NSURLRequest*))completionHandler {
     completionHandler(request);
 }
@@ -73,7 +107,7 @@
     BOOL(^responseHandler)(NSURLResponse*) = [self.responseHandlers objectForKey:dataTask];
     [self.condition unlock];
 
-    if (responseHandler(response)) {
+    if (!responseHandler || responseHandler(response)) {
         [dataTask cancel];
         [self signalConnectionDidFinishLoading:dataTask];
     }
@@ -84,7 +118,7 @@
     BOOL(^dataHandler)(NSData*) = [self.dataHandlers objectForKey:dataTask];
     [self.condition unlock];
 
-    if (dataHandler(data)) {
+    if (!dataHandler || dataHandler(data)) {
         [dataTask cancel];
         [self signalConnectionDidFinishLoading:dataTask];
     }
@@ -103,7 +137,7 @@
     [self.condition lock];
     [self.responseHandlers removeObjectForKey:dataTask];
     [self.dataHandlers removeObjectForKey:dataTask];
-    [self.condition signal];
+    [self.condition broadcast]; // the session is shared, wake up all waiting requests
     [self.condition unlock];
 }
 
@@ -111,9 +145,19 @@
 
 namespace carto {
 
+    struct HTTPClient::IOSImpl::Session {
+        URLConnection* connection;
+
+        explicit Session(URLConnection* connection) : connection(connection) { }
+        ~Session() { [connection deinit]; }
+    };
+
     HTTPClient::IOSImpl::IOSImpl(bool log) :
         _log(log),
-        _timeout(-1)
+        _timeout(-1),
+        _maxConnectionsPerHost(-1),
+        _session(),
+        _mutex()
     {
     }
     
@@ -124,6 +168,12 @@ namespace carto {
         _timeout = milliseconds;
     }
 
+    void HTTPClient::IOSImpl::setMaxConnectionsPerHost(int maxConnections) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _maxConnectionsPerHost = maxConnections;
+        _session.reset(); // the session will be recreated with the new configuration, active requests will finish using the old session
+    }
+
     bool HTTPClient::IOSImpl::makeRequest(const HTTPClient::Request& request, HeadersFunc headersFn, DataFunc dataFn) const {
         NSURL* url = [NSURL URLWithString:[NSString stringWithUTF8String:request.url.c_str()]];
 
@@ -175,17 +225,35 @@ namespace carto {
             return cancel;
         };
 
-        // Send the request synchronously
-        URLConnection* connection = [[URLConnection alloc] init];
-        NSError* error = [connection sendSynchronousRequest:[mutableRequest copy] didReceiveResponse:handleResponse didReceiveData:handleData];
+        // Send the request synchronously using the shared session
+        std::shared_ptr<Session> session = getSession();
+        NSError* error = [session->connection sendSynchronousRequest:[mutableRequest copy] didReceiveResponse:handleResponse didReceiveData:handleData];
         if (error) {
             NSString* description = [error localizedDescription];
             throw NetworkException(std::string([description UTF8String]), request.url);
         }
-        [connection deinit];
 
         // Return the cancelled state
         return cancel == NO;
     }
 
+    std::shared_ptr<HTTPClient::IOSImpl::Session> HTTPClient::IOSImpl::getSession() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_session) {
+            const HTTPClient::IOSImpl* impl = this;
+            URLConnection* connection = [[URLConnection alloc] initWithMaxConnectionsPerHost:_maxConnectionsPerHost metricsHandler:^(BOOL reused, BOOL multiplexed) {
+                if (reused) {
+                    impl->_reusedConnectionCount++;
+                } else {
+                    impl->_openedConnectionCount++;
+                }
+                if (multiplexed) {
+                    impl->_multiplexedRequestCount++;
+                }
+            }];
+            _session = std::make_shared<Session>(connection);
+        }
+        return _session;
+    }
+
 }
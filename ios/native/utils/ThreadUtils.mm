@@ -3,6 +3,7 @@
 #include "utils/Log.h"
 
 #include <sys/syscall.h>
+#include <pthread.h>
 
 #import <Foundation/NSThread.h>
 
@@ -14,6 +15,29 @@ namespace carto {
         [nsThread setThreadPriority:nsPriority];
     }
     
+    void ThreadUtils::SetThreadRole(ThreadRole::ThreadRole role) {
+        // QoS classes also select the core type on asymmetric CPUs
+        qos_class_t qosClass = QOS_CLASS_DEFAULT;
+        switch (role) {
+        case ThreadRole::RENDER_CRITICAL:
+            qosClass = QOS_CLASS_USER_INTERACTIVE;
+            break;
+        case ThreadRole::INTERACTIVE:
+            qosClass = QOS_CLASS_USER_INITIATED;
+            break;
+        case ThreadRole::BACKGROUND:
+            qosClass = QOS_CLASS_UTILITY;
+            break;
+        case ThreadRole::BULK:
+            qosClass = QOS_CLASS_BACKGROUND;
+            break;
+        }
+        int hasError = pthread_set_qos_class_self_np(qosClass, 0);
+        if (hasError != 0) {
+            Log::Errorf("ThreadUtils::SetThreadRole: Failed to set thread QoS class: %d", static_cast<int>(qosClass));
+        }
+    }
+    
     ThreadUtils::ThreadUtils() {
     }
 
@@ -0,0 +1,49 @@
+#include "utils/TraceUtils.h"
+
+#include <os/log.h>
+#include <os/signpost.h>
+
+namespace carto {
+
+    namespace {
+
+        os_log_t GetTraceLog() API_AVAILABLE(ios(12.0)) {
+            static os_log_t log = os_log_create("com.carto.mobilesdk", "SDK");
+            return log;
+        }
+
+    }
+
+    bool TraceUtils::IsEnabled() {
+        if (@available(iOS 12.0, *)) {
+            return os_signpost_enabled(GetTraceLog());
+        }
+        return false;
+    }
+
+    std::uint64_t TraceUtils::BeginSection(const char* name) {
+        if (@available(iOS 12.0, *)) {
+            os_log_t log = GetTraceLog();
+            if (!os_signpost_enabled(log)) {
+                return 0;
+            }
+            os_signpost_id_t signpostId = os_signpost_id_generate(log);
+            os_signpost_interval_begin(log, signpostId, "Section", "%{public}s", name);
+            return static_cast<std::uint64_t>(signpostId);
+        }
+        return 0;
+    }
+
+    void TraceUtils::EndSection(const char* name, std::uint64_t sectionId) {
+        if (sectionId == 0) {
+            return;
+        }
+        if (@available(iOS 12.0, *)) {
+            os_signpost_interval_end(GetTraceLog(), static_cast<os_signpost_id_t>(sectionId), "Section", "%{public}s", name);
+        }
+    }
+
+    TraceUtils::TraceUtils() {
+    }
+
+}
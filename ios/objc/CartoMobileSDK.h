@@ -17,6 +17,7 @@
 #import "NTScreenPos.h"
 #import "NTScreenBounds.h"
 #import "NTMapRange.h"
+#import "NTCacheStatistics.h"
 #import "NTMapTile.h"
 #import "NTMapVec.h"
 #import "NTTileData.h"
@@ -27,6 +28,7 @@
 #import "NTAssetTileDataSource.h"
 #import "NTCombinedTileDataSource.h"
 #import "NTOrderedTileDataSource.h"
+#import "NTCompositeRasterTileDataSource.h"
 #import "NTMergedMBVTTileDataSource.h"
 #import "NTBitmapOverlayRasterTileDataSource.h"
 #import "NTGeoJSONVectorTileDataSource.h"
@@ -37,6 +39,7 @@
 #import "NTMapTilerOnlineTileDataSource.h"
 #import "NTLocalVectorDataSource.h"
 #import "NTTileDownloadListener.h"
+#import "NTTileExportListener.h"
 
 #import "NTFeature.h"
 #import "NTFeatureCollection.h"
@@ -57,6 +60,7 @@
 #import "NTViewState.h"
 
 #import "NTSolidLayer.h"
+#import "NTDebugOverlayLayer.h"
 #import "NTRasterTileEventListener.h"
 #import "NTRasterTileLayer.h"
 #import "NTHillshadeRasterTileLayer.h"
@@ -155,6 +159,9 @@
 
 #ifdef _CARTO_OFFLINE_SUPPORT
 #import "NTMBTilesTileDataSource.h"
+#import "NTMBTilesTileExporter.h"
+#import "NTRecordingTileDataSource.h"
+#import "NTReplayTileDataSource.h"
 #endif
 
 #ifdef _CARTO_PACKAGEMANAGER_SUPPORT
@@ -208,8 +215,12 @@
 #import "NTRoutingService.h"
 #import "NTRouteMatchingRequest.h"
 #import "NTRouteMatchingResult.h"
+#import "NTRoutingMatrixRequest.h"
+#import "NTRoutingMatrixResult.h"
+#import "NTRouteMatchingSession.h"
 #import "NTOSRMOfflineRoutingService.h"
 #import "NTSGREOfflineRoutingService.h"
+#import "NTSGREGraphListener.h"
 #import "NTCartoOnlineRoutingService.h"
 #import "NTValhallaOnlineRoutingService.h"
 #ifdef _CARTO_VALHALLA_ROUTING_SUPPORT
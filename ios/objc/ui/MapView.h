@@ -34,6 +34,7 @@
 @class NTMapEventListener;
 @class NTMapRenderer;
 @class NTOptions;
+@class NTVariant;
 
 /**
  * MapView is a view class supporting map rendering and interaction.
@@ -52,6 +53,39 @@ __attribute__ ((visibility("default"))) @interface NTMapView : NTGLKView
  * @param licenseKey The license string provided for this application.
  */
 +(BOOL)registerLicense:(NSString*)licenseKey;
+/**
+ * Returns the global memory budget shared by the tile caches of all layers and data sources.<br>
+ * @return The global memory budget in bytes. 0 if the budget is not set.
+ */
++(size_t)getMemoryBudget;
+/**
+ * Sets the global memory budget shared by the tile caches of all layers and data sources.<br>
+ * If 0, each cache uses its own capacity. The default is 0.<br>
+ * @param budgetInBytes The new global memory budget in bytes.
+ */
++(void)setMemoryBudget:(size_t)budgetInBytes;
+/**
+ * Returns the global GPU memory budget of all map views.<br>
+ * @return The GPU memory budget in bytes. 0 if the budget is not set.
+ */
++(size_t)getGPUMemoryBudget;
+/**
+ * Sets the global GPU memory budget of all map views. When the graphics resources of the map views exceed the budget,<br>
+ * the preloading caches are released. If 0, GPU memory usage is not limited. The default is 0.<br>
+ * @param budgetInBytes The new GPU memory budget in bytes.
+ */
++(void)setGPUMemoryBudget:(size_t)budgetInBytes;
+/**
+ * Returns true if new map views share the worker thread pools with other map views.<br>
+ * @return True if the thread pools are shared.
+ */
++(BOOL)isSharedThreadPools;
+/**
+ * Enables or disables sharing of the worker thread pools between map views created after this call.<br>
+ * Useful when multiple maps are shown at the same time. The default is false.<br>
+ * @param enabled True if the thread pools should be shared.
+ */
++(void)setSharedThreadPools:(BOOL)enabled;
 /**
  * Returns the Layers object, that can be used for adding and removing map layers.
  * @return The Layer object.
@@ -284,6 +318,18 @@ __attribute__ ((visibility("default"))) @interface NTMapView : NTGLKView
  */
 -(void)cancelAllTasks;
 
+/**
+ * Returns the statistics of the envelope and tile thread pools, for tuning the thread pool sizes.<br>
+ * The result contains the queue depth over time, task counts, worker utilization and<br>
+ * wait and run time histograms per task priority for both pools.<br>
+ * @return The thread pool statistics.
+ */
+-(NTVariant*)getThreadPoolStatistics;
+/**
+ * Resets the statistics of the envelope and tile thread pools.
+ */
+-(void)resetThreadPoolStatistics;
+
 /**
  * Releases the memory occupied by the preloading area. Calling this method releases some
  * memory if preloading is enabled, but means that the area right outside the visible area has to be
@@ -65,6 +65,7 @@ static const int NATIVE_NO_COORDINATE = -1;
 
     [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(appDidEnterBackground) name:UIApplicationDidEnterBackgroundNotification object:nil];
     [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(appWillEnterForeground) name:UIApplicationWillEnterForegroundNotification object:nil];
+    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(appDidReceiveMemoryWarning) name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
 
     _active = YES;
 
@@ -195,6 +196,18 @@ static const int NATIVE_NO_COORDINATE = -1;
 
     [[NSNotificationCenter defaultCenter] removeObserver:self name:UIApplicationDidEnterBackgroundNotification object:nil];
     [[NSNotificationCenter defaultCenter] removeObserver:self name:UIApplicationWillEnterForegroundNotification object:nil];
+    [[NSNotificationCenter defaultCenter] removeObserver:self name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
+}
+
+-(void)appDidReceiveMemoryWarning {
+    carto::Log::Info("MapView::appDidReceiveMemoryWarning");
+
+    // iOS does not report the severity of the warning, treat it as critical as the app may be terminated next
+    @synchronized (self) {
+        if (_baseMapView) {
+            [_baseMapView onMemoryWarning:YES];
+        }
+    }
 }
 
 -(void)appDidEnterBackground {
@@ -324,6 +337,30 @@ static const int NATIVE_NO_COORDINATE = -1;
     }
 }
 
++(size_t)getMemoryBudget {
+    return carto::BaseMapView::GetMemoryBudget();
+}
+
++(void)setMemoryBudget:(size_t)budgetInBytes {
+    carto::BaseMapView::SetMemoryBudget(budgetInBytes);
+}
+
++(size_t)getGPUMemoryBudget {
+    return carto::BaseMapView::GetGPUMemoryBudget();
+}
+
++(void)setGPUMemoryBudget:(size_t)budgetInBytes {
+    carto::BaseMapView::SetGPUMemoryBudget(budgetInBytes);
+}
+
++(BOOL)isSharedThreadPools {
+    return carto::BaseMapView::IsSharedThreadPools();
+}
+
++(void)setSharedThreadPools:(BOOL)enabled {
+    carto::BaseMapView::SetSharedThreadPools(enabled);
+}
+
 -(NTOptions*)getOptions {
     return [_baseMapView getOptions];
 }
@@ -424,6 +461,14 @@ static const int NATIVE_NO_COORDINATE = -1;
     [_baseMapView cancelAllTasks];
 }
 
+-(NTVariant*)getThreadPoolStatistics {
+    return [_baseMapView getThreadPoolStatistics];
+}
+
+-(void)resetThreadPoolStatistics {
+    [_baseMapView resetThreadPoolStatistics];
+}
+
 -(void)clearPreloadingCaches {
     [_baseMapView clearPreloadingCaches];
 }
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+// Vector tile decoding micro-benchmark. Decodes all tiles of a MBTiles corpus with the given decoder and style,
+// reports per-tile decode time distribution and allocated bytes (single thread) and throughput at
+// different thread counts as a JSON object on standard output.
+//
+// Usage: carto_mobile_sdk_decoder_benchmark <corpus.mbtiles> <decoder> <style> [threads] [iterations]
+//   decoder      'mbvt' (style is a compiled style asset package), 'carto' or 'torque' (style is a CartoCSS file)
+//   threads      comma-separated list of thread counts, default is 1,2,4
+//   iterations   number of passes over the corpus per thread count, default is 1
+//
+// The 'carto' decoder applies the CartoCSS style to the tile layer named 'layer0'.
+
+#include "core/BinaryData.h"
+#include "styles/CartoCSSStyleSet.h"
+#include "styles/CompiledStyleSet.h"
+#include "utils/Const.h"
+#include "utils/ZippedAssetPackage.h"
+#include "vectortiles/CartoVectorTileDecoder.h"
+#include "vectortiles/MBVectorTileDecoder.h"
+#include "vectortiles/TorqueTileDecoder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sqlite3pp.h>
+
+#include <vt/TileId.h>
+#include <vt/TileTransformer.h>
+
+namespace {
+
+    std::atomic<long long> allocatedBytes(0);
+
+}
+
+// Count all heap allocations, SDK sources are compiled into the same executable
+void* operator new(std::size_t size) {
+    allocatedBytes += static_cast<long long>(size);
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+
+    using namespace carto;
+
+    struct CorpusTile {
+        vt::TileId tileId;
+        std::shared_ptr<BinaryData> data;
+    };
+
+    bool readCorpus(const std::string& fileName, std::vector<CorpusTile>& tiles) {
+        sqlite3pp::database db;
+        if (db.connect_v2(fileName.c_str(), SQLITE_OPEN_READONLY) != SQLITE_OK) {
+            return false;
+        }
+        try {
+            sqlite3pp::query query(db, "SELECT zoom_level, tile_column, tile_row, tile_data FROM tiles");
+            for (auto it = query.begin(); it != query.end(); ++it) {
+                int zoom = (*it).get<int>(0);
+                int x = (*it).get<int>(1);
+                int y = (1 << zoom) - 1 - (*it).get<int>(2); // TMS scheme
+                std::size_t dataSize = (*it).column_bytes(3);
+                const unsigned char* dataPtr = static_cast<const unsigned char*>((*it).get<const void*>(3));
+                tiles.push_back(CorpusTile { vt::TileId(zoom, x, y), std::make_shared<BinaryData>(dataPtr, dataSize) });
+            }
+        }
+        catch (const std::exception& ex) {
+            std::fprintf(stderr, "Failed to read corpus: %s\n", ex.what());
+            return false;
+        }
+        return true;
+    }
+
+    std::string readTextFile(const std::string& fileName) {
+        std::ifstream file(fileName);
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+
+    std::shared_ptr<BinaryData> readBinaryFile(const std::string& fileName) {
+        std::ifstream file(fileName, std::ios::binary);
+        if (!file) {
+            return std::shared_ptr<BinaryData>();
+        }
+        std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        return std::make_shared<BinaryData>(std::move(data));
+    }
+
+    std::shared_ptr<VectorTileDecoder> createDecoder(const std::string& decoderType, const std::string& styleFileName) {
+        if (decoderType == "mbvt") {
+            std::shared_ptr<BinaryData> styleData = readBinaryFile(styleFileName);
+            if (!styleData) {
+                return std::shared_ptr<VectorTileDecoder>();
+            }
+            auto styleSet = std::make_shared<CompiledStyleSet>(std::make_shared<ZippedAssetPackage>(styleData));
+            return std::make_shared<MBVectorTileDecoder>(styleSet);
+        } else if (decoderType == "carto") {
+            auto styleSet = std::make_shared<CartoCSSStyleSet>(readTextFile(styleFileName));
+            std::map<std::string, std::shared_ptr<CartoCSSStyleSet> > layerStyleSets { { "layer0", styleSet } };
+            return std::make_shared<CartoVectorTileDecoder>(std::vector<std::string> { "layer0" }, layerStyleSets);
+        } else if (decoderType == "torque") {
+            return std::make_shared<TorqueTileDecoder>(std::make_shared<CartoCSSStyleSet>(readTextFile(styleFileName)));
+        }
+        return std::shared_ptr<VectorTileDecoder>();
+    }
+
+    std::vector<int> parseThreadCounts(const std::string& str) {
+        std::vector<int> threadCounts;
+        std::istringstream ss(str);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            int threadCount = std::atoi(item.c_str());
+            if (threadCount > 0) {
+                threadCounts.push_back(threadCount);
+            }
+        }
+        return threadCounts;
+    }
+
+    template <typename T>
+    T getPercentile(const std::vector<T>& sortedValues, int percentile) {
+        if (sortedValues.empty()) {
+            return T();
+        }
+        return sortedValues[(sortedValues.size() - 1) * percentile / 100];
+    }
+
+    void decodeTiles(const VectorTileDecoder& decoder, const std::shared_ptr<vt::TileTransformer>& tileTransformer, const std::vector<CorpusTile>& tiles, std::atomic<std::size_t>& nextTile, std::size_t tileCount) {
+        for (std::size_t i = nextTile++; i < tileCount; i = nextTile++) {
+            const CorpusTile& tile = tiles[i % tiles.size()];
+            decoder.decodeTile(tile.tileId, tile.tileId, tileTransformer, tile.data);
+        }
+    }
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 4) {
+        std::fprintf(stderr, "Usage: %s <corpus.mbtiles> <mbvt|carto|torque> <style> [threads] [iterations]\n", argv[0]);
+        return 1;
+    }
+    std::vector<int> threadCounts = parseThreadCounts(argc > 4 ? argv[4] : "1,2,4");
+    int iterations = std::max(1, argc > 5 ? std::atoi(argv[5]) : 1);
+
+    std::vector<CorpusTile> tiles;
+    if (!readCorpus(argv[1], tiles) || tiles.empty()) {
+        std::fprintf(stderr, "Failed to read tiles from corpus %s\n", argv[1]);
+        return 1;
+    }
+
+    std::shared_ptr<VectorTileDecoder> decoder = createDecoder(argv[2], argv[3]);
+    if (!decoder) {
+        std::fprintf(stderr, "Failed to create decoder %s with style %s\n", argv[2], argv[3]);
+        return 1;
+    }
+    std::shared_ptr<vt::TileTransformer> tileTransformer = std::make_shared<vt::DefaultTileTransformer>(static_cast<float>(Const::WORLD_SIZE));
+
+    // Single-threaded pass for per-tile statistics, the first decode also initializes style caches
+    decoder->decodeTile(tiles.front().tileId, tiles.front().tileId, tileTransformer, tiles.front().data);
+    std::vector<float> decodeTimes;
+    std::vector<long long> tileAllocatedBytes;
+    for (const CorpusTile& tile : tiles) {
+        long long allocatedBytes0 = allocatedBytes.load();
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        decoder->decodeTile(tile.tileId, tile.tileId, tileTransformer, tile.data);
+        decodeTimes.push_back(std::chrono::duration_cast<std::chrono::duration<float, std::milli> >(std::chrono::steady_clock::now() - startTime).count());
+        tileAllocatedBytes.push_back(allocatedBytes.load() - allocatedBytes0);
+    }
+    std::sort(decodeTimes.begin(), decodeTimes.end());
+    std::sort(tileAllocatedBytes.begin(), tileAllocatedBytes.end());
+
+    // Throughput passes, threads share the corpus
+    std::vector<std::pair<int, float> > throughputs;
+    for (int threadCount : threadCounts) {
+        std::size_t tileCount = tiles.size() * iterations;
+        std::atomic<std::size_t> nextTile(0);
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (int i = 0; i < threadCount; i++) {
+            threads.emplace_back(decodeTiles, std::cref(*decoder), std::cref(tileTransformer), std::cref(tiles), std::ref(nextTile), tileCount);
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        float elapsed = std::chrono::duration_cast<std::chrono::duration<float> >(std::chrono::steady_clock::now() - startTime).count();
+        throughputs.emplace_back(threadCount, elapsed > 0 ? tileCount / elapsed : 0.0f);
+    }
+
+    std::printf("{\n");
+    std::printf("  \"decoder\": \"%s\",\n", argv[2]);
+    std::printf("  \"tileCount\": %d,\n", static_cast<int>(tiles.size()));
+    std::printf("  \"decodeTime\": { \"p50\": %.3f, \"p95\": %.3f, \"max\": %.3f },\n", getPercentile(decodeTimes, 50), getPercentile(decodeTimes, 95), decodeTimes.back());
+    std::printf("  \"allocatedBytes\": { \"p50\": %lld, \"p95\": %lld, \"max\": %lld },\n", getPercentile(tileAllocatedBytes, 50), getPercentile(tileAllocatedBytes, 95), tileAllocatedBytes.back());
+    std::printf("  \"throughput\": {");
+    for (std::size_t i = 0; i < throughputs.size(); i++) {
+        std::printf("%s \"%d\": %.1f", i > 0 ? "," : "", throughputs[i].first, throughputs[i].second);
+    }
+    std::printf(" }\n");
+    std::printf("}\n");
+    return 0;
+}
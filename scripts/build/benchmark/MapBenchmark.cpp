@@ -0,0 +1,315 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+// Headless rendering benchmark. Renders a map from a MBTiles file into an offscreen EGL pbuffer surface,
+// replays a scripted sequence of camera events and reports frame time distribution, tile completion times
+// and memory high-water mark as a JSON object on standard output.
+//
+// Usage: carto_mobile_sdk_benchmark <tiles.mbtiles> <camera.script> [style.zip] [width] [height]
+//
+// Requires a build with offline support (MBTilesTileDataSource), for example the 'standard' profile.
+// If the style asset package is given, tiles are decoded as vector tiles, otherwise as raster tiles.
+// Camera script contains one command per line, empty lines and lines starting with '#' are ignored:
+//   focus <x> <y>                 set focus position (EPSG3857) immediately
+//   zoom <zoom>                   set zoom level immediately
+//   pan <dx> <dy> <duration>      pan by the given delta (EPSG3857) over the duration in seconds
+//   zoomby <delta> <duration>     zoom by the given delta over the duration in seconds
+//   rotate <delta> <duration>     rotate by the given angle in degrees over the duration in seconds
+//   tilt <delta> <duration>       tilt by the given angle in degrees over the duration in seconds
+//   wait                          render until all visible tiles are loaded
+
+#include "core/BinaryData.h"
+#include "core/MapPos.h"
+#include "core/MapVec.h"
+#include "components/Layers.h"
+#include "datasources/MBTilesTileDataSource.h"
+#include "layers/RasterTileLayer.h"
+#include "layers/TileLoadListener.h"
+#include "layers/VectorTileLayer.h"
+#include "renderers/MapRenderer.h"
+#include "renderers/components/FrameProfiler.h"
+#include "styles/CompiledStyleSet.h"
+#include "ui/BaseMapView.h"
+#include "utils/ZippedAssetPackage.h"
+#include "vectortiles/MBVectorTileDecoder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+
+namespace {
+
+    using namespace carto;
+
+    struct CameraCommand {
+        std::string name;
+        std::vector<float> args;
+    };
+
+    class BenchmarkTileLoadListener : public TileLoadListener {
+    public:
+        BenchmarkTileLoadListener() : _loaded(false) { }
+
+        bool isLoaded() const { return _loaded.load(); }
+        void reset() { _loaded.store(false); }
+
+        virtual void onVisibleTilesLoaded() { _loaded.store(true); }
+
+    private:
+        std::atomic<bool> _loaded;
+    };
+
+    class OffscreenSurface {
+    public:
+        OffscreenSurface() : _display(EGL_NO_DISPLAY), _surface(EGL_NO_SURFACE), _context(EGL_NO_CONTEXT) { }
+
+        ~OffscreenSurface() {
+            if (_display != EGL_NO_DISPLAY) {
+                eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+                if (_context != EGL_NO_CONTEXT) {
+                    eglDestroyContext(_display, _context);
+                }
+                if (_surface != EGL_NO_SURFACE) {
+                    eglDestroySurface(_display, _surface);
+                }
+                eglTerminate(_display);
+            }
+        }
+
+        bool create(int width, int height) {
+            _display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+            if (_display == EGL_NO_DISPLAY || !eglInitialize(_display, nullptr, nullptr)) {
+                return false;
+            }
+
+            const EGLint configAttribs[] = {
+                EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+                EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+                EGL_DEPTH_SIZE, 24, EGL_STENCIL_SIZE, 8,
+                EGL_NONE
+            };
+            EGLConfig config = nullptr;
+            EGLint configCount = 0;
+            if (!eglChooseConfig(_display, configAttribs, &config, 1, &configCount) || configCount < 1) {
+                return false;
+            }
+
+            const EGLint surfaceAttribs[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+            _surface = eglCreatePbufferSurface(_display, config, surfaceAttribs);
+            if (_surface == EGL_NO_SURFACE) {
+                return false;
+            }
+
+            const EGLint contextAttribs[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+            _context = eglCreateContext(_display, config, EGL_NO_CONTEXT, contextAttribs);
+            if (_context == EGL_NO_CONTEXT) {
+                return false;
+            }
+            return eglMakeCurrent(_display, _surface, _surface, _context) == EGL_TRUE;
+        }
+
+    private:
+        EGLDisplay _display;
+        EGLSurface _surface;
+        EGLContext _context;
+    };
+
+    bool readCameraScript(const std::string& fileName, std::vector<CameraCommand>& commands) {
+        std::ifstream file(fileName);
+        if (!file) {
+            return false;
+        }
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream ss(line);
+            CameraCommand command;
+            if (!(ss >> command.name) || command.name[0] == '#') {
+                continue;
+            }
+            float arg = 0;
+            while (ss >> arg) {
+                command.args.push_back(arg);
+            }
+            commands.push_back(command);
+        }
+        return true;
+    }
+
+    std::shared_ptr<BinaryData> readFile(const std::string& fileName) {
+        std::ifstream file(fileName, std::ios::binary);
+        if (!file) {
+            return std::shared_ptr<BinaryData>();
+        }
+        std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        return std::make_shared<BinaryData>(std::move(data));
+    }
+
+    long long readMemoryHighWaterMark() {
+        // Peak resident set size in kilobytes, as reported by the kernel
+        std::ifstream file("/proc/self/status");
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.compare(0, 6, "VmHWM:") == 0) {
+                return std::atoll(line.c_str() + 6);
+            }
+        }
+        return -1;
+    }
+
+    float getPercentile(const std::vector<float>& sortedValues, int percentile) {
+        if (sortedValues.empty()) {
+            return 0;
+        }
+        return sortedValues[(sortedValues.size() - 1) * percentile / 100];
+    }
+
+    void printTimingStatistics(const char* name, const FrameProfiler::TimingStatistics& statistics, bool last) {
+        std::printf("    \"%s\": { \"p50\": %.2f, \"p95\": %.2f, \"max\": %.2f, \"samples\": %d }%s\n", name, statistics.p50, statistics.p95, statistics.max, statistics.sampleCount, last ? "" : ",");
+    }
+
+    float drawFrame(BaseMapView& mapView, std::vector<float>& frameTimes) {
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        mapView.onDrawFrame();
+        glFinish();
+        float frameTime = std::chrono::duration_cast<std::chrono::duration<float, std::milli> >(std::chrono::steady_clock::now() - startTime).count();
+        frameTimes.push_back(frameTime);
+        return frameTime;
+    }
+
+    bool executeCommand(BaseMapView& mapView, const CameraCommand& command, float& duration) {
+        const std::vector<float>& args = command.args;
+        duration = 0;
+        if (command.name == "focus" && args.size() >= 2) {
+            mapView.setFocusPos(MapPos(args[0], args[1]), 0);
+        } else if (command.name == "zoom" && args.size() >= 1) {
+            mapView.setZoom(args[0], 0);
+        } else if (command.name == "pan" && args.size() >= 3) {
+            mapView.pan(MapVec(args[0], args[1]), args[2]);
+            duration = args[2];
+        } else if (command.name == "zoomby" && args.size() >= 2) {
+            mapView.zoom(args[0], args[1]);
+            duration = args[1];
+        } else if (command.name == "rotate" && args.size() >= 2) {
+            mapView.rotate(args[0], args[1]);
+            duration = args[1];
+        } else if (command.name == "tilt" && args.size() >= 2) {
+            mapView.tilt(args[0], args[1]);
+            duration = args[1];
+        } else if (command.name != "wait") {
+            return false;
+        }
+        return true;
+    }
+
+    const float TILE_LOAD_TIMEOUT = 30.0f;
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::fprintf(stderr, "Usage: %s <tiles.mbtiles> <camera.script> [style.zip] [width] [height]\n", argv[0]);
+        return 1;
+    }
+    std::string styleFileName = argc > 3 ? argv[3] : "";
+    int width = argc > 4 ? std::atoi(argv[4]) : 1080;
+    int height = argc > 5 ? std::atoi(argv[5]) : 1920;
+
+    std::vector<CameraCommand> commands;
+    if (!readCameraScript(argv[2], commands)) {
+        std::fprintf(stderr, "Failed to read camera script %s\n", argv[2]);
+        return 1;
+    }
+
+    OffscreenSurface surface;
+    if (!surface.create(width, height)) {
+        std::fprintf(stderr, "Failed to create offscreen EGL surface\n");
+        return 1;
+    }
+
+    auto mapView = std::make_shared<BaseMapView>();
+    auto dataSource = std::make_shared<MBTilesTileDataSource>(argv[1]);
+    std::shared_ptr<TileLayer> layer;
+    if (!styleFileName.empty()) {
+        std::shared_ptr<BinaryData> styleData = readFile(styleFileName);
+        if (!styleData) {
+            std::fprintf(stderr, "Failed to read style asset package %s\n", styleFileName.c_str());
+            return 1;
+        }
+        auto styleSet = std::make_shared<CompiledStyleSet>(std::make_shared<ZippedAssetPackage>(styleData));
+        layer = std::make_shared<VectorTileLayer>(dataSource, std::make_shared<MBVectorTileDecoder>(styleSet));
+    } else {
+        layer = std::make_shared<RasterTileLayer>(dataSource);
+    }
+    auto tileLoadListener = std::make_shared<BenchmarkTileLoadListener>();
+    layer->setTileLoadListener(tileLoadListener);
+    mapView->getLayers()->add(layer);
+
+    std::shared_ptr<FrameProfiler> frameProfiler = mapView->getMapRenderer()->getFrameProfiler();
+    frameProfiler->setEnabled(true);
+
+    mapView->onSurfaceCreated();
+    mapView->onSurfaceChanged(width, height);
+
+    std::vector<float> frameTimes;
+    std::vector<float> tileCompletionTimes; // milliseconds from the command start, -1 if not completed within the timeout
+    for (const CameraCommand& command : commands) {
+        tileLoadListener->reset();
+
+        float duration = 0;
+        if (!executeCommand(*mapView, command, duration)) {
+            std::fprintf(stderr, "Unknown or invalid camera command: %s\n", command.name.c_str());
+            return 1;
+        }
+
+        // Render the animation, when waiting render until tiles are loaded
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        float elapsed = 0;
+        while (elapsed < duration || (command.name == "wait" && !tileLoadListener->isLoaded() && elapsed < TILE_LOAD_TIMEOUT)) {
+            drawFrame(*mapView, frameTimes);
+            elapsed = std::chrono::duration_cast<std::chrono::duration<float> >(std::chrono::steady_clock::now() - startTime).count();
+        }
+        if (command.name == "wait") {
+            tileCompletionTimes.push_back(tileLoadListener->isLoaded() ? elapsed * 1000.0f : -1.0f);
+        }
+    }
+
+    mapView->onSurfaceDestroyed();
+
+    std::vector<float> sortedFrameTimes(frameTimes);
+    std::sort(sortedFrameTimes.begin(), sortedFrameTimes.end());
+    FrameProfiler::Statistics statistics = frameProfiler->getStatistics();
+
+    std::printf("{\n");
+    std::printf("  \"frameCount\": %d,\n", static_cast<int>(sortedFrameTimes.size()));
+    std::printf("  \"droppedFrameCount\": %lld,\n", statistics.droppedFrameCount);
+    std::printf("  \"frameTime\": { \"p50\": %.2f, \"p95\": %.2f, \"p99\": %.2f, \"max\": %.2f },\n", getPercentile(sortedFrameTimes, 50), getPercentile(sortedFrameTimes, 95), getPercentile(sortedFrameTimes, 99), sortedFrameTimes.empty() ? 0.0f : sortedFrameTimes.back());
+    std::printf("  \"tileCompletionTimes\": [");
+    for (std::size_t i = 0; i < tileCompletionTimes.size(); i++) {
+        std::printf("%s%.1f", i > 0 ? ", " : "", tileCompletionTimes[i]);
+    }
+    std::printf("],\n");
+    std::printf("  \"memoryHighWaterMarkKB\": %lld,\n", readMemoryHighWaterMark());
+    std::printf("  \"profiler\": {\n");
+    printTimingStatistics("gpuFrameTime", statistics.gpuFrameTime, statistics.phaseTimes.empty());
+    for (auto it = statistics.phaseTimes.begin(); it != statistics.phaseTimes.end(); it++) {
+        printTimingStatistics(it->first.c_str(), it->second, std::next(it) == statistics.phaseTimes.end());
+    }
+    std::printf("  }\n");
+    std::printf("}\n");
+    return 0;
+}
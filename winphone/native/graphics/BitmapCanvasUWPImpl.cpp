@@ -4,6 +4,9 @@
 #include "utils/Log.h"
 
 #include <cmath>
+#include <map>
+#include <mutex>
+#include <utility>
 
 #include <utf8.h>
 
@@ -23,60 +26,27 @@ namespace carto {
         _dwriteFactory(),
         _dwriteTextFormat()
     {
-        static const D3D_FEATURE_LEVEL featureLevels[] =
-        {
-            D3D_FEATURE_LEVEL_11_1,
-            D3D_FEATURE_LEVEL_11_0,
-            D3D_FEATURE_LEVEL_10_1,
-            D3D_FEATURE_LEVEL_10_0,
-            D3D_FEATURE_LEVEL_9_3,
-            D3D_FEATURE_LEVEL_9_2,
-            D3D_FEATURE_LEVEL_9_1
-        };
+        const DeviceResources& deviceResources = GetDeviceResources();
+        _device = deviceResources.device;
+        _context = deviceResources.context;
+        _d2dDevice = deviceResources.d2dDevice;
+        _dwriteFactory = GetDWriteFactory();
 
-        HRESULT hr = D3D11CreateDevice(
-            NULL,
-            D3D_DRIVER_TYPE_HARDWARE,
-            NULL,
-            D3D11_CREATE_DEVICE_SINGLETHREADED | D3D11_CREATE_DEVICE_BGRA_SUPPORT,
-            featureLevels,
-            ARRAYSIZE(featureLevels),
-            D3D11_SDK_VERSION,
-            &_device,
-            NULL,
-            &_context);
+        HRESULT hr = _d2dDevice->CreateDeviceContext(D2D1_DEVICE_CONTEXT_OPTIONS_NONE, &_d2dContext);
         if (SUCCEEDED(hr)) {
-            Microsoft::WRL::ComPtr<IDXGIDevice> dxgiDevice;
-            _device.As(&dxgiDevice);
-
-            hr = D2D1CreateDevice(dxgiDevice.Get(), NULL, &_d2dDevice);
+            D2D1_SIZE_U size = { static_cast<UINT32>(width), static_cast<UINT32>(height) };
+            D2D1_BITMAP_PROPERTIES1 targetProperties = { { DXGI_FORMAT_R8G8B8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED }, 96, 96, D2D1_BITMAP_OPTIONS_TARGET, 0 };
+            hr = _d2dContext->CreateBitmap(size, NULL, 0, &targetProperties, &_d2dTargetBitmap);
             if (SUCCEEDED(hr)) {
-                hr = _d2dDevice->CreateDeviceContext(D2D1_DEVICE_CONTEXT_OPTIONS_NONE, &_d2dContext);
-                if (SUCCEEDED(hr)) {
-                    D2D1_SIZE_U size = { static_cast<UINT32>(width), static_cast<UINT32>(height) };
-                    D2D1_BITMAP_PROPERTIES1 targetProperties = { { DXGI_FORMAT_R8G8B8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED }, 96, 96, D2D1_BITMAP_OPTIONS_TARGET, 0 };
-                    hr = _d2dContext->CreateBitmap(size, NULL, 0, &targetProperties, &_d2dTargetBitmap);
-                    if (SUCCEEDED(hr)) {
-                        _d2dContext->SetTarget(_d2dTargetBitmap.Get());
-                    } else {
-                        throw GenericException("BitmapCanvas: Failed to create target bitmap");
-                    }
-
-                    _d2dContext->BeginDraw();
-                    _d2dContext->Clear(D2D1::ColorF(0, 0));
-                } else {
-                    throw GenericException("BitmapCanvas: Failed to create D2DDeviceContext");
-                }
+                _d2dContext->SetTarget(_d2dTargetBitmap.Get());
             } else {
-                throw GenericException("BitmapCanvas: Failed to create D2DDevice");
+                throw GenericException("BitmapCanvas: Failed to create target bitmap");
             }
-        } else {
-            throw GenericException("BitmapCanvas: Failed to create D3DDevice");
-        }
 
-        hr = DWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED, __uuidof(IDWriteFactory), &_dwriteFactory);
-        if (FAILED(hr)) {
-            throw GenericException("BitmapCanvas: Failed to create DWriteFactory");
+            _d2dContext->BeginDraw();
+            _d2dContext->Clear(D2D1::ColorF(0, 0));
+        } else {
+            throw GenericException("BitmapCanvas: Failed to create D2DDeviceContext");
         }
     }
 
@@ -102,6 +72,17 @@ namespace carto {
 
     void BitmapCanvas::UWPImpl::setFont(const std::string& name, float size) {
         if (_dwriteFactory) {
+            // Text formats are immutable, share them between all canvases
+            static std::map<std::pair<std::string, float>, Microsoft::WRL::ComPtr<IDWriteTextFormat> > textFormats;
+            static std::mutex textFormatsMutex;
+
+            std::lock_guard<std::mutex> lock(textFormatsMutex);
+            auto it = textFormats.find(std::make_pair(name, size));
+            if (it != textFormats.end()) {
+                _dwriteTextFormat = it->second;
+                return;
+            }
+
             std::wstring wname;
             utf8::utf8to16(name.begin(), name.end(), std::back_inserter(wname));
             HRESULT hr = _dwriteFactory->CreateTextFormat(
@@ -116,7 +97,9 @@ namespace carto {
                 );
             if (FAILED(hr)) {
                 Log::Errorf("BitmapCanvas: Failed to create text format, %x", (int)hr);
+                return;
             }
+            textFormats[std::make_pair(name, size)] = _dwriteTextFormat;
         }
     }
 
@@ -320,4 +303,64 @@ namespace carto {
         return hr;
     }
 
+    const BitmapCanvas::UWPImpl::DeviceResources& BitmapCanvas::UWPImpl::GetDeviceResources() {
+        // Devices are created single-threaded, so they are reused only by the canvases of the same thread
+        static thread_local DeviceResources deviceResources;
+        if (deviceResources.d2dDevice) {
+            return deviceResources;
+        }
+
+        static const D3D_FEATURE_LEVEL featureLevels[] =
+        {
+            D3D_FEATURE_LEVEL_11_1,
+            D3D_FEATURE_LEVEL_11_0,
+            D3D_FEATURE_LEVEL_10_1,
+            D3D_FEATURE_LEVEL_10_0,
+            D3D_FEATURE_LEVEL_9_3,
+            D3D_FEATURE_LEVEL_9_2,
+            D3D_FEATURE_LEVEL_9_1
+        };
+
+        DeviceResources newDeviceResources;
+        HRESULT hr = D3D11CreateDevice(
+            NULL,
+            D3D_DRIVER_TYPE_HARDWARE,
+            NULL,
+            D3D11_CREATE_DEVICE_SINGLETHREADED | D3D11_CREATE_DEVICE_BGRA_SUPPORT,
+            featureLevels,
+            ARRAYSIZE(featureLevels),
+            D3D11_SDK_VERSION,
+            &newDeviceResources.device,
+            NULL,
+            &newDeviceResources.context);
+        if (FAILED(hr)) {
+            throw GenericException("BitmapCanvas: Failed to create D3DDevice");
+        }
+
+        Microsoft::WRL::ComPtr<IDXGIDevice> dxgiDevice;
+        newDeviceResources.device.As(&dxgiDevice);
+
+        hr = D2D1CreateDevice(dxgiDevice.Get(), NULL, &newDeviceResources.d2dDevice);
+        if (FAILED(hr)) {
+            throw GenericException("BitmapCanvas: Failed to create D2DDevice");
+        }
+
+        deviceResources = newDeviceResources;
+        return deviceResources;
+    }
+
+    Microsoft::WRL::ComPtr<IDWriteFactory> BitmapCanvas::UWPImpl::GetDWriteFactory() {
+        static Microsoft::WRL::ComPtr<IDWriteFactory> dwriteFactory;
+        static std::mutex dwriteFactoryMutex;
+
+        std::lock_guard<std::mutex> lock(dwriteFactoryMutex);
+        if (!dwriteFactory) {
+            HRESULT hr = DWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED, __uuidof(IDWriteFactory), &dwriteFactory);
+            if (FAILED(hr)) {
+                throw GenericException("BitmapCanvas: Failed to create DWriteFactory");
+            }
+        }
+        return dwriteFactory;
+    }
+
 }
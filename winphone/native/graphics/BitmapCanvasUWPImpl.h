@@ -41,8 +41,17 @@ namespace carto {
         virtual std::shared_ptr<Bitmap> buildBitmap() const;
 
     private:
+        struct DeviceResources {
+            Microsoft::WRL::ComPtr<ID3D11Device> device;
+            Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+            Microsoft::WRL::ComPtr<ID2D1Device> d2dDevice;
+        };
+
         HRESULT createDWriteTextLayout(const std::string& text, int maxWidth, bool breakLines, IDWriteTextLayout** pdwriteTextLayout) const;
 
+        static const DeviceResources& GetDeviceResources();
+        static Microsoft::WRL::ComPtr<IDWriteFactory> GetDWriteFactory();
+
         int _width;
         int _height;
         float _strokeWidth;
@@ -2,7 +2,9 @@
 #include "components/Exceptions.h"
 #include "utils/Log.h"
 
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
 #include <chrono>
 #include <limits>
 #include <regex>
@@ -53,14 +55,13 @@ namespace {
         {
             HRESULT hr = S_OK;
 
-            ULONG read = 0;
-            for (read = 0; read < cb; ++read, ++m_buffSeekIndex) {
-                if (m_buffSeekIndex == m_data.size()) {
-                    hr = S_FALSE;
-                    break;
-                }
-
-                static_cast<unsigned char*>(pv)[read] = m_data[m_buffSeekIndex];
+            ULONG read = static_cast<ULONG>(std::min(static_cast<std::size_t>(cb), m_data.size() - m_buffSeekIndex));
+            if (read < cb) {
+                hr = S_FALSE;
+            }
+            if (read > 0) {
+                std::memcpy(pv, &m_data[m_buffSeekIndex], read);
+                m_buffSeekIndex += read;
             }
 
             if (pcbRead != NULL) {
@@ -159,10 +160,11 @@ namespace {
             IXMLHTTPRequest2 *pXHR,
             ISequentialStream *pResponseStream)
         {
+            // Drain the stream using a large buffer to minimize the number of reads and data callbacks
+            _buffer.resize(READ_BUFFER_SIZE);
             while (true) {
-                unsigned char buf[4096];
                 unsigned long bytesRead = 0;
-                HRESULT hr = pResponseStream->Read(buf, sizeof(buf), &bytesRead);
+                HRESULT hr = pResponseStream->Read(_buffer.data(), static_cast<ULONG>(_buffer.size()), &bytesRead);
                 if (FAILED(hr)) {
                     _finishFn(false);
                     return E_ABORT;
@@ -172,7 +174,7 @@ namespace {
                     break;
                 }
 
-                if (!_dataFn(&buf[0], bytesRead)) {
+                if (!_dataFn(_buffer.data(), bytesRead)) {
                     _finishFn(false);
                     return E_ABORT;
                 }
@@ -216,9 +218,12 @@ namespace {
         }
 
     private:
+        static const std::size_t READ_BUFFER_SIZE = 65536;
+
         HeadersFunc _headersFn;
         DataFunc _dataFn;
         FinishFunc _finishFn;
+        std::vector<unsigned char> _buffer;
     };
 
 }
@@ -235,6 +240,10 @@ namespace carto {
         _timeout = milliseconds;
     }
 
+    void HTTPClient::WinSockImpl::setMaxConnectionsPerHost(int maxConnections) {
+        // Connections are pooled by the system HTTP stack, the limit can not be controlled per request object
+    }
+
     bool HTTPClient::WinSockImpl::makeRequest(const HTTPClient::Request& request, HeadersFunc headersFn, DataFunc dataFn) const {
         MULTI_QI mqi = { 0 };
 
@@ -260,9 +269,10 @@ namespace carto {
         }
         std::shared_ptr<std::remove_pointer<::HANDLE>::type> resultEvent(event, &::CloseHandle);
 
-        bool cancel = false;
-        auto finishFn = [&](bool success) {
-            cancel = !success;
+        // The callbacks may be invoked after the request has finished (for example errors after abort), so the result state is shared with them
+        auto cancel = std::make_shared<bool>(false);
+        auto finishFn = [cancel, resultEvent](bool success) {
+            *cancel = !success;
             ::SetEvent(resultEvent.get());
         };
         
@@ -314,7 +324,7 @@ namespace carto {
 
         ::WaitForSingleObjectEx(resultEvent.get(), INFINITE, FALSE);
 
-        return !cancel;
+        return !*cancel;
     }
 
 }
@@ -16,6 +16,7 @@ namespace carto {
         explicit WinSockImpl(bool log);
 
         virtual void setTimeout(int milliseconds);
+        virtual void setMaxConnectionsPerHost(int maxConnections);
         virtual bool makeRequest(const HTTPClient::Request& request, HeadersFunc headersFn, DataFunc dataFn) const;
 
     private:
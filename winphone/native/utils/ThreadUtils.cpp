@@ -11,6 +11,23 @@ namespace carto {
         ::SetThreadPriority(::GetCurrentThread(), static_cast<int>(priority) * THREAD_PRIORITY_HIGHEST / static_cast<int>(ThreadPriority::MAXIMUM));
     }
 
+    void ThreadUtils::SetThreadRole(ThreadRole::ThreadRole role) {
+        switch (role) {
+        case ThreadRole::RENDER_CRITICAL:
+            SetThreadPriority(ThreadPriority::MAXIMUM);
+            break;
+        case ThreadRole::INTERACTIVE:
+            SetThreadPriority(ThreadPriority::NORMAL);
+            break;
+        case ThreadRole::BACKGROUND:
+            SetThreadPriority(ThreadPriority::LOW);
+            break;
+        case ThreadRole::BULK:
+            SetThreadPriority(ThreadPriority::MINIMUM);
+            break;
+        }
+    }
+
     ThreadUtils::ThreadUtils() {
     }
 
@@ -0,0 +1,55 @@
+#include "utils/TraceUtils.h"
+
+#include <windows.h>
+#include <TraceLoggingProvider.h>
+
+// {49bb0e7f-bb50-463d-84eb-4d5c845732fc}
+TRACELOGGING_DEFINE_PROVIDER(
+    CartoTraceProvider,
+    "Carto.MobileSDK",
+    (0x49bb0e7f, 0xbb50, 0x463d, 0x84, 0xeb, 0x4d, 0x5c, 0x84, 0x57, 0x32, 0xfc));
+
+namespace carto {
+
+    namespace {
+
+        struct TraceProviderRegistration {
+            TraceProviderRegistration() {
+                TraceLoggingRegister(CartoTraceProvider);
+            }
+
+            ~TraceProviderRegistration() {
+                TraceLoggingUnregister(CartoTraceProvider);
+            }
+        };
+
+        void RegisterTraceProvider() {
+            static TraceProviderRegistration registration;
+        }
+
+    }
+
+    bool TraceUtils::IsEnabled() {
+        RegisterTraceProvider();
+        return TraceLoggingProviderEnabled(CartoTraceProvider, 0, 0);
+    }
+
+    std::uint64_t TraceUtils::BeginSection(const char* name) {
+        if (!IsEnabled()) {
+            return 0;
+        }
+        TraceLoggingWrite(CartoTraceProvider, "Section", TraceLoggingOpcode(WINEVENT_OPCODE_START), TraceLoggingString(name, "Name"));
+        return 1;
+    }
+
+    void TraceUtils::EndSection(const char* name, std::uint64_t sectionId) {
+        if (sectionId == 0) {
+            return;
+        }
+        TraceLoggingWrite(CartoTraceProvider, "Section", TraceLoggingOpcode(WINEVENT_OPCODE_STOP), TraceLoggingString(name, "Name"));
+    }
+
+    TraceUtils::TraceUtils() {
+    }
+
+}